@@ -278,6 +278,25 @@ public class SerialUAVTalk extends TelemetryTask {
 			return -1;
 		}
 
+		/**
+		 * Returns what is buffered, only blocking while nothing is, where
+		 * the default would read a byte at a time until len are in
+		 */
+		@Override
+		public int read(byte[] b, int off, int len) {
+			try {
+				return data.getBytesBlocking(b, off, len);
+			} catch (InterruptedException e) {
+				if (!shutdown) {
+					Log.e(TAG, "Timed out");
+					if (DEBUG) e.printStackTrace();
+					disconnect();
+					telemService.connectionBroken();
+				}
+			}
+			return -1;
+		}
+
 		public void write(byte[] b) {
 			data.put(b);
 		}
@@ -336,6 +355,25 @@ public class SerialUAVTalk extends TelemetryTask {
 			return buf;
 		}
 
+		//! Take as many bytes as are available, up to len, waiting for at least one
+		public int getBytesBlocking(byte[] dst, int offset, int len) throws InterruptedException {
+			if (len == 0)
+				return 0;
+
+			synchronized(buf) {
+				while (size <= 0) {
+					buf.wait();
+				}
+				int n = Math.min(size, len);
+				buf.position(0);
+				buf.get(dst, offset, n);
+				buf.limit(size);
+				buf.compact();
+				size -= n;
+				return n;
+			}
+		}
+
 		public int getByteBlocking() throws InterruptedException {
 			synchronized(buf) {
 				while (size <= 0) {
@@ -24,6 +24,7 @@ package org.dronin.uavtalk;
 
 import java.nio.ByteBuffer;
 import java.util.ArrayList;
+import java.util.Arrays;
 import java.util.List;
 import java.util.ListIterator;
 import java.util.Observable;
@@ -31,24 +32,66 @@ import java.util.Observer;
 
 public abstract class UAVObject {
 
+	/**
+	 * Observable that notifies without allocating: java.util.Observable
+	 * copies its observer list on every notification, and objects are
+	 * notified for every packet received.  The observers are kept in an
+	 * array that is only copied when one is added or removed.
+	 */
 	public class CallbackListener extends Observable {
 		private final UAVObject parent;
+		private Observer[] observers = new Observer[0];
 
 		public CallbackListener(UAVObject parent) {
 			this.parent = parent;
 		}
 
-		public void event () {
-			synchronized(this) {
-				setChanged();
-				notifyObservers(parent);
+		@Override
+		public synchronized void addObserver(Observer o) {
+			if (o == null)
+				throw new NullPointerException();
+			for (Observer existing : observers)
+				if (existing == o)
+					return;
+			Observer[] n = Arrays.copyOf(observers, observers.length + 1);
+			n[observers.length] = o;
+			observers = n;
+		}
+
+		@Override
+		public synchronized void deleteObserver(Observer o) {
+			for (int i = 0; i < observers.length; i++) {
+				if (observers[i] == o) {
+					Observer[] n = new Observer[observers.length - 1];
+					System.arraycopy(observers, 0, n, 0, i);
+					System.arraycopy(observers, i + 1, n, i, n.length - i);
+					observers = n;
+					return;
+				}
 			}
 		}
+
+		@Override
+		public synchronized void deleteObservers() {
+			observers = new Observer[0];
+		}
+
+		@Override
+		public synchronized int countObservers() {
+			return observers.length;
+		}
+
+		public void event () {
+			event(parent);
+		}
 		public void event (Object data) {
+			Observer[] current;
 			synchronized(this) {
-				setChanged();
-				notifyObservers(data);
+				current = observers;
 			}
+			// Newest first, like Observable
+			for (int i = current.length - 1; i >= 0; i--)
+				current[i].update(this, data);
 		}
 	}
 
@@ -565,6 +608,14 @@ public abstract class UAVObject {
 		return fields;
 	}
 
+	/**
+	 * Get a field by its position, as given by the FIELD_ constants of the
+	 * generated classes, without searching by name
+	 */
+	public UAVObjectField getField(int index) {
+		return fields.get(index);
+	}
+
 	/**
 	 * Get a specific field
 	 *
@@ -573,9 +624,8 @@ public abstract class UAVObject {
 	 */
 	public UAVObjectField getField(String name) {
 		// Look for field
-		ListIterator<UAVObjectField> li = fields.listIterator();
-		while (li.hasNext()) {
-			UAVObjectField field = li.next();
+		for (int i = 0; i < fields.size(); i++) {
+			UAVObjectField field = fields.get(i);
 			if (field.getName().equals(name))
 				return field;
 		}
@@ -597,11 +647,8 @@ public abstract class UAVObject {
 			throw new Exception("Not enough bytes in ByteBuffer to pack object");
 		int numBytes = 0;
 
-		ListIterator<UAVObjectField> li = fields.listIterator();
-		while (li.hasNext()) {
-			UAVObjectField field = li.next();
-			numBytes += field.pack(dataOut);
-		}
+		for (int i = 0; i < fields.size(); i++)
+			numBytes += fields.get(i).pack(dataOut);
 		return numBytes;
 	}
 
@@ -619,11 +666,8 @@ public abstract class UAVObject {
 
 		// QMutexLocker locker(mutex);
 		int numBytes = 0;
-		ListIterator<UAVObjectField> li = fields.listIterator();
-		while (li.hasNext()) {
-			UAVObjectField field = li.next();
-			numBytes += field.unpack(dataIn);
-		}
+		for (int i = 0; i < fields.size(); i++)
+			numBytes += fields.get(i).unpack(dataIn);
 
 		// Trigger all the listeners for the unpack event
 		unpacked();
@@ -25,6 +25,7 @@ package org.dronin.uavtalk;
 import java.nio.ByteBuffer;
 import java.nio.ByteOrder;
 import java.util.ArrayList;
+import java.util.Arrays;
 import java.util.List;
 
 public class UAVObjectField {
@@ -114,66 +115,32 @@ public class UAVObjectField {
      * @param dataOut
      * @return the number of bytes added
      **/
-    @SuppressWarnings("unchecked")
 	public synchronized int pack(ByteBuffer dataOut) {
         // Pack each element in output buffer
     	dataOut.order(ByteOrder.LITTLE_ENDIAN);
         switch (type)
         {
             case INT8:
-            	for (int index = 0; index < numElements; ++index) {
-            		Integer val = (Integer) getValue(index);
-            		dataOut.put(val.byteValue());
-            	}
-                break;
-            case INT16:
-                for (int index = 0; index < numElements; ++index) {
-                	Integer val = (Integer) getValue(index);
-                	dataOut.putShort(val.shortValue());
-                }
-                break;
-            case INT32:
-                for (int index = 0; index < numElements; ++index) {
-                	Integer val = (Integer) getValue(index);
-                	dataOut.putInt(val);
-                }
-                break;
             case UINT8:
-            	// TODO: Deal properly with unsigned
-            	for (int index = 0; index < numElements; ++index) {
-            		Integer val = (Integer) getValue(index);
-            		dataOut.put(val.byteValue());
-            	}
+            case ENUM:
+            case BITFIELD:
+            	for (int index = 0; index < numElements; ++index)
+            		dataOut.put((byte) (long) data[index]);
                 break;
+            case INT16:
             case UINT16:
-            	// TODO: Deal properly with unsigned
-                for (int index = 0; index < numElements; ++index) {
-                	Integer val = (Integer) getValue(index);
-                	dataOut.putShort(val.shortValue());
-                }
+                for (int index = 0; index < numElements; ++index)
+                	dataOut.putShort((short) (long) data[index]);
                 break;
+            case INT32:
             case UINT32:
-            	// TODO: Deal properly with unsigned
-                for (int index = 0; index < numElements; ++index) {
-                	Integer val = (int) ( ((Long) getValue(index)).longValue() & 0xffffffffL);
-                	dataOut.putInt(val);
-                }
-                break;
-            case FLOAT32:
                 for (int index = 0; index < numElements; ++index)
-                	dataOut.putFloat((Float) getValue(index));
+                	dataOut.putInt((int) (long) data[index]);
                 break;
-            case ENUM:
-            	List<Byte> l = (List<Byte>) data;
+            case FLOAT32:
                 for (int index = 0; index < numElements; ++index)
-                	dataOut.put(l.get(index));
+                	dataOut.putFloat((float) data[index]);
                 break;
-            case BITFIELD:
-            	for (int index = 0; index < numElements; ++index) {
-            		Integer val = (Integer) getValue(index);
-            		dataOut.put(val.byteValue());
-            	}
-            	break;
             case STRING:
             	// TODO: Implement strings
             	throw new Error("Strings not yet implemented.  Field name: " + getName());
@@ -182,96 +149,48 @@ public class UAVObjectField {
         return getNumBytes();
     }
 
-    @SuppressWarnings("unchecked")
+	/**
+	 * Unpacks this field straight into its primitive storage, so that
+	 * receiving an object allocates nothing
+	 * @param dataIn
+	 * @return the number of bytes used
+	 */
 	public synchronized int unpack(ByteBuffer dataIn) {
         // Unpack each element from input buffer
     	dataIn.order(ByteOrder.LITTLE_ENDIAN);
         switch (type)
         {
             case INT8:
-            {
-            	List<Byte> l = (List<Byte>) this.data;
-            	for (int index = 0 ; index < numElements; ++index) {
-            		Long val = bound(dataIn.get());
-            		l.set(index, val.byteValue());
-            	}
+            	for (int index = 0 ; index < numElements; ++index)
+            		data[index] = dataIn.get();
                 break;
-            }
             case INT16:
-            {
-            	List<Short> l = (List<Short>) this.data;
-            	for (int index = 0 ; index < numElements; ++index) {
-            		Long val = bound(dataIn.getShort());
-            		l.set(index, val.shortValue());
-            	}
+            	for (int index = 0 ; index < numElements; ++index)
+            		data[index] = dataIn.getShort();
                 break;
-            }
             case INT32:
-            {
-            	List<Integer> l = (List<Integer>) this.data;
-            	for (int index = 0 ; index < numElements; ++index) {
-            		Long val = bound(dataIn.getInt());
-            		l.set(index, val.intValue());
-            	}
+            	for (int index = 0 ; index < numElements; ++index)
+            		data[index] = dataIn.getInt();
                 break;
-            }
             case UINT8:
-            {
-            	List<Short> l = (List<Short>) this.data;
-            	for (int index = 0 ; index < numElements; ++index) {
-            		int signedval = dataIn.get();  // this sign extends it
-            		int unsignedval = signedval & 0xff;    // drop sign extension
-            		l.set(index, (short) unsignedval);
-            	}
+            case ENUM:
+            case BITFIELD:
+            	// Drop the sign extension
+            	for (int index = 0 ; index < numElements; ++index)
+            		data[index] = dataIn.get() & 0xff;
                 break;
-            }
             case UINT16:
-            {
-            	List<Integer> l = (List<Integer>) this.data;
-            	for (int index = 0 ; index < numElements; ++index) {
-            		int signedval = dataIn.getShort();  // this sign extends it
-            		int unsignedval = signedval & 0xffff;    // drop sign extension
-            		l.set(index, unsignedval);
-            	}
+            	for (int index = 0 ; index < numElements; ++index)
+            		data[index] = dataIn.getShort() & 0xffff;
                 break;
-            }
             case UINT32:
-            {
-            	List<Long> l = (List<Long>) this.data;
-            	for (int index = 0 ; index < numElements; ++index) {
-            		long signedval = dataIn.getInt();  // this sign extends it
-            		long unsignedval = signedval & 0xffffffffL;    // drop sign extension
-            		l.set(index, unsignedval);
-            	}
+            	for (int index = 0 ; index < numElements; ++index)
+            		data[index] = dataIn.getInt() & 0xffffffffL;
                 break;
-            }
             case FLOAT32:
-            {
-            	List<Float> l = (List<Float>) this.data;
-            	for (int index = 0 ; index < numElements; ++index) {
-            		Float val = dataIn.getFloat();
-            		l.set(index, val);
-            	}
-                break;
-            }
-            case BITFIELD:
-            {
-            	List<Short> l = (List<Short>) this.data;
-            	for (int index = 0 ; index < numElements; ++index) {
-            		int signedval = dataIn.get();  // this sign extends it
-            		int unsignedval = signedval & 0xff;    // drop sign extension
-            		l.set(index, (short) unsignedval);
-            	}
+            	for (int index = 0 ; index < numElements; ++index)
+            		data[index] = dataIn.getFloat();
                 break;
-            }
-            case ENUM:
-            {
-        		List<Byte> l = (List<Byte>) this.data;
-            	for (int index = 0 ; index < numElements; ++index) {
-            		l.set(index, dataIn.get());
-            	}
-                break;
-            }
             case STRING:
             	// TODO: implement strings
             	//throw new Exception("Strings not handled");
@@ -281,7 +200,6 @@ public class UAVObjectField {
     }
 
     public Object getValue()  { return getValue(0); };
-    @SuppressWarnings("unchecked")
 	public synchronized Object getValue(int index)  {
         // Check that index is not out of bounds
         if ( index >= numElements )
@@ -292,32 +210,21 @@ public class UAVObjectField {
         switch (type)
         {
             case INT8:
-            	return ((List<Byte>) data).get(index).intValue();
             case INT16:
-            	return ((List<Short>) data).get(index).intValue();
             case INT32:
-            	return ((List<Integer>) data).get(index).intValue();
             case UINT8:
-            	return ((List<Short>) data).get(index).intValue();
             case UINT16:
-            	return ((List<Integer>) data).get(index).intValue();
+            case BITFIELD:
+            	return (int) data[index];
             case UINT32:
-            	return ((List<Long>) data).get(index);
+            	return (long) data[index];
             case FLOAT32:
-            	return ((List<Float>) data).get(index);
+            	return (float) data[index];
             case ENUM:
-            {
-            	List<Byte> l = (List<Byte>) data;
-            	Byte val = l.get(index);
-
                 //if(val >= options.size() || val < 0)
                 //	throw new Exception("Invalid value for" + name);
 
-                return options.get(val);
-            }
-            case BITFIELD:
-            	return ((List<Short>) data).get(index).intValue();
-
+                return options.get((int) data[index]);
             case STRING:
             {
             	//throw new Exception("Shit I should do this");
@@ -328,105 +235,73 @@ public class UAVObjectField {
     }
 
     public void setValue(Object data) { setValue(data,0); }
-    @SuppressWarnings("unchecked")
 	public synchronized void setValue(Object data, int index) {
     	// Check that index is not out of bounds
     	//if ( index >= numElements );
     		//throw new Exception("Index out of bounds");
 
+		switch (type) {
+		case ENUM:
+			// Either the numeric value or the name of an option
+			if (data instanceof Number)
+				setDouble(((Number) data).doubleValue(), index);
+			else
+				setDouble(options.indexOf(data), index);
+			break;
+		case STRING:
+			//throw new Exception("Sorry I haven't implemented strings yet");
+			break;
+		default:
+			setDouble(((Number) data).doubleValue(), index);
+		}
+    }
+
+	/**
+	 * The primitive accessors below neither box nor allocate, which the
+	 * generic getValue/setValue do.  Enums give the index of their option.
+	 */
+    public double getDouble() { return getDouble(0); };
+	public synchronized double getDouble(int index) {
+		return data[index];
+	}
+
+	public float getFloat() { return getFloat(0); };
+	public synchronized float getFloat(int index) {
+		return (float) data[index];
+	}
+
+	public long getLong() { return getLong(0); };
+	public synchronized long getLong(int index) {
+		return (long) data[index];
+	}
+
+	public int getInt() { return getInt(0); };
+	public synchronized int getInt(int index) {
+		return (int) data[index];
+	}
+
+    public void setDouble(double value) { setDouble(value, 0); };
+    public synchronized void setDouble(double value, int index) {
     	// Get metadata
     	UAVObject.Metadata mdata = obj.getMetadata();
     	// Update value if the access mode permits
-    	if ( mdata.GetGcsAccess() == UAVObject.AccessMode.ACCESS_READWRITE )
-    	{
-    		switch (type)
-    		{
-    		case INT8:
-    		{
-    			List<Byte> l = (List<Byte>) this.data;
-    			l.set(index, bound(data).byteValue());
-    			break;
-    		}
-    		case INT16:
-    		{
-    			List<Short> l = (List<Short>) this.data;
-    			l.set(index, bound(data).shortValue());
-    			break;
-    		}
-    		case INT32:
-    		{
-    			List<Integer> l = (List<Integer>) this.data;
-    			l.set(index, bound(data).intValue());
-    			break;
-    		}
-    		case UINT8:
-    		{
-    			List<Short> l = (List<Short>) this.data;
-    			l.set(index, bound(data).shortValue());
-    			break;
-    		}
-    		case UINT16:
-    		{
-    			List<Integer> l = (List<Integer>) this.data;
-    			l.set(index, bound(data).intValue());
-    			break;
-    		}
-    		case UINT32:
-    		{
-    			List<Long> l = (List<Long>) this.data;
-    			l.set(index, bound(data));
-    			break;
-    		}
-    		case FLOAT32:
-    		{
-    			List<Float> l = (List<Float>) this.data;
-    			l.set(index, ((Number) data).floatValue());
-    			break;
-    		}
-    		case ENUM:
-    		{
-    			byte val;
-    			try {
-    				// Test if numeric constant passed in
-    				val = ((Number) data).byteValue();
-    			} catch (Exception e) {
-    				val = (byte) options.indexOf(data);
-    			}
-    			//if(val < 0) throw new Exception("Enumerated value not found");
-    			List<Byte> l = (List<Byte>) this.data;
-    			l.set(index, val);
-    			break;
-    		}
-    		case BITFIELD:
-    		{
-    			List<Short> l = (List<Short>) this.data;
-    			l.set(index, bound(data).shortValue());
-    			break;
-    		}
-    		case STRING:
-    		{
-    			//throw new Exception("Sorry I haven't implemented strings yet");
-    		}
-    		}
-    		//obj.updated();
-    	}
-    }
+    	if ( mdata.GetGcsAccess() != UAVObject.AccessMode.ACCESS_READWRITE )
+    		return;
 
-    public double getDouble() { return getDouble(0); };
-    @SuppressWarnings("unchecked")
-	public double getDouble(int index) {
-    	switch (type) {
+    	switch (type)
+    	{
+    	case FLOAT32:
+    		data[index] = (float) value;
+    		break;
     	case ENUM:
-    		return ((List<Byte>)data).get(index);
-    	default:
+    		data[index] = ((byte) (int) value) & 0xff;
+    		break;
+    	case STRING:
     		break;
+    	default:
+    		data[index] = bound((long) value);
     	}
-    	return ((Number) getValue(index)).doubleValue();
-    }
-
-    public void setDouble(double value) { setDouble(value, 0); };
-    public void setDouble(double value, int index) {
-    	setValue(value, index);
+    	//obj.updated();
     }
 
     public int getDataOffset() {
@@ -519,71 +394,8 @@ public class UAVObjectField {
 
     }
 
-    @SuppressWarnings("unchecked")
 	public synchronized void clear() {
-    	switch (type)
-        {
-            case INT8:
-            	((ArrayList<Byte>) data).clear();
-            	for(int index = 0; index < numElements; ++index) {
-            		((ArrayList<Byte>) data).add((byte) 0);
-            	}
-                break;
-            case INT16:
-            	((ArrayList<Short>) data).clear();
-            	for(int index = 0; index < numElements; ++index) {
-            		((ArrayList<Short>) data).add((short) 0);
-            	}
-                break;
-            case INT32:
-            	((ArrayList<Integer>) data).clear();
-            	for(int index = 0; index < numElements; ++index) {
-            		((ArrayList<Integer>) data).add(0);
-            	}
-                break;
-            case UINT8:
-            	((ArrayList<Short>) data).clear();
-            	for(int index = 0; index < numElements; ++index) {
-            		((ArrayList<Short>) data).add((short) 0);
-            	}
-                break;
-            case UINT16:
-            	((ArrayList<Integer>) data).clear();
-            	for(int index = 0; index < numElements; ++index) {
-            		((ArrayList<Integer>) data).add(0);
-            	}
-                break;
-            case UINT32:
-            	((ArrayList<Long>) data).clear();
-            	for(int index = 0; index < numElements; ++index) {
-            		((ArrayList<Long>) data).add((long) 0);
-            	}
-                break;
-            case FLOAT32:
-            	((ArrayList<Float>) data).clear();
-            	for(int index = 0; index < numElements; ++index) {
-            		((ArrayList<Float>) data).add((float) 0);
-            	}
-                break;
-            case BITFIELD:
-            	((ArrayList<Short>) data).clear();
-            	for(int index = 0; index < numElements; ++index) {
-            		((ArrayList<Short>) data).add((short) 0);
-            	}
-                break;
-            case ENUM:
-            	((ArrayList<Byte>) data).clear();
-            	for(int index = 0; index < numElements; ++index) {
-            		((ArrayList<Byte>) data).add((byte) 0);
-            	}
-                break;
-            case STRING:
-            	((ArrayList<Byte>) data).clear();
-            	for(int index = 0; index < numElements; ++index) {
-            		((ArrayList<Byte>) data).add((byte) 0);
-            	}
-                break;
-        }
+    	Arrays.fill(data, 0);
     }
 
     public synchronized void constructorInitialize(String name, String units, FieldType type, List<String> elementNames, List<String> options) {
@@ -594,7 +406,6 @@ public class UAVObjectField {
         this.options = options;
         this.numElements = elementNames.size();
         this.offset = 0;
-        this.data = null;
         this.obj = null;
         this.elementNames = elementNames;
 
@@ -602,116 +413,91 @@ public class UAVObjectField {
         switch (type)
         {
             case INT8:
-            	data = new ArrayList<Byte>(this.numElements);
                 numBytesPerElement = 1;
                 break;
             case INT16:
-            	data = new ArrayList<Short>(this.numElements);
                 numBytesPerElement = 2;
                 break;
             case INT32:
-            	data = new ArrayList<Integer>(this.numElements);
                 numBytesPerElement = 4;
                 break;
             case UINT8:
-            	data = new ArrayList<Short>(this.numElements);
                 numBytesPerElement = 1;
                 break;
             case UINT16:
-            	data = new ArrayList<Integer>(this.numElements);
                 numBytesPerElement = 2;
                 break;
             case UINT32:
-            	data = new ArrayList<Long>(this.numElements);
                 numBytesPerElement = 4;
                 break;
             case FLOAT32:
-            	data = new ArrayList<Float>(this.numElements);
                 numBytesPerElement = 4;
                 break;
             case ENUM:
-            	data = new ArrayList<Byte>(this.numElements);
                 numBytesPerElement = 1;
                 break;
             case BITFIELD:
-            	data = new ArrayList<Short>(this.numElements);
                 numBytesPerElement = 1;
                 break;
             case STRING:
-            	data = new ArrayList<Byte>(this.numElements);
                 numBytesPerElement = 1;
                 break;
             default:
                 numBytesPerElement = 0;
         }
+        data = new double[this.numElements];
         clear();
     }
 
     /**
      * For numerical types bounds the data appropriately
-     * @param val Can be any object, for numerical tries to cast to Number
-     * @return long value with the right range (for float rounds)
+     * @param num The value to store
+     * @return long value with the right range
      * @note This is mostly needed because java has no unsigned integer
      */
-    protected Long bound (Object val) {
-
-    	long num = 0;
-    	if (isNumeric())
-    		num = ((Number) val).longValue();
-
+    protected long bound (long num) {
     	switch(type) {
     	case INT8:
     		if(num < Byte.MIN_VALUE)
-    			return (long) Byte.MAX_VALUE;
+    			return Byte.MIN_VALUE;
     		if(num > Byte.MAX_VALUE)
-    			return (long) Byte.MAX_VALUE;
+    			return Byte.MAX_VALUE;
     		return num;
     	case INT16:
     		if(num < Short.MIN_VALUE)
-    			return (long) Short.MIN_VALUE;
+    			return Short.MIN_VALUE;
     		if(num > Short.MAX_VALUE)
-    			return (long) Short.MAX_VALUE;
+    			return Short.MAX_VALUE;
     		return num;
     	case INT32:
     		if(num < Integer.MIN_VALUE)
-    			return (long) Integer.MIN_VALUE;
+    			return Integer.MIN_VALUE;
     		if(num > Integer.MAX_VALUE)
-    			return (long) Integer.MAX_VALUE;
+    			return Integer.MAX_VALUE;
     		return num;
     	case UINT8:
+    	case BITFIELD:
     		if(num < 0)
-    			return (long) 0;
+    			return 0;
     		if(num > 255)
-    			return (long) 255;
+    			return 255;
     		return num;
     	case UINT16:
     		if(num < 0)
-    			return (long) 0;
+    			return 0;
     		if(num > 65535)
-    			return (long) 65535;
+    			return 65535;
     		return num;
     	case UINT32:
     		if(num < 0)
-    			return (long) 0;
+    			return 0;
     		if(num > 4294967295L)
     			return 4294967295L;
     		return num;
-    	case BITFIELD:
-    		if(num < 0)
-    			return (long) 0;
-    		if(num > 255)
-    			return (long) 255;
+    	default:
     		return num;
-    	case FLOAT32:
-    		return ((Number) val).longValue();
-    	case ENUM:
-    	case STRING:
-    		return 0L;
     	}
-
-    	return num;
     }
-
     @Override
     public UAVObjectField clone()
     {
@@ -732,6 +518,6 @@ public class UAVObjectField {
     private int numBytesPerElement;
     private int offset;
     private UAVObject obj;
-    protected Object data;
+    protected double[] data;
 
 }
@@ -309,16 +309,16 @@ public class UAVObjectManager {
 	 */
 	public synchronized UAVObject getObject(String name, long objId, long instId)
 	{
-		// Check if this object type is already in the list
-		ListIterator<List<UAVObject>> objIter = objects.listIterator();
-		while(objIter.hasNext()) {
-			List<UAVObject> instList = objIter.next();
+		// Check if this object type is already in the list.  This is done
+		// for every packet received, so index rather than iterate to not
+		// allocate.
+		for (int i = 0; i < objects.size(); i++) {
+			List<UAVObject> instList = objects.get(i);
 			if (instList.size() > 0) {
 				if ( (name != null && instList.get(0).getName().compareTo(name) == 0) || (name == null && instList.get(0).getObjID() == objId) ) {
 					// Look for the requested instance ID
-					ListIterator<UAVObject> iter = instList.listIterator();
-					while(iter.hasNext()) {
-						UAVObject obj = iter.next();
+					for (int j = 0; j < instList.size(); j++) {
+						UAVObject obj = instList.get(j);
 						if(obj.getInstID() == instId) {
 							return obj;
 						}
@@ -352,9 +352,8 @@ public class UAVObjectManager {
 	public synchronized List<UAVObject> getObjectInstances(String name, long objId)
 	{
 		// Check if this object type is already in the list
-		ListIterator<List<UAVObject>> objIter = objects.listIterator();
-		while(objIter.hasNext()) {
-			List<UAVObject> instList = objIter.next();
+		for (int i = 0; i < objects.size(); i++) {
+			List<UAVObject> instList = objects.get(i);
 			if (instList.size() > 0) {
 				if ( (name != null && instList.get(0).getName().compareTo(name) == 0) || (name == null && instList.get(0).getObjID() == objId) ) {
 					return instList;
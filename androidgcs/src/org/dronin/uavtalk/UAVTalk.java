@@ -130,6 +130,7 @@ public class UAVTalk {
 
 	static final int ALL_INSTANCES = 0xFFFF;
 	static final int TX_BUFFER_SIZE = 2 * 1024;
+	static final int RX_BLOCK_SIZE = 256;
 
 	/**
 	 * Private data
@@ -149,6 +150,9 @@ public class UAVTalk {
 	// Variables used by the receive state machine
 	ByteBuffer rxTmpBuffer /* 4 */;
 	ByteBuffer rxBuffer;
+	byte[] rxBlock = new byte[RX_BLOCK_SIZE];
+	//! Reused for every packet sent, under the lock on this
+	ByteBuffer txBuffer;
 	int rxType;
 	long rxObjId;
 	long rxInstId;
@@ -195,6 +199,8 @@ public class UAVTalk {
 		rxTmpBuffer.order(ByteOrder.LITTLE_ENDIAN);
 		rxBuffer = ByteBuffer.allocate(MAX_PAYLOAD_LENGTH);
 		rxBuffer.order(ByteOrder.LITTLE_ENDIAN);
+		txBuffer = ByteBuffer.allocate(MAX_PACKET_LENGTH);
+		txBuffer.order(ByteOrder.LITTLE_ENDIAN);
 
 		// TOOD: Callback connect(io, SIGNAL(readyRead()), this,
 		// SLOT(processInputStream()));
@@ -221,19 +227,20 @@ public class UAVTalk {
 	 * @throws IOException
 	 */
 	public boolean processInputStream() throws IOException {
-		int val;
+		int len;
 
-		//inStream.wait();
-		val = inStream.read();
+		// Take whatever has arrived at once rather than a byte per call
+		len = inStream.read(rxBlock);
 
-		if (VERBOSE) Log.v(TAG, "Read: " + val);
+		if (VERBOSE) Log.v(TAG, "Read: " + len + " bytes");
 
-		if (val == -1) {
+		if (len == -1) {
 			return false;
 		}
 
-		 processInputByte(val);
-		 return true;
+		for (int i = 0; i < len; i++)
+			processInputByte(rxBlock[i] & 0xff);
+		return true;
 	}
 
 
@@ -820,14 +827,14 @@ public class UAVTalk {
 	 * @param[in] obj Object handle to send
 	 * @param[in] type Transaction type \return Success (true), Failure (false)
 	 */
-	private boolean transmitSingleObject(UAVObject obj, int type, boolean allInstances) throws IOException {
+	private synchronized boolean transmitSingleObject(UAVObject obj, int type, boolean allInstances) throws IOException {
 		int length;
 		int allInstId = ALL_INSTANCES;
 
 		assert (objMngr != null && outStream != null);
 
-		ByteBuffer bbuf = ByteBuffer.allocate(MAX_PACKET_LENGTH);
-		bbuf.order(ByteOrder.LITTLE_ENDIAN);
+		ByteBuffer bbuf = txBuffer;
+		bbuf.clear();
 
 		// Determine data length
 		if (type == TYPE_OBJ_REQ || type == TYPE_ACK) {
@@ -871,9 +878,6 @@ public class UAVTalk {
 		bbuf.put((byte) (updateCRC(0, bbuf.array(), bbuf.position()) & 0xff));
 
 		int packlen = bbuf.position();
-		bbuf.position(0);
-		byte[] dst = new byte[packlen];
-		bbuf.get(dst, 0, packlen);
 
 		if (type == TYPE_OBJ_ACK || type == TYPE_OBJ_REQ) {
 			// Once we send a UAVTalk packet that requires an ack or object let's set up
@@ -881,12 +885,12 @@ public class UAVTalk {
 			setupTransaction(obj, allInstances, type);
 		}
 
-		outStream.write(dst);
+		outStream.write(bbuf.array(), 0, packlen);
 
 
 		// Update stats
 		++stats.txObjects;
-		stats.txBytes += bbuf.position();
+		stats.txBytes += packlen;
 		stats.txObjectBytes += length;
 
 		// Done
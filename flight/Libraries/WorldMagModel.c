@@ -61,6 +61,22 @@ static WMMtype_Ellipsoid        Ellip;
 static WMMtype_MagneticModel    MagneticModel;
 static float                    decimal_date;
 
+// Field on a small grid around where it was last asked for, so that nearby
+// lookups can be interpolated instead of running the whole model
+#define MAG_GRID_NODES          3
+#define MAG_GRID_SPACING_DEG    1.0f
+#define MAG_GRID_MAX_ALT_DIFF   1000.0f   // m
+#define MAG_GRID_MAX_AGE_YEARS  0.1f
+
+static struct {
+	bool  valid;
+	float lat0;                 // south-west node
+	float lon0;
+	float alt;
+	float date;
+	float B[MAG_GRID_NODES][MAG_GRID_NODES][3];
+} mag_grid;
+
 /**************************************************************************************
 *   Example use - very simple - only two exposed functions
 *
@@ -70,6 +86,9 @@ static float                    decimal_date;
 *	e.g. Iceland in may of 2012 = WMM_GetMagVector(65.0, -20.0, 0.0, 5, 5, 2012, B);
 *	Alt is above the WGS-84 Ellipsoid
 *	B is the NED (XYZ) magnetic vector in nTesla
+*
+*	WMM_GetMagVectorCached() takes the same arguments, for callers that look
+*	the field up repeatedly over an area
 **************************************************************************************/
 
 int WMM_Initialize()
@@ -160,6 +179,106 @@ int WMM_GetMagVector(float Lat, float Lon, float AltEllipsoid, uint16_t Month, u
     return returned;
 }
 
+//! Wrap a longitude difference into -180..180
+static float wrap_lon(float lon)
+{
+	if (lon >= 180)
+		lon -= 360;
+	else if (lon < -180)
+		lon += 360;
+
+	return lon;
+}
+
+/**
+ * Evaluates the model on a grid centred on a point, MAG_GRID_SPACING_DEG
+ * apart, for WMM_GetMagVectorCached() to interpolate in.  Near the poles
+ * the grid is moved so it stays within range.
+ */
+static int WMM_BuildGrid(float Lat, float Lon, float AltEllipsoid, uint16_t Month, uint16_t Day, uint16_t Year)
+{
+    const float half = (MAG_GRID_NODES - 1) * MAG_GRID_SPACING_DEG / 2;
+
+    mag_grid.valid = false;
+    mag_grid.lat0 = Lat - half;
+    if (mag_grid.lat0 < -90)
+        mag_grid.lat0 = -90;
+    else if (mag_grid.lat0 > 90 - 2 * half)
+        mag_grid.lat0 = 90 - 2 * half;
+    mag_grid.lon0 = wrap_lon(Lon - half);
+    mag_grid.alt = AltEllipsoid;
+
+    for (int i = 0; i < MAG_GRID_NODES; i++) {
+        for (int j = 0; j < MAG_GRID_NODES; j++) {
+            int returned = WMM_GetMagVector(mag_grid.lat0 + i * MAG_GRID_SPACING_DEG,
+                    wrap_lon(mag_grid.lon0 + j * MAG_GRID_SPACING_DEG),
+                    AltEllipsoid, Month, Day, Year, mag_grid.B[i][j]);
+
+            if (returned < 0)
+                return returned;
+        }
+    }
+
+    // Left behind by WMM_GetMagVector
+    mag_grid.date = decimal_date;
+    mag_grid.valid = true;
+
+    return 0;
+}
+
+/**
+ * Same as WMM_GetMagVector(), but interpolated from a grid of the field
+ * around the first point asked for.  The grid is only evaluated again once
+ * a point falls outside it, or the altitude or date has moved too far from
+ * what it was evaluated for.  Its centre node is exact, so the first
+ * lookup gives the same answer as WMM_GetMagVector().
+ */
+int WMM_GetMagVectorCached(float Lat, float Lon, float AltEllipsoid, uint16_t Month, uint16_t Day, uint16_t Year, float B[3])
+{
+    if (Lat <  -90) return -1;  // error
+    if (Lat >   90) return -2;  // error
+
+    if (Lon < -180) return -3;  // error
+    if (Lon >  180) return -4;  // error
+
+    if (WMM_DateToYear(Month, Day, Year) < 0)
+        return -8;  // error
+
+    const float span = (MAG_GRID_NODES - 1) * MAG_GRID_SPACING_DEG;
+
+    float u = (Lat - mag_grid.lat0) / MAG_GRID_SPACING_DEG;
+    float v = wrap_lon(Lon - mag_grid.lon0) / MAG_GRID_SPACING_DEG;
+
+    if (!mag_grid.valid ||
+            u < 0 || u > span / MAG_GRID_SPACING_DEG ||
+            v < 0 || v > span / MAG_GRID_SPACING_DEG ||
+            fabsf(AltEllipsoid - mag_grid.alt) > MAG_GRID_MAX_ALT_DIFF ||
+            fabsf(decimal_date - mag_grid.date) > MAG_GRID_MAX_AGE_YEARS) {
+        int returned = WMM_BuildGrid(Lat, Lon, AltEllipsoid, Month, Day, Year);
+
+        if (returned < 0)
+            return returned;
+
+        u = (Lat - mag_grid.lat0) / MAG_GRID_SPACING_DEG;
+        v = wrap_lon(Lon - mag_grid.lon0) / MAG_GRID_SPACING_DEG;
+    }
+
+    // The cell the point is in, and where in it
+    int i = (u < MAG_GRID_NODES - 2) ? (int) u : MAG_GRID_NODES - 2;
+    int j = (v < MAG_GRID_NODES - 2) ? (int) v : MAG_GRID_NODES - 2;
+    float fu = u - i;
+    float fv = v - j;
+
+    for (int k = 0; k < 3; k++) {
+        float south = mag_grid.B[i][j][k] * (1 - fv) + mag_grid.B[i][j + 1][k] * fv;
+        float north = mag_grid.B[i + 1][j][k] * (1 - fv) + mag_grid.B[i + 1][j + 1][k] * fv;
+
+        B[k] = south * (1 - fu) + north * fu;
+    }
+
+    return 0;
+}
+
 int WMM_Geomag(WMMtype_CoordSpherical * CoordSpherical, WMMtype_CoordGeodetic * CoordGeodetic, WMMtype_GeoMagneticElements * GeoMagneticElements)
    /*
       The main subroutine that calls a sequence of WMM sub-functions to calculate the magnetic field elements for a single point.
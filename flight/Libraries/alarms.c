@@ -32,18 +32,34 @@
 
 #include "openpilot.h"
 #include "alarms.h"
-#include "pios_mutex.h"
 #include "pios_reset.h"
+#include "pios_thread.h"
 
 // Private constants
 
+//! Least time between pushes of the table into SystemAlarms
+#define ALARMS_SYNC_PERIOD_MS 50
+
 // Private types
 
 // Private variables
-static struct pios_mutex *lock;
+
+/* The severities, as the modules last set them.  This is what AlarmsGet
+ * and friends read; the SystemAlarms object follows it, pushed whenever an
+ * alarm changes but no more often than every ALARMS_SYNC_PERIOD_MS, so
+ * modules that set their alarm every cycle cost an atomic operation rather
+ * than two copies of the whole object. */
+static volatile uint8_t alarm_table[SYSTEMALARMS_ALARM_NUMELEM];
+
+//! Table has changes SystemAlarms hasn't seen
+static volatile uint8_t sync_pending;
+//! Someone is pushing the table right now
+static volatile uint8_t sync_busy;
+static volatile uint32_t last_sync;
 
 // Private functions
 static int32_t hasSeverity(SystemAlarmsAlarmOptions severity);
+static void syncAlarms(bool force);
 
 /**
  * Initialize the alarms library
@@ -51,8 +67,14 @@ static int32_t hasSeverity(SystemAlarmsAlarmOptions severity);
 int32_t AlarmsInitialize(void)
 {
 	SystemAlarmsInitialize();
-	lock = PIOS_Mutex_Create();
-	PIOS_Assert(lock != NULL);
+
+	uint8_t alarms[SYSTEMALARMS_ALARM_NUMELEM];
+
+	SystemAlarmsAlarmGet(alarms);
+
+	for (uint32_t n = 0; n < SYSTEMALARMS_ALARM_NUMELEM; n++) {
+		alarm_table[n] = alarms[n];
+	}
 
 	uint8_t reboot_reason = SYSTEMALARMS_REBOOTCAUSE_UNDEFINED;
 
@@ -96,29 +118,29 @@ int32_t AlarmsInitialize(void)
  */
 int32_t AlarmsSet(SystemAlarmsAlarmElem alarm, SystemAlarmsAlarmOptions severity)
 {
-	SystemAlarmsData alarms;
-
 	// Check that this is a valid alarm
 	if (alarm >= SYSTEMALARMS_ALARM_NUMELEM)
 	{
 		return -1;
 	}
 
-	// Lock
-	PIOS_Mutex_Lock(lock, PIOS_MUTEX_TIMEOUT_MAX);
+	uint8_t current;
 
-    // Read alarm and update its severity only if it was changed
-    SystemAlarmsGet(&alarms);
-    if ( alarms.Alarm[alarm] != severity )
-    {
-    	alarms.Alarm[alarm] = severity;
-    	SystemAlarmsSet(&alarms);
-    }
+	do {
+		current = alarm_table[alarm];
 
-    // Release lock
-    PIOS_Mutex_Unlock(lock);
-    return 0;
+		// Nothing to do if it's already at this severity
+		if (current == severity) {
+			syncAlarms(false);
+			return 0;
+		}
+	} while (!__sync_bool_compare_and_swap(&alarm_table[alarm], current,
+				severity));
+
+	sync_pending = 1;
+	syncAlarms(false);
 
+	return 0;
 }
 
 /**
@@ -128,17 +150,23 @@ int32_t AlarmsSet(SystemAlarmsAlarmElem alarm, SystemAlarmsAlarmOptions severity
  */
 SystemAlarmsAlarmOptions AlarmsGet(SystemAlarmsAlarmElem alarm)
 {
-	SystemAlarmsData alarms;
-
 	// Check that this is a valid alarm
 	if (alarm >= SYSTEMALARMS_ALARM_NUMELEM)
 	{
 		return 0;
 	}
 
-    // Read alarm
-    SystemAlarmsGet(&alarms);
-    return alarms.Alarm[alarm];
+	return alarm_table[alarm];
+}
+
+/**
+ * Push any changes to the alarms into SystemAlarms straight away, rather
+ * than waiting out the sync period.  Called periodically by the system
+ * module so the last change always gets out.
+ */
+void AlarmsSync(void)
+{
+	syncAlarms(true);
 }
 
 /**
@@ -218,30 +246,60 @@ int32_t AlarmsHasCritical()
  */
 static int32_t hasSeverity(SystemAlarmsAlarmOptions severity)
 {
-	SystemAlarmsData alarms;
 	uint32_t n;
 
-	// Lock
-	PIOS_Mutex_Lock(lock, PIOS_MUTEX_TIMEOUT_MAX);
-
-    // Read alarms
-    SystemAlarmsGet(&alarms);
-
     // Go through alarms and check if any are of the given severity or higher
     for (n = 0; n < SYSTEMALARMS_ALARM_NUMELEM; ++n)
     {
-    	if ( alarms.Alarm[n] >= severity)
+    	if ( alarm_table[n] >= severity)
     	{
-    		PIOS_Mutex_Unlock(lock);
     		return 1;
     	}
     }
 
     // If this point is reached then no alarms found
-	PIOS_Mutex_Unlock(lock);
     return 0;
 }
 
+/**
+ * Copies the table into SystemAlarms if it has changed, and either force is
+ * set or the last copy was long enough ago.  Only one caller does the copy
+ * at a time; the others leave the change pending for the next call.
+ */
+static void syncAlarms(bool force)
+{
+	if (!sync_pending) {
+		return;
+	}
+
+	uint32_t now = PIOS_Thread_Systime();
+
+	if (!force && (now - last_sync) < ALARMS_SYNC_PERIOD_MS) {
+		return;
+	}
+
+	if (!__sync_bool_compare_and_swap(&sync_busy, 0, 1)) {
+		return;
+	}
+
+	// Cleared first, so a change made while copying is pushed next time
+	sync_pending = 0;
+	__sync_synchronize();
+
+	uint8_t alarms[SYSTEMALARMS_ALARM_NUMELEM];
+
+	for (uint32_t n = 0; n < SYSTEMALARMS_ALARM_NUMELEM; n++) {
+		alarms[n] = alarm_table[n];
+	}
+
+	SystemAlarmsAlarmSet(alarms);
+
+	last_sync = now;
+
+	__sync_synchronize();
+	sync_busy = 0;
+}
+
 static const char alarm_names[][10] = {
 	[SYSTEMALARMS_ALARM_OUTOFMEMORY] = "MEMORY",
 	[SYSTEMALARMS_ALARM_CPUOVERLOAD] = "CPU",
@@ -0,0 +1,324 @@
+/**
+ ******************************************************************************
+ * @addtogroup Libraries Libraries
+ * @{
+ *
+ * @file       blackbox.c
+ * @author     dRonin, http://dronin.org Copyright (C) 2017
+ * @brief      Compact control loop log written straight from stabilization
+ *
+ * The stabilization loop encodes one fixed-schema frame per (divided) loop
+ * and drops it into a lock-free byte queue; the logging task takes whole
+ * chunks' worth of bytes back out and writes them to the log.  Nothing here
+ * goes through UAVObjects, so it stays cheap enough to run at the loop rate.
+ * If the log falls behind, frames are dropped and the next one written is a
+ * keyframe, so the decoder picks up again right away.
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "openpilot.h"
+#include "blackbox.h"
+#include "pios_spsc_queue.h"
+#include "pios_crc.h"
+
+#include "actuatorcommand.h"
+
+// Private constants
+#define QUEUE_LEN		2048
+#define CHUNK_SYNC		0x3C
+#define CHUNK_MAX_FRAME_BYTES	(BLACKBOX_CHUNK_MAX_LENGTH - \
+		BLACKBOX_CHUNK_HEADER_LENGTH - 1)
+#define NO_FRAME_START		0xFF
+
+//! Values are clamped so that deltas between them can't overflow
+#define MAX_VALUE		(1 << 28)
+//! Tag, time and every field as five byte varints, at worst
+#define MAX_FRAME_LEN		(1 + 5 + 5 * BLACKBOX_NUM_FIELDS)
+
+DONT_BUILD_IF(MAX_FRAME_LEN - 1 > BLACKBOX_FRAME_KEYFRAME - 1, FrameLenTooBig);
+DONT_BUILD_IF(BLACKBOX_NUM_OUTPUTS != ACTUATORCOMMAND_CHANNEL_NUMELEM,
+		OutputsMismatch);
+
+// Private variables
+static struct pios_spsc_queue *queue;
+static volatile bool enabled;
+static volatile uint32_t dropped;
+
+static volatile float outputs[BLACKBOX_NUM_OUTPUTS];
+
+/* Only touched by the stabilization loop while enabled */
+static int32_t prev_values[BLACKBOX_NUM_FIELDS];
+static uint32_t prev_time;
+static uint8_t frames_since_keyframe;
+static bool need_keyframe;
+static uint8_t divider;
+static uint8_t divider_count;
+
+/* Only touched by the logging task */
+static uint16_t frame_left;
+static uint16_t chunk_seq;
+
+/**
+ * Allocates the frame queue.  Until then, nothing is logged.
+ * \return 0 on success, -1 if out of memory
+ */
+int32_t blackbox_init(void)
+{
+	if (queue)
+		return 0;
+
+	queue = PIOS_SPSC_Queue_Create(1, QUEUE_LEN, CHUNK_MAX_FRAME_BYTES);
+
+	if (!queue)
+		return -1;
+
+	return 0;
+}
+
+/**
+ * Starts taking frames from the control loop, from a keyframe.  Called by
+ * the logging task, which is the only caller of blackbox_get_chunk.
+ * \param[in] loop_divider log one control loop out of this many
+ */
+void blackbox_start(uint8_t loop_divider)
+{
+	if (!queue)
+		return;
+
+	enabled = false;
+
+	/* Throw away whatever is left from the last log */
+	uint16_t num;
+
+	while (PIOS_SPSC_Queue_Peek(queue, &num, 0))
+		PIOS_SPSC_Queue_Consume(queue, num, NULL);
+
+	frame_left = 0;
+
+	divider = loop_divider ? loop_divider : 1;
+	divider_count = 0;
+	need_keyframe = true;
+	dropped = 0;
+
+	enabled = true;
+}
+
+/**
+ * Stops taking frames from the control loop.
+ */
+void blackbox_stop(void)
+{
+	enabled = false;
+}
+
+/**
+ * Records the latest outputs, to go in the next frame.
+ * \param[in] channels actuator output values
+ * \param[in] num_channels number of values
+ */
+void blackbox_log_outputs(const float *channels, uint8_t num_channels)
+{
+	if (!enabled)
+		return;
+
+	if (num_channels > BLACKBOX_NUM_OUTPUTS)
+		num_channels = BLACKBOX_NUM_OUTPUTS;
+
+	for (int i = 0; i < num_channels; i++)
+		outputs[i] = channels[i];
+}
+
+static int32_t blackbox_quantize(float value, float scale)
+{
+	float scaled = value * scale;
+
+	/* Written so that NaN comes out as 0 */
+	if (scaled >= MAX_VALUE)
+		return MAX_VALUE;
+	if (scaled <= -MAX_VALUE)
+		return -MAX_VALUE;
+	if (!(scaled == scaled))
+		return 0;
+
+	return (int32_t) (scaled + ((scaled < 0) ? -0.5f : 0.5f));
+}
+
+static uint8_t *blackbox_put_varint(uint8_t *p, uint32_t value)
+{
+	while (value >= 0x80) {
+		*(p++) = value | 0x80;
+		value >>= 7;
+	}
+
+	*(p++) = value;
+
+	return p;
+}
+
+static uint32_t blackbox_zigzag(int32_t value)
+{
+	return ((uint32_t) value << 1) ^ (uint32_t) (value >> 31);
+}
+
+static uint8_t *blackbox_put_value(uint8_t *p, int field, bool keyframe,
+		int32_t value)
+{
+	int32_t coded = keyframe ? value : value - prev_values[field];
+
+	prev_values[field] = value;
+
+	return blackbox_put_varint(p, blackbox_zigzag(coded));
+}
+
+/**
+ * Logs one pass of the control loop.  Must only be called from the
+ * stabilization task.
+ * \param[in] gyro filtered rates, deg/s
+ * \param[in] rate_desired rate setpoints, deg/s
+ * \param[in] actuator_desired roll, pitch, yaw and thrust commands
+ */
+void blackbox_log_loop(const float *gyro, const float *rate_desired,
+		const float *actuator_desired)
+{
+	if (!enabled)
+		return;
+
+	if (++divider_count < divider)
+		return;
+
+	divider_count = 0;
+
+	uint32_t now = PIOS_DELAY_GetuS();
+
+	bool keyframe = need_keyframe ||
+		(frames_since_keyframe >= BLACKBOX_KEYFRAME_INTERVAL - 1);
+
+	uint8_t frame[MAX_FRAME_LEN];
+	uint8_t *p = frame + 1;
+
+	p = blackbox_put_varint(p, keyframe ? now : now - prev_time);
+
+	/* prev_values may be left part updated if the frame gets dropped,
+	 * but then the next one is a keyframe anyway.
+	 */
+	int n = 0;
+
+	for (int i = 0; i < BLACKBOX_NUM_AXES; i++)
+		p = blackbox_put_value(p, n++, keyframe,
+				blackbox_quantize(gyro[i], BLACKBOX_GYRO_SCALE));
+
+	for (int i = 0; i < BLACKBOX_NUM_AXES; i++)
+		p = blackbox_put_value(p, n++, keyframe,
+				blackbox_quantize(rate_desired[i],
+					BLACKBOX_RATE_SCALE));
+
+	for (int i = 0; i < BLACKBOX_NUM_DESIRED; i++)
+		p = blackbox_put_value(p, n++, keyframe,
+				blackbox_quantize(actuator_desired[i],
+					BLACKBOX_DESIRED_SCALE));
+
+	for (int i = 0; i < BLACKBOX_NUM_OUTPUTS; i++)
+		p = blackbox_put_value(p, n++, keyframe,
+				blackbox_quantize(outputs[i],
+					BLACKBOX_OUTPUT_SCALE));
+
+	uint16_t len = p - frame;
+
+	frame[0] = (keyframe ? BLACKBOX_FRAME_KEYFRAME : 0) | (len - 1);
+
+	/* Only this side adds to the queue, so the space can only grow
+	 * between checking it and sending.  A frame goes in whole or not at
+	 * all.
+	 */
+	if (PIOS_SPSC_Queue_Space(queue) < len) {
+		dropped++;
+		need_keyframe = true;
+		return;
+	}
+
+	PIOS_SPSC_Queue_Send(queue, frame, len, NULL);
+
+	prev_time = now;
+	need_keyframe = false;
+
+	if (keyframe)
+		frames_since_keyframe = 0;
+	else
+		frames_since_keyframe++;
+}
+
+/**
+ * Takes queued frames out as one chunk, ready to write to the log.
+ * \param[out] buf storage for BLACKBOX_CHUNK_MAX_LENGTH bytes
+ * \param[in] timeout_ms how long to wait for a full chunk
+ * \return length of the chunk, or 0 if no frames were queued
+ */
+uint16_t blackbox_get_chunk(uint8_t *buf, uint32_t timeout_ms)
+{
+	if (!queue)
+		return 0;
+
+	uint8_t *frames = buf + BLACKBOX_CHUNK_HEADER_LENGTH;
+
+	uint16_t got = PIOS_SPSC_Queue_Receive(queue, frames,
+			CHUNK_MAX_FRAME_BYTES, timeout_ms, NULL);
+
+	if (!got)
+		return 0;
+
+	/* Find where the first frame starting in this chunk is, and how much
+	 * of the last one is still to come.
+	 */
+	uint16_t pos = frame_left;
+	uint8_t first = (pos < got) ? pos : NO_FRAME_START;
+
+	while (pos < got)
+		pos += 1 + (frames[pos] & ~BLACKBOX_FRAME_KEYFRAME);
+
+	frame_left = pos - got;
+
+	uint16_t size = BLACKBOX_CHUNK_HEADER_LENGTH + got;
+
+	buf[0] = CHUNK_SYNC;
+	buf[1] = BLACKBOX_CHUNK_TYPE;
+	buf[2] = size & 0xff;
+	buf[3] = size >> 8;
+	buf[4] = chunk_seq & 0xff;
+	buf[5] = chunk_seq >> 8;
+	buf[6] = first;
+	buf[7] = BLACKBOX_NUM_FIELDS;
+
+	buf[size] = PIOS_CRC_updateCRC(0, buf, size);
+
+	chunk_seq++;
+
+	return size + 1;
+}
+
+/**
+ * \return frames dropped since blackbox_start, because the log fell behind
+ */
+uint32_t blackbox_dropped_frames(void)
+{
+	return dropped;
+}
+
+/**
+ * @}
+ */
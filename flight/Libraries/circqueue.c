@@ -175,6 +175,9 @@ int circ_queue_advance_write_multi(circ_queue_t q, uint16_t amt) {
 		 * advance later. */
 	}
 
+	/* The data has to be in place before the reader can see it */
+	__sync_synchronize();
+
 	q->write_head = new_write_head;
 
 	return 0;
@@ -263,6 +266,9 @@ void circ_queue_read_completed(circ_queue_t q) {
 	 */
 	PIOS_Assert(read_tail != q->write_head);
 
+	/* Finish reading before the writer may reuse the slot */
+	__sync_synchronize();
+
 	q->read_tail = next_pos(q->num_elem, read_tail);
 }
 
@@ -296,6 +302,8 @@ void circ_queue_read_completed_multi(circ_queue_t q, uint16_t num) {
 
 	PIOS_Assert((read_tail > orig_read_tail) || (read_tail == 0));
 
+	__sync_synchronize();
+
 	q->read_tail = read_tail;
 }
 
@@ -37,6 +37,7 @@
 
 #include "modulesettings.h"
 #include "misc_math.h"
+#include "geofmt.h"
 #include "physical_constants.h"
 #include "attitudeactual.h"
 #include "baroaltitude.h"
@@ -431,8 +432,7 @@ bool frsky_encode_gps_coord(struct frsky_settings *frsky, uint32_t *value, bool
 		else
 			frsky_coord = 3 << 30;
 	}
-	coord = abs(coord);
-	frsky_coord |= (((uint64_t)coord * 6ull) / 100);
+	frsky_coord |= geofmt_minutes_e4(coord);
 
 	*value = frsky_coord;
 	return true;
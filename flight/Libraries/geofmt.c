@@ -0,0 +1,492 @@
+/**
+ ******************************************************************************
+ * @addtogroup Libraries Libraries
+ * @{
+ *
+ * @file       geofmt.c
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2017
+ * @brief      Fixed point UTM/MGRS conversion and number formatting
+ *
+ * The OSD and the telemetry bridges show positions on every update.  The
+ * mgrs library does that with double precision trig, in software on all our
+ * targets, and printf.  This gets the same UTM coordinates, to a few cm,
+ * with 64 bit integers only, and formats numbers without varargs.
+ *
+ * The projection is the series of the mgrs library's tranmerc.c, on WGS84,
+ * with each term rewritten in powers of sin and cos of the latitude so that
+ * none of them grows near the poles.  Values are Q30 fixed point unless
+ * said otherwise, and lengths are in 1/256 m.
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "geofmt.h"
+
+#define Q30_ONE (1LL << 30)
+#define LEN_ONE 256
+
+#define DEG_E7 10000000
+
+//! Radians per 1e-7 degree, Q60
+#define RAD_PER_E7_Q60 2012227627LL
+//! WGS84 first and second eccentricity squared
+#define ES_Q30 7188036LL
+#define EBS_Q30 7236480LL
+//! WGS84 semi-major axis
+#define A_LEN (6378137LL * LEN_ONE)
+//! Meridian distance series; the first term is per 1e-7 degree, Q30
+#define AP_LEN_Q30 3054799339LL
+#define BP_LEN 4105858LL
+#define CP_LEN 4309LL
+#define DP_LEN 6LL
+
+#define UTM_SCALE_NUM 9996
+#define UTM_SCALE_DEN 10000
+#define UTM_FALSE_EASTING (500000LL * LEN_ONE)
+#define UTM_FALSE_NORTHING_S (10000000LL * LEN_ONE)
+#define UTM_MIN_LAT (-80 * DEG_E7)
+#define UTM_MAX_LAT (84 * DEG_E7)
+
+#define CORDIC_ITERATIONS 40
+//! CORDIC gain for CORDIC_ITERATIONS, Q40
+#define CORDIC_GAIN_Q40 667681663043LL
+
+//! atan(2^-i), Q40
+static const int64_t cordic_atan_q40[CORDIC_ITERATIONS] = {
+	863554413089LL, 509785937287LL, 269356888665LL, 136729762476LL,
+	68630207382LL, 34348560106LL, 17178471287LL, 8589759836LL,
+	4294945451LL, 2147480917LL, 1073741483LL, 536870869LL,
+	268435451LL, 134217727LL, 67108864LL, 33554432LL,
+	16777216LL, 8388608LL, 4194304LL, 2097152LL,
+	1048576LL, 524288LL, 262144LL, 131072LL,
+	65536LL, 32768LL, 16384LL, 8192LL,
+	4096LL, 2048LL, 1024LL, 512LL,
+	256LL, 128LL, 64LL, 32LL,
+	16LL, 8LL, 4LL, 2LL,
+};
+
+//! Latitude bands from -80 degrees, 8 degrees each; X runs on to 84
+static const char utm_bands[] = "CDEFGHJKLMNPQRSTUVWX";
+
+//! Powers of ten that fit in 32 bits
+static const uint32_t pow10[] = {
+	1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000,
+	1000000000,
+};
+
+static inline int64_t qmul(int64_t a, int64_t b)
+{
+	return (a * b + (1LL << 29)) >> 30;
+}
+
+/**
+ * x * (k[0] + k[1] eta + k[2] eta^2 + ...), for eta as small as the second
+ * eccentricity
+ */
+static int64_t eta_poly(int64_t x, int64_t eta, const int16_t *k, int n)
+{
+	int64_t acc = 0;
+
+	for (int i = n - 1; i >= 1; i--) {
+		acc = qmul(acc + k[i] * Q30_ONE, eta);
+	}
+
+	return k[0] * x + qmul(x, acc);
+}
+
+static void cordic_sincos(int64_t angle_q40, int64_t *s, int64_t *c)
+{
+	int64_t x = CORDIC_GAIN_Q40;
+	int64_t y = 0;
+	int64_t z = angle_q40;
+
+	for (int i = 0; i < CORDIC_ITERATIONS; i++) {
+		int64_t dx = y >> i;
+		int64_t dy = x >> i;
+
+		if (z >= 0) {
+			x -= dx;
+			y += dy;
+			z -= cordic_atan_q40[i];
+		} else {
+			x += dx;
+			y -= dy;
+			z += cordic_atan_q40[i];
+		}
+	}
+
+	*s = (y + (1 << 9)) >> 10;
+	*c = (x + (1 << 9)) >> 10;
+}
+
+static uint64_t isqrt64(uint64_t v)
+{
+	uint64_t root = 0;
+	uint64_t bit = 1ULL << 62;
+
+	while (bit > v) {
+		bit >>= 2;
+	}
+
+	while (bit) {
+		if (v >= root + bit) {
+			v -= root + bit;
+			root = (root >> 1) + bit;
+		} else {
+			root >>= 1;
+		}
+
+		bit >>= 2;
+	}
+
+	return root;
+}
+
+static int64_t utm_scale(int64_t len)
+{
+	return len * UTM_SCALE_NUM / UTM_SCALE_DEN;
+}
+
+/**
+ * Zone for a position, with the exceptions around Norway and Svalbard
+ */
+static uint8_t utm_zone(int32_t lat_e7, int32_t lon_e7)
+{
+	// From 0 to 360 east, so that the exceptions only match east of 0
+	uint32_t lon_east = lon_e7 + ((lon_e7 < 0) ? 360U * DEG_E7 : 0);
+	int32_t lat_deg = lat_e7 / DEG_E7;
+	uint32_t lon_deg = lon_east / DEG_E7;
+	uint8_t zone = (lon_deg / 6 + 30) % 60 + 1;
+
+	if (lat_deg > 55 && lat_deg < 64 && lon_deg < 3) {
+		zone = 31;
+	} else if (lat_deg > 55 && lat_deg < 64 && lon_deg < 12) {
+		zone = 32;
+	} else if (lat_deg > 71 && lon_deg < 42) {
+		if (lon_deg < 9) {
+			zone = 31;
+		} else if (lon_deg < 21) {
+			zone = 33;
+		} else if (lon_deg < 33) {
+			zone = 35;
+		} else {
+			zone = 37;
+		}
+	}
+
+	return zone;
+}
+
+/**
+ * Projects onto a zone
+ * \param[out] easting In 1/256 m
+ * \param[out] northing In 1/256 m, with the false northing in the south
+ */
+static void utm_project(int32_t lat_e7, int32_t lon_e7, uint8_t zone,
+		int64_t *easting, int64_t *northing)
+{
+	int64_t dlam_e7 = (int64_t) lon_e7 - (6 * zone - 183) * (int64_t) DEG_E7;
+
+	if (dlam_e7 > 180 * (int64_t) DEG_E7) {
+		dlam_e7 -= 360 * (int64_t) DEG_E7;
+	} else if (dlam_e7 < -180 * (int64_t) DEG_E7) {
+		dlam_e7 += 360 * (int64_t) DEG_E7;
+	}
+
+	int64_t s, c;
+	cordic_sincos((lat_e7 * RAD_PER_E7_Q60 + (1LL << 19)) >> 20, &s, &c);
+
+	int64_t l = (dlam_e7 * RAD_PER_E7_Q60 + (1LL << 29)) >> 30;
+	int64_t l2 = qmul(l, l);
+	int64_t l3 = qmul(l2, l);
+	int64_t l4 = qmul(l2, l2);
+	int64_t l5 = qmul(l4, l);
+	int64_t l6 = qmul(l4, l2);
+	int64_t l7 = qmul(l6, l);
+	int64_t l8 = qmul(l4, l4);
+
+	int64_t s2 = qmul(s, s);
+	int64_t c2 = qmul(c, c);
+	int64_t c3 = qmul(c2, c);
+	int64_t c5 = qmul(c3, c2);
+	int64_t c7 = qmul(c5, c2);
+	int64_t s2c = qmul(s2, c);
+	int64_t s2c3 = qmul(s2, c3);
+	int64_t s2c5 = qmul(s2, c5);
+	int64_t s4c = qmul(s2c, s2);
+	int64_t s4c3 = qmul(s2c3, s2);
+	int64_t s6c = qmul(s4c, s2);
+
+	int64_t eta = qmul(EBS_Q30, c2);
+
+	// Radius of curvature in the prime vertical
+	int64_t sn = (A_LEN << 30) /
+		(int64_t) isqrt64((uint64_t) (Q30_ONE - qmul(ES_Q30, s2)) << 30);
+
+	// Meridian distance, from sin(2 lat), sin(4 lat), sin(6 lat)
+	int64_t sin2 = 2 * qmul(s, c);
+	int64_t cos2 = c2 - s2;
+	int64_t sin4 = 2 * qmul(sin2, cos2);
+	int64_t cos4 = qmul(cos2, cos2) - qmul(sin2, sin2);
+	int64_t sin6 = qmul(sin4, cos2) + qmul(cos4, sin2);
+	int64_t tmd = ((lat_e7 * AP_LEN_Q30 + (1LL << 29)) >> 30) -
+		qmul(BP_LEN, sin2) + qmul(CP_LEN, sin4) - qmul(DP_LEN, sin6);
+
+	static const int16_t e3_c3[] = { 1, 1 };
+	static const int16_t e5_c5[] = { 5, 14, 13, 4 };
+	static const int16_t e5_s2c3[] = { 18, 58, 64, 24 };
+
+	int64_t e = qmul(c, l) +
+		qmul((eta_poly(c3, eta, e3_c3, 2) - s2c) / 6, l3) +
+		qmul((eta_poly(c5, eta, e5_c5, 4) -
+			eta_poly(s2c3, eta, e5_s2c3, 4) + s4c) / 120, l5) +
+		qmul((61 * c7 - 479 * s2c5 + 179 * s4c3 - s6c) / 5040, l7);
+
+	static const int16_t n4_c3[] = { 5, 9, 4 };
+	static const int16_t n6_c5[] = { 61, 270, 445, 324, 88 };
+	static const int16_t n6_s2c3[] = { 58, 330, 680, 600, 192 };
+
+	// In sin(lat) * these; s^2 c^n is tan^2 * c^(n+2)
+	int64_t n = qmul(c, l2) / 2 +
+		qmul((eta_poly(c3, eta, n4_c3, 3) - s2c) / 24, l4) +
+		qmul((eta_poly(c5, eta, n6_c5, 5) -
+			eta_poly(s2c3, eta, n6_s2c3, 5) + s4c) / 720, l6) +
+		qmul((1385 * c7 - 3111 * s2c5 + 543 * s4c3 - s6c) / 40320, l8);
+
+	*easting = UTM_FALSE_EASTING + utm_scale(qmul(sn, e));
+	*northing = utm_scale(tmd + qmul(qmul(sn, s), n));
+
+	if (lat_e7 < 0) {
+		*northing += UTM_FALSE_NORTHING_S;
+	}
+}
+
+/**
+ * Converts a position to UTM
+ * \param[in] lat_e7 Latitude, in 1e-7 degrees
+ * \param[in] lon_e7 Longitude, in 1e-7 degrees
+ * \param[out] utm
+ * \return 0 if converted, -1 if the position is in the polar regions
+ */
+int32_t geofmt_utm(int32_t lat_e7, int32_t lon_e7, struct geofmt_utm *utm)
+{
+	if (lat_e7 < UTM_MIN_LAT || lat_e7 > UTM_MAX_LAT) {
+		return -1;
+	}
+
+	int64_t easting, northing;
+
+	utm->zone = utm_zone(lat_e7, lon_e7);
+	utm->band = (lat_e7 >= 72 * DEG_E7) ? 'X' :
+		utm_bands[(lat_e7 - UTM_MIN_LAT) / (8 * DEG_E7)];
+	utm->south = lat_e7 < 0;
+
+	utm_project(lat_e7, lon_e7, utm->zone, &easting, &northing);
+
+	utm->easting_cm = (easting * 100 + LEN_ONE / 2) / LEN_ONE;
+	utm->northing_cm = (northing * 100 + LEN_ONE / 2) / LEN_ONE;
+
+	return 0;
+}
+
+/**
+ * Rounds a length to a number of units, a half to even
+ */
+static uint32_t round_units(int64_t len, int64_t unit)
+{
+	uint32_t units = len / unit;
+	int64_t rem = len % unit;
+
+	if (2 * rem > unit || (2 * rem == unit && (units & 1))) {
+		units++;
+	}
+
+	return units;
+}
+
+/**
+ * Converts a position to an MGRS reference, as the mgrs library would
+ * \param[in] lat_e7 Latitude, in 1e-7 degrees
+ * \param[in] lon_e7 Longitude, in 1e-7 degrees
+ * \param[in] precision Digits of easting and northing, 1 - 5
+ * \param[out] buf At least GEOFMT_MGRS_LEN long
+ * \return 0 if converted, -1 if the position is in the polar regions, where
+ * MGRS is based on UPS instead
+ */
+int32_t geofmt_mgrs(int32_t lat_e7, int32_t lon_e7, uint8_t precision,
+		char *buf)
+{
+	if (lat_e7 < UTM_MIN_LAT || lat_e7 > UTM_MAX_LAT ||
+			precision < 1 || precision > 5) {
+		return -1;
+	}
+
+	uint8_t zone = utm_zone(lat_e7, lon_e7);
+	int64_t unit = pow10[5 - precision] * (int64_t) LEN_ONE;
+	int64_t easting, northing;
+
+	utm_project(lat_e7, lon_e7, zone, &easting, &northing);
+
+	uint32_t east = round_units(easting, unit) * pow10[5 - precision];
+
+	if (zone == 31 && lat_e7 >= 56 * DEG_E7 && lat_e7 < 64 * DEG_E7 &&
+			(lon_e7 >= 3 * DEG_E7 || east >= 500000)) {
+		// Rounded over the edge of 31V, which is cut short for 32V
+		zone = 32;
+		utm_project(lat_e7, lon_e7, zone, &easting, &northing);
+		east = round_units(easting, unit) * pow10[5 - precision];
+	}
+
+	uint32_t north = round_units(northing, unit) * pow10[5 - precision];
+	char band = (lat_e7 >= 72 * DEG_E7) ? 'X' :
+		utm_bands[(lat_e7 - UTM_MIN_LAT) / (8 * DEG_E7)];
+
+	if (lat_e7 <= 0 && north == 10000000) {
+		band = 'N';
+		north = 0;
+	}
+
+	if (band == 'V' && zone == 31 && east == 500000) {
+		// Keeps to the last column of 31V
+		east = 499999;
+	}
+
+	// Square letters: columns repeat every 3 zones, rows every 2
+	uint8_t set = zone % 6;
+	char col_first = "SAJSAJ"[set];
+	uint32_t row = ((north % 2000000) + ((set % 2) ? 0 : 500000)) % 2000000;
+	char row_letter = 'A' + row / 100000;
+	char col_letter = col_first + east / 100000 - 1;
+
+	if (row_letter > 'H') {
+		row_letter++;
+	}
+
+	if (row_letter > 'N') {
+		row_letter++;
+	}
+
+	if (col_first == 'J' && col_letter > 'N') {
+		col_letter++;
+	}
+
+	char *p = geofmt_uint(buf, zone, 2);
+	*p++ = band;
+	*p++ = col_letter;
+	*p++ = row_letter;
+	*p++ = ' ';
+	p = geofmt_uint(p, (east % 100000) / pow10[5 - precision], precision);
+	*p++ = ' ';
+	geofmt_uint(p, (north % 100000) / pow10[5 - precision], precision);
+
+	return 0;
+}
+
+/**
+ * An angle in minutes
+ * \param[in] deg_e7 Angle in 1e-7 degrees
+ * \return Its magnitude, in 1/10000 minutes
+ */
+uint32_t geofmt_minutes_e4(int32_t deg_e7)
+{
+	uint32_t v = (deg_e7 < 0) ? -(int64_t) deg_e7 : deg_e7;
+
+	// The degrees come out whole, which keeps it all in 32 bits
+	return (v / DEG_E7) * 600000 + (v % DEG_E7) * 6 / 100;
+}
+
+/**
+ * Splits an angle into degrees and minutes, as NMEA and most telemetry
+ * protocols carry it
+ * \param[in] deg_e7 Angle in 1e-7 degrees
+ * \param[out] dm
+ */
+void geofmt_deg_min(int32_t deg_e7, struct geofmt_deg_min *dm)
+{
+	uint32_t minutes_e4 = geofmt_minutes_e4(deg_e7);
+
+	dm->negative = deg_e7 < 0;
+	dm->degrees = minutes_e4 / 600000;
+	dm->minutes = (minutes_e4 / 10000) % 60;
+	dm->minutes_e4 = minutes_e4 % 10000;
+}
+
+/**
+ * Writes a number in decimal, and terminates it
+ * \param[out] buf Room for the digits and the terminator
+ * \param[in] value
+ * \param[in] min_digits Pads with zeros to this many digits
+ * \return Where the terminator went, to go on writing from
+ */
+char *geofmt_uint(char *buf, uint32_t value, uint8_t min_digits)
+{
+	char digits[10];
+	uint8_t n = 0;
+
+	do {
+		digits[n++] = '0' + value % 10;
+		value /= 10;
+	} while (value);
+
+	while (min_digits > n) {
+		*buf++ = '0';
+		min_digits--;
+	}
+
+	while (n) {
+		*buf++ = digits[--n];
+	}
+
+	*buf = 0;
+
+	return buf;
+}
+
+/**
+ * Writes a fixed point number with some of its decimals, rounded, as
+ * %0.Nf would
+ * \param[out] buf Room for the sign, digits, point and terminator
+ * \param[in] value The number, times 10^scale
+ * \param[in] scale Decimal digits in value, up to 9
+ * \param[in] decimals Decimals to show, up to scale
+ * \return Where the terminator went, to go on writing from
+ */
+char *geofmt_fixed(char *buf, int32_t value, uint8_t scale, uint8_t decimals)
+{
+	uint32_t v = (value < 0) ? -(int64_t) value : value;
+	uint32_t drop = pow10[scale - decimals];
+
+	v = v / drop + ((v % drop) >= (drop + 1) / 2 && drop > 1);
+
+	if (value < 0 && v) {
+		*buf++ = '-';
+	}
+
+	buf = geofmt_uint(buf, v / pow10[decimals], 1);
+
+	if (decimals) {
+		*buf++ = '.';
+		buf = geofmt_uint(buf, v % pow10[decimals], decimals);
+	}
+
+	return buf;
+}
+
+/**
+ * @}
+ */
@@ -0,0 +1,58 @@
+/**
+ ******************************************************************************
+ * @addtogroup Libraries Libraries
+ * @{
+ *
+ * @file       aes128.h
+ * @author     dRonin, http://dronin.org Copyright (C) 2017
+ * @brief      AES-128 encryption, with the counter and CMAC modes built on it
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef AES128_H
+#define AES128_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define AES128_BLOCK_SIZE	16
+#define AES128_KEY_SIZE		16
+
+/**
+ * Expanded key, and the CMAC subkeys that go with it
+ */
+struct aes128_ctx {
+	uint32_t rk[44];
+	uint8_t k1[AES128_BLOCK_SIZE];
+	uint8_t k2[AES128_BLOCK_SIZE];
+};
+
+void aes128_setkey(struct aes128_ctx *ctx, const uint8_t *key);
+void aes128_encrypt(const struct aes128_ctx *ctx, const uint8_t *in,
+		uint8_t *out);
+void aes128_ctr(const struct aes128_ctx *ctx, const uint8_t *iv,
+		uint8_t *data, size_t len);
+void aes128_cmac(const struct aes128_ctx *ctx, const uint8_t *data,
+		size_t len, uint8_t *mac);
+
+#endif /* AES128_H */
+
+/**
+ * @}
+ */
@@ -0,0 +1,95 @@
+/**
+ ******************************************************************************
+ * @addtogroup Libraries Libraries
+ * @{
+ *
+ * @file       blackbox.h
+ * @author     dRonin, http://dronin.org Copyright (C) 2017
+ * @brief      Compact control loop log written straight from stabilization
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+#ifndef BLACKBOX_H
+#define BLACKBOX_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Stream format
+ *
+ * Frames are packed into chunks framed like UAVTalk packets, so they sit in
+ * the same log as ordinary objects and old parsers step over them:
+ *
+ *   sync(1) = 0x3C, type(1) = 0x2B, size(2), seq(2), first(1), fields(1),
+ *   frame bytes, crc8(1)
+ *
+ * size counts everything but the CRC.  seq goes up by one each chunk, so
+ * lost chunks can be spotted.  first is the offset into the frame bytes of
+ * the first frame that starts in this chunk (0xFF if none does); frames
+ * carry on across chunks.  fields is the number of fields in each frame.
+ *
+ * Each frame is a tag byte, with bit 7 set on keyframes and the length of
+ * the rest of the frame in the low 7 bits, then varints:
+ *
+ *   keyframe: time (us), then every field's value, zigzag encoded
+ *   delta:    time since the last frame (us), then every field's change
+ *             since the last frame, zigzag encoded
+ *
+ * Varints are little endian, 7 bits a byte, with bit 7 set on all but the
+ * last byte.  A keyframe comes every BLACKBOX_KEYFRAME_INTERVAL frames and
+ * right after any frame is dropped.  Fields are scaled to integers as
+ * given below, in this order.
+ */
+
+#define BLACKBOX_CHUNK_TYPE		0x2B
+#define BLACKBOX_CHUNK_HEADER_LENGTH	8
+#define BLACKBOX_CHUNK_MAX_LENGTH	255
+
+#define BLACKBOX_FRAME_KEYFRAME		0x80
+#define BLACKBOX_KEYFRAME_INTERVAL	32
+
+#define BLACKBOX_NUM_AXES		3
+#define BLACKBOX_NUM_DESIRED		4
+#define BLACKBOX_NUM_OUTPUTS		10
+
+//! Gyros x, y, z in 1/16 deg/s
+#define BLACKBOX_GYRO_SCALE		16.0f
+//! RateDesired Roll, Pitch, Yaw in 1/16 deg/s
+#define BLACKBOX_RATE_SCALE		16.0f
+//! ActuatorDesired Roll, Pitch, Yaw, Thrust in 1/10000
+#define BLACKBOX_DESIRED_SCALE		10000.0f
+//! ActuatorCommand Channel in us (or the raw output value)
+#define BLACKBOX_OUTPUT_SCALE		1.0f
+
+#define BLACKBOX_NUM_FIELDS		(2 * BLACKBOX_NUM_AXES + \
+		BLACKBOX_NUM_DESIRED + BLACKBOX_NUM_OUTPUTS)
+
+int32_t blackbox_init(void);
+void blackbox_start(uint8_t divider);
+void blackbox_stop(void);
+void blackbox_log_outputs(const float *channels, uint8_t num_channels);
+void blackbox_log_loop(const float *gyro, const float *rate_desired,
+		const float *actuator_desired);
+uint16_t blackbox_get_chunk(uint8_t *buf, uint32_t timeout_ms);
+uint32_t blackbox_dropped_frames(void);
+
+#endif /* BLACKBOX_H */
+
+/**
+ * @}
+ */
@@ -0,0 +1,66 @@
+/**
+ ******************************************************************************
+ * @addtogroup Libraries Libraries
+ * @{
+ *
+ * @file       geofmt.h
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2017
+ * @brief      Fixed point UTM/MGRS conversion and number formatting
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef _GEOFMT_H
+#define _GEOFMT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+//! Longest MGRS string, "32UMU 12345 67890", with its terminator
+#define GEOFMT_MGRS_LEN 18
+
+struct geofmt_utm {
+	uint8_t zone;		// 1 - 60
+	char band;		// Latitude band letter, C - X
+	bool south;
+	uint32_t easting_cm;
+	uint32_t northing_cm;	// Including the false northing in the south
+};
+
+struct geofmt_deg_min {
+	bool negative;
+	uint16_t degrees;
+	uint8_t minutes;
+	uint16_t minutes_e4;	// Fraction of a minute, in 1/10000 minutes
+};
+
+int32_t geofmt_utm(int32_t lat_e7, int32_t lon_e7, struct geofmt_utm *utm);
+int32_t geofmt_mgrs(int32_t lat_e7, int32_t lon_e7, uint8_t precision,
+		char *buf);
+
+uint32_t geofmt_minutes_e4(int32_t deg_e7);
+void geofmt_deg_min(int32_t deg_e7, struct geofmt_deg_min *dm);
+
+char *geofmt_uint(char *buf, uint32_t value, uint8_t min_digits);
+char *geofmt_fixed(char *buf, int32_t value, uint8_t scale, uint8_t decimals);
+
+#endif /* _GEOFMT_H */
+
+/**
+ * @}
+ */
@@ -77,6 +77,7 @@ void INSSetArmed(bool armed);
 /****************************************************/
 
 void INSResetP(const float *PDiag);
+void INSSetPosVelDelay(float delay);
 void INSSetState(const float pos[3], const float vel[3], const float q[4], const float gyro_bias[3], const float accel_bias[3]);
 void INSSetPosVelVar(float PosVar, float VelVar, float VertPosVar);
 void INSSetGyroBias(const float gyro_bias[3]);
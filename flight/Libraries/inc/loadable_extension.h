@@ -39,10 +39,20 @@ struct loadable_extension {
 	uint32_t magic;           /**< Magic number for structure 'dReX' */
 	uint32_t length;          /**< Number of bytes (with header) of extension */
 
-	uint32_t reserved[2];     /**< Reserved for future use, must be 0 */
+	uint32_t reloc_offset;    /**< Offset, from beginning of structure, of
+				    * the relocation table, or 0 for none
+				    */
+	uint32_t exit_offset;     /**< Function that stops the extension, from
+				    * beginning of structure, or 0 if it can't
+				    * be stopped
+				    */
 
 #define LOADABLE_REQUIRE_VERSION_INVALID 0x00000000
 #define LOADABLE_REQUIRE_VERSION_WIRED   0x00000001
+#define LOADABLE_REQUIRE_VERSION_RELOCS  0x00000002	/* Relocation table,
+							 * exit function, heap
+							 * calls */
+#define LOADABLE_VERSION_CURRENT         LOADABLE_REQUIRE_VERSION_RELOCS
 	uint32_t require_version; /**< Minimum version to try loading */
 
 	uint32_t ram_seg_len;     /**< Number of bytes of ram segments */
@@ -60,7 +70,22 @@ struct loadable_extension {
 	uint32_t payload_crc;     /**< CRC of payload code */
 };
 
-#define DECLARE_LOADABLE_EXTENSION(ent_func) \
+/* Relocation table, made after linking by loadable.example/mkrelocs.py.
+ * Each entry is the offset, in the RAM segment, of an initialised data
+ * word holding a link-time address, which is fixed up at load just as
+ * the GOT entries are.  Only data outside the GOT needs entries, and only
+ * RAM can be fixed up: pointers in constant data stay unrelocated.
+ */
+struct loadable_relocs {
+	uint32_t count;           /**< Number of entries */
+	uint32_t offsets[];       /**< RAM segment offsets to fix up */
+};
+
+/* exit_func, if not 0, must leave nothing of the extension running--
+ * its threads ended, its callbacks unregistered-- before it returns.  What
+ * it allocated is freed after.
+ */
+#define DECLARE_LOADABLE_EXTENSION_EXIT(ent_func, exit_func) \
 extern char _sidata; \
 extern char _eidata; \
  \
@@ -71,8 +96,9 @@ extern char _ramlen; \
 const struct loadable_extension lext __attribute__((section (".extension_header"))) = { \
 	.magic = LOADABLE_EXTENSION_MAGIC, \
 	.length = (uint32_t) &_eidata, \
-	.require_version = LOADABLE_REQUIRE_VERSION_WIRED, \
+	.require_version = LOADABLE_REQUIRE_VERSION_RELOCS, \
 	.entry_offset = (uint32_t) ent_func, \
+	.exit_offset = (uint32_t) exit_func, \
 	.ram_seg_copyoff = (uint32_t) &_sidata, \
 	/* These next & opers are lies, because they're lengths, not offsets */ \
 	.ram_seg_len = (uint32_t) &_ramlen, \
@@ -80,6 +106,9 @@ const struct loadable_extension lext __attribute__((section (".extension_header"
 	.ram_seg_gotlen = (uint32_t) &_gotlen, \
 }
 
+#define DECLARE_LOADABLE_EXTENSION(ent_func) \
+	DECLARE_LOADABLE_EXTENSION_EXIT(ent_func, 0)
+
 #endif
 /**
  * @}
@@ -0,0 +1,50 @@
+/**
+ ******************************************************************************
+ * @addtogroup Libraries Libraries
+ * @{
+ *
+ * @file       looptiming.h
+ * @author     dRonin, http://dronin.org Copyright (C) 2017
+ * @brief      Measures the time from gyro sample to each control loop stage
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+#ifndef LOOPTIMING_H
+#define LOOPTIMING_H
+
+#include <stdint.h>
+
+//! Points along the control loop, in order
+enum looptiming_stage {
+	LOOPTIMING_READ,		/**< Sample handed to the sensors code */
+	LOOPTIMING_FILTER,		/**< Filtered rates published */
+	LOOPTIMING_STABILIZATION,	/**< Controller output published */
+	LOOPTIMING_ACTUATOR,		/**< Motor outputs committed */
+	LOOPTIMING_NUM_STAGES
+};
+
+int32_t looptiming_init(void);
+void looptiming_set_period(uint32_t period_us);
+void looptiming_begin(uint32_t sample_time_us);
+void looptiming_mark(enum looptiming_stage stage);
+void looptiming_publish(void);
+
+#endif /* LOOPTIMING_H */
+
+/**
+ * @}
+ */
@@ -0,0 +1,53 @@
+/**
+ ******************************************************************************
+ * @addtogroup Libraries Libraries
+ * @{
+ *
+ * @file       lz4block.h
+ * @author     dRonin, http://dronin.org Copyright (C) 2017
+ * @brief      Small LZ4 block format compressor, for data sent to the ground
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef LZ4BLOCK_H
+#define LZ4BLOCK_H
+
+#include <stdint.h>
+
+#define LZ4BLOCK_HASH_LOG	6
+
+/**
+ * Scratch space for lz4block_compress.  Kept out of the way by the caller,
+ * so that compressing doesn't need a large stack.
+ */
+struct lz4block_state {
+	uint16_t table[1 << LZ4BLOCK_HASH_LOG];
+};
+
+int32_t lz4block_compress(struct lz4block_state *state,
+		const uint8_t *src, uint16_t src_len,
+		uint8_t *dst, uint16_t dst_len);
+int32_t lz4block_decompress(const uint8_t *src, uint16_t src_len,
+		uint8_t *dst, uint16_t dst_len);
+
+#endif /* LZ4BLOCK_H */
+
+/**
+ * @}
+ */
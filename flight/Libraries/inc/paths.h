@@ -38,6 +38,7 @@ struct path_status {
 	float error;
 	float correction_direction[2];
 	float path_direction[2];
+	float distance_remaining;	// to the end of the path, in m
 };
 
 void path_progress(const PathDesiredData *pathDesired, const float * cur_point, struct path_status * status);
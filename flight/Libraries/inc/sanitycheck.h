@@ -29,6 +29,7 @@
 #include "systemalarms.h"
 
 extern int32_t configuration_check();
+extern void configuration_check_refresh();
 void set_config_error(SystemAlarmsConfigErrorOptions error_code);
 
 #endif /* SANITYCHECK_H */
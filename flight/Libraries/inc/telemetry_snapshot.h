@@ -0,0 +1,81 @@
+/**
+ ******************************************************************************
+ * @addtogroup Libraries Libraries
+ * @{
+ *
+ * @file       telemetry_snapshot.h
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2017
+ * @brief      Shared snapshot of the values reported by telemetry bridges
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef TELEMETRY_SNAPSHOT_H
+#define TELEMETRY_SNAPSHOT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * The values radio and OSD telemetry bridges report, taken together from
+ * their UAVObjects.  Each have_ flag says whether the objects behind that
+ * group exist on this board; the values are zero when they don't.
+ */
+struct telemetry_snapshot {
+	uint32_t taken_ms;
+
+	bool have_attitude;
+	float roll;		// deg
+	float pitch;		// deg
+	float yaw;		// deg, -180..180
+
+	bool have_battery;
+	float voltage;		// V
+	float current;		// A
+	float consumed_energy;	// mAh
+	uint32_t capacity;	// mAh, 0 if not configured
+
+	bool have_gps;
+	uint8_t gps_status;	// GPSPOSITION_STATUS_*
+	uint8_t satellites;
+	int32_t latitude;	// deg * 1e7
+	int32_t longitude;	// deg * 1e7
+	float gps_altitude;	// m MSL
+	float groundspeed;	// m/s
+	float heading;		// deg, course over ground
+
+	bool have_altitude;
+	float altitude;		// m; best of estimate, baro, GPS
+
+	bool have_airspeed;
+	float airspeed;		// m/s, true airspeed
+
+	uint8_t rssi;		// %
+	uint8_t armed;		// FLIGHTSTATUS_ARMED_*
+	uint8_t flight_mode;	// FLIGHTSTATUS_FLIGHTMODE_*
+	uint8_t control_source;	// FLIGHTSTATUS_CONTROLSOURCE_*
+};
+
+int32_t telemetry_snapshot_init(void);
+void telemetry_snapshot_get(struct telemetry_snapshot *snap, uint32_t max_age_ms);
+
+#endif /* TELEMETRY_SNAPSHOT_H */
+
+/**
+ * @}
+ */
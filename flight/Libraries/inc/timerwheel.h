@@ -0,0 +1,83 @@
+/**
+ ******************************************************************************
+ * @addtogroup Libraries Libraries
+ * @{
+ *
+ * @file       timerwheel.h
+ * @author     dRonin, http://dronin.org Copyright (C) 2017
+ * @brief      Hierarchical timer wheel
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef TIMERWHEEL_H
+#define TIMERWHEEL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define TIMER_WHEEL_BITS	6
+#define TIMER_WHEEL_SLOTS	(1 << TIMER_WHEEL_BITS)
+#define TIMER_WHEEL_LEVELS	3
+
+//! Timers further out than this many ticks are clamped to it
+#define TIMER_WHEEL_MAX_DELAY \
+	((1 << (TIMER_WHEEL_BITS * TIMER_WHEEL_LEVELS)) - 1)
+
+/**
+ * A timer, kept in whatever it times.  Not to be touched while it is in a
+ * wheel, except for reading expires.
+ */
+struct timer_wheel_entry {
+	struct timer_wheel_entry *next;
+	//! Whatever points at this entry; NULL when it isn't in a wheel
+	struct timer_wheel_entry **pprev;
+	uint32_t expires;
+	uint8_t level;
+};
+
+struct timer_wheel {
+	//! The first tick not yet expired
+	uint32_t now;
+	uint16_t count[TIMER_WHEEL_LEVELS];
+	struct timer_wheel_entry *slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+};
+
+void timer_wheel_init(struct timer_wheel *wheel, uint32_t now);
+void timer_wheel_add(struct timer_wheel *wheel,
+		struct timer_wheel_entry *entry, uint32_t expires);
+void timer_wheel_remove(struct timer_wheel *wheel,
+		struct timer_wheel_entry *entry);
+struct timer_wheel_entry *timer_wheel_expire(struct timer_wheel *wheel,
+		uint32_t now);
+uint32_t timer_wheel_next(const struct timer_wheel *wheel, uint32_t max);
+
+/**
+ * @brief Is the timer in a wheel
+ */
+static inline bool timer_wheel_pending(const struct timer_wheel_entry *entry)
+{
+	return entry->pprev != NULL;
+}
+
+#endif /* TIMERWHEEL_H */
+
+/**
+ * @}
+ */
@@ -32,6 +32,8 @@
 
 // Public types
 typedef int32_t (*UAVTalkOutputCb)(void *ctx, uint8_t *data, int32_t length);
+typedef uint8_t *(*UAVTalkReserveCb)(void *ctx, uint16_t length);
+typedef int32_t (*UAVTalkCommitCb)(void *ctx, uint16_t length);
 typedef void (*UAVTalkAckCb)(void *ctx, uint32_t obj_id, uint16_t inst_id);
 typedef void (*UAVTalkReqCb)(void *ctx, uint32_t obj_id, uint16_t inst_id);
 typedef int32_t (*UAVTalkFileCb)(void *ctx, uint8_t *buf,
@@ -52,15 +54,37 @@ typedef struct {
 
 typedef void* UAVTalkConnection;
 
+/**
+ * Object ID that, in an OBJ_REQ, asks for every settings object at once.
+ * The reply is the objects followed by an ACK with this ID; firmware
+ * that doesn't know it NACKs it, as it would any unknown object.
+ */
+#define UAVTALK_OBJID_ALL_SETTINGS 0xFFFFFFFF
+
+/**
+ * File ID of the settings digest (see UAVObjReadSettingsDigest), with which
+ * a GCS that cached the settings of a board only fetches those that changed.
+ * Firmware that doesn't know it ends the file straight away.
+ */
+#define UAVTALK_FILEID_SETTINGS_DIGEST 0x81
+
+//! Length of the key shared by the two ends of a secured link
+#define UAVTALK_KEY_LENGTH 16
+
 typedef enum {UAVTALK_STATE_ERROR = 0, UAVTALK_STATE_SYNC, UAVTALK_STATE_TYPE, UAVTALK_STATE_SIZE, UAVTALK_STATE_OBJID, UAVTALK_STATE_INSTID,
 	      UAVTALK_STATE_DATA, UAVTALK_STATE_CS, UAVTALK_STATE_COMPLETE} UAVTalkRxState;
 
 // Public functions
 UAVTalkConnection UAVTalkInitialize(void *ctx, UAVTalkOutputCb outputStream, UAVTalkAckCb ackCallback, UAVTalkReqCb reqCallback, UAVTalkFileCb fileCallback);
+void UAVTalkSetInPlaceOutput(UAVTalkConnection connectionHandle, UAVTalkReserveCb reserveCb, UAVTalkCommitCb commitCb);
 int32_t UAVTalkSendObject(UAVTalkConnection connection, UAVObjHandle obj, uint16_t instId, uint8_t acked);
 int32_t UAVTalkSendObjectTimestamped(UAVTalkConnection connectionHandle, UAVObjHandle obj, uint16_t instId);
+int32_t UAVTalkSendObjectData(UAVTalkConnection connectionHandle, UAVObjHandle obj, uint16_t instId, uint32_t time, const void *data);
+int32_t UAVTalkSendObjectBatched(UAVTalkConnection connectionHandle, UAVObjHandle obj, uint16_t instId);
+int32_t UAVTalkFlushBatch(UAVTalkConnection connectionHandle);
 int32_t UAVTalkSendNack(UAVTalkConnection connectionHandle, uint32_t objId, uint16_t instId);
-void UAVTalkProcessInputStream(UAVTalkConnection connectionHandle, uint8_t *rxbytes,
+int32_t UAVTalkSendAck(UAVTalkConnection connectionHandle, uint32_t objId, uint16_t instId);
+void UAVTalkProcessInputStream(UAVTalkConnection connectionHandle, const uint8_t *rxbytes,
 		int numbytes);
 UAVTalkRxState UAVTalkProcessInputStreamQuiet(UAVTalkConnection connection, uint8_t rxbyte);
 int32_t UAVTalkRelayPacket(UAVTalkConnection inConnectionHandle, UAVTalkConnection outConnectionHandle);
@@ -68,6 +92,8 @@ int32_t UAVTalkReceiveObject(UAVTalkConnection connectionHandle);
 void UAVTalkGetStats(UAVTalkConnection connection, UAVTalkStats *stats);
 uint32_t UAVTalkGetPacketObjId(UAVTalkConnection connection);
 uint32_t UAVTalkGetPacketInstId(UAVTalkConnection connection);
+int32_t UAVTalkSetKey(UAVTalkConnection connection, const uint8_t *key);
+void UAVTalkRequireSecure(UAVTalkConnection connection, bool required);
 
 #endif // UAVTALK_H
 /**
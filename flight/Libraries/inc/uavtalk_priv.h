@@ -33,6 +33,8 @@
 #include "uavobjectsinit.h"
 #include "pios_semaphore.h"
 #include "pios_mutex.h"
+#include "lz4block.h"
+#include "aes128.h"
 
 // Private types and constants
 
@@ -60,6 +62,15 @@ struct filereq_data {
 	uint16_t flags;
 } __attribute__((packed));
 
+//! Most file data carried by one message, before compression
+#define UAVTALK_FILEDATA_CHUNK_LEN 100
+
+//! Scratch space for compressing file data, set aside on first use
+struct filecomp_data {
+	struct lz4block_state lz4;
+	uint8_t raw[UAVTALK_FILEDATA_CHUNK_LEN];
+};
+
 struct fileresp_data {
 	uint32_t offset;
 	uint8_t flags;
@@ -71,6 +82,63 @@ typedef uint8_t uavtalk_checksum;
 #define UAVTALK_MIN_PACKET_LENGTH       UAVTALK_MAX_HEADER_LENGTH + UAVTALK_CHECKSUM_LENGTH
 #define UAVTALK_MAX_PACKET_LENGTH       UAVTALK_MIN_PACKET_LENGTH + UAVTALK_MAX_PAYLOAD_LENGTH
 
+/*
+ * Batched frames carry several objects behind a single sync/type/size
+ * header and checksum.  After the 4 byte frame header each record is
+ * objId(4), len(1), then len bytes of instance ID (multi instance objects
+ * only) and object data.  Frames are kept within the 255 byte size limit
+ * of the ground parsers.
+ */
+#define UAVTALK_BATCH_HEADER_LENGTH     4
+#define UAVTALK_BATCH_RECORD_HEADER_LENGTH 5
+#define UAVTALK_MAX_BATCH_LENGTH        255
+
+/*
+ * Field updates carry a byte range of one object instance: the usual
+ * object (and instance) header, then offset(2) and the bytes of the range.
+ */
+#define UAVTALK_FIELD_OFFSET_LENGTH     2
+
+/*
+ * Secured frames carry one whole ordinary frame, sync byte to checksum,
+ * encrypted with AES-128 in counter mode.  After the 4 byte frame header
+ * come the sender's session salt(4) and frame sequence(4), which with a
+ * block count make the counter blocks, then the encrypted frame, then the
+ * first 8 bytes of the CMAC of everything from the salt on.  Encryption
+ * and MAC keys are both derived from the one shared key.  Like batches,
+ * they are kept within the ground parsers' 255 byte limit.
+ */
+#define UAVTALK_SECURE_HEADER_LENGTH    4
+#define UAVTALK_SECURE_NONCE_LENGTH     8
+#define UAVTALK_SECURE_TAG_LENGTH       8
+#define UAVTALK_MAX_SECURE_LENGTH       255
+#define UAVTALK_MAX_SECURED_FRAME       (UAVTALK_MAX_SECURE_LENGTH - \
+		UAVTALK_SECURE_HEADER_LENGTH - UAVTALK_SECURE_NONCE_LENGTH - \
+		UAVTALK_SECURE_TAG_LENGTH)
+
+//! Keys and session state for secured frames, set aside once keyed
+struct uavtalk_secure {
+	struct aes128_ctx enc;
+	struct aes128_ctx mac;
+
+	bool keyed;
+	//! Frames that aren't secured are refused
+	volatile bool required;
+	//! The last frame accepted was secured, so replies are too
+	volatile bool peer_secured;
+	//! Handling the frame just unwrapped
+	bool unwrapping;
+
+	uint32_t tx_salt;
+	uint32_t tx_seq;
+	uint32_t rx_salt;
+	uint32_t rx_seq;
+	bool rx_valid;
+
+	uint8_t tx_frame[UAVTALK_MAX_SECURE_LENGTH + UAVTALK_CHECKSUM_LENGTH];
+	uint8_t rx_frame[UAVTALK_MAX_SECURED_FRAME];
+};
+
 //! State information for the UAVTalk parser
 typedef struct {
 	UAVObjHandle obj;
@@ -96,10 +164,19 @@ typedef struct {
 	uint32_t txSize;
 	uint8_t *txBuffer;
 
+	uint8_t *batchBuffer;
+	uint16_t batchLength;
+	uint16_t batchObjects;
+	uint32_t batchObjectBytes;
+
 	UAVTalkOutputCb outCb;
+	UAVTalkReserveCb reserveCb;
+	UAVTalkCommitCb commitCb;
 	UAVTalkAckCb ackCb;
 	UAVTalkReqCb reqCb;
 	UAVTalkFileCb fileCb;
+	struct filecomp_data *fileComp;
+	struct uavtalk_secure *secure;
 	void *cbCtx;
 } UAVTalkConnectionData;
 
@@ -115,12 +192,26 @@ typedef struct {
 #define UAVTALK_TYPE_OBJ_ACK   (UAVTALK_TYPE_VER | 0x02)
 #define UAVTALK_TYPE_ACK       (UAVTALK_TYPE_VER | 0x03)
 #define UAVTALK_TYPE_NACK      (UAVTALK_TYPE_VER | 0x04)
+#define UAVTALK_TYPE_OBJ_FIELD (UAVTALK_TYPE_VER | 0x05)
+#define UAVTALK_TYPE_OBJ_FIELD_ACK (UAVTALK_TYPE_VER | 0x06)
 #define UAVTALK_TYPE_FILEREQ   (UAVTALK_TYPE_VER | 0x08)
 #define UAVTALK_TYPE_FILEDATA  (UAVTALK_TYPE_VER | 0x09)
+#define UAVTALK_TYPE_OBJ_BATCH (UAVTALK_TYPE_VER | 0x0A)
+/* 0x0B is blackbox chunks, only ever read by the ground */
+#define UAVTALK_TYPE_SECURE    (UAVTALK_TYPE_VER | 0x0C)
 #define UAVTALK_TYPE_OBJ_TS    (UAVTALK_TIMESTAMPED | UAVTALK_TYPE_OBJ)
 
 #define UAVTALK_FILEDATA_EOF   0x01
 #define UAVTALK_FILEDATA_LAST  0x02
+//! The payload is an LZ4 block; offsets still count uncompressed bytes
+#define UAVTALK_FILEDATA_LZ4   0x04
+
+//! Request flags: how many messages to send back, 0 for the default
+#define UAVTALK_FILEREQ_COUNT_MASK    0x00FF
+//! Request flags: compress the data where that makes it smaller
+#define UAVTALK_FILEREQ_LZ4           0x0100
+#define UAVTALK_FILEREQ_DEFAULT_COUNT 6
+#define UAVTALK_FILEREQ_MAX_COUNT     32
 
 //macros
 #define CHECKCONHANDLE(handle,variable,failcommand) \
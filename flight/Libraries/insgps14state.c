@@ -56,8 +56,10 @@ void RungeKutta(float X[NUMX], float U[NUMU], float dT);
 void StateEq(float X[NUMX], float U[NUMU], float Xdot[NUMX]);
 void LinearizeFG(float X[NUMX], float U[NUMU], float F[NUMX][NUMX],
 		 float G[NUMX][NUMW]);
-void MeasurementEq(float X[NUMX], float Be[3], float Y[NUMV]);
-void LinearizeH(float X[NUMX], float Be[3], float H[NUMV][NUMX]);
+void MeasurementEq(float X[NUMX], float Be[3], float Y[NUMV],
+		uint16_t SensorsUsed);
+void LinearizeH(float X[NUMX], float Be[3], float H[NUMV][NUMX],
+		uint16_t SensorsUsed);
 
 // Private variables
 float F[NUMX][NUMX], G[NUMX][NUMW], H[NUMV][NUMX];	// linearized system matrices
@@ -67,9 +69,49 @@ float P[NUMX][NUMX], X[NUMX];	// covariance matrix and state vector
 float Q[NUMW], R[NUMV];		// input noise and measurement noise variances
 float K[NUMX][NUMV];		// feedback gain matrix
 
+// Recent position and velocity estimates, one every HIST_PERIOD seconds,
+// so that delayed GPS measurements can be compared with the state at the
+// time they were taken
+#define HIST_LEN 32
+#define HIST_PERIOD 0.01f
+static float hist_posvel[HIST_LEN][6];
+static uint8_t hist_head, hist_count;
+static float hist_accum;
+static float posvel_delay;
+
+// The structurally nonzero columns of each row of H, so the serial update
+// only has to visit the states a measurement actually depends on
+static const struct {
+	uint8_t num;
+	uint8_t cols[4];
+} h_nonzero[NUMV] = {
+	{ 1, { 0 } }, { 1, { 1 } }, { 1, { 2 } },	// GPS position
+	{ 1, { 3 } }, { 1, { 4 } }, { 1, { 5 } },	// GPS velocity
+	{ 4, { 6, 7, 8, 9 } }, { 4, { 6, 7, 8, 9 } },	// mag, horizontal plane
+	{ 0 },						// mag z is unused
+	{ 1, { 2 } },					// baro
+};
+
 //  *************  Exposed Functions ****************
 //  *************************************************
 
+static void history_reset()
+{
+	hist_count = 0;
+	hist_accum = HIST_PERIOD;	// record the next prediction
+}
+
+//! Pick the recorded position and velocity closest to delay seconds ago
+static const float *history_lookup(float delay)
+{
+	int steps = delay / HIST_PERIOD + 0.5f;
+
+	if (steps >= hist_count)
+		steps = hist_count - 1;
+
+	return hist_posvel[(hist_head + HIST_LEN - 1 - steps) % HIST_LEN];
+}
+
 uint16_t ins_get_num_states() 
 {
 	return NUMX;
@@ -125,6 +167,8 @@ void INSGPSInit()		//pretty much just a place holder for now
 	R[5] = 0.004f;		// High freq GPS vertical velocity noise variance (m/s)^2
 	R[6] = R[7] = R[8] = 0.005f;	// magnetometer unit vector noise variance
 	R[9] = .05f;		// High freq altimeter noise variance (m^2)
+
+	history_reset();
 }
 
 //! Set the current flight state
@@ -223,6 +267,8 @@ void INSSetState(const float pos[3], const float vel[3], const float q[4], const
 	X[11] = gyro_bias[1];
 	X[12] = gyro_bias[2];
 	X[13] = accel_bias[2];
+
+	history_reset();
 }
 
 void INSPosVelReset(const float pos[3], const float vel[3]) 
@@ -243,6 +289,19 @@ void INSPosVelReset(const float pos[3], const float vel[3])
 	X[3] = vel[0];
 	X[4] = vel[1];
 	X[5] = vel[2];	
+
+	history_reset();
+}
+
+/**
+ * Set how old the position and velocity passed to the following
+ * INSCorrection() calls are.  They are compared with the estimate from that
+ * long ago, up to HIST_LEN * HIST_PERIOD seconds, and the resulting
+ * correction is applied to the current state.
+ */
+void INSSetPosVelDelay(float delay)
+{
+	posvel_delay = delay;
 }
 
 void INSSetPosVelVar(float PosVar, float VelVar, float VertPosVar)
@@ -344,6 +403,18 @@ void INSStatePrediction(const float gyro_data[3], const float accel_data[3], flo
 	X[7] /= qmag;
 	X[8] /= qmag;
 	X[9] /= qmag;
+
+	hist_accum += dT;
+	if (hist_accum >= HIST_PERIOD) {
+		hist_accum = 0;
+
+		for (int i = 0; i < 6; i++)
+			hist_posvel[hist_head][i] = X[i];
+
+		hist_head = (hist_head + 1) % HIST_LEN;
+		if (hist_count < HIST_LEN)
+			hist_count++;
+	}
 }
 
 void INSCovariancePrediction(float dT)
@@ -396,9 +467,36 @@ void INSCorrection(const float mag_data[3], const float Pos[3], const float Vel[
 	Z[9] = BaroAlt;
 
 	// EKF correction step
-	LinearizeH(X, Be, H);
-	MeasurementEq(X, Be, Y);
+	LinearizeH(X, Be, H, SensorsUsed);
+	MeasurementEq(X, Be, Y, SensorsUsed);
+
+	bool delayed = posvel_delay > 0 && hist_count &&
+		(SensorsUsed & (POS_SENSORS | HORIZ_VEL_SENSORS | VERT_VEL_SENSORS));
+	float posvel_before[6];
+
+	if (delayed) {
+		// Innovation against the state when the measurement was taken
+		const float *past = history_lookup(posvel_delay);
+
+		for (int i = 0; i < 6; i++) {
+			Y[i] = past[i];
+			posvel_before[i] = X[i];
+		}
+	}
+
 	SerialUpdate(H, R, Z, Y, P, X, SensorsUsed);
+
+	if (delayed) {
+		// Shift the history by the same correction, so the next delayed
+		// measurement isn't compared against stale estimates
+		for (int i = 0; i < 6; i++) {
+			float delta = X[i] - posvel_before[i];
+
+			for (int j = 0; j < HIST_LEN; j++)
+				hist_posvel[j][i] += delta;
+		}
+	}
+
 	qmag = sqrtf(X[6] * X[6] + X[7] * X[7] + X[8] * X[8] + X[9] * X[9]);
 	X[6] /= qmag;
 	X[7] /= qmag;
@@ -589,6 +687,8 @@ void CovariancePrediction(float F[NUMX][NUMX], float G[NUMX][NUMW],
 //            - or see Simon, "Optimal State Estimation," 1st Ed, p.150
 //  The SensorsUsed variable is a bitwise mask indicating which sensors
 //     should be used in the update.
+//  H*P and H*P*H' only visit the nonzero columns of each row of H, given
+//     by h_nonzero.
 //  ************************************************
 
 void SerialUpdate(float H[NUMV][NUMX], float R[NUMV], float Z[NUMV],
@@ -596,22 +696,25 @@ void SerialUpdate(float H[NUMV][NUMX], float R[NUMV], float Z[NUMV],
 		  uint16_t SensorsUsed)
 {
 	float HP[NUMX], HPHR, Error;
-	uint8_t i, j, k, m;
+	uint8_t i, j, k, m, n;
 
 	// Iterate through all the possible measurements and apply the
 	// appropriate corrections
 	for (m = 0; m < NUMV; m++) {
 
-		if (SensorsUsed & (0x01 << m)) {	// use this sensor for update
+		// use this sensor for update, unless it can't affect anything
+		if ((SensorsUsed & (0x01 << m)) && h_nonzero[m].num) {
+			const uint8_t num = h_nonzero[m].num;
+			const uint8_t *cols = h_nonzero[m].cols;
 
 			for (j = 0; j < NUMX; j++) {	// Find Hp = H*P
 				HP[j] = 0.0f;
-				for (k = 0; k < NUMX; k++)
-					HP[j] += H[m][k] * P[k][j];
+				for (n = 0; n < num; n++)
+					HP[j] += H[m][cols[n]] * P[cols[n]][j];
 			}
 			HPHR = R[m];	// Find  HPHR = H*P*H' + R
-			for (k = 0; k < NUMX; k++)
-				HPHR += HP[k] * H[m][k];
+			for (n = 0; n < num; n++)
+				HPHR += HP[cols[n]] * H[m][cols[n]];
 
 			for (k = 0; k < NUMX; k++)
 				K[k][m] = HP[k] / HPHR;	// find K = HP/HPHR
@@ -842,7 +945,8 @@ void LinearizeFG(float X[NUMX], float U[NUMU], float F[NUMX][NUMX],
  * directly computes the outputs instead of a matrix that
  * you transform the state by
  */
-void MeasurementEq(float X[NUMX], float Be[3], float Y[NUMV])
+void MeasurementEq(float X[NUMX], float Be[3], float Y[NUMV],
+		uint16_t SensorsUsed)
 {
 	const float q0 = X[6];
 	const float q1 = X[7];
@@ -857,6 +961,12 @@ void MeasurementEq(float X[NUMX], float Be[3], float Y[NUMV])
 	Y[4] = X[4];
 	Y[5] = X[5];
 
+	// Alt = -Pz
+	Y[9] = X[2] * -1.0f;
+
+	if (!(SensorsUsed & MAG_SENSORS))
+		return;
+
 	// Rotate Be by only the yaw heading
 	const float a1 = 2*q0*q3 + 2*q1*q2;
 	const float a2 = q0*q0 + q1*q1 - q2*q2 - q3*q3;
@@ -866,17 +976,18 @@ void MeasurementEq(float X[NUMX], float Be[3], float Y[NUMV])
 	Y[6] = Be[0] * cP + Be[1] * sP;
 	Y[7] = -Be[0] * sP + Be[1] * cP;
 	Y[8] = 0; // don't care
-
-	// Alt = -Pz
-	Y[9] = X[2] * -1.0f;
 }
 
 /**
  * Linearize the measurement around the current state estiamte
  * so the predicted measurements are
  *    Z = H * X
+ *
+ * Only the rows for the sensors in SensorsUsed are brought up to date;
+ * everything but the magnetometer rows is constant anyway.
  */
-void LinearizeH(float X[NUMX], float Be[3], float H[NUMV][NUMX])
+void LinearizeH(float X[NUMX], float Be[3], float H[NUMV][NUMX],
+		uint16_t SensorsUsed)
 {
 	const float q0 = X[6];
 	const float q1 = X[7];
@@ -887,6 +998,11 @@ void LinearizeH(float X[NUMX], float Be[3], float H[NUMV][NUMX])
 	H[0][0] = H[1][1] = H[2][2] = 1.0f;
 	// dV/dV=I;  (expect velocity to measure the velocity)
 	H[3][3] = H[4][4] = H[5][5] = 1.0f;
+	// dAlt/dPz = -1  (expected baro readings)
+	H[9][2] = -1.0f;
+
+	if (!(SensorsUsed & MAG_SENSORS))
+		return;
 
 	// dBb/dq    (expected magnetometer readings in the horizontal plane)
 	// these equations were generated by Rhb(q)*Be which is the matrix that
@@ -918,9 +1034,6 @@ void LinearizeH(float X[NUMX], float Be[3], float H[NUMV][NUMX])
 	H[8][6] = 0.0f;
 	H[8][7] = 0.0f;
 	H[8][9] = 0.0f;
-
-	// dAlt/dPz = -1  (expected baro readings)
-	H[9][2] = -1.0f;
 }
 
 /**
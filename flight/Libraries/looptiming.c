@@ -0,0 +1,228 @@
+/**
+ ******************************************************************************
+ * @addtogroup Libraries Libraries
+ * @{
+ *
+ * @file       looptiming.c
+ * @author     dRonin, http://dronin.org Copyright (C) 2017
+ * @brief      Measures the time from gyro sample to each control loop stage
+ *
+ * Each gyro sample's capture time is taken as the origin, and the stages it
+ * goes through are timestamped against it off the microsecond (cycle
+ * counter backed) clock.  The actuator stage may run after a newer sample
+ * came in, in which case it's measured from that one.
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "openpilot.h"
+#include "looptiming.h"
+#include "pios_thread.h"
+
+#include "looplatency.h"
+
+// Private constants
+#define BIN_WIDTH_US		16
+#define NUM_BINS		64
+#define PUBLISH_BINS		LOOPLATENCY_HISTOGRAM_NUMELEM
+#define PUBLISH_PERIOD_MS	1000
+
+// Private types
+struct stage_stats {
+	uint32_t count;
+	uint32_t sum;
+	uint32_t min;
+	uint32_t max;
+	uint16_t bins[NUM_BINS];
+};
+
+struct period_stats {
+	uint32_t count;
+	uint32_t sum;
+	uint32_t max;
+	uint32_t overruns;
+};
+
+// Private variables
+static struct stage_stats *stats;
+static volatile uint32_t origin_us;
+static volatile bool origin_valid;
+static uint32_t period_us;
+static struct period_stats period;
+static uint32_t last_publish;
+
+/**
+ * Allocates the statistics and registers the LoopLatency object.  Until then,
+ * marks are dropped.
+ */
+int32_t looptiming_init(void)
+{
+	if (LoopLatencyInitialize() == -1)
+		return -1;
+
+	if (!stats) {
+		stats = PIOS_malloc_no_dma(sizeof(*stats) * LOOPTIMING_NUM_STAGES);
+		if (!stats)
+			return -1;
+
+		memset(stats, 0, sizeof(*stats) * LOOPTIMING_NUM_STAGES);
+	}
+
+	return 0;
+}
+
+/**
+ * Sets how far apart the samples followed by successive loop runs should be,
+ * for measuring how far off the loop is from it.
+ * \param[in] expected_us the control loop period; zero to not measure
+ */
+void looptiming_set_period(uint32_t expected_us)
+{
+	period_us = expected_us;
+}
+
+/**
+ * Starts following a gyro sample through the loop.
+ * \param[in] sample_time_us when the sample was taken, off PIOS_DELAY_GetuS()
+ */
+void looptiming_begin(uint32_t sample_time_us)
+{
+	if (period_us && origin_valid) {
+		uint32_t interval = sample_time_us - origin_us;
+		uint32_t deviation = (interval > period_us) ?
+			(interval - period_us) : (period_us - interval);
+
+		if (interval > period_us + period_us / 2)
+			period.overruns++;
+		if (deviation > period.max)
+			period.max = deviation;
+
+		period.sum += deviation;
+		period.count++;
+	}
+
+	origin_us = sample_time_us;
+	origin_valid = true;
+}
+
+/**
+ * Records the time since the current sample was taken.
+ * \param[in] stage the stage the sample just got through
+ */
+void looptiming_mark(enum looptiming_stage stage)
+{
+	if (!stats || !origin_valid)
+		return;
+
+	uint32_t latency = PIOS_DELAY_GetuS() - origin_us;
+
+	struct stage_stats *s = &stats[stage];
+
+	uint32_t bin = latency / BIN_WIDTH_US;
+	if (bin >= NUM_BINS)
+		bin = NUM_BINS - 1;
+
+	if (s->bins[bin] < UINT16_MAX)
+		s->bins[bin]++;
+
+	if (!s->count || latency < s->min)
+		s->min = latency;
+	if (latency > s->max)
+		s->max = latency;
+
+	s->sum += latency;
+	s->count++;
+}
+
+static uint16_t clamp_us(uint32_t us)
+{
+	return us > UINT16_MAX ? UINT16_MAX : us;
+}
+
+/**
+ * Publishes the statistics gathered over the last second to LoopLatency, and
+ * starts over.  Called periodically from the System module.
+ */
+void looptiming_publish(void)
+{
+	if (!stats)
+		return;
+
+	if (!PIOS_Thread_Period_Elapsed(last_publish, PUBLISH_PERIOD_MS))
+		return;
+
+	last_publish = PIOS_Thread_Systime();
+
+	LoopLatencyData data;
+	memset(&data, 0, sizeof(data));
+
+	for (int i = 0; i < LOOPTIMING_NUM_STAGES; i++) {
+		struct stage_stats s = stats[i];
+
+		// Marks may race in meanwhile; this is only diagnostics.
+		memset(&stats[i], 0, sizeof(stats[i]));
+
+		if (!s.count)
+			continue;
+
+		data.Min[i] = clamp_us(s.min);
+		data.Mean[i] = clamp_us(s.sum / s.count);
+		data.Max[i] = clamp_us(s.max);
+
+		// Upper edge of the bin the 99th percentile falls in
+		uint32_t target = s.count - s.count / 100;
+		uint32_t seen = 0;
+		int bin;
+
+		for (bin = 0; bin < NUM_BINS - 1; bin++) {
+			seen += s.bins[bin];
+			if (seen >= target)
+				break;
+		}
+
+		uint32_t p99 = (bin + 1) * BIN_WIDTH_US;
+		data.P99[i] = clamp_us(p99 < s.max ? p99 : s.max);
+
+		if (i == LOOPTIMING_ACTUATOR) {
+			data.Samples = s.count;
+
+			for (bin = 0; bin < NUM_BINS; bin++) {
+				data.Histogram[bin * PUBLISH_BINS / NUM_BINS] += s.bins[bin];
+			}
+		}
+	}
+
+	data.HistogramBinWidth = BIN_WIDTH_US * NUM_BINS / PUBLISH_BINS;
+
+	struct period_stats p = period;
+	memset(&period, 0, sizeof(period));
+
+	data.Period = clamp_us(period_us);
+
+	if (p.count) {
+		data.PeriodDeviationMean = clamp_us(p.sum / p.count);
+		data.PeriodDeviationMax = clamp_us(p.max);
+		data.Overruns = p.overruns > UINT16_MAX ? UINT16_MAX : p.overruns;
+	}
+
+	LoopLatencySet(&data);
+}
+
+/**
+ * @}
+ */
@@ -0,0 +1,306 @@
+/**
+ ******************************************************************************
+ * @addtogroup Libraries Libraries
+ * @{
+ *
+ * @file       lz4block.c
+ * @author     dRonin, http://dronin.org Copyright (C) 2017
+ * @brief      Small LZ4 block format compressor, for data sent to the ground
+ *
+ * Writes standard LZ4 blocks (no frame header), so anything that reads LZ4
+ * can take the output.  The compressor is the simple greedy kind, with a
+ * small hash table: it is meant for short buffers of flash contents, which
+ * are mostly long runs and repeated records, and it needs no memory beyond
+ * struct lz4block_state.
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "lz4block.h"
+
+#include <string.h>
+
+// Private constants
+#define MIN_MATCH	4
+//! The last bytes of a block are always literals
+#define LAST_LITERALS	5
+//! ... and the last match starts at least this far from the end
+#define MF_LIMIT	12
+#define RUN_MASK	15
+
+static uint32_t lz4block_read32(const uint8_t *p)
+{
+	uint32_t v;
+
+	memcpy(&v, p, sizeof(v));
+
+	return v;
+}
+
+static uint8_t lz4block_hash(uint32_t v)
+{
+	return (v * 2654435761U) >> (32 - LZ4BLOCK_HASH_LOG);
+}
+
+static uint8_t *lz4block_put_length(uint8_t *op, const uint8_t *oend,
+		uint32_t len)
+{
+	while (len >= 255) {
+		if (op >= oend) {
+			return NULL;
+		}
+
+		*(op++) = 255;
+		len -= 255;
+	}
+
+	if (op >= oend) {
+		return NULL;
+	}
+
+	*(op++) = len;
+
+	return op;
+}
+
+/**
+ * Writes one sequence: literals, then a match unless match_len is 0.
+ * \return where the next sequence goes, or NULL if it didn't fit
+ */
+static uint8_t *lz4block_put_sequence(uint8_t *op, const uint8_t *oend,
+		const uint8_t *lit, uint16_t lit_len,
+		uint16_t offset, uint16_t match_len)
+{
+	if (op >= oend) {
+		return NULL;
+	}
+
+	uint8_t *token = op++;
+
+	if (lit_len >= RUN_MASK) {
+		*token = RUN_MASK << 4;
+
+		op = lz4block_put_length(op, oend, lit_len - RUN_MASK);
+
+		if (!op) {
+			return NULL;
+		}
+	} else {
+		*token = lit_len << 4;
+	}
+
+	if (oend - op < lit_len) {
+		return NULL;
+	}
+
+	memcpy(op, lit, lit_len);
+	op += lit_len;
+
+	if (!match_len) {
+		return op;
+	}
+
+	if (oend - op < 2) {
+		return NULL;
+	}
+
+	*(op++) = offset & 0xff;
+	*(op++) = offset >> 8;
+
+	uint16_t len = match_len - MIN_MATCH;
+
+	if (len >= RUN_MASK) {
+		*token |= RUN_MASK;
+
+		return lz4block_put_length(op, oend, len - RUN_MASK);
+	}
+
+	*token |= len;
+
+	return op;
+}
+
+/**
+ * Compresses a buffer into one LZ4 block.
+ * \param[in] state scratch space
+ * \param[in] src data to compress
+ * \param[in] src_len length of src; less than 65535
+ * \param[out] dst where to put the block
+ * \param[in] dst_len space at dst
+ * \return length of the block, or 0 if it didn't fit in dst_len bytes
+ */
+int32_t lz4block_compress(struct lz4block_state *state,
+		const uint8_t *src, uint16_t src_len,
+		uint8_t *dst, uint16_t dst_len)
+{
+	uint8_t *op = dst;
+	const uint8_t *oend = dst + dst_len;
+	uint16_t anchor = 0;
+
+	if (src_len > MF_LIMIT) {
+		/* Entries are positions plus one, so that 0 is empty */
+		memset(state->table, 0, sizeof(state->table));
+
+		uint16_t match_limit = src_len - MF_LIMIT;
+		uint16_t end_limit = src_len - LAST_LITERALS;
+		uint16_t ip = 0;
+
+		while (ip <= match_limit) {
+			uint32_t seq = lz4block_read32(src + ip);
+			uint8_t h = lz4block_hash(seq);
+			uint16_t ref = state->table[h];
+
+			state->table[h] = ip + 1;
+
+			if (!ref || lz4block_read32(src + ref - 1) != seq) {
+				ip++;
+				continue;
+			}
+
+			ref--;
+
+			/* May run on past ip, which is how runs are coded */
+			uint16_t len = MIN_MATCH;
+
+			while (ip + len < end_limit &&
+					src[ref + len] == src[ip + len]) {
+				len++;
+			}
+
+			op = lz4block_put_sequence(op, oend, src + anchor,
+					ip - anchor, ip - ref, len);
+
+			if (!op) {
+				return 0;
+			}
+
+			ip += len;
+			anchor = ip;
+		}
+	}
+
+	op = lz4block_put_sequence(op, oend, src + anchor, src_len - anchor,
+			0, 0);
+
+	if (!op) {
+		return 0;
+	}
+
+	return op - dst;
+}
+
+static int32_t lz4block_get_length(const uint8_t **ip, const uint8_t *iend)
+{
+	int32_t len = 0;
+	uint8_t b;
+
+	do {
+		if (*ip >= iend) {
+			return -1;
+		}
+
+		b = *((*ip)++);
+		len += b;
+	} while (b == 255);
+
+	return len;
+}
+
+/**
+ * Expands one LZ4 block.
+ * \param[in] src the block
+ * \param[in] src_len length of the block
+ * \param[out] dst where to put the data
+ * \param[in] dst_len space at dst
+ * \return length of the data, or -1 if the block is malformed or too big
+ */
+int32_t lz4block_decompress(const uint8_t *src, uint16_t src_len,
+		uint8_t *dst, uint16_t dst_len)
+{
+	const uint8_t *ip = src;
+	const uint8_t *iend = src + src_len;
+	uint8_t *op = dst;
+	const uint8_t *oend = dst + dst_len;
+
+	while (ip < iend) {
+		uint8_t token = *(ip++);
+		int32_t len = token >> 4;
+
+		if (len == RUN_MASK) {
+			int32_t more = lz4block_get_length(&ip, iend);
+
+			if (more < 0) {
+				return -1;
+			}
+
+			len += more;
+		}
+
+		if (iend - ip < len || oend - op < len) {
+			return -1;
+		}
+
+		memcpy(op, ip, len);
+		op += len;
+		ip += len;
+
+		if (ip >= iend) {
+			break;
+		}
+
+		if (iend - ip < 2) {
+			return -1;
+		}
+
+		uint16_t offset = ip[0] | (ip[1] << 8);
+		ip += 2;
+
+		if (offset == 0 || offset > op - dst) {
+			return -1;
+		}
+
+		len = (token & RUN_MASK) + MIN_MATCH;
+
+		if ((token & RUN_MASK) == RUN_MASK) {
+			int32_t more = lz4block_get_length(&ip, iend);
+
+			if (more < 0) {
+				return -1;
+			}
+
+			len += more;
+		}
+
+		if (oend - op < len) {
+			return -1;
+		}
+
+		/* Byte by byte, since the match may overlap what it makes */
+		const uint8_t *ref = op - offset;
+
+		while (len--) {
+			*(op++) = *(ref++);
+		}
+	}
+
+	return op - dst;
+}
+
+/**
+ * @}
+ */
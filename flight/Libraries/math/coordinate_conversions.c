@@ -35,6 +35,7 @@
 #include <math.h>
 #include <stdint.h>
 #include "coordinate_conversions.h"
+#include "misc_math.h"
 #include "physical_constants.h"
 
 // ****** find ECEF to NED rotation matrix ********
@@ -58,8 +59,9 @@ void RneFromLLA(float LLA[3], float Rne[3][3])
 	Rne[2][2] = -sinLat;
 }
 
-// ****** find roll, pitch, yaw from quaternion ********
-void Quaternion2RPY(const float q[4], float rpy[3])
+/* Both spellings of Quaternion2RPY; approx is always a constant, so each
+ * gets its own copy with the calls resolved. */
+static inline void quaternion2rpy(const float q[4], float rpy[3], bool approx)
 {
 	float R13, R11, R12, R23, R33;
 	float q0s = q[0] * q[0];
@@ -82,8 +84,8 @@ void Quaternion2RPY(const float q[4], float rpy[3])
 		}
 
 		rpy[2] = 0;
-		rpy[1] = RAD2DEG * asinf(-R13);
-		rpy[0] = 2 * RAD2DEG * atan2f(q[3], q[0]);
+		rpy[1] = RAD2DEG * (approx ? fast_asinf(-R13) : asinf(-R13));
+		rpy[0] = 2 * RAD2DEG * (approx ? fast_atan2f(q[3], q[0]) : atan2f(q[3], q[0]));
 
 		return;
 	} else if (R13 <= -0.985f) {
@@ -92,16 +94,32 @@ void Quaternion2RPY(const float q[4], float rpy[3])
 		}
 
 		rpy[2] = 0;
-		rpy[1] = RAD2DEG * asinf(-R13);
-		rpy[0] = -2 * RAD2DEG * atan2f(q[3], q[0]);
+		rpy[1] = RAD2DEG * (approx ? fast_asinf(-R13) : asinf(-R13));
+		rpy[0] = -2 * RAD2DEG * (approx ? fast_atan2f(q[3], q[0]) : atan2f(q[3], q[0]));
 
 
 		return;
 	}
 
-	rpy[1] = RAD2DEG * asinf(-R13);	// pitch always between -pi/2 to pi/2
-	rpy[2] = RAD2DEG * atan2f(R12, R11);
-	rpy[0] = RAD2DEG * atan2f(R23, R33);
+	rpy[1] = RAD2DEG * (approx ? fast_asinf(-R13) : asinf(-R13));	// pitch always between -pi/2 to pi/2
+	rpy[2] = RAD2DEG * (approx ? fast_atan2f(R12, R11) : atan2f(R12, R11));
+	rpy[0] = RAD2DEG * (approx ? fast_atan2f(R23, R33) : atan2f(R23, R33));
+}
+
+// ****** find roll, pitch, yaw from quaternion ********
+void Quaternion2RPY(const float q[4], float rpy[3])
+{
+	quaternion2rpy(q, rpy, false);
+}
+
+/**
+ * @brief Quaternion2RPY, with the trigonometry done by fast_atan2f() and
+ * fast_asinf().  Good to about 1e-3 degrees, which is plenty for attitude
+ * errors and the published attitude, at a fraction of the cost.
+ */
+void Quaternion2RPYApprox(const float q[4], float rpy[3])
+{
+	quaternion2rpy(q, rpy, true);
 }
 
 // ****** find quaternion from roll, pitch, yaw ********
@@ -364,6 +382,28 @@ void quat_mult(const float q1[4], const float q2[4], float qout[4])
 	qout[3] = q1[0]*q2[3] + q1[1]*q2[2] - q1[2]*q2[1] + q1[3]*q2[0];
 }
 
+/**
+ * @brief Multiply two quaternions and normalize the product, in one pass
+ * @param[in] q1 First quaternion
+ * @param[in] q2 Second quaternion
+ * @param[out] qout Unit quaternion in the direction of q1 q2; q1 and q2
+ * must not be zero
+ */
+void quat_mult_normalize(const float q1[4], const float q2[4], float qout[4])
+{
+	float p0 = q1[0]*q2[0] - q1[1]*q2[1] - q1[2]*q2[2] - q1[3]*q2[3];
+	float p1 = q1[0]*q2[1] + q1[1]*q2[0] + q1[2]*q2[3] - q1[3]*q2[2];
+	float p2 = q1[0]*q2[2] - q1[1]*q2[3] + q1[2]*q2[0] + q1[3]*q2[1];
+	float p3 = q1[0]*q2[3] + q1[1]*q2[2] - q1[2]*q2[1] + q1[3]*q2[0];
+
+	float inv_mag = fast_invsqrtf(p0*p0 + p1*p1 + p2*p2 + p3*p3);
+
+	qout[0] = p0 * inv_mag;
+	qout[1] = p1 * inv_mag;
+	qout[2] = p2 * inv_mag;
+	qout[3] = p3 * inv_mag;
+}
+
 /**
  * @brief Rotate a vector by a rotation matrix
  * @param[in] R a three by three rotation matrix (first index is row)
@@ -385,6 +425,41 @@ void rot_mult(float R[3][3], const float vec[3], float vec_out[3], bool transpos
 	}
 }
 
+/**
+ * @brief Rotate several vectors by the same rotation matrix
+ *
+ * The matrix is loaded once and held in registers for the whole batch,
+ * rather than reloaded for every vector as separate rot_mult() calls do.
+ * @param[in] R a three by three rotation matrix (first index is row)
+ * @param[in] vec the source vectors
+ * @param[out] vec_out the output vectors; may not overlap vec
+ * @param[in] n how many vectors
+ * @param[in] transpose If false use R, else if true use R'
+ */
+void rot_mult_n(float R[3][3], const float vec[][3], float vec_out[][3],
+		int n, bool transpose)
+{
+	float r00, r01, r02, r10, r11, r12, r20, r21, r22;
+
+	if (!transpose) {
+		r00 = R[0][0]; r01 = R[0][1]; r02 = R[0][2];
+		r10 = R[1][0]; r11 = R[1][1]; r12 = R[1][2];
+		r20 = R[2][0]; r21 = R[2][1]; r22 = R[2][2];
+	} else {
+		r00 = R[0][0]; r01 = R[1][0]; r02 = R[2][0];
+		r10 = R[0][1]; r11 = R[1][1]; r12 = R[2][1];
+		r20 = R[0][2]; r21 = R[1][2]; r22 = R[2][2];
+	}
+
+	for (int i = 0; i < n; i++) {
+		const float x = vec[i][0], y = vec[i][1], z = vec[i][2];
+
+		vec_out[i][0] = r00 * x + r01 * y + r02 * z;
+		vec_out[i][1] = r10 * x + r11 * y + r12 * z;
+		vec_out[i][2] = r20 * x + r21 * y + r22 * z;
+	}
+}
+
 /**
  * @}
  * @}
@@ -43,6 +43,7 @@ void Rv2Rot(float Rv[3], float R[3][3]);
 
 	// ****** find roll, pitch, yaw from quaternion ********
 void Quaternion2RPY(const float q[4], float rpy[3]);
+void Quaternion2RPYApprox(const float q[4], float rpy[3]);
 
 	// ****** find quaternion from roll, pitch, yaw ********
 void RPY2Quaternion(const float rpy[3], float q[4]);
@@ -71,7 +72,10 @@ float VectorMagnitude(const float v[3]);
 void quat_inverse(float q[4]);
 void quat_copy(const float q[4], float qnew[4]);
 void quat_mult(const float q1[4], const float q2[4], float qout[4]);
+void quat_mult_normalize(const float q1[4], const float q2[4], float qout[4]);
 void rot_mult(float R[3][3], const float vec[3], float vec_out[3], bool transpose);
+void rot_mult_n(float R[3][3], const float vec[][3], float vec_out[][3],
+		int n, bool transpose);
 
 #endif /* COORDINATECONVERSIONS_H_ */
 
@@ -0,0 +1,183 @@
+/**
+ ******************************************************************************
+ * @addtogroup Libraries Libraries
+ * @{
+ * @addtogroup FlightMath Filtering support libraries
+ * @{
+ *
+ * @file       fft.c
+ * @author     dRonin, http://dronin.org, Copyright (C) 2017
+ * @brief      Small in-place radix-2 FFT
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#include <stdint.h>
+#include <math.h>
+#include "fft.h"
+
+/**
+ * Fill a twiddle table for a transform of 1 << log2n points.
+ * \param[out] twiddle Table of 1 << log2n floats
+ * \param[in] log2n Transform size as a power of two
+ */
+void fft_twiddle_create(float *twiddle, uint8_t log2n)
+{
+	uint16_t n = 1 << log2n;
+
+	for (uint16_t i = 0; i < n / 2; i++) {
+		twiddle[i] = cosf(2.0f * (float)M_PI * i / n);
+		twiddle[n / 2 + i] = sinf(2.0f * (float)M_PI * i / n);
+	}
+}
+
+/**
+ * Reverse the low log2n bits of an index.
+ */
+uint16_t fft_bitrev(uint16_t i, uint8_t log2n)
+{
+	uint16_t r = 0;
+
+	for (int b = 0; b < log2n; b++) {
+		r = (r << 1) | (i & 1);
+		i >>= 1;
+	}
+
+	return r;
+}
+
+/**
+ * Hann window coefficient for sample i, taken from the twiddle table
+ * using its symmetry about N/2.
+ */
+float fft_hann(const float *twiddle, uint8_t log2n, uint16_t i)
+{
+	uint16_t n = 1 << log2n;
+
+	if (i == n / 2)
+		return 1.0f;
+
+	if (i > n / 2)
+		i = n - i;
+
+	return 0.5f - 0.5f * twiddle[i];
+}
+
+/**
+ * Run one butterfly stage of the forward transform.  Running stages 0
+ * to log2n - 1 in order over bit-reversed input completes the transform,
+ * which lets callers spread the work out over time.
+ * \param[in,out] work 1 << log2n interleaved re/im pairs
+ * \param[in] twiddle Table from fft_twiddle_create()
+ * \param[in] log2n Transform size as a power of two
+ * \param[in] stage Stage to run
+ */
+void fft_stage(float *work, const float *twiddle, uint8_t log2n, uint8_t stage)
+{
+	uint16_t n = 1 << log2n;
+	const float *cos_tbl = twiddle;
+	const float *sin_tbl = twiddle + n / 2;
+
+	uint16_t half = 1 << stage;
+	uint16_t stride = n >> (stage + 1);
+
+	for (uint16_t k = 0; k < n; k += 2 * half) {
+		for (uint16_t j = 0; j < half; j++) {
+			float c = cos_tbl[j * stride];
+			float s = sin_tbl[j * stride];
+
+			float *a = work + 2 * (k + j);
+			float *b = a + 2 * half;
+
+			float tr = c * b[0] + s * b[1];
+			float ti = c * b[1] - s * b[0];
+
+			b[0] = a[0] - tr;
+			b[1] = a[1] - ti;
+			a[0] += tr;
+			a[1] += ti;
+		}
+	}
+}
+
+/**
+ * Run the whole forward transform over bit-reversed input.
+ */
+void fft_run(float *work, const float *twiddle, uint8_t log2n)
+{
+	for (uint8_t stage = 0; stage < log2n; stage++)
+		fft_stage(work, twiddle, log2n, stage);
+}
+
+/**
+ * Find the strongest local maxima of a magnitude spectrum.
+ * \param[in] mag Magnitudes; bins lo - 1 to hi + 1 must be valid
+ * \param[in] lo First bin to search
+ * \param[in] hi Last bin to search
+ * \param[in] threshold Peaks must be above this magnitude
+ * \param[in] max_peaks Maximum number of peaks to return
+ * \param[out] peak_bin Interpolated bin position of each peak
+ * \param[out] peak_mag Magnitude of each peak
+ * \returns number of peaks found, strongest first
+ */
+uint8_t fft_find_peaks(const float *mag, uint16_t lo, uint16_t hi, float threshold,
+		uint8_t max_peaks, float *peak_bin, float *peak_mag)
+{
+	uint8_t found = 0;
+
+	if (max_peaks == 0)
+		return 0;
+
+	for (uint16_t b = lo; b <= hi; b++) {
+		float c = mag[b];
+
+		if (c <= threshold || c <= mag[b - 1] || c < mag[b + 1])
+			continue;
+
+		int pos = found;
+		while (pos > 0 && peak_mag[pos - 1] < c)
+			pos--;
+
+		if (pos >= max_peaks)
+			continue;
+
+		int last = (found < max_peaks) ? found : max_peaks - 1;
+		for (int i = last; i > pos; i--) {
+			peak_mag[i] = peak_mag[i - 1];
+			peak_bin[i] = peak_bin[i - 1];
+		}
+
+		// Parabolic interpolation between the neighbouring bins.
+		float l = mag[b - 1], r = mag[b + 1];
+		float denom = l - 2.0f * c + r;
+		float delta = (denom != 0.0f) ? 0.5f * (l - r) / denom : 0.0f;
+
+		peak_mag[pos] = c;
+		peak_bin[pos] = b + delta;
+
+		if (found < max_peaks)
+			found++;
+	}
+
+	return found;
+}
+
+/**
+ * @}
+ * @}
+ */
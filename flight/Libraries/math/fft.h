@@ -0,0 +1,48 @@
+/**
+ ******************************************************************************
+ * @addtogroup Libraries Libraries
+ * @{
+ * @addtogroup FlightMath Filtering support libraries
+ * @{
+ *
+ * @file       fft.h
+ * @author     dRonin, http://dronin.org, Copyright (C) 2017
+ * @brief      Small in-place radix-2 FFT
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef FFT_H
+#define FFT_H
+
+#include <stdint.h>
+
+/*
+ * Transforms work on N = 1 << log2n interleaved re/im pairs.  The twiddle
+ * table holds N floats: cos[N / 2] followed by sin[N / 2].  Input has to
+ * be loaded in bit-reversed order, see fft_bitrev().
+ */
+void fft_twiddle_create(float *twiddle, uint8_t log2n);
+uint16_t fft_bitrev(uint16_t i, uint8_t log2n);
+float fft_hann(const float *twiddle, uint8_t log2n, uint16_t i);
+void fft_stage(float *work, const float *twiddle, uint8_t log2n, uint8_t stage);
+void fft_run(float *work, const float *twiddle, uint8_t log2n);
+uint8_t fft_find_peaks(const float *mag, uint16_t lo, uint16_t hi, float threshold,
+		uint8_t max_peaks, float *peak_bin, float *peak_mag);
+
+#endif // FFT_H
@@ -59,30 +59,32 @@ static const float lpfilter_butterworth_factors[16] = {
 	0.3902f, 1.1111f, 1.6629f, 1.9616f
 };
 
-struct lpfilter_biquad_state {
-	float x1, x2, y1, y2;
-};
+#define MAX_BIQUADS			4
 
+/*
+ * Biquads run in transposed direct form II, which needs two state
+ * variables per axis instead of four.  Coefficients for all stages live
+ * in the filter state itself, and the per-axis state is one contiguous
+ * block laid out structure-of-arrays:
+ *
+ *   [first order: prev[width]] [stage 0: z1[width] z2[width]] [stage 1...
+ *
+ * so each stage walks all axes over adjacent memory, and the independent
+ * per-axis multiply-adds can be pipelined by the FPU.
+ */
 struct lpfilter_biquad {
 	float b0, a1, a2;
-	struct lpfilter_biquad_state *s;
-};
-
-struct lpfilter_first_order {
-	float alpha;
-	float *prev;
 };
 
 struct lpfilter_state {
-
-	struct lpfilter_first_order *first_order;
-	struct lpfilter_biquad *biquad[4];
+	struct lpfilter_biquad biquad[MAX_BIQUADS];
+	float alpha;
+	float *state;
 	uint8_t order;
 	uint8_t width;
-
 };
 
-void lpfilter_construct_single_biquad(struct lpfilter_biquad *b, float cutoff, float dT, float q, uint8_t width)
+static void lpfilter_construct_single_biquad(struct lpfilter_biquad *b, float cutoff, float dT, float q)
 {
 	float f = 1.0f / tanf((float)M_PI*cutoff*dT);
 
@@ -91,15 +93,9 @@ void lpfilter_construct_single_biquad(struct lpfilter_biquad *b, float cutoff, f
 	b->b0 = 1.0f / (1.0f + q*f + f*f);
 	b->a1 = 2.0f * (f*f - 1.0f) * b->b0;
 	b->a2 = -(1.0f - q*f + f*f) * b->b0;
-
-	b->s = PIOS_malloc_no_dma(sizeof(struct lpfilter_biquad_state)*width);
-	if(!b->s)
-		PIOS_Assert(0);
-
-	memset((void*)b->s, 0, sizeof(struct lpfilter_biquad_state)*width);
 }
 
-void lpfilter_construct_biquads(lpfilter_state_t filt, float cutoff, float dT, int o, uint8_t width)
+static void lpfilter_construct_biquads(lpfilter_state_t filt, float cutoff, float dT, int o)
 {
 	// Amount of biquad filters needed.
 	int len = o >> 1;
@@ -113,15 +109,9 @@ void lpfilter_construct_biquads(lpfilter_state_t filt, float cutoff, float dT, i
 		addr += i >> 1;
 	}
 
-	// Create all necessary biquads and allocate, too, if not yet done so.
 	for(int i = 0; i < len; i++)
 	{
-		if(!filt->biquad[i]) {
-			filt->biquad[i] = PIOS_malloc_no_dma(sizeof(struct lpfilter_biquad));
-			if(!filt->biquad[i])
-				PIOS_Assert(0);
-		}
-		lpfilter_construct_single_biquad(filt->biquad[i], cutoff, dT, lpfilter_butterworth_factors[addr+i], width);
+		lpfilter_construct_single_biquad(&filt->biquad[i], cutoff, dT, lpfilter_butterworth_factors[addr+i]);
 	}
 }
 
@@ -153,25 +143,24 @@ void lpfilter_create(lpfilter_state_t *filter_ptr, float cutoff, float dT, uint8
 		return;
 	} else if(order > 8) order = 8;
 
-	if(order & 0x1) {
-		// Filter is odd, allocate the first order filter.
-		if(!filter->first_order) {
-			filter->first_order = PIOS_malloc_no_dma(sizeof(struct lpfilter_first_order));
-			if(!filter->first_order)
-				PIOS_Assert(0);
-
-			filter->first_order->prev = PIOS_malloc_no_dma(sizeof(float)*width);
-			if(!filter->first_order->prev)
-				PIOS_Assert(0);
-		}
+	// State for the largest order is allocated once, so changing the
+	// order later on doesn't leak.
+	if(!filter->state) {
+		filter->state = PIOS_malloc_no_dma(sizeof(float) * width * (1 + 2 * MAX_BIQUADS));
+		if(!filter->state)
+			PIOS_Assert(0);
+	}
+
+	memset(filter->state, 0, sizeof(float) * width * (1 + 2 * MAX_BIQUADS));
 
-		filter->first_order->alpha = expf(-2.0f * (float)(M_PI) * cutoff * dT);
-		memset((void*)filter->first_order->prev, 0, sizeof(float)*width);
+	if(order & 0x1) {
+		// Filter is odd, set up the first order stage.
+		filter->alpha = expf(-2.0f * (float)(M_PI) * cutoff * dT);
 	}
 
 	filter->order = order;
 	filter->width = width;
-	lpfilter_construct_biquads(filter, cutoff, dT, order, width);
+	lpfilter_construct_biquads(filter, cutoff, dT, order);
 }
 
 float lpfilter_run_single(lpfilter_state_t filter, uint8_t axis, float sample)
@@ -189,27 +178,28 @@ float lpfilter_run_single(lpfilter_state_t filter, uint8_t axis, float sample)
 	if(!order)
 		return sample;
 
+	int width = filter->width;
+	float *s = filter->state + axis;
+
 	if(order & 0x1) {
 		// Odd order filter
-		filter->first_order->prev[axis] *= filter->first_order->alpha;
-		filter->first_order->prev[axis] += (1 - filter->first_order->alpha) * sample;
-		sample = filter->first_order->prev[axis];
+		*s = filter->alpha * *s + (1 - filter->alpha) * sample;
+		sample = *s;
 	}
 
 	// Run all generated biquads.
 	order >>= 1;
 	for(int i = 0; i < order; i++)
 	{
-		struct lpfilter_biquad *b = filter->biquad[i];
-		struct lpfilter_biquad_state *s = &b->s[axis];
-
-		float y = b->b0 * (sample + 2.0f * s->x1 + s->x2) + b->a1 * s->y1 + b->a2 * s->y2;
+		const struct lpfilter_biquad *b = &filter->biquad[i];
+		float *z1 = s + (1 + 2 * i) * width;
+		float *z2 = z1 + width;
 
-		s->y2 = s->y1;
-		s->y1 = y;
+		float bx = b->b0 * sample;
+		float y = bx + *z1;
 
-		s->x2 = s->x1;
-		s->x1 = sample;
+		*z1 = 2.0f * bx + b->a1 * y + *z2;
+		*z2 = bx + b->a2 * y;
 
 		sample = y;
 	}
@@ -225,33 +215,37 @@ void lpfilter_run(lpfilter_state_t filter, float *sample)
 	// Order at zero means bypass.
 	if(order == 0) return;
 
+	int width = filter->width;
+	float *s = filter->state;
+
 	if(order & 0x1) {
 		// Odd order filter
-		for(int i = 0; i < filter->width; i++)
+		float alpha = filter->alpha;
+
+		for(int j = 0; j < width; j++)
 		{
-			filter->first_order->prev[i] *= filter->first_order->alpha;
-			filter->first_order->prev[i] += (1 - filter->first_order->alpha) * sample[i];
-			sample[i] = filter->first_order->prev[i];
+			s[j] = alpha * s[j] + (1 - alpha) * sample[j];
+			sample[j] = s[j];
 		}
 	}
 
-	// Run all generated biquads.
+	// Run all generated biquads, all axes per stage.
 	order >>= 1;
 	for(int i = 0; i < order; i++)
 	{
-		struct lpfilter_biquad *b = filter->biquad[i];
+		float b0 = filter->biquad[i].b0;
+		float a1 = filter->biquad[i].a1;
+		float a2 = filter->biquad[i].a2;
+		float *z1 = s + (1 + 2 * i) * width;
+		float *z2 = z1 + width;
 
-		for(int j = 0; j < filter->width; j++)
+		for(int j = 0; j < width; j++)
 		{
-			struct lpfilter_biquad_state *s = &b->s[j];
-
-			float y = b->b0 * (sample[j] + 2.0f * s->x1 + s->x2) + b->a1 * s->y1 + b->a2 * s->y2;
-
-			s->y2 = s->y1;
-			s->y1 = y;
+			float bx = b0 * sample[j];
+			float y = bx + z1[j];
 
-			s->x2 = s->x1;
-			s->x1 = sample[j];
+			z1[j] = 2.0f * bx + a1 * y + z2[j];
+			z2[j] = bx + a2 * y;
 
 			sample[j] = y;
 		}
@@ -185,6 +185,8 @@ struct rtkf_state {
 
 	float biaslim;
 
+	bool have_gains;
+
 };
 
 /*
@@ -206,6 +208,7 @@ struct rtkf_state {
 			break;
 		} else if (rtkf_calculate_covariance_3x3(rtkf->A, rtkf->K, rtkf->P, rtkf->Q, rtkf->R) && rtkf->solver_iterations > SOLVER_MIN) {
 			rtkf->solver_iterations = -1;
+			rtkf->have_gains = true;
 			break;
 		}
  	}
@@ -379,6 +382,11 @@ struct lqr_state {
 	float Q[2][2];
 	float u;
 
+	/* Gains of the last converged solution, which the controller keeps
+	   using while the solver works on new weights. */
+	float Kactive[2];
+	bool have_gains;
+
 	float beta;
 	float tau;
 
@@ -400,7 +408,8 @@ struct lqr_state {
 	five seconds. It was a tri-state LQR though.
 
 	Changing the Q state weight matrix in middle operation usually seems to restabilize within
-	a 100 cycles, so TxPID for tuning might qualify.
+	a 100 cycles, so TxPID for tuning might qualify. The solver restarts from the previous
+	covariance and the previous gains stay in use until it converges again.
 */
 void lqr_stabilize_covariance(lqr_t lqr, int iterations)
 {
@@ -416,6 +425,9 @@ void lqr_stabilize_covariance(lqr_t lqr, int iterations)
 			break;
 		} else if (lqr_calculate_covariance_2x2(lqr->A, lqr->B, lqr->K, lqr->P, lqr->Q, lqr->R) && lqr->solver_iterations > SOLVER_MIN) {
 			lqr->solver_iterations = -1;
+			lqr->Kactive[0] = lqr->K0;
+			lqr->Kactive[1] = lqr->K1;
+			lqr->have_gains = true;
 			break;
 		}
 	}
@@ -487,8 +499,8 @@ void lqr_update(lqr_t lqr, float q1, float q2, float r)
 void lqr_get_gains(lqr_t lqr, float K[2])
 {
 	PIOS_Assert(lqr);
-	K[0] = lqr->K[0];
-	K[1] = lqr->K[1];
+	K[0] = lqr->Kactive[0];
+	K[1] = lqr->Kactive[1];
 }
 
 
@@ -523,7 +535,7 @@ float lqg_controller(lqg_t lqg, float signal, float setpoint)
 
 	float xr0 = x_est[0] - setpoint;
 
-	float u = x_est[2] - lqr->K0 * xr0 - lqr->K1 * x_est[1];
+	float u = x_est[2] - lqr->Kactive[0] * xr0 - lqr->Kactive[1] * x_est[1];
 	if (u < -1) u = -1;
 	else if (u > 1) u = 1;
 
@@ -578,6 +590,51 @@ lqr_t lqg_get_lqr(lqg_t lqg)
 	return lqg ? lqg->lqr : NULL;
 }
 
+/*
+	Whether the controller has gains to run with. That's the case once both
+	solvers converged, and stays so while the LQR re-solves for new weights.
+*/
+bool lqg_gains_valid(lqg_t lqg)
+{
+	if (lqg_solver_status(lqg) == LQG_SOLVER_FAILED)
+		return false;
+	return lqg->rtkf->have_gains && lqg->lqr->have_gains;
+}
+
+/*
+	Export the converged Kalman and regulator gains, e.g. to cache them.
+*/
+void lqg_get_solution(lqg_t lqg, float rtkf_K[3], float lqr_K[2])
+{
+	PIOS_Assert(lqg);
+
+	memcpy(rtkf_K, lqg->rtkf->K, sizeof(lqg->rtkf->K));
+	lqr_get_gains(lqg->lqr, lqr_K);
+}
+
+/*
+	Install previously converged gains for the same system and weights,
+	skipping the solvers. A later lqr_update() re-solves from scratch.
+*/
+void lqg_set_solution(lqg_t lqg, const float rtkf_K[3], const float lqr_K[2])
+{
+	PIOS_Assert(lqg);
+
+	rtkf_t rtkf = lqg->rtkf;
+	lqr_t lqr = lqg->lqr;
+
+	memcpy(rtkf->K, rtkf_K, sizeof(rtkf->K));
+	rtkf->solver_iterations = -1;
+	rtkf->have_gains = true;
+
+	lqr->K0 = lqr_K[0];
+	lqr->K1 = lqr_K[1];
+	lqr->Kactive[0] = lqr_K[0];
+	lqr->Kactive[1] = lqr_K[1];
+	lqr->solver_iterations = -1;
+	lqr->have_gains = true;
+}
+
 void lqg_run_covariance(lqg_t lqg, int iter)
 {
 	rtkf_t rtkf = lqg_get_rtkf(lqg);
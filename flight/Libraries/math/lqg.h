@@ -59,6 +59,9 @@ extern lqr_t lqg_get_lqr(lqg_t lqg);
 extern rtkf_t lqg_get_rtkf(lqg_t lqg);
 
 extern void lqg_run_covariance(lqg_t lqg, int iter);
+extern bool lqg_gains_valid(lqg_t lqg);
+extern void lqg_get_solution(lqg_t lqg, float rtkf_K[3], float lqr_K[2]);
+extern void lqg_set_solution(lqg_t lqg, const float rtkf_K[3], const float lqr_K[2]);
 
 extern float lqg_controller(lqg_t lqg, float signal, float setpoint);
 
@@ -0,0 +1,240 @@
+/**
+ ******************************************************************************
+ * @addtogroup Libraries Libraries
+ * @{
+ * @addtogroup FlightMath math support libraries
+ * @{
+ *
+ * @file       magfit.c
+ * @author     dRonin, http://dronin.org, Copyright (C) 2017
+ * @brief      Streaming ellipsoid fit for magnetometer calibration
+ *
+ * Fits A x^2 + B y^2 + C z^2 + D x + E y + F z = 1 to the samples by least
+ * squares.  Only the sums the normal equations need are kept, each decayed
+ * by the forgetting factor as a sample goes in, so the memory taken is the
+ * same after a minute of flight as after a second and the fit follows the
+ * field as it changes.  The bias and per axis scale come from the solution
+ * the same way the GCS gets them from its batch fit.
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#include <math.h>
+#include <string.h>
+#include "magfit.h"
+
+//! Index of element i, j (i <= j) of the packed upper triangle
+#define NORMAL_IDX(i, j) ((i) * MAGFIT_TERMS - (i) * ((i) - 1) / 2 + (j) - (i))
+
+//! Center moves, as a fraction of the radius, that start the coverage over
+#define CENTER_MOVED 0.1f
+
+/**
+ * Start a fit with no samples
+ * @param[out] fit the fit
+ * @param[in] forget factor each sample's weight is multiplied by as each
+ * later sample comes in; 1 forgets nothing
+ */
+void magfit_init(struct magfit *fit, float forget)
+{
+	memset(fit, 0, sizeof(*fit));
+
+	fit->forget = forget;
+}
+
+/**
+ * Take a sample into the fit
+ * @param[in] fit the fit
+ * @param[in] mag the sample
+ * @param[in] min_change samples closer than this to the last one taken in
+ * are dropped, so hovering in one direction doesn't wash the other
+ * directions out of the fit
+ * @return true if the sample was used
+ */
+bool magfit_add(struct magfit *fit, const float mag[3], float min_change)
+{
+	if (!isfinite(mag[0]) || !isfinite(mag[1]) || !isfinite(mag[2]))
+		return false;
+
+	if (fit->samples) {
+		float d[3] = {
+			mag[0] - fit->last[0],
+			mag[1] - fit->last[1],
+			mag[2] - fit->last[2],
+		};
+
+		if (d[0] * d[0] + d[1] * d[1] + d[2] * d[2] < min_change * min_change)
+			return false;
+	} else {
+		fit->unit = sqrtf(mag[0] * mag[0] + mag[1] * mag[1] + mag[2] * mag[2]);
+
+		if (!(fit->unit > 0))
+			return false;
+	}
+
+	fit->last[0] = mag[0];
+	fit->last[1] = mag[1];
+	fit->last[2] = mag[2];
+
+	float x = mag[0] / fit->unit;
+	float y = mag[1] / fit->unit;
+	float z = mag[2] / fit->unit;
+
+	const float phi[MAGFIT_TERMS] = { x * x, y * y, z * z, x, y, z };
+
+	int k = 0;
+	for (int i = 0; i < MAGFIT_TERMS; i++) {
+		for (int j = i; j < MAGFIT_TERMS; j++, k++) {
+			fit->normal[k] = fit->normal[k] * fit->forget + phi[i] * phi[j];
+		}
+
+		fit->rhs[i] = fit->rhs[i] * fit->forget + phi[i];
+	}
+
+	fit->weight = fit->weight * fit->forget + 1;
+
+	fit->octants |= 1 << ((mag[0] > fit->center[0]) |
+			((mag[1] > fit->center[1]) << 1) |
+			((mag[2] > fit->center[2]) << 2));
+
+	fit->samples++;
+
+	return true;
+}
+
+/**
+ * Solve for the ellipsoid through the samples so far
+ * @param[in] fit the fit; the center it keeps to track coverage is moved
+ * @param[in] expected_norm the field strength, or 0 to scale to the mean
+ * radius of the ellipsoid
+ * @param[out] result the calibration, when there is one
+ * @return true if the samples gave an ellipsoid
+ */
+bool magfit_solve(struct magfit *fit, float expected_norm, struct magfit_result *result)
+{
+	float l[MAGFIT_TERMS][MAGFIT_TERMS];
+	float theta[MAGFIT_TERMS];
+
+	if (fit->samples < 2 * MAGFIT_TERMS)
+		return false;
+
+	float trace = 0;
+	for (int i = 0; i < MAGFIT_TERMS; i++)
+		trace += fit->normal[NORMAL_IDX(i, i)];
+
+	// A little ridge so that a sliver of coverage fails cleanly
+	float ridge = 1e-6f * trace / MAGFIT_TERMS;
+
+	// Cholesky factor of the normal matrix, lower triangle
+	for (int i = 0; i < MAGFIT_TERMS; i++) {
+		for (int j = 0; j <= i; j++) {
+			float sum = fit->normal[NORMAL_IDX(j, i)];
+
+			if (i == j)
+				sum += ridge;
+
+			for (int k = 0; k < j; k++)
+				sum -= l[i][k] * l[j][k];
+
+			if (i == j) {
+				if (!(sum > 0))
+					return false;
+
+				l[i][i] = sqrtf(sum);
+			} else {
+				l[i][j] = sum / l[j][j];
+			}
+		}
+	}
+
+	// L L' theta = rhs
+	for (int i = 0; i < MAGFIT_TERMS; i++) {
+		float sum = fit->rhs[i];
+
+		for (int k = 0; k < i; k++)
+			sum -= l[i][k] * theta[k];
+
+		theta[i] = sum / l[i][i];
+	}
+
+	for (int i = MAGFIT_TERMS - 1; i >= 0; i--) {
+		float sum = theta[i];
+
+		for (int k = i + 1; k < MAGFIT_TERMS; k++)
+			sum -= l[k][i] * theta[k];
+
+		theta[i] = sum / l[i][i];
+	}
+
+	float center[3], radius[3];
+	float g = 1;
+
+	for (int i = 0; i < 3; i++) {
+		if (!(theta[i] > 0))
+			return false;
+
+		center[i] = -theta[3 + i] / (2 * theta[i]);
+		g += theta[i] * center[i] * center[i];
+	}
+
+	if (!(g > 0))
+		return false;
+
+	for (int i = 0; i < 3; i++)
+		radius[i] = sqrtf(g / theta[i]);
+
+	// What's left of sum (theta' phi - 1)^2 = theta' N theta - 2 theta' rhs + weight
+	float sq = fit->weight;
+
+	for (int i = 0; i < MAGFIT_TERMS; i++) {
+		float n_theta = 0;
+
+		for (int j = 0; j < MAGFIT_TERMS; j++) {
+			n_theta += fit->normal[(i <= j) ? NORMAL_IDX(i, j) : NORMAL_IDX(j, i)] * theta[j];
+		}
+
+		sq += theta[i] * (n_theta - 2 * fit->rhs[i]);
+	}
+
+	float mean_radius = cbrtf(radius[0] * radius[1] * radius[2]) * fit->unit;
+	float norm = (expected_norm > 0) ? expected_norm : mean_radius;
+
+	float moved = 0;
+
+	for (int i = 0; i < 3; i++) {
+		result->bias[i] = center[i] * fit->unit;
+		result->scale[i] = norm / (radius[i] * fit->unit);
+
+		moved += fabsf(result->bias[i] - fit->center[i]);
+		fit->center[i] = result->bias[i];
+	}
+
+	if (moved > CENTER_MOVED * mean_radius)
+		fit->octants = 0;
+
+	// The equation is off by about twice the fraction the radius is off by
+	result->residual = 50.0f * sqrtf(fmaxf(sq, 0) / fit->weight);
+	result->coverage = __builtin_popcount(fit->octants);
+
+	return true;
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,83 @@
+/**
+ ******************************************************************************
+ * @addtogroup Libraries Libraries
+ * @{
+ * @addtogroup FlightMath math support libraries
+ * @{
+ *
+ * @file       magfit.h
+ * @author     dRonin, http://dronin.org, Copyright (C) 2017
+ * @brief      Streaming ellipsoid fit for magnetometer calibration
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef MAGFIT_H
+#define MAGFIT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+//! Terms of the axis aligned ellipsoid A x^2 + B y^2 + C z^2 + D x + E y + F z = 1
+#define MAGFIT_TERMS 6
+
+/**
+ * Least squares sums for the ellipsoid, with older samples forgotten
+ * geometrically.  Constant size however many samples go in.
+ */
+struct magfit {
+	//! Upper triangle of the sum of phi phi', row by row
+	float normal[MAGFIT_TERMS * (MAGFIT_TERMS + 1) / 2];
+	//! Sum of phi
+	float rhs[MAGFIT_TERMS];
+	//! Sum of the sample weights
+	float weight;
+
+	float forget;
+	//! Samples are divided by this, so the sums stay well conditioned
+	float unit;
+
+	//! The last sample taken in, and the center of the last fit
+	float last[3];
+	float center[3];
+
+	uint32_t samples;
+	//! Bit per octant about the center that samples have been seen in
+	uint8_t octants;
+};
+
+struct magfit_result {
+	float bias[3];
+	//! Per axis gain which makes the ellipsoid a sphere of the expected norm
+	float scale[3];
+	//! RMS distance of the samples from the ellipsoid, as % of its radius
+	float residual;
+	//! Octants about the center that have been seen, out of 8
+	uint8_t coverage;
+};
+
+void magfit_init(struct magfit *fit, float forget);
+bool magfit_add(struct magfit *fit, const float mag[3], float min_change);
+bool magfit_solve(struct magfit *fit, float expected_norm, struct magfit_result *result);
+
+#endif /* MAGFIT_H */
+
+/**
+ * @}
+ * @}
+ */
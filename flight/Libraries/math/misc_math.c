@@ -133,6 +133,50 @@ float expoM(float x, int32_t g, float exponent) {
 	return out;
 }
 
+/**
+ * Tabulate expoM() for one set of parameters
+ * @param[out] table the table to fill in
+ * @param[in] g   sets the exponential amount [0,100]
+ * @param[in] exponent the exponent of the curve
+ *
+ * The curve is odd, so only [0,1] is kept, as fractions of 65535.
+ */
+void expo_table_build(struct expo_table *table, int32_t g, float exponent)
+{
+	for (int i = 0; i <= EXPO_TABLE_SEGMENTS; i++) {
+		float out = expoM((float) i / EXPO_TABLE_SEGMENTS, g, exponent);
+
+		table->points[i] = out * 65535.0f + 0.5f;
+	}
+}
+
+/**
+ * Evaluate an expo curve tabulated by expo_table_build()
+ * @param[in] table the curve
+ * @param[in] x   input from [-1,1]; outside it the output saturates
+ * @return  rescaled input, the same as expoM() to within interpolation
+ * error
+ */
+float expo_table_eval(const struct expo_table *table, float x)
+{
+	float mag = fabsf(x);
+
+	if (!(mag < 1.0f)) {
+		// Saturated, or NaN which is passed through
+		return (mag >= 1.0f) ? sign(x) : x;
+	}
+
+	float scale = mag * EXPO_TABLE_SEGMENTS;
+	int idx = scale;
+
+	float lo = table->points[idx];
+	float hi = table->points[idx + 1];
+
+	float out = (lo + (hi - lo) * (scale - idx)) * (1.0f / 65535.0f);
+
+	return (x < 0) ? -out : out;
+}
+
 /**
  * Interpolate values (groundspeeds, altitudes) over flight legs
  * @param[in] fraction how far we are through the leg
@@ -57,6 +57,21 @@ float circular_modulus_rad(float err);
 float expo3(float x, int32_t g);
 float expoM(float x, int32_t g, float exponent);
 
+/**
+ * Segments an expo_table divides [0,1] into.  The interpolation error is
+ * at most g * exponent * (exponent - 1) / (8 * EXPO_TABLE_SEGMENTS^2),
+ * about 6e-5 for the default rate settings and 0.7% in the very worst case.
+ */
+#define EXPO_TABLE_SEGMENTS 64
+
+//! expoM() tabulated at uniform spacing, so evaluating it needs no powf
+struct expo_table {
+	uint16_t points[EXPO_TABLE_SEGMENTS + 1];
+};
+
+void expo_table_build(struct expo_table *table, int32_t g, float exponent);
+float expo_table_eval(const struct expo_table *table, float x);
+
 float interpolate_value(const float fraction, const float beginVal,
 			const float endVal);
 float vectorn_magnitude(const float *v, int n);
@@ -106,6 +121,112 @@ static inline int16_t sin_approx(int32_t x)
 	return x * ( (3<<s_qP) - (x*x>>qR) ) >> qS;
 }
 
+/** @brief Fast approximation of 1 / sqrtf(x)
+ * Bit-level initial guess followed by two Newton steps, good to about
+ * 5e-6 relative error for normal, positive x.  Avoids the divide and the
+ * square root when normalizing vectors and quaternions.
+ * @param[in] x the value, > 0
+ * @returns approximately 1 / sqrtf(x)
+ */
+static inline float fast_invsqrtf(float x)
+{
+	union {
+		float f;
+		uint32_t i;
+	} conv;
+
+	conv.f = x;
+	conv.i = 0x5f3759df - (conv.i >> 1);
+
+	const float half_x = 0.5f * x;
+
+	conv.f *= 1.5f - half_x * conv.f * conv.f;
+	conv.f *= 1.5f - half_x * conv.f * conv.f;
+
+	return conv.f;
+}
+
+/* Reduces atan2 to an atan of t = min / max in [0, 1], then unfolds the
+ * octant.  Shared by the approximations below. */
+static inline float atan2_octant(float y, float x, float atan_t)
+{
+	if (fabsf(y) > fabsf(x)) {
+		atan_t = 1.57079632679f - atan_t;
+	}
+
+	if (x < 0) {
+		atan_t = 3.14159265359f - atan_t;
+	}
+
+	return (y < 0) ? -atan_t : atan_t;
+}
+
+/** @brief Fast approximation of atan2f(y, x)
+ * Ninth order minimax polynomial (Abramowitz and Stegun 4.4.47) over one
+ * octant, good to about 1e-5 rad.  Enough for attitude and error angles,
+ * for about a third the cycles of libm.
+ * @param[in] y the ordinate
+ * @param[in] x the abscissa
+ * @returns the angle of (x, y) in [-pi, pi], 0 for the origin
+ */
+static inline float fast_atan2f(float y, float x)
+{
+	float ax = fabsf(x), ay = fabsf(y);
+	float mx = (ax > ay) ? ax : ay;
+	float mn = (ax > ay) ? ay : ax;
+
+	if (mx == 0) {
+		return 0;
+	}
+
+	float t = mn / mx;
+	float t2 = t * t;
+
+	float a = t * (0.9998660f + t2 * (-0.3302995f + t2 * (0.1801410f +
+			t2 * (-0.0851330f + t2 * 0.0208351f))));
+
+	return atan2_octant(y, x, a);
+}
+
+/** @brief Coarse approximation of atan2f(y, x)
+ * First order correction to the linear fit, good to about 4e-3 rad (a
+ * quarter degree).  For display and headings, not for control.
+ * @param[in] y the ordinate
+ * @param[in] x the abscissa
+ * @returns the angle of (x, y) in [-pi, pi], 0 for the origin
+ */
+static inline float fast_atan2f_coarse(float y, float x)
+{
+	float ax = fabsf(x), ay = fabsf(y);
+	float mx = (ax > ay) ? ax : ay;
+	float mn = (ax > ay) ? ay : ax;
+
+	if (mx == 0) {
+		return 0;
+	}
+
+	float t = mn / mx;
+
+	float a = t * (0.78539816f + 0.2732395f * (1 - t));
+
+	return atan2_octant(y, x, a);
+}
+
+/** @brief Fast approximation of asinf(x), to the accuracy of fast_atan2f()
+ * @param[in] x the sine, clipped to [-1, 1]
+ * @returns the angle in [-pi/2, pi/2]
+ */
+static inline float fast_asinf(float x)
+{
+	if (x >= 1) {
+		return 1.57079632679f;
+	} else if (x <= -1) {
+		return -1.57079632679f;
+	}
+
+	return fast_atan2f(x, sqrtf((1 - x) * (1 + x)));
+}
+
 /** @brief Multiplies out = a b
  *
  * Matrices are stored in row order, that is a[i*cols + j]
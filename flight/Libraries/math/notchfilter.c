@@ -0,0 +1,489 @@
+/**
+ ******************************************************************************
+ * @addtogroup Libraries Libraries
+ * @{
+ * @addtogroup FlightMath Filtering support libraries
+ * @{
+ *
+ * @file       notchfilter.c
+ * @author     dRonin, http://dronin.org, Copyright (C) 2017
+ * @brief      Dynamic notch filtering steered by a running spectrum estimate
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include "pios.h"
+#include "misc_math.h"
+#include "fft.h"
+#include "notchfilter.h"
+
+#define MAX_FILTER_WIDTH		3
+
+#define FFT_LOG2N			6
+#define FFT_N				(1 << FFT_LOG2N)
+
+//! Decimated samples between the start of two analysis runs
+#define FFT_HOP				(FFT_N / 4)
+
+//! Keep the analysis rate this far above the highest tracked frequency
+#define DECIMATION_MARGIN		2.5f
+
+//! A bin must stand this far above the band average to count as a peak
+#define PEAK_RATIO			2.0f
+
+//! How quickly notch centers follow newly found peaks
+#define FREQ_SMOOTHING			0.3f
+
+//! Steered notches closer than this to their current center aren't recomputed
+#define FREQ_UPDATE_MIN			0.5f
+
+/*
+ * The spectrum is estimated from a decimated copy of the input, with one
+ * ring buffer per axis.  Every FFT_HOP decimated samples a new analysis
+ * run starts on the next axis.  Rather than doing a whole FFT at once, a
+ * run is split into steps -- windowing, one step per butterfly stage and
+ * magnitude accumulation -- and one step is done per call of
+ * notchfilter_run(), so the cost added to any single gyro sample stays
+ * small and constant.  After every axis has been analysed, the strongest
+ * peaks of the summed spectrum steer the notch centers.
+ *
+ * Analysis and filtering both happen from notchfilter_run(), so the
+ * coefficients never change under the filter and need no locking.
+ *
+ * A steered bank skips the analysis entirely; its caller places the
+ * notches with notchfilter_set_frequency(), e.g. from motor RPM.
+ */
+enum notchfilter_step {
+	STEP_IDLE = 0,
+	STEP_LOAD,
+	STEP_BUTTERFLY_FIRST,
+	STEP_BUTTERFLY_LAST = STEP_BUTTERFLY_FIRST + FFT_LOG2N - 1,
+	STEP_MAGNITUDE,
+};
+
+struct notchfilter_biquad {
+	float c0, c1, a2;
+};
+
+struct notchfilter_state {
+	struct notchfilter_biquad *notch;
+	float *freq;
+
+	/* z1[width] z2[width] per notch */
+	float *state;
+
+	/* Spectrum analysis, only allocated for dynamic banks */
+	float *ring;	/* width * FFT_N decimated samples */
+	float *work;	/* FFT_N interleaved re/im pairs */
+	float *spectrum;	/* FFT_N / 2 magnitudes, summed over axes */
+	float *twiddle;	/* cos[FFT_N / 2] followed by sin[FFT_N / 2] */
+
+	float decim_acc[MAX_FILTER_WIDTH];
+
+	float dT;
+	float q;
+	float fs;
+
+	uint8_t min_bin;
+	uint8_t max_bin;
+	uint8_t decim;
+	uint8_t decim_count;
+	uint8_t ring_pos;
+	uint8_t hop_count;
+	uint8_t step;
+	uint8_t axis;
+
+	uint8_t num_notches;
+	uint8_t max_notches;
+	uint8_t width;
+};
+
+static void notchfilter_construct_single_biquad(struct notchfilter_biquad *b, float freq, float dT, float q)
+{
+	float w0 = 2.0f * (float)M_PI * freq * dT;
+	float cs = cosf(w0);
+	float alpha = sinf(w0) / (2.0f * q);
+	float a0_inv = 1.0f / (1.0f + alpha);
+
+	// b0 == b2 and b1 == a1 for a notch; only keep the distinct terms.
+	b->c0 = a0_inv;
+	b->c1 = -2.0f * cs * a0_inv;
+	b->a2 = (1.0f - alpha) * a0_inv;
+}
+
+static void notchfilter_load(notchfilter_state_t filter)
+{
+	const float *ring = filter->ring + filter->axis * FFT_N;
+
+	// Oldest sample first, into bit-reversed order for the butterflies.
+	for (int n = 0; n < FFT_N; n++) {
+		int idx = (filter->ring_pos + n) & (FFT_N - 1);
+		int dst = 2 * fft_bitrev(n, FFT_LOG2N);
+
+		filter->work[dst] = ring[idx] * fft_hann(filter->twiddle, FFT_LOG2N, n);
+		filter->work[dst + 1] = 0.0f;
+	}
+}
+
+static void notchfilter_set_notch(notchfilter_state_t filter, int i, float freq)
+{
+	filter->freq[i] = freq;
+	notchfilter_construct_single_biquad(&filter->notch[i], freq, filter->dT, filter->q);
+}
+
+static void notchfilter_find_peaks(notchfilter_state_t filter)
+{
+	const float *spec = filter->spectrum;
+	int lo = filter->min_bin;
+	int hi = filter->max_bin;
+
+	float mean = 0;
+	for (int b = lo; b <= hi; b++)
+		mean += spec[b];
+	mean /= (hi - lo + 1);
+
+	float peak_mag[NOTCHFILTER_MAX_NOTCHES];
+	float peak_freq[NOTCHFILTER_MAX_NOTCHES];
+	int found = fft_find_peaks(spec, lo, hi, PEAK_RATIO * mean,
+			filter->num_notches, peak_freq, peak_mag);
+
+	for (int i = 0; i < found; i++)
+		peak_freq[i] *= filter->fs / FFT_N;
+
+	// Sort by frequency, so notches keep following the same peak.
+	for (int i = 1; i < found; i++) {
+		float f = peak_freq[i];
+		int j = i;
+
+		for (; j > 0 && peak_freq[j - 1] > f; j--)
+			peak_freq[j] = peak_freq[j - 1];
+
+		peak_freq[j] = f;
+	}
+
+	// Notches without a peak this time hold their last center.
+	for (int i = 0; i < found; i++) {
+		float f = filter->freq[i];
+
+		if (f == 0.0f)
+			f = peak_freq[i];
+		else
+			f += FREQ_SMOOTHING * (peak_freq[i] - f);
+
+		notchfilter_set_notch(filter, i, f);
+	}
+}
+
+static void notchfilter_analyze_step(notchfilter_state_t filter)
+{
+	switch (filter->step) {
+	case STEP_IDLE:
+		return;
+	case STEP_LOAD:
+		notchfilter_load(filter);
+		break;
+	case STEP_MAGNITUDE:
+		for (int b = filter->min_bin - 1; b <= filter->max_bin + 1; b++) {
+			float re = filter->work[2 * b];
+			float im = filter->work[2 * b + 1];
+
+			filter->spectrum[b] += sqrtf(re * re + im * im);
+		}
+
+		if (++filter->axis >= filter->width) {
+			filter->axis = 0;
+			notchfilter_find_peaks(filter);
+			memset(filter->spectrum, 0, sizeof(float) * FFT_N / 2);
+		}
+
+		filter->step = STEP_IDLE;
+		return;
+	default:
+		fft_stage(filter->work, filter->twiddle, FFT_LOG2N, filter->step - STEP_BUTTERFLY_FIRST);
+		break;
+	}
+
+	filter->step++;
+}
+
+static void notchfilter_analyze(notchfilter_state_t filter, const float *sample)
+{
+	int width = filter->width;
+
+	for(int j = 0; j < width; j++)
+		filter->decim_acc[j] += sample[j];
+
+	if(++filter->decim_count >= filter->decim) {
+		float scale = 1.0f / filter->decim;
+
+		for(int j = 0; j < width; j++) {
+			filter->ring[j * FFT_N + filter->ring_pos] = filter->decim_acc[j] * scale;
+			filter->decim_acc[j] = 0;
+		}
+
+		filter->decim_count = 0;
+		filter->ring_pos = (filter->ring_pos + 1) & (FFT_N - 1);
+
+		if(++filter->hop_count >= FFT_HOP && filter->step == STEP_IDLE) {
+			filter->hop_count = 0;
+			filter->step = STEP_LOAD;
+		}
+	}
+
+	notchfilter_analyze_step(filter);
+}
+
+static notchfilter_state_t notchfilter_alloc(notchfilter_state_t *filter_ptr,
+		uint8_t max_notches, uint8_t width)
+{
+	if(!*filter_ptr) {
+		*filter_ptr = PIOS_malloc_no_dma(sizeof(struct notchfilter_state));
+		if(!*filter_ptr)
+			PIOS_Assert(0);
+		memset(*filter_ptr, 0, sizeof(struct notchfilter_state));
+	}
+
+	notchfilter_state_t filter = *filter_ptr;
+
+	// Memory can't be freed, so the width and bank size are fixed once
+	// allocated.
+	if((filter->width != 0 && filter->width != width) || (width > MAX_FILTER_WIDTH) || (width == 0)) {
+		PIOS_Assert(0);
+	}
+
+	if(filter->max_notches != 0 && filter->max_notches != max_notches) {
+		PIOS_Assert(0);
+	}
+
+	if(!filter->state) {
+		filter->notch = PIOS_malloc_no_dma(sizeof(*filter->notch) * max_notches);
+		filter->freq = PIOS_malloc_no_dma(sizeof(*filter->freq) * max_notches);
+		filter->state = PIOS_malloc_no_dma(sizeof(float) * width * 2 * max_notches);
+
+		if(!filter->notch || !filter->freq || !filter->state)
+			PIOS_Assert(0);
+	}
+
+	filter->width = width;
+	filter->max_notches = max_notches;
+	filter->num_notches = 0;
+
+	memset(filter->state, 0, sizeof(float) * width * 2 * max_notches);
+	memset(filter->freq, 0, sizeof(*filter->freq) * max_notches);
+
+	return filter;
+}
+
+/**
+ * Create or reconfigure a dynamic notch filter bank.
+ * \param[in,out] filter_ptr Filter to create; allocated on first use
+ * \param[in] num_notches Number of peaks to track, zero bypasses the filter
+ * \param[in] min_freq Lowest frequency to place a notch at (Hz)
+ * \param[in] max_freq Highest frequency to place a notch at (Hz)
+ * \param[in] q Quality factor of each notch
+ * \param[in] dT Sample period of the filtered signal (s)
+ * \param[in] width Number of axes
+ */
+void notchfilter_create(notchfilter_state_t *filter_ptr, uint8_t num_notches,
+		float min_freq, float max_freq, float q, float dT, uint8_t width)
+{
+	if(!filter_ptr) {
+		PIOS_Assert(0);
+	}
+
+	// Nothing to allocate until notches are actually wanted.
+	if(!*filter_ptr && num_notches == 0)
+		return;
+
+	notchfilter_state_t filter = notchfilter_alloc(filter_ptr, NOTCHFILTER_MAX_NOTCHES, width);
+
+	if(num_notches == 0)
+		return;
+	else if(num_notches > NOTCHFILTER_MAX_NOTCHES)
+		num_notches = NOTCHFILTER_MAX_NOTCHES;
+
+	if(!filter->ring) {
+		filter->ring = PIOS_malloc_no_dma(sizeof(float) * width * FFT_N);
+		filter->work = PIOS_malloc_no_dma(sizeof(float) * 2 * FFT_N);
+		filter->spectrum = PIOS_malloc_no_dma(sizeof(float) * FFT_N / 2);
+		filter->twiddle = PIOS_malloc_no_dma(sizeof(float) * FFT_N);
+
+		if(!filter->ring || !filter->work ||
+				!filter->spectrum || !filter->twiddle)
+			PIOS_Assert(0);
+
+		fft_twiddle_create(filter->twiddle, FFT_LOG2N);
+	}
+
+	memset(filter->ring, 0, sizeof(float) * width * FFT_N);
+	memset(filter->spectrum, 0, sizeof(float) * FFT_N / 2);
+	memset(filter->decim_acc, 0, sizeof(filter->decim_acc));
+
+	// Decimate so the analysis band covers the tracked range with some
+	// margin; a boxcar average is enough to keep aliasing down there.
+	float fs_in = 1.0f / dT;
+	int decim = (int)(fs_in / (DECIMATION_MARGIN * max_freq));
+	filter->decim = bound_min_max(decim, 1, 255);
+	filter->fs = fs_in / filter->decim;
+
+	max_freq = MIN(max_freq, 0.45f * filter->fs);
+
+	int min_bin = (int)(min_freq * FFT_N / filter->fs);
+	int max_bin = (int)ceilf(max_freq * FFT_N / filter->fs);
+	min_bin = MAX(min_bin, 1);
+	max_bin = MIN(max_bin, FFT_N / 2 - 2);
+
+	if(min_bin >= max_bin || q <= 0.0f)
+		return;
+
+	filter->min_bin = min_bin;
+	filter->max_bin = max_bin;
+	filter->dT = dT;
+	filter->q = q;
+	filter->decim_count = 0;
+	filter->ring_pos = 0;
+	filter->hop_count = 0;
+	filter->step = STEP_IDLE;
+	filter->axis = 0;
+	filter->num_notches = num_notches;
+}
+
+/**
+ * Create or reconfigure a notch filter bank placed by the caller.
+ * \param[in,out] filter_ptr Filter to create; allocated on first use
+ * \param[in] num_notches Number of notches, zero bypasses the filter
+ * \param[in] q Quality factor of each notch
+ * \param[in] dT Sample period of the filtered signal (s)
+ * \param[in] width Number of axes
+ */
+void notchfilter_create_steered(notchfilter_state_t *filter_ptr, uint8_t num_notches,
+		float q, float dT, uint8_t width)
+{
+	if(!filter_ptr) {
+		PIOS_Assert(0);
+	}
+
+	if(!*filter_ptr && num_notches == 0)
+		return;
+
+	notchfilter_state_t filter = notchfilter_alloc(filter_ptr, NOTCHFILTER_MAX_STEERED, width);
+
+	if(num_notches == 0 || q <= 0.0f)
+		return;
+	else if(num_notches > NOTCHFILTER_MAX_STEERED)
+		num_notches = NOTCHFILTER_MAX_STEERED;
+
+	filter->dT = dT;
+	filter->q = q;
+	filter->num_notches = num_notches;
+}
+
+/**
+ * Move one notch of a steered bank.
+ * \param[in] filter The filter bank
+ * \param[in] notch Index of the notch
+ * \param[in] freq New center frequency (Hz), zero or out of range disables it
+ */
+void notchfilter_set_frequency(notchfilter_state_t filter, uint8_t notch, float freq)
+{
+	if(!filter || notch >= filter->num_notches)
+		return;
+
+	if(freq <= 0.0f || freq >= 0.45f / filter->dT) {
+		if(filter->freq[notch] != 0.0f) {
+			// Start from rest when it comes back.
+			float *z1 = filter->state + 2 * notch * filter->width;
+			memset(z1, 0, sizeof(float) * 2 * filter->width);
+			filter->freq[notch] = 0.0f;
+		}
+
+		return;
+	}
+
+	if(fabsf(freq - filter->freq[notch]) < FREQ_UPDATE_MIN)
+		return;
+
+	notchfilter_set_notch(filter, notch, freq);
+}
+
+/**
+ * Feed one sample per axis to the spectrum estimate, then run it through
+ * the notches in place.
+ * \param[in] filter The filter bank
+ * \param[in,out] sample Array of width samples, one per axis
+ */
+void notchfilter_run(notchfilter_state_t filter, float *sample)
+{
+	if(!filter) return;
+	int num_notches = filter->num_notches;
+
+	// No notches means bypass.
+	if(num_notches == 0) return;
+
+	int width = filter->width;
+
+	if(filter->ring)
+		notchfilter_analyze(filter, sample);
+
+	for(int i = 0; i < num_notches; i++)
+	{
+		// Not placed yet, until a peak has been found.
+		if(filter->freq[i] == 0.0f)
+			continue;
+
+		float c0 = filter->notch[i].c0;
+		float c1 = filter->notch[i].c1;
+		float a2 = filter->notch[i].a2;
+		float *z1 = filter->state + 2 * i * width;
+		float *z2 = z1 + width;
+
+		for(int j = 0; j < width; j++)
+		{
+			float x = sample[j];
+			float y = c0 * x + z1[j];
+
+			z1[j] = c1 * (x - y) + z2[j];
+			z2[j] = c0 * x - a2 * y;
+
+			sample[j] = y;
+		}
+	}
+}
+
+/**
+ * Get the current center of a notch.
+ * \param[in] filter The filter bank
+ * \param[in] notch Index of the notch
+ * \returns center frequency in Hz, or zero if the notch isn't placed
+ */
+float notchfilter_get_frequency(notchfilter_state_t filter, uint8_t notch)
+{
+	if(!filter || notch >= filter->num_notches)
+		return 0.0f;
+
+	return filter->freq[notch];
+}
+
+/**
+ * @}
+ * @}
+ */
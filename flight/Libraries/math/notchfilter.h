@@ -0,0 +1,49 @@
+/**
+ ******************************************************************************
+ * @addtogroup Libraries Libraries
+ * @{
+ * @addtogroup FlightMath Filtering support libraries
+ * @{
+ *
+ * @file       notchfilter.h
+ * @author     dRonin, http://dronin.org, Copyright (C) 2017
+ * @brief      Dynamic notch filtering steered by a running spectrum estimate
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef NOTCHFILTER_H
+#define NOTCHFILTER_H
+
+//! Most peaks a dynamic bank tracks
+#define NOTCHFILTER_MAX_NOTCHES		4
+//! Most notches in a steered bank
+#define NOTCHFILTER_MAX_STEERED		24
+
+typedef struct notchfilter_state* notchfilter_state_t;
+
+void notchfilter_create(notchfilter_state_t *filter_ptr, uint8_t num_notches,
+		float min_freq, float max_freq, float q, float dT, uint8_t width);
+void notchfilter_run(notchfilter_state_t filter, float *sample);
+float notchfilter_get_frequency(notchfilter_state_t filter, uint8_t notch);
+
+void notchfilter_create_steered(notchfilter_state_t *filter_ptr, uint8_t num_notches,
+		float q, float dT, uint8_t width);
+void notchfilter_set_frequency(notchfilter_state_t filter, uint8_t notch, float freq);
+
+#endif // NOTCHFILTER_H
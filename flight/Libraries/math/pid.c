@@ -28,6 +28,8 @@
  * with this program; if not, see <http://www.gnu.org/licenses/>
  */
 
+#include <float.h>
+
 #include "openpilot.h"
 #include "physical_constants.h"
 #include "misc_math.h"
@@ -245,6 +247,86 @@ float pid_apply_setpoint_antiwindup(struct pid *pid,
 	return ideal_output;
 }
 
+//! Bound to +/-range; written so it compiles to conditional moves
+static inline float pid_bound(float val, float range)
+{
+	val = (val > range) ? range : val;
+	return (val < -range) ? -range : val;
+}
+
+/**
+ * Rate loop core shared by the kernels.  Equivalent to
+ * pid_apply_setpoint_antiwindup() with bounds of +/-1 and an anti windup
+ * bound of 1, but the zero-gain special cases are folded into the
+ * coefficients pid_configure() precomputes, so nothing here branches on
+ * the configuration except the deadband, which is resolved at compile
+ * time in each kernel.
+ */
+static inline float pid_apply_rate_core(struct pid *pid,
+		const struct pid_deadband *deadband, float setpoint,
+		float measured, const bool use_deadband)
+{
+	float err = setpoint - measured;
+	float err_d = (deriv_gamma * setpoint - measured);
+
+	if (use_deadband) {
+		err = cubic_deadband(err, deadband->width, deadband->slope, deadband->cubic_weight,
+			deadband->integrated_response);
+		err_d = cubic_deadband(err_d, deadband->width, deadband->slope, deadband->cubic_weight,
+			deadband->integrated_response);
+	}
+
+	float pterm = err * pid->p;
+
+	// Slope-related anti windup
+	float p = pid_bound(pterm, 1.0f);
+	float accum = pid->iAccumulator + err * pid->iGain * (1 - p*p);
+	accum = pid_bound(accum, pid->iBound);
+
+	// DT1 term; with no derivative gain dAlpha is 1 and this is zero
+	float dterm = pid->lastDer + pid->dAlpha * ((err_d - pid->lastErr) * pid->dGain - pid->lastDer);
+	pid->lastErr = err_d;
+	pid->lastDer = dterm;
+
+	// Back off the integrator by however much the output saturates
+	float ideal_output = pterm + accum + dterm;
+	float output = pid_bound(ideal_output, 1.0f);
+
+	accum += (output - ideal_output) * pid->iGain;
+	pid->iAccumulator = pid_bound(accum, pid->iBound);
+
+	return output;
+}
+
+static float pid_apply_rate(struct pid *pid, const struct pid_deadband *deadband,
+		float setpoint, float measured)
+{
+	(void) deadband;
+
+	return pid_apply_rate_core(pid, NULL, setpoint, measured, false);
+}
+
+static float pid_apply_rate_deadband(struct pid *pid, const struct pid_deadband *deadband,
+		float setpoint, float measured)
+{
+	return pid_apply_rate_core(pid, deadband, setpoint, measured, true);
+}
+
+/**
+ * Pick the rate loop kernel for an axis.  Call again whenever the
+ * deadband changes.
+ * @param[in] deadband The deadband for the axis, or NULL
+ * @returns The kernel to run the axis with
+ */
+pid_rate_kernel_t pid_select_rate_kernel(const struct pid_deadband *deadband)
+{
+	if (deadband && deadband->width > 0) {
+		return pid_apply_rate_deadband;
+	}
+
+	return pid_apply_rate;
+}
+
 /**
  * Reset a bit
  * @param[in] pid The pid to reset
@@ -263,6 +345,9 @@ void pid_zero(struct pid *pid)
  * @brief Configure the common terms that alter ther derivative
  * @param[in] cutoff The cutoff frequency (in Hz)
  * @param[in] gamma The gamma term for setpoint shaping (unsused now)
+ *
+ * pid_configure() bakes the cutoff into the rate loop coefficients, so
+ * call this first.
  */
 void pid_configure_derivative(float cutoff, float g)
 {
@@ -287,6 +372,17 @@ void pid_configure(struct pid *pid, float p, float i, float d, float iLim, float
 	pid->d = d;
 	pid->iLim = iLim;
 	pid->dT = dT;
+
+	pid->iGain = i * dT;
+	pid->iBound = (i == 0) ? FLT_MAX : iLim;
+
+	if (d && dT) {
+		pid->dGain = d / dT;
+		pid->dAlpha = dT / (dT + deriv_tau);
+	} else {
+		pid->dGain = 0;
+		pid->dAlpha = 1;
+	}
 }
 
 /**
@@ -50,8 +50,18 @@ struct pid {
 	float iAccumulator;
 	float lastErr;
 	float lastDer;
+
+	// Precomputed by pid_configure() for the rate loop kernels
+	float iGain;		// i * dT
+	float iBound;		// iLim, or unbounded when i is zero
+	float dGain;		// d / dT
+	float dAlpha;		// derivative lowpass coefficient
 };
 
+//! Rate loop kernel, setpoint weighted with anti windup and output bounded to +/-1
+typedef float (*pid_rate_kernel_t)(struct pid *pid, const struct pid_deadband *deadband,
+		float setpoint, float measured);
+
 //! Methods to use the pid structures
 float pid_apply(struct pid *pid, const float err);
 float pid_apply_antiwindup(struct pid *pid, const float err, float min_bound, float max_bound, float aw_bound);
@@ -63,6 +73,7 @@ void pid_zero(struct pid *pid);
 void pid_configure(struct pid *pid, float p, float i, float d, float iLim, float dT);
 void pid_configure_derivative(float cutoff, float gamma);
 void pid_configure_deadband(struct pid_deadband *deadband, float width, float slope);
+pid_rate_kernel_t pid_select_rate_kernel(const struct pid_deadband *deadband);
 
 
 #endif /* PID_H */
@@ -38,9 +38,22 @@ struct smoothcontrol_state_internal {
 	// Control interval determined by the ringer.
 	uint8_t control_interval;
 
+	// Control interval of the last update, unfiltered.
+	uint8_t last_interval;
+
 	// Duty cycle to use.
 	float duty_cycle;
 
+	// Loop period, seconds.
+	float dT;
+
+	// How old the receiver frame was at the last update, seconds.
+	float frame_age;
+
+	// Receiver frame period estimated from the frame ages, seconds; zero
+	// until there's an estimate.
+	float frame_period;
+
 	// RPY+Thrust.
 	struct smoothcontrol_axis_state axis[4];
 };
@@ -70,6 +83,22 @@ static void smoothcontrol_update(smoothcontrol_state state, struct smoothcontrol
 			axis->differential = (new_signal - axis->current) / cycles;
 			axis->integrator_timeout = (uint8_t)cycles;
 			break;
+
+		// Carries the slope of the last frame forward, from when the frame
+		// arrived rather than when it got here.
+		case SMOOTHCONTROL_PREDICTIVE: {
+			float period = state->frame_period;
+
+			if (!(period > 0))
+				period = MAX(state->control_interval, 1) * state->dT;
+
+			float horizon = period * state->duty_cycle - state->frame_age;
+
+			axis->differential = signal_diff * SMOOTHCONTROL_PREDICTOR_SLOPE * state->dT / period;
+			axis->current = new_signal + axis->differential * state->frame_age / state->dT;
+			axis->integrator_timeout = (uint8_t)bound_min_max(horizon / state->dT, 0, 255);
+			break;
+		}
 	}
 
 	axis->signal = new_signal;
@@ -97,6 +126,7 @@ void smoothcontrol_set_mode(smoothcontrol_state state, uint8_t axis_num, uint8_t
 {
 	PIOS_Assert(state && axis_num <= 3);
 	state->duty_cycle = bound_min_max((float)duty_cycle, 0, 100) / 100.0f;
+	state->axis[axis_num].mode = mode;
 	smoothcontrol_reinit(state, axis_num, state->axis[axis_num].signal);
 }
 
@@ -170,6 +200,7 @@ void smoothcontrol_next(smoothcontrol_state state)
 	if(state->ringer) {
 		int x = ((int)state->control_interval + (int)state->tick_counter) >> 1;
 		state->control_interval = (uint8_t)MIN(x, 255);
+		state->last_interval = state->tick_counter;
 		state->tick_counter = 0;
 
 		state->ringer = false;
@@ -181,6 +212,42 @@ void smoothcontrol_update_dT(smoothcontrol_state state, float dT)
 {
 	PIOS_Assert(state);
 	state->time_bomb = (uint8_t)(SMOOTHCONTROL_TIMEBOMB / 1000.0f / dT);
+	state->dT = dT;
+}
+
+// Tells how old the newest receiver frame is, each loop before running the
+// axes.  The frames are apart by the loop time between updates, plus how much
+// older the frame was last time than now.
+void smoothcontrol_set_frame_age(smoothcontrol_state state, float age)
+{
+	PIOS_Assert(state);
+
+	if (state->tick_counter)
+		return;
+
+	if (!(age >= 0) || age > SMOOTHCONTROL_TIMEBOMB / 1000.0f) {
+		// No receiver timing; fall back on the update ticks.
+		state->frame_age = 0;
+		state->frame_period = 0;
+		return;
+	}
+
+	float period = state->last_interval * state->dT + state->frame_age - age;
+
+	state->frame_age = age;
+
+	// An update without a new frame, or a dropped one.
+	if (!(period > 0.5f * state->dT))
+		return;
+
+	if (state->frame_period > 0) {
+		if (period > 4 * state->frame_period)
+			return;
+
+		state->frame_period += SMOOTHCONTROL_PERIOD_ALPHA * (period - state->frame_period);
+	} else {
+		state->frame_period = period;
+	}
 }
 
 // Duh.
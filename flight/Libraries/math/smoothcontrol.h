@@ -14,6 +14,9 @@
 // At which ratio to start the chamfer.
 #define SMOOTHCONTROL_CHAMFER_START					0.75f
 
+// How quickly the receiver frame period estimate follows new measurements.
+#define SMOOTHCONTROL_PERIOD_ALPHA					0.25f
+
 enum {
 	// Bypass.
 	SMOOTHCONTROL_NONE,
@@ -24,6 +27,10 @@ enum {
 
 	// Linear interpolate control input.
 	SMOOTHCONTROL_LINEAR,
+
+	// Extrapolate from when the receiver frame arrived, at the previous
+	// frame's slope, paced by the measured frame period.
+	SMOOTHCONTROL_PREDICTIVE,
 };
 
 typedef struct smoothcontrol_state_internal* smoothcontrol_state;
@@ -31,6 +38,7 @@ typedef struct smoothcontrol_state_internal* smoothcontrol_state;
 
 void smoothcontrol_initialize(smoothcontrol_state *state);
 void smoothcontrol_update_dT(smoothcontrol_state state, float dT);
+void smoothcontrol_set_frame_age(smoothcontrol_state state, float age);
 void smoothcontrol_next(smoothcontrol_state state);
 void smoothcontrol_run(smoothcontrol_state state, uint8_t axis_num, float *new_signal);
 void smoothcontrol_run_thrust(smoothcontrol_state state, float *new_signal);
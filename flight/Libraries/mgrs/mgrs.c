@@ -400,7 +400,7 @@ int Make_MGRS_String (char* MGRS,
   if (Zone)
     i = sprintf (MGRS+i,"%2.2d",Zone);
   else
-    strncpy(MGRS, "  ", 2);  // 2 spaces
+    memcpy(MGRS, "  ", 2);  // 2 spaces
 
   for (j=0;j<3;j++)
     MGRS[i++] = alphabet[Letters[j]];
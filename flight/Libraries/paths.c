@@ -15,6 +15,10 @@
  * and the distance of that vector.  The distance along the path is also
  * returned in the path_status.
  *
+ * What only depends on the path (direction, length, the centre of an arc)
+ * is worked out once per @ref PathDesired and kept in a segment cache, so
+ * each control cycle only does the part that depends on the position.
+ *
  * @see        The GNU Public License (GPL) Version 3
  *
  *****************************************************************************/
@@ -39,17 +43,41 @@
 #include "uavobjectmanager.h"
 #include "pathdesired.h"
 
+// private types
+
+//! The parts of a path that don't depend on where the vehicle is
+struct path_segment {
+	// What the segment was built from
+	bool valid;
+	uint8_t mode;
+	float start[2];
+	float end[2];
+	float mode_parameters;
+
+	float length;			// start to end, in a straight line
+	float direction[2];		// unit vector from start to end
+	float normal[2];		// direction turned left
+	float center[2];		// of the arc, for curves
+	float radius;			// of the arc or circle
+	float curvature;		// 1 / radius of curves, 0 for straight paths
+};
+
+// private variables
+static struct path_segment segment;
+
 // private functions
-static void path_endpoint(const float * start_point, const float * end_point,
+static void path_segment_build(const PathDesiredData *pathDesired,
+                               struct path_segment *seg);
+static void path_endpoint(const struct path_segment *seg,
                           const float * cur_point, struct path_status * status);
-static void path_vector(const float * start_point, const float * end_point,
+static void path_vector(const struct path_segment *seg,
                         const float * cur_point, struct path_status * status);
-static void path_circle(const float * center_point, float radius,
+static void path_circle(const struct path_segment *seg,
                         const float * cur_point, struct path_status * status,
                         bool clockwise);
-static void path_curve(const float * start_point, const float * end_point,
-                       float radius, const float * cur_point,
-                       struct path_status * status, bool clockwise);
+static void path_curve(const struct path_segment *seg,
+                       const float * cur_point, struct path_status * status,
+                       bool clockwise);
 
 /**
  * @brief Compute progress along path and deviation from it
@@ -64,62 +92,177 @@ void path_progress(const PathDesiredData *pathDesired,
                    struct path_status *status)
 {
 	uint8_t mode = pathDesired->Mode;
-	float start_point[2] = {pathDesired->Start[0],pathDesired->Start[1]};
-	float end_point[2] = {pathDesired->End[0],pathDesired->End[1]};
+
+	if (!segment.valid || segment.mode != mode ||
+			segment.start[0] != pathDesired->Start[0] ||
+			segment.start[1] != pathDesired->Start[1] ||
+			segment.end[0] != pathDesired->End[0] ||
+			segment.end[1] != pathDesired->End[1] ||
+			segment.mode_parameters != pathDesired->ModeParameters) {
+		path_segment_build(pathDesired, &segment);
+	}
 
 	switch(mode) {
 		case PATHDESIRED_MODE_VECTOR:
-			return path_vector(start_point, end_point, cur_point, status);
+			return path_vector(&segment, cur_point, status);
 			break;
 		case PATHDESIRED_MODE_CIRCLERIGHT:
-			return path_curve(start_point, end_point, pathDesired->ModeParameters, cur_point, status, 1);
+			return path_curve(&segment, cur_point, status, 1);
 			break;
 		case PATHDESIRED_MODE_CIRCLELEFT:
-			return path_curve(start_point, end_point, pathDesired->ModeParameters, cur_point, status, 0);
+			return path_curve(&segment, cur_point, status, 0);
 			break;
 		case PATHDESIRED_MODE_CIRCLEPOSITIONLEFT:
-			return path_circle(end_point, pathDesired->ModeParameters, cur_point, status, 0);
+			return path_circle(&segment, cur_point, status, 0);
 			break;
 		case PATHDESIRED_MODE_CIRCLEPOSITIONRIGHT:
-			return path_circle(end_point, pathDesired->ModeParameters, cur_point, status, 1);
+			return path_circle(&segment, cur_point, status, 1);
 			break;
 		case PATHDESIRED_MODE_ENDPOINT:
 		case PATHDESIRED_MODE_HOLDPOSITION:
 		default:
 			// use the endpoint as default failsafe if called in unknown modes
-			return path_endpoint(start_point, end_point, cur_point, status);
+			return path_endpoint(&segment, cur_point, status);
 			break;
 	}
 }
 
+/**
+ * @brief Work out the parts of a path that stay the same along it
+ * @param[in] pathDesired The path
+ * @param[out] seg Where to keep them
+ */
+static void path_segment_build(const PathDesiredData *pathDesired,
+                               struct path_segment *seg)
+{
+	const float *start_point = seg->start;
+	const float *end_point = seg->end;
+
+	seg->valid = true;
+	seg->mode = pathDesired->Mode;
+	seg->start[0] = pathDesired->Start[0];
+	seg->start[1] = pathDesired->Start[1];
+	seg->end[0] = pathDesired->End[0];
+	seg->end[1] = pathDesired->End[1];
+	seg->mode_parameters = pathDesired->ModeParameters;
+
+	float path_north = end_point[0] - start_point[0];
+	float path_east = end_point[1] - start_point[1];
+
+	seg->length = sqrtf(path_north * path_north + path_east * path_east);
+
+	if (seg->length < 1e-6f) {
+		seg->direction[0] = seg->direction[1] = 0;
+	} else {
+		seg->direction[0] = path_north / seg->length;
+		seg->direction[1] = path_east / seg->length;
+	}
+
+	seg->normal[0] = -seg->direction[1];
+	seg->normal[1] = seg->direction[0];
+
+	seg->center[0] = end_point[0];
+	seg->center[1] = end_point[1];
+	seg->radius = pathDesired->ModeParameters;
+	seg->curvature = 0;
+
+	switch (seg->mode) {
+	case PATHDESIRED_MODE_CIRCLEPOSITIONLEFT:
+	case PATHDESIRED_MODE_CIRCLEPOSITIONRIGHT:
+		if (seg->radius < 0.10f) {
+			seg->radius = 0.10f;	// Never try a circle less than 10cm
+		}
+		break;
+	case PATHDESIRED_MODE_CIRCLELEFT:
+	case PATHDESIRED_MODE_CIRCLERIGHT:
+	{
+		bool clockwise = seg->mode == PATHDESIRED_MODE_CIRCLERIGHT;
+		float radius = pathDesired->ModeParameters;
+
+		// OK for up to 10km
+		float min_radius = seg->length / 2.0f + 0.01f;
+
+		if (fabsf(radius) < min_radius) {
+			// This was possibly floating point confusion.
+			// Add 5cm and .5% and call it good.
+			if (radius >= 0) {
+				radius += 0.05f;
+			} else {
+				radius -= 0.05f;
+			}
+
+			radius *= 1.005f;
+
+			if (fabsf(radius) < min_radius) {
+				// Whoops! Radius was not close.  Convert to (nearly)
+				// straight line.
+				radius = min_radius * 1000;
+			}
+		}
+
+		// Compute the center of the circle connecting the two points as the intersection of two circles
+		// around the two points from
+		// http://www.mathworks.com/matlabcentral/newsreader/view_thread/255121
+		float m_n, m_e, p_n, p_e, d;
+
+		// Center between start and end
+		m_n = (start_point[0] + end_point[0]) / 2;
+		m_e = (start_point[1] + end_point[1]) / 2;
+
+		// Normal vector the line between start and end.
+		if (clockwise) {
+			p_n = -(end_point[1] - start_point[1]);
+			p_e = (end_point[0] - start_point[0]);
+		} else {
+			p_n = (end_point[1] - start_point[1]);
+			p_e = -(end_point[0] - start_point[0]);
+		}
+
+		// Work out how far to go along the perpendicular bisector
+		d = sqrtf(radius * radius / (p_n * p_n + p_e * p_e) - 0.25f);
+
+		float radius_sign = (radius > 0) ? 1 : -1;
+
+		if (fabsf(p_n) < 1e-3f && fabsf(p_e) < 1e-3f) {
+			seg->center[0] = m_n;
+			seg->center[1] = m_e;
+		} else {
+			seg->center[0] = m_n + p_n * d * radius_sign;
+			seg->center[1] = m_e + p_e * d * radius_sign;
+		}
+
+		seg->radius = fabsf(radius);
+		seg->curvature = 1 / seg->radius;
+		break;
+	}
+	default:
+		break;
+	}
+}
+
 /**
  * @brief Compute progress towards endpoint. Deviation equals distance
- * @param[in] start_point Starting point
- * @param[in] end_point Ending point
+ * @param[in] seg The path
  * @param[in] cur_point Current location
  * @param[out] status Structure containing progress along path and deviation
  */
-static void path_endpoint(const float *start_point,
-                          const float *end_point,
+static void path_endpoint(const struct path_segment *seg,
                           const float *cur_point,
                           struct path_status *status)
 {
-	float path_north, path_east, diff_north, diff_east;
-	float dist_path, dist_diff;
+	float diff_north, diff_east;
+	float dist_diff;
 
 	// we do not correct in this mode
 	status->correction_direction[0] = status->correction_direction[1] = 0;
 
-	// Distance to go
-	path_north = end_point[0] - start_point[0];
-	path_east = end_point[1] - start_point[1];
-
 	// Current progress location relative to end
-	diff_north = end_point[0] - cur_point[0];
-	diff_east = end_point[1] - cur_point[1];
+	diff_north = seg->end[0] - cur_point[0];
+	diff_east = seg->end[1] - cur_point[1];
 
 	dist_diff = sqrtf( diff_north * diff_north + diff_east * diff_east );
-	dist_path = sqrtf( path_north * path_north + path_east * path_east );
+
+	status->distance_remaining = dist_diff;
 
 	if(dist_diff < 1e-6f ) {
 		status->fractional_progress = 1;
@@ -128,7 +271,7 @@ static void path_endpoint(const float *start_point,
 		return;
 	}
 
-	status->fractional_progress = 1 - dist_diff / (1 + dist_path);
+	status->fractional_progress = 1 - dist_diff / (1 + seg->length);
 	status->error = dist_diff;
 
 	// Compute direction to travel
@@ -138,70 +281,56 @@ static void path_endpoint(const float *start_point,
 
 /**
  * @brief Compute progress along path and deviation from it
- * @param[in] start_point Starting point
- * @param[in] end_point Ending point
+ * @param[in] seg The path
  * @param[in] cur_point Current location
  * @param[out] status Structure containing progress along path and deviation
  */
-static void path_vector(const float *start_point,
-                        const float *end_point,
+static void path_vector(const struct path_segment *seg,
                         const float *cur_point,
                         struct path_status *status)
 {
-	float path_north, path_east, diff_north, diff_east;
-	float dist_path;
-	float dot;
-	float normal[2];
-
-	// Distance to go
-	path_north = end_point[0] - start_point[0];
-	path_east = end_point[1] - start_point[1];
-
-	// Current progress location relative to start
-	diff_north = cur_point[0] - start_point[0];
-	diff_east = cur_point[1] - start_point[1];
-
-	dot = path_north * diff_north + path_east * diff_east;
-	dist_path = sqrtf( path_north * path_north + path_east * path_east );
+	float diff_north, diff_east;
+	float along;
 
-	if(dist_path < 1e-6f) {
+	if(seg->length < 1e-6f) {
 		// if the path is too short, we cannot determine vector direction.
 		// Fly towards the endpoint to prevent flying away,
 		// but assume progress=1 either way.
-		path_endpoint( start_point, end_point, cur_point, status );
+		path_endpoint( seg, cur_point, status );
 		status->fractional_progress = 1;
 		return;
 	}
 
-	// Compute the normal to the path
-	normal[0] = -path_east / dist_path;
-	normal[1] = path_north / dist_path;
+	// Current progress location relative to start
+	diff_north = cur_point[0] - seg->start[0];
+	diff_east = cur_point[1] - seg->start[1];
 
-	status->fractional_progress = dot / (dist_path * dist_path);
-	status->error = normal[0] * diff_north + normal[1] * diff_east;
+	along = seg->direction[0] * diff_north + seg->direction[1] * diff_east;
+
+	status->fractional_progress = along / seg->length;
+	status->distance_remaining = seg->length - along;
+	status->error = seg->normal[0] * diff_north + seg->normal[1] * diff_east;
 
 	// Compute direction to correct error
-	status->correction_direction[0] = (status->error > 0) ? -normal[0] : normal[0];
-	status->correction_direction[1] = (status->error > 0) ? -normal[1] : normal[1];
+	status->correction_direction[0] = (status->error > 0) ? -seg->normal[0] : seg->normal[0];
+	status->correction_direction[1] = (status->error > 0) ? -seg->normal[1] : seg->normal[1];
 	
 	// Now just want magnitude of error
 	status->error = fabsf(status->error);
 
 	// Compute direction to travel
-	status->path_direction[0] = path_north / dist_path;
-	status->path_direction[1] = path_east / dist_path;
+	status->path_direction[0] = seg->direction[0];
+	status->path_direction[1] = seg->direction[1];
 
 }
 
 /**
  * @brief Circle location continuously
- * @param[in] start_point Starting point
- * @param[in] end_point Center point
+ * @param[in] seg The path, circling its end point
  * @param[in] cur_point Current location
  * @param[out] status Structure containing progress along path and deviation
  */
-static void path_circle(const float * center_point,
-                        float radius,
+static void path_circle(const struct path_segment *seg,
                         const float * cur_point,
                         struct path_status * status,
                         bool clockwise)
@@ -210,20 +339,19 @@ static void path_circle(const float * center_point,
 	float cradius;
 	float normal[2];
 
-	if (radius < 0.10f) {
-		radius = 0.10f;		// Never try a circle less than 10cm
-	}
-
 	// Current location relative to center
-	diff_north = cur_point[0] - center_point[0];
-	diff_east = cur_point[1] - center_point[1];
+	diff_north = cur_point[0] - seg->center[0];
+	diff_east = cur_point[1] - seg->center[1];
 
 	cradius = sqrtf(  diff_north * diff_north   +   diff_east * diff_east );
 
+	// Circling never ends
+	status->distance_remaining = INFINITY;
+
 	if (cradius < 1e-6f) {
 		// cradius is zero, just fly somewhere and make sure correction is still a normal
 		status->fractional_progress = 1;
-		status->error = radius;
+		status->error = seg->radius;
 		status->correction_direction[0] = 0;
 		status->correction_direction[1] = 1;
 		status->path_direction[0] = 1;
@@ -244,7 +372,7 @@ static void path_circle(const float * center_point,
 	status->fractional_progress = 0;
 
 	// error is current radius minus wanted radius - positive if too close
-	status->error = radius - cradius;
+	status->error = seg->radius - cradius;
 
 	// Compute direction to correct error
 	status->correction_direction[0] = (status->error>0?1:-1) * diff_north / cradius;
@@ -259,93 +387,35 @@ static void path_circle(const float * center_point,
 
 /**
  * @brief Compute progress along circular path and deviation from it
- * @param[in] start_point Starting point
- * @param[in] end_point Ending point
- * @param[in] radius Radius of the curve segment
+ * @param[in] seg The path, with the centre of its arc
  * @param[in] cur_point Current location
  * @param[out] status Structure containing progress along path and deviation
  */
-static void path_curve(const float * start_point,
-                       const float * end_point,
-                       float radius,
+static void path_curve(const struct path_segment *seg,
                        const float * cur_point,
                        struct path_status *status,
                        bool clockwise)
 {
-	// OK for up to 10km
-	float min_radius = sqrtf(powf(start_point[0] - end_point[0], 2) +
-		powf(start_point[1] - end_point[1], 2)) / 2.0f + 0.01f;
-
-	if (fabsf(radius) < min_radius) {
-		// This was possibly floating point confusion.
-		// Add 5cm and .5% and call it good.
-		if (radius >= 0) {
-			radius += 0.05f;
-		} else {
-			radius -= 0.05f;
-		}
-
-		radius *= 1.005f;
-
-		if (fabsf(radius) < min_radius) {
-			// Whoops! Radius was not close.  Convert to (nearly)
-			// straight line.
-			radius = min_radius * 1000;
-		}
-	}
-
 	float diff_north, diff_east;
-	float path_north, path_east;
 	float cradius;
 	float normal[2];
 
-	// Compute the center of the circle connecting the two points as the intersection of two circles
-	// around the two points from
-	// http://www.mathworks.com/matlabcentral/newsreader/view_thread/255121
-	float m_n, m_e, p_n, p_e, d, center[2];
-
-	// Center between start and end
-	m_n = (start_point[0] + end_point[0]) / 2;
-	m_e = (start_point[1] + end_point[1]) / 2;
-
-	// Normal vector the line between start and end.
-	if (clockwise) {
-		p_n = -(end_point[1] - start_point[1]);
-		p_e = (end_point[0] - start_point[0]);
-	} else {
-		p_n = (end_point[1] - start_point[1]);
-		p_e = -(end_point[0] - start_point[0]);		
-	}
-
-	// Work out how far to go along the perpendicular bisector
-	d = sqrtf(radius * radius / (p_n * p_n + p_e * p_e) - 0.25f);
-
-	float radius_sign = (radius > 0) ? 1 : -1;
-	float m_radius = fabsf(radius);
-
-	if (fabsf(p_n) < 1e-3f && fabsf(p_e) < 1e-3f) {
-		center[0] = m_n;
-		center[1] = m_e;
-	} else {
-		center[0] = m_n + p_n * d * radius_sign;
-		center[1] = m_e + p_e * d * radius_sign;
-	}
-
 	// Current location relative to center
-	diff_north = cur_point[0] - center[0];
-	diff_east = cur_point[1] - center[1];
+	diff_north = cur_point[0] - seg->center[0];
+	diff_east = cur_point[1] - seg->center[1];
 
 	// Compute current radius from the center
 	cradius = sqrtf(  diff_north * diff_north   +   diff_east * diff_east );
 
 	// Compute error in terms of meters from the curve (the distance projected
 	// normal onto the path i.e. cross-track distance)
-	status->error = m_radius - cradius;
+	status->error = seg->radius - cradius;
 
 	if (cradius < 1e-6f) {
 		// cradius is zero, just fly somewhere and make sure correction is still a normal
 		status->fractional_progress = 1;
-		status->error = m_radius;
+		status->distance_remaining = 0;
+		status->error = seg->radius;
 		status->correction_direction[0] = 0;
 		status->correction_direction[1] = 1;
 		status->path_direction[0] = 1;
@@ -371,14 +441,14 @@ static void path_curve(const float * start_point,
 	status->path_direction[0] = normal[0];
 	status->path_direction[1] = normal[1];
 
-	path_north = end_point[0] - start_point[0];
-	path_east = end_point[1] - start_point[1];
-	diff_north = cur_point[0] - start_point[0];
-	diff_east = cur_point[1] - start_point[1];
-	float dist_path = sqrtf( path_north * path_north + path_east * path_east );
-	float dot = path_north * diff_north + path_east * diff_east;
+	diff_north = cur_point[0] - seg->start[0];
+	diff_east = cur_point[1] - seg->start[1];
+	float along = seg->direction[0] * diff_north + seg->direction[1] * diff_east;
+
+	status->fractional_progress = along / seg->length;
 
-	status->fractional_progress = dot / (dist_path * dist_path);
+	// Measured along the chord, which is close enough to slow down with
+	status->distance_remaining = seg->length - along;
 
 	status->error = fabsf(status->error);
 }
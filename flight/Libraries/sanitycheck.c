@@ -62,6 +62,45 @@ static int32_t check_stabilization_rates();
 //! Check the system is safe for autonomous flight
 static int32_t check_safe_autonomous();
 
+//! Check every flight mode position the switch can select
+static int32_t check_flight_modes();
+
+/* The checks are cached, and each is only run again once something it
+ * reads has changed.  Every settings object a check reads is listed below,
+ * and updates to it mark the check stale.  The checks also look at things
+ * no object announces, like which tasks are running and which sensors are
+ * there, which is what configuration_check_refresh() is for. */
+enum {
+	CHECK_FLIGHT_MODES = 1 << 0,
+	CHECK_RATES        = 1 << 1,
+	CHECK_SAFE_TO_ARM  = 1 << 2,
+	CHECK_ALL          = CHECK_FLIGHT_MODES | CHECK_RATES | CHECK_SAFE_TO_ARM,
+};
+
+//! Checks that also read state no object tells us about
+#define CHECK_UNTRACKED (CHECK_FLIGHT_MODES | CHECK_RATES)
+
+struct check_input {
+	UAVObjHandle (*handle)();
+	uint32_t checks;
+};
+
+static const struct check_input check_inputs[] = {
+	{ ManualControlSettingsHandle, CHECK_FLIGHT_MODES },
+	{ SystemSettingsHandle, CHECK_FLIGHT_MODES },
+	{ StateEstimationHandle, CHECK_FLIGHT_MODES },
+	{ SystemIdentHandle, CHECK_FLIGHT_MODES | CHECK_SAFE_TO_ARM },
+	{ StabilizationSettingsHandle, CHECK_RATES },
+	{ FlightStatusHandle, CHECK_SAFE_TO_ARM },
+};
+
+static volatile uint32_t stale_checks = CHECK_ALL;
+static uint32_t inputs_connected;
+
+static int32_t flight_modes_result;
+static int32_t rates_result;
+static int32_t safe_to_arm_result;
+
 bool lqg_sysident_check()
 {
 	if (SystemIdentHandle()) {
@@ -77,9 +116,56 @@ bool lqg_sysident_check()
 	return true;
 }
 
+static void check_input_updated(const UAVObjEvent *ev, void *ctx,
+		void *obj, int len)
+{
+	(void) ev; (void) obj; (void) len;
+
+	__sync_fetch_and_or(&stale_checks, (uint32_t) (uintptr_t) ctx);
+}
+
+/**
+ * Subscribes to the inputs of the checks.  Objects that don't exist yet are
+ * tried again next time; until they appear, nothing can change them.
+ */
+static void connect_check_inputs()
+{
+	for (uint32_t i = 0; i < NELEMENTS(check_inputs); i++) {
+		if (inputs_connected & (1 << i)) {
+			continue;
+		}
+
+		UAVObjHandle obj = check_inputs[i].handle();
+
+		if (!obj) {
+			continue;
+		}
+
+		UAVObjConnectCallback(obj, check_input_updated,
+				(void *) (uintptr_t) check_inputs[i].checks,
+				EV_MASK_ALL_UPDATES);
+
+		inputs_connected |= 1 << i;
+
+		// Anything it changed before now was missed
+		__sync_fetch_and_or(&stale_checks, check_inputs[i].checks);
+	}
+}
+
+/**
+ * Marks stale the checks that depend on state with no object to watch,
+ * such as which tasks are running, so the next configuration_check() looks
+ * at them again.
+ */
+void configuration_check_refresh()
+{
+	__sync_fetch_and_or(&stale_checks, CHECK_UNTRACKED);
+}
+
 /**
  * Run a preflight check over the hardware configuration
- * and currently active modules
+ * and currently active modules.  Only the checks whose inputs have changed
+ * since last time are run; the rest use their last result.
  */
 int32_t configuration_check()
 {
@@ -93,6 +179,43 @@ int32_t configuration_check()
 		return 0;
 	}
 
+	connect_check_inputs();
+
+	uint32_t stale = __sync_fetch_and_and(&stale_checks, 0);
+
+	if (stale & CHECK_FLIGHT_MODES) {
+		flight_modes_result = check_flight_modes();
+	}
+
+	if (stale & CHECK_RATES) {
+		rates_result = check_stabilization_rates();
+	}
+
+	if (stale & CHECK_SAFE_TO_ARM) {
+		safe_to_arm_result = check_safe_to_arm();
+	}
+
+	error_code = flight_modes_result;
+
+	// Check the stabilization rates are within what the sensors can track
+	error_code = (error_code == SYSTEMALARMS_CONFIGERROR_NONE) ? rates_result : error_code;
+
+	// Only check safe to arm if no other errors exist
+	error_code = (error_code == SYSTEMALARMS_CONFIGERROR_NONE) ? safe_to_arm_result : error_code;
+
+	set_config_error(error_code);
+
+	return 0;
+}
+
+/**
+ * For each available flight mode position sanity check the available
+ * modes
+ */
+static int32_t check_flight_modes()
+{
+	SystemAlarmsConfigErrorOptions error_code = SYSTEMALARMS_CONFIGERROR_NONE;
+
 	// Classify airframe type
 	bool multirotor = true;
 	uint8_t airframe_type;
@@ -113,8 +236,6 @@ int32_t configuration_check()
 			multirotor = false;
 	}
 
-	// For each available flight mode position sanity check the available
-	// modes
 	uint8_t num_modes;
 	uint8_t modes[MANUALCONTROLSETTINGS_FLIGHTMODEPOSITION_NUMELEM];
 	ManualControlSettingsFlightModeNumberGet(&num_modes);
@@ -186,15 +307,7 @@ int32_t configuration_check()
 		}
 	}
 
-	// Check the stabilization rates are within what the sensors can track
-	error_code = (error_code == SYSTEMALARMS_CONFIGERROR_NONE) ? check_stabilization_rates() : error_code;
-
-	// Only check safe to arm if no other errors exist
-	error_code = (error_code == SYSTEMALARMS_CONFIGERROR_NONE) ? check_safe_to_arm() : error_code;
-
-	set_config_error(error_code);
-
-	return 0;
+	return error_code;
 }
 
 
@@ -347,6 +460,7 @@ static int32_t check_safe_autonomous()
 	//    Anything  |     None         (unsafe)
 	//   INSOutdoor |     INS
 	//   INSIndoor  |     INS          (unsafe)
+	//     Comp     |     Flow         (indoors, over texture)
 
 	StateEstimationData stateEstimation;
 	StateEstimationGet(&stateEstimation);
@@ -354,6 +468,12 @@ static int32_t check_safe_autonomous()
 	if (stateEstimation.AttitudeFilter == STATEESTIMATION_ATTITUDEFILTER_INSINDOOR)
 		return SYSTEMALARMS_CONFIGERROR_NAVFILTER;
 
+	// Flow navigation runs off the complementary filter's attitude
+	if (stateEstimation.NavigationFilter == STATEESTIMATION_NAVIGATIONFILTER_FLOW)
+		return (stateEstimation.AttitudeFilter == STATEESTIMATION_ATTITUDEFILTER_COMPLEMENTARY ||
+			stateEstimation.AttitudeFilter == STATEESTIMATION_ATTITUDEFILTER_COMPLEMENTARYVELCOMPASS) ?
+			SYSTEMALARMS_CONFIGERROR_NONE : SYSTEMALARMS_CONFIGERROR_NAVFILTER;
+
 	// Anything not allowed is invalid, safe default
 	if (stateEstimation.NavigationFilter != STATEESTIMATION_NAVIGATIONFILTER_INS &&
 		stateEstimation.NavigationFilter != STATEESTIMATION_NAVIGATIONFILTER_RAW)
@@ -0,0 +1,171 @@
+/**
+ ******************************************************************************
+ * @addtogroup Libraries Libraries
+ * @{
+ *
+ * @file       telemetry_snapshot.c
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2017
+ * @brief      Shared snapshot of the values reported by telemetry bridges
+ *
+ * Several bridges can run at once (e.g. Crossfire to the radio and LTM to
+ * an OSD), and they all want the same handful of values.  Rather than each
+ * one copying the same UAVObjects on its own schedule, they ask for a
+ * snapshot no older than they can tolerate; whoever asks first after it
+ * goes stale refreshes it for everyone.
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "openpilot.h"
+#include "pios_mutex.h"
+#include "pios_thread.h"
+
+#include "telemetry_snapshot.h"
+
+#include "airspeedactual.h"
+#include "attitudeactual.h"
+#include "baroaltitude.h"
+#include "flightbatterysettings.h"
+#include "flightbatterystate.h"
+#include "flightstatus.h"
+#include "gpsposition.h"
+#include "manualcontrolcommand.h"
+#include "positionactual.h"
+
+static struct pios_mutex *snapshot_lock;
+static struct telemetry_snapshot snapshot;
+static bool snapshot_valid;
+
+/**
+ * Sets up the snapshot.  Bridges call this from their initialize functions;
+ * calling it more than once is harmless.
+ * \return 0 on success, -1 if the lock couldn't be created
+ */
+int32_t telemetry_snapshot_init(void)
+{
+	if (snapshot_lock)
+		return 0;
+
+	snapshot_lock = PIOS_Mutex_Create();
+
+	return snapshot_lock ? 0 : -1;
+}
+
+static void snapshot_refresh(struct telemetry_snapshot *s)
+{
+	memset(s, 0, sizeof(*s));
+
+	s->taken_ms = PIOS_Thread_Systime();
+
+	if (AttitudeActualHandle()) {
+		AttitudeActualData att;
+		AttitudeActualGet(&att);
+
+		s->have_attitude = true;
+		s->roll = att.Roll;
+		s->pitch = att.Pitch;
+		s->yaw = att.Yaw;
+	}
+
+	if (FlightBatteryStateHandle()) {
+		FlightBatteryStateData bat;
+		FlightBatteryStateGet(&bat);
+
+		s->have_battery = true;
+		s->voltage = bat.Voltage;
+		s->current = bat.Current;
+		s->consumed_energy = bat.ConsumedEnergy;
+
+		if (FlightBatterySettingsHandle())
+			FlightBatterySettingsCapacityGet(&s->capacity);
+	}
+
+	if (GPSPositionHandle()) {
+		GPSPositionData gps;
+		GPSPositionGet(&gps);
+
+		s->have_gps = true;
+		s->gps_status = gps.Status;
+		s->satellites = gps.Satellites;
+		s->latitude = gps.Latitude;
+		s->longitude = gps.Longitude;
+		s->gps_altitude = gps.Altitude;
+		s->groundspeed = gps.Groundspeed;
+		s->heading = gps.Heading;
+	}
+
+	if (PositionActualHandle()) {
+		float down;
+		PositionActualDownGet(&down);
+
+		s->have_altitude = true;
+		s->altitude = -down;
+	} else if (BaroAltitudeHandle()) {
+		s->have_altitude = true;
+		BaroAltitudeAltitudeGet(&s->altitude);
+	} else if (s->have_gps) {
+		s->have_altitude = true;
+		s->altitude = s->gps_altitude;
+	}
+
+	if (AirspeedActualHandle()) {
+		s->have_airspeed = true;
+		AirspeedActualTrueAirspeedGet(&s->airspeed);
+	}
+
+	if (ManualControlCommandHandle()) {
+		int16_t rssi;
+		ManualControlCommandRssiGet(&rssi);
+
+		s->rssi = rssi;
+	}
+
+	FlightStatusData status;
+	FlightStatusGet(&status);
+
+	s->armed = status.Armed;
+	s->flight_mode = status.FlightMode;
+	s->control_source = status.ControlSource;
+}
+
+/**
+ * Copies out the current snapshot, first refreshing it from the UAVObjects
+ * if it is older than the caller can use.
+ * \param[out] snap where to put the values
+ * \param[in] max_age_ms how stale the values may be; 0 always refreshes
+ */
+void telemetry_snapshot_get(struct telemetry_snapshot *snap, uint32_t max_age_ms)
+{
+	PIOS_Assert(snapshot_lock);
+
+	PIOS_Mutex_Lock(snapshot_lock, PIOS_MUTEX_TIMEOUT_MAX);
+
+	if (!snapshot_valid ||
+			(PIOS_Thread_Systime() - snapshot.taken_ms) >= max_age_ms) {
+		snapshot_refresh(&snapshot);
+		snapshot_valid = true;
+	}
+
+	*snap = snapshot;
+
+	PIOS_Mutex_Unlock(snapshot_lock);
+}
+
+/**
+ * @}
+ */
@@ -0,0 +1,272 @@
+/**
+ ******************************************************************************
+ * @addtogroup Libraries Libraries
+ * @{
+ *
+ * @file       timerwheel.c
+ * @author     dRonin, http://dronin.org Copyright (C) 2017
+ * @brief      Hierarchical timer wheel
+ *
+ * Timers are kept in slots by when they expire: the first level has a slot
+ * per tick for the next TIMER_WHEEL_SLOTS ticks, each further level a slot
+ * per whole turn of the level below.  When a level comes round, the timers
+ * in its next slot are spread over the levels below.  Adding, removing and
+ * moving on a tick take the same time however many timers there are.
+ *
+ * Nothing here locks; the user does.
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "timerwheel.h"
+
+#include <string.h>
+
+// Private constants
+#define SLOT_MASK	(TIMER_WHEEL_SLOTS - 1)
+
+#define LEVEL_SHIFT(level) ((level) * TIMER_WHEEL_BITS)
+
+static uint16_t total_count(const struct timer_wheel *wheel)
+{
+	uint16_t total = 0;
+
+	for (int level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+		total += wheel->count[level];
+	}
+
+	return total;
+}
+
+static void slot_insert(struct timer_wheel_entry **slot,
+		struct timer_wheel_entry *entry)
+{
+	entry->next = *slot;
+	if (entry->next) {
+		entry->next->pprev = &entry->next;
+	}
+
+	entry->pprev = slot;
+	*slot = entry;
+}
+
+/**
+ * @brief Puts a timer in the slot for when it expires, seen from the
+ * wheel's current tick
+ */
+static void place(struct timer_wheel *wheel, struct timer_wheel_entry *entry)
+{
+	uint32_t delta = entry->expires - wheel->now;
+
+	// Late timers expire on the next tick
+	if ((int32_t) delta < 0) {
+		entry->expires = wheel->now;
+		delta = 0;
+	} else if (delta > TIMER_WHEEL_MAX_DELAY) {
+		entry->expires = wheel->now + TIMER_WHEEL_MAX_DELAY;
+		delta = TIMER_WHEEL_MAX_DELAY;
+	}
+
+	int level = 0;
+
+	while (delta >> LEVEL_SHIFT(level + 1)) {
+		level++;
+	}
+
+	uint32_t idx = (entry->expires >> LEVEL_SHIFT(level)) & SLOT_MASK;
+
+	slot_insert(&wheel->slots[level][idx], entry);
+	entry->level = level;
+	wheel->count[level]++;
+}
+
+/**
+ * @brief Spreads a slot of a higher level over the ones below
+ */
+static void cascade(struct timer_wheel *wheel, int level)
+{
+	uint32_t idx = (wheel->now >> LEVEL_SHIFT(level)) & SLOT_MASK;
+	struct timer_wheel_entry *entry = wheel->slots[level][idx];
+
+	wheel->slots[level][idx] = NULL;
+
+	while (entry) {
+		struct timer_wheel_entry *next = entry->next;
+
+		wheel->count[level]--;
+		place(wheel, entry);
+
+		entry = next;
+	}
+}
+
+/**
+ * @brief Empties a wheel, starting it at a tick
+ * @param[in] wheel The wheel
+ * @param[in] now The first tick timers may expire on
+ */
+void timer_wheel_init(struct timer_wheel *wheel, uint32_t now)
+{
+	memset(wheel, 0, sizeof(*wheel));
+
+	wheel->now = now;
+}
+
+/**
+ * @brief Adds a timer to a wheel
+ * @param[in] wheel The wheel
+ * @param[in] entry The timer, which must not be in a wheel already
+ * @param[in] expires The tick it expires on.  Ticks that passed already
+ * mean the next one, and ones further out than TIMER_WHEEL_MAX_DELAY that
+ * far out; expires is changed to match.
+ */
+void timer_wheel_add(struct timer_wheel *wheel,
+		struct timer_wheel_entry *entry, uint32_t expires)
+{
+	entry->expires = expires;
+
+	place(wheel, entry);
+}
+
+/**
+ * @brief Takes a timer out of a wheel, if it is in one
+ * @param[in] wheel The wheel
+ * @param[in] entry The timer
+ */
+void timer_wheel_remove(struct timer_wheel *wheel,
+		struct timer_wheel_entry *entry)
+{
+	if (!entry->pprev) {
+		return;
+	}
+
+	wheel->count[entry->level]--;
+
+	*entry->pprev = entry->next;
+	if (entry->next) {
+		entry->next->pprev = entry->pprev;
+	}
+
+	entry->next = NULL;
+	entry->pprev = NULL;
+}
+
+/**
+ * @brief Moves a wheel on to a tick, taking out the timers that expired
+ * @param[in] wheel The wheel
+ * @param[in] now The tick reached; timers expiring on it are included
+ * @returns The expired timers, earliest first, linked through next; they
+ * are no longer in the wheel and may be added again straight away
+ */
+struct timer_wheel_entry *timer_wheel_expire(struct timer_wheel *wheel,
+		uint32_t now)
+{
+	struct timer_wheel_entry *expired = NULL;
+	struct timer_wheel_entry **tail = &expired;
+
+	while ((int32_t) (now - wheel->now) >= 0) {
+		// Nothing to expire or spread; skip straight to the end
+		if (!total_count(wheel)) {
+			wheel->now = now + 1;
+			break;
+		}
+
+		// Highest level first, so that what a level spreads into the
+		// one below gets spread further if that comes round too
+		for (int level = TIMER_WHEEL_LEVELS - 1; level > 0; level--) {
+			if (!(wheel->now & ((1 << LEVEL_SHIFT(level)) - 1))) {
+				cascade(wheel, level);
+			}
+		}
+
+		uint32_t idx = wheel->now & SLOT_MASK;
+		struct timer_wheel_entry *entry = wheel->slots[0][idx];
+
+		wheel->slots[0][idx] = NULL;
+
+		while (entry) {
+			wheel->count[0]--;
+
+			entry->pprev = NULL;
+			*tail = entry;
+			tail = &entry->next;
+
+			entry = entry->next;
+		}
+
+		wheel->now++;
+	}
+
+	return expired;
+}
+
+/**
+ * @brief How long after the last tick expired the wheel next has to be
+ * moved on; either a timer expires then, or a level comes round with
+ * timers to spread
+ * @param[in] wheel The wheel
+ * @param[in] max The most to return, when nothing is due sooner
+ * @returns A number of ticks, at least 1
+ */
+uint32_t timer_wheel_next(const struct timer_wheel *wheel, uint32_t max)
+{
+	uint32_t next = max;
+
+	if (wheel->count[0]) {
+		for (uint32_t i = 0; i < TIMER_WHEEL_SLOTS; i++) {
+			if (wheel->slots[0][(wheel->now + i) & SLOT_MASK]) {
+				if (i + 1 < next) {
+					next = i + 1;
+				}
+
+				break;
+			}
+		}
+	}
+
+	for (int level = 1; level < TIMER_WHEEL_LEVELS; level++) {
+		if (!wheel->count[level]) {
+			continue;
+		}
+
+		uint32_t turn = wheel->now >> LEVEL_SHIFT(level);
+
+		// On a turn, that turn's slot is spread on the next tick
+		uint32_t first =
+			(wheel->now & ((1 << LEVEL_SHIFT(level)) - 1)) ? 1 : 0;
+
+		for (uint32_t i = first; i < first + TIMER_WHEEL_SLOTS; i++) {
+			if (wheel->slots[level][(turn + i) & SLOT_MASK]) {
+				uint32_t at = (turn + i) << LEVEL_SHIFT(level);
+				uint32_t ticks = at - wheel->now + 1;
+
+				if (ticks < next) {
+					next = ticks;
+				}
+
+				break;
+			}
+		}
+	}
+
+	return next ? next : 1;
+}
+
+/**
+ * @}
+ */
@@ -44,8 +44,15 @@
 static int32_t objectTransaction(UAVTalkConnectionData *connection, UAVObjHandle objectId, uint16_t instId, uint8_t type);
 static int32_t sendObject(UAVTalkConnectionData *connection, UAVObjHandle obj, uint16_t instId, uint8_t type);
 static int32_t sendSingleObject(UAVTalkConnectionData *connection, UAVObjHandle obj, uint16_t instId, uint8_t type);
+static int32_t sendObjectFrame(UAVTalkConnectionData *connection, UAVObjHandle obj, uint16_t instId, uint8_t type, const uint8_t *data, uint32_t time);
 static int32_t receiveObject(UAVTalkConnectionData *connection);
-static int32_t sendNack(UAVTalkConnectionData *connection, uint32_t objId, uint16_t instId);
+static int32_t sendIdFrame(UAVTalkConnectionData *connection, uint8_t type,
+		uint32_t objId, uint16_t instId);
+static int32_t batchObject(UAVTalkConnectionData *connection, UAVObjHandle obj, uint16_t instId);
+static int32_t flushBatch(UAVTalkConnectionData *connection);
+static bool sendSecured(UAVTalkConnectionData *connection);
+static int32_t outputFrame(UAVTalkConnectionData *connection, uint8_t *buf, uint16_t length);
+static int32_t receiveSecure(UAVTalkConnectionData *connection);
 
 /**
  * Initialize the UAVTalk library
@@ -85,6 +92,109 @@ UAVTalkConnection UAVTalkInitialize(void *ctx, UAVTalkOutputCb outputStream,
 	return (UAVTalkConnection) connection;
 }
 
+/**
+ * Let single objects be built directly in the link's transmit buffer.
+ * The reserve callback returns space for a whole frame, or NULL to fall
+ * back to the output callback; every non-NULL reservation is followed by
+ * exactly one commit, with length 0 if nothing is to be sent.
+ * \param[in] connection UAVTalkConnection to be used
+ * \param[in] reserveCb Reserves the given number of bytes
+ * \param[in] commitCb Sends the given number of reserved bytes
+ */
+void UAVTalkSetInPlaceOutput(UAVTalkConnection connectionHandle,
+		UAVTalkReserveCb reserveCb, UAVTalkCommitCb commitCb)
+{
+	UAVTalkConnectionData *connection;
+	CHECKCONHANDLE(connectionHandle,connection,return);
+
+	PIOS_Recursive_Mutex_Lock(connection->lock, PIOS_MUTEX_TIMEOUT_MAX);
+	connection->reserveCb = reserveCb;
+	connection->commitCb = commitCb;
+	PIOS_Recursive_Mutex_Unlock(connection->lock);
+}
+
+/**
+ * Set the key for secured frames, which are then accepted from the other
+ * end, and answered in kind.  See UAVTalkRequireSecure to refuse anything
+ * else.
+ * \param[in] connection UAVTalkConnection to be used
+ * \param[in] key UAVTALK_KEY_LENGTH bytes of key, or NULL to stop securing
+ * \return 0 Success
+ * \return -1 Failure
+ */
+int32_t UAVTalkSetKey(UAVTalkConnection connectionHandle, const uint8_t *key)
+{
+	UAVTalkConnectionData *connection;
+	CHECKCONHANDLE(connectionHandle,connection,return -1);
+
+	PIOS_Recursive_Mutex_Lock(connection->lock, PIOS_MUTEX_TIMEOUT_MAX);
+
+	int32_t ret = 0;
+
+	if (!key) {
+		if (connection->secure) {
+			connection->secure->keyed = false;
+		}
+
+		goto unlock_exit;
+	}
+
+	if (!connection->secure) {
+		connection->secure = PIOS_malloc_no_dma(sizeof(*connection->secure));
+
+		if (!connection->secure) {
+			ret = -1;
+			goto unlock_exit;
+		}
+
+		memset(connection->secure, 0, sizeof(*connection->secure));
+	}
+
+	struct uavtalk_secure *secure = connection->secure;
+
+	/* One key for each job, each the shared key's encryption of a
+	 * constant block.  The encryption context holds the shared key
+	 * until both are made. */
+	uint8_t derived[AES128_BLOCK_SIZE] = { 2 };
+
+	aes128_setkey(&secure->enc, key);
+	aes128_encrypt(&secure->enc, derived, derived);
+	aes128_setkey(&secure->mac, derived);
+
+	memset(derived, 0, sizeof(derived));
+	derived[0] = 1;
+
+	aes128_encrypt(&secure->enc, derived, derived);
+	aes128_setkey(&secure->enc, derived);
+
+	memset(derived, 0, sizeof(derived));
+
+	secure->tx_seq = 0;
+	secure->rx_valid = false;
+	secure->peer_secured = false;
+	secure->keyed = true;
+
+unlock_exit:
+	PIOS_Recursive_Mutex_Unlock(connection->lock);
+	return ret;
+}
+
+/**
+ * Choose whether frames that aren't secured are refused, when there is a
+ * key.  Everything sent is then secured too.
+ * \param[in] connection UAVTalkConnection to be used
+ * \param[in] required true to accept only secured frames
+ */
+void UAVTalkRequireSecure(UAVTalkConnection connectionHandle, bool required)
+{
+	UAVTalkConnectionData *connection;
+	CHECKCONHANDLE(connectionHandle,connection,return);
+
+	if (connection->secure) {
+		connection->secure->required = required;
+	}
+}
+
 /**
  * Get communication statistics counters since last call (reset afterwards)
  * \param[in] connection UAVTalkConnection to be used
@@ -147,6 +257,81 @@ int32_t UAVTalkSendObjectTimestamped(UAVTalkConnection connectionHandle, UAVObjH
 	return objectTransaction(connection, obj, instId, UAVTALK_TYPE_OBJ_TS);
 }
 
+/**
+ * Send object data captured earlier as a timestamped object update.  The
+ * timestamp is when the data was captured, not when it goes out.
+ * \param[in] connection UAVTalkConnection to be used
+ * \param[in] obj Object the data belongs to
+ * \param[in] instId The instance ID
+ * \param[in] time When the data was captured, from PIOS_Thread_Systime()
+ * \param[in] data UAVObjGetNumBytes(obj) bytes of object data
+ * \return 0 Success
+ * \return -1 Failure
+ */
+int32_t UAVTalkSendObjectData(UAVTalkConnection connectionHandle, UAVObjHandle obj, uint16_t instId, uint32_t time, const void *data)
+{
+	UAVTalkConnectionData *connection;
+	CHECKCONHANDLE(connectionHandle,connection,return -1);
+
+	return sendObjectFrame(connection, obj, instId, UAVTALK_TYPE_OBJ_TS,
+			data, time);
+}
+
+/**
+ * Queue the specified object to be sent in a batched frame, together with
+ * other objects queued the same way.  The frame is sent when it is full or
+ * when UAVTalkFlushBatch is called.  Objects too large to share a frame
+ * are sent immediately, as by UAVTalkSendObject without ack.
+ * \param[in] connection UAVTalkConnection to be used
+ * \param[in] obj Object to send
+ * \param[in] instId The instance ID or UAVOBJ_ALL_INSTANCES for all instances.
+ * \return 0 Success
+ * \return -1 Failure
+ */
+int32_t UAVTalkSendObjectBatched(UAVTalkConnection connectionHandle, UAVObjHandle obj, uint16_t instId)
+{
+	UAVTalkConnectionData *connection;
+	CHECKCONHANDLE(connectionHandle,connection,return -1);
+
+	// If all instances are requested and this is a single instance object, force instance ID to zero
+	if (instId == UAVOBJ_ALL_INSTANCES && UAVObjIsSingleInstance(obj)) {
+		instId = 0;
+	}
+
+	if (instId == UAVOBJ_ALL_INSTANCES) {
+		uint32_t numInst = UAVObjGetNumInstances(obj);
+		int32_t ret = 0;
+
+		for (uint32_t n = 0; n < numInst; ++n) {
+			if (batchObject(connection, obj, n)) {
+				ret = -1;
+			}
+		}
+
+		return ret;
+	}
+
+	return batchObject(connection, obj, instId);
+}
+
+/**
+ * Send any objects queued by UAVTalkSendObjectBatched.
+ * \param[in] connection UAVTalkConnection to be used
+ * \return 0 Success
+ * \return -1 Failure
+ */
+int32_t UAVTalkFlushBatch(UAVTalkConnection connectionHandle)
+{
+	UAVTalkConnectionData *connection;
+	CHECKCONHANDLE(connectionHandle,connection,return -1);
+
+	PIOS_Recursive_Mutex_Lock(connection->lock, PIOS_MUTEX_TIMEOUT_MAX);
+	int32_t ret = flushBatch(connection);
+	PIOS_Recursive_Mutex_Unlock(connection->lock);
+
+	return ret;
+}
+
 /**
  * Execute the requested transaction on an object.
  * \param[in] connection UAVTalkConnection to be used
@@ -249,6 +434,44 @@ UAVTalkRxState UAVTalkProcessInputStreamQuiet(UAVTalkConnection connectionHandle
 
 		iproc->rxCount = 0;
 		iproc->objId = 0;
+
+		if (iproc->type == UAVTALK_TYPE_SECURE) {
+			/* No object ID either; the rest is checked and
+			 * unwrapped in receiveSecure.
+			 */
+			if (iproc->packet_size > UAVTALK_MAX_SECURE_LENGTH ||
+					iproc->packet_size <
+					UAVTALK_SECURE_HEADER_LENGTH +
+					UAVTALK_SECURE_NONCE_LENGTH +
+					UAVTALK_MIN_HEADER_LENGTH +
+					UAVTALK_CHECKSUM_LENGTH +
+					UAVTALK_SECURE_TAG_LENGTH) {
+				iproc->state = UAVTALK_STATE_ERROR;
+				break;
+			}
+
+			iproc->obj = NULL;
+			iproc->instId = 0;
+			iproc->instanceLength = 0;
+			iproc->length = iproc->packet_size -
+				UAVTALK_SECURE_HEADER_LENGTH;
+			iproc->state = UAVTALK_STATE_DATA;
+			break;
+		}
+
+		if (iproc->type == UAVTALK_TYPE_OBJ_BATCH) {
+			/* No object ID in the header; the rest of the
+			 * frame is records, unpacked in receiveBatch.
+			 */
+			iproc->obj = NULL;
+			iproc->instId = 0;
+			iproc->instanceLength = 0;
+			iproc->length = iproc->packet_size -
+				UAVTALK_BATCH_HEADER_LENGTH;
+			iproc->state = UAVTALK_STATE_DATA;
+			break;
+		}
+
 		iproc->state = UAVTALK_STATE_OBJID;
 		break;
 
@@ -302,6 +525,26 @@ UAVTalkRxState UAVTalkProcessInputStreamQuiet(UAVTalkConnection connectionHandle
 				iproc->state = UAVTALK_STATE_ERROR;
 				break; 
 			}
+		} else if (iproc->type == UAVTALK_TYPE_OBJ_FIELD ||
+				iproc->type == UAVTALK_TYPE_OBJ_FIELD_ACK) {
+			/* Variable length: offset plus however many bytes
+			 * of the object are being updated.
+			 */
+			if (iproc->obj) {
+				iproc->instanceLength = (UAVObjIsSingleInstance(iproc->obj) ? 0 : 2);
+			} else {
+				iproc->instanceLength = 0;
+			}
+
+			iproc->length = iproc->packet_size - iproc->rxPacketLength -
+				iproc->instanceLength;
+
+			if (iproc->packet_size < iproc->rxPacketLength +
+					iproc->instanceLength +
+					UAVTALK_FIELD_OFFSET_LENGTH + 1) {
+				iproc->state = UAVTALK_STATE_ERROR;
+				break;
+			}
 		} else {
 			if (iproc->obj) {
 				iproc->length = UAVObjGetNumBytes(iproc->obj);
@@ -415,22 +658,89 @@ UAVTalkRxState UAVTalkProcessInputStreamQuiet(UAVTalkConnection connectionHandle
 }
 
 /**
- * Process an byte from the telemetry stream.
+ * Consume a contiguous run of bytes in the states where the parser does
+ * not need to look at them one by one: skipping to the next sync byte,
+ * and receiving the payload.  Header fields are left to the byte-wise
+ * state machine.
  * \param[in] connection UAVTalkConnection to be used
- * \param[in] rxbyte Received byte
- * \return UAVTalkRxState
+ * \param[in] rxbytes Received bytes
+ * \param[in] numbytes Number of bytes available
+ * \return Number of bytes consumed, 0 if the next byte must go through
+ * UAVTalkProcessInputStreamQuiet
+ */
+static int processInputBlock(UAVTalkConnectionData *connection,
+		const uint8_t *rxbytes, int numbytes)
+{
+	UAVTalkInputProcessor *iproc = &connection->iproc;
+	int run;
+
+	switch (iproc->state) {
+	case UAVTALK_STATE_SYNC:
+		if (rxbytes[0] == UAVTALK_SYNC_VAL)
+			return 0;
+
+		const uint8_t *sync = memchr(rxbytes, UAVTALK_SYNC_VAL,
+				numbytes);
+
+		run = sync ? (sync - rxbytes) : numbytes;
+		connection->stats.rxBytes += run;
+
+		return run;
+
+	case UAVTALK_STATE_DATA:
+		run = iproc->length - iproc->rxCount;
+
+		if (run > numbytes)
+			run = numbytes;
+
+		if (run <= 0)
+			return 0;
+
+		memcpy(&connection->rxBuffer[iproc->rxCount], rxbytes, run);
+		iproc->cs = PIOS_CRC_updateCRC(iproc->cs, rxbytes, run);
+		iproc->rxCount += run;
+		iproc->rxPacketLength += run;
+		connection->stats.rxBytes += run;
+
+		if (iproc->rxCount >= iproc->length) {
+			iproc->state = UAVTALK_STATE_CS;
+			iproc->rxCount = 0;
+		}
+
+		return run;
+
+	default:
+		return 0;
+	}
+}
+
+/**
+ * Process a block of bytes from the telemetry stream.
+ * \param[in] connection UAVTalkConnection to be used
+ * \param[in] rxbytes Received bytes
+ * \param[in] numbytes Number of received bytes
  */
-void UAVTalkProcessInputStream(UAVTalkConnection connectionHandle, uint8_t *rxbytes,
+void UAVTalkProcessInputStream(UAVTalkConnection connectionHandle, const uint8_t *rxbytes,
 		int numbytes)
 {
 	UAVTalkConnectionData *connection;
 
 	CHECKCONHANDLE(connectionHandle,connection,return);
 
-	for (int i = 0; i < numbytes; i++) {
+	int i = 0;
+
+	while (i < numbytes) {
+		int run = processInputBlock(connection, &rxbytes[i],
+				numbytes - i);
+
+		if (run > 0) {
+			i += run;
+			continue;
+		}
+
 		UAVTalkRxState state =
 			UAVTalkProcessInputStreamQuiet(connectionHandle,
-					rxbytes[i]);
+					rxbytes[i++]);
 
 		if (state == UAVTALK_STATE_COMPLETE) {
 			receiveObject(connection);
@@ -441,7 +751,8 @@ void UAVTalkProcessInputStream(UAVTalkConnection connectionHandle, uint8_t *rxby
 /**
  * Send a parsed packet received on one connection handle out on a different connection handle.
  * The packet must be in a complete state, meaning it is completed parsing.
- * The packet is re-assembled from the component parts into a complete message and sent.
+ * The packet is re-assembled from the component parts into a complete message and sent,
+ * straight into the output link's buffer when it has in-place output set up.
  * This can be used to relay packets from one UAVTalk connection to another.
  * \param[in] connection UAVTalkConnection to be used
  * \param[in] rxbyte Received byte
@@ -472,45 +783,84 @@ int32_t UAVTalkRelayPacket(UAVTalkConnection inConnectionHandle, UAVTalkConnecti
 	// Lock
 	PIOS_Recursive_Mutex_Lock(outConnection->lock, PIOS_MUTEX_TIMEOUT_MAX);
 
-	outConnection->txBuffer[0] = UAVTALK_SYNC_VAL;
+	// Keep the relayed packet ordered after anything already batched
+	flushBatch(outConnection);
+
+	int32_t headerLength = UAVTALK_BATCH_HEADER_LENGTH;
+
+	if (inIproc->type != UAVTALK_TYPE_OBJ_BATCH &&
+			inIproc->type != UAVTALK_TYPE_SECURE) {
+		headerLength = 8;
+
+		if (inIproc->instanceLength) {
+			headerLength = 10;
+		}
+	}
+
+	uint16_t tx_msg_len = headerLength + inIproc->length +
+		UAVTALK_CHECKSUM_LENGTH;
+
+	// Rebuild the frame straight in the output link's buffer if it can
+	// take it, so the payload is only copied once
+	uint8_t *txBuffer = NULL;
+
+	if (outConnection->reserveCb) {
+		txBuffer = (*outConnection->reserveCb)(outConnection->cbCtx,
+				tx_msg_len);
+	}
+
+	bool in_place = txBuffer != NULL;
+
+	if (!in_place) {
+		txBuffer = outConnection->txBuffer;
+	}
+
+	txBuffer[0] = UAVTALK_SYNC_VAL;
 	// Setup type
-	outConnection->txBuffer[1] = inIproc->type;
-	// next 2 bytes are reserved for data length (inserted here later)
-	// Setup object ID
-	outConnection->txBuffer[4] = (uint8_t)(inIproc->objId & 0xFF);
-	outConnection->txBuffer[5] = (uint8_t)((inIproc->objId >> 8) & 0xFF);
-	outConnection->txBuffer[6] = (uint8_t)((inIproc->objId >> 16) & 0xFF);
-	outConnection->txBuffer[7] = (uint8_t)((inIproc->objId >> 24) & 0xFF);
-	int32_t headerLength = 8;
-
-	if (inIproc->instanceLength) {
+	txBuffer[1] = inIproc->type;
+
+	// Store the packet length
+	txBuffer[2] = (uint8_t)((headerLength + inIproc->length) & 0xFF);
+	txBuffer[3] = (uint8_t)(((headerLength + inIproc->length) >> 8) & 0xFF);
+
+	if (headerLength >= 8) {
+		// Setup object ID
+		txBuffer[4] = (uint8_t)(inIproc->objId & 0xFF);
+		txBuffer[5] = (uint8_t)((inIproc->objId >> 8) & 0xFF);
+		txBuffer[6] = (uint8_t)((inIproc->objId >> 16) & 0xFF);
+		txBuffer[7] = (uint8_t)((inIproc->objId >> 24) & 0xFF);
+	}
+
+	if (headerLength == 10) {
 		// Setup instance ID
-		outConnection->txBuffer[8] = (uint8_t)(inIproc->instId & 0xFF);
-		outConnection->txBuffer[9] = (uint8_t)((inIproc->instId >> 8) & 0xFF);
-		headerLength = 10;
+		txBuffer[8] = (uint8_t)(inIproc->instId & 0xFF);
+		txBuffer[9] = (uint8_t)((inIproc->instId >> 8) & 0xFF);
 	}
 
 	// Copy data (if any)
 	if (inIproc->length > 0) {
-		memcpy(&outConnection->txBuffer[headerLength], inConnection->rxBuffer, inIproc->length);
+		memcpy(&txBuffer[headerLength], inConnection->rxBuffer, inIproc->length);
 	}
 
-	// Store the packet length
-	outConnection->txBuffer[2] = (uint8_t)((headerLength + inIproc->length) & 0xFF);
-	outConnection->txBuffer[3] = (uint8_t)(((headerLength + inIproc->length) >> 8) & 0xFF);
-
-	// Copy the checksum
-	outConnection->txBuffer[headerLength + inIproc->length] = inIproc->cs;
+	// The frame is unchanged, so its checksum still holds
+	txBuffer[headerLength + inIproc->length] = inIproc->cs;
 
 	// Send the buffer.
-	int32_t rc = (*outConnection->outCb)(outConnection->cbCtx, outConnection->txBuffer, headerLength + inIproc->length + UAVTALK_CHECKSUM_LENGTH);
+	int32_t rc;
+
+	if (in_place) {
+		rc = (*outConnection->commitCb)(outConnection->cbCtx, tx_msg_len);
+	} else {
+		rc = (*outConnection->outCb)(outConnection->cbCtx, txBuffer,
+				tx_msg_len);
+	}
 
 	// Update stats
 	outConnection->stats.txBytes += (rc > 0) ? rc : 0;
 
 	// evaluate return value before releasing the lock
 	int32_t ret = 0;
-	if (rc != (int32_t)(headerLength + inIproc->length + UAVTALK_CHECKSUM_LENGTH)) {
+	if (rc != tx_msg_len) {
 		outConnection->stats.txErrors++;
 		ret = -1;
 	}
@@ -571,7 +921,65 @@ uint32_t UAVTalkGetPacketInstId(UAVTalkConnection connectionHandle)
 }
 
 /**
- * Handles a request for file data.
+ * Reads the next piece of a file into a message, compressed when asked
+ * for and when that makes it smaller.
+ * \param[in] connection The connection being served
+ * \param[out] buf Where the message payload goes
+ * \param[in] file_id The file requested
+ * \param[in] offset Where in the file to read from
+ * \param[in] compress Whether compressing was asked for
+ * \param[out] flags UAVTALK_FILEDATA_LZ4 if the payload was compressed
+ * \param[out] raw_len Number of bytes of the file taken
+ * \return length of the payload, 0 on EOF, negative on error
+ */
+static int32_t readFileChunk(UAVTalkConnectionData *connection,
+		uint8_t *buf, uint32_t file_id, uint32_t offset, bool compress,
+		uint8_t *flags, int32_t *raw_len)
+{
+	*flags = 0;
+
+	if (compress && !connection->fileComp) {
+		/* Only links that ever ask for compression pay for it; if
+		 * there's no memory, data just goes uncompressed.
+		 */
+		connection->fileComp = PIOS_malloc_no_dma(
+				sizeof(*connection->fileComp));
+	}
+
+	if (!compress || !connection->fileComp) {
+		*raw_len = connection->fileCb(connection->cbCtx, buf,
+				file_id, offset, UAVTALK_FILEDATA_CHUNK_LEN);
+
+		return *raw_len;
+	}
+
+	struct filecomp_data *comp = connection->fileComp;
+
+	*raw_len = connection->fileCb(connection->cbCtx, comp->raw,
+			file_id, offset, UAVTALK_FILEDATA_CHUNK_LEN);
+
+	if (*raw_len <= 0) {
+		return *raw_len;
+	}
+
+	int32_t packed_len = lz4block_compress(&comp->lz4, comp->raw,
+			*raw_len, buf, *raw_len - 1);
+
+	if (packed_len > 0) {
+		*flags = UAVTALK_FILEDATA_LZ4;
+
+		return packed_len;
+	}
+
+	memcpy(buf, comp->raw, *raw_len);
+
+	return *raw_len;
+}
+
+/**
+ * Handles a request for file data.  The request's flags give how many
+ * messages to send back, so that the other end can keep a few requests
+ * going at once rather than waiting on each, and whether to compress.
  * \param[in] connection The connection on which a request was just received.
  */
 static void handleFileReq(UAVTalkConnectionData *connection)
@@ -583,11 +991,24 @@ static void handleFileReq(UAVTalkConnectionData *connection)
 
 	/* printf("Got filereq for file_id=%08x offs=%d\n", file_id, req->offset); */
 
+	uint16_t req_flags = req->flags;
+	int count = req_flags & UAVTALK_FILEREQ_COUNT_MASK;
+
+	if (count == 0) {
+		count = UAVTALK_FILEREQ_DEFAULT_COUNT;
+	} else if (count > UAVTALK_FILEREQ_MAX_COUNT) {
+		count = UAVTALK_FILEREQ_MAX_COUNT;
+	}
+
+	bool compress = (req_flags & UAVTALK_FILEREQ_LZ4) != 0;
+
 	/* Need txbuffer, and need to make sure file response msgs
 	 * are contiguous on link.
 	 */
 	PIOS_Recursive_Mutex_Lock(connection->lock, PIOS_MUTEX_TIMEOUT_MAX);
 
+	flushBatch(connection);
+
 	connection->txBuffer[0] = UAVTALK_SYNC_VAL;  // sync byte
 	connection->txBuffer[1] = UAVTALK_TYPE_FILEDATA;
 	// data length inserted here below
@@ -610,11 +1031,14 @@ static void handleFileReq(UAVTalkConnectionData *connection)
 		resp->flags = 0;
 
 		int32_t cb_numbytes = -1;
+		int32_t raw_numbytes = 0;
+		uint8_t data_flags = 0;
 
 		if (connection->fileCb) {
-			cb_numbytes = connection->fileCb(connection->cbCtx,
+			cb_numbytes = readFileChunk(connection,
 				connection->txBuffer + data_offs,
-				file_id, file_offset, 100);
+				file_id, file_offset, compress,
+				&data_flags, &raw_numbytes);
 		}
 
 		uint8_t total_len = data_offs;
@@ -622,13 +1046,15 @@ static void handleFileReq(UAVTalkConnectionData *connection)
 		if (cb_numbytes > 0) {
 			total_len += cb_numbytes;
 
-			file_offset += cb_numbytes;
+			file_offset += raw_numbytes;
 
-			if (i == 5) {	/* 6 messages per chunk */
+			if (i == count - 1) {
 				resp->flags = UAVTALK_FILEDATA_LAST;
 			} else {
 				resp->flags = 0;
 			}
+
+			resp->flags |= data_flags;
 		} else {
 			/* End of file, last chunk in sequence */
 			resp->flags = UAVTALK_FILEDATA_LAST |
@@ -643,8 +1069,8 @@ static void handleFileReq(UAVTalkConnectionData *connection)
 		connection->txBuffer[total_len] = PIOS_CRC_updateCRC(0,
 				connection->txBuffer, total_len);
 
-		int32_t rc = (*connection->outCb)(connection->cbCtx,
-				connection->txBuffer, total_len + 1);
+		int32_t rc = outputFrame(connection, connection->txBuffer,
+				total_len + 1);
 
 		if (rc == total_len) {
 			// Update stats
@@ -659,6 +1085,74 @@ static void handleFileReq(UAVTalkConnectionData *connection)
 	PIOS_Recursive_Mutex_Unlock(connection->lock);
 }
 
+/**
+ * Unpack the objects carried in a batched frame.  Records for objects we
+ * don't know are skipped.
+ * \param[in] connection The connection on which the frame was received.
+ * \return 0 Success
+ * \return -1 Failure (a malformed record or mismatched object length)
+ */
+static int32_t receiveBatch(UAVTalkConnectionData *connection)
+{
+	UAVTalkInputProcessor *iproc = &connection->iproc;
+
+	const uint8_t *rec = connection->rxBuffer;
+	const uint8_t *end = rec + iproc->length;
+
+	int32_t ret = 0;
+
+	PIOS_Recursive_Mutex_Lock(connection->lock, PIOS_MUTEX_TIMEOUT_MAX);
+
+	while (rec < end) {
+		if ((end - rec) < UAVTALK_BATCH_RECORD_HEADER_LENGTH) {
+			ret = -1;
+			break;
+		}
+
+		uint32_t objId = rec[0] | (rec[1] << 8) | (rec[2] << 16) |
+			((uint32_t) rec[3] << 24);
+		uint8_t len = rec[4];
+
+		rec += UAVTALK_BATCH_RECORD_HEADER_LENGTH;
+
+		if (len > (end - rec)) {
+			ret = -1;
+			break;
+		}
+
+		UAVObjHandle obj = UAVObjGetByID(objId);
+
+		if (obj) {
+			const uint8_t *data = rec;
+			uint32_t expected = UAVObjGetNumBytes(obj);
+			uint16_t instId = 0;
+
+			if (!UAVObjIsSingleInstance(obj)) {
+				expected += 2;
+				instId = data[0] | (data[1] << 8);
+				data += 2;
+			}
+
+			if ((len == expected) &&
+					(instId != UAVOBJ_ALL_INSTANCES)) {
+				UAVObjUnpack(obj, instId, data);
+			} else {
+				ret = -1;
+			}
+		}
+
+		rec += len;
+	}
+
+	if (ret) {
+		connection->stats.rxErrors++;
+	}
+
+	PIOS_Recursive_Mutex_Unlock(connection->lock);
+
+	return ret;
+}
+
 /**
  * Receive an object. This function process objects received through the telemetry stream.
  * \param[in] connection UAVTalkConnection to be used
@@ -682,6 +1176,21 @@ static int32_t receiveObject(UAVTalkConnectionData *connection)
 
 	UAVObjHandle obj = iproc->obj;
 
+	struct uavtalk_secure *secure = connection->secure;
+
+	if (type == UAVTALK_TYPE_SECURE) {
+		return receiveSecure(connection);
+	}
+
+	if (secure && secure->keyed && !secure->unwrapping) {
+		if (secure->required) {
+			connection->stats.rxErrors++;
+			return -1;
+		}
+
+		secure->peer_secured = false;
+	}
+
 	/* Handle ACK/NACK --- don't bother to look up IDs etc for these
 	 * because we don't need it.
 	 *
@@ -714,6 +1223,10 @@ static int32_t receiveObject(UAVTalkConnectionData *connection)
 		return 0;
 	}
 
+	if (type == UAVTALK_TYPE_OBJ_BATCH) {
+		return receiveBatch(connection);
+	}
+
 	PIOS_Recursive_Mutex_Lock(connection->lock, PIOS_MUTEX_TIMEOUT_MAX);
 
 	// Process message type
@@ -739,7 +1252,30 @@ static int32_t receiveObject(UAVTalkConnectionData *connection)
 			}
 		} else {
 			// We don't know this object, and we complain about it
-			sendNack(connection, objId, 0);
+			sendIdFrame(connection, UAVTALK_TYPE_NACK, objId, 0);
+			ret = -1;
+		}
+		break;
+	case UAVTALK_TYPE_OBJ_FIELD:
+	case UAVTALK_TYPE_OBJ_FIELD_ACK:
+		if (obj && (instId != UAVOBJ_ALL_INSTANCES)) {
+			uint16_t offset = connection->rxBuffer[0] |
+				(connection->rxBuffer[1] << 8);
+
+			if (UAVObjUnpackField(obj, instId,
+					connection->rxBuffer + UAVTALK_FIELD_OFFSET_LENGTH,
+					offset,
+					iproc->length - UAVTALK_FIELD_OFFSET_LENGTH) == 0) {
+				if (type == UAVTALK_TYPE_OBJ_FIELD_ACK) {
+					sendObject(connection, obj, instId, UAVTALK_TYPE_ACK);
+				}
+			} else {
+				ret = -1;
+			}
+		} else {
+			if (type == UAVTALK_TYPE_OBJ_FIELD_ACK) {
+				sendIdFrame(connection, UAVTALK_TYPE_NACK, objId, 0);
+			}
 			ret = -1;
 		}
 		break;
@@ -812,6 +1348,23 @@ static int32_t sendObject(UAVTalkConnectionData *connection, UAVObjHandle obj, u
  * \return -1 Failure
  */
 static int32_t sendSingleObject(UAVTalkConnectionData *connection, UAVObjHandle obj, uint16_t instId, uint8_t type)
+{
+	return sendObjectFrame(connection, obj, instId, type, NULL,
+			PIOS_Thread_Systime());
+}
+
+/**
+ * Build and send one object frame.
+ * \param[in] connection UAVTalkConnection to be used
+ * \param[in] obj Object handle to send
+ * \param[in] instId The instance ID
+ * \param[in] type Transaction type
+ * \param[in] data Object data to send, or NULL to pack the object's current data
+ * \param[in] time Timestamp for timestamped types
+ * \return 0 Success
+ * \return -1 Failure
+ */
+static int32_t sendObjectFrame(UAVTalkConnectionData *connection, UAVObjHandle obj, uint16_t instId, uint8_t type, const uint8_t *data, uint32_t time)
 {
 	int32_t length;
 	int32_t dataOffset;
@@ -834,51 +1387,83 @@ static int32_t sendSingleObject(UAVTalkConnectionData *connection, UAVObjHandle
 	// Setup type and object id fields
 	objId = UAVObjGetID(obj);
 
+	// Header is sync, type, length, object id, then instance id and
+	// timestamp if needed
+	dataOffset = UAVObjIsSingleInstance(obj) ? 8 : 10;
+
+	if (type & UAVTALK_TIMESTAMPED) {
+		dataOffset += 2;
+	}
+
+	uint16_t tx_msg_len = dataOffset+length+UAVTALK_CHECKSUM_LENGTH;
+
 	PIOS_Recursive_Mutex_Lock(connection->lock, PIOS_MUTEX_TIMEOUT_MAX);
 
-	connection->txBuffer[0] = UAVTALK_SYNC_VAL;  // sync byte
-	connection->txBuffer[1] = type;
-	// data length inserted here below
-	connection->txBuffer[4] = (uint8_t)(objId & 0xFF);
-	connection->txBuffer[5] = (uint8_t)((objId >> 8) & 0xFF);
-	connection->txBuffer[6] = (uint8_t)((objId >> 16) & 0xFF);
-	connection->txBuffer[7] = (uint8_t)((objId >> 24) & 0xFF);
+	// Keep this packet ordered after anything already batched
+	flushBatch(connection);
+
+	// Build the frame straight in the link's buffer when it allows that
+	uint8_t *txBuffer = NULL;
+
+	// ... unless it is to be wrapped in a secured frame
+	if (connection->reserveCb && !sendSecured(connection)) {
+		txBuffer = (*connection->reserveCb)(connection->cbCtx, tx_msg_len);
+	}
+
+	bool in_place = txBuffer != NULL;
+
+	if (!in_place) {
+		txBuffer = connection->txBuffer;
+	}
+
+	txBuffer[0] = UAVTALK_SYNC_VAL;  // sync byte
+	txBuffer[1] = type;
+	txBuffer[2] = (uint8_t)((dataOffset+length) & 0xFF);
+	txBuffer[3] = (uint8_t)(((dataOffset+length) >> 8) & 0xFF);
+	txBuffer[4] = (uint8_t)(objId & 0xFF);
+	txBuffer[5] = (uint8_t)((objId >> 8) & 0xFF);
+	txBuffer[6] = (uint8_t)((objId >> 16) & 0xFF);
+	txBuffer[7] = (uint8_t)((objId >> 24) & 0xFF);
 
 	// Setup instance ID if one is required
-	if (UAVObjIsSingleInstance(obj)) {
-		dataOffset = 8;
-	} else {
-		connection->txBuffer[8] = (uint8_t)(instId & 0xFF);
-		connection->txBuffer[9] = (uint8_t)((instId >> 8) & 0xFF);
-		dataOffset = 10;
+	int32_t pos = 8;
+
+	if (!UAVObjIsSingleInstance(obj)) {
+		txBuffer[8] = (uint8_t)(instId & 0xFF);
+		txBuffer[9] = (uint8_t)((instId >> 8) & 0xFF);
+		pos = 10;
 	}
 
 	// Add timestamp when the transaction type is appropriate
 	if (type & UAVTALK_TIMESTAMPED) {
-		uint32_t time = PIOS_Thread_Systime();
-		connection->txBuffer[dataOffset] = (uint8_t)(time & 0xFF);
-		connection->txBuffer[dataOffset + 1] = (uint8_t)((time >> 8) & 0xFF);
-		dataOffset += 2;
+		txBuffer[pos] = (uint8_t)(time & 0xFF);
+		txBuffer[pos + 1] = (uint8_t)((time >> 8) & 0xFF);
 	}
 
 	// Copy data (if any)
-	if (length > 0) {
-		if (UAVObjPack(obj, instId, &connection->txBuffer[dataOffset]) < 0) {
+	if (length > 0 && data) {
+		memcpy(&txBuffer[dataOffset], data, length);
+	} else if (length > 0) {
+		if (UAVObjPack(obj, instId, &txBuffer[dataOffset]) < 0) {
+			if (in_place) {
+				(*connection->commitCb)(connection->cbCtx, 0);
+			}
+
 			PIOS_Recursive_Mutex_Unlock(connection->lock);
 			return -1;
 		}
 	}
 
-	// Store the packet length
-	connection->txBuffer[2] = (uint8_t)((dataOffset+length) & 0xFF);
-	connection->txBuffer[3] = (uint8_t)(((dataOffset+length) >> 8) & 0xFF);
-
 	// Calculate checksum
-	connection->txBuffer[dataOffset+length] = PIOS_CRC_updateCRC(0, connection->txBuffer, dataOffset+length);
+	txBuffer[dataOffset+length] = PIOS_CRC_updateCRC(0, txBuffer, dataOffset+length);
 
-	uint16_t tx_msg_len = dataOffset+length+UAVTALK_CHECKSUM_LENGTH;
-	int32_t rc = (*connection->outCb)(connection->cbCtx, connection->txBuffer,
-			tx_msg_len);
+	int32_t rc;
+
+	if (in_place) {
+		rc = (*connection->commitCb)(connection->cbCtx, tx_msg_len);
+	} else {
+		rc = outputFrame(connection, txBuffer, tx_msg_len);
+	}
 
 	if (rc == tx_msg_len) {
 		// Update stats
@@ -906,19 +1491,42 @@ int32_t UAVTalkSendNack(UAVTalkConnection connectionHandle, uint32_t objId,
 	UAVTalkConnectionData *connection;
 	CHECKCONHANDLE(connectionHandle, connection, return -1);
 
-	return sendNack(connection, objId, instId);
+	return sendIdFrame(connection, UAVTALK_TYPE_NACK, objId, instId);
 }
 
-static int32_t sendNack(UAVTalkConnectionData *connection, uint32_t objId,
+/**
+ * Send an ACK by object ID, for requests that aren't answered by sending
+ * one object (such as UAVTALK_OBJID_ALL_SETTINGS).
+ * \param[in] connection UAVTalkConnection to be used
+ * \param[in] objId Object ID to send an ACK for
+ * \param[in] instId inst ID to send an ACK for
+ * \return 0 Success
+ * \return -1 Failure
+ */
+int32_t UAVTalkSendAck(UAVTalkConnection connectionHandle, uint32_t objId,
 		uint16_t instId)
+{
+	UAVTalkConnectionData *connection;
+	CHECKCONHANDLE(connectionHandle, connection, return -1);
+
+	return sendIdFrame(connection, UAVTALK_TYPE_ACK, objId, instId);
+}
+
+/**
+ * Send an ACK or NACK frame, which carry only an object and instance ID.
+ */
+static int32_t sendIdFrame(UAVTalkConnectionData *connection, uint8_t type,
+		uint32_t objId, uint16_t instId)
 {
 	int32_t dataOffset;
 
 	if (!connection->outCb) return -1;
 
 	PIOS_Recursive_Mutex_Lock(connection->lock, PIOS_MUTEX_TIMEOUT_MAX);
+	flushBatch(connection);
+
 	connection->txBuffer[0] = UAVTALK_SYNC_VAL;  // sync byte
-	connection->txBuffer[1] = UAVTALK_TYPE_NACK;
+	connection->txBuffer[1] = type;
 	// data length inserted here below
 	connection->txBuffer[4] = (uint8_t)(objId & 0xFF);
 	connection->txBuffer[5] = (uint8_t)((objId >> 8) & 0xFF);
@@ -942,8 +1550,7 @@ static int32_t sendNack(UAVTalkConnectionData *connection, uint32_t objId,
 	connection->txBuffer[dataOffset] = PIOS_CRC_updateCRC(0, connection->txBuffer, dataOffset);
 
 	uint16_t tx_msg_len = dataOffset + UAVTALK_CHECKSUM_LENGTH;
-	int32_t rc = (*connection->outCb)(connection->cbCtx, connection->txBuffer,
-			tx_msg_len);
+	int32_t rc = outputFrame(connection, connection->txBuffer, tx_msg_len);
 
 	if (rc == tx_msg_len) {
 		// Update stats
@@ -956,6 +1563,334 @@ static int32_t sendNack(UAVTalkConnectionData *connection, uint32_t objId,
 	return 0;
 }
 
+/**
+ * Append one object instance to the pending batched frame, sending the
+ * frame first if the instance doesn't fit.
+ * \param[in] connection UAVTalkConnection to be used
+ * \param[in] obj Object handle to send
+ * \param[in] instId The instance ID (can NOT be UAVOBJ_ALL_INSTANCES)
+ * \return 0 Success
+ * \return -1 Failure
+ */
+static int32_t batchObject(UAVTalkConnectionData *connection, UAVObjHandle obj, uint16_t instId)
+{
+	if (!connection->outCb) return -1;
+
+	uint32_t length = UAVObjGetNumBytes(obj);
+	uint32_t recLength = length + (UAVObjIsSingleInstance(obj) ? 0 : 2);
+
+	// Batches have to leave room to be wrapped on a secured link
+	uint16_t maxLength = UAVTALK_MAX_BATCH_LENGTH;
+
+	if (connection->secure && connection->secure->keyed) {
+		maxLength = UAVTALK_MAX_SECURED_FRAME -
+			UAVTALK_CHECKSUM_LENGTH;
+	}
+
+	// Too big to share a frame with anything; send it on its own.
+	if (recLength > maxLength -
+			UAVTALK_BATCH_HEADER_LENGTH -
+			UAVTALK_BATCH_RECORD_HEADER_LENGTH) {
+		return sendSingleObject(connection, obj, instId,
+				UAVTALK_TYPE_OBJ);
+	}
+
+	PIOS_Recursive_Mutex_Lock(connection->lock, PIOS_MUTEX_TIMEOUT_MAX);
+
+	int32_t ret = -1;
+
+	if (!connection->batchBuffer) {
+		connection->batchBuffer = PIOS_malloc(UAVTALK_MAX_BATCH_LENGTH +
+				UAVTALK_CHECKSUM_LENGTH);
+
+		if (!connection->batchBuffer) {
+			goto unlock_exit;
+		}
+
+		connection->batchLength = 0;
+	}
+
+	if (connection->batchLength + UAVTALK_BATCH_RECORD_HEADER_LENGTH +
+			recLength > maxLength) {
+		flushBatch(connection);
+	}
+
+	if (connection->batchLength == 0) {
+		connection->batchLength = UAVTALK_BATCH_HEADER_LENGTH;
+	}
+
+	uint8_t *rec = connection->batchBuffer + connection->batchLength;
+	uint32_t objId = UAVObjGetID(obj);
+
+	rec[0] = (uint8_t)(objId & 0xFF);
+	rec[1] = (uint8_t)((objId >> 8) & 0xFF);
+	rec[2] = (uint8_t)((objId >> 16) & 0xFF);
+	rec[3] = (uint8_t)((objId >> 24) & 0xFF);
+	rec[4] = recLength;
+
+	uint8_t *data = rec + UAVTALK_BATCH_RECORD_HEADER_LENGTH;
+
+	if (!UAVObjIsSingleInstance(obj)) {
+		data[0] = (uint8_t)(instId & 0xFF);
+		data[1] = (uint8_t)((instId >> 8) & 0xFF);
+		data += 2;
+	}
+
+	if (UAVObjPack(obj, instId, data) < 0) {
+		goto unlock_exit;
+	}
+
+	connection->batchLength += UAVTALK_BATCH_RECORD_HEADER_LENGTH +
+		recLength;
+	connection->batchObjects++;
+	connection->batchObjectBytes += length;
+
+	ret = 0;
+
+unlock_exit:
+	PIOS_Recursive_Mutex_Unlock(connection->lock);
+	return ret;
+}
+
+/**
+ * Send the pending batched frame, if any.  A frame holding just one
+ * object is sent as a plain object packet, which is a byte shorter.
+ * Must be called with the connection lock held.
+ * \param[in] connection UAVTalkConnection to be used
+ * \return 0 Success
+ * \return -1 Failure
+ */
+static int32_t flushBatch(UAVTalkConnectionData *connection)
+{
+	if (connection->batchLength <= UAVTALK_BATCH_HEADER_LENGTH) {
+		return 0;
+	}
+
+	uint8_t *buf = connection->batchBuffer;
+	uint16_t length = connection->batchLength;
+
+	buf[0] = UAVTALK_SYNC_VAL;
+
+	if (connection->batchObjects == 1) {
+		/* Drop the record length byte, leaving the object ID
+		 * followed by the instance ID and data, as in an OBJ packet.
+		 */
+		memmove(buf + UAVTALK_BATCH_RECORD_HEADER_LENGTH,
+				buf + UAVTALK_BATCH_HEADER_LENGTH,
+				4);
+
+		buf++;
+		length--;
+
+		buf[0] = UAVTALK_SYNC_VAL;
+		buf[1] = UAVTALK_TYPE_OBJ;
+	} else {
+		buf[1] = UAVTALK_TYPE_OBJ_BATCH;
+	}
+
+	buf[2] = (uint8_t)(length & 0xFF);
+	buf[3] = (uint8_t)((length >> 8) & 0xFF);
+
+	buf[length] = PIOS_CRC_updateCRC(0, buf, length);
+
+	uint16_t tx_msg_len = length + UAVTALK_CHECKSUM_LENGTH;
+	int32_t rc = outputFrame(connection, buf, tx_msg_len);
+
+	int32_t ret = -1;
+
+	if (rc == tx_msg_len) {
+		// Update stats
+		connection->stats.txObjects += connection->batchObjects;
+		connection->stats.txBytes += tx_msg_len;
+		connection->stats.txObjectBytes += connection->batchObjectBytes;
+
+		ret = 0;
+	} else {
+		connection->stats.txErrors++;
+	}
+
+	connection->batchLength = 0;
+	connection->batchObjects = 0;
+	connection->batchObjectBytes = 0;
+
+	return ret;
+}
+
+/**
+ * Whether frames sent now are wrapped in secured frames: always when they
+ * are required, otherwise when the other end is sending them.
+ */
+static bool sendSecured(UAVTalkConnectionData *connection)
+{
+	struct uavtalk_secure *secure = connection->secure;
+
+	return secure && secure->keyed &&
+		(secure->required || secure->peer_secured);
+}
+
+/**
+ * Fill in the counter block for a secured frame, from its salt and
+ * sequence number.  The last four bytes count blocks of the frame.
+ */
+static void secureCounterBlock(const uint8_t *nonce, uint8_t *block)
+{
+	memset(block, 0, AES128_BLOCK_SIZE);
+	memcpy(block, nonce, UAVTALK_SECURE_NONCE_LENGTH);
+}
+
+/**
+ * Send a complete frame, wrapping it in a secured frame if need be.
+ * Must be called with the connection lock held.
+ * \param[in] connection UAVTalkConnection to be used
+ * \param[in] buf The frame, sync byte to checksum
+ * \param[in] length Length of the frame
+ * \return length on success, as the output callback would
+ * \return -1 Failure
+ */
+static int32_t outputFrame(UAVTalkConnectionData *connection, uint8_t *buf,
+		uint16_t length)
+{
+	if (!sendSecured(connection)) {
+		return (*connection->outCb)(connection->cbCtx, buf, length);
+	}
+
+	struct uavtalk_secure *secure = connection->secure;
+
+	if (length > UAVTALK_MAX_SECURED_FRAME) {
+		connection->stats.txErrors++;
+		return -1;
+	}
+
+	/* A new salt for each session, and whenever the sequence wraps,
+	 * so that no counter block is used twice with a key.  Encrypting
+	 * the time makes it unpredictable to anyone without the key. */
+	if (secure->tx_seq == 0) {
+		uint8_t block[AES128_BLOCK_SIZE] = { 0 };
+		uint32_t raw = PIOS_DELAY_GetRaw();
+		uint32_t now = PIOS_Thread_Systime();
+
+		memcpy(block, &raw, sizeof(raw));
+		memcpy(block + 4, &now, sizeof(now));
+		memcpy(block + 8, &secure->tx_salt, sizeof(secure->tx_salt));
+
+		aes128_encrypt(&secure->enc, block, block);
+		memcpy(&secure->tx_salt, block, sizeof(secure->tx_salt));
+
+		secure->tx_seq = 1;
+	}
+
+	uint32_t seq = secure->tx_seq++;
+
+	uint8_t *frame = secure->tx_frame;
+	uint8_t *nonce = frame + UAVTALK_SECURE_HEADER_LENGTH;
+	uint8_t *sealed = nonce + UAVTALK_SECURE_NONCE_LENGTH;
+	uint16_t size = UAVTALK_SECURE_HEADER_LENGTH +
+		UAVTALK_SECURE_NONCE_LENGTH + length + UAVTALK_SECURE_TAG_LENGTH;
+
+	frame[0] = UAVTALK_SYNC_VAL;
+	frame[1] = UAVTALK_TYPE_SECURE;
+	frame[2] = (uint8_t)(size & 0xFF);
+	frame[3] = (uint8_t)((size >> 8) & 0xFF);
+
+	nonce[0] = (uint8_t)(secure->tx_salt & 0xFF);
+	nonce[1] = (uint8_t)((secure->tx_salt >> 8) & 0xFF);
+	nonce[2] = (uint8_t)((secure->tx_salt >> 16) & 0xFF);
+	nonce[3] = (uint8_t)((secure->tx_salt >> 24) & 0xFF);
+	nonce[4] = (uint8_t)(seq & 0xFF);
+	nonce[5] = (uint8_t)((seq >> 8) & 0xFF);
+	nonce[6] = (uint8_t)((seq >> 16) & 0xFF);
+	nonce[7] = (uint8_t)((seq >> 24) & 0xFF);
+
+	uint8_t block[AES128_BLOCK_SIZE];
+
+	memcpy(sealed, buf, length);
+	secureCounterBlock(nonce, block);
+	aes128_ctr(&secure->enc, block, sealed, length);
+
+	aes128_cmac(&secure->mac, nonce, UAVTALK_SECURE_NONCE_LENGTH + length,
+			block);
+	memcpy(sealed + length, block, UAVTALK_SECURE_TAG_LENGTH);
+
+	frame[size] = PIOS_CRC_updateCRC(0, frame, size);
+
+	int32_t rc = (*connection->outCb)(connection->cbCtx, frame,
+			size + UAVTALK_CHECKSUM_LENGTH);
+
+	if (rc != size + UAVTALK_CHECKSUM_LENGTH) {
+		return -1;
+	}
+
+	return length;
+}
+
+/**
+ * Check and unwrap a secured frame, then handle the frame inside it.
+ * Frames that don't check out, or were seen before, are dropped.
+ * \param[in] connection The connection on which the frame was received.
+ * \return 0 Success
+ * \return -1 Failure
+ */
+static int32_t receiveSecure(UAVTalkConnectionData *connection)
+{
+	UAVTalkInputProcessor *iproc = &connection->iproc;
+	struct uavtalk_secure *secure = connection->secure;
+
+	/* No key, or a secured frame inside a secured frame */
+	if (!secure || !secure->keyed || secure->unwrapping) {
+		connection->stats.rxErrors++;
+		return -1;
+	}
+
+	const uint8_t *nonce = connection->rxBuffer;
+	const uint8_t *sealed = nonce + UAVTALK_SECURE_NONCE_LENGTH;
+	uint16_t length = iproc->length - UAVTALK_SECURE_NONCE_LENGTH -
+		UAVTALK_SECURE_TAG_LENGTH;
+
+	uint8_t block[AES128_BLOCK_SIZE];
+
+	aes128_cmac(&secure->mac, nonce, UAVTALK_SECURE_NONCE_LENGTH + length,
+			block);
+
+	/* Compare all of it, so how long this takes says nothing */
+	uint8_t diff = 0;
+
+	for (int i = 0; i < UAVTALK_SECURE_TAG_LENGTH; i++) {
+		diff |= block[i] ^ sealed[length + i];
+	}
+
+	uint32_t salt = nonce[0] | (nonce[1] << 8) | (nonce[2] << 16) |
+		((uint32_t) nonce[3] << 24);
+	uint32_t seq = nonce[4] | (nonce[5] << 8) | (nonce[6] << 16) |
+		((uint32_t) nonce[7] << 24);
+
+	if (diff || (secure->rx_valid && salt == secure->rx_salt &&
+				seq <= secure->rx_seq)) {
+		connection->stats.rxErrors++;
+		return -1;
+	}
+
+	secure->rx_salt = salt;
+	secure->rx_seq = seq;
+	secure->rx_valid = true;
+	secure->peer_secured = true;
+
+	memcpy(secure->rx_frame, sealed, length);
+	secureCounterBlock(nonce, block);
+	aes128_ctr(&secure->enc, block, secure->rx_frame, length);
+
+	secure->unwrapping = true;
+	UAVTalkProcessInputStream(connection, secure->rx_frame, length);
+	secure->unwrapping = false;
+
+	// Whatever the inner frame left, the outer one is done with
+	iproc->state = UAVTALK_STATE_COMPLETE;
+
+	// Those bytes were already counted, wrapped
+	connection->stats.rxBytes -= length;
+
+	return 0;
+}
+
 /**
  * @}
  * @}
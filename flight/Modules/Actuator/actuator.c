@@ -41,17 +41,23 @@
 #include <math.h>
 
 #include "openpilot.h"
+#include "actuator.h"
 #include "actuatorsettings.h"
 #include "systemsettings.h"
 #include "actuatordesired.h"
 #include "actuatorcommand.h"
+#include "motorrpm.h"
 #include "flightstatus.h"
 #include "mixersettings.h"
 #include "cameradesired.h"
+#include "gyros.h"
 #include "manualcontrolcommand.h"
 #include "pios_thread.h"
 #include "pios_queue.h"
+#include "pios_mutex.h"
 #include "misc_math.h"
+#include "looptiming.h"
+#include "blackbox.h"
 
 // Private constants
 #define MAX_QUEUE_SIZE 2
@@ -82,6 +88,15 @@ DONT_BUILD_IF((MIXERSETTINGS_MIXER1VECTOR_NUMELEM - MIXERSETTINGS_MIXER1VECTOR_A
 static struct pios_queue *queue;
 static struct pios_thread *taskHandle;
 
+/* Held by whichever of the actuator task and the inline path is mixing and
+ * driving the outputs at the moment.
+ */
+static struct pios_mutex *step_mutex;
+
+static volatile bool inline_mixing;
+static volatile bool inline_ran;
+static volatile uint32_t last_inline_systime;
+
 static float hangtime_leakybucket_timeconstant = 0.3f;
 
 // used to inform the actuator thread that actuator / mixer settings are updated
@@ -98,22 +113,52 @@ static MixerSettingsMixer1TypeOptions types_mixer[MAX_MIX_ACTUATORS];
 
 static float motor_mixer[MAX_MIX_ACTUATORS * MIXERSETTINGS_MIXER1VECTOR_NUMELEM];
 
+/* The rows of motor_mixer that actually mix anything (servos and motors),
+ * packed together so the per-update multiply skips the rest.
+ */
+static float mixed_matrix[MAX_MIX_ACTUATORS * MIXERSETTINGS_MIXER1VECTOR_NUMELEM];
+static uint8_t mixed_channel[MAX_MIX_ACTUATORS];
+static uint8_t num_mixed;
+
 /* These are various settings objects used throughout the actuator code */
 static ActuatorSettingsData actuatorSettings;
 static SystemSettingsAirframeTypeOptions airframe_type;
 
 static float curve2[MIXERSETTINGS_THROTTLECURVE2_NUMELEM];
+static float curve2_slope[MIXERSETTINGS_THROTTLECURVE2_NUMELEM - 1];
 
 static MixerSettingsCurve2SourceOptions curve2_src;
 
+/* Loop state, shared by the task and the inline path */
+static uint32_t last_systime;
+static float desired_vect[MIXERSETTINGS_MIXER1VECTOR_NUMELEM];
+static float dT;
+static float maxpoweradd_bucket;
+static bool prev_armed;
+static uint32_t last_rpm_systime;
+static uint32_t last_publish_systime;
+
+/* Camera outputs for this update: CameraDesired, moved on by what the
+ * gyros say the airframe has turned since it was last updated.
+ */
+static volatile bool camera_desired_updated = true;
+static bool camera_connected;
+static bool has_camera;
+static CameraDesiredData camera_desired;
+static float camera_turned[CAMERADESIRED_RATEGAIN_NUMELEM];
+static float camera_vect[CAMERADESIRED_RATEGAIN_NUMELEM];
+static uint32_t camera_raw;
+
 // Private functions
 static void actuator_task(void* parameters);
 
 static float scale_channel(float value, int idx, bool active_cmd);
 static void set_failsafe();
+static void update_motor_rpm();
+static void update_camera();
 
-static float collective_curve(const float input, const float *curve,
-		uint8_t num_points);
+static void compile_collective_curve();
+static float collective_curve(const float input);
 
 volatile enum actuator_interlock actuator_interlock = ACTUATOR_INTERLOCK_OK;
 
@@ -246,11 +291,20 @@ int32_t ActuatorInitialize()
 	queue = PIOS_Queue_Create(MAX_QUEUE_SIZE, sizeof(UAVObjEvent));
 	ActuatorDesiredConnectQueue(queue);
 
+	step_mutex = PIOS_Mutex_Create();
+	if (!step_mutex) {
+		return -1;
+	}
+
 	// Primary output of this module
 	if (ActuatorCommandInitialize() == -1) {
 		return -1;
 	}
 
+	if (MotorRPMInitialize() == -1) {
+		return -1;
+	}
+
 #if defined(MIXERSTATUS_DIAGNOSTICS)
 	// UAVO only used for inspecting the internal status of the mixer during debug
 	if (MixerStatusInitialize()  == -1) {
@@ -408,6 +462,28 @@ static void compute_mixer()
 #if MAX_MIX_ACTUATORS > 9
 	compute_one_token_paste(10);
 #endif
+
+	num_mixed = 0;
+	has_camera = false;
+
+	for (int ct = 0; ct < MAX_MIX_ACTUATORS; ct++) {
+		if ((types_mixer[ct] == MIXERSETTINGS_MIXER1TYPE_CAMERAROLL) ||
+				(types_mixer[ct] == MIXERSETTINGS_MIXER1TYPE_CAMERAPITCH) ||
+				(types_mixer[ct] == MIXERSETTINGS_MIXER1TYPE_CAMERAYAW)) {
+			has_camera = true;
+		}
+
+		if ((types_mixer[ct] != MIXERSETTINGS_MIXER1TYPE_SERVO) &&
+				(types_mixer[ct] != MIXERSETTINGS_MIXER1TYPE_MOTOR)) {
+			continue;
+		}
+
+		memcpy(&mixed_matrix[num_mixed * MIXERSETTINGS_MIXER1VECTOR_NUMELEM],
+				&motor_mixer[ct * MIXERSETTINGS_MIXER1VECTOR_NUMELEM],
+				sizeof(float) * MIXERSETTINGS_MIXER1VECTOR_NUMELEM);
+
+		mixed_channel[num_mixed++] = ct;
+	}
 }
 
 static void fill_desired_vector(
@@ -430,7 +506,7 @@ static void post_process_scale_and_commit(float *motor_vect,
 		float *desired_vect, float dT,
 		bool armed, bool spin_while_armed, bool stabilize_now,
 		bool flip_over_mode,
-		float *maxpoweradd_bucket)
+		float *maxpoweradd_bucket, bool publish)
 {
 	float min_chan = INFINITY;
 	float max_chan = -INFINITY;
@@ -515,28 +591,13 @@ static void post_process_scale_and_commit(float *motor_vect,
 				num_motors++;
 				break;
 			case MIXERSETTINGS_MIXER1TYPE_CAMERAPITCH:
-				if (CameraDesiredHandle()) {
-					CameraDesiredPitchGet(
-							&motor_vect[ct]);
-				} else {
-					motor_vect[ct] = -1;
-				}
+				motor_vect[ct] = camera_vect[CAMERADESIRED_RATEGAIN_PITCH];
 				break;
 			case MIXERSETTINGS_MIXER1TYPE_CAMERAROLL:
-				if (CameraDesiredHandle()) {
-					CameraDesiredRollGet(
-							&motor_vect[ct]);
-				} else {
-					motor_vect[ct] = -1;
-				}
+				motor_vect[ct] = camera_vect[CAMERADESIRED_RATEGAIN_ROLL];
 				break;
 			case MIXERSETTINGS_MIXER1TYPE_CAMERAYAW:
-				if (CameraDesiredHandle()) {
-					CameraDesiredRollGet(
-							&motor_vect[ct]);
-				} else {
-					motor_vect[ct] = -1;
-				}
+				motor_vect[ct] = camera_vect[CAMERADESIRED_RATEGAIN_YAW];
 				break;
 			default:
 				set_failsafe();
@@ -645,15 +706,23 @@ static void post_process_scale_and_commit(float *motor_vect,
 
 	ActuatorCommandMaxUpdateTimeGet(&command.MaxUpdateTime);
 
-	if (command.UpdateTime > command.MaxUpdateTime)
+	if (command.UpdateTime > command.MaxUpdateTime) {
 		command.MaxUpdateTime = 1000.0f*dT;
 
+		/* Don't lose a new maximum between throttled publishes */
+		if (!publish && !ActuatorCommandReadOnly()) {
+			ActuatorCommandMaxUpdateTimeSet(&command.MaxUpdateTime);
+		}
+	}
+
 	// Store bucket content
 	command.LowPowerStabilizationReserve = *maxpoweradd_bucket;
 
 	// Update output object
 	if (!ActuatorCommandReadOnly()) {
-		ActuatorCommandSet(&command);
+		if (publish) {
+			ActuatorCommandSet(&command);
+		}
 	} else {
 		// it's read only during servo configuration--
 		// so GCS takes precedence.
@@ -664,22 +733,24 @@ static void post_process_scale_and_commit(float *motor_vect,
 		PIOS_Servo_Set(n, command.Channel[n]);
 	}
 
+	blackbox_log_outputs(command.Channel, ACTUATORCOMMAND_CHANNEL_NUMELEM);
+
 	PIOS_Servo_Update();
+
+	looptiming_mark(LOOPTIMING_ACTUATOR);
 }
 
 static void normalize_input_data(uint32_t this_systime,
+		ActuatorDesiredData *desired,
 		float (*desired_vect)[MIXERSETTINGS_MIXER1VECTOR_NUMELEM],
 		bool *armed, bool *spin_while_armed, bool *stabilize_now,
 		bool *flip_over_mode)
 {
 	static float manual_throt = -1;
 	float throttle_val = 0;
-	ActuatorDesiredData desired;
 
 	static FlightStatusData flightStatus;
 
-	ActuatorDesiredGet(&desired);
-
 	if (flight_status_updated) {
 		FlightStatusGet(&flightStatus);
 		flight_status_updated = false;
@@ -696,7 +767,7 @@ static void normalize_input_data(uint32_t this_systime,
 
 	*armed = flightStatus.Armed == FLIGHTSTATUS_ARMED_ARMED;
 	*spin_while_armed = actuatorSettings.MotorsSpinWhileArmed == ACTUATORSETTINGS_MOTORSSPINWHILEARMED_TRUE;
-	*flip_over_mode = desired.FlipOverThrustMode == ACTUATORDESIRED_FLIPOVERTHRUSTMODE_TRUE;
+	*flip_over_mode = desired->FlipOverThrustMode == ACTUATORDESIRED_FLIPOVERTHRUSTMODE_TRUE;
 
 	if (airframe_type == SYSTEMSETTINGS_AIRFRAMETYPE_HELICP) {
 		// Helis set throttle from manual control's throttle value,
@@ -706,7 +777,7 @@ static void normalize_input_data(uint32_t this_systime,
 			throttle_val = manual_throt;
 		}
 	} else {
-		throttle_val = desired.Thrust;
+		throttle_val = desired->Thrust;
 	}
 
 	if (!*armed) {
@@ -716,12 +787,12 @@ static void normalize_input_data(uint32_t this_systime,
 	*stabilize_now = throttle_val != 0.0f;
 
 	if (*flip_over_mode) {
-		apply_channel_deadband(&desired.Pitch, 0.25f);
-		apply_channel_deadband(&desired.Roll, 0.25f);
-		apply_channel_deadband(&desired.Yaw, 0.25f);
+		apply_channel_deadband(&desired->Pitch, 0.25f);
+		apply_channel_deadband(&desired->Roll, 0.25f);
+		apply_channel_deadband(&desired->Yaw, 0.25f);
 
-		if ((desired.Pitch == 0) && (desired.Roll == 0) &&
-				(desired.Yaw == 0)) {
+		if ((desired->Pitch == 0) && (desired->Roll == 0) &&
+				(desired->Yaw == 0)) {
 			*stabilize_now = false;
 			throttle_val = 0.0f;
 		}
@@ -731,17 +802,19 @@ static void normalize_input_data(uint32_t this_systime,
 
 	//The source for the secondary curve is selectable
 	float val2 = collective_curve(
-			get_curve2_source(&desired, airframe_type, curve2_src,
-				throttle_val),
-			curve2, MIXERSETTINGS_THROTTLECURVE2_NUMELEM);
+			get_curve2_source(desired, airframe_type, curve2_src,
+				throttle_val));
 
-	fill_desired_vector(&desired, val1, val2, desired_vect);
+	fill_desired_vector(desired, val1, val2, desired_vect);
 }
 
 static void actuator_settings_update()
 {
 	ActuatorSettingsGet(&actuatorSettings);
 
+	PIOS_Servo_SetDshotBidirectional(
+			actuatorSettings.DShotBidirectional == ACTUATORSETTINGS_DSHOTBIDIRECTIONAL_TRUE);
+
 	PIOS_Servo_SetMode(actuatorSettings.TimerUpdateFreq,
 			ACTUATORSETTINGS_TIMERUPDATEFREQ_NUMELEM,
 			actuatorSettings.ChannelMax,
@@ -756,6 +829,158 @@ static void actuator_settings_update()
 	}
 
 	hangtime_leakybucket_timeconstant = actuatorSettings.LowPowerStabilizationTimeConstant;
+
+	inline_mixing = actuatorSettings.InlineMixing == ACTUATORSETTINGS_INLINEMIXING_TRUE;
+}
+
+/**
+ * @brief Mix one ActuatorDesired update and drive the outputs
+ *
+ * Runs from the actuator task, or directly from the stabilization loop
+ * when InlineMixing is enabled.  The caller holds step_mutex.
+ *
+ * \param[in,out] desired the desired actuation; deadbanded in place
+ * \param[in] this_systime system time of this update
+ * \param[in] publish whether to publish ActuatorCommand this time
+ */
+static void actuator_step(ActuatorDesiredData *desired,
+		uint32_t this_systime, bool publish)
+{
+	/* If settings objects have changed, update our internal
+	 * state appropriately.
+	 */
+	if (settings_updated) {
+		actuator_settings_update();
+
+		SystemSettingsAirframeTypeGet(&airframe_type);
+
+		compute_mixer();
+
+		MixerSettingsThrottleCurve2Get(curve2);
+		MixerSettingsCurve2SourceGet(&curve2_src);
+		compile_collective_curve();
+		settings_updated = false;
+	}
+
+	/* Check how long since last update; this is stored into the
+	 * UAVO to allow analysis of actuation jitter.
+	 */
+	if (this_systime > last_systime) {
+		dT = (this_systime - last_systime) / 1000.0f;
+		/* (Otherwise, the timer has wrapped [rare] and we should
+		 * just reuse dT)
+		 */
+	}
+
+	last_systime = this_systime;
+
+	float motor_vect[MAX_MIX_ACTUATORS] = { 0 };
+	float mixed_vect[MAX_MIX_ACTUATORS];
+
+	bool armed, spin_while_armed, stabilize_now, flip_over_mode;
+
+	/* Receive manual control and desired UAV objects.  Perform
+	 * arming / hangtime checks; form a vector with desired
+	 * axis actions.
+	 */
+	normalize_input_data(this_systime, desired, &desired_vect, &armed,
+			&spin_while_armed, &stabilize_now,
+			&flip_over_mode);
+
+	/* Multiply the mixed actuators x desired matrix by the
+	 * desired x 1 column vector, and scatter the result to the
+	 * channels.  Everything else stays zero.
+	 */
+	matrix_mul(mixed_matrix, desired_vect, mixed_vect, num_mixed,
+			MIXERSETTINGS_MIXER1VECTOR_NUMELEM, 1);
+
+	for (int i = 0; i < num_mixed; i++) {
+		motor_vect[mixed_channel[i]] = mixed_vect[i];
+	}
+
+	if (has_camera) {
+		update_camera();
+	}
+
+	/* At arming time, knock all 3d actuators into 3D mode.
+	 * Note we never "take them out" of 3d mode.
+	 */
+	if (armed != prev_armed) {
+		if (armed && desired_3d_mask) {
+			if (!actuator_send_dshot_command_now(
+					DSHOT_COMMAND_3DMODE,
+					DSHOT_COUNT_EXCESSIVE,
+					desired_3d_mask)) {
+				prev_armed = armed;
+			}
+		} else {
+			prev_armed = armed;
+		}
+	}
+
+	/* Perform clipping adjustments on the outputs, along with
+	 * state-related corrections (spin while armed, disarmed, etc).
+	 *
+	 * Program the actual values to the timer subsystem.
+	 */
+	post_process_scale_and_commit(motor_vect, desired_vect,
+			dT, armed, spin_while_armed, stabilize_now,
+			flip_over_mode, &maxpoweradd_bucket, publish);
+
+	/* Telemetry comes back with each frame; publish it at most
+	 * once a millisecond.
+	 */
+	if (actuatorSettings.DShotBidirectional ==
+			ACTUATORSETTINGS_DSHOTBIDIRECTIONAL_TRUE &&
+			this_systime != last_rpm_systime) {
+		update_motor_rpm();
+		last_rpm_systime = this_systime;
+	}
+
+	/* If we got this far, everything is OK. */
+	AlarmsClear(SYSTEMALARMS_ALARM_ACTUATOR);
+}
+
+/**
+ * @brief Mix and commit outputs directly from the caller's loop
+ *
+ * Saves the wakeup of the actuator task for each control cycle.  Only
+ * does anything when InlineMixing is enabled and nobody has stopped the
+ * actuators; otherwise the caller should publish ActuatorDesired as usual.
+ * ActuatorCommand is published every ACTUATOR_INLINE_PUBLISH_MS.
+ *
+ * \param[in] desired the desired actuation for this cycle
+ * \return true if the outputs were updated
+ */
+bool actuator_run_inline(const ActuatorDesiredData *desired)
+{
+	if (!inline_mixing || actuator_interlock != ACTUATOR_INTERLOCK_OK) {
+		/* Hand the outputs straight back to the task */
+		inline_ran = false;
+		return false;
+	}
+
+	ActuatorDesiredData desired_copy = *desired;
+
+	PIOS_Mutex_Lock(step_mutex, PIOS_MUTEX_TIMEOUT_MAX);
+
+	uint32_t this_systime = PIOS_Thread_Systime();
+
+	bool publish = PIOS_Thread_Period_Elapsed(last_publish_systime,
+			ACTUATOR_INLINE_PUBLISH_MS);
+
+	if (publish) {
+		last_publish_systime = this_systime;
+	}
+
+	actuator_step(&desired_copy, this_systime, publish);
+
+	last_inline_systime = this_systime;
+	inline_ran = true;
+
+	PIOS_Mutex_Unlock(step_mutex);
+
+	return true;
 }
 
 /**
@@ -769,6 +994,9 @@ static void actuator_settings_update()
  * Note this code depends on the UAVObjects for the mixers being all being the same
  * and in sequence. If you change the object definition, make sure you check the code!
  *
+ * When the inline path is driving the outputs, this task only watches for
+ * ActuatorDesired going stale and handles the actuator interlock.
+ *
  * @return -1 if error, 0 if success
  */
 static void actuator_task(void* parameters)
@@ -785,31 +1013,10 @@ static void actuator_task(void* parameters)
 	set_failsafe();
 
 	/* This is out here because not everything may change each time */
-	uint32_t last_systime = PIOS_Thread_Systime();
-	float desired_vect[MIXERSETTINGS_MIXER1VECTOR_NUMELEM] = { 0 };
-	float dT = 0.0f;
-	
-	float maxpoweradd_bucket = 0.0f;
-
-	bool prev_armed = false;
+	last_systime = PIOS_Thread_Systime();
 
 	// Main task loop
 	while (1) {
-		/* If settings objects have changed, update our internal
-		 * state appropriately.
-		 */
-		if (settings_updated) {
-			actuator_settings_update();
-
-			SystemSettingsAirframeTypeGet(&airframe_type);
-
-			compute_mixer();
-
-			MixerSettingsThrottleCurve2Get(curve2);
-			MixerSettingsCurve2SourceGet(&curve2_src);
-			settings_updated = false;
-		}
-
 		PIOS_WDG_UpdateFlag(PIOS_WDG_ACTUATOR);
 
 		UAVObjEvent ev;
@@ -818,24 +1025,14 @@ static void actuator_task(void* parameters)
 		if (!PIOS_Queue_Receive(queue, &ev, FAILSAFE_TIMEOUT_MS)) {
 			// If we hit a timeout, set the actuator failsafe and
 			// try again.
+			PIOS_Mutex_Lock(step_mutex, PIOS_MUTEX_TIMEOUT_MAX);
 			set_failsafe();
+			PIOS_Mutex_Unlock(step_mutex);
 			continue;
 		}
 
 		uint32_t this_systime = PIOS_Thread_Systime();
 
-		/* Check how long since last update; this is stored into the
-		 * UAVO to allow analysis of actuation jitter.
-		 */
-		if (this_systime > last_systime) {
-			dT = (this_systime - last_systime) / 1000.0f;
-			/* (Otherwise, the timer has wrapped [rare] and we should
-			 * just reuse dT)
-			 */
-		}
-
-		last_systime = this_systime;
-
 		if (actuator_interlock != ACTUATOR_INTERLOCK_OK) {
 			/* Chosen because: 50Hz does 4-6 updates in 100ms */
 			uint32_t exp_time = this_systime + 100;
@@ -850,7 +1047,9 @@ static void actuator_task(void* parameters)
 				 * before putting us back to OK.
 				 */
 				if (actuator_interlock == ACTUATOR_INTERLOCK_STOPREQUEST) {
+					PIOS_Mutex_Lock(step_mutex, PIOS_MUTEX_TIMEOUT_MAX);
 					set_failsafe();
+					PIOS_Mutex_Unlock(step_mutex);
 
 					this_systime = PIOS_Thread_Systime();
 
@@ -863,76 +1062,165 @@ static void actuator_task(void* parameters)
 				PIOS_WDG_UpdateFlag(PIOS_WDG_ACTUATOR);
 			}
 
+			PIOS_Mutex_Lock(step_mutex, PIOS_MUTEX_TIMEOUT_MAX);
 			PIOS_Servo_SetMode(actuatorSettings.TimerUpdateFreq,
 					ACTUATORSETTINGS_TIMERUPDATEFREQ_NUMELEM,
 					actuatorSettings.ChannelMax,
 					actuatorSettings.ChannelMin);
+			PIOS_Mutex_Unlock(step_mutex);
 			continue;
 		}
 
-
-		float motor_vect[MAX_MIX_ACTUATORS];
-
-		bool armed, spin_while_armed, stabilize_now, flip_over_mode;
-
-		/* Receive manual control and desired UAV objects.  Perform
-		 * arming / hangtime checks; form a vector with desired
-		 * axis actions.
-		 */
-		normalize_input_data(this_systime, &desired_vect, &armed,
-				&spin_while_armed, &stabilize_now,
-				&flip_over_mode);
-
-		/* Multiply the actuators x desired matrix by the
-		 * desired x 1 column vector. */
-		matrix_mul_check(motor_mixer, desired_vect, motor_vect,
-				MAX_MIX_ACTUATORS,
-				MIXERSETTINGS_MIXER1VECTOR_NUMELEM,
-				1);
-
-		/* At arming time, knock all 3d actuators into 3D mode.
-		 * Note we never "take them out" of 3d mode.
+		/* The stabilization loop is mixing inline and this is just
+		 * one of its throttled ActuatorDesired updates.
 		 */
-		if (armed != prev_armed) {
-			if (armed && desired_3d_mask) {
-				if (!actuator_send_dshot_command_now(
-						DSHOT_COMMAND_3DMODE,
-						DSHOT_COUNT_EXCESSIVE,
-						desired_3d_mask)) {
-					prev_armed = armed;
-				}
-			} else {
-				prev_armed = armed;
-			}
+		if (inline_ran && (this_systime - last_inline_systime) < FAILSAFE_TIMEOUT_MS) {
+			continue;
 		}
 
-		/* Perform clipping adjustments on the outputs, along with
-		 * state-related corrections (spin while armed, disarmed, etc).
-		 *
-		 * Program the actual values to the timer subsystem.
-		 */
-		post_process_scale_and_commit(motor_vect, desired_vect,
-				dT, armed, spin_while_armed, stabilize_now,
-				flip_over_mode, &maxpoweradd_bucket);
+		ActuatorDesiredData desired;
+		ActuatorDesiredGet(&desired);
 
-		/* If we got this far, everything is OK. */
-		AlarmsClear(SYSTEMALARMS_ALARM_ACTUATOR);
+		PIOS_Mutex_Lock(step_mutex, PIOS_MUTEX_TIMEOUT_MAX);
+		actuator_step(&desired, this_systime, true);
+		PIOS_Mutex_Unlock(step_mutex);
 	}
 }
 
 /**
- * Interpolate a collective curve
+ * Precompute the segment slopes of the collective curve, so that evaluating
+ * it is one multiply-add.
+ */
+static void compile_collective_curve()
+{
+	for (int i = 0; i < MIXERSETTINGS_THROTTLECURVE2_NUMELEM - 1; i++) {
+		curve2_slope[i] = curve2[i + 1] - curve2[i];
+	}
+}
+
+/**
+ * Interpolate the collective curve
  *
  * we need to accept input in [-1,1] so that the neutral point may be set arbitrarily within the typical channel input range, which is [-1,1]
  *
+ * Same result as linear_interpolate() over curve2.
+ *
  * @param input The input value, in [-1,1]
- * @param curve Array of points in the curve
- * @param num_points Number of points in the curve
  * @return the output value, in [-1,1]
  */
-static float collective_curve(float const input, float const * curve, uint8_t num_points)
+static float collective_curve(float const input)
+{
+	const int last = MIXERSETTINGS_THROTTLECURVE2_NUMELEM - 1;
+
+	float scale = fmaxf((input + 1.0f) * 0.5f, 0.0f) * last;
+	int idx = scale;
+
+	if (idx >= last) {
+		return curve2[last];
+	}
+
+	return curve2[idx] + curve2_slope[idx] * (scale - idx);
+}
+
+/**
+ * Publish the motor speeds reported by the ESCs.  Channels without
+ * valid telemetry this time keep their last value.
+ */
+/**
+ * @brief Work out the camera outputs for this update
+ *
+ * Outputs with a RateGain are moved on from CameraDesired by the gyros,
+ * at the rate we're updated, so a gimbal doesn't lag a fast maneuver by
+ * the camera stabilization period.  Each CameraDesired update starts
+ * them over from its attitude based outputs.
+ */
+static void update_camera()
+{
+	if (!camera_connected) {
+		if (!CameraDesiredHandle()) {
+			for (int i = 0; i < CAMERADESIRED_RATEGAIN_NUMELEM; i++) {
+				camera_vect[i] = -1;
+			}
+
+			return;
+		}
+
+		CameraDesiredConnectCallbackCtx(UAVObjCbSetFlag,
+				&camera_desired_updated);
+		camera_connected = true;
+	}
+
+	uint32_t now = PIOS_DELAY_GetRaw();
+	float dT_camera = PIOS_DELAY_DiffuS2(camera_raw, now) * 1.0e-6f;
+	camera_raw = now;
+
+	/* Stale, or the first time here */
+	if (dT_camera > 0.1f) {
+		dT_camera = 0;
+	}
+
+	if (camera_desired_updated) {
+		camera_desired_updated = false;
+		CameraDesiredGet(&camera_desired);
+		memset(camera_turned, 0, sizeof(camera_turned));
+	}
+
+	camera_vect[CAMERADESIRED_RATEGAIN_ROLL] = camera_desired.Roll;
+	camera_vect[CAMERADESIRED_RATEGAIN_PITCH] = camera_desired.Pitch;
+	camera_vect[CAMERADESIRED_RATEGAIN_YAW] = camera_desired.Yaw;
+
+	if (camera_desired.RateGain[CAMERADESIRED_RATEGAIN_ROLL] == 0 &&
+			camera_desired.RateGain[CAMERADESIRED_RATEGAIN_PITCH] == 0 &&
+			camera_desired.RateGain[CAMERADESIRED_RATEGAIN_YAW] == 0) {
+		return;
+	}
+
+	GyrosData gyros;
+	GyrosGet(&gyros);
+
+	const float *rate = &gyros.x;
+
+	for (int i = 0; i < CAMERADESIRED_RATEGAIN_NUMELEM; i++) {
+		if (camera_desired.RateGain[i] == 0) {
+			continue;
+		}
+
+		camera_turned[i] += rate[i] * dT_camera;
+
+		camera_vect[i] = bound_sym(camera_vect[i] +
+				camera_desired.RateGain[i] *
+				(camera_turned[i] + camera_desired.RateLead * rate[i]),
+				1.0f);
+	}
+}
+
+static void update_motor_rpm()
 {
-	return linear_interpolate(input, curve, num_points, -1.0f, 1.0f);
+	MotorRPMData rpm;
+	MotorRPMGet(&rpm);
+
+	uint8_t pole_pairs = MAX(actuatorSettings.MotorPoles / 2, 1);
+	bool changed = false;
+
+	for (int n = 0; n < MAX_MIX_ACTUATORS; n++) {
+		uint32_t erpm;
+
+		if (types_mixer[n] != MIXERSETTINGS_MIXER1TYPE_MOTOR ||
+				!PIOS_Servo_GetERPM(n, &erpm)) {
+			continue;
+		}
+
+		uint16_t val = MIN(erpm / pole_pairs, UINT16_MAX);
+
+		if (rpm.RPM[n] != val) {
+			rpm.RPM[n] = val;
+			changed = true;
+		}
+	}
+
+	if (changed) {
+		MotorRPMSet(&rpm);
+	}
 }
 
 static float scale_channel_dshot(float value, int idx, bool active_command)
@@ -0,0 +1,46 @@
+/**
+ ******************************************************************************
+ * @addtogroup Modules Modules
+ * @{
+ * @addtogroup ActuatorModule Actuator Module
+ * @{
+ *
+ * @file       actuator.h
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2017
+ * @brief      Inline entry point into the actuator mixer
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef ACTUATOR_H
+#define ACTUATOR_H
+
+#include "openpilot.h"
+#include "actuatordesired.h"
+
+//! How often the inline path publishes ActuatorCommand and ActuatorDesired
+#define ACTUATOR_INLINE_PUBLISH_MS 20
+
+bool actuator_run_inline(const ActuatorDesiredData *desired);
+
+#endif /* ACTUATOR_H */
+
+/**
+  * @}
+  * @}
+  */
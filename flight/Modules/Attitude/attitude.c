@@ -55,6 +55,7 @@
 #include "coordinate_conversions.h"
 #include "WorldMagModel.h"
 #include "insgps.h"
+#include "sensors.h"
 
 // UAVOs
 #include "accels.h"
@@ -74,7 +75,10 @@
 #include "magnetometer.h"
 #include "nedaccel.h"
 #include "nedposition.h"
+#include "opticalflow.h"
+#include "opticalflowsettings.h"
 #include "positionactual.h"
+#include "rangefinder.h"
 #include "stateestimation.h"
 #include "systemalarms.h"
 #include "velocityactual.h"
@@ -131,8 +135,46 @@ struct cfvert {
 	float position_error_z;
 	float position_correction_z;
 	float baro_zero;
+
+	//! Use the Kalman filter on position, velocity and accel bias instead
+	//! of the fixed gains above
+	bool kalman;
+	float accel_bias_z;
+	//! Upper half of the Kalman covariance, in z, v, bias order
+	float p00, p01, p02, p11, p12, p22;
+
+	//! Down position of the ground, while the rangefinder sees it
+	float ground_z;
+	bool ground_valid;
+};
+
+//! Variance of the NED down acceleration, (m/s^2)^2
+#define VERT_KF_ACCEL_VAR	0.09f
+//! How quickly the accel bias wanders, (m/s^2)^2 per second
+#define VERT_KF_BIAS_VAR	0.0001f
+//! Variance of a baro reading, m^2
+#define VERT_KF_BARO_VAR	0.36f
+//! Variance of a rangefinder reading, m^2
+#define VERT_KF_RANGE_VAR	0.0025f
+//! Rangefinder readings are ignored when tilted further than this (45 deg)
+#define VERT_KF_MIN_COS_TILT	0.707f
+
+//! Horizontal position and velocity from the optical flow sensor
+struct cfflow {
+	float position[2];
+	float velocity[2];
+
+	//! When the last flow sample good enough to use came in
+	uint32_t last_sample;
+	bool valid;
 };
 
+//! How much of the difference to the flow velocity to take per sample, at
+//! full quality
+#define FLOW_VELOCITY_GAIN	0.2f
+//! Without a usable flow sample for this long, stop integrating the accels
+#define FLOW_TIMEOUT_MS		500
+
 // Private variables
 static struct pios_thread *attitudeTaskHandle;
 
@@ -142,6 +184,8 @@ static struct pios_queue *magQueue;
 static struct pios_queue *baroQueue;
 static struct pios_queue *gpsQueue;
 static struct pios_queue *gpsVelQueue;
+static struct pios_queue *rangeQueue;
+static struct pios_queue *flowQueue;
 
 static AttitudeSettingsData attitudeSettings;
 static HomeLocationData homeLocation;
@@ -157,6 +201,7 @@ static const float zeros[3] = {0.0f, 0.0f, 0.0f};
 
 static struct complementary_filter_state complementary_filter_state;
 static struct cfvert cfvert; //!< State information for vertical filter
+static struct cfflow cfflow; //!< State information for optical flow navigation
 
 static float dT_expected = 0.001f;	// assume 1KHz if we don't know.
 
@@ -169,15 +214,24 @@ static int32_t setNavigationRaw();
 //! Provide no navigation updates (indoor flying or without gps)
 static int32_t setNavigationNone();
 
+//! Set the navigation information to the optical flow estimate
+static int32_t setNavigationFlow();
+
 //! Update the complementary filter attitude estimate
 static int32_t updateAttitudeComplementary(float dT, bool first_run, bool secondary, bool raw_gps, bool vel_compass);
 //! Set the @ref AttitudeActual to the complementary filter estimate
 static int32_t setAttitudeComplementary();
 
-static float calc_ned_accel(float *q, float *accels);
-static void cfvert_reset(struct cfvert *cf, float baro, float time_constant);
+static float calc_ned_accel(float *q, float *accels, float *accel_ned);
+static void cfvert_reset(struct cfvert *cf, float baro, float time_constant, bool kalman);
 static void cfvert_predict_pos(struct cfvert *cf, float z_accel, float dt);
 static void cfvert_update_baro(struct cfvert *cf, float baro, float dt);
+static void cfvert_update_range(struct cfvert *cf, const RangefinderData *range, const float q[4]);
+static void cfvert_kf_predict(struct cfvert *cf, float z_accel, float dt);
+static void cfvert_kf_correct(struct cfvert *cf, float down, float variance);
+static void cfflow_reset(struct cfflow *cf);
+static void cfflow_predict(struct cfflow *cf, const float accel_ned[3], float dt);
+static void cfflow_update(struct cfflow *cf, const OpticalFlowData *flow, float q[4]);
 
 //! Update the INSGPS attitude estimate
 static int32_t updateAttitudeINSGPS(bool first_run, bool outdoor_mode);
@@ -266,6 +320,8 @@ int32_t AttitudeStart(void)
 	baroQueue = PIOS_Queue_Create(1, sizeof(UAVObjEvent));
 	gpsQueue = PIOS_Queue_Create(1, sizeof(UAVObjEvent));
 	gpsVelQueue = PIOS_Queue_Create(1, sizeof(UAVObjEvent));
+	rangeQueue = PIOS_Queue_Create(1, sizeof(UAVObjEvent));
+	flowQueue = PIOS_Queue_Create(1, sizeof(UAVObjEvent));
 
 	// Initialize quaternion
 	AttitudeActualData attitude;
@@ -294,6 +350,10 @@ int32_t AttitudeStart(void)
 		GPSPositionConnectQueue(gpsQueue);
 	if (GPSVelocityHandle())
 		GPSVelocityConnectQueue(gpsVelQueue);
+	if (RangefinderHandle())
+		RangefinderConnectQueue(rangeQueue);
+	if (OpticalFlowHandle())
+		OpticalFlowConnectQueue(flowQueue);
 
 	// Watchdog must be registered before starting task
 	PIOS_WDG_RegisterFlag(PIOS_WDG_ATTITUDE);
@@ -326,8 +386,9 @@ static void AttitudeTask(void *parameters)
 
 	uint16_t samp_rate = PIOS_SENSORS_GetSampleRate(PIOS_SENSOR_GYRO);
 
+	// Gyros is published once per this many samples, as clamped by sensors
 	if (samp_rate) {
-		dT_expected = 1.0f / samp_rate;
+		dT_expected = (float) sensors_get_loop_divider() / samp_rate;
 	}
 
 	// Main task loop
@@ -467,6 +528,9 @@ static void AttitudeTask(void *parameters)
 		case STATEESTIMATION_NAVIGATIONFILTER_RAW:
 			setNavigationRaw();
 			break;
+		case STATEESTIMATION_NAVIGATIONFILTER_FLOW:
+			setNavigationFlow();
+			break;
 		case STATEESTIMATION_NAVIGATIONFILTER_NONE:
 		default:
 			setNavigationNone();
@@ -573,7 +637,9 @@ static int32_t updateAttitudeComplementary(float dT, bool first_run, bool second
 
 		float baro;
 		BaroAltitudeAltitudeGet(&baro);
-		cfvert_reset(&cfvert, baro, attitudeSettings.VertPositionTau);
+		cfvert_reset(&cfvert, baro, attitudeSettings.VertPositionTau,
+				attitudeSettings.VertFilter == ATTITUDESETTINGS_VERTFILTER_KALMAN);
+		cfflow_reset(&cfflow);
 
 		return 0;
 	}
@@ -632,7 +698,9 @@ static int32_t updateAttitudeComplementary(float dT, bool first_run, bool second
 		// Reset the filter for barometric data
 		float baro;
 		BaroAltitudeAltitudeGet(&baro);
-		cfvert_reset(&cfvert, baro, attitudeSettings.VertPositionTau);
+		cfvert_reset(&cfvert, baro, attitudeSettings.VertPositionTau,
+				attitudeSettings.VertFilter == ATTITUDESETTINGS_VERTFILTER_KALMAN);
+		cfflow_reset(&cfflow);
 
 	} else if (complementary_filter_state.initialization == CF_ARMING ||
 	           complementary_filter_state.initialization == CF_INITIALIZING) {
@@ -654,7 +722,9 @@ static int32_t updateAttitudeComplementary(float dT, bool first_run, bool second
 		// Reset the filter for barometric data
 		float baro;
 		BaroAltitudeAltitudeGet(&baro);
-		cfvert_reset(&cfvert, baro, attitudeSettings.VertPositionTau);
+		cfvert_reset(&cfvert, baro, attitudeSettings.VertPositionTau,
+				attitudeSettings.VertFilter == ATTITUDESETTINGS_VERTFILTER_KALMAN);
+		cfflow_reset(&cfflow);
 	}
 
 	GyrosGet(&gyrosData);
@@ -679,20 +749,23 @@ static int32_t updateAttitudeComplementary(float dT, bool first_run, bool second
 	// Compute the error between the predicted direction of gravity and smoothed acceleration
 	CrossProduct((const float *) accels_filtered, (const float *) grot_filtered, accel_err);
 
-	float grot_mag;
+	// Squared magnitudes, so both can be divided out with one inverse
+	// square root
+	float grot_mag_sq;
 	if (complementary_filter_state.accel_filter_enabled)
-		grot_mag = sqrtf(grot_filtered[0]*grot_filtered[0] + grot_filtered[1]*grot_filtered[1] + grot_filtered[2]*grot_filtered[2]);
+		grot_mag_sq = grot_filtered[0]*grot_filtered[0] + grot_filtered[1]*grot_filtered[1] + grot_filtered[2]*grot_filtered[2];
 	else
-		grot_mag = 1.0f;
+		grot_mag_sq = 1.0f;
 
 	// Account for accel magnitude
-	float accel_mag;
-	accel_mag = accels_filtered[0]*accels_filtered[0] + accels_filtered[1]*accels_filtered[1] + accels_filtered[2]*accels_filtered[2];
-	accel_mag = sqrtf(accel_mag);
-	if (grot_mag > 1.0e-3f && accel_mag > 1.0e-3f) {
-		accel_err[0] /= (accel_mag * grot_mag);
-		accel_err[1] /= (accel_mag * grot_mag);
-		accel_err[2] /= (accel_mag * grot_mag);
+	float accel_mag_sq;
+	accel_mag_sq = accels_filtered[0]*accels_filtered[0] + accels_filtered[1]*accels_filtered[1] + accels_filtered[2]*accels_filtered[2];
+	if (grot_mag_sq > 1.0e-6f && accel_mag_sq > 1.0e-6f) {
+		float inv_mag = fast_invsqrtf(accel_mag_sq * grot_mag_sq);
+
+		accel_err[0] *= inv_mag;
+		accel_err[1] *= inv_mag;
+		accel_err[2] *= inv_mag;
 	} else {
 		accel_err[0] = 0;
 		accel_err[1] = 0;
@@ -780,12 +853,18 @@ static int32_t updateAttitudeComplementary(float dT, bool first_run, bool second
 	gyrosData.z += accel_err[2] * accKp + mag_err[2] * mgKp;
 
 	// Work out time derivative from INSAlgo writeup
-	// Also accounts for the fact that gyros are in deg/s
+	// Also accounts for the fact that gyros are in deg/s.  dT is the
+	// fixed sensor period, so scale the rates once instead of each term.
+	const float half_step = dT * DEG2RAD / 2;
+	const float gx = gyrosData.x * half_step;
+	const float gy = gyrosData.y * half_step;
+	const float gz = gyrosData.z * half_step;
+
 	float qdot[4];
-	qdot[0] = (-cf_q[1] * gyrosData.x - cf_q[2] * gyrosData.y - cf_q[3] * gyrosData.z) * dT * DEG2RAD / 2;
-	qdot[1] = (cf_q[0] * gyrosData.x - cf_q[3] * gyrosData.y + cf_q[2] * gyrosData.z) * dT * DEG2RAD / 2;
-	qdot[2] = (cf_q[3] * gyrosData.x + cf_q[0] * gyrosData.y - cf_q[1] * gyrosData.z) * dT * DEG2RAD / 2;
-	qdot[3] = (-cf_q[2] * gyrosData.x + cf_q[1] * gyrosData.y + cf_q[0] * gyrosData.z) * dT * DEG2RAD / 2;
+	qdot[0] = -cf_q[1] * gx - cf_q[2] * gy - cf_q[3] * gz;
+	qdot[1] = cf_q[0] * gx - cf_q[3] * gy + cf_q[2] * gz;
+	qdot[2] = cf_q[3] * gx + cf_q[0] * gy - cf_q[1] * gz;
+	qdot[3] = -cf_q[2] * gx + cf_q[1] * gy + cf_q[0] * gz;
 
 	// Take a time step
 	cf_q[0] = cf_q[0] + qdot[0];
@@ -801,16 +880,18 @@ static int32_t updateAttitudeComplementary(float dT, bool first_run, bool second
 	}
 
 	// Renomalize
-	float qmag;
-	qmag = sqrtf(cf_q[0]*cf_q[0] + cf_q[1]*cf_q[1] + cf_q[2]*cf_q[2] + cf_q[3]*cf_q[3]);
-	cf_q[0] = cf_q[0] / qmag;
-	cf_q[1] = cf_q[1] / qmag;
-	cf_q[2] = cf_q[2] / qmag;
-	cf_q[3] = cf_q[3] / qmag;
+	float qmag_sq;
+	qmag_sq = cf_q[0]*cf_q[0] + cf_q[1]*cf_q[1] + cf_q[2]*cf_q[2] + cf_q[3]*cf_q[3];
+
+	float inv_qmag = fast_invsqrtf(qmag_sq);
+	cf_q[0] *= inv_qmag;
+	cf_q[1] *= inv_qmag;
+	cf_q[2] *= inv_qmag;
+	cf_q[3] *= inv_qmag;
 
 	// If quaternion has become inappropriately short or has become Nan reinit.
 	// THIS SHOULD NEVER ACTUALLY HAPPEN
-	if((fabsf(qmag) < 1.0e-3f) || IS_NOT_FINITE(qmag)) {
+	if((qmag_sq < 1.0e-6f) || IS_NOT_FINITE(qmag_sq)) {
 		cf_q[0] = 1;
 		cf_q[1] = 0;
 		cf_q[2] = 0;
@@ -821,7 +902,8 @@ static int32_t updateAttitudeComplementary(float dT, bool first_run, bool second
 		static bool got_baro_pt = false;
 
 		// Calculate the NED acceleration and get the z-component
-		float z_accel = calc_ned_accel(cf_q, &accelsData.x);
+		float accel_ned[3];
+		float z_accel = calc_ned_accel(cf_q, &accelsData.x, accel_ned);
 
 		// When this is the only filter compute th vertical state from baro data
 		// Reset the filter for barometric data
@@ -840,6 +922,22 @@ static int32_t updateAttitudeComplementary(float dT, bool first_run, bool second
 		} else {
 			cfvert_predict_pos(&cfvert, z_accel, dT);
 		}
+
+		if (PIOS_Queue_Receive(rangeQueue, &ev, 0) == true) {
+			RangefinderData rangefinder;
+			RangefinderGet(&rangefinder);
+
+			cfvert_update_range(&cfvert, &rangefinder, cf_q);
+		}
+
+		cfflow_predict(&cfflow, accel_ned, dT);
+
+		if (PIOS_Queue_Receive(flowQueue, &ev, 0) == true) {
+			OpticalFlowData flow;
+			OpticalFlowGet(&flow);
+
+			cfflow_update(&cfflow, &flow, cf_q);
+		}
 	}
 
 	if (!secondary && !raw_gps) {
@@ -856,9 +954,8 @@ static int32_t updateAttitudeComplementary(float dT, bool first_run, bool second
  * by the altitude controller. Returns the down component for
  * convenience.
  */
-static float calc_ned_accel(float *q, float *accels)
+static float calc_ned_accel(float *q, float *accels, float *accel_ned)
 {
-	float accel_ned[3];
 	float Rbe[3][3];
 
 	// rotate the accels into the NED frame and remove
@@ -877,7 +974,7 @@ static float calc_ned_accel(float *q, float *accels)
 }
 
 //! Resets the vertical baro complementary filter and zeros the altitude
-static void cfvert_reset(struct cfvert *cf, float baro, float time_constant)
+static void cfvert_reset(struct cfvert *cf, float baro, float time_constant, bool kalman)
 {
 	cf->velocity_z = 0;
 	cf->position_z = 0;
@@ -887,11 +984,26 @@ static void cfvert_reset(struct cfvert *cf, float baro, float time_constant)
 	cf->position_error_z = 0;
 	cf->position_correction_z = 0;
 	cf->baro_zero = baro;
+
+	cf->kalman = kalman;
+	cf->accel_bias_z = 0;
+	cf->p00 = VERT_KF_BARO_VAR;
+	cf->p01 = 0;
+	cf->p02 = 0;
+	cf->p11 = 1;
+	cf->p12 = 0;
+	cf->p22 = 0.25f;
+	cf->ground_valid = false;
 }
 
 //! Predict the position in the future
 static void cfvert_predict_pos(struct cfvert *cf, float z_accel, float dt)
 {
+	if (cf->kalman) {
+		cfvert_kf_predict(cf, z_accel, dt);
+		return;
+	}
+
 	float k1_z = 3 / cf->time_constant_z;
 	float k2_z = 3 / powf(cf->time_constant_z, 2);
 	float k3_z = 1 / powf(cf->time_constant_z, 3);
@@ -912,12 +1024,109 @@ static void cfvert_update_baro(struct cfvert *cf, float baro, float dt)
 {
 	float down = -(baro - cf->baro_zero);
 
+	if (cf->kalman) {
+		cfvert_kf_correct(cf, down, VERT_KF_BARO_VAR);
+		return;
+	}
+
 	// TODO: get from a queue of previous position updates (150 ms latency)
 	float hist_position_base_d = cf->position_base_z;
 
 	cf->position_error_z = down - (hist_position_base_d + cf->position_correction_z);
 }
 
+/**
+ * Update the height above the ground from the rangefinder.  When it first
+ * sees the ground, the ground's position is taken from the current
+ * estimate, so there's no step; after that each reading is a position
+ * measurement relative to it.
+ */
+static void cfvert_update_range(struct cfvert *cf, const RangefinderData *range, const float q[4])
+{
+	if (!cf->kalman)
+		return;
+
+	if (range->RangingStatus != RANGEFINDER_RANGINGSTATUS_INRANGE) {
+		cf->ground_valid = false;
+		return;
+	}
+
+	// The down component of the body z axis
+	float cos_tilt = q[0] * q[0] - q[1] * q[1] - q[2] * q[2] + q[3] * q[3];
+
+	if (cos_tilt < VERT_KF_MIN_COS_TILT)
+		return;
+
+	float height = range->Range * cos_tilt;
+
+	if (!cf->ground_valid) {
+		cf->ground_z = cf->position_z + height;
+		cf->ground_valid = true;
+		return;
+	}
+
+	cfvert_kf_correct(cf, cf->ground_z - height, VERT_KF_RANGE_VAR);
+}
+
+/**
+ * Kalman prediction of position, velocity and accel bias.  The covariance
+ * update F P F' + Q is written out for this F, so that no matrix code is
+ * needed.
+ */
+static void cfvert_kf_predict(struct cfvert *cf, float z_accel, float dt)
+{
+	float accel = z_accel - cf->accel_bias_z;
+	float h = 0.5f * dt * dt;
+
+	cf->position_z += cf->velocity_z * dt + accel * h;
+	cf->velocity_z += accel * dt;
+
+	// F = [1 dt -h; 0 1 -dt; 0 0 1], so first the rows of F P
+	float a0 = cf->p00 + dt * cf->p01 - h * cf->p02;
+	float a1 = cf->p01 + dt * cf->p11 - h * cf->p12;
+	float a2 = cf->p02 + dt * cf->p12 - h * cf->p22;
+	float b1 = cf->p11 - dt * cf->p12;
+	float b2 = cf->p12 - dt * cf->p22;
+
+	// Accel noise enters as a velocity step of accel * dt
+	float q_v = VERT_KF_ACCEL_VAR * dt * dt;
+
+	cf->p00 = a0 + dt * a1 - h * a2 + q_v * 0.25f * dt * dt;
+	cf->p01 = a1 - dt * a2 + q_v * 0.5f * dt;
+	cf->p02 = a2;
+	cf->p11 = b1 - dt * b2 + q_v;
+	cf->p12 = b2;
+	cf->p22 += VERT_KF_BIAS_VAR * dt;
+}
+
+//! Kalman correction with a measurement of the down position
+static void cfvert_kf_correct(struct cfvert *cf, float down, float variance)
+{
+	float inv_s = 1.0f / (cf->p00 + variance);
+
+	float k0 = cf->p00 * inv_s;
+	float k1 = cf->p01 * inv_s;
+	float k2 = cf->p02 * inv_s;
+
+	float err = down - cf->position_z;
+
+	cf->position_z += k0 * err;
+	cf->velocity_z += k1 * err;
+	cf->accel_bias_z += k2 * err;
+
+	// P -= K H P, with H = [1 0 0]
+	cf->p22 -= k2 * cf->p02;
+	cf->p12 -= k1 * cf->p02;
+	cf->p11 -= k1 * cf->p01;
+	cf->p02 -= k0 * cf->p02;
+	cf->p01 -= k0 * cf->p01;
+	cf->p00 -= k0 * cf->p00;
+
+	if (IS_NOT_FINITE(cf->position_z) || IS_NOT_FINITE(cf->p00)) {
+		cfvert_reset(cf, cf->baro_zero, cf->time_constant_z, true);
+	}
+}
+
 //! Set the navigation information to the raw estimates
 static int32_t setNavigationRaw()
 {
@@ -982,6 +1191,97 @@ static int32_t setNavigationNone()
 	return 0;
 }
 
+/**
+ * Set the navigation information to the optical flow estimate, and the
+ * vertical filter for down.  Without flow only down is set.
+ */
+static int32_t setNavigationFlow()
+{
+	if (!cfflow.valid)
+		return setNavigationNone();
+
+	PositionActualData positionActual;
+	positionActual.North = cfflow.position[0];
+	positionActual.East = cfflow.position[1];
+	positionActual.Down = cfvert.position_z;
+	PositionActualSet(&positionActual);
+
+	VelocityActualData velocityActual;
+	velocityActual.North = cfflow.velocity[0];
+	velocityActual.East = cfflow.velocity[1];
+	velocityActual.Down = cfvert.velocity_z;
+	VelocityActualSet(&velocityActual);
+
+	return 0;
+}
+
+//! Zero the flow position, around wherever the craft is now
+static void cfflow_reset(struct cfflow *cf)
+{
+	cf->position[0] = 0;
+	cf->position[1] = 0;
+	cf->velocity[0] = 0;
+	cf->velocity[1] = 0;
+	cf->valid = false;
+}
+
+//! Carry the horizontal estimate forward on the NED accels, between flow samples
+static void cfflow_predict(struct cfflow *cf, const float accel_ned[3], float dt)
+{
+	if (!cf->valid)
+		return;
+
+	if (PIOS_Thread_Period_Elapsed(cf->last_sample, FLOW_TIMEOUT_MS)) {
+		// Hold position rather than let the accels run away with it
+		cf->velocity[0] = 0;
+		cf->velocity[1] = 0;
+		cf->valid = false;
+		return;
+	}
+
+	for (int i = 0; i < 2; i++) {
+		cf->position[i] += (cf->velocity[i] + 0.5f * accel_ned[i] * dt) * dt;
+		cf->velocity[i] += accel_ned[i] * dt;
+	}
+}
+
+/**
+ * Pull the velocity towards one flow sample, weighted by its quality.  The
+ * PX4Flow has already taken the rotation out with its own gyro and scaled
+ * the flow by its sonar, so the sample is the body frame ground speed; the
+ * current attitude turns it into north and east.
+ */
+static void cfflow_update(struct cfflow *cf, const OpticalFlowData *flow, float q[4])
+{
+	uint8_t min_quality;
+	OpticalFlowSettingsQualityGet(&min_quality);
+
+	if (flow->Quality == 0 || flow->Quality < min_quality)
+		return;
+
+	float Rbe[3][3];
+	Quaternion2R(q, Rbe);
+
+	// Only the first two rows of R' times [x, y, 0] are needed
+	float flow_ned[2] = {
+		Rbe[0][0] * flow->x + Rbe[1][0] * flow->y,
+		Rbe[0][1] * flow->x + Rbe[1][1] * flow->y,
+	};
+
+	float gain = FLOW_VELOCITY_GAIN * flow->Quality / 255.0f;
+
+	if (!cf->valid) {
+		cf->velocity[0] = flow_ned[0];
+		cf->velocity[1] = flow_ned[1];
+		cf->valid = true;
+	} else {
+		cf->velocity[0] += gain * (flow_ned[0] - cf->velocity[0]);
+		cf->velocity[1] += gain * (flow_ned[1] - cf->velocity[1]);
+	}
+
+	cf->last_sample = PIOS_Thread_Systime();
+}
+
 /**
  * Set the @ref AttitudeActual UAVO to the complementary filter
  * estimate
@@ -990,7 +1290,7 @@ static int32_t setAttitudeComplementary()
 {
 	AttitudeActualData attitude;
 	quat_copy(cf_q, &attitude.q1);
-	Quaternion2RPY(&attitude.q1,&attitude.Roll);
+	Quaternion2RPYApprox(&attitude.q1,&attitude.Roll);
 	AttitudeActualSet(&attitude);
 
 	return 0;
@@ -1086,6 +1386,9 @@ static int32_t updateAttitudeINSGPS(bool first_run, bool outdoor_mode)
 	static uint32_t ins_last_time = 0;
 	static uint32_t ins_init_time = 0;
 
+	// Time the covariance estimate is behind the state estimate
+	static float cov_dT;
+
 	static enum {INS_INIT, INS_WARMUP, INS_RUNNING} ins_state;
 
 	float NED[3] = {0.0f, 0.0f, 0.0f};
@@ -1109,6 +1412,7 @@ static int32_t updateAttitudeINSGPS(bool first_run, bool outdoor_mode)
 		home_location_updated = false;
 
 		ins_last_time = PIOS_DELAY_GetRaw();
+		cov_dT = 0;
 
 		return 0;
 	}
@@ -1298,15 +1602,30 @@ static int32_t updateAttitudeINSGPS(bool first_run, bool outdoor_mode)
 	// Advance the state estimate
 	INSStatePrediction(gyros, &accelsData.x, dT);
 
-	// Advance the covariance estimate
-	INSCovariancePrediction(dT);
+	cov_dT += dT;
+
+	// Fuse one group of sensors per cycle, so that GPS, mag and baro
+	// arriving together don't add up into one long iteration.  Whatever
+	// is left over stays pending and is fused on the following cycles.
+	bool fuse_gps = gps_updated || gps_vel_updated;
+	float gps_delay = 0;
+
+	if (fuse_gps) {
+		// The solution is older than it looks by however long it sat
+		// between arriving and getting here, when the GPS reports that
+		uint32_t rx_time = gps_updated ?
+			gpsData.ReceivedTime : gpsVelData.ReceivedTime;
+
+		gps_delay = insSettings.GpsDelay * 0.001f;
+
+		if (rx_time)
+			gps_delay += (PIOS_Thread_Systime() - rx_time) * 0.001f;
+	}
 
-	if(mag_updated) {
+	if (mag_updated && !fuse_gps) {
 		sensors |= MAG_SENSORS;
 		mag_updated = false;
-	}
-	
-	if(baro_updated) {
+	} else if (baro_updated && !fuse_gps) {
 		sensors |= BARO_SENSOR;
 		baro_updated = false;
 	}
@@ -1367,7 +1686,7 @@ static int32_t updateAttitudeINSGPS(bool first_run, bool outdoor_mode)
 
 	// Update fake position at 10 hz
 	static uint32_t indoor_pos_time;
-	if (!outdoor_mode && PIOS_DELAY_DiffuS(indoor_pos_time) > 100000) {
+	if (!outdoor_mode && !sensors && PIOS_DELAY_DiffuS(indoor_pos_time) > 100000) {
 		sensors |= HORIZ_VEL_SENSORS | HORIZ_POS_SENSORS;
 
 		indoor_pos_time = PIOS_DELAY_GetRaw();
@@ -1380,8 +1699,18 @@ static int32_t updateAttitudeINSGPS(bool first_run, bool outdoor_mode)
 	 * TODO: Need to add a general sanity check for all the inputs to make sure their kosher
 	 * although probably should occur within INS itself
 	 */
-	if (sensors)
+	// Advance the covariance estimate, at the configured rate but always
+	// before it is used for a correction.
+	if (sensors || insSettings.CovariancePredictRate == 0 ||
+			cov_dT * insSettings.CovariancePredictRate >= 1.0f) {
+		INSCovariancePrediction(cov_dT);
+		cov_dT = 0;
+	}
+
+	if (sensors) {
+		INSSetPosVelDelay(gps_delay);
 		INSCorrection(&magData.x, NED, vel, ( baroData.Altitude + baro_offset ), sensors);
+	}
 
 	// Export the state and variance for monitoring the EKF
 	INSStateData state;
@@ -1393,7 +1722,8 @@ static int32_t updateAttitudeINSGPS(bool first_run, bool outdoor_mode)
 		INSSetGyroBias(zeros);
 
 	float accel_bias_corrected[3] = {accelsData.x - state.State[13], accelsData.y - state.State[14], accelsData.z - state.State[15]};
-	calc_ned_accel(&state.State[6], accel_bias_corrected);
+	float accel_ned[3];
+	calc_ned_accel(&state.State[6], accel_bias_corrected, accel_ned);
 
 	return 0;
 }
@@ -1405,7 +1735,7 @@ static int32_t setAttitudeINSGPS()
 	AttitudeActualData attitude;
 
 	INSGetState(NULL, NULL, &attitude.q1, gyro_bias, NULL);
-	Quaternion2RPY(&attitude.q1,&attitude.Roll);
+	Quaternion2RPYApprox(&attitude.q1,&attitude.Roll);
 	AttitudeActualSet(&attitude);
 
 	if (insSettings.ComputeGyroBias == INSSETTINGS_COMPUTEGYROBIAS_TRUE && 
@@ -1552,7 +1882,7 @@ static void check_home_location()
 		float LLA[3] = { homeLocation.Latitude / 10e6f, homeLocation.Longitude / 10e6f, homeLocation.Altitude };
 
 		// Compute magnetic flux direction at home location
-		if (WMM_GetMagVector(LLA[0], LLA[1], LLA[2], gpsTime.Month, gpsTime.Day, gpsTime.Year, &homeLocation.Be[0]) >= 0)
+		if (WMM_GetMagVectorCached(LLA[0], LLA[1], LLA[2], gpsTime.Month, gpsTime.Day, gpsTime.Year, &homeLocation.Be[0]) >= 0)
 		{   // calculations appeared to go OK
 
 			// Compute local acceleration due to gravity.  Vehicles that span a very large
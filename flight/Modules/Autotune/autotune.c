@@ -45,7 +45,9 @@
 #include "actuatordesired.h"
 #include "stabilizationdesired.h"
 #include "stabilizationsettings.h"
+#include "sensorsettings.h"
 #include "systemident.h"
+#include "systemidentstate.h"
 #include <pios_board_info.h>
 #include <eventdispatcher.h>
 #include "systemsettings.h"
@@ -80,6 +82,44 @@ struct at_measurement {
 
 static struct at_measurement *at_averages;
 
+/* Streaming identification.  Each axis is fit online to the first order
+ * model the wizard uses,
+ *
+ *   d[n] = a * d[n-1] + b * u[n-1] + c
+ *
+ * where d is the change in gyro rate over one sample and u the actuator
+ * desired, by recursive least squares with a forgetting factor.  It needs
+ * a few floats per axis instead of the capture buffer, so it runs even on
+ * boards that can't spare the buffer (or are built with
+ * AUTOTUNE_STREAMING_ONLY), and isn't limited to one wiggle period.
+ */
+#define AT_RLS_N 3
+#define AT_RLS_MEMORY_S 4.0f	/* Time constant of the forgetting */
+#define AT_RLS_P0 100.0f	/* Initial covariance; small priors */
+
+struct at_rls {
+	float theta[AT_RLS_N];
+	float P[AT_RLS_N][AT_RLS_N];
+	float noise_sq;		/* Mean square residual, forgotten alike */
+
+	float last_gyro;
+	float last_d;
+	float last_u;
+	uint8_t primed;
+};
+
+struct at_estimate {
+	float tau;
+	float beta;
+	float beta_sd;
+	float bias;
+	float noise;
+};
+
+static struct at_rls at_rls[3];
+static float at_rls_dT;
+static float at_rls_lambda;
+
 // Private variables
 static bool module_enabled;
 
@@ -144,6 +184,123 @@ int32_t AutotuneStart(void)
 
 MODULE_INITCALL(AutotuneInitialize, AutotuneStart)
 
+static void at_rls_reset(struct at_rls *rls)
+{
+	*rls = (struct at_rls) { { 0 } };
+
+	for (int i = 0; i < AT_RLS_N; i++) {
+		rls->P[i][i] = AT_RLS_P0;
+	}
+}
+
+static void at_rls_update(struct at_rls *rls, float gyro, float u)
+{
+	float d = gyro - rls->last_gyro;
+	float x[AT_RLS_N] = { rls->last_d, rls->last_u, 1.0f };
+
+	rls->last_gyro = gyro;
+	rls->last_d = d;
+	rls->last_u = u;
+
+	/* The first two samples only fill in the history */
+	if (rls->primed < 2) {
+		rls->primed++;
+		return;
+	}
+
+	float Px[AT_RLS_N];
+	float denom = at_rls_lambda;
+	float err = d;
+
+	for (int i = 0; i < AT_RLS_N; i++) {
+		Px[i] = 0;
+
+		for (int j = 0; j < AT_RLS_N; j++) {
+			Px[i] += rls->P[i][j] * x[j];
+		}
+
+		denom += x[i] * Px[i];
+		err -= rls->theta[i] * x[i];
+	}
+
+	rls->noise_sq = at_rls_lambda * rls->noise_sq +
+		(1 - at_rls_lambda) * err * err;
+
+	for (int i = 0; i < AT_RLS_N; i++) {
+		rls->theta[i] += Px[i] / denom * err;
+	}
+
+	/* P is symmetric, so P x x' P is just Px Px'; updating one triangle
+	 * and mirroring it keeps rounding from skewing it. */
+	for (int i = 0; i < AT_RLS_N; i++) {
+		for (int j = i; j < AT_RLS_N; j++) {
+			rls->P[i][j] = (rls->P[i][j] - Px[i] * Px[j] / denom) /
+				at_rls_lambda;
+			rls->P[j][i] = rls->P[i][j];
+		}
+	}
+}
+
+/**
+ * Converts a fit into the wizard's terms.
+ * \return false if the fit isn't (yet) a stable, positive response
+ */
+static bool at_rls_estimate(const struct at_rls *rls, struct at_estimate *est)
+{
+	float a = rls->theta[0];
+	float b = rls->theta[1];
+	float c = rls->theta[2];
+
+	if (!(a > 0 && a < 1) || !(b > 0)) {
+		return false;
+	}
+
+	float scale = 1 / ((1 - a) * at_rls_dT);
+
+	est->tau = -at_rls_dT / logf(a);
+	est->beta = logf(b * scale);
+	est->bias = c * scale;
+	est->noise = sqrtf(rls->noise_sq);
+
+	/* Linearized: dbeta = da / (1 - a) + db / b */
+	float g[AT_RLS_N] = { 1 / (1 - a), 1 / b, 0 };
+	float var = 0;
+
+	for (int i = 0; i < AT_RLS_N; i++) {
+		for (int j = 0; j < AT_RLS_N; j++) {
+			var += g[i] * rls->P[i][j] * g[j];
+		}
+	}
+
+	est->beta_sd = sqrtf(rls->noise_sq * var);
+
+	return true;
+}
+
+static void at_publish_estimates()
+{
+	SystemIdentStateData ident_state = {
+		.Samples = update_counter,
+	};
+
+	for (int axis = 0; axis < 3; axis++) {
+		struct at_rls rls = at_rls[axis];
+		struct at_estimate est;
+
+		if (!at_rls_estimate(&rls, &est)) {
+			continue;
+		}
+
+		ident_state.Tau[axis] = est.tau;
+		ident_state.Beta[axis] = est.beta;
+		ident_state.BetaStdDev[axis] = est.beta_sd;
+		ident_state.Bias[axis] = est.bias;
+		ident_state.Noise[axis] = est.noise;
+	}
+
+	SystemIdentStateSet(&ident_state);
+}
+
 static void at_new_actuators(const UAVObjEvent *ev,
 		void *ctx, void *obj, int len) {
 	(void) ev; (void) ctx;
@@ -173,6 +330,10 @@ static void at_new_actuators(const UAVObjEvent *ev,
 			if (!tune_running) {
 				update_counter = 0;
 				throttle_accumulator = 0;
+
+				for (int i = 0; i < 3; i++) {
+					at_rls_reset(&at_rls[i]);
+				}
 			}
 
 			tune_running = true;
@@ -180,19 +341,25 @@ static void at_new_actuators(const UAVObjEvent *ev,
 		}
 	}
 
-	struct at_measurement *avg_point = &at_averages[actuators.SystemIdentCycle / AUTOTUNE_AVERAGING_DECIMATION];
+	at_rls_update(&at_rls[0], g.x, actuators.Roll);
+	at_rls_update(&at_rls[1], g.y, actuators.Pitch);
+	at_rls_update(&at_rls[2], g.z, actuators.Yaw);
 
-	if (first_cycle) {
-		*avg_point = (struct at_measurement) { { 0 } };
-	}
+	if (at_averages) {
+		struct at_measurement *avg_point = &at_averages[actuators.SystemIdentCycle / AUTOTUNE_AVERAGING_DECIMATION];
+
+		if (first_cycle) {
+			*avg_point = (struct at_measurement) { { 0 } };
+		}
 
-	avg_point->y[0] += g.x;
-	avg_point->y[1] += g.y;
-	avg_point->y[2] += g.z;
+		avg_point->y[0] += g.x;
+		avg_point->y[1] += g.y;
+		avg_point->y[2] += g.z;
 
-	avg_point->u[0] += actuators.Roll;
-	avg_point->u[1] += actuators.Pitch;
-	avg_point->u[2] += actuators.Yaw;
+		avg_point->u[0] += actuators.Roll;
+		avg_point->u[1] += actuators.Pitch;
+		avg_point->u[2] += actuators.Yaw;
+	}
 
 	update_counter++;
 	throttle_accumulator += 10000 * actuators.Thrust;
@@ -202,6 +369,8 @@ static void UpdateSystemIdent(uint32_t predicts, float hover_throttle,
 		bool new_tune) {
 	SystemIdentData system_ident;
 
+	SystemIdentGet(&system_ident);
+
 	system_ident.NewTune = new_tune;
 	system_ident.NumAfPredicts = predicts;
 
@@ -275,36 +444,46 @@ static void autotune_step(const UAVObjEvent *ev,
 		decim_wiggle_points =
 			ident_wiggle_points / AUTOTUNE_AVERAGING_DECIMATION;
 
+#ifndef AUTOTUNE_STREAMING_ONLY
 		uint16_t buf_size = sizeof(*at_averages) * decim_wiggle_points;
 		at_averages = PIOS_malloc(buf_size);
+#endif
+
+		uint16_t samp_rate = PIOS_SENSORS_GetSampleRate(PIOS_SENSOR_GYRO);
+
+		// One ActuatorDesired update per loop_divider gyro samples
+		uint8_t loop_divider;
+		SensorSettingsLoopDividerGet(&loop_divider);
+
+		at_rls_dT = samp_rate ?
+			((float) MAX(loop_divider, 1) / samp_rate) : 0.001f;
+		at_rls_lambda = 1 - at_rls_dT / AT_RLS_MEMORY_S;
 
-		if (at_averages) {
+		/* Without the buffer there is nothing for the wizard to
+		 * download, but the streaming estimates still work. */
+		if (SystemIdentStateInitialize() == 0) {
 			ActuatorDesiredConnectCallback(at_new_actuators);
 			PIOS_Modules_Enable(PIOS_MODULE_AUTOTUNE);
 		}
 	}
 
-	if (!at_averages) {
-		/* Do nothing because we couldn't get our buffer */
-		/* Assert alarm XXX? */
-		return;
-	}
-
 	uint8_t armed;
 
 	FlightStatusArmedGet(&armed);
 
 	if (save_needed) {
 		if (armed == FLIGHTSTATUS_ARMED_DISARMED) {
-			if (autotune_save_averaging()) {
+			if (at_averages && autotune_save_averaging()) {
 				// Try again next time, I guess.
 				return;
 			}
 
 			float hover_throttle = ((float) (throttle_accumulator / update_counter)) / 10000.0f;
 
+			/* Only tell the GCS about a new tune when there's a
+			 * capture for it to process */
 			UpdateSystemIdent(update_counter, hover_throttle,
-					true);
+					at_averages != NULL);
 
 			// Save the UAVO locally.
 			UAVObjSave(SystemIdentHandle(), 0);
@@ -335,6 +514,8 @@ static void autotune_step(const UAVObjEvent *ev,
 			UpdateSystemIdent(update_counter, hover_throttle,
 					false);
 
+			at_publish_estimates();
+
 			if (!tune_running) {
 				/* Threshold: 24 seconds of data @ 500Hz */
 				if (update_counter > 12000) {
@@ -39,35 +39,77 @@
 #include "flightbatterysettings.h"
 #include "modulesettings.h"
 #include "pios_thread.h"
+#include "deferredwork.h"
+#include "misc_math.h"
 
 // ****************
 // Private constants
-#define STACK_SIZE_BYTES            624
-#define TASK_PRIORITY               PIOS_THREAD_PRIO_LOW
 #define SAMPLE_PERIOD_MS            250
+
+// Battery model
+#define MODEL_FORGET                0.995f	// per sample, so about a minute remembered
+#define MODEL_OCV_VAR_MAX           100.0f	// V^2
+#define MODEL_R_VAR_MAX             1.0f	// Ohm^2
+#define MODEL_R_VAR_VALID           1e-3f	// once the current has varied this much
+#define REST_CURRENT                1.0f	// A; below this the voltage is the resting voltage
+#define SEED_MAX_CHARGE             0.9f	// packs fuller than this are taken to be full
+#define CHARGE_CORRECTION_TAU       300.0f	// s; how slowly the voltage corrects the mAh count
+
 // Private types
 
+//! Voltage as a linear function of current, V = OCV - I R, fit by recursive least squares
+struct battery_model {
+	float ocv;
+	float r;
+	float p[2][2];
+	bool initialized;
+};
+
 // Private variables
 static bool module_enabled = false;
-static struct pios_thread *batteryTaskHandle;
+static struct deferred_work *batteryWork;
 static int8_t voltageADCPin = -1; //ADC pin for voltage
 static int8_t currentADCPin = -1; //ADC pin for current
 static bool battery_settings_updated;
 
 static float avg_current_lpf_for_time;
+static struct battery_model model;
+
+static bool cells_calculated;
+static int cells_holddown;
+static unsigned cells = 1;
+static bool charge_seeded;
+
+static FlightBatteryStateData flightBatteryData;
+static FlightBatterySettingsData batterySettings;
+
+//! Resting lithium polymer cell voltage at each 5% of charge
+static const float lipo_cell_ocv[] = {
+	3.27f, 3.61f, 3.69f, 3.71f, 3.73f, 3.75f, 3.77f, 3.79f, 3.80f, 3.82f,
+	3.84f, 3.85f, 3.87f, 3.91f, 3.95f, 3.98f, 4.02f, 4.08f, 4.11f, 4.15f,
+	4.20f
+};
 
 // ****************
 // Private functions
-static void batteryTask(void * parameters);
+static int32_t batteryUpdate(void *ctx);
+static void model_update(float voltage, float current);
+static float charge_from_cell_voltage(float cell_voltage);
 
 static int32_t BatteryStart(void)
 {
 	if (module_enabled) {
+		battery_settings_updated = true;
 		FlightBatterySettingsConnectCallbackCtx(UAVObjCbSetFlag, &battery_settings_updated);
 
-		// Start tasks
-		batteryTaskHandle = PIOS_Thread_Create(batteryTask, "batteryBridge", STACK_SIZE_BYTES, NULL, TASK_PRIORITY);
-		TaskMonitorAdd(TASKINFO_RUNNING_BATTERY, batteryTaskHandle);
+		FlightBatteryStateGet(&flightBatteryData);
+
+		// Sampled from the shared low priority worker
+		batteryWork = deferred_work_create(DEFERRED_WORK_LOW, batteryUpdate, NULL);
+		if (batteryWork == NULL)
+			return -1;
+
+		deferred_work_schedule(batteryWork, SAMPLE_PERIOD_MS);
 		return 0;
 	}
 	return -1;
@@ -104,175 +146,279 @@ int32_t BatteryInitialize(void)
 MODULE_INITCALL(BatteryInitialize, BatteryStart)
 
 /**
- * Main task. It does not return.
+ * Takes a sample and updates the battery state
+ * \returns The time until the next sample
  */
-static void batteryTask(void * parameters)
+static int32_t batteryUpdate(void *ctx)
 {
 	const float dT = SAMPLE_PERIOD_MS / 1000.0f;
 
-	battery_settings_updated = true;
-	bool cells_calculated = false;
-	int cells_holddown = 0;
-	unsigned cells = 1;
+	float energyRemaining;
 
-	FlightBatteryStateData flightBatteryData;
-	FlightBatterySettingsData batterySettings;
+	if (battery_settings_updated) {
+		battery_settings_updated = false;
+		FlightBatterySettingsGet(&batterySettings);
 
-	FlightBatteryStateGet(&flightBatteryData);
+		voltageADCPin = batterySettings.VoltagePin;
+		if (voltageADCPin == FLIGHTBATTERYSETTINGS_VOLTAGEPIN_NONE)
+			voltageADCPin = -1;
 
-	// Main task loop
-	uint32_t lastSysTime;
-	lastSysTime = PIOS_Thread_Systime();
-	while (true) {
-		PIOS_Thread_Sleep_Until(&lastSysTime, SAMPLE_PERIOD_MS);
-		float energyRemaining;
+		currentADCPin = batterySettings.CurrentPin;
+		if (currentADCPin == FLIGHTBATTERYSETTINGS_CURRENTPIN_NONE)
+			currentADCPin = -1;
 
-		if (battery_settings_updated) {
-			battery_settings_updated = false;
-			FlightBatterySettingsGet(&batterySettings);
+		cells_calculated = false;
+		model.initialized = false;
+	}
 
-			voltageADCPin = batterySettings.VoltagePin;
-			if (voltageADCPin == FLIGHTBATTERYSETTINGS_VOLTAGEPIN_NONE)
-				voltageADCPin = -1;
+	bool adc_pin_invalid = false;
+	bool adc_offset_invalid = false;
+
+	// handle voltage
+	if (voltageADCPin >= 0) {
+		float adc_voltage = (float)PIOS_ADC_GetChannelVolt(voltageADCPin);
+		float scaled_voltage = 0.0f;
+
+		// A negative result indicates an error (PIOS_ADC_GetChannelVolt returns negative on error)
+		if(adc_voltage < 0.0f)
+			adc_pin_invalid = true;
+		else {
+			// scale to actual voltage
+			scaled_voltage = (adc_voltage * 1000.0f
+					/ batterySettings.SensorCalibrationFactor[FLIGHTBATTERYSETTINGS_SENSORCALIBRATIONFACTOR_VOLTAGE])
+					+ batterySettings.SensorCalibrationOffset[FLIGHTBATTERYSETTINGS_SENSORCALIBRATIONOFFSET_VOLTAGE]; //in Volts
+
+			// disallow negative values as these are cast to unsigned integral types
+			// in some telemetry layers
+			if (scaled_voltage < 0.0f) {
+				scaled_voltage = 0.0f;
+				adc_offset_invalid = true;
+			} else if (batterySettings.MaxCellVoltage > 0.0f && scaled_voltage > 2.5f) {
+				if (!cells_calculated) {
+					cells = ((scaled_voltage / batterySettings.MaxCellVoltage) + 0.9f);
+					if (cells > 0) {
+						cells_holddown++;
+					} else {
+						cells_holddown = 0;
+					}
 
-			currentADCPin = batterySettings.CurrentPin;
-			if (currentADCPin == FLIGHTBATTERYSETTINGS_CURRENTPIN_NONE)
-				currentADCPin = -1;
+					if (cells_holddown >= (1000 / SAMPLE_PERIOD_MS)) {
+						cells_calculated = true;
+						flightBatteryData.DetectedCellCount = cells;
+					}
+				}
+			} else {
+				cells_calculated = false;
+			}
 
-			cells_calculated = false;
+			if (!cells_calculated) {
+				cells = batterySettings.NbCells;
+				flightBatteryData.DetectedCellCount = 0;
+			}
 		}
 
-		bool adc_pin_invalid = false;
-		bool adc_offset_invalid = false;
-
-		// handle voltage
-		if (voltageADCPin >= 0) {
-			float adc_voltage = (float)PIOS_ADC_GetChannelVolt(voltageADCPin);
-			float scaled_voltage = 0.0f;
-
-			// A negative result indicates an error (PIOS_ADC_GetChannelVolt returns negative on error)
-			if(adc_voltage < 0.0f)
-				adc_pin_invalid = true;
-			else {
-				// scale to actual voltage
-				scaled_voltage = (adc_voltage * 1000.0f
-						/ batterySettings.SensorCalibrationFactor[FLIGHTBATTERYSETTINGS_SENSORCALIBRATIONFACTOR_VOLTAGE])
-						+ batterySettings.SensorCalibrationOffset[FLIGHTBATTERYSETTINGS_SENSORCALIBRATIONOFFSET_VOLTAGE]; //in Volts
-
-				// disallow negative values as these are cast to unsigned integral types
-				// in some telemetry layers
-				if (scaled_voltage < 0.0f) {
-					scaled_voltage = 0.0f;
-					adc_offset_invalid = true;
-				} else if (batterySettings.MaxCellVoltage > 0.0f && scaled_voltage > 2.5f) {
-					if (!cells_calculated) {
-						cells = ((scaled_voltage / batterySettings.MaxCellVoltage) + 0.9f);
-						if (cells > 0) {
-							cells_holddown++;
-						} else {
-							cells_holddown = 0;
-						}
-
-						if (cells_holddown >= (1000 / SAMPLE_PERIOD_MS)) {
-							cells_calculated = true;
-							flightBatteryData.DetectedCellCount = cells;
-						}
-					}
-				} else {
-					cells_calculated = false;
-				}
+		flightBatteryData.Voltage = scaled_voltage;
 
-				if (!cells_calculated) {
-					cells = batterySettings.NbCells;
-					flightBatteryData.DetectedCellCount = 0;
-				}
+		// generate alarms and warnings
+		if (flightBatteryData.Voltage < (batterySettings.CellVoltageThresholds[FLIGHTBATTERYSETTINGS_CELLVOLTAGETHRESHOLDS_ALARM] * cells))
+			AlarmsSet(SYSTEMALARMS_ALARM_BATTERY, SYSTEMALARMS_ALARM_CRITICAL);
+		else if (flightBatteryData.Voltage < (batterySettings.CellVoltageThresholds[FLIGHTBATTERYSETTINGS_CELLVOLTAGETHRESHOLDS_WARNING] * cells))
+			AlarmsSet(SYSTEMALARMS_ALARM_BATTERY, SYSTEMALARMS_ALARM_WARNING);
+		else
+			AlarmsClear(SYSTEMALARMS_ALARM_BATTERY);
+	} else {
+		flightBatteryData.Voltage = 0;
+	}
+
+	// handle current
+	if (currentADCPin >= 0) {
+		float adc_voltage = (float)PIOS_ADC_GetChannelVolt(currentADCPin);
+		float scaled_current = 0.0f;
+
+		// A negative result indicates an error (PIOS_ADC_GetChannelVolt returns -1 on error)
+		if(adc_voltage < 0.0f)
+			adc_pin_invalid = true;
+		else {
+			// scale to actual current
+			scaled_current = (adc_voltage * 1000.0f
+					/ batterySettings.SensorCalibrationFactor[FLIGHTBATTERYSETTINGS_SENSORCALIBRATIONFACTOR_CURRENT])
+					+ batterySettings.SensorCalibrationOffset[FLIGHTBATTERYSETTINGS_SENSORCALIBRATIONOFFSET_CURRENT]; //in Amps
+
+			// disallow negative values as these are cast to unsigned integral types
+			// in some telemetry layers
+			if(scaled_current < 0.0f) {
+				scaled_current = 0.0f;
+				adc_offset_invalid = true;
 			}
+		}
+
+		flightBatteryData.Current = scaled_current;
+
+		if (flightBatteryData.Current > flightBatteryData.PeakCurrent)
+			flightBatteryData.PeakCurrent = flightBatteryData.Current; //in Amps
+
+		flightBatteryData.ConsumedEnergy += (flightBatteryData.Current * dT * 1000.0f / 3600.0f); //in mAh
+
+		//Apply a 2 second rise time low-pass filter to average the current
+		float alpha = 1.0f - dT / (dT + 2.0f);
+		flightBatteryData.AvgCurrent = alpha * flightBatteryData.AvgCurrent + (1 - alpha) * flightBatteryData.Current; //in Amps
+
+		// XXX Arguably this should be to 10% capacity or 15%
+		energyRemaining = batterySettings.Capacity - flightBatteryData.ConsumedEnergy; // in mAh
+
+		// And for time estimation, smooth things much more.
+		// Second order since it incorporates the above
+		// smoothing, 12s time constant for this layer.
+		alpha = 1.0f - dT / (dT + 12.0f);
+
+		avg_current_lpf_for_time = avg_current_lpf_for_time * alpha + (1 - alpha) * flightBatteryData.AvgCurrent;
+
+		if (avg_current_lpf_for_time > 0.1f)
+			flightBatteryData.EstimatedFlightTime = (energyRemaining / (avg_current_lpf_for_time * 1000.0f)) * 3600.0f; //in Sec
+		else
+			flightBatteryData.EstimatedFlightTime = 9999;
+
+		// generate alarms and warnings
+		if ((batterySettings.FlightTimeThresholds[FLIGHTBATTERYSETTINGS_FLIGHTTIMETHRESHOLDS_ALARM] > 0)
+			&& (flightBatteryData.EstimatedFlightTime < batterySettings.FlightTimeThresholds[FLIGHTBATTERYSETTINGS_FLIGHTTIMETHRESHOLDS_ALARM]))
+			AlarmsSet(SYSTEMALARMS_ALARM_FLIGHTTIME, SYSTEMALARMS_ALARM_CRITICAL);
+		else if ((batterySettings.FlightTimeThresholds[FLIGHTBATTERYSETTINGS_FLIGHTTIMETHRESHOLDS_WARNING] > 0)
+				 && (flightBatteryData.EstimatedFlightTime < batterySettings.FlightTimeThresholds[FLIGHTBATTERYSETTINGS_FLIGHTTIMETHRESHOLDS_WARNING]))
+			AlarmsSet(SYSTEMALARMS_ALARM_FLIGHTTIME, SYSTEMALARMS_ALARM_WARNING);
+		else
+			AlarmsClear(SYSTEMALARMS_ALARM_FLIGHTTIME);
+	} else {
+		flightBatteryData.Current = 0;
+	}
 
-			flightBatteryData.Voltage = scaled_voltage;
+	if (voltageADCPin >= 0 && currentADCPin >= 0 && !adc_pin_invalid) {
+		model_update(flightBatteryData.Voltage, flightBatteryData.Current);
 
-			// generate alarms and warnings
-			if (flightBatteryData.Voltage < (batterySettings.CellVoltageThresholds[FLIGHTBATTERYSETTINGS_CELLVOLTAGETHRESHOLDS_ALARM] * cells))
-				AlarmsSet(SYSTEMALARMS_ALARM_BATTERY, SYSTEMALARMS_ALARM_CRITICAL);
-			else if (flightBatteryData.Voltage < (batterySettings.CellVoltageThresholds[FLIGHTBATTERYSETTINGS_CELLVOLTAGETHRESHOLDS_WARNING] * cells))
-				AlarmsSet(SYSTEMALARMS_ALARM_BATTERY, SYSTEMALARMS_ALARM_WARNING);
-			else
-				AlarmsClear(SYSTEMALARMS_ALARM_BATTERY);
+		if (model.p[1][1] < MODEL_R_VAR_VALID) {
+			flightBatteryData.InternalResistance = model.r * 1000.0f;
+			flightBatteryData.RestingVoltage = flightBatteryData.Voltage +
+				flightBatteryData.Current * model.r;
 		} else {
-			flightBatteryData.Voltage = 0;
+			flightBatteryData.InternalResistance = 0;
+			flightBatteryData.RestingVoltage = 0;
 		}
+	}
 
-		// handle current
-		if (currentADCPin >= 0) {
-			float adc_voltage = (float)PIOS_ADC_GetChannelVolt(currentADCPin);
-			float scaled_current = 0.0f;
-
-			// A negative result indicates an error (PIOS_ADC_GetChannelVolt returns -1 on error)
-			if(adc_voltage < 0.0f)
-				adc_pin_invalid = true;
-			else {
-				// scale to actual current
-				scaled_current = (adc_voltage * 1000.0f
-						/ batterySettings.SensorCalibrationFactor[FLIGHTBATTERYSETTINGS_SENSORCALIBRATIONFACTOR_CURRENT])
-						+ batterySettings.SensorCalibrationOffset[FLIGHTBATTERYSETTINGS_SENSORCALIBRATIONOFFSET_CURRENT]; //in Amps
-
-				// disallow negative values as these are cast to unsigned integral types
-				// in some telemetry layers
-				if(scaled_current < 0.0f) {
-					scaled_current = 0.0f;
-					adc_offset_invalid = true;
-				}
+	// Pull the mAh count toward what the resting voltage says is left.
+	// A pack plugged in part used gets its count straight away; after
+	// that only slowly, as the voltage curve is flat in the middle.
+	if (cells_calculated && voltageADCPin >= 0) {
+		float resting = flightBatteryData.RestingVoltage;
+
+		if (resting <= 0 && (currentADCPin < 0 ||
+				flightBatteryData.Current < REST_CURRENT)) {
+			resting = flightBatteryData.Voltage;
+		}
+
+		if (resting > 0) {
+			float charge = charge_from_cell_voltage(resting / cells);
+			float consumed = (1 - charge) * batterySettings.Capacity;
+
+			if (!charge_seeded) {
+				charge_seeded = true;
+
+				if (charge < SEED_MAX_CHARGE)
+					flightBatteryData.ConsumedEnergy = consumed;
+			} else if (currentADCPin >= 0) {
+				flightBatteryData.ConsumedEnergy +=
+					(consumed - flightBatteryData.ConsumedEnergy) *
+					dT / CHARGE_CORRECTION_TAU;
 			}
+		}
+	}
 
-			flightBatteryData.Current = scaled_current;
+	if(adc_pin_invalid)
+		AlarmsSet(SYSTEMALARMS_ALARM_ADC, SYSTEMALARMS_ALARM_CRITICAL);
+	else if(adc_offset_invalid)
+		AlarmsSet(SYSTEMALARMS_ALARM_ADC, SYSTEMALARMS_ALARM_WARNING);
+	else if(voltageADCPin >= 0 || currentADCPin >= 0)
+		AlarmsSet(SYSTEMALARMS_ALARM_ADC, SYSTEMALARMS_ALARM_OK);
+	else
+		AlarmsSet(SYSTEMALARMS_ALARM_ADC, SYSTEMALARMS_ALARM_UNINITIALISED);
 
-			if (flightBatteryData.Current > flightBatteryData.PeakCurrent)
-				flightBatteryData.PeakCurrent = flightBatteryData.Current; //in Amps
+	FlightBatteryStateSet(&flightBatteryData);
 
-			flightBatteryData.ConsumedEnergy += (flightBatteryData.Current * dT * 1000.0f / 3600.0f); //in mAh
+	return SAMPLE_PERIOD_MS;
+}
 
-			//Apply a 2 second rise time low-pass filter to average the current
-			float alpha = 1.0f - dT / (dT + 2.0f);
-			flightBatteryData.AvgCurrent = alpha * flightBatteryData.AvgCurrent + (1 - alpha) * flightBatteryData.Current; //in Amps
+/**
+ * Fit the voltage to the current by recursive least squares, forgetting
+ * old samples so the open circuit voltage can follow the pack down.
+ * @param[in] voltage battery voltage
+ * @param[in] current current drawn
+ */
+static void model_update(float voltage, float current)
+{
+	if (!model.initialized) {
+		model = (struct battery_model) {
+			.ocv = voltage,
+			.p = { { MODEL_OCV_VAR_MAX, 0 }, { 0, MODEL_R_VAR_MAX } },
+			.initialized = true,
+		};
+
+		return;
+	}
 
-			// XXX Arguably this should be to 10% capacity or 15%
-			energyRemaining = batterySettings.Capacity - flightBatteryData.ConsumedEnergy; // in mAh
+	// V = [1 -I] [OCV R]'
+	const float phi[2] = { 1, -current };
 
-			// And for time estimation, smooth things much more.
-			// Second order since it incorporates the above
-			// smoothing, 12s time constant for this layer.
-			alpha = 1.0f - dT / (dT + 12.0f);
+	float p_phi[2] = {
+		model.p[0][0] * phi[0] + model.p[0][1] * phi[1],
+		model.p[1][0] * phi[0] + model.p[1][1] * phi[1],
+	};
 
-			avg_current_lpf_for_time = avg_current_lpf_for_time * alpha + (1 - alpha) * flightBatteryData.AvgCurrent;
+	float den = MODEL_FORGET + phi[0] * p_phi[0] + phi[1] * p_phi[1];
+	float k[2] = { p_phi[0] / den, p_phi[1] / den };
 
-			if (avg_current_lpf_for_time > 0.1f)
-				flightBatteryData.EstimatedFlightTime = (energyRemaining / (avg_current_lpf_for_time * 1000.0f)) * 3600.0f; //in Sec
-			else
-				flightBatteryData.EstimatedFlightTime = 9999;
+	float err = voltage - (model.ocv - current * model.r);
 
-			// generate alarms and warnings
-			if ((batterySettings.FlightTimeThresholds[FLIGHTBATTERYSETTINGS_FLIGHTTIMETHRESHOLDS_ALARM] > 0)
-				&& (flightBatteryData.EstimatedFlightTime < batterySettings.FlightTimeThresholds[FLIGHTBATTERYSETTINGS_FLIGHTTIMETHRESHOLDS_ALARM]))
-				AlarmsSet(SYSTEMALARMS_ALARM_FLIGHTTIME, SYSTEMALARMS_ALARM_CRITICAL);
-			else if ((batterySettings.FlightTimeThresholds[FLIGHTBATTERYSETTINGS_FLIGHTTIMETHRESHOLDS_WARNING] > 0)
-					 && (flightBatteryData.EstimatedFlightTime < batterySettings.FlightTimeThresholds[FLIGHTBATTERYSETTINGS_FLIGHTTIMETHRESHOLDS_WARNING]))
-				AlarmsSet(SYSTEMALARMS_ALARM_FLIGHTTIME, SYSTEMALARMS_ALARM_WARNING);
-			else
-				AlarmsClear(SYSTEMALARMS_ALARM_FLIGHTTIME);
-		} else {
-			flightBatteryData.Current = 0;
+	model.ocv += k[0] * err;
+	model.r += k[1] * err;
+
+	if (model.r < 0)
+		model.r = 0;
+
+	for (int i = 0; i < 2; i++) {
+		for (int j = 0; j < 2; j++) {
+			model.p[i][j] = (model.p[i][j] - k[i] * p_phi[j]) / MODEL_FORGET;
 		}
+	}
 
-		if(adc_pin_invalid)
-			AlarmsSet(SYSTEMALARMS_ALARM_ADC, SYSTEMALARMS_ALARM_CRITICAL);
-		else if(adc_offset_invalid)
-			AlarmsSet(SYSTEMALARMS_ALARM_ADC, SYSTEMALARMS_ALARM_WARNING);
-		else if(voltageADCPin >= 0 || currentADCPin >= 0)
-			AlarmsSet(SYSTEMALARMS_ALARM_ADC, SYSTEMALARMS_ALARM_OK);
-		else
-			AlarmsSet(SYSTEMALARMS_ALARM_ADC, SYSTEMALARMS_ALARM_UNINITIALISED);
+	// Forgetting with a steady current would wind the covariance up
+	model.p[0][0] = MIN(model.p[0][0], MODEL_OCV_VAR_MAX);
+	model.p[1][1] = MIN(model.p[1][1], MODEL_R_VAR_MAX);
+
+	float p_max = sqrtf(model.p[0][0] * model.p[1][1]);
+	model.p[0][1] = model.p[1][0] = bound_sym(model.p[0][1], p_max);
+}
+
+/**
+ * Look up the state of charge of a resting lithium polymer cell
+ * @param[in] cell_voltage resting voltage of one cell
+ * @return the fraction of charge left
+ */
+static float charge_from_cell_voltage(float cell_voltage)
+{
+	const int points = NELEMENTS(lipo_cell_ocv);
+
+	if (cell_voltage <= lipo_cell_ocv[0])
+		return 0;
+
+	for (int i = 1; i < points; i++) {
+		if (cell_voltage < lipo_cell_ocv[i]) {
+			float frac = (cell_voltage - lipo_cell_ocv[i - 1]) /
+				(lipo_cell_ocv[i] - lipo_cell_ocv[i - 1]);
 
-		FlightBatteryStateSet(&flightBatteryData);
+			return (i - 1 + frac) / (points - 1);
+		}
 	}
+
+	return 1;
 }
 
 /**
@@ -0,0 +1,345 @@
+/**
+ ******************************************************************************
+ * @addtogroup Modules Modules
+ * @{
+ * @addtogroup Benchmark Benchmark Module
+ * @{
+ *
+ * @file       bench_cases.c
+ * @author     dRonin, http://dronin.org, Copyright (C) 2017
+ * @brief      Control loop math benchmark cases shared by host and target
+ *
+ * Each case runs one step of a flight math library the way the control
+ * loop calls it.  The same cases are timed with a wall clock by the host
+ * benchmark in flight/tests/bench and with the cycle counter by the
+ * Benchmark module on a board.
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "pios.h"
+
+#include "bench_cases.h"
+#include "coordinate_conversions.h"
+#include "insgps.h"
+#include "lpfilter.h"
+#include "lqg.h"
+#include "pid.h"
+#include "smoothcontrol.h"
+
+#include <math.h>
+
+//! Loop rate the cases are configured for
+#define BENCH_DT	0.001f
+//! Length of the input table, must be a power of two
+#define BENCH_INPUTS	64
+
+static const char * const bench_names[BENCH_NUM_CASES] = {
+	[BENCH_LPFILTER] = "LPFilter",
+	[BENCH_PID] = "PID",
+	[BENCH_LQG] = "LQG",
+	[BENCH_SMOOTHCONTROL] = "SmoothControl",
+	[BENCH_COORDINATES] = "Coordinates",
+	[BENCH_INS_PREDICT] = "INSPredict",
+	[BENCH_INS_COVARIANCE] = "INSCovariance",
+	[BENCH_INS_CORRECTION] = "INSCorrection",
+	[BENCH_FAST_COORDINATES] = "FastCoordinates",
+};
+
+static float inputs[BENCH_INPUTS];
+
+static lpfilter_state_t lpfilter;
+static struct pid pid[3];
+static struct pid_deadband deadband;
+static pid_rate_kernel_t rate_kernel;
+static lqg_t lqg;
+static smoothcontrol_state smoothing;
+
+//! Results are summed in here so the compiler can't drop the work
+static volatile float bench_sink;
+
+/**
+ * Allocate and configure the state used by every case.  Safe to call
+ * more than once; the INS is re-initialized each time.
+ */
+void bench_setup()
+{
+	for (int i = 0; i < BENCH_INPUTS; i++) {
+		inputs[i] = 100.0f * sinf(2 * (float) M_PI * i / BENCH_INPUTS) +
+			10.0f * sinf(14 * (float) M_PI * i / BENCH_INPUTS);
+	}
+
+	if (!lpfilter) {
+		lpfilter_create(&lpfilter, 90.0f, BENCH_DT, 2, 3);
+	}
+
+	pid_configure_derivative(80.0f, 1.0f);
+	for (int i = 0; i < 3; i++) {
+		pid_configure(&pid[i], 0.002f, 0.005f, 0.00003f, 0.3f, BENCH_DT);
+	}
+	pid_configure_deadband(&deadband, 2.0f, 0.3f);
+	rate_kernel = pid_select_rate_kernel(&deadband);
+
+	if (!lqg) {
+		rtkf_t rtkf = rtkf_create(10.0f, 0.03f, BENCH_DT, 10000.0f,
+				0.00001f, 10.0f, 0.0001f, 0.05f);
+		lqr_t lqr = lqr_create(10.0f, 0.03f, BENCH_DT, 0.01f, 0.0001f, 20.0f);
+
+		lqg = lqg_create(rtkf, lqr);
+
+		for (int i = 0; i < 1000 && lqg_solver_status(lqg) != LQG_SOLVER_DONE; i++) {
+			lqg_run_covariance(lqg, 10);
+		}
+	}
+
+	if (!smoothing) {
+		smoothcontrol_initialize(&smoothing);
+	}
+	smoothcontrol_update_dT(smoothing, BENCH_DT);
+	for (int i = 0; i < 3; i++) {
+		smoothcontrol_set_mode(smoothing, i, SMOOTHCONTROL_NORMAL, 50);
+	}
+
+	const float Be[3] = { 0.5f, 0.05f, 0.8f };
+
+	INSGPSInit();
+	INSSetMagNorth(Be);
+}
+
+static void bench_lpfilter(uint32_t iterations)
+{
+	float gyro[3];
+
+	for (uint32_t i = 0; i < iterations; i++) {
+		gyro[0] = inputs[i & (BENCH_INPUTS - 1)];
+		gyro[1] = inputs[(i + 16) & (BENCH_INPUTS - 1)];
+		gyro[2] = inputs[(i + 32) & (BENCH_INPUTS - 1)];
+
+		lpfilter_run(lpfilter, gyro);
+	}
+
+	bench_sink += gyro[0] + gyro[1] + gyro[2];
+}
+
+static void bench_pid(uint32_t iterations)
+{
+	float out = 0;
+
+	for (uint32_t i = 0; i < iterations; i++) {
+		for (int j = 0; j < 3; j++) {
+			out += rate_kernel(&pid[j], &deadband, 0,
+					inputs[(i + 16 * j) & (BENCH_INPUTS - 1)]);
+		}
+	}
+
+	bench_sink += out;
+}
+
+static void bench_lqg(uint32_t iterations)
+{
+	float out = 0;
+
+	for (uint32_t i = 0; i < iterations; i++) {
+		out += lqg_controller(lqg, inputs[i & (BENCH_INPUTS - 1)], 0);
+	}
+
+	bench_sink += out;
+}
+
+static void bench_smoothcontrol(uint32_t iterations)
+{
+	float out = 0;
+
+	for (uint32_t i = 0; i < iterations; i++) {
+		// New receiver frame every 8 control cycles
+		if ((i & 7) == 0) {
+			*smoothcontrol_get_ringer(smoothing) = true;
+		}
+
+		for (int j = 0; j < 3; j++) {
+			float signal = inputs[((i >> 3) + 16 * j) & (BENCH_INPUTS - 1)];
+
+			smoothcontrol_run(smoothing, j, &signal);
+			out += signal;
+		}
+
+		smoothcontrol_next(smoothing);
+	}
+
+	bench_sink += out;
+}
+
+static void bench_coordinates(uint32_t iterations)
+{
+	float rpy[3], q[4], R[3][3];
+	float out = 0;
+
+	for (uint32_t i = 0; i < iterations; i++) {
+		rpy[0] = 0.5f * inputs[i & (BENCH_INPUTS - 1)];
+		rpy[1] = 0.3f * inputs[(i + 16) & (BENCH_INPUTS - 1)];
+		rpy[2] = inputs[(i + 32) & (BENCH_INPUTS - 1)];
+
+		RPY2Quaternion(rpy, q);
+		Quaternion2R(q, R);
+		R2Quaternion(R, q);
+		Quaternion2RPY(q, rpy);
+
+		out += rpy[0] + rpy[1] + rpy[2];
+	}
+
+	bench_sink += out;
+}
+
+static void bench_ins_predict(uint32_t iterations)
+{
+	float gyro[3], accel[3];
+
+	for (uint32_t i = 0; i < iterations; i++) {
+		gyro[0] = 0.001f * inputs[i & (BENCH_INPUTS - 1)];
+		gyro[1] = 0.001f * inputs[(i + 16) & (BENCH_INPUTS - 1)];
+		gyro[2] = 0.001f * inputs[(i + 32) & (BENCH_INPUTS - 1)];
+		accel[0] = 0.01f * inputs[(i + 8) & (BENCH_INPUTS - 1)];
+		accel[1] = 0.01f * inputs[(i + 24) & (BENCH_INPUTS - 1)];
+		accel[2] = -9.81f;
+
+		INSStatePrediction(gyro, accel, BENCH_DT);
+	}
+}
+
+static void bench_ins_covariance(uint32_t iterations)
+{
+	for (uint32_t i = 0; i < iterations; i++) {
+		INSCovariancePrediction(BENCH_DT);
+	}
+}
+
+static void bench_ins_correction(uint32_t iterations)
+{
+	float mag[3] = { 0.5f, 0.05f, 0.8f };
+	float pos[3], vel[3];
+
+	for (uint32_t i = 0; i < iterations; i++) {
+		pos[0] = 0.01f * inputs[i & (BENCH_INPUTS - 1)];
+		pos[1] = 0.01f * inputs[(i + 16) & (BENCH_INPUTS - 1)];
+		pos[2] = 0;
+		vel[0] = 0.001f * inputs[(i + 8) & (BENCH_INPUTS - 1)];
+		vel[1] = 0.001f * inputs[(i + 24) & (BENCH_INPUTS - 1)];
+		vel[2] = 0;
+
+		INSCorrection(mag, pos, vel, pos[2], FULL_SENSORS);
+	}
+}
+
+/**
+ * The attitude and stabilization inner loop work on the approximate
+ * kernels: fused product and renormalisation, a batched rotation, and
+ * polynomial angles.
+ */
+static void bench_fast_coordinates(uint32_t iterations)
+{
+	float rpy[3], q[4], dq[4] = { 1, 0, 0, 0 }, R[3][3];
+	float vecs[3][3], rotated[3][3];
+	float out = 0;
+
+	for (uint32_t i = 0; i < iterations; i++) {
+		rpy[0] = 0.5f * inputs[i & (BENCH_INPUTS - 1)];
+		rpy[1] = 0.3f * inputs[(i + 16) & (BENCH_INPUTS - 1)];
+		rpy[2] = inputs[(i + 32) & (BENCH_INPUTS - 1)];
+
+		RPY2Quaternion(rpy, q);
+		Quaternion2R(q, R);
+
+		for (int j = 0; j < 3; j++) {
+			vecs[j][0] = inputs[(i + 8 * j) & (BENCH_INPUTS - 1)];
+			vecs[j][1] = inputs[(i + 8 * j + 16) & (BENCH_INPUTS - 1)];
+			vecs[j][2] = inputs[(i + 8 * j + 32) & (BENCH_INPUTS - 1)];
+		}
+
+		rot_mult_n(R, (const float (*)[3]) vecs, rotated, 3, true);
+
+		dq[1] = 0.0001f * rotated[0][0];
+		dq[2] = 0.0001f * rotated[1][1];
+		dq[3] = 0.0001f * rotated[2][2];
+
+		quat_mult_normalize(q, dq, q);
+		Quaternion2RPYApprox(q, rpy);
+
+		out += rpy[0] + rpy[1] + rpy[2];
+	}
+
+	bench_sink += out;
+}
+
+/**
+ * Run one benchmark case
+ * \param[in] bench the case to run
+ * \param[in] iterations the number of control loop steps to simulate
+ */
+void bench_run(enum bench_case bench, uint32_t iterations)
+{
+	switch (bench) {
+	case BENCH_LPFILTER:
+		bench_lpfilter(iterations);
+		break;
+	case BENCH_PID:
+		bench_pid(iterations);
+		break;
+	case BENCH_LQG:
+		bench_lqg(iterations);
+		break;
+	case BENCH_SMOOTHCONTROL:
+		bench_smoothcontrol(iterations);
+		break;
+	case BENCH_COORDINATES:
+		bench_coordinates(iterations);
+		break;
+	case BENCH_INS_PREDICT:
+		bench_ins_predict(iterations);
+		break;
+	case BENCH_INS_COVARIANCE:
+		bench_ins_covariance(iterations);
+		break;
+	case BENCH_INS_CORRECTION:
+		bench_ins_correction(iterations);
+		break;
+	case BENCH_FAST_COORDINATES:
+		bench_fast_coordinates(iterations);
+		break;
+	default:
+		PIOS_Assert(0);
+	}
+}
+
+/**
+ * Get the name of a benchmark case
+ * \param[in] bench the case
+ * \returns the name, matching the BenchmarkResults element name
+ */
+const char *bench_name(enum bench_case bench)
+{
+	if (bench >= BENCH_NUM_CASES) {
+		return NULL;
+	}
+
+	return bench_names[bench];
+}
+
+/**
+ * @}
+ * @}
+ */
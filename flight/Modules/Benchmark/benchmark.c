@@ -0,0 +1,132 @@
+/**
+ ******************************************************************************
+ * @addtogroup Modules Modules
+ * @{
+ * @addtogroup Benchmark Benchmark Module
+ * @{
+ *
+ * @file       benchmark.c
+ * @author     dRonin, http://dronin.org, Copyright (C) 2017
+ * @brief      Measure the flight math libraries in cycles on the board
+ *
+ * Only built into benchmark firmware (BENCHMARK=YES on a target that
+ * supports it).  The cases share the INSGPS state with the Attitude
+ * module, so such a firmware must not be flown; passes are skipped while
+ * armed.
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "openpilot.h"
+#include "pios_thread.h"
+
+#include "bench_cases.h"
+
+#include "benchmarkresults.h"
+#include "flightstatus.h"
+
+// Private constants
+#define STACK_SIZE_BYTES 1200
+#define TASK_PRIORITY PIOS_THREAD_PRIO_LOW
+
+//! Let the rest of the firmware finish starting up first
+#define STARTUP_DELAY_MS 5000
+#define PASS_PERIOD_MS 1000
+#define ITERATIONS 200
+
+DONT_BUILD_IF(BENCHMARKRESULTS_CYCLES_NUMELEM != BENCH_NUM_CASES, BenchmarkCaseCount);
+
+// Private variables
+static struct pios_thread *taskHandle;
+
+// Private functions
+static void benchmarkTask(void *parameters);
+
+/**
+ * Initialise the module, called on startup
+ * \returns 0 on success or -1 if initialisation failed
+ */
+int32_t BenchmarkInitialize(void)
+{
+	if (BenchmarkResultsInitialize() == -1) {
+		return -1;
+	}
+
+	return 0;
+}
+
+/**
+ * Start the benchmark task
+ * \returns 0 on success or -1 if initialisation failed
+ */
+int32_t BenchmarkStart(void)
+{
+	taskHandle = PIOS_Thread_Create(benchmarkTask, "Benchmark", STACK_SIZE_BYTES, NULL, TASK_PRIORITY);
+
+	return 0;
+}
+
+MODULE_INITCALL(BenchmarkInitialize, BenchmarkStart);
+
+/**
+ * Time every case once per pass and keep the fastest run of each.
+ * Running at low priority, a pass that gets preempted only reads slow and
+ * is discarded by the minimum.
+ */
+static void benchmarkTask(void *parameters)
+{
+	BenchmarkResultsData results;
+
+	BenchmarkResultsGet(&results);
+
+	PIOS_Thread_Sleep(STARTUP_DELAY_MS);
+
+	bench_setup();
+
+	while (1) {
+		PIOS_Thread_Sleep(PASS_PERIOD_MS);
+
+		uint8_t armed;
+		FlightStatusArmedGet(&armed);
+
+		if (armed != FLIGHTSTATUS_ARMED_DISARMED) {
+			continue;
+		}
+
+		for (int i = 0; i < BENCH_NUM_CASES; i++) {
+			uint32_t start = PIOS_DELAY_GetRaw();
+			bench_run(i, ITERATIONS);
+			uint32_t cycles = (PIOS_DELAY_GetRaw() - start) / ITERATIONS;
+
+			if (results.Cycles[i] == 0 || cycles < results.Cycles[i]) {
+				results.Cycles[i] = cycles;
+			}
+		}
+
+		// Long INS runs drift the state; start each pass fresh
+		bench_setup();
+
+		results.Passes++;
+		BenchmarkResultsSet(&results);
+	}
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,58 @@
+/**
+ ******************************************************************************
+ * @addtogroup Modules Modules
+ * @{
+ * @addtogroup Benchmark Benchmark Module
+ * @{
+ *
+ * @file       bench_cases.h
+ * @author     dRonin, http://dronin.org, Copyright (C) 2017
+ * @brief      Control loop math benchmark cases shared by host and target
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef BENCH_CASES_H
+#define BENCH_CASES_H
+
+#include <stdint.h>
+
+//! Benchmark cases, in the order of the BenchmarkResults elements
+enum bench_case {
+	BENCH_LPFILTER,
+	BENCH_PID,
+	BENCH_LQG,
+	BENCH_SMOOTHCONTROL,
+	BENCH_COORDINATES,
+	BENCH_INS_PREDICT,
+	BENCH_INS_COVARIANCE,
+	BENCH_INS_CORRECTION,
+	BENCH_FAST_COORDINATES,
+	BENCH_NUM_CASES
+};
+
+void bench_setup();
+void bench_run(enum bench_case bench, uint32_t iterations);
+const char *bench_name(enum bench_case bench);
+
+#endif /* BENCH_CASES_H */
+
+/**
+ * @}
+ * @}
+ */
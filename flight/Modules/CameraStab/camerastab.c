@@ -39,6 +39,9 @@
  * when the flight control is on the airframe of the aircraft.  If the controller is
  * placed on the gimbal using the standard stabilization code will work.
  *
+ * Axes with the GyroFeedForward output mode get a RateGain in @ref CameraDesired,
+ * and the actuator moves them from the gyros at each of its updates, not just
+ * at each of ours.
  */
 
 #include "openpilot.h"
@@ -193,6 +196,11 @@ static void attitudeUpdated(const UAVObjEvent *ev,
 
 	CameraStabSettingsData *settings = &csd->settings;
 
+	// Everything goes out in one update, so the actuator doesn't see
+	// half of it
+	CameraDesiredData desired;
+	CameraDesiredGet(&desired);
+
 	// Check how long since last update, time delta between calls in ms
 	uint32_t thisSysTime = PIOS_Thread_Systime();
 	float dT_ms = thisSysTime - csd->lastSysTime;
@@ -246,10 +254,10 @@ static void attitudeUpdated(const UAVObjEvent *ev,
 			}
 			switch(i) {
 			case PITCH:
-				CameraDesiredDeclinationSet(&csd->inputs[i]);
+				desired.Declination = csd->inputs[i];
 				break;
 			case YAW:
-				CameraDesiredBearingSet(&csd->inputs[i]);
+				desired.Bearing = csd->inputs[i];
 				break;
 			default:
 				break;
@@ -287,11 +295,11 @@ static void attitudeUpdated(const UAVObjEvent *ev,
 					break;
 				case CAMERASTABSETTINGS_INPUT_PITCH:
 					// Store the absolute declination relative to UAV
-					CameraDesiredDeclinationSet(&pitch);
+					desired.Declination = pitch;
 					csd->inputs[CAMERASTABSETTINGS_INPUT_PITCH] = -pitch;
 					break;
 				case CAMERASTABSETTINGS_INPUT_YAW:
-					CameraDesiredBearingSet(&yaw);
+					desired.Bearing = yaw;
 					csd->inputs[CAMERASTABSETTINGS_INPUT_YAW] = yaw;
 					break;
 				}
@@ -307,18 +315,28 @@ static void attitudeUpdated(const UAVObjEvent *ev,
 		if (thisSysTime > LOAD_DELAY) {
 			switch (i) {
 			case ROLL:
-				CameraDesiredRollSet(&output);
+				desired.Roll = output;
 				break;
 			case PITCH:
-				CameraDesiredPitchSet(&output);
+				desired.Pitch = output;
 				break;
 			case YAW:
-				CameraDesiredYawSet(&output);
+				desired.Yaw = output;
 				break;
 			}
+
+			if (settings->OutputMode[i] == CAMERASTABSETTINGS_OUTPUTMODE_GYROFEEDFORWARD) {
+				desired.RateGain[i] = 1.0f / settings->OutputRange[i];
+			} else {
+				desired.RateGain[i] = 0;
+			}
 		}
 	}
 
+	desired.RateLead = settings->GyroLead / 1000.0f;
+
+	CameraDesiredSet(&desired);
+
 	// Send a message over CAN, if include
 	gimbal_can_message();
 }
@@ -33,11 +33,50 @@
 #include <stdbool.h>
 #include "modulesettings.h"
 #include "faultsettings.h"
+#include "faultstressstats.h"
+#include "actuatorcommand.h"
 #include "pios_thread.h"
+#include "misc_math.h"
+#include "uavobjectsinit.h"
+
+//! Actuator updates timed, before the load starts, for the baseline
+#define STRESS_BASELINE_LOOPS 1000
+//! Gives up on the baseline after this long without the actuator running
+#define STRESS_BASELINE_TIMEOUT_MS 5000
+#define STRESS_STATS_PERIOD_MS 1000
+//! Flash is read in pieces this big, all inside the one transaction
+#define STRESS_FLASH_CHUNK 64
+#define STRESS_STACK_SIZE 1024
+
+/**
+ * Time between actuator updates, which is how long the control loop takes
+ * to go round.  Written by the actuator callback and read by the stress
+ * task; only the stress task resets window_max, and losing a sample to that
+ * is of no matter.
+ */
+struct stress_loop {
+	uint32_t last_raw;
+	uint32_t loops;
+	uint32_t total_us;
+	uint32_t overruns;
+	uint16_t window_max;
+	uint16_t deadline;
+	bool running;
+};
+
+static const enum pios_thread_prio_e stress_prio[FAULTSETTINGS_STRESSBUSYTIME_NUMELEM] = {
+	[FAULTSETTINGS_STRESSBUSYTIME_LOW] = PIOS_THREAD_PRIO_LOW,
+	[FAULTSETTINGS_STRESSBUSYTIME_NORMAL] = PIOS_THREAD_PRIO_NORMAL,
+	[FAULTSETTINGS_STRESSBUSYTIME_HIGH] = PIOS_THREAD_PRIO_HIGH,
+	[FAULTSETTINGS_STRESSBUSYTIME_HIGHEST] = PIOS_THREAD_PRIO_HIGHEST,
+};
 
 static bool module_enabled;
 static uint8_t active_fault;
 
+static volatile struct stress_loop stress_loop;
+static volatile uint32_t stress_busy_us[FAULTSETTINGS_STRESSBUSYTIME_NUMELEM];
+
 static int32_t fault_initialize(void)
 {
 #ifdef MODULE_Fault_BUILTIN
@@ -63,6 +102,11 @@ static int32_t fault_initialize(void)
 		return -1;
 	}
 
+	if (module_enabled && FaultStressStatsInitialize() == -1) {
+		module_enabled = false;
+		return -1;
+	}
+
 	if (module_enabled) {
 		FaultSettingsActivateFaultGet(&active_fault);
 
@@ -89,6 +133,7 @@ static int32_t fault_initialize(void)
 }
 
 static void fault_task(void *parameters);
+static void stress_task(void *parameters);
 
 static int32_t fault_start(void)
 {
@@ -103,6 +148,11 @@ static int32_t fault_start(void)
 
 			return 0;
 			break;
+		case FAULTSETTINGS_ACTIVATEFAULT_CPUSTRESS:
+			fault_task_handle = PIOS_Thread_Create(stress_task, "Stress", STRESS_STACK_SIZE, NULL, PIOS_THREAD_PRIO_NORMAL);
+			(void) fault_task_handle;
+
+			return 0;
 		}
 	}
 	return -1;
@@ -126,6 +176,227 @@ static void fault_task(void *parameters)
 	}
 }
 
+/**
+ * Times the control loop by its actuator updates
+ */
+static void stress_actuator_cb(const UAVObjEvent *ev, void *ctx,
+		void *obj_data, int len)
+{
+	(void) ev; (void) ctx; (void) obj_data; (void) len;
+
+	uint32_t now = PIOS_DELAY_GetRaw();
+
+	if (stress_loop.last_raw) {
+		uint32_t dt = PIOS_DELAY_DiffuS2(stress_loop.last_raw, now);
+
+		stress_loop.loops++;
+		stress_loop.total_us += dt;
+
+		if (stress_loop.running && dt > stress_loop.deadline) {
+			stress_loop.overruns++;
+		}
+
+		if (dt > stress_loop.window_max) {
+			stress_loop.window_max = MIN(dt, UINT16_MAX);
+		}
+	}
+
+	stress_loop.last_raw = now;
+}
+
+/**
+ * Spins for StressBusyTime at its priority, each StressPeriod
+ * \param[in] parameters The FaultSettings StressBusyTime element
+ */
+static void stress_busy_task(void *parameters)
+{
+	uintptr_t level = (uintptr_t) parameters;
+	uint32_t next = PIOS_Thread_Systime();
+
+	while (1) {
+		uint16_t busy[FAULTSETTINGS_STRESSBUSYTIME_NUMELEM];
+		uint16_t period;
+
+		FaultSettingsStressBusyTimeGet(busy);
+		FaultSettingsStressPeriodGet(&period);
+
+		if (busy[level]) {
+			uint32_t start = PIOS_DELAY_GetRaw();
+
+			PIOS_DELAY_WaituS(busy[level]);
+
+			stress_busy_us[level] += PIOS_DELAY_DiffuS(start);
+		}
+
+		PIOS_Thread_Sleep_Until(&next, MAX(period, 1));
+	}
+}
+
+/**
+ * Reads StressFlashRead bytes from the settings partition in one
+ * transaction, holding the flash (and its bus) the whole time
+ * \return time the transaction took, in us
+ */
+static uint32_t stress_read_flash(uint16_t bytes)
+{
+#if defined(PIOS_INCLUDE_FLASH)
+	static uint8_t buf[STRESS_FLASH_CHUNK];
+	static uint32_t offset;
+	uintptr_t part_id;
+	uint32_t part_size;
+
+	if (PIOS_FLASH_find_partition_id(FLASH_PARTITION_LABEL_SETTINGS, &part_id) ||
+			PIOS_FLASH_get_partition_size(part_id, &part_size) ||
+			part_size < sizeof(buf)) {
+		return 0;
+	}
+
+	uint32_t start = PIOS_DELAY_GetRaw();
+
+	if (PIOS_FLASH_start_transaction(part_id)) {
+		return 0;
+	}
+
+	for (uint32_t done = 0; done < bytes; done += sizeof(buf)) {
+		if (offset + sizeof(buf) > part_size) {
+			offset = 0;
+		}
+
+		PIOS_FLASH_read_data(part_id, offset, buf, sizeof(buf));
+		offset += sizeof(buf);
+	}
+
+	PIOS_FLASH_end_transaction(part_id);
+
+	return PIOS_DELAY_DiffuS(start);
+#else
+	return 0;
+#endif /* PIOS_INCLUDE_FLASH */
+}
+
+/**
+ * Sends update events for an object by setting it to its current value, so
+ * that everything connected to it does its work again
+ * \return events sent
+ */
+static uint32_t stress_send_events(uint32_t obj_id, uint16_t count)
+{
+	static uint8_t buf[UAVOBJECTS_LARGEST];
+	UAVObjHandle obj = UAVObjGetByID(obj_id);
+
+	if (!obj || UAVObjGetNumBytes(obj) > sizeof(buf)) {
+		return 0;
+	}
+
+	for (uint16_t i = 0; i < count; i++) {
+		UAVObjGetData(obj, buf);
+		UAVObjSetData(obj, buf);
+	}
+
+	return count;
+}
+
+/**
+ * Measures the control loop unloaded, starts the busy tasks, then applies
+ * the bus and event load each StressPeriod and reports how the loop copes
+ */
+static void stress_task(void *parameters)
+{
+	FaultStressStatsData stats;
+
+	memset(&stats, 0, sizeof(stats));
+
+	if (ActuatorCommandHandle()) {
+		UAVObjConnectCallback(ActuatorCommandHandle(), stress_actuator_cb,
+				NULL, EV_UPDATED);
+	}
+
+	uint32_t wait_start = PIOS_Thread_Systime();
+
+	while (stress_loop.loops < STRESS_BASELINE_LOOPS &&
+			PIOS_Thread_Systime() - wait_start < STRESS_BASELINE_TIMEOUT_MS) {
+		PIOS_Thread_Sleep(100);
+	}
+
+	if (stress_loop.loops) {
+		stats.BaselineLoopTime = MIN(stress_loop.total_us / stress_loop.loops,
+				UINT16_MAX);
+	}
+
+	FaultSettingsStressDeadlineGet(&stats.Deadline);
+
+	if (stats.Deadline == 0) {
+		stats.Deadline = MIN(stats.BaselineLoopTime * 3 / 2, UINT16_MAX);
+	}
+
+	stress_loop.deadline = stats.Deadline;
+	stress_loop.window_max = 0;
+	stress_loop.running = true;
+
+	uint32_t last_loops = stress_loop.loops;
+	uint32_t last_total_us = stress_loop.total_us;
+	uint32_t first_loops = last_loops;
+	uint32_t last_busy_us[FAULTSETTINGS_STRESSBUSYTIME_NUMELEM] = { 0 };
+
+	for (uintptr_t i = 0; i < FAULTSETTINGS_STRESSBUSYTIME_NUMELEM; i++) {
+		struct pios_thread *busy_task_handle =
+			PIOS_Thread_Create(stress_busy_task, "StressBusy",
+					PIOS_THREAD_STACK_SIZE_MIN, (void *) i, stress_prio[i]);
+		(void) busy_task_handle;
+	}
+
+	uint32_t next = PIOS_Thread_Systime();
+	uint32_t last_stats = next;
+
+	while (1) {
+		FaultSettingsData settings;
+		FaultSettingsGet(&settings);
+
+		if (settings.StressFlashRead) {
+			uint32_t flash_us = stress_read_flash(settings.StressFlashRead);
+
+			stats.FlashReads += settings.StressFlashRead;
+			stats.MaxFlashReadTime = MAX(stats.MaxFlashReadTime,
+					MIN(flash_us, UINT16_MAX));
+		}
+
+		if (settings.StressEventObject && settings.StressEventCount) {
+			stats.Events += stress_send_events(settings.StressEventObject,
+					settings.StressEventCount);
+		}
+
+		uint32_t now = PIOS_Thread_Systime();
+
+		if (now - last_stats >= STRESS_STATS_PERIOD_MS) {
+			uint32_t loops = stress_loop.loops;
+			uint32_t total_us = stress_loop.total_us;
+
+			stats.Loops = loops - first_loops;
+			stats.LoopOverruns = stress_loop.overruns;
+			stats.MeanLoopTime = (loops != last_loops) ?
+				MIN((total_us - last_total_us) / (loops - last_loops), UINT16_MAX) : 0;
+			stats.MaxLoopTime = stress_loop.window_max;
+			stress_loop.window_max = 0;
+
+			for (int i = 0; i < FAULTSETTINGS_STRESSBUSYTIME_NUMELEM; i++) {
+				uint32_t busy_us = stress_busy_us[i];
+
+				stats.BusyLoad[i] = MIN((busy_us - last_busy_us[i]) /
+						((now - last_stats) * 10), 100);
+				last_busy_us[i] = busy_us;
+			}
+
+			FaultStressStatsSet(&stats);
+
+			last_loops = loops;
+			last_total_us = total_us;
+			last_stats = now;
+		}
+
+		PIOS_Thread_Sleep_Until(&next, MAX(settings.StressPeriod, 1));
+	}
+}
+
 /** 
   * @}
   * @}
@@ -44,9 +44,11 @@
 #include "gpstime.h"
 #include "gpssatellites.h"
 #include "gpsvelocity.h"
+#include "gpscorrection.h"
 #include "modulesettings.h"
 #include "pios_thread.h"
 #include "pios_modules.h"
+#include "pios_spsc_queue.h"
 
 #include "NMEA.h"
 #include "UBX.h"
@@ -63,16 +65,30 @@
 
 static void gpsTask(void *parameters);
 static void updateSettings();
+static void gpsCorrectionUpdated(const UAVObjEvent *ev, void *ctx, void *obj_data,
+		int len);
+static bool gpsSendCorrections(void);
 
 // ****************
 // Private constants
 
 #define GPS_TIMEOUT_MS                  750
 #define GPS_COM_TIMEOUT_MS              100
+//! Bytes taken from the port at a time; a NAV-PVT message is exactly 100
+#define GPS_RX_BLOCK_LEN                32
 #define STACK_SIZE_BYTES                850
 
 #define TASK_PRIORITY                   PIOS_THREAD_PRIO_LOW
 
+//! The longest RTCM3 frame: preamble and length, 1023 bytes, then CRC
+#define GPS_CORRECTION_MAX_LEN          (3 + 1023 + 3)
+//! Complete messages waiting for the GPS port; a frame and a bit
+#define GPS_CORRECTION_QUEUE_LEN        1280
+//! Bytes put to the port at a time; its transmit buffer is small
+#define GPS_CORRECTION_CHUNK_LEN        8
+//! How often the port is topped up while corrections are waiting
+#define GPS_CORRECTION_POLL_MS          2
+
 // ****************
 // Private variables
 
@@ -85,6 +101,22 @@ static char* gps_rx_buffer;
 
 static struct GPS_RX_STATS gpsRxStats;
 
+/* Reassembly of the correction messages the GCS sends up in GPSCorrection
+ * fragments.  Only whole messages are queued, so a lost fragment costs one
+ * message instead of feeding the receiver a broken frame.  Allocated when
+ * the first fragment arrives. */
+struct gps_correction {
+	struct pios_spsc_queue *queue;	// Whole messages, for the GPS task
+	uint16_t len;			// Of the message being reassembled
+	uint8_t sequence;
+	uint8_t next_fragment;		// 0 when not reassembling
+	uint8_t sent_sequence;		// Of the last message queued
+	bool sent_any;
+	uint8_t msg[GPS_CORRECTION_MAX_LEN];
+};
+
+static struct gps_correction *gpsCorrection;
+
 // ****************
 /**
  * Initialise the gps module
@@ -143,6 +175,13 @@ int32_t GPSInitialize(void)
 		return -1;
 	}
 #endif
+
+	// Corrections are optional; the GPS works without them
+	if (gpsPort && module_enabled && GPSCorrectionInitialize() == 0) {
+		UAVObjConnectCallback(GPSCorrectionHandle(),
+				gpsCorrectionUpdated, NULL, EV_UNPACKED);
+	}
+
 	updateSettings();
 
 	if (gpsPort && module_enabled) {
@@ -248,6 +287,12 @@ static void gpsTask(void *parameters)
 
 		uint32_t loopTimeMs = PIOS_Thread_Systime();
 
+		// Messages are written from here, never in the middle of one
+		// of the configuration writes above
+		if (gpsSendCorrections()) {
+			xDelay = GPS_CORRECTION_POLL_MS;
+		}
+
 		// XXX TODO: also on modulesettings change..
 		if (!timeOfConfigAttemptMs) {
 			ModuleSettingsGPSDataProtocolGet(&gpsProtocol);
@@ -258,30 +303,36 @@ static void gpsTask(void *parameters)
 			continue;
 		}
 
-		uint8_t c;
+		uint8_t rx_block[GPS_RX_BLOCK_LEN];
+		int32_t received;
 
 		// This blocks the task until there is something on the buffer
-		while (PIOS_COM_ReceiveBuffer(gpsPort, &c, 1, xDelay) > 0)
+		while ((received = PIOS_COM_ReceiveBuffer(gpsPort, rx_block,
+				sizeof(rx_block), xDelay)) > 0)
 		{
-			int res;
-			switch (gpsProtocol) {
+			for (int32_t i = 0; i < received; i++) {
+				uint8_t c = rx_block[i];
+				int res;
+
+				switch (gpsProtocol) {
 #if defined(PIOS_INCLUDE_GPS_NMEA_PARSER)
-				case MODULESETTINGS_GPSDATAPROTOCOL_NMEA:
-					res = parse_nmea_stream (c,gps_rx_buffer, &gpsposition, &gpsRxStats);
-					break;
+					case MODULESETTINGS_GPSDATAPROTOCOL_NMEA:
+						res = parse_nmea_stream (c,gps_rx_buffer, &gpsposition, &gpsRxStats);
+						break;
 #endif
 #if defined(PIOS_INCLUDE_GPS_UBX_PARSER)
-				case MODULESETTINGS_GPSDATAPROTOCOL_UBX:
-					res = parse_ubx_stream (c,gps_rx_buffer, &gpsposition, &gpsRxStats);
-					break;
+					case MODULESETTINGS_GPSDATAPROTOCOL_UBX:
+						res = parse_ubx_stream (c,gps_rx_buffer, &gpsposition, &gpsRxStats);
+						break;
 #endif
-				default:
-					res = NO_PARSER; // this should not happen
-					break;
-			}
+					default:
+						res = NO_PARSER; // this should not happen
+						break;
+				}
 
-			if (res == PARSER_COMPLETE) {
-				timeOfLastUpdateMs = loopTimeMs;
+				if (res == PARSER_COMPLETE) {
+					timeOfLastUpdateMs = loopTimeMs;
+				}
 			}
 
 			xDelay = 0;	// For now on, don't block / wait,
@@ -318,6 +369,116 @@ static void gpsTask(void *parameters)
 }
 
 
+/**
+ * Put as much of the waiting corrections to the GPS port as it takes
+ * \return true if some are still waiting
+ */
+static bool gpsSendCorrections(void)
+{
+	struct gps_correction *corr = gpsCorrection;
+
+	if (!corr) {
+		return false;
+	}
+
+	uint16_t num;
+	uint8_t *pos;
+
+	while ((pos = PIOS_SPSC_Queue_Peek(corr->queue, &num, 0)) != NULL) {
+		if (num > GPS_CORRECTION_CHUNK_LEN) {
+			num = GPS_CORRECTION_CHUNK_LEN;
+		}
+
+		if (PIOS_COM_SendBufferNonBlocking(gpsPort, pos, num) != num) {
+			return true;
+		}
+
+		PIOS_SPSC_Queue_Consume(corr->queue, num, NULL);
+	}
+
+	return false;
+}
+
+/**
+ * Reassembles the fragments of a correction message, as telemetry unpacks
+ * them, and queues the message once it is whole.  Fragments of a message
+ * that lost one, and repeats of the last fragment, are dropped.
+ */
+static void gpsCorrectionUpdated(const UAVObjEvent *ev, void *ctx, void *obj_data,
+		int len)
+{
+	(void) ev; (void) ctx; (void) len;
+
+	const GPSCorrectionData *frag = obj_data;
+	struct gps_correction *corr = gpsCorrection;
+
+	if (!corr) {
+		corr = PIOS_malloc(sizeof(*corr));
+
+		if (!corr) {
+			return;
+		}
+
+		corr->queue = PIOS_SPSC_Queue_Create(1, GPS_CORRECTION_QUEUE_LEN, 1);
+
+		if (!corr->queue) {
+			PIOS_free(corr);
+			return;
+		}
+
+		corr->next_fragment = 0;
+		corr->sent_any = false;
+		gpsCorrection = corr;
+	}
+
+	if (frag->Fragment == 0) {
+		if (corr->sent_any && frag->Sequence == corr->sent_sequence) {
+			// Repeated; the GPS has it already
+			return;
+		}
+
+		corr->sequence = frag->Sequence;
+		corr->len = 0;
+	} else if (frag->Sequence != corr->sequence ||
+			frag->Fragment != corr->next_fragment) {
+		if (frag->Sequence != corr->sequence ||
+				frag->Fragment + 1 != corr->next_fragment) {
+			// Lost a fragment; wait for the next message
+			corr->next_fragment = 0;
+		}
+
+		return;
+	}
+
+	uint16_t frag_len = frag->Length;
+
+	if (frag_len > GPSCORRECTION_DATA_NUMELEM) {
+		frag_len = GPSCORRECTION_DATA_NUMELEM;
+	}
+
+	if (corr->len + frag_len > GPS_CORRECTION_MAX_LEN) {
+		corr->next_fragment = 0;
+		return;
+	}
+
+	memcpy(corr->msg + corr->len, frag->Data, frag_len);
+	corr->len += frag_len;
+	corr->next_fragment = frag->Fragment + 1;
+
+	if (corr->next_fragment < frag->Fragments) {
+		return;
+	}
+
+	// Whole; if the GPS is that far behind, this one is too old anyway
+	if (PIOS_SPSC_Queue_Space(corr->queue) >= corr->len) {
+		PIOS_SPSC_Queue_Send(corr->queue, corr->msg, corr->len, NULL);
+	}
+
+	corr->sent_sequence = corr->sequence;
+	corr->sent_any = true;
+	corr->next_fragment = 0;
+}
+
 /**
  * Update the GPS settings, called on startup.
  */
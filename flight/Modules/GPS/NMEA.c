@@ -29,6 +29,7 @@
 
 #include "openpilot.h"
 #include "pios.h"
+#include "pios_thread.h"
 
 #if defined(PIOS_INCLUDE_GPS_NMEA_PARSER)
 
@@ -110,6 +111,8 @@ int parse_nmea_stream (uint8_t c, char *gps_rx_buffer, GPSPositionData *GpsData,
 	// detect start while acquiring stream
 	if (!start_flag && (c == '$')) // NMEA identifier found
 	{
+		// Only GGA publishes the position, so this ends up being its start
+		GpsData->ReceivedTime = PIOS_Thread_Systime();
 		start_flag = true;
 		found_cr = false;
 		rx_count = 0;
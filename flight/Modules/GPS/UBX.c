@@ -30,6 +30,7 @@
 
 #include "openpilot.h"
 #include "pios.h"
+#include "pios_thread.h"
 
 #if defined(PIOS_INCLUDE_GPS_UBX_PARSER)
 
@@ -37,6 +38,8 @@
 #include "GPS.h"
 
 static uint32_t parse_errors;
+//! When the sync of the frame being received arrived
+static uint32_t frame_start_ms;
 
 static bool checksum_ubx_message(const struct UBXPacket *);
 static uint32_t parse_ubx_message(const struct UBXPacket *, GPSPositionData *);
@@ -64,8 +67,10 @@ int parse_ubx_stream (uint8_t c, char *gps_rx_buffer, GPSPositionData *GpsData,
 
 	switch (proto_state) {
 		case START: // detect protocol
-			if (c ==  UBX_SYNC1) // first UBX sync char found
+			if (c ==  UBX_SYNC1) { // first UBX sync char found
+				frame_start_ms = PIOS_Thread_Systime();
 				proto_state = UBX_SY2;
+			}
 			break;
 		case UBX_SY2:
 			if (c == UBX_SYNC2) // second UBX sync char found
@@ -147,6 +152,7 @@ int parse_ubx_stream (uint8_t c, char *gps_rx_buffer, GPSPositionData *GpsData,
 
 static struct msgtracker{
 		uint32_t	currentTOW;		// TOW of the message set currently in progress
+		uint32_t	arrivalMs;		// when the first message of the set arrived
 		uint8_t		msg_received;	// keep track of received message types
 	} msgtracker;
 
@@ -157,6 +163,7 @@ bool check_msgtracker (uint32_t tow, uint8_t msg_flag)
 	if (tow > msgtracker.currentTOW ? true                  // start of a new message set
 		: (msgtracker.currentTOW - tow > 6*24*3600*1000)) { // 6 days, TOW wrap around occured
 		msgtracker.currentTOW = tow;
+		msgtracker.arrivalMs = frame_start_ms;
 		msgtracker.msg_received = NONE_RECEIVED;
 	} else if (tow < msgtracker.currentTOW)	// message outdated (don't process)
 				return false;
@@ -253,6 +260,7 @@ static void parse_ubx_nav_velned (const struct UBX_NAV_VELNED *velned, GPSPositi
 			GpsVelocity.East	= (float)velned->velE/100.0f;
 			GpsVelocity.Down	= (float)velned->velD/100.0f;
 			GpsVelocity.Accuracy	= (float)velned->sAcc/100.0f;
+			GpsVelocity.ReceivedTime	= msgtracker.arrivalMs;
 			GPSVelocitySet(&GpsVelocity);
 			GpsPosition->Groundspeed = (float)velned->gSpeed * 0.01f;
 			GpsPosition->Heading = (float)velned->heading * 1.0e-5f;
@@ -260,6 +268,74 @@ static void parse_ubx_nav_velned (const struct UBX_NAV_VELNED *velned, GPSPositi
 	}
 }
 
+/**
+ * NAV-PVT carries what POSLLH, SOL and VELNED do between them, so one of
+ * these completes the set for its epoch.  Only the DOPs still come from
+ * NAV-DOP, which the receiver sends before NAV-PVT in each epoch.
+ */
+static void parse_ubx_nav_pvt (const struct UBX_NAV_PVT *pvt, GPSPositionData *GpsPosition)
+{
+	static uint8_t last_second = 0xff;
+
+	if (!check_msgtracker(pvt->iTOW, ALL_RECEIVED))
+		return;
+
+	GpsPosition->Satellites = pvt->numSV;
+	GpsPosition->PDOP = (float)pvt->pDOP * 0.01f;
+	GpsPosition->Accuracy = sqrtf((float)pvt->hAcc * pvt->hAcc +
+			(float)pvt->vAcc * pvt->vAcc) * 0.001f;
+
+	if (pvt->flags & PVT_FLAGS_GNSSFIX_OK) {
+		switch (pvt->fixType) {
+			case STATUS_GPSFIX_2DFIX:
+				GpsPosition->Status = GPSPOSITION_STATUS_FIX2D;
+				break;
+			case STATUS_GPSFIX_3DFIX:
+				GpsPosition->Status = (pvt->flags & PVT_FLAGS_DIFFSOLN) ?
+					GPSPOSITION_STATUS_DIFF3D : GPSPOSITION_STATUS_FIX3D;
+				break;
+			default: GpsPosition->Status = GPSPOSITION_STATUS_NOFIX;
+		}
+	} else
+		GpsPosition->Status = GPSPOSITION_STATUS_NOFIX;
+
+	if (GpsPosition->Status != GPSPOSITION_STATUS_NOFIX) {
+		GPSVelocityData GpsVelocity;
+
+		GpsPosition->Altitude = (float)pvt->hMSL*0.001f;
+		GpsPosition->GeoidSeparation = (float)(pvt->height - pvt->hMSL)*0.001f;
+		GpsPosition->Latitude = pvt->lat;
+		GpsPosition->Longitude = pvt->lon;
+		GpsPosition->Groundspeed = (float)pvt->gSpeed * 0.001f;
+		GpsPosition->Heading = (float)pvt->headMot * 1.0e-5f;
+
+		GpsVelocity.North	= (float)pvt->velN * 0.001f;
+		GpsVelocity.East	= (float)pvt->velE * 0.001f;
+		GpsVelocity.Down	= (float)pvt->velD * 0.001f;
+		GpsVelocity.Accuracy	= (float)pvt->sAcc * 0.001f;
+		GpsVelocity.ReceivedTime	= msgtracker.arrivalMs;
+		GPSVelocitySet(&GpsVelocity);
+	}
+
+	// The time changes far less often than the position is sent
+	if ((pvt->valid & (PVT_VALID_DATE | PVT_VALID_TIME)) ==
+			(PVT_VALID_DATE | PVT_VALID_TIME) &&
+			pvt->sec != last_second) {
+		GPSTimeData GpsTime;
+
+		GpsTime.Year = pvt->year;
+		GpsTime.Month = pvt->month;
+		GpsTime.Day = pvt->day;
+		GpsTime.Hour = pvt->hour;
+		GpsTime.Minute = pvt->min;
+		GpsTime.Second = pvt->sec;
+
+		GPSTimeSet(&GpsTime);
+
+		last_second = pvt->sec;
+	}
+}
+
 static void parse_ubx_nav_timeutc (const struct UBX_NAV_TIMEUTC *timeutc)
 {
 	if (!(timeutc->valid & TIMEUTC_VALIDWKN))
@@ -380,6 +456,10 @@ static uint32_t parse_ubx_message (const struct UBXPacket *ubx, GPSPositionData
 				case UBX_ID_VELNED:
 					parse_ubx_nav_velned (&ubx->payload.nav_velned, GpsPosition);
 					break;
+				case UBX_ID_PVT:
+					if (ubx->header.len >= UBX_NAV_PVT_MIN_LEN)
+						parse_ubx_nav_pvt (&ubx->payload.nav_pvt, GpsPosition);
+					break;
 				case UBX_ID_TIMEUTC:
 					parse_ubx_nav_timeutc (&ubx->payload.nav_timeutc);
 					break;
@@ -397,6 +477,7 @@ static uint32_t parse_ubx_message (const struct UBXPacket *ubx, GPSPositionData
 			break;
 	}
 	if (msgtracker.msg_received == ALL_RECEIVED) {
+		GpsPosition->ReceivedTime = msgtracker.arrivalMs;
 		GPSPositionSet(GpsPosition);
 		msgtracker.msg_received = NONE_RECEIVED;
 		id = GPSPOSITION_OBJID;
@@ -71,6 +71,7 @@
 #define UBLOX_NAV_STATUS    0x03
 #define UBLOX_NAV_DOP       0x04
 #define UBLOX_NAV_SOL       0x06
+#define UBLOX_NAV_PVT       0x07
 #define UBLOX_NAV_VELNED    0x12
 #define UBLOX_NAV_TIMEUTC   0x21
 #define UBLOX_NAV_SBAS      0x32
@@ -406,6 +407,32 @@ static void ubx_cfg_set_constellation(uintptr_t gps_port,
     ubx_cfg_send_checksummed(gps_port, msg, sizeof(msg));
 }
 
+//! Whether the receiver sends NAV-PVT, which replaces POSLLH, SOL and VELNED
+static bool ubx_cfg_has_pvt(uint8_t ver) {
+    return ver >= 8;
+}
+
+//! Enable the navigation messages that the parser combines into GPSPosition
+static void ubx_cfg_enable_messages(uintptr_t gps_port, uint8_t ver) {
+    if (ubx_cfg_has_pvt(ver)) {
+        ubx_cfg_enable_message(gps_port, UBLOX_NAV_CLASS, UBLOX_NAV_PVT, 1);       // NAV-PVT
+
+        // Saved configuration may still have these on; they're redundant now
+        ubx_cfg_enable_message(gps_port, UBLOX_NAV_CLASS, UBLOX_NAV_VELNED, 0);    // NAV-VELNED
+        ubx_cfg_enable_message(gps_port, UBLOX_NAV_CLASS, UBLOX_NAV_POSLLH, 0);    // NAV-POSLLH
+        ubx_cfg_enable_message(gps_port, UBLOX_NAV_CLASS, UBLOX_NAV_SOL, 0);       // NAV-SOL
+        ubx_cfg_enable_message(gps_port, UBLOX_NAV_CLASS, UBLOX_NAV_TIMEUTC, 0);   // NAV-TIMEUTC
+    } else {
+        ubx_cfg_enable_message(gps_port, UBLOX_NAV_CLASS, UBLOX_NAV_VELNED, 1);    // NAV-VELNED
+        ubx_cfg_enable_message(gps_port, UBLOX_NAV_CLASS, UBLOX_NAV_POSLLH, 1);    // NAV-POSLLH
+        ubx_cfg_enable_message(gps_port, UBLOX_NAV_CLASS, UBLOX_NAV_SOL, 1);       // NAV-SOL
+        ubx_cfg_enable_message(gps_port, UBLOX_NAV_CLASS, UBLOX_NAV_TIMEUTC, 5);   // NAV-TIMEUTC
+    }
+
+    ubx_cfg_enable_message(gps_port, UBLOX_NAV_CLASS, UBLOX_NAV_DOP, 1);       // NAV-DOP
+    ubx_cfg_enable_message(gps_port, UBLOX_NAV_CLASS, UBLOX_NAV_SVINFO, 5);    // NAV-SVINFO
+}
+
 //! Apply firmware version specific configuration tweaks
 static void ubx_cfg_version_specific(uintptr_t gps_port, uint8_t ver,
         ModuleSettingsGPSConstellationOptions constellation,
@@ -413,14 +440,19 @@ static void ubx_cfg_version_specific(uintptr_t gps_port, uint8_t ver,
     // Enable satellite-based differential GPS.
     ubx_cfg_set_sbas(gps_port, sbas_const);
 
-    if (ver >= 8) {
-        // 10Hz for ver 8, unless 'ALL' constellations in which case we
-        // are 5Hz
-        // TODO: Detect modules where we can ask for 18/10Hz instead
+    if (ver >= 9) {
+        // 20Hz for ver 9 and above, with any constellations; NAV-PVT
+        // keeps that within what the link carries
+        ubx_cfg_set_rate(gps_port, (uint16_t)50);
+
+        ubx_cfg_set_constellation(gps_port, constellation, sbas_const);
+    } else if (ver >= 8) {
+        // Ver 8 does 18Hz with one constellation, but only 10Hz when
+        // tracking 'ALL' of them
         if (constellation == MODULESETTINGS_GPSCONSTELLATION_ALL) {
-            ubx_cfg_set_rate(gps_port, (uint16_t)200);
-        } else {
             ubx_cfg_set_rate(gps_port, (uint16_t)100);
+        } else {
+            ubx_cfg_set_rate(gps_port, (uint16_t)56);
         }
 
         ubx_cfg_set_constellation(gps_port, constellation, sbas_const);
@@ -500,23 +532,17 @@ void ubx_cfg_send_configuration(uintptr_t gps_port, char *buffer,
         UBloxInfoGet(&ublox);
     } while (ublox.swVersion == 0 && i++ < 10);
 
-    ubx_cfg_enable_message(gps_port, UBLOX_NAV_CLASS, UBLOX_NAV_VELNED, 1);    // NAV-VELNED
-    ubx_cfg_enable_message(gps_port, UBLOX_NAV_CLASS, UBLOX_NAV_POSLLH, 1);    // NAV-POSLLH
-    ubx_cfg_enable_message(gps_port, UBLOX_NAV_CLASS, UBLOX_NAV_SOL, 1);       // NAV-SOL
-    ubx_cfg_enable_message(gps_port, UBLOX_NAV_CLASS, UBLOX_NAV_TIMEUTC, 5);   // NAV-TIMEUTC
-    ubx_cfg_enable_message(gps_port, UBLOX_NAV_CLASS, UBLOX_NAV_DOP, 1);       // NAV-DOP
-    ubx_cfg_enable_message(gps_port, UBLOX_NAV_CLASS, UBLOX_NAV_SVINFO, 5);    // NAV-SVINFO
-
-    ubx_cfg_set_mode(gps_port, dyn_mode);
-
     // Hardcoded version. The poll version method should fetch the
     // data but we need to link to that.
+    uint8_t ver = 6;
     if (ublox.hwVersion > 0)
-        ubx_cfg_version_specific(gps_port, floorf(ublox.hwVersion),
-                constellation, sbas_const);
-    else
-        ubx_cfg_version_specific(gps_port, 6,
-                constellation, sbas_const);
+        ver = floorf(ublox.hwVersion);
+
+    ubx_cfg_enable_messages(gps_port, ver);
+
+    ubx_cfg_set_mode(gps_port, dyn_mode);
+
+    ubx_cfg_version_specific(gps_port, ver, constellation, sbas_const);
 }
 
 //! Make sure the GPS is set to the same baud
@@ -10,6 +10,14 @@
  * @author     dRonin, http://dronin.org Copyright (C) 2015
  * @brief      Check the UAV is within the geofence boundaries
  *
+ * Besides the radius around home, the fence can have a ceiling and any
+ * number of polygons, sent as @ref GeoFenceVertex instances.  The polygons
+ * are indexed by splitting their north-south extent into bands, each
+ * listing the edges that cross it.  Whether a point is inside then only
+ * takes the edges of its band, and the nearest edge is searched for band
+ * by band outward from it, stopping once a band is further away than the
+ * nearest edge found so far.
+ *
  * @see        The GNU Public License (GPL) Version 3
  *
  *****************************************************************************/
@@ -35,6 +43,8 @@
 #include "physical_constants.h"
 
 #include "geofencesettings.h"
+#include "geofencestatus.h"
+#include "geofencevertex.h"
 #include "positionactual.h"
 #include "modulesettings.h"
 
@@ -43,19 +53,40 @@
 // Configuration
 //
 #define SAMPLE_PERIOD_MS     250
+#define MAX_VERTICES         64
+#define NUM_BANDS            16
+//! Polygon number of vertices that aren't part of the fence
+#define POLYGON_UNUSED       255
 
 // Private types
 
-// Private variables
+//! Polygon edges, bucketed by the north-south bands they cross
+struct fence_polygons {
+	float vertex[MAX_VERTICES][2];		// north, east
+	uint8_t next[MAX_VERTICES];		// other end of the edge from each vertex
+	uint8_t num_vertices;
+
+	float band_north;			// south edge of the first band
+	float band_height;
+	uint16_t band_start[NUM_BANDS + 1];	// into band_edges
+	uint8_t band_edges[MAX_VERTICES * NUM_BANDS];
+};
 
 // Private functions
 static void settingsUpdated(const UAVObjEvent *ev,
 		void *ctx, void *obj, int len);
+static void verticesUpdated(const UAVObjEvent *ev,
+		void *ctx, void *obj, int len);
 static void checkPosition(const UAVObjEvent *ev,
 		void *ctx, void *obj, int len);
+static void buildPolygons(struct fence_polygons *fence);
+static float polygonDistance(const struct fence_polygons *fence,
+		float north, float east);
 
 // Private variables
 static GeoFenceSettingsData *geofenceSettings;
+static struct fence_polygons *fencePolygons;
+static volatile bool verticesChanged;
 
 /**
  * Initialise the module, called on startup
@@ -77,7 +108,9 @@ int32_t GeofenceInitialize(void)
 	}
 #endif
 
-	if (GeoFenceSettingsInitialize() == -1) {
+	if (GeoFenceSettingsInitialize() == -1 ||
+			GeoFenceStatusInitialize() == -1 ||
+			GeoFenceVertexInitialize() == -1) {
 		module_enabled = false;
 		return -1;
 	}
@@ -85,7 +118,8 @@ int32_t GeofenceInitialize(void)
 	if (module_enabled) {
 		// allocate and initialize the static data storage only if module is enabled
 		geofenceSettings = (GeoFenceSettingsData *) PIOS_malloc(sizeof(GeoFenceSettingsData));
-		if (geofenceSettings == NULL) {
+		fencePolygons = (struct fence_polygons *) PIOS_malloc(sizeof(*fencePolygons));
+		if (geofenceSettings == NULL || fencePolygons == NULL) {
 			module_enabled = false;
 			return -1;
 		}
@@ -93,6 +127,9 @@ int32_t GeofenceInitialize(void)
 		GeoFenceSettingsConnectCallback(settingsUpdated);
 		settingsUpdated(NULL, NULL, NULL, 0);
 
+		GeoFenceVertexConnectCallback(verticesUpdated);
+		buildPolygons(fencePolygons);
+
 		return 0;
 	}
 
@@ -127,16 +164,49 @@ static void checkPosition(const UAVObjEvent *ev,
 		void *ctx, void *obj, int len)
 {
 	(void) ev; (void) ctx; (void) obj; (void) len;
+
+	// Rebuilt here rather than on each vertex, so an upload is indexed once
+	if (verticesChanged) {
+		verticesChanged = false;
+		buildPolygons(fencePolygons);
+	}
+
 	if (PositionActualHandle()) {
 		PositionActualData positionActual;
 		PositionActualGet(&positionActual);
 
-		const float distance2 = powf(positionActual.North, 2) + powf(positionActual.East, 2);
+		GeoFenceStatusData status;
+
+		const float distance = sqrtf(powf(positionActual.North, 2) + powf(positionActual.East, 2));
+
+		status.BoundaryDistance = geofenceSettings->ErrorRadius - distance;
+		status.CeilingDistance = 0;
+
+		bool error = distance > geofenceSettings->ErrorRadius;
+		bool warning = distance > geofenceSettings->WarningRadius;
 
-		// ErrorRadius is squared when it is fetched, so this is correct
-		if (distance2 > geofenceSettings->ErrorRadius) {
+		if (fencePolygons->num_vertices) {
+			float edge = polygonDistance(fencePolygons,
+					positionActual.North, positionActual.East);
+
+			status.BoundaryDistance = MIN(status.BoundaryDistance, edge);
+
+			error |= edge < 0;
+			warning |= edge < geofenceSettings->WarningDistance;
+		}
+
+		if (geofenceSettings->Ceiling) {
+			status.CeilingDistance = geofenceSettings->Ceiling + positionActual.Down;
+
+			error |= status.CeilingDistance < 0;
+			warning |= status.CeilingDistance < geofenceSettings->WarningDistance;
+		}
+
+		GeoFenceStatusSet(&status);
+
+		if (error) {
 			AlarmsSet(SYSTEMALARMS_ALARM_GEOFENCE, SYSTEMALARMS_ALARM_ERROR);
-		} else if (distance2 > geofenceSettings->WarningRadius) {
+		} else if (warning) {
 			AlarmsSet(SYSTEMALARMS_ALARM_GEOFENCE, SYSTEMALARMS_ALARM_WARNING);
 		} else {
 			AlarmsClear(SYSTEMALARMS_ALARM_GEOFENCE);
@@ -152,10 +222,175 @@ static void settingsUpdated(const UAVObjEvent *ev,
 {
 	(void) ev; (void) ctx; (void) obj; (void) len;
 	GeoFenceSettingsGet(geofenceSettings);
+}
+
+static void verticesUpdated(const UAVObjEvent *ev,
+		void *ctx, void *obj, int len)
+{
+	(void) ev; (void) ctx; (void) obj; (void) len;
+	verticesChanged = true;
+}
+
+//! Join the last vertex of a polygon to its first, or drop it if too small
+static uint8_t closePolygon(struct fence_polygons *fence, uint8_t first, uint8_t end)
+{
+	if (end - first < 3) {
+		return first;
+	}
+
+	fence->next[end - 1] = first;
+
+	return end;
+}
+
+/**
+ * Collect the vertices into closed polygons and bucket their edges.
+ * Runs of fewer than three vertices with the same polygon are skipped.
+ */
+static void buildPolygons(struct fence_polygons *fence)
+{
+	uint16_t num_inst = MIN(UAVObjGetNumInstances(GeoFenceVertexHandle()), MAX_VERTICES);
+
+	uint8_t n = 0, first = 0;
+	uint8_t polygon = POLYGON_UNUSED;
+
+	for (uint16_t i = 0; i < num_inst; i++) {
+		GeoFenceVertexData vertex;
+		GeoFenceVertexInstGet(i, &vertex);
+
+		if (vertex.Polygon != polygon) {
+			n = closePolygon(fence, first, n);
+			first = n;
+			polygon = vertex.Polygon;
+		}
+
+		if (polygon == POLYGON_UNUSED) {
+			continue;
+		}
+
+		fence->vertex[n][0] = vertex.Position[GEOFENCEVERTEX_POSITION_NORTH];
+		fence->vertex[n][1] = vertex.Position[GEOFENCEVERTEX_POSITION_EAST];
+		fence->next[n] = n + 1;
+		n++;
+	}
+
+	fence->num_vertices = closePolygon(fence, first, n);
+
+	float north_min = 0, north_max = 0;
+
+	for (uint8_t i = 0; i < fence->num_vertices; i++) {
+		float north = fence->vertex[i][0];
+
+		if (i == 0 || north < north_min) {
+			north_min = north;
+		}
+		if (i == 0 || north > north_max) {
+			north_max = north;
+		}
+	}
+
+	fence->band_north = north_min;
+	fence->band_height = MAX(north_max - north_min, 1.0f) / NUM_BANDS;
+
+	uint16_t count = 0;
+
+	for (uint8_t b = 0; b < NUM_BANDS; b++) {
+		float south = fence->band_north + b * fence->band_height;
+		float north = south + fence->band_height;
+
+		fence->band_start[b] = count;
+
+		for (uint8_t i = 0; i < fence->num_vertices; i++) {
+			float a = fence->vertex[i][0];
+			float c = fence->vertex[fence->next[i]][0];
+
+			if (MAX(a, c) >= south && MIN(a, c) <= north) {
+				fence->band_edges[count++] = i;
+			}
+		}
+	}
+
+	fence->band_start[NUM_BANDS] = count;
+}
+
+//! Distance from a point to the segment between two vertices
+static float edgeDistance(const float *a, const float *b,
+		float north, float east)
+{
+	float dn = b[0] - a[0];
+	float de = b[1] - a[1];
+	float len2 = dn * dn + de * de;
+	float t = 0;
+
+	if (len2 > 0) {
+		t = ((north - a[0]) * dn + (east - a[1]) * de) / len2;
+		t = bound_min_max(t, 0, 1);
+	}
+
+	return sqrtf(powf(north - a[0] - t * dn, 2) + powf(east - a[1] - t * de, 2));
+}
+
+/**
+ * Find how far a point is from the nearest polygon edge
+ * \return the distance, positive inside the fence and negative outside
+ */
+static float polygonDistance(const struct fence_polygons *fence,
+		float north, float east)
+{
+	int32_t band = floorf((north - fence->band_north) / fence->band_height);
+	bool inside = false;
+
+	// Even-odd rule: crossings of a ray due east, from the point's band
+	if (band >= 0 && band < NUM_BANDS) {
+		for (uint16_t j = fence->band_start[band]; j < fence->band_start[band + 1]; j++) {
+			const float *a = fence->vertex[fence->band_edges[j]];
+			const float *b = fence->vertex[fence->next[fence->band_edges[j]]];
+
+			if ((a[0] > north) != (b[0] > north) &&
+					east < a[1] + (north - a[0]) * (b[1] - a[1]) / (b[0] - a[0])) {
+				inside = !inside;
+			}
+		}
+	}
+
+	band = MIN(MAX(band, 0), NUM_BANDS - 1);
+
+	float best = INFINITY;
+
+	for (int32_t step = 0; step < NUM_BANDS; step++) {
+		bool searched = false;
+
+		for (int32_t dir = -1; dir <= 1; dir += 2) {
+			int32_t b = band + dir * step;
+
+			if (b < 0 || b >= NUM_BANDS || (step == 0 && dir > 0)) {
+				continue;
+			}
+
+			// How far the point is from this band, north-south
+			float south = fence->band_north + b * fence->band_height;
+			float gap = MAX(MAX(south - north, north - south - fence->band_height), 0);
+
+			if (gap >= best) {
+				continue;
+			}
+
+			searched = true;
+
+			for (uint16_t j = fence->band_start[b]; j < fence->band_start[b + 1]; j++) {
+				const float *a = fence->vertex[fence->band_edges[j]];
+				const float *c = fence->vertex[fence->next[fence->band_edges[j]]];
+
+				best = MIN(best, edgeDistance(a, c, north, east));
+			}
+		}
+
+		if (!searched && step > 0) {
+			break;
+		}
+	}
 
-	// Cache squared distances to save computations
-	geofenceSettings->WarningRadius = powf(geofenceSettings->WarningRadius, 2);
-	geofenceSettings->ErrorRadius = powf(geofenceSettings->ErrorRadius, 2);
+	return inside ? best : -best;
 }
 
 /**
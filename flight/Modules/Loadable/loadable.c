@@ -29,23 +29,61 @@
 #include "openpilot.h"
 #include <stdbool.h>
 #include "pios_thread.h"
+#include "pios_mutex.h"
 
 #include "loadable_extension.h"
 
 #include "modulesettings.h"
+#include "loadableextensions.h"
 
 #define MOD_RAM_BEGIN    0x10000000
 #define MOD_RODATA_BEGIN 0x20000000
 #define MOD_CALLS_BEGIN  0xdf000000
 
+/* These must match the ends of the call addresses in
+ * loadable.example/module_layout.ld */
 #define CALL_DO_DUMB_TEST_DELAY 0xdf000001
 #define CALL_PIOS_THREAD_CREATE 0xdf000003
 #define CALL_PIOS_THREAD_SLEEP  0xdf000005
 #define CALL_DO_DUMB_REGTASK    0xdf000007
 #define CALL_ANNUNC_CUSTOM      0xdf000009
+#define CALL_PIOS_MALLOC        0xdf00000b
+#define CALL_PIOS_FREE          0xdf00000d
+#define CALL_PIOS_THREAD_DELETE 0xdf00000f
+
+#define MAX_EXTENSIONS LOADABLEEXTENSIONS_STATE_NUMELEM
+
+/* Everything allocated for an extension starts with this, so that it can
+ * all be counted, and freed when the extension stops.  It comes from the
+ * block pools, since the heap can't take anything back.
+ */
+struct ext_alloc {
+	struct ext_alloc *next;
+	uint32_t size;
+};
+
+struct ext_instance {
+	const struct loadable_extension *ext;
+	void *data_seg;
+	void *ram_seg;		/* Kept across restarts, for data_seg */
+	struct ext_alloc *allocs;
+	uint32_t heap_used;
+	uint8_t state;
+};
 
 static bool module_enabled;
 
+static struct ext_instance extensions[MAX_EXTENSIONS];
+static int num_extensions;
+static struct pios_mutex *alloc_mutex;
+
+/* Whose thread TASKINFO_RUNNING_LOADABLE shows; there's just the one */
+static struct ext_instance *taskinfo_owner;
+
+static void publish_heap_used(void);
+static void commands_updated(const UAVObjEvent *ev, void *ctx, void *obj,
+		int len);
+
 static int32_t loadable_initialize(void)
 {
 #ifdef MODULE_Loadable_BUILTIN
@@ -60,11 +98,111 @@ static int32_t loadable_initialize(void)
 	}
 #endif
 
+	if (!module_enabled) {
+		return 0;
+	}
+
+	alloc_mutex = PIOS_Mutex_Create();
+
+	if (!alloc_mutex) {
+		module_enabled = false;
+		return -1;
+	}
+
+	if (LoadableExtensionsInitialize() == -1) {
+		module_enabled = false;
+		return -1;
+	}
+
 	return 0;
 }
 
-static uint32_t construct_trampoline(struct loadable_extension *ext,
-		void *data_seg, uint32_t got_addr)
+static void *ext_malloc(struct ext_instance *inst, size_t size)
+{
+	struct ext_alloc *alloc = PIOS_pool_malloc(sizeof(*alloc) + size);
+
+	if (!alloc) {
+		return NULL;
+	}
+
+	alloc->size = size;
+
+	PIOS_Mutex_Lock(alloc_mutex, PIOS_MUTEX_TIMEOUT_MAX);
+	alloc->next = inst->allocs;
+	inst->allocs = alloc;
+	inst->heap_used += size;
+	PIOS_Mutex_Unlock(alloc_mutex);
+
+	return alloc + 1;
+}
+
+static void ext_free(struct ext_instance *inst, void *ptr)
+{
+	if (!ptr) {
+		return;
+	}
+
+	struct ext_alloc *alloc = ((struct ext_alloc *) ptr) - 1;
+	bool found = false;
+
+	PIOS_Mutex_Lock(alloc_mutex, PIOS_MUTEX_TIMEOUT_MAX);
+
+	for (struct ext_alloc **link = &inst->allocs; *link;
+			link = &(*link)->next) {
+		if (*link == alloc) {
+			*link = alloc->next;
+			inst->heap_used -= alloc->size;
+			found = true;
+			break;
+		}
+	}
+
+	PIOS_Mutex_Unlock(alloc_mutex);
+
+	/* Not something it was given; leave it be rather than corrupt
+	 * the heap */
+	if (found) {
+		PIOS_pool_free(alloc);
+	}
+}
+
+static void ext_free_all(struct ext_instance *inst)
+{
+	PIOS_Mutex_Lock(alloc_mutex, PIOS_MUTEX_TIMEOUT_MAX);
+
+	struct ext_alloc *alloc = inst->allocs;
+
+	inst->allocs = NULL;
+	inst->heap_used = 0;
+
+	PIOS_Mutex_Unlock(alloc_mutex);
+
+	while (alloc) {
+		struct ext_alloc *next = alloc->next;
+
+		PIOS_pool_free(alloc);
+		alloc = next;
+	}
+}
+
+/* Which extension a call came from, by its data segment: extension code,
+ * and the trampolines into it, always has that in r9.
+ */
+static struct ext_instance *ext_by_data_seg(uintptr_t data_seg)
+{
+	for (int i = 0; i < num_extensions; i++) {
+		if (extensions[i].data_seg &&
+				(uintptr_t) extensions[i].data_seg == data_seg) {
+			return &extensions[i];
+		}
+	}
+
+	return NULL;
+}
+
+/* Never inlined: the labels in the asm below can only appear once */
+static uint32_t __attribute__((noinline))
+construct_trampoline(struct ext_instance *inst, uint32_t got_addr)
 {
 	/* FLASH relative offset */
 
@@ -93,7 +231,7 @@ static uint32_t construct_trampoline(struct loadable_extension *ext,
 		"trampend:\n\t"
 		: "=r" (tramp_len), "=r" (tramp_template));
 
-	uint32_t *tramp_alloc = PIOS_malloc(tramp_len);
+	uint32_t *tramp_alloc = ext_malloc(inst, tramp_len);
 
 	if (!tramp_alloc) {
 		return 0;
@@ -101,24 +239,67 @@ static uint32_t construct_trampoline(struct loadable_extension *ext,
 
 	memcpy(tramp_alloc, tramp_template, tramp_len);
 
-	tramp_alloc[(tramp_len / 4) - 2] = ((uintptr_t) ext) + got_addr;
-	tramp_alloc[(tramp_len / 4) - 1] = (uintptr_t) data_seg;
+	tramp_alloc[(tramp_len / 4) - 2] = ((uintptr_t) inst->ext) + got_addr;
+	tramp_alloc[(tramp_len / 4) - 1] = (uintptr_t) inst->data_seg;
 
 	return ((uint32_t) tramp_alloc) + 1;
 }
 
-static void *layout_extension_ram(struct loadable_extension *ext)
+/* Turn one link-time address into where it is now */
+static bool relocate_word(struct ext_instance *inst, uint32_t *word)
+{
+	const struct loadable_extension *ext = inst->ext;
+	uint32_t addr = *word;
+
+	if (addr >= MOD_CALLS_BEGIN) {
+		/* df... These shouldn't really show up in
+		 * GOT, but ignore them if they do
+		 */
+	} else if (addr >= MOD_RODATA_BEGIN) {
+		/* RODATA.  Convert to a flash memory address */
+		*word = ((uint32_t) ext) + addr - MOD_RODATA_BEGIN;
+	} else if (addr >= MOD_RAM_BEGIN) {
+		/* RAM-resident relative offset */
+		*word = (uint32_t) ((char *) inst->data_seg + addr -
+				MOD_RAM_BEGIN - ext->ram_seg_copyoff);
+	} else if (addr) {
+		/* Code address, presumably used in callback.  It
+		 * needs a trampoline that ensures that R9 is set.
+		 */
+		*word = construct_trampoline(inst, addr);
+
+		if (!*word) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static bool layout_extension_ram(struct ext_instance *inst)
 {
+	const struct loadable_extension *ext = inst->ext;
 	char *new_seg;
 
 	/* Allocate a data segment, and copy the things that matter
-	 * from it.
+	 * from it.  It can be larger than any pool block, so rather than
+	 * lose one to the heap on each start, the first is kept and reused.
 	 */
-	new_seg = PIOS_malloc(ext->ram_seg_len);
-	if (!new_seg) {
-		return NULL;
+	if (!inst->ram_seg) {
+		inst->ram_seg = PIOS_malloc(ext->ram_seg_len);
+
+		if (!inst->ram_seg) {
+			return false;
+		}
 	}
 
+	new_seg = inst->ram_seg;
+	inst->data_seg = new_seg;
+
+	PIOS_Mutex_Lock(alloc_mutex, PIOS_MUTEX_TIMEOUT_MAX);
+	inst->heap_used += ext->ram_seg_len;
+	PIOS_Mutex_Unlock(alloc_mutex);
+
 	memcpy(new_seg,
 			(void *) (((uintptr_t) ext) + ext->ram_seg_copyoff),
 			ext->ram_seg_copylen);
@@ -127,47 +308,37 @@ static void *layout_extension_ram(struct loadable_extension *ext)
 	memset(new_seg + ext->ram_seg_copylen, 0,
 			ext->ram_seg_len - ext->ram_seg_copylen);
 
-	/* process relocations */
+	/* process relocations: first the GOT, then the data words the
+	 * table made at build time says hold addresses */
 	uint32_t *got = (uint32_t *) new_seg;
 
 	for (int i = 0; i < (ext->ram_seg_gotlen / sizeof(uint32_t)); i++) {
-		if (got[i] >= MOD_CALLS_BEGIN) {
-			/* df... These shouldn't really show up in
-			 * GOT, but ignore them if they do
-			 */
-		} else if (got[i] >= MOD_RODATA_BEGIN) {
-			/* RODATA.  Convert to a flash memory address */
-
-			got[i] = ((uint32_t) ext) + got[i] - MOD_RODATA_BEGIN;
-		} else if (got[i] >= MOD_RAM_BEGIN) {
-			/* RAM-resident relative offset */
-			got[i] = (uint32_t) (new_seg + got[i] - MOD_RAM_BEGIN - ext->ram_seg_copyoff);
-		} else if (got[i]) {
-			/* Code address, presumably used in callback.  It
-			 * needs a trampoline that ensures that R9 is set.
-			 */
-			got[i] = construct_trampoline(ext, new_seg, got[i]);
-
-			if (!got[i]) {
-				return NULL;
+		if (!relocate_word(inst, &got[i])) {
+			return false;
+		}
+	}
+
+	if (ext->reloc_offset) {
+		const struct loadable_relocs *relocs = (const void *)
+			(((uintptr_t) ext) + ext->reloc_offset);
+
+		for (uint32_t i = 0; i < relocs->count; i++) {
+			if (!relocate_word(inst,
+					(uint32_t *) (new_seg + relocs->offsets[i]))) {
+				return false;
 			}
 		}
 	}
 
-	return new_seg;
+	return true;
 }
 
-static void invoke_one_loadable(struct loadable_extension *ext)
+static void call_extension(void *seg, uintptr_t offset_in_ext,
+		const struct loadable_extension *ext)
 {
-	/* XXX check payload CRC. */
-
-	register void *data_seg asm("r9") = layout_extension_ram(ext);
-
-	if (!data_seg) {
-		return;
-	}
+	register void *data_seg asm("r9") = seg;
 
-	void (*entry)() = (void *) (((uintptr_t) ext) + ext->entry_offset);
+	void (*entry)() = (void *) (((uintptr_t) ext) + offset_in_ext);
 
 	asm volatile(
 		"blx %0\n\t"
@@ -183,7 +354,115 @@ static void invoke_one_loadable(struct loadable_extension *ext)
 		);
 }
 
-static void invoke_loadables()
+static void start_extension(struct ext_instance *inst)
+{
+	if (inst->state == LOADABLEEXTENSIONS_STATE_RUNNING) {
+		return;
+	}
+
+	/* XXX check payload CRC. */
+
+	if (!layout_extension_ram(inst)) {
+		ext_free_all(inst);
+		inst->data_seg = NULL;
+		inst->state = LOADABLEEXTENSIONS_STATE_FAILED;
+		return;
+	}
+
+	inst->state = LOADABLEEXTENSIONS_STATE_RUNNING;
+
+	call_extension(inst->data_seg, inst->ext->entry_offset, inst->ext);
+}
+
+static void stop_extension(struct ext_instance *inst)
+{
+	if (inst->state != LOADABLEEXTENSIONS_STATE_RUNNING ||
+			!inst->ext->exit_offset) {
+		return;
+	}
+
+	/* Its thread may be the one being shown, and is going away */
+	if (taskinfo_owner == inst) {
+		TaskMonitorRemove(TASKINFO_RUNNING_LOADABLE);
+		taskinfo_owner = NULL;
+	}
+
+	call_extension(inst->data_seg, inst->ext->exit_offset, inst->ext);
+
+	/* It has let go of everything, so this takes the trampolines too;
+	 * the data segment stays for the next start */
+	ext_free_all(inst);
+	inst->data_seg = NULL;
+	inst->state = LOADABLEEXTENSIONS_STATE_STOPPED;
+}
+
+static bool validate_extension(const struct loadable_extension *ext,
+		uint32_t space)
+{
+	/* Validate header before trying to go further */
+
+	if (ext->magic != LOADABLE_EXTENSION_MAGIC) {
+		return false;
+	}
+
+	if (ext->length < sizeof(struct loadable_extension) ||
+			ext->length > space) {
+		return false;
+	}
+
+	if (ext->require_version == LOADABLE_REQUIRE_VERSION_INVALID ||
+			ext->require_version > LOADABLE_VERSION_CURRENT) {
+		return false;
+	}
+
+	if (ext->entry_offset >= ext->length) {
+		return false;
+	}
+
+	if (ext->entry_offset < sizeof(struct loadable_extension)) {
+		return false;
+	}
+
+	if (ext->exit_offset && (ext->exit_offset >= ext->length ||
+			ext->exit_offset < sizeof(struct loadable_extension))) {
+		return false;
+	}
+
+	if (ext->reloc_offset) {
+		if ((ext->reloc_offset & 3) ||
+				ext->reloc_offset < sizeof(struct loadable_extension) ||
+				ext->reloc_offset > ext->length - sizeof(uint32_t)) {
+			return false;
+		}
+
+		const struct loadable_relocs *relocs = (const void *)
+			(((uintptr_t) ext) + ext->reloc_offset);
+
+		if (relocs->count > (ext->length - ext->reloc_offset -
+					sizeof(uint32_t)) / sizeof(uint32_t)) {
+			return false;
+		}
+
+		/* Every fixup has to be an initialised word of RAM */
+		for (uint32_t i = 0; i < relocs->count; i++) {
+			if ((relocs->offsets[i] & 3) ||
+					relocs->offsets[i] + sizeof(uint32_t) >
+					ext->ram_seg_copylen) {
+				return false;
+			}
+		}
+	}
+
+	/* XXX test the data seg related things for sanity */
+
+	/* XXX alignment requirements */
+
+	/* XXX check CRC */
+
+	return true;
+}
+
+static void find_extensions()
 {
 	uintptr_t part_id;
 
@@ -204,42 +483,92 @@ static void invoke_loadables()
 
 	uint32_t part_pos = 0;
 
-	while ((part_pos + sizeof(struct loadable_extension)) < part_len) {
-		struct loadable_extension *ext =
+	while ((part_pos + sizeof(struct loadable_extension)) < part_len &&
+			num_extensions < MAX_EXTENSIONS) {
+		const struct loadable_extension *ext =
 			(void *) (part_beginning + part_pos);
 
-		/* Validate header before trying to go further */
-
-		if (ext->magic != LOADABLE_EXTENSION_MAGIC) {
+		if (!validate_extension(ext, part_len - part_pos)) {
 			return;
 		}
 
-		if (ext->length < sizeof(struct loadable_extension)) {
-			return;
-		}
+		struct ext_instance *inst = &extensions[num_extensions++];
 
-		if (ext->require_version == LOADABLE_REQUIRE_VERSION_INVALID) {
-			return;
-		}
+		inst->ext = ext;
+		inst->state = LOADABLEEXTENSIONS_STATE_STOPPED;
 
-		if (ext->entry_offset >= ext->length) {
-			return;
-		}
+		part_pos += ext->length;
+	}
+}
 
-		if (ext->entry_offset < sizeof(struct loadable_extension)) {
-			return;
+static void publish_heap_used(void)
+{
+	uint32_t heap_used[LOADABLEEXTENSIONS_HEAPUSED_NUMELEM] = { 0 };
+
+	for (int i = 0; i < num_extensions; i++) {
+		heap_used[i] = extensions[i].heap_used;
+	}
+
+	LoadableExtensionsHeapUsedSet(heap_used);
+}
+
+static void publish_status(void)
+{
+	LoadableExtensionsData status;
+
+	LoadableExtensionsGet(&status);
+
+	for (int i = 0; i < MAX_EXTENSIONS; i++) {
+		if (i < num_extensions) {
+			status.State[i] = extensions[i].state;
+			status.Length[i] = extensions[i].ext->length;
+			status.HeapUsed[i] = extensions[i].heap_used;
+		} else {
+			status.State[i] = LOADABLEEXTENSIONS_STATE_EMPTY;
+			status.Length[i] = 0;
+			status.HeapUsed[i] = 0;
 		}
 
-		/* XXX test the data seg related things for sanity */
+		status.Command[i] = LOADABLEEXTENSIONS_COMMAND_NONE;
+	}
 
-		/* XXX alignment requirements */
+	LoadableExtensionsSet(&status);
+}
 
-		/* XXX check CRC */
+static void commands_updated(const UAVObjEvent *ev, void *ctx, void *obj,
+		int len)
+{
+	(void) ev; (void) ctx; (void) obj; (void) len;
 
-		invoke_one_loadable(ext);
+	uint8_t commands[LOADABLEEXTENSIONS_COMMAND_NUMELEM];
 
-		part_pos += ext->length;
+	LoadableExtensionsCommandGet(commands);
+
+	bool commanded = false;
+
+	for (int i = 0; i < MAX_EXTENSIONS; i++) {
+		if (commands[i] != LOADABLEEXTENSIONS_COMMAND_NONE) {
+			commanded = true;
+		}
+	}
+
+	/* Including when it's this module's own update */
+	if (!commanded) {
+		return;
 	}
+
+	for (int i = 0; i < num_extensions; i++) {
+		switch (commands[i]) {
+		case LOADABLEEXTENSIONS_COMMAND_START:
+			start_extension(&extensions[i]);
+			break;
+		case LOADABLEEXTENSIONS_COMMAND_STOP:
+			stop_extension(&extensions[i]);
+			break;
+		}
+	}
+
+	publish_status();
 }
 
 static int32_t loadable_start(void)
@@ -248,7 +577,15 @@ static int32_t loadable_start(void)
 		return 0;
 	}
 
-	invoke_loadables();
+	find_extensions();
+
+	for (int i = 0; i < num_extensions; i++) {
+		start_extension(&extensions[i]);
+	}
+
+	publish_status();
+
+	LoadableExtensionsConnectCallback(commands_updated);
 
 	return 0;
 }
@@ -256,9 +593,79 @@ static int32_t loadable_start(void)
 
 MODULE_INITCALL(loadable_initialize, loadable_start)
 
-static void do_dumb_regtask(struct pios_thread *h)
+/* Heap calls from extensions come with the caller's data segment, so
+ * what they take is put down to them.
+ */
+void *loadable_malloc_C(size_t size, uintptr_t data_seg)
+{
+	struct ext_instance *inst = ext_by_data_seg(data_seg);
+
+	if (!inst) {
+		return NULL;
+	}
+
+	void *ptr = ext_malloc(inst, size);
+
+	publish_heap_used();
+
+	return ptr;
+}
+
+void loadable_free_C(void *ptr, uintptr_t data_seg)
+{
+	struct ext_instance *inst = ext_by_data_seg(data_seg);
+
+	if (!inst) {
+		return;
+	}
+
+	ext_free(inst, ptr);
+
+	publish_heap_used();
+}
+
+void loadable_malloc(void) __attribute__((naked));
+void loadable_free(void) __attribute__((naked));
+
+void loadable_malloc(void)
+{
+	asm volatile(
+		"mov r1, r9\n\t"
+		"b loadable_malloc_C\n\t"
+		: );
+}
+
+void loadable_free(void)
+{
+	asm volatile(
+		"mov r1, r9\n\t"
+		"b loadable_free_C\n\t"
+		: );
+}
+
+/* Found by data segment like the allocations, so that stopping another
+ * extension doesn't take this one's thread off the task list.
+ */
+void loadable_regtask_C(struct pios_thread *h, uintptr_t data_seg)
+{
+	struct ext_instance *inst = ext_by_data_seg(data_seg);
+
+	if (!inst) {
+		return;
+	}
+
+	TaskMonitorAdd(TASKINFO_RUNNING_LOADABLE, h);
+	taskinfo_owner = inst;
+}
+
+void loadable_regtask(void) __attribute__((naked));
+
+void loadable_regtask(void)
 {
-        TaskMonitorAdd(TASKINFO_RUNNING_LOADABLE, h);
+	asm volatile(
+		"mov r1, r9\n\t"
+		"b loadable_regtask_C\n\t"
+		: );
 }
 
 static void do_dumb_test_delay(int cycles) {
@@ -285,11 +692,20 @@ void MemManageHandler_C(uint32_t *exception_stack) {
 			pc = (uintptr_t) PIOS_Thread_Sleep;
 			break;
 		case CALL_DO_DUMB_REGTASK:
-			pc = (uintptr_t) do_dumb_regtask;
+			pc = (uintptr_t) loadable_regtask;
 			break;
 		case CALL_ANNUNC_CUSTOM:
 			pc = (uintptr_t) system_annunc_custom_string;
 			break;
+		case CALL_PIOS_MALLOC:
+			pc = (uintptr_t) loadable_malloc;
+			break;
+		case CALL_PIOS_FREE:
+			pc = (uintptr_t) loadable_free;
+			break;
+		case CALL_PIOS_THREAD_DELETE:
+			pc = (uintptr_t) PIOS_Thread_Delete;
+			break;
 		default:
 			while (1);
 	}
@@ -51,6 +51,7 @@
 #include "attitudeactual.h"
 #include "baroaltitude.h"
 #include "flightbatterystate.h"
+#include "flightlogsummary.h"
 #include "flightstatus.h"
 #include "gpsposition.h"
 #include "gpstime.h"
@@ -75,6 +76,7 @@
 #include "pios_com_priv.h"
 
 #include <uavtalk.h>
+#include "blackbox.h"
 
 // Private constants
 #define STACK_SIZE_BYTES 1200
@@ -82,9 +84,61 @@
 const char DIGITS[16] = "0123456789abcdef";
 
 #define LOGGING_PERIOD_MS 100
+//! How often captured updates are written out while logging
+#define LOGGING_DRAIN_MS 5
+#define LOG_RING_LEN 4096
+
+//! Actuator updates further apart than this have missed control loops
+#define LOG_SUMMARY_OVERRUN_MS 5
+//! Vibration is measured over windows this long
+#define LOG_SUMMARY_VIBRATION_MS 1000
+//! Starting time between index entries; doubled each time they fill up
+#define LOG_SUMMARY_INDEX_PERIOD_S 1
+//! The summary is written as a single instance timestamped object: sync,
+//! type, size, object id and timestamp, then the data and a CRC
+#define LOG_SUMMARY_FRAME_SYNC 0x3C
+#define LOG_SUMMARY_FRAME_HEADER 10
+#define LOG_SUMMARY_FRAME_LEN (LOG_SUMMARY_FRAME_HEADER + \
+		FLIGHTLOGSUMMARY_NUMBYTES + 1)
 
 // Private types
 
+/**
+ * An update captured by obj_updated_callback, followed in the ring by the
+ * object's data.  A record with no object means the rest of the ring up to
+ * the end is unused, and the next record is at the start.
+ */
+struct log_record {
+	UAVObjHandle obj;
+	uint32_t time;
+	uint16_t inst_id;
+	uint16_t len;
+};
+
+#define LOG_RECORD_ALIGN __alignof__(struct log_record)
+#define LOG_RECORD_SIZE(len) ((sizeof(struct log_record) + (len) + \
+			LOG_RECORD_ALIGN - 1) & ~(LOG_RECORD_ALIGN - 1))
+
+/**
+ * What goes into the summary of the log being written, besides the summary
+ * itself.  Only the logging task uses this, apart from the actuator counts.
+ */
+struct log_summary {
+	FlightLogSummaryData data;
+	uint32_t file_start;	// written_bytes where the file starts
+	uint32_t start_time;
+	uint32_t last_time;
+	bool saturated;
+	uint8_t alarms[SYSTEMALARMS_ALARM_NUMELEM];
+
+	uint32_t vib_window_start;
+	uint16_t vib_samples;
+	float vib_sum;
+	float vib_sum_sq;
+	float vib_total;
+	uint16_t vib_windows;
+};
+
 // Private variables
 static UAVTalkConnection uavTalkCon;
 static struct pios_thread *loggingTaskHandle;
@@ -96,19 +150,46 @@ static LoggingStatsData loggingData;
 static void    loggingTask(void *parameters);
 static int32_t send_data(uint8_t *data, int32_t length);
 static int32_t send_data_nonblock(void *ctx, uint8_t *data, int32_t length);
+static uint8_t *reserve_data(void *ctx, uint16_t length);
+static int32_t commit_data(void *ctx, uint16_t length);
 static uint16_t get_minimum_logging_period();
 static void unregister_object(UAVObjHandle obj);
 static void register_object(UAVObjHandle obj);
+static void connect_logged(UAVObjHandle obj, uint16_t period);
 static void register_default_profile();
 static void logAll(UAVObjHandle obj);
 static void logSettings(UAVObjHandle obj);
 static void writeHeader();
 static void updateSettings();
+static void log_ring_reset();
+static void log_ring_drain();
+static void log_summary_start(uint32_t file_start, uint16_t file_id);
+static void log_summary_update();
+static void log_summary_finish();
+#ifdef PIOS_INCLUDE_LOG_TO_FLASH
+static int32_t log_summary_read(uint16_t file_id);
+#endif
 
 // Local variables
 static uintptr_t logging_com_id;
 static uint32_t written_bytes;
 static bool destination_onboard_flash;
+static bool blackbox_available;
+static bool blackbox_running;
+static uint8_t blackbox_chunk[BLACKBOX_CHUNK_MAX_LENGTH];
+
+/* Ring of captured updates.  Any task can add to the head, under
+ * PIOS_IRQ_Disable; only the logging task moves the tail.
+ */
+static uint8_t log_ring[LOG_RING_LEN] __attribute__((aligned(8)));
+static volatile uint16_t log_ring_head;
+static volatile uint16_t log_ring_tail;
+static volatile uint32_t dropped_updates;
+
+static struct log_summary summary;
+static bool summary_active;
+static volatile uint16_t summary_overruns;
+static volatile uint16_t summary_max_loop;
 
 #ifdef PIOS_INCLUDE_LOG_TO_FLASH
 static const struct streamfs_cfg streamfs_settings = {
@@ -177,7 +258,7 @@ int32_t LoggingInitialize(void)
 	if (!module_enabled)
 		return -1;
 
-	if (LoggingStatsInitialize() == -1) {
+	if (LoggingStatsInitialize() == -1 || FlightLogSummaryInitialize() == -1) {
 		module_enabled = false;
 		return -1;
 	}
@@ -190,6 +271,16 @@ int32_t LoggingInitialize(void)
 		module_enabled = false;
 		return -1;
 	}
+
+	UAVTalkSetInPlaceOutput(uavTalkCon, &reserve_data, &commit_data);
+
+	/* The frame queue is only set aside if it's going to be used */
+	uint8_t profile;
+	LoggingSettingsProfileGet(&profile);
+
+	if (profile == LOGGINGSETTINGS_PROFILE_BLACKBOX) {
+		blackbox_available = (blackbox_init() == 0);
+	}
 	
 	return 0;
 }
@@ -225,6 +316,8 @@ static void loggingTask(void *parameters)
 	bool write_open = false;
 	bool read_open = false;
 	int32_t read_sector = 0;
+	uint16_t read_file = 0;
+	uint32_t read_offset = 0;
 	uint8_t read_data[LOGGINGSTATS_FILESECTOR_NUMELEM];
 #endif
 
@@ -296,6 +389,7 @@ static void loggingTask(void *parameters)
 			LoggingStatsSet(&loggingData);
 			break;
 		case LOGGINGSTATS_OPERATION_INITIALIZING:
+		{
 			// Unregister all objects
 			UAVObjIterate(&unregister_object);
 #ifdef PIOS_INCLUDE_LOG_TO_FLASH
@@ -325,6 +419,9 @@ static void loggingTask(void *parameters)
 			}
 #endif /* PIOS_INCLUDE_LOG_TO_FLASH */
 
+			// Offsets in the summary are from here
+			uint32_t file_start = written_bytes;
+
 			// Write information at start of the log file
 			writeHeader();
 
@@ -336,10 +433,23 @@ static void loggingTask(void *parameters)
 			}
 
 			// Register objects to be logged
+			log_ring_reset();
+
+			log_summary_start(file_start, destination_onboard_flash ?
+					loggingData.MaxFileId : 0);
+
 			switch (settings.Profile) {
 				case LOGGINGSETTINGS_PROFILE_BASIC:
 					register_default_profile();
 					break;
+				case LOGGINGSETTINGS_PROFILE_BLACKBOX:
+					register_default_profile();
+
+					if (blackbox_available) {
+						blackbox_start(settings.BlackboxDivider);
+						blackbox_running = true;
+					}
+					break;
 				case LOGGINGSETTINGS_PROFILE_CUSTOM:
 				case LOGGINGSETTINGS_PROFILE_FULLBORE:
 					UAVObjIterate(&register_object);
@@ -351,26 +461,80 @@ static void loggingTask(void *parameters)
 			loggingData.Operation = LOGGINGSTATS_OPERATION_LOGGING;
 			LoggingStatsSet(&loggingData);
 			break;
+		}
 		case LOGGINGSTATS_OPERATION_LOGGING:
-			{
-				// Sleep between updating stats.
-				PIOS_Thread_Sleep_Until(&now, LOGGING_PERIOD_MS);
+			if (blackbox_running) {
+				// Write control loop frames as they come in
+				uint16_t len = blackbox_get_chunk(blackbox_chunk,
+						LOGGING_DRAIN_MS);
+
+				if (len) {
+					send_data(blackbox_chunk, len);
+				}
+			} else {
+				PIOS_Thread_Sleep(LOGGING_DRAIN_MS);
+			}
+
+			// Write out the updates captured since last time
+			log_ring_drain();
 
-				LoggingStatsBytesLoggedSet(&written_bytes);
+			log_summary_update();
+
+			if (!PIOS_Thread_Period_Elapsed(now, LOGGING_PERIOD_MS)) {
+				break;
+			}
 
-				now = PIOS_Thread_Systime();
+			if (blackbox_running) {
+				uint32_t dropped = blackbox_dropped_frames();
+				LoggingStatsBlackboxDroppedFramesSet(&dropped);
 			}
+
+			uint32_t dropped = dropped_updates;
+			LoggingStatsDroppedUpdatesSet(&dropped);
+			LoggingStatsBytesLoggedSet(&written_bytes);
+
+			now = PIOS_Thread_Systime();
+			break;
+		case LOGGINGSTATS_OPERATION_SUMMARY:
+			loggingData.Operation = LOGGINGSTATS_OPERATION_ERROR;
+#ifdef PIOS_INCLUDE_LOG_TO_FLASH
+			if (destination_onboard_flash && !write_open) {
+				if (read_open) {
+					PIOS_STREAMFS_Close(logging_com_id);
+					read_open = false;
+				}
+
+				if (log_summary_read(loggingData.FileRequest) == 0) {
+					loggingData.Operation = LOGGINGSTATS_OPERATION_COMPLETE;
+				}
+			}
+#endif /* PIOS_INCLUDE_LOG_TO_FLASH */
+			LoggingStatsSet(&loggingData);
 			break;
 		case LOGGINGSTATS_OPERATION_DOWNLOAD:
 #ifdef PIOS_INCLUDE_LOG_TO_FLASH
 			if (destination_onboard_flash) {
+				if (read_open && loggingData.FileSectorNum == 0 &&
+						(read_sector != 0 ||
+						 read_file != loggingData.FileRequest ||
+						 read_offset != loggingData.FileOffset)) {
+					// A new request, perhaps for another part of the file
+					PIOS_STREAMFS_Close(logging_com_id);
+					read_open = false;
+				}
+
 				if (!read_open) {
 					// Start reading
 					if (PIOS_STREAMFS_OpenRead(logging_com_id, loggingData.FileRequest) != 0) {
 						loggingData.Operation = LOGGINGSTATS_OPERATION_ERROR;
+					} else if (PIOS_STREAMFS_Seek(logging_com_id, loggingData.FileOffset) != 0) {
+						loggingData.Operation = LOGGINGSTATS_OPERATION_ERROR;
+						PIOS_STREAMFS_Close(logging_com_id);
 					} else {
 						read_open = true;
 						read_sector = -1;
+						read_file = loggingData.FileRequest;
+						read_offset = loggingData.FileOffset;
 					}
 				}
 				if (read_open && read_sector == loggingData.FileSectorNum) {
@@ -410,6 +574,17 @@ static void loggingTask(void *parameters)
 
 			// fall-through to default case
 		default:
+			if (blackbox_running) {
+				blackbox_stop();
+				blackbox_running = false;
+			}
+
+			if (summary_active) {
+				// Nothing more is captured; the summary goes last
+				log_ring_drain();
+				log_summary_finish();
+			}
+
 			//  Makes sure that we are not hogging the processor
 			PIOS_Thread_Sleep(10);
 #ifdef PIOS_INCLUDE_LOG_TO_FLASH
@@ -478,6 +653,164 @@ static int32_t send_data_nonblock(void *ctx, uint8_t *data, int32_t length)
 	return length;
 }
 
+/**
+ * Reserve room to build a log frame directly in the port's buffer
+ * \param[in] length Length of the frame
+ * \return where to build it, or NULL to use send_data_nonblock instead
+ */
+static uint8_t *reserve_data(void *ctx, uint16_t length)
+{
+	(void) ctx;
+
+	/* Only the logging task writes frames, so it can afford to wait a
+	 * little for the port to catch up; the ring holds updates meanwhile.
+	 */
+	return PIOS_COM_SendReserve(logging_com_id, length, LOGGING_DRAIN_MS);
+}
+
+/**
+ * Send a frame built in space from reserve_data
+ * \param[in] length Length of the frame, or 0 to drop it
+ * \return number of bytes transmitted
+ */
+static int32_t commit_data(void *ctx, uint16_t length)
+{
+	(void) ctx;
+
+	int32_t ret = PIOS_COM_SendCommit(logging_com_id, length);
+
+	if (ret > 0)
+		written_bytes += ret;
+
+	return ret;
+}
+
+/**
+ * Throw away anything captured but not yet written.  Only called by the
+ * logging task, before connecting the callbacks.
+ */
+static void log_ring_reset()
+{
+	log_ring_tail = log_ring_head;
+	dropped_updates = 0;
+}
+
+/**
+ * Copy an update into the ring, to be written out by the logging task.
+ * \param[in] obj Object updated
+ * \param[in] inst_id Instance updated
+ * \param[in] data Copy of the object's data
+ * \param[in] len Length of data
+ */
+static void log_ring_put(UAVObjHandle obj, uint16_t inst_id,
+		const void *data, uint16_t len)
+{
+	uint16_t size = LOG_RECORD_SIZE(len);
+	uint32_t time = PIOS_Thread_Systime();
+
+	if (size > LOG_RING_LEN / 2) {
+		dropped_updates++;
+		return;
+	}
+
+	PIOS_IRQ_Disable();
+
+	uint16_t head = log_ring_head;
+	uint16_t tail = log_ring_tail;
+	uint16_t pos = head;
+
+	/* The head never catches up with the tail, so that a full ring
+	 * can't be mistaken for an empty one.
+	 */
+	if (head >= tail) {
+		uint16_t to_end = LOG_RING_LEN - head;
+
+		if (to_end < size || (to_end == size && tail == 0)) {
+			// Go back around to the start, if there's room there
+			if (tail <= size) {
+				goto drop;
+			}
+
+			if (to_end >= sizeof(struct log_record)) {
+				struct log_record *marker =
+					(struct log_record *) &log_ring[head];
+				marker->obj = NULL;
+			}
+
+			pos = 0;
+		}
+	} else if (tail - head <= size) {
+		goto drop;
+	}
+
+	struct log_record *rec = (struct log_record *) &log_ring[pos];
+
+	rec->obj = obj;
+	rec->time = time;
+	rec->inst_id = inst_id;
+	rec->len = len;
+	memcpy(rec + 1, data, len);
+
+	pos += size;
+
+	if (pos == LOG_RING_LEN) {
+		pos = 0;
+	}
+
+	__sync_synchronize();
+
+	log_ring_head = pos;
+
+	PIOS_IRQ_Enable();
+
+	return;
+
+drop:
+	dropped_updates++;
+
+	PIOS_IRQ_Enable();
+}
+
+/**
+ * Write out everything in the ring.  Only called by the logging task.
+ */
+static void log_ring_drain()
+{
+	uint16_t tail = log_ring_tail;
+
+	while (tail != log_ring_head) {
+		__sync_synchronize();
+
+		if (LOG_RING_LEN - tail < sizeof(struct log_record)) {
+			tail = 0;
+			continue;
+		}
+
+		struct log_record *rec = (struct log_record *) &log_ring[tail];
+
+		if (!rec->obj) {
+			tail = 0;
+			continue;
+		}
+
+		UAVTalkSendObjectData(uavTalkCon, rec->obj, rec->inst_id,
+				rec->time, rec + 1);
+
+		tail += LOG_RECORD_SIZE(rec->len);
+
+		if (tail == LOG_RING_LEN) {
+			tail = 0;
+		}
+
+		// Hand the space back as soon as it's written
+		__sync_synchronize();
+
+		log_ring_tail = tail;
+	}
+
+	log_ring_tail = tail;
+}
+
 /**
  * @brief Callback for adding an object to the logging queue
  * @param ev the event
@@ -485,17 +818,248 @@ static int32_t send_data_nonblock(void *ctx, uint8_t *data, int32_t length)
 static void obj_updated_callback(const UAVObjEvent *ev, void *cb_ctx,
 		void *uavo_data, int uavo_len)
 {
-	(void) cb_ctx; (void) uavo_data; (void) uavo_len;
+	(void) cb_ctx;
 
 	if (loggingData.Operation != LOGGINGSTATS_OPERATION_LOGGING){
 		// We are not logging, so all events are discarded
 		return;
 	}
 
-	UAVTalkSendObjectTimestamped(uavTalkCon, ev->obj, ev->instId);
+	/* Serializing and writing out is left to the logging task, so all
+	 * this costs the publisher is a copy.
+	 */
+	log_ring_put(ev->obj, ev->instId, uavo_data, uavo_len);
 }
 
 
+/**
+ * Counts late actuator updates, from the actuator task
+ */
+static void log_summary_actuator_cb(const UAVObjEvent *ev, void *ctx,
+		void *obj_data, int len)
+{
+	(void) ev; (void) ctx; (void) len;
+
+	const ActuatorCommandData *cmd = obj_data;
+
+	if (cmd->UpdateTime > LOG_SUMMARY_OVERRUN_MS) {
+		summary_overruns++;
+	}
+
+	if (cmd->UpdateTime > summary_max_loop) {
+		summary_max_loop = cmd->UpdateTime;
+	}
+}
+
+/**
+ * Start summarizing a new log.  Called by the logging task once the header
+ * and initial objects are written.
+ * \param[in] file_start written_bytes at the start of the file
+ * \param[in] file_id File being written
+ */
+static void log_summary_start(uint32_t file_start, uint16_t file_id)
+{
+	uint32_t now = PIOS_Thread_Systime();
+
+	memset(&summary, 0, sizeof(summary));
+
+	summary.file_start = file_start;
+	summary.start_time = now;
+	summary.last_time = now;
+	summary.vib_window_start = now;
+
+	summary.data.FileId = file_id;
+	summary.data.HeaderBytes = written_bytes - file_start;
+	summary.data.IndexPeriod = LOG_SUMMARY_INDEX_PERIOD_S;
+
+	SystemAlarmsAlarmGet(summary.alarms);
+
+	summary_overruns = 0;
+	summary_max_loop = 0;
+
+	if (ActuatorCommandHandle()) {
+		UAVObjConnectCallback(ActuatorCommandHandle(),
+				log_summary_actuator_cb, NULL, EV_UPDATED);
+	}
+
+	summary_active = true;
+}
+
+/**
+ * Fold the current state into the summary.  Called by the logging task
+ * each time it has written out what was captured, so offsets land between
+ * records.
+ */
+static void log_summary_update()
+{
+	FlightLogSummaryData *data = &summary.data;
+	uint32_t now = PIOS_Thread_Systime();
+	uint32_t elapsed = now - summary.start_time;
+	uint32_t offset = written_bytes - summary.file_start;
+	uint32_t dt = now - summary.last_time;
+
+	summary.last_time = now;
+
+	// Index, thinned out to every other entry whenever it fills
+	if (elapsed >= data->IndexCount * data->IndexPeriod * 1000) {
+		if (data->IndexCount == FLIGHTLOGSUMMARY_INDEXOFFSET_NUMELEM) {
+			for (int i = 0; i < FLIGHTLOGSUMMARY_INDEXOFFSET_NUMELEM / 2; i++) {
+				data->IndexOffset[i] = data->IndexOffset[2 * i];
+			}
+
+			data->IndexCount = FLIGHTLOGSUMMARY_INDEXOFFSET_NUMELEM / 2;
+			data->IndexPeriod *= 2;
+		}
+
+		if (elapsed >= data->IndexCount * data->IndexPeriod * 1000) {
+			data->IndexOffset[data->IndexCount++] = offset;
+		}
+	}
+
+	GyrosData gyros;
+	GyrosGet(&gyros);
+
+	data->MaxRollRate = MAX(data->MaxRollRate, fabsf(gyros.x));
+	data->MaxPitchRate = MAX(data->MaxPitchRate, fabsf(gyros.y));
+	data->MaxYawRate = MAX(data->MaxYawRate, fabsf(gyros.z));
+
+	if (ActuatorDesiredHandle()) {
+		ActuatorDesiredData desired;
+		ActuatorDesiredGet(&desired);
+
+		bool saturated = fabsf(desired.Roll) >= 1.0f ||
+			fabsf(desired.Pitch) >= 1.0f ||
+			fabsf(desired.Yaw) >= 1.0f ||
+			fabsf(desired.Thrust) >= 1.0f;
+
+		if (saturated) {
+			if (!summary.saturated) {
+				data->Saturations++;
+			}
+
+			data->SaturationTime += dt;
+		}
+
+		summary.saturated = saturated;
+	}
+
+	// Spread of the acceleration magnitude about its mean
+	AccelsData accels;
+	AccelsGet(&accels);
+
+	float accel = sqrtf(accels.x * accels.x + accels.y * accels.y +
+			accels.z * accels.z);
+
+	summary.vib_sum += accel;
+	summary.vib_sum_sq += accel * accel;
+	summary.vib_samples++;
+
+	if (now - summary.vib_window_start >= LOG_SUMMARY_VIBRATION_MS) {
+		float mean = summary.vib_sum / summary.vib_samples;
+		float var = summary.vib_sum_sq / summary.vib_samples - mean * mean;
+		float rms = (var > 0) ? sqrtf(var) : 0;
+
+		data->MaxVibration = MAX(data->MaxVibration, rms);
+		summary.vib_total += rms;
+		summary.vib_windows++;
+
+		summary.vib_window_start = now;
+		summary.vib_samples = 0;
+		summary.vib_sum = 0;
+		summary.vib_sum_sq = 0;
+	}
+
+	uint8_t alarms[SYSTEMALARMS_ALARM_NUMELEM];
+	SystemAlarmsAlarmGet(alarms);
+
+	for (int i = 0; i < SYSTEMALARMS_ALARM_NUMELEM; i++) {
+		if (alarms[i] == summary.alarms[i]) {
+			continue;
+		}
+
+		summary.alarms[i] = alarms[i];
+		data->AlarmTransitions++;
+
+		if (data->EventCount < FLIGHTLOGSUMMARY_EVENTTIME_NUMELEM) {
+			data->EventTime[data->EventCount] = elapsed;
+			data->EventOffset[data->EventCount] = offset;
+			data->EventAlarm[data->EventCount] = i;
+			data->EventSeverity[data->EventCount] = alarms[i];
+			data->EventCount++;
+		}
+	}
+}
+
+/**
+ * Complete the summary and write it as the last record of the log
+ */
+static void log_summary_finish()
+{
+	FlightLogSummaryData *data = &summary.data;
+
+	if (ActuatorCommandHandle()) {
+		UAVObjDisconnectCallback(ActuatorCommandHandle(),
+				log_summary_actuator_cb, NULL);
+	}
+
+	data->Duration = PIOS_Thread_Systime() - summary.start_time;
+	data->LogBytes = written_bytes - summary.file_start;
+	data->LoopOverruns = summary_overruns;
+	data->MaxLoopTime = summary_max_loop;
+
+	if (summary.vib_windows) {
+		data->MeanVibration = summary.vib_total / summary.vib_windows;
+	}
+
+	FlightLogSummarySet(data);
+	UAVTalkSendObjectTimestamped(uavTalkCon, FlightLogSummaryHandle(), 0);
+
+	summary_active = false;
+}
+
+#ifdef PIOS_INCLUDE_LOG_TO_FLASH
+/**
+ * Read the summary of a log back from the end of it, into FlightLogSummary
+ * \param[in] file_id File to read
+ * \return 0 if found, -1 if not
+ */
+static int32_t log_summary_read(uint16_t file_id)
+{
+	static uint8_t frame[LOG_SUMMARY_FRAME_LEN];
+	int32_t rc = -1;
+
+	if (PIOS_STREAMFS_OpenRead(logging_com_id, file_id) != 0) {
+		return -1;
+	}
+
+	int32_t size = PIOS_STREAMFS_FileSize(logging_com_id);
+
+	if (size >= LOG_SUMMARY_FRAME_LEN &&
+			PIOS_STREAMFS_Seek(logging_com_id, size - LOG_SUMMARY_FRAME_LEN) == 0 &&
+			PIOS_STREAMFS_Read(logging_com_id, frame, sizeof(frame)) == sizeof(frame)) {
+		uint16_t len;
+		uint32_t obj_id;
+
+		memcpy(&len, frame + 2, sizeof(len));
+		memcpy(&obj_id, frame + 4, sizeof(obj_id));
+
+		// Logs cut short, or from before summaries, end in something else
+		if (frame[0] == LOG_SUMMARY_FRAME_SYNC && obj_id == FLIGHTLOGSUMMARY_OBJID &&
+				len == LOG_SUMMARY_FRAME_HEADER + FLIGHTLOGSUMMARY_NUMBYTES) {
+			// Not logging, so the summary state is free
+			memcpy(&summary.data, frame + LOG_SUMMARY_FRAME_HEADER,
+					FLIGHTLOGSUMMARY_NUMBYTES);
+			FlightLogSummarySet(&summary.data);
+			rc = 0;
+		}
+	}
+
+	PIOS_STREAMFS_Close(logging_com_id);
+
+	return rc;
+}
+#endif /* PIOS_INCLUDE_LOG_TO_FLASH */
+
 /**
  * Get the minimum logging period in milliseconds
 */
@@ -567,16 +1131,41 @@ static void register_object(UAVObjHandle obj)
 			return;
 		}
 
-		if (meta_data.loggingUpdatePeriod == 0){
-			return;
-		}
-
 		period = meta_data.loggingUpdatePeriod;
 	}
 
-	period = MAX(period, get_minimum_logging_period());
+	if (period) {
+		period = MAX(period, get_minimum_logging_period());
+	}
+
+	connect_logged(obj, period);
+}
+
+/**
+ * Connect the update callback so that an object is logged at most once a
+ * period, unless OverrideObjectId gives it a period of its own.
+ * \param[in] obj Object to connect; may be NULL if it isn't built in
+ * \param[in] period Shortest time between logged updates (ms), or 0 to not
+ * log it
+ */
+static void connect_logged(UAVObjHandle obj, uint16_t period)
+{
+	if (!obj) {
+		return;
+	}
+
+	uint32_t obj_id = UAVObjGetID(obj);
 
-	if (period == 1) {
+	for (int i = 0; i < LOGGINGSETTINGS_OVERRIDEOBJECTID_NUMELEM; i++) {
+		if (settings.OverrideObjectId[i] == obj_id) {
+			period = settings.OverridePeriod[i];
+			break;
+		}
+	}
+
+	if (period == 0) {
+		return;
+	} else if (period == 1) {
 		// log every update
 		UAVObjConnectCallback(obj, obj_updated_callback, NULL, EV_UPDATED | EV_UNPACKED);
 	} else {
@@ -593,69 +1182,57 @@ static void register_default_profile()
 	// For the default profile, we limit things to 100Hz (for now)
 	uint16_t min_period = MAX(get_minimum_logging_period(), 10);
 
-	// Objects for which we log all changes (use 100Hz to limit max data rate)
-	UAVObjConnectCallbackThrottled(FlightStatusHandle(), obj_updated_callback, NULL, EV_UPDATED | EV_UNPACKED, 10);
-	UAVObjConnectCallbackThrottled(SystemAlarmsHandle(), obj_updated_callback, NULL, EV_UPDATED | EV_UNPACKED, 10);
-	if (WaypointActiveHandle()) {
-		UAVObjConnectCallbackThrottled(WaypointActiveHandle(), obj_updated_callback, NULL, EV_UPDATED | EV_UNPACKED, 10);
-	}
+	uint16_t period[LOGGINGSETTINGS_BASICDECIMATION_NUMELEM];
 
-	if (SystemIdentHandle()){
-		UAVObjConnectCallbackThrottled(SystemIdentHandle(), obj_updated_callback, NULL, EV_UPDATED | EV_UNPACKED, 10);
+	for (int i = 0; i < LOGGINGSETTINGS_BASICDECIMATION_NUMELEM; i++) {
+		period[i] = MIN(settings.BasicDecimation[i] * min_period,
+				UINT16_MAX);
 	}
 
+	// Objects for which we log all changes (use 100Hz to limit max data rate)
+	connect_logged(FlightStatusHandle(), 10);
+	connect_logged(SystemAlarmsHandle(), 10);
+	connect_logged(WaypointActiveHandle(), 10);
+	connect_logged(SystemIdentHandle(), 10);
+
 	// Log fast
-	UAVObjConnectCallbackThrottled(AccelsHandle(), obj_updated_callback, NULL, EV_UPDATED | EV_UNPACKED, min_period);
-	UAVObjConnectCallbackThrottled(GyrosHandle(), obj_updated_callback, NULL, EV_UPDATED | EV_UNPACKED, min_period);
+	connect_logged(AccelsHandle(), period[LOGGINGSETTINGS_BASICDECIMATION_SENSORS]);
 
-	// Log a bit slower
-	UAVObjConnectCallbackThrottled(AttitudeActualHandle(), obj_updated_callback, NULL, EV_UPDATED | EV_UNPACKED, 5 * min_period);
+	// The blackbox frames carry these at the loop rate already
+	bool blackbox = settings.Profile == LOGGINGSETTINGS_PROFILE_BLACKBOX &&
+		blackbox_available;
 
-	if (MagnetometerHandle()) {
-		UAVObjConnectCallbackThrottled(MagnetometerHandle(), obj_updated_callback, NULL, EV_UPDATED | EV_UNPACKED, 5 * min_period);
+	if (!blackbox) {
+		connect_logged(GyrosHandle(), period[LOGGINGSETTINGS_BASICDECIMATION_SENSORS]);
 	}
 
-	UAVObjConnectCallbackThrottled(ManualControlCommandHandle(), obj_updated_callback, NULL, EV_UPDATED | EV_UNPACKED, 5 * min_period);
-	UAVObjConnectCallbackThrottled(ActuatorDesiredHandle(), obj_updated_callback, NULL, EV_UPDATED | EV_UNPACKED, 5 * min_period);
-	UAVObjConnectCallbackThrottled(StabilizationDesiredHandle(), obj_updated_callback, NULL, EV_UPDATED | EV_UNPACKED, 5 * min_period);
+	// Log a bit slower
+	connect_logged(AttitudeActualHandle(), period[LOGGINGSETTINGS_BASICDECIMATION_ATTITUDE]);
+	connect_logged(MagnetometerHandle(), period[LOGGINGSETTINGS_BASICDECIMATION_ATTITUDE]);
 
-	// Log slow
-	if (FlightBatteryStateHandle()) {
-		UAVObjConnectCallbackThrottled(FlightBatteryStateHandle(), obj_updated_callback, NULL, EV_UPDATED | EV_UNPACKED, 10 * min_period);
-	}
-	if (BaroAltitudeHandle()) {
-		UAVObjConnectCallbackThrottled(BaroAltitudeHandle(), obj_updated_callback, NULL, EV_UPDATED | EV_UNPACKED, 10 * min_period);
-	}
-	if (AirspeedActualHandle()) {
-		UAVObjConnectCallbackThrottled(AirspeedActualHandle(), obj_updated_callback, NULL, EV_UPDATED | EV_UNPACKED, 10 * min_period);
-	}
-	if (GPSPositionHandle()) {
-		UAVObjConnectCallbackThrottled(GPSPositionHandle(), obj_updated_callback, NULL, EV_UPDATED | EV_UNPACKED, 10 * min_period);
-	}
-	if (PositionActualHandle()) {
-		UAVObjConnectCallbackThrottled(PositionActualHandle(), obj_updated_callback, NULL, EV_UPDATED | EV_UNPACKED, 10 * min_period);
-	}
-	if (VelocityActualHandle()) {
-		UAVObjConnectCallbackThrottled(VelocityActualHandle(), obj_updated_callback, NULL, EV_UPDATED | EV_UNPACKED, 10 * min_period);
+	connect_logged(ManualControlCommandHandle(), period[LOGGINGSETTINGS_BASICDECIMATION_CONTROL]);
+	if (!blackbox) {
+		connect_logged(ActuatorDesiredHandle(), period[LOGGINGSETTINGS_BASICDECIMATION_CONTROL]);
 	}
+	connect_logged(StabilizationDesiredHandle(), period[LOGGINGSETTINGS_BASICDECIMATION_CONTROL]);
+
+	// Log slow
+	connect_logged(FlightBatteryStateHandle(), period[LOGGINGSETTINGS_BASICDECIMATION_NAVIGATION]);
+	connect_logged(BaroAltitudeHandle(), period[LOGGINGSETTINGS_BASICDECIMATION_NAVIGATION]);
+	connect_logged(AirspeedActualHandle(), period[LOGGINGSETTINGS_BASICDECIMATION_NAVIGATION]);
+	connect_logged(GPSPositionHandle(), period[LOGGINGSETTINGS_BASICDECIMATION_NAVIGATION]);
+	connect_logged(PositionActualHandle(), period[LOGGINGSETTINGS_BASICDECIMATION_NAVIGATION]);
+	connect_logged(VelocityActualHandle(), period[LOGGINGSETTINGS_BASICDECIMATION_NAVIGATION]);
 
 	// Log very slow
-	if (GPSTimeHandle()) {
-		UAVObjConnectCallbackThrottled(GPSTimeHandle(), obj_updated_callback, NULL, EV_UPDATED | EV_UNPACKED, 50 * min_period);
-	}
+	connect_logged(GPSTimeHandle(), period[LOGGINGSETTINGS_BASICDECIMATION_GPSTIME]);
 
 	// Log very very slow
-	if (GPSSatellitesHandle()) {
-		UAVObjConnectCallbackThrottled(GPSSatellitesHandle(), obj_updated_callback, NULL, EV_UPDATED | EV_UNPACKED, 500 * min_period);
-	}
+	connect_logged(GPSSatellitesHandle(), period[LOGGINGSETTINGS_BASICDECIMATION_GPSSATELLITES]);
 
 	// Log LQG data
-	if (RTKFEstimateHandle()) {
-		UAVObjConnectCallbackThrottled(RTKFEstimateHandle(), obj_updated_callback, NULL, EV_UPDATED | EV_UNPACKED, 2 * min_period);
-	}
-	if (LQGSolutionHandle()) {
-		UAVObjConnectCallbackThrottled(LQGSolutionHandle(), obj_updated_callback, NULL, EV_UPDATED | EV_UNPACKED, 100 * min_period);
-	}
+	connect_logged(RTKFEstimateHandle(), period[LOGGINGSETTINGS_BASICDECIMATION_LQGESTIMATE]);
+	connect_logged(LQGSolutionHandle(), period[LOGGINGSETTINGS_BASICDECIMATION_LQGSOLUTION]);
 }
 
 
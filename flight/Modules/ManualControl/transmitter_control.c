@@ -66,6 +66,10 @@
 #define RCVR_ACTIVITY_MONITOR_CHANNELS_PER_GROUP 12
 #define RCVR_ACTIVITY_MONITOR_MIN_RANGE 20
 
+// Channels read from a receiver in one go; any numbered higher are read
+// one at a time
+#define MAX_GROUP_CHANNELS 20
+
 // If the neutral point on the throttle channel is 35% over the configured
 // minimum, we assume they're providing bidirectional thrust.
 #define THRUST_BIDIR_THRESH 0.35f
@@ -76,6 +80,14 @@
  * arming, etc. */
 #define MIN_MEANINGFUL_RANGE 40
 
+/* Scaling of a channel to -1..1, worked out from the settings */
+struct channel_scale {
+	int16_t neutral;
+	float direction;	// 1 if max > min, -1 if the other way around
+	float max_gain;		// per us on the max side of neutral
+	float min_gain;		// and on the min side
+};
+
 struct rcvr_activity_fsm {
 	ManualControlSettingsChannelGroupsOptions group;
 	uint16_t prev[RCVR_ACTIVITY_MONITOR_CHANNELS_PER_GROUP];
@@ -96,8 +108,12 @@ static uint32_t                   lastSysTime;
 static float                      flight_mode_value;
 static enum control_status        control_status;
 static bool                       settings_updated;
+static volatile bool              stab_settings_updated;
+static struct expo_table          rate_expo[STABILIZATIONSETTINGS_RATEEXPO_NUMELEM];
 static bool                       thrust_is_bidir;
 static bool                       collective_is_thrust;
+static struct channel_scale       channel_scale[MANUALCONTROLSETTINGS_CHANNELGROUPS_NUMELEM];
+static uint8_t                    group_channels[MANUALCONTROLSETTINGS_CHANNELGROUPS_NONE];
 
 // Private functions
 static float get_thrust_source(ManualControlCommandData *manual_control_command,
@@ -106,7 +122,9 @@ static void update_stabilization_desired(ManualControlCommandData * manual_contr
 static void set_flight_mode();
 static void process_transmitter_events(ManualControlCommandData * cmd, ManualControlSettingsData * settings, bool valid, bool settings_updated);
 static void set_manual_control_error(SystemAlarmsManualControlOptions errorCode);
-static float scaleChannel(int n, int16_t value);
+static void compile_channels();
+static void read_channels();
+static void scale_channels(float *scaled);
 static bool validInputRange(int n, uint16_t value, uint16_t offset);
 static uint32_t timeDifferenceMs(uint32_t start_time, uint32_t end_time);
 static void resetRcvrActivity(struct rcvr_activity_fsm * fsm);
@@ -142,7 +160,8 @@ int32_t transmitter_control_initialize()
 			|| StabilizationDesiredInitialize() == -1
 			|| ReceiverActivityInitialize() == -1
 			|| LoiterCommandInitialize() == -1
-			|| ManualControlSettingsInitialize() == -1) {
+			|| ManualControlSettingsInitialize() == -1
+			|| StabilizationSettingsInitialize() == -1) {
 		return -1;
 	}
 
@@ -154,8 +173,10 @@ int32_t transmitter_control_initialize()
 
 	// Use callback to update the settings when they change
 	ManualControlSettingsConnectCallbackCtx(UAVObjCbSetFlag, &settings_updated);
+	StabilizationSettingsConnectCallbackCtx(UAVObjCbSetFlag, &stab_settings_updated);
 
 	settings_updated = true;
+	stab_settings_updated = true;
 
 	// Main task loop
 	lastSysTime = PIOS_Thread_Systime();
@@ -232,6 +253,8 @@ static void perform_tc_settings_update()
 	settings_updated = false;
 	ManualControlSettingsGet(&settings);
 
+	compile_channels();
+
 	uint8_t thrust_channel;
 
 	if (channel_is_configured(MANUALCONTROLSETTINGS_CHANNELGROUPS_COLLECTIVE)) {
@@ -367,26 +390,21 @@ int32_t transmitter_control_update()
 
 	bool valid_input_detected = true;
 
-	// Read channel values in us
+	cmd.FrameAge = MIN(PIOS_RCVR_GetFrameAge(), UINT16_MAX);
+
+	// Read channel values in us, and scale them
+	read_channels();
+	scale_channels(scaledChannel);
+
 	for (uint8_t n = 0;
 	     n < MANUALCONTROLSETTINGS_CHANNELGROUPS_NUMELEM && n < MANUALCONTROLCOMMAND_CHANNEL_NUMELEM;
 	     ++n) {
-
-		if (settings.ChannelGroups[n] >= MANUALCONTROLSETTINGS_CHANNELGROUPS_NONE) {
-			cmd.Channel[n] = PIOS_RCVR_INVALID;
-			validChannel[n] = false;
-		} else {
-			cmd.Channel[n] = PIOS_RCVR_Read(pios_rcvr_group_map[settings.ChannelGroups[n]],
-							settings.ChannelNumber[n]);
-		}
-
 		// If a channel has timed out this is not valid data and we shouldn't update anything
 		// until we decide to go to failsafe
 		if(cmd.Channel[n] == (uint16_t) PIOS_RCVR_TIMEOUT) {
 			valid_input_detected = false;
 			validChannel[n] = false;
 		} else {
-			scaledChannel[n] = scaleChannel(n, cmd.Channel[n]);
 			validChannel[n] = validInputRange(n, cmd.Channel[n], CONNECTION_OFFSET);
 		}
 	}
@@ -864,13 +882,7 @@ static void set_flight_mode()
 {
 	uint8_t new_mode = transmitter_control_get_flight_mode();
 
-	FlightStatusFlightModeOptions cur_mode;
-
-	FlightStatusFlightModeGet(&cur_mode);
-
-	if (cur_mode != new_mode) {
-		FlightStatusFlightModeSet(&new_mode);
-	}
+	FlightStatusFlightModeSetIfChanged(&new_mode);
 }
 
 
@@ -897,9 +909,14 @@ static void resetRcvrActivity(struct rcvr_activity_fsm * fsm)
 }
 
 static void updateRcvrActivitySample(uintptr_t rcvr_id, uint16_t samples[], uint8_t max_channels) {
-	for (uint8_t channel = 1; channel <= max_channels; channel++) {
-		// Subtract 1 because channels are 1 indexed
-		samples[channel - 1] = PIOS_RCVR_Read(rcvr_id, channel);
+	int32_t values[RCVR_ACTIVITY_MONITOR_CHANNELS_PER_GROUP];
+
+	max_channels = MIN(max_channels, RCVR_ACTIVITY_MONITOR_CHANNELS_PER_GROUP);
+
+	PIOS_RCVR_ReadAll(rcvr_id, values, max_channels);
+
+	for (uint8_t i = 0; i < max_channels; i++) {
+		samples[i] = values[i];
 	}
 }
 
@@ -920,6 +937,10 @@ static bool updateRcvrActivityCompare(uintptr_t rcvr_id, struct rcvr_activity_fs
 		rssi_channel = settings.RssiChannelNumber;
 	}
 
+	int32_t values[RCVR_ACTIVITY_MONITOR_CHANNELS_PER_GROUP];
+
+	PIOS_RCVR_ReadAll(rcvr_id, values, RCVR_ACTIVITY_MONITOR_CHANNELS_PER_GROUP);
+
 	/* Compare the current value to the previous sampled value */
 	for (uint8_t channel = 1;
 	     channel <= RCVR_ACTIVITY_MONITOR_CHANNELS_PER_GROUP;
@@ -931,7 +952,7 @@ static bool updateRcvrActivityCompare(uintptr_t rcvr_id, struct rcvr_activity_fs
 
 		uint16_t delta;
 		uint16_t prev = fsm->prev[channel - 1];   // Subtract 1 because channels are 1 indexed
-		uint16_t curr = PIOS_RCVR_Read(rcvr_id, channel);
+		uint16_t curr = values[channel - 1];
 		if (curr > prev) {
 			delta = curr - prev;
 		} else {
@@ -1027,15 +1048,13 @@ static inline float scale_stabilization(StabilizationSettingsData *stabSettings,
 		case SHAREDDEFS_STABILIZATIONMODE_WEAKLEVELING:
 		case SHAREDDEFS_STABILIZATIONMODE_AXISLOCK:
 		case SHAREDDEFS_STABILIZATIONMODE_LQG:
-			cmd = expoM(cmd, stabSettings->RateExpo[axis],
-					stabSettings->RateExponent[axis]*0.1f);
+			cmd = expo_table_eval(&rate_expo[axis], cmd);
 			return cmd * stabSettings->ManualRate[axis];
 		case SHAREDDEFS_STABILIZATIONMODE_ACRODYNE:
 			// For acrodyne, pass the command through raw.
 			return cmd;
 		case SHAREDDEFS_STABILIZATIONMODE_ACROPLUS:
-			cmd = expoM(cmd, stabSettings->RateExpo[axis],
-					stabSettings->RateExponent[axis]*0.1f);
+			cmd = expo_table_eval(&rate_expo[axis], cmd);
 			return cmd;
 		case SHAREDDEFS_STABILIZATIONMODE_SYSTEMIDENT:
 		case SHAREDDEFS_STABILIZATIONMODE_ATTITUDE:
@@ -1059,6 +1078,15 @@ static void update_stabilization_desired(ManualControlCommandData * manual_contr
 	StabilizationSettingsData stabSettings;
 	StabilizationSettingsGet(&stabSettings);
 
+	if (stab_settings_updated) {
+		stab_settings_updated = false;
+
+		for (int i = 0; i < STABILIZATIONSETTINGS_RATEEXPO_NUMELEM; i++) {
+			expo_table_build(&rate_expo[i], stabSettings.RateExpo[i],
+					stabSettings.RateExponent[i] * 0.1f);
+		}
+	}
+
 	const uint8_t MANUAL_SETTINGS[3] = {
 		STABILIZATIONDESIRED_STABILIZATIONMODE_MANUAL,
 		STABILIZATIONDESIRED_STABILIZATIONMODE_MANUAL,
@@ -1236,39 +1264,106 @@ static void set_loiter_command(ManualControlCommandData *cmd)
 }
 
 /**
- * Convert channel from servo pulse duration (microseconds) to scaled -1/+1 range.
+ * Works out, from the settings, how many channels to read from each
+ * channel group and how to scale each channel.
  */
-static float scaleChannel(int n, int16_t value)
+static void compile_channels()
 {
-	// TODO : change these variable names to be safer
-	int16_t min = settings.ChannelMin[n];
-	int16_t max = settings.ChannelMax[n];
-	int16_t neutral = settings.ChannelNeutral[n];
+	memset(group_channels, 0, sizeof(group_channels));
 
-	float valueScaled;
+	for (int n = 0; n < MANUALCONTROLSETTINGS_CHANNELGROUPS_NUMELEM; n++) {
+		uint8_t group = settings.ChannelGroups[n];
 
-	// Scale
-	if ((max > min && value >= neutral) || (min > max && value <= neutral))
-	{
-		if (max != neutral)
-			valueScaled = (float)(value - neutral) / (float)(max - neutral);
-		else
-			valueScaled = 0;
+		if (group < MANUALCONTROLSETTINGS_CHANNELGROUPS_NONE) {
+			uint8_t number = MIN(settings.ChannelNumber[n], MAX_GROUP_CHANNELS);
+
+			group_channels[group] = MAX(group_channels[group], number);
+		}
+
+		int16_t min = settings.ChannelMin[n];
+		int16_t max = settings.ChannelMax[n];
+		int16_t neutral = settings.ChannelNeutral[n];
+
+		struct channel_scale *scale = &channel_scale[n];
+
+		scale->neutral = neutral;
+		scale->min_gain = (min != neutral) ? 1.0f / (neutral - min) : 0;
+
+		if (max > min) {
+			scale->direction = 1;
+		} else if (min > max) {
+			scale->direction = -1;
+		} else {
+			// All of it scales as the min side
+			scale->direction = 1;
+			scale->max_gain = scale->min_gain;
+			continue;
+		}
+
+		scale->max_gain = (max != neutral) ? 1.0f / (max - neutral) : 0;
 	}
-	else
-	{
-		if (min != neutral)
-			valueScaled = (float)(value - neutral) / (float)(neutral - min);
-		else
-			valueScaled = 0;
+}
+
+/**
+ * Reads the configured channels into the command, taking each channel
+ * group's channels from its receiver in one go.
+ */
+static void read_channels()
+{
+	int32_t values[MAX_GROUP_CHANNELS];
+
+	for (int n = 0; n < MANUALCONTROLCOMMAND_CHANNEL_NUMELEM; n++) {
+		if (n >= MANUALCONTROLSETTINGS_CHANNELGROUPS_NUMELEM ||
+				settings.ChannelGroups[n] >= MANUALCONTROLSETTINGS_CHANNELGROUPS_NONE) {
+			cmd.Channel[n] = PIOS_RCVR_INVALID;
+		}
 	}
 
-	// Bound
-	if (valueScaled >  1.0f) valueScaled =  1.0f;
-	else
-	if (valueScaled < -1.0f) valueScaled = -1.0f;
+	for (int group = 0; group < MANUALCONTROLSETTINGS_CHANNELGROUPS_NONE; group++) {
+		if (!group_channels[group]) {
+			continue;
+		}
+
+		uintptr_t rcvr_id = pios_rcvr_group_map[group];
+
+		PIOS_RCVR_ReadAll(rcvr_id, values, group_channels[group]);
 
-	return valueScaled;
+		for (int n = 0;
+		     n < MANUALCONTROLSETTINGS_CHANNELGROUPS_NUMELEM && n < MANUALCONTROLCOMMAND_CHANNEL_NUMELEM;
+		     n++) {
+			if (settings.ChannelGroups[n] != group) {
+				continue;
+			}
+
+			uint8_t number = settings.ChannelNumber[n];
+
+			if (number == 0) {
+				cmd.Channel[n] = PIOS_RCVR_INVALID;
+			} else if (number <= MAX_GROUP_CHANNELS) {
+				cmd.Channel[n] = values[number - 1];
+			} else {
+				cmd.Channel[n] = PIOS_RCVR_Read(rcvr_id, number);
+			}
+		}
+	}
+}
+
+/**
+ * Convert channels from servo pulse duration (microseconds) to scaled -1/+1 range.
+ */
+static void scale_channels(float *scaled)
+{
+	for (int n = 0;
+	     n < MANUALCONTROLSETTINGS_CHANNELGROUPS_NUMELEM && n < MANUALCONTROLCOMMAND_CHANNEL_NUMELEM;
+	     n++) {
+		const struct channel_scale *scale = &channel_scale[n];
+
+		float offset = (int16_t) cmd.Channel[n] - scale->neutral;
+		float gain = (offset * scale->direction >= 0) ?
+			scale->max_gain : scale->min_gain;
+
+		scaled[n] = bound_sym(offset * gain, 1.0f);
+	}
 }
 
 static uint32_t timeDifferenceMs(uint32_t start_time, uint32_t end_time) {
@@ -1351,11 +1446,7 @@ static void set_manual_control_error(SystemAlarmsManualControlOptions error_code
 	}
 
 	// Make sure not to set the error code if it didn't change
-	SystemAlarmsManualControlOptions current_error_code;
-	SystemAlarmsManualControlGet((uint8_t *) &current_error_code);
-	if (current_error_code != error_code) {
-		SystemAlarmsManualControlSet((uint8_t *) &error_code);
-	}
+	SystemAlarmsManualControlSetIfChanged((uint8_t *) &error_code);
 
 	// AlarmSet checks only updates on toggle
 	AlarmsSet(SYSTEMALARMS_ALARM_MANUALCONTROL, (uint8_t) severity);
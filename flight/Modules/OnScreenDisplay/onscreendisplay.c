@@ -108,6 +108,7 @@
 #include "fonts.h"
 #include "WMMInternal.h"
 #include "mgrs.h"
+#include "geofmt.h"
 
 extern uint8_t PIOS_Board_Revision(void);
 
@@ -1337,13 +1338,13 @@ void render_user_page(OnScreenDisplayPageSettingsData * page)
 		}
 
 		if (page->GpsLat) {
-			sprintf(tmp_str, "%0.5f", (double)gps_data.Latitude / 10000000.0);
+			geofmt_fixed(tmp_str, gps_data.Latitude, 7, 5);
 			write_string(tmp_str, page->GpsLatPosX, page->GpsLatPosY, 0, 0, TEXT_VA_TOP, (int)page->GpsLatAlign, 0,
 					page->GpsLatFont);
 		}
 
 		if (page->GpsLon) {
-			sprintf(tmp_str, "%0.5f", (double)gps_data.Longitude / 10000000.0);
+			geofmt_fixed(tmp_str, gps_data.Longitude, 7, 5);
 			write_string(tmp_str, page->GpsLonPosX, page->GpsLonPosY, 0, 0, TEXT_VA_TOP, (int)page->GpsLonAlign, 0,
 					page->GpsLonFont);
 		}
@@ -1352,8 +1353,9 @@ void render_user_page(OnScreenDisplayPageSettingsData * page)
 		if (page->GpsMgrs) {
 			static char mgrs_str[20] = {0};
 
-			if (frame_counter % 5 == 0) {
-				// the conversion to MGRS is computationally expensive, so we update it a bit slower
+			if (geofmt_mgrs(gps_data.Latitude, gps_data.Longitude, 5, mgrs_str) != 0 &&
+					frame_counter % 5 == 0) {
+				// the polar regions need UPS, which is computationally expensive, so we update it a bit slower
 				tmp_int1 = Convert_Geodetic_To_MGRS((double)gps_data.Latitude * (double)DEG2RAD / 10000000.0,
 								(double)gps_data.Longitude * (double)DEG2RAD / 10000000.0, 5, mgrs_str);
 				if (tmp_int1 != 0)
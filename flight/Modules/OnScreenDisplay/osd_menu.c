@@ -1437,10 +1437,11 @@ void filter_menu(void)
 		[STATEESTIMATION_ATTITUDEFILTER_INSINDOOR] = "INSIndoor",
 		[STATEESTIMATION_ATTITUDEFILTER_INSOUTDOOR] = "INSOutdoor",
 	};
-	const char * nav_filter_strings[3] = {
+	const char * nav_filter_strings[4] = {
 		[STATEESTIMATION_NAVIGATIONFILTER_NONE] = "None",
 		[STATEESTIMATION_NAVIGATIONFILTER_RAW] = "Raw",
 		[STATEESTIMATION_NAVIGATIONFILTER_INS] = "INS",
+		[STATEESTIMATION_NAVIGATIONFILTER_FLOW] = "Flow",
 	};
 
 	draw_menu_title("Filter Settings");
@@ -57,20 +57,92 @@ extern uint8_t *disp_buffer;
 #endif /* defined(PIOS_VIDEO_SPLITBUFFER) */
 
 
-void clearGraphics()
+/*
+ * Rather than wiping the whole draw buffer before each frame, only the bands
+ * of rows that were drawn into the last time this buffer was drawn are
+ * cleared.  Most of a typical page is empty, so this saves most of the clear.
+ * The two buffers take turns, so each keeps its own record.
+ */
+#define DIRTY_BAND_SHIFT 4
+#define DIRTY_BAND_ROWS  (1 << DIRTY_BAND_SHIFT)
+#define DIRTY_BANDS      ((BUFFER_HEIGHT + DIRTY_BAND_ROWS - 1) / DIRTY_BAND_ROWS)
+
+DONT_BUILD_IF(DIRTY_BANDS > 31, DirtyBandsFitWord);
+
+#if defined(PIOS_VIDEO_SPLITBUFFER)
+#define DRAW_BUFFER_ID draw_buffer_mask
+#else
+#define DRAW_BUFFER_ID draw_buffer
+#endif /* defined(PIOS_VIDEO_SPLITBUFFER) */
+
+struct dirty_rows {
+	const uint8_t *buffer;
+	uint32_t bands;
+};
+
+static struct dirty_rows dirty[2];
+static uint32_t *draw_dirty = &dirty[0].bands;
+
+//! Marks rows y0 to y1 (inclusive, y0 <= y1, both on screen) as drawn
+static inline void mark_dirty(int y0, int y1)
+{
+	*draw_dirty |= (2U << (y1 >> DIRTY_BAND_SHIFT)) -
+		(1U << (y0 >> DIRTY_BAND_SHIFT));
+}
+
+static void clear_rows(int first_band, int num_bands)
 {
+	int start = first_band * DIRTY_BAND_ROWS * BUFFER_WIDTH;
+	int len = num_bands * DIRTY_BAND_ROWS * BUFFER_WIDTH;
+
+	if (start + len > BUFFER_HEIGHT * BUFFER_WIDTH) {
+		len = BUFFER_HEIGHT * BUFFER_WIDTH - start;
+	}
+
 #if defined(PIOS_VIDEO_SPLITBUFFER)
-	memset((uint8_t *)draw_buffer_mask, 0, BUFFER_HEIGHT * BUFFER_WIDTH);
-	memset((uint8_t *)draw_buffer_level, 0, BUFFER_HEIGHT * BUFFER_WIDTH);
+	memset(draw_buffer_mask + start, 0, len);
+	memset(draw_buffer_level + start, 0, len);
 #else
-	memset((uint8_t *)draw_buffer, 0, BUFFER_HEIGHT * BUFFER_WIDTH);
+	memset(draw_buffer + start, 0, len);
 #endif /* defined(PIOS_VIDEO_SPLITBUFFER) */
 }
 
+void clearGraphics()
+{
+	struct dirty_rows *d;
+
+	if (dirty[0].buffer == DRAW_BUFFER_ID) {
+		d = &dirty[0];
+	} else if (dirty[1].buffer == DRAW_BUFFER_ID) {
+		d = &dirty[1];
+	} else {
+		// Not seen yet, so nothing is known about what it holds
+		d = (draw_dirty == &dirty[0].bands) ? &dirty[1] : &dirty[0];
+		d->buffer = DRAW_BUFFER_ID;
+		d->bands = (1U << DIRTY_BANDS) - 1;
+	}
+
+	uint32_t bands = d->bands;
+
+	// Clear each run of dirty bands with one memset per buffer
+	while (bands) {
+		int first = __builtin_ctz(bands);
+		int num = __builtin_ctz(~(bands >> first));
+
+		clear_rows(first, num);
+
+		bands &= ~(((1U << num) - 1) << first);
+	}
+
+	d->bands = 0;
+	draw_dirty = &d->bands;
+}
+
 void draw_image(uint16_t x, uint16_t y, const struct Image * image)
 {
 #if defined(PIOS_VIDEO_SPLITBUFFER)
 	CHECK_COORDS(x + image->width, y + image->height);
+	mark_dirty(y, y + image->height - 1);
 	uint8_t byte_width = image->width / 8;
 	uint8_t pixel_offset = x % 8;
 	uint8_t mask1 = 0xFF;
@@ -97,6 +169,7 @@ void draw_image(uint16_t x, uint16_t y, const struct Image * image)
 	}
 #else
 	CHECK_COORDS(x + image->width, y + image->height);
+	mark_dirty(y, y + image->height - 1);
 	uint8_t byte_width = image->width / 4;
 	uint8_t pixel_offset = 2 * (x % 4);
 	uint8_t mask1 = 0xFF;
@@ -235,6 +308,7 @@ void write_pixel(uint8_t *buff, int x, int y, int mode)
 	// index to set it in.
 	int wordnum = CALC_BUFF_ADDR(x, y);
 	uint8_t mask = CALC_BIT_MASK(x);
+	mark_dirty(y, y);
 	WRITE_WORD_MODE(buff, wordnum, mask, mode);
 }
 #else
@@ -245,6 +319,7 @@ void write_pixel(int x, int y, uint8_t value)
 	// index to set it in.
 	int wordnum = CALC_BUFF_ADDR(x, y);
 	uint8_t mask = CALC_BIT_MASK(x);
+	mark_dirty(y, y);
 	WRITE_WORD(draw_buffer, wordnum, mask, value);
 }
 #endif /* PIOS_VIDEO_SPLITBUFFER */
@@ -265,6 +340,7 @@ void write_pixel_lm(int x, int y, int mmode, int lmode)
 	// index to set it in.
 	int addr   = CALC_BUFF_ADDR(x, y);
 	uint8_t mask = CALC_BIT_MASK(x);
+	mark_dirty(y, y);
 #if defined(PIOS_VIDEO_SPLITBUFFER)
 	WRITE_WORD_MODE(draw_buffer_mask, addr, mask, mmode);
 	WRITE_WORD_MODE(draw_buffer_level, addr, mask, lmode);
@@ -274,6 +350,47 @@ void write_pixel_lm(int x, int y, int mmode, int lmode)
 #endif /* defined(PIOS_VIDEO_SPLITBUFFER) */
 }
 
+#if defined(PIOS_VIDEO_SPLITBUFFER)
+/**
+ * write_span: apply a mode to every pixel of a run of whole bytes, a word at
+ * a time where the run is long enough.
+ *
+ * @param       buff    pointer to buffer to write in
+ * @param       addr    first byte
+ * @param       len     number of bytes
+ * @param       mode    0 = clear, 1 = set, 2 = toggle
+ */
+static void write_span(uint8_t *buff, int addr, int len, int mode)
+{
+	uint8_t *p = buff + addr;
+
+	if (len <= 0) {
+		return;
+	}
+
+	switch (mode) {
+	case 0:
+		memset(p, 0, len);
+		break;
+	case 1:
+		memset(p, 0xff, len);
+		break;
+	case 2:
+		while (len && ((uintptr_t)p & 3)) {
+			*(p++) ^= 0xff;
+			len--;
+		}
+		for (; len >= 4; len -= 4, p += 4) {
+			*((uint32_t *)p) ^= 0xffffffff;
+		}
+		while (len--) {
+			*(p++) ^= 0xff;
+		}
+		break;
+	}
+}
+#endif /* defined(PIOS_VIDEO_SPLITBUFFER) */
+
 /**
  * write_hline: optimised horizontal line writing algorithm
  *
@@ -295,13 +412,14 @@ void write_hline(uint8_t *buff, int x0, int x1, int y, int mode)
 	if (x0 == x1) {
 		return;
 	}
+	mark_dirty(y, y);
 	/* This is an optimised algorithm for writing horizontal lines.
 	 * We begin by finding the addresses of the x0 and x1 points. */
 	int addr0     = CALC_BUFF_ADDR(x0, y);
 	int addr1     = CALC_BUFF_ADDR(x1, y);
 	int addr0_bit = CALC_BIT_IN_WORD(x0);
 	int addr1_bit = CALC_BIT_IN_WORD(x1);
-	int mask, mask_l, mask_r, i;
+	int mask, mask_l, mask_r;
 	/* If the addresses are equal, we only need to write one word
 	 * which is an island. */
 	if (addr0 == addr1) {
@@ -313,11 +431,8 @@ void write_hline(uint8_t *buff, int x0, int x1, int y, int mode)
 		mask_r = COMPUTE_HLINE_EDGE_R_MASK(addr1_bit);
 		WRITE_WORD_MODE(buff, addr0, mask_l, mode);
 		WRITE_WORD_MODE(buff, addr1, mask_r, mode);
-		// Now write 0xffff words from start+1 to end-1.
-		for (i = addr0 + 1; i <= addr1 - 1; i++) {
-			uint8_t m = 0xff;
-			WRITE_WORD_MODE(buff, i, m, mode);
-		}
+		// Now write whole bytes from start+1 to end-1.
+		write_span(buff, addr0 + 1, addr1 - addr0 - 1, mode);
 	}
 }
 #else
@@ -332,13 +447,14 @@ void write_hline(int x0, int x1, int y, uint8_t value)
 	if (x0 == x1) {
 		return;
 	}
+	mark_dirty(y, y);
 	/* This is an optimised algorithm for writing horizontal lines.
 	 * We begin by finding the addresses of the x0 and x1 points. */
 	int addr0     = CALC_BUFF_ADDR(x0, y);
 	int addr1     = CALC_BUFF_ADDR(x1, y);
 	int addr0_bit = CALC_BIT1_IN_WORD(x0);
 	int addr1_bit = CALC_BIT0_IN_WORD(x1);
-	int mask, mask_l, mask_r, i;
+	int mask, mask_l, mask_r;
 	/* If the addresses are equal, we only need to write one word
 	 * which is an island. */
 	if (addr0 == addr1) {
@@ -350,10 +466,9 @@ void write_hline(int x0, int x1, int y, uint8_t value)
 		mask_r = COMPUTE_HLINE_EDGE_R_MASK(addr1_bit);
 		WRITE_WORD(draw_buffer, addr0, mask_l, value);
 		WRITE_WORD(draw_buffer, addr1, mask_r, value);
-		// Now write 0xffff words from start+1 to end-1.
-		for (i = addr0 + 1; i <= addr1 - 1; i++) {
-			uint8_t m = 0xff;
-			WRITE_WORD(draw_buffer, i, m, value);
+		// Now write whole bytes from start+1 to end-1.
+		if (addr1 - addr0 > 1) {
+			memset(draw_buffer + addr0 + 1, value, addr1 - addr0 - 1);
 		}
 	}
 }
@@ -432,6 +547,7 @@ void write_vline(uint8_t *buff, int x, int y0, int y1, int mode)
 	if (y0 == y1) {
 		return;
 	}
+	mark_dirty(y0, y1);
 	/* This is an optimised algorithm for writing vertical lines.
 	 * We begin by finding the addresses of the x,y0 and x,y1 points. */
 	int addr0  = CALC_BUFF_ADDR(x, y0);
@@ -456,6 +572,7 @@ void write_vline(int x, int y0, int y1, uint8_t value)
 	if (y0 == y1) {
 		return;
 	}
+	mark_dirty(y0, y1);
 	/* This is an optimised algorithm for writing vertical lines.
 	 * We begin by finding the addresses of the x,y0 and x,y1 points. */
 	int addr0  = CALC_BUFF_ADDR(x, y0);
@@ -546,13 +663,14 @@ void write_filled_rectangle(uint8_t *buff, int x, int y, int width, int height,
 	if (width <= 0 || height <= 0) {
 		return;
 	}
+	mark_dirty(y, y + height - 1);
 	// Calculate as if the rectangle was only a horizontal line. We then
 	// step these addresses through each row until we iterate `height` times.
 	int addr0     = CALC_BUFF_ADDR(x, y);
 	int addr1     = CALC_BUFF_ADDR(x + width, y);
 	int addr0_bit = CALC_BIT_IN_WORD(x);
 	int addr1_bit = CALC_BIT_IN_WORD(x + width);
-	int mask, mask_l, mask_r, i;
+	int mask, mask_l, mask_r;
 	// If the addresses are equal, we need to write one word vertically.
 	if (addr0 == addr1) {
 		mask = COMPUTE_HLINE_ISLAND_MASK(addr0_bit, addr1_bit);
@@ -580,10 +698,7 @@ void write_filled_rectangle(uint8_t *buff, int x, int y, int width, int height,
 		addr0 = addr0_old;
 		addr1 = addr1_old;
 		while (yy < height) {
-			for (i = addr0 + 1; i <= addr1 - 1; i++) {
-				uint8_t m = 0xff;
-				WRITE_WORD_MODE(buff, i, m, mode);
-			}
+			write_span(buff, addr0 + 1, addr1 - addr0 - 1, mode);
 			addr0 += BUFFER_WIDTH;
 			addr1 += BUFFER_WIDTH;
 			yy++;
@@ -600,13 +715,14 @@ void write_filled_rectangle(int x, int y, int width, int height, uint8_t value)
 	if (width <= 0 || height <= 0) {
 		return;
 	}
+	mark_dirty(y, y + height - 1);
 	// Calculate as if the rectangle was only a horizontal line. We then
 	// step these addresses through each row until we iterate `height` times.
 	int addr0     = CALC_BUFF_ADDR(x, y);
 	int addr1     = CALC_BUFF_ADDR(x + width, y);
 	int addr0_bit = CALC_BIT_IN_WORD(x);
 	int addr1_bit = CALC_BIT_IN_WORD(x + width);
-	int mask, mask_l, mask_r, i;
+	int mask, mask_l, mask_r;
 	// If the addresses are equal, we need to write one word vertically.
 	if (addr0 == addr1) {
 		mask = COMPUTE_HLINE_ISLAND_MASK(addr0_bit, addr1_bit);
@@ -634,9 +750,8 @@ void write_filled_rectangle(int x, int y, int width, int height, uint8_t value)
 		addr0 = addr0_old;
 		addr1 = addr1_old;
 		while (yy < height) {
-			for (i = addr0 + 1; i <= addr1 - 1; i++) {
-				uint8_t m = 0xff;
-				WRITE_WORD(draw_buffer, i, m, value);
+			if (addr1 - addr0 > 1) {
+				memset(draw_buffer + addr0 + 1, value, addr1 - addr0 - 1);
 			}
 			addr0 += BUFFER_WIDTH;
 			addr1 += BUFFER_WIDTH;
@@ -1195,6 +1310,41 @@ void write_word_misaligned_MASKED(uint8_t *buff, uint16_t word, uint16_t mask, u
 }
 
 
+#if defined(PIOS_VIDEO_SPLITBUFFER)
+/**
+ * write_glyph_row: Draw one row of a character on both draw buffers in a
+ * single pass.  Does the same as OR-ing the mask into both buffers and then
+ * NAND-ing the black pixels out of the level buffer, but touches each byte
+ * once.
+ *
+ * @param       addr    address of first byte
+ * @param       xoff    x offset (0-7)
+ * @param       mask    pixels drawn (16 bits, leftmost in the top bit)
+ * @param       black   pixels drawn black
+ */
+static inline void write_glyph_row(unsigned int addr, unsigned int xoff,
+		uint16_t mask, uint16_t black)
+{
+	// The row covers up to three bytes
+	uint32_t m = (uint32_t)mask << (8 - xoff);
+	uint32_t b = (uint32_t)black << (8 - xoff);
+
+	for (int i = 0; i < 3 && m; i++) {
+		uint8_t mb = m >> 16;
+		uint8_t bb = b >> 16;
+
+		if (mb) {
+			draw_buffer_mask[addr + i] |= mb;
+			draw_buffer_level[addr + i] =
+				(draw_buffer_level[addr + i] | mb) & ~bb;
+		}
+
+		m = (m << 8) & 0xffffff;
+		b = (b << 8) & 0xffffff;
+	}
+}
+#endif /* defined(PIOS_VIDEO_SPLITBUFFER) */
+
 /**
  * write_char: Draw a character on the current draw buffer.
  *
@@ -1224,6 +1374,8 @@ void write_char(uint8_t ch, int x, int y, const struct FontEntry *font_info)
 		return;
 	}
 
+	mark_dirty(MAX(y, GRAPHICS_TOP), MIN(y + font_info->height - 1, GRAPHICS_BOTTOM));
+
 	// Compute starting address of character
 	int addr = CALC_BUFF_ADDR(x, y);
 	int wbit = CALC_BIT_IN_WORD(x);
@@ -1237,12 +1389,7 @@ void write_char(uint8_t ch, int x, int y, const struct FontEntry *font_info)
 #if defined(PIOS_VIDEO_SPLITBUFFER)
 				mask = data & 0xFFFF;
 				levels   = (data >> 16) & 0xFFFF;
-				// mask
-				write_word_misaligned_OR(draw_buffer_mask, mask, addr, wbit);
-				// level
-				write_word_misaligned_OR(draw_buffer_level, mask, addr, wbit);
-				mask = (mask & levels);
-				write_word_misaligned_NAND(draw_buffer_level, mask, addr, wbit);
+				write_glyph_row(addr, wbit, mask, mask & levels);
 #else
 				data16 = (data & 0xFFFF0000) >> 16;
 				mask = data16 | (data16 << 1);
@@ -1264,12 +1411,7 @@ void write_char(uint8_t ch, int x, int y, const struct FontEntry *font_info)
 #if defined(PIOS_VIDEO_SPLITBUFFER)
 				levels = data & 0xFF00;
 				mask = (data & 0x00FF) << 8;
-				// mask
-				write_word_misaligned_OR(draw_buffer_mask, mask, addr, wbit);
-				// level
-				write_word_misaligned_OR(draw_buffer_level, mask, addr, wbit);
-				mask = (mask & levels);
-				write_word_misaligned_NAND(draw_buffer_level, mask, addr, wbit);
+				write_glyph_row(addr, wbit, mask, mask & levels);
 #else
 				mask = data | (data << 1);
 				write_word_misaligned_MASKED(draw_buffer, data, mask, addr, wbit);
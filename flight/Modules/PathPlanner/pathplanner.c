@@ -315,16 +315,19 @@ static bool waypointValid(int32_t idx) {
 		return false;
 	}
 
-	// Get the activated waypoint
-	WaypointData waypoint;
-	WaypointInstGet(idx, &waypoint);
+	// Peek at the waypoint in place; we only need its mode
+	const WaypointData *wp = WaypointInstBorrow(idx);
 
-	// Perhaps should fully validate here..
-	if (waypoint.Mode == WAYPOINT_MODE_INVALID) {
+	if (!wp) {
 		return false;
 	}
 
-	return true;
+	// Perhaps should fully validate here..
+	bool valid = wp->Mode != WAYPOINT_MODE_INVALID;
+
+	WaypointRelease();
+
+	return valid;
 }
 
 /**
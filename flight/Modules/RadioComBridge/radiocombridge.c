@@ -86,6 +86,9 @@ typedef struct {
 	UAVTalkConnection radioUAVTalkCon;
 
 	volatile bool have_port;
+
+	// Port of the telemetry side frame being built in place
+	uintptr_t telem_reserved_port;
 } RadioComBridgeData;
 
 // ****************
@@ -95,6 +98,10 @@ static void telemetryRxTask(void *parameters);
 static void radioRxTask(void *parameters);
 static int32_t UAVTalkSendHandler(void *ctx, uint8_t * buf, int32_t length);
 static int32_t RadioSendHandler(void *ctx, uint8_t * buf, int32_t length);
+static uint8_t *UAVTalkReserveHandler(void *ctx, uint16_t length);
+static int32_t UAVTalkCommitHandler(void *ctx, uint16_t length);
+static uint8_t *RadioReserveHandler(void *ctx, uint16_t length);
+static int32_t RadioCommitHandler(void *ctx, uint16_t length);
 
 static void ProcessLocalStream(UAVTalkConnection inConnectionHandle,
 				   UAVTalkConnection outConnectionHandle,
@@ -250,6 +257,12 @@ static int32_t RadioComBridgeInitialize(void)
 		return -1;
 	}
 
+	// Relayed frames go straight into the other side's transmit buffer
+	UAVTalkSetInPlaceOutput(data->telemUAVTalkCon, UAVTalkReserveHandler,
+			UAVTalkCommitHandler);
+	UAVTalkSetInPlaceOutput(data->radioUAVTalkCon, RadioReserveHandler,
+			RadioCommitHandler);
+
 	return 0;
 }
 
@@ -314,20 +327,23 @@ static void radioRxTask( __attribute__ ((unused))
 #endif
 		if (PIOS_COM_RADIOBRIDGE &&
 				PIOS_COM_Available(PIOS_COM_RADIOBRIDGE)) {
-			uint8_t serial_data[32];
+			// Parse straight out of the port buffer
+			const uint8_t *serial_data;
 			uint16_t bytes_to_process =
-			    PIOS_COM_ReceiveBuffer(PIOS_COM_RADIOBRIDGE,
-						   serial_data,
-						   sizeof(serial_data),
-						   MAX_PORT_DELAY);
+			    PIOS_COM_ReceiveSpan(PIOS_COM_RADIOBRIDGE,
+						 &serial_data,
+						 MAX_PORT_DELAY);
 			if (bytes_to_process > 0) {
 				// Pass the data through the UAVTalk parser.
-				for (uint8_t i = 0;
+				for (uint16_t i = 0;
 				     i < bytes_to_process; i++) {
 					ProcessRadioStream(data->radioUAVTalkCon,
 							   data->telemUAVTalkCon,
 							   serial_data[i]);
 				}
+
+				PIOS_COM_ReceiveSpanDone(PIOS_COM_RADIOBRIDGE,
+							 bytes_to_process);
 			}
 
 			/* periodically inject ComBridgeStats to downstream */
@@ -381,24 +397,26 @@ static void telemetryRxTask( __attribute__ ((unused))
 		}
 
 		if (inputPort) {
-			uint8_t serial_data[32];
+			const uint8_t *serial_data;
 			uint16_t bytes_to_process =
-			    PIOS_COM_ReceiveBuffer(inputPort, serial_data,
-						   sizeof(serial_data),
-						   MAX_PORT_DELAY);
+			    PIOS_COM_ReceiveSpan(inputPort, &serial_data,
+						 MAX_PORT_DELAY);
 
 			if (bytes_to_process > 0) {
 				if (inputPort == PIOS_COM_TELEM_USB) {
 					processUsbActivity(true);
 				}
 
-				for (uint8_t i = 0; i < bytes_to_process;
+				for (uint16_t i = 0; i < bytes_to_process;
 						i++) {
 					ProcessLocalStream(
 						data->telemUAVTalkCon,
 						data->radioUAVTalkCon,
 						serial_data[i]);
 				}
+
+				PIOS_COM_ReceiveSpanDone(inputPort,
+							 bytes_to_process);
 			}
 		} else {
 			PIOS_Thread_Sleep(5);
@@ -454,6 +472,76 @@ static int32_t RadioSendHandler(void *ctx, uint8_t * buf, int32_t length)
 	}
 }
 
+/**
+ * Reserve space for a frame in the com port's transmit buffer.
+ *
+ * @param[in] length Length of the frame
+ * @return where to build the frame, or NULL to use UAVTalkSendHandler
+ */
+static uint8_t *UAVTalkReserveHandler(void *ctx, uint16_t length)
+{
+	(void) ctx;
+
+	uintptr_t outputPort = getComPort();
+
+	if (!outputPort) {
+		return NULL;
+	}
+
+	uint8_t *buf = PIOS_COM_SendReserve(outputPort, length,
+			RETRY_TIMEOUT_MS);
+
+	if (buf) {
+		data->telem_reserved_port = outputPort;
+	}
+
+	return buf;
+}
+
+/**
+ * Send a frame built in space from UAVTalkReserveHandler.
+ *
+ * @param[in] length Length of the frame, or 0 to drop it
+ * @return number of bytes transmitted
+ */
+static int32_t UAVTalkCommitHandler(void *ctx, uint16_t length)
+{
+	(void) ctx;
+
+	return PIOS_COM_SendCommit(data->telem_reserved_port, length);
+}
+
+/**
+ * Reserve space for a frame in the radio port's transmit buffer.
+ *
+ * @param[in] length Length of the frame
+ * @return where to build the frame, or NULL to use RadioSendHandler
+ */
+static uint8_t *RadioReserveHandler(void *ctx, uint16_t length)
+{
+	(void) ctx;
+
+	if (!PIOS_COM_RADIOBRIDGE) {
+		return NULL;
+	}
+
+	return PIOS_COM_SendReserve(PIOS_COM_RADIOBRIDGE, length,
+			RETRY_TIMEOUT_MS);
+}
+
+/**
+ * Send a frame built in space from RadioReserveHandler.
+ *
+ * @param[in] length Length of the frame, or 0 to drop it
+ * @return number of bytes transmitted
+ */
+static int32_t RadioCommitHandler(void *ctx, uint16_t length)
+{
+	(void) ctx;
+
+	return PIOS_COM_SendCommit(PIOS_COM_RADIOBRIDGE, length);
+}
+
 #define MetaObjectId(x) (x+1)
 /**
  * @brief Process a byte of data received on the telemetry stream
@@ -32,6 +32,7 @@
 
 int32_t sensors_init(void);
 bool sensors_step();
+uint8_t sensors_get_loop_divider(void);
 
 #endif
 
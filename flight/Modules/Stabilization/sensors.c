@@ -36,6 +36,8 @@
 #include "pios_queue.h"
 #include "misc_math.h"
 #include "lpfilter.h"
+#include "notchfilter.h"
+#include "magfit.h"
 #include "sensors.h"
 
 #if defined(PIOS_INCLUDE_PX4FLOW)
@@ -48,6 +50,7 @@ extern pios_i2c_t external_i2c_adapter_id;
 #include "attitudeactual.h"
 #include "attitudesettings.h"
 #include "baroaltitude.h"
+#include "flightstatus.h"
 #include "gyros.h"
 #include "gyrosbias.h"
 #include "homelocation.h"
@@ -58,23 +61,48 @@ extern pios_i2c_t external_i2c_adapter_id;
 #include "inssettings.h"
 #include "magnetometer.h"
 #include "magbias.h"
+#include "magfitstate.h"
+#include "motorrpm.h"
 #include "coordinate_conversions.h"
+#include "looptiming.h"
 
 // Private constants
 #define MAX_SENSOR_PERIOD 6	// allow sensor data as slow as 166Hz
 #define REQUIRED_GOOD_CYCLES 50
 #define MAX_TIME_BETWEEN_VALID_BARO_DATAS_US (100*1000)
 #define MAX_TIME_BETWEEN_VALID_MAG_DATAS_US (300*1000)
+#define RPM_NOTCH_MAX_HARMONICS 3
+#define MAX_GYRO_BATCH 8	// most gyro samples filtered per step
+#define RPM_NOTCH_MAX_MOTORS (NOTCHFILTER_MAX_STEERED / RPM_NOTCH_MAX_HARMONICS)
+
+// Gyro temperature compensation
+#define TEMP_COMP_BLOCK 500		// gyro samples averaged per temperature step
+#define TEMP_COMP_EPSILON 0.05f	// deg C the average must move by to recompute
+#define TEMP_COMP_REST_STDDEV 0.5f	// deg/s gyro spread for the board to be still
+#define TEMP_COMP_SCALE 50.0f		// deg C; temperatures are divided by it when learning
+#define TEMP_COMP_PRIOR_WEIGHT 20.0f	// blocks' worth of trust in the coefficients being refined
+#define TEMP_COMP_MIN_BLOCKS 10
+#define TEMP_COMP_SAVE_CHANGE 1.0f	// deg C between writes of the refined coefficients
+
+// Ellipsoid fit to the magnetometer
+#define MAG_FIT_FORGET 0.995f		// per sample taken, so about 200 samples remembered
+#define MAG_FIT_MIN_CHANGE 50.0f	// mGau a sample must differ from the last one taken by
+#define MAG_FIT_SOLVE_INTERVAL 25	// samples taken between solutions
+#define MAG_FIT_MIN_SAMPLES 100
+#define MAG_FIT_MIN_COVERAGE 6
+#define MAG_FIT_MAX_RESIDUAL 5.0f	// percent
 
 // Private types
 enum mag_calibration_algo {
 	MAG_CALIBRATION_PRELEMARI,
-	MAG_CALIBRATION_NORMALIZE_LENGTH
+	MAG_CALIBRATION_NORMALIZE_LENGTH,
+	MAG_CALIBRATION_ELLIPSOID
 };
 
 // Private functions
 static void update_accels(struct pios_sensor_accel_data *accel);
-static void update_gyros(struct pios_sensor_gyro_data *gyro);
+static void update_gyros(struct pios_sensor_gyro_data *gyros, int count);
+static void update_gyros_ring(uint32_t head);
 static void update_mags(struct pios_sensor_mag_data *mag);
 static void update_baro(struct pios_sensor_baro_data *baro);
 
@@ -92,15 +120,21 @@ extern int32_t simsensors_init(void);
 
 static void mag_calibration_prelemari(MagnetometerData *mag);
 static void mag_calibration_fix_length(MagnetometerData *mag);
+static void mag_calibration_ellipsoid(MagnetometerData *mag);
 
-static void updateTemperatureComp(float temperature, float *temp_bias);
+static void updateTemperatureComp(float temperature, const float *gyros, float *temp_bias);
+static void temp_comp_learn(float temperature, const float *gyro_mean);
 static void sensors_settings_update();
+static void update_rpm_notches();
 
 // Private variables
 static INSSettingsData insSettings;
 static AccelsData accelsData;
 
 static volatile bool settings_updated = true;
+static volatile bool motor_rpm_updated = true;
+static uint32_t gyro_seq;
+static uint8_t loop_divider = 1;
 
 // These values are initialized by settings but can be updated by the attitude algorithm
 static bool bias_correct_gyro = true;
@@ -118,15 +152,21 @@ static float gyro_coeff_x[4] = {0,0,0,0};
 static float gyro_coeff_y[4] = {0,0,0,0};
 static float gyro_coeff_z[4] = {0,0,0,0};
 static float gyro_temp_bias[3] = {0,0,0};
+static bool temp_comp_learning;
 static float z_accel_offset = 0;
 static float Rsb[3][3] = {{0}}; //! Rotation matrix that transforms from the body frame to the sensor board frame
 static int8_t rotate = 0;
 
 //! Select the algorithm to try and null out the magnetometer bias error
 static enum mag_calibration_algo mag_calibration_algo = MAG_CALIBRATION_PRELEMARI;
+static struct magfit mag_fit;
 
 static lpfilter_state_t gyro_filter;
 static lpfilter_state_t accel_filter;
+static notchfilter_state_t gyro_notch;
+static notchfilter_state_t gyro_rpm_notch;
+static uint8_t rpm_notch_harmonics;
+static float rpm_notch_min_freq;
 
 /**
  * API for sensor fusion algorithms:
@@ -148,13 +188,31 @@ int32_t sensors_init(void)
 		|| BaroAltitudeInitialize() == -1 \
 		|| MagnetometerInitialize() == -1 \
 		|| MagBiasInitialize() == -1 \
+		|| MagFitStateInitialize() == -1 \
 		|| AttitudeSettingsInitialize() == -1 \
 		|| SensorSettingsInitialize() == -1 \
-		|| INSSettingsInitialize() == -1) {
+		|| INSSettingsInitialize() == -1 \
+		|| MotorRPMInitialize() == -1 \
+		|| looptiming_init() == -1) {
 
 		return -1;
 	}
 
+	// Fixed from boot, as everything downstream is set up for the rate
+	SensorSettingsLoopDividerGet(&loop_divider);
+
+	if (loop_divider < 1) {
+		loop_divider = 1;
+	} else if (loop_divider > MAX_GYRO_BATCH) {
+		loop_divider = MAX_GYRO_BATCH;
+	}
+
+	uint16_t samp_rate = PIOS_SENSORS_GetSampleRate(PIOS_SENSOR_GYRO);
+
+	if (samp_rate) {
+		looptiming_set_period(1000000 * loop_divider / samp_rate);
+	}
+
 #if defined (PIOS_INCLUDE_OPTICALFLOW)
 	if (OpticalFlowSettingsInitialize() == -1){
 		return -1;
@@ -199,6 +257,7 @@ int32_t sensors_init(void)
 	AttitudeSettingsConnectCallbackCtx(UAVObjCbSetFlag, &settings_updated);
 	SensorSettingsConnectCallbackCtx(UAVObjCbSetFlag, &settings_updated);
 	INSSettingsConnectCallbackCtx(UAVObjCbSetFlag, &settings_updated);
+	MotorRPMConnectCallbackCtx(UAVObjCbSetFlag, &motor_rpm_updated);
 
 #ifdef PIOS_INCLUDE_SIMSENSORS
 	simsensors_init();
@@ -207,6 +266,14 @@ int32_t sensors_init(void)
 	return 0;
 }
 
+/**
+ * Gyro samples per step, from SensorSettings.LoopDivider at boot.
+ */
+uint8_t sensors_get_loop_divider(void)
+{
+	return loop_divider;
+}
+
 /**
  * This polls the gyros and pumps that data to other users.
  */
@@ -222,7 +289,8 @@ bool sensors_step()
 		sensors_settings_update();
 	}
 
-	struct pios_sensor_gyro_data gyros;
+	struct pios_sensor_gyro_data gyros[MAX_GYRO_BATCH];
+	uint32_t gyro_times[MAX_GYRO_BATCH];
 	struct pios_sensor_accel_data accels;
 	struct pios_sensor_mag_data mags;
 	struct pios_sensor_baro_data baro;
@@ -285,8 +353,55 @@ bool sensors_step()
 	}
 #endif /* PIOS_INCLUDE_RANGEFINDER */
 
-	//Block on gyro data but nothing else
-	if (PIOS_SENSORS_GetData(PIOS_SENSOR_GYRO, &gyros, MAX_SENSOR_PERIOD) == false) {
+	//Block on gyro data but nothing else, until loop_divider samples have
+	//come in; the loop is then locked to every loop_divider'th one.
+	//Ring-based gyros are read in place further down.
+	bool gyro_ring = PIOS_SENSORS_HasRing(PIOS_SENSOR_GYRO);
+	uint32_t gyro_head = 0;
+	int gyro_count = 0;
+
+	if (gyro_ring) {
+		gyro_head = gyro_seq;
+
+		do {
+			uint32_t head = PIOS_SENSORS_RingWait(PIOS_SENSOR_GYRO,
+					gyro_head, MAX_SENSOR_PERIOD);
+
+			if (head == gyro_head) {
+				break;
+			}
+
+			gyro_head = head;
+			gyro_count = gyro_head - gyro_seq;
+		} while (gyro_count < loop_divider);
+	} else {
+		do {
+			int got = PIOS_SENSORS_GetDataBatch(PIOS_SENSOR_GYRO,
+					gyros + gyro_count, gyro_times + gyro_count,
+					MAX_GYRO_BATCH - gyro_count, MAX_SENSOR_PERIOD);
+
+			if (!got) {
+				break;
+			}
+
+			gyro_count += got;
+		} while (gyro_count < loop_divider);
+	}
+
+	// Follow the newest sample through the loop
+	if (gyro_count) {
+		uint32_t sample_time = gyro_times[gyro_count - 1];
+
+		if (gyro_ring) {
+			PIOS_SENSORS_RingGet(PIOS_SENSOR_GYRO, gyro_head - 1,
+					&sample_time);
+		}
+
+		looptiming_begin(sample_time);
+		looptiming_mark(LOOPTIMING_READ);
+	}
+
+	if (gyro_count == 0) {
 		good_run = false;
 	} else {
 		ret = true;
@@ -301,7 +416,17 @@ bool sensors_step()
 
 	// Update gyros after the accels since the rest of the code expects
 	// the accels to be available first
-	update_gyros(&gyros);
+	if (gyro_count) {
+		if (motor_rpm_updated) {
+			update_rpm_notches();
+		}
+
+		if (gyro_ring) {
+			update_gyros_ring(gyro_head);
+		} else {
+			update_gyros(gyros, gyro_count);
+		}
+	}
 
 	// Check total time to get the sensors wasn't over the limit
 	uint32_t dT_us = PIOS_DELAY_DiffuS(timeval);
@@ -312,7 +437,7 @@ bool sensors_step()
 	}
 #endif
 
-	if (dT_us > (MAX_SENSOR_PERIOD * 1000)) {
+	if (dT_us > (MAX_SENSOR_PERIOD * 1000 * loop_divider)) {
 		good_run = false;
 	}
 
@@ -365,25 +490,91 @@ static void update_accels(struct pios_sensor_accel_data *accels)
 }
 
 /**
- * @brief Apply calibration and rotation to the raw gyro data
- * @param[in] gyros The raw gyro data
+ * @brief Scale and filter one raw gyro sample
+ * @param[in] gyros The raw gyro sample
+ * @param[out] gyros_out The filtered rates
  */
-static void update_gyros(struct pios_sensor_gyro_data *gyros)
+static void filter_gyros(const struct pios_sensor_gyro_data *gyros, float *gyros_out)
 {
 	// Scale the gyros
-	float gyros_out[3] = {
-	    gyros->x * gyro_scale[0],
-	    gyros->y * gyro_scale[1],
-	    gyros->z * gyro_scale[2]
-	};
+	gyros_out[0] = gyros->x * gyro_scale[0];
+	gyros_out[1] = gyros->y * gyro_scale[1];
+	gyros_out[2] = gyros->z * gyro_scale[2];
 
+	// Notch out tracked motor noise before the static lowpass
+	notchfilter_run(gyro_rpm_notch, gyros_out);
+	notchfilter_run(gyro_notch, gyros_out);
 	lpfilter_run(gyro_filter, gyros_out);
+}
+
+static void publish_gyros(float *gyros_out, float temperature);
+
+/**
+ * @brief Apply calibration and rotation to the raw gyro data
+ * @param[in] gyros The raw gyro samples, oldest first
+ * @param[in] count Number of samples, only the filtered newest is published
+ */
+static void update_gyros(struct pios_sensor_gyro_data *gyros, int count)
+{
+	float gyros_out[3];
+
+	for (int i = 0; i < count; i++) {
+		filter_gyros(&gyros[i], gyros_out);
+	}
+
+	publish_gyros(gyros_out, gyros[count - 1].temperature);
+}
+
+/**
+ * @brief Filter the new samples straight out of the driver's ring
+ * @param[in] head Sequence after the newest sample
+ */
+static void update_gyros_ring(uint32_t head)
+{
+	float gyros_out[3];
+	float temperature = 0;
+	bool filtered = false;
+
+	// If we fell behind, pick up at the oldest sample still around
+	gyro_seq = PIOS_SENSORS_RingOldest(PIOS_SENSOR_GYRO, gyro_seq);
 
+	for (; gyro_seq != head; gyro_seq++) {
+		const struct pios_sensor_gyro_data *sample =
+			PIOS_SENSORS_RingGet(PIOS_SENSOR_GYRO, gyro_seq, NULL);
+
+		if (!sample) {
+			continue;
+		}
+
+		struct pios_sensor_gyro_data raw = *sample;
+
+		// Drop it if the driver lapped us while reading it
+		if (!PIOS_SENSORS_RingValid(PIOS_SENSOR_GYRO, gyro_seq)) {
+			continue;
+		}
+
+		filter_gyros(&raw, gyros_out);
+		temperature = raw.temperature;
+		filtered = true;
+	}
+
+	if (filtered) {
+		publish_gyros(gyros_out, temperature);
+	}
+}
+
+/**
+ * @brief Apply bias correction and rotation to the filtered gyro data and publish it
+ * @param[in] gyros_out The filtered rates
+ * @param[in] temperature The gyro temperature
+ */
+static void publish_gyros(float *gyros_out, float temperature)
+{
 	GyrosData gyrosData;
-	gyrosData.temperature = gyros->temperature;
+	gyrosData.temperature = temperature;
 
 	// Update the bias due to the temperature
-	updateTemperatureComp(gyrosData.temperature, gyro_temp_bias);
+	updateTemperatureComp(gyrosData.temperature, gyros_out, gyro_temp_bias);
 
 	// Apply temperature bias correction before the rotation
 	if (bias_correct_gyro) {
@@ -423,6 +614,8 @@ static void update_gyros(struct pios_sensor_gyro_data *gyros)
 	}
 
 	GyrosSet(&gyrosData);
+
+	looptiming_mark(LOOPTIMING_FILTER);
 }
 
 /**
@@ -459,6 +652,9 @@ static void update_mags(struct pios_sensor_mag_data *mag)
 		case MAG_CALIBRATION_NORMALIZE_LENGTH:
 			mag_calibration_fix_length(&magData);
 			break;
+		case MAG_CALIBRATION_ELLIPSOID:
+			mag_calibration_ellipsoid(&magData);
+			break;
 		default:
 			// No calibration
 			break;
@@ -537,12 +733,21 @@ static void update_rangefinder(struct pios_sensor_rangefinder_data *data)
 
 /**
  * Compute the bias expected from temperature variation for each gyro
- * channel
+ * channel.  The temperature is averaged over a block of samples, and the
+ * polynomials are only evaluated again when that average moves.  When
+ * learning, each block the board spends disarmed and still also goes
+ * toward refining the coefficients.
+ * @param[in] temperature the gyro temperature
+ * @param[in] gyros the gyro rates with no temperature correction applied
+ * @param[out] temp_bias the bias to take out of the gyros
  */
-static void updateTemperatureComp(float temperature, float *temp_bias)
+static void updateTemperatureComp(float temperature, const float *gyros, float *temp_bias)
 {
-	static int temp_counter = -1;
+	static int temp_counter = 0;
 	static float temp_accum = 0;
+	static float gyro_accum[3];
+	static float gyro_sq_accum[3];
+	static float last_t = NAN;
 	static const float TEMP_MIN = -10;
 	static const float TEMP_MAX = 60;
 
@@ -551,22 +756,173 @@ static void updateTemperatureComp(float temperature, float *temp_bias)
 	if (temperature > TEMP_MAX)
 		temperature = TEMP_MAX;
 
-	if (temp_counter < 500) {
+	if (temp_counter < TEMP_COMP_BLOCK) {
 		temp_accum += temperature;
+
+		for (int i = 0; i < 3; i++) {
+			gyro_accum[i] += gyros[i];
+			gyro_sq_accum[i] += gyros[i] * gyros[i];
+		}
+
 		temp_counter ++;
-	} else {
-		float t = temp_accum / temp_counter;
-		temp_accum = 0;
-		temp_counter = 0;
-
-		// Compute a third order polynomial for each chanel after each 500 samples
-		temp_bias[0] = gyro_coeff_x[0] + gyro_coeff_x[1] * t + 
-		               gyro_coeff_x[2] * powf(t,2) + gyro_coeff_x[3] * powf(t,3);
-		temp_bias[1] = gyro_coeff_y[0] + gyro_coeff_y[1] * t + 
-		               gyro_coeff_y[2] * powf(t,2) + gyro_coeff_y[3] * powf(t,3);
-		temp_bias[2] = gyro_coeff_z[0] + gyro_coeff_z[1] * t + 
-		               gyro_coeff_z[2] * powf(t,2) + gyro_coeff_z[3] * powf(t,3);
+		return;
+	}
+
+	float t = temp_accum / temp_counter;
+
+	uint8_t armed;
+	FlightStatusArmedGet(&armed);
+
+	if (temp_comp_learning && armed == FLIGHTSTATUS_ARMED_DISARMED) {
+		float gyro_mean[3];
+		bool still = true;
+
+		for (int i = 0; i < 3; i++) {
+			gyro_mean[i] = gyro_accum[i] / temp_counter;
+
+			float var = gyro_sq_accum[i] / temp_counter - gyro_mean[i] * gyro_mean[i];
+
+			if (var > TEMP_COMP_REST_STDDEV * TEMP_COMP_REST_STDDEV)
+				still = false;
+		}
+
+		if (still) {
+			temp_comp_learn(t, gyro_mean);
+
+			// The coefficients may have moved under the cached bias
+			last_t = NAN;
+		}
+	}
+
+	temp_accum = 0;
+	temp_counter = 0;
+
+	for (int i = 0; i < 3; i++) {
+		gyro_accum[i] = 0;
+		gyro_sq_accum[i] = 0;
+	}
+
+	if (fabsf(t - last_t) < TEMP_COMP_EPSILON)
+		return;
+
+	last_t = t;
+
+	// Compute a third order polynomial for each chanel
+	temp_bias[0] = gyro_coeff_x[0] + t * (gyro_coeff_x[1] + t * (gyro_coeff_x[2] + t * gyro_coeff_x[3]));
+	temp_bias[1] = gyro_coeff_y[0] + t * (gyro_coeff_y[1] + t * (gyro_coeff_y[2] + t * gyro_coeff_y[3]));
+	temp_bias[2] = gyro_coeff_z[0] + t * (gyro_coeff_z[1] + t * (gyro_coeff_z[2] + t * gyro_coeff_z[3]));
+}
+
+/**
+ * Refine the gyro temperature coefficients with the mean gyro rates of a
+ * block spent still, which are all bias.  Least squares over every such
+ * block so far, held toward the coefficients from the settings so that a
+ * narrow spread of temperatures doesn't throw the curve off outside it.
+ * The result is used straight away, and written to @ref SensorSettings when
+ * the temperature has moved on enough since the last write.
+ * @param[in] temperature block mean temperature
+ * @param[in] gyro_mean block mean of each gyro, with no correction applied
+ */
+static void temp_comp_learn(float temperature, const float *gyro_mean)
+{
+	// Sums of u^k for k up to 6; the normal matrix is S[i + j]
+	static float S[7];
+	static float rhs[3][4];
+	static uint32_t blocks;
+	static float last_saved_t = NAN;
+
+	float *coeffs[3] = { gyro_coeff_x, gyro_coeff_y, gyro_coeff_z };
+
+	const float u = temperature / TEMP_COMP_SCALE;
+	float u_k = 1;
+
+	for (int k = 0; k < 7; k++) {
+		S[k] += u_k;
+
+		if (k < 4) {
+			for (int i = 0; i < 3; i++)
+				rhs[i][k] += u_k * gyro_mean[i];
+		}
+
+		u_k *= u;
+	}
+
+	if (++blocks < TEMP_COMP_MIN_BLOCKS)
+		return;
+
+	// Cholesky factor of the normal matrix plus the prior
+	float l[4][4];
+
+	for (int i = 0; i < 4; i++) {
+		for (int j = 0; j <= i; j++) {
+			float sum = S[i + j];
+
+			if (i == j)
+				sum += TEMP_COMP_PRIOR_WEIGHT;
+
+			for (int k = 0; k < j; k++)
+				sum -= l[i][k] * l[j][k];
+
+			if (i == j) {
+				if (!(sum > 0))
+					return;
+
+				l[i][i] = sqrtf(sum);
+			} else {
+				l[i][j] = sum / l[j][j];
+			}
+		}
+	}
+
+	for (int axis = 0; axis < 3; axis++) {
+		float theta[4];
+		float scale = 1;
+
+		// Coefficients of u rather than of the temperature
+		for (int k = 0; k < 4; k++) {
+			theta[k] = rhs[axis][k] + TEMP_COMP_PRIOR_WEIGHT * coeffs[axis][k] * scale;
+			scale *= TEMP_COMP_SCALE;
+		}
+
+		for (int i = 0; i < 4; i++) {
+			for (int k = 0; k < i; k++)
+				theta[i] -= l[i][k] * theta[k];
+
+			theta[i] /= l[i][i];
+		}
+
+		for (int i = 3; i >= 0; i--) {
+			for (int k = i + 1; k < 4; k++)
+				theta[i] -= l[k][i] * theta[k];
+
+			theta[i] /= l[i][i];
+		}
+
+		scale = 1;
+
+		for (int k = 0; k < 4; k++) {
+			if (isfinite(theta[k]))
+				coeffs[axis][k] = theta[k] / scale;
+
+			scale *= TEMP_COMP_SCALE;
+		}
 	}
+
+	if (fabsf(temperature - last_saved_t) < TEMP_COMP_SAVE_CHANGE)
+		return;
+
+	last_saved_t = temperature;
+
+	SensorSettingsData sensorSettings;
+	SensorSettingsGet(&sensorSettings);
+
+	for (int k = 0; k < 4; k++) {
+		sensorSettings.XGyroTempCoeff[k] = gyro_coeff_x[k];
+		sensorSettings.YGyroTempCoeff[k] = gyro_coeff_y[k];
+		sensorSettings.ZGyroTempCoeff[k] = gyro_coeff_z[k];
+	}
+
+	SensorSettingsSet(&sensorSettings);
 }
 
 /**
@@ -678,6 +1034,82 @@ static void mag_calibration_fix_length(MagnetometerData *mag)
 /**
  * Locally cache some variables from the AtttitudeSettings object
  */
+/**
+ * Fit an ellipsoid to the magnetometer as the craft turns, and once the fit
+ * is good move the @ref MagBias toward its center.  Unlike the other two
+ * this doesn't lean on the attitude estimate, which the bias being wrong
+ * corrupts, and it finds the scale too.  The scale only goes in
+ * @ref MagFitState, for the GCS to fold into the sensor settings.
+ */
+static void mag_calibration_ellipsoid(MagnetometerData *mag)
+{
+	MagBiasData magBias;
+	MagBiasGet(&magBias);
+
+	const float sample[3] = { mag->x, mag->y, mag->z };
+
+	// Remove the current estimate of the bias
+	mag->x -= magBias.x;
+	mag->y -= magBias.y;
+	mag->z -= magBias.z;
+
+	if (!magfit_add(&mag_fit, sample, MAG_FIT_MIN_CHANGE) ||
+			(mag_fit.samples % MAG_FIT_SOLVE_INTERVAL)) {
+		return;
+	}
+
+	float expected_norm = 0;
+
+	HomeLocationData homeLocation;
+	HomeLocationGet(&homeLocation);
+
+	if (homeLocation.Set == HOMELOCATION_SET_TRUE) {
+		expected_norm = sqrtf(homeLocation.Be[0] * homeLocation.Be[0] +
+				homeLocation.Be[1] * homeLocation.Be[1] +
+				homeLocation.Be[2] * homeLocation.Be[2]);
+	}
+
+	struct magfit_result fit;
+
+	MagFitStateData magFit;
+	MagFitStateGet(&magFit);
+
+	magFit.Samples = mag_fit.samples;
+
+	if (!magfit_solve(&mag_fit, expected_norm, &fit)) {
+		magFit.Status = (mag_fit.samples < MAG_FIT_MIN_SAMPLES) ?
+			MAGFITSTATE_STATUS_COLLECTING : MAGFITSTATE_STATUS_POOR;
+		MagFitStateSet(&magFit);
+		return;
+	}
+
+	for (int i = 0; i < 3; i++) {
+		magFit.Bias[i] = fit.bias[i];
+		magFit.Scale[i] = fit.scale[i];
+	}
+
+	magFit.Residual = fit.residual;
+	magFit.Coverage = fit.coverage;
+
+	if (mag_fit.samples < MAG_FIT_MIN_SAMPLES ||
+			fit.coverage < MAG_FIT_MIN_COVERAGE) {
+		magFit.Status = MAGFITSTATE_STATUS_COLLECTING;
+	} else if (fit.residual > MAG_FIT_MAX_RESIDUAL) {
+		magFit.Status = MAGFITSTATE_STATUS_POOR;
+	} else {
+		magFit.Status = MAGFITSTATE_STATUS_CONVERGED;
+
+		const float rate = MIN(insSettings.MagBiasNullingRate, 1.0f);
+
+		magBias.x += rate * (fit.bias[0] - magBias.x);
+		magBias.y += rate * (fit.bias[1] - magBias.y);
+		magBias.z += rate * (fit.bias[2] - magBias.z);
+		MagBiasSet(&magBias);
+	}
+
+	MagFitStateSet(&magFit);
+}
+
 static void sensors_settings_update()
 {
 	settings_updated = false;
@@ -723,6 +1155,20 @@ static void sensors_settings_update()
 	gyro_coeff_z[2] =  sensorSettings.ZGyroTempCoeff[2];
 	gyro_coeff_z[3] =  sensorSettings.ZGyroTempCoeff[3];
 	z_accel_offset  =  sensorSettings.ZAccelOffset;
+	temp_comp_learning = (sensorSettings.GyroTempCompLearning ==
+			SENSORSETTINGS_GYROTEMPCOMPLEARNING_ENABLED);
+
+	switch (insSettings.MagBiasNullingAlgorithm) {
+	case INSSETTINGS_MAGBIASNULLINGALGORITHM_FIXLENGTH:
+		mag_calibration_algo = MAG_CALIBRATION_NORMALIZE_LENGTH;
+		break;
+	case INSSETTINGS_MAGBIASNULLINGALGORITHM_ELLIPSOIDFIT:
+		mag_calibration_algo = MAG_CALIBRATION_ELLIPSOID;
+		break;
+	default:
+		mag_calibration_algo = MAG_CALIBRATION_PRELEMARI;
+		break;
+	}
 
 	// Zero out any adaptive tracking
 	MagBiasData magBias;
@@ -732,6 +1178,8 @@ static void sensors_settings_update()
 	magBias.z = 0;
 	MagBiasSet(&magBias);
 
+	magfit_init(&mag_fit, MAG_FIT_FORGET);
+
 	uint8_t bias_correct;
 	AttitudeSettingsBiasCorrectGyroGet(&bias_correct);
 	bias_correct_gyro = (bias_correct == ATTITUDESETTINGS_BIASCORRECTGYRO_TRUE);
@@ -757,6 +1205,54 @@ static void sensors_settings_update()
 
 	lpfilter_create(&gyro_filter, sensorSettings.LowpassCutoff, gyro_dT, sensorSettings.LowpassOrder, 3);
 	lpfilter_create(&accel_filter, sensorSettings.LowpassCutoff, accel_dT, sensorSettings.LowpassOrder, 3);
+	notchfilter_create(&gyro_notch, sensorSettings.DynamicNotches,
+		sensorSettings.NotchMinFrequency, sensorSettings.NotchMaxFrequency,
+		sensorSettings.NotchQ, gyro_dT, 3);
+
+	rpm_notch_harmonics = MIN(sensorSettings.RPMNotchHarmonics, RPM_NOTCH_MAX_HARMONICS);
+	rpm_notch_min_freq = sensorSettings.RPMNotchMinFrequency;
+	notchfilter_create_steered(&gyro_rpm_notch, rpm_notch_harmonics * RPM_NOTCH_MAX_MOTORS,
+		sensorSettings.RPMNotchQ, gyro_dT, 3);
+	motor_rpm_updated = true;
+}
+
+/**
+ * Place the RPM notches on the harmonics of each spinning motor
+ */
+static void update_rpm_notches()
+{
+	motor_rpm_updated = false;
+
+	if (rpm_notch_harmonics == 0) {
+		return;
+	}
+
+	MotorRPMData motorRPM;
+	MotorRPMGet(&motorRPM);
+
+	int notch = 0;
+	int motors = 0;
+
+	for (int i = 0; i < MOTORRPM_RPM_NUMELEM && motors < RPM_NOTCH_MAX_MOTORS; i++) {
+		if (motorRPM.RPM[i] == 0) {
+			continue;
+		}
+
+		float fundamental = motorRPM.RPM[i] / 60.0f;
+
+		for (int h = 1; h <= rpm_notch_harmonics; h++) {
+			float freq = fundamental * h;
+			notchfilter_set_frequency(gyro_rpm_notch, notch++,
+					freq >= rpm_notch_min_freq ? freq : 0);
+		}
+
+		motors++;
+	}
+
+	// Park the notches of motors that aren't reporting
+	for (; notch < rpm_notch_harmonics * RPM_NOTCH_MAX_MOTORS; notch++) {
+		notchfilter_set_frequency(gyro_rpm_notch, notch, 0);
+	}
 }
 /**
   * @}
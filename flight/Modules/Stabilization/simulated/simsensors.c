@@ -44,7 +44,9 @@
 #ifdef PIOS_INCLUDE_SIMSENSORS
 
 #include "accels.h"
+#include "actuatorcommand.h"
 #include "actuatordesired.h"
+#include "actuatorsettings.h"
 #include "airspeedactual.h"
 #include "attitudeactual.h"
 #include "attitudesimulated.h"
@@ -59,16 +61,21 @@
 #include "homelocation.h"
 #include "magnetometer.h"
 #include "magbias.h"
+#include "mixersettings.h"
 #include "ratedesired.h"
 #include "systemsettings.h"
 
 #include "coordinate_conversions.h"
+#include "misc_math.h"
 
 // Private constants
 #define STACK_SIZE_BYTES 1540
 #define TASK_PRIORITY PIOS_THREAD_PRIO_HIGH
 #define SENSOR_PERIOD 2
 
+// The multirotor model knows ten mixers, one per channel
+DONT_BUILD_IF(ACTUATORCOMMAND_CHANNEL_NUMELEM != 10, MixerChannelMismatch);
+
 // Private types
 
 // Private variables
@@ -78,7 +85,7 @@ static float rand_gauss();
 
 static int sens_rate = 500;
 
-enum sensor_sim_type {MODEL_YASIM, MODEL_QUADCOPTER, MODEL_AIRPLANE, MODEL_CAR} sensor_sim_type;
+enum sensor_sim_type {MODEL_YASIM, MODEL_QUADCOPTER, MODEL_MULTIROTOR, MODEL_AIRPLANE, MODEL_CAR} sensor_sim_type;
 
 static bool have_gyro_data, have_accel_data, have_mag_data, have_baro_data;
 
@@ -92,9 +99,12 @@ extern bool use_yasim;
 static void simulateYasim();
 #endif
 
+extern bool use_rigidbody;
+
 // Private functions
 static void simsensors_step();
 static void simulateModelQuadcopter();
+static void simulateModelMultirotor();
 static void simulateModelAirplane();
 static void simulateModelCar();
 
@@ -239,7 +249,8 @@ static void simsensors_step()
 		case SYSTEMSETTINGS_AIRFRAMETYPE_HEXA:
 		case SYSTEMSETTINGS_AIRFRAMETYPE_OCTO:
 		default:
-			sensor_sim_type = MODEL_QUADCOPTER;
+			sensor_sim_type = use_rigidbody ?
+				MODEL_MULTIROTOR : MODEL_QUADCOPTER;
 			break;
 		case SYSTEMSETTINGS_AIRFRAMETYPE_GROUNDVEHICLECAR:
 			sensor_sim_type = MODEL_CAR;
@@ -259,6 +270,9 @@ static void simsensors_step()
 		default:
 			simulateModelQuadcopter();
 			break;
+		case MODEL_MULTIROTOR:
+			simulateModelMultirotor();
+			break;
 		case MODEL_AIRPLANE:
 			simulateModelAirplane();
 			break;
@@ -692,76 +706,18 @@ static void simulateYasim()
 }
 #endif /* PIOS_INCLUDE_SIMSENSORS_YASIM */
 
-static void simulateModelQuadcopter()
+/**
+ * Produces the baro, GPS and mag readings and AttitudeSimulated for the
+ * multirotor models, from the true state of the airframe.
+ */
+static void simsensors_multirotor_outputs(double *pos, double *vel, float *q,
+		float (*Rbe)[3][3])
 {
-	static double pos[3] = {0,0,0};
-	static double vel[3] = {0,0,0};
-	static double ned_accel[3] = {0,0,0};
-	static float q[4] = {1,0,0,0};
-	static float rpy[3] = {0,0,0}; // Low pass filtered actuator
 	static float baro_offset = 0.0f;
-	float Rbe[3][3];
 
-	const float MAX_THRUST = GRAVITY * 2;
-	const float K_FRICTION = 1;
 	const float GPS_PERIOD = 0.1f;
 	const float MAG_PERIOD = 1.0 / 75.0;
 	const float BARO_PERIOD = 1.0 / 20.0;
-	const float GYRO_NOISE_SCALE = 1.0f;
-
-	float dT = 0.002;
-	float thrust;
-
-	simsensors_scale_controls(rpy, &thrust, MAX_THRUST);
-	simsensors_gyro_set(rpy, GYRO_NOISE_SCALE, 20);
-
-	// Predict the attitude forward in time
-	float qdot[4];
-	qdot[0] = (-q[1] * rpy[0] - q[2] * rpy[1] - q[3] * rpy[2]) * dT * DEG2RAD / 2;
-	qdot[1] = (q[0] * rpy[0] - q[3] * rpy[1] + q[2] * rpy[2]) * dT * DEG2RAD / 2;
-	qdot[2] = (q[3] * rpy[0] + q[0] * rpy[1] - q[1] * rpy[2]) * dT * DEG2RAD / 2;
-	qdot[3] = (-q[2] * rpy[0] + q[1] * rpy[1] + q[0] * rpy[2]) * dT * DEG2RAD / 2;
-
-	simsensors_quat_timestep(q, qdot);
-
-	static float wind[3] = {0,0,0};
-	wind[0] = wind[0] * 0.95 + rand_gauss() / 10.0;
-	wind[1] = wind[1] * 0.95 + rand_gauss() / 10.0;
-	wind[2] = wind[2] * 0.95 + rand_gauss() / 10.0;
-
-	Quaternion2R(q,Rbe);
-	// Make thrust negative as down is positive
-	ned_accel[0] = -thrust * Rbe[2][0];
-	ned_accel[1] = -thrust * Rbe[2][1];
-	// Gravity causes acceleration of 9.81 in the down direction
-	ned_accel[2] = -thrust * Rbe[2][2] + GRAVITY;
-
-	// Apply acceleration based on velocity
-	ned_accel[0] -= K_FRICTION * (vel[0] - wind[0]);
-	ned_accel[1] -= K_FRICTION * (vel[1] - wind[1]);
-	ned_accel[2] -= K_FRICTION * (vel[2] - wind[2]);
-
-	// Predict the velocity forward in time
-	vel[0] = vel[0] + ned_accel[0] * dT;
-	vel[1] = vel[1] + ned_accel[1] * dT;
-	vel[2] = vel[2] + ned_accel[2] * dT;
-
-	// Predict the position forward in time
-	pos[0] = pos[0] + vel[0] * dT;
-	pos[1] = pos[1] + vel[1] * dT;
-	pos[2] = pos[2] + vel[2] * dT;
-
-	// Simulate hitting ground
-	if(pos[2] > 0) {
-		pos[2] = 0;
-		vel[2] = 0;
-		ned_accel[2] = 0;
-	}
-
-	// Sensor feels gravity (when not acceleration in ned frame e.g. ned_accel[2] = 0)
-	ned_accel[2] -= GRAVITY;
-
-	simsensors_accels_setfromned(ned_accel, &Rbe, accel_bias, 30);
 
 	simsensors_baro_drift(&baro_offset);
 
@@ -833,7 +789,7 @@ static void simulateModelQuadcopter()
 	// Update mag periodically
 	static uint32_t last_mag_time = 0;
 	if (PIOS_Thread_Period_Elapsed(last_mag_time, MAG_PERIOD)) {
-		simsensors_mag_set(homeLocation.Be, &Rbe);
+		simsensors_mag_set(homeLocation.Be, Rbe);
 		last_mag_time = PIOS_Thread_Systime();
 	}
 
@@ -853,6 +809,263 @@ static void simulateModelQuadcopter()
 	AttitudeSimulatedSet(&attitudeSimulated);
 }
 
+static void simulateModelQuadcopter()
+{
+	static double pos[3] = {0,0,0};
+	static double vel[3] = {0,0,0};
+	static double ned_accel[3] = {0,0,0};
+	static float q[4] = {1,0,0,0};
+	static float rpy[3] = {0,0,0}; // Low pass filtered actuator
+	float Rbe[3][3];
+
+	const float MAX_THRUST = GRAVITY * 2;
+	const float K_FRICTION = 1;
+	const float GYRO_NOISE_SCALE = 1.0f;
+
+	float dT = 0.002;
+	float thrust;
+
+	simsensors_scale_controls(rpy, &thrust, MAX_THRUST);
+	simsensors_gyro_set(rpy, GYRO_NOISE_SCALE, 20);
+
+	// Predict the attitude forward in time
+	float qdot[4];
+	qdot[0] = (-q[1] * rpy[0] - q[2] * rpy[1] - q[3] * rpy[2]) * dT * DEG2RAD / 2;
+	qdot[1] = (q[0] * rpy[0] - q[3] * rpy[1] + q[2] * rpy[2]) * dT * DEG2RAD / 2;
+	qdot[2] = (q[3] * rpy[0] + q[0] * rpy[1] - q[1] * rpy[2]) * dT * DEG2RAD / 2;
+	qdot[3] = (-q[2] * rpy[0] + q[1] * rpy[1] + q[0] * rpy[2]) * dT * DEG2RAD / 2;
+
+	simsensors_quat_timestep(q, qdot);
+
+	static float wind[3] = {0,0,0};
+	wind[0] = wind[0] * 0.95 + rand_gauss() / 10.0;
+	wind[1] = wind[1] * 0.95 + rand_gauss() / 10.0;
+	wind[2] = wind[2] * 0.95 + rand_gauss() / 10.0;
+
+	Quaternion2R(q,Rbe);
+	// Make thrust negative as down is positive
+	ned_accel[0] = -thrust * Rbe[2][0];
+	ned_accel[1] = -thrust * Rbe[2][1];
+	// Gravity causes acceleration of 9.81 in the down direction
+	ned_accel[2] = -thrust * Rbe[2][2] + GRAVITY;
+
+	// Apply acceleration based on velocity
+	ned_accel[0] -= K_FRICTION * (vel[0] - wind[0]);
+	ned_accel[1] -= K_FRICTION * (vel[1] - wind[1]);
+	ned_accel[2] -= K_FRICTION * (vel[2] - wind[2]);
+
+	// Predict the velocity forward in time
+	vel[0] = vel[0] + ned_accel[0] * dT;
+	vel[1] = vel[1] + ned_accel[1] * dT;
+	vel[2] = vel[2] + ned_accel[2] * dT;
+
+	// Predict the position forward in time
+	pos[0] = pos[0] + vel[0] * dT;
+	pos[1] = pos[1] + vel[1] * dT;
+	pos[2] = pos[2] + vel[2] * dT;
+
+	// Simulate hitting ground
+	if(pos[2] > 0) {
+		pos[2] = 0;
+		vel[2] = 0;
+		ned_accel[2] = 0;
+	}
+
+	// Sensor feels gravity (when not acceleration in ned frame e.g. ned_accel[2] = 0)
+	ned_accel[2] -= GRAVITY;
+
+	simsensors_accels_setfromned(ned_accel, &Rbe, accel_bias, 30);
+
+	simsensors_multirotor_outputs(pos, vel, q, &Rbe);
+}
+
+/**
+ * Rigid-body multirotor, for when the closed loop should see real dynamics
+ * rather than the rate-command shortcut above.  It flies the motor outputs
+ * in ActuatorCommand: each motor's speed lags its command, its thrust goes
+ * with speed squared, and the moment it makes about each axis is taken from
+ * its mixer row.  Any frame the mixer can describe flies, and a mixer or
+ * controller mistake shows up the way it would on the real craft.  Gyro
+ * and accel noise grow with motor speed, to stand in for vibration.
+ */
+static void simulateModelMultirotor()
+{
+	static double pos[3] = {0,0,0};
+	static double vel[3] = {0,0,0};
+	static double ned_accel[3] = {0,0,0};
+	static float q[4] = {1,0,0,0};
+	static float rates[3] = {0,0,0};	// rad/s, body frame
+	static float motor_speed[ACTUATORCOMMAND_CHANNEL_NUMELEM];	// 0..1
+	float Rbe[3][3];
+
+	const float MASS = 1.0f;		// kg
+	const float MAX_THRUST = 2 * GRAVITY * MASS;	// N, all motors
+	const float MOTOR_TAU = 0.03f;		// s
+	const float ARM = 0.18f;		// m
+	const float YAW_MOMENT = 0.02f;		// Nm per N of thrust
+	const float INERTIA[3] = { 0.008f, 0.008f, 0.014f };	// kg m^2
+	const float ROT_DRAG = 0.01f;		// Nm per rad/s
+	const float K_FRICTION = 0.3f;		// N per m/s
+	const float GYRO_NOISE_SCALE = 0.5f;
+	const float GYRO_VIBRATION = 3.0f;	// deg/s at full speed
+	const float ACCEL_VIBRATION = 1.5f;	// m/s^2 at full speed
+
+	float dT = 0.002;
+
+	ActuatorCommandData cmd;
+	ActuatorCommandGet(&cmd);
+	ActuatorSettingsData actuatorSettings;
+	ActuatorSettingsGet(&actuatorSettings);
+	MixerSettingsData mixerSettings;
+	MixerSettingsGet(&mixerSettings);
+
+	int16_t (*vectors[])[MIXERSETTINGS_MIXER1VECTOR_NUMELEM] = {
+		&mixerSettings.Mixer1Vector, &mixerSettings.Mixer2Vector,
+		&mixerSettings.Mixer3Vector, &mixerSettings.Mixer4Vector,
+		&mixerSettings.Mixer5Vector, &mixerSettings.Mixer6Vector,
+		&mixerSettings.Mixer7Vector, &mixerSettings.Mixer8Vector,
+		&mixerSettings.Mixer9Vector, &mixerSettings.Mixer10Vector,
+	};
+	const uint8_t types[] = {
+		mixerSettings.Mixer1Type, mixerSettings.Mixer2Type,
+		mixerSettings.Mixer3Type, mixerSettings.Mixer4Type,
+		mixerSettings.Mixer5Type, mixerSettings.Mixer6Type,
+		mixerSettings.Mixer7Type, mixerSettings.Mixer8Type,
+		mixerSettings.Mixer9Type, mixerSettings.Mixer10Type,
+	};
+
+	int motors = 0;
+
+	for (int i = 0; i < NELEMENTS(types); i++) {
+		if (types[i] == MIXERSETTINGS_MIXER1TYPE_MOTOR) {
+			motors++;
+		}
+	}
+
+	float thrust = 0;
+	float moment[3] = {0,0,0};
+	float mean_speed = 0;
+
+	for (int i = 0; (i < NELEMENTS(types)) && motors; i++) {
+		if (types[i] != MIXERSETTINGS_MIXER1TYPE_MOTOR) {
+			continue;
+		}
+
+		float range = actuatorSettings.ChannelMax[i] -
+			actuatorSettings.ChannelMin[i];
+		float command = 0;
+
+		if (range != 0) {
+			command = bound_min_max((cmd.Channel[i] -
+					actuatorSettings.ChannelMin[i]) / range,
+					0, 1);
+		}
+
+		motor_speed[i] += (command - motor_speed[i]) * dT / MOTOR_TAU;
+
+		float motor_thrust = MAX_THRUST / motors *
+			motor_speed[i] * motor_speed[i];
+
+		thrust += motor_thrust;
+		moment[0] += ARM * motor_thrust *
+			(*vectors[i])[MIXERSETTINGS_MIXER1VECTOR_ROLL] / 128.0f;
+		moment[1] += ARM * motor_thrust *
+			(*vectors[i])[MIXERSETTINGS_MIXER1VECTOR_PITCH] / 128.0f;
+		moment[2] += YAW_MOMENT * motor_thrust *
+			(*vectors[i])[MIXERSETTINGS_MIXER1VECTOR_YAW] / 128.0f;
+
+		mean_speed += motor_speed[i] / motors;
+	}
+
+	// Euler's equations, with the products of inertia taken as zero
+	float omega_cross_J[3] = {
+		rates[1] * rates[2] * (INERTIA[2] - INERTIA[1]),
+		rates[2] * rates[0] * (INERTIA[0] - INERTIA[2]),
+		rates[0] * rates[1] * (INERTIA[1] - INERTIA[0]),
+	};
+
+	for (int i = 0; i < 3; i++) {
+		rates[i] += (moment[i] - ROT_DRAG * rates[i] - omega_cross_J[i]) /
+			INERTIA[i] * dT;
+	}
+
+	// Sitting on the ground without the thrust to lift off; the legs
+	// keep it from tipping
+	bool grounded = (pos[2] >= 0) && (thrust < MASS * GRAVITY);
+
+	if (grounded) {
+		rates[0] = rates[1] = rates[2] = 0;
+	}
+
+	float rpy[3] = {
+		rates[0] * RAD2DEG,
+		rates[1] * RAD2DEG,
+		rates[2] * RAD2DEG,
+	};
+
+	simsensors_gyro_set(rpy, GYRO_NOISE_SCALE + GYRO_VIBRATION * mean_speed,
+			20);
+
+	// Predict the attitude forward in time
+	float qdot[4];
+	qdot[0] = (-q[1] * rpy[0] - q[2] * rpy[1] - q[3] * rpy[2]) * dT * DEG2RAD / 2;
+	qdot[1] = (q[0] * rpy[0] - q[3] * rpy[1] + q[2] * rpy[2]) * dT * DEG2RAD / 2;
+	qdot[2] = (q[3] * rpy[0] + q[0] * rpy[1] - q[1] * rpy[2]) * dT * DEG2RAD / 2;
+	qdot[3] = (-q[2] * rpy[0] + q[1] * rpy[1] + q[0] * rpy[2]) * dT * DEG2RAD / 2;
+
+	simsensors_quat_timestep(q, qdot);
+
+	static float wind[3] = {0,0,0};
+	wind[0] = wind[0] * 0.95 + rand_gauss() / 10.0;
+	wind[1] = wind[1] * 0.95 + rand_gauss() / 10.0;
+	wind[2] = wind[2] * 0.95 + rand_gauss() / 10.0;
+
+	Quaternion2R(q,Rbe);
+	// Make thrust negative as down is positive
+	ned_accel[0] = -thrust / MASS * Rbe[2][0];
+	ned_accel[1] = -thrust / MASS * Rbe[2][1];
+	// Gravity causes acceleration of 9.81 in the down direction
+	ned_accel[2] = -thrust / MASS * Rbe[2][2] + GRAVITY;
+
+	// Apply acceleration based on velocity
+	ned_accel[0] -= K_FRICTION / MASS * (vel[0] - wind[0]);
+	ned_accel[1] -= K_FRICTION / MASS * (vel[1] - wind[1]);
+	ned_accel[2] -= K_FRICTION / MASS * (vel[2] - wind[2]);
+
+	if (grounded) {
+		ned_accel[0] = ned_accel[1] = 0;
+		vel[0] = vel[1] = 0;
+	}
+
+	// Predict the velocity forward in time
+	vel[0] = vel[0] + ned_accel[0] * dT;
+	vel[1] = vel[1] + ned_accel[1] * dT;
+	vel[2] = vel[2] + ned_accel[2] * dT;
+
+	// Predict the position forward in time
+	pos[0] = pos[0] + vel[0] * dT;
+	pos[1] = pos[1] + vel[1] * dT;
+	pos[2] = pos[2] + vel[2] * dT;
+
+	// Simulate hitting ground
+	if(pos[2] > 0) {
+		pos[2] = 0;
+		vel[2] = 0;
+		ned_accel[2] = 0;
+	}
+
+	// Sensor feels gravity (when not acceleration in ned frame e.g. ned_accel[2] = 0)
+	double sensed[3] = {
+		ned_accel[0] + rand_gauss() * ACCEL_VIBRATION * mean_speed,
+		ned_accel[1] + rand_gauss() * ACCEL_VIBRATION * mean_speed,
+		ned_accel[2] - GRAVITY + rand_gauss() * ACCEL_VIBRATION * mean_speed,
+	};
+
+	simsensors_accels_setfromned(sensed, &Rbe, accel_bias, 30);
+
+	simsensors_multirotor_outputs(pos, vel, q, &Rbe);
+}
+
 /**
  * This method performs a simple simulation of an airplane
  * 
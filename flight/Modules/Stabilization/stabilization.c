@@ -41,8 +41,10 @@
 
 #include "openpilot.h"
 #include "stabilization.h"
+#include "actuator.h"
 #include "pios_thread.h"
 #include "pios_queue.h"
+#include <eventdispatcher.h>
 
 #include "accels.h"
 #include "actuatordesired.h"
@@ -54,6 +56,7 @@
 #include "systemident.h"
 #include "stabilizationdesired.h"
 #include "stabilizationsettings.h"
+#include "stabilizationtuning.h"
 #include "subtrim.h"
 #include "subtrimsettings.h"
 #include "systemsettings.h"
@@ -62,6 +65,7 @@
 #include "lqgsettings.h"
 #include "rtkfestimate.h"
 #include "lqgsolution.h"
+#include "lqgsolutioncache.h"
 #include "systemalarms.h"
 
 #include "altitudeholdsettings.h"
@@ -76,6 +80,8 @@
 #include "misc_math.h"
 #include "smoothcontrol.h"
 #include "lqg.h"
+#include "looptiming.h"
+#include "blackbox.h"
 
 // Sensors subsystem which runs in this task
 #include "sensors.h"
@@ -96,6 +102,9 @@ DONT_BUILD_IF((MAX_AXES+0 != 3), stabAxisWrongCount);
 #endif
 
 #define TASK_PRIORITY PIOS_THREAD_PRIO_HIGHEST
+
+//! How often to check whether converged LQG gains need saving
+#define LQG_CACHE_SAVE_PERIOD_MS 1000
 #define FAILSAFE_TIMEOUT_MS 30
 #define COORDINATED_FLIGHT_MIN_ROLL_THRESHOLD 3.0f
 #define COORDINATED_FLIGHT_MAX_YAW_THRESHOLD 0.05f
@@ -158,6 +167,7 @@ static float weak_leveling_kp = 0;
 static uint8_t weak_leveling_max = 0;
 static bool lowThrottleZeroIntegral;
 static float max_rate_alpha = 0.8f;
+static struct expo_table rate_expo[MAX_AXES];
 float vbar_decay = 0.991f;
 
 #if defined(TARGET_MAY_HAVE_BARO)
@@ -169,9 +179,12 @@ static float altitude_hold_maxdescentrate;
 #endif
 
 static struct pid pids[PID_MAX];
+static pid_rate_kernel_t rate_kernel[MAX_AXES];
 static smoothcontrol_state rc_smoothing;
 #if defined(STABILIZATION_LQG)
 static lqg_t lqg[MAX_AXES];
+static uint32_t lqg_hash[MAX_AXES];
+static volatile bool lqg_cache_dirty;
 #endif
 
 #ifndef NO_CONTROL_DEADBANDS
@@ -183,6 +196,11 @@ static void stabilizationTask(void* parameters);
 static void zero_pids(void);
 static void calculate_pids(float dT);
 static void update_settings(float dT);
+static void apply_tuning(float dT);
+#if defined(STABILIZATION_LQG)
+static void load_lqg_solution(lqg_t lqg, int axis);
+static void save_lqg_cache(const UAVObjEvent *ev, void *ctx, void *obj, int len);
+#endif
 
 #ifndef NO_CONTROL_DEADBANDS
 #define get_deadband(axis) (deadbands ? (deadbands + axis) : NULL)
@@ -221,6 +239,16 @@ int32_t StabilizationStart()
 	taskHandle = PIOS_Thread_Create(stabilizationTask, "Stabilization", STACK_SIZE_BYTES, NULL, TASK_PRIORITY);
 	TaskMonitorAdd(TASKINFO_RUNNING_STABILIZATION, taskHandle);
 
+#if defined(STABILIZATION_LQG)
+	// Saving to flash stalls, so keep it out of the control loop
+	UAVObjEvent ev = {
+		.obj = LQGSolutionCacheHandle(),
+		.instId = 0,
+		.event = 0,
+	};
+	EventPeriodicCallbackCreate(&ev, save_lqg_cache, LQG_CACHE_SAVE_PERIOD_MS);
+#endif
+
 	return 0;
 }
 
@@ -231,6 +259,7 @@ int32_t StabilizationInitialize()
 {
 	// Initialize variables
 	if (StabilizationSettingsInitialize() == -1
+		|| StabilizationTuningInitialize() == -1
 		|| ActuatorDesiredInitialize() == -1
 		|| SubTrimInitialize() == -1
 		|| SubTrimSettingsInitialize() == -1
@@ -243,7 +272,8 @@ int32_t StabilizationInitialize()
 	if (LQGSettingsInitialize() == -1 ||
 		SystemIdentInitialize() == -1 ||
 		RTKFEstimateInitialize() == -1 ||
-		LQGSolutionInitialize() == -1) {
+		LQGSolutionInitialize() == -1 ||
+		LQGSolutionCacheInitialize() == -1) {
 		return -1;
 	}
 #endif
@@ -412,9 +442,9 @@ static void calculate_attitude_errors(uint8_t *axis_mode, float *raw_input,
 	quat_copy(&attitudeActual->q1, atti_inverse);
 	quat_inverse(atti_inverse);
 
-	quat_mult(atti_inverse, desired_quat, vehicle_reprojected);
+	quat_mult_normalize(atti_inverse, desired_quat, vehicle_reprojected);
 
-	Quaternion2RPY(vehicle_reprojected, local_attitude_error);
+	Quaternion2RPYApprox(vehicle_reprojected, local_attitude_error);
 
 	// Note we divide by the maximum limit here so the fraction ranges from 0 to 1 depending on
 	// how much is requested.
@@ -425,6 +455,26 @@ static void calculate_attitude_errors(uint8_t *axis_mode, float *raw_input,
 }
 
 #if defined(STABILIZATION_LQG)
+/**
+ * Identify the model and weights an axis is solved for, to match it
+ * against the cached solutions.
+ */
+static uint32_t lqg_settings_hash(const LQGSettingsData *lqgSettings, float beta, float tau, float dT, int axis)
+{
+	const float params[] = {
+		beta, tau, dT,
+		lqgSettings->RTKF[axis == YAW ? LQGSETTINGS_RTKF_YAWR : LQGSETTINGS_RTKF_R],
+		lqgSettings->RTKF[LQGSETTINGS_RTKF_Q1],
+		lqgSettings->RTKF[LQGSETTINGS_RTKF_Q2],
+		lqgSettings->RTKF[LQGSETTINGS_RTKF_Q3],
+		lqgSettings->LQRegulator[axis == YAW ? LQGSETTINGS_LQREGULATOR_YAWQ1 : LQGSETTINGS_LQREGULATOR_Q1],
+		lqgSettings->LQRegulator[axis == YAW ? LQGSETTINGS_LQREGULATOR_YAWQ2 : LQGSETTINGS_LQREGULATOR_Q2],
+		lqgSettings->LQRegulator[axis == YAW ? LQGSETTINGS_LQREGULATOR_YAWR : LQGSETTINGS_LQREGULATOR_R],
+	};
+
+	return PIOS_CRC32_updateCRC(0, (const uint8_t *) params, sizeof(params));
+}
+
 static void initialize_lqg_controllers(float dT)
 {
 	if (SystemIdentHandle()) {
@@ -435,6 +485,9 @@ static void initialize_lqg_controllers(float dT)
 		LQGSettingsGet(&lqgSettings);
 
 		for (int i = 0; i < MAX_AXES; i++) {
+			float beta = sysIdent.Beta[i];
+			float tau = (sysIdent.Tau[0] + sysIdent.Tau[1]) * 0.5f;
+
 			if (lqg[i]) {
 				/* Update Q matrix. */
 				lqr_t lqr = lqg_get_lqr(lqg[i]);
@@ -443,11 +496,12 @@ static void initialize_lqg_controllers(float dT)
 						lqgSettings.LQRegulator[i == YAW ? LQGSETTINGS_LQREGULATOR_YAWQ2 : LQGSETTINGS_LQREGULATOR_Q2],
 						lqgSettings.LQRegulator[i == YAW ? LQGSETTINGS_LQREGULATOR_YAWR : LQGSETTINGS_LQREGULATOR_R]
 					);
+
+				/* Going back to weights solved before skips the solver. */
+				lqg_hash[i] = lqg_settings_hash(&lqgSettings, beta, tau, dT, i);
+				load_lqg_solution(lqg[i], i);
 			} else {
 				/* Initial setup. */
-				float beta = sysIdent.Beta[i];
-				float tau = (sysIdent.Tau[0] + sysIdent.Tau[1]) * 0.5f;
-
 				if (tau > 0.001f && beta >= 6) {
 					rtkf_t rtkf = rtkf_create(beta, tau, dT,
 							lqgSettings.RTKF[i == YAW ? LQGSETTINGS_RTKF_YAWR : LQGSETTINGS_RTKF_R],
@@ -462,6 +516,9 @@ static void initialize_lqg_controllers(float dT)
 							lqgSettings.LQRegulator[i == YAW ? LQGSETTINGS_LQREGULATOR_YAWR : LQGSETTINGS_LQREGULATOR_R]
 						);
 					lqg[i] = lqg_create(rtkf, lqr);
+
+					lqg_hash[i] = lqg_settings_hash(&lqgSettings, beta, tau, dT, i);
+					load_lqg_solution(lqg[i], i);
 				}
 			}
 		}
@@ -496,6 +553,79 @@ static void dump_lqg_solution(lqg_t lqg, int axis)
 		LQGSolutionSet(&lqgsol);
 	}
 }
+
+static float *lqg_cache_kf(LQGSolutionCacheData *cache, int axis)
+{
+	switch (axis) {
+		case ROLL:
+			return cache->RollKF;
+		case PITCH:
+			return cache->PitchKF;
+		default:
+			return cache->YawKF;
+	}
+}
+
+static float *lqg_cache_k(LQGSolutionCacheData *cache, int axis)
+{
+	switch (axis) {
+		case ROLL:
+			return cache->RollK;
+		case PITCH:
+			return cache->PitchK;
+		default:
+			return cache->YawK;
+	}
+}
+
+/**
+ * Seed an axis from the cache if it holds a solution for the same model
+ * and weights.
+ */
+static void load_lqg_solution(lqg_t lqg, int axis)
+{
+	LQGSolutionCacheData cache;
+	LQGSolutionCacheGet(&cache);
+
+	if (lqg_hash[axis] && cache.Hash[axis] == lqg_hash[axis]) {
+		lqg_set_solution(lqg, lqg_cache_kf(&cache, axis), lqg_cache_k(&cache, axis));
+		dump_lqg_solution(lqg, axis);
+	}
+}
+
+static void store_lqg_solution(lqg_t lqg, int axis)
+{
+	LQGSolutionCacheData cache;
+	LQGSolutionCacheGet(&cache);
+
+	if (cache.Hash[axis] == lqg_hash[axis]) {
+		return;
+	}
+
+	cache.Hash[axis] = lqg_hash[axis];
+	lqg_get_solution(lqg, lqg_cache_kf(&cache, axis), lqg_cache_k(&cache, axis));
+
+	LQGSolutionCacheSet(&cache);
+	lqg_cache_dirty = true;
+}
+
+static void save_lqg_cache(const UAVObjEvent *ev, void *ctx, void *obj, int len)
+{
+	(void) ev; (void) ctx; (void) obj; (void) len;
+
+	if (!lqg_cache_dirty) {
+		return;
+	}
+
+	uint8_t armed;
+	FlightStatusArmedGet(&armed);
+
+	if (armed == FLIGHTSTATUS_ARMED_DISARMED) {
+		lqg_cache_dirty = false;
+		UAVObjSave(LQGSolutionCacheHandle(), 0);
+	}
+}
+
 #endif
 
 MODULE_HIPRI_INITCALL(StabilizationInitialize, StabilizationStart);
@@ -724,6 +854,7 @@ static void stabilizationTask(void* parameters)
 	SystemSettingsAirframeTypeOptions airframe_type;
 
 	volatile bool settings_updated = true;
+	volatile bool tuning_updated = false;
 	volatile bool flightstatus_updated = true;
 	volatile bool lqgsettings_updated = true;
 
@@ -735,6 +866,7 @@ static void stabilizationTask(void* parameters)
 	FlightStatusConnectCallbackCtx(UAVObjCbSetFlag, &flightstatus_updated);
 	SystemSettingsConnectCallbackCtx(UAVObjCbSetFlag, &settings_updated);
 	StabilizationSettingsConnectCallbackCtx(UAVObjCbSetFlag, &settings_updated);
+	StabilizationTuningConnectCallbackCtx(UAVObjCbSetFlag, &tuning_updated);
 	VbarSettingsConnectCallbackCtx(UAVObjCbSetFlag, &settings_updated);
 	SubTrimSettingsConnectCallbackCtx(UAVObjCbSetFlag, &settings_updated);
 #ifdef TARGET_MAY_HAVE_BARO
@@ -754,6 +886,7 @@ static void stabilizationTask(void* parameters)
 
 	uint32_t iteration = 0;
 	float dT_measured = 0;
+	uint32_t last_desired_publish = 0;
 
 	uint8_t ident_shift = 5;
 
@@ -761,8 +894,9 @@ static void stabilizationTask(void* parameters)
 
 	uint16_t samp_rate = PIOS_SENSORS_GetSampleRate(PIOS_SENSOR_GYRO);
 
+	// Run once per loop_divider gyro samples, and tune everything to that
 	if (samp_rate) {
-		dT_expected = 1.0f / samp_rate;
+		dT_expected = (float) sensors_get_loop_divider() / samp_rate;
 	}
 
 	smoothcontrol_update_dT(rc_smoothing, dT_expected);
@@ -819,6 +953,11 @@ static void stabilizationTask(void* parameters)
 			settings_updated = false;
 		}
 
+		if (tuning_updated) {
+			tuning_updated = false;
+			apply_tuning(dT_expected);
+		}
+
 		// Wait until the AttitudeRaw object is updated, if a timeout
 		// then alarm.  We don't update, and Actuator will notice and
 		// actuator-failsafe.
@@ -831,9 +970,17 @@ static void stabilizationTask(void* parameters)
 
 		static bool frequency_wrong = false;
 
-		float dT = PIOS_DELAY_DiffuS(timeval) * 1.0e-6f;
+		uint32_t period_us = PIOS_DELAY_DiffuS(timeval);
+		float dT = period_us * 1.0e-6f;
 		timeval = PIOS_DELAY_GetRaw();
 
+#ifdef FLIGHT_POSIX
+		if ((iteration >= 100) && !PIOS_Thread_FakeClock_IsActive()) {
+			PIOS_Thread_RecordJitter("Stabilization", period_us,
+					dT_expected * 1.0e6f + 0.5f);
+		}
+#endif
+
 		if (iteration < 100) {
 			dT_measured = 0;
 		} else if (iteration < 2100) {
@@ -935,6 +1082,13 @@ static void stabilizationTask(void* parameters)
 		bool failsafed = stabilization_failsafe_checks(&stabDesired, &actuatorDesired, airframe_type,
 			raw_input, axis_mode);
 
+#if defined(PIOS_INCLUDE_RCVR)
+		smoothcontrol_set_frame_age(rc_smoothing,
+				PIOS_RCVR_GetFrameAge() * 1e-6f);
+#else
+		smoothcontrol_set_frame_age(rc_smoothing, -1);
+#endif
+
 		// A flag to track which stabilization mode each axis is in
 		static uint8_t previous_mode[MAX_AXES] = {255,255,255};
 
@@ -974,33 +1128,32 @@ static void stabilizationTask(void* parameters)
 		for (int i = 0; i < MAX_AXES; i++) {
 			/* Solve for LQG, if it's configured for an axis. */
 			if (lqg[i]) {
-				int status = lqg_solver_status(lqg[i]);
+				if (lqg_solver_status(lqg[i]) == LQG_SOLVER_RUNNING) {
+					lqg_run_covariance(lqg[i], 1);
+
+					if (lqg_solver_status(lqg[i]) == LQG_SOLVER_DONE) {
+						dump_lqg_solution(lqg[i], i);
+						store_lqg_solution(lqg[i], i);
+					}
+				}
+
 				SystemAlarmsConfigErrorOptions err;
 				SystemAlarmsConfigErrorGet(&err);
-				switch(status) {
-					case LQG_SOLVER_RUNNING:
-						lqg_run_covariance(lqg[i], 1);
-						dump_lqg_solution(lqg[i], i);
-						/* Drop to failed, because we want to set the LQG config error during that time, anyway,
-						   to prevent arming. */
-					case LQG_SOLVER_FAILED:
-						/* Values don't converge in time, probably bogus. Light up the Christmas three. */
-						if (err != SYSTEMALARMS_CONFIGERROR_LQG) {
-							err = SYSTEMALARMS_CONFIGERROR_LQG;
-							SystemAlarmsConfigErrorSet(&err);
-							AlarmsSet(SYSTEMALARMS_ALARM_SYSTEMCONFIGURATION, SYSTEMALARMS_ALARM_ERROR);
-						}
-						break;
-					case LQG_SOLVER_DONE:
-						/* Clear the error, everything's ready to go. */
-						if (err == SYSTEMALARMS_CONFIGERROR_LQG) {
-							err = SYSTEMALARMS_CONFIGERROR_NONE;
-							SystemAlarmsConfigErrorSet(&err);
-							AlarmsClear(SYSTEMALARMS_ALARM_SYSTEMCONFIGURATION);
-						}
-						break;
-					default:
-						PIOS_Assert(0);
+
+				/* While re-solving for new weights, the previous solution stays in use. */
+				if (!lqg_gains_valid(lqg[i])) {
+					/* Still solving from scratch, or values don't converge in time, probably bogus.
+					   Light up the Christmas three, to prevent arming. */
+					if (err != SYSTEMALARMS_CONFIGERROR_LQG) {
+						err = SYSTEMALARMS_CONFIGERROR_LQG;
+						SystemAlarmsConfigErrorSet(&err);
+						AlarmsSet(SYSTEMALARMS_ALARM_SYSTEMCONFIGURATION, SYSTEMALARMS_ALARM_ERROR);
+					}
+				} else if (err == SYSTEMALARMS_CONFIGERROR_LQG) {
+					/* Clear the error, everything's ready to go. */
+					err = SYSTEMALARMS_CONFIGERROR_NONE;
+					SystemAlarmsConfigErrorSet(&err);
+					AlarmsClear(SYSTEMALARMS_ALARM_SYSTEMCONFIGURATION);
 				}
 			}
 		}
@@ -1021,7 +1174,7 @@ static void stabilizationTask(void* parameters)
 
 				case STABILIZATIONDESIRED_STABILIZATIONMODE_LQG:
 #if defined(STABILIZATION_LQG)
-					if (lqg[i] && (lqg_solver_status(lqg[i]) == LQG_SOLVER_DONE)) {
+					if (lqg_gains_valid(lqg[i])) {
 						if (reinit) {
 							lqg_set_x0(lqg[i], gyro_filtered[i]);
 						}
@@ -1049,7 +1202,7 @@ static void stabilizationTask(void* parameters)
 					rateDesiredAxis[i] = bound_sym(raw_input[i], settings.ManualRate[i]);
 
 					// Compute the inner loop
-					actuatorDesiredAxis[i] = pid_apply_setpoint_antiwindup(&pids[PID_GROUP_RATE + i], get_deadband(i),  rateDesiredAxis[i],  gyro_filtered[i], -1.0f, 1.0f, 1.0f);
+					actuatorDesiredAxis[i] = rate_kernel[i](&pids[PID_GROUP_RATE + i], get_deadband(i), rateDesiredAxis[i], gyro_filtered[i]);
 
 					break;
 
@@ -1061,9 +1214,8 @@ static void stabilizationTask(void* parameters)
 
 					raw_input[i] = bound_sym(raw_input[i], 1.0f);
 
-					float curve_cmd = expoM(raw_input[i],
-							settings.RateExpo[i],
-							settings.RateExponent[i]*0.1f);
+					float curve_cmd = expo_table_eval(&rate_expo[i],
+							raw_input[i]);
 
 					const float break_point = settings.AcroDynamicTransition[i]/100.0f;
 
@@ -1095,7 +1247,7 @@ static void stabilizationTask(void* parameters)
 					rateDesiredAxis[i] = bound_sym(curve_cmd * max_rate_filtered[i], max_rate_filtered[i]);
 
 					// Compute the inner loop
-					actuatorDesiredAxis[i] = pid_apply_setpoint_antiwindup(&pids[PID_GROUP_RATE + i], get_deadband(i),  rateDesiredAxis[i],  gyro_filtered[i], -1.0f, 1.0f, 1.0f);
+					actuatorDesiredAxis[i] = rate_kernel[i](&pids[PID_GROUP_RATE + i], get_deadband(i), rateDesiredAxis[i], gyro_filtered[i]);
 
 					break;
 
@@ -1121,7 +1273,7 @@ static void stabilizationTask(void* parameters)
 							}
 
 					// Compute the inner loop
-					actuatorDesiredAxis[i] = pid_apply_setpoint_antiwindup(&pids[PID_GROUP_RATE + i], get_deadband(i),  rateDesiredAxis[i],  gyro_filtered[i], -1.0f, 1.0f, 1.0f);
+					actuatorDesiredAxis[i] = rate_kernel[i](&pids[PID_GROUP_RATE + i], get_deadband(i), rateDesiredAxis[i], gyro_filtered[i]);
 					actuatorDesiredAxis[i] = factor * raw_input[i] + (1.0f - factor) * actuatorDesiredAxis[i];
 					actuatorDesiredAxis[i] = bound_sym(actuatorDesiredAxis[i], 1.0f);
 
@@ -1129,7 +1281,7 @@ static void stabilizationTask(void* parameters)
 
 				case STABILIZATIONDESIRED_STABILIZATIONMODE_ATTITUDELQG:
 #if defined(STABILIZATION_LQG)
-					if (lqg[i] && (lqg_solver_status(lqg[i]) == LQG_SOLVER_DONE)) {
+					if (lqg_gains_valid(lqg[i])) {
 						if (reinit) {
 							pids[PID_GROUP_ATT + i].iAccumulator = 0;
 							lqg_set_x0(lqg[i], gyro_filtered[i]);
@@ -1163,7 +1315,7 @@ static void stabilizationTask(void* parameters)
 					rateDesiredAxis[i] = bound_sym(rateDesiredAxis[i], settings.MaximumRate[i]);
 
 					// Compute the inner loop
-					actuatorDesiredAxis[i] = pid_apply_setpoint_antiwindup(&pids[PID_GROUP_RATE + i], get_deadband(i),  rateDesiredAxis[i],  gyro_filtered[i], -1.0f, 1.0f, 1.0f);
+					actuatorDesiredAxis[i] = rate_kernel[i](&pids[PID_GROUP_RATE + i], get_deadband(i), rateDesiredAxis[i], gyro_filtered[i]);
 					actuatorDesiredAxis[i] = bound_sym(actuatorDesiredAxis[i],1.0f);
 
 					break;
@@ -1188,7 +1340,7 @@ static void stabilizationTask(void* parameters)
 
 					// Compute desired rate as input biased towards leveling
 					rateDesiredAxis[i] = bound_sym(raw_input[i] + weak_leveling, settings.ManualRate[i]);
-					actuatorDesiredAxis[i] = pid_apply_setpoint_antiwindup(&pids[PID_GROUP_RATE + i], get_deadband(i),  rateDesiredAxis[i],  gyro_filtered[i], -1.0f, 1.0f, 1.0f);
+					actuatorDesiredAxis[i] = rate_kernel[i](&pids[PID_GROUP_RATE + i], get_deadband(i), rateDesiredAxis[i], gyro_filtered[i]);
 
 					break;
 				}
@@ -1213,7 +1365,7 @@ static void stabilizationTask(void* parameters)
 						rateDesiredAxis[i] = bound_sym(tmpRateDesired, settings.MaximumRate[i]);
 					}
 
-					actuatorDesiredAxis[i] = pid_apply_setpoint_antiwindup(&pids[PID_GROUP_RATE + i], get_deadband(i),  rateDesiredAxis[i],  gyro_filtered[i], -1.0f, 1.0f, 1.0f);
+					actuatorDesiredAxis[i] = rate_kernel[i](&pids[PID_GROUP_RATE + i], get_deadband(i), rateDesiredAxis[i], gyro_filtered[i]);
 
 					break;
 
@@ -1239,7 +1391,7 @@ static void stabilizationTask(void* parameters)
 					rateDesiredAxis[i] = bound_sym(rateDesiredAxis[i], settings.ManualRate[i]);
 
 					// Compute the inner loop
-					actuatorDesiredAxis[i] = pid_apply_setpoint_antiwindup(&pids[PID_GROUP_RATE + i], get_deadband(i),  rateDesiredAxis[i],  gyro_filtered[i], -1.0f, 1.0f, 1.0f);
+					actuatorDesiredAxis[i] = rate_kernel[i](&pids[PID_GROUP_RATE + i], get_deadband(i), rateDesiredAxis[i], gyro_filtered[i]);
 					actuatorDesiredAxis[i] = bound_sym(actuatorDesiredAxis[i],1.0f);
 
 					break;
@@ -1289,13 +1441,13 @@ static void stabilizationTask(void* parameters)
 						rateDesiredAxis[i] = bound_sym(rateDesiredAxis[i], settings.MaximumRate[i]);
 
 						// Compute the inner loop
-						actuatorDesiredAxis[i] = pid_apply_setpoint_antiwindup(&pids[PID_GROUP_RATE + i], get_deadband(i),  rateDesiredAxis[i],  gyro_filtered[i], -1.0f, 1.0f, 1.0f);
+						actuatorDesiredAxis[i] = rate_kernel[i](&pids[PID_GROUP_RATE + i], get_deadband(i), rateDesiredAxis[i], gyro_filtered[i]);
 					} else {
 						// Get the desired rate. yaw is always in rate mode in system ident.
 						rateDesiredAxis[i] = bound_sym(raw_input[i], settings.ManualRate[i]);
 
 						// Compute the inner loop only for yaw
-						actuatorDesiredAxis[i] = pid_apply_setpoint_antiwindup(&pids[PID_GROUP_RATE + i], get_deadband(i),  rateDesiredAxis[i],  gyro_filtered[i], -1.0f, 1.0f, 1.0f);
+						actuatorDesiredAxis[i] = rate_kernel[i](&pids[PID_GROUP_RATE + i], get_deadband(i), rateDesiredAxis[i], gyro_filtered[i]);
 					}
 
 					const float scale = settings.AutotuneActuationEffort[i];
@@ -1471,7 +1623,7 @@ static void stabilizationTask(void* parameters)
 					rateDesiredAxis[i] = bound_sym(rateDesiredAxis[i], settings.PoiMaximumRate[i]);
 
 					// Compute the inner loop
-					actuatorDesiredAxis[i] = pid_apply_setpoint_antiwindup(&pids[PID_GROUP_RATE + i], get_deadband(i),  rateDesiredAxis[i],  gyro_filtered[i], -1.0f, 1.0f, 1.0f);
+					actuatorDesiredAxis[i] = rate_kernel[i](&pids[PID_GROUP_RATE + i], get_deadband(i), rateDesiredAxis[i], gyro_filtered[i]);
 
 					break;
 				case STABILIZATIONDESIRED_STABILIZATIONMODE_DISABLED:
@@ -1527,7 +1679,21 @@ static void stabilizationTask(void* parameters)
 		// Save dT
 		actuatorDesired.UpdateTime = dT * 1000;
 
-		ActuatorDesiredSet(&actuatorDesired);
+		looptiming_mark(LOOPTIMING_STABILIZATION);
+
+		/* Mix and drive the outputs right here when configured to,
+		 * publishing ActuatorDesired only for telemetry and as the
+		 * actuator task's failsafe heartbeat.
+		 */
+		if (!actuator_run_inline(&actuatorDesired) ||
+				PIOS_Thread_Period_Elapsed(last_desired_publish,
+					ACTUATOR_INLINE_PUBLISH_MS)) {
+			ActuatorDesiredSet(&actuatorDesired);
+			last_desired_publish = PIOS_Thread_Systime();
+		}
+
+		blackbox_log_loop(gyro_filtered, rateDesiredAxis,
+				actuatorDesiredAxis);
 
 		if(flightStatus.Armed != FLIGHTSTATUS_ARMED_ARMED ||
 		   (lowThrottleZeroIntegral && get_throttle(&actuatorDesired, &airframe_type) == 0))
@@ -1573,11 +1739,16 @@ static uint8_t remap_smoothing_mode(uint8_t m)
 			return SMOOTHCONTROL_NORMAL;
 		case STABILIZATIONSETTINGS_MANUALCONTROLSMOOTHING_LINEAR:
 			return SMOOTHCONTROL_LINEAR;
+		case STABILIZATIONSETTINGS_MANUALCONTROLSMOOTHING_PREDICTIVE:
+			return SMOOTHCONTROL_PREDICTIVE;
 	}
 }
 
 static void calculate_pids(float dT)
 {
+	// Set up the derivative term, before the PIDs that use it
+	pid_configure_derivative(settings.DerivativeCutoff, settings.DerivativeGamma);
+
 	// Set the roll rate PID constants
 	pid_configure(&pids[PID_RATE_ROLL],
 	              settings.RollRatePID[STABILIZATIONSETTINGS_ROLLRATEPID_KP],
@@ -1655,9 +1826,6 @@ static void calculate_pids(float dT)
 	              settings.CoordinatedFlightYawPI[STABILIZATIONSETTINGS_COORDINATEDFLIGHTYAWPI_ILIMIT],
 		      dT);
 
-	// Set up the derivative term
-	pid_configure_derivative(settings.DerivativeCutoff, settings.DerivativeGamma);
-
 #ifndef NO_CONTROL_DEADBANDS
 	if(deadbands ||
 		settings.DeadbandWidth[STABILIZATIONSETTINGS_DEADBANDWIDTH_ROLL] ||
@@ -1674,6 +1842,12 @@ static void calculate_pids(float dT)
 			0.01f * (float)settings.DeadbandSlope[STABILIZATIONSETTINGS_DEADBANDSLOPE_YAW]);
 	}
 #endif
+
+	// Pick the rate loop kernels now rather than branching on the
+	// configuration every cycle
+	for (int i = 0; i < MAX_AXES; i++) {
+		rate_kernel[i] = pid_select_rate_kernel(get_deadband(i));
+	}
 }
 
 static void calculate_vert_pids(float dT)
@@ -1687,6 +1861,52 @@ static void calculate_vert_pids(float dT)
 #endif
 }
 
+/**
+ * Reconfigures one loop from a tuned set of gains, if they're new.
+ * @param[in,out] current the gains in settings, updated to the tuned ones
+ */
+static void tune_pid(struct pid *pid, float *current, const float *tuned,
+		int num_gains, float dT)
+{
+	if (!memcmp(current, tuned, num_gains * sizeof(float))) {
+		return;
+	}
+
+	memcpy(current, tuned, num_gains * sizeof(float));
+
+	if (num_gains == 4) {
+		// Kp, Ki, Kd, ILimit
+		pid_configure(pid, current[0], current[1], current[2], current[3], dT);
+	} else {
+		// Kp, Ki, ILimit
+		pid_configure(pid, current[0], current[1], 0, current[2], dT);
+	}
+}
+
+/**
+ * Takes the gains TxPID is tuning, faster than it writes them to
+ * StabilizationSettings, and reconfigures only the loops they changed
+ * rather than doing all of update_settings().  Integrators are left alone.
+ */
+static void apply_tuning(float dT)
+{
+	StabilizationTuningData tuning;
+	StabilizationTuningGet(&tuning);
+
+	tune_pid(&pids[PID_RATE_ROLL], settings.RollRatePID,
+			tuning.RollRatePID, STABILIZATIONSETTINGS_ROLLRATEPID_NUMELEM, dT);
+	tune_pid(&pids[PID_RATE_PITCH], settings.PitchRatePID,
+			tuning.PitchRatePID, STABILIZATIONSETTINGS_PITCHRATEPID_NUMELEM, dT);
+	tune_pid(&pids[PID_RATE_YAW], settings.YawRatePID,
+			tuning.YawRatePID, STABILIZATIONSETTINGS_YAWRATEPID_NUMELEM, dT);
+	tune_pid(&pids[PID_ATT_ROLL], settings.RollPI,
+			tuning.RollPI, STABILIZATIONSETTINGS_ROLLPI_NUMELEM, dT);
+	tune_pid(&pids[PID_ATT_PITCH], settings.PitchPI,
+			tuning.PitchPI, STABILIZATIONSETTINGS_PITCHPI_NUMELEM, dT);
+	tune_pid(&pids[PID_ATT_YAW], settings.YawPI,
+			tuning.YawPI, STABILIZATIONSETTINGS_YAWPI_NUMELEM, dT);
+}
+
 static void update_settings(float dT)
 {
 	SubTrimSettingsData subTrimSettings;
@@ -1706,6 +1926,11 @@ static void update_settings(float dT)
 	calculate_pids(dT);
 	calculate_vert_pids(dT);
 
+	for (int i = 0; i < MAX_AXES; i++) {
+		expo_table_build(&rate_expo[i], settings.RateExpo[i],
+				settings.RateExponent[i] * 0.1f);
+	}
+
 	// Maximum deviation to accumulate for axis lock
 	max_axis_lock = settings.MaxAxisLock;
 	max_axislock_rate = settings.MaxAxisLockRate;
@@ -44,8 +44,16 @@
 #define STACK_SIZE_BYTES 512
 #define TASK_PRIORITY PIOS_THREAD_PRIO_LOW
 
-#define STORM32BGC_PERIOD_MS  20  // 50 Hz
-#define STORM32BGC_QUEUE_SIZE 64
+#define STORM32BGC_PERIOD_MS      20  // 50 Hz, when CameraDesired isn't updated
+#define STORM32BGC_MIN_PERIOD_MS  5   // Updates closer than this share a frame
+#define STORM32BGC_ACK_PERIOD_MS  500 // How often a frame asks for an ACK
+#define STORM32BGC_QUEUE_SIZE     4
+
+#define STORM32BGC_START_ACK      0xFA // Start sign, asking for an ACK
+#define STORM32BGC_START_NOACK    0xF9 // Start sign, not asking for one
+#define STORM32BGC_START_REPLY    0xFB
+
+#define STORM32BGC_REPLY_LEN      6
 
 // Private types
 
@@ -60,7 +68,9 @@ static void storm32bgcTask(void *parameters);
 
 static inline uint16_t crc_calculate(uint8_t* pBuffer, int length);
 
-static uint8_t cmd_set_angle(float pitch, float roll, float yaw, uint8_t flags, uint8_t type);
+static void cmd_set_angle(float pitch, float roll, float yaw, uint8_t flags, uint8_t type, bool ack);
+static bool receive_ack(uint8_t *ack);
+static void set_alarm(uint8_t ack);
 
 // Local variables
 static uintptr_t storm32bgc_com_id;
@@ -119,35 +129,79 @@ int32_t Storm32BgcStart(void)
 
 MODULE_INITCALL(Storm32BgcInitialize, Storm32BgcStart);
 
+/**
+ * Sends the gimbal CameraDesired as soon as it's updated, or every
+ * STORM32BGC_PERIOD_MS if it isn't.  Updates coming quicker than the
+ * link should carry are folded into one frame.  Only a frame every
+ * STORM32BGC_ACK_PERIOD_MS asks for an ACK, and that's picked up as it
+ * comes in rather than waited for.
+ */
 static void storm32bgcTask(void *parameters)
 {
-	uint32_t now = PIOS_Thread_Systime();
-
 	CameraDesiredData cameraDesired;
+	UAVObjEvent ev;
+
+	uint32_t ack_requested = PIOS_Thread_Systime();
+	bool ack_pending = false;
+
+	CameraDesiredConnectQueue(storm32bgc_queue);
 
 	// Loop forever
 	while (1)
 	{
-		PIOS_Thread_Sleep_Until(&now, STORM32BGC_PERIOD_MS);
+		if (PIOS_Queue_Receive(storm32bgc_queue, &ev, STORM32BGC_PERIOD_MS)) {
+			// Let any updates right behind this one catch up, and
+			// send them all as one
+			PIOS_Thread_Sleep(STORM32BGC_MIN_PERIOD_MS);
+
+			while (PIOS_Queue_Receive(storm32bgc_queue, &ev, 0));
+		}
+
+		uint8_t ack;
+
+		if (receive_ack(&ack)) {
+			ack_pending = false;
+			set_alarm(ack);
+		} else if (ack_pending &&
+				PIOS_Thread_Period_Elapsed(ack_requested, STORM32BGC_ACK_PERIOD_MS)) {
+			ack_pending = false;
+			set_alarm(0);
+		}
+
+		bool want_ack = !ack_pending &&
+			PIOS_Thread_Period_Elapsed(ack_requested, STORM32BGC_ACK_PERIOD_MS);
 
 		CameraDesiredGet(&cameraDesired);
 
 		float pitch_setpoint = cameraDesired.Declination;
 		float yaw_setpoint   = cameraDesired.Bearing;
 
-		switch(cmd_set_angle(pitch_setpoint, 0.0f, yaw_setpoint, 0x00, 0x00)) {
+		cmd_set_angle(pitch_setpoint, 0.0f, yaw_setpoint, 0x00, 0x00, want_ack);
+
+		if (want_ack) {
+			ack_requested = PIOS_Thread_Systime();
+			ack_pending = true;
+		}
+	}
+}
+
+/**
+ * Sets the gimbal alarm from an ACK, see receive_ack()
+ */
+static void set_alarm(uint8_t ack)
+{
+	switch(ack) {
 
-			case 0:  // No response from Storm32Bgc
-				AlarmsSet(SYSTEMALARMS_ALARM_GIMBAL, SYSTEMALARMS_ALARM_WARNING);
-				break;
+		case 0:  // No response from Storm32Bgc
+			AlarmsSet(SYSTEMALARMS_ALARM_GIMBAL, SYSTEMALARMS_ALARM_WARNING);
+			break;
 
-			case 1:  // ACK response from Storm32Bgc
-				AlarmsSet(SYSTEMALARMS_ALARM_GIMBAL, SYSTEMALARMS_ALARM_OK);
-				break;
+		case 1:  // ACK response from Storm32Bgc
+			AlarmsSet(SYSTEMALARMS_ALARM_GIMBAL, SYSTEMALARMS_ALARM_OK);
+			break;
 
-			default: // ACK response from Storm32Bgc invalid
-				AlarmsSet(SYSTEMALARMS_ALARM_GIMBAL, SYSTEMALARMS_ALARM_CRITICAL);
-		}
+		default: // ACK response from Storm32Bgc invalid
+			AlarmsSet(SYSTEMALARMS_ALARM_GIMBAL, SYSTEMALARMS_ALARM_CRITICAL);
 	}
 }
 
@@ -224,24 +278,13 @@ static inline uint16_t crc_calculate(uint8_t* pBuffer, int length)
 
 /**
  * Send the Set Angle Command
- * \return   0 = No Response from Storm32bgc
- * \return   1 = SERIALRCCMD_ACK_OK
- * \return   2 = SERIALRCCMD_ACK_ERR_FAIL
- * \return   3 = SERIALRCCMD_ACK_ERR_ACCESS_DENIED
- * \return   4 = SERIALRCCMD_ACK_ERR_NOT_SUPPORTED
- * \return 151 = SERIALRCCMD_ACK_ERR_TIMEOUT
- * \return 152 = SERIALRCCMD_ACK_ERR_CRC
- * \return 153 = SERIALRCCMD_ACK_ERR_PAYLOADLEN
- * \return 200 = Storm32bgc ACK CRC incorrect
+ * \param[in] ack whether the Storm32bgc should ACK it, see receive_ack()
  */
-static uint8_t cmd_set_angle(float pitch, float roll, float yaw, uint8_t flags, uint8_t type)
+static void cmd_set_angle(float pitch, float roll, float yaw, uint8_t flags, uint8_t type, bool ack)
 {
 	uint8_t command_string[19];
-	uint8_t read_data[6] = {0,};
-	uint8_t bytes_read;
-	uint8_t ack;
 
-	command_string[0] = 0xFA;  // Start Sign
+	command_string[0] = ack ? STORM32BGC_START_ACK : STORM32BGC_START_NOACK;  // Start Sign
 	command_string[1] = 0x0E;  // Length of Payload
 	command_string[2] = 0x11;  // Command Byte - CMD_SETANGLE
 
@@ -273,26 +316,55 @@ static uint8_t cmd_set_angle(float pitch, float roll, float yaw, uint8_t flags,
 	command_string[18] = crc.bytes[1];
 
 	PIOS_COM_SendBuffer(storm32bgc_com_id, &command_string[0], 19);
+}
 
-	bytes_read = PIOS_COM_ReceiveBuffer(storm32bgc_com_id, read_data, 6, 500);
+/**
+ * Takes whatever has come back from the Storm32bgc, without waiting
+ * \param[out] ack the last ACK that came in, if any:
+ *      1 = SERIALRCCMD_ACK_OK
+ *      2 = SERIALRCCMD_ACK_ERR_FAIL
+ *      3 = SERIALRCCMD_ACK_ERR_ACCESS_DENIED
+ *      4 = SERIALRCCMD_ACK_ERR_NOT_SUPPORTED
+ *    151 = SERIALRCCMD_ACK_ERR_TIMEOUT
+ *    152 = SERIALRCCMD_ACK_ERR_CRC
+ *    153 = SERIALRCCMD_ACK_ERR_PAYLOADLEN
+ *    200 = Storm32bgc ACK CRC incorrect
+ * \return true if an ACK came in
+ */
+static bool receive_ack(uint8_t *ack)
+{
+	static uint8_t read_data[STORM32BGC_REPLY_LEN];
+	static uint8_t bytes_read;
 
-	if (bytes_read != 0)
-	{
-		crc.value = crc_calculate(&read_data[1], 3);  // Does not include Start Sign
+	uint8_t c;
+	bool received = false;
+
+	while (PIOS_COM_ReceiveBuffer(storm32bgc_com_id, &c, 1, 0) == 1) {
+		// Anything before a start sign is junk
+		if (bytes_read == 0 && c != STORM32BGC_START_REPLY) {
+			continue;
+		}
 
-		if ((crc.bytes[0] == read_data[4]) && (crc.bytes[1] == read_data[5]))
-		{
-			ack = read_data[3];
+		read_data[bytes_read++] = c;
 
-			ack++;
+		if (bytes_read < STORM32BGC_REPLY_LEN) {
+			continue;
 		}
-		else
-			ack = 200;
+
+		bytes_read = 0;
+
+		crc.value = crc_calculate(&read_data[1], 3);  // Does not include Start Sign
+
+		if ((crc.bytes[0] == read_data[4]) && (crc.bytes[1] == read_data[5])) {
+			*ack = read_data[3] + 1;
+		} else {
+			*ack = 200;
+		}
+
+		received = true;
 	}
-	else
-		ack = 0;
 
-	return ack;
+	return received;
 }
 
 /**
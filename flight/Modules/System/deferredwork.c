@@ -0,0 +1,253 @@
+/**
+ ******************************************************************************
+ * @addtogroup Modules Modules
+ * @{
+ * @addtogroup SystemModule System
+ * @{
+ *
+ * @file       deferredwork.c
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2017
+ * @brief      Shared worker threads for slow periodic module work
+ *
+ * Modules that only wake up a few times a second to sample something used
+ * to each have a thread of their own, and with it a stack mostly sitting
+ * idle.  Here a thread per priority tier runs all of their work instead,
+ * each item to completion, in the order it falls due.  When it is due is
+ * kept in a timer wheel per tier, so the thread sleeps until the first
+ * item is due or until new work is scheduled.
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "openpilot.h"
+
+#include "deferredwork.h"
+#include "taskinfo.h"
+#include "taskmonitor.h"
+#include "timerwheel.h"
+#include "pios_mutex.h"
+#include "pios_semaphore.h"
+#include "pios_struct_helper.h"
+#include "pios_thread.h"
+
+// Private constants
+#define STACK_SIZE_BYTES	800
+//! Longest a worker sleeps without anything due
+#define MAX_WAIT_MS		1000
+
+// Private types
+struct deferred_tier {
+	struct timer_wheel wheel;
+	struct pios_semaphore *wakeup;
+	struct pios_thread *thread;
+};
+
+struct deferred_work {
+	struct timer_wheel_entry timer;
+	deferred_work_fn fn;
+	void *ctx;
+	struct deferred_tier *tier;
+	//! Taken off the wheel to run; scheduling it now only sets rerun_at
+	bool running;
+	bool rerun;
+	uint32_t rerun_at;
+};
+
+// Private variables
+static struct pios_mutex *mutex;
+static struct deferred_tier *tiers[DEFERRED_WORK_NUM_TIERS];
+
+static const struct {
+	const char *name;
+	enum pios_thread_prio_e prio;
+	uint8_t task_idx;
+} tier_info[DEFERRED_WORK_NUM_TIERS] = {
+	[DEFERRED_WORK_LOW] = {
+		.name = "DeferredLow",
+		.prio = PIOS_THREAD_PRIO_LOW,
+		.task_idx = TASKINFO_RUNNING_DEFERREDLOW,
+	},
+	[DEFERRED_WORK_NORMAL] = {
+		.name = "DeferredNormal",
+		.prio = PIOS_THREAD_PRIO_NORMAL,
+		.task_idx = TASKINFO_RUNNING_DEFERREDNORMAL,
+	},
+};
+
+// Private functions
+static void deferredWorkTask(void *parameters);
+
+/**
+ * Set up the scheduler; the worker threads are only started once they
+ * have work.
+ * \returns 0 on success or -1 if initialization failed
+ */
+int32_t deferred_work_initialize(void)
+{
+	mutex = PIOS_Mutex_Create();
+	if (mutex == NULL)
+		return -1;
+
+	return 0;
+}
+
+/**
+ * @brief Creates a work item; it first runs when scheduled
+ * @param[in] tier The worker thread it runs on
+ * @param[in] fn What to run
+ * @param[in] ctx Passed to fn
+ * @returns The work, or NULL if it couldn't be created
+ */
+struct deferred_work *deferred_work_create(enum deferred_work_tier tier,
+		deferred_work_fn fn, void *ctx)
+{
+	PIOS_Assert(mutex);
+	PIOS_Assert(tier < DEFERRED_WORK_NUM_TIERS);
+
+	struct deferred_work *work = PIOS_malloc_no_dma(sizeof(*work));
+	if (work == NULL)
+		return NULL;
+
+	memset(work, 0, sizeof(*work));
+	work->fn = fn;
+	work->ctx = ctx;
+
+	PIOS_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
+
+	if (tiers[tier] == NULL) {
+		struct deferred_tier *t = PIOS_malloc_no_dma(sizeof(*t));
+
+		if (t == NULL) {
+			PIOS_Mutex_Unlock(mutex);
+			return NULL;
+		}
+
+		timer_wheel_init(&t->wheel, PIOS_Thread_Systime());
+
+		t->wakeup = PIOS_Semaphore_Create();
+		PIOS_Assert(t->wakeup);
+
+		tiers[tier] = t;
+
+		t->thread = PIOS_Thread_Create(deferredWorkTask,
+				tier_info[tier].name, STACK_SIZE_BYTES, t,
+				tier_info[tier].prio);
+		PIOS_Assert(t->thread);
+
+		TaskMonitorAdd(tier_info[tier].task_idx, t->thread);
+	}
+
+	work->tier = tiers[tier];
+
+	PIOS_Mutex_Unlock(mutex);
+
+	return work;
+}
+
+/**
+ * @brief Runs work after a delay, instead of whenever it was due before
+ * @param[in] work The work
+ * @param[in] delay_ms How long from now; 0 to run it as soon as the
+ * worker gets to it
+ */
+void deferred_work_schedule(struct deferred_work *work, uint32_t delay_ms)
+{
+	struct deferred_tier *tier = work->tier;
+	uint32_t at = PIOS_Thread_Systime() + delay_ms;
+
+	PIOS_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
+
+	if (work->running) {
+		work->rerun = true;
+		work->rerun_at = at;
+	} else {
+		timer_wheel_remove(&tier->wheel, &work->timer);
+		timer_wheel_add(&tier->wheel, &work->timer, at);
+	}
+
+	PIOS_Mutex_Unlock(mutex);
+
+	PIOS_Semaphore_Give(tier->wakeup);
+}
+
+/**
+ * Worker thread for a tier.  It does not return.
+ */
+static void deferredWorkTask(void *parameters)
+{
+	struct deferred_tier *tier = parameters;
+
+	while (true) {
+		PIOS_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
+
+		struct timer_wheel_entry *expired =
+			timer_wheel_expire(&tier->wheel, PIOS_Thread_Systime());
+
+		for (struct timer_wheel_entry *e = expired; e; e = e->next) {
+			container_of(e, struct deferred_work, timer)->running = true;
+		}
+
+		PIOS_Mutex_Unlock(mutex);
+
+		while (expired) {
+			struct deferred_work *work =
+				container_of(expired, struct deferred_work, timer);
+
+			// Adding the work back below reuses its link
+			expired = expired->next;
+
+			int32_t again = work->fn(work->ctx);
+
+			PIOS_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
+
+			work->running = false;
+
+			// Counting from when it was due keeps periodic work in
+			// phase; if it fell behind it runs on the next tick
+			if (work->rerun) {
+				work->rerun = false;
+				timer_wheel_add(&tier->wheel, &work->timer,
+						work->rerun_at);
+			} else if (again >= 0) {
+				timer_wheel_add(&tier->wheel, &work->timer,
+						work->timer.expires + again);
+			}
+
+			PIOS_Mutex_Unlock(mutex);
+		}
+
+		PIOS_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
+
+		// Measured from the last tick expired, not from now
+		uint32_t due = tier->wheel.now - 1 +
+			timer_wheel_next(&tier->wheel, MAX_WAIT_MS);
+
+		PIOS_Mutex_Unlock(mutex);
+
+		int32_t wait = due - PIOS_Thread_Systime();
+
+		if (wait > 0) {
+			PIOS_Semaphore_Take(tier->wakeup, wait);
+		}
+	}
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,63 @@
+/**
+ ******************************************************************************
+ * @addtogroup Modules Modules
+ * @{
+ * @addtogroup SystemModule System
+ * @{
+ *
+ * @file       deferredwork.h
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2017
+ * @brief      Shared worker threads for slow periodic module work
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef DEFERREDWORK_H
+#define DEFERREDWORK_H
+
+#include <stdint.h>
+
+//! Which worker thread runs an item; one thread per tier
+enum deferred_work_tier {
+	DEFERRED_WORK_LOW,
+	DEFERRED_WORK_NORMAL,
+	DEFERRED_WORK_NUM_TIERS
+};
+
+/**
+ * Work run to completion on a worker thread.  It must not block for long,
+ * as everything else on the tier waits for it.
+ * @param[in] ctx The context the work was created with
+ * @returns How many ms after it was due to run it again, or a negative
+ * number to wait for the next deferred_work_schedule
+ */
+typedef int32_t (*deferred_work_fn)(void *ctx);
+
+struct deferred_work;
+
+int32_t deferred_work_initialize(void);
+struct deferred_work *deferred_work_create(enum deferred_work_tier tier,
+		deferred_work_fn fn, void *ctx);
+void deferred_work_schedule(struct deferred_work *work, uint32_t delay_ms);
+
+#endif /* DEFERREDWORK_H */
+
+/**
+ * @}
+ * @}
+ */
@@ -258,6 +258,47 @@ static void interp_in_hsv(bool backwards, const uint8_t *rgb_start,
 	rgb_out[2] = float_to_q8(rgbf[2]);
 }
 
+/*
+ * HSV blends are precomputed at this many evenly spaced points between
+ * the two colors, and linearly interpolated in between, so that the float
+ * conversions only happen when the colors or blend type change.
+ */
+#define GRADIENT_STEPS_LOG2 6
+#define GRADIENT_STEPS (1 << GRADIENT_STEPS_LOG2)
+
+static struct {
+	uint8_t blend_type;
+	uint8_t base[3];
+	uint8_t end[3];
+	uint8_t colors[GRADIENT_STEPS + 1][3];
+} gradient;
+
+static void interp_in_hsv_table(bool backwards, const uint8_t *rgb_start,
+		const uint8_t *rgb_end, uint8_t *rgb_out, uint16_t fraction,
+		uint8_t blend_type) {
+	if ((gradient.blend_type != blend_type) ||
+			memcmp(gradient.base, rgb_start, sizeof(gradient.base)) ||
+			memcmp(gradient.end, rgb_end, sizeof(gradient.end))) {
+		for (int i = 0; i <= GRADIENT_STEPS; i++) {
+			interp_in_hsv(backwards, rgb_start, rgb_end,
+					gradient.colors[i],
+					MIN(i * (65536 / GRADIENT_STEPS), 65535));
+		}
+
+		gradient.blend_type = blend_type;
+		memcpy(gradient.base, rgb_start, sizeof(gradient.base));
+		memcpy(gradient.end, rgb_end, sizeof(gradient.end));
+	}
+
+	int idx = fraction >> (16 - GRADIENT_STEPS_LOG2);
+	uint16_t step_fraction = fraction << GRADIENT_STEPS_LOG2;
+
+	for (int i = 0; i < 3; i++) {
+		rgb_out[i] = linear_interp_u16(gradient.colors[idx][i],
+				gradient.colors[idx + 1][i], step_fraction);
+	}
+}
+
 static inline uint16_t float_to_u16(float in)
 {
 	if (in >= 1) {
@@ -430,17 +471,20 @@ void systemmod_process_rgb_leds(bool led_override, bool led_override_active,
 					rgbSettings.RangeBaseColor[2],
 					rgbSettings.RangeEndColor[2],
 					fraction);
+			break;
 		case RGBLEDSETTINGS_RANGECOLORBLENDTYPE_LINEARINHSV:
-			interp_in_hsv(false, rgbSettings.RangeBaseColor,
+			interp_in_hsv_table(false, rgbSettings.RangeBaseColor,
 					rgbSettings.RangeEndColor,
 					range_color,
-					fraction);
+					fraction,
+					rgbSettings.RangeColorBlendType);
 			break;
 		case RGBLEDSETTINGS_RANGECOLORBLENDTYPE_LINEARINHSVBACKWARDSHUE:
-			interp_in_hsv(true, rgbSettings.RangeBaseColor,
+			interp_in_hsv_table(true, rgbSettings.RangeBaseColor,
 					rgbSettings.RangeEndColor,
 					range_color,
-					fraction);
+					fraction,
+					rgbSettings.RangeColorBlendType);
 			break;
 	}
 
@@ -34,19 +34,27 @@
 #include <utlist.h>
 
 #include "systemmod.h"
+#include "deferredwork.h"
 #include "sanitycheck.h"
 #include "taskinfo.h"
 #include "taskmonitor.h"
+#include "looptiming.h"
+#include "timerwheel.h"
 #include "pios_thread.h"
 #include "pios_mutex.h"
 #include "pios_queue.h"
+#include "pios_struct_helper.h"
 #include "misc_math.h"
 #include "morsel.h"
 
 #include "annunciatorsettings.h"
+#include "callbackinfo.h"
 #include "flightstatus.h"
+#include "irqinfo.h"
+#include "bootprofile.h"
 #include "manualcontrolcommand.h"
 #include "manualcontrolsettings.h"
+#include "mutexstats.h"
 #include "objectpersistence.h"
 #include "stabilizationsettings.h"
 #include "stateestimation.h"
@@ -119,7 +127,7 @@ typedef struct {
 struct PeriodicObjectListStruct {
 	EventCallbackInfo evInfo; /** Event callback information */
 	uint16_t updatePeriodMs; /** Update period in ms or 0 if no periodic updates are needed */
-	int32_t timeToNextUpdateMs; /** Time delay to the next update */
+	struct timer_wheel_entry timer; /** When the next update is, while updatePeriodMs > 0 */
 	struct PeriodicObjectListStruct* next; /** Needed by linked list library (utlist.h) */
 };
 typedef struct PeriodicObjectListStruct PeriodicObjectList;
@@ -128,11 +136,14 @@ typedef struct PeriodicObjectListStruct PeriodicObjectList;
 
 // Private variables
 static PeriodicObjectList* objList;
+static struct timer_wheel periodicTimers;
 static struct pios_recursive_mutex *mutex;
 static EventStats stats;
 
+#if !defined(PIOS_INCLUDE_CHIBIOS)
 static volatile uint32_t idleCounter;
 static volatile uint32_t idleCounterClear;
+#endif
 static struct pios_thread *systemTaskHandle;
 static struct pios_queue *objectPersistenceQueue;
 
@@ -145,6 +156,7 @@ static void systemPeriodicCb(const UAVObjEvent *ev,
 static void objectUpdatedCb(const UAVObjEvent *ev,
 		void *ctx, void *obj, int len);
 static uint32_t processPeriodicUpdates();
+static void schedulePeriodic(PeriodicObjectList *objEntry);
 static int32_t eventPeriodicCreate(UAVObjEvent *ev,
 		UAVObjEventCallback cb, struct pios_queue *queue,
 		uint16_t periodMs);
@@ -164,6 +176,9 @@ static inline void updateSystemAlarms();
 #if defined(WDG_STATS_DIAGNOSTICS)
 static inline void updateWDGstats();
 #endif
+#if defined(UAVO_CALLBACK_DIAGNOSTICS)
+static void updateCallbackInfo();
+#endif
 
 /**
  * Create the module task.
@@ -192,8 +207,14 @@ int32_t SystemModInitialize(void)
 	if (mutex == NULL)
 		return -1;
 
+	timer_wheel_init(&periodicTimers, PIOS_Thread_Systime());
+
+	if (deferred_work_initialize() == -1)
+		return -1;
+
 	if (SystemSettingsInitialize() == -1
 			|| SystemStatsInitialize() == -1
+			|| BootProfileInitialize() == -1
 			|| FlightStatusInitialize() == -1
 			|| ObjectPersistenceInitialize() == -1
 			|| AnnunciatorSettingsInitialize() == -1
@@ -207,10 +228,22 @@ int32_t SystemModInitialize(void)
 	if (TaskInfoInitialize() == -1)
 		return -1;
 #endif
+#if defined(DIAG_IRQS)
+	if (IRQInfoInitialize() == -1)
+		return -1;
+#endif
+#if defined(DIAG_MUTEXES)
+	if (MutexStatsInitialize() == -1)
+		return -1;
+#endif
 #if defined(WDG_STATS_DIAGNOSTICS)
 	if (WatchdogStatusInitialize() == -1)
 		return -1;
 #endif
+#if defined(UAVO_CALLBACK_DIAGNOSTICS)
+	if (CallbackInfoInitialize() == -1)
+		return -1;
+#endif
 
 	objectPersistenceQueue = PIOS_Queue_Create(1, sizeof(UAVObjEvent));
 	if (objectPersistenceQueue == NULL)
@@ -220,6 +253,36 @@ int32_t SystemModInitialize(void)
 }
 
 MODULE_HIPRI_INITCALL(SystemModInitialize, SystemModStart)
+
+/**
+ * Reports how long each stage of the boot took.  Called once every
+ * module has been started.
+ */
+static void publishBootProfile(void)
+{
+	const struct pios_modules_boot_profile *profile =
+		PIOS_Modules_GetBootProfile();
+	BootProfileData boot;
+
+	memset(&boot, 0, sizeof(boot));
+
+	boot.BoardInit = profile->board_init_us;
+	boot.ModuleInit = profile->module_init_us;
+	boot.TaskCreate = profile->task_create_us;
+	boot.SlowestInit = profile->slowest_init_us;
+	boot.SlowestStart = profile->slowest_start_us;
+
+	if (profile->slowest_init)
+		strncpy((char *) boot.SlowestInitName, profile->slowest_init,
+				sizeof(boot.SlowestInitName));
+
+	if (profile->slowest_start)
+		strncpy((char *) boot.SlowestStartName, profile->slowest_start,
+				sizeof(boot.SlowestStartName));
+
+	BootProfileSet(&boot);
+}
+
 void system_task()
 {
 	if (PIOS_heap_malloc_failed_p()) {
@@ -235,6 +298,8 @@ void system_task()
 	PIOS_IAP_WriteBootCount(0);
 #endif
 
+	publishBootProfile();
+
 	systemTaskHandle = PIOS_Thread_WrapCurrentThread("system");
 	PIOS_Thread_ChangePriority(TASK_PRIORITY);
 
@@ -276,6 +341,13 @@ void system_task()
 			// If object persistence is updated call the callback
 			objectUpdatedCb(&ev, NULL, NULL, 0);
 		}
+
+#if defined(PIOS_INCLUDE_LOGFS_SETTINGS)
+		// Collect garbage in the settings log a slice at a time, so
+		// that saves don't stall on it when the log fills up.
+		extern uintptr_t pios_uavo_settings_fs_id;
+		PIOS_FLASHFS_Maintain(pios_uavo_settings_fs_id);
+#endif
 	}
 }
 
@@ -445,6 +517,9 @@ static void systemPeriodicCb(const UAVObjEvent *ev,
 		// Update the system statistics
 		updateStats();
 
+		// Publish the control loop latencies
+		looptiming_publish();
+
 #ifndef PIPXTREME
 		// Update the system alarms
 		updateSystemAlarms();
@@ -458,8 +533,15 @@ static void systemPeriodicCb(const UAVObjEvent *ev,
 		// Update the task status object
 		TaskMonitorUpdateAll();
 #endif
+
+#if defined(UAVO_CALLBACK_DIAGNOSTICS)
+		updateCallbackInfo();
+#endif
 	}
 
+	// Make sure the last alarm change reaches SystemAlarms
+	AlarmsSync();
+
 #if defined(PIOS_INCLUDE_ANNUNC)
 	// Figure out what we should be doing.
 
@@ -521,8 +603,12 @@ static void systemPeriodicCb(const UAVObjEvent *ev,
 				 * through startup... but it also just
 				 * seems prudent to check this stuff
 				 * every half second or so while disarmed.
-				 * (for lost events, etc.)
+				 * (for lost events, etc.)  The checks that
+				 * only read objects are still cached.
 				 */
+#ifndef NO_SENSORS
+				configuration_check_refresh();
+#endif
 				config_check_needed = true;
 			}
 		}
@@ -729,12 +815,73 @@ static void updateWDGstats()
 }
 #endif
 
+#if defined(UAVO_CALLBACK_DIAGNOSTICS)
+#if defined(FLIGHT_POSIX)
+/* Start of the executable, from the linker; makes 64 bit addresses fit */
+extern const char __executable_start[];
+#define CALLBACK_IMAGE_BASE ((uintptr_t) __executable_start)
+#else
+#define CALLBACK_IMAGE_BASE 0
+#endif
+
+/**
+ * Keep the slowest callbacks (by worst case time) in the CallbackInfo
+ * object, ordered slowest first.
+ */
+static void collectCallbackProfile(const struct UAVObjCallbackProfile *prof,
+		void *ctx)
+{
+	CallbackInfoData *info = ctx;
+
+	if (!prof->calls) {
+		return;
+	}
+
+	int slot;
+
+	for (slot = 0; slot < CALLBACKINFO_MAXTIME_NUMELEM; slot++) {
+		if (!info->Calls[slot] || prof->max_us > info->MaxTime[slot]) {
+			break;
+		}
+	}
+
+	if (slot >= CALLBACKINFO_MAXTIME_NUMELEM) {
+		return;
+	}
+
+	for (int i = CALLBACKINFO_MAXTIME_NUMELEM - 1; i > slot; i--) {
+		info->ObjectID[i] = info->ObjectID[i - 1];
+		info->Callback[i] = info->Callback[i - 1];
+		info->Calls[i] = info->Calls[i - 1];
+		info->MaxTime[i] = info->MaxTime[i - 1];
+		info->MeanTime[i] = info->MeanTime[i - 1];
+	}
+
+	info->ObjectID[slot] = prof->obj_id;
+	info->Callback[slot] = (uintptr_t) prof->cb - CALLBACK_IMAGE_BASE;
+	info->Calls[slot] = prof->calls;
+	info->MaxTime[slot] = prof->max_us;
+	info->MeanTime[slot] = prof->mean_us;
+}
+
+/**
+ * Called periodically to update the callback execution time statistics
+ */
+static void updateCallbackInfo()
+{
+	CallbackInfoData info = { };
+
+	UAVObjIterateCallbackProfiles(collectCallbackProfile, &info);
+
+	CallbackInfoSet(&info);
+}
+#endif
+
 /**
  * Called periodically to update the system stats
  */
 static void updateStats()
 {
-	static uint32_t lastTickCount = 0;
 	SystemStatsData stats;
 
 	// Get stats and update
@@ -747,11 +894,30 @@ static void updateStats()
 	stats.IRQStackRemaining = (uint16_t)PIOS_SYS_IrqStackUnused();
 	stats.OSStackRemaining = (uint16_t)PIOS_SYS_OsStackUnused();
 
+#if defined(PIOS_INCLUDE_CHIBIOS)
+	// The idle thread sleeps until the next interrupt, so it can't be
+	// counted spinning; instead see how long it was switched in for.
+	static uint32_t lastRaw = 0;
+	uint32_t raw = PIOS_DELAY_GetRaw();
+	uint32_t idleCycles = PIOS_Thread_Get_Idle_Runtime();
+
+	if (lastRaw && raw != lastRaw) {
+		float idleFraction = (float)idleCycles / (float)(raw - lastRaw);
+		if (idleFraction > 1)
+			idleFraction = 1;
+
+		stats.IdleTime = roundf(100.0f * idleFraction);
+		stats.CPULoad = 100 - stats.IdleTime;
+	}
+
+	lastRaw = raw;
+#else
 	// When idleCounterClear was not reset by the idle-task, it means the idle-task did not run
 	if (idleCounterClear) {
 		idleCounter = 0;
 	}
 
+	static uint32_t lastTickCount = 0;
 	uint32_t now = PIOS_Thread_Systime();
 	if (now > lastTickCount) {
 		float dT = (now - lastTickCount) / 1000.0f;
@@ -767,6 +933,7 @@ static void updateStats()
 
 	lastTickCount = now;
 	idleCounterClear = 1;
+#endif
 
 	SystemStatsSet(&stats);
 }
@@ -843,6 +1010,7 @@ static void updateSystemAlarms()
  */
 void vApplicationIdleHook(void)
 {
+#if !defined(PIOS_INCLUDE_CHIBIOS)
 	// Called when the scheduler has no tasks to run
 	if (idleCounterClear == 0) {
 		++idleCounter;
@@ -850,6 +1018,7 @@ void vApplicationIdleHook(void)
 		idleCounter = 0;
 		idleCounterClear = 0;
 	}
+#endif
 }
 
 /**
@@ -922,6 +1091,21 @@ int32_t EventPeriodicQueueUpdate(UAVObjEvent* ev, struct pios_queue *queue, uint
 	return eventPeriodicUpdate(ev, 0, queue, periodMs);
 }
 
+/**
+ * Schedule the first update of a periodic event, if it has a period.
+ * Must be called with the lock held.
+ * \param[in] objEntry The periodic event
+ */
+static void schedulePeriodic(PeriodicObjectList *objEntry)
+{
+	if (objEntry->updatePeriodMs == 0)
+		return;
+
+	// avoid bunching of updates
+	timer_wheel_add(&periodicTimers, &objEntry->timer,
+			PIOS_Thread_Systime() + randomize_int(objEntry->updatePeriodMs));
+}
+
 /**
  * Dispatch an event through a callback at periodic intervals.
  * \param[in] ev The event to be dispatched
@@ -959,7 +1143,8 @@ static int32_t eventPeriodicCreate(UAVObjEvent* ev, UAVObjEventCallback cb, stru
 	objEntry->evInfo.cb = cb;
 	objEntry->evInfo.queue = queue;
 	objEntry->updatePeriodMs = periodMs;
-	objEntry->timeToNextUpdateMs = randomize_int(periodMs); // avoid bunching of updates
+	objEntry->timer.pprev = NULL;
+	schedulePeriodic(objEntry);
 	// Add to list
 	LL_APPEND(objList, objEntry);
 	// Release lock
@@ -989,9 +1174,18 @@ static int32_t eventPeriodicUpdate(UAVObjEvent* ev, UAVObjEventCallback cb, stru
 				objEntry->evInfo.ev.instId == ev->instId &&
 				objEntry->evInfo.ev.event == ev->event)
 		{
-			// Object found, update period
+			// Object found, update period.  One with a period
+			// that isn't in the wheel is being dispatched, and
+			// is put back by processPeriodicUpdates.
+			bool dispatching = objEntry->updatePeriodMs > 0 &&
+				!timer_wheel_pending(&objEntry->timer);
+
 			objEntry->updatePeriodMs = periodMs;
-			objEntry->timeToNextUpdateMs = randomize_int(periodMs); // avoid bunching of updates
+
+			if (!dispatching) {
+				timer_wheel_remove(&periodicTimers, &objEntry->timer);
+				schedulePeriodic(objEntry);
+			}
 			// Release lock
 			PIOS_Recursive_Mutex_Unlock(mutex);
 			return 0;
@@ -1008,61 +1202,58 @@ static int32_t eventPeriodicUpdate(UAVObjEvent* ev, UAVObjEventCallback cb, stru
 #define MAX_UPDATE_PERIOD_MS 350
 
 /**
- * Handle periodic updates for all objects.
- * \return The system time until the next update (in ms) or -1 if failed
+ * Handle periodic updates for all objects.  Only the events that are due
+ * are visited, so this costs the same however many objects are periodic.
+ * \return The system time until the next update (in ms)
  */
 static uint32_t processPeriodicUpdates()
 {
-	PeriodicObjectList* objEntry;
-	int32_t timeNow;
-	int32_t offset;
-
 	// Get lock
 	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
 
-	// Iterate through each object and update its timer, if zero then transmit object.
-	// Also calculate smallest delay to next update.
 	uint32_t now = PIOS_Thread_Systime();
-	uint32_t timeToNextUpdate = PIOS_Thread_Systime() + MAX_UPDATE_PERIOD_MS;
-	LL_FOREACH(objList, objEntry)
-	{
-		// If object is configured for periodic updates
-		if (objEntry->updatePeriodMs > 0)
+	struct timer_wheel_entry *timer = timer_wheel_expire(&periodicTimers, now);
+
+	while (timer) {
+		struct timer_wheel_entry *next = timer->next;
+		PeriodicObjectList *objEntry =
+			container_of(timer, PeriodicObjectList, timer);
+
+		// Next update, a period on from this one; if we ran late,
+		// keep to the same phase rather than bunching up
+		if (objEntry->updatePeriodMs > 0) {
+			uint32_t due = timer->expires + objEntry->updatePeriodMs;
+			if ((int32_t) (due - now) <= 0)
+				due = now + objEntry->updatePeriodMs -
+					(now - timer->expires) % objEntry->updatePeriodMs;
+
+			timer_wheel_add(&periodicTimers, timer, due);
+		}
+
+		// Invoke callback, if one
+		if ( objEntry->evInfo.cb != 0)
 		{
-			// Check if time for the next update
-			timeNow = PIOS_Thread_Systime();
-			if (objEntry->timeToNextUpdateMs <= timeNow)
-			{
-				// Reset timer
-				offset = ( timeNow - objEntry->timeToNextUpdateMs ) % objEntry->updatePeriodMs;
-				objEntry->timeToNextUpdateMs = timeNow + objEntry->updatePeriodMs - offset;
-				// Invoke callback, if one
-				if ( objEntry->evInfo.cb != 0)
-				{
-					objEntry->evInfo.cb(&objEntry->evInfo.ev, NULL, NULL, 0); // the function is expected to copy the event information
-				}
-				// Push event to queue, if one
-				if ( objEntry->evInfo.queue != 0)
-				{
-					if (PIOS_Queue_Send(objEntry->evInfo.queue, &objEntry->evInfo.ev, 0) != true ) // do not block if queue is full
-					{
-						if (objEntry->evInfo.ev.obj != NULL)
-							stats.lastErrorID = UAVObjGetID(objEntry->evInfo.ev.obj);
-						++stats.eventErrors;
-					}
-				}
-			}
-			// Update minimum delay
-			if (objEntry->timeToNextUpdateMs < timeToNextUpdate)
+			objEntry->evInfo.cb(&objEntry->evInfo.ev, NULL, NULL, 0); // the function is expected to copy the event information
+		}
+		// Push event to queue, if one
+		if ( objEntry->evInfo.queue != 0)
+		{
+			if (PIOS_Queue_Send(objEntry->evInfo.queue, &objEntry->evInfo.ev, 0) != true ) // do not block if queue is full
 			{
-				timeToNextUpdate = objEntry->timeToNextUpdateMs;
+				if (objEntry->evInfo.ev.obj != NULL)
+					stats.lastErrorID = UAVObjGetID(objEntry->evInfo.ev.obj);
+				++stats.eventErrors;
 			}
 		}
+
+		timer = next;
 	}
 
+	uint32_t delay = timer_wheel_next(&periodicTimers, MAX_UPDATE_PERIOD_MS);
+
 	// Done
 	PIOS_Recursive_Mutex_Unlock(mutex);
-	return timeToNextUpdate - now;
+	return delay;
 }
 
 DONT_BUILD_IF(ANNUNCIATORSETTINGS_MANUALBUZZER_MAXOPTVAL >
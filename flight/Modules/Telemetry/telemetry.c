@@ -36,10 +36,12 @@
 #include <eventdispatcher.h>
 #include "flighttelemetrystats.h"
 #include "gcstelemetrystats.h"
+#include "linkping.h"
 #include "modulesettings.h"
 #include "pios_thread.h"
 #include "pios_mutex.h"
 #include "pios_queue.h"
+#include "misc_math.h"
 
 #include "pios_hal.h"
 
@@ -69,9 +71,24 @@
 #define USB_ACTIVITY_TIMEOUT_MS 6000
 
 #define MAX_ACKS_PENDING 3
+#define MAX_BATCHED_EVENTS 8
 #define MAX_REQS_PENDING 5
 #define ACK_TIMEOUT_MS 250
 
+/* Link scheduler.  The token bucket holds LINK_BURST_MS worth of the
+ * estimated link rate.  The link is considered saturated when sends
+ * blocked for more than 1/LINK_SATURATED_DIV of a stats period; the
+ * estimate then drops to the measured throughput, otherwise it grows by
+ * 1/LINK_PROBE_DIV per period until the link is clearly not the limit.
+ */
+#define LINK_BURST_MS 250
+#define LINK_MIN_RATE 100
+#define LINK_MIN_BURST 64
+#define LINK_SATURATED_DIV 4
+#define LINK_PROBE_DIV 4
+#define LINK_FRAME_OVERHEAD 11
+#define LOWPRI_MAX_STRETCH 8
+
 // Private types
 
 // Private variables
@@ -104,6 +121,22 @@ struct telemetry_state {
 
 	struct pios_semaphore *access_sem;
 	volatile bool request_inhibit, tx_inhibited, rx_inhibited;
+	volatile bool use_batched_frames;
+
+	/* Link scheduler state; a link_rate of 0 means unlimited */
+	uint32_t link_rate;
+	int32_t link_tokens;
+	uint32_t link_refill_time;
+	uint32_t link_stats_time;
+	volatile uint32_t tx_blocked_ms;
+	uint32_t tx_deferred;
+	uint8_t lowpri_stretch;
+
+	/* When the last LinkPing was unpacked */
+	volatile uint32_t ping_received_ms;
+
+	/* Port holding a frame being built in place */
+	uintptr_t reserved_port;
 
 	UAVTalkConnection uavTalkCon;
 };
@@ -117,6 +150,8 @@ static void telemetryTxTask(void *parameters);
 static void telemetryRxTask(void *parameters);
 
 static int32_t transmitData(void *ctx, uint8_t *data, int32_t length);
+static uint8_t *reserveTransmit(void *ctx, uint16_t length);
+static int32_t commitTransmit(void *ctx, uint16_t length);
 static void addAckPending(telem_t telem, UAVObjHandle obj, uint16_t inst_id);
 static void ackCallback(void *ctx, uint32_t obj_id, uint16_t inst_id);
 static void reqCallback(void *ctx, uint32_t obj_id, uint16_t inst_id);
@@ -127,6 +162,9 @@ static int32_t setUpdatePeriod(telem_t telem, UAVObjHandle obj, int32_t updatePe
 static void processObjEvent(telem_t telem, UAVObjEvent * ev);
 static void updateTelemetryStats(telem_t telem);
 static void gcsTelemetryStatsUpdated();
+static void linkPingUnpacked(const UAVObjEvent *ev, void *ctx, void *obj,
+		int len);
+static void linkPingReceived(telem_t telem, UAVObjEvent *ev);
 static void updateSettings();
 static uintptr_t getComPort();
 static void update_object_instances(uint32_t obj_id, uint32_t inst_id);
@@ -139,6 +177,45 @@ static void registerObjectShim(UAVObjHandle obj) {
 	registerObject(&telem_state, obj);
 }
 
+static void sendSettingsShim(UAVObjHandle obj) {
+	telem_t telem = &telem_state;
+
+	if (UAVObjIsMetaobject(obj) || !UAVObjIsSettings(obj)) {
+		return;
+	}
+
+	uint16_t num_insts = UAVObjGetNumInstances(obj);
+
+	for (uint16_t i = 0; i < num_insts; i++) {
+		int32_t success;
+
+		if (telem->use_batched_frames) {
+			success = UAVTalkSendObjectBatched(telem->uavTalkCon,
+					obj, i);
+		} else {
+			success = UAVTalkSendObject(telem->uavTalkCon, obj, i,
+					false);
+		}
+
+		if (success == -1) {
+			telem->tx_errors++;
+		}
+	}
+}
+
+static void restretchObjectShim(UAVObjHandle obj) {
+	if (UAVObjIsMetaobject(obj)) {
+		return;
+	}
+
+	UAVObjMetadata metadata;
+	UAVObjGetMetadata(obj, &metadata);
+
+	if (UAVObjGetTelemetryPriority(&metadata) == TELEMETRYPRIORITY_LOW) {
+		updateObject(&telem_state, obj, EV_NONE);
+	}
+}
+
 /**
  * Initialise the telemetry module
  * \return -1 if initialisation failed
@@ -158,6 +235,10 @@ int32_t TelemetryStart(void)
 	// Listen to objects of interest
 	GCSTelemetryStatsConnectQueue(telem_state.queue);
 
+	// Pings are answered whatever LinkPing's metadata says
+	LinkPingConnectCallback(linkPingUnpacked);
+	LinkPingConnectQueue(telem_state.queue);
+
 	struct pios_thread *telemetryTxTaskHandle;
 	struct pios_thread *telemetryRxTaskHandle;
 
@@ -181,7 +262,8 @@ int32_t TelemetryStart(void)
 int32_t TelemetryInitialize(void)
 {
 	if (FlightTelemetryStatsInitialize() == -1 ||
-			GCSTelemetryStatsInitialize() == -1) {
+			GCSTelemetryStatsInitialize() == -1 ||
+			LinkPingInitialize() == -1) {
 		return -1;
 	}
 
@@ -193,6 +275,7 @@ int32_t TelemetryInitialize(void)
 
 	// Initialize vars
 	telem_state.time_of_last_update = 0;
+	telem_state.lowpri_stretch = 1;
 
 	// Create object queues
 	telem_state.queue = PIOS_Queue_Create(MAX_QUEUE_SIZE, sizeof(UAVObjEvent));
@@ -200,6 +283,8 @@ int32_t TelemetryInitialize(void)
 	// Initialise UAVTalk
 	telem_state.uavTalkCon = UAVTalkInitialize(&telem_state, transmitData,
 			ackCallback, reqCallback, fileReqCallback);
+	UAVTalkSetInPlaceOutput(telem_state.uavTalkCon, reserveTransmit,
+			commitTransmit);
 
 	//register the new uavo instance callback function in the uavobjectmanager
 	UAVObjRegisterNewInstanceCB(update_object_instances);
@@ -265,6 +350,14 @@ static void updateObject(telem_t telem, UAVObjHandle obj, int32_t eventType)
 	UAVObjGetMetadata(obj, &metadata);
 	updateMode = UAVObjGetTelemetryUpdateMode(&metadata);
 
+	// Low priority objects are slowed down while the link is saturated
+	if (UAVObjGetTelemetryPriority(&metadata) == TELEMETRYPRIORITY_LOW) {
+		uint32_t period = metadata.telemetryUpdatePeriod *
+			telem->lowpri_stretch;
+
+		metadata.telemetryUpdatePeriod = MIN(period, UINT16_MAX);
+	}
+
 	// Setup object depending on update mode
 	switch (updateMode) {
 	case UPDATEMODE_PERIODIC:
@@ -427,7 +520,7 @@ static void addAckPending(telem_t telem, UAVObjHandle obj, uint16_t inst_id)
 /**
  * Callback for when we receive a request for data.  Converts a file
  * id to the actual unit of information, and returns/copies it.
- * Currently only operates on partitions.
+ * Serves flash partitions, and the profiler sample ring when built in.
  *
  * \param[in] ctx Callback context (telemetry subsystem handle)
  * \param[in] file_id The requested file_id
@@ -475,6 +568,16 @@ static int32_t fileReqCallback(void *ctx, uint8_t *buf,
 		return len;
 	}
 
+	if (file_id == UAVTALK_FILEID_SETTINGS_DIGEST) {
+		return UAVObjReadSettingsDigest(buf, offset, len);
+	}
+
+#if defined(DIAG_PROFILE)
+	if (file_id == PIOS_PROFILER_FILE_ID) {
+		return PIOS_Profiler_Read(buf, offset, len);
+	}
+#endif
+
 	return -1;
 }
 
@@ -550,6 +653,123 @@ static void ackCallback(void *ctx, uint32_t obj_id, uint16_t inst_id)
 	DEBUG_PRINTF(3, "telem: Got UNEXPECTED ack for %d/%d\n", obj_id, inst_id);
 }
 
+/**
+ * Decides whether an update should be sent now, given the link capacity,
+ * and charges the token bucket for it if so.  High priority objects are
+ * always sent.  Low priority objects are deferred as soon as the bucket
+ * can't cover them; normal priority periodic updates only once it is
+ * overdrawn.
+ *
+ * \param[in] telem Telemetry subsystem handle
+ * \param[in] ev The event being processed
+ * \param[in] metadata Metadata of the event's object
+ * \return true if the update should be skipped this time
+ */
+static bool linkSchedulerDefer(telem_t telem, UAVObjEvent *ev,
+		const UAVObjMetadata *metadata)
+{
+	if (!telem->link_rate) {
+		return false;
+	}
+
+	uint32_t now = PIOS_Thread_Systime();
+	int32_t burst = MAX(telem->link_rate * LINK_BURST_MS / 1000,
+			LINK_MIN_BURST);
+
+	telem->link_tokens += (now - telem->link_refill_time) *
+		telem->link_rate / 1000;
+	telem->link_refill_time = now;
+
+	if (telem->link_tokens > burst) {
+		telem->link_tokens = burst;
+	}
+
+	int32_t cost = UAVObjGetNumBytes(ev->obj) + LINK_FRAME_OVERHEAD;
+
+	if (ev->instId == UAVOBJ_ALL_INSTANCES) {
+		cost *= UAVObjGetNumInstances(ev->obj);
+	}
+
+	bool defer = false;
+
+	switch (UAVObjGetTelemetryPriority(metadata)) {
+	case TELEMETRYPRIORITY_HIGH:
+		break;
+	case TELEMETRYPRIORITY_LOW:
+		defer = !UAVObjGetTelemetryAcked(metadata) &&
+			(telem->link_tokens < cost);
+		break;
+	default:
+		defer = (ev->event == EV_UPDATED_PERIODIC) &&
+			(telem->link_tokens <= 0);
+		break;
+	}
+
+	if (defer) {
+		telem->tx_deferred++;
+		return true;
+	}
+
+	/* Sends that must happen can overdraw the bucket, by up to one
+	 * burst, which then holds back the deferrable traffic. */
+	telem->link_tokens = MAX(telem->link_tokens - cost, -burst);
+
+	return false;
+}
+
+/**
+ * Adjusts the link rate estimate and the low priority period stretch
+ * from the throughput measured over the last stats period.
+ *
+ * \param[in] telem Telemetry subsystem handle
+ * \param[in] tx_bytes Bytes transmitted during the period
+ * \param[in] period_ms Length of the period
+ */
+static void linkSchedulerUpdate(telem_t telem, uint32_t tx_bytes,
+		uint32_t period_ms)
+{
+	uint32_t blocked_ms = telem->tx_blocked_ms;
+	uint32_t deferred = telem->tx_deferred;
+	uint8_t stretch = telem->lowpri_stretch;
+
+	telem->tx_blocked_ms = 0;
+	telem->tx_deferred = 0;
+
+	uint32_t measured = tx_bytes * 1000 / period_ms;
+
+#if defined(PIOS_COM_TELEM_USB)
+	if (getComPort() == PIOS_COM_TELEM_USB) {
+		/* Never the bottleneck */
+		blocked_ms = 0;
+		telem->link_rate = 0;
+	}
+#endif
+
+	if (blocked_ms > period_ms / LINK_SATURATED_DIV) {
+		telem->link_rate = MAX(measured, LINK_MIN_RATE);
+	} else if (telem->link_rate) {
+		telem->link_rate += telem->link_rate / LINK_PROBE_DIV;
+
+		if (telem->link_rate > 2 * MAX(measured, LINK_MIN_RATE)) {
+			telem->link_rate = 0;
+		}
+	}
+
+	if (deferred && telem->link_rate) {
+		stretch = MIN(stretch * 2, LOWPRI_MAX_STRETCH);
+	} else if (!telem->link_rate) {
+		stretch = 1;
+	} else if (stretch > 1 && !(blocked_ms > period_ms / LINK_SATURATED_DIV)) {
+		stretch /= 2;
+	}
+
+	if (stretch != telem->lowpri_stretch) {
+		telem->lowpri_stretch = stretch;
+
+		UAVObjIterate(&restretchObjectShim);
+	}
+}
+
 /**
  * Processes queue events
  */
@@ -559,6 +779,8 @@ static void processObjEvent(telem_t telem, UAVObjEvent * ev)
 		updateTelemetryStats(telem);
 	} else if (ev->obj == GCSTelemetryStatsHandle()) {
 		gcsTelemetryStatsUpdated(telem);
+	} else if (ev->obj == LinkPingHandle()) {
+		linkPingReceived(telem, ev);
 	} else {
 		// Act on event
 		if (ev->event == EV_UPDATED || ev->event == EV_UPDATED_MANUAL ||
@@ -572,15 +794,26 @@ static void processObjEvent(telem_t telem, UAVObjEvent * ev)
 			// Get object metadata
 			UAVObjGetMetadata(ev->obj, &metadata);
 
-			if (UAVObjGetTelemetryAcked(&metadata)) {
+			// Leave it to the next update if the link is busy
+			bool deferred = linkSchedulerDefer(telem, ev, &metadata);
+
+			if (!deferred && UAVObjGetTelemetryAcked(&metadata)) {
 				acked = true;
 
 				addAckPending(telem, ev->obj, ev->instId);
 			}
 
-			success = UAVTalkSendObject(telem->uavTalkCon,
-					ev->obj, ev->instId,
-					acked);
+			if (deferred) {
+				success = 0;
+			} else if (!acked && telem->use_batched_frames) {
+				success = UAVTalkSendObjectBatched(
+						telem->uavTalkCon,
+						ev->obj, ev->instId);
+			} else {
+				success = UAVTalkSendObject(telem->uavTalkCon,
+						ev->obj, ev->instId,
+						acked);
+			}
 
 			if (success == -1) {
 				telem->tx_errors++;
@@ -626,6 +859,18 @@ static bool sendRequestedObjs(telem_t telem)
 	// Unlock, to ensure new requests can come in OK.
 	PIOS_Mutex_Unlock(telem->reqack_mutex);
 
+	if (preq.obj_id == UAVTALK_OBJID_ALL_SETTINGS) {
+		/* Send every settings object back to back, then say we're
+		 * done; the ACK also flushes the last batched frame. */
+		UAVObjIterate(&sendSettingsShim);
+		UAVTalkSendAck(telem->uavTalkCon, UAVTALK_OBJID_ALL_SETTINGS, 0);
+
+		PIOS_Mutex_Lock(telem->reqack_mutex,
+				PIOS_MUTEX_TIMEOUT_MAX);
+
+		return true;
+	}
+
 	// handle request
 	UAVObjHandle obj = UAVObjGetByID(preq.obj_id);
 
@@ -691,8 +936,17 @@ static void telemetryTxTask(void *parameters)
 		if (retval == true) {
 			// Process event
 			processObjEvent(telem, &ev);
+
+			/* Take whatever else is already queued, so that
+			 * it can share batched frames. */
+			for (int i = 0; i < MAX_BATCHED_EVENTS &&
+					PIOS_Queue_Receive(telem->queue, &ev, 0);
+					i++) {
+				processObjEvent(telem, &ev);
+			}
 		}
 
+		UAVTalkFlushBatch(telem->uavTalkCon);
 	}
 }
 
@@ -709,17 +963,25 @@ static void telemetryRxTask(void *parameters)
 
 		if (inputPort && (!telem->request_inhibit)) {
 			// Block until data are available
-			uint8_t serial_data[16];
+			const uint8_t *serial_data;
 			uint16_t bytes_to_process;
 
 			telem->rx_inhibited = false;
 
-			bytes_to_process = PIOS_COM_ReceiveBuffer(inputPort,
-					serial_data, sizeof(serial_data), 100);
+			/* Only the telemetry port need be secured; USB takes
+			 * someone with the aircraft in hand. */
+			UAVTalkRequireSecure(telem->uavTalkCon,
+					inputPort == PIOS_COM_TELEM_SER);
+
+			/* Parse straight out of the port buffer */
+			bytes_to_process = PIOS_COM_ReceiveSpan(inputPort,
+					&serial_data, 100);
 
 			if (bytes_to_process > 0) {
 				UAVTalkProcessInputStream(telem->uavTalkCon,
 						serial_data, bytes_to_process);
+				PIOS_COM_ReceiveSpanDone(inputPort,
+						bytes_to_process);
 
 #if defined(PIOS_COM_TELEM_USB)
 				if (inputPort == PIOS_COM_TELEM_USB) {
@@ -743,16 +1005,63 @@ static void telemetryRxTask(void *parameters)
  */
 static int32_t transmitData(void *ctx, uint8_t * data, int32_t length)
 {
-	(void) ctx;
+	telem_t telem = ctx;
 
 	uintptr_t outputPort = getComPort();
 
-	if (outputPort)
-		return PIOS_COM_SendBuffer(outputPort, data, length);
+	if (outputPort) {
+		/* Time spent blocked here is how the scheduler notices
+		 * that the link is saturated. */
+		uint32_t start = PIOS_Thread_Systime();
+		int32_t ret = PIOS_COM_SendBuffer(outputPort, data, length);
+
+		telem->tx_blocked_ms += PIOS_Thread_Systime() - start;
+
+		return ret;
+	}
 
 	return -1;
 }
 
+/**
+ * Reserve room to build a frame directly in the port's transmit buffer.
+ * \param[in] length Length of the frame
+ * \return where to build it, or NULL to use transmitData instead
+ */
+static uint8_t *reserveTransmit(void *ctx, uint16_t length)
+{
+	telem_t telem = ctx;
+
+	uintptr_t outputPort = getComPort();
+
+	if (!outputPort) {
+		return NULL;
+	}
+
+	uint32_t start = PIOS_Thread_Systime();
+	uint8_t *buf = PIOS_COM_SendReserve(outputPort, length, 5000);
+
+	telem->tx_blocked_ms += PIOS_Thread_Systime() - start;
+
+	if (buf) {
+		telem->reserved_port = outputPort;
+	}
+
+	return buf;
+}
+
+/**
+ * Send a frame built in space from reserveTransmit.
+ * \param[in] length Length of the frame, or 0 to drop it
+ * \return number of bytes transmitted
+ */
+static int32_t commitTransmit(void *ctx, uint16_t length)
+{
+	telem_t telem = ctx;
+
+	return PIOS_COM_SendCommit(telem->reserved_port, length);
+}
+
 /**
  * Set update period of object (it must be already setup for periodic updates)
  * \param[in] obj The object to update
@@ -791,6 +1100,42 @@ static void gcsTelemetryStatsUpdated(telem_t telem)
 	}
 }
 
+/**
+ * Notes when a ping came off the link, before it waits in the queue behind
+ * whatever is being sent, so that the wait doesn't count as link time.
+ */
+static void linkPingUnpacked(const UAVObjEvent *ev, void *ctx, void *obj,
+		int len)
+{
+	(void) ctx; (void) obj; (void) len;
+
+	if (ev->event == EV_UNPACKED) {
+		telem_state.ping_received_ms = PIOS_Thread_Systime();
+	}
+}
+
+/**
+ * Answers a ping from the GCS with when it was received and when the answer
+ * went out, so the GCS can work out the round trip and the clock offset.
+ * Our own update of LinkPing comes back here and is ignored.
+ */
+static void linkPingReceived(telem_t telem, UAVObjEvent *ev)
+{
+	if (ev->event != EV_UNPACKED) {
+		return;
+	}
+
+	LinkPingData ping;
+	LinkPingGet(&ping);
+
+	ping.FlightReceived = telem->ping_received_ms;
+	ping.FlightSent = PIOS_Thread_Systime();
+
+	LinkPingSet(&ping);
+
+	UAVTalkSendObject(telem->uavTalkCon, LinkPingHandle(), 0, false);
+}
+
 /**
  * Update telemetry statistics and handle connection handshake
  */
@@ -822,6 +1167,17 @@ static void updateTelemetryStats(telem_t telem)
 		flightStats.TxRetries += telem->tx_retries;
 		telem->tx_errors = 0;
 		telem->tx_retries = 0;
+
+		/* Only adapt over something like a full period, not on
+		 * the extra calls from GCSTelemetryStats updates. */
+		uint32_t period_ms = PIOS_Thread_Systime() -
+			telem->link_stats_time;
+
+		if (period_ms >= STATS_UPDATE_PERIOD_MS / 2) {
+			linkSchedulerUpdate(telem, utalkStats.txBytes,
+					period_ms);
+			telem->link_stats_time += period_ms;
+		}
 	} else {
 		flightStats.RxDataRate = 0;
 		flightStats.TxDataRate = 0;
@@ -830,6 +1186,14 @@ static void updateTelemetryStats(telem_t telem)
 		flightStats.TxRetries = 0;
 		telem->tx_errors = 0;
 		telem->tx_retries = 0;
+
+		telem->link_rate = 0;
+		telem->link_stats_time = PIOS_Thread_Systime();
+
+		if (telem->lowpri_stretch != 1) {
+			telem->lowpri_stretch = 1;
+			UAVObjIterate(&restretchObjectShim);
+		}
 	}
 
 	// Check for connection timeout
@@ -876,6 +1240,15 @@ static void updateTelemetryStats(telem_t telem)
 	}
 #endif
 
+	flightStats.AcceptsFieldUpdates =
+		FLIGHTTELEMETRYSTATS_ACCEPTSFIELDUPDATES_TRUE;
+
+	// Only batch objects once the GCS has said it can parse the frames
+	telem->use_batched_frames =
+		(flightStats.Status == FLIGHTTELEMETRYSTATS_STATUS_CONNECTED) &&
+		(gcsStats.AcceptsBatchedFrames ==
+			GCSTELEMETRYSTATS_ACCEPTSBATCHEDFRAMES_TRUE);
+
 	// Update object
 	FlightTelemetryStatsSet(&flightStats);
 
@@ -897,6 +1270,21 @@ static void updateSettings()
 
 		PIOS_HAL_ConfigureSerialSpeed(PIOS_COM_TELEM_SER, speed);
 	}
+
+	uint8_t key[MODULESETTINGS_TELEMETRYKEY_NUMELEM];
+	uint8_t any = 0;
+
+	ModuleSettingsTelemetryKeyGet(key);
+
+	for (int i = 0; i < sizeof(key); i++) {
+		any |= key[i];
+	}
+
+	if (any) {
+		UAVTalkSetKey(telem_state.uavTalkCon, key);
+	}
+
+	memset(key, 0, sizeof(key));
 }
 
 #if defined(PIOS_COM_TELEM_USB)
@@ -33,11 +33,15 @@
  */
 
 /**
- * Output object: StabilizationSettings
+ * Output object: StabilizationSettings, StabilizationTuning
  *
  * This module will periodically update values of stabilization PID settings
  * depending on configured input control channels. New values of stabilization
- * settings are not saved to flash, but updated in RAM. It is expected that the
+ * settings are not saved to flash, but updated in RAM. Changed rate and
+ * attitude gains go straight to StabilizationTuning, which stabilization
+ * applies to just those loops; StabilizationSettings, which makes every
+ * module redo its whole configuration, gets them at a lower rate.
+ * It is expected that the
  * module will be enabled only for tuning. When desired values are found, they
  * can be read via GCS and saved permanently. Then this module should be
  * disabled again.
@@ -48,10 +52,12 @@
 
 #include "openpilot.h"
 #include <eventdispatcher.h>
+#include "pios_thread.h"
 
 #include "txpidsettings.h"
 #include "manualcontrolcommand.h"
 #include "stabilizationsettings.h"
+#include "stabilizationtuning.h"
 #include "sensorsettings.h"
 #include "vbarsettings.h"
 #include "vtolpathfollowersettings.h"
@@ -63,6 +69,7 @@
 // Configuration
 //
 #define SAMPLE_PERIOD_MS		200
+#define SETTINGS_UPDATE_PERIOD_MS	2000	// Coalesce StabilizationSettings writes
 #define TELEMETRY_UPDATE_PERIOD_MS	0	// 0 = update on change (default)
 
 // Sanity checks
@@ -76,6 +83,8 @@
 struct txpid_struct {
 	TxPIDSettingsData inst;
 	StabilizationSettingsData stab;
+	StabilizationTuningData tuning;
+	uint32_t stab_updated_time;
 	SensorSettingsData sensor;
 	VbarSettingsData vbar;
 	VtolPathFollowerSettingsData vtolPathFollowerSettingsData;
@@ -91,6 +100,7 @@ static struct txpid_struct *txpid_data;
 static void updatePIDs(const UAVObjEvent *ev,
 		void *ctx, void *obj, int len);
 static bool update(float *var, float val);
+static void updateTuning(void);
 static float scale(float val, float inMin, float inMax, float outMin, float outMax);
 
 /**
@@ -127,6 +137,10 @@ int32_t TxPIDInitialize(void)
 				return -1;
 			}
 
+			if (StabilizationTuningInitialize() == -1) {
+				return -1;
+			}
+
 			return 0;
 		}
 	}
@@ -413,9 +427,16 @@ static void updatePIDs(const UAVObjEvent *ev,
 		}
 	}
 
-	// Update UAVOs, if necessary
+	// Update UAVOs, if necessary.  StabilizationSettings is fetched anew
+	// each time, so it keeps needing an update until these are written.
 	if (stabilizationSettingsNeedsUpdate) {
-		StabilizationSettingsSet(&txpid_data->stab);
+		updateTuning();
+
+		if (PIOS_Thread_Period_Elapsed(txpid_data->stab_updated_time,
+					SETTINGS_UPDATE_PERIOD_MS)) {
+			StabilizationSettingsSet(&txpid_data->stab);
+			txpid_data->stab_updated_time = PIOS_Thread_Systime();
+		}
 	}
 
 	if (sensorSettingsNeedsUpdate) {
@@ -434,6 +455,27 @@ static void updatePIDs(const UAVObjEvent *ev,
 	}
 }
 
+/**
+ * Publishes the rate and attitude gains to StabilizationTuning, if they're
+ * any different from what was last published there.
+ */
+static void updateTuning(void)
+{
+	StabilizationTuningData tuning;
+
+	memcpy(tuning.RollRatePID, txpid_data->stab.RollRatePID, sizeof(tuning.RollRatePID));
+	memcpy(tuning.PitchRatePID, txpid_data->stab.PitchRatePID, sizeof(tuning.PitchRatePID));
+	memcpy(tuning.YawRatePID, txpid_data->stab.YawRatePID, sizeof(tuning.YawRatePID));
+	memcpy(tuning.RollPI, txpid_data->stab.RollPI, sizeof(tuning.RollPI));
+	memcpy(tuning.PitchPI, txpid_data->stab.PitchPI, sizeof(tuning.PitchPI));
+	memcpy(tuning.YawPI, txpid_data->stab.YawPI, sizeof(tuning.YawPI));
+
+	if (memcmp(&tuning, &txpid_data->tuning, sizeof(tuning))) {
+		txpid_data->tuning = tuning;
+		StabilizationTuningSet(&tuning);
+	}
+}
+
 /**
  * Scales input val from [inMin..inMax] range to [outMin..outMax].
  * If val is out of input range (inMin <= inMax), it will be bound.
@@ -0,0 +1,383 @@
+/**
+ ******************************************************************************
+ * @addtogroup Modules Modules
+ * @{
+ * @addtogroup UAVOCANBridge UAVO to CAN bus bridge
+ * @{
+ *
+ * @file       uavocanbridge.c
+ * @author     dRonin, http://dronin.org, Copyright (C) 2017
+ * @brief      Carries selected UAVObjects over the CAN bus
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ * Each object in CANBridgeSettings gets its own standard ID, BaseID plus
+ * its index, and is either sent out whenever it updates or taken from the
+ * bus.  Only the IDs of received objects get through the hardware
+ * acceptance filters, so the rest of the traffic on the bus costs nothing.
+ *
+ * Objects bigger than a frame are split up.  The first byte of each frame
+ * holds a 3 bit sequence number, the same for every segment of one update,
+ * and a 5 bit segment index; the other seven are object data.  Segments
+ * leave in order, and an update with one missing is thrown away.
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "openpilot.h"
+#include "modulesettings.h"
+#include "pios_thread.h"
+#include "pios_queue.h"
+#include "pios_can.h"
+#include "misc_math.h"
+
+#include "canbridgesettings.h"
+#include "flightbatterystate.h"
+#include "gpsposition.h"
+#include "gpsvelocity.h"
+#include "motorrpm.h"
+
+#if defined(PIOS_INCLUDE_CAN)
+
+// Private constants
+#define STACK_SIZE_BYTES 512
+#define TASK_PRIORITY PIOS_THREAD_PRIO_LOW
+
+#define QUEUE_LENGTH 32
+
+#define SEGMENT_DATA_LEN 7
+#define MAX_SEGMENTS 32
+#define MAX_OBJECT_LEN (SEGMENT_DATA_LEN * MAX_SEGMENTS)
+
+//! Stands in for a frame length to ask the task to send an object
+#define TX_REQUEST 0xff
+
+//! How long to wait for a free transmit mailbox before giving up
+#define TX_RETRY_MS 5
+
+// Private types
+
+//! A received frame, or a request to send an object
+struct bridge_msg {
+	uint16_t std_id;
+	uint8_t len;
+	uint8_t data[8];
+};
+
+struct bridge_object {
+	int32_t (*initialize)(void);
+	UAVObjHandle (*handle)(void);
+};
+
+struct bridge_state {
+	UAVObjHandle obj;
+	uint8_t mode;
+	uint8_t num_segments;
+
+	//! An update for this object is queued and not sent yet
+	volatile bool tx_pending;
+	uint8_t seq;
+
+	//! Segment expected next, or MAX_SEGMENTS when between updates
+	uint8_t next_segment;
+	uint8_t *rx_buf;
+};
+
+// Private variables
+static const struct bridge_object bridge_objects[CANBRIDGESETTINGS_OBJECTS_NUMELEM] = {
+	[CANBRIDGESETTINGS_OBJECTS_FLIGHTBATTERYSTATE] = {
+		FlightBatteryStateInitialize, FlightBatteryStateHandle },
+	[CANBRIDGESETTINGS_OBJECTS_GPSPOSITION] = {
+		GPSPositionInitialize, GPSPositionHandle },
+	[CANBRIDGESETTINGS_OBJECTS_GPSVELOCITY] = {
+		GPSVelocityInitialize, GPSVelocityHandle },
+	[CANBRIDGESETTINGS_OBJECTS_MOTORRPM] = {
+		MotorRPMInitialize, MotorRPMHandle },
+};
+
+static struct pios_thread *bridgeTaskHandle;
+static bool module_enabled;
+static struct pios_queue *bridge_queue;
+static struct bridge_state bridge_state[CANBRIDGESETTINGS_OBJECTS_NUMELEM];
+static uint16_t base_id;
+static uint8_t tx_buf[MAX_OBJECT_LEN];
+
+extern uintptr_t pios_can_id;
+
+// Private functions
+static void uavoCANBridgeTask(void *parameters);
+static bool frame_received(uintptr_t context, uint16_t std_id,
+		const uint8_t *data, uint8_t len);
+static void object_updated(const UAVObjEvent *ev, void *ctx, void *obj,
+		int len);
+static void send_object(uint8_t index);
+static void receive_segment(uint8_t index, const uint8_t *data,
+		uint8_t len);
+
+/**
+ * Initialise the module
+ * \return -1 if initialisation failed
+ * \return 0 on success
+ */
+int32_t UAVOCANBridgeInitialize(void)
+{
+#ifdef MODULE_UAVOCANBRIDGE_BUILTIN
+	module_enabled = true;
+#else
+	uint8_t module_state[MODULESETTINGS_ADMINSTATE_NUMELEM];
+	ModuleSettingsAdminStateGet(module_state);
+	if (module_state[MODULESETTINGS_ADMINSTATE_UAVOCANBRIDGE] == MODULESETTINGS_ADMINSTATE_ENABLED) {
+		module_enabled = true;
+	} else {
+		module_enabled = false;
+	}
+#endif
+
+	if (!pios_can_id)
+		module_enabled = false;
+
+	if (!module_enabled)
+		return -1;
+
+	if (CANBridgeSettingsInitialize() == -1) {
+		module_enabled = false;
+		return -1;
+	}
+
+	return 0;
+}
+
+/**
+ * Start the module
+ * \return -1 if initialisation failed
+ * \return 0 on success
+ */
+int32_t UAVOCANBridgeStart(void)
+{
+	if (!module_enabled)
+		return -1;
+
+	CANBridgeSettingsData settings;
+	CANBridgeSettingsGet(&settings);
+
+	base_id = settings.BaseID;
+
+	uint16_t rx_ids[CANBRIDGESETTINGS_OBJECTS_NUMELEM];
+	uint8_t num_rx = 0;
+	bool any = false;
+
+	for (uint8_t i = 0; i < CANBRIDGESETTINGS_OBJECTS_NUMELEM; i++) {
+		struct bridge_state *state = &bridge_state[i];
+
+		state->mode = settings.Objects[i];
+		state->next_segment = MAX_SEGMENTS;
+
+		if (state->mode == CANBRIDGESETTINGS_OBJECTS_DISABLED)
+			continue;
+
+		bridge_objects[i].initialize();
+		state->obj = bridge_objects[i].handle();
+
+		if (!state->obj ||
+				UAVObjGetNumBytes(state->obj) > MAX_OBJECT_LEN) {
+			state->mode = CANBRIDGESETTINGS_OBJECTS_DISABLED;
+			continue;
+		}
+
+		uint32_t size = UAVObjGetNumBytes(state->obj);
+
+		state->num_segments = (size + SEGMENT_DATA_LEN - 1) / SEGMENT_DATA_LEN;
+
+		if (state->mode == CANBRIDGESETTINGS_OBJECTS_RECEIVE) {
+			state->rx_buf = PIOS_malloc(size);
+
+			if (!state->rx_buf) {
+				state->mode = CANBRIDGESETTINGS_OBJECTS_DISABLED;
+				continue;
+			}
+
+			rx_ids[num_rx++] = base_id + i;
+		}
+
+		any = true;
+	}
+
+	if (!any)
+		return -1;
+
+	bridge_queue = PIOS_Queue_Create(QUEUE_LENGTH, sizeof(struct bridge_msg));
+	if (!bridge_queue)
+		return -1;
+
+	for (uint8_t i = 0; i < CANBRIDGESETTINGS_OBJECTS_NUMELEM; i++) {
+		if (bridge_state[i].mode == CANBRIDGESETTINGS_OBJECTS_TRANSMIT) {
+			UAVObjConnectCallback(bridge_state[i].obj, object_updated,
+					(void *) (uintptr_t) i,
+					EV_UPDATED | EV_UPDATED_MANUAL);
+		}
+	}
+
+	if (num_rx)
+		PIOS_CAN_SetFilters(pios_can_id, rx_ids, num_rx, frame_received, 0);
+
+	bridgeTaskHandle = PIOS_Thread_Create(uavoCANBridgeTask, "UAVOCANBridge", STACK_SIZE_BYTES, NULL, TASK_PRIORITY);
+	TaskMonitorAdd(TASKINFO_RUNNING_UAVOCANBRIDGE, bridgeTaskHandle);
+
+	return 0;
+}
+
+MODULE_INITCALL(UAVOCANBridgeInitialize, UAVOCANBridgeStart);
+
+/**
+ * Receives frames from the ISR, and requests to send objects from whoever
+ * updated them, and deals with both in turn.
+ */
+static void uavoCANBridgeTask(void *parameters)
+{
+	struct bridge_msg msg;
+
+	while (1) {
+		if (!PIOS_Queue_Receive(bridge_queue, &msg, PIOS_QUEUE_TIMEOUT_MAX))
+			continue;
+
+		uint16_t index = msg.std_id - base_id;
+
+		if (index >= CANBRIDGESETTINGS_OBJECTS_NUMELEM)
+			continue;
+
+		if (msg.len == TX_REQUEST) {
+			send_object(index);
+		} else if (bridge_state[index].mode == CANBRIDGESETTINGS_OBJECTS_RECEIVE) {
+			receive_segment(index, msg.data, msg.len);
+		}
+	}
+}
+
+/**
+ * Called from the CAN receive ISR; hands the frame to the task.
+ */
+static bool frame_received(uintptr_t context, uint16_t std_id,
+		const uint8_t *data, uint8_t len)
+{
+	struct bridge_msg msg = {
+		.std_id = std_id,
+		.len = MIN(len, sizeof(msg.data)),
+	};
+
+	memcpy(msg.data, data, msg.len);
+
+	bool woken = false;
+	PIOS_Queue_Send_FromISR(bridge_queue, &msg, &woken);
+
+	return woken;
+}
+
+/**
+ * Asks the task to send an object that was updated.  Updates that come in
+ * before the last one went out are folded into it.
+ */
+static void object_updated(const UAVObjEvent *ev, void *ctx, void *obj,
+		int len)
+{
+	uint8_t index = (uintptr_t) ctx;
+
+	if (bridge_state[index].tx_pending)
+		return;
+
+	struct bridge_msg msg = {
+		.std_id = base_id + index,
+		.len = TX_REQUEST,
+	};
+
+	bridge_state[index].tx_pending = true;
+
+	if (!PIOS_Queue_Send(bridge_queue, &msg, 0))
+		bridge_state[index].tx_pending = false;
+}
+
+static void send_object(uint8_t index)
+{
+	struct bridge_state *state = &bridge_state[index];
+
+	state->tx_pending = false;
+
+	uint32_t size = UAVObjGetNumBytes(state->obj);
+	UAVObjGetData(state->obj, tx_buf);
+
+	state->seq = (state->seq + 1) & 0x07;
+
+	for (uint8_t segment = 0; segment < state->num_segments; segment++) {
+		uint8_t frame[8];
+		uint32_t offset = segment * SEGMENT_DATA_LEN;
+		uint8_t len = MIN(size - offset, SEGMENT_DATA_LEN);
+
+		frame[0] = (state->seq << 5) | segment;
+		memcpy(&frame[1], &tx_buf[offset], len);
+
+		int32_t ret;
+		uint32_t tries = 0;
+
+		while ((ret = PIOS_CAN_TxFrame(pios_can_id, base_id + index,
+						frame, len + 1)) == -2 &&
+				tries++ < TX_RETRY_MS) {
+			PIOS_Thread_Sleep(1);
+		}
+
+		// The receiver drops the rest of this update anyway
+		if (ret < 0)
+			return;
+	}
+}
+
+static void receive_segment(uint8_t index, const uint8_t *data,
+		uint8_t len)
+{
+	struct bridge_state *state = &bridge_state[index];
+
+	if (len < 2)
+		return;
+
+	uint8_t seq = data[0] >> 5;
+	uint8_t segment = data[0] & 0x1f;
+
+	if (segment == 0) {
+		state->seq = seq;
+		state->next_segment = 0;
+	}
+
+	if (segment != state->next_segment || seq != state->seq ||
+			segment >= state->num_segments) {
+		state->next_segment = MAX_SEGMENTS;
+		return;
+	}
+
+	uint32_t size = UAVObjGetNumBytes(state->obj);
+	uint32_t offset = segment * SEGMENT_DATA_LEN;
+
+	memcpy(&state->rx_buf[offset], &data[1],
+			MIN(len - 1, size - offset));
+
+	if (++state->next_segment == state->num_segments) {
+		UAVObjSetData(state->obj, state->rx_buf);
+		state->next_segment = MAX_SEGMENTS;
+	}
+}
+
+#endif /* PIOS_INCLUDE_CAN */
+
+/**
+ * @}
+ * @}
+ */
@@ -38,12 +38,10 @@
 #include "taskinfo.h"
 
 #include "uavocrossfiretelemetry.h"
+#include "telemetry_snapshot.h"
 
 #include "modulesettings.h"
-#include "flightbatterystate.h"
-#include "flightbatterysettings.h"
 #include "gpsposition.h"
-#include "attitudeactual.h"
 #include "manualcontrolsettings.h"
 
 // Private constants
@@ -90,7 +88,8 @@ static int32_t uavoCrossfireTelemetryStart(void)
 
 static int32_t uavoCrossfireTelemetryInitialize(void)
 {
-	module_enabled = PIOS_Modules_IsEnabled(PIOS_MODULE_UAVOCROSSFIRETELEMETRY); 
+	module_enabled = PIOS_Modules_IsEnabled(PIOS_MODULE_UAVOCROSSFIRETELEMETRY) &&
+		(telemetry_snapshot_init() == 0);
 	return 0;
 }
 MODULE_INITCALL(uavoCrossfireTelemetryInitialize, uavoCrossfireTelemetryStart)
@@ -100,21 +99,18 @@ MODULE_INITCALL(uavoCrossfireTelemetryInitialize, uavoCrossfireTelemetryStart)
 #define WRITE_VAL16(buf,p,x)			{ typeof(x) v = x; uint8_t *q = (uint8_t*)&v; buf[p++] = q[1]; buf[p++] = q[0]; }
 #define WRITE_VAL32(buf,p,x)			{ typeof(x) v = x; uint8_t *q = (uint8_t*)&v; buf[p++] = q[3]; buf[p++] = q[2]; buf[p++] = q[1]; buf[p++] = q[0]; }
 
-static int crsftelem_create_attitude(uint8_t *buf)
+static int crsftelem_create_attitude(uint8_t *buf, const struct telemetry_snapshot *snap)
 {
 	int pos = 0;
 
-	if(AttitudeActualHandle()) {
-		AttitudeActualData attitudeData;
-		AttitudeActualGet(&attitudeData);
-
+	if(snap->have_attitude) {
 		buf[pos++] = 0;
 		buf[pos++] = CRSF_PAYLOAD_LEN(CRSF_PAYLOAD_ATTITUDE);
 		buf[pos++] = CRSF_FRAME_ATTITUDE;
 
-		WRITE_VAL16(buf, pos, (int16_t)(DEG2RAD(attitudeData.Pitch)*10000.0f));
-		WRITE_VAL16(buf, pos, (int16_t)(DEG2RAD(attitudeData.Roll)*10000.0f));
-		WRITE_VAL16(buf, pos, (int16_t)(DEG2RAD(attitudeData.Yaw)*10000.0f));
+		WRITE_VAL16(buf, pos, (int16_t)(DEG2RAD(snap->pitch)*10000.0f));
+		WRITE_VAL16(buf, pos, (int16_t)(DEG2RAD(snap->roll)*10000.0f));
+		WRITE_VAL16(buf, pos, (int16_t)(DEG2RAD(snap->yaw)*10000.0f));
 
 		buf[pos++] = PIOS_CRC_updateCRC_TBS(0, buf+2, buf[1] - CRSF_CRC_LEN);
 	}
@@ -122,30 +118,24 @@ static int crsftelem_create_attitude(uint8_t *buf)
 	return pos;
 }
 
-static int crsftelem_create_battery(uint8_t *buf)
+static int crsftelem_create_battery(uint8_t *buf, const struct telemetry_snapshot *snap)
 {
 	int pos = 0;
 
-	if(FlightBatteryStateHandle() && FlightBatterySettingsHandle()) {
-		FlightBatteryStateData batteryData;
-		FlightBatterySettingsData batterySettings;
-
-		FlightBatteryStateGet(&batteryData);
-		FlightBatterySettingsGet(&batterySettings);
-
+	if(snap->have_battery) {
 		buf[pos++] = 0;
 		buf[pos++] = CRSF_PAYLOAD_LEN(CRSF_PAYLOAD_BATTERY);
 		buf[pos++] = CRSF_FRAME_BATTERY;
 
-		WRITE_VAL16(buf, pos, (uint16_t)(batteryData.Voltage * 10.0f))
-		WRITE_VAL16(buf, pos, (uint16_t)(batteryData.Current * 10.0f))
+		WRITE_VAL16(buf, pos, (uint16_t)(snap->voltage * 10.0f))
+		WRITE_VAL16(buf, pos, (uint16_t)(snap->current * 10.0f))
 
 		// Should apparently be capacity used?
-		buf[pos++] = (uint8_t)((batterySettings.Capacity & 0x00FF0000) >> 16);
-		buf[pos++] = (uint8_t)((batterySettings.Capacity & 0x0000FF00) >> 8);
-		buf[pos++] = (uint8_t)(batterySettings.Capacity & 0x000000FF);
+		buf[pos++] = (uint8_t)((snap->capacity & 0x00FF0000) >> 16);
+		buf[pos++] = (uint8_t)((snap->capacity & 0x0000FF00) >> 8);
+		buf[pos++] = (uint8_t)(snap->capacity & 0x000000FF);
 
-		float charge_state = batterySettings.Capacity == 0 ? 100.0f : (batteryData.ConsumedEnergy / batterySettings.Capacity);
+		float charge_state = snap->capacity == 0 ? 100.0f : (snap->consumed_energy / snap->capacity);
 		if(charge_state < 0) charge_state = 0;
 		else if(charge_state > 100) charge_state = 100;
 		buf[pos++] = (uint8_t)charge_state;
@@ -156,32 +146,29 @@ static int crsftelem_create_battery(uint8_t *buf)
 	return pos;
 }
 
-static int crsftelem_create_gps(uint8_t *buf)
+static int crsftelem_create_gps(uint8_t *buf, const struct telemetry_snapshot *snap)
 {
 	int pos = 0;
 
-	if(GPSPositionHandle()) {
-		GPSPositionData gpsData;
-		GPSPositionGet(&gpsData);
-
-		if(gpsData.Status >= GPSPOSITION_STATUS_FIX2D) {
+	if(snap->have_gps) {
+		if(snap->gps_status >= GPSPOSITION_STATUS_FIX2D) {
 			buf[pos++] = 0;
 			buf[pos++] = CRSF_PAYLOAD_LEN(CRSF_PAYLOAD_GPS);
 			buf[pos++] = CRSF_FRAME_GPS;
 
 			// Latitude (x10^7, as dRonin)
-			WRITE_VAL32(buf, pos, (int32_t)gpsData.Latitude);
+			WRITE_VAL32(buf, pos, snap->latitude);
 			// Longitude (x10^7, as dRonin)
-			WRITE_VAL32(buf, pos, (int32_t)gpsData.Longitude);
+			WRITE_VAL32(buf, pos, snap->longitude);
 			// Groundspeed (apparently tenth of km/h)
-			WRITE_VAL16(buf, pos, (uint16_t)(gpsData.Groundspeed*10.0f));
+			WRITE_VAL16(buf, pos, (uint16_t)(snap->groundspeed*10.0f));
 			// Heading (apparently hundreth of a degree)
-			WRITE_VAL16(buf, pos, (uint16_t)(gpsData.Heading*100.0f));
+			WRITE_VAL16(buf, pos, (uint16_t)(snap->heading*100.0f));
 			// Altitude 1000 = 0m
 			WRITE_VAL16(buf, pos, (uint16_t)(1000.0f+
-				(gpsData.Status >= GPSPOSITION_STATUS_FIX3D ? gpsData.Altitude : 0.0f)));
+				(snap->gps_status >= GPSPOSITION_STATUS_FIX3D ? snap->gps_altitude : 0.0f)));
 			// Satellites
-			buf[pos++] = gpsData.Satellites;
+			buf[pos++] = snap->satellites;
 
 			buf[pos++] = PIOS_CRC_updateCRC_TBS(0, buf+2, buf[1] - CRSF_CRC_LEN);
 		}
@@ -204,25 +191,28 @@ static void uavoCrossfireTelemetryTask(void *parameters)
 		uint8_t len = 0;
 
 		if(!PIOS_Crossfire_IsFailsafed(crsf_telem_dev_id)) {
+			struct telemetry_snapshot snap;
+			telemetry_snapshot_get(&snap, idledelay);
 
 			switch(counter++ % 3) {
 				default:
 				case 0: // Attitude
-					len = crsftelem_create_attitude(buf);
+					len = crsftelem_create_attitude(buf, &snap);
 					break;
 				case 1: // Battery
-					len = crsftelem_create_battery(buf);
+					len = crsftelem_create_battery(buf, &snap);
 					break;
 				case 2: // GPS
-					len = crsftelem_create_gps(buf);
+					len = crsftelem_create_gps(buf, &snap);
 					break;
 			}
 
 			if(len) {
 				while(PIOS_Crossfire_SendTelemetry(crsf_telem_dev_id, buf, len)) {
 					// Keep repeating until telemetry went through, without
-					// locking up the whole thing.
-					PIOS_Thread_Sleep(2);
+					// locking up the whole thing. The send window can be
+					// under a millisecond at high packet rates.
+					PIOS_Thread_Sleep(1);
 				}
 			}
 		}
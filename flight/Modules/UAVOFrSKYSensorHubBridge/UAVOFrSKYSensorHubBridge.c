@@ -49,6 +49,7 @@
 #include "attitudeactual.h"
 #include "pios_thread.h"
 #include "pios_modules.h"
+#include "geofmt.h"
 
 #if defined(PIOS_INCLUDE_FRSKY_SENSOR_HUB)
 // ****************
@@ -742,8 +743,11 @@ static uint16_t frsky_pack_gps(
 
 	// latitude
 	{
-		uint16_t integerValue = (abs(latitude) / 100000);
-		uint16_t decimalValue = (abs(latitude) / 10) % 10000;
+		// ddmm.mmmm, as NMEA has it
+		struct geofmt_deg_min dm;
+		geofmt_deg_min(latitude, &dm);
+		uint16_t integerValue = dm.degrees * 100 + dm.minutes;
+		uint16_t decimalValue = dm.minutes_e4;
 
 		frsky_serialize_value(FRSKY_GPS_LATITUDE_INTEGER, (uint8_t*)&integerValue, serial_buf, &index);
 		frsky_serialize_value(FRSKY_GPS_LATITUDE_DECIMAL, (uint8_t*)&decimalValue, serial_buf, &index);
@@ -757,8 +761,11 @@ static uint16_t frsky_pack_gps(
 
 	// longitude
 	{
-		uint16_t integerValue = (abs(longitude) / 100000);
-		uint16_t decimalValue = (abs(longitude) / 10) % 10000;
+		// ddmm.mmmm, as NMEA has it
+		struct geofmt_deg_min dm;
+		geofmt_deg_min(longitude, &dm);
+		uint16_t integerValue = dm.degrees * 100 + dm.minutes;
+		uint16_t decimalValue = dm.minutes_e4;
 
 		uint16_t hemisphere = 'E';
 		if (longitude < 0) {
@@ -39,6 +39,7 @@
 #include "uavohottbridge.h"
 #include "pios_thread.h"
 #include "pios_modules.h"
+#include "geofmt.h"
 
 // Private constants
 #define STACK_SIZE_BYTES 700
@@ -842,20 +843,16 @@ uword_t scale_float2uword(float value, float scale, float offset) {
 void convert_long2gps(int32_t value, uint8_t *dir, uword_t *min, uword_t *sec) {
 	//convert gps decigrad value into degrees, minutes and seconds
 	uword_t temp;
-	uint32_t absvalue = abs(value);
-	uint16_t degrees = (absvalue / 10000000);
-	uint32_t seconds = (absvalue - degrees * 10000000) * 6;
-	uint16_t minutes = seconds / 1000000;
-	seconds %= 1000000;
-	seconds = seconds / 100;
-	uint16_t degmin = degrees * 100 + minutes;
+	struct geofmt_deg_min dm;
+	geofmt_deg_min(value, &dm);
+	uint16_t degmin = dm.degrees * 100 + dm.minutes;
 	// write results
-	*dir = (value < 0) ? 1 : 0;
+	*dir = dm.negative ? 1 : 0;
 	temp.l = (uint8_t)degmin & 0xff;
 	temp.h = (uint8_t)(degmin >> 8) & 0xff;
 	*min = temp;
-	temp.l = (uint8_t)seconds & 0xff;
-	temp.h = (uint8_t)(seconds >> 8) & 0xff;
+	temp.l = (uint8_t)dm.minutes_e4 & 0xff;
+	temp.h = (uint8_t)(dm.minutes_e4 >> 8) & 0xff;
 	*sec = temp;
 }
 
@@ -54,16 +54,10 @@
 #include "openpilot.h"
 #include "modulesettings.h"
 
-#include "accels.h"
-#include "airspeedactual.h"
-#include "attitudeactual.h"
-#include "baroaltitude.h"
 #include "flightstatus.h"
 #include "gpsposition.h"
-#include "flightbatterysettings.h"
-#include "flightbatterystate.h"
-#include "manualcontrolcommand.h"
-#include "positionactual.h"
+
+#include "telemetry_snapshot.h"
 
 #include "pios_thread.h"
 #include "pios_modules.h"
@@ -99,9 +93,9 @@ static void uavoLighttelemetryBridgeTask(void *parameters);
 static void updateSettings();
 
 static int send_LTM_Packet(uint8_t *LTPacket, uint8_t LTPacket_size);
-static int send_LTM_Gframe();
-static int send_LTM_Aframe();
-static int send_LTM_Sframe();
+static int send_LTM_Gframe(const struct telemetry_snapshot *snap);
+static int send_LTM_Aframe(const struct telemetry_snapshot *snap);
+static int send_LTM_Sframe(const struct telemetry_snapshot *snap);
 
 
 /**
@@ -112,7 +106,8 @@ int32_t uavoLighttelemetryBridgeInitialize()
 {
 	lighttelemetryPort = PIOS_COM_LIGHTTELEMETRY;
 
-	if (lighttelemetryPort && PIOS_Modules_IsEnabled(PIOS_MODULE_UAVOLIGHTTELEMETRYBRIDGE)) {
+	if (lighttelemetryPort && PIOS_Modules_IsEnabled(PIOS_MODULE_UAVOLIGHTTELEMETRYBRIDGE) &&
+			(telemetry_snapshot_init() == 0)) {
 		// Update telemetry settings
 		module_enabled = true;
 		return 0;
@@ -154,16 +149,19 @@ static void uavoLighttelemetryBridgeTask(void *parameters)
 	{
 		int ret = 0;
 
+		struct telemetry_snapshot snap;
+		telemetry_snapshot_get(&snap, CHUNK_TIME);
+
 		if (!ret) {
 			switch (ltm_scheduler) {
 				case 0:
 				case 6:
-					ret = send_LTM_Sframe();
+					ret = send_LTM_Sframe(&snap);
 					break;
 
 				case 3:
 				case 9:
-					ret = send_LTM_Gframe();
+					ret = send_LTM_Gframe(&snap);
 					break;
 
 				case 1:
@@ -178,7 +176,7 @@ static void uavoLighttelemetryBridgeTask(void *parameters)
 				case 5:
 				case 8:
 				case 11:
-					ret = send_LTM_Aframe();
+					ret = send_LTM_Aframe(&snap);
 					break;
 
 				default:
@@ -208,37 +206,21 @@ static void uavoLighttelemetryBridgeTask(void *parameters)
  *#######################################################################
 */
 //GPS packet
-static int send_LTM_Gframe()
+static int send_LTM_Gframe(const struct telemetry_snapshot *snap)
 {
-	GPSPositionData pdata = { };	/* Set to all 0's */
-
-	bool have_gps = false;
-
-	if (GPSPositionHandle() != NULL) {
-		have_gps = true;
-		GPSPositionGet(&pdata);
-	}
-
-	int32_t lt_latitude = pdata.Latitude;
-	int32_t lt_longitude = pdata.Longitude;
-	uint8_t lt_groundspeed = (uint8_t)roundf(pdata.Groundspeed); //rounded m/s .
+	int32_t lt_latitude = snap->latitude;
+	int32_t lt_longitude = snap->longitude;
+	uint8_t lt_groundspeed = (uint8_t)roundf(snap->groundspeed); //rounded m/s .
 	int32_t lt_altitude = 0;
-	if (PositionActualHandle() != NULL) {
-		float altitude;
-		PositionActualDownGet(&altitude);
-		lt_altitude = (int32_t)roundf(altitude * -100.0f);
-	} else if (BaroAltitudeHandle() != NULL) {
-		float altitude;
-		BaroAltitudeAltitudeGet(&altitude);
-		lt_altitude = (int32_t)roundf(altitude * 100.0f); //Baro alt in cm.
-	} else if (have_gps) {
-		lt_altitude = (int32_t)roundf(pdata.Altitude * 100.0f); //GPS alt in cm.
+	if (snap->have_altitude) {
+		// Estimated, baro or GPS altitude, in that order
+		lt_altitude = (int32_t)roundf(snap->altitude * 100.0f); //alt in cm.
 	} else {
 		return 0;	/* Don't even bother, no data for this frame! */
 	}
 	
 	uint8_t lt_gpsfix;
-	switch (pdata.Status) {
+	switch (snap->gps_status) {
 	case GPSPOSITION_STATUS_NOGPS:
 		lt_gpsfix = 0;
 		break;
@@ -256,7 +238,7 @@ static int send_LTM_Gframe()
 		break;
 	}
 	
-	uint8_t lt_gpssats = (int8_t)pdata.Satellites;
+	uint8_t lt_gpssats = (int8_t)snap->satellites;
 	//pack G frame	
 	uint8_t LTBuff[LTM_GFRAME_SIZE];
 	//G Frame: $T(2 bytes)G(1byte)LAT(cm,4 bytes)LON(cm,4bytes)SPEED(m/s,1bytes)ALT(cm,4bytes)SATS(6bits)FIX(2bits)CRC(xor,1byte)
@@ -285,14 +267,12 @@ static int send_LTM_Gframe()
 }
 
 //Attitude packet
-static int send_LTM_Aframe()
+static int send_LTM_Aframe(const struct telemetry_snapshot *snap)
 {
 	//prepare data
-	AttitudeActualData adata;
-	AttitudeActualGet(&adata);
-	int16_t lt_pitch   = (int16_t)(roundf(adata.Pitch));	//-180/180°
-	int16_t lt_roll	   = (int16_t)(roundf(adata.Roll));		//-180/180°
-	int16_t lt_heading = (int16_t)(roundf(adata.Yaw));		//-180/180°
+	int16_t lt_pitch   = (int16_t)(roundf(snap->pitch));	//-180/180°
+	int16_t lt_roll	   = (int16_t)(roundf(snap->roll));		//-180/180°
+	int16_t lt_heading = (int16_t)(roundf(snap->yaw));		//-180/180°
 	//pack A frame	
 	uint8_t LTBuff[LTM_AFRAME_SIZE];
 	
@@ -314,7 +294,7 @@ static int send_LTM_Aframe()
 }
 
 //Sensors packet
-static int send_LTM_Sframe()
+static int send_LTM_Sframe(const struct telemetry_snapshot *snap)
 {
 	//prepare data
 	uint16_t lt_vbat = 0;
@@ -326,35 +306,23 @@ static int send_LTM_Sframe()
 	uint8_t	 lt_flightmode = 0;
 	
 	
-	if (FlightBatteryStateHandle() != NULL) {
-		FlightBatteryStateData sdata;
-		FlightBatteryStateGet(&sdata);
-		lt_vbat = (uint16_t)roundf(sdata.Voltage*1000);	  //Battery voltage in mv
-		lt_amp = (uint16_t)roundf(sdata.ConsumedEnergy);	  //mA consumed
-	}
-	if (ManualControlCommandHandle() != NULL) {
-		ManualControlCommandData mdata;
-		ManualControlCommandGet(&mdata);
-		lt_rssi = (uint8_t)mdata.Rssi;					  //RSSI in %
+	if (snap->have_battery) {
+		lt_vbat = (uint16_t)roundf(snap->voltage*1000);	  //Battery voltage in mv
+		lt_amp = (uint16_t)roundf(snap->consumed_energy);	  //mA consumed
 	}
-	if (AirspeedActualHandle() != NULL) {
-		AirspeedActualData adata;
-		AirspeedActualGet (&adata);
-		lt_airspeed = (uint8_t)roundf(adata.TrueAirspeed);	  //Airspeed in m/s
-	} else if (GPSPositionHandle() != NULL) {
-		float groundspeed;
-		GPSPositionGroundspeedGet(&groundspeed);
-		lt_airspeed = (uint8_t)roundf(groundspeed);
+	lt_rssi = snap->rssi;							  //RSSI in %
+	if (snap->have_airspeed) {
+		lt_airspeed = (uint8_t)roundf(snap->airspeed);	  //Airspeed in m/s
+	} else if (snap->have_gps) {
+		lt_airspeed = (uint8_t)roundf(snap->groundspeed);
 	}
 
-	FlightStatusData fdata;
-	FlightStatusGet(&fdata);
-	lt_arm = fdata.Armed;									  //Armed status
+	lt_arm = snap->armed;									  //Armed status
 	if (lt_arm == 1)		//arming , we don't use this one
 		lt_arm = 0;		
 	else if (lt_arm == 2)  // armed
 		lt_arm = 1;
-	if (fdata.ControlSource == FLIGHTSTATUS_CONTROLSOURCE_FAILSAFE)
+	if (snap->control_source == FLIGHTSTATUS_CONTROLSOURCE_FAILSAFE)
 		lt_failsafe = 1;
 	else
 		lt_failsafe = 0;
@@ -363,7 +331,7 @@ static int send_LTM_Sframe()
 	// 8: Altitude Hold, 9: Loiter/GPS Hold, 10: Auto/Waypoints, 11: Heading Hold / headFree,
 	// 12: Circle, 13: RTH, 14: FollowMe, 15: LAND, 16:FlybyWireA, 17: FlybywireB, 18: Cruise, 19: Unknown
 
-	switch (fdata.FlightMode) {
+	switch (snap->flight_mode) {
 	case FLIGHTSTATUS_FLIGHTMODE_MANUAL:
 		lt_flightmode = 0; break;
 	case FLIGHTSTATUS_FLIGHTMODE_STABILIZED1:
@@ -38,6 +38,7 @@
 #include "pios_thread.h"
 #include "pios_sensors.h"
 #include "pios_modules.h"
+#include "pios_crc.h"
 #include <pios_hal.h>
 
 #include "actuatorsettings.h"
@@ -172,6 +173,12 @@ typedef enum {
 	MSP_HEADER_M,
 	MSP_HEADER_SIZE,
 	MSP_HEADER_CMD,
+	MSP_HEADER_X,
+	MSP_V2_FLAG,
+	MSP_V2_CMD_LO,
+	MSP_V2_CMD_HI,
+	MSP_V2_SIZE_LO,
+	MSP_V2_SIZE_HI,
 	MSP_FILLBUF,
 	MSP_CHECKSUM,
 	MSP_DISCARD,
@@ -199,17 +206,25 @@ struct msp_bridge {
 
 	enum msp_handler handler;
 	msp_state state;
-	uint8_t cmd_size;
-	uint8_t cmd_id;
-	uint8_t cmd_i;
-	uint8_t checksum;
+	bool v2;		// Request (and so the reply) uses MSP v2 framing
+	uint16_t cmd_size;
+	uint16_t cmd_id;
+	uint16_t cmd_i;
+	uint8_t checksum;	// XOR for v1, crc8 dvb-s2 for v2
 	union {
 		uint8_t data[128];
 		// Specific packed data structures go here.
 		struct msp_cmddata_escserial escserial;
 	} cmd_data;
+
+	// Replies are queued here and go out together once the received
+	// bytes on hand have been handled.
+	uint16_t tx_len;
+	uint8_t tx_buf[256];
 };
 
+#define MSP_RX_CHUNK 32
+
 #if defined(PIOS_MSP_STACK_SIZE)
 #define STACK_SIZE_BYTES PIOS_MSP_STACK_SIZE
 #else
@@ -229,45 +244,89 @@ static void uavoMSPBridgeTask(void *parameters);
 void esc4wayProcess(void *mspPort);
 
 
-static void msp_send_error(struct msp_bridge *m, uint8_t cmd)
+static void msp_flush(struct msp_bridge *m)
 {
-	uint8_t buf[6];
+	if (m->tx_len) {
+		PIOS_COM_SendBuffer(m->com, m->tx_buf, m->tx_len);
+		m->tx_len = 0;
+	}
+}
 
-	buf[0] = '$';
-	buf[1] = 'M';
-	buf[2] = '|';
-	buf[3] = 0;
-	buf[4] = cmd;
-	buf[5] = cmd;	// Checksum == cmd
+static void msp_queue(struct msp_bridge *m, const uint8_t *data, size_t len)
+{
+	if (m->tx_len + len > sizeof(m->tx_buf)) {
+		msp_flush(m);
+
+		if (len > sizeof(m->tx_buf)) {
+			PIOS_COM_SendBuffer(m->com, data, len);
+			return;
+		}
+	}
 
-	PIOS_COM_SendBuffer(m->com, buf, sizeof(buf));
+	memcpy(m->tx_buf + m->tx_len, data, len);
+	m->tx_len += len;
 }
 
-static void msp_send(struct msp_bridge *m, uint8_t cmd, const uint8_t *data, size_t len)
+/**
+ * Queues one reply frame, in whichever framing the request used.
+ * @param[in] type '>' for a reply, '!' (v2) or '|' (v1) for an error
+ */
+static void msp_queue_frame(struct msp_bridge *m, uint8_t type, uint16_t cmd,
+		const uint8_t *data, size_t len)
 {
-	uint8_t buf[5];
-	uint8_t cs = (uint8_t)(len) ^ cmd;
+	uint8_t buf[8];
+	uint8_t cs;
+	size_t hdr_len;
 
 	buf[0] = '$';
-	buf[1] = 'M';
-	buf[2] = '>';
-	buf[3] = (uint8_t)(len);
-	buf[4] = cmd;
-
-	PIOS_COM_SendBuffer(m->com, buf, sizeof(buf));
-	PIOS_COM_SendBuffer(m->com, data, len);
+	buf[2] = type;
+
+	if (m->v2) {
+		buf[1] = 'X';
+		buf[3] = 0;	// flags
+		buf[4] = cmd & 0xff;
+		buf[5] = cmd >> 8;
+		buf[6] = len & 0xff;
+		buf[7] = len >> 8;
+		hdr_len = 8;
+
+		cs = PIOS_CRC_updateCRC_TBS(0, buf + 3, 5);
+		cs = PIOS_CRC_updateCRC_TBS(cs, data, len);
+	} else {
+		buf[1] = 'M';
+		buf[3] = (uint8_t)(len);
+		buf[4] = cmd;
+		hdr_len = 5;
+
+		cs = buf[3] ^ buf[4];
+		for (int i = 0; i < len; i++) {
+			cs ^= data[i];
+		}
+	}
 
-	for (int i = 0; i < len; i++) {
-		cs ^= data[i];
+	// Keep the frame in one piece if it fits at all
+	if (m->tx_len + hdr_len + len + 1 > sizeof(m->tx_buf)) {
+		msp_flush(m);
 	}
-	cs ^= 0;
 
-	buf[0] = cs;
-	PIOS_COM_SendBuffer(m->com, buf, 1);
+	msp_queue(m, buf, hdr_len);
+	msp_queue(m, data, len);
+	msp_queue(m, &cs, 1);
+}
+
+static void msp_send_error(struct msp_bridge *m, uint16_t cmd)
+{
+	msp_queue_frame(m, m->v2 ? '!' : '|', cmd, NULL, 0);
+}
+
+static void msp_send(struct msp_bridge *m, uint16_t cmd, const uint8_t *data, size_t len)
+{
+	msp_queue_frame(m, '>', cmd, data, len);
 }
 
 static msp_state msp_state_size(struct msp_bridge *m, uint8_t b)
 {
+	m->v2 = false;
 	m->cmd_size = b;
 	m->checksum = b;
 	return MSP_HEADER_CMD;
@@ -287,10 +346,46 @@ static msp_state msp_state_cmd(struct msp_bridge *m, uint8_t b)
 	return m->cmd_size == 0 ? MSP_CHECKSUM : MSP_FILLBUF;
 }
 
+static msp_state msp_state_v2_header(struct msp_bridge *m, uint8_t b)
+{
+	m->checksum = PIOS_CRC_updateCRC_TBS(m->checksum, &b, 1);
+
+	switch (m->state) {
+	case MSP_V2_FLAG:
+		return MSP_V2_CMD_LO;
+	case MSP_V2_CMD_LO:
+		m->cmd_id = b;
+		return MSP_V2_CMD_HI;
+	case MSP_V2_CMD_HI:
+		m->cmd_id |= b << 8;
+		return MSP_V2_SIZE_LO;
+	case MSP_V2_SIZE_LO:
+		m->cmd_size = b;
+		return MSP_V2_SIZE_HI;
+	case MSP_V2_SIZE_HI:
+		m->cmd_size |= b << 8;
+		m->cmd_i = 0;
+
+		if (m->cmd_size > sizeof(m->cmd_data)) {
+			return MSP_DISCARD;
+		}
+
+		return m->cmd_size == 0 ? MSP_CHECKSUM : MSP_FILLBUF;
+	default:
+		return MSP_IDLE;
+	}
+}
+
 static msp_state msp_state_fill_buf(struct msp_bridge *m, uint8_t b)
 {
 	m->cmd_data.data[m->cmd_i++] = b;
-	m->checksum ^= b;
+
+	if (m->v2) {
+		m->checksum = PIOS_CRC_updateCRC_TBS(m->checksum, &b, 1);
+	} else {
+		m->checksum ^= b;
+	}
+
 	return m->cmd_i == m->cmd_size ? MSP_CHECKSUM : MSP_FILLBUF;
 }
 
@@ -1067,6 +1162,12 @@ static msp_state msp_state_checksum(struct msp_bridge *m, uint8_t b)
 		return MSP_IDLE;
 	}
 
+	// v2 commands past the v1 range aren't anything we know
+	if (m->cmd_id > 0xff) {
+		msp_send_error(m, m->cmd_id);
+		return MSP_IDLE;
+	}
+
 	// Respond to interesting things.
 	switch (m->cmd_id) {
 	case MSP_API_VERSION:
@@ -1183,11 +1284,36 @@ static void msp_receive_byte(struct msp_bridge *m, uint8_t b)
 		}
 		break;
 	case MSP_HEADER_START:
-		m->state = b == 'M' ? MSP_HEADER_M : MSP_IDLE;
+		switch (b) {
+		case 'M':
+			m->state = MSP_HEADER_M;
+			break;
+		case 'X':
+			m->state = MSP_HEADER_X;
+			break;
+		default:
+			m->state = MSP_IDLE;
+		}
 		break;
 	case MSP_HEADER_M:
 		m->state = b == '<' ? MSP_HEADER_SIZE : MSP_IDLE;
 		break;
+	case MSP_HEADER_X:
+		if (b == '<') {
+			m->v2 = true;
+			m->checksum = 0;
+			m->state = MSP_V2_FLAG;
+		} else {
+			m->state = MSP_IDLE;
+		}
+		break;
+	case MSP_V2_FLAG:
+	case MSP_V2_CMD_LO:
+	case MSP_V2_CMD_HI:
+	case MSP_V2_SIZE_LO:
+	case MSP_V2_SIZE_HI:
+		m->state = msp_state_v2_header(m, b);
+		break;
 	case MSP_HEADER_SIZE:
 		m->state = msp_state_size(m, b);
 		break;
@@ -1295,15 +1421,30 @@ static void uavoMSPBridgeTask(void *parameters)
 		case MSP_HANDLER_MSP:
 			(void) 0;
 
-			uint8_t b = 0;
+			uint8_t b[MSP_RX_CHUNK];
 
+			// Wait for something to arrive, then take whatever
+			// else is already waiting so that a burst of polls
+			// is answered with one transmit.
 			uint16_t count =
-				PIOS_COM_ReceiveBuffer(msp->com, &b, 1, 3000);
+				PIOS_COM_ReceiveBuffer(msp->com, b, 1, 3000);
 
 			if (count) {
-				msp_receive_byte(msp, b);
+				count += PIOS_COM_ReceiveBuffer(msp->com,
+						b + 1, sizeof(b) - 1, 0);
+			}
+
+			for (uint16_t i = 0; i < count; i++) {
+				msp_receive_byte(msp, b[i]);
+
+				// Port was handed to telemetry or 4way
+				if (msp->handler != MSP_HANDLER_MSP) {
+					break;
+				}
 			}
 
+			msp_flush(msp);
+
 			break;
 
 #ifdef PIOS_INCLUDE_4WAY
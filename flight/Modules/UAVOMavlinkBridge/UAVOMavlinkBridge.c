@@ -47,6 +47,9 @@
 #include "systemstats.h"
 #include "homelocation.h"
 #include "baroaltitude.h"
+
+// Only the one link is ever parsed; keep the library to one rx buffer
+#define MAVLINK_COMM_NUM_BUFFERS 1
 #include "mavlink.h"
 #include "pios_thread.h"
 #include "pios_modules.h"
@@ -60,6 +63,8 @@
 
 static void uavoMavlinkBridgeTask(void *parameters);
 static bool stream_trigger(enum MAV_DATA_STREAM stream_num);
+static void stream_watch(UAVObjHandle obj, enum MAV_DATA_STREAM stream_num);
+static void receive_requests(void);
 
 // ****************
 // Private constants
@@ -73,7 +78,13 @@ static bool stream_trigger(enum MAV_DATA_STREAM stream_num);
 #define TASK_PRIORITY               PIOS_THREAD_PRIO_LOW
 #define TASK_RATE_HZ				10
 
-static const uint8_t mav_rates[] =
+//! Streams whose objects haven't changed are still resent this often
+#define STREAM_KEEPALIVE_TICKS		TASK_RATE_HZ
+
+#define RX_CHUNK					16
+
+//! Default rates, in Hz; the ground station may change these
+static uint8_t mav_rates[] =
 	 { [MAV_DATA_STREAM_RAW_SENSORS]=0x02, //2Hz
 	   [MAV_DATA_STREAM_EXTENDED_STATUS]=0x02, //2Hz
 	   [MAV_DATA_STREAM_RC_CHANNELS]=0x05, //5Hz
@@ -94,8 +105,16 @@ static bool module_enabled = false;
 
 static uint8_t * stream_ticks;
 
+//! Set by UAVO callbacks when something a stream reports has changed
+static volatile uint8_t * stream_dirty;
+
+//! Ticks since each stream was last sent
+static uint8_t * stream_idle;
+
 static mavlink_message_t *mav_msg;
 
+static mavlink_message_t *rx_msg;
+
 static void updateSettings();
 
 /**
@@ -127,10 +146,19 @@ static int32_t uavoMavlinkBridgeInitialize(void) {
 
 		mav_msg = PIOS_malloc(sizeof(*mav_msg));
 		stream_ticks = PIOS_malloc_no_dma(MAXSTREAMS);
+		stream_dirty = PIOS_malloc_no_dma(MAXSTREAMS);
+		stream_idle = PIOS_malloc_no_dma(MAXSTREAMS);
 
-		if (mav_msg && stream_ticks) {
+		// Only needed if the port can hear the ground station
+		if (mavlink_port != PIOS_COM_GPS)
+			rx_msg = PIOS_malloc_no_dma(sizeof(*rx_msg));
+
+		if (mav_msg && stream_ticks && stream_dirty && stream_idle) {
 			for (int x = 0; x < MAXSTREAMS; ++x) {
-				stream_ticks[x] = (TASK_RATE_HZ / mav_rates[x]);
+				stream_ticks[x] = mav_rates[x] ?
+					(TASK_RATE_HZ / mav_rates[x]) : 0;
+				stream_dirty[x] = 1;
+				stream_idle[x] = 0;
 			}
 
 			module_enabled = true;
@@ -167,9 +195,25 @@ static void uavoMavlinkBridgeTask(void *parameters) {
 
 	SystemStatsData systemStats;
 
+	// Objects are all registered by now; have them tell us when the
+	// data behind each stream changes, so unchanged data isn't resent.
+	stream_watch(FlightBatteryStateHandle(), MAV_DATA_STREAM_EXTENDED_STATUS);
+	stream_watch(SystemStatsHandle(), MAV_DATA_STREAM_EXTENDED_STATUS);
+	stream_watch(ManualControlCommandHandle(), MAV_DATA_STREAM_RC_CHANNELS);
+	stream_watch(GPSPositionHandle(), MAV_DATA_STREAM_POSITION);
+	stream_watch(HomeLocationHandle(), MAV_DATA_STREAM_POSITION);
+	stream_watch(AttitudeActualHandle(), MAV_DATA_STREAM_EXTRA1);
+	stream_watch(ActuatorDesiredHandle(), MAV_DATA_STREAM_EXTRA2);
+	stream_watch(AttitudeActualHandle(), MAV_DATA_STREAM_EXTRA2);
+	stream_watch(AirspeedActualHandle(), MAV_DATA_STREAM_EXTRA2);
+	stream_watch(BaroAltitudeHandle(), MAV_DATA_STREAM_EXTRA2);
+	stream_watch(FlightStatusHandle(), MAV_DATA_STREAM_EXTRA2);
+
 	while (1) {
 		PIOS_Thread_Sleep_Until(&lastSysTime, 1000 / TASK_RATE_HZ);
 
+		receive_requests();
+
 		if (stream_trigger(MAV_DATA_STREAM_EXTENDED_STATUS)) {
 			FlightBatteryStateData batState = {};
 
@@ -470,6 +514,11 @@ static void uavoMavlinkBridgeTask(void *parameters) {
 	}
 }
 
+/**
+ * Decides whether a stream is due.  A stream is sent at its rate, but only
+ * when one of the objects behind it has changed since it was last sent, or
+ * when it has gone STREAM_KEEPALIVE_TICKS without being sent at all.
+ */
 static bool stream_trigger(enum MAV_DATA_STREAM stream_num) {
 	uint8_t rate = (uint8_t) mav_rates[stream_num];
 
@@ -477,20 +526,98 @@ static bool stream_trigger(enum MAV_DATA_STREAM stream_num) {
 		return false;
 	}
 
+	if (stream_idle[stream_num] < STREAM_KEEPALIVE_TICKS) {
+		stream_idle[stream_num]++;
+	}
+
 	if (stream_ticks[stream_num] == 0) {
 		// we're triggering now, setup the next trigger point
 		if (rate > TASK_RATE_HZ) {
 			rate = TASK_RATE_HZ;
 		}
 		stream_ticks[stream_num] = (TASK_RATE_HZ / rate);
+
+		if (!stream_dirty[stream_num] &&
+				stream_idle[stream_num] < STREAM_KEEPALIVE_TICKS) {
+			return false;
+		}
+
+		stream_dirty[stream_num] = 0;
+		stream_idle[stream_num] = 0;
 		return true;
 	}
 
-	// count down at 50Hz
+	// count down at TASK_RATE_HZ
 	stream_ticks[stream_num]--;
 	return false;
 }
 
+static void stream_watch(UAVObjHandle obj, enum MAV_DATA_STREAM stream_num)
+{
+	if (obj == NULL)
+		return;
+
+	UAVObjConnectCallback(obj, UAVObjCbSetFlag,
+			(void *) &stream_dirty[stream_num], EV_MASK_ALL_UPDATES);
+}
+
+/**
+ * Applies a REQUEST_DATA_STREAM from the ground station: the requested rate
+ * for one stream, or for all of them.
+ */
+static void handle_request_data_stream(const mavlink_message_t *msg)
+{
+	mavlink_request_data_stream_t req;
+
+	mavlink_msg_request_data_stream_decode(msg, &req);
+
+	uint16_t rate = req.start_stop ? req.req_message_rate : 0;
+
+	if (rate > TASK_RATE_HZ) {
+		rate = TASK_RATE_HZ;
+	}
+
+	for (int x = 0; x < MAXSTREAMS; ++x) {
+		if (req.req_stream_id != MAV_DATA_STREAM_ALL &&
+				req.req_stream_id != x) {
+			continue;
+		}
+
+		mav_rates[x] = rate;
+		stream_ticks[x] = 0;
+		stream_dirty[x] = 1;
+	}
+}
+
+/**
+ * Takes whatever the ground station has sent since the last tick.
+ */
+static void receive_requests(void)
+{
+	if (rx_msg == NULL)
+		return;
+
+	uint8_t buf[RX_CHUNK];
+	uint16_t count;
+
+	while ((count = PIOS_COM_ReceiveBuffer(mavlink_port, buf,
+					sizeof(buf), 0)) > 0) {
+		for (uint16_t i = 0; i < count; i++) {
+			mavlink_status_t status;
+
+			if (!mavlink_parse_char(MAVLINK_COMM_0, buf[i],
+						rx_msg, &status))
+				continue;
+
+			switch (rx_msg->msgid) {
+			case MAVLINK_MSG_ID_REQUEST_DATA_STREAM:
+				handle_request_data_stream(rx_msg);
+				break;
+			}
+		}
+	}
+}
+
 static void updateSettings()
 {
 	
@@ -34,16 +34,22 @@
  * This module executes on a timer trigger. When the module is
  * triggered it will update the data of VibrationAnalysiOutput,
  * with the accumulated accelerometer samples. 
+ *
+ * In spectrum mode the FFT is instead done on board over windows that
+ * overlap by half, and only the binned magnitudes and strongest peaks
+ * are published in @ref VibrationAnalysisSpectrum.
  */
 
 #include "openpilot.h"
 #include "physical_constants.h"
 #include "pios_thread.h"
 #include "pios_queue.h"
+#include "fft.h"
 
 #include "accels.h"
 #include "modulesettings.h"
 #include "vibrationanalysisoutput.h"
+#include "vibrationanalysisspectrum.h"
 #include "vibrationanalysissettings.h"
 
 
@@ -67,6 +73,11 @@
 
 #define MAX_WINDOW_SIZE 1024
 
+#define MAX_SPECTRUM_LOG2N 8
+#define MAX_SPECTRUM_WINDOW_SIZE (1 << MAX_SPECTRUM_LOG2N) // Larger windows are clamped in spectrum mode
+#define SPECTRUM_BINS VIBRATIONANALYSISSPECTRUM_X_NUMELEM
+#define SPECTRUM_PEAKS VIBRATIONANALYSISSPECTRUM_PEAKFREQUENCY_NUMELEM
+
 // Comment for larger smaller buffers and much better accuracy. The maximum window size will be allocated.
 #define USE_SINGLE_INSTANCE_BUFFERS 1
 
@@ -96,11 +107,29 @@ static struct VibrationAnalysis_data {
 	int16_t *accel_buffer_x;
 	int16_t *accel_buffer_y;
 	int16_t *accel_buffer_z;
+
+	bool spectrum_mode;
 } *vtd;
 
+// Spectrum mode buffers, allocated for the largest window the first time
+// spectrum mode is used. Kept apart from vtd, which is cleared whenever
+// the window size changes.
+static struct VibrationAnalysis_spectrum {
+	int16_t *samples;  // [x window][y window][z window]
+	float *work;       // FFT_N interleaved re/im pairs
+	float *twiddle;
+	float *magnitude;  // Summed over axes, window / 2 bins
+	uint8_t twiddle_log2n;
+
+	VibrationAnalysisSpectrumData spectrum; // Too large for the task stack
+
+} *vsd;
+
 
 // Private functions
 static void VibrationAnalysisTask(void *parameters);
+static int32_t VibrationAnalysisSpectrumAlloc(void);
+static void VibrationAnalysisComputeSpectrum(float sample_rate);
 
 /*
 *   Releases any memory dinamically allocated
@@ -193,6 +222,20 @@ static int32_t VibrationAnalysisStart(void)
             break;
     }
 
+    VibrationAnalysisSettingsOutputModeOptions output_mode;
+    VibrationAnalysisSettingsOutputModeGet(&output_mode);
+    bool spectrum_mode = (output_mode == VIBRATIONANALYSISSETTINGS_OUTPUTMODE_SPECTRUM);
+
+    if (spectrum_mode) {
+        if (VibrationAnalysisSpectrumAlloc() != 0) {
+            VibrationAnalysisCleanup();
+            return -1;
+        }
+
+        if (window_size > MAX_SPECTRUM_WINDOW_SIZE)
+            window_size = MAX_SPECTRUM_WINDOW_SIZE;
+    }
+
     // Is the new window size different?
     // Will happen upon initialization and when the window size changes
     if (window_size != vtd->window_size) {
@@ -284,6 +327,8 @@ static int32_t VibrationAnalysisStart(void)
         }
     }
     
+    vtd->spectrum_mode = spectrum_mode;
+
     // Start main task
     if (taskHandle == NULL) {
         taskHandle = PIOS_Thread_Create(VibrationAnalysisTask, "VibrationAnalysis", STACK_SIZE_BYTES, NULL, TASK_PRIORITY);
@@ -320,7 +365,8 @@ static int32_t VibrationAnalysisInitialize(void)
 		return -1;
 
 	// Initialize UAVOs
-	if (VibrationAnalysisSettingsInitialize() == -1 || VibrationAnalysisOutputInitialize() == -1) {
+	if (VibrationAnalysisSettingsInitialize() == -1 || VibrationAnalysisOutputInitialize() == -1 ||
+			VibrationAnalysisSpectrumInitialize() == -1) {
         module_enabled = false;
         return -1;
     }
@@ -382,10 +428,17 @@ static void VibrationAnalysisTask(void *parameters)
             sampleRate_ms = sampleRate_ms > 0 ? sampleRate_ms : 1; //Ensure sampleRate never is 0.
             
             //Reconfigure any parameter
+            uint16_t old_window_size = vtd->window_size;
+            bool old_spectrum_mode = vtd->spectrum_mode;
+
             VibrationAnalysisStart();
             
             vibrationAnalysisOutputData.samples = vtd->window_size;
 
+            // Overlapping spectrum windows keep half a window around
+            if (vtd->window_size != old_window_size || vtd->spectrum_mode != old_spectrum_mode)
+                sample_count = 0;
+
             lastSettingsUpdateTime = PIOS_Thread_Systime();
 
             runningAcquisition = 1;
@@ -429,10 +482,10 @@ static void VibrationAnalysisTask(void *parameters)
         vtd->accels_static_bias_y = alpha*accels_avg_y + (1-alpha)*vtd->accels_static_bias_y;
         vtd->accels_static_bias_z = alpha*accels_avg_z + (1-alpha)*vtd->accels_static_bias_z;
         
-        // Add averaged values to the buffer, and remove DC bias.
-        vtd->accel_buffer_x[sample_count] = (accels_avg_x - vtd->accels_static_bias_x)*FLOAT_TO_FIXED;
-        vtd->accel_buffer_y[sample_count] = (accels_avg_y - vtd->accels_static_bias_y)*FLOAT_TO_FIXED;
-        vtd->accel_buffer_z[sample_count] = (accels_avg_z - vtd->accels_static_bias_z)*FLOAT_TO_FIXED;
+        // Remove DC bias and convert to fixed point
+        int16_t accel_fixed_x = (accels_avg_x - vtd->accels_static_bias_x)*FLOAT_TO_FIXED;
+        int16_t accel_fixed_y = (accels_avg_y - vtd->accels_static_bias_y)*FLOAT_TO_FIXED;
+        int16_t accel_fixed_z = (accels_avg_z - vtd->accels_static_bias_z)*FLOAT_TO_FIXED;
         
         //Reset the accumulators
         vtd->accels_data_sum_x = 0;
@@ -440,6 +493,34 @@ static void VibrationAnalysisTask(void *parameters)
         vtd->accels_data_sum_z = 0;
         vtd->accels_sum_count = 0;
 
+        if (vtd->spectrum_mode) {
+            uint16_t window_size = vtd->window_size;
+
+            vsd->samples[sample_count] = accel_fixed_x;
+            vsd->samples[window_size + sample_count] = accel_fixed_y;
+            vsd->samples[2 * window_size + sample_count] = accel_fixed_z;
+
+            if (++sample_count < window_size)
+                continue;
+
+            VibrationAnalysisComputeSpectrum(1000.0f / sampleRate_ms);
+
+            // Keep the newer half for the next, overlapping window
+            for (int axis = 0; axis < 3; axis++) {
+                int16_t *buf = vsd->samples + axis * window_size;
+                memmove(buf, buf + window_size / 2, window_size / 2 * sizeof(*buf));
+            }
+
+            sample_count = window_size / 2;
+            runningAcquisition = 0;
+            continue;
+        }
+
+        // Add values to the buffer
+        vtd->accel_buffer_x[sample_count] = accel_fixed_x;
+        vtd->accel_buffer_y[sample_count] = accel_fixed_y;
+        vtd->accel_buffer_z[sample_count] = accel_fixed_z;
+
         // Advance sample and reset when at buffer end
         sample_count++;
 
@@ -488,6 +569,107 @@ static void VibrationAnalysisTask(void *parameters)
     }
 }
 
+/**
+ * Allocate the spectrum mode buffers, once, for the largest window
+ * \return 0 on success, -1 if out of memory
+ */
+static int32_t VibrationAnalysisSpectrumAlloc(void)
+{
+    if (vsd != NULL)
+        return 0;
+
+    struct VibrationAnalysis_spectrum *s = PIOS_malloc(sizeof(*s));
+    if (s == NULL)
+        return -1;
+
+    memset(s, 0, sizeof(*s));
+
+    s->samples = PIOS_malloc(3 * MAX_SPECTRUM_WINDOW_SIZE * sizeof(*s->samples));
+    s->work = PIOS_malloc(2 * MAX_SPECTRUM_WINDOW_SIZE * sizeof(*s->work));
+    s->twiddle = PIOS_malloc(MAX_SPECTRUM_WINDOW_SIZE * sizeof(*s->twiddle));
+    s->magnitude = PIOS_malloc(MAX_SPECTRUM_WINDOW_SIZE / 2 * sizeof(*s->magnitude));
+
+    if (s->samples == NULL || s->work == NULL || s->twiddle == NULL || s->magnitude == NULL)
+        return -1;
+
+    vsd = s;
+
+    return 0;
+}
+
+/**
+ * Transform the current window of each axis and publish the binned
+ * magnitudes and strongest peaks
+ * \param[in] sample_rate Rate the window was sampled at [Hz]
+ */
+static void VibrationAnalysisComputeSpectrum(float sample_rate)
+{
+    uint16_t window_size = vtd->window_size;
+    uint8_t log2n = 0;
+    while ((1 << log2n) < window_size)
+        log2n++;
+
+    if (vsd->twiddle_log2n != log2n) {
+        fft_twiddle_create(vsd->twiddle, log2n);
+        vsd->twiddle_log2n = log2n;
+    }
+
+    uint16_t num_bins = window_size / 2;
+    uint16_t group = num_bins > SPECTRUM_BINS ? num_bins / SPECTRUM_BINS : 1;
+
+    // Hann window sums to N/2, and the one-sided spectrum doubles it again
+    float to_amplitude = 4.0f / (window_size * FLOAT_TO_FIXED);
+
+    VibrationAnalysisSpectrumData *spectrum = &vsd->spectrum;
+    memset(spectrum, 0, sizeof(*spectrum));
+    memset(vsd->magnitude, 0, num_bins * sizeof(*vsd->magnitude));
+
+    uint16_t *out[3] = { spectrum->x, spectrum->y, spectrum->z };
+
+    for (int axis = 0; axis < 3; axis++) {
+        const int16_t *buf = vsd->samples + axis * window_size;
+
+        for (uint16_t i = 0; i < window_size; i++) {
+            uint16_t dst = 2 * fft_bitrev(i, log2n);
+            vsd->work[dst] = buf[i] * fft_hann(vsd->twiddle, log2n, i);
+            vsd->work[dst + 1] = 0;
+        }
+
+        fft_run(vsd->work, vsd->twiddle, log2n);
+
+        for (uint16_t b = 0; b < num_bins; b++) {
+            float re = vsd->work[2 * b];
+            float im = vsd->work[2 * b + 1];
+            float mag = sqrtf(re * re + im * im) * to_amplitude;
+
+            vsd->magnitude[b] += mag;
+
+            // Each band reports the largest bin it covers
+            uint16_t band = b / group;
+            float fixed = mag * FLOAT_TO_FIXED;
+            if (band < SPECTRUM_BINS && fixed > out[axis][band])
+                out[axis][band] = fixed < UINT16_MAX ? fixed : UINT16_MAX;
+        }
+    }
+
+    // Skip the bins next to DC, which the bias removal leaves behind
+    float peak_bin[SPECTRUM_PEAKS];
+    float peak_mag[SPECTRUM_PEAKS];
+    uint8_t found = fft_find_peaks(vsd->magnitude, 2, num_bins - 2, 0,
+            SPECTRUM_PEAKS, peak_bin, peak_mag);
+
+    for (uint8_t i = 0; i < found; i++) {
+        spectrum->peakfrequency[i] = peak_bin[i] * sample_rate / window_size;
+        spectrum->peakmagnitude[i] = peak_mag[i];
+    }
+
+    spectrum->scale = FLOAT_TO_FIXED;
+    spectrum->binwidth = group * sample_rate / window_size;
+    spectrum->samples = window_size;
+
+    VibrationAnalysisSpectrumSet(spectrum);
+}
+
 /**
  * @}
  * @}
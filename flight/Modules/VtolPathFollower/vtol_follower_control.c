@@ -58,6 +58,7 @@
 #include "velocitydesired.h"
 #include "velocityactual.h"
 #include "vtolpathfollowersettings.h"
+#include "waypoint.h"
 #include "systemsettings.h"
 
 // Private variables
@@ -70,9 +71,73 @@ static float vtol_path_m=0, vtol_path_r=0, vtol_end_m=0, vtol_end_r=0;
 // Time constants converted to IIR parameter
 static float loiter_brakealpha=0.96f, loiter_errordecayalpha=0.88f;
 
+// What the last guidance update asked of the velocity controller, so that
+// it can carry on between guidance updates
+static bool velocity_loop_engaged;
+static float velocity_loop_att_adj[2];
+
 static int32_t vtol_follower_control_impl(
 	const float *hold_pos_ned, float alt_rate, bool update_status);
 
+/**
+ * Near the end of a straight waypoint leg, turn the path direction towards
+ * the leg after it, so the corner is flown as a curve.  The blend stops at
+ * half way between the two so that the leg still completes.
+ * @param[in] pathDesired the leg being flown
+ * @param[in,out] progress progress along it, whose direction is blended
+ */
+static void blend_next_leg(const PathDesiredData *pathDesired,
+	struct path_status *progress)
+{
+	const float blend = vtol_guidanceSettings.PathCornerBlend;
+
+	if (pathDesired->Mode != PATHDESIRED_MODE_VECTOR ||
+			pathDesired->Waypoint < 0 ||
+			progress->distance_remaining >= blend ||
+			WaypointHandle() == NULL) {
+		return;
+	}
+
+	uint16_t next = pathDesired->Waypoint + 1;
+
+	if (next >= UAVObjGetNumInstances(WaypointHandle())) {
+		return;
+	}
+
+	const WaypointData *wp = WaypointInstBorrow(next);
+
+	if (!wp) {
+		return;
+	}
+
+	bool straight = (wp->Mode == WAYPOINT_MODE_VECTOR) ||
+		(wp->Mode == WAYPOINT_MODE_ENDPOINT);
+	float next_dir[2] = {
+		wp->Position[WAYPOINT_POSITION_NORTH] - pathDesired->End[0],
+		wp->Position[WAYPOINT_POSITION_EAST] - pathDesired->End[1] };
+
+	WaypointRelease();
+
+	float next_len = vectorn_magnitude(next_dir, 2);
+
+	if (!straight || next_len < 1e-3f) {
+		return;
+	}
+
+	float w = 0.5f * (1 - MAX(progress->distance_remaining, 0) / blend);
+
+	float dir[2] = {
+		progress->path_direction[0] * (1 - w) + next_dir[0] / next_len * w,
+		progress->path_direction[1] * (1 - w) + next_dir[1] / next_len * w };
+	float len = vectorn_magnitude(dir, 2);
+
+	// Legs that double back leave nothing to blend
+	if (len > 1e-3f) {
+		progress->path_direction[0] = dir[0] / len;
+		progress->path_direction[1] = dir[1] / len;
+	}
+}
+
 /**
  * Compute desired velocity to follow the desired path from the current location.
  * @param[in] dT the time since last evaluation
@@ -142,6 +207,10 @@ int32_t vtol_follower_control_path(const PathDesiredData *pathDesired,
 		return vtol_follower_control_impl(pathDesired->End, 0, false);
 	}
 	
+	if (vtol_guidanceSettings.PathCornerBlend > 0) {
+		blend_next_leg(pathDesired, progress);
+	}
+
 	// Interpolate desired velocity and altitude along the path
 	float groundspeed = interpolate_value(progress->fractional_progress,
 	    pathDesired->StartingVelocity, pathDesired->EndingVelocity);
@@ -334,8 +403,10 @@ int32_t vtol_follower_control_altrate(const float *hold_pos_ned,
 /**
  * Compute the desired acceleration based on the desired
  * velocity and actual velocity
+ * @param[in] dT the time since the last guidance update
+ * @param[in] guidance_step whether VelocityDesired was just recomputed
  */
-static int32_t vtol_follower_control_accel(float dT)
+static int32_t vtol_follower_control_accel(float dT, bool guidance_step)
 {
 	VelocityDesiredData velocityDesired;
 	VelocityActualData velocityActual;
@@ -348,17 +419,24 @@ static int32_t vtol_follower_control_accel(float dT)
 
 	static float last_north_velocity;
 	static float last_east_velocity;
+	static float north_change, east_change;
 
 	NedAccelGet(&nedAccel);
 	VelocityActualGet(&velocityActual);
 	VelocityDesiredGet(&velocityDesired);
 	
-	// Optionally compute the acceleration required component from a changing velocity desired
-	if (vtol_guidanceSettings.VelocityChangePrediction == VTOLPATHFOLLOWERSETTINGS_VELOCITYCHANGEPREDICTION_TRUE && dT > 0) {
-		north_acceleration = (velocityDesired.North - last_north_velocity) / dT;
-		east_acceleration = (velocityDesired.East - last_east_velocity) / dT;
-		last_north_velocity = velocityDesired.North;
-		last_east_velocity = velocityDesired.East;
+	// Optionally compute the acceleration required component from a changing velocity desired.
+	// VelocityDesired only moves at guidance updates, so keep the rate it changed at until the next.
+	if (vtol_guidanceSettings.VelocityChangePrediction == VTOLPATHFOLLOWERSETTINGS_VELOCITYCHANGEPREDICTION_TRUE) {
+		if (guidance_step && dT > 0) {
+			north_change = (velocityDesired.North - last_north_velocity) / dT;
+			east_change = (velocityDesired.East - last_east_velocity) / dT;
+			last_north_velocity = velocityDesired.North;
+			last_east_velocity = velocityDesired.East;
+		}
+
+		north_acceleration = north_change;
+		east_acceleration = east_change;
 	} else {
 		north_acceleration = 0;
 		east_acceleration = 0;
@@ -439,22 +517,18 @@ static float vtol_follower_control_altitude(float downCommand) {
 
 /**
  * Compute desired attitude from the desired velocity
- * @param[in] dT the time since last evaluation
+ * @param[in] dT the time since the last guidance update
  * @param[in] att_adj an adjustment to the attitude for loiter mode
+ * @param[in] guidance_step whether VelocityDesired was just recomputed
  *
  * Takes in @ref NedActual which has the acceleration in the
  * NED frame as the feedback term and then compares the
  * @ref VelocityActual against the @ref VelocityDesired
  */
-int32_t vtol_follower_control_attitude(float dT, const float *att_adj)
+static int32_t vtol_follower_control_attitude_impl(float dT,
+		const float *att_adj, bool guidance_step)
 {
-	vtol_follower_control_accel(dT);
-
-	float default_adj[2] = {0,0};
-
-	if (!att_adj) {
-		att_adj = default_adj;
-	}
+	vtol_follower_control_accel(dT, guidance_step);
 
 	AccelDesiredData accelDesired;
 	AccelDesiredGet(&accelDesired);
@@ -542,6 +616,48 @@ int32_t vtol_follower_control_attitude(float dT, const float *att_adj)
 	return 0;
 }
 
+/**
+ * Compute desired attitude from the desired velocity just computed by
+ * guidance, and keep doing so with vtol_follower_control_velocity() until
+ * the next guidance update.
+ * @param[in] dT the time since last evaluation
+ * @param[in] att_adj an adjustment to the attitude for loiter mode
+ */
+int32_t vtol_follower_control_attitude(float dT, const float *att_adj)
+{
+	velocity_loop_att_adj[0] = att_adj ? att_adj[0] : 0;
+	velocity_loop_att_adj[1] = att_adj ? att_adj[1] : 0;
+	velocity_loop_engaged = true;
+
+	return vtol_follower_control_attitude_impl(dT, velocity_loop_att_adj,
+			true);
+}
+
+/**
+ * Mark the start of a guidance update.  Unless it ends up commanding an
+ * attitude, the velocity controller stays idle until the next one.
+ */
+void vtol_follower_control_guidance_start()
+{
+	velocity_loop_engaged = false;
+}
+
+/**
+ * Run the velocity controller alone, between guidance updates, against the
+ * latest @ref VelocityActual from the INS and the @ref VelocityDesired and
+ * attitude adjustment the last guidance update left.
+ * @return 0 if an attitude was commanded, -1 if guidance isn't flying
+ */
+int32_t vtol_follower_control_velocity()
+{
+	if (!velocity_loop_engaged) {
+		return -1;
+	}
+
+	return vtol_follower_control_attitude_impl(0, velocity_loop_att_adj,
+			false);
+}
+
 static float loiter_deadband(float input, float threshold, float expoPercent) {
 	if (input > threshold) {
 		input -= threshold;
@@ -720,19 +836,27 @@ void vtol_follower_control_settings_updated()
 
 	vtol_dT = vtol_guidanceSettings.UpdatePeriod / 1000.0f;
 
+	// The velocity controller may run faster than guidance
+	if ((vtol_guidanceSettings.VelocityUpdatePeriod > 0) &&
+			(vtol_guidanceSettings.VelocityUpdatePeriod < vtol_guidanceSettings.UpdatePeriod)) {
+		vtol_velocity_dT = vtol_guidanceSettings.VelocityUpdatePeriod / 1000.0f;
+	} else {
+		vtol_velocity_dT = vtol_dT;
+	}
+
 	// Configure the velocity control PID loops
 	pid_configure(&vtol_pids[NORTH_VELOCITY],
 		vtol_guidanceSettings.HorizontalVelPID[VTOLPATHFOLLOWERSETTINGS_HORIZONTALVELPID_KP], // Kp
 		vtol_guidanceSettings.HorizontalVelPID[VTOLPATHFOLLOWERSETTINGS_HORIZONTALVELPID_KI], // Ki
 		0, // Kd
 		vtol_guidanceSettings.HorizontalVelPID[VTOLPATHFOLLOWERSETTINGS_HORIZONTALVELPID_ILIMIT],
-		vtol_dT);
+		vtol_velocity_dT);
 	pid_configure(&vtol_pids[EAST_VELOCITY],
 		vtol_guidanceSettings.HorizontalVelPID[VTOLPATHFOLLOWERSETTINGS_HORIZONTALVELPID_KP], // Kp
 		vtol_guidanceSettings.HorizontalVelPID[VTOLPATHFOLLOWERSETTINGS_HORIZONTALVELPID_KI], // Ki
 		0, // Kd
 		vtol_guidanceSettings.HorizontalVelPID[VTOLPATHFOLLOWERSETTINGS_HORIZONTALVELPID_ILIMIT],
-		vtol_dT);
+		vtol_velocity_dT);
 
 	// Configure the position control (velocity output) PID loops
 	pid_configure(&vtol_pids[NORTH_POSITION],
@@ -753,7 +877,7 @@ void vtol_follower_control_settings_updated()
 	pid_configure(&vtol_pids[DOWN_POSITION], altitudeHoldSettings.PositionKp, 0, 0, 0, vtol_dT);
 	pid_configure(&vtol_pids[DOWN_VELOCITY],
 	              altitudeHoldSettings.VelocityKp, altitudeHoldSettings.VelocityKi,
-	              0, 1, vtol_dT);  // Note the ILimit here is 1 because we use this offset to set the throttle offset
+	              0, 1, vtol_velocity_dT);  // Note the ILimit here is 1 because we use this offset to set the throttle offset
 
 	// Calculate the constants used in the deadband calculation
 	cubic_deadband_setup(vtol_guidanceSettings.EndpointDeadbandWidth,
@@ -59,6 +59,7 @@ enum vtol_pid {
 
 extern VtolPathFollowerSettingsData vtol_guidanceSettings;
 extern float vtol_dT;
+extern float vtol_velocity_dT;
 
 // Control code public API methods
 int32_t vtol_follower_control_path(const PathDesiredData *pathDesired, struct path_status *progress);
@@ -66,6 +67,8 @@ int32_t vtol_follower_control_endpoint(const float *hold_pos_ned);
 int32_t vtol_follower_control_altrate(const float *hold_pos_ned,
 		float alt_adj);
 int32_t vtol_follower_control_attitude(const float dT, const float *att_adj);
+void vtol_follower_control_guidance_start();
+int32_t vtol_follower_control_velocity();
 int32_t vtol_follower_control_land(const float *hold_pos_ned, bool *landed);
 bool vtol_follower_control_loiter(float dT, float *hold_pos, float *att_adj,
 		float *alt_adj);
@@ -60,6 +60,7 @@
 
 VtolPathFollowerSettingsData vtol_guidanceSettings;
 float vtol_dT = 0.050f;
+float vtol_velocity_dT = 0.050f;
 
 // Private constants
 #define MAX_QUEUE_SIZE 4
@@ -162,10 +163,17 @@ static void vtolPathFollowerTask(void *parameters)
 	AltitudeHoldSettingsConnectCallbackCtx(UAVObjCbSetFlag,
 			&settings_updated);
 
+	// Velocity loop passes between guidance updates
+	uint32_t velocity_steps = 0;
+	uint32_t velocity_steps_per_guidance = 1;
+
 	// Main task loop
 	while (1) {
 		if (settings_updated) {
+			settings_updated = false;
 			vtol_follower_control_settings_updated();
+
+			velocity_steps_per_guidance = (uint32_t) (vtol_dT / vtol_velocity_dT + 0.5f);
 		}
 	
 		SystemSettingsGet(&systemSettings);
@@ -191,7 +199,7 @@ static void vtolPathFollowerTask(void *parameters)
 
 		// Make sure when flight mode toggles, to immediately update the path
 		UAVObjEvent ev;
-		PIOS_Queue_Receive(queue, &ev, vtol_guidanceSettings.UpdatePeriod);
+		PIOS_Queue_Receive(queue, &ev, vtol_velocity_dT * 1000.0f + 0.5f);
 		
 		static uint8_t last_flight_mode;
 		FlightStatusGet(&flightStatus);
@@ -202,6 +210,7 @@ static void vtolPathFollowerTask(void *parameters)
 			// The mode has changed
 
 			last_flight_mode = flightStatus.FlightMode;
+			velocity_steps = 0;
 
 			switch(flightStatus.FlightMode) {
 			case FLIGHTSTATUS_FLIGHTMODE_RETURNTOHOME:
@@ -231,7 +240,18 @@ static void vtolPathFollowerTask(void *parameters)
 		}
 
 		if (fsm_running) {
-			vtol_follower_fsm_update();
+			// Guidance runs at the position rate; in between, only
+			// the velocity controller, fed by the INS velocity.
+			if (velocity_steps == 0) {
+				vtol_follower_control_guidance_start();
+				vtol_follower_fsm_update();
+			} else {
+				vtol_follower_control_velocity();
+			}
+
+			if (++velocity_steps >= velocity_steps_per_guidance) {
+				velocity_steps = 0;
+			}
 		} else {
 			for (uint32_t i = 0; i < VTOL_PID_NUM; i++)
 				pid_zero(&vtol_pids[i]);
@@ -416,7 +416,8 @@ static int32_t PIOS_BMI160_ClaimBus()
 	if (PIOS_BMI160_Validate(dev) != 0)
 		return -1;
 
-	if (PIOS_SPI_ClaimBus(dev->spi_id) != 0)
+	/* Get in ahead of flash and OSD traffic on a shared bus */
+	if (PIOS_SPI_ClaimBusPriority(dev->spi_id) != 0)
 		return -2;
 
 	PIOS_SPI_RC_PinSet(dev->spi_id, dev->slave_num, 0);
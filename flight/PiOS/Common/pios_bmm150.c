@@ -35,7 +35,7 @@
 
 #include "pios_semaphore.h"
 #include "pios_thread.h"
-#include "pios_queue.h"
+#include "pios_spsc_queue.h"
 #include "physical_constants.h"
 #include "taskmonitor.h"
 
@@ -67,7 +67,7 @@ struct pios_bmm150_dev {
 	pios_spi_t spi_id;                      /**< Handle to the communication driver */
 	uint32_t spi_slave_mag;                 /**< The slave number (SPI) */
 
-	struct pios_queue *mag_queue;
+	struct pios_spsc_queue *mag_queue;
 
 	struct pios_thread *task_handle;
 
@@ -136,7 +136,7 @@ static struct pios_bmm150_dev *PIOS_BMM_Alloc(const struct pios_bmm150_cfg *cfg)
 
 	dev->magic = PIOS_BMM_DEV_MAGIC;
 
-	dev->mag_queue = PIOS_Queue_Create(PIOS_BMM_QUEUE_LEN, sizeof(struct pios_sensor_mag_data));
+	dev->mag_queue = PIOS_SPSC_Queue_Create(sizeof(struct pios_sensor_mag_data), PIOS_BMM_QUEUE_LEN, 1);
 	if (dev->mag_queue == NULL) {
 		PIOS_free(dev);
 		return NULL;
@@ -520,7 +520,7 @@ static void PIOS_BMM_Task(void *parameters)
 		mag_data.y *= mag_scale;
 		mag_data.z *= mag_scale;
 
-		PIOS_Queue_Send(bmm_dev->mag_queue, &mag_data, 0);
+		PIOS_SPSC_Queue_Send(bmm_dev->mag_queue, &mag_data, 1, NULL);
 
 		PIOS_Thread_Sleep(24);
 	}
@@ -104,6 +104,8 @@ struct bmp280_dev {
 	int16_t  digP9;
 
 	uint8_t oversampling;
+	//! What the sensor was last set running with, 0 if it needs setting
+	uint8_t running_oversampling;
 	enum pios_bmp280_dev_magic magic;
 
 	struct pios_semaphore *busy;
@@ -264,12 +266,26 @@ static int32_t PIOS_BMP280_StartADC(void)
 		return -1;
 
 	/* Start the conversion */
-	return(PIOS_BMP280_WriteCommand(BMP280_CTRL_MEAS,
-				dev->oversampling | BMP280_MODE_CONTINUOUS));
+	if (PIOS_BMP280_WriteCommand(BMP280_CTRL_MEAS,
+				dev->oversampling | BMP280_MODE_CONTINUOUS) != 0)
+		return -1;
+
+	dev->running_oversampling = dev->oversampling;
 
 	return 0;
 }
 
+/**
+ * @brief Change the oversampling; the sensor is set to it on the next read
+ */
+void PIOS_BMP280_SetOversampling(uint8_t oversampling)
+{
+	if (PIOS_BMP280_Validate(dev) != 0)
+		return;
+
+	dev->oversampling = oversampling;
+}
+
 /**
  * @brief Return the delay for the current osr
  */
@@ -290,7 +306,8 @@ static int32_t PIOS_BMP280_GetDelay() {
 
 /**
 * Read the ADC conversion value (once ADC conversion has completed)
-* \return 0 if successfully read the ADC, -1 if failed
+* \return 0 if successfully read the ADC, -1 if there was no good result,
+* -2 if the sensor could not be read
 */
 static int32_t PIOS_BMP280_ReadADC()
 {
@@ -302,7 +319,7 @@ static int32_t PIOS_BMP280_ReadADC()
 	/* Read and store results */
 
 	if (PIOS_BMP280_Read(BMP280_PRESS_MSB, data, 6) != 0)
-			return -1;
+			return -2;
 
 	static int32_t T = 0;
 
@@ -539,13 +556,20 @@ static bool PIOS_BMP280_callback(void *ctx, void *output,
 
 	int32_t read_adc_result = 0;
 
-	PIOS_BMP280_StartADC();
+	/* It runs continuously, so it only needs telling once, or again if
+	 * the oversampling changes or it stops answering */
+	if (dev->running_oversampling != dev->oversampling) {
+		PIOS_BMP280_StartADC();
+	}
 
 	PIOS_BMP280_ClaimDevice();
 	read_adc_result = PIOS_BMP280_ReadADC();
 	PIOS_BMP280_ReleaseDevice();
 
 	if (read_adc_result) {
+		if (read_adc_result == -2) {
+			dev->running_oversampling = 0;
+		}
 		return false;
 	}
 
@@ -38,11 +38,10 @@
 
 #if defined(PIOS_INCLUDE_COM)
 
-#include <circqueue.h>
 #include <pios_com_priv.h>
 #include "pios_delay.h"		/* PIOS_DELAY_WaitmS */
 
-#include "pios_semaphore.h"
+#include "pios_spsc_queue.h"
 #include "pios_mutex.h"
 
 enum pios_com_dev_magic {
@@ -54,14 +53,14 @@ struct pios_com_dev {
 	uintptr_t lower_id;
 	const struct pios_com_driver * driver;
 
-	struct pios_semaphore *tx_sem;
-	struct pios_semaphore *rx_sem;
 #if defined(PIOS_INCLUDE_RTOS)
 	struct pios_mutex *sendbuffer_mtx;
 #endif
 
-	circ_queue_t rx;
-	circ_queue_t tx;
+	/* The driver callbacks are the other end of both queues; waiters are
+	 * only signalled when they are actually blocked. */
+	struct pios_spsc_queue *rx;
+	struct pios_spsc_queue *tx;
 };
 
 static bool PIOS_COM_validate(struct pios_com_dev *com_dev)
@@ -83,8 +82,6 @@ static struct pios_com_dev *PIOS_COM_alloc(void)
 
 static uint16_t PIOS_COM_TxOutCallback(uintptr_t context, uint8_t * buf, uint16_t buf_len, uint16_t * headroom, bool * need_yield);
 static uint16_t PIOS_COM_RxInCallback(uintptr_t context, uint8_t * buf, uint16_t buf_len, uint16_t * headroom, bool * need_yield);
-static void PIOS_COM_UnblockRx(struct pios_com_dev *com_dev, bool * need_yield);
-static void PIOS_COM_UnblockTx(struct pios_com_dev *com_dev, bool * need_yield);
 
 /**
   * Initialises COM layer
@@ -113,12 +110,9 @@ int32_t PIOS_COM_Init(uintptr_t * com_id, const struct pios_com_driver * driver,
 	com_dev->tx = NULL;
 
 	if (rx_buffer_len) {
-		com_dev->rx = circ_queue_new(1, rx_buffer_len);
+		com_dev->rx = PIOS_SPSC_Queue_Create(1, rx_buffer_len - 1, 1);
 
 		if (!com_dev->rx) goto out_fail;
-#if defined(PIOS_INCLUDE_RTOS)
-		com_dev->rx_sem = PIOS_Semaphore_Create();
-#endif	/* PIOS_INCLUDE_RTOS */
 		(com_dev->driver->bind_rx_cb)(lower_id, PIOS_COM_RxInCallback, (uintptr_t)com_dev);
 		if (com_dev->driver->rx_start) {
 			/* Start the receiver */
@@ -128,11 +122,8 @@ int32_t PIOS_COM_Init(uintptr_t * com_id, const struct pios_com_driver * driver,
 	}
 
 	if (tx_buffer_len) {
-		com_dev->tx = circ_queue_new(1, tx_buffer_len);
+		com_dev->tx = PIOS_SPSC_Queue_Create(1, tx_buffer_len - 1, 1);
 		if (!com_dev->tx) goto out_fail;
-#if defined(PIOS_INCLUDE_RTOS)
-		com_dev->tx_sem = PIOS_Semaphore_Create();
-#endif	/* PIOS_INCLUDE_RTOS */
 		(com_dev->driver->bind_tx_cb)(lower_id, PIOS_COM_TxOutCallback, (uintptr_t)com_dev);
 	}
 #if defined(PIOS_INCLUDE_RTOS)
@@ -146,26 +137,6 @@ out_fail:
 	return(-1);
 }
 
-static void PIOS_COM_UnblockRx(struct pios_com_dev *com_dev, bool * need_yield)
-{
-#if defined(PIOS_INCLUDE_RTOS)
-	if (PIOS_IRQ_InISR() == true)
-		PIOS_Semaphore_Give_FromISR(com_dev->rx_sem, need_yield);
-	else
-		PIOS_Semaphore_Give(com_dev->rx_sem);
-#endif
-}
-
-static void PIOS_COM_UnblockTx(struct pios_com_dev *com_dev, bool * need_yield)
-{
-#if defined(PIOS_INCLUDE_RTOS)
-	if (PIOS_IRQ_InISR() == true)
-		PIOS_Semaphore_Give_FromISR(com_dev->tx_sem, need_yield);
-	else
-		PIOS_Semaphore_Give(com_dev->tx_sem);
-#endif
-}
-
 static uint16_t PIOS_COM_RxInCallback(uintptr_t context, uint8_t * buf, uint16_t buf_len, uint16_t * headroom, bool * need_yield)
 {
 	struct pios_com_dev *com_dev = (struct pios_com_dev *)context;
@@ -174,16 +145,11 @@ static uint16_t PIOS_COM_RxInCallback(uintptr_t context, uint8_t * buf, uint16_t
 	PIOS_Assert(valid);
 	PIOS_Assert(com_dev->rx);
 
-	uint16_t bytes_into_fifo = circ_queue_write_data(com_dev->rx,
-			buf, buf_len);
-
-	if (bytes_into_fifo > 0) {
-		/* Data has been added to the buffer */
-		PIOS_COM_UnblockRx(com_dev, need_yield);
-	}
+	uint16_t bytes_into_fifo = PIOS_SPSC_Queue_Send(com_dev->rx,
+			buf, buf_len, need_yield);
 
 	if (headroom) {
-		circ_queue_write_pos(com_dev->rx, NULL, headroom);
+		*headroom = PIOS_SPSC_Queue_Space(com_dev->rx);
 	}
 
 	return (bytes_into_fifo);
@@ -199,16 +165,11 @@ static uint16_t PIOS_COM_TxOutCallback(uintptr_t context, uint8_t * buf, uint16_
 	PIOS_Assert(buf_len);
 	PIOS_Assert(com_dev->tx);
 
-	uint16_t bytes_from_fifo = circ_queue_read_data(com_dev->tx,
-			buf, buf_len);
-
-	if (bytes_from_fifo > 0) {
-		/* More space has been made in the buffer */
-		PIOS_COM_UnblockTx(com_dev, need_yield);
-	}
+	uint16_t bytes_from_fifo = PIOS_SPSC_Queue_Receive(com_dev->tx,
+			buf, buf_len, 0, need_yield);
 
 	if (headroom) {
-		circ_queue_read_pos(com_dev->tx, NULL, headroom);
+		*headroom = PIOS_SPSC_Queue_Pending(com_dev->tx);
 	}
 
 	return (bytes_from_fifo);
@@ -265,7 +226,7 @@ static int32_t SendBufferNonBlockingImpl(uintptr_t com_id, const uint8_t *buffer
 		/* This call uses queue "reader" state, so it is required that
 		 * no one actually be reading the tx queue at the time or
 		 * undefined behavior may result */
-		circ_queue_clear(com_dev->tx);
+		PIOS_SPSC_Queue_Clear(com_dev->tx);
 #if defined(PIOS_INCLUDE_RTOS)
 		PIOS_Mutex_Unlock(com_dev->sendbuffer_mtx);
 #endif /* PIOS_INCLUDE_RTOS */
@@ -275,10 +236,7 @@ static int32_t SendBufferNonBlockingImpl(uintptr_t com_id, const uint8_t *buffer
 
 	if (all_or_nothing) {
 		// atomic-check
-		uint16_t tot_avail;
-
-		circ_queue_write_pos(com_dev->tx, NULL, &tot_avail);
-		if (len > tot_avail) {
+		if (len > PIOS_SPSC_Queue_Space(com_dev->tx)) {
 #if defined(PIOS_INCLUDE_RTOS)
 			PIOS_Mutex_Unlock(com_dev->sendbuffer_mtx);
 #endif /* PIOS_INCLUDE_RTOS */
@@ -287,16 +245,13 @@ static int32_t SendBufferNonBlockingImpl(uintptr_t com_id, const uint8_t *buffer
 		}
 	}
 
-	uint16_t bytes_into_fifo = circ_queue_write_data(com_dev->tx,
-			buffer, len);
+	uint16_t bytes_into_fifo = PIOS_SPSC_Queue_Send(com_dev->tx,
+			buffer, len, NULL);
 
 	/* Make sure the tx is actually started */
 	if (com_dev->driver->tx_start) {
-		uint16_t tx_avail;
-
-		circ_queue_read_pos(com_dev->tx, NULL, &tx_avail);
 		com_dev->driver->tx_start(com_dev->lower_id,
-					  tx_avail);
+					  PIOS_SPSC_Queue_Pending(com_dev->tx));
 	}
 
 #if defined(PIOS_INCLUDE_RTOS)
@@ -352,7 +307,7 @@ int32_t PIOS_COM_SendBufferStallTimeout(uintptr_t com_id, const uint8_t *buffer,
 			sent += rc;
 		} else if (rc == 0) {
 			/* Block... for 5 seconds? */
-			if (PIOS_Semaphore_Take(com_dev->tx_sem, max_ms) != true) {
+			if (!PIOS_SPSC_Queue_WaitSpace(com_dev->tx, 1, max_ms)) {
 				return -3;
 			}
 		} else {
@@ -391,6 +346,155 @@ int32_t PIOS_COM_SendBuffer(uintptr_t com_id, const uint8_t *buffer, uint16_t le
 	return PIOS_COM_SendBufferStallTimeout(com_id, buffer, len, 5000);
 }
 
+/**
+* Sends several buffers over given port as one unit, so no other sender's
+* data lands in between.  Each byte is copied once, straight into the fifo.
+* (blocking function)
+* \param[in] port COM port
+* \param[in] iov buffers to send, in order
+* \param[in] iovcnt number of buffers
+* \param[in] max_ms Maximum num of milliseconds without progress to block.
+* \return -1 if port not available
+* \return -3 another thread is sending, or no progress for max_ms
+* \return number of bytes transmitted on success
+*/
+int32_t PIOS_COM_SendBufferv(uintptr_t com_id, const struct pios_com_iovec *iov, uint8_t iovcnt, uint32_t max_ms)
+{
+	struct pios_com_dev *com_dev = (struct pios_com_dev *)com_id;
+
+	if (!PIOS_COM_validate(com_dev)) {
+		/* Undefined COM port for this board (see pios_board.c) */
+		return -1;
+	}
+
+	PIOS_Assert(com_dev->tx);
+
+#if defined(PIOS_INCLUDE_RTOS)
+	if (PIOS_Mutex_Lock(com_dev->sendbuffer_mtx, max_ms) != true) {
+		return -3;
+	}
+#endif /* defined(PIOS_INCLUDE_RTOS) */
+
+	int32_t sent = 0;
+
+	for (uint8_t i = 0; i < iovcnt; i++) {
+		const uint8_t *buffer = iov[i].base;
+		uint16_t len = iov[i].len;
+
+		if (com_dev->driver->available && !com_dev->driver->available(com_dev->lower_id)) {
+			/* Act as a sink while the device is down, as
+			 * SendBufferNonBlockingImpl does */
+			PIOS_SPSC_Queue_Clear(com_dev->tx);
+			sent += len;
+			continue;
+		}
+
+		while (len > 0) {
+			uint16_t rc = PIOS_SPSC_Queue_Send(com_dev->tx,
+					buffer, len, NULL);
+
+			if (com_dev->driver->tx_start) {
+				com_dev->driver->tx_start(com_dev->lower_id,
+						PIOS_SPSC_Queue_Pending(com_dev->tx));
+			}
+
+			buffer += rc;
+			len -= rc;
+			sent += rc;
+
+			if (len && !PIOS_SPSC_Queue_WaitSpace(com_dev->tx, 1, max_ms)) {
+#if defined(PIOS_INCLUDE_RTOS)
+				PIOS_Mutex_Unlock(com_dev->sendbuffer_mtx);
+#endif /* PIOS_INCLUDE_RTOS */
+				return sent ? sent : -3;
+			}
+		}
+	}
+
+#if defined(PIOS_INCLUDE_RTOS)
+	PIOS_Mutex_Unlock(com_dev->sendbuffer_mtx);
+#endif /* PIOS_INCLUDE_RTOS */
+
+	return sent;
+}
+
+/**
+* Reserves contiguous space in the transmit fifo, so a frame can be built
+* in place and sent without any copies.  On success the port stays claimed
+* for this caller until PIOS_COM_SendCommit, which must follow promptly;
+* other senders get -3 meanwhile.
+* \param[in] port COM port
+* \param[in] len bytes needed
+* \param[in] max_ms Maximum num of milliseconds to wait for the port and space.
+* \return where to write the frame, or NULL if the port is busy, down, or
+*         the free space is not contiguous; use PIOS_COM_SendBuffer then
+*/
+uint8_t *PIOS_COM_SendReserve(uintptr_t com_id, uint16_t len, uint32_t max_ms)
+{
+	struct pios_com_dev *com_dev = (struct pios_com_dev *)com_id;
+
+	if (!PIOS_COM_validate(com_dev) || !com_dev->tx) {
+		return NULL;
+	}
+
+	if (com_dev->driver->available && !com_dev->driver->available(com_dev->lower_id)) {
+		return NULL;
+	}
+
+#if defined(PIOS_INCLUDE_RTOS)
+	if (PIOS_Mutex_Lock(com_dev->sendbuffer_mtx, max_ms) != true) {
+		return NULL;
+	}
+#endif /* defined(PIOS_INCLUDE_RTOS) */
+
+	uint16_t contig = 0;
+	uint8_t *pos = NULL;
+
+	if (PIOS_SPSC_Queue_WaitSpace(com_dev->tx, len, max_ms)) {
+		pos = PIOS_SPSC_Queue_Reserve(com_dev->tx, &contig);
+	}
+
+	if (contig < len) {
+#if defined(PIOS_INCLUDE_RTOS)
+		PIOS_Mutex_Unlock(com_dev->sendbuffer_mtx);
+#endif /* PIOS_INCLUDE_RTOS */
+		return NULL;
+	}
+
+	return pos;
+}
+
+/**
+* Sends a frame built in space from PIOS_COM_SendReserve and releases
+* the port.
+* \param[in] port COM port
+* \param[in] len bytes written; at most what was reserved, and 0 abandons
+*            the reservation
+* \return -1 if port not available
+* \return number of bytes transmitted on success
+*/
+int32_t PIOS_COM_SendCommit(uintptr_t com_id, uint16_t len)
+{
+	struct pios_com_dev *com_dev = (struct pios_com_dev *)com_id;
+
+	if (!PIOS_COM_validate(com_dev)) {
+		return -1;
+	}
+
+	PIOS_SPSC_Queue_Commit(com_dev->tx, len, NULL);
+
+	if (len && com_dev->driver->tx_start) {
+		com_dev->driver->tx_start(com_dev->lower_id,
+				PIOS_SPSC_Queue_Pending(com_dev->tx));
+	}
+
+#if defined(PIOS_INCLUDE_RTOS)
+	PIOS_Mutex_Unlock(com_dev->sendbuffer_mtx);
+#endif /* PIOS_INCLUDE_RTOS */
+
+	return len;
+}
+
 /**
 * Sends a single character over given port
 * \param[in] port COM port
@@ -504,26 +608,19 @@ uint16_t PIOS_COM_GetNumReceiveBytesPending(uintptr_t com_id) {
 
 	PIOS_Assert(com_dev->rx);
 
-	uint16_t rx_pending;
-
-	circ_queue_read_pos(com_dev->rx, NULL, &rx_pending);
+	uint16_t rx_pending = PIOS_SPSC_Queue_Pending(com_dev->rx);
 
 	if (rx_pending == 0) {
 		/* No more bytes in receive buffer */
 		/* Make sure the receiver is running */
 		if (com_dev->driver->rx_start) {
-			uint16_t bytes_available = 0;
-
-			/* Find out how much room in rx buffer */
-			circ_queue_write_pos(com_dev->rx, NULL,
-					&bytes_available);
 			/* Notify the lower layer that there is now room in the rx buffer */
 			(com_dev->driver->rx_start)(com_dev->lower_id,
-					bytes_available);
+					PIOS_SPSC_Queue_Space(com_dev->rx));
 		}
 
 		/* Recheck, just in case something happened */
-		circ_queue_read_pos(com_dev->rx, NULL, &rx_pending);
+		rx_pending = PIOS_SPSC_Queue_Pending(com_dev->rx);
 	}
 
 	return rx_pending;
@@ -548,38 +645,20 @@ uint16_t PIOS_COM_ReceiveBuffer(uintptr_t com_id, uint8_t * buf, uint16_t buf_le
 	}
 	PIOS_Assert(com_dev->rx);
 
-	/* Clear any pending RX wakeup */
-	if (com_dev->rx_sem) {
-		PIOS_Semaphore_Take(com_dev->rx_sem, 0);
-	}
-
-check_again:
-	bytes_from_fifo = circ_queue_read_data(com_dev->rx, buf, buf_len);
+	bytes_from_fifo = PIOS_SPSC_Queue_Receive(com_dev->rx, buf, buf_len,
+			0, NULL);
 
 	if (bytes_from_fifo == 0) {
 		/* No more bytes in receive buffer */
 		/* Make sure the receiver is running while we wait */
 		if (com_dev->driver->rx_start) {
 			/* Notify the lower layer that there is now room in the rx buffer */
-			uint16_t rx_space_avail;
-
-			circ_queue_write_pos(com_dev->rx, NULL,
-					&rx_space_avail);
 			(com_dev->driver->rx_start)(com_dev->lower_id,
-						    rx_space_avail);
+					PIOS_SPSC_Queue_Space(com_dev->rx));
 		}
 		if (timeout_ms > 0) {
-#if defined(PIOS_INCLUDE_RTOS)
-			if (PIOS_Semaphore_Take(com_dev->rx_sem, timeout_ms) == true) {
-				/* Make sure we don't come back here again */
-				timeout_ms = 0;
-				goto check_again;
-			}
-#else
-			PIOS_DELAY_WaitmS(1);
-			timeout_ms--;
-			goto check_again;
-#endif
+			bytes_from_fifo = PIOS_SPSC_Queue_Receive(com_dev->rx,
+					buf, buf_len, timeout_ms, NULL);
 		}
 	}
 
@@ -587,6 +666,61 @@ check_again:
 	return (bytes_from_fifo);
 }
 
+/**
+ * Get received bytes in place, without copying them out of the port buffer.
+ * The bytes stay buffered until released with PIOS_COM_ReceiveSpanDone,
+ * which must be called before the next receive on this port.
+ * \param[in] port COM port
+ * \param[out] span first received byte
+ * \param[in] timeout_ms how long to wait for data
+ * \returns number of contiguous bytes at span
+ */
+uint16_t PIOS_COM_ReceiveSpan(uintptr_t com_id, const uint8_t **span, uint32_t timeout_ms)
+{
+	PIOS_Assert(span);
+	uint16_t contig;
+
+	struct pios_com_dev *com_dev = (struct pios_com_dev *)com_id;
+
+	if (!PIOS_COM_validate(com_dev)) {
+		/* Undefined COM port for this board (see pios_board.c) */
+		PIOS_Assert(0);
+	}
+	PIOS_Assert(com_dev->rx);
+
+	*span = PIOS_SPSC_Queue_Peek(com_dev->rx, &contig, 0);
+
+	if (contig == 0) {
+		/* Make sure the receiver is running while we wait */
+		if (com_dev->driver->rx_start) {
+			(com_dev->driver->rx_start)(com_dev->lower_id,
+					PIOS_SPSC_Queue_Space(com_dev->rx));
+		}
+		if (timeout_ms > 0) {
+			*span = PIOS_SPSC_Queue_Peek(com_dev->rx, &contig,
+					timeout_ms);
+		}
+	}
+
+	return contig;
+}
+
+/**
+ * Release bytes obtained with PIOS_COM_ReceiveSpan
+ * \param[in] port COM port
+ * \param[in] len number of bytes consumed, at most what the span held
+ */
+void PIOS_COM_ReceiveSpanDone(uintptr_t com_id, uint16_t len)
+{
+	struct pios_com_dev *com_dev = (struct pios_com_dev *)com_id;
+
+	if (!PIOS_COM_validate(com_dev)) {
+		PIOS_Assert(0);
+	}
+
+	PIOS_SPSC_Queue_Consume(com_dev->rx, len, NULL);
+}
+
 /**
  * Query if a com port is available for use.  That can be
  * used to check a link is established even if the device
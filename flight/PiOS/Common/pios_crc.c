@@ -7,6 +7,7 @@
  *
  */
 
+#include "pios_config.h"
 #include <pios_crc.h>
 
 #include <stdbool.h>
@@ -152,6 +153,12 @@ uint8_t PIOS_CRC_updateByte(uint8_t crc, const uint8_t data)
  */
 uint8_t PIOS_CRC_updateCRC(uint8_t crc, const uint8_t* data, int32_t length)
 {
+#if defined(PIOS_INCLUDE_CRC_HW)
+	if (length >= PIOS_CRC_HW_MIN_LENGTH &&
+			PIOS_CRC_HW_updateCRC(&crc, data, length))
+		return crc;
+#endif
+
 	// use registers for speed
 	register int32_t len = length;
 	register uint8_t crc8 = crc;
@@ -40,6 +40,7 @@
 #include "pios_crc.h"
 #include "pios_com.h"
 #include "pios_com_priv.h"
+#include "misc_math.h"
 
 #define CRSF_CRCFIELD(frame)		(frame.payload[frame.length - CRSF_CRC_LEN - CRSF_TYPE_LEN])
 
@@ -74,8 +75,25 @@ struct pios_crossfire_dev {
 
 	// To track frame starts to track whether telemetry is OK to send.
 	uint32_t time_frame_start;
+
+	// Raw time the last frame of any kind finished, and the last RC frame
+	// began; telemetry goes in the gap before the next RC frame is due.
+	uint32_t time_frame_end;
+	uint32_t time_rc_start;
+	uint32_t time_last_rx;
+
+	// Measured RC frame period, 0 until known.
+	uint16_t rc_period_us;
+	uint8_t period_mismatches;
+
+	// From the link statistics frame, 0xff until one arrives.
+	uint8_t rf_mode;
 };
 
+// Intervals out of line with the measured period before it's relearned,
+// i.e. the link has really changed rate rather than dropped a frame.
+#define CRSF_PERIOD_RELEARN			8
+
 /**
  * @brief Allocates a driver instance
  * @retval pios_crossfire_dev pointer on success, NULL on failure
@@ -94,6 +112,7 @@ static bool PIOS_Crossfire_Validate(const struct pios_crossfire_dev *dev);
  * @retval raw channel value, or error value (see pios_rcvr.h)
  */
 static int32_t PIOS_Crossfire_Read(uintptr_t id, uint8_t channel);
+static int32_t PIOS_Crossfire_ReadAll(uintptr_t context, int32_t *channels, uint8_t num_channels);
 /**
  * @brief Set all channels in the last frame buffer to a given value
  * @param[in] dev Driver instance
@@ -130,6 +149,7 @@ static void PIOS_Crossfire_Supervisor(uintptr_t context);
 // public
 const struct pios_rcvr_driver pios_crossfire_rcvr_driver = {
 	.read = PIOS_Crossfire_Read,
+	.read_all = PIOS_Crossfire_ReadAll,
 };
 
 
@@ -141,6 +161,7 @@ static struct pios_crossfire_dev *PIOS_Crossfire_Alloc(void)
 
 	memset(dev, 0, sizeof(*dev));
 	dev->magic = PIOS_CROSSFIRE_MAGIC;
+	dev->rf_mode = 0xff;
 
 	return dev;
 }
@@ -190,7 +211,7 @@ int PIOS_Crossfire_InitTelemetry(uintptr_t crsf_id)
 
 static int32_t PIOS_Crossfire_Read(uintptr_t context, uint8_t channel)
 {
-	if (channel > PIOS_CROSSFIRE_CHANNELS)
+	if (channel >= PIOS_CROSSFIRE_CHANNELS)
 		return PIOS_RCVR_INVALID;
 
 	struct pios_crossfire_dev *dev = (struct pios_crossfire_dev *)context;
@@ -200,6 +221,27 @@ static int32_t PIOS_Crossfire_Read(uintptr_t context, uint8_t channel)
 	return dev->channel_data[channel];
 }
 
+/**
+ * Get all the channels at once
+ * \output PIOS_RCVR_NODRIVER on an invalid device
+ * \output the number of channels filled in
+ */
+static int32_t PIOS_Crossfire_ReadAll(uintptr_t context, int32_t *channels, uint8_t num_channels)
+{
+	struct pios_crossfire_dev *dev = (struct pios_crossfire_dev *)context;
+
+	if (!PIOS_Crossfire_Validate(dev))
+		return PIOS_RCVR_NODRIVER;
+
+	if (num_channels > PIOS_CROSSFIRE_CHANNELS)
+		num_channels = PIOS_CROSSFIRE_CHANNELS;
+
+	for (int i = 0; i < num_channels; i++)
+		channels[i] = dev->channel_data[i];
+
+	return num_channels;
+}
+
 static void PIOS_Crossfire_SetAllChannels(struct pios_crossfire_dev *dev, uint16_t value)
 {
 	for (int i = 0; i < PIOS_CROSSFIRE_CHANNELS; i++)
@@ -214,16 +256,33 @@ static uint16_t PIOS_Crossfire_Receive(uintptr_t context, uint8_t *buf, uint16_t
 	if (!PIOS_Crossfire_Validate(dev))
 		goto out_fail;
 
-	if(dev->buf_pos == 0) {
-		dev->time_frame_start = PIOS_DELAY_GetRaw();
-	}
+	int i = 0;
+
+	// At high packet rates the line is never quiet long enough for the
+	// supervisor to notice a short frame, so resync on gaps here too.
+	uint32_t now = PIOS_DELAY_GetRaw();
+
+	if (dev->buf_pos > 0 &&
+			PIOS_DELAY_DiffuS(dev->time_last_rx) > CRSF_TIMING_INTERBYTE)
+		PIOS_Crossfire_ResetBuffer(dev);
+
+	dev->time_last_rx = now;
 
-	for (int i = 0; i < buf_len; i++) {
+	while (i < buf_len) {
 		// Ignore any stuff beyond what's expected.
 		if(dev->buf_pos >= dev->bytes_expected)
 			break;
 
-		dev->u.rx_buf[dev->buf_pos++] = buf[i];
+		if(dev->buf_pos == 0)
+			dev->time_frame_start = now;
+
+		// Copy up to the length field, or to the end of the frame, at once.
+		int want = (dev->buf_pos < CRSF_LEN_IDX) ? CRSF_LEN_IDX : dev->bytes_expected;
+		int n = MIN(want - dev->buf_pos, buf_len - i);
+
+		memcpy(&dev->u.rx_buf[dev->buf_pos], &buf[i], n);
+		dev->buf_pos += n;
+		i += n;
 
 		if(dev->buf_pos == CRSF_LEN_IDX) {
 			// Read length field and adjust. Denotes payload, plus type field, plus CRC field.
@@ -237,13 +296,11 @@ static uint16_t PIOS_Crossfire_Receive(uintptr_t context, uint8_t *buf, uint16_t
 		}
 
 		if (dev->buf_pos == dev->bytes_expected) {
-			// Frame complete, decode.
+			// Frame complete, decode. This resets the buffer either
+			// way, so anything after it starts the next frame.
 			if(PIOS_Crossfire_UnpackFrame(dev)) {
 				// Frame is valid, trigger semaphore.
 				PIOS_RCVR_ActiveFromISR();
-				// Ignore any stuff that might be left in the buffer.
-				// There shouldn't be anything.
-				break;
 			}
 		}
 	}
@@ -267,10 +324,82 @@ static void PIOS_Crossfire_ResetBuffer(struct pios_crossfire_dev *dev)
 	dev->bytes_expected = CRSF_MAX_FRAMELEN;
 }
 
+/**
+ * @brief Period of the RC frames, measured if possible, else as implied by
+ * the RF mode the receiver last reported.
+ */
+static uint32_t PIOS_Crossfire_FramePeriod(const struct pios_crossfire_dev *dev)
+{
+	if (dev->rc_period_us)
+		return dev->rc_period_us;
+
+	switch (dev->rf_mode) {
+	case CRSF_RFMODE_4HZ:
+		return 250000;
+	case CRSF_RFMODE_50HZ:
+		return 20000;
+	case CRSF_RFMODE_150HZ:
+		return 6667;
+	default:
+		return CRSF_TIMING_FRAMEDISTANCE;
+	}
+}
+
+/**
+ * @brief Learn the RC frame period from the start of a good RC frame.
+ */
+static void PIOS_Crossfire_TrackPeriod(struct pios_crossfire_dev *dev)
+{
+	uint32_t interval = PIOS_DELAY_DiffuS(dev->time_rc_start) -
+		PIOS_DELAY_DiffuS(dev->time_frame_start);
+
+	dev->time_rc_start = dev->time_frame_start;
+
+	if (interval < CRSF_TIMING_MINPERIOD || interval > CRSF_TIMING_MAXPERIOD)
+		return;
+
+	// Dropped frames show up as a multiple of the period; don't let
+	// those stretch it, unless the rate has really changed.
+	if (dev->rc_period_us &&
+			(interval > dev->rc_period_us * 5 / 4 ||
+			 interval < dev->rc_period_us * 3 / 4)) {
+		if (++dev->period_mismatches < CRSF_PERIOD_RELEARN)
+			return;
+
+		dev->rc_period_us = 0;
+	}
+
+	dev->period_mismatches = 0;
+
+	if (dev->rc_period_us)
+		dev->rc_period_us = (dev->rc_period_us * 3 + interval) / 4;
+	else
+		dev->rc_period_us = interval;
+}
+
 static bool PIOS_Crossfire_UnpackFrame(struct pios_crossfire_dev *dev)
 {
-	// Currently there appears to be only RC channel messages.
-	// We also only care about those for now.
+	dev->time_frame_end = PIOS_DELAY_GetRaw();
+
+	if(dev->u.frame.type == CRSF_FRAME_LINKSTATISTICS &&
+		dev->u.frame.length == (CRSF_TYPE_LEN + CRSF_PAYLOAD_LINKSTATISTICS + CRSF_CRC_LEN)) {
+
+		uint8_t crc = PIOS_CRC_updateCRC_TBS(0, &dev->u.frame.type, dev->u.frame.length - CRSF_CRC_LEN);
+
+		if(crc == CRSF_CRCFIELD(dev->u.frame)) {
+			const struct crsf_payload_linkstats *ls =
+				(const struct crsf_payload_linkstats *) dev->u.frame.payload;
+
+			// A new RF mode means a new frame rate; measure afresh.
+			if (ls->rf_mode != dev->rf_mode) {
+				dev->rf_mode = ls->rf_mode;
+				dev->rc_period_us = 0;
+			}
+		}
+
+		PIOS_Crossfire_ResetBuffer(dev);
+		return false;
+	}
 
 	if(dev->u.frame.type == CRSF_FRAME_RCCHANNELS &&
 		dev->u.frame.length == (CRSF_TYPE_LEN + CRSF_PAYLOAD_RCCHANNELS + CRSF_CRC_LEN)) {
@@ -309,6 +438,8 @@ static bool PIOS_Crossfire_UnpackFrame(struct pios_crossfire_dev *dev)
 			// RC control is still happening.
 			dev->failsafe_timer = 0;
 
+			PIOS_Crossfire_TrackPeriod(dev);
+
 			PIOS_Crossfire_ResetBuffer(dev);
 
 			return true;
@@ -355,16 +486,20 @@ int PIOS_Crossfire_SendTelemetry(uintptr_t crsf_id, uint8_t *buf, uint8_t bytes)
 	if(!bytes)
 		return 0;
 
-	uint32_t delay = PIOS_DELAY_DiffuS(dev->time_frame_start);
-	if((delay > CRSF_TIMING_MAXFRAME) & (delay < (CRSF_TIMING_FRAMEDISTANCE-CRSF_TIMING_MAXFRAME))) {
+	// Never while a frame is coming in, nor right on the heels of one.
+	if (dev->buf_pos != 0 ||
+			PIOS_DELAY_DiffuS(dev->time_frame_end) < CRSF_TIMING_GUARD)
+		return -1;
 
-		// We're still within the send window.
-		PIOS_COM_SendBuffer(dev->telem_com_id, buf, (uint16_t)bytes);
-		return 0;
+	// And only if the whole frame is out before the next RC frame is due.
+	uint32_t since_rc = PIOS_DELAY_DiffuS(dev->time_rc_start);
+	uint32_t tx_time = bytes * CRSF_TIMING_BYTE_US;
 
-	} else {
+	if (since_rc + tx_time + CRSF_TIMING_GUARD > PIOS_Crossfire_FramePeriod(dev))
 		return -1;
-	}
+
+	PIOS_COM_SendBuffer(dev->telem_com_id, buf, (uint16_t)bytes);
+	return 0;
 }
 
 bool PIOS_Crossfire_IsFailsafed(uintptr_t crsf_id)
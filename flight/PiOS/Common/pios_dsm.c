@@ -47,9 +47,11 @@ static void PIOS_DSM_Supervisor(uintptr_t dsm_id);
 
 #if defined(PIOS_INCLUDE_RCVR)
 static int32_t PIOS_DSM_Get(uintptr_t rcvr_id, uint8_t channel);
+static int32_t PIOS_DSM_ReadAll(uintptr_t rcvr_id, int32_t *channels, uint8_t num_channels);
 
 const struct pios_rcvr_driver pios_dsm_rcvr_driver = {
 	.read = PIOS_DSM_Get,
+	.read_all = PIOS_DSM_ReadAll,
 };
 #endif
 
@@ -259,9 +261,11 @@ int PIOS_DSM_UnrollChannels(struct pios_dsm_dev *dsm_dev)
 			goto stream_error;
 		}
 
-		/* extract and save the channel value */
+		/* extract and save the channel value; slots can name up to 16
+		 * channels, more than are kept */
 		uint8_t channel_num = (word >> resolution) & 0x0f;
-		state->channel_data[channel_num] = (word & mask);
+		if (channel_num < PIOS_DSM_NUM_INPUTS)
+			state->channel_data[channel_num] = (word & mask);
 	}
 
 #ifdef DSM_LOST_FRAME_COUNTER
@@ -423,6 +427,27 @@ static int32_t PIOS_DSM_Get(uintptr_t rcvr_id, uint8_t channel)
 	/* may also be PIOS_RCVR_TIMEOUT set by other function */
 	return dsm_dev->state.channel_data[channel];
 }
+
+/**
+ * Get all the channels at once
+ * \output PIOS_RCVR_INVALID on an invalid device
+ * \output the number of channels filled in
+ */
+static int32_t PIOS_DSM_ReadAll(uintptr_t rcvr_id, int32_t *channels, uint8_t num_channels)
+{
+	struct pios_dsm_dev *dsm_dev = (struct pios_dsm_dev *)rcvr_id;
+
+	if (!PIOS_DSM_Validate(dsm_dev))
+		return PIOS_RCVR_INVALID;
+
+	if (num_channels > PIOS_DSM_NUM_INPUTS)
+		num_channels = PIOS_DSM_NUM_INPUTS;
+
+	for (int i = 0; i < num_channels; i++)
+		channels[i] = dsm_dev->state.channel_data[i];
+
+	return num_channels;
+}
 #endif
 
 /**
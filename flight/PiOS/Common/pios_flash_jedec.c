@@ -58,6 +58,22 @@
 
 #define JEDED_READ_OPT_DATA          0x4B
 
+/* Longest read done in one bus claim.  Longer ones are split, so sensors
+ * sharing the bus can get in between the pieces. */
+#define JEDEC_READ_CHUNK             128
+
+/* Reads that fit in one aligned line are served from a few cached lines.
+ * Filesystem scans read headers and erased checks a handful of bytes at a
+ * time, and each read costs a bus claim and a command whatever its size. */
+#define JEDEC_CACHE_LINE             32
+#define JEDEC_CACHE_LINES            4
+#define JEDEC_CACHE_INVALID          0xffffffff
+
+struct jedec_cache_line {
+	uint32_t addr;
+	uint8_t data[JEDEC_CACHE_LINE];
+};
+
 enum pios_jedec_dev_magic {
 	PIOS_JEDEC_DEV_MAGIC = 0xcb55aa55,
 };
@@ -75,6 +91,9 @@ struct jedec_flash_dev {
 	const struct pios_flash_jedec_cfg *cfg;
 	struct pios_semaphore *transaction_lock;
 	enum pios_jedec_dev_magic magic;
+
+	struct jedec_cache_line cache[JEDEC_CACHE_LINES];
+	uint8_t cache_victim;
 };
 
 //! Private functions
@@ -87,6 +106,7 @@ static int32_t PIOS_Flash_Jedec_ClaimBus(struct jedec_flash_dev *flash_dev);
 static int32_t PIOS_Flash_Jedec_ReleaseBus(struct jedec_flash_dev *flash_dev);
 static int32_t PIOS_Flash_Jedec_WriteEnable(struct jedec_flash_dev *flash_dev);
 static int32_t PIOS_Flash_Jedec_Busy(struct jedec_flash_dev *flash_dev);
+static void PIOS_Flash_Jedec_Invalidate(struct jedec_flash_dev *flash_dev, uint32_t chip_offset, uint32_t len);
 
 /**
  * @brief Allocate a new device
@@ -100,6 +120,9 @@ static struct jedec_flash_dev *PIOS_Flash_Jedec_alloc(void)
 
 	flash_dev->magic = PIOS_JEDEC_DEV_MAGIC;
 
+	PIOS_Flash_Jedec_Invalidate(flash_dev, 0, JEDEC_CACHE_INVALID);
+	flash_dev->cache_victim = 0;
+
 	return(flash_dev);
 }
 
@@ -195,6 +218,45 @@ static int32_t PIOS_Flash_Jedec_ReleaseBus(struct jedec_flash_dev *flash_dev)
 	return 0;
 }
 
+/**
+ * @brief Drops the cached lines overlapping a range
+ */
+static void PIOS_Flash_Jedec_Invalidate(struct jedec_flash_dev *flash_dev, uint32_t chip_offset, uint32_t len)
+{
+	for (int i = 0; i < JEDEC_CACHE_LINES; i++) {
+		struct jedec_cache_line *line = &flash_dev->cache[i];
+
+		if (line->addr - chip_offset < len ||
+				chip_offset - line->addr < JEDEC_CACHE_LINE)
+			line->addr = JEDEC_CACHE_INVALID;
+	}
+}
+
+/**
+ * @brief Reads into a buffer with the bus claimed and CS asserted
+ */
+static int32_t PIOS_Flash_Jedec_ReadClaimed(struct jedec_flash_dev *flash_dev, uint32_t chip_offset, uint8_t *data, uint16_t len)
+{
+	/* Execute read command and clock in address.  Keep CS asserted */
+	uint8_t out[] = {
+		flash_dev->cfg->fast_read ? JEDEC_FAST_READ : JEDEC_READ_DATA,
+		(chip_offset >> 16) & 0xff,
+		(chip_offset >>  8) & 0xff,
+		(chip_offset >>  0) & 0xff,
+		0,	/* Dummy byte, for FAST_READ */
+	};
+
+	if (PIOS_SPI_TransferBlock(flash_dev->spi_id, out, NULL,
+				flash_dev->cfg->fast_read ? sizeof(out) : sizeof(out) - 1) < 0)
+		return -2;
+
+	/* Copy the transfer data to the buffer */
+	if (PIOS_SPI_TransferBlock(flash_dev->spi_id, NULL, data, len) < 0)
+		return -3;
+
+	return 0;
+}
+
 /**
  * @brief Returns if the flash chip is busy
  * @returns -1 for failure, 0 for not busy, 1 for busy
@@ -352,6 +414,9 @@ static int32_t PIOS_Flash_Jedec_EraseSector(uintptr_t chip_id, uint32_t chip_sec
 	if (PIOS_Flash_Jedec_ClaimBus(flash_dev) != 0)
 		return -1;
 
+	/* The sector size isn't known here, so forget everything */
+	PIOS_Flash_Jedec_Invalidate(flash_dev, 0, JEDEC_CACHE_INVALID);
+
 	if (PIOS_SPI_TransferBlock(flash_dev->spi_id,out,NULL,sizeof(out)) < 0) {
 		PIOS_Flash_Jedec_ReleaseBus(flash_dev);
 		return -2;
@@ -410,6 +475,8 @@ static int32_t PIOS_Flash_Jedec_WriteData(uintptr_t chip_id, uint32_t chip_offse
 	if (PIOS_Flash_Jedec_ClaimBus(flash_dev) != 0)
 		return -1;
 
+	PIOS_Flash_Jedec_Invalidate(flash_dev, chip_offset, len);
+
 	if (PIOS_SPI_TransferBlock(flash_dev->spi_id,out,NULL,sizeof(out)) < 0) {
 		PIOS_Flash_Jedec_ReleaseBus(flash_dev);
 		return -1;
@@ -459,29 +526,59 @@ static int32_t PIOS_Flash_Jedec_ReadData(uintptr_t chip_id, uint32_t chip_offset
 	if (PIOS_Flash_Jedec_Validate(flash_dev) != 0)
 		return -1;
 
-	if (PIOS_Flash_Jedec_ClaimBus(flash_dev) == -1)
-		return -1;
+	uint32_t line_addr = chip_offset & ~(JEDEC_CACHE_LINE - 1);
 
-	/* Execute read command and clock in address.  Keep CS asserted */
-	uint8_t out[] = {
-		JEDEC_READ_DATA,
-		(chip_offset >> 16) & 0xff,
-		(chip_offset >>  8) & 0xff,
-		(chip_offset >>  0) & 0xff,
-	};
+	if (len > 0 && chip_offset + len <= line_addr + JEDEC_CACHE_LINE) {
+		if (PIOS_Flash_Jedec_ClaimBus(flash_dev) == -1)
+			return -1;
+
+		struct jedec_cache_line *line = NULL;
+
+		for (int i = 0; i < JEDEC_CACHE_LINES; i++) {
+			if (flash_dev->cache[i].addr == line_addr) {
+				line = &flash_dev->cache[i];
+				break;
+			}
+		}
+
+		if (!line) {
+			line = &flash_dev->cache[flash_dev->cache_victim];
+			flash_dev->cache_victim = (flash_dev->cache_victim + 1) % JEDEC_CACHE_LINES;
+
+			int32_t ret = PIOS_Flash_Jedec_ReadClaimed(flash_dev, line_addr, line->data, JEDEC_CACHE_LINE);
+			if (ret != 0) {
+				line->addr = JEDEC_CACHE_INVALID;
+				PIOS_Flash_Jedec_ReleaseBus(flash_dev);
+				return ret;
+			}
+
+			line->addr = line_addr;
+		}
+
+		memcpy(data, &line->data[chip_offset - line_addr], len);
 
-	if (PIOS_SPI_TransferBlock(flash_dev->spi_id,out,NULL,sizeof(out)) < 0) {
 		PIOS_Flash_Jedec_ReleaseBus(flash_dev);
-		return -2;
+
+		return 0;
 	}
 
-	/* Copy the transfer data to the buffer */
-	if (PIOS_SPI_TransferBlock(flash_dev->spi_id,NULL,data,len) < 0) {
+	while (len > 0) {
+		uint16_t chunk = len < JEDEC_READ_CHUNK ? len : JEDEC_READ_CHUNK;
+
+		if (PIOS_Flash_Jedec_ClaimBus(flash_dev) == -1)
+			return -1;
+
+		int32_t ret = PIOS_Flash_Jedec_ReadClaimed(flash_dev, chip_offset, data, chunk);
+
 		PIOS_Flash_Jedec_ReleaseBus(flash_dev);
-		return -3;
-	}
 
-	PIOS_Flash_Jedec_ReleaseBus(flash_dev);
+		if (ret != 0)
+			return ret;
+
+		chip_offset += chunk;
+		data += chunk;
+		len -= chunk;
+	}
 
 	return 0;
 }
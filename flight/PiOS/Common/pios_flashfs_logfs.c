@@ -42,6 +42,23 @@ enum pios_flashfs_logfs_dev_magic {
 	PIOS_FLASHFS_LOGFS_DEV_MAGIC = 0x94938201,
 };
 
+/*
+ * Background garbage collection erases the spare arena one sector at a
+ * time and then migrates live slots into it a few at a time, so that a
+ * save rarely finds the log full and has to collect synchronously.
+ */
+enum logfs_gc_state {
+	LOGFS_GC_IDLE,
+	LOGFS_GC_ERASING,	/* erasing the destination arena sector by sector */
+	LOGFS_GC_COPYING,	/* migrating active slots to the destination arena */
+};
+
+/* Start collecting in the background once this few slots remain free */
+#define LOGFS_GC_START_FREE_SLOTS(num_slots) ((num_slots) / 4)
+
+/* Slots migrated per background step */
+#define LOGFS_GC_SLOTS_PER_STEP 4
+
 struct logfs_state {
 	enum pios_flashfs_logfs_dev_magic magic;
 	const struct flashfs_logfs_cfg *cfg;
@@ -55,6 +72,27 @@ struct logfs_state {
 	uint16_t num_free_slots;   /* slots in free state */
 	uint16_t num_active_slots; /* slots in active state */
 
+	/*
+	 * Index of the active slots of the mounted arena, so finding an
+	 * object costs one header read rather than a scan of the log.
+	 * Active slots hash on (obj_id, obj_inst_id) into per-bucket
+	 * chains linked through slot_next; slot_tag holds each slot's full
+	 * hash so that only likely matches get read back from flash.
+	 * Slot 0 holds the arena header, so 0 ends a chain.
+	 */
+	uint16_t *index_buckets;
+	uint16_t index_num_buckets; /* power of 2 */
+	uint16_t *slot_next;
+	uint16_t *slot_tag;
+
+	/* Background garbage collection progress */
+	enum logfs_gc_state gc_state;
+	uint8_t gc_dst_arena_id;
+	uint32_t gc_erase_offset;  /* next offset to erase within the destination arena */
+	uint16_t gc_src_slot_id;   /* next source slot to consider for copying */
+	uint16_t gc_dst_slot_id;   /* next free slot in the destination arena */
+	uint16_t *gc_copy_slot;    /* destination slot holding each copied source slot, 0 if none */
+
 	/* Underlying flash partition handle */
 	uintptr_t partition_id;
 	uint32_t partition_size;
@@ -77,6 +115,76 @@ static uintptr_t logfs_get_addr(const struct logfs_state *logfs, uint8_t arena_i
 		(slot_id  * logfs->cfg->slot_size));
 }
 
+/*
+ * In-RAM slot index
+ */
+
+static uint16_t logfs_index_hash(uint32_t obj_id, uint16_t obj_inst_id)
+{
+	uint32_t h = obj_id ^ ((uint32_t)obj_inst_id * 0x9E3779B1);
+
+	h ^= h >> 16;
+	h *= 0x85EBCA6B;
+	h ^= h >> 13;
+
+	return h;
+}
+
+static int32_t logfs_index_alloc(struct logfs_state *logfs)
+{
+	uint16_t num_slots = logfs->cfg->arena_size / logfs->cfg->slot_size;
+
+	/* About two active slots per bucket when the arena is full */
+	uint16_t num_buckets = 1;
+	while (num_buckets * 2 < num_slots) {
+		num_buckets <<= 1;
+	}
+
+	logfs->index_buckets = PIOS_malloc_no_dma(num_buckets * sizeof(uint16_t));
+	logfs->slot_next = PIOS_malloc_no_dma(num_slots * sizeof(uint16_t));
+	logfs->slot_tag = PIOS_malloc_no_dma(num_slots * sizeof(uint16_t));
+	logfs->gc_copy_slot = PIOS_malloc_no_dma(num_slots * sizeof(uint16_t));
+
+	if (!logfs->index_buckets || !logfs->slot_next || !logfs->slot_tag ||
+			!logfs->gc_copy_slot) {
+		return -1;
+	}
+
+	logfs->index_num_buckets = num_buckets;
+
+	return 0;
+}
+
+static void logfs_index_clear(struct logfs_state *logfs)
+{
+	memset(logfs->index_buckets, 0,
+		logfs->index_num_buckets * sizeof(uint16_t));
+}
+
+static void logfs_index_add(struct logfs_state *logfs, uint16_t slot_id, uint32_t obj_id, uint16_t obj_inst_id)
+{
+	uint16_t tag = logfs_index_hash(obj_id, obj_inst_id);
+	uint16_t *bucket = &logfs->index_buckets[tag & (logfs->index_num_buckets - 1)];
+
+	logfs->slot_tag[slot_id]  = tag;
+	logfs->slot_next[slot_id] = *bucket;
+	*bucket = slot_id;
+}
+
+static void logfs_index_remove(struct logfs_state *logfs, uint16_t slot_id, uint32_t obj_id, uint16_t obj_inst_id)
+{
+	uint16_t tag = logfs_index_hash(obj_id, obj_inst_id);
+
+	for (uint16_t *link = &logfs->index_buckets[tag & (logfs->index_num_buckets - 1)];
+	     *link != 0;
+	     link = &logfs->slot_next[*link]) {
+		if (*link == slot_id) {
+			*link = logfs->slot_next[slot_id];
+			return;
+		}
+	}
+}
+
 /*
  * The bits within these enum values must progress ONLY
  * from 1 -> 0 so that we can write later ones on top
@@ -109,19 +217,14 @@ struct arena_header {
  ****************************************/
 
 /**
- * @brief Erases all sectors within the given arena and sets arena to erased state.
+ * @brief Sets an arena whose sectors have all been erased to erased state.
  * @return 0 if success, < 0 on failure
  * @note Must be called while holding the flash transaction lock
  */
-static int32_t logfs_erase_arena(const struct logfs_state *logfs, uint8_t arena_id)
+static int32_t logfs_mark_arena_erased(const struct logfs_state *logfs, uint8_t arena_id)
 {
 	uintptr_t arena_addr = logfs_get_addr (logfs, arena_id, 0);
 
-	/* Erase all of the sectors in the arena */
-	if (PIOS_FLASH_erase_range(logfs->partition_id, arena_addr, logfs->cfg->arena_size) != 0) {
-		return -1;
-	}
-
 	/* Mark this arena as fully erased */
 	struct arena_header arena_hdr = {
 		.magic = logfs->cfg->fs_magic,
@@ -139,6 +242,23 @@ static int32_t logfs_erase_arena(const struct logfs_state *logfs, uint8_t arena_
 	return 0;
 }
 
+/**
+ * @brief Erases all sectors within the given arena and sets arena to erased state.
+ * @return 0 if success, < 0 on failure
+ * @note Must be called while holding the flash transaction lock
+ */
+static int32_t logfs_erase_arena(const struct logfs_state *logfs, uint8_t arena_id)
+{
+	uintptr_t arena_addr = logfs_get_addr (logfs, arena_id, 0);
+
+	/* Erase all of the sectors in the arena */
+	if (PIOS_FLASH_erase_range(logfs->partition_id, arena_addr, logfs->cfg->arena_size) != 0) {
+		return -1;
+	}
+
+	return logfs_mark_arena_erased(logfs, arena_id);
+}
+
 /**
  * @brief Marks the given arena as reserved so it can be filled.
  * @return 0 if success, < 0 on failure
@@ -334,6 +454,26 @@ struct slot_header {
 	uint16_t obj_size;
 } __attribute__((packed));
 
+/**
+ * @brief Obsoletes a slot that was left partly written
+ * @note Must be called while holding the flash transaction lock
+ */
+static int32_t logfs_discard_slot (struct logfs_state *logfs, uint16_t slot_id)
+{
+	/* Only the state changes, other fields are left erased */
+	struct slot_header slot_hdr;
+	memset(&slot_hdr, 0xFF, sizeof(slot_hdr));
+	slot_hdr.state = SLOT_STATE_OBSOLETE;
+
+	/* The slot is no longer free, whether or not this succeeds */
+	logfs->num_free_slots--;
+
+	return PIOS_FLASH_write_data(logfs->partition_id,
+					logfs_get_addr (logfs, logfs->active_arena_id, slot_id),
+					(uint8_t *)&slot_hdr,
+					sizeof(slot_hdr));
+}
+
 /* NOTE: Must be called while holding the flash transaction lock */
 static int32_t logfs_raw_copy_bytes (const struct logfs_state *logfs, uintptr_t src_addr, uint16_t src_size, uintptr_t dst_addr)
 {
@@ -405,6 +545,8 @@ static int32_t logfs_unmount_log(struct logfs_state *logfs)
 	logfs->num_free_slots   = 0;
 	logfs->mounted          = false;
 
+	logfs_index_clear(logfs);
+
 	return 0;
 }
 
@@ -416,10 +558,18 @@ static int32_t logfs_mount_log(struct logfs_state *logfs, uint8_t arena_id)
 	logfs->num_free_slots   = 0;
 	logfs->active_arena_id  = arena_id;
 
-	/* Scan the log to find out how full it is */
-	for (uint16_t slot_id = 1;
-	     slot_id < (logfs->cfg->arena_size / logfs->cfg->slot_size);
-	     slot_id++) {
+	logfs_index_clear(logfs);
+
+	uint16_t num_slots = logfs->cfg->arena_size / logfs->cfg->slot_size;
+
+	/*
+	 * Scan the log to find out how full it is, and index what's in it.
+	 * Slots are only ever used in order, so empty slots form one block
+	 * at the end of the arena and the scan can stop at the first one.
+	 * This keeps mounting (and so boot) quick when the arena is mostly
+	 * empty, as it is after every garbage collection.
+	 */
+	for (uint16_t slot_id = 1; slot_id < num_slots; slot_id++) {
 		struct slot_header slot_hdr;
 		uintptr_t slot_addr = logfs_get_addr (logfs, logfs->active_arena_id, slot_id);
 		if (PIOS_FLASH_read_data(logfs->partition_id,
@@ -429,26 +579,50 @@ static int32_t logfs_mount_log(struct logfs_state *logfs, uint8_t arena_id)
 			return -1;
 		}
 
-		/*
-		 * Empty slots must be in a continguous block at the
-		 * end of the arena.
-		 */
-		PIOS_Assert (slot_hdr.state == SLOT_STATE_EMPTY ||
-			logfs->num_free_slots == 0);
+		if (slot_hdr.state == SLOT_STATE_EMPTY) {
+			logfs->num_free_slots = num_slots - slot_id;
+			break;
+		}
 
 		switch (slot_hdr.state) {
-		case SLOT_STATE_EMPTY:
-			logfs->num_free_slots++;
-			break;
 		case SLOT_STATE_ACTIVE:
 			logfs->num_active_slots++;
+			logfs_index_add(logfs, slot_id, slot_hdr.obj_id,
+				slot_hdr.obj_inst_id);
 			break;
+		case SLOT_STATE_EMPTY:
 		case SLOT_STATE_RESERVED:
 		case SLOT_STATE_OBSOLETE:
 			break;
 		}
 	}
 
+	/*
+	 * Saves write object data ahead of the header, so the first free
+	 * slot could hold data from a save that got interrupted.  Retire
+	 * it if it isn't fully erased.
+	 */
+	if (logfs->num_free_slots > 0) {
+		uint16_t slot_id = num_slots - logfs->num_free_slots;
+		uintptr_t slot_addr = logfs_get_addr (logfs, logfs->active_arena_id, slot_id);
+
+		bool erased = true;
+		for (uint32_t offset = 0; erased && offset < logfs->cfg->slot_size; offset += sizeof(uint32_t)) {
+			uint32_t word;
+			if (PIOS_FLASH_read_data(logfs->partition_id,
+							slot_addr + offset,
+							(uint8_t *)&word,
+							sizeof(word)) != 0) {
+				return -1;
+			}
+			erased = (word == 0xFFFFFFFF);
+		}
+
+		if (!erased && logfs_discard_slot(logfs, slot_id) != 0) {
+			return -1;
+		}
+	}
+
 	/* Scan is complete, mark the arena mounted */
 	logfs->active_arena_id = arena_id;
 	logfs->mounted = true;
@@ -468,6 +642,7 @@ static struct logfs_state *PIOS_FLASHFS_Logfs_alloc(void)
 	logfs = (struct logfs_state *)PIOS_malloc_no_dma(sizeof(*logfs));
 	if (!logfs) return (NULL);
 
+	memset(logfs, 0, sizeof(*logfs));
 	logfs->magic = PIOS_FLASHFS_LOGFS_DEV_MAGIC;
 	return(logfs);
 }
@@ -475,6 +650,10 @@ static void PIOS_FLASHFS_Logfs_free(struct logfs_state *logfs)
 {
 	/* Invalidate the magic */
 	logfs->magic = ~PIOS_FLASHFS_LOGFS_DEV_MAGIC;
+	PIOS_free(logfs->index_buckets);
+	PIOS_free(logfs->slot_next);
+	PIOS_free(logfs->slot_tag);
+	PIOS_free(logfs->gc_copy_slot);
 	PIOS_free(logfs);
 }
 
@@ -520,6 +699,12 @@ int32_t PIOS_FLASHFS_Logfs_Init(uintptr_t *fs_id, const struct flashfs_logfs_cfg
 	logfs->partition_size = partition_size; /* size of underlying partition */
 	logfs->mounted        = false;
 
+	if (logfs_index_alloc(logfs) != 0) {
+		PIOS_FLASHFS_Logfs_free(logfs);
+		rc = -1;
+		goto out_exit;
+	}
+
 	if (PIOS_FLASH_start_transaction(logfs->partition_id) != 0) {
 		rc = -1;
 		goto out_exit;
@@ -586,34 +771,124 @@ out_exit:
 	return rc;
 }
 
+/*
+ * How many slots could garbage collection free up?
+ */
+static uint16_t logfs_num_reclaimable_slots(const struct logfs_state *logfs)
+{
+	uint16_t num_slots = logfs->cfg->arena_size / logfs->cfg->slot_size;
+
+	return (num_slots - 1) - logfs->num_free_slots - logfs->num_active_slots;
+}
+
 /* NOTE: Must be called while holding the flash transaction lock */
-static int32_t logfs_garbage_collect (struct logfs_state *logfs) {
+static void logfs_gc_start(struct logfs_state *logfs)
+{
 	PIOS_Assert (logfs->mounted);
+	PIOS_Assert (logfs->gc_state == LOGFS_GC_IDLE);
 
-	/* Source arena is the active arena */
-	uint8_t src_arena_id = logfs->active_arena_id;
+	/* Destination arena is the one after the active arena */
+	logfs->gc_dst_arena_id = (logfs->active_arena_id + 1) % (logfs->partition_size / logfs->cfg->arena_size);
+	logfs->gc_erase_offset = 0;
+	logfs->gc_state = LOGFS_GC_ERASING;
+}
 
-	/* Compute destination arena */
-	uint8_t dst_arena_id = (logfs->active_arena_id + 1) % (logfs->partition_size / logfs->cfg->arena_size);
+/**
+ * @brief Erases the next sector of the destination arena
+ * @return 0 if success, < 0 on failure
+ * @note Must be called while holding the flash transaction lock
+ */
+static int32_t logfs_gc_erase_step(struct logfs_state *logfs)
+{
+	uintptr_t arena_addr = logfs_get_addr (logfs, logfs->gc_dst_arena_id, 0);
+
+	uint32_t sector_size;
+	if (PIOS_FLASH_get_sector_size(logfs->partition_id,
+					arena_addr + logfs->gc_erase_offset,
+					&sector_size) != 0) {
+		return -1;
+	}
 
-	/* Erase destination arena */
-	if (logfs_erase_arena (logfs, dst_arena_id) != 0) {
+	if (PIOS_FLASH_erase_range(logfs->partition_id,
+					arena_addr + logfs->gc_erase_offset,
+					sector_size) != 0) {
 		return -1;
 	}
 
-	/* Reserve the destination arena so we can start filling it */
-	if (logfs_reserve_arena (logfs, dst_arena_id) != 0) {
+	logfs->gc_erase_offset += sector_size;
+	if (logfs->gc_erase_offset < logfs->cfg->arena_size) {
+		/* More sectors left to erase */
+		return 0;
+	}
+
+	/* Mark the destination arena erased and reserve it so we can start filling it */
+	if (logfs_mark_arena_erased (logfs, logfs->gc_dst_arena_id) != 0) {
+		return -1;
+	}
+	if (logfs_reserve_arena (logfs, logfs->gc_dst_arena_id) != 0) {
 		/* Unable to reserve the arena */
 		return -2;
 	}
 
-	/* Copy active slots from active arena to destination arena */
-	uint16_t dst_slot_id = 1;
-	for (uint16_t src_slot_id = 1;
-	     src_slot_id < (logfs->cfg->arena_size / logfs->cfg->slot_size);
-	     src_slot_id++) {
+	memset(logfs->gc_copy_slot, 0,
+		(logfs->cfg->arena_size / logfs->cfg->slot_size) * sizeof(uint16_t));
+	logfs->gc_src_slot_id = 1;
+	logfs->gc_dst_slot_id = 1;
+	logfs->gc_state = LOGFS_GC_COPYING;
+
+	return 0;
+}
+
+/**
+ * @brief Switches over to the destination arena once every slot is copied
+ * @return 0 if success, < 0 on failure
+ * @note Must be called while holding the flash transaction lock
+ */
+static int32_t logfs_gc_finish(struct logfs_state *logfs)
+{
+	uint8_t src_arena_id = logfs->active_arena_id;
+
+	logfs->gc_state = LOGFS_GC_IDLE;
+
+	/* Activate the destination arena */
+	if (logfs_activate_arena (logfs, logfs->gc_dst_arena_id) != 0) {
+		return -5;
+	}
+
+	/* Unmount the source arena */
+	if (logfs_unmount_log (logfs) != 0) {
+		return -6;
+	}
+
+	/* Obsolete the source arena */
+	if (logfs_obsolete_arena (logfs, src_arena_id) != 0) {
+		return -7;
+	}
+
+	/* Mount the new arena */
+	if (logfs_mount_log (logfs, logfs->gc_dst_arena_id) != 0) {
+		return -8;
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Copies up to max_slots active slots to the destination arena
+ * @return 0 if success, < 0 on failure
+ * @note Slots appended to the log while copying get picked up too, since
+ *       the copy only completes once it catches up with the end of the log
+ * @note Must be called while holding the flash transaction lock
+ */
+static int32_t logfs_gc_copy_step(struct logfs_state *logfs, uint16_t max_slots)
+{
+	uint16_t log_end = (logfs->cfg->arena_size / logfs->cfg->slot_size) - logfs->num_free_slots;
+
+	while (max_slots > 0 && logfs->gc_src_slot_id < log_end) {
+		uint16_t src_slot_id = logfs->gc_src_slot_id;
+
 		struct slot_header slot_hdr;
-		uintptr_t src_addr = logfs_get_addr (logfs, src_arena_id, src_slot_id);
+		uintptr_t src_addr = logfs_get_addr (logfs, logfs->active_arena_id, src_slot_id);
 		if (PIOS_FLASH_read_data(logfs->partition_id,
 						src_addr,
 						(uint8_t *)&slot_hdr,
@@ -622,7 +897,7 @@ static int32_t logfs_garbage_collect (struct logfs_state *logfs) {
 		}
 
 		if (slot_hdr.state == SLOT_STATE_ACTIVE) {
-			uintptr_t dst_addr = logfs_get_addr (logfs, dst_arena_id, dst_slot_id);
+			uintptr_t dst_addr = logfs_get_addr (logfs, logfs->gc_dst_arena_id, logfs->gc_dst_slot_id);
 			if (logfs_raw_copy_bytes(logfs,
 							src_addr,
 							sizeof(slot_hdr) + slot_hdr.obj_size,
@@ -630,46 +905,90 @@ static int32_t logfs_garbage_collect (struct logfs_state *logfs) {
 				/* Failed to copy all bytes */
 				return -4;
 			}
-			dst_slot_id++;
+			logfs->gc_copy_slot[src_slot_id] = logfs->gc_dst_slot_id;
+			logfs->gc_dst_slot_id++;
+			max_slots--;
 		}
+
+		logfs->gc_src_slot_id++;
 	}
 
-	/* Activate the destination arena */
-	if (logfs_activate_arena (logfs, dst_arena_id) != 0) {
-		return -5;
+	if (logfs->gc_src_slot_id < log_end) {
+		/* More slots left to copy */
+		return 0;
 	}
 
-	/* Unmount the source arena */
-	if (logfs_unmount_log (logfs) != 0) {
-		return -6;
+	return logfs_gc_finish(logfs);
+}
+
+/**
+ * @brief Does a bounded slice of garbage collection work
+ * @return 0 if success, < 0 on failure
+ * @note Must be called while holding the flash transaction lock
+ */
+static int32_t logfs_gc_step(struct logfs_state *logfs, uint16_t max_slots)
+{
+	int32_t rc;
+
+	switch (logfs->gc_state) {
+	case LOGFS_GC_ERASING:
+		rc = logfs_gc_erase_step(logfs);
+		break;
+	case LOGFS_GC_COPYING:
+		rc = logfs_gc_copy_step(logfs, max_slots);
+		break;
+	default:
+		rc = 0;
+		break;
 	}
 
-	/* Obsolete the source arena */
-	if (logfs_obsolete_arena (logfs, src_arena_id) != 0) {
-		return -7;
+	if (rc != 0) {
+		/* Start over from scratch next time */
+		logfs->gc_state = LOGFS_GC_IDLE;
 	}
 
-	/* Mount the new arena */
-	if (logfs_mount_log (logfs, dst_arena_id) != 0) {
-		return -8;
+	return rc;
+}
+
+/**
+ * @brief Runs garbage collection to completion, picking up any cycle
+ *        already in progress in the background
+ * @return 0 if success, < 0 on failure
+ * @note Must be called while holding the flash transaction lock
+ */
+static int32_t logfs_garbage_collect (struct logfs_state *logfs) {
+	PIOS_Assert (logfs->mounted);
+
+	if (logfs->gc_state == LOGFS_GC_IDLE) {
+		logfs_gc_start(logfs);
+	}
+
+	while (logfs->gc_state != LOGFS_GC_IDLE) {
+		int32_t rc = logfs_gc_step(logfs, UINT16_MAX);
+		if (rc != 0) {
+			return rc;
+		}
 	}
 
 	return 0;
 }
 
 /* NOTE: Must be called while holding the flash transaction lock */
-static int16_t logfs_object_find_next (const struct logfs_state *logfs, struct slot_header *slot_hdr, uint16_t *curr_slot, uint32_t obj_id, uint16_t obj_inst_id)
+static int16_t logfs_object_find (const struct logfs_state *logfs, struct slot_header *slot_hdr, uint16_t *slot_id, uint32_t obj_id, uint16_t obj_inst_id)
 {
 	PIOS_Assert(slot_hdr);
-	PIOS_Assert(curr_slot);
+	PIOS_Assert(slot_id);
 
-	/* First slot in the arena is reserved for arena header, skip it. */
-	if (*curr_slot == 0) *curr_slot = 1;
+	uint16_t tag = logfs_index_hash(obj_id, obj_inst_id);
 
-	for (uint16_t slot_id = *curr_slot;
-	     slot_id < (logfs->cfg->arena_size / logfs->cfg->slot_size);
-	     slot_id++) {
-		uintptr_t slot_addr = logfs_get_addr (logfs, logfs->active_arena_id, slot_id);
+	for (uint16_t candidate = logfs->index_buckets[tag & (logfs->index_num_buckets - 1)];
+	     candidate != 0;
+	     candidate = logfs->slot_next[candidate]) {
+		if (logfs->slot_tag[candidate] != tag) {
+			continue;
+		}
+
+		uintptr_t slot_addr = logfs_get_addr (logfs, logfs->active_arena_id, candidate);
 
 		if (PIOS_FLASH_read_data(logfs->partition_id,
 						slot_addr,
@@ -677,15 +996,11 @@ static int16_t logfs_object_find_next (const struct logfs_state *logfs, struct s
 						sizeof (*slot_hdr)) != 0) {
 			return -2;
 		}
-		if (slot_hdr->state == SLOT_STATE_EMPTY) {
-			/* We hit the end of the log */
-			break;
-		}
 		if (slot_hdr->state == SLOT_STATE_ACTIVE &&
 			slot_hdr->obj_id      == obj_id &&
 			slot_hdr->obj_inst_id == obj_inst_id) {
 			/* Found what we were looking for */
-			*curr_slot = slot_id;
+			*slot_id = candidate;
 			return 0;
 		}
 	}
@@ -695,16 +1010,16 @@ static int16_t logfs_object_find_next (const struct logfs_state *logfs, struct s
 }
 
 /* NOTE: Must be called while holding the flash transaction lock */
-/* OPTIMIZE: could trust that there is at most one active version of every object and terminate the search when we find one */
+/* Keeps going after the first match, in case an interrupted save left two active versions */
 static int8_t logfs_delete_object (struct logfs_state *logfs, uint32_t obj_id, uint16_t obj_inst_id)
 {
 	int8_t rc;
 
 	bool more = true;
-	uint16_t curr_slot_id = 0;
+	uint16_t curr_slot_id;
 	do {
 		struct slot_header slot_hdr;
-		switch (logfs_object_find_next (logfs, &slot_hdr, &curr_slot_id, obj_id, obj_inst_id)) {
+		switch (logfs_object_find (logfs, &slot_hdr, &curr_slot_id, obj_id, obj_inst_id)) {
 		case 0:
 			/* Found a matching slot.  Obsolete it. */
 			slot_hdr.state = SLOT_STATE_OBSOLETE;
@@ -719,6 +1034,22 @@ static int8_t logfs_delete_object (struct logfs_state *logfs, uint32_t obj_id, u
 			}
 			/* Object has been successfully obsoleted and is no longer active */
 			logfs->num_active_slots--;
+			logfs_index_remove(logfs, curr_slot_id, obj_id, obj_inst_id);
+
+			/* Don't let a collection in progress carry the old version over */
+			if (logfs->gc_state == LOGFS_GC_COPYING &&
+					logfs->gc_copy_slot[curr_slot_id] != 0) {
+				slot_addr = logfs_get_addr (logfs, logfs->gc_dst_arena_id,
+						logfs->gc_copy_slot[curr_slot_id]);
+				if (PIOS_FLASH_write_data(logfs->partition_id,
+								slot_addr,
+								(uint8_t *)&slot_hdr,
+								sizeof(slot_hdr)) != 0) {
+					rc = -2;
+					goto out_exit;
+				}
+				logfs->gc_copy_slot[curr_slot_id] = 0;
+			}
 			break;
 		case -1:
 			/* Search completed, object not found */
@@ -737,17 +1068,16 @@ out_exit:
 }
 
 /* NOTE: Must be called while holding the flash transaction lock */
-static int8_t logfs_reserve_free_slot (struct logfs_state *logfs, uint16_t *slot_id, struct slot_header *slot_hdr, uint32_t obj_id, uint16_t obj_inst_id, uint16_t obj_size)
+static int8_t logfs_claim_free_slot (struct logfs_state *logfs, uint16_t *slot_id, uint16_t obj_size)
 {
 	PIOS_Assert(slot_id);
-	PIOS_Assert(slot_hdr);
 
 	if (logfs->num_free_slots < 1) {
 		/* No free slots to allocate */
 		return -1;
 	}
 
-	if (obj_size > (logfs->cfg->slot_size - sizeof (slot_hdr))) {
+	if (obj_size > (logfs->cfg->slot_size - sizeof (struct slot_header))) {
 		/* This object is too big for the slot */
 		return -2;
 	}
@@ -757,70 +1087,71 @@ static int8_t logfs_reserve_free_slot (struct logfs_state *logfs, uint16_t *slot
 
 	uintptr_t slot_addr = logfs_get_addr (logfs, logfs->active_arena_id, candidate_slot_id);
 
+	struct slot_header slot_hdr;
 	if (PIOS_FLASH_read_data(logfs->partition_id,
 					slot_addr,
-					(uint8_t *)slot_hdr,
-					sizeof (*slot_hdr)) != 0) {
+					(uint8_t *)&slot_hdr,
+					sizeof (slot_hdr)) != 0) {
 		/* Failed to read slot header for candidate slot */
 		return -3;
 	}
 
-	if (slot_hdr->state != SLOT_STATE_EMPTY) {
+	if (slot_hdr.state != SLOT_STATE_EMPTY) {
 		/* Candidate slot isn't empty!  Something is broken. */
 		PIOS_DEBUG_Assert(0);
 		return -4;
 	}
 
-	/* Mark this slot as RESERVED */
-	slot_hdr->state       = SLOT_STATE_RESERVED;
-	slot_hdr->obj_id      = obj_id;
-	slot_hdr->obj_inst_id = obj_inst_id;
-	slot_hdr->obj_size    = obj_size;
-
-	if (PIOS_FLASH_write_data(logfs->partition_id,
-					slot_addr,
-					(uint8_t *)slot_hdr,
-					sizeof(*slot_hdr)) != 0) {
-		/* Failed to write the slot header */
-		return -5;
-	}
-
-	/* FIXME: If the header write (above) failed, may have partially written data, thus corrupting that slot but we would have missed decrementing this counter */
-	logfs->num_free_slots--;
-
 	*slot_id = candidate_slot_id;
 	return 0;
 }
 
+/*
+ * The object data goes into the slot first, and the header only gets
+ * written once it's complete, taking the slot straight from empty to
+ * active.  That saves programming a reserved header first, at the cost
+ * of mount having to check that the first free slot isn't left over
+ * from an interrupted save.
+ */
+
 /* NOTE: Must be called while holding the flash transaction lock */
 static int8_t logfs_append_to_log (struct logfs_state *logfs, uint32_t obj_id, uint16_t obj_inst_id, uint8_t *obj_data, uint16_t obj_size)
 {
-	/* Reserve a free slot for our new object */
+	/* Find a free slot for our new object */
 	uint16_t free_slot_id;
-	struct slot_header slot_hdr;
-	if (logfs_reserve_free_slot (logfs, &free_slot_id, &slot_hdr, obj_id, obj_inst_id, obj_size) != 0) {
-		/* Failed to reserve a free slot */
+	if (logfs_claim_free_slot (logfs, &free_slot_id, obj_size) != 0) {
+		/* Failed to find a free slot */
 		return -1;
 	}
 
 	/* Compute slot address */
 	uintptr_t slot_addr = logfs_get_addr (logfs, logfs->active_arena_id, free_slot_id);
 
-	/* Write the data into the reserved slot, starting after the slot header */
+	/* Write the data into the slot, starting after the slot header */
 	if (obj_size > 0) {
-		uintptr_t slot_offset = sizeof(slot_hdr);
+		uintptr_t slot_offset = sizeof(struct slot_header);
 
 		if (PIOS_FLASH_write_data(logfs->partition_id,
 						slot_addr + slot_offset,
 						obj_data,
 						obj_size) != 0) {
 			/* Failed to write the object data to the slot */
+			logfs_discard_slot(logfs, free_slot_id);
 			return -2;
 		}
 	}
 
 	/* Mark this slot active in one atomic step */
-	slot_hdr.state = SLOT_STATE_ACTIVE;
+	struct slot_header slot_hdr = {
+		.state       = SLOT_STATE_ACTIVE,
+		.obj_id      = obj_id,
+		.obj_inst_id = obj_inst_id,
+		.obj_size    = obj_size,
+	};
+
+	/* FIXME: If the header write fails, it may have been partially written, in which case mount will find an invalid slot */
+	logfs->num_free_slots--;
+
 	if (PIOS_FLASH_write_data(logfs->partition_id,
 					slot_addr,
 					(uint8_t *)&slot_hdr,
@@ -831,9 +1162,47 @@ static int8_t logfs_append_to_log (struct logfs_state *logfs, uint32_t obj_id, u
 
 	/* Object has been successfully written to the slot */
 	logfs->num_active_slots++;
+	logfs_index_add(logfs, free_slot_id, obj_id, obj_inst_id);
 	return 0;
 }
 
+/**
+ * @brief Checks whether an active slot already holds exactly this data
+ * @return true if the contents match, false if they differ or can't be read
+ * @note Must be called while holding the flash transaction lock
+ */
+static bool logfs_object_matches (const struct logfs_state *logfs, uint16_t slot_id, const struct slot_header *slot_hdr, const uint8_t *obj_data, uint16_t obj_size)
+{
+	if (slot_hdr->obj_size != obj_size) {
+		return false;
+	}
+
+	uintptr_t data_addr = logfs_get_addr (logfs, logfs->active_arena_id, slot_id) + sizeof(*slot_hdr);
+
+#define COMPARE_BLOCK_SIZE 16
+	uint8_t data_block[COMPARE_BLOCK_SIZE];
+
+	while (obj_size) {
+		uint16_t blk_size = MIN(obj_size, COMPARE_BLOCK_SIZE);
+
+		if (PIOS_FLASH_read_data(logfs->partition_id,
+						data_addr,
+						data_block,
+						blk_size) != 0) {
+			return false;
+		}
+		if (memcmp(data_block, obj_data, blk_size) != 0) {
+			return false;
+		}
+
+		obj_size  -= blk_size;
+		obj_data  += blk_size;
+		data_addr += blk_size;
+	}
+
+	return true;
+}
+
 
 /**********************************
  *
@@ -857,6 +1226,7 @@ static int8_t logfs_append_to_log (struct logfs_state *logfs, uint32_t obj_id, u
  * @retval -5 if garbage collection failed
  * @retval -6 if filesystem is full even after garbage collection should have freed space
  * @retval -7 if writing the new object to the filesystem failed
+ * @note Saving an object identical to the stored version writes nothing
  */
 int32_t PIOS_FLASHFS_ObjSave(uintptr_t fs_id, uint32_t obj_id, uint16_t obj_inst_id, uint8_t *obj_data, uint16_t obj_size)
 {
@@ -876,6 +1246,15 @@ int32_t PIOS_FLASHFS_ObjSave(uintptr_t fs_id, uint32_t obj_id, uint16_t obj_inst
 		goto out_exit;
 	}
 
+	/* Nothing to write if the stored version is already identical */
+	uint16_t slot_id;
+	struct slot_header slot_hdr;
+	if (logfs_object_find (logfs, &slot_hdr, &slot_id, obj_id, obj_inst_id) == 0 &&
+			logfs_object_matches (logfs, slot_id, &slot_hdr, obj_data, obj_size)) {
+		rc = 0;
+		goto out_end_trans;
+	}
+
 	if (logfs_delete_object (logfs, obj_id, obj_inst_id) != 0) {
 		rc = -3;
 		goto out_end_trans;
@@ -963,9 +1342,9 @@ int32_t PIOS_FLASHFS_ObjLoad(uintptr_t fs_id, uint32_t obj_id, uint16_t obj_inst
 	}
 
 	/* Find the object in the log */
-	uint16_t slot_id = 0;
+	uint16_t slot_id;
 	struct slot_header slot_hdr;
-	if (logfs_object_find_next (logfs, &slot_hdr, &slot_id, obj_id, obj_inst_id) != 0) {
+	if (logfs_object_find (logfs, &slot_hdr, &slot_id, obj_id, obj_inst_id) != 0) {
 		/* Object does not exist in fs */
 		rc = -3;
 		goto out_end_trans;
@@ -1042,6 +1421,72 @@ out_exit:
 	return rc;
 }
 
+/**
+ * @brief Does a bounded slice of background maintenance on the filesystem
+ * @param[in] fs_id The filesystem to use for this action
+ * @return 0 if there's nothing more to do, 1 if more work remains, or error code
+ * @retval -1 if fs_id is not a valid filesystem instance
+ * @retval -2 if failed to start transaction
+ * @retval -3 if garbage collection failed
+ * @note Call this periodically from a low priority task.  Each call erases
+ * at most one sector or migrates a handful of slots, and once the log is
+ * getting full it collects garbage ahead of time so that saves don't stall.
+ */
+int32_t PIOS_FLASHFS_Maintain(uintptr_t fs_id)
+{
+	int32_t rc;
+
+	struct logfs_state *logfs = (struct logfs_state *)fs_id;
+
+	if (!PIOS_FLASHFS_Logfs_validate(logfs)) {
+		rc = -1;
+		goto out_exit;
+	}
+
+	uint16_t num_slots = logfs->cfg->arena_size / logfs->cfg->slot_size;
+
+	/* Cheap check without the lock for the common case of nothing to do */
+	if (logfs->gc_state == LOGFS_GC_IDLE &&
+			logfs->num_free_slots > LOGFS_GC_START_FREE_SLOTS(num_slots)) {
+		rc = 0;
+		goto out_exit;
+	}
+
+	if (PIOS_FLASH_start_transaction(logfs->partition_id) != 0) {
+		rc = -2;
+		goto out_exit;
+	}
+
+	if (!logfs->mounted) {
+		rc = 0;
+		goto out_end_trans;
+	}
+
+	if (logfs->gc_state == LOGFS_GC_IDLE) {
+		/* Only worth collecting if it would free something up */
+		if (logfs->num_free_slots > LOGFS_GC_START_FREE_SLOTS(num_slots) ||
+				logfs_num_reclaimable_slots(logfs) == 0) {
+			rc = 0;
+			goto out_end_trans;
+		}
+
+		logfs_gc_start(logfs);
+	}
+
+	if (logfs_gc_step(logfs, LOGFS_GC_SLOTS_PER_STEP) != 0) {
+		rc = -3;
+		goto out_end_trans;
+	}
+
+	rc = (logfs->gc_state != LOGFS_GC_IDLE) ? 1 : 0;
+
+out_end_trans:
+	PIOS_FLASH_end_transaction(logfs->partition_id);
+
+out_exit:
+	return rc;
+}
+
 /**
  * @brief Erases all filesystem arenas and activate the first arena
  * @param[in] fs_id The filesystem to use for this action
@@ -1067,6 +1512,8 @@ int32_t PIOS_FLASHFS_Format(uintptr_t fs_id)
 		logfs_unmount_log(logfs);
 	}
 
+	logfs->gc_state = LOGFS_GC_IDLE;
+
 	if (PIOS_FLASH_start_transaction(logfs->partition_id) != 0) {
 		rc = -2;
 		goto out_exit;
@@ -155,6 +155,15 @@ uintptr_t pios_com_debug_id;
 #define PIOS_COM_TELEM_USB_TX_BUF_LEN 65
 #endif
 
+/* Enough to fill a multi-packet CDC transfer while the last one goes out */
+#ifndef PIOS_COM_TELEM_USB_CDC_TX_BUF_LEN
+#if defined(STM32F4XX)
+#define PIOS_COM_TELEM_USB_CDC_TX_BUF_LEN 513
+#else
+#define PIOS_COM_TELEM_USB_CDC_TX_BUF_LEN PIOS_COM_TELEM_USB_TX_BUF_LEN
+#endif
+#endif
+
 #ifndef PIOS_COM_BRIDGE_RX_BUF_LEN
 #define PIOS_COM_BRIDGE_RX_BUF_LEN 65
 #endif
@@ -167,6 +176,10 @@ uintptr_t pios_com_debug_id;
 #define PIOS_COM_MAVLINK_TX_BUF_LEN 128
 #endif
 
+#ifndef PIOS_COM_MAVLINK_RX_BUF_LEN
+#define PIOS_COM_MAVLINK_RX_BUF_LEN 32
+#endif
+
 #ifndef PIOS_COM_MSP_TX_BUF_LEN
 #define PIOS_COM_MSP_TX_BUF_LEN 128
 #endif
@@ -259,7 +272,7 @@ static const struct pios_bmp280_cfg external_bmp280_cfg = {
 
 static const struct pios_ms5611_cfg external_ms5611_cfg = {
 	.oversampling             = MS5611_OSR_4096,
-	.temperature_interleaving = 1,
+	.temperature_interleaving = 10,
 	.use_0x76_address         = false,
 };
 #endif
@@ -621,6 +634,7 @@ void PIOS_HAL_ConfigurePort(HwSharedPortTypesOptions port_type,
 	usart_port_params.tx_invert   = false; // Only used by F3 targets
 	usart_port_params.rxtx_swap   = false; // Only used by F3 targets
 	usart_port_params.single_wire = false; // Only used by F3 targets
+	usart_port_params.dma         = false;
 
 	// If there is a hardware inverter for this port
 	if (sbus_cfg != NULL) {
@@ -644,6 +658,7 @@ void PIOS_HAL_ConfigurePort(HwSharedPortTypesOptions port_type,
 		break;
 
 	case HWSHARED_PORTTYPES_COMBRIDGE:
+		usart_port_params.dma = true;
 		PIOS_HAL_ConfigureCom(usart_port_cfg, &usart_port_params, PIOS_COM_BRIDGE_RX_BUF_LEN, PIOS_COM_BRIDGE_TX_BUF_LEN, com_driver, &port_driver_id);
 		target = &pios_com_bridge_id;
 		//module is enabled by the USB port config rather than here
@@ -787,7 +802,8 @@ void PIOS_HAL_ConfigurePort(HwSharedPortTypesOptions port_type,
 
 	case HWSHARED_PORTTYPES_MAVLINKTX:
 #if defined(PIOS_INCLUDE_MAVLINK)
-		PIOS_HAL_ConfigureCom(usart_port_cfg, &usart_port_params, 0, PIOS_COM_MAVLINK_TX_BUF_LEN, com_driver, &port_driver_id);
+		usart_port_params.dma = true;
+		PIOS_HAL_ConfigureCom(usart_port_cfg, &usart_port_params, PIOS_COM_MAVLINK_RX_BUF_LEN, PIOS_COM_MAVLINK_TX_BUF_LEN, com_driver, &port_driver_id);
 		target = &pios_com_mavlink_id;
 		PIOS_Modules_Enable(PIOS_MODULE_UAVOMAVLINKBRIDGE);
 #endif          /* PIOS_INCLUDE_MAVLINK */
@@ -795,6 +811,7 @@ void PIOS_HAL_ConfigurePort(HwSharedPortTypesOptions port_type,
 
 	case HWSHARED_PORTTYPES_MAVLINKTX_GPS_RX:
 #if defined(PIOS_INCLUDE_MAVLINK)
+		usart_port_params.dma = true;
 		PIOS_HAL_ConfigureCom(usart_port_cfg, &usart_port_params, PIOS_COM_GPS_RX_BUF_LEN, PIOS_COM_MAVLINK_TX_BUF_LEN, com_driver, &port_driver_id);
 		target = &pios_com_mavlink_id;
 		target2 = &pios_com_gps_id;
@@ -805,6 +822,7 @@ void PIOS_HAL_ConfigurePort(HwSharedPortTypesOptions port_type,
 
 	case HWSHARED_PORTTYPES_MSP:
 #if defined(PIOS_INCLUDE_MSP_BRIDGE)
+		usart_port_params.dma = true;
 		PIOS_HAL_ConfigureCom(usart_port_cfg, &usart_port_params, PIOS_COM_MSP_RX_BUF_LEN, PIOS_COM_MSP_TX_BUF_LEN, com_driver, &port_driver_id);
 		target = &pios_com_msp_id;
 		PIOS_Modules_Enable(PIOS_MODULE_UAVOMSPBRIDGE);
@@ -906,6 +924,7 @@ void PIOS_HAL_ConfigurePort(HwSharedPortTypesOptions port_type,
 		break;
 
 	case HWSHARED_PORTTYPES_TELEMETRY:
+		usart_port_params.dma = true;
 		PIOS_HAL_ConfigureCom(usart_port_cfg, &usart_port_params, PIOS_COM_TELEM_RF_RX_BUF_LEN, PIOS_COM_TELEM_RF_TX_BUF_LEN, com_driver, &port_driver_id);
 		target = &pios_com_telem_serial_id;
 		break;
@@ -988,7 +1007,7 @@ void PIOS_HAL_ConfigureCDC(HwSharedUSB_VCPPortOptions port_type,
 	{
 		if (PIOS_COM_Init(&pios_com_telem_usb_id, &pios_usb_cdc_com_driver, pios_usb_cdc_id,
 						PIOS_COM_TELEM_USB_RX_BUF_LEN,
-						PIOS_COM_TELEM_USB_TX_BUF_LEN)) {
+						PIOS_COM_TELEM_USB_CDC_TX_BUF_LEN)) {
 			PIOS_Assert(0);
 		}
 	}
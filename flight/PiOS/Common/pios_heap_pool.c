@@ -0,0 +1,276 @@
+/**
+ ******************************************************************************
+ * @file       pios_heap_pool.c
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2017
+ * @addtogroup PIOS PIOS Core hardware abstraction layer
+ * @{
+ * @addtogroup PIOS_HEAP Heap Allocation Abstraction
+ * @{
+ * @brief Fixed size block pools, for memory that has to be given back
+ *
+ * The heap itself never frees anything.  Memory that is taken and given
+ * back at runtime can come from these pools instead: each power of two size
+ * class keeps a list of freed blocks, and a block only comes from the heap
+ * when its list is empty.  Blocks never go back to the heap, but freeing
+ * one makes it available for the next allocation of that class.
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "pios.h"
+#include "pios_heap.h"
+#include "pios_irq.h"
+
+#include <stddef.h>		/* offsetof */
+
+#if defined(FLIGHT_POSIX)
+#include <pthread.h>
+
+/* No interrupts to mask there, but the threads are real */
+static pthread_mutex_t pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+#define POOL_LOCK() pthread_mutex_lock(&pool_mutex)
+#define POOL_UNLOCK() pthread_mutex_unlock(&pool_mutex)
+#else
+#define POOL_LOCK() PIOS_IRQ_Disable()
+#define POOL_UNLOCK() PIOS_IRQ_Enable()
+#endif
+
+//! Blocks in class n are (POOL_MIN_BLOCK << n) bytes
+#define POOL_MIN_BLOCK_LOG2 4
+#define POOL_MIN_BLOCK (1 << POOL_MIN_BLOCK_LOG2)
+
+//! Marks a block that was too large for any class
+#define POOL_UNPOOLED 0xff
+
+/**
+ * A block, as seen from just before the memory handed out.  The class is
+ * kept ahead of the data, where it survives while the block is in use; the
+ * link to the next free block overlaps the data, since it's only needed
+ * while nobody else has the block.
+ */
+struct pool_block {
+	uint8_t class_idx;
+	struct pool_block *next;
+};
+
+struct pool_class {
+	struct pool_block *free_list;
+	struct pios_pool_stats stats;
+};
+
+static struct pool_class pool_classes[PIOS_POOL_NUM_CLASSES];
+
+//! Space taken ahead of each block, a whole word so the data stays aligned
+#define POOL_HEADER_SIZE ((offsetof(struct pool_block, next) + sizeof(uintptr_t) - 1) & ~(sizeof(uintptr_t) - 1))
+
+static int pool_class_for(size_t size)
+{
+	size_t block = POOL_MIN_BLOCK;
+
+	for (int i = 0; i < PIOS_POOL_NUM_CLASSES; i++) {
+		if (size <= block)
+			return i;
+
+		block <<= 1;
+	}
+
+	return -1;
+}
+
+static uint16_t pool_block_size(int class_idx)
+{
+	return POOL_MIN_BLOCK << class_idx;
+}
+
+/**
+ * Takes a new block for a class from the heap.  Must not be called from an
+ * interrupt, since the heap suspends the scheduler.
+ */
+static struct pool_block *pool_carve(int class_idx)
+{
+	struct pool_block *blk = PIOS_malloc(POOL_HEADER_SIZE +
+			pool_block_size(class_idx));
+
+	if (!blk)
+		return NULL;
+
+	blk->class_idx = class_idx;
+
+	return blk;
+}
+
+static void *pool_data(struct pool_block *blk)
+{
+	return ((uint8_t *) blk) + POOL_HEADER_SIZE;
+}
+
+static struct pool_block *pool_block_of(void *buf)
+{
+	return (struct pool_block *) (((uint8_t *) buf) - POOL_HEADER_SIZE);
+}
+
+/**
+ * Allocates a block big enough for size bytes.  The memory is DMA-safe.
+ * Blocks freed by PIOS_pool_free are reused first; only when there are none
+ * of the right size is a new one taken from the heap, so this must not be
+ * called from an interrupt unless PIOS_pool_reserve has set blocks aside.
+ * Requests larger than the largest class come straight from the heap, and
+ * freeing them does nothing.
+ * \param[in] size bytes needed
+ * \return the memory, or NULL if there wasn't any
+ */
+void *PIOS_pool_malloc(size_t size)
+{
+	int class_idx = pool_class_for(size);
+
+	if (class_idx < 0) {
+		struct pool_block *blk = PIOS_malloc(POOL_HEADER_SIZE + size);
+
+		if (!blk)
+			return NULL;
+
+		blk->class_idx = POOL_UNPOOLED;
+
+		return pool_data(blk);
+	}
+
+	struct pool_class *pc = &pool_classes[class_idx];
+
+	POOL_LOCK();
+
+	struct pool_block *blk = pc->free_list;
+
+	if (blk) {
+		pc->free_list = blk->next;
+		pc->stats.in_use++;
+
+		if (pc->stats.in_use > pc->stats.peak)
+			pc->stats.peak = pc->stats.in_use;
+	}
+
+	POOL_UNLOCK();
+
+	if (blk)
+		return pool_data(blk);
+
+	blk = pool_carve(class_idx);
+
+	POOL_LOCK();
+
+	if (blk) {
+		pc->stats.carved++;
+		pc->stats.in_use++;
+
+		if (pc->stats.in_use > pc->stats.peak)
+			pc->stats.peak = pc->stats.in_use;
+	} else {
+		pc->stats.failures++;
+	}
+
+	POOL_UNLOCK();
+
+	return blk ? pool_data(blk) : NULL;
+}
+
+/**
+ * Gives back a block from PIOS_pool_malloc, so that the next allocation of
+ * the same size class can have it.  Safe to call from an interrupt.
+ * \param[in] buf the block, or NULL
+ */
+void PIOS_pool_free(void *buf)
+{
+	if (!buf)
+		return;
+
+	struct pool_block *blk = pool_block_of(buf);
+
+	if (blk->class_idx == POOL_UNPOOLED)
+		return;
+
+	PIOS_Assert(blk->class_idx < PIOS_POOL_NUM_CLASSES);
+
+	struct pool_class *pc = &pool_classes[blk->class_idx];
+
+	POOL_LOCK();
+
+	blk->next = pc->free_list;
+	pc->free_list = blk;
+	pc->stats.in_use--;
+
+	POOL_UNLOCK();
+}
+
+/**
+ * Sets blocks aside ahead of time, while the heap still has room, so that
+ * later allocations of this size don't depend on what is left then and can
+ * be made from an interrupt.
+ * \param[in] size bytes per block
+ * \param[in] count blocks wanted on the free list
+ * \return 0 on success, -1 if the size is too large or the heap ran out
+ */
+int32_t PIOS_pool_reserve(size_t size, uint16_t count)
+{
+	int class_idx = pool_class_for(size);
+
+	if (class_idx < 0)
+		return -1;
+
+	struct pool_class *pc = &pool_classes[class_idx];
+
+	for (uint16_t i = 0; i < count; i++) {
+		struct pool_block *blk = pool_carve(class_idx);
+
+		if (!blk)
+			return -1;
+
+		POOL_LOCK();
+
+		blk->next = pc->free_list;
+		pc->free_list = blk;
+		pc->stats.carved++;
+
+		POOL_UNLOCK();
+	}
+
+	return 0;
+}
+
+/**
+ * Reports how one size class has been used.
+ * \param[in] class_idx which class, below PIOS_POOL_NUM_CLASSES
+ * \param[out] stats where to put the numbers
+ * \return 0 on success, -1 if there is no such class
+ */
+int32_t PIOS_pool_get_stats(uint8_t class_idx, struct pios_pool_stats *stats)
+{
+	if (class_idx >= PIOS_POOL_NUM_CLASSES)
+		return -1;
+
+	POOL_LOCK();
+
+	*stats = pool_classes[class_idx].stats;
+
+	POOL_UNLOCK();
+
+	stats->block_size = pool_block_size(class_idx);
+
+	return 0;
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -34,9 +34,8 @@
 
 #if defined(PIOS_INCLUDE_HMC5883)
 
-#include "pios_semaphore.h"
 #include "pios_thread.h"
-#include "pios_queue.h"
+#include "pios_spsc_queue.h"
 
 /* Private constants */
 #define HMC5883_TASK_PRIORITY        PIOS_THREAD_PRIO_HIGHEST
@@ -53,11 +52,20 @@ enum pios_hmc5883_dev_magic {
 struct hmc5883_dev {
 	pios_i2c_t i2c_id;
 	const struct pios_hmc5883_cfg *cfg;
-	struct pios_queue *queue;
+	struct pios_spsc_queue *queue;
 	struct pios_thread *task;
-	struct pios_semaphore *data_ready_sema;
 	enum pios_hmc5883_dev_magic magic;
 	enum pios_hmc5883_orientation orientation;
+
+	/* Reads the data registers and sets the mode again.  With a data ready
+	 * line in continuous mode it's started from the interrupt and
+	 * finishes in the I2C interrupt, with no task at all. */
+	struct pios_i2c_txn read_txns[3];
+	uint8_t read_addr;
+	uint8_t read_buf[6];
+	uint8_t mode_buf[2];
+	volatile bool read_pending;
+	bool use_drdy;
 };
 
 /* Local Variables */
@@ -65,6 +73,10 @@ static int32_t PIOS_HMC5883_Config(const struct pios_hmc5883_cfg * cfg);
 static int32_t PIOS_HMC5883_Read(uint8_t address, uint8_t * buffer, uint8_t len);
 static int32_t PIOS_HMC5883_Write(uint8_t address, uint8_t buffer);
 static void PIOS_HMC5883_Task(void *parameters);
+static void PIOS_HMC5883_SetupRead(void);
+#ifndef PIOS_HMC5883_NO_EXTI
+static void PIOS_HMC5883_StartRead(void);
+#endif
 
 static struct hmc5883_dev *dev;
 
@@ -80,7 +92,7 @@ static struct hmc5883_dev * PIOS_HMC5883_alloc(void)
 	
 	hmc5883_dev->magic = PIOS_HMC5883_DEV_MAGIC;
 	
-	hmc5883_dev->queue = PIOS_Queue_Create(PIOS_HMC5883_MAX_DOWNSAMPLE, sizeof(struct pios_sensor_mag_data));
+	hmc5883_dev->queue = PIOS_SPSC_Queue_Create(sizeof(struct pios_sensor_mag_data), PIOS_HMC5883_MAX_DOWNSAMPLE, 1);
 	if (hmc5883_dev->queue == NULL) {
 		PIOS_free(hmc5883_dev);
 		return NULL;
@@ -117,18 +129,15 @@ int32_t PIOS_HMC5883_Init(pios_i2c_t i2c_id, const struct pios_hmc5883_cfg *cfg)
 	dev->cfg = cfg;
 	dev->i2c_id = i2c_id;
 	dev->orientation = cfg->Default_Orientation;
+	dev->use_drdy = false;
+	dev->read_pending = false;
+
+	PIOS_HMC5883_SetupRead();
 
 	/* check if we are using an irq line */
 #ifndef PIOS_HMC5883_NO_EXTI
-	if (cfg->exti_cfg != NULL) {
+	if (cfg->exti_cfg != NULL)
 		PIOS_EXTI_Init(cfg->exti_cfg);
-
-		dev->data_ready_sema = PIOS_Semaphore_Create();
-		PIOS_Assert(dev->data_ready_sema != NULL);
-	}
-	else {
-		dev->data_ready_sema = NULL;
-	}
 #endif
 
 	if (PIOS_HMC5883_Config(cfg) != 0)
@@ -136,6 +145,17 @@ int32_t PIOS_HMC5883_Init(pios_i2c_t i2c_id, const struct pios_hmc5883_cfg *cfg)
 
 	PIOS_SENSORS_Register(PIOS_SENSOR_MAG, dev->queue);
 
+#ifndef PIOS_HMC5883_NO_EXTI
+	if (cfg->exti_cfg != NULL && cfg->Mode == PIOS_HMC5883_MODE_CONTINUOUS) {
+		dev->use_drdy = true;
+
+		/* In case data ready went by during the configuration */
+		PIOS_HMC5883_StartRead();
+
+		return 0;
+	}
+#endif
+
 	dev->task = PIOS_Thread_Create(PIOS_HMC5883_Task, "pios_hmc5883", HMC5883_TASK_STACK_BYTES, NULL, HMC5883_TASK_PRIORITY);
 
 	PIOS_Assert(dev->task != NULL);
@@ -262,55 +282,52 @@ static uint16_t PIOS_HMC5883_Config_GetSensitivity()
 }
 
 /**
- * @brief Read current X, Z, Y values (in that order)
- * \param[out] int16_t array of size 3 to store X, Z, and Y magnetometer readings
- * \return 0 for success or -1 for failure
+ * @brief Fills in the transactions that read the data registers
  */
-static int32_t PIOS_HMC5883_ReadMag(struct pios_sensor_mag_data *mag_data)
+static void PIOS_HMC5883_SetupRead(void)
 {
-	if (PIOS_HMC5883_Validate(dev) != 0)
-		return -1;
-
 	/* don't use PIOS_HMC5883_Read and PIOS_HMC5883_Write here because the task could be
 	 * switched out of context in between which would give the sensor less time to capture
 	 * the next sample.
 	 */
-	uint8_t addr_read = PIOS_HMC5883_DATAOUT_XMSB_REG;
-	uint8_t buffer_read[6];
+	dev->read_addr = PIOS_HMC5883_DATAOUT_XMSB_REG;
 
 	// PIOS_HMC5883_MODE_CONTINUOUS: This should not be necessary but for some reason it is coming out of continuous conversion mode
 	// PIOS_HMC5883_MODE_SINGLE: This triggers the next measurement
-	uint8_t buffer_write[2] = {
-		PIOS_HMC5883_MODE_REG,
-		dev->cfg->Mode
+	dev->mode_buf[0] = PIOS_HMC5883_MODE_REG;
+	dev->mode_buf[1] = dev->cfg->Mode;
+
+	dev->read_txns[0] = (struct pios_i2c_txn) {
+		.info = __func__,
+		.addr = PIOS_HMC5883_I2C_ADDR,
+		.rw = PIOS_I2C_TXN_WRITE,
+		.len = sizeof(dev->read_addr),
+		.buf = &dev->read_addr,
 	};
-
-	const struct pios_i2c_txn txn_list[] = {
-		{
-			.info = __func__,
-			.addr = PIOS_HMC5883_I2C_ADDR,
-			.rw = PIOS_I2C_TXN_WRITE,
-			.len = sizeof(addr_read),
-			.buf = &addr_read,
-		},
-		{
-			.info = __func__,
-			.addr = PIOS_HMC5883_I2C_ADDR,
-			.rw = PIOS_I2C_TXN_READ,
-			.len = sizeof(buffer_read),
-			.buf = buffer_read,
-		},
-		{
-			.info = __func__,
-			.addr = PIOS_HMC5883_I2C_ADDR,
-			.rw = PIOS_I2C_TXN_WRITE,
-			.len = sizeof(buffer_write),
-			.buf = buffer_write,
-		},
+	dev->read_txns[1] = (struct pios_i2c_txn) {
+		.info = __func__,
+		.addr = PIOS_HMC5883_I2C_ADDR,
+		.rw = PIOS_I2C_TXN_READ,
+		.len = sizeof(dev->read_buf),
+		.buf = dev->read_buf,
 	};
+	dev->read_txns[2] = (struct pios_i2c_txn) {
+		.info = __func__,
+		.addr = PIOS_HMC5883_I2C_ADDR,
+		.rw = PIOS_I2C_TXN_WRITE,
+		.len = sizeof(dev->mode_buf),
+		.buf = dev->mode_buf,
+	};
+}
 
-	if (PIOS_I2C_Transfer(dev->i2c_id, txn_list, NELEMENTS(txn_list)) != 0)
-		return -1;
+/**
+ * @brief Converts the X, Z, Y values (in that order) last read into the
+ * board frame
+ * \param[out] mag_data the reading
+ */
+static void PIOS_HMC5883_ConvertMag(struct pios_sensor_mag_data *mag_data)
+{
+	const uint8_t *buffer_read = dev->read_buf;
 
 	int16_t mag_x, mag_y, mag_z;
 	uint16_t sensitivity = PIOS_HMC5883_Config_GetSensitivity();
@@ -361,7 +378,23 @@ static int32_t PIOS_HMC5883_ReadMag(struct pios_sensor_mag_data *mag_data)
 			mag_data->z = mag_z;
 			break;
 	}
-	
+}
+
+/**
+ * @brief Read current X, Z, Y values
+ * \param[out] mag_data the reading
+ * \return 0 for success or -1 for failure
+ */
+static int32_t PIOS_HMC5883_ReadMag(struct pios_sensor_mag_data *mag_data)
+{
+	if (PIOS_HMC5883_Validate(dev) != 0)
+		return -1;
+
+	if (PIOS_I2C_Transfer(dev->i2c_id, dev->read_txns, NELEMENTS(dev->read_txns)) != 0)
+		return -1;
+
+	PIOS_HMC5883_ConvertMag(mag_data);
+
 	return 0;
 }
 
@@ -471,13 +504,41 @@ int32_t PIOS_HMC5883_Test(void)
 #ifndef PIOS_HMC5883_NO_EXTI
 bool PIOS_HMC5883_IRQHandler(void)
 {
-	if (PIOS_HMC5883_Validate(dev) != 0)
+	if (PIOS_HMC5883_Validate(dev) != 0 || !dev->use_drdy)
 		return false;
 
-	bool woken = false;
-	PIOS_Semaphore_Give_FromISR(dev->data_ready_sema, &woken);
+	PIOS_HMC5883_StartRead();
 
-	return woken;
+	return false;
+}
+
+/**
+ * @brief Queues the reading just made behind whatever else is on the bus
+ */
+static void PIOS_HMC5883_ReadDone(void *ctx, int32_t result, bool *woken)
+{
+	dev->read_pending = false;
+
+	if (result != 0)
+		return;
+
+	struct pios_sensor_mag_data mag_data;
+	PIOS_HMC5883_ConvertMag(&mag_data);
+
+	PIOS_SPSC_Queue_Send(dev->queue, &mag_data, 1, woken);
+}
+
+static void PIOS_HMC5883_StartRead(void)
+{
+	PIOS_IRQ_Disable();
+
+	if (!dev->read_pending) {
+		dev->read_pending = PIOS_I2C_Transfer_Callback(dev->i2c_id,
+				dev->read_txns, NELEMENTS(dev->read_txns),
+				PIOS_HMC5883_ReadDone, NULL) == 0;
+	}
+
+	PIOS_IRQ_Enable();
 }
 #endif
 
@@ -520,18 +581,11 @@ static void PIOS_HMC5883_Task(void *parameters)
 	uint32_t now = PIOS_Thread_Systime();
 
 	while (1) {
-		if ((dev->data_ready_sema != NULL) && (dev->cfg->Mode == PIOS_HMC5883_MODE_CONTINUOUS)) {
-			if (PIOS_Semaphore_Take(dev->data_ready_sema, PIOS_SEMAPHORE_TIMEOUT_MAX) != true) {
-				PIOS_Thread_Sleep(100);
-				continue;
-			}
-		} else {
-			PIOS_Thread_Sleep_Until(&now, sample_delay);
-		}
+		PIOS_Thread_Sleep_Until(&now, sample_delay);
 
 		struct pios_sensor_mag_data mag_data;
 		if (PIOS_HMC5883_ReadMag(&mag_data) == 0)
-			PIOS_Queue_Send(dev->queue, &mag_data, 0);
+			PIOS_SPSC_Queue_Send(dev->queue, &mag_data, 1, NULL);
 	}
 }
 
@@ -88,6 +88,7 @@
 
 /* Forward Declarations */
 static int32_t PIOS_HSUM_Get(uintptr_t rcvr_id, uint8_t channel);
+static int32_t PIOS_HSUM_ReadAll(uintptr_t rcvr_id, int32_t *channels, uint8_t num_channels);
 static uint16_t PIOS_HSUM_RxInCallback(uintptr_t context,
 				       uint8_t *buf,
 				       uint16_t buf_len,
@@ -98,6 +99,7 @@ static void PIOS_HSUM_Supervisor(uintptr_t hsum_id);
 /* Local Variables */
 const struct pios_rcvr_driver pios_hsum_rcvr_driver = {
 	.read = PIOS_HSUM_Get,
+	.read_all = PIOS_HSUM_ReadAll,
 };
 
 enum pios_hsum_dev_magic {
@@ -358,6 +360,27 @@ static int32_t PIOS_HSUM_Get(uintptr_t rcvr_id, uint8_t channel)
 	return hsum_dev->state.channel_data[channel];
 }
 
+/**
+ * Get all the channels at once
+ * \output PIOS_RCVR_INVALID on an invalid device
+ * \output the number of channels filled in
+ */
+static int32_t PIOS_HSUM_ReadAll(uintptr_t rcvr_id, int32_t *channels, uint8_t num_channels)
+{
+	struct pios_hsum_dev *hsum_dev = (struct pios_hsum_dev *)rcvr_id;
+
+	if (!PIOS_HSUM_Validate(hsum_dev))
+		return PIOS_RCVR_INVALID;
+
+	if (num_channels > PIOS_HSUM_NUM_INPUTS)
+		num_channels = PIOS_HSUM_NUM_INPUTS;
+
+	for (int i = 0; i < num_channels; i++)
+		channels[i] = hsum_dev->state.channel_data[i];
+
+	return num_channels;
+}
+
 /**
  * Input data supervisor is called periodically and provides
  * two functions: frame syncing and failsafe triggering.
@@ -69,6 +69,7 @@ static bool PIOS_IBus_Validate(const struct pios_ibus_dev *dev);
  * @retval raw channel value, or error value (see pios_rcvr.h)
  */
 static int32_t PIOS_IBus_Read(uintptr_t id, uint8_t channel);
+static int32_t PIOS_IBus_ReadAll(uintptr_t context, int32_t *channels, uint8_t num_channels);
 /**
  * @brief Set all channels in the last frame buffer to a given value
  * @param[in] dev Driver instance
@@ -105,6 +106,7 @@ static void PIOS_IBus_Supervisor(uintptr_t context);
 // public
 const struct pios_rcvr_driver pios_ibus_rcvr_driver = {
 	.read = PIOS_IBus_Read,
+	.read_all = PIOS_IBus_ReadAll,
 };
 
 
@@ -147,7 +149,7 @@ int PIOS_IBus_Init(uintptr_t *ibus_id, const struct pios_com_driver *driver,
 
 static int32_t PIOS_IBus_Read(uintptr_t context, uint8_t channel)
 {
-	if (channel > PIOS_IBUS_CHANNELS)
+	if (channel >= PIOS_IBUS_CHANNELS)
 		return PIOS_RCVR_INVALID;
 
 	struct pios_ibus_dev *dev = (struct pios_ibus_dev *)context;
@@ -157,6 +159,27 @@ static int32_t PIOS_IBus_Read(uintptr_t context, uint8_t channel)
 	return dev->channel_data[channel];
 }
 
+/**
+ * Get all the channels at once
+ * \output PIOS_RCVR_NODRIVER on an invalid device
+ * \output the number of channels filled in
+ */
+static int32_t PIOS_IBus_ReadAll(uintptr_t context, int32_t *channels, uint8_t num_channels)
+{
+	struct pios_ibus_dev *dev = (struct pios_ibus_dev *)context;
+
+	if (!PIOS_IBus_Validate(dev))
+		return PIOS_RCVR_NODRIVER;
+
+	if (num_channels > PIOS_IBUS_CHANNELS)
+		num_channels = PIOS_IBUS_CHANNELS;
+
+	for (int i = 0; i < num_channels; i++)
+		channels[i] = dev->channel_data[i];
+
+	return num_channels;
+}
+
 static void PIOS_IBus_SetAllChannels(struct pios_ibus_dev *dev, uint16_t value)
 {
 	for (int i = 0; i < PIOS_IBUS_CHANNELS; i++)
@@ -224,6 +247,8 @@ static void PIOS_IBus_UnpackFrame(struct pios_ibus_dev *dev)
 
 	dev->failsafe_timer = 0;
 
+	PIOS_RCVR_ActiveFromISR();
+
 out_fail:
 	PIOS_IBus_ResetBuffer(dev);
 }
@@ -69,6 +69,16 @@
 #define SYNC_INTERVAL_NTSC 33366
 #define SYNC_INTERVAL_PAL  40000
 
+/* Display memory has a cell for every PAL position */
+#define MAX7456_CELLS (MAX7456_PAL_ROWS * MAX7456_COLUMNS)
+
+/* Longest run of characters sent in one bus claim */
+#define MAX7456_RUN_MAX MAX7456_COLUMNS
+
+#define cell_val(chr, attr) ((uint16_t) (((attr) & 0x07) << 8) | (chr))
+#define cell_chr(cell) ((uint8_t) (cell))
+#define cell_attr(cell) ((uint8_t) ((cell) >> 8))
+
 ///////////////////////////////////////////////////////////////////////////////
 
 struct max7456_dev_s {
@@ -80,15 +90,20 @@ struct max7456_dev_s {
 	uint8_t mode, right, bottom, hcenter, vcenter;
 
 	uint8_t mask;
-	bool opened;
 
 	bool force_mode;
 	uint8_t det_mode_fallback;
 
 	uint32_t next_sync_expected;
+
+	/* What has been drawn, and what the chip is showing.  Each cell has
+	 * the character in the low byte and its attributes in the high. */
+	uint16_t screen[MAX7456_CELLS];
+	uint16_t shown[MAX7456_CELLS];
 };
 
 static bool poll_vsync_spi (max7456_dev_t dev);
+static void clear_chip(max7456_dev_t dev);
 
 /* Max7456 says 100ns period (10MHz) is OK.  But it may be off-board in
  * some circumstances, so let's not push our luck.
@@ -283,7 +298,8 @@ static void reset_hard(max7456_dev_t dev)
 		write_register_sel(dev, r, brightness);
 	}
 
-	PIOS_MAX7456_clear(dev);
+	/* What was drawn goes back up at the next flush */
+	clear_chip(dev);
 }
 
 int PIOS_MAX7456_init(max7456_dev_t *dev_out,
@@ -317,8 +333,12 @@ void PIOS_MAX7456_set_mode(max7456_dev_t dev, bool force, uint8_t fallback)
 void PIOS_MAX7456_clear(max7456_dev_t dev)
 {
 	PIOS_Assert(dev->magic == MAX7456_MAGIC);
-	PIOS_Assert(!dev->opened);
 
+	memset(dev->screen, 0, sizeof(dev->screen));
+}
+
+static void clear_chip(max7456_dev_t dev)
+{
 	uint8_t dmm;
 	dmm = read_register_sel(dev, MAX7456_REG_DMM);
 
@@ -330,6 +350,8 @@ void PIOS_MAX7456_clear(max7456_dev_t dev)
 	while (MAX7456_DMM_CLR_R(dmm) != MAX7456_DMM_CLR_READY) {
 		dmm = read_register_sel(dev, MAX7456_REG_DMM);
 	}
+
+	memset(dev->shown, 0, sizeof(dev->shown));
 }
 
 void PIOS_MAX7456_upload_char (max7456_dev_t dev, uint8_t char_index,
@@ -407,19 +429,14 @@ void PIOS_MAX7456_download_char (max7456_dev_t dev, uint8_t char_index,
 	enable_osd(dev);
 }
 
-/* Assumes you have already selected */
-static inline void set_offset (max7456_dev_t dev, uint8_t col, uint8_t row)
+static inline uint16_t cell_offset (uint8_t col, uint8_t row)
 {
-	PIOS_Assert(dev->magic == MAX7456_MAGIC);
-
 	if (col > 29) {
 		// Still will wrap to next line...
 		col = 29;
 	}
 
-	uint16_t offset = (row * 30 + col) & 0x1ff;
-	write_register(dev, MAX7456_REG_DMAH, offset >> 8);
-	write_register(dev, MAX7456_REG_DMAL,(uint8_t) offset);
+	return row * 30 + col;
 }
 
 static bool poll_vsync_spi (max7456_dev_t dev)
@@ -434,59 +451,104 @@ void PIOS_MAX7456_put (max7456_dev_t dev,
 {
 	PIOS_Assert(dev->magic == MAX7456_MAGIC);
 
-	PIOS_Assert(!dev->opened);
+	uint16_t offset = cell_offset(col, row);
 
-	chip_select(dev);
-	set_offset(dev, col, row);
-	write_register(dev, MAX7456_REG_DMM,(attr & 0x07) << 3);
-	write_register(dev, MAX7456_REG_DMDI, chr);
-	chip_unselect(dev);
+	if (offset < MAX7456_CELLS) {
+		dev->screen[offset] = cell_val(chr, attr);
+	}
 }
 
-static void PIOS_MAX7456_open (max7456_dev_t dev, uint8_t col, uint8_t row,
-		uint8_t attr)
+#define valid_char(c) (c == MAX7456_DMDI_AUTOINCREMENT_STOP ? 0x00 : c)
+void PIOS_MAX7456_puts(max7456_dev_t dev, uint8_t col, uint8_t row, const char *s, uint8_t attr)
 {
 	PIOS_Assert(dev->magic == MAX7456_MAGIC);
 
-	PIOS_Assert(!dev->opened);
+	if (col == MAX7456_FMT_H_CENTER) {
+		col = ((MAX7456_COLUMNS - strlen(s)) / 2);
+	}
 
-	dev->opened = true;
+	uint16_t offset = cell_offset(col > dev->right ? 0 : col,
+			row > dev->bottom ? 0 : row);
 
-	chip_select(dev);
-	set_offset(dev, col > dev->right ? 0 : col, row > dev->bottom ? 0 : row);
-
-	// 16 bits operating mode, char attributes, autoincrement
-	write_register(dev, MAX7456_REG_DMM, ((attr & 0x07) << 3) | 0x01);
+	while (*s && offset < MAX7456_CELLS)
+	{
+		dev->screen[offset++] = cell_val(valid_char((uint8_t) *s), attr);
+		s++;
+	}
 }
 
-static void PIOS_MAX7456_close (max7456_dev_t dev)
+/* Sends a run of changed cells with the same attributes, in auto-increment
+ * mode, and returns where it stopped. */
+static uint16_t flush_run(max7456_dev_t dev, uint16_t offset)
 {
-	PIOS_Assert(dev->magic == MAX7456_MAGIC);
+	uint8_t attr = cell_attr(dev->screen[offset]);
 
-	PIOS_Assert(dev->opened);
+	uint8_t buf[6 + 2 * (MAX7456_RUN_MAX + 1)];
+	uint8_t len = 0;
+
+	buf[len++] = MAX7456_REG_DMAH;
+	buf[len++] = offset >> 8;
+	buf[len++] = MAX7456_REG_DMAL;
+	buf[len++] = (uint8_t) offset;
+	// 16 bits operating mode, char attributes, autoincrement
+	buf[len++] = MAX7456_REG_DMM;
+	buf[len++] = (attr << 3) | 0x01;
+
+	uint16_t end = offset + MAX7456_RUN_MAX;
+
+	while (offset < MAX7456_CELLS && offset < end &&
+			dev->screen[offset] != dev->shown[offset] &&
+			cell_attr(dev->screen[offset]) == attr &&
+			cell_chr(dev->screen[offset]) != MAX7456_DMDI_AUTOINCREMENT_STOP) {
+		buf[len++] = MAX7456_REG_DMDI;
+		buf[len++] = cell_chr(dev->screen[offset]);
+
+		dev->shown[offset] = dev->screen[offset];
+		offset++;
+	}
 
 	// terminate autoincrement mode
-	write_register(dev, MAX7456_REG_DMDI, MAX7456_DMDI_AUTOINCREMENT_STOP);
+	buf[len++] = MAX7456_REG_DMDI;
+	buf[len++] = MAX7456_DMDI_AUTOINCREMENT_STOP;
 
+	chip_select(dev);
+	PIOS_SPI_TransferBlock(dev->spi_id, buf, NULL, len);
 	chip_unselect(dev);
-	dev->opened = false;
+
+	return offset;
 }
 
-#define valid_char(c) (c == MAX7456_DMDI_AUTOINCREMENT_STOP ? 0x00 : c)
-void PIOS_MAX7456_puts(max7456_dev_t dev, uint8_t col, uint8_t row, const char *s, uint8_t attr)
+/* The auto-increment terminator can only be written on its own */
+static void flush_cell(max7456_dev_t dev, uint16_t offset)
+{
+	uint16_t cell = dev->screen[offset];
+
+	chip_select(dev);
+	write_register(dev, MAX7456_REG_DMAH, offset >> 8);
+	write_register(dev, MAX7456_REG_DMAL, (uint8_t) offset);
+	write_register(dev, MAX7456_REG_DMM, cell_attr(cell) << 3);
+	write_register(dev, MAX7456_REG_DMDI, cell_chr(cell));
+	chip_unselect(dev);
+
+	dev->shown[offset] = cell;
+}
+
+void PIOS_MAX7456_flush(max7456_dev_t dev)
 {
 	PIOS_Assert(dev->magic == MAX7456_MAGIC);
 
-	if (col == MAX7456_FMT_H_CENTER) {
-		col = ((MAX7456_COLUMNS - strlen(s)) / 2);
-	}
-	PIOS_MAX7456_open(dev, col, row, attr);
-	while (*s)
-	{
-		write_register(dev, MAX7456_REG_DMDI, valid_char(*s));
-		s++;
+	uint16_t offset = 0;
+
+	while (offset < MAX7456_CELLS) {
+		if (dev->screen[offset] == dev->shown[offset]) {
+			offset++;
+		} else if (cell_chr(dev->screen[offset]) == MAX7456_DMDI_AUTOINCREMENT_STOP) {
+			flush_cell(dev, offset);
+			offset++;
+		} else {
+			offset = flush_run(dev, offset);
+		}
 	}
-	PIOS_MAX7456_close(dev);
 }
 
 void PIOS_MAX7456_get_extents(max7456_dev_t dev, 
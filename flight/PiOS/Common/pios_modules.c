@@ -45,6 +45,53 @@ bool PIOS_Modules_IsEnabled(enum pios_modules module)
 	return modules_enabled[module];
 }
 
+static struct pios_modules_boot_profile boot_profile;
+
+/**
+ * Records how long board initialization (driver setup and sensor
+ * probing) took.
+ */
+void PIOS_Modules_ProfileBoardInit(uint32_t us)
+{
+	boot_profile.board_init_us = us;
+}
+
+/**
+ * Records how long one module's initialize or start function took, and
+ * keeps it if it's the slowest so far.
+ * \param[in] name the function
+ * \param[in] start true for the start (task create) function
+ * \param[in] us time taken
+ */
+void PIOS_Modules_ProfileInitcall(const char *name, bool start, uint32_t us)
+{
+	if (start) {
+		if (us >= boot_profile.slowest_start_us) {
+			boot_profile.slowest_start_us = us;
+			boot_profile.slowest_start = name;
+		}
+	} else if (us >= boot_profile.slowest_init_us) {
+		boot_profile.slowest_init_us = us;
+		boot_profile.slowest_init = name;
+	}
+}
+
+/**
+ * Records how long initializing (or starting) all the modules took.
+ */
+void PIOS_Modules_ProfileAll(bool start, uint32_t us)
+{
+	if (start)
+		boot_profile.task_create_us = us;
+	else
+		boot_profile.module_init_us = us;
+}
+
+const struct pios_modules_boot_profile *PIOS_Modules_GetBootProfile(void)
+{
+	return &boot_profile;
+}
+
 /**
  * @ }
  * @ }
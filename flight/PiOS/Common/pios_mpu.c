@@ -43,6 +43,15 @@
 #endif // PIOS_MPU_SPI_HIGH_SPEED
 #define PIOS_MPU_SPI_LOW_SPEED               300000
 
+//! Accel, temperature and gyro, in register order
+#define PIOS_MPU_FIFO_SAMPLE_SIZE            14
+//! Most samples taken out of the FIFO in one transfer
+#define PIOS_MPU_FIFO_MAX_SAMPLES            (2 * PIOS_MPU_FIFO_MAX_BATCH)
+//! Gyro samples held for the consumer, a full FIFO read and some slack
+#define PIOS_MPU_RING_SLOTS                  32
+//! Longest a batch may take to build up
+#define PIOS_MPU_FIFO_MAX_LATENCY_US         2000
+
 
 /**
  * WHOAMI ids of each device, must be same length as pios_mpu_type
@@ -95,7 +104,6 @@ struct pios_mpu_dev {
 	enum pios_mpu_gyro_range gyro_range;
 	enum pios_mpu_accel_range accel_range;
 	enum pios_mpu_dev_magic magic;              /**< Magic bytes to validate the struct contents */
-	struct pios_sensor_gyro_data gyro_data;
 	struct pios_sensor_accel_data accel_data;
 #ifdef PIOS_INCLUDE_MPU_MAG
 	bool use_mag;
@@ -105,6 +113,12 @@ struct pios_mpu_dev {
 #endif // PIOS_INCLUDE_MPU_MAG
 	volatile uint32_t interrupt_count;
 	volatile uint8_t sensor_ready;
+	volatile uint32_t irq_time_us;              /**< When the newest sample was signalled */
+	uint16_t sample_rate;                       /**< Output data rate [Hz] */
+	uint8_t fifo_batch;                         /**< Samples per FIFO read, 0 when reading registers */
+	volatile uint8_t fifo_pending;              /**< Samples signalled since the consumer was woken */
+	uint8_t *fifo_tx;
+	uint8_t *fifo_rx;
 };
 
 #define SENSOR_ACCEL			(1 << 0)
@@ -174,27 +188,39 @@ static int32_t PIOS_MPU_SPI_Probe(enum pios_mpu_type *detected_device);
 static int32_t PIOS_MPU_I2C_Probe(enum pios_mpu_type *detected_device);
 #endif // defined(PIOS_INCLUDE_I2C) || defined(__DOXYGEN__)
 
-static int PIOS_MPU_parse_data(struct pios_mpu_dev *p);
+static int PIOS_MPU_parse_data(struct pios_mpu_dev *p,
+		struct pios_sensor_gyro_data *gyro_data);
+static void PIOS_MPU_decode_data(struct pios_mpu_dev *p, const uint8_t *mpu_rec_buf,
+		struct pios_sensor_gyro_data *gyro_data);
+#if defined(PIOS_INCLUDE_SPI)
+static int PIOS_MPU_read_fifo(struct pios_mpu_dev *p);
+#endif // PIOS_INCLUDE_SPI
 
-static bool PIOS_MPU_callback_gyro(void *ctx, void *output,
-		int ms_to_wait, int *next_call)
+/* Reads the sensor and puts the gyro samples straight into the ring. */
+static bool PIOS_MPU_fill_gyro(void *ctx, int ms_to_wait)
 {
 	struct pios_mpu_dev *dev = (struct pios_mpu_dev *)ctx;
 
 	PIOS_Assert(dev);
-	PIOS_Assert(output);
-
-	*next_call = 0;		/* Baby you know you can call me anytime */
 
 	if (PIOS_Semaphore_Take(dev->data_ready_sema, ms_to_wait) != true) {
 		return false;
 	}
 
-	if (PIOS_MPU_parse_data(dev)) {
+#if defined(PIOS_INCLUDE_SPI)
+	if (dev->fifo_batch) {
+		return PIOS_MPU_read_fifo(dev) > 0;
+	}
+#endif // PIOS_INCLUDE_SPI
+
+	struct pios_sensor_gyro_data *gyro_data =
+		PIOS_SENSORS_RingNext(PIOS_SENSOR_GYRO, dev->irq_time_us);
+
+	if (PIOS_MPU_parse_data(dev, gyro_data)) {
 		return false;
 	}
 
-	memcpy(output, &dev->gyro_data, sizeof(dev->gyro_data));
+	PIOS_SENSORS_RingPublish(PIOS_SENSOR_GYRO);
 
 	return true;
 }
@@ -520,11 +546,16 @@ static int32_t PIOS_MPU_Common_Init(void)
 	mpu_dev->accel_range = PIOS_MPU_SCALE_8G;
 	mpu_dev->gyro_range = PIOS_MPU_SCALE_1000_DEG;
 
-	int ret = PIOS_SENSORS_RegisterCallback(PIOS_SENSOR_GYRO,
-			PIOS_MPU_callback_gyro, mpu_dev);
+	int ret = PIOS_SENSORS_RegisterRing(PIOS_SENSOR_GYRO,
+			sizeof(struct pios_sensor_gyro_data), PIOS_MPU_RING_SLOTS,
+			PIOS_MPU_fill_gyro, mpu_dev);
 
 	PIOS_Assert(!ret);
 
+	if (mpu_dev->cfg->fifo_batch > 1) {
+		PIOS_MPU_SetFIFOBatch(mpu_dev->cfg->fifo_batch);
+	}
+
 	ret = PIOS_SENSORS_RegisterCallback(PIOS_SENSOR_ACCEL,
 			PIOS_MPU_callback_accel, mpu_dev);
 
@@ -746,6 +777,13 @@ int32_t PIOS_MPU_SetSampleRate(uint16_t samplerate_hz)
 	int32_t retval = PIOS_MPU_WriteReg(PIOS_MPU_SMPLRT_DIV_REG, (uint8_t)divisor);
 
 	if (retval == 0) {
+		mpu_dev->sample_rate = samplerate_hz;
+
+		/* Keep the batch from building up for too long */
+		if (mpu_dev->fifo_batch) {
+			PIOS_MPU_SetFIFOBatch(mpu_dev->fifo_batch);
+		}
+
 		PIOS_SENSORS_SetSampleRate(PIOS_SENSOR_ACCEL, samplerate_hz);
 		PIOS_SENSORS_SetSampleRate(PIOS_SENSOR_GYRO, samplerate_hz);
 #ifdef PIOS_INCLUDE_MPU_MAG
@@ -768,6 +806,83 @@ enum pios_mpu_type PIOS_MPU_GetType(void)
 	return mpu_dev->mpu_type;
 }
 
+int32_t PIOS_MPU_SetFIFOBatch(uint8_t samples)
+{
+	if (PIOS_MPU_Validate(mpu_dev) != 0)
+		return -1;
+
+	uint32_t max_batch = (uint32_t)mpu_dev->sample_rate *
+		PIOS_MPU_FIFO_MAX_LATENCY_US / 1000000;
+
+	if (max_batch > PIOS_MPU_FIFO_MAX_BATCH)
+		max_batch = PIOS_MPU_FIFO_MAX_BATCH;
+
+	if (samples > max_batch)
+		samples = max_batch;
+
+	if (samples < 2)
+		samples = 0;
+
+#ifdef PIOS_INCLUDE_MPU_MAG
+	/* The mag is slaved through the data registers, so it needs
+	 * every sample read from there */
+	if (mpu_dev->use_mag)
+		samples = 0;
+#endif // PIOS_INCLUDE_MPU_MAG
+
+#if defined(PIOS_INCLUDE_SPI)
+	if (mpu_dev->com_driver_type != PIOS_MPU_COM_SPI)
+		samples = 0;
+#else
+	samples = 0;
+#endif // PIOS_INCLUDE_SPI
+
+	int32_t user_ctrl = PIOS_MPU_ReadReg(PIOS_MPU_USER_CTRL_REG);
+	if (user_ctrl < 0)
+		return -PIOS_MPU_ERROR_READFAILED;
+
+	user_ctrl &= ~PIOS_MPU_USERCTL_FIFO_EN;
+
+	/* Stop and flush the FIFO, and go back to register reads */
+	mpu_dev->fifo_batch = 0;
+
+	if (PIOS_MPU_WriteReg(PIOS_MPU_FIFO_EN_REG, 0) != 0 ||
+			PIOS_MPU_WriteReg(PIOS_MPU_USER_CTRL_REG,
+				user_ctrl | PIOS_MPU_USERCTL_FIFO_RST) != 0)
+		return -PIOS_MPU_ERROR_WRITEFAILED;
+
+	if (!samples)
+		return 0;
+
+	if (!mpu_dev->fifo_tx) {
+		uint16_t size = 1 + PIOS_MPU_FIFO_MAX_SAMPLES * PIOS_MPU_FIFO_SAMPLE_SIZE;
+
+		mpu_dev->fifo_tx = PIOS_malloc(size);
+		mpu_dev->fifo_rx = PIOS_malloc(size);
+		PIOS_Assert(mpu_dev->fifo_tx && mpu_dev->fifo_rx);
+
+		memset(mpu_dev->fifo_tx, 0, size);
+		mpu_dev->fifo_tx[0] = PIOS_MPU_FIFO_REG | 0x80;
+	}
+
+	if (PIOS_MPU_WriteReg(PIOS_MPU_FIFO_EN_REG,
+				PIOS_MPU_FIFO_TEMP_OUT | PIOS_MPU_FIFO_GYRO_X_OUT |
+				PIOS_MPU_FIFO_GYRO_Y_OUT | PIOS_MPU_FIFO_GYRO_Z_OUT |
+				PIOS_MPU_ACCEL_OUT) != 0)
+		return -PIOS_MPU_ERROR_WRITEFAILED;
+
+	mpu_dev->fifo_pending = 0;
+	mpu_dev->fifo_batch = samples;
+
+	if (PIOS_MPU_WriteReg(PIOS_MPU_USER_CTRL_REG,
+				user_ctrl | PIOS_MPU_USERCTL_FIFO_EN) != 0) {
+		mpu_dev->fifo_batch = 0;
+		return -PIOS_MPU_ERROR_WRITEFAILED;
+	}
+
+	return 0;
+}
+
 #if defined(PIOS_INCLUDE_I2C)
 static int32_t PIOS_MPU_I2C_Probe(enum pios_mpu_type *detected_device)
 {
@@ -887,7 +1002,8 @@ static int32_t PIOS_MPU_ClaimBus(bool lowspeed)
 	if (PIOS_MPU_Validate(mpu_dev) != 0)
 		return -1;
 
-	if (PIOS_SPI_ClaimBus(mpu_dev->spi_driver_id) != 0)
+	/* Get in ahead of flash and OSD traffic on a shared bus */
+	if (PIOS_SPI_ClaimBusPriority(mpu_dev->spi_driver_id) != 0)
 		return -2;
 
 	if (lowspeed)
@@ -982,48 +1098,58 @@ bool PIOS_MPU_IRQHandler(void)
 	bool woken = false;
 
 	mpu_dev->interrupt_count++;
+	mpu_dev->irq_time_us = PIOS_DELAY_GetuS();
+
+	/* In FIFO mode only wake the consumer once a batch is ready */
+	if (mpu_dev->fifo_batch &&
+			++mpu_dev->fifo_pending < mpu_dev->fifo_batch)
+		return false;
+
+	mpu_dev->fifo_pending = 0;
 
 	PIOS_Semaphore_Give_FromISR(mpu_dev->data_ready_sema, &woken);
 
 	return woken;
 }
 
+//! Layout of a sensor data register read, starting with the SPI dummy byte
+enum pios_mpu_data_idx {
+	IDX_SPI_DUMMY_BYTE = 0,
+	IDX_ACCEL_XOUT_H,
+	IDX_ACCEL_XOUT_L,
+	IDX_ACCEL_YOUT_H,
+	IDX_ACCEL_YOUT_L,
+	IDX_ACCEL_ZOUT_H,
+	IDX_ACCEL_ZOUT_L,
+	IDX_TEMP_OUT_H,
+	IDX_TEMP_OUT_L,
+	IDX_GYRO_XOUT_H,
+	IDX_GYRO_XOUT_L,
+	IDX_GYRO_YOUT_H,
+	IDX_GYRO_YOUT_L,
+	IDX_GYRO_ZOUT_H,
+	IDX_GYRO_ZOUT_L,
+#ifdef PIOS_INCLUDE_MPU_MAG
+	IDX_MAG_ST1,
+	IDX_MAG_XOUT_L,
+	IDX_MAG_XOUT_H,
+	IDX_MAG_YOUT_L,
+	IDX_MAG_YOUT_H,
+	IDX_MAG_ZOUT_L,
+	IDX_MAG_ZOUT_H,
+	IDX_MAG_ST2,
+#endif // PIOS_INCLUDE_MPU_MAG
+	BUFFER_SIZE
+};
+
 /**
  * @brief Tries to read out the IMU.
  *
  * @return Zero on success.
  */
-static int PIOS_MPU_parse_data(struct pios_mpu_dev *p)
+static int PIOS_MPU_parse_data(struct pios_mpu_dev *p,
+		struct pios_sensor_gyro_data *gyro_data)
 {
-	enum {
-		IDX_SPI_DUMMY_BYTE = 0,
-		IDX_ACCEL_XOUT_H,
-		IDX_ACCEL_XOUT_L,
-		IDX_ACCEL_YOUT_H,
-		IDX_ACCEL_YOUT_L,
-		IDX_ACCEL_ZOUT_H,
-		IDX_ACCEL_ZOUT_L,
-		IDX_TEMP_OUT_H,
-		IDX_TEMP_OUT_L,
-		IDX_GYRO_XOUT_H,
-		IDX_GYRO_XOUT_L,
-		IDX_GYRO_YOUT_H,
-		IDX_GYRO_YOUT_L,
-		IDX_GYRO_ZOUT_H,
-		IDX_GYRO_ZOUT_L,
-#ifdef PIOS_INCLUDE_MPU_MAG
-		IDX_MAG_ST1,
-		IDX_MAG_XOUT_L,
-		IDX_MAG_XOUT_H,
-		IDX_MAG_YOUT_L,
-		IDX_MAG_YOUT_H,
-		IDX_MAG_ZOUT_L,
-		IDX_MAG_ZOUT_H,
-		IDX_MAG_ST2,
-#endif // PIOS_INCLUDE_MPU_MAG
-		BUFFER_SIZE
-	};
-
 	uint8_t mpu_rec_buf[BUFFER_SIZE];
 
 #ifdef PIOS_INCLUDE_SPI
@@ -1077,6 +1203,100 @@ static int PIOS_MPU_parse_data(struct pios_mpu_dev *p)
 	}
 #endif // defined(PIOS_INCLUDE_I2C)
 
+	PIOS_MPU_decode_data(p, mpu_rec_buf, gyro_data);
+
+	return 0;
+}
+
+#if defined(PIOS_INCLUDE_SPI)
+/**
+ * @brief Flushes the FIFO after it fell out of step.
+ */
+static void PIOS_MPU_reset_fifo(void)
+{
+	int32_t user_ctrl = PIOS_MPU_ReadReg(PIOS_MPU_USER_CTRL_REG);
+
+	if (user_ctrl >= 0)
+		PIOS_MPU_WriteReg(PIOS_MPU_USER_CTRL_REG,
+				user_ctrl | PIOS_MPU_USERCTL_FIFO_RST);
+}
+
+/**
+ * @brief Reads out the buffered samples in one transfer.
+ *
+ * The FIFO is filled at the output data rate, so sample times are counted
+ * back from the newest data ready interrupt. The gyro samples are decoded
+ * straight into the sensor ring.
+ *
+ * @return The number of samples read, zero on failure.
+ */
+static int PIOS_MPU_read_fifo(struct pios_mpu_dev *p)
+{
+	uint8_t cnt_tx[3] = { PIOS_MPU_FIFO_CNT_MSB | 0x80, 0, 0 };
+	uint8_t cnt_rx[3];
+
+	if (PIOS_MPU_ClaimBus(false) != 0)
+		return 0;
+
+	if (PIOS_SPI_TransferBlock(p->spi_driver_id, cnt_tx, cnt_rx, sizeof(cnt_tx)) < 0) {
+		PIOS_MPU_ReleaseBus(false);
+		return 0;
+	}
+
+	PIOS_MPU_ReleaseBus(false);
+
+	uint32_t newest_us = p->irq_time_us;
+
+	uint16_t fifo_bytes = (cnt_rx[1] << 8) | cnt_rx[2];
+	int count = fifo_bytes / PIOS_MPU_FIFO_SAMPLE_SIZE;
+
+	/* Overflowed or out of step: the samples aren't contiguous anymore */
+	if (count > PIOS_MPU_FIFO_MAX_SAMPLES ||
+			(fifo_bytes % PIOS_MPU_FIFO_SAMPLE_SIZE)) {
+		PIOS_MPU_reset_fifo();
+		return 0;
+	}
+
+	int n = count;
+	if (!n)
+		return 0;
+
+	if (PIOS_MPU_ClaimBus(false) != 0)
+		return 0;
+
+	if (PIOS_SPI_TransferBlock(p->spi_driver_id, p->fifo_tx, p->fifo_rx,
+				1 + n * PIOS_MPU_FIFO_SAMPLE_SIZE) < 0) {
+		PIOS_MPU_ReleaseBus(false);
+		return 0;
+	}
+
+	PIOS_MPU_ReleaseBus(false);
+
+	uint32_t period_us = 1000000 / p->sample_rate;
+
+	for (int i = 0; i < n; i++) {
+		struct pios_sensor_gyro_data *gyro_data =
+			PIOS_SENSORS_RingNext(PIOS_SENSOR_GYRO,
+				newest_us - (n - 1 - i) * period_us);
+
+		/* Each sample lines up with the register layout, the byte
+		 * before it standing in for the SPI dummy byte */
+		PIOS_MPU_decode_data(p, &p->fifo_rx[i * PIOS_MPU_FIFO_SAMPLE_SIZE],
+				gyro_data);
+
+		PIOS_SENSORS_RingPublish(PIOS_SENSOR_GYRO);
+	}
+
+	return n;
+}
+#endif // PIOS_INCLUDE_SPI
+
+/**
+ * @brief Converts one sample from the sensor data register layout.
+ */
+static void PIOS_MPU_decode_data(struct pios_mpu_dev *p, const uint8_t *mpu_rec_buf,
+		struct pios_sensor_gyro_data *gyro_data)
+{
 	float accel_x = (int16_t)(mpu_rec_buf[IDX_ACCEL_XOUT_H] << 8 | mpu_rec_buf[IDX_ACCEL_XOUT_L]);
 	float accel_y = (int16_t)(mpu_rec_buf[IDX_ACCEL_YOUT_H] << 8 | mpu_rec_buf[IDX_ACCEL_YOUT_L]);
 	float accel_z = (int16_t)(mpu_rec_buf[IDX_ACCEL_ZOUT_H] << 8 | mpu_rec_buf[IDX_ACCEL_ZOUT_L]);
@@ -1097,14 +1317,17 @@ static int PIOS_MPU_parse_data(struct pios_mpu_dev *p)
 	gyro_z *= gyro_scale;
 
 #ifdef PIOS_INCLUDE_MPU_MAG
-	float mag_x = (int16_t)(mpu_rec_buf[IDX_MAG_XOUT_H] << 8 | mpu_rec_buf[IDX_MAG_XOUT_L]);
-	float mag_y = (int16_t)(mpu_rec_buf[IDX_MAG_YOUT_H] << 8 | mpu_rec_buf[IDX_MAG_YOUT_L]);
-	float mag_z = (int16_t)(mpu_rec_buf[IDX_MAG_ZOUT_H] << 8 | mpu_rec_buf[IDX_MAG_ZOUT_L]);
+	float mag_x = 0, mag_y = 0, mag_z = 0;
+
+	if (mpu_dev->use_mag) {
+		mag_x = (int16_t)(mpu_rec_buf[IDX_MAG_XOUT_H] << 8 | mpu_rec_buf[IDX_MAG_XOUT_L]);
+		mag_y = (int16_t)(mpu_rec_buf[IDX_MAG_YOUT_H] << 8 | mpu_rec_buf[IDX_MAG_YOUT_L]);
+		mag_z = (int16_t)(mpu_rec_buf[IDX_MAG_ZOUT_H] << 8 | mpu_rec_buf[IDX_MAG_ZOUT_L]);
+	}
 
 	struct pios_sensor_mag_data *mag_data = &mpu_dev->mag_data;
 #endif // PIOS_INCLUDE_MPU_MAG
 
-	struct pios_sensor_gyro_data *gyro_data = &mpu_dev->gyro_data;
 	struct pios_sensor_accel_data *accel_data = &mpu_dev->accel_data;
 
 	/*
@@ -1274,7 +1497,6 @@ static int PIOS_MPU_parse_data(struct pios_mpu_dev *p)
 		}
 	}
 #endif // PIOS_INCLUDE_MPU_MAG
-	return 0;
 }
 
 #endif // PIOS_INCLUDE_MPU
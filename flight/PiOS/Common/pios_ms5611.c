@@ -35,13 +35,9 @@
 
 #include "pios_ms5611_priv.h"
 #include "pios_semaphore.h"
-#include "pios_thread.h"
-#include "pios_queue.h"
 
 /* Private constants */
 #define PIOS_MS5611_OVERSAMPLING oversampling
-#define MS5611_TASK_PRIORITY	PIOS_THREAD_PRIO_HIGHEST
-#define MS5611_TASK_STACK_BYTES	512
 
 /* MS5611 Addresses */
 #define MS5611_I2C_ADDR_0x76    0x76
@@ -61,7 +57,9 @@ uint8_t ms5611_i2c_addr;
 /* Private methods */
 static int32_t PIOS_MS5611_Read(uint8_t address, uint8_t * buffer, uint8_t len);
 static int32_t PIOS_MS5611_WriteCommand(uint8_t command);
-static void PIOS_MS5611_Task(void *parameters);
+static uint32_t PIOS_MS5611_GetConversionTime(enum pios_ms5611_osr osr);
+static bool PIOS_MS5611_Callback(void *ctx, void *output,
+		int ms_to_wait, int *next_call);
 
 /* Private types */
 
@@ -79,13 +77,21 @@ enum conversion_type {
 struct ms5611_dev {
 	const struct pios_ms5611_cfg * cfg;
 	pios_i2c_t i2c_id;
-	struct pios_thread *task;
-	struct pios_queue *queue;
 
 	int64_t pressure_unscaled;
 	int64_t temperature_unscaled;
 	uint16_t calibration[6];
 	enum conversion_type current_conversion_type;
+	enum pios_ms5611_osr oversampling;
+
+	//! A conversion has been started and not read yet
+	bool conversion_pending;
+	uint32_t conversion_start;
+	uint32_t conversion_us;
+
+	//! Pressure conversions to go before the next temperature one
+	uint32_t pressure_countdown;
+
 	enum pios_ms5611_dev_magic magic;
 
 	struct pios_semaphore *busy;
@@ -106,12 +112,6 @@ static struct ms5611_dev * PIOS_MS5611_alloc(void)
 
 	memset(ms5611_dev, 0, sizeof(*ms5611_dev));
 
-	ms5611_dev->queue = PIOS_Queue_Create(1, sizeof(struct pios_sensor_baro_data));
-	if (ms5611_dev->queue == NULL) {
-		PIOS_free(ms5611_dev);
-		return NULL;
-	}
-
 	ms5611_dev->magic = PIOS_MS5611_DEV_MAGIC;
 
 	ms5611_dev->busy = PIOS_Semaphore_Create();
@@ -146,6 +146,7 @@ int32_t PIOS_MS5611_Init(const struct pios_ms5611_cfg *cfg, pios_i2c_t i2c_devic
 
 	dev->i2c_id = i2c_device;
 	dev->cfg = cfg;
+	dev->oversampling = cfg->oversampling;
 
 	/* Which I2C address is being used? */
 	if (dev->cfg->use_0x76_address == true)
@@ -166,15 +167,22 @@ int32_t PIOS_MS5611_Init(const struct pios_ms5611_cfg *cfg, pios_i2c_t i2c_devic
 		dev->calibration[i] = (data[0] << 8) | data[1];
 	}
 
-	PIOS_SENSORS_Register(PIOS_SENSOR_BARO, dev->queue);
-
-	dev->task = PIOS_Thread_Create(
-			PIOS_MS5611_Task, "pios_ms5611", MS5611_TASK_STACK_BYTES, NULL, MS5611_TASK_PRIORITY);
-	PIOS_Assert(dev->task != NULL);
+	PIOS_SENSORS_RegisterCallback(PIOS_SENSOR_BARO, PIOS_MS5611_Callback, dev);
 
 	return 0;
 }
 
+/**
+ * @brief Change the oversampling; it applies from the next conversion
+ */
+void PIOS_MS5611_SetOversampling(enum pios_ms5611_osr oversampling)
+{
+	if (PIOS_MS5611_Validate(dev) != 0)
+		return;
+
+	dev->oversampling = oversampling;
+}
+
 /**
  * Claim the MS5611 device semaphore.
  * \return 0 if no error
@@ -211,45 +219,55 @@ static int32_t PIOS_MS5611_StartADC(enum conversion_type type)
 	/* Start the conversion */
 	switch (type) {
 	case TEMPERATURE_CONV:
-		while (PIOS_MS5611_WriteCommand(MS5611_TEMP_ADDR + dev->cfg->oversampling) != 0)
-			continue;
+		if (PIOS_MS5611_WriteCommand(MS5611_TEMP_ADDR + dev->oversampling) != 0)
+			return -2;
 		break;
 	case PRESSURE_CONV:
-		while (PIOS_MS5611_WriteCommand(MS5611_PRES_ADDR + dev->cfg->oversampling) != 0)
-			continue;
+		if (PIOS_MS5611_WriteCommand(MS5611_PRES_ADDR + dev->oversampling) != 0)
+			return -2;
 		break;
 	default:
 		return -1;
 	}
 
 	dev->current_conversion_type = type;
+	dev->conversion_us = PIOS_MS5611_GetConversionTime(dev->oversampling);
+	dev->conversion_start = PIOS_DELAY_GetRaw();
+	dev->conversion_pending = true;
 
 	return 0;
 }
 
 /**
- * @brief Return the delay for the current osr
+ * @brief Return the longest a conversion takes at an osr, in microseconds
  */
-static int32_t PIOS_MS5611_GetDelay()
+static uint32_t PIOS_MS5611_GetConversionTime(enum pios_ms5611_osr osr)
 {
-	if (PIOS_MS5611_Validate(dev) != 0)
-		return 100;
-
-	switch(dev->cfg->oversampling) {
+	switch(osr) {
 	case MS5611_OSR_256:
-		return 2;
+		return 600;
 	case MS5611_OSR_512:
-		return 2;
+		return 1170;
 	case MS5611_OSR_1024:
-		return 3;
+		return 2280;
 	case MS5611_OSR_2048:
-		return 5;
+		return 4540;
 	case MS5611_OSR_4096:
-		return 10;
 	default:
 		break;
 	}
-	return 10;
+	return 9040;
+}
+
+/**
+ * @brief Return the delay in ms for the conversion last started
+ */
+static int32_t PIOS_MS5611_GetDelay()
+{
+	if (PIOS_MS5611_Validate(dev) != 0)
+		return 100;
+
+	return dev->conversion_us / 1000 + 1;
 }
 
 /**
@@ -263,6 +281,8 @@ static int32_t PIOS_MS5611_ReadADC(void)
 
 	uint8_t data[3];
 
+	dev->conversion_pending = false;
+
 	static int64_t delta_temp;
 	static int64_t temperature;
 
@@ -405,49 +425,65 @@ int32_t PIOS_MS5611_Test()
 	return 0;
 }
 
-static void PIOS_MS5611_Task(void *parameters)
+/**
+ * @brief Reads the conversion that has finished and starts the next, so the
+ * sensor converts between calls instead of a task sleeping on it.
+ * Temperature is converted once every temperature_interleaving pressures.
+ */
+static bool PIOS_MS5611_Callback(void *ctx, void *output,
+		int ms_to_wait, int *next_call)
 {
-	// init this to 1 in order to force a temperature read on the first run
-	uint32_t temp_press_interleave_count = 1;
-	int32_t  read_adc_result = 0;
+	struct ms5611_dev *dev = (struct ms5611_dev *)ctx;
 
-	while (1) {
+	PIOS_Assert(dev);
+	PIOS_Assert(output);
 
-		--temp_press_interleave_count;
+	if (dev->conversion_pending) {
+		uint32_t elapsed = PIOS_DELAY_DiffuS(dev->conversion_start);
 
-		if (temp_press_interleave_count == 0)
-		{
-			// Update the temperature data
-			PIOS_MS5611_ClaimDevice();
-			PIOS_MS5611_StartADC(TEMPERATURE_CONV);
-			PIOS_Thread_Sleep(PIOS_MS5611_GetDelay());
-			PIOS_MS5611_ReadADC();
-			PIOS_MS5611_ReleaseDevice();
-
-			temp_press_interleave_count = dev->cfg->temperature_interleaving;
-			if (temp_press_interleave_count == 0)
-				temp_press_interleave_count = 1;
+		if (elapsed < dev->conversion_us) {
+			*next_call = (dev->conversion_us - elapsed + 999) / 1000;
+			return false;
 		}
+	}
+
+	bool have_pressure = false;
+
+	PIOS_MS5611_ClaimDevice();
 
-		// Update the pressure data
-		PIOS_MS5611_ClaimDevice();
-		PIOS_MS5611_StartADC(PRESSURE_CONV);
-		PIOS_Thread_Sleep(PIOS_MS5611_GetDelay());
-		read_adc_result = PIOS_MS5611_ReadADC();
-		PIOS_MS5611_ReleaseDevice();
-
-		// Compute the altitude from the pressure and temperature and send it out
-		struct pios_sensor_baro_data data;
-		data.temperature = ((float) dev->temperature_unscaled) / 100.0f;
-		data.pressure = ((float) dev->pressure_unscaled) / 1000.0f;
-		data.altitude = 44330.0f * (1.0f - powf(data.pressure / MS5611_P0, (1.0f / 5.255f)));
-
-		if (read_adc_result == 0) {
-			PIOS_Queue_Send(dev->queue, &data, 0);
+	if (dev->conversion_pending) {
+		enum conversion_type done = dev->current_conversion_type;
+
+		have_pressure = (PIOS_MS5611_ReadADC() == 0) && (done == PRESSURE_CONV);
+	}
+
+	bool temperature_due = dev->pressure_countdown == 0;
+
+	if (PIOS_MS5611_StartADC(temperature_due ? TEMPERATURE_CONV : PRESSURE_CONV) == 0) {
+		if (temperature_due) {
+			dev->pressure_countdown = dev->cfg->temperature_interleaving;
+			if (dev->pressure_countdown == 0)
+				dev->pressure_countdown = 1;
+		} else {
+			dev->pressure_countdown--;
 		}
 	}
-}
 
+	PIOS_MS5611_ReleaseDevice();
+
+	*next_call = PIOS_MS5611_GetDelay();
+
+	if (!have_pressure)
+		return false;
+
+	// Compute the altitude from the pressure and temperature and send it out
+	struct pios_sensor_baro_data *data = (struct pios_sensor_baro_data *)output;
+	data->temperature = ((float) dev->temperature_unscaled) / 100.0f;
+	data->pressure = ((float) dev->pressure_unscaled) / 1000.0f;
+	data->altitude = 44330.0f * (1.0f - powf(data->pressure / MS5611_P0, (1.0f / 5.255f)));
+
+	return true;
+}
 
 #endif
 
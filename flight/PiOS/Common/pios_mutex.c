@@ -34,14 +34,72 @@
 struct pios_mutex
 {
 	Mutex mtx;
+#if defined(DIAG_MUTEXES)
+	struct pios_mutex_stats stats;
+#endif
 };
 
 struct pios_recursive_mutex
 {
 	Mutex mtx;
 	uint32_t count;
+#if defined(DIAG_MUTEXES)
+	struct pios_mutex_stats stats;
+#endif
 };
 
+#if defined(DIAG_MUTEXES)
+static const struct pios_mutex_stats *stats_head;
+
+/**
+ * @brief   Adds a mutex to the statistics list.
+ *
+ * @param[in] stats        statistics of the new mutex
+ * @param[in] creator      return address of the create call
+ */
+static void mutex_stats_register(struct pios_mutex_stats *stats, void *creator)
+{
+	memset(stats, 0, sizeof(*stats));
+	stats->creator = (uintptr_t) creator;
+
+	chSysLock();
+	stats->next = stats_head;
+	stats_head = stats;
+	chSysUnlock();
+}
+
+/**
+ * @brief   Records a lock that had to wait.  Called holding the mutex.
+ *
+ * @param[in] stats        statistics of the mutex
+ * @param[in] owner        thread that held the mutex when the wait began
+ * @param[in] start        PIOS_DELAY_GetRaw() when the wait began
+ */
+static void mutex_stats_record(struct pios_mutex_stats *stats, Thread *owner,
+		uint32_t start)
+{
+	uint32_t waited = PIOS_DELAY_GetRaw() - start;
+
+	stats->waits++;
+	stats->wait_cycles += waited;
+	if (waited > stats->max_wait_cycles)
+		stats->max_wait_cycles = waited;
+	stats->owner = (uintptr_t) owner;
+}
+
+/**
+ *
+ * @brief   Gets the statistics of the most recently created mutex.
+ *
+ * @returns first entry of the list, follow @p next for the others
+ *
+ */
+const struct pios_mutex_stats *PIOS_Mutex_Stats_First(void)
+{
+	return stats_head;
+}
+#endif /* DIAG_MUTEXES */
+
 /**
  *
  * @brief   Creates a non recursive mutex.
@@ -58,6 +116,10 @@ struct pios_mutex *PIOS_Mutex_Create(void)
 
 	chMtxInit(&mtx->mtx);
 
+#if defined(DIAG_MUTEXES)
+	mutex_stats_register(&mtx->stats, __builtin_return_address(0));
+#endif
+
 	return mtx;
 }
 
@@ -75,7 +137,17 @@ bool PIOS_Mutex_Lock(struct pios_mutex *mtx, uint32_t timeout_ms)
 {
 	PIOS_Assert(mtx != NULL);
 
+#if defined(DIAG_MUTEXES)
+	if (!chMtxTryLock(&mtx->mtx)) {
+		Thread *owner = mtx->mtx.m_owner;
+		uint32_t start = PIOS_DELAY_GetRaw();
+
+		chMtxLock(&mtx->mtx);
+		mutex_stats_record(&mtx->stats, owner, start);
+	}
+#else
 	chMtxLock(&mtx->mtx);
+#endif
 
 	return true;
 }
@@ -115,6 +187,10 @@ struct pios_recursive_mutex *PIOS_Recursive_Mutex_Create(void)
 	chMtxInit(&mtx->mtx);
 	mtx->count = 0;
 
+#if defined(DIAG_MUTEXES)
+	mutex_stats_register(&mtx->stats, __builtin_return_address(0));
+#endif
+
 	return mtx;
 }
 
@@ -134,8 +210,22 @@ bool PIOS_Recursive_Mutex_Lock(struct pios_recursive_mutex *mtx, uint32_t timeou
 
 	chSysLock();
 
-	if (chThdSelf() != mtx->mtx.m_owner)
+	if (chThdSelf() != mtx->mtx.m_owner) {
+#if defined(DIAG_MUTEXES)
+		Thread *owner = mtx->mtx.m_owner;
+
+		if (owner != NULL) {
+			uint32_t start = PIOS_DELAY_GetRaw();
+
+			chMtxLockS(&mtx->mtx);
+			mutex_stats_record(&mtx->stats, owner, start);
+		} else {
+			chMtxLockS(&mtx->mtx);
+		}
+#else
 		chMtxLockS(&mtx->mtx);
+#endif
+	}
 
 	++mtx->count;
 
@@ -47,7 +47,7 @@ struct omnip_dev_s {
 	int num_received;
 	int num_invalid;
 
-	struct pios_queue *queue;
+	struct pios_spsc_queue *queue;
 
 	struct pios_sensor_rangefinder_data rf_data;
 };
@@ -97,7 +97,7 @@ static void PIOS_OMNIP_ProcessMessage(omnip_dev_t dev)
 	 * had not taken effect yet.
 	 */
 	if (dev->num_received > 2) {
-		PIOS_Queue_Send(dev->queue, &dev->rf_data, 0);
+		PIOS_SPSC_Queue_Send(dev->queue, &dev->rf_data, 1, NULL);
 	}
 
 	return;
@@ -182,8 +182,7 @@ int32_t PIOS_OMNIP_Init(omnip_dev_t *dev,
 		.magic = PIOS_OMNIP_DEV_MAGIC,
 	};
 
-	(*dev)->queue = PIOS_Queue_Create(2,
-			sizeof(struct pios_sensor_rangefinder_data));
+	(*dev)->queue = PIOS_SPSC_Queue_Create(sizeof(struct pios_sensor_rangefinder_data), 2, 1);
 
 	if (!(*dev)->queue) {
 		return -2;
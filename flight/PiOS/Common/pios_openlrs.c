@@ -1190,8 +1190,12 @@ static void pios_openlrs_rx_after_receive(pios_openlrs_t openlrs_dev,
 		openlrs_dev->numberOfLostPackets = 0;
 		openlrs_dev->nextBeaconTimeMs = 0;
 
-		/* Could consider splitting difference with interval */
-		openlrs_dev->lastPacketTimeUs = timeUs;
+		/* Anchor the hop schedule to when the packet actually
+		 * arrived, not to when this task got around to it; that
+		 * depends on CPU load and on how long the frame took to
+		 * handle (e.g. sending telemetry back).
+		 */
+		openlrs_dev->lastPacketTimeUs = openlrs_dev->rxPacketTimeUs;
 		openlrs_dev->linkLossTimeMs = 0;
 	} else if (openlrs_dev->numberOfLostPackets < openlrs_dev->hopcount) {
 		DEBUG_PRINTF(2,"OLRS WARN: Lost packet: %d\r\n",
@@ -1809,6 +1813,7 @@ bool PIOS_OpenLRS_EXT_Int(pios_openlrs_t openlrs_dev)
 	if (openlrs_dev->rf_mode == Transmit) {
 		openlrs_dev->rf_mode = Transmitted;
 	} else if (openlrs_dev->rf_mode == Receive) {
+		openlrs_dev->rxPacketTimeUs = PIOS_DELAY_GetuS();
 		openlrs_dev->rf_mode = Received;
 	}
 
@@ -2314,11 +2319,23 @@ static void rfm22_set_frequency(pios_openlrs_t openlrs_dev, uint32_t f)
 	rfm22_release_bus(openlrs_dev);
 }
 
+DONT_BUILD_IF(RFM22_interrupt_status2 != RFM22_interrupt_status1 + 1,
+		ItStatusNotAdjacent);
+
 /* Must have claimed bus first */
 static void rfm22_get_it_status(pios_openlrs_t openlrs_dev)
 {
-	openlrs_dev->it_status1 = rfm22_read(openlrs_dev, RFM22_interrupt_status1);
-	openlrs_dev->it_status2 = rfm22_read(openlrs_dev, RFM22_interrupt_status2);
+	/* Both status registers in one burst; reading them is what
+	 * clears the interrupt, so this is on every packet's path. */
+	uint8_t out[3] = { RFM22_interrupt_status1 & 0x7F, 0xFF, 0xFF };
+	uint8_t in[3];
+
+	rfm22_assert_cs(openlrs_dev);
+	PIOS_SPI_TransferBlock(openlrs_dev->spi_id, out, in, sizeof(out));
+	rfm22_deassert_cs(openlrs_dev);
+
+	openlrs_dev->it_status1 = in[1];
+	openlrs_dev->it_status2 = in[2];
 }
 
 static void rfm22_check_hang(pios_openlrs_t openlrs_dev)
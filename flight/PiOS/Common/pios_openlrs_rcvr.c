@@ -43,10 +43,12 @@
 
 /* Provide a RCVR driver */
 static int32_t PIOS_OpenLRS_Rcvr_Get(uintptr_t rcvr_id, uint8_t channel);
+static int32_t PIOS_OpenLRS_Rcvr_ReadAll(uintptr_t openlrs_rcvr_id, int32_t *channels, uint8_t num_channels);
 static void PIOS_OpenLRS_Rcvr_Supervisor(uintptr_t ppm_id);
 
 const struct pios_rcvr_driver pios_openlrs_rcvr_driver = {
 	.read = PIOS_OpenLRS_Rcvr_Get,
+	.read_all = PIOS_OpenLRS_Rcvr_ReadAll,
 };
 
 /* Local Variables */
@@ -182,6 +184,28 @@ static int32_t PIOS_OpenLRS_Rcvr_Get(uintptr_t openlrs_rcvr_id, uint8_t channel)
 	return openlrs_rcvr_dev->channels[channel];
 }
 
+/**
+ * Get all the channels at once
+ * \output PIOS_RCVR_INVALID on an invalid device
+ * \output the number of channels filled in
+ */
+static int32_t PIOS_OpenLRS_Rcvr_ReadAll(uintptr_t openlrs_rcvr_id, int32_t *channels, uint8_t num_channels)
+{
+	struct pios_openlrs_rcvr_dev *openlrs_rcvr_dev =
+			(struct pios_openlrs_rcvr_dev *)openlrs_rcvr_id;
+
+	if (!PIOS_OpenLRS_Rcvr_Validate(openlrs_rcvr_dev))
+		return PIOS_RCVR_INVALID;
+
+	if (num_channels > OPENLRS_PPM_NUM_CHANNELS)
+		num_channels = OPENLRS_PPM_NUM_CHANNELS;
+
+	for (int i = 0; i < num_channels; i++)
+		channels[i] = openlrs_rcvr_dev->channels[i];
+
+	return num_channels;
+}
+
 static void PIOS_OpenLRS_Rcvr_Supervisor(uintptr_t openlrs_rcvr_id)
 {
 	/* Recover our device context */
@@ -37,7 +37,7 @@
 
 #include "pios_semaphore.h"
 #include "pios_thread.h"
-#include "pios_queue.h"
+#include "pios_spsc_queue.h"
 
 /* Private constants */
 #define PX4FLOW_TASK_PRIORITY        PIOS_THREAD_PRIO_HIGH
@@ -55,8 +55,8 @@ enum pios_px4flow_dev_magic {
 struct px4flow_dev {
 	pios_i2c_t i2c_id;
 	const struct pios_px4flow_cfg *cfg;
-	struct pios_queue *optical_flow_queue;
-	struct pios_queue *rangefinder_queue;
+	struct pios_spsc_queue *optical_flow_queue;
+	struct pios_spsc_queue *rangefinder_queue;
 	struct pios_thread *task;
 	struct pios_semaphore *data_ready_sema;
 	enum pios_px4flow_dev_magic magic;
@@ -81,8 +81,8 @@ static struct px4flow_dev * PIOS_PX4Flow_alloc(void)
 	
 	px4flow_dev->magic = PIOS_PX4FLOW_DEV_MAGIC;
 	
-	px4flow_dev->optical_flow_queue = PIOS_Queue_Create(PIOS_PX4FLOW_MAX_DOWNSAMPLE, sizeof(struct pios_sensor_optical_flow_data));
-	px4flow_dev->rangefinder_queue = PIOS_Queue_Create(PIOS_PX4FLOW_MAX_DOWNSAMPLE, sizeof(struct pios_sensor_rangefinder_data));
+	px4flow_dev->optical_flow_queue = PIOS_SPSC_Queue_Create(sizeof(struct pios_sensor_optical_flow_data), PIOS_PX4FLOW_MAX_DOWNSAMPLE, 1);
+	px4flow_dev->rangefinder_queue = PIOS_SPSC_Queue_Create(sizeof(struct pios_sensor_rangefinder_data), PIOS_PX4FLOW_MAX_DOWNSAMPLE, 1);
 	if (px4flow_dev->optical_flow_queue == NULL || px4flow_dev->rangefinder_queue == NULL) {
 		PIOS_free(px4flow_dev);
 		return NULL;
@@ -238,7 +238,7 @@ static int32_t PIOS_PX4Flow_ReadData()
 			rangefinder_data.range_status = true;
 		}
 
-		PIOS_Queue_Send(dev->rangefinder_queue, &rangefinder_data, 0);
+		PIOS_SPSC_Queue_Send(dev->rangefinder_queue, &rangefinder_data, 1, NULL);
 	}
 
 	/* Rotate the flow from the sensor frame into the body frame. It's not
@@ -256,7 +256,7 @@ static int32_t PIOS_PX4Flow_ReadData()
 
 	optical_flow_data.quality = i2c_frame.qual;
 
-	PIOS_Queue_Send(dev->optical_flow_queue, &optical_flow_data, 0);
+	PIOS_SPSC_Queue_Send(dev->optical_flow_queue, &optical_flow_data, 1, NULL);
 
 	return 0;
 }
@@ -36,6 +36,8 @@ static struct pios_rcvr_dev * PIOS_RCVR_alloc(void)
 
 static struct pios_semaphore *rcvr_activity;
 static uint32_t rcvr_last_wake;
+static uint32_t rcvr_last_frame;
+static bool rcvr_have_frame;
 
 /**
   * Initialises RCVR layer
@@ -118,6 +120,52 @@ int32_t PIOS_RCVR_Read(uintptr_t rcvr_id, uint8_t channel)
   return rcvr_dev->driver->read(rcvr_dev->lower_id, channel);
 }
 
+/**
+ * @brief Reads the first num_channels channels at once
+ *
+ * One call into drivers providing read_all, instead of one per channel.
+ * @param[in] rcvr_id driver to read from
+ * @param[out] channels channel 1 goes in channels[0], and so on; each is
+ * what PIOS_RCVR_Read would give for it
+ * @param[in] num_channels how many channels to read
+ * @returns how many channels the driver has of those asked for, or
+ *  @retval PIOS_RCVR_INVALID invalid device
+ *  @retval PIOS_RCVR_NODRIVER driver was not initialized
+ */
+int32_t PIOS_RCVR_ReadAll(uintptr_t rcvr_id, int32_t *channels, uint8_t num_channels)
+{
+  int32_t filled;
+
+  if (rcvr_id == 0) {
+    filled = PIOS_RCVR_NODRIVER;
+  } else {
+    struct pios_rcvr_dev * rcvr_dev = (struct pios_rcvr_dev *)rcvr_id;
+
+    if (!PIOS_RCVR_validate(rcvr_dev)) {
+      /* Undefined RCVR port for this board (see pios_board.c) */
+      PIOS_Assert(0);
+    }
+
+    if (rcvr_dev->driver->read_all) {
+      filled = rcvr_dev->driver->read_all(rcvr_dev->lower_id, channels,
+          num_channels);
+    } else {
+      PIOS_DEBUG_Assert(rcvr_dev->driver->read);
+
+      for (filled = 0; filled < num_channels; filled++) {
+        channels[filled] = rcvr_dev->driver->read(rcvr_dev->lower_id, filled);
+      }
+    }
+  }
+
+  /* Whatever the driver didn't have reads as the error, or invalid */
+  for (int i = (filled < 0) ? 0 : filled; i < num_channels; i++) {
+    channels[i] = (filled < 0) ? filled : PIOS_RCVR_INVALID;
+  }
+
+  return filled;
+}
+
 #define MIN_WAKE_INTERVAL_uS 4000	/* 250Hz ought to be enough for anyone*/
 
 bool PIOS_RCVR_WaitActivity(uint32_t timeout_ms) {
@@ -137,7 +185,23 @@ bool PIOS_RCVR_WaitActivity(uint32_t timeout_ms) {
   }
 }
 
+/**
+ * Gets how long ago the last receiver frame arrived, as reported by
+ * PIOS_RCVR_Active / PIOS_RCVR_ActiveFromISR.
+ * \return microseconds since the frame, or UINT32_MAX if there hasn't been one
+ */
+uint32_t PIOS_RCVR_GetFrameAge() {
+  if (!rcvr_have_frame) {
+    return UINT32_MAX;
+  }
+
+  return PIOS_DELAY_DiffuS(rcvr_last_frame);
+}
+
 void PIOS_RCVR_Active() {
+  rcvr_last_frame = PIOS_DELAY_GetRaw();
+  rcvr_have_frame = true;
+
   if (PIOS_DELAY_DiffuS(rcvr_last_wake) >= MIN_WAKE_INTERVAL_uS) {
     if (rcvr_activity) {
       rcvr_last_wake = PIOS_DELAY_GetRaw();
@@ -152,6 +216,9 @@ void PIOS_RCVR_Active() {
 }
 
 void PIOS_RCVR_ActiveFromISR() {
+  rcvr_last_frame = PIOS_DELAY_GetRaw();
+  rcvr_have_frame = true;
+
   if (PIOS_DELAY_DiffuS(rcvr_last_wake) >= MIN_WAKE_INTERVAL_uS) {
     bool dont_care;
 
@@ -36,6 +36,7 @@
 
 /* Forward Declarations */
 static int32_t PIOS_SBus_Get(uintptr_t rcvr_id, uint8_t channel);
+static int32_t PIOS_SBus_ReadAll(uintptr_t rcvr_id, int32_t *channels, uint8_t num_channels);
 static uint16_t PIOS_SBus_RxInCallback(uintptr_t context,
 				       uint8_t *buf,
 				       uint16_t buf_len,
@@ -47,6 +48,7 @@ static void PIOS_SBus_Supervisor(uintptr_t sbus_id);
 /* Local Variables */
 const struct pios_rcvr_driver pios_sbus_rcvr_driver = {
 	.read = PIOS_SBus_Get,
+	.read_all = PIOS_SBus_ReadAll,
 };
 
 enum pios_sbus_dev_magic {
@@ -150,6 +152,27 @@ static int32_t PIOS_SBus_Get(uintptr_t rcvr_id, uint8_t channel)
 	return sbus_dev->state.channel_data[channel];
 }
 
+/**
+ * Get all the channels at once
+ * \output PIOS_RCVR_INVALID on an invalid device
+ * \output the number of channels filled in
+ */
+static int32_t PIOS_SBus_ReadAll(uintptr_t rcvr_id, int32_t *channels, uint8_t num_channels)
+{
+	struct pios_sbus_dev *sbus_dev = (struct pios_sbus_dev *)rcvr_id;
+
+	if (!PIOS_SBus_Validate(sbus_dev))
+		return PIOS_RCVR_INVALID;
+
+	if (num_channels > PIOS_SBUS_NUM_INPUTS)
+		num_channels = PIOS_SBUS_NUM_INPUTS;
+
+	for (int i = 0; i < num_channels; i++)
+		channels[i] = sbus_dev->state.channel_data[i];
+
+	return num_channels;
+}
+
 /**
  * Compute channel_data[] from received_data[].
  * For efficiency it unrolls first 8 channels without loops and does the
@@ -243,7 +266,17 @@ static uint16_t PIOS_SBus_RxInCallback(uintptr_t context,
 	struct pios_sbus_state *state = &(sbus_dev->state);
 
 	/* process byte(s) and clear receive timer */
-	for (uint8_t i = 0; i < buf_len; i++) {
+	for (uint16_t i = 0; i < buf_len; i++) {
+		/* With DMA reception whole frames tend to show up at once;
+		 * take those in one go */
+		if (state->byte_count == 1 &&
+				buf_len - i >= SBUS_FRAME_LENGTH - 1) {
+			memcpy(state->received_data, &buf[i],
+					SBUS_FRAME_LENGTH - 2);
+			state->byte_count = SBUS_FRAME_LENGTH - 1;
+			i += SBUS_FRAME_LENGTH - 2;
+		}
+
 		PIOS_SBus_UpdateState(state, buf[i]);
 	}
 
@@ -0,0 +1,246 @@
+/**
+ ******************************************************************************
+ * @addtogroup PIOS PIOS Core hardware abstraction layer
+ * @{
+ * @addtogroup PIOS_SENSORREPLAY Sensor replay
+ * @{
+ *
+ * @file       pios_sensorreplay.c
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2017
+ * @brief      Feeds recorded sensor samples back into the sensor queues, at
+ *             the times they were recorded, so that estimator and filter
+ *             changes can be compared on the same input.
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+/* Project Includes */
+#include "pios.h"
+
+#if defined(PIOS_INCLUDE_SENSORREPLAY)
+
+#include "pios_sensorreplay.h"
+#include "pios_thread.h"
+#include "pios_spsc_queue.h"
+
+/* Private constants */
+#define REPLAY_NUM_TYPES	4	/* accel, gyro, mag, baro */
+#define REPLAY_QUEUE_LEN	16	/* A couple of ms of 8kHz gyro */
+#define REPLAY_STACK_SIZE	PIOS_THREAD_STACK_SIZE_MIN
+#define REPLAY_TASK_PRIORITY	PIOS_THREAD_PRIO_HIGHEST
+
+DONT_BUILD_IF(PIOS_SENSOR_ACCEL != 0 || PIOS_SENSOR_GYRO != 1 ||
+		PIOS_SENSOR_MAG != 2 || PIOS_SENSOR_BARO != 3,
+		ReplayTypesMatchFormat);
+
+/* Private types */
+struct pios_sensorreplay_dev {
+	pios_sensorreplay_read_t read_cb;
+	void *ctx;
+
+	struct pios_spsc_queue *queue[REPLAY_NUM_TYPES];
+
+	volatile uint32_t dropped;
+	volatile bool finished;
+};
+
+static const uint8_t sample_size[REPLAY_NUM_TYPES] = {
+	[PIOS_SENSOR_ACCEL] = sizeof(struct pios_sensor_accel_data),
+	[PIOS_SENSOR_GYRO]  = sizeof(struct pios_sensor_gyro_data),
+	[PIOS_SENSOR_MAG]   = sizeof(struct pios_sensor_mag_data),
+	[PIOS_SENSOR_BARO]  = sizeof(struct pios_sensor_baro_data),
+};
+
+/* Private functions */
+static void PIOS_SENSORREPLAY_Task(void *parameters);
+
+/**
+ * Read exactly len bytes of the recording
+ * @return true if they were all there
+ */
+static bool replay_read(pios_sensorreplay_t dev, void *buf, uint32_t len)
+{
+	uint8_t *pos = buf;
+
+	while (len > 0) {
+		int32_t got = dev->read_cb(dev->ctx, pos, len);
+
+		if (got <= 0) {
+			return false;
+		}
+
+		pos += got;
+		len -= got;
+	}
+
+	return true;
+}
+
+/**
+ * Read the next record of a type we know the size of
+ * @return false at the end of the recording, or if it is corrupt
+ */
+static bool replay_next(pios_sensorreplay_t dev,
+		struct pios_sensorreplay_record *rec, void *sample)
+{
+	if (!replay_read(dev, rec, sizeof(*rec))) {
+		return false;
+	}
+
+	if (rec->type >= REPLAY_NUM_TYPES) {
+		return false;
+	}
+
+	return replay_read(dev, sample, sample_size[rec->type]);
+}
+
+/**
+ * Start replaying a recording
+ * @param[out] dev the replay instance
+ * @param[in] read_cb reads the recording, from the start
+ * @param[in] ctx passed to read_cb
+ * @return 0 on success, negative if the recording can't be used
+ */
+int32_t PIOS_SENSORREPLAY_Init(pios_sensorreplay_t *dev,
+		pios_sensorreplay_read_t read_cb, void *ctx)
+{
+	struct pios_sensorreplay_header header;
+
+	struct pios_sensorreplay_dev *replay_dev =
+		PIOS_malloc(sizeof(*replay_dev));
+
+	if (!replay_dev) {
+		return -1;
+	}
+
+	memset(replay_dev, 0, sizeof(*replay_dev));
+
+	replay_dev->read_cb = read_cb;
+	replay_dev->ctx = ctx;
+
+	if (!replay_read(replay_dev, &header, sizeof(header)) ||
+			(header.magic != PIOS_SENSORREPLAY_MAGIC)) {
+		PIOS_free(replay_dev);
+		return -2;
+	}
+
+	if (!header.sample_rate[PIOS_SENSOR_GYRO]) {
+		/* Nothing would ever tick the control loop */
+		PIOS_free(replay_dev);
+		return -3;
+	}
+
+	for (int i = 0; i < REPLAY_NUM_TYPES; i++) {
+		if (!header.sample_rate[i]) {
+			continue;
+		}
+
+		replay_dev->queue[i] = PIOS_SPSC_Queue_Create(sample_size[i],
+				REPLAY_QUEUE_LEN, 1);
+
+		if (!replay_dev->queue[i]) {
+			return -4;
+		}
+
+		PIOS_SENSORS_SetSampleRate(i, header.sample_rate[i]);
+		PIOS_SENSORS_Register(i, replay_dev->queue[i]);
+	}
+
+	if (header.max_gyro) {
+		PIOS_SENSORS_SetMaxGyro(header.max_gyro);
+	}
+
+	struct pios_thread *replay_task = PIOS_Thread_Create(
+			PIOS_SENSORREPLAY_Task, "pios_sensorreplay",
+			REPLAY_STACK_SIZE, replay_dev, REPLAY_TASK_PRIORITY);
+
+	if (!replay_task) {
+		return -5;
+	}
+
+	*dev = replay_dev;
+
+	return 0;
+}
+
+/**
+ * Samples that were due while the sensors queue was full
+ */
+uint32_t PIOS_SENSORREPLAY_GetDropped(pios_sensorreplay_t dev)
+{
+	return dev->dropped;
+}
+
+/**
+ * Whether the whole recording has been sent
+ */
+bool PIOS_SENSORREPLAY_IsFinished(pios_sensorreplay_t dev)
+{
+	return dev->finished;
+}
+
+static void PIOS_SENSORREPLAY_Task(void *parameters)
+{
+	pios_sensorreplay_t dev = parameters;
+
+	struct pios_sensorreplay_record rec;
+	union {
+		struct pios_sensor_accel_data accel;
+		struct pios_sensor_gyro_data gyro;
+		struct pios_sensor_mag_data mag;
+		struct pios_sensor_baro_data baro;
+	} sample;
+
+	bool have_rec = replay_next(dev, &rec, &sample);
+
+	uint32_t first_us = rec.time_us;
+	uint32_t start_raw = PIOS_DELAY_GetRaw();
+
+	while (have_rec) {
+		uint32_t due_us = rec.time_us - first_us;
+		uint32_t elapsed_us = PIOS_DELAY_DiffuS(start_raw);
+
+		/* Sleep through whole ms; samples closer together than
+		 * that go out in a burst, like a sensor FIFO's would. */
+		if ((int32_t) (due_us - elapsed_us) >= 1000) {
+			PIOS_Thread_Sleep((due_us - elapsed_us) / 1000);
+			continue;
+		}
+
+		struct pios_spsc_queue *q = dev->queue[rec.type];
+
+		if (q && !PIOS_SPSC_Queue_Send(q, &sample, 1, NULL)) {
+			dev->dropped++;
+		}
+
+		have_rec = replay_next(dev, &rec, &sample);
+	}
+
+	dev->finished = true;
+
+	/* Sensors go quiet from here, as if they had failed */
+	while (true) {
+		PIOS_Thread_Sleep(1000);
+	}
+}
+
+#endif /* PIOS_INCLUDE_SENSORREPLAY */
+
+/**
+ * @}
+ * @}
+ */
@@ -35,11 +35,30 @@
 #include <unistd.h>
 #endif
 
+//! A ring of samples, written and read in place
+struct pios_sensor_ring {
+	uint8_t *samples;
+	uint32_t *timestamps;
+	uint16_t sample_size;
+	uint16_t num_slots;
+
+	volatile uint32_t head;		/* Count of published samples */
+	uint32_t read_seq;		/* Next sample for GetData/GetDataBatch */
+
+	PIOS_SENSOR_FillCallback_t fill_cb;
+	void *fill_ctx;
+};
+
 //! The list of queue handles / callbacks
 static struct PIOS_Sensor {
 	PIOS_SENSOR_Callback_t getdata_cb;
 	void *getdata_ctx;
 
+	PIOS_SENSOR_BatchCallback_t getbatch_cb;
+	void *getbatch_ctx;
+
+	struct pios_sensor_ring *ring;
+
 	uint32_t next_time;
 
 	uint16_t sample_rate;
@@ -58,11 +77,11 @@ int32_t PIOS_SENSORS_Init()
 static bool PIOS_SENSORS_QueueCallback(void *ctx, void *buf,
 		int ms_to_wait, int *next_call)
 {
-	struct pios_queue *q = ctx;
+	struct pios_spsc_queue *q = ctx;
 
 	*next_call = 0;		/* May immediately have data on next call */
 
-	return PIOS_Queue_Receive(q, buf, ms_to_wait);
+	return PIOS_SPSC_Queue_Receive(q, buf, 1, ms_to_wait, NULL) == 1;
 }
 
 int32_t PIOS_SENSORS_RegisterCallback(enum pios_sensor_type type,
@@ -79,7 +98,20 @@ int32_t PIOS_SENSORS_RegisterCallback(enum pios_sensor_type type,
 	return 0;
 }
 
-int32_t PIOS_SENSORS_Register(enum pios_sensor_type type, struct pios_queue *queue)
+int32_t PIOS_SENSORS_RegisterBatchCallback(enum pios_sensor_type type,
+		PIOS_SENSOR_BatchCallback_t callback, void *ctx)
+{
+	PIOS_Assert(type < PIOS_SENSOR_NUM);
+
+	struct PIOS_Sensor *sensor = &sensors[type];
+
+	sensor->getbatch_ctx = ctx;
+	sensor->getbatch_cb = callback;
+
+	return 0;
+}
+
+int32_t PIOS_SENSORS_Register(enum pios_sensor_type type, struct pios_spsc_queue *queue)
 {
 	return PIOS_SENSORS_RegisterCallback(type,
 			PIOS_SENSORS_QueueCallback, queue);
@@ -97,7 +129,176 @@ bool PIOS_SENSORS_IsRegistered(enum pios_sensor_type type)
 		return false;
 	}
 
-	return sensor->getdata_cb != NULL;
+	return sensor->getdata_cb != NULL || sensor->ring != NULL;
+}
+
+int32_t PIOS_SENSORS_RegisterRing(enum pios_sensor_type type,
+		uint16_t sample_size, uint16_t num_slots,
+		PIOS_SENSOR_FillCallback_t fill_cb, void *ctx)
+{
+	PIOS_Assert(type < PIOS_SENSOR_NUM);
+	PIOS_Assert(num_slots >= 2);
+
+	struct PIOS_Sensor *sensor = &sensors[type];
+
+	/* No free(), so a ring is allocated once and has to keep its shape */
+	if (sensor->ring) {
+		PIOS_Assert(sensor->ring->sample_size == sample_size &&
+				sensor->ring->num_slots == num_slots);
+	} else {
+		struct pios_sensor_ring *ring = PIOS_malloc_no_dma(sizeof(*ring));
+		PIOS_Assert(ring);
+
+		*ring = (struct pios_sensor_ring) {
+			.samples = PIOS_malloc_no_dma(sample_size * num_slots),
+			.timestamps = PIOS_malloc_no_dma(sizeof(uint32_t) * num_slots),
+			.sample_size = sample_size,
+			.num_slots = num_slots,
+		};
+		PIOS_Assert(ring->samples && ring->timestamps);
+
+		sensor->ring = ring;
+	}
+
+	sensor->ring->fill_cb = fill_cb;
+	sensor->ring->fill_ctx = ctx;
+	sensor->ring->read_seq = sensor->ring->head;
+	sensor->missing = 0;
+
+	return 0;
+}
+
+bool PIOS_SENSORS_HasRing(enum pios_sensor_type type)
+{
+	if (type >= PIOS_SENSOR_NUM) {
+		return false;
+	}
+
+	return sensors[type].ring != NULL;
+}
+
+void *PIOS_SENSORS_RingNext(enum pios_sensor_type type, uint32_t timestamp)
+{
+	PIOS_Assert(type < PIOS_SENSOR_NUM);
+
+	struct pios_sensor_ring *ring = sensors[type].ring;
+	PIOS_Assert(ring);
+
+	uint16_t slot = ring->head % ring->num_slots;
+
+	ring->timestamps[slot] = timestamp;
+
+	return ring->samples + slot * ring->sample_size;
+}
+
+void PIOS_SENSORS_RingPublish(enum pios_sensor_type type)
+{
+	struct pios_sensor_ring *ring = sensors[type].ring;
+
+	/* The sample has to be in place before readers see it */
+	__sync_synchronize();
+
+	ring->head++;
+}
+
+uint32_t PIOS_SENSORS_RingWait(enum pios_sensor_type type, uint32_t seq,
+		int ms_to_wait)
+{
+	struct pios_sensor_ring *ring = sensors[type].ring;
+
+	if (!ring) {
+		return seq;
+	}
+
+	if (ring->head == seq && ring->fill_cb) {
+		ring->fill_cb(ring->fill_ctx, ms_to_wait);
+	}
+
+	return ring->head;
+}
+
+bool PIOS_SENSORS_RingValid(enum pios_sensor_type type, uint32_t seq)
+{
+	struct pios_sensor_ring *ring = sensors[type].ring;
+
+	/* The slot at head may be mid-write, so a ring holds one less */
+	uint32_t age = ring->head - seq;
+
+	return age != 0 && age < ring->num_slots;
+}
+
+const void *PIOS_SENSORS_RingGet(enum pios_sensor_type type, uint32_t seq,
+		uint32_t *timestamp)
+{
+	struct pios_sensor_ring *ring = sensors[type].ring;
+
+	if (!ring || !PIOS_SENSORS_RingValid(type, seq)) {
+		return NULL;
+	}
+
+	__sync_synchronize();
+
+	uint16_t slot = seq % ring->num_slots;
+
+	if (timestamp) {
+		*timestamp = ring->timestamps[slot];
+	}
+
+	return ring->samples + slot * ring->sample_size;
+}
+
+uint32_t PIOS_SENSORS_RingOldest(enum pios_sensor_type type, uint32_t seq)
+{
+	struct pios_sensor_ring *ring = sensors[type].ring;
+
+	uint32_t head = ring->head;
+
+	if (head - seq >= ring->num_slots) {
+		return head - (ring->num_slots - 1);
+	}
+
+	return seq;
+}
+
+/* Copies out of a ring for consumers that use GetData/GetDataBatch. */
+static int PIOS_SENSORS_RingCopy(struct PIOS_Sensor *sensor,
+		enum pios_sensor_type type, void *buf, uint32_t *timestamps,
+		int max_samples, int ms_to_wait, bool newest_only)
+{
+	struct pios_sensor_ring *ring = sensor->ring;
+
+	uint32_t head = PIOS_SENSORS_RingWait(type, ring->read_seq, ms_to_wait);
+	uint32_t seq = PIOS_SENSORS_RingOldest(type, ring->read_seq);
+
+	if (newest_only && head != seq) {
+		seq = head - 1;
+	}
+
+	int count = 0;
+
+	for (; seq != head && count < max_samples; seq++) {
+		uint32_t timestamp;
+		const void *sample = PIOS_SENSORS_RingGet(type, seq, &timestamp);
+
+		if (!sample) {
+			continue;
+		}
+
+		memcpy((uint8_t *)buf + count * ring->sample_size, sample,
+				ring->sample_size);
+
+		if (PIOS_SENSORS_RingValid(type, seq)) {
+			if (timestamps) {
+				timestamps[count] = timestamp;
+			}
+
+			count++;
+		}
+	}
+
+	ring->read_seq = seq;
+
+	return count;
 }
 
 bool PIOS_SENSORS_GetData(enum pios_sensor_type type, void *buf, int ms_to_wait)
@@ -108,6 +309,11 @@ bool PIOS_SENSORS_GetData(enum pios_sensor_type type, void *buf, int ms_to_wait)
 
 	struct PIOS_Sensor *sensor = &sensors[type];
 
+	if (sensor->ring) {
+		return PIOS_SENSORS_RingCopy(sensor, type, buf, NULL, 1,
+				ms_to_wait, true) > 0;
+	}
+
 	if (!sensor->getdata_cb) {
 		return false;
 	}
@@ -125,7 +331,12 @@ bool PIOS_SENSORS_GetData(enum pios_sensor_type type, void *buf, int ms_to_wait)
 			if (PIOS_Thread_FakeClock_IsActive()) {
 				while (!PIOS_Thread_Period_Elapsed(now,
 							time_until)) {
-					usleep(1000);
+					/* Lockstep ticks as soon as
+					 * everyone is idle */
+					if (!PIOS_Thread_FakeClock_IsLockstep()) {
+						usleep(1000);
+					}
+
 					PIOS_Thread_FakeClock_Tick();
 				}
 			} else {
@@ -159,6 +370,37 @@ bool PIOS_SENSORS_GetData(enum pios_sensor_type type, void *buf, int ms_to_wait)
 	return ret;
 }
 
+int PIOS_SENSORS_GetDataBatch(enum pios_sensor_type type, void *buf,
+		uint32_t *timestamps, int max_samples, int ms_to_wait)
+{
+	if (type >= PIOS_SENSOR_NUM || max_samples < 1) {
+		return 0;
+	}
+
+	struct PIOS_Sensor *sensor = &sensors[type];
+
+	if (sensor->ring) {
+		return PIOS_SENSORS_RingCopy(sensor, type, buf, timestamps,
+				max_samples, ms_to_wait, false);
+	}
+
+	if (sensor->getbatch_cb) {
+		return sensor->getbatch_cb(sensor->getbatch_ctx, buf,
+				timestamps, max_samples, ms_to_wait);
+	}
+
+	/* Sensors without batch support hand out one sample at a time */
+	if (!PIOS_SENSORS_GetData(type, buf, ms_to_wait)) {
+		return 0;
+	}
+
+	if (timestamps) {
+		timestamps[0] = PIOS_DELAY_GetuS();
+	}
+
+	return 1;
+}
+
 void PIOS_SENSORS_SetMaxGyro(int32_t rate)
 {
 	max_gyro_rate = rate;
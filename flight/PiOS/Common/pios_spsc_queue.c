@@ -0,0 +1,386 @@
+/**
+ ******************************************************************************
+ * @file       pios_spsc_queue.c
+ * @author     dRonin, http://dronin.org Copyright (C) 2017
+ * @addtogroup PIOS PIOS Core hardware abstraction layer
+ * @{
+ * @addtogroup PIOS_SPSC_Queue Single producer, single consumer queue
+ * @{
+ * @brief Lock-free queue with wakeups only when the other side waits
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "pios.h"
+#include "pios_spsc_queue.h"
+#include "pios_semaphore.h"
+#include "pios_mutex.h"
+
+#include <circqueue.h>
+
+struct pios_spsc_queue {
+	circ_queue_t cq;
+	uint16_t wake_threshold;
+
+	/* Nonzero while that side is blocked; how many items (space) it
+	 * needs before it's worth waking. */
+	volatile uint16_t reader_want;
+	volatile uint16_t writer_want;
+
+	struct pios_semaphore *data_sem;
+	struct pios_semaphore *space_sem;
+
+#if defined(PIOS_INCLUDE_RTOS)
+	/* Writers that block, as several PIOS_COM senders may, wait one at a
+	 * time; there is only the one writer_want. */
+	struct pios_mutex *writer_mtx;
+#endif
+};
+
+/**
+ * @brief Creates a queue.
+ *
+ * @param[in] item_size size of each item
+ * @param[in] queue_length number of items the queue holds
+ * @param[in] wake_threshold items that must be queued before a blocked
+ * reader is woken, unless it asked for fewer
+ *
+ * @returns the queue, or NULL on failure
+ */
+struct pios_spsc_queue *PIOS_SPSC_Queue_Create(uint16_t item_size,
+		uint16_t queue_length, uint16_t wake_threshold)
+{
+	PIOS_Assert(queue_length > 0);
+	PIOS_Assert(wake_threshold > 0 && wake_threshold <= queue_length);
+
+	struct pios_spsc_queue *q = PIOS_malloc_no_dma(sizeof(*q));
+
+	if (!q)
+		return NULL;
+
+	/* circqueue keeps one slot empty */
+	q->cq = circ_queue_new(item_size, queue_length + 1);
+	q->data_sem = PIOS_Semaphore_Create();
+	q->space_sem = PIOS_Semaphore_Create();
+
+	if (!q->cq || !q->data_sem || !q->space_sem)
+		return NULL;
+
+#if defined(PIOS_INCLUDE_RTOS)
+	q->writer_mtx = PIOS_Mutex_Create();
+
+	if (!q->writer_mtx)
+		return NULL;
+#endif
+
+	q->wake_threshold = wake_threshold;
+	q->reader_want = 0;
+	q->writer_want = 0;
+
+	return q;
+}
+
+static void spsc_signal(struct pios_semaphore *sem, bool *wokenp)
+{
+	if (PIOS_IRQ_InISR()) {
+		bool woken = false;
+
+		PIOS_Semaphore_Give_FromISR(sem, &woken);
+
+		if (wokenp && woken)
+			*wokenp = true;
+	} else {
+		PIOS_Semaphore_Give(sem);
+	}
+}
+
+/**
+ * @brief What is left of a timeout that started at start_us.
+ */
+static uint32_t spsc_remaining(uint32_t start_us, uint32_t timeout_ms)
+{
+	if (timeout_ms == PIOS_SEMAPHORE_TIMEOUT_MAX)
+		return timeout_ms;
+
+	uint32_t elapsed_ms = PIOS_DELAY_GetuSSince(start_us) / 1000;
+
+	return (elapsed_ms < timeout_ms) ? timeout_ms - elapsed_ms : 0;
+}
+
+/**
+ * @brief Blocks one side until the other has made enough progress.
+ *
+ * The flag goes up before the final check, so the other side either sees
+ * it and signals, or had already made the progress the check finds.
+ *
+ * @returns true if the condition was met
+ */
+static bool spsc_wait(struct pios_spsc_queue *q, volatile uint16_t *want,
+		struct pios_semaphore *sem, uint16_t (*level)(struct pios_spsc_queue *),
+		uint16_t needed, uint32_t start_us, uint32_t timeout_ms)
+{
+	while (level(q) < needed) {
+		/* Wakeups that don't satisfy the wait don't extend it */
+		uint32_t remaining = spsc_remaining(start_us, timeout_ms);
+
+		if (remaining == 0)
+			return false;
+
+		*want = needed;
+		__sync_synchronize();
+
+		if (level(q) >= needed) {
+			*want = 0;
+			return true;
+		}
+
+		/* A stale signal from an earlier wait just costs a loop */
+		bool signalled = PIOS_Semaphore_Take(sem, remaining);
+
+		*want = 0;
+
+		if (!signalled)
+			return level(q) >= needed;
+	}
+
+	return true;
+}
+
+/**
+ * @brief Wakes a blocked reader once a write has queued enough items.
+ */
+static void spsc_write_done(struct pios_spsc_queue *q, uint16_t sent,
+		bool *wokenp)
+{
+	__sync_synchronize();
+
+	uint16_t want = q->reader_want;
+
+	if (sent && want && PIOS_SPSC_Queue_Pending(q) >= want) {
+		q->reader_want = 0;
+		spsc_signal(q->data_sem, wokenp);
+	}
+}
+
+/**
+ * @brief Wakes a blocked writer once a read has freed enough space.
+ */
+static void spsc_read_done(struct pios_spsc_queue *q, uint16_t got,
+		bool *wokenp)
+{
+	__sync_synchronize();
+
+	uint16_t want = q->writer_want;
+
+	if (got && want && PIOS_SPSC_Queue_Space(q) >= want) {
+		q->writer_want = 0;
+		spsc_signal(q->space_sem, wokenp);
+	}
+}
+
+/**
+ * @brief Appends items to the queue.  Never blocks, so it may be called
+ * from an ISR.
+ *
+ * @param[in] q the queue
+ * @param[in] items items to append
+ * @param[in] num number of items
+ * @param[out] wokenp set true if a higher priority task was woken; may be NULL
+ *
+ * @returns number of items appended, fewer than num if the queue filled
+ */
+uint16_t PIOS_SPSC_Queue_Send(struct pios_spsc_queue *q, const void *items,
+		uint16_t num, bool *wokenp)
+{
+	uint16_t sent = circ_queue_write_data(q->cq, items, num);
+
+	spsc_write_done(q, sent, wokenp);
+
+	return sent;
+}
+
+/**
+ * @brief Gets the free space after the last queued item, so the writer can
+ * fill it in place.  Nothing is queued until PIOS_SPSC_Queue_Commit.
+ *
+ * @param[in] q the queue
+ * @param[out] num number of contiguous items that fit at the returned
+ * address
+ *
+ * @returns where the next item goes
+ */
+void *PIOS_SPSC_Queue_Reserve(struct pios_spsc_queue *q, uint16_t *num)
+{
+	return circ_queue_write_pos(q->cq, num, NULL);
+}
+
+/**
+ * @brief Queues items filled in after PIOS_SPSC_Queue_Reserve.
+ *
+ * @param[in] q the queue
+ * @param[in] num items to queue; no more than Reserve returned
+ * @param[out] wokenp set true if a higher priority task was woken; may be NULL
+ */
+void PIOS_SPSC_Queue_Commit(struct pios_spsc_queue *q, uint16_t num,
+		bool *wokenp)
+{
+	if (circ_queue_advance_write_multi(q->cq, num))
+		num = 0;
+
+	spsc_write_done(q, num, wokenp);
+}
+
+/**
+ * @brief Takes items from the queue.
+ *
+ * With a timeout, waits until the wake threshold (or max_items, if less)
+ * is queued, then returns whatever is there once it expires.
+ *
+ * @param[in] q the queue
+ * @param[out] items storage for max_items items
+ * @param[in] max_items most items to take
+ * @param[in] timeout_ms how long to wait; must be 0 from an ISR
+ * @param[out] wokenp set true if a higher priority task was woken; may be NULL
+ *
+ * @returns number of items taken
+ */
+uint16_t PIOS_SPSC_Queue_Receive(struct pios_spsc_queue *q, void *items,
+		uint16_t max_items, uint32_t timeout_ms, bool *wokenp)
+{
+	uint16_t needed = q->wake_threshold;
+
+	if (needed > max_items)
+		needed = max_items;
+
+	spsc_wait(q, &q->reader_want, q->data_sem, PIOS_SPSC_Queue_Pending,
+			needed, PIOS_DELAY_GetuS(), timeout_ms);
+
+	uint16_t got = circ_queue_read_data(q->cq, items, max_items);
+
+	spsc_read_done(q, got, wokenp);
+
+	return got;
+}
+
+/**
+ * @brief Gets the oldest contiguous run of queued items without copying
+ * them out.  The items stay queued until PIOS_SPSC_Queue_Consume.
+ *
+ * @param[in] q the queue
+ * @param[out] num number of contiguous items at the returned address
+ * @param[in] timeout_ms how long to wait for the wake threshold; must be 0
+ * from an ISR
+ *
+ * @returns the first item, or NULL if none are queued
+ */
+void *PIOS_SPSC_Queue_Peek(struct pios_spsc_queue *q, uint16_t *num,
+		uint32_t timeout_ms)
+{
+	spsc_wait(q, &q->reader_want, q->data_sem, PIOS_SPSC_Queue_Pending,
+			q->wake_threshold, PIOS_DELAY_GetuS(), timeout_ms);
+
+	void *items = circ_queue_read_pos(q->cq, num, NULL);
+
+	if (!items)
+		*num = 0;
+
+	return items;
+}
+
+/**
+ * @brief Releases items obtained from PIOS_SPSC_Queue_Peek.
+ *
+ * @param[in] q the queue
+ * @param[in] num items to release; no more than Peek returned
+ * @param[out] wokenp set true if a higher priority task was woken; may be NULL
+ */
+void PIOS_SPSC_Queue_Consume(struct pios_spsc_queue *q, uint16_t num,
+		bool *wokenp)
+{
+	circ_queue_read_completed_multi(q->cq, num);
+
+	spsc_read_done(q, num, wokenp);
+}
+
+/**
+ * @brief Waits, as the writer, until num items fit in the queue.  Writers
+ * that get here from several tasks wait in turn.
+ *
+ * @param[in] q the queue
+ * @param[in] num items that need to fit
+ * @param[in] timeout_ms how long to wait, in all
+ *
+ * @returns true if the space is there
+ */
+bool PIOS_SPSC_Queue_WaitSpace(struct pios_spsc_queue *q, uint16_t num,
+		uint32_t timeout_ms)
+{
+	if (PIOS_SPSC_Queue_Space(q) >= num)
+		return true;
+
+	uint32_t start_us = PIOS_DELAY_GetuS();
+
+#if defined(PIOS_INCLUDE_RTOS)
+	if (!PIOS_Mutex_Lock(q->writer_mtx, timeout_ms))
+		return PIOS_SPSC_Queue_Space(q) >= num;
+#endif
+
+	bool ok = spsc_wait(q, &q->writer_want, q->space_sem,
+			PIOS_SPSC_Queue_Space, num, start_us, timeout_ms);
+
+#if defined(PIOS_INCLUDE_RTOS)
+	PIOS_Mutex_Unlock(q->writer_mtx);
+#endif
+
+	return ok;
+}
+
+/**
+ * @brief Number of items waiting to be received.
+ */
+uint16_t PIOS_SPSC_Queue_Pending(struct pios_spsc_queue *q)
+{
+	uint16_t avail;
+
+	circ_queue_read_pos(q->cq, NULL, &avail);
+
+	return avail;
+}
+
+/**
+ * @brief Number of items that can be sent without blocking.
+ */
+uint16_t PIOS_SPSC_Queue_Space(struct pios_spsc_queue *q)
+{
+	uint16_t avail;
+
+	circ_queue_write_pos(q->cq, NULL, &avail);
+
+	return avail;
+}
+
+/**
+ * @brief Drops everything queued.  This moves the reader's position, so
+ * the reader must not be running at the same time.
+ */
+void PIOS_SPSC_Queue_Clear(struct pios_spsc_queue *q)
+{
+	circ_queue_clear(q->cq);
+}
+
+/**
+  * @}
+  * @}
+  */
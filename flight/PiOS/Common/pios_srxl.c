@@ -127,6 +127,7 @@ static void PIOS_SRXL_ResetChannels(struct pios_srxl_dev *dev, uint16_t val);
  * @param[in] channel Channel to grab, 0 based
  */
 static int32_t PIOS_SRXL_Read(uintptr_t id, uint8_t channel);
+static int32_t PIOS_SRXL_ReadAll(uintptr_t id, int32_t *channels, uint8_t num_channels);
 /**
  * @brief Supervisor task to handle failsafe and frame timeout
  * @ param[in] id Pointer to device structure
@@ -137,7 +138,8 @@ void PIOS_SRXL_Supervisor(uintptr_t id);
 
 /* Public Variables */
 const struct pios_rcvr_driver pios_srxl_rcvr_driver = {
-	.read = PIOS_SRXL_Read
+	.read = PIOS_SRXL_Read,
+	.read_all = PIOS_SRXL_ReadAll,
 };
 
 /* Implementation */
@@ -204,7 +206,6 @@ static uint16_t PIOS_SRXL_RxCallback(uintptr_t context, uint8_t *buf,
 		return PIOS_RCVR_INVALID;
 
 	dev->rx_timer = 0;
-	uint16_t consumed = 0;
 
 	for (int i = 0; i < buf_len; i++) {
 		if (dev->rx_buffer_pos == 0) {
@@ -223,14 +224,14 @@ static uint16_t PIOS_SRXL_RxCallback(uintptr_t context, uint8_t *buf,
 		PIOS_SRXL_UpdateCRC(dev, buf[i]);
 		if (dev->rx_buffer_pos == dev->frame_length)
 				PIOS_SRXL_ParseFrame(dev);
-		consumed++;
 	}
 
 	if (headroom)
 		*headroom = PIOS_SRXL_RXBUF_LEN - dev->rx_buffer_pos;
 	*task_woken = false;
 
-	return consumed;
+	/* Bytes outside of a frame are consumed too, by dropping them */
+	return buf_len;
 }
 
 static void PIOS_SRXL_ParseFrame(struct pios_srxl_dev *dev)
@@ -290,9 +291,32 @@ static int32_t PIOS_SRXL_Read(uintptr_t id, uint8_t channel)
 	struct pios_srxl_dev *dev = (struct pios_srxl_dev *)id;
 	if (!PIOS_SRXL_ValidateDev(dev))
 		return PIOS_RCVR_INVALID;
+	if (channel >= PIOS_SRXL_MAX_CHANNELS)
+		return PIOS_RCVR_INVALID;
 	return dev->channels[channel];
 }
 
+/**
+ * Get all the channels at once
+ * \output PIOS_RCVR_INVALID on an invalid device
+ * \output the number of channels filled in
+ */
+static int32_t PIOS_SRXL_ReadAll(uintptr_t id, int32_t *channels, uint8_t num_channels)
+{
+	struct pios_srxl_dev *dev = (struct pios_srxl_dev *)id;
+
+	if (!PIOS_SRXL_ValidateDev(dev))
+		return PIOS_RCVR_INVALID;
+
+	if (num_channels > PIOS_SRXL_MAX_CHANNELS)
+		num_channels = PIOS_SRXL_MAX_CHANNELS;
+
+	for (int i = 0; i < num_channels; i++)
+		channels[i] = dev->channels[i];
+
+	return num_channels;
+}
+
 static void PIOS_SRXL_ResetChannels(struct pios_srxl_dev *dev, uint16_t val)
 {
 	if (!PIOS_SRXL_ValidateDev(dev))
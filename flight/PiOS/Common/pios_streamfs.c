@@ -57,6 +57,9 @@
 #define PIOS_STREAMFS_TASK_PRIORITY    PIOS_THREAD_PRIO_LOW
 #define PIOS_STREAMFS_TASK_STACK_BYTES 1000
 
+/* How long a partly filled page may sit in RAM before being written out */
+#define PIOS_STREAMFS_FLUSH_MS         500
+
 /* Provide a COM driver */
 static void PIOS_STREAMFS_RegisterTxCallback(uintptr_t fs_id, pios_com_callback tx_out_cb, uintptr_t context);
 static void PIOS_STREAMFS_TxStart(uintptr_t fs_id, uint16_t tx_bytes_avail);
@@ -87,7 +90,18 @@ struct streamfs_state {
 	uintptr_t rx_in_context;
 	pios_com_callback tx_out_cb;
 	uintptr_t tx_out_context;
+
+	/*
+	 * Write-behind buffer.  Data from PIOS_COM is staged here until it
+	 * reaches the next write_size boundary in flash, so that flash is
+	 * programmed a whole aligned page at a time.
+	 */
 	uint8_t *com_buffer;
+	uint32_t com_buffer_fill;
+
+	/* Arena erased ahead of time for the file to continue into, or -1 */
+	int32_t erased_arena;
+	bool erase_ahead_failed;
 
 	/* Information for current file handle */
 	bool file_open_writing;
@@ -210,6 +224,13 @@ static int32_t streamfs_new_sector(struct streamfs_state *streamfs)
 	streamfs->active_file_arena = (streamfs->active_file_arena + 1) % streamfs->partition_arenas;
 	streamfs->active_file_arena_offset = 0;
 	streamfs->active_file_segment++;
+	streamfs->erase_ahead_failed = false;
+
+	// Nothing to do if the background task got to it first
+	if (streamfs->erased_arena == streamfs->active_file_arena) {
+		streamfs->erased_arena = -1;
+		return 0;
+	}
 
 	// Test whether the sector has already been erased by checking the footer
 	start_address = streamfs_get_addr(streamfs, streamfs->active_file_arena,
@@ -469,6 +490,70 @@ static int32_t streamfs_read_from_file(struct streamfs_state *streamfs, uint8_t
 	return total_read_len;
 }
 
+/**
+ * Walk the arenas of the file open for reading, in order
+ * @param[in] offset Where in the file to move the read position to, or NULL
+ * to leave it
+ * @param[out] size Length of the file
+ * @return 0 if success, < 0 on failure or if offset is past the end
+ *
+ * NOTE: Must be called while holding the flash transaction lock
+ */
+static int32_t streamfs_walk_file(struct streamfs_state *streamfs, const uint32_t *offset, uint32_t *size)
+{
+	const uint32_t arena_data = streamfs->cfg->arena_size - sizeof(struct streamfs_footer);
+
+	int32_t arena = streamfs_find_first_arena(streamfs, streamfs->active_file_id);
+	if (arena < 0) {
+		return -1;
+	}
+
+	bool found = (offset == NULL);
+	int32_t last_segment = -1;
+	uint32_t total = 0;
+
+	for (uint32_t i = 0; i < streamfs->partition_arenas; i++) {
+		struct streamfs_footer footer;
+		uint32_t start_address = streamfs_get_addr(streamfs, arena, arena_data);
+		if (PIOS_FLASH_read_data(streamfs->partition_id, start_address, (uint8_t *) &footer, sizeof(footer)) != 0) {
+			return -2;
+		}
+
+		// Segments of a file are in consecutive arenas
+		if (footer.magic != streamfs->cfg->fs_magic || footer.file_id != streamfs->active_file_id ||
+				(last_segment >= 0 && footer.file_segment != last_segment + 1)) {
+			break;
+		}
+		last_segment = footer.file_segment;
+
+		// The end of a full arena is read as the start of the next
+		if (!found && (*offset - total < footer.written_bytes ||
+				(*offset - total == footer.written_bytes && footer.written_bytes < arena_data))) {
+			streamfs->active_file_arena = arena;
+			streamfs->active_file_arena_offset = *offset - total;
+			found = true;
+		}
+
+		total += footer.written_bytes;
+
+		if (footer.written_bytes < arena_data) {
+			break;
+		}
+
+		arena = (arena + 1) % streamfs->partition_arenas;
+	}
+
+	if (!found && *offset == total) {
+		streamfs->active_file_arena = arena;
+		streamfs->active_file_arena_offset = 0;
+		found = true;
+	}
+
+	*size = total;
+
+	return found ? 0 : -3;
+}
+
 /* NOTE: Must be called while holding the flash transaction lock */
 static int32_t streamfs_scan_filesystem(struct streamfs_state *streamfs)
 {
@@ -510,6 +595,100 @@ static int32_t streamfs_scan_filesystem(struct streamfs_state *streamfs)
 	return 0;
 }
 
+/**
+ * How many bytes the write-behind buffer should hold before going to
+ * flash: up to the next write_size boundary, or the footer.
+ */
+static uint32_t streamfs_stage_size(const struct streamfs_state *streamfs)
+{
+	uint32_t offset = streamfs->active_file_arena_offset;
+	uint32_t to_boundary = streamfs->cfg->write_size - (offset % streamfs->cfg->write_size);
+	uint32_t to_footer = streamfs->cfg->arena_size - sizeof(struct streamfs_footer) - offset;
+
+	return MIN(to_boundary, to_footer);
+}
+
+/**
+ * Pull whatever PIOS_COM has queued into the write-behind buffer
+ * @return number of bytes pulled
+ */
+static int32_t streamfs_stage_data(struct streamfs_state *streamfs)
+{
+	if (!streamfs->tx_out_cb)
+		return 0;
+
+	uint32_t stage_size = streamfs->cfg->write_size;
+	if (streamfs->file_open_writing)
+		stage_size = streamfs_stage_size(streamfs);
+
+	if (streamfs->com_buffer_fill >= stage_size)
+		return 0;
+
+	int32_t bytes = (streamfs->tx_out_cb)(
+		streamfs->tx_out_context,
+		streamfs->com_buffer + streamfs->com_buffer_fill,
+		stage_size - streamfs->com_buffer_fill,
+		NULL, NULL);
+
+	if (bytes <= 0)
+		return 0;
+
+	if (!streamfs->file_open_writing) {
+		// Drain out pending data while file not open
+		return bytes;
+	}
+
+	streamfs->com_buffer_fill += bytes;
+
+	return bytes;
+}
+
+/**
+ * Write out the write-behind buffer, whether or not it is full
+ * @return 0 if success, < 0 on failure
+ * @note Must be called while holding the flash transaction lock
+ */
+static int32_t streamfs_flush(struct streamfs_state *streamfs)
+{
+	if (streamfs->com_buffer_fill == 0)
+		return 0;
+
+	int32_t rc = streamfs_append_to_file(streamfs, streamfs->com_buffer,
+			streamfs->com_buffer_fill);
+
+	// Data is dropped on error, rather than retrying forever
+	streamfs->com_buffer_fill = 0;
+
+	return (rc < 0) ? rc : 0;
+}
+
+/**
+ * Erase the arena the open file will move into next, so that crossing
+ * into it doesn't stall on the erase.
+ * @return true if an erase happened
+ * @note Must be called while holding the flash transaction lock
+ */
+static bool streamfs_erase_ahead(struct streamfs_state *streamfs)
+{
+	if (!streamfs->file_open_writing || streamfs->partition_arenas < 2)
+		return false;
+
+	int32_t next_arena = (streamfs->active_file_arena + 1) % streamfs->partition_arenas;
+
+	if (streamfs->erased_arena == next_arena || streamfs->erase_ahead_failed)
+		return false;
+
+	if (streamfs_erase_arena(streamfs, next_arena) != 0) {
+		// Leave it to streamfs_new_sector rather than retrying
+		streamfs->erase_ahead_failed = true;
+		return false;
+	}
+
+	streamfs->erased_arena = next_arena;
+
+	return true;
+}
+
 static void PIOS_STREAMFS_Task(void *parameters)
 {
 	struct streamfs_state *streamfs = parameters;
@@ -518,28 +697,40 @@ static void PIOS_STREAMFS_Task(void *parameters)
 	PIOS_Assert(tmp);
 
 	while (1) {
-		int32_t bytes_to_write = 0;
-
-		if (streamfs->tx_out_cb) {
-			bytes_to_write = (streamfs->tx_out_cb)(
-				streamfs->tx_out_context,
-				streamfs->com_buffer,
-				streamfs->cfg->write_size,
-				NULL, NULL);
-		}
+		bool got_data = streamfs_stage_data(streamfs) > 0;
 
-		if (bytes_to_write <= 0) {
-			// Block here until woken.
-			PIOS_Mutex_Unlock(streamfs->mutex);
-			PIOS_Semaphore_Take(streamfs->sem, PIOS_SEMAPHORE_TIMEOUT_MAX);
-			tmp = PIOS_Mutex_Lock(streamfs->mutex, PIOS_MUTEX_TIMEOUT_MAX);
-			PIOS_Assert(tmp);
+		bool page_full = streamfs->file_open_writing &&
+			(streamfs->com_buffer_fill >= streamfs_stage_size(streamfs));
+
+		if (got_data && !page_full) {
+			// Keep topping up the page
 			continue;
 		}
 
-		if (!streamfs->file_open_writing) {
-			// Drain out pending data while file not open
-			continue;
+		bool timed_out = false;
+
+		if (!page_full) {
+			// Erase ahead while there's nothing to write.  Otherwise block
+			// here until woken, or until a partly filled page is due to
+			// be written out.
+			bool erase_due = streamfs->file_open_writing &&
+				streamfs->partition_arenas > 1 &&
+				!streamfs->erase_ahead_failed &&
+				streamfs->erased_arena != (streamfs->active_file_arena + 1) % streamfs->partition_arenas;
+
+			if (!erase_due) {
+				uint32_t timeout = streamfs->com_buffer_fill ?
+					PIOS_STREAMFS_FLUSH_MS : PIOS_SEMAPHORE_TIMEOUT_MAX;
+
+				PIOS_Mutex_Unlock(streamfs->mutex);
+				timed_out = !PIOS_Semaphore_Take(streamfs->sem, timeout);
+				tmp = PIOS_Mutex_Lock(streamfs->mutex, PIOS_MUTEX_TIMEOUT_MAX);
+				PIOS_Assert(tmp);
+
+				if (!timed_out || !streamfs->com_buffer_fill) {
+					continue;
+				}
+			}
 		}
 
 		if (PIOS_FLASH_start_transaction(streamfs->partition_id) != 0) {
@@ -550,18 +741,10 @@ static void PIOS_STREAMFS_Task(void *parameters)
 			continue;
 		}
 
-		// Flush available data from PIOS_COM interface to
-		// file system
-		while (bytes_to_write > 0) {
-			if (streamfs_append_to_file(streamfs, streamfs->com_buffer, bytes_to_write) != 0) {
-				break;
-			}
-
-			bytes_to_write = (streamfs->tx_out_cb)(
-					streamfs->tx_out_context,
-					streamfs->com_buffer,
-					streamfs->cfg->write_size,
-					NULL, NULL);
+		if (page_full || timed_out) {
+			streamfs_flush(streamfs);
+		} else {
+			streamfs_erase_ahead(streamfs);
 		}
 
 		PIOS_FLASH_end_transaction(streamfs->partition_id);
@@ -600,6 +783,9 @@ int32_t PIOS_STREAMFS_Init(uintptr_t *fs_id, const struct streamfs_cfg *cfg, enu
 	/* sector_size must exceed write_size */
 	PIOS_Assert(cfg->arena_size > cfg->write_size);
 
+	/* write_size must divide the sector size, so that writes stay page aligned */
+	PIOS_Assert((cfg->arena_size % cfg->write_size) == 0);
+
 	int8_t rc;
 
 	struct streamfs_state *streamfs;
@@ -627,6 +813,11 @@ int32_t PIOS_STREAMFS_Init(uintptr_t *fs_id, const struct streamfs_cfg *cfg, enu
 	streamfs->active_file_id           = 0;
 	streamfs->active_file_arena        = 0;
 	streamfs->active_file_arena_offset = 0;
+	streamfs->com_buffer_fill          = 0;
+	streamfs->erased_arena             = -1;
+	streamfs->erase_ahead_failed       = false;
+	streamfs->tx_out_cb                = NULL;
+	streamfs->tx_out_context           = 0;
 
 	streamfs->mutex = PIOS_Mutex_Create();
 
@@ -700,6 +891,8 @@ int32_t PIOS_STREAMFS_Format(uintptr_t fs_id)
 		goto out_end_trans;
 	}
 
+	streamfs->erased_arena = -1;
+
 	/* Chip erased and log remounted successfully */
 	rc = 0;
 
@@ -762,6 +955,9 @@ int32_t PIOS_STREAMFS_OpenWrite(uintptr_t fs_id)
 	streamfs->active_file_segment = 0;
 	streamfs->active_file_arena = streamfs_find_new_sector(streamfs);
 	streamfs->active_file_arena_offset = 0;
+	streamfs->com_buffer_fill = 0;
+	streamfs->erased_arena = -1;
+	streamfs->erase_ahead_failed = false;
 	streamfs->file_open_writing = true;
 
 	// Erase this sector to prepare for streaming
@@ -905,6 +1101,19 @@ int32_t PIOS_STREAMFS_Close(uintptr_t fs_id)
 		goto out_exit;
 	}
 
+	// Write out whatever is still queued up
+	while (true) {
+		if (streamfs->com_buffer_fill >= streamfs_stage_size(streamfs) &&
+				streamfs_flush(streamfs) != 0) {
+			break;
+		}
+		if (streamfs_stage_data(streamfs) <= 0) {
+			break;
+		}
+	}
+
+	streamfs_flush(streamfs);
+
 	if (streamfs->active_file_arena_offset != 0) {
 		// Close segment when something has been written. This avoids creating
 		// null files with an open/close operation
@@ -914,9 +1123,8 @@ int32_t PIOS_STREAMFS_Close(uintptr_t fs_id)
 		}
 	}
 
-
-	// TODO: make sure to flush remaining data
 	streamfs->file_open_writing = false;
+	streamfs->erased_arena = -1;
 
 	if (streamfs_scan_filesystem(streamfs) != 0) {
 		rc = -4;
@@ -971,6 +1179,73 @@ int32_t PIOS_STREAMFS_Read(uintptr_t fs_id, uint8_t *data, uint32_t len) {
 	return rc;
 }
 
+/**
+ * Move the read position of the file open for reading
+ * @param[in] offset Bytes from the start of the file
+ * @return 0 if success, < 0 on failure or if offset is past the end
+ */
+int32_t PIOS_STREAMFS_Seek(uintptr_t fs_id, uint32_t offset)
+{
+	int32_t rc;
+
+	struct streamfs_state *streamfs = (struct streamfs_state *)
+		PIOS_COM_GetDriverCtx(fs_id);
+
+	bool valid = streamfs_validate(streamfs);
+	PIOS_Assert(valid);
+
+	if (!streamfs->file_open_reading)
+		return -4;
+
+	if (PIOS_FLASH_start_transaction(streamfs->partition_id) != 0) {
+		return -2;
+	}
+
+	uint32_t size;
+	rc = streamfs_walk_file(streamfs, &offset, &size);
+	if (rc < 0) {
+		rc = -5;
+	}
+
+	PIOS_FLASH_end_transaction(streamfs->partition_id);
+
+	return rc;
+}
+
+/**
+ * Get the length of the file open for reading
+ * @return the length in bytes, or < 0 on failure
+ */
+int32_t PIOS_STREAMFS_FileSize(uintptr_t fs_id)
+{
+	int32_t rc;
+
+	struct streamfs_state *streamfs = (struct streamfs_state *)
+		PIOS_COM_GetDriverCtx(fs_id);
+
+	bool valid = streamfs_validate(streamfs);
+	PIOS_Assert(valid);
+
+	if (!streamfs->file_open_reading)
+		return -4;
+
+	if (PIOS_FLASH_start_transaction(streamfs->partition_id) != 0) {
+		return -2;
+	}
+
+	uint32_t size;
+	rc = streamfs_walk_file(streamfs, NULL, &size);
+	if (rc < 0) {
+		rc = -5;
+	} else {
+		rc = size;
+	}
+
+	PIOS_FLASH_end_transaction(streamfs->partition_id);
+
+	return rc;
+}
+
 // Testing methods for unit tests
 int32_t PIOS_STREAMFS_Testing_Write(uintptr_t fs_id, uint8_t *data, uint32_t len)
 {
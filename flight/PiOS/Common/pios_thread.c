@@ -296,6 +296,43 @@ uint32_t PIOS_Thread_Get_Stack_Usage(struct pios_thread *threadp)
 	return result;
 }
 
+/**
+ *
+ * @brief   Returns the time the idle thread has run, and starts counting again.
+ *
+ * @note    Interrupts taken while idle are counted as idle time.
+ *
+ * @return runtime in cycles of the delay counter
+ *
+ */
+uint32_t PIOS_Thread_Get_Idle_Runtime(void)
+{
+	chSysLock();
+
+	Thread *idlep = chSysGetIdleThread();
+	uint32_t result = idlep->ticks_total;
+	idlep->ticks_total = 0;
+
+	chSysUnlock();
+
+	return result;
+}
+
+/**
+ *
+ * @brief   Checks whether a thread is the one behind a native RTOS handle.
+ *
+ * @param[in] threadp      pointer to instance of @p struct pios_thread
+ * @param[in] native       native thread handle, as recorded by other PiOS code
+ *
+ * @return true if they are the same thread
+ *
+ */
+bool PIOS_Thread_Is_Native(struct pios_thread *threadp, uintptr_t native)
+{
+	return (uintptr_t) threadp->threadp == native;
+}
+
 /**
  *
  * @brief   Suspends execution of all threads.
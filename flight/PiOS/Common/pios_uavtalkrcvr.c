@@ -44,10 +44,12 @@ static UAVTalkReceiverData uavreceiverdata;
 
 /* Provide a RCVR driver */
 static int32_t PIOS_UAVTALKRCVR_Get(uintptr_t rcvr_id, uint8_t channel);
+static int32_t PIOS_UAVTALKRCVR_ReadAll(uintptr_t rcvr_id, int32_t *channels, uint8_t num_channels);
 static void PIOS_uavtalkrcvr_Supervisor(uintptr_t rcvr_id);
 
 const struct pios_rcvr_driver pios_uavtalk_rcvr_driver = {
 	.read = PIOS_UAVTALKRCVR_Get,
+	.read_all = PIOS_UAVTALKRCVR_ReadAll,
 };
 
 /* Local Variables */
@@ -60,6 +62,10 @@ struct pios_uavtalkrcvr_dev {
 
 	uint16_t supv_timer;
 	volatile bool Fresh;
+
+	/* Sender's stamp on the newest frame taken, when it stamps them */
+	uint16_t last_stamp;
+	volatile bool have_stamp;
 };
 
 static struct pios_uavtalkrcvr_dev *global_uavtalkrcvr_dev;
@@ -79,6 +85,7 @@ static struct pios_uavtalkrcvr_dev *PIOS_uavtalkrcvr_alloc(void)
 	uavtalkrcvr_dev->magic = PIOS_UAVTALKRCVR_DEV_MAGIC;
 	uavtalkrcvr_dev->Fresh = false;
 	uavtalkrcvr_dev->supv_timer = 0;
+	uavtalkrcvr_dev->have_stamp = false;
 
 	/* The update callback cannot receive the device pointer, so set it in a global */
 	global_uavtalkrcvr_dev = uavtalkrcvr_dev;
@@ -91,8 +98,25 @@ static void uavreceiver_updated(const UAVObjEvent *ev,
 {
 	struct pios_uavtalkrcvr_dev *uavtalkrcvr_dev = global_uavtalkrcvr_dev;
 	if (ev->obj == UAVTalkReceiverHandle()) {
+		UAVTalkReceiverData frame;
+
+		UAVTalkReceiverGet(&frame);
+
+		/* Frames aren't acked, so one can be repeated or overtaken by
+		 * the next on another link; never step the sticks back. */
+		if (frame.Timestamp) {
+			if (uavtalkrcvr_dev->have_stamp &&
+					(int16_t)(frame.Timestamp -
+					uavtalkrcvr_dev->last_stamp) <= 0) {
+				return;
+			}
+
+			uavtalkrcvr_dev->last_stamp = frame.Timestamp;
+			uavtalkrcvr_dev->have_stamp = true;
+		}
+
 		PIOS_RCVR_Active();
-		UAVTalkReceiverGet(&uavreceiverdata);
+		uavreceiverdata = frame;
 
 		uavtalkrcvr_dev->Fresh = true;
 	}
@@ -140,6 +164,21 @@ static int32_t PIOS_UAVTALKRCVR_Get(uintptr_t rcvr_id, uint8_t channel)
 	return (uavreceiverdata.Channel[channel]);
 }
 
+/**
+ * Get all the channels at once
+ * \output the number of channels filled in
+ */
+static int32_t PIOS_UAVTALKRCVR_ReadAll(uintptr_t rcvr_id, int32_t *channels, uint8_t num_channels)
+{
+	if (num_channels > UAVTALKRECEIVER_CHANNEL_NUMELEM)
+		num_channels = UAVTALKRECEIVER_CHANNEL_NUMELEM;
+
+	for (int i = 0; i < num_channels; i++)
+		channels[i] = uavreceiverdata.Channel[i];
+
+	return num_channels;
+}
+
 static void PIOS_uavtalkrcvr_Supervisor(uintptr_t uavtalkrcvr_id) {
 	/* Recover our device context */
 	struct pios_uavtalkrcvr_dev * uavtalkrcvr_dev = (struct pios_uavtalkrcvr_dev *)uavtalkrcvr_id;
@@ -159,6 +198,9 @@ static void PIOS_uavtalkrcvr_Supervisor(uintptr_t uavtalkrcvr_id) {
 	if (!uavtalkrcvr_dev->Fresh) {
 		for (int32_t i = 0; i < UAVTALKRECEIVER_CHANNEL_NUMELEM; i++)
 			uavreceiverdata.Channel[i] = PIOS_RCVR_TIMEOUT;
+
+		/* The sender may have restarted its clock */
+		uavtalkrcvr_dev->have_stamp = false;
 	}
 
 	uavtalkrcvr_dev->Fresh = false;
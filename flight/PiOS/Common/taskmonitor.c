@@ -27,6 +27,12 @@
 #include "openpilot.h"
 #include "taskmonitor.h"
 #include "pios_mutex.h"
+#if defined(DIAG_IRQS)
+#include "irqinfo.h"
+#endif
+#if defined(DIAG_MUTEXES)
+#include "mutexstats.h"
+#endif
 
 // Private constants
 
@@ -43,6 +49,12 @@ DONT_BUILD_IF(TASKINFO_RUNNING_NUMELEM != TASKINFO_RUNNINGTIME_NUMELEM,
 		taskelems2);
 
 // Private functions
+#if defined(DIAG_IRQS)
+static void update_irq_info(uint32_t deltaTime);
+#endif
+#if defined(DIAG_MUTEXES)
+static void update_mutex_stats(void);
+#endif
 
 /**
  * Initialize library
@@ -157,11 +169,120 @@ void TaskMonitorUpdateAll(void)
 	// Update object
 	TaskInfoSet(&data);
 
+#if defined(DIAG_IRQS)
+	update_irq_info(deltaTime);
+#endif
+#if defined(DIAG_MUTEXES)
+	update_mutex_stats();
+#endif
+
 	// Done
 	PIOS_Mutex_Unlock(lock);
 #endif
 }
 
+#if defined(DIAG_IRQS)
+/**
+ * Publish the busiest interrupt handlers since the last update
+ * \param[in] deltaTime elapsed cycles, divided by 100
+ */
+static void update_irq_info(uint32_t deltaTime)
+{
+	IRQInfoData data;
+
+	memset(&data, 0, sizeof(data));
+
+	uint32_t top_cycles[IRQINFO_VECTOR_NUMELEM] = { 0 };
+	uint32_t total = 0;
+
+	for (uint32_t vector = 1; vector < PIOS_IRQ_NUM_VECTORS; vector++) {
+		uint32_t cycles = PIOS_IRQ_Get_Runtime(vector);
+
+		total += cycles;
+
+		/* Insert into the descending top list */
+		int slot = IRQINFO_VECTOR_NUMELEM;
+
+		while (slot > 0 && cycles > top_cycles[slot - 1]) {
+			slot--;
+		}
+
+		if (slot >= IRQINFO_VECTOR_NUMELEM) {
+			continue;
+		}
+
+		for (int i = IRQINFO_VECTOR_NUMELEM - 1; i > slot; i--) {
+			top_cycles[i] = top_cycles[i - 1];
+			data.Vector[i] = data.Vector[i - 1];
+		}
+
+		top_cycles[slot] = cycles;
+		data.Vector[slot] = vector;
+	}
+
+	for (int i = 0; i < IRQINFO_VECTOR_NUMELEM; i++) {
+		data.RunningTime[i] = (float) top_cycles[i] / deltaTime;
+	}
+
+	data.TotalRunningTime = (float) total / deltaTime;
+
+	IRQInfoSet(&data);
+}
+#endif /* DIAG_IRQS */
+
+#if defined(DIAG_MUTEXES)
+/**
+ * Publish the most contended mutexes.  Called with the task lock held.
+ */
+static void update_mutex_stats(void)
+{
+	MutexStatsData data;
+
+	memset(&data, 0, sizeof(data));
+	memset(data.Owner, 0xff, sizeof(data.Owner));
+
+	for (const struct pios_mutex_stats *stats = PIOS_Mutex_Stats_First();
+			stats; stats = stats->next) {
+		if (stats->waits == 0)
+			continue;
+
+		/* Insert into the list ordered by total wait, descending */
+		int slot = MUTEXSTATS_CREATOR_NUMELEM;
+
+		while (slot > 0 && (data.Creator[slot - 1] == 0 ||
+				stats->wait_cycles > data.WaitCycles[slot - 1])) {
+			slot--;
+		}
+
+		if (slot >= MUTEXSTATS_CREATOR_NUMELEM)
+			continue;
+
+		for (int i = MUTEXSTATS_CREATOR_NUMELEM - 1; i > slot; i--) {
+			data.Creator[i] = data.Creator[i - 1];
+			data.Waits[i] = data.Waits[i - 1];
+			data.WaitCycles[i] = data.WaitCycles[i - 1];
+			data.MaxWaitCycles[i] = data.MaxWaitCycles[i - 1];
+			data.Owner[i] = data.Owner[i - 1];
+		}
+
+		data.Creator[slot] = stats->creator;
+		data.Waits[slot] = stats->waits;
+		data.WaitCycles[slot] = stats->wait_cycles;
+		data.MaxWaitCycles[slot] = stats->max_wait_cycles;
+		data.Owner[slot] = 0xff;
+
+		for (int n = 0; n < TASKINFO_RUNNING_NUMELEM; n++) {
+			if (handles[n] && PIOS_Thread_Is_Native(handles[n], stats->owner)) {
+				data.Owner[slot] = n;
+				break;
+			}
+		}
+	}
+
+	MutexStatsSet(&data);
+}
+#endif /* DIAG_MUTEXES */
+
 /**
  * @}
  */
@@ -158,8 +158,10 @@ void initTask(void)
 
 	PIOS_HAL_InitUAVTalkReceiver();
 
-	/* board driver init */
+	/* board driver init, sensor probing included */
+	uint32_t board_init_raw = PIOS_DELAY_GetRaw();
 	PIOS_Board_Init();
+	PIOS_Modules_ProfileBoardInit(PIOS_DELAY_DiffuS(board_init_raw));
 
 	/* Initialize modules */
 	MODULE_INITIALISE_ALL(PIOS_WDG_Clear);
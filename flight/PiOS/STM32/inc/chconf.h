@@ -549,10 +549,17 @@ typedef uint32_t halrtcnt_t;
  *          after processing the virtual timers queue.
  */
 #if !defined(SYSTEM_TICK_EVENT_HOOK) || defined(__DOXYGEN__)
+#if defined(DIAG_PROFILE)
+#define SYSTEM_TICK_EVENT_HOOK() {                                          \
+  extern void PIOS_Profiler_Sample(void);                                   \
+  PIOS_Profiler_Sample();                                                   \
+}
+#else
 #define SYSTEM_TICK_EVENT_HOOK() {                                          \
   /* System tick event code here.*/                                         \
 }
 #endif
+#endif
 
 /**
  * @brief   System halt hook.
@@ -575,6 +582,10 @@ typedef uint32_t halrtcnt_t;
    in the project options.*/
 #define CORTEX_USE_FPU                  TRUE
 
+/* Sleep on WFI in the idle thread rather than spinning.  The delay counter
+   keeps running through it, see PIOS_DELAY_Init().*/
+#define CORTEX_ENABLE_WFI_IDLE          TRUE
+
 #endif  /* _CHCONF_H_ */
 
 /** @} */
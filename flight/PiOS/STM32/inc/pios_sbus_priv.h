@@ -33,8 +33,10 @@
 
 #include <pios.h>
 
+#ifndef FLIGHT_POSIX
 #include <pios_stm32.h>
 #include <pios_usart_priv.h>
+#endif
 
 /*
  * S.Bus serial port settings:
@@ -77,11 +79,15 @@
  * S.Bus configuration programmable invertor
  */
 struct pios_sbus_cfg {
+#ifndef FLIGHT_POSIX
 	struct stm32_gpio inv;
 	void (*gpio_clk_func)(uint32_t periph, FunctionalState state);
 	uint32_t gpio_clk_periph;
 	BitAction gpio_inv_enable;
 	BitAction gpio_inv_disable;
+#else
+	char unused;
+#endif
 };
 
 /*
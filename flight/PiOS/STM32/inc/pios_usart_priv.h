@@ -36,12 +36,28 @@
 
 extern const struct pios_com_driver pios_usart_com_driver;
 
+/**
+ * Optional DMA for a USART.  Receive runs continuously into a circular
+ * buffer that is handed upward on idle line, half and full transfer;
+ * transmit pulls chunks from the COM layer and completes on the USART's
+ * own TC interrupt.  The board routes the rx stream/channel IRQ to
+ * PIOS_USART_DMA_Rx_IRQHandler.  Bytes arrive in bursts rather than one
+ * at a time, so it is only used for protocols that ask for it in the
+ * params.
+ */
+struct pios_usart_dma_cfg {
+	struct stm32_dma dma;	/* irq is for the rx stream/channel */
+	uint32_t rx_flags;	/* all event flags of the rx stream/channel */
+	uint32_t tx_flags;	/* all event flags of the tx stream/channel */
+};
+
 struct pios_usart_cfg {
 	USART_TypeDef *regs;
 	uint32_t remap;		/* GPIO_Remap_* */
 	struct stm32_gpio rx;
 	struct stm32_gpio tx;
 	struct stm32_irq irq;
+	const struct pios_usart_dma_cfg *dma;	/* NULL for interrupt per byte */
 };
 
 struct pios_usart_params {
@@ -50,10 +66,12 @@ struct pios_usart_params {
 	bool tx_invert;
 	bool rxtx_swap;
 	bool single_wire;
+	bool dma;		/* use cfg->dma, if the port has one */
 };
 
 extern int32_t PIOS_USART_Init(uintptr_t * usart_id, const struct pios_usart_cfg * cfg, struct pios_usart_params * params);
 extern const struct pios_usart_cfg * PIOS_USART_GetConfig(uintptr_t usart_id);
+extern void PIOS_USART_DMA_Rx_IRQHandler(const struct pios_usart_cfg * cfg);
 
 #endif /* PIOS_USART_PRIV_H */
 
@@ -66,6 +66,11 @@ int32_t PIOS_DELAY_Init(void)
 	/* enable the CPU cycle counter */
 	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
 
+	/* keep the core clock, and so the cycle counter, running in sleep;
+	 * the idle thread waits for interrupts, and the delays and thread
+	 * runtimes are all measured with it */
+	DBGMCU->CR |= DBGMCU_CR_DBG_SLEEP;
+
 	return 0;
 }
 
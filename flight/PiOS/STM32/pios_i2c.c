@@ -36,6 +36,16 @@
 
 #include <pios_i2c_priv.h>
 
+//! Transfers an adapter holds, counting the one on the bus
+#define PIOS_I2C_QUEUE_LEN 4
+
+struct pios_i2c_request {
+	const struct pios_i2c_txn *txn_list;
+	uint32_t num_txns;
+	pios_i2c_callback_t callback;
+	void *ctx;
+};
+
 struct pios_i2c_adapter {
 	enum pios_i2c_adapter_magic         magic;
 	const struct pios_i2c_adapter_cfg * cfg;
@@ -53,6 +63,16 @@ struct pios_i2c_adapter {
 	uint8_t *active_byte;
 	uint8_t *last_byte;
 
+	/* The transfer at queue_head is on the bus; the rest start from the
+	 * interrupt as soon as it stops, without waking their tasks. */
+	struct pios_i2c_request queue[PIOS_I2C_QUEUE_LEN];
+	uint8_t queue_head;
+	volatile uint8_t queue_count;
+	bool transfer_done;
+
+	/* Result handed back to the task blocked in PIOS_I2C_Transfer() */
+	volatile int32_t transfer_result;
+
 #if defined(PIOS_I2C_DIAGNOSTICS)
 	volatile struct pios_i2c_fault_history i2c_adapter_fault_history;
 
@@ -95,6 +115,7 @@ struct pios_i2c_adapter {
 #endif
 
 static void i2c_adapter_inject_event(struct pios_i2c_adapter *i2c_adapter, enum i2c_adapter_event event, bool *woken);
+static void i2c_adapter_complete(struct pios_i2c_adapter *i2c_adapter, int32_t result, bool *woken);
 
 static bool PIOS_I2C_validate(struct pios_i2c_adapter *i2c_adapter)
 {
@@ -230,7 +251,7 @@ int32_t PIOS_I2C_CheckClear(pios_i2c_t i2c_adapter)
 	if (PIOS_Mutex_Lock(i2c_adapter->lock, 0) == false)
 		return -1;
 
-	if (i2c_adapter->state != I2C_STATE_STOPPED) {
+	if (i2c_adapter->state != I2C_STATE_STOPPED || i2c_adapter->queue_count) {
 		PIOS_Mutex_Unlock(i2c_adapter->lock);
 		return -2;
 	}
@@ -252,6 +273,133 @@ static void i2c_adapter_fsm_init(struct pios_i2c_adapter *i2c_adapter)
 	i2c_adapter->state = I2C_STATE_STOPPED;
 }
 
+/**
+ * Puts the transfer at the head of the queue on the bus.  Called with
+ * interrupts disabled or from the I2C interrupts.
+ */
+static void i2c_adapter_start_queued(struct pios_i2c_adapter *i2c_adapter, bool *woken)
+{
+	struct pios_i2c_request *req = &i2c_adapter->queue[i2c_adapter->queue_head];
+
+	i2c_adapter->last_txn = &req->txn_list[req->num_txns - 1];
+	i2c_adapter->active_txn = &req->txn_list[0];
+	i2c_adapter->bus_error = false;
+	i2c_adapter->nack = false;
+
+	i2c_adapter_inject_event(i2c_adapter, I2C_EVENT_START, woken);
+}
+
+/**
+ * Retires the transfer on the bus, starts the next one queued and then
+ * tells the owner of the finished one.  Called with interrupts disabled or
+ * from the I2C interrupts.
+ */
+static void i2c_adapter_complete(struct pios_i2c_adapter *i2c_adapter, int32_t result, bool *woken)
+{
+	if (!i2c_adapter->queue_count)
+		return;
+
+	struct pios_i2c_request req = i2c_adapter->queue[i2c_adapter->queue_head];
+
+	i2c_adapter->queue_head = (i2c_adapter->queue_head + 1) % PIOS_I2C_QUEUE_LEN;
+	i2c_adapter->queue_count--;
+
+	/* Before the callback, so one that queues a transfer doesn't start it
+	 * too */
+	if (i2c_adapter->queue_count)
+		i2c_adapter_start_queued(i2c_adapter, woken);
+
+	if (req.callback)
+		req.callback(req.ctx, result, woken);
+}
+
+static int32_t i2c_adapter_enqueue(struct pios_i2c_adapter *i2c_adapter,
+		const struct pios_i2c_txn txn_list[], uint32_t num_txns,
+		pios_i2c_callback_t callback, void *ctx)
+{
+	bool woken = false;
+
+	PIOS_IRQ_Disable();
+
+	if (i2c_adapter->queue_count >= PIOS_I2C_QUEUE_LEN) {
+		PIOS_IRQ_Enable();
+		return -1;
+	}
+
+	uint8_t idx = (i2c_adapter->queue_head + i2c_adapter->queue_count) % PIOS_I2C_QUEUE_LEN;
+
+	i2c_adapter->queue[idx] = (struct pios_i2c_request) {
+		.txn_list = txn_list,
+		.num_txns = num_txns,
+		.callback = callback,
+		.ctx = ctx,
+	};
+
+	if (i2c_adapter->queue_count++ == 0)
+		i2c_adapter_start_queued(i2c_adapter, &woken);
+
+	PIOS_IRQ_Enable();
+
+	return 0;
+}
+
+/**
+ * Gives up on a transfer that timed out.  It's taken off the queue if it
+ * never started; if it's on the bus, or still waiting behind a transfer
+ * that was there for the whole timeout, the bus is reset.
+ * \return false if the transfer finished after all
+ */
+static bool i2c_adapter_abort(struct pios_i2c_adapter *i2c_adapter,
+		const struct pios_i2c_txn txn_list[])
+{
+	bool woken = false;
+	bool found = false;
+
+	PIOS_IRQ_Disable();
+
+	uint8_t count = i2c_adapter->queue_count;
+
+	for (uint8_t i = 1; i < count; i++) {
+		uint8_t idx = (i2c_adapter->queue_head + i) % PIOS_I2C_QUEUE_LEN;
+
+		if (found) {
+			uint8_t prev = (idx + PIOS_I2C_QUEUE_LEN - 1) % PIOS_I2C_QUEUE_LEN;
+			i2c_adapter->queue[prev] = i2c_adapter->queue[idx];
+		} else if (i2c_adapter->queue[idx].txn_list == txn_list) {
+			found = true;
+		}
+	}
+
+	if (found)
+		i2c_adapter->queue_count--;
+
+	if (found || (count && i2c_adapter->queue[i2c_adapter->queue_head].txn_list == txn_list)) {
+		found = true;
+
+		i2c_adapter_fsm_init(i2c_adapter);
+		i2c_adapter->transfer_done = false;
+		i2c_adapter_complete(i2c_adapter, -2, &woken);
+	}
+
+	PIOS_IRQ_Enable();
+
+	return found;
+}
+
+static void i2c_adapter_transfer_done(void *ctx, int32_t result, bool *woken)
+{
+	struct pios_i2c_adapter *i2c_adapter = ctx;
+
+	i2c_adapter->transfer_result = result;
+
+	/* wake up blocked PIOS_I2C_Transfer() */
+	if (PIOS_Semaphore_Give_FromISR(i2c_adapter->sem_ready, woken) == false) {
+#if defined(I2C_HALT_ON_ERRORS)
+		PIOS_DEBUG_Assert(0);
+#endif
+	}
+}
+
 /**
 * Initializes IIC driver
 * \param[in] mode currently only mode 0 supported
@@ -301,35 +449,54 @@ int32_t PIOS_I2C_Transfer(pios_i2c_t i2c_adapter, const struct pios_i2c_txn txn_
 	if (PIOS_Mutex_Lock(i2c_adapter->lock, i2c_adapter->cfg->transfer_timeout_ms) == false)
 		return -2;
 
-	PIOS_DEBUG_Assert(i2c_adapter->state == I2C_STATE_STOPPED);
-
-	i2c_adapter->last_txn = &txn_list[num_txns - 1];
-	i2c_adapter->active_txn = &txn_list[0];
-	i2c_adapter->bus_error = false;
-	i2c_adapter->nack = false;
-
 	/* Make sure the done/ready semaphore is consumed before we start */
 	PIOS_Semaphore_Take(i2c_adapter->sem_ready, 0);
 
-	bool dummy = false;
-	i2c_adapter_inject_event(i2c_adapter, I2C_EVENT_START, &dummy);
+	if (i2c_adapter_enqueue(i2c_adapter, txn_list, num_txns,
+				i2c_adapter_transfer_done, i2c_adapter) != 0) {
+		PIOS_Mutex_Unlock(i2c_adapter->lock);
+		return -2;
+	}
 
 	/* Wait for the transfer to complete */
 	bool semaphore_success = (PIOS_Semaphore_Take(i2c_adapter->sem_ready, i2c_adapter->cfg->transfer_timeout_ms) == true);
 
-	if (!semaphore_success)
+	if (!semaphore_success) {
 		I2C_DIAG_INCR(i2c_adapter, i2c_timeout_counter);
 
-	int32_t result = !semaphore_success ? -2 :
-			i2c_adapter->bus_error ? -1 :
-			i2c_adapter->nack ? -3 :
-			0;
+		/* It may have just made it */
+		semaphore_success = !i2c_adapter_abort(i2c_adapter, txn_list);
+	}
+
+	int32_t result = semaphore_success ? i2c_adapter->transfer_result : -2;
 
 	PIOS_Mutex_Unlock(i2c_adapter->lock);
 
 	return result;
 }
 
+/**
+ * Queues a transfer and returns without waiting for it.  It starts as soon
+ * as the transfers ahead of it on the bus finish, straight from the
+ * interrupt, so a batch of reads from the devices on a bus goes out back
+ * to back.  Safe to call from an ISR, including from a callback.
+ * \param[in] txn_list transactions, which with their buffers must stay
+ * valid until the callback
+ * \param[in] callback called from the I2C interrupt with the result
+ * \return 0 if queued, -1 if the queue is full
+ */
+int32_t PIOS_I2C_Transfer_Callback(pios_i2c_t i2c_adapter, const struct pios_i2c_txn txn_list[],
+		uint32_t num_txns, pios_i2c_callback_t callback, void *ctx)
+{
+	bool valid = PIOS_I2C_validate(i2c_adapter);
+	PIOS_Assert(valid);
+
+	PIOS_DEBUG_Assert(txn_list);
+	PIOS_DEBUG_Assert(num_txns);
+
+	return i2c_adapter_enqueue(i2c_adapter, txn_list, num_txns, callback, ctx);
+}
+
 #if defined(PIOS_I2C_DIAGNOSTICS)
 /**
  * Logs the last N state transitions and N IRQ events due to
@@ -723,6 +890,16 @@ static void i2c_adapter_inject_event(struct pios_i2c_adapter *i2c_adapter, enum
 
 	/* Process any AUTO transitions in the FSM */
 	i2c_adapter_process_auto(i2c_adapter, woken);
+
+	if (i2c_adapter->transfer_done) {
+		i2c_adapter->transfer_done = false;
+
+		int32_t result = i2c_adapter->bus_error ? -1 :
+				i2c_adapter->nack ? -3 :
+				0;
+
+		i2c_adapter_complete(i2c_adapter, result, woken);
+	}
 }
 
 static void go_fsm_fault(struct pios_i2c_adapter *i2c_adapter, bool *woken)
@@ -767,12 +944,8 @@ static void go_stopped(struct pios_i2c_adapter *i2c_adapter, bool *woken)
 {
 	set_i2c_irqs(i2c_adapter, DISABLE);
 
-	/* wake up blocked PIOS_I2C_Transfer() */
-	if (PIOS_Semaphore_Give_FromISR(i2c_adapter->sem_ready, woken) == false) {
-#if defined(I2C_HALT_ON_ERRORS)
-		PIOS_DEBUG_Assert(0);
-#endif
-	}
+	/* Retired once the FSM has settled, in i2c_adapter_inject_event() */
+	i2c_adapter->transfer_done = true;
 }
 
 static void setup_txn_ptrs(struct pios_i2c_adapter *i2c_adapter)
@@ -93,6 +93,109 @@ bool PIOS_IRQ_InISR(void)
 	return (__get_IPSR() & 0xff) != 0;
 }
 
+#if defined(PIOS_INCLUDE_CHIBIOS) && defined(DIAG_IRQS)
+
+/* Handlers can only nest as deep as there are priority levels */
+#define IRQ_MAX_NESTING 16
+
+static uint32_t irq_cycles[PIOS_IRQ_NUM_VECTORS];
+static uint8_t irq_stack[IRQ_MAX_NESTING];
+static uint8_t irq_depth;
+static uint32_t irq_segment_start;
+static uint32_t irq_outer_start;
+
+/**
+ * Charge the running handler for the cycles since its segment began
+ * \param[in] now current cycle count
+ */
+static inline void irq_charge(uint32_t now)
+{
+	if (irq_depth > 0 && irq_depth <= IRQ_MAX_NESTING) {
+		irq_cycles[irq_stack[irq_depth - 1]] += now - irq_segment_start;
+	}
+
+	irq_segment_start = now;
+}
+
+/**
+ * Start accounting a handler; called from PIOS_IRQ_Prologue.
+ *
+ * Time is exclusive: when a handler is preempted by a higher priority one,
+ * the cycles until it resumes are charged to the preempting handler.
+ */
+void PIOS_IRQ_Account_Enter(void)
+{
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	uint32_t now = hal_lld_get_counter_value();
+	uint32_t vector = __get_IPSR() & 0x1ff;
+
+	if (irq_depth == 0) {
+		irq_outer_start = now;
+	}
+
+	irq_charge(now);
+
+	if (irq_depth < IRQ_MAX_NESTING) {
+		irq_stack[irq_depth] = (vector < PIOS_IRQ_NUM_VECTORS) ? vector : 0;
+	}
+
+	irq_depth++;
+
+	__set_PRIMASK(primask);
+}
+
+/**
+ * Stop accounting a handler; called from PIOS_IRQ_Epilogue.
+ *
+ * When returning to thread mode the handler time is removed from the
+ * interrupted thread, so task run times no longer include ISR load.
+ */
+void PIOS_IRQ_Account_Exit(void)
+{
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	uint32_t now = hal_lld_get_counter_value();
+
+	irq_charge(now);
+
+	if (irq_depth > 0) {
+		irq_depth--;
+	}
+
+	if (irq_depth == 0 && (SCB->ICSR & SCB_ICSR_RETTOBASE_Msk)) {
+		currp->ticks_switched_in += now - irq_outer_start;
+	}
+
+	__set_PRIMASK(primask);
+}
+
+/**
+ * Get the cycles spent in a handler since the last call.
+ * \param[in] vector exception number (IRQn + 16)
+ * \return cycles spent in the handler
+ */
+uint32_t PIOS_IRQ_Get_Runtime(uint32_t vector)
+{
+	if (vector >= PIOS_IRQ_NUM_VECTORS) {
+		return 0;
+	}
+
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	uint32_t result = irq_cycles[vector];
+	irq_cycles[vector] = 0;
+
+	__set_PRIMASK(primask);
+
+	return result;
+}
+
+#endif /* PIOS_INCLUDE_CHIBIOS && DIAG_IRQS */
+
 /**
   * @}
   * @}
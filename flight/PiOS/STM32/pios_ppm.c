@@ -36,9 +36,11 @@
 
 /* Provide a RCVR driver */
 static int32_t PIOS_PPM_Get(uintptr_t rcvr_id, uint8_t channel);
+static int32_t PIOS_PPM_ReadAll(uintptr_t rcvr_id, int32_t *channels, uint8_t num_channels);
 
 const struct pios_rcvr_driver pios_ppm_rcvr_driver = {
 	.read = PIOS_PPM_Get,
+	.read_all = PIOS_PPM_ReadAll,
 };
 
 #define PIOS_PPM_IN_MIN_NUM_CHANNELS		4
@@ -204,6 +206,27 @@ static int32_t PIOS_PPM_Get(uintptr_t rcvr_id, uint8_t channel)
 	return ppm_dev->CaptureValue[channel];
 }
 
+/**
+ * Get all the channels at once
+ * \output PIOS_RCVR_INVALID on an invalid device
+ * \output the number of channels filled in
+ */
+static int32_t PIOS_PPM_ReadAll(uintptr_t rcvr_id, int32_t *channels, uint8_t num_channels)
+{
+	struct pios_ppm_dev * ppm_dev = (struct pios_ppm_dev *)rcvr_id;
+
+	if (!PIOS_PPM_validate(ppm_dev))
+		return PIOS_RCVR_INVALID;
+
+	if (num_channels > PIOS_PPM_IN_MAX_NUM_CHANNELS)
+		num_channels = PIOS_PPM_IN_MAX_NUM_CHANNELS;
+
+	for (int i = 0; i < num_channels; i++)
+		channels[i] = ppm_dev->CaptureValue[i];
+
+	return num_channels;
+}
+
 static void PIOS_PPM_tim_overflow_cb (uintptr_t tim_id, uintptr_t context, uint8_t channel, uint16_t count)
 {
 	struct pios_ppm_dev * ppm_dev = (struct pios_ppm_dev *)context;
@@ -0,0 +1,116 @@
+/**
+ ******************************************************************************
+ * @addtogroup PIOS PIOS Core hardware abstraction layer
+ * @{
+ * @addtogroup PIOS_PROFILER Sampling profiler
+ * @brief Records the interrupted program counter on every system tick
+ * @{
+ *
+ * @file       pios_profiler.c
+ * @author     dRonin, http://dronin.org, Copyright (C) 2017
+ * @brief      Sampling PC profiler driven by the system tick
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+/* Project Includes */
+#include "pios.h"
+
+#if defined(PIOS_INCLUDE_CHIBIOS) && defined(DIAG_PROFILE)
+
+#include "pios_profiler.h"
+
+DONT_BUILD_IF((PIOS_PROFILER_NUM_SAMPLES & (PIOS_PROFILER_NUM_SAMPLES - 1)) != 0,
+		ProfilerSamplesPowerOfTwo);
+
+/* Offset of the stacked PC in the hardware exception frame */
+#define FRAME_PC_WORD 6
+
+static uint32_t samples[PIOS_PROFILER_NUM_SAMPLES];
+static uint32_t sample_head;
+
+/**
+ * Record where the system tick interrupted.  Called from the tick hook.
+ *
+ * Threads run on the process stack, so when the tick is the only active
+ * exception the interrupted PC is at a fixed offset in the frame on PSP.
+ * Ticks that land inside another handler are recorded as a marker, since
+ * that frame is buried on the main stack under our own.
+ */
+void PIOS_Profiler_Sample(void)
+{
+	uint32_t pc = PIOS_PROFILER_SAMPLE_IN_ISR;
+
+	if (SCB->ICSR & SCB_ICSR_RETTOBASE_Msk) {
+		const uint32_t *frame = (const uint32_t *) __get_PSP();
+
+		pc = frame[FRAME_PC_WORD];
+	}
+
+	samples[sample_head & (PIOS_PROFILER_NUM_SAMPLES - 1)] = pc;
+	sample_head++;
+}
+
+/**
+ * Copy out part of the sample ring, oldest sample first.
+ *
+ * The ring keeps filling while it is read, so a transfer is a sliding
+ * window rather than a snapshot; that is fine for a statistical profile.
+ *
+ * \param[out] buf destination
+ * \param[in] offset byte offset into the ring
+ * \param[in] len maximum number of bytes to copy
+ * \return number of bytes copied, 0 at the end of the ring
+ */
+int32_t PIOS_Profiler_Read(uint8_t *buf, uint32_t offset, uint32_t len)
+{
+	uint32_t head = sample_head;
+	uint32_t count = head;
+
+	if (count > PIOS_PROFILER_NUM_SAMPLES) {
+		count = PIOS_PROFILER_NUM_SAMPLES;
+	}
+
+	uint32_t size = count * sizeof(samples[0]);
+
+	if (offset >= size) {
+		return 0;
+	}
+
+	if (len > size - offset) {
+		len = size - offset;
+	}
+
+	uint32_t first = head - count;
+
+	for (uint32_t i = 0; i < len; i++) {
+		uint32_t byte = offset + i;
+		uint32_t idx = (first + byte / sizeof(samples[0])) &
+			(PIOS_PROFILER_NUM_SAMPLES - 1);
+
+		buf[i] = samples[idx] >> ((byte % sizeof(samples[0])) * 8);
+	}
+
+	return len;
+}
+
+#endif /* PIOS_INCLUDE_CHIBIOS && DIAG_PROFILE */
+
+/**
+ * @}
+ * @}
+ */
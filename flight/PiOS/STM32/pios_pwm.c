@@ -36,9 +36,11 @@
 
 /* Provide a RCVR driver */
 static int32_t PIOS_PWM_Get(uintptr_t rcvr_id, uint8_t channel);
+static int32_t PIOS_PWM_ReadAll(uintptr_t rcvr_id, int32_t *channels, uint8_t num_channels);
 
 const struct pios_rcvr_driver pios_pwm_rcvr_driver = {
 	.read = PIOS_PWM_Get,
+	.read_all = PIOS_PWM_ReadAll,
 };
 
 /* Local Variables */
@@ -176,6 +178,27 @@ static int32_t PIOS_PWM_Get(uintptr_t rcvr_id, uint8_t channel)
 	return pwm_dev->CaptureValue[channel];
 }
 
+/**
+ * Get all the channels at once
+ * \output PIOS_RCVR_INVALID on an invalid device
+ * \output the number of channels filled in
+ */
+static int32_t PIOS_PWM_ReadAll(uintptr_t rcvr_id, int32_t *channels, uint8_t num_channels)
+{
+	struct pios_pwm_dev * pwm_dev = (struct pios_pwm_dev *)rcvr_id;
+
+	if (!PIOS_PWM_validate(pwm_dev))
+		return PIOS_RCVR_INVALID;
+
+	if (num_channels > PIOS_PWM_NUM_INPUTS)
+		num_channels = PIOS_PWM_NUM_INPUTS;
+
+	for (int i = 0; i < num_channels; i++)
+		channels[i] = pwm_dev->CaptureValue[i];
+
+	return num_channels;
+}
+
 static void PIOS_PWM_tim_overflow_cb (uintptr_t tim_id, uintptr_t context, uint8_t channel, uint16_t count)
 {
 	struct pios_pwm_dev * pwm_dev = (struct pios_pwm_dev *)context;
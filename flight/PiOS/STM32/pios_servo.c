@@ -86,11 +86,29 @@ struct output_channel {
 	enum channel_mode mode;
 
 	union {
-		uint32_t pwm_res;
+		struct {
+			uint32_t res;
+			int16_t offset;		// ticks added after scaling
+		} pwm;
 		struct dshot_info dshot;
 	} i;
 } __attribute__((packed));
 
+/* Analog ESC protocols, as one-pulse outputs.  Channels are set in the usual
+ * 1000-2000us servo terms, and sent scaled to the protocol's range.
+ */
+struct analog_shot {
+	uint16_t rate;
+	uint32_t base_ns;	// pulse sent for 1000us
+	uint32_t span_ns;	// and how much longer it gets at 2000us
+};
+
+static const struct analog_shot analog_shots[] = {
+	{ SHOT_ONESHOT125, 125000, 125000 },
+	{ SHOT_ONESHOT42, 41667, 41667 },
+	{ SHOT_MULTISHOT, 5000, 20000 },
+};
+
 static struct output_channel *output_channels;
 
 static uintptr_t servo_tim_id;
@@ -185,6 +203,33 @@ struct timer_bank {
 	uint16_t period;
 };
 
+static const struct analog_shot *find_analog_shot(uint16_t rate)
+{
+	for (int i = 0; i < NELEMENTS(analog_shots); i++) {
+		if (analog_shots[i].rate == rate) {
+			return &analog_shots[i];
+		}
+	}
+
+	return NULL;
+}
+
+static void ChannelSetup_PWM(int j, uint32_t clk_rate,
+		const struct analog_shot *shot)
+{
+	if (shot) {
+		// Ticks per second of the channel value
+		output_channels[j].i.pwm.res =
+			(uint64_t) clk_rate * shot->span_ns / 1000000;
+		output_channels[j].i.pwm.offset =
+			((int64_t) shot->base_ns - shot->span_ns) *
+			clk_rate / 1000000000;
+	} else {
+		output_channels[j].i.pwm.res = clk_rate;
+		output_channels[j].i.pwm.offset = 0;
+	}
+}
+
 static void ChannelSetup_DShot(int j, uint16_t rate)
 {
 	switch (rate) {
@@ -292,6 +337,8 @@ static int BankSetup_PWM(struct timer_bank *bank, int32_t max_tim_clock,
  * @brief PIOS_Servo_SetMode Sets the PWM output frequency and resolution.
  * An output rate of 0 indicates Synchronous updates (e.g. SyncPWM/OneShot), otherwise
  * normal PWM at the specified output rate. SyncPWM uses hardware one-pulse mode.
+ * SHOT_ONESHOT125, SHOT_ONESHOT42 and SHOT_MULTISHOT are SyncPWM too, with
+ * the bank sized to the protocol and channel values scaled into its range.
  * Timer prescaler and related parameters are calculated based on the channel
  * with highest max pulse length on each timer. A deadtime is provided to
  * ensure SyncPWM pulses cannot merge.
@@ -365,6 +412,15 @@ int PIOS_Servo_SetMode(const uint16_t *out_rate, const int banks, const uint16_t
 
 		uint16_t rate = out_rate[i];
 
+		const struct analog_shot *shot = find_analog_shot(rate);
+
+		if (shot) {
+			// The longest pulse the protocol sends, not the channel value
+			timer_banks[i].max_pulse =
+				(shot->base_ns + shot->span_ns + 999) / 1000;
+			rate = SHOT_ONESHOT;
+		}
+
 		if (servo_cfg->force_1MHz && (rate == SHOT_ONESHOT)) {
 			/* We've been asked for syncPWM but are in a config
 			 * where we can't do it.  This means CC3D + 333Hz.
@@ -488,11 +544,11 @@ int PIOS_Servo_SetMode(const uint16_t *out_rate, const int banks, const uint16_t
 #endif
 					break;
 				case SHOT_ONESHOT:
-					output_channels[j].i.pwm_res = timer_banks[i].clk_rate;
+					ChannelSetup_PWM(j, timer_banks[i].clk_rate, shot);
 					output_channels[j].mode = SYNC_PWM;
 					break;
 				default:
-					output_channels[j].i.pwm_res = timer_banks[i].clk_rate;
+					ChannelSetup_PWM(j, timer_banks[i].clk_rate, shot);
 					if (channel_max[j] >= channel_min[j]) {
 						output_channels[j].mode = REGULAR_PWM;
 					} else {
@@ -582,7 +638,7 @@ void PIOS_Servo_SetFraction(uint8_t servo, uint16_t fraction,
 	val += spread * fraction;
 
 	// Multiply by ticks/second to get: Ticks * 1000000: 36.16
-	val *= output_channels[servo].i.pwm_res;
+	val *= output_channels[servo].i.pwm.res;
 
 	// Ticks: 16.16
 	val /= 1000000;
@@ -591,6 +647,14 @@ void PIOS_Servo_SetFraction(uint8_t servo, uint16_t fraction,
 	val += 32767;
 	val = val >> 16;
 
+	int16_t offset = output_channels[servo].i.pwm.offset;
+
+	if (offset < 0 && val < (uint64_t) -offset) {
+		val = 0;
+	} else {
+		val += offset;
+	}
+
 	if (resetting && (fraction < 0xff00)) {
 		/* If we're resetting and the value isn't driven to the maximum
 		 * value, drive low with no pulses.  If it's at the max value,
@@ -602,6 +666,41 @@ void PIOS_Servo_SetFraction(uint8_t servo, uint16_t fraction,
 	PIOS_Servo_SetRaw(servo, val);
 }
 
+/**
+ * @brief Selects bidirectional DShot for outputs set up by the next
+ * PIOS_Servo_SetMode. Only DMA-driven DShot supports it.
+ * @param enable Whether to use bidirectional DShot
+ */
+void PIOS_Servo_SetDshotBidirectional(bool enable)
+{
+#if defined(PIOS_INCLUDE_DMASHOT)
+	PIOS_DMAShot_SetBidirectional(enable);
+#else
+	(void) enable;
+#endif
+}
+
+/**
+ * @brief Gets the electrical RPM last reported by an ESC
+ * @param servo Servo number (0->num_channels-1)
+ * @param erpm Set to the electrical RPM, zero for a stopped motor
+ * @return true if the channel has valid telemetry
+ */
+bool PIOS_Servo_GetERPM(uint8_t servo, uint32_t *erpm)
+{
+#if defined(PIOS_INCLUDE_DMASHOT)
+	if (servo_cfg && servo < servo_cfg->num_channels &&
+			output_channels[servo].mode == SYNC_DSHOT_DMA) {
+		return PIOS_DMAShot_GetERPM(&servo_cfg->channels[servo], erpm);
+	}
+#else
+	(void) servo;
+	(void) erpm;
+#endif
+
+	return false;
+}
+
 bool PIOS_Servo_IsDshot(uint8_t servo) {
 	switch (output_channels[servo].mode) {
 		case SYNC_DSHOT_300:
@@ -652,8 +751,12 @@ void PIOS_Servo_Set(uint8_t servo, float position)
 
 	/* recalculate the position value based on timer clock rate */
 	/* position is in us. */
-	float us_to_count = output_channels[servo].i.pwm_res / 1000000.0f;
-	position = position * us_to_count;
+	float us_to_count = output_channels[servo].i.pwm.res / 1000000.0f;
+	position = position * us_to_count + output_channels[servo].i.pwm.offset;
+
+	if (position < 0) {
+		position = 0;
+	}
 
 	if (resetting && (output_channels[servo].mode != REGULAR_INVERTED_PWM)) {
 		/* Don't nail inverted channels low during reset, because they
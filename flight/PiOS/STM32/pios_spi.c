@@ -89,6 +89,7 @@ int32_t PIOS_SPI_Init(pios_spi_t *spi_id, const struct pios_spi_cfg *cfg)
 	spi_dev->cfg = cfg;
 
 	spi_dev->busy = PIOS_Semaphore_Create();
+	spi_dev->priority_waiting = 0;
 
 	switch (spi_dev->cfg->init.SPI_NSS) {
 	case SPI_NSS_Soft:
@@ -233,9 +234,36 @@ int32_t PIOS_SPI_ClaimBus(pios_spi_t spi_dev)
 	if (PIOS_Semaphore_Take(spi_dev->busy, PIOS_SEMAPHORE_TIMEOUT_MAX) != true)
 		return -1;
 
+	if (spi_dev->priority_waiting) {
+		/* The semaphore wakes waiters in order, so give it to the
+		 * priority claim queued behind us and wait our turn again */
+		PIOS_Semaphore_Give(spi_dev->busy);
+
+		if (PIOS_Semaphore_Take(spi_dev->busy, PIOS_SEMAPHORE_TIMEOUT_MAX) != true)
+			return -1;
+	}
+
 	return 0;
 }
 
+int32_t PIOS_SPI_ClaimBusPriority(pios_spi_t spi_dev)
+{
+	bool valid = PIOS_SPI_validate(spi_dev);
+	PIOS_Assert(valid);
+
+	PIOS_IRQ_Disable();
+	spi_dev->priority_waiting++;
+	PIOS_IRQ_Enable();
+
+	bool taken = PIOS_Semaphore_Take(spi_dev->busy, PIOS_SEMAPHORE_TIMEOUT_MAX);
+
+	PIOS_IRQ_Disable();
+	spi_dev->priority_waiting--;
+	PIOS_IRQ_Enable();
+
+	return taken ? 0 : -1;
+}
+
 int32_t PIOS_SPI_ReleaseBus(pios_spi_t spi_dev)
 {
 	bool valid = PIOS_SPI_validate(spi_dev);
@@ -4,7 +4,6 @@
 
 struct pios_spislave_dev {
 	const struct pios_spislave_cfg *cfg;
-	bool last_ssel;
 };
 
 static void setup_spi_dma(spislave_t slave_dev, uint32_t tx_len)
@@ -42,19 +41,19 @@ int32_t PIOS_SPISLAVE_PollSS(spislave_t slave_dev)
 	bool pin_status = GPIO_ReadInputDataBit(slave_dev->cfg->ssel.gpio,
 		slave_dev->cfg->ssel.init.GPIO_Pin) == Bit_SET;
 
-	if (slave_dev->last_ssel != pin_status) {
-		slave_dev->last_ssel = pin_status;
+	/* Something was clocked and we're deselected again, so the
+	 * frame is complete.  This doesn't wait to see the edge, as a
+	 * whole frame can come and go while the caller is busy. */
+	if (pin_status) {
+		int resp_len;
 
-		/* This was a rising edge that we spotted. */
-		if (pin_status) {
-			int resp_len;
+		int len = slave_dev->cfg->max_rx_len -
+			DMA_GetCurrDataCounter(slave_dev->cfg->rx_dma.channel);
 
-			/* XXX figure out count, wait as appropriate, meh */
-			slave_dev->cfg->process_message(
-				slave_dev->cfg->ctx, 0, &resp_len);
+		slave_dev->cfg->process_message(
+			slave_dev->cfg->ctx, len, &resp_len);
 
-			setup_spi_dma(slave_dev, resp_len);
-		}
+		setup_spi_dma(slave_dev, resp_len);
 	}
 
 	return 0;
@@ -71,7 +70,6 @@ int32_t PIOS_SPISLAVE_Init(spislave_t *spislave_id,
 	if (!slave_dev) goto out_fail;
 
 	slave_dev->cfg = cfg;
-	slave_dev->last_ssel = true;
 
 #ifndef STM32F10X_MD
 	/* Initialize the GPIO pins */
@@ -60,12 +60,20 @@ struct pios_can_dev {
 	uintptr_t rx_in_context;
 	pios_com_callback tx_out_cb;
 	uintptr_t tx_out_context;
+	pios_can_frame_cb frame_cb;
+	uintptr_t frame_context;
 };
 
 // Local constants
 #define CAN_COM_ID      0x11
 #define MAX_SEND_LEN    8
 
+/* Acceptance filter banks per controller, each holding four standard IDs */
+#define CAN_FILTER_BANKS 14
+#define CAN_IDS_PER_BANK 4
+
+static void can_filter_bank(uint8_t bank, const uint16_t *ids, bool enable);
+
 void USB_HP_CAN1_TX_IRQHandler(void);
 
 static bool PIOS_CAN_validate(struct pios_can_dev *can_dev)
@@ -89,6 +97,12 @@ static struct pios_can_dev *PIOS_CAN_alloc(void)
 //! The local handle for the CAN device
 static struct pios_can_dev *can_dev;
 
+//! First filter bank belonging to this controller
+static uint8_t filter_first_bank(struct pios_can_dev *can_dev)
+{
+	return 0;
+}
+
 /**
  * Initialize the CAN driver and return an opaque id
  * @param[out]   id the CAN interface handle
@@ -130,21 +144,15 @@ int32_t PIOS_CAN_Init(uintptr_t *can_id, const struct pios_can_cfg *cfg)
 	*can_id = (uintptr_t)can_dev;
 
 	CAN_DeInit(can_dev->cfg->regs);
-	CAN_Init(can_dev->cfg->regs, (CAN_InitTypeDef *)&can_dev->cfg->init);
-
-	/* CAN filter init */
-	CAN_FilterInitTypeDef CAN_FilterInitStructure;
-	CAN_FilterInitStructure.CAN_FilterNumber = 0;
-	CAN_FilterInitStructure.CAN_FilterMode = CAN_FilterMode_IdMask;
-	CAN_FilterInitStructure.CAN_FilterScale = CAN_FilterScale_32bit;
-	CAN_FilterInitStructure.CAN_FilterIdHigh = 0x0000;
-	CAN_FilterInitStructure.CAN_FilterIdLow = 0x0000;
-	CAN_FilterInitStructure.CAN_FilterMaskIdHigh = 0x0000;
-	CAN_FilterInitStructure.CAN_FilterMaskIdLow = 0x0000;  
-	CAN_FilterInitStructure.CAN_FilterFIFOAssignment = 1;
-
-	CAN_FilterInitStructure.CAN_FilterActivation = ENABLE;
-	CAN_FilterInit(&CAN_FilterInitStructure);
+
+	/* Send in the order queued, so multi-frame messages arrive in order */
+	CAN_InitTypeDef init = can_dev->cfg->init;
+	init.CAN_TXFP = ENABLE;
+
+	CAN_Init(can_dev->cfg->regs, &init);
+
+	/* Accept everything until told otherwise */
+	can_filter_bank(filter_first_bank(can_dev), NULL, true);
 
 	// Enable the receiver IRQ
  	NVIC_Init((NVIC_InitTypeDef*) &can_dev->cfg->rx_irq.init);
@@ -219,8 +227,9 @@ static struct pios_queue *pios_can_queues[PIOS_CAN_LAST];
 /**
  * Process received CAN messages and push them out any corresponding
  * queues. Called from ISR.
+ * \return true if the StdId is one of the known messages
  */
-static bool process_received_message(CanRxMsg message)
+static bool process_received_message(CanRxMsg message, bool *woken)
 {
 	// Look for a known message that matches this CAN StdId
 	uint32_t msg_id;
@@ -232,13 +241,10 @@ static bool process_received_message(CanRxMsg message)
 
 	// Get the queue for this message and send the data
 	struct pios_queue *queue = pios_can_queues[msg_id];
-	if (queue == NULL)
-		return false;
+	if (queue != NULL)
+		PIOS_Queue_Send_FromISR(queue, message.Data, woken);
 
-	bool woken = false;
-	PIOS_Queue_Send_FromISR(queue, message.Data, &woken);
-
-	return woken;
+	return true;
 }
 
 /**
@@ -314,8 +320,10 @@ static void PIOS_CAN_RxGeneric(void)
 		if (can_dev->rx_in_cb) {
 			(void) (can_dev->rx_in_cb)(can_dev->rx_in_context, RxMessage.Data, RxMessage.DLC, NULL, &rx_need_yield);
 		}
-	} else {
-		rx_need_yield = process_received_message(RxMessage);
+	} else if (!process_received_message(RxMessage, &rx_need_yield) &&
+			can_dev->frame_cb) {
+		rx_need_yield = (can_dev->frame_cb)(can_dev->frame_context,
+				RxMessage.StdId, RxMessage.Data, RxMessage.DLC);
 	}
 }
 
@@ -388,6 +396,134 @@ int32_t PIOS_CAN_TxData(uintptr_t id, enum pios_can_messages msg_id, uint8_t *da
 	return msg.DLC;
 }
 
+/**
+ * Programs one acceptance filter bank, feeding FIFO1.  Given ids, the bank
+ * matches exactly those four standard IDs; otherwise it accepts everything.
+ */
+static void can_filter_bank(uint8_t bank, const uint16_t *ids, bool enable)
+{
+	CAN_FilterInitTypeDef filter = {
+		.CAN_FilterNumber = bank,
+		.CAN_FilterFIFOAssignment = 1,
+		.CAN_FilterActivation = enable ? ENABLE : DISABLE,
+	};
+
+	if (ids) {
+		/* 16 bit list mode; the StdId is the top 11 bits, RTR and IDE clear */
+		filter.CAN_FilterMode = CAN_FilterMode_IdList;
+		filter.CAN_FilterScale = CAN_FilterScale_16bit;
+		filter.CAN_FilterIdLow = ids[0] << 5;
+		filter.CAN_FilterIdHigh = ids[1] << 5;
+		filter.CAN_FilterMaskIdLow = ids[2] << 5;
+		filter.CAN_FilterMaskIdHigh = ids[3] << 5;
+	} else {
+		filter.CAN_FilterMode = CAN_FilterMode_IdMask;
+		filter.CAN_FilterScale = CAN_FilterScale_32bit;
+	}
+
+	CAN_FilterInit(&filter);
+}
+
+/**
+ * Sets the hardware acceptance filters to pass only the given standard IDs,
+ * along with the COM stream and the known messages, and hands those frames
+ * to a callback from the receive ISR.  If there are more IDs than the
+ * filter banks hold, everything is accepted and the callback has to
+ * sort them out.
+ * @param[in] id the CAN device ID
+ * @param[in] std_ids the standard IDs to receive
+ * @param[in] num_ids how many there are
+ * @param[in] cb called with each frame for one of std_ids
+ * @param[in] context passed to cb
+ * @returns 0 if the filters hold every ID, 1 if accepting everything,
+ * -1 on error
+ */
+int32_t PIOS_CAN_SetFilters(uintptr_t id, const uint16_t *std_ids,
+		uint8_t num_ids, pios_can_frame_cb cb, uintptr_t context)
+{
+	struct pios_can_dev *can_dev = (struct pios_can_dev *)id;
+
+	if (!PIOS_CAN_validate(can_dev))
+		return -1;
+
+	uint16_t ids[CAN_FILTER_BANKS * CAN_IDS_PER_BANK];
+	uint32_t num = 0;
+
+	ids[num++] = CAN_COM_ID;
+	for (uint32_t i = 0; i < PIOS_CAN_LAST; i++)
+		ids[num++] = pios_can_message_stdid[i];
+
+	bool fits = num + num_ids <= NELEMENTS(ids);
+
+	if (fits) {
+		for (uint32_t i = 0; i < num_ids; i++)
+			ids[num++] = std_ids[i] & 0x7FF;
+
+		/* Fill out the last bank by repeating the final ID */
+		for (; num % CAN_IDS_PER_BANK; num++)
+			ids[num] = ids[num - 1];
+	}
+
+	/*
+	 * Order is important in these assignments since ISR uses _cb
+	 * field to determine if it's ok to dereference _cb and _context
+	 */
+	can_dev->frame_context = context;
+	can_dev->frame_cb = cb;
+
+	uint8_t first_bank = filter_first_bank(can_dev);
+
+	for (uint32_t bank = 0; bank < CAN_FILTER_BANKS; bank++) {
+		if (!fits) {
+			can_filter_bank(first_bank + bank, NULL, bank == 0);
+		} else if (bank * CAN_IDS_PER_BANK < num) {
+			can_filter_bank(first_bank + bank,
+					&ids[bank * CAN_IDS_PER_BANK], true);
+		} else {
+			can_filter_bank(first_bank + bank, NULL, false);
+		}
+	}
+
+	return fits ? 0 : 1;
+}
+
+/**
+ * PIOS_CAN_TxFrame transmits a single frame with a specified ID
+ * @param[in] id the CAN device ID
+ * @param[in] std_id The standard ID (< 0x7FF)
+ * @param[in] data Pointer to the frame data
+ * @param[in] len Length of the data, at most 8
+ * @returns number of bytes sent if successful, -1 if not, -2 if all the
+ * transmit mailboxes are busy
+ */
+int32_t PIOS_CAN_TxFrame(uintptr_t id, uint16_t std_id, const uint8_t *data,
+		uint8_t len)
+{
+	struct pios_can_dev *can_dev = (struct pios_can_dev *)id;
+
+	if (!PIOS_CAN_validate(can_dev) || len > MAX_SEND_LEN)
+		return -1;
+
+	CanTxMsg msg;
+	msg.StdId = std_id & 0x7FF;
+	msg.ExtId = 0;
+	msg.IDE = CAN_ID_STD;
+	msg.RTR = CAN_RTR_DATA;
+	msg.DLC = len;
+	memcpy(msg.Data, data, len);
+
+	/* The COM stream transmits from the ISR; keep it off the mailbox
+	 * found empty here */
+	PIOS_IRQ_Disable();
+	uint8_t mailbox = CAN_Transmit(can_dev->cfg->regs, &msg);
+	PIOS_IRQ_Enable();
+
+	if (mailbox == CAN_TxStatus_NoMailBox)
+		return -2;
+
+	return len;
+}
+
 
 #endif /* PIOS_INCLUDE_CAN */
 /**
@@ -0,0 +1,97 @@
+/**
+ ******************************************************************************
+ * @addtogroup PIOS PIOS Core hardware abstraction layer
+ * @{
+ * @addtogroup   PIOS_CRC CRC Functions
+ * @{
+ *
+ * @file       pios_crc_hw.c
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2017
+ * @brief      CRC8 using the STM32F30x CRC calculation unit
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "pios.h"
+
+#if defined(PIOS_INCLUDE_CRC_HW)
+
+#include <string.h>
+
+/* The unit is shared by every task that computes a CRC.  Rather than
+ * block, a caller that finds it busy falls back to the table.
+ */
+static volatile uint8_t crc_hw_busy;
+static bool crc_hw_initialized;
+
+/**
+ * Update an UAVTalk style CRC8 (poly 0x07, no reflection) in hardware.
+ * \param[in,out] crc The current crc value, updated on success
+ * \param[in] data Data buffer
+ * \param[in] length Number of bytes to process
+ * \return true if the unit was free and the crc was updated
+ */
+bool PIOS_CRC_HW_updateCRC(uint8_t *crc, const uint8_t *data, int32_t length)
+{
+	if (__sync_lock_test_and_set(&crc_hw_busy, 1)) {
+		return false;
+	}
+
+	if (!crc_hw_initialized) {
+		RCC_AHBPeriphClockCmd(RCC_AHBPeriph_CRC, ENABLE);
+
+		CRC_PolynomialSizeSelect(CRC_PolSize_8);
+		CRC_SetPolynomial(0x07);
+		CRC_ReverseInputDataSelect(CRC_ReverseInputData_No);
+		CRC_ReverseOutputDataCmd(DISABLE);
+
+		crc_hw_initialized = true;
+	}
+
+	CRC_SetInitRegister(*crc);
+	CRC_ResetDR();
+
+	/* Words are shifted in MSB first, so byte swap to keep the
+	 * stream order.
+	 */
+	while (length >= 4) {
+		uint32_t word;
+
+		memcpy(&word, data, sizeof(word));
+		CRC->DR = __builtin_bswap32(word);
+
+		data += 4;
+		length -= 4;
+	}
+
+	while (length--) {
+		*(__IO uint8_t *)&CRC->DR = *data++;
+	}
+
+	*crc = CRC->DR;
+
+	__sync_lock_release(&crc_hw_busy);
+
+	return true;
+}
+
+#endif /* PIOS_INCLUDE_CRC_HW */
+
+/**
+ * @}
+ * @}
+ */
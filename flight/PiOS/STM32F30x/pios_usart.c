@@ -55,6 +55,11 @@ const struct pios_com_driver pios_usart_com_driver = {
 	.bind_rx_cb = PIOS_USART_RegisterRxCallback,
 };
 
+/* DMA buffer sizes.  RX hands up at half and full, so each half must cover
+ * the worst interrupt latency at the highest baud rate in use. */
+#define PIOS_USART_DMA_RX_LEN 128
+#define PIOS_USART_DMA_TX_LEN 64
+
 enum pios_usart_dev_magic {
 	PIOS_USART_DEV_MAGIC = 0x4152834A,
 };
@@ -68,6 +73,12 @@ struct pios_usart_dev {
 	pios_com_callback tx_out_cb;
 	uintptr_t tx_out_context;
 
+	uint8_t *rx_dma_buf;
+	uint16_t rx_dma_tail;
+	uint8_t *tx_dma_buf;
+	volatile bool tx_dma_busy;
+	bool use_dma;
+
 	uint32_t error_overruns;
 };
 
@@ -98,6 +109,7 @@ static struct pios_usart_dev * PIOS_USART_alloc(void)
  * each physical IRQ to a specific registered device instance.
  */
 static void PIOS_USART_generic_irq_handler(uintptr_t usart_id);
+static int32_t PIOS_USART_DMA_Init(struct pios_usart_dev *usart_dev);
 
 static uintptr_t PIOS_USART_1_id;
 void USART1_EXTI25_IRQHandler(void) __attribute__ ((alias ("PIOS_USART_1_irq_handler")));
@@ -223,8 +235,15 @@ int32_t PIOS_USART_Init(uintptr_t * usart_id, const struct pios_usart_cfg * cfg,
 		break;
 	}
 	NVIC_Init((NVIC_InitTypeDef *)&(usart_dev->cfg->irq.init));
-	USART_ITConfig(usart_dev->cfg->regs, USART_IT_RXNE, ENABLE);
-	USART_ITConfig(usart_dev->cfg->regs, USART_IT_TXE,  ENABLE);
+	if (usart_dev->cfg->dma && params->dma) {
+		usart_dev->use_dma = true;
+
+		if (PIOS_USART_DMA_Init(usart_dev))
+			goto out_fail;
+	} else {
+		USART_ITConfig(usart_dev->cfg->regs, USART_IT_RXNE, ENABLE);
+		USART_ITConfig(usart_dev->cfg->regs, USART_IT_TXE,  ENABLE);
+	}
 
 	// FIXME XXX Clear / reset uart here - sends NUL char else
 
@@ -244,6 +263,10 @@ static void PIOS_USART_RxStart(uintptr_t usart_id, uint16_t rx_bytes_avail)
 	bool valid = PIOS_USART_validate(usart_dev);
 	PIOS_Assert(valid);
 	
+	/* DMA receive never stops */
+	if (usart_dev->use_dma)
+		return;
+
 	USART_ITConfig(usart_dev->cfg->regs, USART_IT_RXNE, ENABLE);
 }
 static void PIOS_USART_TxStart(uintptr_t usart_id, uint16_t tx_bytes_avail)
@@ -253,6 +276,14 @@ static void PIOS_USART_TxStart(uintptr_t usart_id, uint16_t tx_bytes_avail)
 	bool valid = PIOS_USART_validate(usart_dev);
 	PIOS_Assert(valid);
 	
+	if (usart_dev->use_dma) {
+		/* Let the ISR start the transfer, so only it touches the
+		 * DMA state */
+		if (!usart_dev->tx_dma_busy)
+			NVIC_SetPendingIRQ(usart_dev->cfg->irq.init.NVIC_IRQChannel);
+		return;
+	}
+
 	USART_ITConfig(usart_dev->cfg->regs, USART_IT_TXE, ENABLE);
 }
 
@@ -319,6 +350,178 @@ static void PIOS_USART_RegisterTxCallback(uintptr_t usart_id, pios_com_callback
 	usart_dev->tx_out_cb = tx_out_cb;
 }
 
+static int32_t PIOS_USART_DMA_Init(struct pios_usart_dev *usart_dev)
+{
+	const struct pios_usart_dma_cfg *dma = usart_dev->cfg->dma;
+	USART_TypeDef *regs = usart_dev->cfg->regs;
+
+	usart_dev->rx_dma_buf = PIOS_malloc(PIOS_USART_DMA_RX_LEN);
+	usart_dev->tx_dma_buf = PIOS_malloc(PIOS_USART_DMA_TX_LEN);
+	if (!usart_dev->rx_dma_buf || !usart_dev->tx_dma_buf)
+		return -1;
+
+	/* Receive runs forever into a circular buffer */
+	DMA_InitTypeDef init = dma->dma.rx.init;
+	init.DMA_PeripheralBaseAddr = (uint32_t)&regs->RDR;
+	init.DMA_MemoryBaseAddr = (uint32_t)usart_dev->rx_dma_buf;
+	init.DMA_DIR = DMA_DIR_PeripheralSRC;
+	init.DMA_BufferSize = PIOS_USART_DMA_RX_LEN;
+	init.DMA_Mode = DMA_Mode_Circular;
+
+	DMA_DeInit(dma->dma.rx.channel);
+	DMA_Init(dma->dma.rx.channel, &init);
+	DMA_ITConfig(dma->dma.rx.channel, DMA_IT_HT | DMA_IT_TC, ENABLE);
+
+	/* Transmit is set up once; each transfer only sets its length */
+	init = dma->dma.tx.init;
+	init.DMA_PeripheralBaseAddr = (uint32_t)&regs->TDR;
+	init.DMA_MemoryBaseAddr = (uint32_t)usart_dev->tx_dma_buf;
+	init.DMA_DIR = DMA_DIR_PeripheralDST;
+	init.DMA_BufferSize = PIOS_USART_DMA_TX_LEN;
+	init.DMA_Mode = DMA_Mode_Normal;
+
+	DMA_DeInit(dma->dma.tx.channel);
+	DMA_Init(dma->dma.tx.channel, &init);
+
+	NVIC_Init((NVIC_InitTypeDef *)&dma->dma.irq.init);
+
+	USART_DMACmd(regs, USART_DMAReq_Rx | USART_DMAReq_Tx, ENABLE);
+	DMA_Cmd(dma->dma.rx.channel, ENABLE);
+
+	USART_ITConfig(regs, USART_IT_IDLE, ENABLE);
+
+	return 0;
+}
+
+/**
+ * Hands everything the rx DMA has written since the last call up to the
+ * COM layer, as at most two contiguous spans.  Runs from both the USART
+ * and the DMA IRQ, which must share a priority.
+ */
+static void PIOS_USART_DMA_RxDrain(struct pios_usart_dev *usart_dev, bool *need_yield)
+{
+	uint16_t head = PIOS_USART_DMA_RX_LEN -
+		DMA_GetCurrDataCounter(usart_dev->cfg->dma->dma.rx.channel);
+	uint16_t tail = usart_dev->rx_dma_tail;
+
+	if (head == PIOS_USART_DMA_RX_LEN)
+		head = 0;
+
+	if (head == tail)
+		return;
+
+	if (usart_dev->rx_in_cb) {
+		if (head < tail) {
+			(void) (usart_dev->rx_in_cb)(usart_dev->rx_in_context,
+					&usart_dev->rx_dma_buf[tail],
+					PIOS_USART_DMA_RX_LEN - tail, NULL, need_yield);
+			tail = 0;
+		}
+
+		if (head > tail) {
+			(void) (usart_dev->rx_in_cb)(usart_dev->rx_in_context,
+					&usart_dev->rx_dma_buf[tail],
+					head - tail, NULL, need_yield);
+		}
+	}
+
+	usart_dev->rx_dma_tail = head;
+}
+
+/**
+ * Starts the next transmit chunk, or stops if the COM layer has nothing.
+ */
+static void PIOS_USART_DMA_TxNext(struct pios_usart_dev *usart_dev, bool *need_yield)
+{
+	const struct pios_usart_dma_cfg *dma = usart_dev->cfg->dma;
+	uint16_t len = 0;
+
+	if (usart_dev->tx_out_cb) {
+		len = (usart_dev->tx_out_cb)(usart_dev->tx_out_context,
+				usart_dev->tx_dma_buf, PIOS_USART_DMA_TX_LEN,
+				NULL, need_yield);
+	}
+
+	if (len == 0) {
+		usart_dev->tx_dma_busy = false;
+		USART_ITConfig(usart_dev->cfg->regs, USART_IT_TC, DISABLE);
+		return;
+	}
+
+	usart_dev->tx_dma_busy = true;
+
+	/* The channel must be off to take a new length */
+	DMA_Cmd(dma->dma.tx.channel, DISABLE);
+	DMA_ClearFlag(dma->tx_flags);
+	DMA_SetCurrDataCounter(dma->dma.tx.channel, len);
+	USART_ClearFlag(usart_dev->cfg->regs, USART_FLAG_TC);
+	DMA_Cmd(dma->dma.tx.channel, ENABLE);
+	USART_ITConfig(usart_dev->cfg->regs, USART_IT_TC, ENABLE);
+}
+
+static void PIOS_USART_DMA_irq_handler(struct pios_usart_dev *usart_dev)
+{
+	USART_TypeDef *regs = usart_dev->cfg->regs;
+	uint32_t isr = regs->ISR;
+	bool need_yield = false;
+
+	if (isr & USART_ISR_ORE) {
+		USART_ClearITPendingBit(regs, USART_IT_ORE);
+		++usart_dev->error_overruns;
+	}
+
+	if (isr & USART_ISR_IDLE) {
+		USART_ClearITPendingBit(regs, USART_IT_IDLE);
+		PIOS_USART_DMA_RxDrain(usart_dev, &need_yield);
+	}
+
+	/* TC means the last chunk is out; otherwise this was a kick from
+	 * TxStart */
+	if (!usart_dev->tx_dma_busy || (isr & USART_ISR_TC))
+		PIOS_USART_DMA_TxNext(usart_dev, &need_yield);
+}
+
+/**
+ * Services the rx DMA half and full transfer interrupts.  Boards call this
+ * from the handler of the channel in the USART's DMA config.
+ */
+void PIOS_USART_DMA_Rx_IRQHandler(const struct pios_usart_cfg *cfg)
+{
+	uintptr_t usart_id = 0;
+
+	switch ((uint32_t)cfg->regs) {
+	case (uint32_t)USART1:
+		usart_id = PIOS_USART_1_id;
+		break;
+	case (uint32_t)USART2:
+		usart_id = PIOS_USART_2_id;
+		break;
+	case (uint32_t)USART3:
+		usart_id = PIOS_USART_3_id;
+		break;
+	case (uint32_t)UART4:
+		usart_id = PIOS_UART_4_id;
+		break;
+	case (uint32_t)UART5:
+		usart_id = PIOS_UART_5_id;
+		break;
+	}
+
+	PIOS_IRQ_Prologue();
+
+	DMA_ClearFlag(cfg->dma->rx_flags);
+
+	struct pios_usart_dev *usart_dev = (struct pios_usart_dev *)usart_id;
+
+	if (usart_dev && PIOS_USART_validate(usart_dev) && usart_dev->use_dma) {
+		bool need_yield = false;
+
+		PIOS_USART_DMA_RxDrain(usart_dev, &need_yield);
+	}
+
+	PIOS_IRQ_Epilogue();
+}
+
 static void PIOS_USART_generic_irq_handler(uintptr_t usart_id)
 {
 	struct pios_usart_dev * usart_dev = (struct pios_usart_dev *)usart_id;
@@ -329,6 +532,11 @@ static void PIOS_USART_generic_irq_handler(uintptr_t usart_id)
 	bool valid = PIOS_USART_validate(usart_dev);
 	PIOS_Assert(valid);
 	
+	if (usart_dev->use_dma) {
+		PIOS_USART_DMA_irq_handler(usart_dev);
+		return;
+	}
+
 	/* Check if RXNE flag is set */
 	if (USART_GetITStatus(usart_dev->cfg->regs, USART_IT_RXNE)) {
 		uint8_t byte = (uint8_t)USART_ReceiveData(usart_dev->cfg->regs);
@@ -132,7 +132,8 @@ void PIOS_DMAShot_InitializeDMAs();
 void PIOS_DMAShot_Validate();
 
 /**
- * @brief Sets the throttle value of a specific servo.
+ * @brief Sets the throttle value of a specific servo. The frame is staged and only
+ * goes out with the next PIOS_DMAShot_TriggerUpdate().
  * @param[in] servo_channel The servo to update.
  * @param[in] throttle The desired throttle value (0-2047).
  * @retval TRUE on success, FALSE if the channel's not set up for DMA.
@@ -140,8 +141,24 @@ void PIOS_DMAShot_Validate();
 void PIOS_DMAShot_WriteValue(const struct pios_tim_channel *servo_channel, uint16_t throttle);
 
 /**
- * @brief Triggers the configured DMA channels to fire and send throttle values to the timer DMAR and optional CCRx registers.
+ * @brief Copies the staged frames into the DMA buffers, and triggers the configured DMA channels to fire and send
+ * throttle values to the timer DMAR and optional CCRx registers.
  */
 void PIOS_DMAShot_TriggerUpdate();
 
+/**
+ * @brief Selects bidirectional DShot for timers set up after this call. Timers
+                        that can't capture the ESC reply keep sending regular DShot.
+ * @param[in] enable Whether to use bidirectional DShot.
+ */
+void PIOS_DMAShot_SetBidirectional(bool enable);
+
+/**
+ * @brief Gets the last eRPM reported by the ESC on a servo.
+ * @param[in] servo_channel The servo in question.
+ * @param[out] erpm Electrical RPM, zero for a stopped motor.
+ * @retval TRUE if the last reply was valid, FALSE otherwise.
+ */
+bool PIOS_DMAShot_GetERPM(const struct pios_tim_channel *servo_channel, uint32_t *erpm);
+
 #endif // PIOS_DMASHOT_H
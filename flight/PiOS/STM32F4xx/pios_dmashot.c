@@ -58,8 +58,26 @@ struct servo_timer {
 	uint16_t duty_cycle_1;                                                          // And for 1-bit
 
 	union dma_buffer buffer;                                                        // DMA buffer
+	union dma_buffer frame;                                                         // Next frame, copied to the DMA buffer on trigger
+	uint16_t buffer_size;                                                           // Size of either buffer, in bytes
 	uint8_t dma_started;                                                            // Whether DMA transfers have been initiated
 
+	uint32_t nibble_duty[16][4];                                                    // CC values for each 4-bit pattern, MSB first
+
+	// Bidirectional DShot. After each frame the pins are released and the
+	// timer paces DMA reads of the GPIO input register instead.
+	bool bidir;                                                                     // Timer runs bidirectional DShot
+	bool capture_started;                                                           // Telemetry capture in progress
+	GPIO_TypeDef *capture_gpio;                                                     // Port all channels are on
+	uint32_t moder_mask;                                                            // MODER bits of the channel pins
+	uint32_t moder_af;                                                              // MODER value for AF mode
+	uint16_t *capture_buffer;                                                       // Sampled IDR values
+	uint16_t capture_samples;                                                       // Samples per capture
+	uint16_t capture_period;                                                        // Timer period while sampling
+	uint16_t dshot_period;                                                          // Timer period while sending
+
+	uint32_t erpm[4];                                                               // Last decoded eRPM per channel
+	uint8_t erpm_valid;                                                             // Bitmask of channels with valid eRPM
 };
 
 // DShot signal is 16-bit. Use a pause before and after to delimit signal and quell the timer CC
@@ -75,9 +93,19 @@ struct servo_timer {
 
 #define TIMC_TO_INDEX(c)                        ((c)>>2)
 
+// ESC replies are 21 bits, GCR-coded at 5/4 the command rate, starting about
+// 30us after the command frame. Sample each bit this many times, over a
+// window long enough for the reply delay at the fastest rate.
+#define DMASHOT_TELEM_BITS                      21
+#define DMASHOT_TELEM_OVERSAMPLE                3
+#define DMASHOT_TELEM_WINDOW_US                 40
+#define DMASHOT_TELEM_MAX_SAMPLES               256
+
 const struct pios_dmashot_cfg *dmashot_cfg;
 struct servo_timer **servo_timers;
 
+static bool dmashot_bidir;
+
 // Whether a timer is 16- or 32-bit wide.
 static inline bool PIOS_DMAShot_HalfWord(struct servo_timer *s_timer)
 {
@@ -170,20 +198,31 @@ void PIOS_DMAShot_WriteValue(const struct pios_tim_channel *servo_channel, uint1
 		throttle |= 16;
 	}
 
-	throttle |=
+	uint16_t crc =
 			((throttle >> 4 ) & 0xf) ^
 			((throttle >> 8 ) & 0xf) ^
 			((throttle >> 12) & 0xf);
 
-	// Leading zero, trailing zero.
-	for (int i = DMASHOT_MESSAGE_PAUSE; i < DMASHOT_MESSAGE_WIDTH+DMASHOT_MESSAGE_PAUSE; i++) {
-		int addr = i * channels + shift;
+	// ESCs tell bidirectional frames apart by the inverted checksum.
+	if (s_timer->bidir)
+		crc = ~crc & 0xf;
+
+	throttle |= crc;
+
+	// Expand a nibble at a time into the staging frame, which is interleaved
+	// by channel for the burst. Leading and trailing zeroes are never written.
+	int addr = DMASHOT_MESSAGE_PAUSE * channels + shift;
+
+	for (int n = 12; n >= 0; n -= 4) {
+		const uint32_t *duty = s_timer->nibble_duty[(throttle >> n) & 0xf];
+
 		if (PIOS_DMAShot_HalfWord(s_timer)) {
-			s_timer->buffer.hw[addr] = throttle & 0x8000 ? s_timer->duty_cycle_1 : s_timer->duty_cycle_0;
+			for (int b = 0; b < 4; b++, addr += channels)
+				s_timer->frame.hw[addr] = duty[b];
 		} else {
-			s_timer->buffer.fw[addr] = throttle & 0x8000 ? s_timer->duty_cycle_1 : s_timer->duty_cycle_0;
+			for (int b = 0; b < 4; b++, addr += channels)
+				s_timer->frame.fw[addr] = duty[b];
 		}
-		throttle <<= 1;
 	}
 }
 
@@ -311,6 +350,10 @@ void PIOS_DMAShot_InitializeGPIOs()
 
 				GPIO_InitTypeDef gpio_cfg = servo_channel->pin.init;
 				gpio_cfg.GPIO_Speed = GPIO_High_Speed;
+
+				// The line idles high and the ESC answers on it.
+				if (s_timer->bidir)
+					gpio_cfg.GPIO_PuPd = GPIO_PuPd_UP;
 				GPIO_Init(servo_channel->pin.gpio, &gpio_cfg);
 
 				GPIO_PinAFConfig(servo_channel->pin.gpio, servo_channel->pin.pin_source, servo_channel->remap);
@@ -364,6 +407,46 @@ static void PIOS_DMAShot_TimerSetup(struct servo_timer *s_timer, uint32_t sysclo
 	TIM_SelectOnePulseMode(timer, TIM_OPMode_Repetitive);
 }
 
+// Whether telemetry can be captured on this timer: the reply is sampled by
+// DMA reads of one GPIO input register, which only DMA2 can reach, and
+// which isn't possible when going through a master timer.
+static bool PIOS_DMAShot_CanCapture(struct servo_timer *s_timer)
+{
+	if (s_timer->dma->master_timer)
+		return false;
+
+	if ((uintptr_t)s_timer->dma->stream < (uintptr_t)DMA2_Stream0)
+		return false;
+
+	GPIO_TypeDef *gpio = NULL;
+	uint32_t moder_mask = 0;
+	uint32_t moder_af = 0;
+
+	for (int j = 0; j < 4; j++) {
+		const struct pios_tim_channel *servo_channel = s_timer->servo_channels[j];
+		if (!servo_channel)
+			continue;
+
+		if (gpio && gpio != servo_channel->pin.gpio)
+			return false;
+
+		gpio = servo_channel->pin.gpio;
+
+		int pin = servo_channel->pin.pin_source;
+		moder_mask |= 3 << (pin * 2);
+		moder_af |= GPIO_Mode_AF << (pin * 2);
+	}
+
+	if (!gpio)
+		return false;
+
+	s_timer->capture_gpio = gpio;
+	s_timer->moder_mask = moder_mask;
+	s_timer->moder_af = moder_af;
+
+	return true;
+}
+
 void PIOS_DMAShot_InitializeTimers(TIM_OCInitTypeDef *ocinit)
 {
 	// If there's nothing setup, fail hard. We shouldn't be getting here.
@@ -382,15 +465,44 @@ void PIOS_DMAShot_InitializeTimers(TIM_OCInitTypeDef *ocinit)
 			continue;
 		}
 
-		PIOS_DMAShot_TimerSetup(s_timer, s_timer->sysclock, s_timer->dshot_freq, ocinit, false);
+		s_timer->bidir = dmashot_bidir && PIOS_DMAShot_CanCapture(s_timer);
+		s_timer->capture_started = false;
+		s_timer->erpm_valid = 0;
+
+		// Bidirectional DShot idles high, so flip the output polarity.
+		TIM_OCInitTypeDef oc = *ocinit;
+		if (s_timer->bidir) {
+			oc.TIM_OCPolarity = (oc.TIM_OCPolarity == TIM_OCPolarity_High) ?
+				TIM_OCPolarity_Low : TIM_OCPolarity_High;
+		}
+
+		PIOS_DMAShot_TimerSetup(s_timer, s_timer->sysclock, s_timer->dshot_freq, &oc, false);
 
 		int f = s_timer->sysclock / s_timer->dshot_freq;
+		s_timer->dshot_period = f;
+
+		if (s_timer->bidir) {
+			uint32_t sample_rate = s_timer->dshot_freq / 4 * 5 * DMASHOT_TELEM_OVERSAMPLE;
+			uint32_t samples = (uint64_t)sample_rate * DMASHOT_TELEM_WINDOW_US / 1000000 +
+				DMASHOT_TELEM_BITS * DMASHOT_TELEM_OVERSAMPLE;
+
+			s_timer->capture_period = s_timer->sysclock / sample_rate;
+			s_timer->capture_samples = samples < DMASHOT_TELEM_MAX_SAMPLES ?
+				samples : DMASHOT_TELEM_MAX_SAMPLES;
+		}
 
 		s_timer->duty_cycle_0 = (f * DSHOT_DUTY_CYCLE_0 + 50) / 100;
 		s_timer->duty_cycle_1 = (f * DSHOT_DUTY_CYCLE_1 + 50) / 100;
 
+		for (int n = 0; n < 16; n++) {
+			for (int b = 0; b < 4; b++) {
+				s_timer->nibble_duty[n][b] = (n & (8 >> b)) ?
+					s_timer->duty_cycle_1 : s_timer->duty_cycle_0;
+			}
+		}
+
 		if (s_timer->dma->master_timer)
-			PIOS_DMAShot_TimerSetup(s_timer, s_timer->sysclock, s_timer->dshot_freq, ocinit, true);
+			PIOS_DMAShot_TimerSetup(s_timer, s_timer->sysclock, s_timer->dshot_freq, &oc, true);
 
 		s_timer->dma_started = 0;
 	}
@@ -445,6 +557,34 @@ static void PIOS_DMAShot_DMASetup(struct servo_timer *s_timer)
 	DMA_ITConfig(s_timer->dma->stream, DMA_IT_TC, DISABLE);
 }
 
+// Points the timer's DMA stream at the GPIO input register, for sampling the reply.
+static void PIOS_DMAShot_CaptureDMASetup(struct servo_timer *s_timer)
+{
+	DMA_DeInit(s_timer->dma->stream);
+
+	DMA_InitTypeDef dma;
+	DMA_StructInit(&dma);
+
+	dma.DMA_Channel = s_timer->dma->channel;
+	dma.DMA_Memory0BaseAddr = (uint32_t)s_timer->capture_buffer;
+	dma.DMA_PeripheralBaseAddr = (uint32_t)&s_timer->capture_gpio->IDR;
+
+	dma.DMA_MemoryDataSize = DMA_MemoryDataSize_HalfWord;
+	dma.DMA_PeripheralDataSize = DMA_PeripheralDataSize_HalfWord;
+	dma.DMA_MemoryInc = DMA_MemoryInc_Enable;
+	dma.DMA_PeripheralInc = DMA_PeripheralInc_Disable;
+
+	dma.DMA_DIR = DMA_DIR_PeripheralToMemory;
+	dma.DMA_Mode = DMA_Mode_Normal;
+	dma.DMA_BufferSize = s_timer->capture_samples;
+	dma.DMA_Priority = DMA_Priority_VeryHigh;
+	dma.DMA_FIFOMode = DMA_FIFOMode_Disable;
+
+	DMA_Init(s_timer->dma->stream, &dma);
+
+	DMA_ITConfig(s_timer->dma->stream, DMA_IT_TC, DISABLE);
+}
+
 // Allocates an aligned buffer for DMA burst transfers. Returns uint32_t, since
 // that's the pointer type for Mem0 base address in DMA_InitTypeDef.
 static uint32_t PIOS_DMAShot_AllocateBuffer(uint16_t size)
@@ -476,16 +616,173 @@ void PIOS_DMAShot_InitializeDMAs()
 
 		if (!s_timer->buffer.ptr) {
 			// Allocate buffer at timer resolution.
-			s_timer->buffer.ptr = PIOS_DMAShot_AllocateBuffer(
-					PIOS_DMAShot_GetNumChannels(s_timer) * DMASHOT_STM32_BUFFER *
-					(PIOS_DMAShot_HalfWord(s_timer) ? sizeof(uint16_t) : sizeof(uint32_t))
-				);
+			s_timer->buffer_size = PIOS_DMAShot_GetNumChannels(s_timer) * DMASHOT_STM32_BUFFER *
+					(PIOS_DMAShot_HalfWord(s_timer) ? sizeof(uint16_t) : sizeof(uint32_t));
+			s_timer->buffer.ptr = PIOS_DMAShot_AllocateBuffer(s_timer->buffer_size);
+
+			// The staging frame is only touched by the CPU.
+			s_timer->frame.ptr = (uint32_t)PIOS_malloc_no_dma(s_timer->buffer_size);
+			PIOS_Assert(s_timer->frame.ptr);
+			memset(s_timer->frame.fw, 0, s_timer->buffer_size);
+		}
+
+		if (s_timer->bidir && !s_timer->capture_buffer) {
+			s_timer->capture_buffer = (uint16_t *)PIOS_DMAShot_AllocateBuffer(
+					DMASHOT_TELEM_MAX_SAMPLES * sizeof(uint16_t));
 		}
 
 		PIOS_DMAShot_DMASetup(s_timer);
 	}
 }
 
+static const uint8_t gcr_decode[32] = {
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 9, 10, 11, 0, 13, 14, 15,
+	0, 0, 2, 3, 0, 5, 6, 7, 0, 0, 8, 1, 0, 4, 12, 0,
+};
+
+// Decodes a telemetry reply from one pin's samples. Returns the eRPM, zero
+// for a stopped motor, or -1 if there's no valid reply.
+static int32_t PIOS_DMAShot_DecodeTelemetry(const uint16_t *samples, int count, uint16_t pin)
+{
+	int i = 0;
+
+	// The reply starts with the line going low.
+	while (i < count && (samples[i] & pin))
+		i++;
+
+	if (i >= count)
+		return -1;
+
+	// Turn run lengths into bits: every level change marks a one, which
+	// leaves the GCR word in the low 20 bits under the start bit.
+	uint32_t value = 0;
+	int bits = 0;
+	int start = i;
+	bool level = false;
+
+	for (i++; i < count && bits < DMASHOT_TELEM_BITS; i++) {
+		bool l = (samples[i] & pin) != 0;
+		if (l == level)
+			continue;
+
+		int len = (i - start + DMASHOT_TELEM_OVERSAMPLE / 2) / DMASHOT_TELEM_OVERSAMPLE;
+		if (len < 1)
+			len = 1;
+
+		value <<= len;
+		value |= 1 << (len - 1);
+		bits += len;
+
+		start = i;
+		level = l;
+	}
+
+	// The last run merges into the idle level, so infer its length.
+	if (bits < 18 || bits > DMASHOT_TELEM_BITS)
+		return -1;
+
+	int tail = DMASHOT_TELEM_BITS - bits;
+	if (tail > 0) {
+		value <<= tail;
+		value |= 1 << (tail - 1);
+	}
+
+	uint32_t decoded = gcr_decode[value & 0x1f] |
+		(gcr_decode[(value >> 5) & 0x1f] << 4) |
+		(gcr_decode[(value >> 10) & 0x1f] << 8) |
+		(gcr_decode[(value >> 15) & 0x1f] << 12);
+
+	uint32_t csum = decoded ^ (decoded >> 8);
+	csum ^= csum >> 4;
+
+	if ((csum & 0xf) != 0xf)
+		return -1;
+
+	decoded >>= 4;
+
+	if (decoded == 0x0fff)
+		return 0;
+
+	// 3 bit exponent, 9 bit mantissa period in us.
+	uint32_t period_us = (decoded & 0x1ff) << (decoded >> 9);
+	if (!period_us)
+		return -1;
+
+	return (60000000 + period_us / 2) / period_us;
+}
+
+// Waits out the capture, decodes every channel and puts the timer back
+// into output mode.
+static void PIOS_DMAShot_FinishCapture(struct servo_timer *s_timer)
+{
+	// Timer-paced, so it ends whether or not an ESC answered.
+	while (DMA_GetFlagStatus(s_timer->dma->stream, s_timer->dma->tcif) != SET) ;
+
+	TIM_Cmd(s_timer->dma->timer, DISABLE);
+	TIM_DMACmd(s_timer->dma->timer, TIM_DMA_Update, DISABLE);
+	DMA_Cmd(s_timer->dma->stream, DISABLE);
+	while (DMA_GetCmdStatus(s_timer->dma->stream) == ENABLE) ;
+
+	for (int j = 0; j < 4; j++) {
+		const struct pios_tim_channel *servo_channel = s_timer->servo_channels[j];
+		if (!servo_channel)
+			continue;
+
+		int32_t erpm = PIOS_DMAShot_DecodeTelemetry(s_timer->capture_buffer,
+				s_timer->capture_samples, servo_channel->pin.init.GPIO_Pin);
+
+		if (erpm >= 0) {
+			s_timer->erpm[j] = erpm;
+			s_timer->erpm_valid |= 1 << j;
+		} else {
+			s_timer->erpm_valid &= ~(1 << j);
+		}
+	}
+
+	// Hand the pins back to the timer.
+	GPIO_TypeDef *gpio = s_timer->capture_gpio;
+	gpio->MODER = (gpio->MODER & ~s_timer->moder_mask) | s_timer->moder_af;
+
+	TIM_SetAutoreload(s_timer->dma->timer, s_timer->dshot_period);
+	PIOS_DMAShot_DMASetup(s_timer);
+
+	s_timer->capture_started = false;
+}
+
+// Waits for the command frame to go out, then releases the pins and
+// starts sampling the reply.
+static void PIOS_DMAShot_StartCapture(struct servo_timer *s_timer)
+{
+	TIM_TypeDef *timer = s_timer->dma->timer;
+
+	// Transfer complete fires as the trailing pause is written; it only
+	// takes effect at the next update.
+	while (DMA_GetFlagStatus(s_timer->dma->stream, s_timer->dma->tcif) != SET) ;
+	TIM_ClearFlag(timer, TIM_FLAG_Update);
+	while (TIM_GetFlagStatus(timer, TIM_FLAG_Update) != SET) ;
+
+	TIM_Cmd(timer, DISABLE);
+	TIM_DMACmd(timer, TIM_DMA_Update, DISABLE);
+	DMA_Cmd(s_timer->dma->stream, DISABLE);
+	while (DMA_GetCmdStatus(s_timer->dma->stream) == ENABLE) ;
+
+	// Inputs, left to the pull-ups.
+	s_timer->capture_gpio->MODER &= ~s_timer->moder_mask;
+
+	PIOS_DMAShot_CaptureDMASetup(s_timer);
+
+	TIM_DMAConfig(timer, TIM_DMABase_CCR1, TIM_DMABurstLength_1Transfer);
+	TIM_SetAutoreload(timer, s_timer->capture_period);
+	TIM_SetCounter(timer, 0);
+
+	DMA_ClearFlag(s_timer->dma->stream, s_timer->dma->tcif);
+	DMA_Cmd(s_timer->dma->stream, ENABLE);
+	TIM_DMACmd(timer, TIM_DMA_Update, ENABLE);
+	TIM_Cmd(timer, ENABLE);
+
+	s_timer->capture_started = true;
+}
+
 void PIOS_DMAShot_TriggerUpdate()
 {
 	// If there's nothing setup, fail hard. We shouldn't be getting here.
@@ -496,8 +793,12 @@ void PIOS_DMAShot_TriggerUpdate()
 		if (!s_timer || !s_timer->sysclock)
 			continue;
 
-		// Wait for DMA to finish.
-		if(s_timer->dma_started) {
+		// Wait for DMA to finish. Bidirectional timers already waited for
+		// their frame before capturing.
+		if (s_timer->bidir) {
+			if (s_timer->capture_started)
+				PIOS_DMAShot_FinishCapture(s_timer);
+		} else if(s_timer->dma_started) {
 			while(DMA_GetFlagStatus(s_timer->dma->stream, s_timer->dma->tcif) != SET) ;
 		}
 
@@ -518,6 +819,9 @@ void PIOS_DMAShot_TriggerUpdate()
 		TIM_Cmd(s_timer->dma->timer, DISABLE);
 		TIM_SetCounter(s_timer->dma->timer, 0);
 
+		// The previous frame is out, so the new one can go in whole.
+		memcpy(s_timer->buffer.fw, s_timer->frame.fw, s_timer->buffer_size);
+
 		DMA_ClearFlag(s_timer->dma->stream, s_timer->dma->tcif);
 		DMA_SetCurrDataCounter(s_timer->dma->stream, PIOS_DMAShot_GetNumChannels(s_timer) * DMASHOT_STM32_BUFFER);
 	}
@@ -547,6 +851,36 @@ void PIOS_DMAShot_TriggerUpdate()
 		DMA_Cmd(s_timer->dma->stream, ENABLE);
 		s_timer->dma_started = 1;
 	}
+
+	// Frames are going out on all timers in parallel; now turn the
+	// bidirectional ones around to listen.
+	for (int i = 0; i < MAX_TIMERS; i++) {
+		struct servo_timer *s_timer = servo_timers[i];
+		if (!s_timer || !s_timer->sysclock || !s_timer->bidir)
+			continue;
+
+		PIOS_DMAShot_StartCapture(s_timer);
+	}
+}
+
+void PIOS_DMAShot_SetBidirectional(bool enable)
+{
+	dmashot_bidir = enable;
+}
+
+bool PIOS_DMAShot_GetERPM(const struct pios_tim_channel *servo_channel, uint32_t *erpm)
+{
+	struct servo_timer *s_timer = PIOS_DMAShot_GetServoTimer(servo_channel);
+	if (!s_timer || !s_timer->bidir)
+		return false;
+
+	int idx = TIMC_TO_INDEX(servo_channel->timer_chan);
+	if (!(s_timer->erpm_valid & (1 << idx)))
+		return false;
+
+	*erpm = s_timer->erpm[idx];
+
+	return true;
 }
 
 bool PIOS_DMAShot_IsReady()
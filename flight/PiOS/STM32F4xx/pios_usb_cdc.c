@@ -39,6 +39,14 @@
 #include "pios_usb_board_data.h" /* PIOS_BOARD_*_DATA_LENGTH */
 #include "pios_usbhook.h"	 /* PIOS_USBHOOK_* */
 
+/*
+ * Full size packets sent per IN transfer.  The OTG core splits a transfer
+ * into packets itself and queues as many as fit in the endpoint's TX FIFO,
+ * so the bus keeps moving while there's data rather than waiting on an
+ * interrupt after every packet.
+ */
+#define PIOS_USB_CDC_TX_PACKETS 4
+
 /* Implement COM layer driver API */
 static void PIOS_USB_CDC_RegisterTxCallback(uintptr_t usbcdc_id, pios_com_callback tx_out_cb, uintptr_t context);
 static void PIOS_USB_CDC_RegisterRxCallback(uintptr_t usbcdc_id, pios_com_callback rx_in_cb, uintptr_t context);
@@ -75,13 +83,14 @@ struct pios_usb_cdc_dev {
 	uint8_t rx_packet_buffer[PIOS_USB_BOARD_CDC_DATA_LENGTH] __attribute__ ((aligned(4)));
 	volatile bool rx_active;
 
+	uint8_t tx_packet_buffer[PIOS_USB_BOARD_CDC_DATA_LENGTH * PIOS_USB_CDC_TX_PACKETS] __attribute__ ((aligned(4)));
+	volatile bool tx_active;
+
 	/*
-	 * NOTE: This is -1 as somewhat of a hack.  It ensures that we always send packets
-	 * that are strictly < maxPacketSize for this interface which means we never have
-	 * to bother with zero length packets (ZLP).
+	 * Set when a transfer ended on a full packet.  The host takes a short
+	 * packet as the end of the data, so we follow it with a zero length one.
 	 */
-	uint8_t tx_packet_buffer[PIOS_USB_BOARD_CDC_DATA_LENGTH - 1] __attribute__ ((aligned(4)));
-	volatile bool tx_active;
+	volatile bool tx_zlp_pending;
 
 	uint8_t ctrl_tx_packet_buffer[PIOS_USB_BOARD_CDC_MGMT_LENGTH] __attribute__ ((aligned(4)));
 
@@ -159,6 +168,7 @@ int32_t PIOS_USB_CDC_Init(uintptr_t * usbcdc_id, const struct pios_usb_cdc_cfg *
 	/* Rx and Tx are not active yet */
 	usb_cdc_dev->rx_active = false;
 	usb_cdc_dev->tx_active = false;
+	usb_cdc_dev->tx_zlp_pending = false;
 
 	/* Clear stats */
 	usb_cdc_dev->rx_dropped = 0;
@@ -191,6 +201,17 @@ static bool PIOS_USB_CDC_SendData(struct pios_usb_cdc_dev * usb_cdc_dev)
 		return false;
 	}
 
+	if (usb_cdc_dev->tx_zlp_pending) {
+		usb_cdc_dev->tx_zlp_pending = false;
+		usb_cdc_dev->tx_active = true;
+
+		PIOS_USBHOOK_EndpointTx(usb_cdc_dev->cfg->data_tx_ep,
+					usb_cdc_dev->tx_packet_buffer,
+					0);
+
+		return true;
+	}
+
 	bool need_yield = false;
 	bytes_to_tx = (usb_cdc_dev->tx_out_cb)(usb_cdc_dev->tx_out_context,
 					       usb_cdc_dev->tx_packet_buffer,
@@ -208,6 +229,8 @@ static bool PIOS_USB_CDC_SendData(struct pios_usb_cdc_dev * usb_cdc_dev)
 	 * to make sure we don't race with the Tx completion interrupt
 	 */
 	usb_cdc_dev->tx_active = true;
+	usb_cdc_dev->tx_zlp_pending =
+		(bytes_to_tx % PIOS_USB_BOARD_CDC_DATA_LENGTH) == 0;
 
 	PIOS_USBHOOK_EndpointTx(usb_cdc_dev->cfg->data_tx_ep,
 				usb_cdc_dev->tx_packet_buffer,
@@ -484,7 +507,7 @@ static void PIOS_USB_CDC_DATA_IF_Init(uintptr_t usb_cdc_id)
 
 	/* Register endpoint specific callbacks with the USBHOOK layer */
 	PIOS_USBHOOK_RegisterEpInCallback(usb_cdc_dev->cfg->data_tx_ep,
-					  sizeof(usb_cdc_dev->tx_packet_buffer),
+					  PIOS_USB_BOARD_CDC_DATA_LENGTH,
 					  PIOS_USB_CDC_DATA_EP_IN_Callback,
 					  (uintptr_t) usb_cdc_dev);
 	PIOS_USBHOOK_RegisterEpOutCallback(usb_cdc_dev->cfg->data_rx_ep,
@@ -507,6 +530,7 @@ static void PIOS_USB_CDC_DATA_IF_DeInit(uintptr_t usb_cdc_id)
 	usb_cdc_dev->rx_dropped = 0;
 	usb_cdc_dev->rx_oversize = 0;
 	usb_cdc_dev->tx_active = false;
+	usb_cdc_dev->tx_zlp_pending = false;
 	usb_cdc_dev->usb_data_if_enabled = false;
 
 	/* DeRegister endpoint specific callbacks with the USBHOOK layer */
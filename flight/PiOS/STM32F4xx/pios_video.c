@@ -109,10 +109,22 @@ static uint16_t num_video_lines = 0;
 static enum pios_video_system video_system_act = PIOS_VIDEO_SYSTEM_NONE;
 static const struct pios_video_type_cfg *pios_video_type_cfg_act = &pios_video_type_cfg_pal;
 
+/* Side by side 3D: the OSD draws one eye, as ever, and each line of it is
+ * clocked out twice, at double the pixel rate, for the two halves of the
+ * picture. */
+static enum pios_video_3d_mode mode_3d = PIOS_VIDEO_3D_DISABLED;
+static enum pios_video_3d_mode mode_3d_new = PIOS_VIDEO_3D_DISABLED;
+static uint8_t right_eye_x_shift = 0;
+static uint8_t right_eye_x_shift_new = 0;
+static uint16_t right_eye_arr_value;
+static bool right_eye_next;
+
 // Private functions
 static void swap_buffers();
 static void prepare_line(int16_t line);
+static void prepare_right_eye();
 static void vid_disable_spis();
+static void set_pixel_clock();
 
 /**
  * @brief Vsync interrupt service routine
@@ -153,26 +165,39 @@ bool PIOS_Vsync_ISR()
 			pios_video_type_cfg_act = &pios_video_type_cfg_pal;
 		}
 
-		if (dev_cfg->pixel_timer.timer == TIM9) { // XXX or other fast timers
-			dev_cfg->pixel_timer.timer->CCR1 = pios_video_type_cfg_act->dc;
-			dev_cfg->pixel_timer.timer->ARR  = pios_video_type_cfg_act->period - 1;
-		} else {
-			dev_cfg->pixel_timer.timer->CCR1 = pios_video_type_cfg_act->dc / 2;
-			dev_cfg->pixel_timer.timer->ARR  = pios_video_type_cfg_act->period / 2 - 1;
-		}
+		set_pixel_clock();
 
 		x_offset = -100;	/* Force recalc */
 	} else if (video_system_act == video_system_tmp) {
 		mode_hysteresis = 0;
 	}
 
-	if (x_offset != x_offset_new)
+	if (mode_3d != mode_3d_new) {
+		mode_3d = mode_3d_new;
+
+		set_pixel_clock();
+
+		x_offset = -100;	/* Force recalc */
+	}
+
+	if ((x_offset != x_offset_new) ||
+			(right_eye_x_shift != right_eye_x_shift_new))
 	{
 		x_offset = x_offset_new;
+		right_eye_x_shift = right_eye_x_shift_new;
 
 		arr_value = (pios_video_type_cfg_act->dc * (pios_video_type_cfg_act->graphics_column_start + x_offset)) / 2;
+
+		// The shift is in OSD pixels, which are half width in 3D
+		right_eye_arr_value = (pios_video_type_cfg_act->dc * right_eye_x_shift) / 4;
+
+		if (right_eye_arr_value < 1) {
+			right_eye_arr_value = 1;
+		}
 	}
 
+	right_eye_next = false;
+
 	bool woken = false;
 
 	// Every VSYNC_REDRAW_CNT field: swap buffers and trigger redraw
@@ -279,6 +304,19 @@ void PIOS_VIDEO_DMA_Handler(void)
 
 		vid_disable_spis();
 
+		if (right_eye_next) {
+			// Send the same line again for the right eye
+			right_eye_next = false;
+			prepare_right_eye();
+
+			return;
+		}
+
+		if (mode_3d != PIOS_VIDEO_3D_DISABLED) {
+			// Put back the delay from hsync for the next line
+			dev_cfg->hsync_capture.timer->ARR = arr_value;
+		}
+
 		int16_t line = active_line;
 
 		if ((line >= 0) && (line < pios_video_type_cfg_act->graphics_height_real)) { // lines existing
@@ -296,16 +334,11 @@ void PIOS_VIDEO_DMA_Handler(void)
 }
 
 /**
- * Prepare the system to watch for a Hsync pulse to trigger the pixel clock and clock out the next line
- * Note: This function is called for every line (~13k times / s), so we use direct register access for
- * efficiency
+ * Load a line of the display buffer into the DMA engines, to be clocked out
+ * once the capture timer starts the pixel timer
  */
-static inline void prepare_line(int16_t line)
+static inline void load_line(uint32_t buf_offset)
 {
-	TIM_ITConfig(dev_cfg->hsync_capture.timer, TIM_IT_Update, DISABLE);
-
-	uint32_t buf_offset = line * BUFFER_WIDTH;
-
 	// Set initial value
 	dev_cfg->pixel_timer.timer->CNT   = 0;
 
@@ -328,11 +361,62 @@ static inline void prepare_line(int16_t line)
 	dev_cfg->mask.dma.tx.channel->CR  |= (uint32_t)DMA_SxCR_EN;
 	dev_cfg->level.dma.tx.channel->CR |= (uint32_t)DMA_SxCR_EN;
 
+	dev_cfg->mask.regs->CR1  &= (uint16_t) ~ SPI_CR1_SSI;
+	dev_cfg->level.regs->CR1 &= (uint16_t) ~ SPI_CR1_SSI;
+}
+
+/**
+ * Prepare the system to watch for a Hsync pulse to trigger the pixel clock and clock out the next line
+ * Note: This function is called for every line (~13k times / s), so we use direct register access for
+ * efficiency
+ */
+static inline void prepare_line(int16_t line)
+{
+	TIM_ITConfig(dev_cfg->hsync_capture.timer, TIM_IT_Update, DISABLE);
+
 	// Advance line counter
 	active_line++;
 
-	dev_cfg->mask.regs->CR1  &= (uint16_t) ~ SPI_CR1_SSI;
-	dev_cfg->level.regs->CR1 &= (uint16_t) ~ SPI_CR1_SSI;
+	right_eye_next = (mode_3d != PIOS_VIDEO_3D_DISABLED);
+
+	load_line(line * BUFFER_WIDTH);
+}
+
+/**
+ * Clock out the line just sent again, for the right eye.  There's no hsync
+ * to start it, so the capture timer is started by hand; its update starts
+ * the pixel timer right_eye_x_shift pixels after the left eye finished.
+ */
+static inline void prepare_right_eye()
+{
+	load_line((active_line - 1) * BUFFER_WIDTH);
+
+	dev_cfg->hsync_capture.timer->ARR = right_eye_arr_value;
+	dev_cfg->hsync_capture.timer->CR1 |= TIM_CR1_CEN;
+}
+
+/**
+ * Set the pixel clock for the video system; twice as fast in 3D, so that
+ * each eye takes half the line
+ */
+static void set_pixel_clock()
+{
+	uint8_t period = pios_video_type_cfg_act->period;
+	uint8_t dc = pios_video_type_cfg_act->dc;
+
+	if (mode_3d != PIOS_VIDEO_3D_DISABLED) {
+		period /= 2;
+		dc /= 2;
+	}
+
+	if (dev_cfg->pixel_timer.timer == TIM9) { // XXX or other fast timers
+		dev_cfg->pixel_timer.timer->CCR1 = dc;
+		dev_cfg->pixel_timer.timer->ARR  = period - 1;
+	} else {
+		// Slower timers round the PAL 3D pixel down a little
+		dev_cfg->pixel_timer.timer->CCR1 = dc / 2;
+		dev_cfg->pixel_timer.timer->ARR  = period / 2 - 1;
+	}
 }
 
 
@@ -457,13 +541,7 @@ void PIOS_Video_Init(const struct pios_video_cfg *cfg)
 
 	TIM_OC1Init(cfg->pixel_timer.timer, (TIM_OCInitTypeDef*)&cfg->tim_oc_init);
 	TIM_OC1PreloadConfig(cfg->pixel_timer.timer, TIM_OCPreload_Enable);
-	if (dev_cfg->pixel_timer.timer == TIM9) { // XXX or other fast timers
-		TIM_SetCompare1(cfg->pixel_timer.timer, pios_video_type_cfg_act->dc);
-		TIM_SetAutoreload(cfg->pixel_timer.timer, pios_video_type_cfg_act->period - 1);
-	} else {
-		TIM_SetCompare1(cfg->pixel_timer.timer, pios_video_type_cfg_act->dc / 2);
-		TIM_SetAutoreload(cfg->pixel_timer.timer, pios_video_type_cfg_act->period / 2 - 1);
-	}
+	set_pixel_clock();
 	TIM_ARRPreloadConfig(cfg->pixel_timer.timer, ENABLE);
 	TIM_CtrlPWMOutputs(cfg->pixel_timer.timer, ENABLE);
 
@@ -589,9 +667,10 @@ void PIOS_Video_SetXScale(uint8_t x_scale)
 /**
 *  Set the 3D mode configuration
 */
-void PIOS_Video_Set3DConfig(enum pios_video_3d_mode mode, uint8_t right_eye_x_shift)
+void PIOS_Video_Set3DConfig(enum pios_video_3d_mode mode, uint8_t x_shift)
 {
-	// Not supported by this driver
-	return;
+	// Takes effect at the next vsync
+	right_eye_x_shift_new = x_shift;
+	mode_3d_new = mode;
 }
 #endif /* PIOS_INCLUDE_VIDEO */
@@ -99,7 +99,9 @@ const struct pios_video_type_boundary *pios_video_type_boundary_act = &pios_vide
 
 // Private variables
 static int16_t active_line = 0;
-static uint32_t buffer_offset;
+static int16_t field_lines;
+static const uint8_t *next_line;
+static uint16_t line_length;
 static int8_t y_offset = 0;
 static const struct pios_video_cfg *dev_cfg = NULL;
 static uint16_t num_video_lines = 0;
@@ -154,7 +156,12 @@ bool PIOS_Vsync_ISR()
 
 	// Get ready for the first line. We will start outputting data at line zero.
 	active_line = 0 - (pios_video_type_cfg_act->graphics_line_start + y_offset);
-	buffer_offset = 0;
+
+	// Work out everything the line interrupts need now, so that they only
+	// have to load it into the DMA engine
+	field_lines = pios_video_type_cfg_act->graphics_height_real;
+	line_length = pios_video_type_cfg_act->dma_buffer_length;
+	next_line = disp_buffer;
 
 #if defined(PIOS_INCLUDE_FREERTOS)
 	/* Yield From ISR if needed */
@@ -169,31 +176,30 @@ bool PIOS_Hsync_ISR()
 
 	active_line++;
 
-	if ((active_line >= 0) && (active_line < pios_video_type_cfg_act->graphics_height_real)) {
-		// Check if QUADSPI is busy
-		if (QUADSPI->SR & 0x20)
-			goto exit;
-
-		// Disable DMA
-		dev_cfg->dma.tx.channel->CR &= ~(uint32_t)DMA_SxCR_EN;
+	if ((active_line >= 0) && (active_line < field_lines)) {
+		// If QUADSPI is still busy with the last line, skip this one, but
+		// move on anyway so that the lines after it don't shift down
+		if (!(QUADSPI->SR & 0x20)) {
+			// Disable DMA
+			dev_cfg->dma.tx.channel->CR &= ~(uint32_t)DMA_SxCR_EN;
 
-		// Clear the DMA interrupt flags
-		dev_cfg->pixel_dma->HIFCR  |= DMA_FLAG_TCIF7 | DMA_FLAG_HTIF7 | DMA_FLAG_FEIF7 | DMA_FLAG_TEIF7 | DMA_FLAG_DMEIF7;
+			// Clear the DMA interrupt flags
+			dev_cfg->pixel_dma->HIFCR  |= DMA_FLAG_TCIF7 | DMA_FLAG_HTIF7 | DMA_FLAG_FEIF7 | DMA_FLAG_TEIF7 | DMA_FLAG_DMEIF7;
 
-		// Load new line
-		dev_cfg->dma.tx.channel->M0AR = (uint32_t)&disp_buffer[buffer_offset];
+			// Load new line
+			dev_cfg->dma.tx.channel->M0AR = (uint32_t)next_line;
 
-		// Set length
-		dev_cfg->dma.tx.channel->NDTR = (uint16_t)pios_video_type_cfg_act->dma_buffer_length;
-		QUADSPI->DLR = (uint32_t)pios_video_type_cfg_act->dma_buffer_length - 1;
+			// Set length
+			dev_cfg->dma.tx.channel->NDTR = line_length;
+			QUADSPI->DLR = line_length - 1;
 
-		// Enable DMA
-		dev_cfg->dma.tx.channel->CR |= (uint32_t)DMA_SxCR_EN;
+			// Enable DMA
+			dev_cfg->dma.tx.channel->CR |= (uint32_t)DMA_SxCR_EN;
+		}
 
-		buffer_offset += BUFFER_WIDTH;
+		next_line += BUFFER_WIDTH;
 	}
 
-exit:
 #if defined(PIOS_INCLUDE_FREERTOS)
 	/* Yield From ISR if needed */
 	portEND_SWITCHING_ISR(woken == true ? pdTRUE : pdFALSE);
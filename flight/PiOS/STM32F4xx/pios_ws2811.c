@@ -86,6 +86,10 @@ struct ws2811_dev_s {
 	// And this gets fixed up to be a shifted right image, etc.
 	uint8_t gpio_bit;
 
+	// What each nibble of pixel data turns into in the DMA buffer: two
+	// words, four bits of falling edge bytes interleaved with gpio_bit.
+	uint32_t nibble_words[16][2];
+
 	bool cur_buf;
 	bool eof;
 
@@ -142,6 +146,19 @@ int PIOS_WS2811_init(ws2811_dev_t *dev_out, const struct pios_ws2811_cfg *cfg,
 			(dev->gpio_bit << 24);
 	}
 
+	for (int n = 0; n < 16; n++) {
+		for (int w = 0; w < 2; w++) {
+			// Bytes are little endian; the first bit is the top one
+			uint8_t first = (n & (0x8 >> (w * 2))) ? 0 : dev->gpio_bit;
+			uint8_t second = (n & (0x4 >> (w * 2))) ? 0 : dev->gpio_bit;
+
+			dev->nibble_words[n][w] = first |
+				(dev->gpio_bit << 8) |
+				(second << 16) |
+				(dev->gpio_bit << 24);
+		}
+	}
+
 	dev->lame_dma_buf[0] = (dev->gpio_bit) |
 		(dev->gpio_bit << 8) |
 		(dev->gpio_bit << 16) |
@@ -195,8 +212,8 @@ DONT_BUILD_IF((WS2811_DMA_BUFSIZE % 16) != 0, DMABufIntegralBytes);
 
 // Updates pixel_data_ptr to where we are.  returns true if we've reached
 // the end.
-static bool fill_dma_buf(uint8_t * restrict dma_buf, uint8_t **pixel_data_ptr,
-		uint8_t *pixel_data_end, uint8_t gpio_val) {
+static bool fill_dma_buf(uint32_t * restrict dma_buf, uint8_t **pixel_data_ptr,
+		uint8_t *pixel_data_end, const uint32_t (*nibble_words)[2]) {
 	// Our local shadow of this, for efficient blitting.
 	uint8_t * restrict p_d_p = *pixel_data_ptr;
 
@@ -206,26 +223,20 @@ static bool fill_dma_buf(uint8_t * restrict dma_buf, uint8_t **pixel_data_ptr,
 		return true;
 	}
 
-	for (int i = 0; i < WS2811_DMA_BUFSIZE; i += 16) {
+	// Each byte of pixel data is 16 bytes of DMA buffer; we clock out
+	// most significant bit first.
+	for (int i = 0; i < WS2811_DMA_BUFSIZE / 4; i += 4) {
 		if (p_d_p >= pixel_data_end) break;
 
 		uint8_t p = *(p_d_p++);
 
-		for (int j = 0; j < 8; j++) {
-			if (!(p & 0x80)) {
-				// It's zero-- therefore the pin has to fall
-				// early.
-				dma_buf[i + j*2] = gpio_val;
-			} else {
-				// It's one.  Therefore we let the prefilled
-				// bit in the odd position clear it; we do
-				// nothing.
-				dma_buf[i + j*2] = 0;
-			}
-
-			// We clock out most significant bit first.
-			p = p << 1;
-		}
+		const uint32_t *hi = nibble_words[p >> 4];
+		const uint32_t *lo = nibble_words[p & 0xf];
+
+		dma_buf[i] = hi[0];
+		dma_buf[i + 1] = hi[1];
+		dma_buf[i + 2] = lo[0];
+		dma_buf[i + 3] = lo[1];
 	}
 	*pixel_data_ptr = p_d_p;
 
@@ -330,11 +341,11 @@ void PIOS_WS2811_trigger_update(ws2811_dev_t dev)
 	// Current one to blit is the first
 	dev->cur_buf = false;
 
-	fill_dma_buf((uint8_t *) dev->dma_buf_0, &dev->pixel_data_pos,
-			dev->pixel_data_end, dev->gpio_bit);
+	fill_dma_buf(dev->dma_buf_0, &dev->pixel_data_pos,
+			dev->pixel_data_end, dev->nibble_words);
 
-	dev->eof = fill_dma_buf((uint8_t *) dev->dma_buf_1, &dev->pixel_data_pos,
-			dev->pixel_data_end, dev->gpio_bit);
+	dev->eof = fill_dma_buf(dev->dma_buf_1, &dev->pixel_data_pos,
+			dev->pixel_data_end, dev->nibble_words);
 
 	ws2811_cue_dma(dev);
 }
@@ -383,11 +394,10 @@ void PIOS_WS2811_dma_interrupt_handler(ws2811_dev_t dev)
 	// If cur_buf is true, we're currently blitting 1, so we should
 	// be updating 0.
 
-	uint8_t *buf = (uint8_t *)
-		(dev->cur_buf ? dev->dma_buf_0 : dev->dma_buf_1);
+	uint32_t *buf = dev->cur_buf ? dev->dma_buf_0 : dev->dma_buf_1;
 
 	dev->eof = fill_dma_buf(buf, &dev->pixel_data_pos,
-			dev->pixel_data_end, dev->gpio_bit);
+			dev->pixel_data_end, dev->nibble_words);
 
 epilogue:
 	PIOS_IRQ_Epilogue();
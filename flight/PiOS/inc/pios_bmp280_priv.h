@@ -48,6 +48,8 @@ int32_t PIOS_BMP280_Init(const struct pios_bmp280_cfg *cfg, pios_i2c_t i2c_devic
 int32_t PIOS_BMP280_SPI_Init(const struct pios_bmp280_cfg *cfg, pios_spi_t spi_device,
 	uint32_t spi_slave);
 
+void PIOS_BMP280_SetOversampling(uint8_t oversampling);
+
 #endif /* PIOS_BMP280_PRIV_H */
 
 /**
@@ -54,6 +54,22 @@ int32_t PIOS_CAN_TxData(uintptr_t id, enum pios_can_messages, uint8_t *data);
 //! Get a queue to receive messages of a particular message ID
 struct pios_queue * PIOS_CAN_RegisterMessageQueue(uintptr_t id, enum pios_can_messages msg_id);
 
+/**
+ * Called from the receive ISR with each accepted frame that isn't the COM
+ * stream or one of the messages above.
+ * \return true if a higher priority task was woken
+ */
+typedef bool (*pios_can_frame_cb)(uintptr_t context, uint16_t std_id,
+		const uint8_t *data, uint8_t len);
+
+//! Accept only the given standard IDs (plus the driver's own), and hand them to cb
+int32_t PIOS_CAN_SetFilters(uintptr_t id, const uint16_t *std_ids,
+		uint8_t num_ids, pios_can_frame_cb cb, uintptr_t context);
+
+//! Transmit a raw frame with a particular standard ID
+int32_t PIOS_CAN_TxFrame(uintptr_t id, uint16_t std_id, const uint8_t *data,
+		uint8_t len);
+
 #endif /* PIOS_CAN_H */
 
 /**
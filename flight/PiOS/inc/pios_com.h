@@ -38,6 +38,12 @@ struct pios_com_driver;
 /** Opaque struct for device handles */
 struct pios_com_dev;
 
+//! One buffer of a PIOS_COM_SendBufferv
+struct pios_com_iovec {
+	const void *base;
+	uint16_t len;
+};
+
 typedef uint16_t (*pios_com_callback)(uintptr_t context, uint8_t * buf, uint16_t buf_len, uint16_t * headroom, bool * task_woken);
 
 struct pios_com_driver {
@@ -57,11 +63,16 @@ extern int32_t PIOS_COM_SendChar(uintptr_t com_id, char c);
 extern int32_t PIOS_COM_SendBufferNonBlocking(uintptr_t com_id, const uint8_t *buffer, uint16_t len);
 extern int32_t PIOS_COM_SendBufferStallTimeout(uintptr_t com_id, const uint8_t *buffer, uint16_t len, uint32_t max_ms);
 extern int32_t PIOS_COM_SendBuffer(uintptr_t com_id, const uint8_t *buffer, uint16_t len);
+extern int32_t PIOS_COM_SendBufferv(uintptr_t com_id, const struct pios_com_iovec *iov, uint8_t iovcnt, uint32_t max_ms);
+extern uint8_t *PIOS_COM_SendReserve(uintptr_t com_id, uint16_t len, uint32_t max_ms);
+extern int32_t PIOS_COM_SendCommit(uintptr_t com_id, uint16_t len);
 extern int32_t PIOS_COM_SendStringNonBlocking(uintptr_t com_id, const char *str);
 extern int32_t PIOS_COM_SendString(uintptr_t com_id, const char *str);
 extern int32_t PIOS_COM_SendFormattedStringNonBlocking(uintptr_t com_id, const char *format, ...);
 extern int32_t PIOS_COM_SendFormattedString(uintptr_t com_id, const char *format, ...);
 extern uint16_t PIOS_COM_ReceiveBuffer(uintptr_t com_id, uint8_t * buf, uint16_t buf_len, uint32_t timeout_ms);
+extern uint16_t PIOS_COM_ReceiveSpan(uintptr_t com_id, const uint8_t **span, uint32_t timeout_ms);
+extern void PIOS_COM_ReceiveSpanDone(uintptr_t com_id, uint16_t len);
 extern bool PIOS_COM_Available(uintptr_t com_id);
 uint16_t PIOS_COM_GetNumReceiveBytesPending(uintptr_t com_id);
 
@@ -27,9 +27,17 @@
  */
 
 #include <stdint.h>
+#include <stdbool.h>
 
 uint8_t PIOS_CRC_updateByte(uint8_t crc, const uint8_t data);
 uint8_t PIOS_CRC_updateCRC(uint8_t crc, const uint8_t* data, int32_t length);
+#if defined(PIOS_INCLUDE_CRC_HW)
+/* Minimum run length worth handing to the CRC unit */
+#define PIOS_CRC_HW_MIN_LENGTH 8
+
+bool PIOS_CRC_HW_updateCRC(uint8_t *crc, const uint8_t *data, int32_t length);
+#endif
+
 uint8_t PIOS_CRC_updateCRC_TBS(uint8_t crc, const uint8_t *data, int32_t length);
 
 uint16_t PIOS_CRC16_updateByte(uint16_t crc, const uint8_t data);
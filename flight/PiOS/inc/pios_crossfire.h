@@ -52,12 +52,14 @@
 // Frame types.
 #define CRSF_FRAME_GPS				0x02
 #define CRSF_FRAME_BATTERY			0x08
+#define CRSF_FRAME_LINKSTATISTICS	0x14
 #define CRSF_FRAME_RCCHANNELS		0x16
 #define CRSF_FRAME_ATTITUDE			0x1e
 
 // Payload sizes
 #define CRSF_PAYLOAD_GPS			15
 #define CRSF_PAYLOAD_BATTERY		8
+#define CRSF_PAYLOAD_LINKSTATISTICS	10
 #define CRSF_PAYLOAD_RCCHANNELS		22
 #define CRSF_PAYLOAD_ATTITUDE		6
 // Maximum payload in the protocol can be 32 bytes.
@@ -65,8 +67,25 @@
 #define CRSF_MAX_PAYLOAD			32
 
 
-#define CRSF_TIMING_MAXFRAME		1000
+// Frame period to assume until one has been measured, and the range of
+// periods that are believed when measured.
 #define CRSF_TIMING_FRAMEDISTANCE	4000
+#define CRSF_TIMING_MINPERIOD		1000
+#define CRSF_TIMING_MAXPERIOD		25000
+
+// Time on the wire per byte at 420kbaud with start and stop bits, rounded up.
+#define CRSF_TIMING_BYTE_US			24
+
+// Quiet time kept on either side of a telemetry frame.
+#define CRSF_TIMING_GUARD			200
+
+// A gap this long within a frame means the bytes so far were junk.
+#define CRSF_TIMING_INTERBYTE		300
+
+// RF modes as reported in the link statistics frame.
+#define CRSF_RFMODE_4HZ				0
+#define CRSF_RFMODE_50HZ			1
+#define CRSF_RFMODE_150HZ			2
 
 // We don't need those. Yet. More like a reference right now.
 struct crsf_payload_gps {
@@ -88,6 +107,21 @@ struct crsf_payload_battery {
 
 } __attribute__((packed));
 
+struct crsf_payload_linkstats {
+
+	uint8_t uplink_rssi_ant1;
+	uint8_t uplink_rssi_ant2;
+	uint8_t uplink_lq;
+	int8_t uplink_snr;
+	uint8_t active_antenna;
+	uint8_t rf_mode;
+	uint8_t uplink_tx_power;
+	uint8_t downlink_rssi;
+	uint8_t downlink_lq;
+	int8_t downlink_snr;
+
+} __attribute__((packed));
+
 struct crsf_payload_attitude {
 
 	int16_t pitch;
@@ -99,6 +133,7 @@ struct crsf_payload_attitude {
 union crsf_combo_payload {
 	struct crsf_payload_gps gps;
 	struct crsf_payload_battery battery;
+	struct crsf_payload_linkstats linkstats;
 	struct crsf_payload_attitude attitude;
 	uint8_t payload[CRSF_MAX_PAYLOAD + CRSF_CRC_LEN];
 };
@@ -43,6 +43,7 @@ enum pios_flash_partition_labels {
 extern int32_t PIOS_FLASH_find_partition_id(enum pios_flash_partition_labels label, uintptr_t *partition_id);
 extern uint16_t PIOS_FLASH_get_num_partitions(void);
 extern int32_t PIOS_FLASH_get_partition_size(uintptr_t partition_id, uint32_t *partition_size);
+extern int32_t PIOS_FLASH_get_sector_size(uintptr_t partition_id, uint32_t offset, uint32_t *sector_size);
 
 extern int32_t PIOS_FLASH_start_transaction(uintptr_t partition_id);
 extern int32_t PIOS_FLASH_end_transaction(uintptr_t partition_id);
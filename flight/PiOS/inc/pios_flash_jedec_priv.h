@@ -48,6 +48,9 @@ struct pios_flash_jedec_cfg {
 	uint8_t expect_memorytype;
 	uint8_t expect_capacity;
 	uint32_t sector_erase;
+	/* Read with FAST_READ (0x0B), for parts whose READ (0x03) isn't rated
+	 * for the bus clock */
+	bool fast_read;
 };
 
 int32_t PIOS_Flash_Jedec_Init(uintptr_t *flash_id, pios_spi_t spi_id, uint32_t slave_num, const struct pios_flash_jedec_cfg *cfg);
@@ -29,6 +29,7 @@
 
 #include <stdlib.h>		/* size_t */
 #include <stdbool.h>		/* bool */
+#include <stdint.h>		/* uint16_t */
 
 extern bool PIOS_heap_malloc_failed_p(void);
 
@@ -42,4 +43,20 @@ extern size_t PIOS_fastheap_get_free_size(void);
 extern void PIOS_heap_initialize_blocks(void);
 extern void PIOS_heap_increase_size(size_t bytes);
 
+//! Size classes of the block pools, 16 bytes up to 4KiB
+#define PIOS_POOL_NUM_CLASSES 9
+
+struct pios_pool_stats {
+	uint16_t block_size;	/* bytes in each block of the class */
+	uint16_t carved;	/* blocks taken from the heap so far */
+	uint16_t in_use;	/* blocks handed out and not yet freed */
+	uint16_t peak;		/* most blocks in use at once */
+	uint16_t failures;	/* allocations the heap couldn't satisfy */
+};
+
+extern void * PIOS_pool_malloc(size_t size);
+extern void PIOS_pool_free(void * buf);
+extern int32_t PIOS_pool_reserve(size_t size, uint16_t count);
+extern int32_t PIOS_pool_get_stats(uint8_t class_idx, struct pios_pool_stats *stats);
+
 #endif	/* PIOS_HEAP_H */
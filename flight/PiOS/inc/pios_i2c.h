@@ -47,10 +47,19 @@ struct pios_i2c_txn {
 
 typedef struct pios_i2c_adapter *pios_i2c_t;
 
+/**
+ * Completion of a transfer started with PIOS_I2C_Transfer_Callback, called
+ * from the I2C interrupt.
+ * \param[in] ctx the context given with the transfer
+ * \param[in] result 0 on success, -1 on bus error, -2 on timeout, -3 on NACK
+ * \param[out] woken set true if a higher priority task was woken
+ */
+typedef void (*pios_i2c_callback_t)(void *ctx, int32_t result, bool *woken);
+
 /* Public Functions */
 extern int32_t PIOS_I2C_CheckClear(pios_i2c_t i2c_id);
 extern int32_t PIOS_I2C_Transfer(pios_i2c_t i2c_id, const struct pios_i2c_txn txn_list[], uint32_t num_txns);
-extern int32_t PIOS_I2C_Transfer_Callback(pios_i2c_t i2c_id, const struct pios_i2c_txn txn_list[], uint32_t, void *callback);
+extern int32_t PIOS_I2C_Transfer_Callback(pios_i2c_t i2c_id, const struct pios_i2c_txn txn_list[], uint32_t num_txns, pios_i2c_callback_t callback, void *ctx);
 extern void PIOS_I2C_EV_IRQ_Handler(pios_i2c_t i2c_id);
 extern void PIOS_I2C_ER_IRQ_Handler(pios_i2c_t i2c_id);
 
@@ -46,6 +46,7 @@ typedef int32_t (*initcall_t)(void);
 typedef struct {
 	initcall_t fn_minit;
 	initcall_t fn_tinit;
+	const char *name;
 } initmodule_t;
 
 /* Init module section */
@@ -61,22 +62,36 @@ extern initmodule_t __module_initcall_start[], __module_initcall_end[];
 
 #define __define_module_initcall(level, ifn, sfn) \
 	static initmodule_t __initcall_##fn __attribute__((__used__)) \
-	__attribute__((__section__(".initcall." level))) = { .fn_minit = ifn, .fn_tinit = sfn };
+	__attribute__((__section__(".initcall." level))) = { .fn_minit = ifn, .fn_tinit = sfn, .name = #ifn };
 
 #define MODULE_HIPRI_INITCALL(ifn, sfn)		__define_module_initcall("a_module", ifn, sfn)
 #define MODULE_INITCALL(ifn, sfn)		__define_module_initcall("module", ifn, sfn)
 
+/* Each call is timed, and the results kept by PIOS_Modules_Profile* */
+#define MODULE_CALL_PROFILED(fn, call, start) {			\
+		uint32_t call_raw = PIOS_DELAY_GetRaw();		\
+		(fn->call)();						\
+		PIOS_Modules_ProfileInitcall(fn->name, start,		\
+				PIOS_DELAY_DiffuS(call_raw));		\
+	}
+
 #define MODULE_INITIALISE_ALL(wdgfn)  { \
+		uint32_t all_raw = PIOS_DELAY_GetRaw();			\
 		for (initmodule_t *fn = __module_initcall_start; fn < __module_initcall_end; fn++) { \
 			if (fn->fn_minit)				\
-				(fn->fn_minit)();			\
+				MODULE_CALL_PROFILED(fn, fn_minit, false); \
 			(wdgfn)();					\
 		}							\
+		PIOS_Modules_ProfileAll(false, PIOS_DELAY_DiffuS(all_raw)); \
 	}
 
-#define MODULE_TASKCREATE_ALL  { for (initmodule_t *fn = __module_initcall_start; fn < __module_initcall_end; fn++) \
-									if (fn->fn_tinit) \
-									   (fn->fn_tinit)(); }
+#define MODULE_TASKCREATE_ALL  { \
+		uint32_t all_raw = PIOS_DELAY_GetRaw();			\
+		for (initmodule_t *fn = __module_initcall_start; fn < __module_initcall_end; fn++) \
+			if (fn->fn_tinit)				\
+				MODULE_CALL_PROFILED(fn, fn_tinit, true); \
+		PIOS_Modules_ProfileAll(true, PIOS_DELAY_DiffuS(all_raw)); \
+	}
 
 #endif	/* PIOS_INITCALL_H */
 
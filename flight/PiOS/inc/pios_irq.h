@@ -38,7 +38,17 @@ extern int32_t PIOS_IRQ_Disable(void);
 extern int32_t PIOS_IRQ_Enable(void);
 extern bool PIOS_IRQ_InISR(void);
 
-#if defined(PIOS_INCLUDE_CHIBIOS)
+#if defined(PIOS_INCLUDE_CHIBIOS) && defined(DIAG_IRQS)
+//! Exception numbers tracked by the ISR accounting (16 core + 112 IRQs)
+#define PIOS_IRQ_NUM_VECTORS 128
+
+extern void PIOS_IRQ_Account_Enter(void);
+extern void PIOS_IRQ_Account_Exit(void);
+extern uint32_t PIOS_IRQ_Get_Runtime(uint32_t vector);
+
+#	define PIOS_IRQ_Prologue() CH_IRQ_PROLOGUE(); PIOS_IRQ_Account_Enter()
+#	define PIOS_IRQ_Epilogue() PIOS_IRQ_Account_Exit(); CH_IRQ_EPILOGUE()
+#elif defined(PIOS_INCLUDE_CHIBIOS)
 #	define PIOS_IRQ_Prologue() CH_IRQ_PROLOGUE()
 #	define PIOS_IRQ_Epilogue() CH_IRQ_EPILOGUE()
 #else
@@ -79,9 +79,16 @@ int PIOS_MAX7456_init (max7456_dev_t *dev_out,
 /**
  * @brief Clear the screen
  * @param[in] dev The max7456 device handle
+ * @note Like put and puts, this only changes the screen held in memory
  */
 void PIOS_MAX7456_clear (max7456_dev_t dev);
 
+/**
+ * @brief Sends the characters that changed since the last flush to the chip
+ * @param[in] dev The max7456 device handle
+ */
+void PIOS_MAX7456_flush (max7456_dev_t dev);
+
 /**
  * @brief Upload a character to the device
  * @param[in] dev The max7456 device handle
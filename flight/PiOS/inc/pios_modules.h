@@ -49,6 +49,22 @@ enum pios_modules {
 #ifndef PIOS_NO_MODULES
 void PIOS_Modules_Enable(enum pios_modules module);
 bool PIOS_Modules_IsEnabled(enum pios_modules module);
+
+//! Where boot time went, as recorded by the initcall macros
+struct pios_modules_boot_profile {
+	uint32_t board_init_us;
+	uint32_t module_init_us;
+	uint32_t task_create_us;
+	uint32_t slowest_init_us;
+	const char *slowest_init;
+	uint32_t slowest_start_us;
+	const char *slowest_start;
+};
+
+void PIOS_Modules_ProfileBoardInit(uint32_t us);
+void PIOS_Modules_ProfileInitcall(const char *name, bool start, uint32_t us);
+void PIOS_Modules_ProfileAll(bool start, uint32_t us);
+const struct pios_modules_boot_profile *PIOS_Modules_GetBootProfile(void);
 #else
 #define PIOS_Modules_Enable(x) do { (void) (x); } while (0)
 #endif
@@ -123,6 +123,9 @@ enum pios_mpu_accel_range {
 	PIOS_MPU_SCALE_16G = 0x18
 };
 
+//! Most samples batched per FIFO read
+#define PIOS_MPU_FIFO_MAX_BATCH 8
+
 enum pios_mpu_orientation { // clockwise rotation from board forward
 	PIOS_MPU_TOP_0DEG    = 0x00,
 	PIOS_MPU_TOP_90DEG   = 0x01,
@@ -140,6 +143,7 @@ struct pios_mpu_cfg {
 	uint16_t default_samplerate;
 	enum pios_mpu_orientation orientation;
 	bool skip_startup_irq_check;
+	uint8_t fifo_batch;		/* Samples to batch through the FIFO, 0 to read every sample */
 #ifdef PIOS_INCLUDE_MPU_MAG
 	bool use_internal_mag;		/* Flag to indicate whether or not to use the internal mag on MPU9x50 devices */
 #endif // PIOS_INCLUDE_MPU_MAG
@@ -191,6 +195,15 @@ void PIOS_MPU_SetAccelBandwidth(uint16_t bandwidth);
  */
 bool PIOS_MPU_IRQHandler(void);
 
+/**
+ * @brief Batches samples through the FIFO, waking the consumer and reading
+ * out the sensor once per batch. Needs SPI, and isn't available alongside
+ * the internal mag. The batch is limited to 2ms worth of samples.
+ * @param[in] samples Samples per batch, 0 or 1 to read every sample
+ * @returns 0 if successful
+ */
+int32_t PIOS_MPU_SetFIFOBatch(uint8_t samples);
+
 /**
  * @brief Which type of MPU was detected?
  */
@@ -55,6 +55,9 @@ struct pios_ms5611_cfg {
 int32_t PIOS_MS5611_Init(const struct pios_ms5611_cfg * cfg, pios_i2c_t i2c_device);
 int32_t PIOS_MS5611_SPI_Init(pios_spi_t spi_id, uint32_t slave_num, const struct pios_ms5611_cfg *cfg);
 
+void PIOS_MS5611_SetOversampling(enum pios_ms5611_osr oversampling);
+void PIOS_MS5611_SPI_SetOversampling(enum pios_ms5611_osr oversampling);
+
 #endif /* PIOS_MS5611_PRIV_H */
 
 /** 
@@ -61,7 +61,7 @@ bool PIOS_Mutex_Unlock(struct pios_mutex *mtx);
  * - semaphore
  * - non-recursive mutex
  *
- * Note that this implementation doesn't prevent priority inversion.
+ * Both kinds of mutex use priority inheritance on every backend.
  *
  * see FreeRTOS documentation for details: http://www.freertos.org/a00113.html
  * see ChibiOS documentation for details: http://chibios.sourceforge.net/html/group__synchronization.html
@@ -71,6 +71,25 @@ struct pios_recursive_mutex *PIOS_Recursive_Mutex_Create(void);
 bool PIOS_Recursive_Mutex_Lock(struct pios_recursive_mutex *mtx, uint32_t timeout_ms);
 bool PIOS_Recursive_Mutex_Unlock(struct pios_recursive_mutex *mtx);
 
+#if defined(DIAG_MUTEXES)
+/*
+ * Contention statistics kept for every mutex, built with DIAG_MUTEXES.
+ * Only locks that had to wait are counted; times are in PIOS_DELAY raw
+ * ticks (CPU cycles on STM32). The list is only ever prepended to, so it
+ * can be walked without locking.
+ */
+struct pios_mutex_stats {
+	const struct pios_mutex_stats *next;
+	uintptr_t creator;		/* return address of the create call */
+	uint32_t waits;
+	uint32_t wait_cycles;
+	uint32_t max_wait_cycles;
+	uintptr_t owner;		/* native handle of the holder last waited on */
+};
+
+const struct pios_mutex_stats *PIOS_Mutex_Stats_First(void);
+#endif /* DIAG_MUTEXES */
+
 #endif /* PIOS_MUTEX_H_ */
 
 /**
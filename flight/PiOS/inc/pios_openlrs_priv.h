@@ -201,6 +201,8 @@ struct pios_openlrs_dev {
 	// Variables from OpenLRS for radio control
 	uint8_t hopcount;
 	uint32_t lastPacketTimeUs;
+	// When the radio raised its packet-valid interrupt, from the ISR
+	volatile uint32_t rxPacketTimeUs;
 	uint32_t numberOfLostPackets;
 	uint16_t lastAFCCvalue;
 	uint32_t nextBeaconTimeMs;
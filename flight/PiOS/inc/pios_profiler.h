@@ -0,0 +1,51 @@
+/**
+ ******************************************************************************
+ * @addtogroup PIOS PIOS Core hardware abstraction layer
+ * @{
+ * @addtogroup PIOS_PROFILER Sampling profiler
+ * @{
+ *
+ * @file       pios_profiler.h
+ * @author     dRonin, http://dronin.org, Copyright (C) 2017
+ * @brief      Sampling PC profiler driven by the system tick
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef PIOS_PROFILER_H
+#define PIOS_PROFILER_H
+
+#include <stdint.h>
+
+//! Number of program counter samples kept in the ring
+#define PIOS_PROFILER_NUM_SAMPLES 1024
+
+//! Sample value recorded when the tick interrupted another handler
+#define PIOS_PROFILER_SAMPLE_IN_ISR 0xFFFFFFFF
+
+//! UAVTalk file id the sample ring is served under
+#define PIOS_PROFILER_FILE_ID 0x80
+
+extern void PIOS_Profiler_Sample(void);
+extern int32_t PIOS_Profiler_Read(uint8_t *buf, uint32_t offset, uint32_t len);
+
+#endif /* PIOS_PROFILER_H */
+
+/**
+ * @}
+ * @}
+ */
@@ -33,13 +33,18 @@
 struct pios_rcvr_driver {
 	void    (*init)(uintptr_t id);
 	int32_t (*read)(uintptr_t id, uint8_t channel);
+	/* Optional: the first num_channels channels in one go, channel 0
+	 * first; returns how many were filled in, or an error */
+	int32_t (*read_all)(uintptr_t id, int32_t *channels, uint8_t num_channels);
 };
 
 /* Public Functions */
 int32_t PIOS_RCVR_Read(uintptr_t rcvr_id, uint8_t channel);
+int32_t PIOS_RCVR_ReadAll(uintptr_t rcvr_id, int32_t *channels, uint8_t num_channels);
 bool PIOS_RCVR_WaitActivity(uint32_t timeout_ms);
 void PIOS_RCVR_Active();
 void PIOS_RCVR_ActiveFromISR();
+uint32_t PIOS_RCVR_GetFrameAge();
 uintptr_t PIOS_RCVR_GetLowerDevice(uintptr_t rcvr_id);
 
 /*! Define error codes for PIOS_RCVR_Get */
@@ -0,0 +1,79 @@
+/**
+ ******************************************************************************
+ * @addtogroup PIOS PIOS Core hardware abstraction layer
+ * @{
+ * @addtogroup PIOS_SENSORREPLAY Sensor replay
+ * @{
+ *
+ * @file       pios_sensorreplay.h
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2017
+ * @brief      Feeds recorded sensor samples back into the sensor queues
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef PIOS_SENSORREPLAY_H
+#define PIOS_SENSORREPLAY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Replay format, little endian (python/dronin-sensorreplay writes it from
+ * UAVTalk and blackbox logs):
+ *
+ *   header: magic(4) = "SRP1", max_gyro(2) in deg/s, reserved(2),
+ *           sample_rate(2) in Hz for each of accel, gyro, mag and baro
+ *           (0 if the recording has none)
+ *   record: time(4) in us, type(1) as in enum pios_sensor_type, then the
+ *           matching struct pios_sensor_*_data as packed floats
+ *
+ * Records come in time order.  Each is sent on to PIOS_SENSORS when its
+ * time comes around, measured from the first record.
+ */
+
+#define PIOS_SENSORREPLAY_MAGIC		0x31505253	/* "SRP1" */
+
+struct pios_sensorreplay_header {
+	uint32_t magic;
+	uint16_t max_gyro;
+	uint16_t reserved;
+	uint16_t sample_rate[4];
+} __attribute__((packed));
+
+struct pios_sensorreplay_record {
+	uint32_t time_us;
+	uint8_t type;
+} __attribute__((packed));
+
+//! Reads len bytes of the recording, returning how many it got
+typedef int32_t (*pios_sensorreplay_read_t)(void *ctx, uint8_t *buf,
+		uint32_t len);
+
+typedef struct pios_sensorreplay_dev *pios_sensorreplay_t;
+
+int32_t PIOS_SENSORREPLAY_Init(pios_sensorreplay_t *dev,
+		pios_sensorreplay_read_t read_cb, void *ctx);
+uint32_t PIOS_SENSORREPLAY_GetDropped(pios_sensorreplay_t dev);
+bool PIOS_SENSORREPLAY_IsFinished(pios_sensorreplay_t dev);
+
+#endif /* PIOS_SENSORREPLAY_H */
+
+/**
+ * @}
+ * @}
+ */
@@ -32,7 +32,7 @@
 
 #include "pios.h"
 #include "stdint.h"
-#include "pios_queue.h"
+#include "pios_spsc_queue.h"
 
 //! Pios sensor structure for generic gyro data
 struct pios_sensor_gyro_data {
@@ -97,22 +97,74 @@ enum pios_sensor_type
 typedef bool (*PIOS_SENSOR_Callback_t)(void *ctx, void *output,
 		int ms_to_wait, int *next_call);
 
+//! Function that calls into sensor to get up to max_samples samples at
+//! once, oldest first, with their times in microseconds if timestamps is
+//! given. Returns the number of samples.
+typedef int (*PIOS_SENSOR_BatchCallback_t)(void *ctx, void *output,
+		uint32_t *timestamps, int max_samples, int ms_to_wait);
+
+//! Function that has a ring-based sensor produce samples, waiting up to
+//! ms_to_wait for them.
+typedef bool (*PIOS_SENSOR_FillCallback_t)(void *ctx, int ms_to_wait);
+
 //! Initialize the PIOS_SENSORS interface
 int32_t PIOS_SENSORS_Init();
 
-//! Register a queue-based sensor with the PIOS_SENSORS interface
-int32_t PIOS_SENSORS_Register(enum pios_sensor_type type, struct pios_queue *queue);
+//! Register a queue-based sensor with the PIOS_SENSORS interface.  The
+//! driver is the only sender; PIOS_SENSORS is the only receiver.
+int32_t PIOS_SENSORS_Register(enum pios_sensor_type type, struct pios_spsc_queue *queue);
 
 //! Register a callback-based sensor with the PIOS_SENSORS interface
 int32_t PIOS_SENSORS_RegisterCallback(enum pios_sensor_type type,
 		PIOS_SENSOR_Callback_t callback, void *ctx);
 
+//! Register a batch callback, alongside the regular one, for a sensor type
+int32_t PIOS_SENSORS_RegisterBatchCallback(enum pios_sensor_type type,
+		PIOS_SENSOR_BatchCallback_t callback, void *ctx);
+
+/* Sample rings. The driver writes each sample straight into a slot and
+ * publishes it by bumping the sequence counter; consumers read slots in
+ * place by sequence number, and check afterwards that the slot wasn't
+ * reused meanwhile. GetData/GetDataBatch keep working on ring sensors. */
+
+//! Register a ring-based sensor with the PIOS_SENSORS interface
+int32_t PIOS_SENSORS_RegisterRing(enum pios_sensor_type type,
+		uint16_t sample_size, uint16_t num_slots,
+		PIOS_SENSOR_FillCallback_t fill_cb, void *ctx);
+
+//! Checks if a sensor type delivers samples through a ring
+bool PIOS_SENSORS_HasRing(enum pios_sensor_type type);
+
+//! Get the slot for the next sample, to fill in place
+void *PIOS_SENSORS_RingNext(enum pios_sensor_type type, uint32_t timestamp);
+
+//! Publish the sample filled in since PIOS_SENSORS_RingNext()
+void PIOS_SENSORS_RingPublish(enum pios_sensor_type type);
+
+//! Wait for samples newer than seq, returns the sequence after the newest
+uint32_t PIOS_SENSORS_RingWait(enum pios_sensor_type type, uint32_t seq,
+		int ms_to_wait);
+
+//! Get a sample in place, or NULL if it's gone or not there yet
+const void *PIOS_SENSORS_RingGet(enum pios_sensor_type type, uint32_t seq,
+		uint32_t *timestamp);
+
+//! Check a sample read in place wasn't overwritten meanwhile
+bool PIOS_SENSORS_RingValid(enum pios_sensor_type type, uint32_t seq);
+
+//! Skip seq forward to the oldest sample still in the ring
+uint32_t PIOS_SENSORS_RingOldest(enum pios_sensor_type type, uint32_t seq);
+
 //! Checks if a sensor type is registered with the PIOS_SENSORS interface
 bool PIOS_SENSORS_IsRegistered(enum pios_sensor_type type);
 
 //! Get the data for a sensor type
 bool PIOS_SENSORS_GetData(enum pios_sensor_type type, void *buf, int ms_to_wait);
 
+//! Get a block of samples for a sensor type, returns how many
+int PIOS_SENSORS_GetDataBatch(enum pios_sensor_type type, void *buf,
+		uint32_t *timestamps, int max_samples, int ms_to_wait);
+
 //! Set the maximum gyro rate in deg/s
 void PIOS_SENSORS_SetMaxGyro(int32_t rate);
 
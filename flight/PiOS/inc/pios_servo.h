@@ -35,10 +35,14 @@
 #define PIOS_SERVO_MAX_BANKS 8
 
 /* Used in out_rate.  If 65535, we really mean 65535Hz.  Values close to that
- * are reserved/abused for dshot support.  0 is used for sync pwm per legacy
+ * are reserved/abused for dshot and analog oneshot protocol support.  0 is
+ * used for sync pwm per legacy
  */
 enum pios_servo_shot_type {
 	SHOT_ONESHOT = 0,
+	SHOT_ONESHOT125 = 65529,
+	SHOT_ONESHOT42 = 65530,
+	SHOT_MULTISHOT = 65531,
 	SHOT_DSHOT300 = 65532,
 	SHOT_DSHOT600 = 65533,
 	SHOT_DSHOT1200 = 65534
@@ -71,6 +75,8 @@ extern void PIOS_Servo_PrepareForReset();
 extern void PIOS_Servo_Set(uint8_t servo, float position);
 extern void PIOS_Servo_Update(void);
 extern bool PIOS_Servo_IsDshot(uint8_t servo);
+extern void PIOS_Servo_SetDshotBidirectional(bool enable);
+extern bool PIOS_Servo_GetERPM(uint8_t servo, uint32_t *erpm);
 
 #endif /* PIOS_SERVO_H */
 
@@ -91,6 +91,17 @@ int32_t PIOS_SPI_TransferBlock(pios_spi_t spi_dev, const uint8_t *send_buffer, u
  */
 int32_t PIOS_SPI_ClaimBus(pios_spi_t spi_dev);
 
+/**
+ * Claim the SPI bus semaphore ahead of regular claims.  For the short,
+ * latency sensitive transactions, like gyro reads, on a bus shared with
+ * slower devices; a regular claim that is granted while one of these is
+ * waiting hands the bus over first.
+ * \param[in] spi_dev SPI handle
+ * \return 0 if no error
+ * \return -1 if timeout before claiming semaphore
+ */
+int32_t PIOS_SPI_ClaimBusPriority(pios_spi_t spi_dev);
+
 /**
  * Release the SPI bus semaphore.
  * \param[in] spi_dev SPI handle
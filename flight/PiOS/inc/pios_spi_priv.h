@@ -38,6 +38,8 @@
 struct pios_spi_dev {
 	const struct pios_spi_cfg *cfg;
 	struct pios_semaphore *busy;
+	//! Claims from PIOS_SPI_ClaimBusPriority() not yet granted
+	volatile uint8_t priority_waiting;
 };
 
 struct pios_spi_cfg {
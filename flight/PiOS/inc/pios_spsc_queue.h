@@ -0,0 +1,69 @@
+/**
+ ******************************************************************************
+ * @file       pios_spsc_queue.h
+ * @author     dRonin, http://dronin.org Copyright (C) 2017
+ * @addtogroup PIOS PIOS Core hardware abstraction layer
+ * @{
+ * @addtogroup PIOS_SPSC_Queue Single producer, single consumer queue
+ * @{
+ * @brief Lock-free queue with wakeups only when the other side waits
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef PIOS_SPSC_QUEUE_H_
+#define PIOS_SPSC_QUEUE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * A circqueue with blocking on top, for one writer and one reader, either
+ * of which may be an ISR.  Items move without taking any lock.  A side
+ * that blocks raises a flag first, and the other side only signals the
+ * semaphore when that flag is up and enough items (or space) are there,
+ * so the common case of nobody waiting costs no RTOS call at all.
+ *
+ * Unlike PIOS_Queue, there may be only one sending and one receiving
+ * context for a given queue.
+ */
+
+struct pios_spsc_queue;
+
+struct pios_spsc_queue *PIOS_SPSC_Queue_Create(uint16_t item_size,
+		uint16_t queue_length, uint16_t wake_threshold);
+uint16_t PIOS_SPSC_Queue_Send(struct pios_spsc_queue *q, const void *items,
+		uint16_t num, bool *wokenp);
+uint16_t PIOS_SPSC_Queue_Receive(struct pios_spsc_queue *q, void *items,
+		uint16_t max_items, uint32_t timeout_ms, bool *wokenp);
+void *PIOS_SPSC_Queue_Reserve(struct pios_spsc_queue *q, uint16_t *num);
+void PIOS_SPSC_Queue_Commit(struct pios_spsc_queue *q, uint16_t num,
+		bool *wokenp);
+void *PIOS_SPSC_Queue_Peek(struct pios_spsc_queue *q, uint16_t *num,
+		uint32_t timeout_ms);
+void PIOS_SPSC_Queue_Consume(struct pios_spsc_queue *q, uint16_t num,
+		bool *wokenp);
+bool PIOS_SPSC_Queue_WaitSpace(struct pios_spsc_queue *q, uint16_t num,
+		uint32_t timeout_ms);
+uint16_t PIOS_SPSC_Queue_Pending(struct pios_spsc_queue *q);
+uint16_t PIOS_SPSC_Queue_Space(struct pios_spsc_queue *q);
+void PIOS_SPSC_Queue_Clear(struct pios_spsc_queue *q);
+
+#endif /* PIOS_SPSC_QUEUE_H_ */
+
+/**
+  * @}
+  * @}
+  */
@@ -28,7 +28,9 @@
 #define PIOS_SRXL_H
 
 #include <pios.h>
+#ifndef FLIGHT_POSIX
 #include <pios_usart_priv.h>
+#endif
 
 #define PIOS_SRXL_MAX_CHANNELS 16
 
@@ -37,6 +37,8 @@ int32_t PIOS_STREAMFS_MinFileId(uintptr_t fs_id);
 int32_t PIOS_STREAMFS_MaxFileId(uintptr_t fs_id);
 int32_t PIOS_STREAMFS_Close(uintptr_t fs_id);
 int32_t PIOS_STREAMFS_Read(uintptr_t fs_id, uint8_t *data, uint32_t len);
+int32_t PIOS_STREAMFS_Seek(uintptr_t fs_id, uint32_t offset);
+int32_t PIOS_STREAMFS_FileSize(uintptr_t fs_id);
 
 
 #endif	/* PIOS_FLASHFS_STREAMFS_H_ */
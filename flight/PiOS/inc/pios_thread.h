@@ -75,6 +75,8 @@ void PIOS_Thread_Sleep(uint32_t time_ms);
 void PIOS_Thread_Sleep_Until(uint32_t *previous_ms, uint32_t increment_ms);
 uint32_t PIOS_Thread_Get_Stack_Usage(struct pios_thread *threadp);
 uint32_t PIOS_Thread_Get_Runtime(struct pios_thread *threadp);
+uint32_t PIOS_Thread_Get_Idle_Runtime(void);
+bool PIOS_Thread_Is_Native(struct pios_thread *threadp, uintptr_t native);
 void PIOS_Thread_Scheduler_Suspend(void);
 void PIOS_Thread_Scheduler_Resume(void);
 
@@ -95,6 +97,12 @@ void PIOS_Thread_ChangePriority(enum pios_thread_prio_e prio);
 void PIOS_Thread_FakeClock_Tick(void);
 bool PIOS_Thread_FakeClock_IsActive(void);
 void PIOS_Thread_FakeClock_UpdateBarrier(uint32_t increment);
+void PIOS_Thread_FakeClock_Lockstep(uint32_t exit_after_ms);
+bool PIOS_Thread_FakeClock_IsLockstep(void);
+void PIOS_Thread_FakeClock_Park(void);
+void PIOS_Thread_FakeClock_Unpark(void);
+void PIOS_Thread_RecordJitter(const char *name, uint32_t period_us,
+		uint32_t expected_us);
 #endif
 
 #endif /* PIOS_THREAD_H_ */
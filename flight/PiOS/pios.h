@@ -87,6 +87,9 @@
 #include <pios_delay.h>
 #include <pios_annunc.h>
 #include <pios_irq.h>
+#if defined(DIAG_PROFILE)
+#include <pios_profiler.h>
+#endif
 #include <pios_adc.h>
 #include <pios_internal_adc.h>
 #include <pios_servo.h>
@@ -177,6 +180,10 @@
 #include <pios_crossfire.h>
 #endif
 
+#if defined(PIOS_INCLUDE_SENSORREPLAY)
+#include <pios_sensorreplay.h>
+#endif
+
 #if defined(PIOS_INCLUDE_MAX7456)
 #include <pios_max7456.h>
 #endif
@@ -3,6 +3,7 @@ SRC += pios_exti.c
 SRC += pios_uavtalkrcvr.c
 SRC += pios_crc.c
 SRC += pios_com.c
+SRC += pios_spsc_queue.c
 SRC += pios_dsm.c
 SRC += pios_rcvr.c
 SRC += pios_hsum.c
@@ -16,6 +17,7 @@ SRC += pios_usb_desc_hid_only.c
 SRC += pios_usb_util.c
 SRC += pios_adc.c
 SRC += pios_heap.c
+SRC += pios_heap_pool.c
 SRC += pios_semaphore.c
 SRC += pios_mutex.c
 SRC += pios_queue.c
@@ -28,6 +30,7 @@ SRC += pios_srxl.c
 SRC += pios_ibus.c
 SRC += pios_spi.c
 SRC += pios_irq.c
+SRC += pios_profiler.c
 SRC += pios_pwm.c
 SRC += pios_ppm.c
 SRC += pios_debug.c
@@ -1,8 +1,38 @@
 #include <stdint.h>
 
+/* How long a flash part takes for things, so that filesystem work can be
+ * measured without the hardware.  Without it, every operation is free. */
+struct pios_flash_posix_timing {
+	const char *name;
+	uint32_t spi_clock_hz;		/* Bus clock for commands and data */
+	uint16_t page_size;		/* Programs can't cross these */
+	uint32_t page_program_us;	/* tPP, per page programmed */
+	uint32_t sector_erase_us;	/* tSE, for size_of_sector */
+	bool realtime;			/* Also wait that long for real */
+};
+
+/* Typical figures from the datasheets of the parts on our boards */
+extern const struct pios_flash_posix_timing pios_flash_posix_timing_m25p16;
+extern const struct pios_flash_posix_timing pios_flash_posix_timing_mx25l32;
+extern const struct pios_flash_posix_timing pios_flash_posix_timing_s25fl127;
+
 struct pios_flash_posix_cfg {
 	uint32_t size_of_flash;
 	uint32_t size_of_sector;
+	const struct pios_flash_posix_timing *timing;
+};
+
+struct pios_flash_posix_stats {
+	uint64_t busy_ns;		/* Time the part spent on operations */
+	uint64_t max_op_ns;		/* Longest single operation */
+	uint32_t reads;
+	uint32_t bytes_read;
+	uint32_t page_programs;
+	uint32_t bytes_written;
+	uint32_t erases;
+	uint32_t min_sector_erases;	/* Wear of the least and most */
+	uint32_t max_sector_erases;	/* erased sectors */
+	uint32_t bad_programs;		/* Writes that set 0 bits back to 1 */
 };
 
 int32_t PIOS_Flash_Posix_Init(uintptr_t * chip_id,
@@ -10,5 +40,8 @@ int32_t PIOS_Flash_Posix_Init(uintptr_t * chip_id,
 		bool force_recreate);
 void PIOS_Flash_Posix_Destroy(uintptr_t chip_id);
 void PIOS_Flash_Posix_SetFName(const char *name);
+void PIOS_Flash_Posix_GetStats(uintptr_t chip_id,
+		struct pios_flash_posix_stats *stats);
+void PIOS_Flash_Posix_ResetStats(uintptr_t chip_id);
 
 extern const struct pios_flash_driver pios_posix_flash_driver;
@@ -36,6 +36,7 @@ typedef int32_t (*initcall_t)(void);
 typedef struct {
 	initcall_t fn_minit;
 	initcall_t fn_tinit;
+	const char *name;
 } initmodule_t;
 
 /* Init module section */
@@ -48,6 +49,7 @@ static void _add_init_fn(void) __attribute__((constructor)); \
 static void _add_init_fn(void) { \
 	__module_initcall_end->fn_minit = (ifn); \
 	__module_initcall_end->fn_tinit = (sfn); \
+	__module_initcall_end->name = #ifn; \
 	__module_initcall_end++; \
 }
 
@@ -56,6 +58,7 @@ static void _add_init_fn(void) __attribute__((constructor)); \
 static void _add_init_fn(void) { \
 	__module_hipriinitcall_end->fn_minit = (ifn); \
 	__module_hipriinitcall_end->fn_tinit = (sfn); \
+	__module_hipriinitcall_end->name = #ifn; \
 	__module_hipriinitcall_end++; \
 }
 
@@ -67,28 +70,40 @@ initmodule_t *__module_initcall_end = __module_initcalls; \
 initmodule_t *__module_hipriinitcall_start = __module_hipriinitcalls; \
 initmodule_t *__module_hipriinitcall_end = __module_hipriinitcalls;
 
+/* Each call is timed, and the results kept by PIOS_Modules_Profile* */
+#define MODULE_CALL_PROFILED(fn, call, start) {                 \
+	uint32_t call_raw = PIOS_DELAY_GetRaw();                \
+	(fn->call)();                                           \
+	PIOS_Modules_ProfileInitcall(fn->name, start,           \
+			PIOS_DELAY_DiffuS(call_raw));           \
+}
+
 #define MODULE_INITIALISE_ALL(wdgfn)  { \
+	uint32_t all_raw = PIOS_DELAY_GetRaw();                 \
 	for (initmodule_t *fn = __module_hipriinitcall_start; fn < __module_hipriinitcall_end; fn++) { \
 		if (fn->fn_minit)                               \
-		(fn->fn_minit)();                               \
+			MODULE_CALL_PROFILED(fn, fn_minit, false); \
 		(wdgfn)();                                      \
 	} ;                                                     \
 	for (initmodule_t *fn = __module_initcall_start; fn < __module_initcall_end; fn++) { \
 		if (fn->fn_minit)                               \
-		(fn->fn_minit)();                               \
+			MODULE_CALL_PROFILED(fn, fn_minit, false); \
 		(wdgfn)();                                      \
 	}                                                       \
+	PIOS_Modules_ProfileAll(false, PIOS_DELAY_DiffuS(all_raw)); \
 }
 
 #define MODULE_TASKCREATE_ALL { \
+	uint32_t all_raw = PIOS_DELAY_GetRaw();                 \
 	for (initmodule_t *fn = __module_hipriinitcall_start; fn < __module_hipriinitcall_end; fn++) { \
 		if (fn->fn_tinit)                              \
-			(fn->fn_tinit)();                      \
+			MODULE_CALL_PROFILED(fn, fn_tinit, true); \
 	}                                                      \
 	for (initmodule_t *fn = __module_initcall_start; fn < __module_initcall_end; fn++) { \
 		if (fn->fn_tinit)                              \
-			(fn->fn_tinit)();                      \
+			MODULE_CALL_PROFILED(fn, fn_tinit, true); \
 	}                                                      \
+	PIOS_Modules_ProfileAll(true, PIOS_DELAY_DiffuS(all_raw)); \
 }
 
 
@@ -0,0 +1,48 @@
+/**
+ ******************************************************************************
+ *
+ * @file       pios_reactor.h
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2017
+ * @brief      One thread waiting on the file descriptors of the posix drivers.
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef PIOS_REACTOR_H
+#define PIOS_REACTOR_H
+
+#include <pios.h>
+
+/* Most descriptors watched at once */
+#define PIOS_REACTOR_MAX_FDS	16
+
+/**
+ * Called on the reactor thread when the descriptor is readable.  It should
+ * do at most one read, so as not to block the other devices.
+ * \return true when everything read has been handed on; false when some of
+ * it is still held because the consumer is full.  The descriptor isn't
+ * watched until the callback catches up, and meanwhile the callback is
+ * retried every PIOS_REACTOR_RETRY_MS.
+ */
+typedef bool (*pios_reactor_cb)(uintptr_t context);
+
+#define PIOS_REACTOR_RETRY_MS	2
+
+extern int32_t PIOS_Reactor_Add(int fd, pios_reactor_cb cb, uintptr_t context);
+extern int32_t PIOS_Reactor_Remove(int fd);
+
+#endif /* PIOS_REACTOR_H */
@@ -0,0 +1,71 @@
+/**
+ ******************************************************************************
+ *
+ * @file       pios_shm_priv.h
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2017
+ * @brief      Shared memory COM driver private definitions.
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef PIOS_SHM_PRIV_H
+#define PIOS_SHM_PRIV_H
+
+#include <pios.h>
+
+/*
+ * Layout of the shared file, as seen by the tools on the other side
+ * (python/dronin/telemetry.py and the GCS shmconnection plugin).  All
+ * fields are little endian, as on every host flightd runs on.
+ *
+ *   0  magic         PIOS_SHM_MAGIC, written last once the rings are ready
+ *   4  ring_size     bytes of data in each ring, a power of two
+ *   8  dropped       bytes flightd threw away because to_host was full
+ *  12  reserved
+ *  16  to_host ring  flightd writes, the host reads
+ *   .. to_fc ring    the host writes, flightd reads
+ *
+ * Each ring is a head, a tail, then ring_size bytes of data.  Head and tail
+ * are free-running byte counts; only the writer moves head and only the
+ * reader moves tail, so neither side needs a lock.  The writer stores the
+ * data before publishing the new head, and the reader is done with the data
+ * before it publishes the new tail.
+ */
+#define PIOS_SHM_MAGIC		0x4d485344	/* "DSHM" */
+#define PIOS_SHM_RING_SIZE	65536
+
+struct pios_shm_ring {
+	uint32_t head;
+	uint32_t tail;
+	uint8_t data[PIOS_SHM_RING_SIZE];
+};
+
+struct pios_shm_region {
+	uint32_t magic;
+	uint32_t ring_size;
+	uint32_t dropped;
+	uint32_t reserved;
+
+	struct pios_shm_ring to_host;
+	struct pios_shm_ring to_fc;
+};
+
+extern const struct pios_com_driver pios_shm_com_driver;
+
+extern int32_t PIOS_SHM_Init(uintptr_t *shm_id, const char *path);
+
+#endif /* PIOS_SHM_PRIV_H */
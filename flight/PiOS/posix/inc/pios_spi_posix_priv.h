@@ -12,4 +12,11 @@ struct pios_spi_cfg {
 	char base_path[PATH_MAX];
 };
 
+/* Selects the slave, exchanges len bytes and deselects it again in a single
+ * spidev call, rather than the three that RC_PinSet/TransferBlock/RC_PinSet
+ * take.  The bus must already be claimed. */
+int32_t PIOS_SPI_TransferSelected(pios_spi_t spi_dev, uint32_t slave_id,
+		const uint8_t *send_buffer, uint8_t *receive_buffer,
+		uint16_t len);
+
 #endif /* PIOS_SPI_POSIX_PRIV_H */
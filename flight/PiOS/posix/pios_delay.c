@@ -30,6 +30,10 @@
 
 /* Project Includes */
 #include "pios.h"
+
+/* From pios_thread.c, which unit tests using delays don't link */
+extern bool PIOS_Thread_FakeClock_IsLockstep(void) __attribute__((weak));
+extern uint32_t PIOS_Thread_Systime(void) __attribute__((weak));
 #include "time.h"
 
 #include <time.h>
@@ -152,6 +156,13 @@ int32_t PIOS_DELAY_WaitmS(uint32_t mS)
 
 uint32_t PIOS_DELAY_GetRaw()
 {
+	/* Lockstep runs faster than real time; follow the simulated clock
+	 * so that measured intervals agree with it. */
+	if (PIOS_Thread_FakeClock_IsLockstep &&
+			PIOS_Thread_FakeClock_IsLockstep()) {
+		return PIOS_Thread_Systime() * 1000;
+	}
+
 	uint32_t raw_us = get_monotonic_us_time() - base_time;
 	return raw_us;
 }
@@ -8,6 +8,7 @@
 #include "pios_flash_posix_priv.h"
 
 #include <pios_semaphore.h>
+#include <pios_delay.h>
 
 enum flash_posix_magic {
 	FLASH_POSIX_MAGIC = 0x321dabc1,
@@ -19,6 +20,33 @@ struct flash_posix_dev {
 	FILE * flash_file;
 
 	struct pios_semaphore *transaction_lock;
+
+	struct pios_flash_posix_stats stats;
+	uint32_t *sector_erases;
+};
+
+const struct pios_flash_posix_timing pios_flash_posix_timing_m25p16 = {
+	.name            = "M25P16",
+	.spi_clock_hz    = 20000000,
+	.page_size       = 256,
+	.page_program_us = 640,
+	.sector_erase_us = 600000,	/* 64KB */
+};
+
+const struct pios_flash_posix_timing pios_flash_posix_timing_mx25l32 = {
+	.name            = "MX25L3206E",
+	.spi_clock_hz    = 20000000,
+	.page_size       = 256,
+	.page_program_us = 1400,
+	.sector_erase_us = 60000,	/* 4KB */
+};
+
+const struct pios_flash_posix_timing pios_flash_posix_timing_s25fl127 = {
+	.name            = "S25FL127S",
+	.spi_clock_hz    = 20000000,
+	.page_size       = 256,
+	.page_program_us = 250,
+	.sector_erase_us = 130000,	/* 64KB */
 };
 
 static struct flash_posix_dev * PIOS_Flash_Posix_Alloc(void)
@@ -88,6 +116,12 @@ int32_t PIOS_Flash_Posix_Init(uintptr_t * chip_id,
 
 	flash_dev->transaction_lock = PIOS_Semaphore_Create();
 
+	flash_dev->sector_erases = PIOS_malloc(sizeof(uint32_t) *
+			(cfg->size_of_flash / cfg->size_of_sector));
+	assert(flash_dev->sector_erases);
+
+	PIOS_Flash_Posix_ResetStats((uintptr_t)flash_dev);
+
 	*chip_id = (uintptr_t)flash_dev;
 
 	return 0;
@@ -99,9 +133,64 @@ void PIOS_Flash_Posix_Destroy(uintptr_t chip_id)
 
 	fclose(flash_dev->flash_file);
 
+	PIOS_free(flash_dev->sector_erases);
 	PIOS_free(flash_dev);
 }
 
+/**
+ * Get what the flash has done since it was initialized, or since
+ * PIOS_Flash_Posix_ResetStats
+ */
+void PIOS_Flash_Posix_GetStats(uintptr_t chip_id,
+		struct pios_flash_posix_stats *stats)
+{
+	struct flash_posix_dev * flash_dev = (struct flash_posix_dev *)chip_id;
+
+	uint32_t num_sectors = flash_dev->cfg->size_of_flash /
+		flash_dev->cfg->size_of_sector;
+
+	flash_dev->stats.min_sector_erases = UINT32_MAX;
+	flash_dev->stats.max_sector_erases = 0;
+
+	for (uint32_t i = 0; i < num_sectors; i++) {
+		uint32_t n = flash_dev->sector_erases[i];
+
+		if (n < flash_dev->stats.min_sector_erases)
+			flash_dev->stats.min_sector_erases = n;
+		if (n > flash_dev->stats.max_sector_erases)
+			flash_dev->stats.max_sector_erases = n;
+	}
+
+	*stats = flash_dev->stats;
+}
+
+void PIOS_Flash_Posix_ResetStats(uintptr_t chip_id)
+{
+	struct flash_posix_dev * flash_dev = (struct flash_posix_dev *)chip_id;
+
+	memset(&flash_dev->stats, 0, sizeof(flash_dev->stats));
+	memset(flash_dev->sector_erases, 0, sizeof(uint32_t) *
+			(flash_dev->cfg->size_of_flash / flash_dev->cfg->size_of_sector));
+}
+
+/* Time to clock a command, its address and len bytes over the bus */
+static uint64_t PIOS_Flash_Posix_BusTime(const struct pios_flash_posix_timing *timing,
+		uint32_t len)
+{
+	return (uint64_t)(4 + len) * 8 * 1000000000ULL / timing->spi_clock_hz;
+}
+
+static void PIOS_Flash_Posix_Busy(struct flash_posix_dev *flash_dev, uint64_t ns)
+{
+	flash_dev->stats.busy_ns += ns;
+
+	if (ns > flash_dev->stats.max_op_ns)
+		flash_dev->stats.max_op_ns = ns;
+
+	if (flash_dev->cfg->timing->realtime)
+		PIOS_DELAY_WaituS(ns / 1000);
+}
+
 /**********************************
  *
  * Provide a PIOS flash driver API
@@ -153,6 +242,15 @@ static int32_t PIOS_Flash_Posix_EraseSector(uintptr_t chip_id, uint32_t chip_sec
 
 	fflush(flash_dev->flash_file);
 
+	flash_dev->stats.erases++;
+	flash_dev->sector_erases[chip_offset / flash_dev->cfg->size_of_sector]++;
+
+	if (flash_dev->cfg->timing) {
+		PIOS_Flash_Posix_Busy(flash_dev,
+				PIOS_Flash_Posix_BusTime(flash_dev->cfg->timing, 0) +
+				flash_dev->cfg->timing->sector_erase_us * 1000ULL);
+	}
+
 	return 0;
 }
 
@@ -169,13 +267,50 @@ static int32_t PIOS_Flash_Posix_WriteData(uintptr_t chip_id, uint32_t chip_offse
 		assert(0);
 	}
 
+	/* Programming can only clear bits; real parts would leave the set
+	 * ones alone, here they're written but counted */
+	uint8_t old[len];
 	size_t s;
+	s = fread (old, 1, len, flash_dev->flash_file);
+
+	assert (s == len);
+
+	for (uint16_t i = 0; i < len; i++) {
+		if (data[i] & ~old[i]) {
+			flash_dev->stats.bad_programs++;
+			break;
+		}
+	}
+
+	if (fseek (flash_dev->flash_file, chip_offset, SEEK_SET) != 0) {
+		assert(0);
+	}
+
 	s = fwrite (data, 1, len, flash_dev->flash_file);
 
 	assert (s == len);
 
 	fflush(flash_dev->flash_file);
 
+	flash_dev->stats.bytes_written += len;
+
+	const struct pios_flash_posix_timing *timing = flash_dev->cfg->timing;
+
+	if (timing && len) {
+		/* Each page touched is a program of its own */
+		uint32_t first_page = chip_offset / timing->page_size;
+		uint32_t last_page = (chip_offset + len - 1) / timing->page_size;
+		uint32_t pages = last_page - first_page + 1;
+
+		flash_dev->stats.page_programs += pages;
+
+		/* A command per page, and the data once */
+		PIOS_Flash_Posix_Busy(flash_dev,
+				PIOS_Flash_Posix_BusTime(timing, len) +
+				PIOS_Flash_Posix_BusTime(timing, 0) * (pages - 1) +
+				timing->page_program_us * 1000ULL * pages);
+	}
+
 	return 0;
 }
 
@@ -197,6 +332,14 @@ static int32_t PIOS_Flash_Posix_ReadData(uintptr_t chip_id, uint32_t chip_offset
 
 	assert (s == len);
 
+	flash_dev->stats.reads++;
+	flash_dev->stats.bytes_read += len;
+
+	if (flash_dev->cfg->timing) {
+		PIOS_Flash_Posix_Busy(flash_dev,
+				PIOS_Flash_Posix_BusTime(flash_dev->cfg->timing, len));
+	}
+
 	return 0;
 }
 
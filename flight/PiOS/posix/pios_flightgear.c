@@ -56,7 +56,7 @@
 struct flightgear_dev {
 	int socket;
 
-	struct pios_queue *accel_queue, *gyro_queue;
+	struct pios_spsc_queue *accel_queue, *gyro_queue;
 
 	struct sockaddr_in send_addr;
 };
@@ -78,9 +78,13 @@ static void PIOS_FLIGHTGEAR_RxTask(void *param)
 	while (true) {
 		char buf[320];
 
+		PIOS_Thread_FakeClock_Park();
+
 		ssize_t cnt = recv(fg_dev->socket, buf, sizeof(buf) - 1,
 				0);
 
+		PIOS_Thread_FakeClock_Unpark();
+
 		if (cnt < 0) {
 			perror("fg-recv");
 
@@ -131,8 +135,8 @@ static void PIOS_FLIGHTGEAR_RxTask(void *param)
 			gyro_data.y = gyro_data.y * 0.3 + rates[1] * 0.7;
 			gyro_data.z = gyro_data.z * 0.3 + rates[2] * 0.7;
 
-			PIOS_Queue_Send(fg_dev->accel_queue, &accel_data, 0);
-			PIOS_Queue_Send(fg_dev->gyro_queue, &gyro_data, 0);
+			PIOS_SPSC_Queue_Send(fg_dev->accel_queue, &accel_data, 1, NULL);
+			PIOS_SPSC_Queue_Send(fg_dev->gyro_queue, &gyro_data, 1, NULL);
 
 			fd_set r;
 
@@ -146,8 +150,12 @@ static void PIOS_FLIGHTGEAR_RxTask(void *param)
 				.tv_usec = 2800,
 			};
 
+			PIOS_Thread_FakeClock_Park();
+
 			select(fg_dev->socket + 1, &r, NULL, NULL, &timeout);
 
+			PIOS_Thread_FakeClock_Unpark();
+
 			if (FD_ISSET(fg_dev->socket, &r)) {
 				break;
 			}
@@ -204,12 +212,12 @@ int32_t PIOS_FLIGHTGEAR_Init(flightgear_dev_t *dev, uint16_t port)
 		exit(EXIT_FAILURE);
 	}
 
-	fg_dev->accel_queue = PIOS_Queue_Create(2, sizeof(struct pios_sensor_accel_data));
+	fg_dev->accel_queue = PIOS_SPSC_Queue_Create(sizeof(struct pios_sensor_accel_data), 2, 1);
 	if (fg_dev->accel_queue == NULL) {
 		exit(1);
 	}
 
-	fg_dev->gyro_queue = PIOS_Queue_Create(2, sizeof(struct pios_sensor_gyro_data));
+	fg_dev->gyro_queue = PIOS_SPSC_Queue_Create(sizeof(struct pios_sensor_gyro_data), 2, 1);
 	if (fg_dev->gyro_queue == NULL) {
 		exit(1);
 	}
@@ -37,6 +37,7 @@
 #include "taskmonitor.h"
 
 #include "pios_flyingpio_priv.h"
+#include "pios_spi_posix_priv.h"
 #include "flyingpio_messages.h"
 
 #include "actuatorcommand.h"
@@ -64,7 +65,10 @@ const struct pios_adc_driver pios_flyingpio_adc_driver = {
 		.lsb_voltage = PIOS_FLYINGPIO_ADC_LSB_Voltage,
 };
 
-#define MIN_QUIET_TIME 300		/* Microseconds */
+/* The FlyingPIO arms its DMA for the next frame (and the response it
+ * prepared earlier) before it acts on the one it just got, so this only
+ * needs to cover it noticing that the select line went up. */
+#define MIN_QUIET_TIME 100		/* Microseconds */
 
 /**
  * @brief The device state struct
@@ -192,17 +196,13 @@ static int PIOS_FLYINGPIO_SendCmd(struct flyingpi_msg *msg) {
 
 	PIOS_SPI_SetClockSpeed(fpio_dev->spi_id, 15000000);
 
-	PIOS_SPI_RC_PinSet(fpio_dev->spi_id, fpio_dev->spi_slave,
-		false);
-
+	/* One kernel round trip for the whole exchange */
 	struct flyingpi_msg resp;
-	if (PIOS_SPI_TransferBlock(fpio_dev->spi_id, (uint8_t *)msg,
-			(uint8_t *)&resp, len)) {
+	if (PIOS_SPI_TransferSelected(fpio_dev->spi_id, fpio_dev->spi_slave,
+			(uint8_t *)msg, (uint8_t *)&resp, len)) {
 		ret = -1;
 	}
 
-	PIOS_SPI_RC_PinSet(fpio_dev->spi_id, fpio_dev->spi_slave,
-		true);
 	PIOS_SPI_ReleaseBus(fpio_dev->spi_id);
 
 	fpio_dev->last_msg_time = PIOS_DELAY_GetRaw();
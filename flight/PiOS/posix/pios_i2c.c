@@ -128,6 +128,23 @@ int32_t PIOS_I2C_Transfer(pios_i2c_t i2c_id, const struct pios_i2c_txn txn_list[
 	return ret;
 }
 
+/**
+ * The kernel does the transfer synchronously, so this just calls back
+ * before returning.
+ */
+int32_t PIOS_I2C_Transfer_Callback(pios_i2c_t i2c_id, const struct pios_i2c_txn txn_list[],
+		uint32_t num_txns, pios_i2c_callback_t callback, void *ctx)
+{
+	int32_t result = PIOS_I2C_Transfer(i2c_id, txn_list, num_txns);
+
+	if (callback) {
+		bool woken = false;
+		callback(ctx, result, &woken);
+	}
+
+	return 0;
+}
+
 #endif /* PIOS_INCLUDE_I2C */
 
 /**
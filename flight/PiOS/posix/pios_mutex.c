@@ -33,6 +33,10 @@
 
 struct pios_mutex {
 	pthread_mutex_t mutex;
+#if defined(DIAG_MUTEXES)
+	struct pios_mutex_stats stats;
+	uintptr_t holder;	/* pthreads has no portable way to ask */
+#endif
 };
 
 struct pios_recursive_mutex {
@@ -40,7 +44,28 @@ struct pios_recursive_mutex {
 	struct pios_mutex mutex;
 };
 
-struct pios_mutex *PIOS_Mutex_Create(void)
+#if defined(DIAG_MUTEXES)
+static const struct pios_mutex_stats *stats_head;
+static pthread_mutex_t stats_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void mutex_stats_register(struct pios_mutex_stats *stats, void *creator)
+{
+	memset(stats, 0, sizeof(*stats));
+	stats->creator = (uintptr_t) creator;
+
+	pthread_mutex_lock(&stats_lock);
+	stats->next = stats_head;
+	stats_head = stats;
+	pthread_mutex_unlock(&stats_lock);
+}
+
+const struct pios_mutex_stats *PIOS_Mutex_Stats_First(void)
+{
+	return stats_head;
+}
+#endif /* DIAG_MUTEXES */
+
+static struct pios_mutex *mutex_create(int type, void *creator)
 {
 	pthread_mutexattr_t attr;
 
@@ -48,25 +73,54 @@ struct pios_mutex *PIOS_Mutex_Create(void)
 		abort();
 	}
 
-	pthread_mutexattr_setprotocol(&attr, PTHREAD_PRIO_INHERIT);
+	/* Same guarantee as the ChibiOS mutexes; refuse to run without it */
+	if (pthread_mutexattr_settype(&attr, type) ||
+			pthread_mutexattr_setprotocol(&attr, PTHREAD_PRIO_INHERIT)) {
+		abort();
+	}
 
 	struct pios_mutex *p = malloc(sizeof(*p));
 
 	if (p) {
 		if (pthread_mutex_init(&p->mutex, &attr)) {
 			free(p);
-
-			return NULL;
+			p = NULL;
 		}
 	}
 
+	pthread_mutexattr_destroy(&attr);
+
+#if defined(DIAG_MUTEXES)
+	if (p) {
+		mutex_stats_register(&p->stats, creator);
+	}
+#else
+	(void) creator;
+#endif
+
 	return p;
 }
 
+struct pios_mutex *PIOS_Mutex_Create(void)
+{
+	return mutex_create(PTHREAD_MUTEX_DEFAULT, __builtin_return_address(0));
+}
+
 bool PIOS_Mutex_Lock(struct pios_mutex *mtx, uint32_t timeout_ms)
 {
 	int ret;
 
+#if defined(DIAG_MUTEXES)
+	if (!pthread_mutex_trylock(&mtx->mutex)) {
+		mtx->holder = (uintptr_t) pthread_self();
+
+		return true;
+	}
+
+	uintptr_t owner = mtx->holder;
+	uint32_t start = PIOS_DELAY_GetRaw();
+#endif
+
 	if (timeout_ms >= PIOS_MUTEX_TIMEOUT_MAX) {
 		ret = pthread_mutex_lock(&mtx->mutex);
 
@@ -98,6 +152,20 @@ bool PIOS_Mutex_Lock(struct pios_mutex *mtx, uint32_t timeout_ms)
 #endif
 	}
 
+#if defined(DIAG_MUTEXES)
+	if (ret == 0) {
+		uint32_t waited = PIOS_DELAY_GetRaw() - start;
+
+		mtx->stats.waits++;
+		mtx->stats.wait_cycles += waited;
+		if (waited > mtx->stats.max_wait_cycles)
+			mtx->stats.max_wait_cycles = waited;
+
+		mtx->stats.owner = owner;
+		mtx->holder = (uintptr_t) pthread_self();
+	}
+#endif
+
 	return (ret == 0);
 }
 
@@ -114,26 +182,8 @@ bool PIOS_Mutex_Unlock(struct pios_mutex *mtx)
 
 struct pios_recursive_mutex *PIOS_Recursive_Mutex_Create(void)
 {
-	pthread_mutexattr_t attr;
-
-	if (pthread_mutexattr_init(&attr)) {
-		abort();
-	}
-
-	pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
-	pthread_mutexattr_setprotocol(&attr, PTHREAD_PRIO_INHERIT);
-
-	struct pios_mutex *p = malloc(sizeof(*p));
-
-	if (p) {
-		if (pthread_mutex_init(&p->mutex, &attr)) {
-			free(p);
-
-			return NULL;
-		}
-	}
-
-	return (struct pios_recursive_mutex *) p;
+	return (struct pios_recursive_mutex *)
+		mutex_create(PTHREAD_MUTEX_RECURSIVE, __builtin_return_address(0));
 }
 
 bool PIOS_Recursive_Mutex_Lock(struct pios_recursive_mutex *mtx, uint32_t timeout_ms) 
@@ -144,17 +144,27 @@ bool PIOS_Queue_Send(struct pios_queue *queuep,
 	PIOS_Assert(queuep->magic == QUEUE_MAGIC);
 
 	if (PIOS_Thread_FakeClock_IsActive()) {
+		/* In lockstep, wait on the fake clock so the ticker sees us
+		 * as idle; otherwise poll in real time. */
+		bool lockstep = PIOS_Thread_FakeClock_IsLockstep();
 		uint32_t start = PIOS_Thread_Systime();
 
-		do {
-			if (PIOS_Queue_Send_Impl(queuep, itemp, 1)) {
+		while (true) {
+			if (PIOS_Queue_Send_Impl(queuep, itemp,
+						lockstep ? 0 : 1)) {
 				return true;
 			}
-		} while ((timeout_ms == PIOS_QUEUE_TIMEOUT_MAX) ||
-				(!PIOS_Thread_Period_Elapsed(start,
-							     timeout_ms)));
 
-		return false;
+			if ((timeout_ms != PIOS_QUEUE_TIMEOUT_MAX) &&
+					PIOS_Thread_Period_Elapsed(start,
+						timeout_ms)) {
+				return false;
+			}
+
+			if (lockstep) {
+				PIOS_Thread_Sleep(1);
+			}
+		}
 	}
 
 	return PIOS_Queue_Send_Impl(queuep, itemp, timeout_ms);
@@ -216,17 +226,25 @@ bool PIOS_Queue_Receive(struct pios_queue *queuep,
 	PIOS_Assert(queuep->magic == QUEUE_MAGIC);
 
 	if (PIOS_Thread_FakeClock_IsActive()) {
+		bool lockstep = PIOS_Thread_FakeClock_IsLockstep();
 		uint32_t start = PIOS_Thread_Systime();
 
-		do {
-			if (PIOS_Queue_Receive_Impl(queuep, itemp, 1)) {
+		while (true) {
+			if (PIOS_Queue_Receive_Impl(queuep, itemp,
+						lockstep ? 0 : 1)) {
 				return true;
 			}
-		} while ((timeout_ms == PIOS_QUEUE_TIMEOUT_MAX) ||
-				(!PIOS_Thread_Period_Elapsed(start,
-							     timeout_ms)));
 
-		return false;
+			if ((timeout_ms != PIOS_QUEUE_TIMEOUT_MAX) &&
+					PIOS_Thread_Period_Elapsed(start,
+						timeout_ms)) {
+				return false;
+			}
+
+			if (lockstep) {
+				PIOS_Thread_Sleep(1);
+			}
+		}
 	}
 
 	return PIOS_Queue_Receive_Impl(queuep, itemp, timeout_ms);
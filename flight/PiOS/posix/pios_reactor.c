@@ -0,0 +1,352 @@
+/**
+ ******************************************************************************
+ *
+ * @file       pios_reactor.c
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2017
+ * @brief      One thread waiting on the file descriptors of the posix drivers.
+ * @see        The GNU Public License (GPL) Version 3
+ * @addtogroup PIOS PIOS Core hardware abstraction layer
+ * @{
+ * @addtogroup PIOS_REACTOR Posix I/O reactor
+ * @{
+ *
+ * The serial and TCP COM drivers used to have a blocking receive thread
+ * each.  Instead they hand their descriptors to this one thread, which waits
+ * on all of them at once (with epoll on Linux, and poll elsewhere) and calls
+ * back into the driver when there's something to read.
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+/* Project Includes */
+#include "pios.h"
+
+#include <pios_reactor.h>
+#include "pios_thread.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+#include <sys/epoll.h>
+#else
+#include <poll.h>
+#endif
+
+struct reactor_entry {
+	int fd;
+	pios_reactor_cb cb;
+	uintptr_t context;
+
+	/* Holding data the consumer had no room for; not watched */
+	bool backlogged;
+};
+
+static struct reactor_entry entries[PIOS_REACTOR_MAX_FDS];
+static pthread_mutex_t reactor_mutex = PTHREAD_MUTEX_INITIALIZER;
+static bool reactor_started;
+
+#if defined(__linux__)
+static int epoll_fd = -1;
+#else
+/* Wakes the poll() up when the set of descriptors changes */
+static int wake_pipe[2] = { -1, -1 };
+#endif
+
+static void reactor_watch(int slot, bool watch)
+{
+#if defined(__linux__)
+	struct epoll_event ev = {
+		.events = watch ? EPOLLIN : 0,
+		.data.u32 = slot,
+	};
+
+	epoll_ctl(epoll_fd, EPOLL_CTL_MOD, entries[slot].fd, &ev);
+#else
+	(void) slot;
+	(void) watch;
+#endif
+}
+
+static void reactor_wake(void)
+{
+#if !defined(__linux__)
+	char c = 0;
+
+	if (write(wake_pipe[1], &c, 1) < 0) {
+		/* Pipe full; it'll wake up anyway */
+	}
+#endif
+}
+
+static void reactor_dispatch(int slot)
+{
+	pthread_mutex_lock(&reactor_mutex);
+
+	struct reactor_entry entry = entries[slot];
+
+	pthread_mutex_unlock(&reactor_mutex);
+
+	if (!entry.cb) {
+		return;
+	}
+
+	/* Not under the mutex, so the callback can add and remove */
+	bool caught_up = entry.cb(entry.context);
+
+	pthread_mutex_lock(&reactor_mutex);
+
+	/* Unless the callback took itself out */
+	if ((entries[slot].fd == entry.fd) && (entries[slot].cb == entry.cb)) {
+		if (caught_up == entries[slot].backlogged) {
+			entries[slot].backlogged = !caught_up;
+			reactor_watch(slot, caught_up);
+		}
+	}
+
+	pthread_mutex_unlock(&reactor_mutex);
+}
+
+static bool reactor_any_backlogged(void)
+{
+	bool any = false;
+
+	pthread_mutex_lock(&reactor_mutex);
+
+	for (int i = 0; i < PIOS_REACTOR_MAX_FDS; i++) {
+		if (entries[i].cb && entries[i].backlogged) {
+			any = true;
+			break;
+		}
+	}
+
+	pthread_mutex_unlock(&reactor_mutex);
+
+	return any;
+}
+
+static void PIOS_Reactor_Task(void *unused)
+{
+	(void) unused;
+
+	while (1) {
+		bool retry = reactor_any_backlogged();
+		int timeout = retry ? PIOS_REACTOR_RETRY_MS : -1;
+
+#if defined(__linux__)
+		struct epoll_event events[PIOS_REACTOR_MAX_FDS];
+
+		PIOS_Thread_FakeClock_Park();
+
+		int n = epoll_wait(epoll_fd, events, PIOS_REACTOR_MAX_FDS,
+				timeout);
+
+		PIOS_Thread_FakeClock_Unpark();
+
+		for (int i = 0; i < n; i++) {
+			reactor_dispatch(events[i].data.u32);
+		}
+#else
+		struct pollfd fds[PIOS_REACTOR_MAX_FDS + 1];
+		int slots[PIOS_REACTOR_MAX_FDS];
+		int num_fds = 0;
+
+		pthread_mutex_lock(&reactor_mutex);
+
+		for (int i = 0; i < PIOS_REACTOR_MAX_FDS; i++) {
+			if (entries[i].cb && !entries[i].backlogged) {
+				fds[num_fds].fd = entries[i].fd;
+				fds[num_fds].events = POLLIN;
+				fds[num_fds].revents = 0;
+				slots[num_fds++] = i;
+			}
+		}
+
+		pthread_mutex_unlock(&reactor_mutex);
+
+		fds[num_fds].fd = wake_pipe[0];
+		fds[num_fds].events = POLLIN;
+		fds[num_fds].revents = 0;
+
+		PIOS_Thread_FakeClock_Park();
+
+		int n = poll(fds, num_fds + 1, timeout);
+
+		PIOS_Thread_FakeClock_Unpark();
+
+		if (n > 0) {
+			if (fds[num_fds].revents) {
+				char buf[16];
+
+				if (read(wake_pipe[0], buf, sizeof(buf)) < 0) {
+					/* Nothing there after all */
+				}
+			}
+
+			for (int i = 0; i < num_fds; i++) {
+				if (fds[i].revents) {
+					reactor_dispatch(slots[i]);
+				}
+			}
+		}
+#endif
+
+		if (n < 0 && errno != EINTR) {
+			perror("pios_reactor wait");
+			PIOS_Thread_Sleep(1);
+		}
+
+		if (retry) {
+			for (int i = 0; i < PIOS_REACTOR_MAX_FDS; i++) {
+				if (entries[i].backlogged) {
+					reactor_dispatch(i);
+				}
+			}
+		}
+	}
+}
+
+/* Called with the mutex held */
+static int32_t reactor_start(void)
+{
+	if (reactor_started) {
+		return 0;
+	}
+
+#if defined(__linux__)
+	epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+
+	if (epoll_fd < 0) {
+		perror("epoll_create1");
+		return -1;
+	}
+#else
+	if (pipe(wake_pipe)) {
+		perror("pipe");
+		return -1;
+	}
+
+	fcntl(wake_pipe[0], F_SETFL, O_NONBLOCK);
+	fcntl(wake_pipe[1], F_SETFL, O_NONBLOCK);
+#endif
+
+	struct pios_thread *reactor_task = PIOS_Thread_Create(
+			PIOS_Reactor_Task, "pios_reactor",
+			PIOS_THREAD_STACK_SIZE_MIN, NULL,
+			PIOS_THREAD_PRIO_HIGHEST);
+
+	PIOS_Assert(reactor_task);
+
+	reactor_started = true;
+
+	return 0;
+}
+
+/**
+ * Starts watching a descriptor, starting the reactor thread if need be.
+ * \param[in] fd descriptor to wait on
+ * \param[in] cb called on the reactor thread when fd is readable
+ * \param[in] context passed to cb
+ * \return 0 on success, -1 on failure
+ */
+int32_t PIOS_Reactor_Add(int fd, pios_reactor_cb cb, uintptr_t context)
+{
+	PIOS_Assert(cb);
+
+	pthread_mutex_lock(&reactor_mutex);
+
+	if (reactor_start()) {
+		pthread_mutex_unlock(&reactor_mutex);
+		return -1;
+	}
+
+	int slot;
+
+	for (slot = 0; slot < PIOS_REACTOR_MAX_FDS; slot++) {
+		if (!entries[slot].cb) {
+			break;
+		}
+	}
+
+	if (slot >= PIOS_REACTOR_MAX_FDS) {
+		pthread_mutex_unlock(&reactor_mutex);
+		return -1;
+	}
+
+#if defined(__linux__)
+	struct epoll_event ev = {
+		.events = EPOLLIN,
+		.data.u32 = slot,
+	};
+
+	if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev)) {
+		perror("epoll_ctl");
+		pthread_mutex_unlock(&reactor_mutex);
+		return -1;
+	}
+#endif
+
+	entries[slot] = (struct reactor_entry) {
+		.fd = fd,
+		.cb = cb,
+		.context = context,
+	};
+
+	pthread_mutex_unlock(&reactor_mutex);
+
+	reactor_wake();
+
+	return 0;
+}
+
+/**
+ * Stops watching a descriptor.  Call before closing it.  The callback isn't
+ * called again, though a call already under way on the reactor thread may
+ * still be finishing when this returns.
+ * \param[in] fd descriptor given to PIOS_Reactor_Add
+ * \return 0 on success, -1 if it wasn't being watched
+ */
+int32_t PIOS_Reactor_Remove(int fd)
+{
+	int32_t ret = -1;
+
+	pthread_mutex_lock(&reactor_mutex);
+
+	for (int slot = 0; slot < PIOS_REACTOR_MAX_FDS; slot++) {
+		if (entries[slot].cb && (entries[slot].fd == fd)) {
+#if defined(__linux__)
+			epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, NULL);
+#endif
+
+			entries[slot] = (struct reactor_entry) { .fd = -1 };
+			ret = 0;
+			break;
+		}
+	}
+
+	pthread_mutex_unlock(&reactor_mutex);
+
+	reactor_wake();
+
+	return ret;
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -28,6 +28,11 @@
 
 #include <pios.h>
 
+/* From pios_thread.c, which unit tests using semaphores don't link */
+extern bool PIOS_Thread_FakeClock_IsLockstep(void) __attribute__((weak));
+extern uint32_t PIOS_Thread_Systime(void) __attribute__((weak));
+extern void PIOS_Thread_Sleep(uint32_t time_ms) __attribute__((weak));
+
 struct pios_semaphore {
 #define SEMAPHORE_MAGIC 0x616d6553	/* 'Sema' */
 	uint32_t magic;
@@ -69,10 +74,9 @@ struct pios_semaphore *PIOS_Semaphore_Create(void)
 	return s;
 }
 
-bool PIOS_Semaphore_Take(struct pios_semaphore *sema, uint32_t timeout_ms)
+static bool PIOS_Semaphore_Take_Impl(struct pios_semaphore *sema,
+		uint32_t timeout_ms)
 {
-	PIOS_Assert(sema->magic == SEMAPHORE_MAGIC);
-
         struct timespec abstime;
 
         if (timeout_ms != PIOS_QUEUE_TIMEOUT_MAX) {
@@ -108,6 +112,33 @@ bool PIOS_Semaphore_Take(struct pios_semaphore *sema, uint32_t timeout_ms)
 	return true;
 }
 
+bool PIOS_Semaphore_Take(struct pios_semaphore *sema, uint32_t timeout_ms)
+{
+	PIOS_Assert(sema->magic == SEMAPHORE_MAGIC);
+
+	/* In lockstep, wait on the fake clock so the ticker sees us as idle */
+	if (PIOS_Thread_FakeClock_IsLockstep &&
+			PIOS_Thread_FakeClock_IsLockstep()) {
+		uint32_t start = PIOS_Thread_Systime();
+
+		while (true) {
+			if (PIOS_Semaphore_Take_Impl(sema, 0)) {
+				return true;
+			}
+
+			if ((timeout_ms != PIOS_QUEUE_TIMEOUT_MAX) &&
+					((PIOS_Thread_Systime() - start) >=
+						timeout_ms)) {
+				return false;
+			}
+
+			PIOS_Thread_Sleep(1);
+		}
+	}
+
+	return PIOS_Semaphore_Take_Impl(sema, timeout_ms);
+}
+
 bool PIOS_Semaphore_Give(struct pios_semaphore *sema)
 {
 	bool old;
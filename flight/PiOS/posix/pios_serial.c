@@ -36,6 +36,7 @@
 #include "pios.h"
 
 #include <pios_serial_priv.h>
+#include <pios_reactor.h>
 #include "pios_thread.h"
 #include <unistd.h>
 #include <sys/types.h>
@@ -75,6 +76,7 @@ typedef struct {
 
 	bool ever_used_custom_rate;
 	bool dont_touch_line;
+	bool closed;
 } pios_ser_dev;
 
 const struct pios_com_driver pios_serial_com_driver = {
@@ -106,42 +108,56 @@ static void rx_do_cb(pios_ser_dev *ser_dev, uint8_t *incoming_buffer,
 }
 
 /**
- * RxTask
+ * Reads whatever is waiting, up to a buffer's worth.  Like a UART, what the
+ * COM layer has no room for is dropped.
  */
-static void PIOS_SERIAL_RxTask(void *ser_dev_n)
+static bool serial_rx_ready(uintptr_t context)
 {
-	pios_ser_dev *ser_dev = (pios_ser_dev*)ser_dev_n;
+	pios_ser_dev *ser_dev = (pios_ser_dev *) context;
 
-	const int INCOMING_BUFFER_SIZE = 16;
-	uint8_t incoming_buffer[INCOMING_BUFFER_SIZE];
+	int result = read(ser_dev->readfd, ser_dev->rx_buffer,
+			PIOS_SERIAL_RX_BUFFER_SIZE);
 
-	while (1) {
-		int result = read(ser_dev->readfd, incoming_buffer,
-				INCOMING_BUFFER_SIZE);
+	if (result > 0) {
+		rx_do_cb(ser_dev, ser_dev->rx_buffer, result);
 
-		if (result > 0) {
-			rx_do_cb(ser_dev, incoming_buffer, result);
-		}
+		return true;
+	}
 
-		if (result == 0) {	/* EOF */
-			if (ser_dev->dont_touch_line) {
-				/* In any case we don't expect a device
-				 * to go away.  For true serial devices,
-				 * it probably means USB or something and
-				 * keeping the rest of the tasks going
-				 * seems best.  If it's stdio-ish, then
-				 * we really want to take the process
-				 * down.
-				 */
-				exit(1);
-			}
+	if (result == -1 && (errno == EAGAIN || errno == EINTR)) {
+		return true;
+	}
 
-			break;
-		}
+	if (ser_dev->dont_touch_line) {
+		/* In any case we don't expect a device to go away.  For
+		 * true serial devices, it probably means USB or something
+		 * and keeping the rest of the tasks going seems best.  If
+		 * it's stdio-ish, then we really want to take the process
+		 * down.
+		 */
+		exit(1);
+	}
 
-		if (result == -1) {
-			PIOS_Thread_Sleep(1);
-		}
+	if (result == -1) {
+		perror("serial-read");
+	}
+
+	PIOS_Reactor_Remove(ser_dev->readfd);
+	ser_dev->closed = true;
+
+	return true;
+}
+
+/**
+ * RxTask, for descriptors the reactor can't wait on (regular files, which
+ * are always readable anyway).
+ */
+static void PIOS_SERIAL_RxTask(void *ser_dev_n)
+{
+	pios_ser_dev *ser_dev = (pios_ser_dev*)ser_dev_n;
+
+	while (!ser_dev->closed) {
+		serial_rx_ready((uintptr_t) ser_dev);
 	}
 }
 
@@ -164,8 +180,12 @@ int32_t PIOS_SERIAL_InitFromFd(uintptr_t *serial_id, int readfd,
 	ser_dev->readfd = readfd;
 	ser_dev->writefd = writefd;
 
-	PIOS_Thread_Create(PIOS_SERIAL_RxTask, "pios_serial_rx",
-		PIOS_THREAD_STACK_SIZE_MIN, ser_dev, PIOS_THREAD_PRIO_HIGHEST);
+	if (PIOS_Reactor_Add(ser_dev->readfd, serial_rx_ready,
+				(uintptr_t) ser_dev)) {
+		PIOS_Thread_Create(PIOS_SERIAL_RxTask, "pios_serial_rx",
+			PIOS_THREAD_STACK_SIZE_MIN, ser_dev,
+			PIOS_THREAD_PRIO_HIGHEST);
+	}
 
 	printf("serial dev %p - fd %i/%i opened\n", ser_dev,
 		ser_dev->readfd, ser_dev->writefd);
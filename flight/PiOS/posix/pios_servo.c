@@ -98,4 +98,15 @@ bool PIOS_Servo_IsDshot(uint8_t servo) {
 	return false;
 }
 
+void PIOS_Servo_SetDshotBidirectional(bool enable) {
+	(void) enable;
+}
+
+bool PIOS_Servo_GetERPM(uint8_t servo, uint32_t *erpm) {
+	(void) servo;
+	(void) erpm;
+
+	return false;
+}
+
 #endif
@@ -0,0 +1,293 @@
+/**
+ ******************************************************************************
+ *
+ * @file       pios_shm.c
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2017
+ * @brief      COM driver over a pair of rings in a shared memory file.
+ * @see        The GNU Public License (GPL) Version 3
+ * @addtogroup PIOS PIOS Core hardware abstraction layer
+ * @{
+ * @addtogroup PIOS_SHM Shared memory COM driver
+ * @{
+ *
+ * Carries a COM stream (normally telemetry) to tools on the same host
+ * without going through the socket layer.  The COM layer fills the ring in
+ * the shared file directly, and the host reads frames straight out of it;
+ * the other way, the rx task hands the COM layer pointers into the ring.
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+/* Project Includes */
+#include "pios.h"
+
+#if defined(PIOS_INCLUDE_SHM)
+
+#include <pios_shm_priv.h>
+#include "pios_thread.h"
+
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+/* The tools find the rings at fixed offsets */
+DONT_BUILD_IF(offsetof(struct pios_shm_region, to_host) != 16, ShmLayout);
+DONT_BUILD_IF(PIOS_SHM_RING_SIZE & (PIOS_SHM_RING_SIZE - 1), ShmRingPow2);
+
+/* Most handed to the COM layer at once; its lengths are 16 bit */
+#define SHM_MAX_CHUNK 4096
+
+/* Provide a COM driver */
+static void PIOS_SHM_RegisterRxCallback(uintptr_t shm_id, pios_com_callback rx_in_cb, uintptr_t context);
+static void PIOS_SHM_RegisterTxCallback(uintptr_t shm_id, pios_com_callback tx_out_cb, uintptr_t context);
+static void PIOS_SHM_TxStart(uintptr_t shm_id, uint16_t tx_bytes_avail);
+static void PIOS_SHM_RxStart(uintptr_t shm_id, uint16_t rx_bytes_avail);
+
+typedef struct {
+	struct pios_shm_region *region;
+
+	pios_com_callback tx_out_cb;
+	uintptr_t tx_out_context;
+	pios_com_callback rx_in_cb;
+	uintptr_t rx_in_context;
+
+	/* Somewhere to put what doesn't fit when nobody is reading */
+	uint8_t overflow[64];
+} pios_shm_dev;
+
+const struct pios_com_driver pios_shm_com_driver = {
+	.tx_start   = PIOS_SHM_TxStart,
+	.rx_start   = PIOS_SHM_RxStart,
+	.bind_tx_cb = PIOS_SHM_RegisterTxCallback,
+	.bind_rx_cb = PIOS_SHM_RegisterRxCallback,
+};
+
+static pios_shm_dev *find_shm_dev_by_id(uintptr_t shm)
+{
+	return (pios_shm_dev *) shm;
+}
+
+/**
+ * RxTask.  Polls the ring from the host on the (possibly fake) clock, and
+ * hands the COM layer whatever has arrived in place.
+ */
+static void PIOS_SHM_RxTask(void *shm_dev_n)
+{
+	pios_shm_dev *shm_dev = shm_dev_n;
+	struct pios_shm_ring *ring = &shm_dev->region->to_fc;
+
+	while (1) {
+		uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+		uint32_t tail = ring->tail;
+
+		if (head == tail || !shm_dev->rx_in_cb) {
+			PIOS_Thread_Sleep(1);
+			continue;
+		}
+
+		uint32_t offset = tail & (PIOS_SHM_RING_SIZE - 1);
+		uint32_t len = head - tail;
+
+		if (len > PIOS_SHM_RING_SIZE - offset) {
+			len = PIOS_SHM_RING_SIZE - offset;
+		}
+
+		if (len > SHM_MAX_CHUNK) {
+			len = SHM_MAX_CHUNK;
+		}
+
+		bool rx_need_yield = false;
+
+		int32_t taken = shm_dev->rx_in_cb(shm_dev->rx_in_context,
+				&ring->data[offset], len, NULL, &rx_need_yield);
+
+		if (taken > 0) {
+			__atomic_store_n(&ring->tail, tail + taken,
+					__ATOMIC_RELEASE);
+		}
+
+		if (taken < (int32_t) len) {
+			/* COM layer is full; let it drain */
+			PIOS_Thread_Sleep(2);
+		}
+	}
+}
+
+/**
+ * Creates (or takes over) the shared file and starts serving it.
+ * \param[out] shm_id the new device
+ * \param[in] path file to share, normally under /dev/shm
+ * \return 0 on success, -1 on failure
+ */
+int32_t PIOS_SHM_Init(uintptr_t *shm_id, const char *path)
+{
+	int fd = open(path, O_RDWR | O_CREAT, 0666);
+
+	if (fd < 0) {
+		perror("shm open");
+		return -1;
+	}
+
+	if (ftruncate(fd, sizeof(struct pios_shm_region))) {
+		perror("shm ftruncate");
+		close(fd);
+		return -1;
+	}
+
+	struct pios_shm_region *region = mmap(NULL, sizeof(*region),
+			PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+	close(fd);
+
+	if (region == MAP_FAILED) {
+		perror("shm mmap");
+		return -1;
+	}
+
+	pios_shm_dev *shm_dev = PIOS_malloc(sizeof(pios_shm_dev));
+
+	if (!shm_dev) {
+		munmap(region, sizeof(*region));
+		return -1;
+	}
+
+	memset(shm_dev, 0, sizeof(*shm_dev));
+
+	shm_dev->region = region;
+
+	/* A reader still attached from a previous run sees the magic go
+	 * away, and starts over once it comes back. */
+	__atomic_store_n(&region->magic, 0, __ATOMIC_RELEASE);
+
+	region->ring_size = PIOS_SHM_RING_SIZE;
+	region->dropped = 0;
+	region->to_host.head = region->to_host.tail = 0;
+	region->to_fc.head = region->to_fc.tail = 0;
+
+	__atomic_store_n(&region->magic, PIOS_SHM_MAGIC, __ATOMIC_RELEASE);
+
+	struct pios_thread *rx_task = PIOS_Thread_Create(PIOS_SHM_RxTask,
+			"pios_shm_rx", PIOS_THREAD_STACK_SIZE_MIN, shm_dev,
+			PIOS_THREAD_PRIO_HIGHEST);
+
+	PIOS_Assert(rx_task);
+
+	printf("shm dev %p - sharing %s\n", shm_dev, path);
+
+	*shm_id = (uintptr_t) shm_dev;
+
+	return 0;
+}
+
+static void PIOS_SHM_RxStart(uintptr_t shm_id, uint16_t rx_bytes_avail)
+{
+	/* The rx task polls */
+}
+
+static void PIOS_SHM_TxStart(uintptr_t shm_id, uint16_t tx_bytes_avail)
+{
+	pios_shm_dev *shm_dev = find_shm_dev_by_id(shm_id);
+
+	PIOS_Assert(shm_dev);
+
+	if (!shm_dev->tx_out_cb) {
+		return;
+	}
+
+	struct pios_shm_region *region = shm_dev->region;
+	struct pios_shm_ring *ring = &region->to_host;
+
+	/* Like the TCP driver, take everything right away; what doesn't fit
+	 * because the host has fallen behind (or isn't there) is dropped
+	 * and counted, and the UAVTalk framing resyncs on the far side. */
+	while (tx_bytes_avail > 0) {
+		uint32_t head = ring->head;
+		uint32_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+
+		uint32_t offset = head & (PIOS_SHM_RING_SIZE - 1);
+		uint32_t space = PIOS_SHM_RING_SIZE - (head - tail);
+
+		if (space > PIOS_SHM_RING_SIZE - offset) {
+			space = PIOS_SHM_RING_SIZE - offset;
+		}
+
+		if (space > SHM_MAX_CHUNK) {
+			space = SHM_MAX_CHUNK;
+		}
+
+		bool tx_need_yield = false;
+		uint16_t length;
+
+		if (space) {
+			length = (shm_dev->tx_out_cb)(shm_dev->tx_out_context,
+					&ring->data[offset], space, NULL,
+					&tx_need_yield);
+
+			__atomic_store_n(&ring->head, head + length,
+					__ATOMIC_RELEASE);
+		} else {
+			length = (shm_dev->tx_out_cb)(shm_dev->tx_out_context,
+					shm_dev->overflow,
+					sizeof(shm_dev->overflow), NULL,
+					&tx_need_yield);
+
+			region->dropped += length;
+		}
+
+		if (!length) {
+			break;
+		}
+
+		if (length >= tx_bytes_avail) {
+			break;
+		}
+
+		tx_bytes_avail -= length;
+	}
+}
+
+static void PIOS_SHM_RegisterRxCallback(uintptr_t shm_id, pios_com_callback rx_in_cb, uintptr_t context)
+{
+	pios_shm_dev *shm_dev = find_shm_dev_by_id(shm_id);
+
+	PIOS_Assert(shm_dev);
+
+	/*
+	 * Order is important in these assignments since the rx task uses
+	 * _cb field to determine if it's ok to dereference _cb and _context
+	 */
+	shm_dev->rx_in_context = context;
+	shm_dev->rx_in_cb = rx_in_cb;
+}
+
+static void PIOS_SHM_RegisterTxCallback(uintptr_t shm_id, pios_com_callback tx_out_cb, uintptr_t context)
+{
+	pios_shm_dev *shm_dev = find_shm_dev_by_id(shm_id);
+
+	PIOS_Assert(shm_dev);
+
+	shm_dev->tx_out_context = context;
+	shm_dev->tx_out_cb = tx_out_cb;
+}
+
+#endif /* PIOS_INCLUDE_SHM */
+
+/**
+ * @}
+ * @}
+ */
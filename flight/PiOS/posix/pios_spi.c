@@ -42,6 +42,7 @@
 struct pios_spi_dev {
 	const struct pios_spi_cfg *cfg;
 	struct pios_semaphore *busy;
+	volatile uint8_t priority_waiting;
 	uint32_t slave_count;
 	uint32_t speed_hz;
 
@@ -74,6 +75,7 @@ int32_t PIOS_SPI_Init(pios_spi_t *spi_id, const struct pios_spi_cfg *cfg)
 	spi_dev->cfg = cfg;
 
 	spi_dev->busy = PIOS_Semaphore_Create();
+	spi_dev->priority_waiting = 0;
 	spi_dev->slave_count = 0;
 
 	for (int i = 0; i < SPI_MAX_SUBDEV; i++) {
@@ -133,9 +135,31 @@ int32_t PIOS_SPI_ClaimBus(pios_spi_t spi_dev)
 	if (PIOS_Semaphore_Take(spi_dev->busy, 65535) != true)
 		return -1;
 
+	if (__atomic_load_n(&spi_dev->priority_waiting, __ATOMIC_ACQUIRE)) {
+		/* Let the priority claim have it, and wait our turn again */
+		PIOS_Semaphore_Give(spi_dev->busy);
+
+		if (PIOS_Semaphore_Take(spi_dev->busy, 65535) != true)
+			return -1;
+	}
+
 	return 0;
 }
 
+int32_t PIOS_SPI_ClaimBusPriority(pios_spi_t spi_dev)
+{
+	bool valid = PIOS_SPI_validate(spi_dev);
+	PIOS_Assert(valid);
+
+	__atomic_add_fetch(&spi_dev->priority_waiting, 1, __ATOMIC_ACQ_REL);
+
+	bool taken = PIOS_Semaphore_Take(spi_dev->busy, 65535);
+
+	__atomic_sub_fetch(&spi_dev->priority_waiting, 1, __ATOMIC_ACQ_REL);
+
+	return taken ? 0 : -1;
+}
+
 int32_t PIOS_SPI_ReleaseBus(pios_spi_t spi_dev)
 {
 	bool valid = PIOS_SPI_validate(spi_dev);
@@ -215,6 +239,34 @@ int32_t PIOS_SPI_TransferBlock(pios_spi_t spi_dev, const uint8_t *send_buffer, u
 	return 0;
 }
 
+int32_t PIOS_SPI_TransferSelected(pios_spi_t spi_dev, uint32_t slave_id,
+		const uint8_t *send_buffer, uint8_t *receive_buffer,
+		uint16_t len)
+{
+	bool valid = PIOS_SPI_validate(spi_dev);
+
+	PIOS_Assert(valid);
+	PIOS_Assert(slave_id < spi_dev->slave_count);
+	PIOS_Assert(spi_dev->selected == -1);
+
+	struct spi_ioc_transfer xfer = {
+		.rx_buf = (uintptr_t) receive_buffer,
+		.tx_buf = (uintptr_t) send_buffer,
+		.len = len,
+		.speed_hz = spi_dev->speed_hz,
+		.cs_change = 0	// Deselect at the end
+	};
+
+	int status = ioctl(spi_dev->fd[slave_id], SPI_IOC_MESSAGE(1), &xfer);
+
+	if (status < 0) {
+		perror("ioctl-SPI_IOC_MESSAGE");
+		return -1;
+	}
+
+	return 0;
+}
+
 #endif
 
 /**
@@ -45,6 +45,9 @@
 #ifndef __APPLE__
 #include <sys/mman.h>
 #include <sched.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
 #endif
 #endif
 
@@ -54,6 +57,7 @@
 #include "pios_com_priv.h"
 #include "pios_serial_priv.h"
 #include "pios_tcp_priv.h"
+#include "pios_shm_priv.h"
 #include "pios_flash_posix_priv.h"
 #include "pios_flightgear.h"
 #include "pios_thread.h"
@@ -76,6 +80,12 @@ static bool debug_fpe=false;
 #define MAX_SPI_BUSES 16
 
 bool are_realtime = false;
+int realtime_cpu = -1;
+
+#ifdef __linux__
+static cpu_set_t realtime_cpus;
+static bool realtime_cpus_set;
+#endif
 
 #ifdef PIOS_INCLUDE_SPI
 static int num_spi = 0;
@@ -107,17 +117,32 @@ int orig_stdout;
 static void Usage(char *cmdName) {
 	printf( "usage: %s [-f] [-r] [-m orientation] [-p proto] [-s spibase]\n"
 		"\t\t[-d drvname:bus:id] [-l logfile] [-I i2cdev] [-i drvname:bus]\n"
-		"\t\t[-g port] [-c confflash] [-x time] -!\n"
+		"\t\t[-g port] [-c confflash] [-x time] [-!] [-L] [-R]\n"
+		"\t\t[-a cpulist] [-A cpu] [-P replayfile]\n"
 		"\n"
 #if !(defined(_WIN32) || defined(WIN32) || defined(__MINGW32__))
 		"\t-f\t\t\tEnables floating point exception trapping mode\n"
 #endif
 #ifdef __linux__
 		"\t-r\t\t\tGoes realtime and pins all memory (requires root)\n"
+		"\t-a cpulist\t\tCPUs to run on when realtime, e.g. 0,2-3\n"
+		"\t\t\t\t(default 0)\n"
+		"\t-A cpu\t\t\tCPU for the highest priority (flight loop)\n"
+		"\t\t\t\tthreads alone when realtime; isolate it\n"
+		"\t\t\t\twith isolcpus= for the least jitter\n"
 #endif
 		"\t-!\t\t\tUse a fake clock timebase gated by gcs/simsensors\n"
+		"\t-L\t\t\tRun the fake clock in lockstep, as fast as possible;\n"
+		"\t\t\t\t-x then counts simulated seconds\n"
+		"\t-R\t\t\tSimulate multirotors as a rigid body flown by\n"
+		"\t\t\t\tActuatorCommand, with motor dynamics\n"
 		"\t-l log\t\t\tWrites simulation data to a log\n"
 		"\t-g port\t\t\tStarts FlightGear driver on port\n"
+#ifdef PIOS_INCLUDE_SENSORREPLAY
+		"\t-P replayfile\t\tFeeds the sensors from a recording made\n"
+		"\t\t\t\tby dronin-sensorreplay, in real time (or\n"
+		"\t\t\t\tsimulated time with -L)\n"
+#endif
 #ifdef PIOS_INCLUDE_SIMSENSORS_YASIM
 		"\t-y\t\t\tUse an external simulator (drhil yasim)\n"
 #endif
@@ -125,6 +150,8 @@ static void Usage(char *cmdName) {
 		"\t-x time\t\t\tExit after time seconds\n"
 #endif
 		"\t-S drvname:serialpath\tStarts a serial driver on serialpath\n"
+		"\t\t\tserialpath may be a TCP port, stdio, or\n"
+		"\t\t\tshm:/dev/shm/dronin-name for a shared memory ring\n"
 		"\t\t\tAvailable drivers: gps msp lighttelemetry telemetry omnip\n\n"
 #ifdef PIOS_INCLUDE_SPI
 		"\t-p proto\t\tSpecify a flyingpio rcvr protocol\n"
@@ -151,6 +178,32 @@ static void Usage(char *cmdName) {
 #include <pios_omnip.h>
 #endif
 
+#ifdef PIOS_INCLUDE_SENSORREPLAY
+static int32_t sensor_replay_read(void *ctx, uint8_t *buf, uint32_t len)
+{
+	return fread(buf, 1, len, (FILE *) ctx);
+}
+
+static int handle_sensor_replay(const char *fname)
+{
+	FILE *f = fopen(fname, "rb");
+
+	if (!f) {
+		perror("fopen");
+		return -1;
+	}
+
+	pios_sensorreplay_t dontcare;
+
+	if (PIOS_SENSORREPLAY_Init(&dontcare, sensor_replay_read, f)) {
+		fclose(f);
+		return -1;
+	}
+
+	return 0;
+}
+#endif
+
 #define SERIAL_BUF_LEN 384
 static int handle_serial_device(const char *optarg) {
 	char arg_copy[128];
@@ -194,6 +247,18 @@ static int handle_serial_device(const char *optarg) {
 
 		com_driver = &pios_tcp_com_driver;
 
+#ifdef PIOS_INCLUDE_SHM
+	} else if (!strcmp(ser_path, "shm")) {
+		char *shm_path = strtok_r(NULL, "", &saveptr);
+		if (shm_path == NULL) goto fail;
+
+		if (PIOS_SHM_Init(&lower_id, shm_path)) {
+			printf("Can't init shared memory\n");
+			goto fail;
+		}
+
+		com_driver = &pios_shm_com_driver;
+#endif
 	} else if (!strcmp(ser_path, "stdio")) {
 		if (PIOS_SERIAL_InitFromFd(&lower_id, STDIN_FILENO,
 					orig_stdout, true)) {
@@ -366,7 +431,7 @@ static int handle_device(const char *optarg) {
 		ms5611_cfg = PIOS_malloc(sizeof(*ms5611_cfg));
 
 		ms5611_cfg->oversampling = MS5611_OSR_512;
-		ms5611_cfg->temperature_interleaving = 1;
+		ms5611_cfg->temperature_interleaving = 10;
 
 		int ret = PIOS_MS5611_SPI_Init(spi_devs[bus_num], dev_num, ms5611_cfg);
 
@@ -433,6 +498,52 @@ fail:
 }
 #endif
 
+#ifdef __linux__
+/* Parses a list like 0,2-3 into cpus */
+static int parse_cpu_list(const char *list, cpu_set_t *cpus)
+{
+	CPU_ZERO(cpus);
+
+	while (*list) {
+		char *endptr;
+
+		long first = strtol(list, &endptr, 10);
+		long last = first;
+
+		if (endptr == list) {
+			return -1;
+		}
+
+		if (*endptr == '-') {
+			list = endptr + 1;
+			last = strtol(list, &endptr, 10);
+
+			if (endptr == list) {
+				return -1;
+			}
+		}
+
+		if ((first < 0) || (last < first) || (last >= CPU_SETSIZE)) {
+			return -1;
+		}
+
+		for (long i = first; i <= last; i++) {
+			CPU_SET(i, cpus);
+		}
+
+		if (*endptr == ',') {
+			endptr++;
+		} else if (*endptr) {
+			return -1;
+		}
+
+		list = endptr;
+	}
+
+	return CPU_COUNT(cpus) ? 0 : -1;
+}
+#endif
+
 static void go_realtime() {
 #ifdef __linux__
 	/* First, pin all our memory.  We don't want stuff we need
@@ -444,15 +555,26 @@ static void go_realtime() {
 		exit(1);
 	}
 
-	/* We always run on the same processor-- why migrate when
+#ifdef __GLIBC__
+	/* ... and keep what we free, rather than handing it back and taking
+	 * page faults to lock it in again the next time. */
+	mallopt(M_TRIM_THRESHOLD, -1);
+	mallopt(M_MMAP_MAX, 0);
+#endif
+
+	/* We always run on the same processor(s)-- why migrate when
 	 * you never yield?
 	 */
 
 	cpu_set_t allowable_cpus;
 
-	CPU_ZERO(&allowable_cpus);
+	if (realtime_cpus_set) {
+		allowable_cpus = realtime_cpus;
+	} else {
+		CPU_ZERO(&allowable_cpus);
 
-	CPU_SET(0, &allowable_cpus);
+		CPU_SET(0, &allowable_cpus);
+	}
 
 	rc = sched_setaffinity(0, sizeof(allowable_cpus), &allowable_cpus);
 
@@ -488,6 +610,8 @@ static char **saved_argv;
 bool use_yasim;
 #endif
 
+bool use_rigidbody;
+
 void PIOS_SYS_Args(int argc, char *argv[]) {
 	saved_argc = argc;
 	saved_argv = argv;
@@ -495,8 +619,10 @@ void PIOS_SYS_Args(int argc, char *argv[]) {
 	int opt;
 
 	bool hw_argseen = true;
+	bool lockstep = false;
+	int exit_after = 0;
 
-	while ((opt = getopt(argc, argv, "!yfrx:g:l:s:d:S:I:i:m:c:p:")) != -1) {
+	while ((opt = getopt(argc, argv, "!LRyfrx:g:l:s:d:S:I:i:m:c:p:a:A:P:")) != -1) {
 		switch (opt) {
 #ifdef PIOS_INCLUDE_SIMSENSORS_YASIM
 			case 'y':
@@ -506,6 +632,12 @@ void PIOS_SYS_Args(int argc, char *argv[]) {
 			case '!':
 				PIOS_Thread_FakeClock_Tick();
 				break;
+			case 'L':
+				lockstep = true;
+				break;
+			case 'R':
+				use_rigidbody = true;
+				break;
 			case 'c':
 				PIOS_Flash_Posix_SetFName(optarg);
 				break;
@@ -520,6 +652,40 @@ void PIOS_SYS_Args(int argc, char *argv[]) {
 
 				go_realtime();
 				break;
+#ifdef __linux__
+			case 'a':
+				if (are_realtime) {
+					printf("Affinity must be before realtime\n");
+					exit(1);
+				}
+
+				if (parse_cpu_list(optarg, &realtime_cpus)) {
+					printf("Invalid CPU list %s\n", optarg);
+					exit(1);
+				}
+
+				realtime_cpus_set = true;
+				break;
+			case 'A':
+			{
+				char *endptr;
+
+				if (are_realtime) {
+					printf("Affinity must be before realtime\n");
+					exit(1);
+				}
+
+				realtime_cpu = strtol(optarg, &endptr, 10);
+
+				if ((endptr == optarg) || (*endptr != '\0') ||
+						(realtime_cpu < 0) ||
+						(realtime_cpu >= CPU_SETSIZE)) {
+					printf("Invalid CPU %s\n", optarg);
+					exit(1);
+				}
+				break;
+			}
+#endif
 			case 'l':
 			{
 				uintptr_t tmp;
@@ -645,12 +811,21 @@ void PIOS_SYS_Args(int argc, char *argv[]) {
 				hw_argseen = false;
 				break;
 			}
+#ifdef PIOS_INCLUDE_SENSORREPLAY
+			case 'P':
+				if (handle_sensor_replay(optarg)) {
+					printf("Couldn't start sensor replay %s\n",
+							optarg);
+					exit(1);
+				}
+
+				hw_argseen = false;
+				break;
+#endif
 #if !(defined(_WIN32) || defined(WIN32) || defined(__MINGW32__))
 			case 'x':
 			{
-				int timeout = atoi(optarg);
-
-				alarm(timeout);
+				exit_after = atoi(optarg);
 				break;
 			}
 #endif
@@ -664,6 +839,17 @@ void PIOS_SYS_Args(int argc, char *argv[]) {
 	if (optind < argc) {
 		Usage(argv[0]);
 	}
+
+	if (lockstep) {
+		PIOS_Thread_FakeClock_Lockstep(exit_after * 1000);
+		return;
+	}
+
+#if !(defined(_WIN32) || defined(WIN32) || defined(__MINGW32__))
+	if (exit_after) {
+		alarm(exit_after);
+	}
+#endif
 }
 
 /**
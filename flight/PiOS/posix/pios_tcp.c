@@ -39,6 +39,7 @@
 #if defined(PIOS_INCLUDE_TCP)
 
 #include <pios_tcp_priv.h>
+#include <pios_reactor.h>
 #include "pios_thread.h"
 #include <unistd.h>
 #include <sys/types.h>
@@ -70,6 +71,10 @@ typedef struct {
 	pios_com_callback rx_in_cb;
 	uintptr_t rx_in_context;
 
+	/* Read but not yet taken by the COM layer */
+	uint16_t rx_offset;
+	uint16_t rx_len;
+
 	uint8_t rx_buffer[PIOS_TCP_RX_BUFFER_SIZE];
 	uint8_t tx_buffer[PIOS_TCP_RX_BUFFER_SIZE];
 } pios_tcp_dev;
@@ -89,109 +94,125 @@ static pios_tcp_dev * find_tcp_dev_by_id(uintptr_t tcp)
 	return (pios_tcp_dev *) tcp;
 }
 
-static void rx_cb_all(pios_tcp_dev *tcp_dev, uint8_t *incoming_buffer,
-		int len) {
-	int sent = 0;
-
-	bool rx_need_yield = false;
-
-	sent = tcp_dev->rx_in_cb(tcp_dev->rx_in_context, incoming_buffer, len,
-			NULL, &rx_need_yield);
+/**
+ * Hands the COM layer what's left of the last read.  While on other drivers
+ * it may be desirable to spill immediately if the consumer is not keeping
+ * up, TCP is self-regulating in speed and GCS may want to really hammer us.
+ * Let's not let the client run-ahead and force us to drop stuff that we've
+ * read; instead hold on to it, and stop reading until it's gone.
+ * \return true if everything has been taken
+ */
+static bool rx_deliver(pios_tcp_dev *tcp_dev)
+{
+	while (tcp_dev->rx_offset < tcp_dev->rx_len) {
+		if (!tcp_dev->rx_in_cb) {
+			break;
+		}
 
-	if (sent < 0) {
-		return;
-	}
+		bool rx_need_yield = false;
 
-	while (sent < len) {
-		PIOS_Thread_Sleep(2);
+		int sent = tcp_dev->rx_in_cb(tcp_dev->rx_in_context,
+				tcp_dev->rx_buffer + tcp_dev->rx_offset,
+				tcp_dev->rx_len - tcp_dev->rx_offset,
+				NULL, &rx_need_yield);
 
-		int sent_chunk = tcp_dev->rx_in_cb(tcp_dev->rx_in_context,
-			incoming_buffer, len, NULL, &rx_need_yield);
+		if (sent < 0) {
+			break;
+		}
 
-		if (sent_chunk < 0) {
-			return;
+		if (sent == 0) {
+			return false;
 		}
 
-		sent += sent_chunk;
+		tcp_dev->rx_offset += sent;
 	}
+
+	tcp_dev->rx_offset = tcp_dev->rx_len = 0;
+
+	return true;
 }
 
-/**
- * RxTask
- */
-static void PIOS_TCP_RxTask(void *tcp_dev_n)
+static bool tcp_listen_ready(uintptr_t context);
+
+static bool tcp_connection_ready(uintptr_t context)
 {
-	pios_tcp_dev *tcp_dev = (pios_tcp_dev*)tcp_dev_n;
-	
-	const int INCOMING_BUFFER_SIZE = 16;
-	uint8_t incoming_buffer[INCOMING_BUFFER_SIZE];
-	int error;
+	pios_tcp_dev *tcp_dev = (pios_tcp_dev *) context;
 
-	while (1) {
-	
-		do
-		{
-			tcp_dev->socket_connection = accept(tcp_dev->socket, NULL, NULL);
-			error = errno;
-
-			PIOS_Thread_Sleep(1);
-		} while (tcp_dev->socket_connection == INVALID_SOCKET && (error == EINTR || error == EAGAIN));
-
-		if (tcp_dev->socket_connection < 0) {
-			int error = errno;
-			(void)error;
-			perror("Accept failed");
-			close(tcp_dev->socket);
-			exit(EXIT_FAILURE);
-		}
+	if (!rx_deliver(tcp_dev)) {
+		return false;
+	}
 
-		fprintf(stderr, "Connection accepted\n");
+	int result = recv(tcp_dev->socket_connection,
+			(void *) tcp_dev->rx_buffer, PIOS_TCP_RX_BUFFER_SIZE, 0);
 
-		while (1) {
-			// Received is used to track the scoket whereas the dev variable is only updated when it can be
+	if (result > 0) {
+		tcp_dev->rx_len = result;
 
-			int result = recv(tcp_dev->socket_connection,
-					(void *) incoming_buffer,
-					INCOMING_BUFFER_SIZE, 0);
-			error = errno;
+		return rx_deliver(tcp_dev);
+	}
 
-			if (result > 0 && tcp_dev->rx_in_cb) {
-				/* While on other drivers it may be desirable to
-				 * spill immediately if the consumer is not
-				 * keeping up, TCP is self-regulating in speed
-				 * and GCS may want to really hammer us.  Let's
-				 * not let the client run-ahead and force us to
-				 * drop stuff that we've read.
-				 */
+	if (result == -1 && (errno == EAGAIN || errno == EINTR)) {
+		return true;
+	}
 
-				rx_cb_all(tcp_dev, incoming_buffer, result);
+	/* Closed, or broken; wait for the next one */
+	PIOS_Reactor_Remove(tcp_dev->socket_connection);
 
-			}
+	close(tcp_dev->socket_connection);
+	tcp_dev->socket_connection = INVALID_SOCKET;
 
-			if (result == 0) {
-				break;
-			}
+	PIOS_Reactor_Add(tcp_dev->socket, tcp_listen_ready,
+			(uintptr_t) tcp_dev);
 
-			if (result == -1) {
-				if (error == EAGAIN)
-					PIOS_Thread_Sleep(1);
-				else if (error == EINTR)
-					(void)error;
-				else
-					break;
-			}
+	return true;
+}
+
+static bool tcp_listen_ready(uintptr_t context)
+{
+	pios_tcp_dev *tcp_dev = (pios_tcp_dev *) context;
+
+	int connection = accept(tcp_dev->socket, NULL, NULL);
+
+	if (connection == INVALID_SOCKET) {
+		if (errno == EINTR || errno == EAGAIN ||
+				errno == EWOULDBLOCK ||
+				errno == ECONNABORTED) {
+			return true;
 		}
-		
-		close(tcp_dev->socket_connection);
+
+		perror("Accept failed");
+		close(tcp_dev->socket);
+		exit(EXIT_FAILURE);
+	}
+
+	fprintf(stderr, "Connection accepted\n");
+
+	/* One client at a time; the rest queue up in the backlog */
+	PIOS_Reactor_Remove(tcp_dev->socket);
+
+	/* Some hosts hand the listening socket's O_NONBLOCK on; sends
+	 * should still block */
+	fcntl(connection, F_SETFL, 0);
+
+	tcp_dev->rx_offset = tcp_dev->rx_len = 0;
+	tcp_dev->socket_connection = connection;
+
+	if (PIOS_Reactor_Add(connection, tcp_connection_ready,
+				(uintptr_t) tcp_dev)) {
+		close(connection);
 		tcp_dev->socket_connection = INVALID_SOCKET;
+
+		PIOS_Reactor_Add(tcp_dev->socket, tcp_listen_ready,
+				(uintptr_t) tcp_dev);
 	}
+
+	return true;
 }
 
 
 /**
  * Open TCP socket
  */
-struct pios_thread *tcpRxTaskHandle;
 int32_t PIOS_TCP_Init(uintptr_t *tcp_id, const struct pios_tcp_cfg * cfg)
 {
 	pios_tcp_dev *tcp_dev = PIOS_malloc(sizeof(pios_tcp_dev));
@@ -241,8 +262,16 @@ int32_t PIOS_TCP_Init(uintptr_t *tcp_id, const struct pios_tcp_cfg * cfg)
 		exit(EXIT_FAILURE);
 	}
 	
-	tcpRxTaskHandle = PIOS_Thread_Create(
-			PIOS_TCP_RxTask, "pios_tcp_rx", PIOS_THREAD_STACK_SIZE_MIN, tcp_dev, PIOS_THREAD_PRIO_HIGHEST);
+	/* So a client that goes away between the wakeup and the accept
+	 * can't leave the reactor stuck in accept() */
+	fcntl(tcp_dev->socket, F_SETFL, O_NONBLOCK);
+
+	res = PIOS_Reactor_Add(tcp_dev->socket, tcp_listen_ready,
+			(uintptr_t) tcp_dev);
+	if (res == -1) {
+		fprintf(stderr, "Socket can't be watched\n");
+		exit(EXIT_FAILURE);
+	}
 	
 	printf("tcp dev %p - socket %i opened - result %i\n", tcp_dev, tcp_dev->socket, res);
 	
@@ -307,8 +336,8 @@ static void PIOS_TCP_RegisterRxCallback(uintptr_t tcp_id, pios_com_callback rx_i
 	PIOS_Assert(tcp_dev);
 	
 	/*
-	 * Order is important in these assignments since ISR uses _cb
-	 * field to determine if it's ok to dereference _cb and _context
+	 * Order is important in these assignments since the reactor uses
+	 * _cb field to determine if it's ok to dereference _cb and _context
 	 */
 	tcp_dev->rx_in_context = context;
 	tcp_dev->rx_in_cb = rx_in_cb;
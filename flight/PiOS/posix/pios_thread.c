@@ -25,6 +25,8 @@
 
 
 #include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
 #include <unistd.h>
 
 #include <pios.h>
@@ -34,6 +36,34 @@
 
 bool __attribute__((weak)) are_realtime;
 
+/* CPU dedicated to PIOS_THREAD_PRIO_HIGHEST threads when realtime, or -1 to
+ * leave them with the rest of the process. */
+int __attribute__((weak)) realtime_cpu = -1;
+
+/* Scheduling for each pios priority when realtime.  The flight loop
+ * threads are FIFO, so nothing of equal priority timeslices them; the
+ * levels that many modules share stay round robin.  Everything is kept
+ * below 50, where PREEMPT_RT runs the threaded IRQ handlers the sensor
+ * buses depend on. */
+static const struct {
+	int policy;
+	int priority;
+} realtime_sched[] = {
+	[PIOS_THREAD_PRIO_LOW] = { SCHED_RR, 20 },
+	[PIOS_THREAD_PRIO_NORMAL] = { SCHED_RR, 30 },
+	[PIOS_THREAD_PRIO_HIGH] = { SCHED_FIFO, 40 },
+	[PIOS_THREAD_PRIO_HIGHEST] = { SCHED_FIFO, 49 },
+};
+
+/* Stack sizes passed in are tuned for the flight controllers; code here
+ * runs on the host libc, which wants a good deal more (printf alone can
+ * take several kilobytes).  Scale them up, but stay well under the 8MB
+ * pthread default: with many simulated vehicles on one box, or with -r
+ * locking every page, that default is most of each process's footprint.
+ */
+#define POSIX_STACK_SCALE 32
+#define POSIX_STACK_MIN (256 * 1024)
+
 struct pios_thread
 {
 	pthread_t thread;
@@ -41,6 +71,66 @@ struct pios_thread
 	const char *name;
 };
 
+static volatile uint32_t fake_clock;
+static pthread_cond_t fake_clock_cond = PTHREAD_COND_INITIALIZER;
+static pthread_mutex_t fake_clock_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+#ifdef PIOS_INCLUDE_FAKETICK
+/* How long the ticker waits for everyone to go quiet before giving up and
+ * advancing anyways, in real ms.  Only a thread stuck on something the
+ * lockstep accounting doesn't know about should ever hit this.
+ */
+#define LOCKSTEP_STALL_MS 50
+
+/* A thread sleeping on the fake clock in lockstep mode.  Lives on the
+ * sleeper's stack; the ticker clears parked when the expiration comes up,
+ * so the thread counts as busy again from that very tick.
+ */
+struct fake_sleeper {
+	uint32_t expiration;
+	bool parked;
+	struct fake_sleeper *next;
+};
+
+static bool fake_lockstep;
+static uint32_t fake_exit_time;
+static int fake_threads;	/* threads the ticker waits on */
+static int fake_parked;		/* ... of which sleeping or blocked in I/O */
+static uint32_t fake_stalls;
+static struct fake_sleeper *fake_sleepers;
+static __thread bool fake_counted;
+
+static void fake_threads_adjust(int delta)
+{
+	pthread_mutex_lock(&fake_clock_mutex);
+
+	fake_threads += delta;
+	pthread_cond_broadcast(&fake_clock_cond);
+
+	pthread_mutex_unlock(&fake_clock_mutex);
+}
+#endif
+
+struct thread_start {
+	void (*fp)(void *);
+	void *argp;
+};
+
+static void *thread_trampoline(void *arg)
+{
+	struct thread_start start = *(struct thread_start *) arg;
+
+	free(arg);
+
+#ifdef PIOS_INCLUDE_FAKETICK
+	fake_counted = true;
+#endif
+
+	start.fp(start.argp);
+
+	return NULL;
+}
+
 /**
  * @brief   Creates a handle for the current thread.
  *
@@ -60,12 +150,20 @@ struct pios_thread *PIOS_Thread_WrapCurrentThread(const char *namep)
 
 	thread->name = namep;
 
+#ifdef PIOS_INCLUDE_FAKETICK
+	fake_counted = true;
+	fake_threads_adjust(1);
+#endif
+
 	if (are_realtime) {
 		struct sched_param param = {
-			.sched_priority = 30 + PIOS_THREAD_PRIO_HIGHEST * 5
+			.sched_priority =
+				realtime_sched[PIOS_THREAD_PRIO_HIGHEST].priority
 		};
 
-		pthread_setschedparam(thread->thread, SCHED_RR, &param);
+		pthread_setschedparam(thread->thread,
+				realtime_sched[PIOS_THREAD_PRIO_HIGHEST].policy,
+				&param);
 	}
 
 #ifdef __linux__
@@ -80,8 +178,12 @@ void PIOS_Thread_ChangePriority(enum pios_thread_prio_e prio)
 	(void) prio;
 #ifdef __linux__
 	if (are_realtime) {
-		int pri_val = 30 + prio * 5;
-		pthread_setschedprio(pthread_self(), pri_val);
+		struct sched_param param = {
+			.sched_priority = realtime_sched[prio].priority
+		};
+
+		pthread_setschedparam(pthread_self(),
+				realtime_sched[prio].policy, &param);
 	}
 #endif
 }
@@ -97,25 +199,66 @@ struct pios_thread *PIOS_Thread_Create(void (*fp)(void *), const char *namep, si
 		abort();
 	}
 
+	size_t stack_size = stack_bytes * POSIX_STACK_SCALE;
+
+	if (stack_size < POSIX_STACK_MIN) {
+		stack_size = POSIX_STACK_MIN;
+	}
+
+	if (pthread_attr_setstacksize(&attr, stack_size)) {
+		perror("pthread_attr_setstacksize");
+		abort();
+	}
+
 	if (are_realtime) {
 		struct sched_param param = {
-			.sched_priority = 30 + prio * 5
+			.sched_priority = realtime_sched[prio].priority
 		};
 
 		pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
-		pthread_attr_setschedpolicy(&attr, SCHED_RR);
+		pthread_attr_setschedpolicy(&attr, realtime_sched[prio].policy);
 		pthread_attr_setschedparam(&attr, &param);
+
+#ifdef __linux__
+		if ((prio == PIOS_THREAD_PRIO_HIGHEST) && (realtime_cpu >= 0)) {
+			cpu_set_t cpus;
+
+			CPU_ZERO(&cpus);
+			CPU_SET(realtime_cpu, &cpus);
+
+			pthread_attr_setaffinity_np(&attr, sizeof(cpus), &cpus);
+		}
+#endif
 	}
 
 	thread->name = namep;
 
-	void *(*thr_func)(void *) = (void *) fp;
+	struct thread_start *start = malloc(sizeof(*start));
+
+	if (!start) {
+		free(thread);
+		return NULL;
+	}
+
+	start->fp = fp;
+	start->argp = argp;
+
+	/* Counted before it exists, so the ticker can't get ahead of it */
+#ifdef PIOS_INCLUDE_FAKETICK
+	fake_threads_adjust(1);
+#endif
 
-	int ret = pthread_create(&thread->thread, &attr, thr_func, argp);
+	int ret = pthread_create(&thread->thread, &attr, thread_trampoline,
+			start);
 
 	if (ret) {
 		printf("Couldn't start thr (%s) ret=%d\n", namep, ret);
 
+#ifdef PIOS_INCLUDE_FAKETICK
+		fake_threads_adjust(-1);
+#endif
+
+		free(start);
 		free(thread);
 		return NULL;
 	}
@@ -141,13 +284,15 @@ void PIOS_Thread_Delete(struct pios_thread *threadp)
 	free(threadp);
 #endif
 
+#ifdef PIOS_INCLUDE_FAKETICK
+	if (fake_counted) {
+		fake_threads_adjust(-1);
+	}
+#endif
+
 	pthread_exit(0);
 }
 
-static volatile uint32_t fake_clock;
-static pthread_cond_t fake_clock_cond = PTHREAD_COND_INITIALIZER;
-static pthread_mutex_t fake_clock_mutex = PTHREAD_MUTEX_INITIALIZER;
-
 static inline uint32_t PIOS_Thread_GetClock_Impl()
 {
 	struct timespec monotime;
@@ -170,6 +315,57 @@ void PIOS_Thread_FakeClock_UpdateBarrier(uint32_t increment)
 	pthread_mutex_unlock(&fake_clock_mutex);
 }
 
+/**
+ * @brief Waits, with the fake clock lock held, until every counted thread
+ * other than the caller is parked.  Gives up after LOCKSTEP_STALL_MS of
+ * real time so that a thread waiting on something outside the accounting
+ * (a mutex held across a sleep, say) slows the simulation instead of
+ * hanging it.
+ */
+static void fake_wait_quiescent(void)
+{
+	int self = fake_counted ? 1 : 0;
+
+	struct timespec abstime;
+
+	clock_gettime(CLOCK_REALTIME, &abstime);
+
+	abstime.tv_nsec += LOCKSTEP_STALL_MS * 1000000;
+
+	if (abstime.tv_nsec >= 1000000000) {
+		abstime.tv_nsec -= 1000000000;
+		abstime.tv_sec += 1;
+	}
+
+	while (fake_parked + self < fake_threads) {
+		if (pthread_cond_timedwait(&fake_clock_cond,
+					&fake_clock_mutex, &abstime)) {
+			if (!fake_stalls++) {
+				printf("Lockstep: %d of %d threads still busy, advancing anyways\n",
+						fake_threads - self - fake_parked,
+						fake_threads - self);
+			}
+
+			break;
+		}
+	}
+}
+
+/**
+ * @brief Marks the sleepers whose time has come as busy again.  Called with
+ * the fake clock lock held, right after advancing the clock.
+ */
+static void fake_wake_sleepers(void)
+{
+	for (struct fake_sleeper *s = fake_sleepers; s; s = s->next) {
+		if (s->parked &&
+				((fake_clock - s->expiration) < 0x80000000)) {
+			s->parked = false;
+			fake_parked--;
+		}
+	}
+}
+
 void PIOS_Thread_FakeClock_Tick(void)
 {
 	bool blocked = false;
@@ -192,18 +388,103 @@ void PIOS_Thread_FakeClock_Tick(void)
 		HwSimulationFakeTickBlockedSet(&val);
 	}
 
+	if (fake_lockstep) {
+		fake_wait_quiescent();
+	}
+
 	if (fake_clock == 0) {
 		fake_clock = PIOS_Thread_GetClock_Impl() + 1;
 	} else {
 		fake_clock++;
 	}
 
+	if (fake_lockstep) {
+		fake_wake_sleepers();
+	}
+
 	pthread_cond_broadcast(&fake_clock_cond);
 
 	pthread_mutex_unlock(&fake_clock_mutex);
+
+	if (fake_exit_time && (PIOS_Thread_Systime() >= fake_exit_time)) {
+		printf("Lockstep: %u ms simulated, %u stalled ticks.  Exiting\n",
+				fake_exit_time, fake_stalls);
+		exit(0);
+	}
+}
+
+/**
+ * @brief Switches the fake clock to lockstep.  Each tick then waits until
+ * every firmware thread is sleeping on the fake clock or blocked in I/O, so
+ * the simulation runs as fast as the work allows and the result of a run
+ * doesn't depend on how the host schedules threads.  Starts the fake clock
+ * if it isn't already.
+ * @param[in] exit_after_ms exit the process after this much simulated time,
+ * or 0 to run forever
+ */
+void PIOS_Thread_FakeClock_Lockstep(uint32_t exit_after_ms)
+{
+	fake_lockstep = true;
+
+	if (!fake_clock) {
+		PIOS_Thread_FakeClock_Tick();
+	}
+
+	if (exit_after_ms) {
+		fake_exit_time = PIOS_Thread_Systime() + exit_after_ms;
+	}
+}
+
+/**
+ * @brief Marks the calling thread as blocked on something outside the
+ * firmware, such as a socket, so lockstep ticks don't wait for it.  Pair
+ * with PIOS_Thread_FakeClock_Unpark() as soon as the call returns.
+ */
+void PIOS_Thread_FakeClock_Park(void)
+{
+	if (!fake_counted) {
+		return;
+	}
+
+	pthread_mutex_lock(&fake_clock_mutex);
+
+	fake_parked++;
+	pthread_cond_broadcast(&fake_clock_cond);
+
+	pthread_mutex_unlock(&fake_clock_mutex);
+}
+
+void PIOS_Thread_FakeClock_Unpark(void)
+{
+	if (!fake_counted) {
+		return;
+	}
+
+	pthread_mutex_lock(&fake_clock_mutex);
+
+	fake_parked--;
+
+	pthread_mutex_unlock(&fake_clock_mutex);
+}
+#else
+void PIOS_Thread_FakeClock_Park(void)
+{
+}
+
+void PIOS_Thread_FakeClock_Unpark(void)
+{
 }
 #endif
 
+bool PIOS_Thread_FakeClock_IsLockstep(void)
+{
+#ifdef PIOS_INCLUDE_FAKETICK
+	return fake_lockstep;
+#else
+	return false;
+#endif
+}
+
 bool PIOS_Thread_FakeClock_IsActive(void)
 {
 	return fake_clock != 0;
@@ -229,6 +510,8 @@ uint32_t PIOS_Thread_Systime(void)
 void PIOS_Thread_Sleep(uint32_t time_ms)
 {
 	if (time_ms == PIOS_THREAD_TIMEOUT_MAX) {
+		PIOS_Thread_FakeClock_Park();
+
 		while (true) {
 			usleep(50000000); /* 50s */
 		}
@@ -239,6 +522,37 @@ void PIOS_Thread_Sleep(uint32_t time_ms)
 
 		uint32_t expiration = fake_clock + time_ms;
 
+#ifdef PIOS_INCLUDE_FAKETICK
+		if (fake_lockstep && fake_counted) {
+			struct fake_sleeper me = {
+				.expiration = time_ms ? expiration : expiration + 1,
+				.parked = true,
+				.next = fake_sleepers,
+			};
+
+			fake_sleepers = &me;
+			fake_parked++;
+			pthread_cond_broadcast(&fake_clock_cond);
+
+			while (me.parked) {
+				pthread_cond_wait(&fake_clock_cond,
+						&fake_clock_mutex);
+			}
+
+			struct fake_sleeper **pp = &fake_sleepers;
+
+			while (*pp != &me) {
+				pp = &(*pp)->next;
+			}
+
+			*pp = me.next;
+
+			pthread_mutex_unlock(&fake_clock_mutex);
+
+			return;
+		}
+#endif
+
 		while ((expiration - fake_clock) <= time_ms) {
 			pthread_cond_wait(&fake_clock_cond,
 					&fake_clock_mutex);
@@ -278,6 +592,16 @@ uint32_t PIOS_Thread_Get_Runtime(struct pios_thread *threadp)
 	return 0;	/* XXX */
 }
 
+uint32_t PIOS_Thread_Get_Idle_Runtime(void)
+{
+	return 0;	/* XXX */
+}
+
+bool PIOS_Thread_Is_Native(struct pios_thread *threadp, uintptr_t native)
+{
+	return pthread_equal(threadp->thread, (pthread_t) native);
+}
+
 bool PIOS_Thread_Period_Elapsed(const uint32_t prev_systime,
 		const uint32_t increment_ms)
 {
@@ -288,6 +612,77 @@ bool PIOS_Thread_Period_Elapsed(const uint32_t prev_systime,
 	return increment_ms <= interval;
 }
 
+/* Histogram of how far a loop strays from its period, in power of two
+ * buckets: 0us, 1us, 2-3us, 4-7us ... the last takes everything over */
+#define JITTER_BUCKETS 18
+
+static struct {
+	const char *name;
+	uint32_t expected_us;
+	uint32_t buckets[JITTER_BUCKETS];
+	uint32_t samples;
+	uint32_t worst_us;
+} jitter;
+
+static void jitter_report(void)
+{
+	printf("%s: %u loops, %u us period, worst deviation %u us\n",
+			jitter.name, jitter.samples, jitter.expected_us,
+			jitter.worst_us);
+
+	for (int i = 0; i < JITTER_BUCKETS; i++) {
+		if (!jitter.buckets[i]) {
+			continue;
+		}
+
+		uint32_t lo = i ? (1 << (i - 1)) : 0;
+
+		if (i == JITTER_BUCKETS - 1) {
+			printf("\t>= %6u us: %u\n", lo, jitter.buckets[i]);
+		} else {
+			printf("\t< %7u us: %u\n", 1 << i, jitter.buckets[i]);
+		}
+	}
+}
+
+/**
+ * @brief Records one period of a loop, printed as a histogram of its
+ * deviation from the expected period when flightd exits.  Only one loop
+ * (the first to call) is tracked; it is meant for the stabilization loop
+ * when running realtime.  Must be called from a single thread.
+ * @param[in] name what to call the loop in the report
+ * @param[in] period_us how long this iteration took
+ * @param[in] expected_us how long it should have taken
+ */
+void PIOS_Thread_RecordJitter(const char *name, uint32_t period_us,
+		uint32_t expected_us)
+{
+	if (!jitter.name) {
+		jitter.name = name;
+		atexit(jitter_report);
+	} else if (jitter.name != name) {
+		return;
+	}
+
+	jitter.expected_us = expected_us;
+
+	uint32_t dev = (period_us > expected_us) ?
+		(period_us - expected_us) : (expected_us - period_us);
+
+	int bucket = dev ? (32 - __builtin_clz(dev)) : 0;
+
+	if (bucket >= JITTER_BUCKETS) {
+		bucket = JITTER_BUCKETS - 1;
+	}
+
+	jitter.buckets[bucket]++;
+	jitter.samples++;
+
+	if (dev > jitter.worst_us) {
+		jitter.worst_us = dev;
+	}
+}
+
 /**
   * @}
   * @}
@@ -40,6 +40,20 @@
 #define UAVOBJ_ALL_INSTANCES 0xFFFF
 #define UAVOBJ_MAX_INSTANCES 1000
 
+/*
+ * The settings digest read with UAVObjReadSettingsDigest, all little endian:
+ *   uint64_t  UAVOHASH of the firmware
+ *   uint8_t   serial number of the CPU, PIOS_SYS_SERIAL_NUM_BINARY_LEN bytes
+ *   uint32_t  fingerprint: CRC32 of all the records
+ * followed by a record for each settings object, and for each metaobject
+ * whose metadata was changed from the defaults:
+ *   uint32_t  object ID
+ *   uint32_t  CRC32 of the packed data of instance 0
+ * The CRCs are PIOS_CRC32_updateCRC from 0.
+ */
+#define UAVOBJ_DIGEST_HEADER_LEN (8 + PIOS_SYS_SERIAL_NUM_BINARY_LEN + 4)
+#define UAVOBJ_DIGEST_RECORD_LEN 8
+
 /*
  * Shifts and masks used to read/write metadata flags.
  */
@@ -63,6 +77,16 @@ typedef enum {
 	UPDATEMODE_THROTTLED = 3 /** Object is updated on change, but not more often than the interval time */
 } UAVObjUpdateMode;
 
+/**
+ * Telemetry priority class, used by the telemetry scheduler when the link
+ * can not keep up with every update
+ */
+typedef enum {
+	TELEMETRYPRIORITY_NORMAL = 0, /** Periodic updates are skipped only when the link is overcommitted */
+	TELEMETRYPRIORITY_HIGH = 1, /** Always sent, never deferred or stretched */
+	TELEMETRYPRIORITY_LOW = 2 /** Deferred first, and its period is stretched while the link is saturated */
+} UAVObjTelemetryPriority;
+
 /**
  * Object metadata, each object has a meta object that holds its metadata. The metadata define
  * properties for each object and can be used by multiple modules (e.g. telemetry and logger)
@@ -78,12 +102,15 @@ typedef enum {
  *      3    gcsTelemetryAcked        Defines if an ack is required for the transactions of this object (1:acked, 0:not acked)
  *    4-5    telemetryUpdateMode      Update mode used by the telemetry module (UAVObjUpdateMode)
  *    6-7    gcsTelemetryUpdateMode   Update mode used by the GCS (UAVObjUpdateMode)
+ *
+ * telemetryPriority holds the UAVObjTelemetryPriority used by the telemetry module.
  */
 typedef struct {
 	uint8_t flags; /** Defines flags for update and logging modes and whether an update should be ACK'd (bits defined above) */
 	uint16_t telemetryUpdatePeriod; /** Update period used by the telemetry module (only if telemetry mode is PERIODIC) */
 	uint16_t gcsTelemetryUpdatePeriod; /** Update period used by the GCS (only if telemetry mode is PERIODIC) */
 	uint16_t loggingUpdatePeriod; /** Update period used by the logging module (only if logging mode is PERIODIC) */
+	uint8_t telemetryPriority; /** Priority class used by the telemetry module (UAVObjTelemetryPriority) */
 } __attribute__((packed)) UAVObjMetadata;
 
 /**
@@ -143,8 +170,21 @@ typedef struct {
 	uint32_t eventCallbackErrors;
 	uint32_t lastCallbackErrorID;
 	uint32_t lastQueueErrorID;
+	uint32_t lastCallbackErrorDrops; /** Total drops so far for lastCallbackErrorID */
+	uint32_t eventCallbackMaxPending; /** High-water mark of nested pending callback events */
 } UAVObjStats;
 
+/**
+ * Execution time statistics for one connected callback
+ */
+struct UAVObjCallbackProfile {
+	uint32_t obj_id;
+	UAVObjEventCallback cb;
+	uint32_t calls;
+	uint32_t max_us;
+	uint32_t mean_us;
+};
+
 typedef void (*new_uavo_instance_cb_t)(uint32_t,uint32_t);
 void UAVObjRegisterNewInstanceCB(new_uavo_instance_cb_t callback);
 
@@ -152,17 +192,22 @@ int32_t UAVObjInitialize();
 void UAVObjGetStats(UAVObjStats* statsOut);
 void UAVObjClearStats();
 UAVObjHandle UAVObjRegister(uint32_t id,
-		int32_t isSingleInstance, int32_t isSettings, uint32_t numBytes, UAVObjInitializeCallback initCb);
+		int32_t isSingleInstance, int32_t isSettings, int32_t isFastRam,
+		int32_t isReadMostly, uint32_t numBytes,
+		UAVObjInitializeCallback initCb);
 UAVObjHandle UAVObjGetByID(uint32_t id);
 uint32_t UAVObjGetID(UAVObjHandle obj);
 uint32_t UAVObjGetNumBytes(UAVObjHandle obj);
+uint16_t UAVObjGetEventDrops(UAVObjHandle obj);
 uint16_t UAVObjGetNumInstances(UAVObjHandle obj);
 UAVObjHandle UAVObjGetLinkedObj(UAVObjHandle obj);
 uint16_t UAVObjCreateInstance(UAVObjHandle obj_handle, UAVObjInitializeCallback initCb);
 bool UAVObjIsSingleInstance(UAVObjHandle obj);
 bool UAVObjIsMetaobject(UAVObjHandle obj);
 bool UAVObjIsSettings(UAVObjHandle obj);
+void UAVObjSetSuppressUnchanged(UAVObjHandle obj, bool suppress);
 int32_t UAVObjUnpack(UAVObjHandle obj_handle, uint16_t instId, const uint8_t* dataIn);
+int32_t UAVObjUnpackField(UAVObjHandle obj_handle, uint16_t instId, const uint8_t* dataIn, uint32_t offset, uint32_t size);
 int32_t UAVObjPack(UAVObjHandle obj_handle, uint16_t instId, uint8_t* dataOut);
 int32_t UAVObjSave(UAVObjHandle obj_handle, uint16_t instId);
 int32_t UAVObjLoad(UAVObjHandle obj_handle, uint16_t instId);
@@ -179,13 +224,21 @@ int32_t UAVObjLoadMetaobjects();
 int32_t UAVObjDeleteMetaobjects();
 int32_t UAVObjSetData(UAVObjHandle obj_handle, const void* dataIn);
 int32_t UAVObjSetDataField(UAVObjHandle obj_handle, const void* dataIn, uint32_t offset, uint32_t size);
+int32_t UAVObjSetDataIfChanged(UAVObjHandle obj_handle, const void* dataIn);
+int32_t UAVObjSetDataFieldIfChanged(UAVObjHandle obj_handle, const void* dataIn, uint32_t offset, uint32_t size);
 int32_t UAVObjGetData(UAVObjHandle obj_handle, void* dataOut);
 int32_t UAVObjGetDataField(UAVObjHandle obj_handle, void* dataOut, uint32_t offset, uint32_t size);
 int32_t UAVObjSetInstanceData(UAVObjHandle obj_handle, uint16_t instId, const void* dataIn);
 int32_t UAVObjSetInstanceDataField(UAVObjHandle obj_handle, uint16_t instId, const void* dataIn, uint32_t offset, uint32_t size);
+int32_t UAVObjSetInstanceDataIfChanged(UAVObjHandle obj_handle, uint16_t instId, const void* dataIn);
+int32_t UAVObjSetInstanceDataFieldIfChanged(UAVObjHandle obj_handle, uint16_t instId, const void* dataIn, uint32_t offset, uint32_t size);
 int32_t UAVObjGetInstanceData(UAVObjHandle obj_handle, uint16_t instId, void* dataOut);
 int32_t UAVObjGetInstanceDataField(UAVObjHandle obj_handle, uint16_t instId, void* dataOut, uint32_t offset, uint32_t size);
+const void *UAVObjBorrowInstanceData(UAVObjHandle obj_handle, uint16_t instId);
+void UAVObjReleaseInstanceData(UAVObjHandle obj_handle);
 int32_t UAVObjSetMetadata(UAVObjHandle obj_handle, const UAVObjMetadata* dataIn);
+int32_t UAVObjSetDefaultMetadata(UAVObjHandle obj_handle, const UAVObjMetadata *defaults);
+int32_t UAVObjSetDefaultData(UAVObjHandle obj_handle, uint16_t instId, const void *defaults);
 int32_t UAVObjGetMetadata(UAVObjHandle obj_handle, UAVObjMetadata* dataOut);
 uint8_t UAVObjGetMetadataAccess(const UAVObjMetadata* dataOut);
 UAVObjAccessType UAVObjGetAccess(const UAVObjMetadata* dataOut);
@@ -200,6 +253,8 @@ UAVObjUpdateMode UAVObjGetTelemetryUpdateMode(const UAVObjMetadata* dataOut);
 void UAVObjSetTelemetryUpdateMode(UAVObjMetadata* dataOut, UAVObjUpdateMode val);
 UAVObjUpdateMode UAVObjGetGcsTelemetryUpdateMode(const UAVObjMetadata* dataOut);
 void UAVObjSetTelemetryGcsUpdateMode(UAVObjMetadata* dataOut, UAVObjUpdateMode val);
+UAVObjTelemetryPriority UAVObjGetTelemetryPriority(const UAVObjMetadata* dataOut);
+void UAVObjSetTelemetryPriority(UAVObjMetadata* dataOut, UAVObjTelemetryPriority val);
 int8_t UAVObjReadOnly(UAVObjHandle obj);
 int32_t UAVObjConnectQueue(UAVObjHandle obj_handle, struct pios_queue *queue, uint8_t eventMask);
 int32_t UAVObjDisconnectQueue(UAVObjHandle obj_handle, struct pios_queue *queue);
@@ -214,8 +269,13 @@ void UAVObjIterate(void (*iterator)(UAVObjHandle obj));
 int32_t getEventMask(UAVObjHandle obj_handle, struct pios_queue *queue);
 uint8_t UAVObjCount();
 uint32_t UAVObjIDByIndex(uint8_t index);
+int32_t UAVObjReadSettingsDigest(uint8_t *buf, uint32_t offset, uint32_t len);
 void UAVObjCbSetFlag(const UAVObjEvent *objEv, void *ctx, void *obj, int len);
 void UAVObjCbCopyData(const UAVObjEvent *objEv, void *ctx, void *obj, int len);
+#if defined(UAVO_CALLBACK_DIAGNOSTICS)
+void UAVObjIterateCallbackProfiles(void (*iterator)(
+		const struct UAVObjCallbackProfile *prof, void *ctx), void *ctx);
+#endif
 
 #endif // UAVOBJECTMANAGER_H
 
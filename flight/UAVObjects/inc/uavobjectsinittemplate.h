@@ -35,6 +35,10 @@ void UAVObjectsInitializeAll();
 
 #define UAVOBJECTS_LARGEST $(SIZECALCULATION)
 
+//! Number of objects defined, and the smallest power of two not below it
+#define UAVOBJECTS_COUNT $(OBJCOUNT)
+#define UAVOBJECTS_COUNT_POW2 $(OBJCOUNTPOW2)
+
 #endif /* UAVOBJECTSINIT_H */
 
 /**
@@ -40,7 +40,6 @@
 
 #include "pios_queue.h"
 #include "uavobjectmanager.h"
-#include "uavoversion.h"
 
 $(PARENT_INCLUDES)
 
@@ -48,6 +47,9 @@ $(PARENT_INCLUDES)
 #define $(NAMEUC)_OBJID $(OBJIDHEX)
 #define $(NAMEUC)_ISSINGLEINST $(ISSINGLEINST)
 #define $(NAMEUC)_ISSETTINGS $(ISSETTINGS)
+#define $(NAMEUC)_ISFASTRAM $(ISFASTRAM)
+#define $(NAMEUC)_ISREADMOSTLY $(ISREADMOSTLY)
+#define $(NAMEUC)_ISSUPPRESSUNCHANGED $(ISSUPPRESSUNCHANGED)
 #define $(NAMEUC)_NUMBYTES $(NUMBYTES)
 
 // Generic interface functions
@@ -70,10 +72,28 @@ static inline int32_t $(NAME)Get($(NAME)Data *dataOut) { return UAVObjGetData($(
 
 static inline int32_t $(NAME)Set(const $(NAME)Data *dataIn) { return UAVObjSetData($(NAME)Handle(), dataIn); }
 
+/**
+ * @function $(NAME)SetIfChanged(dataIn)
+ * @brief Set a $(NAME)Data object, sending no update if that changes nothing
+ * @param[in] dataIn
+ */
+static inline int32_t $(NAME)SetIfChanged(const $(NAME)Data *dataIn) { return UAVObjSetDataIfChanged($(NAME)Handle(), dataIn); }
+
 static inline int32_t $(NAME)InstGet(uint16_t instId, $(NAME)Data *dataOut) { return UAVObjGetInstanceData($(NAME)Handle(), instId, dataOut); }
 
 static inline int32_t $(NAME)InstSet(uint16_t instId, const $(NAME)Data *dataIn) { return UAVObjSetInstanceData($(NAME)Handle(), instId, dataIn); }
 
+static inline int32_t $(NAME)InstSetIfChanged(uint16_t instId, const $(NAME)Data *dataIn) { return UAVObjSetInstanceDataIfChanged($(NAME)Handle(), instId, dataIn); }
+
+/**
+ * @function $(NAME)InstBorrow(instId)
+ * @brief Read a $(NAME) instance in place; must be paired with $(NAME)Release()
+ * @return Pointer to the instance data, or NULL if it doesn't exist (no need to release)
+ */
+static inline const $(NAME)Data *$(NAME)InstBorrow(uint16_t instId) { return (const $(NAME)Data *)UAVObjBorrowInstanceData($(NAME)Handle(), instId); }
+
+static inline void $(NAME)Release() { UAVObjReleaseInstanceData($(NAME)Handle()); }
+
 static inline int32_t $(NAME)ConnectQueue(struct pios_queue *queue) { return UAVObjConnectQueue($(NAME)Handle(), queue, EV_MASK_ALL_UPDATES); }
 
 static inline int32_t $(NAME)ConnectCallback(UAVObjEventCallback cb) { return UAVObjConnectCallback($(NAME)Handle(), cb, NULL, EV_MASK_ALL_UPDATES); }
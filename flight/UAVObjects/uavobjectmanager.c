@@ -37,16 +37,62 @@
 #include <utlist.h>
 
 #include "pios_struct_helper.h"
-#include "pios_heap.h"		/* PIOS_malloc_no_dma */
+#include "pios_heap.h"		/* PIOS_malloc, PIOS_malloc_no_dma */
 #include "pios_mutex.h"
 #include "pios_queue.h"
 #include "pios_thread.h"
 #include "misc_math.h"
+#include "pios_crc.h"
+#include "uavobjectsinit.h"	/* UAVOBJECTS_COUNT_POW2 */
+#include "uavoversion.h"	/* UAVOHASH */
 
 extern uintptr_t pios_uavo_settings_fs_id;
 
 // Constants
 
+/*
+ * Number of buckets in the object ID hash index.  Must be a power of two.
+ * Object IDs are already hashes of the object definition, so the low bits
+ * (above the meta bit) are used directly to pick a bucket.  By default it
+ * follows the number of objects the generator saw: a firmware registers
+ * well under half of them, so a bucket for every four keeps the chains to
+ * one or two objects.
+ */
+#ifndef UAVOBJ_ID_HASH_BUCKETS
+#if UAVOBJECTS_COUNT_POW2 > 128
+#define UAVOBJ_ID_HASH_BUCKETS (UAVOBJECTS_COUNT_POW2 / 4)
+#else
+#define UAVOBJ_ID_HASH_BUCKETS 32
+#endif
+#endif
+
+#if (UAVOBJ_ID_HASH_BUCKETS & (UAVOBJ_ID_HASH_BUCKETS - 1)) != 0
+#error UAVOBJ_ID_HASH_BUCKETS must be a power of two
+#endif
+
+/*
+ * Fast heap bytes that only objects marked fastram may use.
+ */
+#ifndef UAVOBJ_FASTHEAP_RESERVE
+#define UAVOBJ_FASTHEAP_RESERVE 1024
+#endif
+
+/*
+ * Maximum number of events that may be pending in sendEvent while callbacks
+ * are nested (a callback updating another object, which has callbacks...).
+ * Boards with many bridge modules connected to the same objects may want to
+ * raise this in pios_config.h.
+ */
+#ifndef UAVOBJ_MAX_PENDING_EVENTS
+#define UAVOBJ_MAX_PENDING_EVENTS 6
+#endif
+
+/*
+ * Number of times a lock-free read of single instance data is retried when
+ * it races a writer, before falling back to taking the mutex.
+ */
+#define UAVOBJ_OPTIMISTIC_READ_TRIES 3
+
 // Private types
 
 // Macros
@@ -69,6 +115,12 @@ struct ObjectEventEntry {
 	uint8_t                   hasThrottle : 1;
 	uint8_t                   eventMask : 7;
 	struct ObjectEventEntry * next;
+
+#if defined(UAVO_CALLBACK_DIAGNOSTICS)
+	uint32_t                  prof_calls;
+	uint32_t                  prof_max_cycles;
+	uint64_t                  prof_total_cycles;
+#endif
 };
 
 struct ObjectEventEntryThrottled {
@@ -103,27 +155,54 @@ struct UAVOBase {
 		bool isMeta        : 1;
 		bool isSingle      : 1;
 		bool isSettings    : 1;
+		/* Metadata has been changed, and copied to the heap */
+		bool metaOnHeap    : 1;
+		/* Data is kept by reference (see UAVOReadMostly) */
+		bool isReadMostly  : 1;
+		/* ... and has been changed, and copied to the heap */
+		bool dataOnHeap    : 1;
+		/* Sets that change nothing send no event */
+		bool suppressUnchanged : 1;
 	} flags;
 
 } __attribute__((packed));
 
-/* Augmented type for Meta UAVO */
+/*
+ * Augmented type for Meta UAVO
+ *
+ * Most metadata is never changed from what the object definition says, so
+ * it points at the generated defaults in flash until it is (see
+ * metaDataForWrite).
+ */
 struct UAVOMeta {
 	struct UAVOBase   base;
-	UAVObjMetadata    instance0;
+	const UAVObjMetadata *instance0;
 } __attribute__((packed));
 
-/* Shared data structure for all data-carrying UAVObjects (UAVOSingle and UAVOMulti) */
+/*
+ * Shared data structure for all data-carrying UAVObjects (UAVOSingle and UAVOMulti)
+ *
+ * The odd-sized members come first and are padded out so that the pointers
+ * and the instance data following this header are word aligned (checked
+ * below); borrowed instance data is dereferenced directly by callers.
+ */
 struct UAVOData {
 	struct UAVOBase   base;
-	uint32_t          id;
 	/*
 	 * Embed the Meta object as another complete UAVO
 	 * inside the payload for this UAVO.
 	 */
 	struct UAVOMeta   metaObj;
-	struct UAVOData * next;
 	uint16_t          instance_size;
+	uint16_t          event_drops;
+	uint8_t           pad[2];
+	uint32_t          id;
+	struct UAVOData * next;
+	struct UAVOData * next_hash;
+
+	/* Sequence counter for lock-free readers of single instance data;
+	 * odd while a write is in progress.  Writers hold the mutex. */
+	volatile uint32_t data_seq;
 } __attribute__((packed));
 
 /* Augmented type for Single Instance Data UAVO */
@@ -152,6 +231,13 @@ struct UAVOMulti {
 	struct UAVOData        uavo;
 
 	uint16_t               num_instances;
+
+	/* Most recently looked up instance, so in-order walks over the
+	 * instance list (missions, telemetry, logging) don't start from
+	 * instance 0 every time.  Only accessed with the mutex held. */
+	uint16_t               last_inst_id;
+	struct UAVOMultiInst * last_inst;
+
 	struct UAVOMultiInst   instance0;
 	/*
 	 * Additional space will be malloc'd here to hold the
@@ -159,6 +245,23 @@ struct UAVOMulti {
 	 */
 } __attribute__((packed));
 
+/*
+ * Augmented type for read-mostly single instance settings
+ *
+ * Like the metadata, the data points at the generated defaults in flash
+ * until it is changed (see dataForWrite), so large settings that are left
+ * alone don't take RAM.
+ */
+struct UAVOReadMostly {
+	struct UAVOData   uavo;
+	const uint8_t   * instance0;
+} __attribute__((packed));
+
+DONT_BUILD_IF(offsetof(struct UAVOData, id) % 4, uavoDataHeaderAlign);
+DONT_BUILD_IF(offsetof(struct UAVOData, data_seq) % 4, uavoDataSeqAlign);
+DONT_BUILD_IF(offsetof(struct UAVOSingle, instance0) % 4, uavoSingleDataAlign);
+DONT_BUILD_IF(offsetof(struct UAVOMulti, instance0.instance) % 4, uavoMultiDataAlign);
+
 /** all information about a metaobject are hardcoded constants **/
 #define MetaNumBytes sizeof(UAVObjMetadata)
 
@@ -166,9 +269,11 @@ struct UAVOMulti {
 #define MetaBaseObjectPtr(obj) ((struct UAVOData *)((obj)-offsetof(struct UAVOData, metaObj)))
 //#define MetaObjectPtr(obj) ((struct UAVOMeta*) &((obj)->metaObj))
 #define MetaObjectPtr(obj) (&((obj)->metaObj.base))
-#define MetaDataPtr(obj) ((UAVObjMetadata*)&((obj)->instance0))
-#define LinkedMetaDataPtr(obj) ((UAVObjMetadata*)&((obj)->metaObj.instance0))
+#define MetaDataPtr(obj) ((const UAVObjMetadata*)((obj)->instance0))
+#define LinkedMetaDataPtr(obj) ((const UAVObjMetadata*)((obj)->metaObj.instance0))
 #define MetaObjectId(id) ((id)+1)
+#define DataObjectId(id) ((id) & ~1)
+#define IdHashBucket(id) (((id) >> 1) & (UAVOBJ_ID_HASH_BUCKETS - 1))
 
 /** all information about instances are dependant on object type **/
 #define ObjSingleInstanceDataOffset(obj) ((void*)(&(( (struct UAVOSingle*)obj )->instance0)))
@@ -188,9 +293,29 @@ static int32_t disconnectObj(UAVObjHandle obj_handle, struct pios_queue *queue,
 
 // Private variables
 static struct UAVOData * uavo_list;
+static struct UAVOData * uavo_id_hash[UAVOBJ_ID_HASH_BUCKETS];
 static struct ObjectEventEntry * events_unused;
 static struct ObjectEventEntry * events_unused_throttled;
+/*
+ * The object manager uses two locks:
+ *
+ * - mutex serializes writes to object data, event dispatch and the
+ *   connection lists.  Readers of single instance data objects normally
+ *   don't take it at all; see readDataOptimistic.
+ * - reg_mutex serializes object registration.  Registered objects are
+ *   only ever appended to uavo_list and the ID index, fully initialized,
+ *   so both are walked without any lock.
+ * - fs_mutex serializes saves and loads, which go through one trampoline.
+ *   mutex is only taken within it to copy the data, never across flash
+ *   I/O.
+ *
+ * When two are needed reg_mutex or fs_mutex is taken first, so objects
+ * must not be registered, saved or loaded from callbacks that run with
+ * mutex held, those connected with UAVObjConnectCallback.
+ */
 static struct pios_recursive_mutex *mutex;
+static struct pios_recursive_mutex *reg_mutex;
+static struct pios_recursive_mutex *fs_mutex;
 static const UAVObjMetadata defMetadata = {
 	.flags = (ACCESS_READWRITE << UAVOBJ_ACCESS_SHIFT |
 		ACCESS_READWRITE << UAVOBJ_GCS_ACCESS_SHIFT |
@@ -201,8 +326,12 @@ static const UAVObjMetadata defMetadata = {
 	.telemetryUpdatePeriod    = 0,
 	.gcsTelemetryUpdatePeriod = 0,
 	.loggingUpdatePeriod      = 0,
+	.telemetryPriority        = TELEMETRYPRIORITY_NORMAL,
 };
 
+/* What metadata reads as until an object's defaults are set */
+static const UAVObjMetadata blankMetadata;
+
 static UAVObjStats stats;
 static new_uavo_instance_cb_t newUavObjInstanceCB;
 
@@ -219,6 +348,7 @@ int32_t UAVObjInitialize()
 {
 	// Initialize variables
 	uavo_list = NULL;
+	memset(uavo_id_hash, 0, sizeof(uavo_id_hash));
 	events_unused = NULL;
 	events_unused_throttled = NULL;
 
@@ -232,10 +362,19 @@ int32_t UAVObjInitialize()
 
 	memset(&stats, 0, sizeof(UAVObjStats));
 
-	// Create mutex
+	// Create mutexes
 	mutex = PIOS_Recursive_Mutex_Create();
 	if (mutex == NULL)
 		return -1;
+
+	reg_mutex = PIOS_Recursive_Mutex_Create();
+	if (reg_mutex == NULL)
+		return -1;
+
+	fs_mutex = PIOS_Recursive_Mutex_Create();
+	if (fs_mutex == NULL)
+		return -1;
+
 	// Done
 	return 0;
 }
@@ -278,17 +417,109 @@ static void UAVObjInitMetaData (struct UAVOMeta * obj_meta)
 	uavo_base->flags.isSingle = true;
 	uavo_base->next_event     = NULL;
 
-	/* Clear the instance data carried in the UAVO */
-	memset(&(obj_meta->instance0), 0, sizeof(obj_meta->instance0));
+	obj_meta->instance0 = &blankMetadata;
+}
+
+/**
+ * Get the metadata of a metaobject to change it, copying it from the
+ * defaults to the heap the first time.  Must be called with the mutex held.
+ * \return the metadata, or NULL if it couldn't be copied
+ */
+static UAVObjMetadata *metaDataForWrite(struct UAVOMeta *obj_meta)
+{
+	if (!obj_meta->base.flags.metaOnHeap) {
+		UAVObjMetadata *copy = PIOS_malloc(sizeof(*copy));
+
+		if (!copy) {
+			return NULL;
+		}
+
+		memcpy(copy, obj_meta->instance0, sizeof(*copy));
+
+		obj_meta->instance0 = copy;
+		obj_meta->base.flags.metaOnHeap = true;
+	}
+
+	return (UAVObjMetadata *) obj_meta->instance0;
+}
+
+/**
+ * Get the data of a single instance object, wherever it is kept.
+ */
+static inline const uint8_t *singleInstanceData(struct UAVOData *obj)
+{
+	if (obj->base.flags.isReadMostly) {
+		return ((struct UAVOReadMostly *) obj)->instance0;
+	}
+
+	return ((struct UAVOSingle *) obj)->instance0;
+}
+
+/**
+ * Get the instance data of an object to change it.  Read-mostly data is
+ * copied from flash to the heap the first time; it stays there, as the
+ * heap doesn't take memory back.  Must be called with the mutex held.
+ * \param[in] obj The object
+ * \param[in] data The instance data, as returned by getInstance()
+ * \return the data to write to, or NULL if it couldn't be copied
+ */
+static uint8_t *dataForWrite(struct UAVOData *obj, void *data)
+{
+	if (!obj->base.flags.isReadMostly || obj->base.flags.dataOnHeap) {
+		return data;
+	}
+
+	struct UAVOReadMostly *uavo_rm = (struct UAVOReadMostly *) obj;
+	uint8_t *copy = PIOS_malloc(obj->instance_size);
+
+	if (!copy) {
+		return NULL;
+	}
+
+	if (uavo_rm->instance0) {
+		memcpy(copy, uavo_rm->instance0, obj->instance_size);
+	} else {
+		memset(copy, 0, obj->instance_size);
+	}
+
+	/* The copy is the same as what it replaces, so lock-free readers
+	 * are fine with either */
+	uavo_rm->instance0 = copy;
+	obj->base.flags.dataOnHeap = true;
+
+	return copy;
+}
+
+/**
+ * Settings are read rarely and are the bulk of the object data, so they go
+ * to normal SRAM and leave the fast heap to the data the control loops touch.
+ * Small targets that can't spare the SRAM still put them in the fast heap.
+ * Objects are registered in whatever order the modules start, so the last
+ * UAVOBJ_FASTHEAP_RESERVE bytes of the fast heap are kept for the ones
+ * marked fastram.
+ */
+static void * UAVObjAllocData(uint32_t size, bool is_settings, bool is_fast_ram)
+{
+	if (is_settings && PIOS_heap_get_free_size() >= size)
+		return PIOS_malloc(size);
+
+	if (!is_fast_ram && !is_settings &&
+			PIOS_fastheap_get_free_size() < size + UAVOBJ_FASTHEAP_RESERVE &&
+			PIOS_heap_get_free_size() >= size)
+		return PIOS_malloc(size);
+
+	return PIOS_malloc_no_dma(size);
 }
 
-static struct UAVOData * UAVObjAllocSingle(uint32_t num_bytes)
+static struct UAVOData * UAVObjAllocSingle(uint32_t num_bytes, bool is_settings,
+		bool is_fast_ram)
 {
 	/* Compute the complete size of the object, including the data for a single embedded instance */
 	uint32_t object_size = sizeof(struct UAVOSingle) + num_bytes;
 
 	/* Allocate the object from the heap */
-	struct UAVOSingle * uavo_single = (struct UAVOSingle *) PIOS_malloc_no_dma(object_size);
+	struct UAVOSingle * uavo_single = (struct UAVOSingle *) UAVObjAllocData(object_size, is_settings,
+			is_fast_ram);
 	if (!uavo_single)
 		return (NULL);
 
@@ -305,13 +536,37 @@ static struct UAVOData * UAVObjAllocSingle(uint32_t num_bytes)
 	return (&(uavo_single->uavo));
 }
 
-static struct UAVOData * UAVObjAllocMulti(uint32_t num_bytes)
+static struct UAVOData * UAVObjAllocReadMostly(void)
+{
+	/* Only the header; the data is the defaults until it's changed */
+	struct UAVOReadMostly * uavo_rm = (struct UAVOReadMostly *) PIOS_malloc(
+			sizeof(struct UAVOReadMostly));
+	if (!uavo_rm)
+		return (NULL);
+
+	/* Fill in the common part of the UAVO */
+	struct UAVOBase * uavo_base = &(uavo_rm->uavo.base);
+	memset(uavo_base, 0, sizeof(*uavo_base));
+	uavo_base->flags.isSingle     = true;
+	uavo_base->flags.isReadMostly = true;
+	uavo_base->next_event         = NULL;
+
+	/* Set by the defaults */
+	uavo_rm->instance0 = NULL;
+
+	/* Give back the generic UAVO part */
+	return (&(uavo_rm->uavo));
+}
+
+static struct UAVOData * UAVObjAllocMulti(uint32_t num_bytes, bool is_settings,
+		bool is_fast_ram)
 {
 	/* Compute the complete size of the object, including the data for a single embedded instance */
 	uint32_t object_size = sizeof(struct UAVOMulti) + num_bytes;
 
 	/* Allocate the object from the heap */
-	struct UAVOMulti * uavo_multi = (struct UAVOMulti *) PIOS_malloc_no_dma(object_size);
+	struct UAVOMulti * uavo_multi = (struct UAVOMulti *) UAVObjAllocData(object_size, is_settings,
+			is_fast_ram);
 	if (!uavo_multi)
 		return (NULL);
 
@@ -323,6 +578,8 @@ static struct UAVOData * UAVObjAllocMulti(uint32_t num_bytes)
 
 	/* Set up the type-specific part of the UAVO */
 	uavo_multi->num_instances = 1;
+	uavo_multi->last_inst_id  = 0;
+	uavo_multi->last_inst     = &(uavo_multi->instance0);
 
 	/* Clear the instance data carried in the UAVO */
 	uavo_multi->instance0.next = NULL;
@@ -332,6 +589,65 @@ static struct UAVOData * UAVObjAllocMulti(uint32_t num_bytes)
 	return (&(uavo_multi->uavo));
 }
 
+/**
+ * Mark the start of a write to the data of an object.  Must be called with
+ * the mutex held, and paired with dataWriteEnd.
+ */
+static inline void dataWriteBegin(struct UAVOData *obj)
+{
+	obj->data_seq++;
+	__sync_synchronize();
+}
+
+/**
+ * Mark the end of a write started with dataWriteBegin.
+ */
+static inline void dataWriteEnd(struct UAVOData *obj)
+{
+	__sync_synchronize();
+	obj->data_seq++;
+}
+
+/**
+ * Copy out (part of) the data of a single instance data object without
+ * taking the mutex.  The copy is retried if it raced a writer.  If a write
+ * is in progress the caller must fall back to the locked path instead of
+ * spinning here: the writer may be a preempted lower priority task, and
+ * only blocking on the mutex lets it run to completion.
+ * \param[in] obj The object, which must be a single instance data object
+ * \param[out] dataOut Destination buffer
+ * \param[in] offset Offset into the object data
+ * \param[in] size Number of bytes to copy
+ * \return true if a consistent copy was made, false otherwise
+ */
+static bool readDataOptimistic(struct UAVOData *obj, void *dataOut,
+		uint32_t offset, uint32_t size)
+{
+	for (int i = 0; i < UAVOBJ_OPTIMISTIC_READ_TRIES; i++) {
+		uint32_t seq = obj->data_seq;
+
+		if (seq & 1) {
+			return false;
+		}
+
+		__sync_synchronize();
+
+		const uint8_t *data = singleInstanceData(obj);
+		if (!data) {
+			return false;
+		}
+
+		memcpy(dataOut, data + offset, size);
+		__sync_synchronize();
+
+		if (obj->data_seq == seq) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
 /**************************
  * UAVObject Database APIs
  *************************/
@@ -341,6 +657,9 @@ static struct UAVOData * UAVObjAllocMulti(uint32_t num_bytes)
  * \param[in] id Unique object ID
  * \param[in] isSingleInstance Is this a single instance or multi-instance object
  * \param[in] isSettings Is this a settings object
+ * \param[in] isFastRam Should this object be kept in fast RAM if possible
+ * \param[in] isReadMostly Should this single instance object be left in
+ * flash until it is changed
  * \param[in] numBytes Number of bytes of object data (for one instance)
  * \param[in] initCb Default field and metadata initialization function
  * \return Object handle, or NULL if failure.
@@ -348,22 +667,24 @@ static struct UAVOData * UAVObjAllocMulti(uint32_t num_bytes)
  */
 UAVObjHandle UAVObjRegister(uint32_t id,
 			int32_t isSingleInstance, int32_t isSettings,
-			uint32_t num_bytes,
+			int32_t isFastRam, int32_t isReadMostly, uint32_t num_bytes,
 			UAVObjInitializeCallback initCb)
 {
 	struct UAVOData * uavo_data = NULL;
 
-	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
+	PIOS_Recursive_Mutex_Lock(reg_mutex, PIOS_MUTEX_TIMEOUT_MAX);
 
 	/* Don't allow duplicate registrations */
 	if (UAVObjGetByID(id))
 		goto unlock_exit;
 
 	/* Map the various flags to one of the UAVO types we understand */
-	if (isSingleInstance) {
-		uavo_data = UAVObjAllocSingle (num_bytes);
+	if (isSingleInstance && isReadMostly) {
+		uavo_data = UAVObjAllocReadMostly ();
+	} else if (isSingleInstance) {
+		uavo_data = UAVObjAllocSingle (num_bytes, isSettings, isFastRam);
 	} else {
-		uavo_data = UAVObjAllocMulti (num_bytes);
+		uavo_data = UAVObjAllocMulti (num_bytes, isSettings, isFastRam);
 	}
 
 	if (!uavo_data)
@@ -372,6 +693,9 @@ UAVObjHandle UAVObjRegister(uint32_t id,
 	/* Fill in the details about this UAVO */
 	uavo_data->id            = id;
 	uavo_data->instance_size = num_bytes;
+	uavo_data->event_drops   = 0;
+	uavo_data->data_seq      = 0;
+	uavo_data->next          = NULL;
 	if (isSettings) {
 		uavo_data->base.flags.isSettings = true;
 	}
@@ -379,13 +703,15 @@ UAVObjHandle UAVObjRegister(uint32_t id,
 	/* Initialize the embedded meta UAVO */
 	UAVObjInitMetaData (&uavo_data->metaObj);
 
-	/* Add the newly created object to the global list of objects */
-	LL_APPEND(uavo_list, uavo_data);
-
 	/* Initialize object fields and metadata to default values */
 	if (initCb)
 		initCb((UAVObjHandle) uavo_data, 0);
 
+	/* Without defaults to refer to, read-mostly data lives on the heap */
+	if (uavo_data->base.flags.isReadMostly &&
+			!((struct UAVOReadMostly *) uavo_data)->instance0)
+		dataForWrite(uavo_data, NULL);
+
 	/* Always try to load the meta object from flash */
 	UAVObjLoad((UAVObjHandle) &(uavo_data->metaObj), 0);
 
@@ -397,8 +723,19 @@ UAVObjHandle UAVObjRegister(uint32_t id,
 	UAVObjInstanceUpdated((UAVObjHandle) uavo_data, 0);
 	UAVObjInstanceUpdated((UAVObjHandle) &(uavo_data->metaObj), 0);
 
+	/* Publish the fully initialized object in the list of objects and
+	 * the ID index.  Both are walked without taking any lock, so the
+	 * object must be complete before anything points at it. */
+	__sync_synchronize();
+	LL_APPEND(uavo_list, uavo_data);
+
+	uint32_t bucket = IdHashBucket(id);
+	uavo_data->next_hash = uavo_id_hash[bucket];
+	__sync_synchronize();
+	uavo_id_hash[bucket] = uavo_data;
+
 unlock_exit:
-	PIOS_Recursive_Mutex_Unlock(mutex);
+	PIOS_Recursive_Mutex_Unlock(reg_mutex);
 	return (UAVObjHandle) uavo_data;
 }
 
@@ -409,27 +746,24 @@ unlock_exit:
  */
 UAVObjHandle UAVObjGetByID(uint32_t id)
 {
-	UAVObjHandle found_obj = NULL;
+	/* Objects are only ever added to the index (never removed), and
+	 * they are added at the head of a bucket chain only after being
+	 * fully set up.  So the chains can be walked without the lock. */
+	uint32_t data_id = DataObjectId(id);
 
-	// Get lock
-	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
-
-	// Look for object
 	struct UAVOData * tmp_obj;
-	LL_FOREACH(uavo_list, tmp_obj) {
-		if (tmp_obj->id == id) {
-			found_obj = &tmp_obj->base;
-			goto unlock_exit;
-		}
-		if (MetaObjectId(tmp_obj->id) == id) {
-			found_obj = &(tmp_obj->metaObj.base);
-			goto unlock_exit;
+	for (tmp_obj = uavo_id_hash[IdHashBucket(data_id)]; tmp_obj;
+			tmp_obj = tmp_obj->next_hash) {
+		if (tmp_obj->id == data_id) {
+			if (id != data_id) {
+				return &(tmp_obj->metaObj.base);
+			}
+
+			return &tmp_obj->base;
 		}
 	}
 
-unlock_exit:
-	PIOS_Recursive_Mutex_Unlock(mutex);
-	return found_obj;
+	return NULL;
 }
 
 /**
@@ -457,6 +791,28 @@ uint32_t UAVObjGetID(UAVObjHandle obj_handle)
 	}
 }
 
+/**
+ * Get the number of events for this object (or its metaobject) that were
+ * dropped because too many callbacks were already pending.
+ * \param[in] obj The object handle
+ * \return The number of dropped events, saturating at UINT16_MAX
+ */
+uint16_t UAVObjGetEventDrops(UAVObjHandle obj_handle)
+{
+	PIOS_Assert(obj_handle);
+
+	struct UAVOData *uavo_data;
+
+	if (UAVObjIsMetaobject(obj_handle)) {
+		uavo_data = container_of((struct UAVOMeta *)obj_handle,
+				struct UAVOData, metaObj);
+	} else {
+		uavo_data = (struct UAVOData *) obj_handle;
+	}
+
+	return uavo_data->event_drops;
+}
+
 /**
  * Get the number of bytes of the object's data (for one instance)
  * \param[in] obj The object handle
@@ -608,6 +964,24 @@ bool UAVObjIsSettings(UAVObjHandle obj_handle)
 	return uavo_base->flags.isSettings;
 }
 
+/**
+ * Choose whether setting the object to what it already holds sends out an
+ * update.  Off by default, as some users wait on every set (e.g. to run
+ * once per sample) rather than on changes.
+ * \param[in] obj The object handle
+ * \param[in] suppress True to send no update for sets that change nothing
+ */
+void UAVObjSetSuppressUnchanged(UAVObjHandle obj_handle, bool suppress)
+{
+	PIOS_Assert(obj_handle);
+
+	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
+
+	((struct UAVOBase *) obj_handle)->flags.suppressUnchanged = suppress;
+
+	PIOS_Recursive_Mutex_Unlock(mutex);
+}
+
 /**
  * Unpack an object from a byte array
  * \param[in] obj The object handle
@@ -620,12 +994,33 @@ int32_t UAVObjUnpack(UAVObjHandle obj_handle, uint16_t instId,
 {
 	PIOS_Assert(obj_handle);
 
+	return UAVObjUnpackField(obj_handle, instId, dataIn, 0,
+			UAVObjGetNumBytes(obj_handle));
+}
+
+/**
+ * Unpack a byte range of an object from a byte array.  Unlike
+ * UAVObjSetInstanceDataField this ignores the access mode, as it is meant
+ * for updates arriving from telemetry.  Only a full unpack creates a missing
+ * instance.
+ * \param[in] obj The object handle
+ * \param[in] instId The instance ID
+ * \param[in] dataIn The bytes for the range
+ * \param[in] offset Offset of the range into the object data
+ * \param[in] size Length of the range
+ * \return 0 if success or -1 if failure
+ */
+int32_t UAVObjUnpackField(UAVObjHandle obj_handle, uint16_t instId,
+		const uint8_t * dataIn, uint32_t offset, uint32_t size)
+{
+	PIOS_Assert(obj_handle);
+
 	// Lock
 	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
 
 	int32_t rc = -1;
 
-	void *target;
+	uint8_t *target;
 	int len;
 
 	if (UAVObjIsMetaobject(obj_handle)) {
@@ -633,9 +1028,8 @@ int32_t UAVObjUnpack(UAVObjHandle obj_handle, uint16_t instId,
 			goto unlock_exit;
 		}
 
-		target = MetaDataPtr((struct UAVOMeta *)obj_handle);
+		target = (uint8_t *) MetaDataPtr((struct UAVOMeta *)obj_handle);
 		len = MetaNumBytes;
-		memcpy(MetaDataPtr((struct UAVOMeta *)obj_handle), dataIn, MetaNumBytes);
 	} else {
 		struct UAVOData *obj;
 		InstanceHandle instEntry;
@@ -648,6 +1042,10 @@ int32_t UAVObjUnpack(UAVObjHandle obj_handle, uint16_t instId,
 
 		// If the instance does not exist create it and any other instances before it
 		if (instEntry == NULL) {
+			if (offset != 0 || size != obj->instance_size) {
+				goto unlock_exit;
+			}
+
 			instEntry = createInstance(obj, instId);
 			if (instEntry == NULL) {
 				goto unlock_exit;
@@ -659,7 +1057,38 @@ int32_t UAVObjUnpack(UAVObjHandle obj_handle, uint16_t instId,
 		len = obj->instance_size;
 	}
 
-	memcpy(target, dataIn, len);
+	// Check for overrun
+	if ((size + offset) > len) {
+		goto unlock_exit;
+	}
+
+	if (UAVObjIsMetaobject(obj_handle)) {
+		/* Leave metadata that isn't changing where it is */
+		if (memcmp(target + offset, dataIn, size)) {
+			target = (uint8_t *) metaDataForWrite(
+					(struct UAVOMeta *)obj_handle);
+			if (!target) {
+				goto unlock_exit;
+			}
+
+			memcpy(target + offset, dataIn, size);
+		}
+	} else {
+		struct UAVOData *obj = (struct UAVOData *) obj_handle;
+
+		/* Likewise read-mostly data */
+		if (!obj->base.flags.isReadMostly ||
+				memcmp(target + offset, dataIn, size)) {
+			target = dataForWrite(obj, target);
+			if (!target) {
+				goto unlock_exit;
+			}
+
+			dataWriteBegin(obj);
+			memcpy(target + offset, dataIn, size);
+			dataWriteEnd(obj);
+		}
+	}
 
 	// Fire event
 	sendEvent((struct UAVOBase*)obj_handle, instId, EV_UNPACKED,
@@ -683,6 +1112,15 @@ int32_t UAVObjPack(UAVObjHandle obj_handle, uint16_t instId, uint8_t * dataOut)
 {
 	PIOS_Assert(obj_handle);
 
+	if (instId == 0 && UAVObjIsSingleInstance(obj_handle) &&
+			!UAVObjIsMetaobject(obj_handle)) {
+		struct UAVOData *obj = (struct UAVOData *) obj_handle;
+
+		if (readDataOptimistic(obj, dataOut, 0, obj->instance_size)) {
+			return 0;
+		}
+	}
+
 	// Lock
 	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
 
@@ -716,21 +1154,23 @@ unlock_exit:
 	return rc;
 }
 
-#if defined(PIOS_INCLUDE_FASTHEAP)
 /**
- * Trampoline buffer used for loads from the underlying filesystem.
- * This is required on platforms that store the UAVO data in non-DMA
- * RAM regions since the underlying flash driver may use DMA to transfer
- * the data into the buffer that we give it.
+ * Trampoline buffer used for saves and loads, with fs_mutex held.
+ * Object data is copied through it with the mutex held only for the copy,
+ * so writers never wait for the flash.  It is also required on platforms
+ * that store the UAVO data in non-DMA RAM regions since the underlying
+ * flash driver may use DMA to transfer the data into the buffer that we
+ * give it.
  */
-static uint8_t uavobj_save_trampoline[256] __attribute__((aligned(4)));
-#endif	/* PIOS_INCLUDE_FASTHEAP */
+static uint8_t uavobj_fs_trampoline[256] __attribute__((aligned(4)));
 
 /**
  * Save the data of the specified object to the file system (SD card).
  * If the object contains multiple instances, all of them will be saved.
  * A new file with the name of the object will be created.
  * The object data can be restored using the UAVObjLoad function.
+ * Must not be called with the object manager lock held, as from a callback
+ * connected with UAVObjConnectCallback.
  * @param[in] obj The object handle.
  * @param[in] instId The instance ID
  * @param[in] file File to append to
@@ -740,82 +1180,60 @@ int32_t UAVObjSave(UAVObjHandle obj_handle, uint16_t instId)
 {
 	PIOS_Assert(obj_handle);
 
-	if (UAVObjIsMetaobject(obj_handle)) {
-		if (instId != 0)
-			return -1;
+	int32_t rc = -1;
+	uint32_t len = UAVObjGetNumBytes(obj_handle);
 
-		// Save the object to the filesystem
-		int32_t rc;
-#if defined(PIOS_INCLUDE_FASTHEAP)
-		memcpy(uavobj_save_trampoline,
-			MetaDataPtr((struct UAVOMeta *)obj_handle),
-			UAVObjGetNumBytes(obj_handle));
+	if (len > sizeof(uavobj_fs_trampoline))
+		return -1;
 
-		rc = PIOS_FLASHFS_ObjSave(pios_uavo_settings_fs_id,
-					UAVObjGetID(obj_handle),
-					instId,
-					uavobj_save_trampoline,
-					UAVObjGetNumBytes(obj_handle));
-#else /* PIOS_INCLUDE_FASTHEAP */
-		rc = PIOS_FLASHFS_ObjSave(pios_uavo_settings_fs_id,
-					UAVObjGetID(obj_handle),
-					instId,
-					(uint8_t*) MetaDataPtr((struct UAVOMeta *)obj_handle),
-					UAVObjGetNumBytes(obj_handle));
-#endif  /* PIOS_INCLUDE_FASTHEAP */
-
-		if (rc != 0)
-			return -1;
+	PIOS_Recursive_Mutex_Lock(fs_mutex, PIOS_MUTEX_TIMEOUT_MAX);
+
+	/* Hold the lock only for the copy, so that the saved data isn't
+	 * torn by a writer */
+	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
+
+	if (UAVObjIsMetaobject(obj_handle)) {
+		if (instId != 0) {
+			PIOS_Recursive_Mutex_Unlock(mutex);
+			goto unlock_exit;
+		}
+
+		memcpy(uavobj_fs_trampoline,
+			MetaDataPtr((struct UAVOMeta *)obj_handle), len);
 	} else {
 		InstanceHandle instEntry = getInstance( (struct UAVOData *)obj_handle, instId);
 
-		if (instEntry == NULL)
-			return -1;
+		if (instEntry == NULL || InstanceData(instEntry) == NULL) {
+			PIOS_Recursive_Mutex_Unlock(mutex);
+			goto unlock_exit;
+		}
 
-		if (InstanceData(instEntry) == NULL)
-			return -1;
+		memcpy(uavobj_fs_trampoline, InstanceData(instEntry), len);
+	}
 
-		// Save the object to the filesystem
-		int32_t rc;
-#if defined(PIOS_INCLUDE_FASTHEAP)
-		memcpy(uavobj_save_trampoline,
-			InstanceData(instEntry),
-			UAVObjGetNumBytes(obj_handle));
+	PIOS_Recursive_Mutex_Unlock(mutex);
 
-		rc = PIOS_FLASHFS_ObjSave(pios_uavo_settings_fs_id,
-					UAVObjGetID(obj_handle),
-					instId,
-					uavobj_save_trampoline,
-					UAVObjGetNumBytes(obj_handle));
-#else /* PIOS_INCLUDE_FASTHEAP */
-		rc = PIOS_FLASHFS_ObjSave(pios_uavo_settings_fs_id,
-					UAVObjGetID(obj_handle),
-					instId,
-					InstanceData(instEntry),
-					UAVObjGetNumBytes(obj_handle));
-#endif  /* PIOS_INCLUDE_FASTHEAP */
-
-		if (rc != 0)
-			return -1;
-	}
+	// Save the object to the filesystem
+	if (PIOS_FLASHFS_ObjSave(pios_uavo_settings_fs_id,
+				UAVObjGetID(obj_handle),
+				instId,
+				uavobj_fs_trampoline,
+				len) != 0)
+		goto unlock_exit;
 
-	return 0;
-}
+	rc = 0;
 
-#if defined(PIOS_INCLUDE_FASTHEAP)
-/**
- * Trampoline buffer used for loads from the underlying filesystem.
- * This is required on platforms that store the UAVO data in non-DMA
- * RAM regions since the underlying flash driver may use DMA to transfer
- * the data into the buffer that we give it.
- */
-static uint8_t uavobj_load_trampoline[256] __attribute__((aligned(4)));
-#endif	/* PIOS_INCLUDE_FASTHEAP */
+unlock_exit:
+	PIOS_Recursive_Mutex_Unlock(fs_mutex);
+	return rc;
+}
 
 /**
  * Load an object from the file system (SD card).
  * A file with the name of the object will be opened.
  * The object data can be saved using the UAVObjSave function.
+ * Must not be called with the object manager lock held, as from a callback
+ * connected with UAVObjConnectCallback.
  * @param[in] obj The object handle.
  * @param[in] instId The object instance
  * @return 0 if success or -1 if failure
@@ -824,51 +1242,77 @@ int32_t UAVObjLoad(UAVObjHandle obj_handle, uint16_t instId)
 {
 	PIOS_Assert(obj_handle);
 
-	void *target;
-	int len;
+	int32_t rc = -1;
+	uint32_t len = UAVObjGetNumBytes(obj_handle);
+
+	if (len > sizeof(uavobj_fs_trampoline))
+		return -1;
+
+	if (UAVObjIsMetaobject(obj_handle) && instId != 0)
+		return -1;
+
+	PIOS_Recursive_Mutex_Lock(fs_mutex, PIOS_MUTEX_TIMEOUT_MAX);
+
+	// Load the object from the filesystem, without holding up writers
+	if (PIOS_FLASHFS_ObjLoad(pios_uavo_settings_fs_id,
+				UAVObjGetID(obj_handle),
+				instId,
+				uavobj_fs_trampoline,
+				len) != 0)
+		goto unlock_fs_exit;
+
+	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
 
 	if (UAVObjIsMetaobject(obj_handle)) {
-		if (instId != 0)
-			return -1;
+		/* Only metadata that really was changed and saved takes heap;
+		 * nothing is copied unless it differs. */
+		struct UAVOMeta *obj_meta = (struct UAVOMeta *) obj_handle;
 
-		target = MetaDataPtr((struct UAVOMeta *)obj_handle);
-		len = UAVObjGetNumBytes(obj_handle);
+		if (memcmp(MetaDataPtr(obj_meta), uavobj_fs_trampoline, len)) {
+			UAVObjMetadata *meta = metaDataForWrite(obj_meta);
+
+			if (!meta)
+				goto unlock_exit;
+
+			memcpy(meta, uavobj_fs_trampoline, len);
+		}
+
+		sendEvent((struct UAVOBase*)obj_handle, 0, EV_UNPACKED,
+				(void *) MetaDataPtr(obj_meta), len);
 	} else {
+		struct UAVOData *data_obj = (struct UAVOData *) obj_handle;
 
-		InstanceHandle instEntry = getInstance( (struct UAVOData *)obj_handle, instId);
+		InstanceHandle instEntry = getInstance(data_obj, instId);
 
 		if (instEntry == NULL)
-			return -1;
+			goto unlock_exit;
 
-		target = InstanceData(instEntry);
-		len = UAVObjGetNumBytes(obj_handle);
-	}
-
-	// Load the object from the filesystem
-	int32_t rc;
-#if defined(PIOS_INCLUDE_FASTHEAP)
-	rc = PIOS_FLASHFS_ObjLoad(pios_uavo_settings_fs_id,
-			UAVObjGetID(obj_handle),
-			instId,
-			uavobj_load_trampoline,
-			len);
-#else  /* PIOS_INCLUDE_FASTHEAP */
-	rc = PIOS_FLASHFS_ObjLoad(pios_uavo_settings_fs_id,
-			UAVObjGetID(obj_handle),
-			instId,
-			target,
-			len);
-#endif  /* PIOS_INCLUDE_FASTHEAP */
-
-	if (rc != 0)
-		return -1;
+		void *target = InstanceData(instEntry);
 
-#if defined(PIOS_INCLUDE_FASTHEAP)
-	memcpy(target, uavobj_load_trampoline, len);
-#endif  /* PIOS_INCLUDE_FASTHEAP */
+		/* Read-mostly data is only copied out of flash if what was
+		 * stored differs from it */
+		if (!data_obj->base.flags.isReadMostly ||
+				memcmp(target, uavobj_fs_trampoline, len)) {
+			target = dataForWrite(data_obj, target);
+			if (!target)
+				goto unlock_exit;
 
-	sendEvent((struct UAVOBase*)obj_handle, instId, EV_UNPACKED, target, len);
-	return 0;
+			dataWriteBegin(data_obj);
+			memcpy(target, uavobj_fs_trampoline, len);
+			dataWriteEnd(data_obj);
+		}
+
+		sendEvent((struct UAVOBase*)obj_handle, instId, EV_UNPACKED,
+				target, len);
+	}
+
+	rc = 0;
+
+unlock_exit:
+	PIOS_Recursive_Mutex_Unlock(mutex);
+unlock_fs_exit:
+	PIOS_Recursive_Mutex_Unlock(fs_mutex);
+	return rc;
 }
 
 /**
@@ -892,11 +1336,11 @@ int32_t UAVObjSaveSettings()
 {
 	struct UAVOData *obj;
 
-	// Get lock
-	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
-
 	int32_t rc = -1;
 
+	/* The object list is append-only and walked without the lock;
+	 * each object is locked individually while it is processed. */
+
 	// Save all settings objects
 	LL_FOREACH(uavo_list, obj) {
 		// Check if this is a settings object
@@ -912,7 +1356,6 @@ int32_t UAVObjSaveSettings()
 	rc = 0;
 
 unlock_exit:
-	PIOS_Recursive_Mutex_Unlock(mutex);
 	return rc;
 }
 
@@ -924,11 +1367,11 @@ int32_t UAVObjLoadSettings()
 {
 	struct UAVOData *obj;
 
-	// Get lock
-	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
-
 	int32_t rc = -1;
 
+	/* The object list is append-only and walked without the lock;
+	 * each object is locked individually while it is processed. */
+
 	// Load all settings objects
 	LL_FOREACH(uavo_list, obj) {
 		// Check if this is a settings object
@@ -944,7 +1387,6 @@ int32_t UAVObjLoadSettings()
 	rc = 0;
 
 unlock_exit:
-	PIOS_Recursive_Mutex_Unlock(mutex);
 	return rc;
 }
 
@@ -956,9 +1398,6 @@ int32_t UAVObjDeleteSettings()
 {
 	struct UAVOData *obj;
 
-	// Get lock
-	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
-
 	int32_t rc = -1;
 
 	// Save all settings objects
@@ -976,7 +1415,6 @@ int32_t UAVObjDeleteSettings()
 	rc = 0;
 
 unlock_exit:
-	PIOS_Recursive_Mutex_Unlock(mutex);
 	return rc;
 }
 
@@ -988,11 +1426,11 @@ int32_t UAVObjSaveMetaobjects()
 {
 	struct UAVOData *obj;
 
-	// Get lock
-	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
-
 	int32_t rc = -1;
 
+	/* The object list is append-only and walked without the lock;
+	 * each object is locked individually while it is processed. */
+
 	// Save all settings objects
 	LL_FOREACH(uavo_list, obj) {
 		// Save object
@@ -1005,7 +1443,6 @@ int32_t UAVObjSaveMetaobjects()
 	rc = 0;
 
 unlock_exit:
-	PIOS_Recursive_Mutex_Unlock(mutex);
 	return rc;
 }
 
@@ -1017,11 +1454,11 @@ int32_t UAVObjLoadMetaobjects()
 {
 	struct UAVOData *obj;
 
-	// Get lock
-	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
-
 	int32_t rc = -1;
 
+	/* The object list is append-only and walked without the lock;
+	 * each object is locked individually while it is processed. */
+
 	// Load all settings objects
 	LL_FOREACH(uavo_list, obj) {
 		// Load object
@@ -1034,7 +1471,6 @@ int32_t UAVObjLoadMetaobjects()
 	rc = 0;
 
 unlock_exit:
-	PIOS_Recursive_Mutex_Unlock(mutex);
 	return rc;
 }
 
@@ -1046,9 +1482,6 @@ int32_t UAVObjDeleteMetaobjects()
 {
 	struct UAVOData *obj;
 
-	// Get lock
-	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
-
 	int32_t rc = -1;
 
 	// Load all settings objects
@@ -1063,7 +1496,6 @@ int32_t UAVObjDeleteMetaobjects()
 	rc = 0;
 
 unlock_exit:
-	PIOS_Recursive_Mutex_Unlock(mutex);
 	return rc;
 }
 
@@ -1089,6 +1521,28 @@ int32_t UAVObjSetDataField(UAVObjHandle obj_handle, const void* dataIn, uint32_t
 	return UAVObjSetInstanceDataField(obj_handle, 0, dataIn, offset, size);
 }
 
+/**
+ * Set the object data, sending no event if that changes nothing
+ * \param[in] obj The object handle
+ * \param[in] dataIn The object's data structure
+ * \return 0 if success or -1 if failure
+ */
+int32_t UAVObjSetDataIfChanged(UAVObjHandle obj_handle, const void *dataIn)
+{
+	return UAVObjSetInstanceDataIfChanged(obj_handle, 0, dataIn);
+}
+
+/**
+ * Set a field of the object data, sending no event if that changes nothing
+ * \param[in] obj The object handle
+ * \param[in] dataIn The field's data
+ * \return 0 if success or -1 if failure
+ */
+int32_t UAVObjSetDataFieldIfChanged(UAVObjHandle obj_handle, const void* dataIn, uint32_t offset, uint32_t size)
+{
+	return UAVObjSetInstanceDataFieldIfChanged(obj_handle, 0, dataIn, offset, size);
+}
+
 /**
  * Get the object data
  * \param[in] obj The object handle
@@ -1108,33 +1562,79 @@ int32_t UAVObjGetData(UAVObjHandle obj_handle, void *dataOut)
  */
 int32_t UAVObjGetDataField(UAVObjHandle obj_handle, void* dataOut, uint32_t offset, uint32_t size)
 {
-	return UAVObjGetInstanceDataField(obj_handle, 0, dataOut, offset, size);
+	return UAVObjGetInstanceDataField(obj_handle, 0, dataOut, offset, size);
+}
+
+#define INSTANCE_COPY_ALL 0xffffffff
+
+/**
+ * Set the data of a specific object instance
+ * \param[in] obj The object handle
+ * \param[in] instId The object instance ID
+ * \param[in] dataIn The object's data structure
+ * \return 0 if success or -1 if failure
+ */
+int32_t UAVObjSetInstanceData(UAVObjHandle obj_handle, uint16_t instId,
+			const void *dataIn)
+{
+	return UAVObjSetInstanceDataField(obj_handle, instId, dataIn,
+		0, INSTANCE_COPY_ALL);
+}
+
+static int32_t setInstanceDataField(UAVObjHandle obj_handle, uint16_t instId,
+		const void *dataIn, uint32_t offset, uint32_t size,
+		bool ifChanged);
+
+/**
+ * Set the data of a specific object instance
+ * \param[in] obj The object handle
+ * \param[in] instId The object instance ID
+ * \param[in] dataIn The object's data structure
+ * \return 0 if success or -1 if failure
+ */
+int32_t UAVObjSetInstanceDataField(UAVObjHandle obj_handle, uint16_t instId, const void* dataIn, uint32_t offset, uint32_t size)
+{
+	return setInstanceDataField(obj_handle, instId, dataIn, offset, size,
+		false);
 }
 
-#define INSTANCE_COPY_ALL 0xffffffff
-
 /**
- * Set the data of a specific object instance
+ * Set the data of a specific object instance, sending no event if that
+ * changes nothing
  * \param[in] obj The object handle
  * \param[in] instId The object instance ID
  * \param[in] dataIn The object's data structure
  * \return 0 if success or -1 if failure
  */
-int32_t UAVObjSetInstanceData(UAVObjHandle obj_handle, uint16_t instId,
+int32_t UAVObjSetInstanceDataIfChanged(UAVObjHandle obj_handle, uint16_t instId,
 			const void *dataIn)
 {
-	return UAVObjSetInstanceDataField(obj_handle, instId, dataIn,
-		0, INSTANCE_COPY_ALL);
+	return setInstanceDataField(obj_handle, instId, dataIn,
+		0, INSTANCE_COPY_ALL, true);
 }
 
 /**
- * Set the data of a specific object instance
+ * Set a field of a specific object instance, sending no event if that
+ * changes nothing
  * \param[in] obj The object handle
  * \param[in] instId The object instance ID
- * \param[in] dataIn The object's data structure
+ * \param[in] dataIn The field's data
  * \return 0 if success or -1 if failure
  */
-int32_t UAVObjSetInstanceDataField(UAVObjHandle obj_handle, uint16_t instId, const void* dataIn, uint32_t offset, uint32_t size)
+int32_t UAVObjSetInstanceDataFieldIfChanged(UAVObjHandle obj_handle, uint16_t instId, const void* dataIn, uint32_t offset, uint32_t size)
+{
+	return setInstanceDataField(obj_handle, instId, dataIn, offset, size,
+		true);
+}
+
+/**
+ * Copy into an instance and send the event for it
+ * \param[in] ifChanged Leave out the event if nothing changes; objects
+ * that suppress unchanged updates always do
+ */
+static int32_t setInstanceDataField(UAVObjHandle obj_handle, uint16_t instId,
+		const void *dataIn, uint32_t offset, uint32_t size,
+		bool ifChanged)
 {
 	PIOS_Assert(obj_handle);
 
@@ -1154,7 +1654,7 @@ int32_t UAVObjSetInstanceDataField(UAVObjHandle obj_handle, uint16_t instId, con
 
 		obj_len = MetaNumBytes;
 
-		target = MetaDataPtr((struct UAVOMeta *)obj_handle);
+		target = (void *) MetaDataPtr((struct UAVOMeta *)obj_handle);
 	} else {
 		struct UAVOData * obj;
 		InstanceHandle instEntry;
@@ -1188,8 +1688,40 @@ int32_t UAVObjSetInstanceDataField(UAVObjHandle obj_handle, uint16_t instId, con
 		goto unlock_exit;
 	}
 
+	// Compared under the lock, so nothing can change it in between
+	if ((ifChanged || obj_handle->flags.suppressUnchanged) &&
+			!memcmp(target + offset, dataIn, size)) {
+		rc = 0;
+		goto unlock_exit;
+	}
+
 	// Set data
-	memcpy(target + offset, dataIn, size);
+	if (UAVObjIsMetaobject(obj_handle)) {
+		/* Leave metadata that isn't changing where it is */
+		if (memcmp(target + offset, dataIn, size)) {
+			target = metaDataForWrite((struct UAVOMeta *)obj_handle);
+			if (!target) {
+				goto unlock_exit;
+			}
+
+			memcpy(target + offset, dataIn, size);
+		}
+	} else {
+		struct UAVOData *obj = (struct UAVOData *) obj_handle;
+
+		/* Likewise read-mostly data */
+		if (!obj->base.flags.isReadMostly ||
+				memcmp(target + offset, dataIn, size)) {
+			target = dataForWrite(obj, target);
+			if (!target) {
+				goto unlock_exit;
+			}
+
+			dataWriteBegin(obj);
+			memcpy(target + offset, dataIn, size);
+			dataWriteEnd(obj);
+		}
+	}
 
 	// Fire event
 	sendEvent((struct UAVOBase *)obj_handle, instId, EV_UPDATED,
@@ -1213,6 +1745,15 @@ int32_t UAVObjGetInstanceData(UAVObjHandle obj_handle, uint16_t instId,
 {
 	PIOS_Assert(obj_handle);
 
+	if (instId == 0 && UAVObjIsSingleInstance(obj_handle) &&
+			!UAVObjIsMetaobject(obj_handle)) {
+		struct UAVOData *obj = (struct UAVOData *) obj_handle;
+
+		if (readDataOptimistic(obj, dataOut, 0, obj->instance_size)) {
+			return 0;
+		}
+	}
+
 	// Lock
 	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
 
@@ -1259,6 +1800,19 @@ int32_t UAVObjGetInstanceDataField(UAVObjHandle obj_handle, uint16_t instId, voi
 {
 	PIOS_Assert(obj_handle);
 
+	if (instId == 0 && UAVObjIsSingleInstance(obj_handle) &&
+			!UAVObjIsMetaobject(obj_handle)) {
+		struct UAVOData *obj = (struct UAVOData *) obj_handle;
+
+		if ((size + offset) > obj->instance_size) {
+			return -1;
+		}
+
+		if (readDataOptimistic(obj, dataOut, offset, size)) {
+			return 0;
+		}
+	}
+
 	// Lock
 	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
 
@@ -1276,7 +1830,7 @@ int32_t UAVObjGetInstanceDataField(UAVObjHandle obj_handle, uint16_t instId, voi
 		}
 
 		// Set data
-		memcpy(dataOut, MetaDataPtr((struct UAVOMeta *)obj_handle) + offset, size);
+		memcpy(dataOut, (const uint8_t *) MetaDataPtr((struct UAVOMeta *)obj_handle) + offset, size);
 	} else {
 		struct UAVOData * obj;
 		InstanceHandle instEntry;
@@ -1306,6 +1860,56 @@ unlock_exit:
 	return rc;
 }
 
+/**
+ * Borrow a read-only pointer to the data of an object instance, to read it
+ * in place instead of copying it out.  The object manager lock is held
+ * until UAVObjReleaseInstanceData() is called, so the borrow must be short
+ * and the caller must not block while holding it.
+ * \param[in] obj The object handle
+ * \param[in] instId The object instance ID
+ * \return Pointer to the instance data, or NULL (with no lock held) if the
+ * instance does not exist
+ */
+const void *UAVObjBorrowInstanceData(UAVObjHandle obj_handle, uint16_t instId)
+{
+	PIOS_Assert(obj_handle);
+
+	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
+
+	InstanceHandle instEntry;
+
+	if (UAVObjIsMetaobject(obj_handle)) {
+		if (instId != 0) {
+			instEntry = NULL;
+		} else {
+			/* The borrower may write to it */
+			instEntry = metaDataForWrite(
+					(struct UAVOMeta *)obj_handle);
+		}
+	} else {
+		instEntry = getInstance((struct UAVOData *) obj_handle, instId);
+	}
+
+	if (instEntry == NULL) {
+		PIOS_Recursive_Mutex_Unlock(mutex);
+		return NULL;
+	}
+
+	return InstanceData(instEntry);
+}
+
+/**
+ * Release instance data borrowed with UAVObjBorrowInstanceData().
+ * The pointer must not be used afterwards.
+ * \param[in] obj The object handle
+ */
+void UAVObjReleaseInstanceData(UAVObjHandle obj_handle)
+{
+	PIOS_Assert(obj_handle);
+
+	PIOS_Recursive_Mutex_Unlock(mutex);
+}
+
 /**
  * Set the object metadata
  * \param[in] obj The object handle
@@ -1329,6 +1933,91 @@ int32_t UAVObjSetMetadata(UAVObjHandle obj_handle, const UAVObjMetadata * dataIn
 	return 0;
 }
 
+/**
+ * Set the object metadata back to its defaults.  The defaults are used
+ * where they are, so they must stay valid; they are normally the generated
+ * ones in flash.  The heap doesn't take memory back, so metadata that was
+ * already copied there keeps its copy and has the defaults copied in.
+ * \param[in] obj The object handle
+ * \param[in] defaults The object's default metadata
+ * \return 0 if success or -1 if failure
+ */
+int32_t UAVObjSetDefaultMetadata(UAVObjHandle obj_handle,
+		const UAVObjMetadata *defaults)
+{
+	PIOS_Assert(obj_handle);
+	PIOS_Assert(defaults);
+
+	if (UAVObjIsMetaobject(obj_handle)) {
+		return -1;
+	}
+
+	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
+
+	struct UAVOMeta *obj_meta = &((struct UAVOData *)obj_handle)->metaObj;
+
+	if (obj_meta->base.flags.metaOnHeap) {
+		memcpy((void *) obj_meta->instance0, defaults, MetaNumBytes);
+	} else {
+		obj_meta->instance0 = defaults;
+	}
+
+	sendEvent(&obj_meta->base, 0, EV_UPDATED,
+			(void *) MetaDataPtr(obj_meta), MetaNumBytes);
+
+	PIOS_Recursive_Mutex_Unlock(mutex);
+	return 0;
+}
+
+/**
+ * Set an object instance back to its defaults.  Read-mostly data that
+ * hasn't been changed uses the defaults where they are, so they must stay
+ * valid; they are normally the generated ones in flash.  Any other data
+ * has the defaults copied in.
+ * \param[in] obj The object handle
+ * \param[in] instId The object instance ID
+ * \param[in] defaults The object's default data
+ * \return 0 if success or -1 if failure
+ */
+int32_t UAVObjSetDefaultData(UAVObjHandle obj_handle, uint16_t instId,
+		const void *defaults)
+{
+	PIOS_Assert(obj_handle);
+	PIOS_Assert(defaults);
+
+	if (UAVObjIsMetaobject(obj_handle)) {
+		return -1;
+	}
+
+	struct UAVOData *obj = (struct UAVOData *) obj_handle;
+
+	if (!obj->base.flags.isReadMostly) {
+		return UAVObjSetInstanceData(obj_handle, instId, defaults);
+	}
+
+	if (instId != 0) {
+		return -1;
+	}
+
+	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
+
+	struct UAVOReadMostly *uavo_rm = (struct UAVOReadMostly *) obj;
+
+	dataWriteBegin(obj);
+	if (obj->base.flags.dataOnHeap) {
+		memcpy((void *) uavo_rm->instance0, defaults, obj->instance_size);
+	} else {
+		uavo_rm->instance0 = defaults;
+	}
+	dataWriteEnd(obj);
+
+	sendEvent(&obj->base, 0, EV_UPDATED, (void *) uavo_rm->instance0,
+			obj->instance_size);
+
+	PIOS_Recursive_Mutex_Unlock(mutex);
+	return 0;
+}
+
 /**
  * Get the object metadata
  * \param[in] obj The object handle
@@ -1482,6 +2171,33 @@ void UAVObjSetGcsTelemetryUpdateMode(UAVObjMetadata* metadata, UAVObjUpdateMode
 	SET_BITS(metadata->flags, UAVOBJ_GCS_TELEMETRY_UPDATE_MODE_SHIFT, val, UAVOBJ_UPDATE_MODE_MASK);
 }
 
+/**
+ * Get the UAVObject metadata telemetry priority class
+ * \param[in] metadata The metadata object
+ * \return the telemetry priority class
+ */
+UAVObjTelemetryPriority UAVObjGetTelemetryPriority(const UAVObjMetadata* metadata) {
+	PIOS_Assert(metadata);
+
+	switch (metadata->telemetryPriority) {
+	case TELEMETRYPRIORITY_HIGH:
+	case TELEMETRYPRIORITY_LOW:
+		return metadata->telemetryPriority;
+	default:
+		return TELEMETRYPRIORITY_NORMAL;
+	}
+}
+
+/**
+ * Set the UAVObject metadata telemetry priority class
+ * \param[in] metadata The metadata object
+ * \param[in] val The telemetry priority class
+ */
+void UAVObjSetTelemetryPriority(UAVObjMetadata* metadata, UAVObjTelemetryPriority val) {
+	PIOS_Assert(metadata);
+	metadata->telemetryPriority = val;
+}
+
 
 /**
  * Check if an object is read only
@@ -1656,18 +2372,13 @@ void UAVObjIterate(void (*iterator) (UAVObjHandle obj))
 {
 	PIOS_Assert(iterator);
 
-	// Get lock
-	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
-
-	// Iterate through the list and invoke iterator for each object
+	/* The object list is append-only, so it is walked without a lock.
+	 * Objects registered during the walk may or may not be visited. */
 	struct UAVOData *obj;
 	LL_FOREACH(uavo_list, obj) {
 		(*iterator) ((UAVObjHandle) obj);
 		(*iterator) ((UAVObjHandle) &obj->metaObj);
 	}
-
-	// Release lock
-	PIOS_Recursive_Mutex_Unlock(mutex);
 }
 
 /* type signature must match invokeCallback below, with 4 or fewer args */
@@ -1758,8 +2469,22 @@ static int32_t pumpOneEvent(UAVObjEvent *msg, void *obj_data, int len) {
 
 			// Invoke callback (from event task) if a valid one is registered
 			if (event->cb) {
+#if defined(UAVO_CALLBACK_DIAGNOSTICS)
+				uint32_t cb_start = PIOS_DELAY_GetRaw();
+#endif
+
 				// invoke callback directly; callbacks must be well behaved
 				invokeCallback(event, msg, obj_data, len);
+
+#if defined(UAVO_CALLBACK_DIAGNOSTICS)
+				uint32_t cb_cycles = PIOS_DELAY_GetRaw() - cb_start;
+
+				event->prof_calls++;
+				event->prof_total_cycles += cb_cycles;
+				if (cb_cycles > event->prof_max_cycles) {
+					event->prof_max_cycles = cb_cycles;
+				}
+#endif
 			} else if (event->cbInfo.queue) {
 				if (event->hasThrottle) {
 					throtInfo->inhibited = 1;
@@ -1794,7 +2519,7 @@ static int32_t sendEvent(struct UAVOBase * obj, uint16_t instId,
 		UAVObjEvent msg;
 		void *obj_data;
 		int len;
-	} pending_events[3];
+	} pending_events[UAVOBJ_MAX_PENDING_EVENTS];
 
 	/* The logic to spool up callbacks here may be a little confusing.
 	 * basically, this relies on the fact that we are in a re-entrant
@@ -1806,7 +2531,8 @@ static int32_t sendEvent(struct UAVOBase * obj, uint16_t instId,
 	 * update that will trigger in turn more callbacks.
 	 *
 	 * To handle this, we have a small buffer to store the pending
-	 * callbacks.
+	 * callbacks.  No separate locking is needed for it; every caller
+	 * of sendEvent holds the object manager mutex.
 	 *
 	 * We also make the point of disallowing a callback from generating
 	 * the exact same callback.  This is relevant to things like
@@ -1818,10 +2544,24 @@ static int32_t sendEvent(struct UAVOBase * obj, uint16_t instId,
 	 * trigger callback B which triggers callback A.  Don't do that.
 	 */
 
-	if (num_pending >= 3) {
+	if (num_pending >= UAVOBJ_MAX_PENDING_EVENTS) {
 		/* Unable to pump event; backlog too long */
+		struct UAVOData *uavo_data;
+
+		if (obj->flags.isMeta) {
+			uavo_data = container_of((struct UAVOMeta *)obj,
+					struct UAVOData, metaObj);
+		} else {
+			uavo_data = (struct UAVOData *) obj;
+		}
+
+		if (uavo_data->event_drops < UINT16_MAX) {
+			uavo_data->event_drops++;
+		}
+
 		stats.eventCallbackErrors++;
 		stats.lastCallbackErrorID = UAVObjGetID(obj);
+		stats.lastCallbackErrorDrops = uavo_data->event_drops;
 
 		return -1;
 	}
@@ -1847,6 +2587,10 @@ static int32_t sendEvent(struct UAVOBase * obj, uint16_t instId,
 
 	num_pending++;
 
+	if (num_pending > stats.eventCallbackMaxPending) {
+		stats.eventCallbackMaxPending = num_pending;
+	}
+
 	/* Only enter the section of pumping events if we are the "first event" */
 	if (!in_progress) {
 		/* While there are events to pump.. */
@@ -1940,9 +2684,7 @@ static InstanceHandle getInstance(struct UAVOData * obj, uint16_t instId)
 		if (instId != 0)
 			return NULL;
 
-		/* Augment our pointer to reflect the proper type */
-		struct UAVOSingle * uavo_single = (struct UAVOSingle *) obj;
-		return (&(uavo_single->instance0));
+		return (InstanceHandle) singleInstanceData(obj);
 	} else {
 		/* Multi Instance */
 		/* Augment our pointer to reflect the proper type */
@@ -1950,17 +2692,30 @@ static InstanceHandle getInstance(struct UAVOData * obj, uint16_t instId)
 		if (instId >= uavo_multi->num_instances)
 			return NULL;
 
-		// Look for specified instance ID
+		// Look for specified instance ID, resuming from the last
+		// lookup when we're walking forward
 		uint16_t instance = 0;
-		struct UAVOMultiInst *instEntry;
-		LL_FOREACH(&(uavo_multi->instance0), instEntry) {
-			if (instance++ == instId) {
-				/* Found it */
-				return &(instEntry->instance);
+		struct UAVOMultiInst *instEntry = &(uavo_multi->instance0);
+
+		if (instId >= uavo_multi->last_inst_id) {
+			instance = uavo_multi->last_inst_id;
+			instEntry = uavo_multi->last_inst;
+		}
+
+		while (instance < instId) {
+			instEntry = instEntry->next;
+			instance++;
+
+			if (!instEntry) {
+				/* Instance was not found */
+				return NULL;
 			}
 		}
-		/* Instance was not found */
-		return NULL;
+
+		uavo_multi->last_inst_id = instId;
+		uavo_multi->last_inst = instEntry;
+
+		return &(instEntry->instance);
 	}
 }
 
@@ -2136,8 +2891,6 @@ int32_t getEventMask(UAVObjHandle obj_handle, struct pios_queue *queue)
 uint8_t UAVObjCount()
 {
 	uint8_t count = 0;
-	// Get lock
-	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
 
 	// Look for object
 	struct UAVOData * tmp_obj;
@@ -2145,8 +2898,6 @@ uint8_t UAVObjCount()
 		++count;
 	}
 
-	// Release lock
-	PIOS_Recursive_Mutex_Unlock(mutex);
 	return count;
 }
 
@@ -2157,26 +2908,214 @@ uint8_t UAVObjCount()
 uint32_t UAVObjIDByIndex(uint8_t index)
 {
 	uint8_t count = 0;
-	// Get lock
-	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
 
 	// Look for object
 	struct UAVOData * tmp_obj;
 	LL_FOREACH(uavo_list, tmp_obj) {
 		if (count == index)
 		{
-			// Release lock
-			PIOS_Recursive_Mutex_Unlock(mutex);
 			return tmp_obj->id;
 		}
 		++count;
 	}
 
-	// Release lock
-	PIOS_Recursive_Mutex_Unlock(mutex);
 	return 0;
 }
 
+/**
+ * Where in the settings digest a read is, and the part of it wanted.
+ */
+struct digestWindow {
+	uint8_t *buf;
+	uint32_t start;
+	uint32_t end;
+	uint32_t pos;
+	uint32_t filled;
+};
+
+/**
+ * Put bytes at the current position of the digest, keeping those that fall
+ * in the window.
+ */
+static void digestPut(struct digestWindow *w, const void *data, uint32_t len)
+{
+	const uint8_t *bytes = data;
+
+	for (uint32_t i = 0; i < len; i++, w->pos++) {
+		if (w->pos >= w->start && w->pos < w->end) {
+			w->buf[w->pos - w->start] = bytes[i];
+			w->filled++;
+		}
+	}
+}
+
+/**
+ * CRC of the instance 0 data of an object, or of a metaobject's metadata.
+ * Must be called with the mutex held.
+ */
+static uint32_t digestObjectCRC(UAVObjHandle obj_handle)
+{
+	if (UAVObjIsMetaobject(obj_handle)) {
+		return PIOS_CRC32_updateCRC(0,
+				(const uint8_t *) MetaDataPtr((struct UAVOMeta *) obj_handle),
+				MetaNumBytes);
+	}
+
+	struct UAVOData *obj = (struct UAVOData *) obj_handle;
+	const uint8_t *data = (const uint8_t *) getInstance(obj, 0);
+
+	if (data) {
+		return PIOS_CRC32_updateCRC(0, data, obj->instance_size);
+	}
+
+	/* Read-mostly data that was never set is all zeroes */
+	uint32_t crc = 0;
+
+	for (uint32_t i = 0; i < obj->instance_size; i++) {
+		crc = PIOS_CRC32_updateByte(crc, 0);
+	}
+
+	return crc;
+}
+
+/**
+ * Put the record of an object in the digest.  The CRC is only worked out
+ * when the record is in the window, or it goes into the fingerprint.
+ */
+static void digestRecord(struct digestWindow *w, UAVObjHandle obj_handle,
+		uint32_t *fingerprint)
+{
+	if (!fingerprint && (w->pos + UAVOBJ_DIGEST_RECORD_LEN <= w->start ||
+				w->pos >= w->end)) {
+		w->pos += UAVOBJ_DIGEST_RECORD_LEN;
+		return;
+	}
+
+	uint32_t record[2] = {
+		UAVObjGetID(obj_handle),
+		digestObjectCRC(obj_handle),
+	};
+
+	if (fingerprint) {
+		*fingerprint = PIOS_CRC32_updateCRC(*fingerprint,
+				(const uint8_t *) record, sizeof(record));
+	}
+
+	digestPut(w, record, sizeof(record));
+}
+
+/**
+ * Read part of the settings digest, from which a GCS that cached the
+ * settings of this board can tell which of them changed since.  See
+ * uavobjectmanager.h for the layout.  The CRCs are of the data in RAM,
+ * which may not have been saved.
+ * \param[out] buf Where to put the bytes read
+ * \param[in] offset Where in the digest to start
+ * \param[in] len The most bytes to read
+ * \return the number of bytes read, 0 past the end
+ */
+int32_t UAVObjReadSettingsDigest(uint8_t *buf, uint32_t offset, uint32_t len)
+{
+	PIOS_Assert(buf);
+
+	struct digestWindow w = {
+		.buf = buf,
+		.start = offset,
+		.end = offset + len,
+		.pos = UAVOBJ_DIGEST_HEADER_LEN,
+	};
+
+	/* Everything is needed for the fingerprint, so only bother when the
+	 * header is being read */
+	bool in_header = offset < UAVOBJ_DIGEST_HEADER_LEN;
+	uint32_t fingerprint = 0;
+
+	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
+
+	struct UAVOData *obj;
+	LL_FOREACH(uavo_list, obj) {
+		if (UAVObjIsSettings(&obj->base)) {
+			digestRecord(&w, &obj->base,
+					in_header ? &fingerprint : NULL);
+		}
+
+		/* Metadata still at its defaults is known to the GCS */
+		if (obj->metaObj.base.flags.metaOnHeap) {
+			digestRecord(&w, &obj->metaObj.base,
+					in_header ? &fingerprint : NULL);
+		}
+	}
+
+	PIOS_Recursive_Mutex_Unlock(mutex);
+
+	if (in_header) {
+		uint64_t uavo_hash = UAVOHASH;
+		uint8_t serial[PIOS_SYS_SERIAL_NUM_BINARY_LEN] = { 0 };
+
+		PIOS_SYS_SerialNumberGetBinary(serial);
+
+		w.pos = 0;
+		digestPut(&w, &uavo_hash, sizeof(uavo_hash));
+		digestPut(&w, serial, sizeof(serial));
+		digestPut(&w, &fingerprint, sizeof(fingerprint));
+	}
+
+	return w.filled;
+}
+
+#if defined(UAVO_CALLBACK_DIAGNOSTICS)
+/**
+ * Iterate through the execution time statistics of every connected callback.
+ * The iterator is invoked with the object manager lock held, so it should
+ * only copy out what it needs.
+ * \param[in] iterator Invoked once per connected callback
+ * \param[in] ctx Passed through to the iterator
+ */
+void UAVObjIterateCallbackProfiles(void (*iterator)(
+			const struct UAVObjCallbackProfile *prof, void *ctx),
+		void *ctx)
+{
+	PIOS_Assert(iterator);
+
+	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
+
+	struct UAVOData *obj;
+	LL_FOREACH(uavo_list, obj) {
+		for (int i = 0; i < 2; i++) {
+			struct UAVOBase *base = i ? MetaObjectPtr(obj) : &obj->base;
+
+			struct ObjectEventEntry *event;
+			LL_FOREACH(base->next_event, event) {
+				if (!event->cb) {
+					continue;
+				}
+
+				uint32_t mean_cycles = 0;
+
+				if (event->prof_calls) {
+					mean_cycles = event->prof_total_cycles /
+						event->prof_calls;
+				}
+
+				struct UAVObjCallbackProfile prof = {
+					.obj_id = UAVObjGetID(base),
+					.cb = event->cb,
+					.calls = event->prof_calls,
+					.max_us = PIOS_DELAY_DiffuS2(0,
+							event->prof_max_cycles),
+					.mean_us = PIOS_DELAY_DiffuS2(0,
+							mean_cycles),
+				};
+
+				iterator(&prof, ctx);
+			}
+		}
+	}
+
+	PIOS_Recursive_Mutex_Unlock(mutex);
+}
+#endif /* UAVO_CALLBACK_DIAGNOSTICS */
+
 /**
  * Unblocks a throttled event-- allows it to be inserted into queues once
  * again.
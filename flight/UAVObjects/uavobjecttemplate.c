@@ -58,7 +58,11 @@ int32_t $(NAME)Initialize(void)
 	
 	// Register object with the object manager
 	handle = UAVObjRegister($(NAMEUC)_OBJID,
-			$(NAMEUC)_ISSINGLEINST, $(NAMEUC)_ISSETTINGS, $(NAMEUC)_NUMBYTES, &$(NAME)SetDefaults);
+			$(NAMEUC)_ISSINGLEINST, $(NAMEUC)_ISSETTINGS, $(NAMEUC)_ISFASTRAM,
+			$(NAMEUC)_ISREADMOSTLY, $(NAMEUC)_NUMBYTES, &$(NAME)SetDefaults);
+
+	if (handle != 0 && $(NAMEUC)_ISSUPPRESSUNCHANGED)
+		UAVObjSetSuppressUnchanged(handle, true);
 
 	// Done
 	if (handle != 0)
@@ -71,28 +75,32 @@ int32_t $(NAME)Initialize(void)
 	}
 }
 
-static void $(NAME)SetDefaultsImpl(UAVObjHandle obj, uint16_t instId) {
-	// Initialize object fields to their default values
-	$(NAME)Data data = {};
-
+// Default field values; read-mostly objects use them from flash
+static const $(NAME)Data dataDefaults = {
 $(INITFIELDS)
-	UAVObjSetInstanceData(obj, instId, &data);
+};
+
+static void $(NAME)SetDefaultsImpl(UAVObjHandle obj, uint16_t instId) {
+	UAVObjSetDefaultData(obj, instId, &dataDefaults);
 }
 
-static void $(NAME)SetMetadataDefaults(UAVObjHandle obj) {
-	// Initialize object metadata to their default values
-	UAVObjMetadata metadata;
-	metadata.flags =
+// Default metadata, used from flash until something changes it
+static const UAVObjMetadata metadataDefaults = {
+	.flags =
 		$(FLIGHTACCESS) << UAVOBJ_ACCESS_SHIFT |
 		$(GCSACCESS) << UAVOBJ_GCS_ACCESS_SHIFT |
 		$(FLIGHTTELEM_ACKED) << UAVOBJ_TELEMETRY_ACKED_SHIFT |
 		$(GCSTELEM_ACKED) << UAVOBJ_GCS_TELEMETRY_ACKED_SHIFT |
 		$(FLIGHTTELEM_UPDATEMODE) << UAVOBJ_TELEMETRY_UPDATE_MODE_SHIFT |
-		$(GCSTELEM_UPDATEMODE) << UAVOBJ_GCS_TELEMETRY_UPDATE_MODE_SHIFT;
-	metadata.telemetryUpdatePeriod = $(FLIGHTTELEM_UPDATEPERIOD);
-	metadata.gcsTelemetryUpdatePeriod = $(GCSTELEM_UPDATEPERIOD);
-	metadata.loggingUpdatePeriod = $(LOGGING_UPDATEPERIOD);
-	UAVObjSetMetadata(obj, &metadata);
+		$(GCSTELEM_UPDATEMODE) << UAVOBJ_GCS_TELEMETRY_UPDATE_MODE_SHIFT,
+	.telemetryUpdatePeriod = $(FLIGHTTELEM_UPDATEPERIOD),
+	.gcsTelemetryUpdatePeriod = $(GCSTELEM_UPDATEPERIOD),
+	.loggingUpdatePeriod = $(LOGGING_UPDATEPERIOD),
+	.telemetryPriority = $(FLIGHTTELEM_PRIORITY),
+};
+
+static void $(NAME)SetMetadataDefaults(UAVObjHandle obj) {
+	UAVObjSetDefaultMetadata(obj, &metadataDefaults);
 }
 
 /**
@@ -1,10 +1,13 @@
 #include <loadable_extension.h>
 
 static void entry();
+static void stop();
 
-DECLARE_LOADABLE_EXTENSION(entry);
+DECLARE_LOADABLE_EXTENSION_EXIT(entry, stop);
 
+#include <stdbool.h>
 #include <stddef.h>
+#include <pios_heap.h>
 #include <pios_thread.h>
 #include <pios_modules.h>
 
@@ -17,33 +20,61 @@ void dumb_test_two(void (*fp)(void));
 
 void dumb_regtask(struct pios_thread *h);
 
-const char *const foo = "foobar";
-/* const char *foo = "test"; doesn't work presently.
- * GOT correctly ends up pointing to offset on copydata.
- * But offset on copydata points to location requiring a relocation.
- * analysis here:
- * https://gist.github.com/mlyle/308393dbc7df3762a366d585d5306ceb
+/* The pointer is data, fixed up from the relocation table mkrelocs.py
+ * adds; constant data can't be.
  */
+const char *foo = "foobar";
+
+static volatile bool stopping;
+static volatile bool stopped;
+
+static int *counts;
 
 static void loopy(void *unused) {
 	(void) unused;
 
-	while (1) {
+	while (!stopping) {
 		PIOS_Thread_Sleep(10);
 		dumb_test_delay(i);
 		dumb_test_delay(j);
 		system_annunc_custom_string(foo);
+
+		if (counts) {
+			(*counts)++;
+		}
 	}
 
+	stopped = true;
+
+	PIOS_Thread_Delete(NULL);
 }
 
 static void entry() {
 	j = i * 2;
 
+	stopping = false;
+	stopped = false;
+
+	/* Put down to this extension, and freed when it stops */
+	counts = PIOS_malloc(sizeof(*counts));
+	if (counts) {
+		*counts = 0;
+	}
+
 	struct pios_thread *loadable_task_handle;
 
 	loadable_task_handle = PIOS_Thread_Create(loopy, "module", PIOS_THREAD_STACK_SIZE_MIN, NULL, PIOS_THREAD_PRIO_NORMAL);
 	if (loadable_task_handle) {
 		dumb_regtask(loadable_task_handle);
+	} else {
+		stopped = true;
+	}
+}
+
+static void stop() {
+	stopping = true;
+
+	while (!stopped) {
+		PIOS_Thread_Sleep(1);
 	}
 }
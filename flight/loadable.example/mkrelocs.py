@@ -0,0 +1,124 @@
+#!/usr/bin/env python3
+#
+# Appends the relocation table to a loadable extension (see struct
+# loadable_relocs in flight/Libraries/inc/loadable_extension.h), from the
+# relocations the linker kept with --emit-relocs, and points the header
+# at it.
+#
+# (c) 2017, dRonin
+#
+# See also: The GNU Public License (GPL) Version 3
+#
+
+import argparse
+import struct
+import sys
+
+MOD_RAM_BEGIN = 0x10000000
+
+SHT_REL = 9
+R_ARM_ABS32 = 2
+
+# Words of the extension header
+HDR_LENGTH = 1
+HDR_RELOC_OFFSET = 2
+HDR_RAM_SEG_COPYLEN = 6
+HDR_RAM_SEG_COPYOFF = 7
+
+def read_sections(elf):
+    if elf[:4] != b'\x7fELF' or elf[4] != 1 or elf[5] != 1:
+        raise ValueError("not a little endian 32 bit ELF file")
+
+    shoff, = struct.unpack_from('<I', elf, 0x20)
+    shentsize, shnum, shstrndx = struct.unpack_from('<HHH', elf, 0x2e)
+
+    sections = []
+
+    for i in range(shnum):
+        (name, stype, flags, addr, offset, size, link, info, align,
+                entsize) = struct.unpack_from('<10I', elf, shoff + i * shentsize)
+        sections.append({'name': name, 'type': stype, 'offset': offset,
+                         'size': size, 'info': info})
+
+    strtab = sections[shstrndx]
+
+    for sect in sections:
+        start = strtab['offset'] + sect['name']
+        sect['name'] = elf[start:elf.index(b'\0', start)].decode()
+
+    return sections
+
+def absolute_relocs(elf, sections):
+    """ Yields the section name and address of each absolute relocation """
+    for sect in sections:
+        if sect['type'] != SHT_REL:
+            continue
+
+        target = sections[sect['info']]['name']
+
+        for pos in range(sect['offset'], sect['offset'] + sect['size'], 8):
+            r_offset, r_info = struct.unpack_from('<II', elf, pos)
+
+            if (r_info & 0xff) == R_ARM_ABS32:
+                yield target, r_offset
+
+def main():
+    parser = argparse.ArgumentParser(
+            description="Add the relocation table to a loadable extension")
+    parser.add_argument('elf', help="extension linked with --emit-relocs")
+    parser.add_argument('bin', help="binary made from it, updated in place")
+    args = parser.parse_args()
+
+    with open(args.elf, 'rb') as f:
+        elf = f.read()
+
+    with open(args.bin, 'rb') as f:
+        image = bytearray(f.read())
+
+    header = list(struct.unpack_from('<12I', image))
+    ram_base = MOD_RAM_BEGIN + header[HDR_RAM_SEG_COPYOFF]
+
+    offsets = []
+
+    for target, addr in absolute_relocs(elf, read_sections(elf)):
+        if target == '.data':
+            offset = addr - ram_base
+
+            if offset & 3 or offset < 0 or \
+                    offset + 4 > header[HDR_RAM_SEG_COPYLEN]:
+                raise ValueError("relocation at 0x%08x is outside the "
+                                 "data segment" % addr)
+
+            offsets.append(offset)
+        elif target in ('.text', '.rodata'):
+            # Flash is run where it is, and can't be fixed up
+            raise ValueError("absolute address at 0x%08x in %s; make it "
+                             "writable data" % (addr, target))
+
+    if not offsets:
+        return 0
+
+    offsets.sort()
+
+    length = max(len(image), header[HDR_LENGTH])
+    length = (length + 3) & ~3
+
+    image.extend(b'\0' * (length - len(image)))
+    image.extend(struct.pack('<I', len(offsets)))
+
+    for offset in offsets:
+        image.extend(struct.pack('<I', offset))
+
+    header[HDR_RELOC_OFFSET] = length
+    header[HDR_LENGTH] = len(image)
+    struct.pack_into('<12I', image, 0, *header)
+
+    with open(args.bin, 'wb') as f:
+        f.write(image)
+
+    print("%d relocations" % len(offsets))
+
+    return 0
+
+if __name__ == '__main__':
+    sys.exit(main())
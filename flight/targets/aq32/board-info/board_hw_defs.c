@@ -1507,7 +1507,7 @@ static const struct pios_hmc5883_cfg pios_hmc5883_internal_cfg = {
 #include "pios_ms5611_priv.h"
 static const struct pios_ms5611_cfg pios_ms5611_cfg = {
     .oversampling             = MS5611_OSR_4096,
-    .temperature_interleaving = 1,
+    .temperature_interleaving = 10,
     .use_0x76_address         = true,
 };
 #endif /* PIOS_INCLUDE_MS5611 */
@@ -48,6 +48,9 @@ enum bl_commands {
 	BL_MSG_STATUS_REQ,
 	BL_MSG_STATUS_REP,
 	BL_MSG_WIPE_PARTITION,
+	BL_MSG_SECTOR_CRC_REQ,
+	BL_MSG_SECTOR_CRC_REP,
+	BL_MSG_WRITE_RANGE_START,
 
 	BL_MSG_WRITE_START = 0x27,
 };
@@ -154,6 +157,34 @@ struct bl_messages {
 			enum dfu_partition_label label;
 		} wipe_partition;
 
+		struct msg_sector_crc_req {
+			enum dfu_partition_label label;
+			uint8_t unused;
+			uint16_t first_sector;
+		} sector_crc_req;
+
+#define SECTOR_CRCS_PER_PACKET 6
+		struct msg_sector_crc_rep {
+			enum dfu_partition_label label;
+			uint8_t num_sectors; /* 0 once past the end of the partition */
+			uint16_t first_sector;
+			uint32_t first_offset;
+			struct {
+				uint32_t size;
+				uint32_t crc;
+			} sectors[SECTOR_CRCS_PER_PACKET];
+		} sector_crc_rep;
+
+		/* Write part of a partition, erasing only the sectors it covers */
+		struct msg_xfer_range_start {
+			uint32_t packets_in_transfer;
+			enum dfu_partition_label label;
+			uint8_t words_in_last_packet;
+			uint32_t expected_crc; /* of the whole range, padded with 0xFF */
+			uint32_t start_offset; /* must be the start of a sector */
+			uint32_t length;
+		} xfer_range_start;
+
 		uint8_t pad[62];
 	} __attribute__((aligned(1)))v;
 } __attribute__((packed));
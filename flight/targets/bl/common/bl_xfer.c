@@ -41,6 +41,16 @@
 
 #define MIN(x,y) ((x) < (y) ? (x) : (y))
 
+/*
+ * Incoming write packets are gathered here and programmed a chunk at a time,
+ * rather than opening a flash transaction for every 56 byte packet.  Must be
+ * a multiple of the packet size so only the last chunk of a transfer is
+ * short.
+ */
+#define XFER_WRITE_BUF_SIZE (XFER_BYTES_PER_PACKET * 16)
+
+static uint32_t xfer_write_buf[XFER_WRITE_BUF_SIZE / sizeof(uint32_t)];
+
 static uint32_t bl_compute_partition_crc(uintptr_t partition_id, uint32_t partition_offset, uint32_t length)
 {
 	CRC_ResetDR();
@@ -77,7 +87,7 @@ bool bl_xfer_crc_ok_p(const struct xfer_state * xfer)
 
 	uint32_t actual_crc = bl_compute_partition_crc(xfer->partition_id,
 						xfer->original_partition_offset,
-						xfer->partition_size);
+						xfer->crc_length);
 
 	return (actual_crc == xfer->crc);
 }
@@ -250,6 +260,8 @@ bool bl_xfer_write_start(struct xfer_state * xfer, const struct msg_xfer_start *
 		return false;
 	}
 
+	xfer->crc_length = xfer->partition_size;
+
 	/* Figure out if we need to erase the *selected* partition before writing to it */
 	if (partition_needs_erase) {
 		PIOS_FLASH_start_transaction(xfer->partition_id);
@@ -262,11 +274,191 @@ bool bl_xfer_write_start(struct xfer_state * xfer, const struct msg_xfer_start *
 	xfer->current_partition_offset = xfer->original_partition_offset;
 	xfer->bytes_to_xfer = bytes_to_xfer;
 	xfer->next_packet_number = 0;
+	xfer->write_buf_len = 0;
 	xfer->in_progress = true;
 
 	return true;
 }
 
+/**
+ * Finds a partition that can be written a range at a time.  The description
+ * shares the firmware partition and is never erased on its own, so it can't
+ * be; the firmware partition stops short of it.
+ */
+static bool bl_xfer_find_range_partition(enum dfu_partition_label label,
+		uintptr_t *partition_id, uint32_t *limit)
+{
+	const struct pios_board_info * bdinfo = &pios_board_info_blob;
+	enum pios_flash_partition_labels flash_label;
+
+	switch (label) {
+#ifdef F1_UPGRADER
+	case DFU_PARTITION_BL:
+		flash_label = FLASH_PARTITION_LABEL_BL;
+		break;
+#endif
+	case DFU_PARTITION_FW:
+		flash_label = FLASH_PARTITION_LABEL_FW;
+		break;
+	case DFU_PARTITION_SETTINGS:
+		flash_label = FLASH_PARTITION_LABEL_SETTINGS;
+		break;
+	case DFU_PARTITION_AUTOTUNE:
+		flash_label = FLASH_PARTITION_LABEL_AUTOTUNE;
+		break;
+	case DFU_PARTITION_LOG:
+		flash_label = FLASH_PARTITION_LABEL_LOG;
+		break;
+	case DFU_PARTITION_LOADABLE_EXTENSION:
+		flash_label = FLASH_PARTITION_LABEL_LOADABLE_EXTENSION;
+		break;
+	default:
+		return false;
+	}
+
+	if (PIOS_FLASH_find_partition_id(flash_label, partition_id) != 0)
+		return false;
+
+	if (PIOS_FLASH_get_partition_size(*partition_id, limit) != 0)
+		return false;
+
+#ifdef F1_UPGRADER
+	if (label == DFU_PARTITION_BL)
+		*limit -= bdinfo->desc_size;
+#endif
+	if (label == DFU_PARTITION_FW)
+		*limit -= bdinfo->desc_size;
+
+	return true;
+}
+
+bool bl_xfer_send_sector_crcs(const struct msg_sector_crc_req *sector_crc_req)
+{
+	uintptr_t partition_id;
+	uint32_t limit;
+
+	if (!bl_xfer_find_range_partition(sector_crc_req->label, &partition_id, &limit))
+		return false;
+
+	uint16_t first_sector = BE16_TO_CPU(sector_crc_req->first_sector);
+
+	struct bl_messages msg = {
+		.flags_command = BL_MSG_SECTOR_CRC_REP,
+		.v.sector_crc_rep = {
+			.label        = sector_crc_req->label,
+			.first_sector = CPU_TO_BE16(first_sector),
+		},
+	};
+
+	/* Walk the sectors from the start of the partition */
+	uint32_t offset = 0;
+	uint16_t sector = 0;
+	uint8_t n = 0;
+
+	while ((offset < limit) && (n < SECTOR_CRCS_PER_PACKET)) {
+		uint32_t sector_size;
+		if (PIOS_FLASH_get_sector_size(partition_id, offset, &sector_size) != 0)
+			return false;
+
+		if (sector >= first_sector) {
+			/* The last one may be cut short by the description */
+			uint32_t size = MIN(sector_size, limit - offset);
+
+			if (n == 0)
+				msg.v.sector_crc_rep.first_offset = CPU_TO_BE32(offset);
+
+			msg.v.sector_crc_rep.sectors[n].size = CPU_TO_BE32(size);
+			msg.v.sector_crc_rep.sectors[n].crc  = CPU_TO_BE32(
+				bl_compute_partition_crc(partition_id, offset, size));
+			n++;
+		}
+
+		offset += sector_size;
+		sector++;
+	}
+
+	msg.v.sector_crc_rep.num_sectors = n;
+
+	PIOS_COM_MSG_Send(PIOS_COM_TELEM_USB, (uint8_t *)&msg, sizeof(msg));
+
+	return true;
+}
+
+bool bl_xfer_write_range_start(struct xfer_state * xfer, const struct msg_xfer_range_start *range_start)
+{
+	/* Disable any previous transfer */
+	xfer->in_progress = false;
+
+	uint32_t limit;
+
+	if (!bl_xfer_find_range_partition(range_start->label, &xfer->partition_id, &limit))
+		return false;
+
+	uint32_t start  = BE32_TO_CPU(range_start->start_offset);
+	uint32_t length = BE32_TO_CPU(range_start->length);
+
+	if ((length == 0) || (start >= limit) || (length > limit - start))
+		return false;
+
+	uint32_t bytes_to_xfer = (BE32_TO_CPU(range_start->packets_in_transfer) - 1) * XFER_BYTES_PER_PACKET +
+		range_start->words_in_last_packet * sizeof(uint32_t);
+
+	if (bytes_to_xfer > length)
+		return false;
+
+	/* Erase whole sectors from start until the range is covered */
+	uint32_t erase_length = 0;
+	while (erase_length < length) {
+		uint32_t sector_size;
+		if (PIOS_FLASH_get_sector_size(xfer->partition_id, start + erase_length, &sector_size) != 0)
+			return false;
+
+		erase_length += sector_size;
+	}
+
+	PIOS_FLASH_start_transaction(xfer->partition_id);
+	int32_t ret = PIOS_FLASH_erase_range(xfer->partition_id, start, erase_length);
+	PIOS_FLASH_end_transaction(xfer->partition_id);
+	if (ret != 0)
+		return false;
+
+	PIOS_FLASH_get_partition_size(xfer->partition_id, &xfer->partition_size);
+
+	xfer->check_crc  = true;
+	xfer->crc        = BE32_TO_CPU(range_start->expected_crc);
+	xfer->crc_length = length;
+
+	xfer->original_partition_offset = start;
+	xfer->current_partition_offset  = start;
+	xfer->bytes_to_xfer = bytes_to_xfer;
+	xfer->next_packet_number = 0;
+	xfer->write_buf_len = 0;
+	xfer->in_progress = true;
+
+	return true;
+}
+
+static bool bl_xfer_flush_write_buf(struct xfer_state * xfer)
+{
+	if (xfer->write_buf_len == 0) {
+		return true;
+	}
+
+	PIOS_FLASH_start_transaction(xfer->partition_id);
+
+	int32_t ret = PIOS_FLASH_write_data(xfer->partition_id,
+			xfer->current_partition_offset,
+			(uint8_t *)xfer_write_buf,
+			xfer->write_buf_len);
+
+	PIOS_FLASH_end_transaction(xfer->partition_id);
+
+	xfer->current_partition_offset += xfer->write_buf_len;
+	xfer->write_buf_len = 0;
+
+	return (ret == 0);
+}
+
 bool bl_xfer_write_cont(struct xfer_state * xfer, const struct msg_xfer_cont *xfer_cont)
 {
 	if (!xfer->in_progress) {
@@ -286,28 +478,30 @@ bool bl_xfer_write_cont(struct xfer_state * xfer, const struct msg_xfer_cont *xf
 		return false;
 	}
 
-	/* Fix up the endian of the data words */
+	/* Fix up the endian of the data words on the way into the write buffer */
+	uint32_t *dest = &xfer_write_buf[xfer->write_buf_len / sizeof(uint32_t)];
 	for (uint8_t i = 0; i < bytes_this_xfer / sizeof(uint32_t); i++) {
-		uint32_t *data = &((uint32_t *)xfer_cont->data)[i];
-		*data = BE32_TO_CPU(*data);
+		uint32_t word;
+		memcpy(&word, &xfer_cont->data[i * sizeof(uint32_t)], sizeof(word));
+		dest[i] = BE32_TO_CPU(word);
 	}
 
-	/* Write the data to flash */
-	PIOS_FLASH_start_transaction(xfer->partition_id);
-
-	PIOS_FLASH_write_data(xfer->partition_id,
-			xfer->current_partition_offset,
-			xfer_cont->data,
-			bytes_this_xfer);
-
-	PIOS_FLASH_end_transaction(xfer->partition_id);
-
 	/* Update accounting for how many bytes we've received */
-	xfer->current_partition_offset += bytes_this_xfer;
-	xfer->bytes_to_xfer            -= bytes_this_xfer;
+	xfer->write_buf_len += bytes_this_xfer;
+	xfer->bytes_to_xfer -= bytes_this_xfer;
 
 	xfer->next_packet_number++;
 
+	/*
+	 * Program once the buffer is full, or the transfer is complete so that
+	 * everything is in flash before the CRC is checked.  The host keeps
+	 * queueing packets behind the USB endpoint while this runs.
+	 */
+	if ((xfer->write_buf_len + XFER_BYTES_PER_PACKET > sizeof(xfer_write_buf)) ||
+			(xfer->bytes_to_xfer == 0)) {
+		return bl_xfer_flush_write_buf(xfer);
+	}
+
 	return true;
 }
 
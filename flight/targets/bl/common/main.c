@@ -634,6 +634,13 @@ static void process_packet_rx(struct bl_fsm_context * context, const struct bl_m
 			/* Failed to start the write */
 		}
 		break;
+	case BL_MSG_WRITE_RANGE_START:
+		if (bl_xfer_write_range_start(&context->xfer, &(msg->v.xfer_range_start))) {
+			bl_fsm_inject_event(context, BL_EVENT_WRITE_START);
+		} else {
+			/* Failed to start the write */
+		}
+		break;
 	case BL_MSG_WRITE_CONT:
 		if (bl_fsm_get_state(context) == BL_STATE_DFU_WRITE_IN_PROGRESS) {
 			if (!bl_xfer_write_cont(&context->xfer, &(msg->v.xfer_cont))) {
@@ -673,8 +680,13 @@ static void process_packet_rx(struct bl_fsm_context * context, const struct bl_m
 		bl_xfer_wipe_partition(&(msg->v.wipe_partition));
 		break;
 
+	case BL_MSG_SECTOR_CRC_REQ:
+		bl_xfer_send_sector_crcs(&(msg->v.sector_crc_req));
+		break;
+
 	case BL_MSG_CAP_REP:
 	case BL_MSG_STATUS_REP:
+	case BL_MSG_SECTOR_CRC_REP:
 	case BL_MSG_READ_CONT:
 		/* We've received a *reply* packet when we expected a request. */
 		break;
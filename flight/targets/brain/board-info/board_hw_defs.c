@@ -1689,7 +1689,7 @@ static struct pios_mpu_cfg pios_mpu_cfg = {
 #include "pios_ms5611_priv.h"
 static const struct pios_ms5611_cfg pios_ms5611_cfg = {
 	.oversampling = MS5611_OSR_4096,
-	.temperature_interleaving = 1,
+	.temperature_interleaving = 10,
 };
 #endif /* PIOS_INCLUDE_MS5611 */
 
@@ -81,6 +81,7 @@
 //#define CAMERASTAB_POI_MODE
 
 #define PIOS_INCLUDE_FASTHEAP
+#define PIOS_INCLUDE_CRC_HW
 
 #endif /* PIOS_CONFIG_H */
 
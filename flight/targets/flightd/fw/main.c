@@ -91,8 +91,12 @@ void initTask()
 
 	PIOS_SYS_Args(g_argc, g_argv);
 
-	/* board driver init */
+	/* board driver init, sensor probing included.  Start the clock
+	 * now rather than in there, so that the time can be measured. */
+	PIOS_DELAY_Init();
+	uint32_t board_init_raw = PIOS_DELAY_GetRaw();
 	PIOS_Board_Init();
+	PIOS_Modules_ProfileBoardInit(PIOS_DELAY_DiffuS(board_init_raw));
 
 	/* Initialize modules */
 	MODULE_INITIALISE_ALL(PIOS_WDG_Clear);
@@ -110,10 +110,12 @@
 
 #define PIOS_INCLUDE_FAKETICK
 #define PIOS_INCLUDE_SIMSENSORS
+#define PIOS_INCLUDE_SENSORREPLAY
 #define PIOS_INCLUDE_ADC
 
 #if !(defined(_WIN32) || defined(WIN32) || defined(__MINGW32__))
 #define PIOS_INCLUDE_SIMSENSORS_YASIM
+#define PIOS_INCLUDE_SHM
 #endif
 
 #endif /* PIOS_CONFIG_POSIX_H */
@@ -51,6 +51,14 @@ static struct flyingpicmd_cfg_fa cfg;
 uintptr_t adc_id;
 static uint16_t msg_num;
 
+/* The SPI slave is re-armed as soon as a frame completes, with a response
+ * prepared ahead of time; the frame is acted on (and the next response
+ * made) afterwards, while the host is already free to send another. */
+static struct flyingpi_msg rx_work;
+static struct flyingpi_msg tx_next;
+static int tx_next_len;
+static bool msg_pending;
+
 extern void TIM1_CC_IRQHandler(void);
 extern void TIM1_BRK_UP_TRG_COM_IRQHandler(void);
 extern void TIM2_IRQHandler(void);
@@ -142,11 +150,11 @@ static void handle_actuator_fc(struct flyingpicmd_actuator_fc *cmd) {
 	PIOS_WDG_Clear();
 }
 
-static void generate_status_message(int *resp_len)
+static void generate_status_message(void)
 {
-	tx_buf.id = FLYINGPIRESP_IO;
+	tx_next.id = FLYINGPIRESP_IO;
 
-	struct flyingpiresp_io_10 *resp = &tx_buf.body.io_10;
+	struct flyingpiresp_io_10 *resp = &tx_next.body.io_10;
 
 	bzero(resp, sizeof(*resp));
 
@@ -166,19 +174,19 @@ static void generate_status_message(int *resp_len)
 		resp->adc_data[i] = PIOS_ADC_GetChannelRaw(i);
 	}
 
-	flyingpi_calc_crc(&tx_buf, true, resp_len);
+	flyingpi_calc_crc(&tx_next, true, &tx_next_len);
 
 	msg_num++;
 }
 
-static void process_pio_message_impl(int *resp_len)
+static void process_pio_message_impl(struct flyingpi_msg *msg)
 {
-	switch (rx_buf.id) {
+	switch (msg->id) {
 		case FLYINGPICMD_ACTUATOR:
-			handle_actuator_fc(&rx_buf.body.actuator_fc);
+			handle_actuator_fc(&msg->body.actuator_fc);
 			break;
 		case FLYINGPICMD_CFG:
-			handle_cfg_fa(&rx_buf.body.cfg_fa);
+			handle_cfg_fa(&msg->body.cfg_fa);
 			break;
 		default:
 			/* We got a message with an unknown type, but valid
@@ -186,22 +194,39 @@ static void process_pio_message_impl(int *resp_len)
 			PIOS_Assert(0);
 			break;
 	}
+}
+
+/* Called by the SPI slave driver with DMA stopped; keep it short. */
+static void process_pio_message(void *ctx, int len, int *resp_len)
+{
+	(void) ctx;
+	(void) len;
+
+	memcpy(&rx_work, &rx_buf, sizeof(rx_work));
 
 	/* If we get an edge and no clocking.. make sure the message is
 	 * invalidated / not reused */
 	rx_buf.id = 0;
+
+	memcpy(&tx_buf, &tx_next, tx_next_len);
+	*resp_len = tx_next_len;
+
+	msg_pending = true;
 }
 
-static void process_pio_message(void *ctx, int len, int *resp_len)
+static void handle_pending_message(void)
 {
-	(void) ctx;
-	(void) len;
+	if (!msg_pending) {
+		return;
+	}
 
-	if (flyingpi_calc_crc(&rx_buf, false, NULL)) {
-		process_pio_message_impl(resp_len);
+	msg_pending = false;
+
+	if (flyingpi_calc_crc(&rx_work, false, NULL)) {
+		process_pio_message_impl(&rx_work);
 	}
 
-	generate_status_message(resp_len);
+	generate_status_message();
 }
 
 int main()
@@ -240,8 +265,13 @@ int main()
 	tx_buf.id = 0x33;
 	tx_buf.crc8 = 0x22;
 
-	int initial_msg_len;
-	generate_status_message(&initial_msg_len);
+	/* One response to go out with the first frame, and the one after
+	 * it ready to take its place */
+	generate_status_message();
+	memcpy(&tx_buf, &tx_next, tx_next_len);
+
+	int initial_msg_len = tx_next_len;
+	generate_status_message();
 
 	PIOS_SPISLAVE_Init(&spislave_dev, &pios_spislave_cfg, initial_msg_len);
 
@@ -249,6 +279,7 @@ int main()
 
 	while (1) {
 		PIOS_SPISLAVE_PollSS(spislave_dev);
+		handle_pending_message();
 		PIOS_INTERNAL_ADC_DoStep(adc_dev);
 
 		i++;
@@ -78,6 +78,7 @@
 //#define CAMERASTAB_POI_MODE
 
 #define PIOS_INCLUDE_FASTHEAP
+#define PIOS_INCLUDE_CRC_HW
 #define PIOS_INCLUDE_WS2811
 #define PIOS_INCLUDE_MAX7456
 #define CHAROSD_FONT_MINIMAL
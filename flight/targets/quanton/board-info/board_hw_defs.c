@@ -2413,7 +2413,7 @@ static const struct pios_hmc5883_cfg pios_hmc5883_internal_cfg = {
 #include "pios_ms5611_priv.h"
 static const struct pios_ms5611_cfg pios_ms5611_cfg = {
 	.oversampling = MS5611_OSR_1024,
-	.temperature_interleaving = 1,
+	.temperature_interleaving = 10,
 };
 #endif /* PIOS_INCLUDE_MS5611 */
 
@@ -381,6 +381,7 @@ static const struct pios_flash_jedec_cfg flash_chip_cfgs[] = {
 		.expect_memorytype   = 0x20,
 		.expect_capacity     = 0x15,
 		.sector_erase        = 0xD8,
+		.fast_read           = true,	/* READ is only good to 20MHz */
 	},
 	{
 		/* Larger NOR flash has been shipping on some clone Revolution boards
@@ -2056,7 +2057,7 @@ static const struct pios_hmc5883_cfg pios_hmc5883_cfg = {
 #include "pios_ms5611_priv.h"
 static const struct pios_ms5611_cfg pios_ms5611_cfg = {
 	.oversampling = MS5611_OSR_1024,
-	.temperature_interleaving = 1,
+	.temperature_interleaving = 10,
 };
 #endif /* PIOS_INCLUDE_MS5611 */
 
@@ -1115,7 +1115,7 @@ const struct pios_usb_cdc_cfg pios_usb_cdc_cfg = {
 #include "pios_ms5611_priv.h"
 static const struct pios_ms5611_cfg pios_ms5611_cfg = {
 	.oversampling = MS5611_OSR_1024,
-	.temperature_interleaving = 1,
+	.temperature_interleaving = 10,
 };
 #endif /* PIOS_INCLUDE_MS5611 */
 
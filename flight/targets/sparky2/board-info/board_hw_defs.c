@@ -350,6 +350,7 @@ static const struct pios_flash_jedec_cfg flash_m25p_cfg = {
 	.expect_memorytype   = 0x20,
 	.expect_capacity     = 0x15,
 	.sector_erase        = 0xD8,
+	.fast_read           = true,	/* READ is only good to 20MHz */
 };
 #endif	/* PIOS_INCLUDE_FLASH_JEDEC */
 
@@ -572,9 +573,59 @@ bool get_external_flash(uint32_t board_revision)
 /*
  * MAIN USART
  */
+
+/* USART1 RX on DMA2 Stream5 Ch4, TX on DMA2 Stream7 Ch4 */
+static const struct pios_usart_dma_cfg pios_usart_main_dma_cfg = {
+	.dma = {
+		.irq = {
+			.init = {
+				.NVIC_IRQChannel = DMA2_Stream5_IRQn,
+				.NVIC_IRQChannelPreemptionPriority = PIOS_IRQ_PRIO_MID,
+				.NVIC_IRQChannelSubPriority = 0,
+				.NVIC_IRQChannelCmd = ENABLE,
+			},
+		},
+		.rx = {
+			.channel = DMA2_Stream5,
+			.init = {
+				.DMA_Channel            = DMA_Channel_4,
+				.DMA_PeripheralInc      = DMA_PeripheralInc_Disable,
+				.DMA_MemoryInc          = DMA_MemoryInc_Enable,
+				.DMA_PeripheralDataSize = DMA_PeripheralDataSize_Byte,
+				.DMA_MemoryDataSize     = DMA_MemoryDataSize_Byte,
+				.DMA_Priority           = DMA_Priority_Medium,
+				.DMA_FIFOMode           = DMA_FIFOMode_Disable,
+				.DMA_FIFOThreshold      = DMA_FIFOThreshold_Full,
+				.DMA_MemoryBurst        = DMA_MemoryBurst_Single,
+				.DMA_PeripheralBurst    = DMA_PeripheralBurst_Single,
+			},
+		},
+		.tx = {
+			.channel = DMA2_Stream7,
+			.init = {
+				.DMA_Channel            = DMA_Channel_4,
+				.DMA_PeripheralInc      = DMA_PeripheralInc_Disable,
+				.DMA_MemoryInc          = DMA_MemoryInc_Enable,
+				.DMA_PeripheralDataSize = DMA_PeripheralDataSize_Byte,
+				.DMA_MemoryDataSize     = DMA_MemoryDataSize_Byte,
+				.DMA_Priority           = DMA_Priority_Medium,
+				.DMA_FIFOMode           = DMA_FIFOMode_Disable,
+				.DMA_FIFOThreshold      = DMA_FIFOThreshold_Full,
+				.DMA_MemoryBurst        = DMA_MemoryBurst_Single,
+				.DMA_PeripheralBurst    = DMA_PeripheralBurst_Single,
+			},
+		},
+	},
+	.rx_flags = DMA_FLAG_TCIF5 | DMA_FLAG_HTIF5 | DMA_FLAG_TEIF5 |
+		DMA_FLAG_DMEIF5 | DMA_FLAG_FEIF5,
+	.tx_flags = DMA_FLAG_TCIF7 | DMA_FLAG_HTIF7 | DMA_FLAG_TEIF7 |
+		DMA_FLAG_DMEIF7 | DMA_FLAG_FEIF7,
+};
+
 static const struct pios_usart_cfg pios_usart_main_cfg = {
 	.regs = USART1,
 	.remap = GPIO_AF_USART1,
+	.dma = &pios_usart_main_dma_cfg,
 	.irq = {
 		.init = {
 			.NVIC_IRQChannel = USART1_IRQn,
@@ -605,6 +656,11 @@ static const struct pios_usart_cfg pios_usart_main_cfg = {
 	},
 };
 
+void DMA2_Stream5_IRQHandler(void)
+{
+	PIOS_USART_DMA_Rx_IRQHandler(&pios_usart_main_cfg);
+}
+
 static const struct pios_usart_cfg pios_usart_rcvr_pc7_cfg = {
 	.regs = USART6,
 	.remap = GPIO_AF_USART6,
@@ -1544,7 +1600,7 @@ bool get_use_can(uint32_t board_revision)
 #include "pios_ms5611_priv.h"
 static const struct pios_ms5611_cfg pios_ms5611_cfg = {
 	.oversampling = MS5611_OSR_1024,
-	.temperature_interleaving = 1,
+	.temperature_interleaving = 10,
 };
 #endif /* PIOS_INCLUDE_MS5611 */
 
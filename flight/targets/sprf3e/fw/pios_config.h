@@ -81,6 +81,7 @@
 //#define CAMERASTAB_POI_MODE
 
 #define PIOS_INCLUDE_FASTHEAP
+#define PIOS_INCLUDE_CRC_HW
 #define PIOS_INCLUDE_WS2811
 #define SYSTEMMOD_RGBLED_SUPPORT
 
@@ -0,0 +1,188 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     dRonin, http://dronin.org, Copyright (C) 2017
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>		/* printf */
+#include <stdlib.h>		/* abort */
+#include <string.h>		/* memset */
+#include <stdint.h>		/* uint*_t */
+
+extern "C" {
+#include "aes128.h"		/* API for encryption */
+}
+
+/* The key used by the SP 800-38A and RFC 4493 examples */
+static const uint8_t example_key[AES128_KEY_SIZE] = {
+  0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6,
+  0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c,
+};
+
+/* ... and their message */
+static const uint8_t example_msg[64] = {
+  0x6b, 0xc1, 0xbe, 0xe2, 0x2e, 0x40, 0x9f, 0x96,
+  0xe9, 0x3d, 0x7e, 0x11, 0x73, 0x93, 0x17, 0x2a,
+  0xae, 0x2d, 0x8a, 0x57, 0x1e, 0x03, 0xac, 0x9c,
+  0x9e, 0xb7, 0x6f, 0xac, 0x45, 0xaf, 0x8e, 0x51,
+  0x30, 0xc8, 0x1c, 0x46, 0xa3, 0x5c, 0xe4, 0x11,
+  0xe5, 0xfb, 0xc1, 0x19, 0x1a, 0x0a, 0x52, 0xef,
+  0xf6, 0x9f, 0x24, 0x45, 0xdf, 0x4f, 0x9b, 0x17,
+  0xad, 0x2b, 0x41, 0x7b, 0xe6, 0x6c, 0x37, 0x10,
+};
+
+// To use a test fixture, derive a class from testing::Test.
+class AES128 : public testing::Test {
+protected:
+  virtual void SetUp() {
+    aes128_setkey(&ctx, example_key);
+  }
+
+  virtual void TearDown() {
+  }
+
+  struct aes128_ctx ctx;
+};
+
+TEST_F(AES128, EncryptsFIPS197Example) {
+  /* FIPS-197 appendix C.1 */
+  const uint8_t key[AES128_KEY_SIZE] = {
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+    0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f,
+  };
+  const uint8_t plain[AES128_BLOCK_SIZE] = {
+    0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77,
+    0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff,
+  };
+  const uint8_t expected[AES128_BLOCK_SIZE] = {
+    0x69, 0xc4, 0xe0, 0xd8, 0x6a, 0x7b, 0x04, 0x30,
+    0xd8, 0xcd, 0xb7, 0x80, 0x70, 0xb4, 0xc5, 0x5a,
+  };
+  uint8_t out[AES128_BLOCK_SIZE];
+
+  aes128_setkey(&ctx, key);
+  aes128_encrypt(&ctx, plain, out);
+
+  EXPECT_EQ(0, memcmp(expected, out, sizeof(out)));
+
+  /* In place gives the same */
+  memcpy(out, plain, sizeof(out));
+  aes128_encrypt(&ctx, out, out);
+
+  EXPECT_EQ(0, memcmp(expected, out, sizeof(out)));
+}
+
+TEST_F(AES128, CounterModeSP80038A) {
+  /* SP 800-38A F.5.1 */
+  const uint8_t iv[AES128_BLOCK_SIZE] = {
+    0xf0, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7,
+    0xf8, 0xf9, 0xfa, 0xfb, 0xfc, 0xfd, 0xfe, 0xff,
+  };
+  const uint8_t expected[64] = {
+    0x87, 0x4d, 0x61, 0x91, 0xb6, 0x20, 0xe3, 0x26,
+    0x1b, 0xef, 0x68, 0x64, 0x99, 0x0d, 0xb6, 0xce,
+    0x98, 0x06, 0xf6, 0x6b, 0x79, 0x70, 0xfd, 0xff,
+    0x86, 0x17, 0x18, 0x7b, 0xb9, 0xff, 0xfd, 0xff,
+    0x5a, 0xe4, 0xdf, 0x3e, 0xdb, 0xd5, 0xd3, 0x5e,
+    0x5b, 0x4f, 0x09, 0x02, 0x0d, 0xb0, 0x3e, 0xab,
+    0x1e, 0x03, 0x1d, 0xda, 0x2f, 0xbe, 0x03, 0xd1,
+    0x79, 0x21, 0x70, 0xa0, 0xf3, 0x00, 0x9c, 0xee,
+  };
+  uint8_t buf[64];
+
+  memcpy(buf, example_msg, sizeof(buf));
+  aes128_ctr(&ctx, iv, buf, sizeof(buf));
+
+  EXPECT_EQ(0, memcmp(expected, buf, sizeof(buf)));
+
+  /* Decrypting is the same operation */
+  aes128_ctr(&ctx, iv, buf, sizeof(buf));
+
+  EXPECT_EQ(0, memcmp(example_msg, buf, sizeof(buf)));
+}
+
+TEST_F(AES128, CounterModePartialBlock) {
+  const uint8_t iv[AES128_BLOCK_SIZE] = { 0 };
+  uint8_t whole[40];
+  uint8_t part[40];
+
+  memcpy(whole, example_msg, sizeof(whole));
+  memcpy(part, example_msg, sizeof(part));
+
+  /* A shorter run is a prefix of the longer one's result */
+  aes128_ctr(&ctx, iv, whole, sizeof(whole));
+  aes128_ctr(&ctx, iv, part, 21);
+
+  EXPECT_EQ(0, memcmp(whole, part, 21));
+  EXPECT_EQ(0, memcmp(example_msg + 21, part + 21, sizeof(part) - 21));
+}
+
+TEST_F(AES128, CMACRFC4493) {
+  /* RFC 4493 section 4, examples 1 to 4 */
+  const uint8_t expected[4][AES128_BLOCK_SIZE] = {
+    { 0xbb, 0x1d, 0x69, 0x29, 0xe9, 0x59, 0x37, 0x28,
+      0x7f, 0xa3, 0x7d, 0x12, 0x9b, 0x75, 0x67, 0x46 },
+    { 0x07, 0x0a, 0x16, 0xb4, 0x6b, 0x4d, 0x41, 0x44,
+      0xf7, 0x9b, 0xdd, 0x9d, 0xd0, 0x4a, 0x28, 0x7c },
+    { 0xdf, 0xa6, 0x67, 0x47, 0xde, 0x9a, 0xe6, 0x30,
+      0x30, 0xca, 0x32, 0x61, 0x14, 0x97, 0xc8, 0x27 },
+    { 0x51, 0xf0, 0xbe, 0xbf, 0x7e, 0x3b, 0x9d, 0x92,
+      0xfc, 0x49, 0x74, 0x17, 0x79, 0x36, 0x3c, 0xfe },
+  };
+  const size_t lengths[4] = { 0, 16, 40, 64 };
+  uint8_t mac[AES128_BLOCK_SIZE];
+
+  for (int i = 0; i < 4; i++) {
+    aes128_cmac(&ctx, example_msg, lengths[i], mac);
+
+    EXPECT_EQ(0, memcmp(expected[i], mac, sizeof(mac))) << "example " << i + 1;
+  }
+}
+
+TEST_F(AES128, CMACSubkeys) {
+  /* RFC 4493 section 4, subkey generation */
+  const uint8_t k1[AES128_BLOCK_SIZE] = {
+    0xfb, 0xee, 0xd6, 0x18, 0x35, 0x71, 0x33, 0x66,
+    0x7c, 0x85, 0xe0, 0x8f, 0x72, 0x36, 0xa8, 0xde,
+  };
+  const uint8_t k2[AES128_BLOCK_SIZE] = {
+    0xf7, 0xdd, 0xac, 0x30, 0x6a, 0xe2, 0x66, 0xcc,
+    0xf9, 0x0b, 0xc1, 0x1e, 0xe4, 0x6d, 0x51, 0x3b,
+  };
+
+  EXPECT_EQ(0, memcmp(k1, ctx.k1, sizeof(k1)));
+  EXPECT_EQ(0, memcmp(k2, ctx.k2, sizeof(k2)));
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,11 @@
+/*
+ * The math libraries only need PiOS from openpilot.h; this keeps the
+ * benchmark from pulling in the UAVObject manager through alarms.h.
+ */
+
+#ifndef OPENPILOT_H
+#define OPENPILOT_H
+
+#include <pios.h>
+
+#endif /* OPENPILOT_H */
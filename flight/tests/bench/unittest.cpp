@@ -0,0 +1,120 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     dRonin, http://dronin.org, Copyright (C) 2017
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Host benchmarks of the flight math libraries
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>		/* printf */
+#include <stdint.h>		/* uint*_t */
+#include <chrono>
+
+extern "C" {
+#include "bench_cases.h"
+}
+
+// Each case is timed REPEATS times over ITERATIONS steps and the fastest
+// run is reported, which keeps scheduler noise out of the numbers.
+#define ITERATIONS 20000
+#define REPEATS 5
+
+class Benchmark : public testing::Test {
+protected:
+  virtual void SetUp() {
+    bench_setup();
+  }
+
+  void time_case(enum bench_case bench) {
+    const char *name = bench_name(bench);
+    double best = 0;
+
+    ASSERT_TRUE(name != NULL);
+
+    // Warm the caches and let the filters settle first
+    bench_run(bench, ITERATIONS / 10);
+
+    for (int i = 0; i < REPEATS; i++) {
+      auto start = std::chrono::steady_clock::now();
+      bench_run(bench, ITERATIONS);
+      auto end = std::chrono::steady_clock::now();
+
+      double ns = std::chrono::duration<double, std::nano>(end - start).count() / ITERATIONS;
+      if (i == 0 || ns < best) {
+        best = ns;
+      }
+    }
+
+    printf("%-16s %10.1f ns/op\n", name, best);
+    RecordProperty(name, (int) (best + 0.5));
+
+    EXPECT_GT(best, 0);
+  }
+};
+
+TEST_F(Benchmark, LPFilter) {
+  time_case(BENCH_LPFILTER);
+}
+
+TEST_F(Benchmark, PID) {
+  time_case(BENCH_PID);
+}
+
+TEST_F(Benchmark, LQG) {
+  time_case(BENCH_LQG);
+}
+
+TEST_F(Benchmark, SmoothControl) {
+  time_case(BENCH_SMOOTHCONTROL);
+}
+
+TEST_F(Benchmark, Coordinates) {
+  time_case(BENCH_COORDINATES);
+}
+
+TEST_F(Benchmark, INSPredict) {
+  time_case(BENCH_INS_PREDICT);
+}
+
+TEST_F(Benchmark, INSCovariance) {
+  time_case(BENCH_INS_COVARIANCE);
+}
+
+TEST_F(Benchmark, INSCorrection) {
+  time_case(BENCH_INS_CORRECTION);
+}
+
+TEST_F(Benchmark, FastCoordinates) {
+  time_case(BENCH_FAST_COORDINATES);
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -181,3 +181,94 @@ TEST_F(QuatRPYTest, BackAndForth) {
 		}
 	}
 }
+
+TEST_F(QuatRPYTest, ApproxMatchesExact) {
+	float eps = 0.002f;
+
+	float quat[4];
+	float rpy[3];
+	float rpy_out[3];
+	float rpy_approx[3];
+
+	for (float r = -175; r < 175; r += 7.3f) {
+		for (float p = -89; p < 89; p += 4.1f) {
+			for (float y = -175; y < 175; y += 11.7f) {
+				rpy[0] = r; rpy[1] = p; rpy[2] = y;
+
+				RPY2Quaternion(rpy, quat);
+				Quaternion2RPY(quat, rpy_out);
+				Quaternion2RPYApprox(quat, rpy_approx);
+
+				for (int i = 0; i < 3; i++) {
+					ASSERT_NEAR(rpy_out[i], rpy_approx[i], eps);
+				}
+			}
+		}
+	}
+}
+
+class QuatMath : public CoordConversion {
+  virtual void SetUp() {
+  }
+
+  virtual void TearDown() {
+  }
+};
+
+TEST_F(QuatMath, MultNormalizeMatchesMult) {
+	float eps = 0.00001f;
+
+	float q1[4], q2[4], prod[4], fused[4];
+	float rpy[3];
+
+	for (int i = 0; i < 100; i++) {
+		rpy[0] = i * 3.7f - 170; rpy[1] = i * 1.3f - 65; rpy[2] = i * 2.9f;
+		RPY2Quaternion(rpy, q1);
+
+		rpy[0] = i * 1.1f; rpy[1] = 40 - i * 0.7f; rpy[2] = 170 - i * 3.1f;
+		RPY2Quaternion(rpy, q2);
+
+		// Not quite unit length, as after integrating a step
+		for (int j = 0; j < 4; j++) {
+			q1[j] *= 1.01f;
+			q2[j] *= 0.98f;
+		}
+
+		quat_mult(q1, q2, prod);
+		quat_mult_normalize(q1, q2, fused);
+
+		float mag = sqrtf(prod[0] * prod[0] + prod[1] * prod[1] +
+				prod[2] * prod[2] + prod[3] * prod[3]);
+
+		for (int j = 0; j < 4; j++) {
+			ASSERT_NEAR(prod[j] / mag, fused[j], eps);
+		}
+	}
+}
+
+TEST_F(QuatMath, RotMultNMatchesRotMult) {
+	float eps = 0.00001f;
+
+	float rpy[3] = { 30, -20, 100 };
+	float q[4], R[3][3];
+
+	RPY2Quaternion(rpy, q);
+	Quaternion2R(q, R);
+
+	float vecs[5][3] = {
+		{ 1, 0, 0 }, { 0, 1, 0 }, { 0, 0, 1 }, { 1, 2, 3 }, { -4, 0.5f, 9 },
+	};
+	float out[5][3], expected[3];
+
+	for (int transpose = 0; transpose < 2; transpose++) {
+		rot_mult_n(R, vecs, out, 5, transpose);
+
+		for (int i = 0; i < 5; i++) {
+			rot_mult(R, vecs[i], expected, transpose);
+
+			for (int j = 0; j < 3; j++) {
+				ASSERT_NEAR(expected[j], out[i][j], eps);
+			}
+		}
+	}
+}
@@ -0,0 +1,53 @@
+/**
+ ******************************************************************************
+ * @file       bench_parts.h
+ * @author     dRonin, http://dronin.org, Copyright (C) 2017
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief The flash parts and filesystem layouts benchmarked
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef BENCH_PARTS_H
+#define BENCH_PARTS_H
+
+#include "pios_flash_priv.h"
+#include "pios_flash_posix_priv.h"
+#include "pios_flashfs_logfs_priv.h"
+#include "pios_streamfs_priv.h"
+
+struct bench_part {
+	const struct pios_flash_posix_cfg *flash_cfg;
+	const struct pios_flash_partition *partitions;
+	uint8_t num_partitions;
+	/* Laid out as on the boards that carry the part */
+	const struct flashfs_logfs_cfg *logfs_cfg;
+	const struct streamfs_cfg *streamfs_cfg;
+};
+
+extern const struct bench_part bench_parts[];
+extern const uint32_t bench_num_parts;
+
+extern uintptr_t pios_posix_flash_id;
+
+#endif /* BENCH_PARTS_H */
+
+/**
+ * @}
+ * @}
+ */
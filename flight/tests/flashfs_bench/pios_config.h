@@ -0,0 +1,4 @@
+#define PIOS_INCLUDE_DELAY
+#define PIOS_INCLUDE_FLASH
+#define PIOS_NO_HW
+#define FLIGHT_POSIX
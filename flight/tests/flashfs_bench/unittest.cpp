@@ -0,0 +1,284 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     dRonin, http://dronin.org, Copyright (C) 2017
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Benchmarks of logfs and streamfs on modelled flash parts
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>		/* printf */
+#include <string.h>		/* memset */
+#include <stdint.h>		/* uint*_t */
+#include <unistd.h>		/* unlink */
+#include <string>
+
+extern "C" {
+
+#include "pios_flash.h"		/* PIOS_FLASH_* API */
+
+#include "bench_parts.h"
+
+#include "pios_flashfs.h"	/* PIOS_FLASHFS_* */
+
+#include "pios_streamfs.h"	/* PIOS_STREAMFS_* */
+
+int32_t PIOS_STREAMFS_Testing_Write(uintptr_t fs_id, uint8_t *data, uint32_t len);
+
+}
+
+// All times below are what the modelled part would have spent busy, from
+// the posix flash driver, not how long the host took.
+#define FLASH_FNAME "flashfs_bench.bin"
+
+// Roughly the settings objects of a configured board
+#define NUM_OBJS 60
+#define MIN_OBJ_SIZE 10
+#define MAX_OBJ_SIZE 240
+#define SAVE_ROUNDS 20
+
+// Most of the log partition
+#define LOG_CHUNK 256
+#define LOG_BYTES (768 * 1024)
+
+class FlashfsBenchmark : public testing::Test {
+protected:
+  virtual void SetUp() {
+    PIOS_Flash_Posix_SetFName(FLASH_FNAME);
+    flash_id = 0;
+  }
+
+  virtual void TearDown() {
+    if (flash_id) {
+      PIOS_Flash_Posix_Destroy(flash_id);
+    }
+    unlink(FLASH_FNAME);
+  }
+
+  void open_part(const struct bench_part *part) {
+    ASSERT_EQ(0, PIOS_Flash_Posix_Init(&pios_posix_flash_id, part->flash_cfg, true));
+    flash_id = pios_posix_flash_id;
+    PIOS_FLASH_register_partition_table(part->partitions, part->num_partitions);
+  }
+
+  uint64_t busy_ns() {
+    struct pios_flash_posix_stats stats;
+
+    PIOS_Flash_Posix_GetStats(flash_id, &stats);
+    return stats.busy_ns;
+  }
+
+  void report(const struct bench_part *part, const char *what, double value, const char *unit) {
+    std::string name = std::string(part->flash_cfg->timing->name) + "." + what;
+
+    printf("%-12s %-22s %12.2f %s\n", part->flash_cfg->timing->name, what, value, unit);
+    RecordProperty(name.c_str(), (int) (value + 0.5));
+  }
+
+  static uint16_t obj_size(uint32_t obj) {
+    return MIN_OBJ_SIZE + (obj * 37) % (MAX_OBJ_SIZE - MIN_OBJ_SIZE + 1);
+  }
+
+  // Saves every object SAVE_ROUNDS times over, as a tuning session would,
+  // optionally letting the background compaction run between saves.
+  void settings_saves(const struct bench_part *part, bool maintain) {
+    const char *suffix = maintain ? "maintained" : "inline";
+    uintptr_t fs_id;
+    uint8_t obj[MAX_OBJ_SIZE];
+    uint64_t total_ns = 0, worst_ns = 0;
+    uint32_t saves = 0;
+
+    open_part(part);
+    ASSERT_EQ(0, PIOS_FLASHFS_Logfs_Init(&fs_id, part->logfs_cfg, FLASH_PARTITION_LABEL_SETTINGS));
+    PIOS_Flash_Posix_ResetStats(flash_id);
+
+    for (uint32_t round = 0; round < SAVE_ROUNDS; round++) {
+      for (uint32_t i = 0; i < NUM_OBJS; i++) {
+        memset(obj, round + i, obj_size(i));
+
+        uint64_t before = busy_ns();
+        ASSERT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, i, 0, obj, obj_size(i)));
+        uint64_t took = busy_ns() - before;
+
+        total_ns += took;
+        if (took > worst_ns) {
+          worst_ns = took;
+        }
+        saves++;
+
+        if (maintain) {
+          PIOS_FLASHFS_Maintain(fs_id);
+        }
+      }
+    }
+
+    struct pios_flash_posix_stats stats;
+    PIOS_Flash_Posix_GetStats(flash_id, &stats);
+
+    report(part, (std::string("save_mean_us_") + suffix).c_str(), total_ns / 1e3 / saves, "us");
+    report(part, (std::string("save_worst_ms_") + suffix).c_str(), worst_ns / 1e6, "ms");
+    report(part, (std::string("erases_") + suffix).c_str(), stats.erases, "sectors");
+    report(part, (std::string("wear_max_") + suffix).c_str(), stats.max_sector_erases, "erases");
+
+    EXPECT_EQ(0U, stats.bad_programs);
+
+    // Everything must still read back as last saved
+    for (uint32_t i = 0; i < NUM_OBJS; i++) {
+      uint8_t expected[MAX_OBJ_SIZE];
+
+      memset(expected, SAVE_ROUNDS - 1 + i, obj_size(i));
+      EXPECT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, i, 0, obj, obj_size(i)));
+      EXPECT_EQ(0, memcmp(expected, obj, obj_size(i)));
+    }
+
+    PIOS_FLASHFS_Logfs_Destroy(fs_id);
+  }
+
+  uintptr_t flash_id;
+};
+
+TEST_F(FlashfsBenchmark, SettingsSave) {
+  for (uint32_t p = 0; p < bench_num_parts; p++) {
+    settings_saves(&bench_parts[p], false);
+    TearDown();
+    SetUp();
+  }
+}
+
+TEST_F(FlashfsBenchmark, SettingsSaveMaintained) {
+  for (uint32_t p = 0; p < bench_num_parts; p++) {
+    settings_saves(&bench_parts[p], true);
+    TearDown();
+    SetUp();
+  }
+}
+
+// What loading every setting costs at boot
+TEST_F(FlashfsBenchmark, SettingsLoad) {
+  for (uint32_t p = 0; p < bench_num_parts; p++) {
+    const struct bench_part *part = &bench_parts[p];
+    uintptr_t fs_id;
+    uint8_t obj[MAX_OBJ_SIZE];
+
+    open_part(part);
+    ASSERT_EQ(0, PIOS_FLASHFS_Logfs_Init(&fs_id, part->logfs_cfg, FLASH_PARTITION_LABEL_SETTINGS));
+
+    for (uint32_t i = 0; i < NUM_OBJS; i++) {
+      memset(obj, i, obj_size(i));
+      ASSERT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, i, 0, obj, obj_size(i)));
+    }
+
+    PIOS_Flash_Posix_ResetStats(flash_id);
+
+    for (uint32_t i = 0; i < NUM_OBJS; i++) {
+      EXPECT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, i, 0, obj, obj_size(i)));
+    }
+
+    report(part, "load_all_ms", busy_ns() / 1e6, "ms");
+
+    PIOS_FLASHFS_Logfs_Destroy(fs_id);
+    TearDown();
+    SetUp();
+  }
+}
+
+// Logging a flight over an older one, with the sector erases inline as
+// they are whenever the streamfs task hasn't erased ahead
+TEST_F(FlashfsBenchmark, LogAppend) {
+  for (uint32_t p = 0; p < bench_num_parts; p++) {
+    const struct bench_part *part = &bench_parts[p];
+    uintptr_t fs_id;
+    uint8_t chunk[LOG_CHUNK];
+    uint64_t worst_ns = 0;
+
+    open_part(part);
+    ASSERT_EQ(0, PIOS_STREAMFS_Init(&fs_id, part->streamfs_cfg, FLASH_PARTITION_LABEL_LOG));
+    ASSERT_EQ(0, PIOS_STREAMFS_Format(fs_id));
+
+    // The older flight, which leaves no erased sectors to log into
+    memset(chunk, 0, sizeof(chunk));
+    ASSERT_EQ(0, PIOS_STREAMFS_OpenWrite(fs_id));
+    for (uint32_t off = 0; off < LOG_BYTES; off += LOG_CHUNK) {
+      ASSERT_EQ(0, PIOS_STREAMFS_Testing_Write(fs_id, chunk, sizeof(chunk)));
+    }
+    ASSERT_EQ(0, PIOS_STREAMFS_Close(fs_id));
+
+    ASSERT_EQ(0, PIOS_STREAMFS_OpenWrite(fs_id));
+    PIOS_Flash_Posix_ResetStats(flash_id);
+
+    for (uint32_t off = 0; off < LOG_BYTES; off += LOG_CHUNK) {
+      memset(chunk, off / LOG_CHUNK, sizeof(chunk));
+
+      uint64_t before = busy_ns();
+      ASSERT_EQ(0, PIOS_STREAMFS_Testing_Write(fs_id, chunk, sizeof(chunk)));
+      uint64_t took = busy_ns() - before;
+
+      if (took > worst_ns) {
+        worst_ns = took;
+      }
+    }
+
+    uint64_t write_ns = busy_ns();
+
+    struct pios_flash_posix_stats stats;
+    PIOS_Flash_Posix_GetStats(flash_id, &stats);
+
+    report(part, "log_kbytes_per_s", LOG_BYTES / 1024.0 / (write_ns / 1e9), "KB/s");
+    report(part, "log_worst_stall_ms", worst_ns / 1e6, "ms");
+    report(part, "log_erases", stats.erases, "sectors");
+
+    EXPECT_EQ(0U, stats.bad_programs);
+
+    ASSERT_EQ(0, PIOS_STREAMFS_Close(fs_id));
+
+    int32_t file_id = PIOS_STREAMFS_MaxFileId(fs_id);
+    ASSERT_EQ(0, PIOS_STREAMFS_OpenRead(fs_id, file_id));
+
+    PIOS_Flash_Posix_ResetStats(flash_id);
+
+    uint32_t total = 0;
+    int32_t rc;
+    while ((rc = PIOS_STREAMFS_Read(fs_id, chunk, sizeof(chunk))) > 0) {
+      EXPECT_EQ((uint8_t) (total / LOG_CHUNK), chunk[0]);
+      total += rc;
+    }
+
+    report(part, "read_kbytes_per_s", total / 1024.0 / (busy_ns() / 1e9), "KB/s");
+
+    EXPECT_EQ((uint32_t) LOG_BYTES, total);
+
+    PIOS_STREAMFS_Close(fs_id);
+    TearDown();
+    SetUp();
+  }
+}
+
+/**
+ * @}
+ * @}
+ */
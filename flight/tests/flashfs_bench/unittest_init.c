@@ -0,0 +1,188 @@
+/* 
+ * These need to be defined in a .c file so that we can use
+ * designated initializer syntax which c++ doesn't support (yet).
+ */
+
+#define NELEMENTS(x) (sizeof(x) / sizeof(*(x)))
+
+#include "pios.h"
+
+#include "bench_parts.h"
+
+#include "pios_thread.h"
+
+/* The same 2MB of each part is used: a 256KB settings partition and a 1MB
+ * log partition, so that the parts differ only in timing and sectors. */
+#define FLASH_SIZE (2 * 1024 * 1024)
+#define SETTINGS_SIZE (256 * 1024)
+#define LOG_SIZE (1024 * 1024)
+
+uintptr_t pios_posix_flash_id;
+
+/* 64KB sectors, as erased with 0xD8 on revo, sparky2 and brainre1 */
+static const struct pios_flash_sector_range sectors_64k[] = {
+	{
+		.base_sector = 0,
+		.last_sector = FLASH_SIZE / FLASH_SECTOR_64KB - 1,
+		.sector_size = FLASH_SECTOR_64KB,
+	},
+};
+
+static const struct pios_flash_chip chip_64k = {
+	.driver        = &pios_posix_flash_driver,
+	.chip_id       = &pios_posix_flash_id,
+	.page_size     = 256,
+	.sector_blocks = sectors_64k,
+	.num_blocks    = NELEMENTS(sectors_64k),
+};
+
+#define SECTORS_64K(bytes) ((bytes) / FLASH_SECTOR_64KB)
+
+static const struct pios_flash_partition partitions_64k[] = {
+	{
+		.label        = FLASH_PARTITION_LABEL_SETTINGS,
+		.chip_desc    = &chip_64k,
+		.first_sector = 0,
+		.last_sector  = SECTORS_64K(SETTINGS_SIZE) - 1,
+		.chip_offset  = 0,
+		.size         = SETTINGS_SIZE,
+	},
+
+	{
+		.label        = FLASH_PARTITION_LABEL_LOG,
+		.chip_desc    = &chip_64k,
+		.first_sector = SECTORS_64K(SETTINGS_SIZE),
+		.last_sector  = SECTORS_64K(SETTINGS_SIZE + LOG_SIZE) - 1,
+		.chip_offset  = SETTINGS_SIZE,
+		.size         = LOG_SIZE,
+	},
+};
+
+/* 4KB sectors, as erased with 0x20 on brain and quanton */
+static const struct pios_flash_sector_range sectors_4k[] = {
+	{
+		.base_sector = 0,
+		.last_sector = FLASH_SIZE / FLASH_SECTOR_4KB - 1,
+		.sector_size = FLASH_SECTOR_4KB,
+	},
+};
+
+static const struct pios_flash_chip chip_4k = {
+	.driver        = &pios_posix_flash_driver,
+	.chip_id       = &pios_posix_flash_id,
+	.page_size     = 256,
+	.sector_blocks = sectors_4k,
+	.num_blocks    = NELEMENTS(sectors_4k),
+};
+
+#define SECTORS_4K(bytes) ((bytes) / FLASH_SECTOR_4KB)
+
+static const struct pios_flash_partition partitions_4k[] = {
+	{
+		.label        = FLASH_PARTITION_LABEL_SETTINGS,
+		.chip_desc    = &chip_4k,
+		.first_sector = 0,
+		.last_sector  = SECTORS_4K(SETTINGS_SIZE) - 1,
+		.chip_offset  = 0,
+		.size         = SETTINGS_SIZE,
+	},
+
+	{
+		.label        = FLASH_PARTITION_LABEL_LOG,
+		.chip_desc    = &chip_4k,
+		.first_sector = SECTORS_4K(SETTINGS_SIZE),
+		.last_sector  = SECTORS_4K(SETTINGS_SIZE + LOG_SIZE) - 1,
+		.chip_offset  = SETTINGS_SIZE,
+		.size         = LOG_SIZE,
+	},
+};
+
+static const struct flashfs_logfs_cfg logfs_64k = {
+	.fs_magic      = 0x89abceef,
+	.arena_size    = 0x00010000, /* 256 * slot size */
+	.slot_size     = 0x00000100, /* 256 bytes */
+};
+
+static const struct flashfs_logfs_cfg logfs_4k = {
+	.fs_magic      = 0x89abceef,
+	.arena_size    = 0x00004000, /* 64 * slot size */
+	.slot_size     = 0x00000100, /* 256 bytes */
+};
+
+/* As the logging module sets it up */
+static const struct streamfs_cfg streamfs_64k = {
+	.fs_magic      = 0x89abceef,
+	.arena_size    = FLASH_SECTOR_64KB,
+	.write_size    = 0x00000100, /* 256 bytes */
+};
+
+static const struct streamfs_cfg streamfs_4k = {
+	.fs_magic      = 0x89abceef,
+	.arena_size    = FLASH_SECTOR_4KB,
+	.write_size    = 0x00000100, /* 256 bytes */
+};
+
+static const struct pios_flash_posix_cfg flash_m25p16 = {
+	.size_of_flash  = FLASH_SIZE,
+	.size_of_sector = FLASH_SECTOR_64KB,
+	.timing         = &pios_flash_posix_timing_m25p16,
+};
+
+static const struct pios_flash_posix_cfg flash_mx25l32 = {
+	.size_of_flash  = FLASH_SIZE,
+	.size_of_sector = FLASH_SECTOR_4KB,
+	.timing         = &pios_flash_posix_timing_mx25l32,
+};
+
+static const struct pios_flash_posix_cfg flash_s25fl127 = {
+	.size_of_flash  = FLASH_SIZE,
+	.size_of_sector = FLASH_SECTOR_64KB,
+	.timing         = &pios_flash_posix_timing_s25fl127,
+};
+
+const struct bench_part bench_parts[] = {
+	{
+		.flash_cfg      = &flash_m25p16,
+		.partitions     = partitions_64k,
+		.num_partitions = NELEMENTS(partitions_64k),
+		.logfs_cfg      = &logfs_64k,
+		.streamfs_cfg   = &streamfs_64k,
+	},
+	{
+		.flash_cfg      = &flash_mx25l32,
+		.partitions     = partitions_4k,
+		.num_partitions = NELEMENTS(partitions_4k),
+		.logfs_cfg      = &logfs_4k,
+		.streamfs_cfg   = &streamfs_4k,
+	},
+	{
+		.flash_cfg      = &flash_s25fl127,
+		.partitions     = partitions_64k,
+		.num_partitions = NELEMENTS(partitions_64k),
+		.logfs_cfg      = &logfs_64k,
+		.streamfs_cfg   = &streamfs_64k,
+	},
+};
+
+const uint32_t bench_num_parts = NELEMENTS(bench_parts);
+
+/* streamfs starts a task to write out what's logged through PIOS_COM.  The
+ * benchmarks append with PIOS_STREAMFS_Testing_Write instead, so the task
+ * is never run. */
+struct pios_thread *PIOS_Thread_Create(void (*fp)(void *), const char *namep, size_t stack_bytes, void *argp, enum pios_thread_prio_e prio)
+{
+	static int dummy;
+
+	return (struct pios_thread *) &dummy;
+}
+
+void PIOS_Thread_Sleep(uint32_t time_ms)
+{
+}
+
+/* The streamfs calls take the COM device layered on top of it; the
+ * benchmarks have none and pass the streamfs instance itself. */
+uintptr_t PIOS_COM_GetDriverCtx(uintptr_t com_id)
+{
+	return com_id;
+}
@@ -0,0 +1,287 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2017
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+
+#include <math.h>		/* fabs */
+#include <stdio.h>		/* snprintf */
+#include <stdlib.h>		/* rand */
+#include <stdint.h>		/* uint*_t */
+
+extern "C" {
+#include "geofmt.h"		/* API for fixed point formatting */
+#include "mgrs.h"
+#include "utm.h"
+}
+
+#define WGS84_A 6378137.0
+#define WGS84_F (1 / 298.257223563)
+
+// In metres; the two agree to a cm or two out at the edges of the zones
+#define UTM_TOLERANCE 0.03
+
+// To use a test fixture, derive a class from testing::Test.
+class GeoFmt : public testing::Test {
+protected:
+  virtual void SetUp() {
+    srand(42);
+  }
+
+  virtual void TearDown() {
+  }
+
+  int32_t randomE7(int32_t min, int32_t max) {
+    return min + (int32_t) ((double) rand() / RAND_MAX * ((double) max - min));
+  }
+
+  /* Compares against the mgrs library, at the zone it picks */
+  void checkUtm(int32_t lat_e7, int32_t lon_e7) {
+    struct geofmt_utm utm;
+    int zone;
+    char hemisphere;
+    double easting, northing;
+
+    Set_UTM_Parameters(WGS84_A, WGS84_F, 0);
+    ASSERT_EQ(0, Convert_Geodetic_To_UTM(lat_e7 / 1e7 * M_PI / 180,
+          lon_e7 / 1e7 * M_PI / 180, &zone, &hemisphere, &easting, &northing));
+    ASSERT_EQ(0, geofmt_utm(lat_e7, lon_e7, &utm));
+
+    EXPECT_EQ(zone, utm.zone) << lat_e7 << " " << lon_e7;
+    EXPECT_EQ(hemisphere == 'S', utm.south) << lat_e7 << " " << lon_e7;
+    EXPECT_NEAR(easting, utm.easting_cm / 100.0, UTM_TOLERANCE)
+      << lat_e7 << " " << lon_e7;
+    EXPECT_NEAR(northing, utm.northing_cm / 100.0, UTM_TOLERANCE)
+      << lat_e7 << " " << lon_e7;
+  }
+
+  /* Whether a coordinate is too near a rounding edge to compare strings */
+  bool nearEdge(double m, int precision) {
+    double unit = pow(10, 5 - precision);
+    double frac = fmod(m / unit, 1.0);
+
+    return fabs(frac - 0.5) * unit < UTM_TOLERANCE;
+  }
+
+  void checkMgrs(int32_t lat_e7, int32_t lon_e7, int precision) {
+    char expected[32];
+    char actual[GEOFMT_MGRS_LEN];
+    int zone;
+    char hemisphere;
+    double easting, northing;
+
+    Set_UTM_Parameters(WGS84_A, WGS84_F, 0);
+    Convert_Geodetic_To_UTM(lat_e7 / 1e7 * M_PI / 180,
+        lon_e7 / 1e7 * M_PI / 180, &zone, &hemisphere, &easting, &northing);
+
+    if (nearEdge(easting, precision) || nearEdge(northing, precision)) {
+      return;
+    }
+
+    ASSERT_EQ(0, Convert_Geodetic_To_MGRS(lat_e7 / 1e7 * M_PI / 180,
+          lon_e7 / 1e7 * M_PI / 180, precision, expected));
+    ASSERT_EQ(0, geofmt_mgrs(lat_e7, lon_e7, precision, actual));
+
+    EXPECT_STREQ(expected, actual) << lat_e7 << " " << lon_e7;
+  }
+};
+
+TEST_F(GeoFmt, UtmGrid) {
+  for (int32_t lat = -80; lat < 84; lat++) {
+    for (int32_t lon = -180; lon < 180; lon += 3) {
+      checkUtm(lat * 10000000 + 1234567, lon * 10000000 + 7654321);
+    }
+  }
+}
+
+TEST_F(GeoFmt, UtmRandom) {
+  for (int i = 0; i < 100000; i++) {
+    checkUtm(randomE7(-800000000, 840000000),
+        randomE7(-1800000000, 1799999999));
+  }
+}
+
+TEST_F(GeoFmt, UtmOutOfRange) {
+  struct geofmt_utm utm;
+  char buf[GEOFMT_MGRS_LEN];
+
+  EXPECT_EQ(-1, geofmt_utm(-800000001, 0, &utm));
+  EXPECT_EQ(-1, geofmt_utm(840000001, 0, &utm));
+  EXPECT_EQ(-1, geofmt_mgrs(890000000, 0, 5, buf));
+  EXPECT_EQ(-1, geofmt_mgrs(0, 0, 0, buf));
+  EXPECT_EQ(-1, geofmt_mgrs(0, 0, 6, buf));
+}
+
+TEST_F(GeoFmt, UtmBands) {
+  struct geofmt_utm utm;
+
+  ASSERT_EQ(0, geofmt_utm(-800000000, 0, &utm));
+  EXPECT_EQ('C', utm.band);
+  ASSERT_EQ(0, geofmt_utm(-1, 0, &utm));
+  EXPECT_EQ('M', utm.band);
+  ASSERT_EQ(0, geofmt_utm(0, 0, &utm));
+  EXPECT_EQ('N', utm.band);
+  ASSERT_EQ(0, geofmt_utm(720000000, 0, &utm));
+  EXPECT_EQ('X', utm.band);
+  ASSERT_EQ(0, geofmt_utm(840000000, 0, &utm));
+  EXPECT_EQ('X', utm.band);
+}
+
+TEST_F(GeoFmt, MgrsKnown) {
+  char buf[GEOFMT_MGRS_LEN];
+
+  // Norway and Svalbard, where the zones are moved
+  ASSERT_EQ(0, geofmt_mgrs(600000000, 50000000, 5, buf));
+  EXPECT_EQ(buf[0], '3');
+  EXPECT_EQ(buf[1], '2');
+  ASSERT_EQ(0, geofmt_mgrs(780000000, 100000000, 5, buf));
+  EXPECT_EQ(buf[0], '3');
+  EXPECT_EQ(buf[1], '3');
+}
+
+TEST_F(GeoFmt, MgrsGrid) {
+  for (int precision = 1; precision <= 5; precision++) {
+    for (int32_t lat = -80; lat < 84; lat += 2) {
+      for (int32_t lon = -180; lon < 180; lon += 5) {
+        checkMgrs(lat * 10000000 + 3141592, lon * 10000000 + 2718281,
+            precision);
+      }
+    }
+  }
+}
+
+TEST_F(GeoFmt, MgrsRandom) {
+  for (int i = 0; i < 100000; i++) {
+    checkMgrs(randomE7(-800000000, 840000000),
+        randomE7(-1800000000, 1799999999), 1 + i % 5);
+  }
+}
+
+TEST_F(GeoFmt, MgrsZone31V) {
+  // Along the cut short eastern edge of 31V, both sides
+  for (int32_t lon = 25000000; lon < 35000000; lon += 1000) {
+    checkMgrs(600000000, lon, 5);
+    checkMgrs(600000000, lon, 1);
+  }
+}
+
+TEST_F(GeoFmt, MinutesE4) {
+  EXPECT_EQ(0u, geofmt_minutes_e4(0));
+  EXPECT_EQ(600000u, geofmt_minutes_e4(10000000));
+  EXPECT_EQ(600000u, geofmt_minutes_e4(-10000000));
+  EXPECT_EQ(108000000u, geofmt_minutes_e4(1800000000));
+  EXPECT_EQ(108000000u, geofmt_minutes_e4(-1800000000));
+
+  for (int i = 0; i < 100000; i++) {
+    int32_t v = randomE7(-1800000000, 1800000000);
+
+    // As the bridges had it, with the fraction of a degree in 32 bits
+    uint32_t a = abs(v);
+    uint32_t expected = (a / 10000000) * 600000 + (a % 10000000) * 6 / 100;
+
+    EXPECT_EQ(expected, geofmt_minutes_e4(v));
+  }
+}
+
+TEST_F(GeoFmt, DegMin) {
+  struct geofmt_deg_min dm;
+
+  geofmt_deg_min(-1234567890, &dm);
+
+  EXPECT_TRUE(dm.negative);
+  EXPECT_EQ(123, dm.degrees);
+  EXPECT_EQ(27, dm.minutes);
+  EXPECT_EQ(4073, dm.minutes_e4);
+
+  geofmt_deg_min(475999999, &dm);
+
+  EXPECT_FALSE(dm.negative);
+  EXPECT_EQ(47, dm.degrees);
+  EXPECT_EQ(35, dm.minutes);
+  EXPECT_EQ(9999, dm.minutes_e4);
+}
+
+TEST_F(GeoFmt, Uint) {
+  char buf[16];
+  char expected[16];
+
+  EXPECT_EQ(buf + 1, geofmt_uint(buf, 0, 0));
+  EXPECT_STREQ("0", buf);
+  EXPECT_EQ(buf + 10, geofmt_uint(buf, UINT32_MAX, 1));
+  EXPECT_STREQ("4294967295", buf);
+  EXPECT_EQ(buf + 5, geofmt_uint(buf, 42, 5));
+  EXPECT_STREQ("00042", buf);
+
+  for (int i = 0; i < 10000; i++) {
+    uint32_t v = rand();
+    uint8_t digits = i % 10;
+
+    snprintf(expected, sizeof(expected), "%0*u", digits, v);
+    geofmt_uint(buf, v, digits);
+
+    EXPECT_STREQ(expected, buf);
+  }
+}
+
+TEST_F(GeoFmt, Fixed) {
+  char buf[16];
+  char expected[16];
+
+  geofmt_fixed(buf, -4, 7, 5);
+  EXPECT_STREQ("0.00000", buf);
+  geofmt_fixed(buf, -50, 7, 5);
+  EXPECT_STREQ("-0.00001", buf);
+  geofmt_fixed(buf, INT32_MIN, 7, 5);
+  EXPECT_STREQ("-214.74836", buf);
+  geofmt_fixed(buf, 1234, 2, 0);
+  EXPECT_STREQ("12", buf);
+  geofmt_fixed(buf, 1234, 2, 2);
+  EXPECT_STREQ("12.34", buf);
+
+  for (int i = 0; i < 100000; i++) {
+    int32_t v = randomE7(-1800000000, 1800000000);
+
+    // printf rounds the nearest double, which for a tie can go either way
+    if (abs(v) % 100 == 50) {
+      continue;
+    }
+
+    snprintf(expected, sizeof(expected), "%0.5f", v / 1e7);
+    geofmt_fixed(buf, v, 7, 5);
+
+    EXPECT_STREQ(expected, buf);
+  }
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,286 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2017
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+
+#include <pthread.h>		/* pthread_create */
+#include <stdlib.h>		/* abort */
+#include <string.h>		/* memset */
+#include <stdint.h>		/* uint*_t */
+
+extern "C" {
+#include "pios_heap.h"		/* PIOS_pool_* API */
+
+void PIOS_DEBUG_Panic(const char *)
+{
+  abort();
+}
+}
+
+// The pools are global, so each test only looks at how the stats move
+class HeapPool : public testing::Test {
+protected:
+  struct pios_pool_stats before;
+
+  int classOf(size_t size) {
+    struct pios_pool_stats stats;
+
+    for (uint8_t i = 0; i < PIOS_POOL_NUM_CLASSES; i++) {
+      PIOS_pool_get_stats(i, &stats);
+
+      if (size <= stats.block_size) {
+        return i;
+      }
+    }
+
+    return -1;
+  }
+
+  void snapshot(size_t size) {
+    ASSERT_EQ(0, PIOS_pool_get_stats(classOf(size), &before));
+  }
+
+  struct pios_pool_stats now(size_t size) {
+    struct pios_pool_stats stats;
+
+    PIOS_pool_get_stats(classOf(size), &stats);
+
+    return stats;
+  }
+};
+
+TEST_F(HeapPool, Classes) {
+  struct pios_pool_stats stats;
+
+  ASSERT_EQ(0, PIOS_pool_get_stats(0, &stats));
+  EXPECT_EQ(16, stats.block_size);
+  ASSERT_EQ(0, PIOS_pool_get_stats(PIOS_POOL_NUM_CLASSES - 1, &stats));
+  EXPECT_EQ(4096, stats.block_size);
+  EXPECT_EQ(-1, PIOS_pool_get_stats(PIOS_POOL_NUM_CLASSES, &stats));
+
+  EXPECT_EQ(0, classOf(1));
+  EXPECT_EQ(0, classOf(16));
+  EXPECT_EQ(1, classOf(17));
+  EXPECT_EQ(PIOS_POOL_NUM_CLASSES - 1, classOf(4096));
+}
+
+TEST_F(HeapPool, AllocFree) {
+  snapshot(100);
+
+  uint8_t *buf = (uint8_t *) PIOS_pool_malloc(100);
+
+  ASSERT_TRUE(buf != NULL);
+  EXPECT_EQ(0u, (uintptr_t) buf % sizeof(uintptr_t));
+
+  // The whole block is ours, up to the class size
+  memset(buf, 0xa5, 128);
+
+  EXPECT_EQ(before.in_use + 1, now(100).in_use);
+  EXPECT_LE(before.in_use + 1, now(100).peak);
+
+  PIOS_pool_free(buf);
+
+  EXPECT_EQ(before.in_use, now(100).in_use);
+
+  PIOS_pool_free(NULL);
+}
+
+TEST_F(HeapPool, Reuse) {
+  void *a = PIOS_pool_malloc(200);
+  ASSERT_TRUE(a != NULL);
+  PIOS_pool_free(a);
+
+  snapshot(200);
+
+  // Anything in the same class gets the block back, without a new one
+  void *b = PIOS_pool_malloc(129);
+  EXPECT_EQ(a, b);
+  EXPECT_EQ(before.carved, now(200).carved);
+
+  // With it taken, the next one comes from the heap
+  void *c = PIOS_pool_malloc(256);
+  ASSERT_TRUE(c != NULL);
+  EXPECT_NE(b, c);
+  EXPECT_EQ(before.carved + 1, now(200).carved);
+  EXPECT_EQ(before.in_use + 2, now(200).in_use);
+
+  // Last freed, first reused
+  PIOS_pool_free(b);
+  PIOS_pool_free(c);
+  EXPECT_EQ(c, PIOS_pool_malloc(250));
+  EXPECT_EQ(b, PIOS_pool_malloc(250));
+
+  PIOS_pool_free(b);
+  PIOS_pool_free(c);
+  EXPECT_EQ(before.in_use, now(200).in_use);
+  EXPECT_EQ(before.failures, now(200).failures);
+}
+
+TEST_F(HeapPool, Peak) {
+  void *bufs[8];
+
+  snapshot(1000);
+
+  for (int i = 0; i < 8; i++) {
+    bufs[i] = PIOS_pool_malloc(1000);
+    ASSERT_TRUE(bufs[i] != NULL);
+  }
+
+  for (int i = 0; i < 8; i++) {
+    PIOS_pool_free(bufs[i]);
+  }
+
+  struct pios_pool_stats stats = now(1000);
+
+  EXPECT_EQ(before.in_use, stats.in_use);
+  EXPECT_LE(before.in_use + 8, stats.peak);
+  EXPECT_LE(8u, stats.carved);
+}
+
+TEST_F(HeapPool, Reserve) {
+  snapshot(3000);
+
+  ASSERT_EQ(0, PIOS_pool_reserve(3000, 4));
+
+  EXPECT_EQ(before.carved + 4, now(3000).carved);
+  EXPECT_EQ(before.in_use, now(3000).in_use);
+
+  // The reserved blocks are handed out before any new ones
+  void *bufs[4];
+
+  for (int i = 0; i < 4; i++) {
+    bufs[i] = PIOS_pool_malloc(3000);
+    ASSERT_TRUE(bufs[i] != NULL);
+  }
+
+  EXPECT_EQ(before.carved + 4, now(3000).carved);
+
+  for (int i = 0; i < 4; i++) {
+    PIOS_pool_free(bufs[i]);
+  }
+
+  EXPECT_EQ(-1, PIOS_pool_reserve(4097, 1));
+}
+
+TEST_F(HeapPool, Unpooled) {
+  struct pios_pool_stats stats[PIOS_POOL_NUM_CLASSES];
+
+  for (uint8_t i = 0; i < PIOS_POOL_NUM_CLASSES; i++) {
+    PIOS_pool_get_stats(i, &stats[i]);
+  }
+
+  uint8_t *buf = (uint8_t *) PIOS_pool_malloc(10000);
+
+  ASSERT_TRUE(buf != NULL);
+  memset(buf, 0x5a, 10000);
+  PIOS_pool_free(buf);
+
+  // Too big for any class, so no class counts it
+  for (uint8_t i = 0; i < PIOS_POOL_NUM_CLASSES; i++) {
+    struct pios_pool_stats after;
+
+    PIOS_pool_get_stats(i, &after);
+
+    EXPECT_EQ(stats[i].carved, after.carved);
+    EXPECT_EQ(stats[i].in_use, after.in_use);
+  }
+}
+
+#define THREAD_COUNT 4
+#define THREAD_ROUNDS 50000
+#define THREAD_BLOCKS 4
+
+static pthread_barrier_t start_barrier;
+
+static void *churn(void *arg)
+{
+  uint8_t id = (uintptr_t) arg;
+  uint8_t *bufs[THREAD_BLOCKS];
+
+  pthread_barrier_wait(&start_barrier);
+
+  for (int i = 0; i < THREAD_ROUNDS; i++) {
+    for (int k = 0; k < THREAD_BLOCKS; k++) {
+      bufs[k] = (uint8_t *) PIOS_pool_malloc(48);
+
+      if (!bufs[k]) {
+        return (void *) 1;
+      }
+
+      memset(bufs[k], id, 48);
+    }
+
+    // Another thread given the same block would have written over it
+    for (int k = 0; k < THREAD_BLOCKS; k++) {
+      for (int j = 0; j < 48; j++) {
+        if (bufs[k][j] != id) {
+          return (void *) 1;
+        }
+      }
+
+      PIOS_pool_free(bufs[k]);
+    }
+  }
+
+  return NULL;
+}
+
+TEST_F(HeapPool, Threads) {
+  pthread_t threads[THREAD_COUNT];
+
+  snapshot(48);
+
+  pthread_barrier_init(&start_barrier, NULL, THREAD_COUNT);
+
+  for (uintptr_t i = 0; i < THREAD_COUNT; i++) {
+    ASSERT_EQ(0, pthread_create(&threads[i], NULL, churn, (void *) (i + 1)));
+  }
+
+  for (int i = 0; i < THREAD_COUNT; i++) {
+    void *ret;
+
+    ASSERT_EQ(0, pthread_join(threads[i], &ret));
+    EXPECT_EQ(NULL, ret);
+  }
+
+  pthread_barrier_destroy(&start_barrier);
+
+  struct pios_pool_stats stats = now(48);
+
+  EXPECT_EQ(before.in_use, stats.in_use);
+  EXPECT_GE(before.carved + THREAD_COUNT * THREAD_BLOCKS, stats.carved);
+}
+
+/**
+ * @}
+ * @}
+ */
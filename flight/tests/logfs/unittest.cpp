@@ -326,6 +326,140 @@ TEST_F(LogfsTestCooked, WriteManyVerify) {
   EXPECT_EQ(0, memcmp(obj3, obj3_check, sizeof(obj3)));
 }
 
+TEST_F(LogfsTestCooked, WriteDeleteRemountVerify) {
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ1_ID, 0, obj1, sizeof(obj1)));
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ1_ID, 123, obj1_alt, sizeof(obj1_alt)));
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ2_ID, 0, obj2, sizeof(obj2)));
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ1_ID, 0, obj1_alt, sizeof(obj1_alt)));
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjDelete(fs_id, OBJ2_ID, 0));
+
+  /* Remount, rebuilding the slot index from what is in flash */
+  PIOS_FLASHFS_Logfs_Destroy(fs_id);
+  EXPECT_EQ(0, PIOS_FLASHFS_Logfs_Init(&fs_id, &flashfs_config_settings, FLASH_PARTITION_LABEL_SETTINGS));
+
+  unsigned char obj1_check[OBJ1_SIZE];
+  memset(obj1_check, 0, sizeof(obj1_check));
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, OBJ1_ID, 0, obj1_check, sizeof(obj1_check)));
+  EXPECT_EQ(0, memcmp(obj1_alt, obj1_check, sizeof(obj1_alt)));
+
+  memset(obj1_check, 0, sizeof(obj1_check));
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, OBJ1_ID, 123, obj1_check, sizeof(obj1_check)));
+  EXPECT_EQ(0, memcmp(obj1_alt, obj1_check, sizeof(obj1_alt)));
+
+  unsigned char obj2_check[OBJ2_SIZE];
+  EXPECT_EQ(-3, PIOS_FLASHFS_ObjLoad(fs_id, OBJ2_ID, 0, obj2_check, sizeof(obj2_check)));
+}
+
+TEST_F(LogfsTestCooked, BackgroundGarbageCollect) {
+  /* Nothing to collect on a fresh filesystem */
+  EXPECT_EQ(0, PIOS_FLASHFS_Maintain(fs_id));
+
+  /* Keep a handful of instances live */
+  for (uint16_t i = 1; i <= 8; i++) {
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ1_ID, i, obj1, sizeof(obj1)));
+  }
+
+  /* Churn one instance until the log fills up enough to start collecting */
+  int32_t rc = 0;
+  for (uint32_t i = 0; rc == 0 && i < (flashfs_config_settings.arena_size / flashfs_config_settings.slot_size); i++) {
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ1_ID, 0, (i % 2) ? obj1 : obj1_alt, sizeof(obj1)));
+    rc = PIOS_FLASHFS_Maintain(fs_id);
+  }
+  EXPECT_EQ(1, rc);
+
+  /* Migrate the first few slots */
+  EXPECT_EQ(1, PIOS_FLASHFS_Maintain(fs_id));
+
+  /* Change objects that have and haven't been migrated yet while collecting */
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjDelete(fs_id, OBJ1_ID, 1));
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ1_ID, 2, obj1_alt, sizeof(obj1_alt)));
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjDelete(fs_id, OBJ1_ID, 8));
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ2_ID, 0, obj2, sizeof(obj2)));
+
+  /* Finish collecting */
+  for (uint32_t i = 0; rc == 1 && i < 100; i++) {
+    rc = PIOS_FLASHFS_Maintain(fs_id);
+  }
+  EXPECT_EQ(0, rc);
+
+  for (uint32_t pass = 0; pass < 2; pass++) {
+    unsigned char obj1_check[OBJ1_SIZE];
+
+    EXPECT_EQ(-3, PIOS_FLASHFS_ObjLoad(fs_id, OBJ1_ID, 1, obj1_check, sizeof(obj1_check)));
+    EXPECT_EQ(-3, PIOS_FLASHFS_ObjLoad(fs_id, OBJ1_ID, 8, obj1_check, sizeof(obj1_check)));
+
+    memset(obj1_check, 0, sizeof(obj1_check));
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, OBJ1_ID, 2, obj1_check, sizeof(obj1_check)));
+    EXPECT_EQ(0, memcmp(obj1_alt, obj1_check, sizeof(obj1_alt)));
+
+    for (uint16_t i = 3; i <= 7; i++) {
+      memset(obj1_check, 0, sizeof(obj1_check));
+      EXPECT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, OBJ1_ID, i, obj1_check, sizeof(obj1_check)));
+      EXPECT_EQ(0, memcmp(obj1, obj1_check, sizeof(obj1)));
+    }
+
+    unsigned char obj2_check[OBJ2_SIZE];
+    memset(obj2_check, 0, sizeof(obj2_check));
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, OBJ2_ID, 0, obj2_check, sizeof(obj2_check)));
+    EXPECT_EQ(0, memcmp(obj2, obj2_check, sizeof(obj2)));
+
+    /* Remount and check what made it to flash */
+    PIOS_FLASHFS_Logfs_Destroy(fs_id);
+    EXPECT_EQ(0, PIOS_FLASHFS_Logfs_Init(&fs_id, &flashfs_config_settings, FLASH_PARTITION_LABEL_SETTINGS));
+  }
+
+  /* The log has room again */
+  EXPECT_EQ(0, PIOS_FLASHFS_Maintain(fs_id));
+}
+
+TEST_F(LogfsTestCooked, WriteUnchangedManyTimes) {
+  /* Identical saves shouldn't use up the log */
+  for (uint32_t i = 0; i < 2 * (flashfs_config_settings.arena_size / flashfs_config_settings.slot_size); i++) {
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ1_ID, 0, obj1, sizeof(obj1)));
+    EXPECT_EQ(0, PIOS_FLASHFS_Maintain(fs_id));
+  }
+
+  /* A changed save still goes through */
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ1_ID, 0, obj1_alt, sizeof(obj1_alt)));
+
+  unsigned char obj1_check[OBJ1_SIZE];
+  memset(obj1_check, 0, sizeof(obj1_check));
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, OBJ1_ID, 0, obj1_check, sizeof(obj1_check)));
+  EXPECT_EQ(0, memcmp(obj1_alt, obj1_check, sizeof(obj1_alt)));
+}
+
+TEST_F(LogfsTestCooked, RecoverInterruptedWrite) {
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ1_ID, 0, obj1, sizeof(obj1)));
+
+  /* Leave data in the next free slot as if a save was cut short before its header got written */
+  uintptr_t partition_id;
+  EXPECT_EQ(0, PIOS_FLASH_find_partition_id(FLASH_PARTITION_LABEL_SETTINGS, &partition_id));
+  EXPECT_EQ(0, PIOS_FLASH_start_transaction(partition_id));
+  EXPECT_EQ(0, PIOS_FLASH_write_data(partition_id, 2 * flashfs_config_settings.slot_size + 12, obj2, sizeof(obj2)));
+  EXPECT_EQ(0, PIOS_FLASH_end_transaction(partition_id));
+
+  /* Remounting should skip over the dirty slot */
+  PIOS_FLASHFS_Logfs_Destroy(fs_id);
+  EXPECT_EQ(0, PIOS_FLASHFS_Logfs_Init(&fs_id, &flashfs_config_settings, FLASH_PARTITION_LABEL_SETTINGS));
+
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ3_ID, 0, obj3, sizeof(obj3)));
+
+  for (uint32_t pass = 0; pass < 2; pass++) {
+    unsigned char obj1_check[OBJ1_SIZE];
+    memset(obj1_check, 0, sizeof(obj1_check));
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, OBJ1_ID, 0, obj1_check, sizeof(obj1_check)));
+    EXPECT_EQ(0, memcmp(obj1, obj1_check, sizeof(obj1)));
+
+    unsigned char obj3_check[OBJ3_SIZE];
+    memset(obj3_check, 0, sizeof(obj3_check));
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, OBJ3_ID, 0, obj3_check, sizeof(obj3_check)));
+    EXPECT_EQ(0, memcmp(obj3, obj3_check, sizeof(obj3)));
+
+    PIOS_FLASHFS_Logfs_Destroy(fs_id);
+    EXPECT_EQ(0, PIOS_FLASHFS_Logfs_Init(&fs_id, &flashfs_config_settings, FLASH_PARTITION_LABEL_SETTINGS));
+  }
+}
+
 class LogfsTestCookedMultiPart : public LogfsTestRaw {
 protected:
   virtual void SetUp() {
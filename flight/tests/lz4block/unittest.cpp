@@ -0,0 +1,153 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     dRonin, http://dronin.org, Copyright (C) 2017
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>		/* printf */
+#include <stdlib.h>		/* abort */
+#include <string.h>		/* memset */
+#include <stdint.h>		/* uint*_t */
+
+extern "C" {
+#include "lz4block.h"		/* API for compression */
+}
+
+// To use a test fixture, derive a class from testing::Test.
+class LZ4Block : public testing::Test {
+protected:
+  virtual void SetUp() {
+    srand(42);
+  }
+
+  virtual void TearDown() {
+  }
+
+  /* Compresses and expands len bytes of src, and checks they come back */
+  int32_t roundTrip(const uint8_t *src, uint16_t len) {
+    uint8_t packed[1024];
+    uint8_t unpacked[1024];
+
+    int32_t packed_len = lz4block_compress(&state, src, len,
+        packed, sizeof(packed));
+
+    EXPECT_GT(packed_len, 0);
+
+    int32_t unpacked_len = lz4block_decompress(packed, packed_len,
+        unpacked, sizeof(unpacked));
+
+    EXPECT_EQ(len, unpacked_len);
+    EXPECT_EQ(0, memcmp(src, unpacked, len));
+
+    return packed_len;
+  }
+
+  struct lz4block_state state;
+};
+
+TEST_F(LZ4Block, ErasedFlash) {
+  uint8_t buf[100];
+
+  memset(buf, 0xff, sizeof(buf));
+
+  /* A run comes down to a literal, a match and the last few literals */
+  EXPECT_EQ(11, roundTrip(buf, sizeof(buf)));
+}
+
+TEST_F(LZ4Block, RandomDataDoesNotFit) {
+  uint8_t buf[100];
+  uint8_t packed[100];
+
+  for (unsigned int i = 0; i < sizeof(buf); i++) {
+    buf[i] = rand();
+  }
+
+  /* Anything that doesn't shrink is turned away when the space is tight */
+  EXPECT_EQ(0, lz4block_compress(&state, buf, sizeof(buf),
+        packed, sizeof(buf) - 1));
+
+  roundTrip(buf, sizeof(buf));
+}
+
+TEST_F(LZ4Block, RoundTripMixed) {
+  uint8_t buf[600];
+
+  for (int trial = 0; trial < 200; trial++) {
+    uint16_t len = rand() % sizeof(buf);
+
+    /* Records that repeat with small changes, like a log */
+    for (int i = 0; i < len; i++) {
+      buf[i] = (rand() % 4) ? (i % 23) : rand();
+    }
+
+    roundTrip(buf, len);
+  }
+}
+
+TEST_F(LZ4Block, ShortInputs) {
+  uint8_t buf[16];
+
+  memset(buf, 0x55, sizeof(buf));
+
+  for (int len = 0; len <= 16; len++) {
+    roundTrip(buf, len);
+  }
+}
+
+TEST_F(LZ4Block, DecodesReferenceBlock) {
+  /* One a and a match of 8 a's one byte back, then bcdef */
+  const uint8_t block[] = { 0x14, 'a', 0x01, 0x00, 0x50, 'b', 'c', 'd', 'e', 'f' };
+  const char expected[] = "aaaaaaaaabcdef";
+  uint8_t out[32];
+
+  ASSERT_EQ((int32_t) strlen(expected),
+      lz4block_decompress(block, sizeof(block), out, sizeof(out)));
+  EXPECT_EQ(0, memcmp(expected, out, strlen(expected)));
+}
+
+TEST_F(LZ4Block, RejectsMalformed) {
+  uint8_t out[32];
+
+  /* Match reaching back before the start */
+  const uint8_t bad_offset[] = { 0x14, 'a', 0x02, 0x00, 0x10, 'b' };
+  EXPECT_EQ(-1, lz4block_decompress(bad_offset, sizeof(bad_offset),
+        out, sizeof(out)));
+
+  /* Literals running off the end */
+  const uint8_t truncated[] = { 0x50, 'a', 'b' };
+  EXPECT_EQ(-1, lz4block_decompress(truncated, sizeof(truncated),
+        out, sizeof(out)));
+
+  /* More output than there is room for */
+  const uint8_t too_long[] = { 0x1f, 'a', 0x01, 0x00, 0x40, 0x50, 'b', 'c', 'd', 'e', 'f' };
+  EXPECT_EQ(-1, lz4block_decompress(too_long, sizeof(too_long),
+        out, sizeof(out)));
+}
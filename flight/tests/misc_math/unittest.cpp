@@ -356,6 +356,96 @@ TEST_F(LinearInterpolate, CollectiveCurve1to1) {
 };
 
 // Test fixture for matrix math
+// Test fixture for fast_invsqrtf()
+class FastInvSqrt : public MiscMath {
+protected:
+  virtual void SetUp() {
+  }
+
+  virtual void TearDown() {
+  }
+};
+
+TEST_F(FastInvSqrt, MatchesInvSqrt) {
+  float eps = 0.00001f;
+
+  // Sweep 8 decades, both in and well out of the unit range
+  for (float x = 1e-4f; x < 1e4f; x *= 1.05f) {
+    EXPECT_NEAR(1.0f, fast_invsqrtf(x) * sqrtf(x), eps);
+  }
+};
+
+// Test fixture for fast_atan2f() and friends
+class FastTrig : public MiscMath {
+protected:
+  virtual void SetUp() {
+  }
+
+  virtual void TearDown() {
+  }
+};
+
+TEST_F(FastTrig, Atan2MatchesAtan2) {
+  // Around the whole circle, at several radii
+  for (float a = -3.1f; a < 3.1f; a += 0.001f) {
+    for (float r = 0.001f; r < 1000.0f; r *= 10.0f) {
+      float y = r * sinf(a);
+      float x = r * cosf(a);
+
+      EXPECT_NEAR(atan2f(y, x), fast_atan2f(y, x), 2e-5f);
+      EXPECT_NEAR(atan2f(y, x), fast_atan2f_coarse(y, x), 4e-3f);
+    }
+  }
+
+  EXPECT_EQ(0.0f, fast_atan2f(0.0f, 0.0f));
+  EXPECT_NEAR(M_PI / 2, fast_atan2f(1.0f, 0.0f), 2e-5f);
+  EXPECT_NEAR(M_PI, fast_atan2f(0.0f, -1.0f), 2e-5f);
+};
+
+TEST_F(FastTrig, AsinMatchesAsin) {
+  for (float x = -1.0f; x <= 1.0f; x += 0.0001f) {
+    EXPECT_NEAR(asinf(x), fast_asinf(x), 2e-5f);
+  }
+
+  // Clipped, rather than NaN, just past the ends
+  EXPECT_NEAR(M_PI / 2, fast_asinf(1.00001f), 2e-5f);
+  EXPECT_NEAR(-M_PI / 2, fast_asinf(-1.00001f), 2e-5f);
+};
+
+// Test fixture for expo_table_build() and expo_table_eval()
+class ExpoTable : public MiscMath {
+protected:
+  virtual void SetUp() {
+  }
+
+  virtual void TearDown() {
+  }
+};
+
+TEST_F(ExpoTable, MatchesExpoM) {
+  struct expo_table table;
+
+  // The default rate settings, then the far corners of the settings
+  const int32_t g[] = { 35, 0, 100, 100 };
+  const float exponent[] = { 3.0f, 3.0f, 2.0f, 16.0f };
+
+  for (int i = 0; i < 4; i++) {
+    expo_table_build(&table, g[i], exponent[i]);
+
+    float eps = g[i] * 0.01f * exponent[i] * (exponent[i] - 1) /
+      (8 * EXPO_TABLE_SEGMENTS * EXPO_TABLE_SEGMENTS) + 2e-5f;
+
+    for (float x = -1.0f; x <= 1.0f; x += 0.0005f) {
+      EXPECT_NEAR(expoM(x, g[i], exponent[i]), expo_table_eval(&table, x), eps);
+    }
+
+    EXPECT_EQ(0.0f, expo_table_eval(&table, 0.0f));
+    EXPECT_EQ(1.0f, expo_table_eval(&table, 1.0f));
+    EXPECT_EQ(1.0f, expo_table_eval(&table, 1.5f));
+    EXPECT_EQ(-1.0f, expo_table_eval(&table, -1.5f));
+  }
+};
+
 class MatrixMath : public MiscMath {
 protected:
   virtual void SetUp() {
@@ -0,0 +1,15 @@
+#define PIOS_NO_HW
+#define FLIGHT_POSIX
+
+#define PIOS_INCLUDE_RTC
+#define PIOS_INCLUDE_RCVR
+#define PIOS_INCLUDE_DSM
+#define PIOS_INCLUDE_SBUS
+#define PIOS_INCLUDE_HSUM
+#define PIOS_INCLUDE_SRXL
+#define PIOS_INCLUDE_IBUS
+#define PIOS_INCLUDE_CROSSFIRE
+
+#define PIOS_DSM_NUM_INPUTS 12
+#define PIOS_SBUS_NUM_INPUTS (16+2)
+#define PIOS_HSUM_NUM_INPUTS 32
@@ -0,0 +1,405 @@
+/**
+ ******************************************************************************
+ * @file       rx_decoders.c
+ * @author     dRonin, http://dronin.org, Copyright (C) 2017
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Receiver decoders driven as their serial port would
+ *
+ * Each driver is bound to a fake serial port and has its RTC supervisor
+ * and PIOS_DELAY time run from a simulated clock, so that the same bytes
+ * always decode the same way however fast the host is.
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "rx_decoders.h"
+
+#include "pios_crc.h"
+#include "pios_dsm_priv.h"
+#include "pios_sbus_priv.h"
+#include "pios_hsum_priv.h"
+#include "pios_srxl.h"
+#include "pios_ibus.h"
+#include "pios_crossfire.h"
+
+uint32_t rx_frames_decoded;
+
+static struct rx_harness *opening;
+static uint32_t sim_time_us;
+
+/* Fake serial port: the lower id is the harness itself */
+static void rx_bind_rx_cb(uintptr_t id, pios_com_callback rx_in_cb, uintptr_t context)
+{
+	struct rx_harness *h = (struct rx_harness *)id;
+
+	h->rx_in_cb = rx_in_cb;
+	h->rx_in_context = context;
+}
+
+static const struct pios_com_driver rx_com_driver = {
+	.bind_rx_cb = rx_bind_rx_cb,
+};
+
+bool PIOS_RTC_RegisterTickCallback(void (*fn)(uintptr_t id), uintptr_t data)
+{
+	if (!opening || opening->tick_cb)
+		return false;
+
+	opening->tick_cb = fn;
+	opening->tick_context = data;
+
+	return true;
+}
+
+void PIOS_RCVR_ActiveFromISR()
+{
+	rx_frames_decoded++;
+}
+
+/* Crossfire opens a COM device for telemetry, which is never sent here */
+int32_t PIOS_COM_Init(uintptr_t *com_id, const struct pios_com_driver *driver,
+		uintptr_t lower_id, uint16_t rx_buffer_len, uint16_t tx_buffer_len)
+{
+	*com_id = 0;
+
+	return 0;
+}
+
+int32_t PIOS_COM_SendBuffer(uintptr_t com_id, const uint8_t *buffer, uint16_t len)
+{
+	return len;
+}
+
+/* PIOS_DELAY on the simulated clock, with raw counts in microseconds */
+uint32_t PIOS_DELAY_GetRaw()
+{
+	return sim_time_us;
+}
+
+uint32_t PIOS_DELAY_DiffuS(uint32_t raw)
+{
+	return sim_time_us - raw;
+}
+
+uint32_t PIOS_DELAY_GetuS()
+{
+	return sim_time_us;
+}
+
+int32_t PIOS_DELAY_WaituS(uint32_t uS)
+{
+	sim_time_us += uS;
+
+	return 0;
+}
+
+/**
+ * Start a decoder on a fake serial port
+ * @return 0 on success, the driver's error otherwise
+ */
+int32_t rx_harness_open(struct rx_harness *h, const struct rx_decoder *decoder)
+{
+	memset(h, 0, sizeof(*h));
+	h->decoder = decoder;
+
+	opening = h;
+	int32_t rc = decoder->init(&h->id, &rx_com_driver, (uintptr_t)h);
+	opening = NULL;
+
+	if (rc)
+		return rc;
+
+	if (!h->rx_in_cb || !h->tick_cb)
+		return -100;
+
+	return 0;
+}
+
+/**
+ * Hand bytes to the driver as the USART interrupt would, then let the
+ * time they took on the wire pass
+ * @return the number of bytes the driver consumed
+ */
+uint16_t rx_harness_feed(struct rx_harness *h, uint8_t *buf, uint16_t len)
+{
+	uint16_t headroom;
+	bool need_yield;
+
+	uint16_t consumed = (h->rx_in_cb)(h->rx_in_context, buf, len,
+			&headroom, &need_yield);
+
+	rx_harness_idle(h, len * h->decoder->byte_us);
+
+	return consumed;
+}
+
+/**
+ * Let time pass, running the supervisor on every RTC tick
+ */
+void rx_harness_idle(struct rx_harness *h, uint32_t us)
+{
+	h->idle_us += us;
+	sim_time_us += us;
+
+	while (h->idle_us >= RX_TICK_US) {
+		(h->tick_cb)(h->tick_context);
+		h->idle_us -= RX_TICK_US;
+	}
+}
+
+int32_t rx_harness_read(struct rx_harness *h, uint8_t channel)
+{
+	return h->decoder->rcvr_driver->read(h->id, channel);
+}
+
+/* CRC-16/CCITT as SRXL and SUMD use it, most significant bit first */
+static uint16_t rx_crc16_ccitt(const uint8_t *data, int len)
+{
+	uint16_t crc = 0;
+
+	for (int n = 0; n < len; n++) {
+		crc ^= (uint16_t)data[n] << 8;
+		for (int i = 0; i < 8; i++)
+			crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : (crc << 1);
+	}
+
+	return crc;
+}
+
+/* 16 channels of 11 bits, least significant bit first, as S.Bus and
+ * Crossfire carry them */
+static void rx_pack_11bit(uint8_t *buf, const uint16_t *channels)
+{
+	memset(buf, 0, 22);
+
+	for (int i = 0; i < 16; i++) {
+		uint32_t bit = i * 11;
+
+		for (int b = 0; b < 11; b++, bit++) {
+			if (channels[i] & (1 << b))
+				buf[bit / 8] |= 1 << (bit % 8);
+		}
+	}
+}
+
+static int32_t rx_dsm_init(uintptr_t *id, const struct pios_com_driver *driver,
+		uintptr_t lower_id)
+{
+	static const struct pios_dsm_cfg cfg;
+
+	return PIOS_DSM_Init(id, &cfg, driver, lower_id,
+			HWSHARED_DSMXMODE_AUTODETECT);
+}
+
+/* DSMX, 11 bit, 11ms; frames alternate between the two halves of the
+ * channels */
+static uint16_t rx_dsm_encode(uint8_t *buf, const uint16_t *channels)
+{
+	static bool second;
+
+	buf[0] = 0;	/* fades */
+	buf[1] = 0xb2;
+
+	for (int i = 0; i < DSM_CHANNELS_PER_FRAME; i++) {
+		int ch = i + (second ? DSM_CHANNELS_PER_FRAME : 0);
+		uint16_t word;
+
+		if (ch < PIOS_DSM_NUM_INPUTS)
+			word = (ch << 11) | (channels[ch] & 0x7ff);
+		else
+			word = 0xffff;
+
+		if (second && i == 0)
+			word |= DSM_2ND_FRAME_MASK;
+
+		buf[2 + i * 2] = word >> 8;
+		buf[3 + i * 2] = word & 0xff;
+	}
+
+	second = !second;
+
+	return DSM_FRAME_LENGTH;
+}
+
+static uint16_t rx_sbus_encode(uint8_t *buf, const uint16_t *channels)
+{
+	buf[0] = SBUS_SOF_BYTE;
+	rx_pack_11bit(&buf[1], channels);
+	buf[23] = 0;	/* flags */
+	buf[24] = SBUS_EOF_BYTE;
+
+	return SBUS_FRAME_LENGTH;
+}
+
+static int32_t rx_hsum_init(uintptr_t *id, const struct pios_com_driver *driver,
+		uintptr_t lower_id)
+{
+	return PIOS_HSUM_Init(id, driver, lower_id, PIOS_HSUM_PROTO_SUMD);
+}
+
+/* SUMD with 16 channels */
+static uint16_t rx_hsum_encode(uint8_t *buf, const uint16_t *channels)
+{
+	const int n = 16;
+
+	buf[0] = 0xA8;
+	buf[1] = 0x01;
+	buf[2] = n;
+
+	for (int i = 0; i < n; i++) {
+		buf[3 + i * 2] = channels[i] >> 8;
+		buf[4 + i * 2] = channels[i] & 0xff;
+	}
+
+	uint16_t crc = rx_crc16_ccitt(buf, 3 + n * 2);
+	buf[3 + n * 2] = crc >> 8;
+	buf[4 + n * 2] = crc & 0xff;
+
+	return 5 + n * 2;
+}
+
+/* Multiplex SRXL, 12 channels */
+static uint16_t rx_srxl_encode(uint8_t *buf, const uint16_t *channels)
+{
+	const int n = 12;
+
+	buf[0] = 0xA1;
+
+	for (int i = 0; i < n; i++) {
+		buf[1 + i * 2] = channels[i] >> 8;
+		buf[2 + i * 2] = channels[i] & 0xff;
+	}
+
+	uint16_t crc = rx_crc16_ccitt(buf, 1 + n * 2);
+	buf[1 + n * 2] = crc >> 8;
+	buf[2 + n * 2] = crc & 0xff;
+
+	return 3 + n * 2;
+}
+
+/* 14 channel IBus frame, of which the driver uses the first 10 */
+static uint16_t rx_ibus_encode(uint8_t *buf, const uint16_t *channels)
+{
+	uint16_t sum = 0xffff;
+
+	buf[0] = 0x20;
+	buf[1] = 0x40;
+
+	for (int i = 0; i < 14; i++) {
+		uint16_t value = (i < 10) ? channels[i] : 1500;
+
+		buf[2 + i * 2] = value & 0xff;
+		buf[3 + i * 2] = value >> 8;
+	}
+
+	for (int i = 0; i < 30; i++)
+		sum -= buf[i];
+
+	buf[30] = sum & 0xff;
+	buf[31] = sum >> 8;
+
+	return 32;
+}
+
+static uint16_t rx_crossfire_encode(uint8_t *buf, const uint16_t *channels)
+{
+	buf[0] = 0xC8;	/* to the flight controller */
+	buf[1] = CRSF_TYPE_LEN + CRSF_PAYLOAD_RCCHANNELS + CRSF_CRC_LEN;
+	buf[2] = CRSF_FRAME_RCCHANNELS;
+	rx_pack_11bit(&buf[3], channels);
+	buf[3 + CRSF_PAYLOAD_RCCHANNELS] = PIOS_CRC_updateCRC_TBS(0, &buf[2],
+			CRSF_TYPE_LEN + CRSF_PAYLOAD_RCCHANNELS);
+
+	return 4 + CRSF_PAYLOAD_RCCHANNELS;
+}
+
+const struct rx_decoder rx_decoders[] = {
+	{
+		.name            = "dsm",
+		.init            = rx_dsm_init,
+		.rcvr_driver     = &pios_dsm_rcvr_driver,
+		.encode          = rx_dsm_encode,
+		.num_channels    = PIOS_DSM_NUM_INPUTS,
+		.min_value       = 0,
+		.max_value       = 2047,
+		.frame_period_us = 11000,
+		.byte_us         = 87,	/* 115200 8N1 */
+	},
+	{
+		.name            = "sbus",
+		.init            = PIOS_SBus_Init,
+		.rcvr_driver     = &pios_sbus_rcvr_driver,
+		.encode          = rx_sbus_encode,
+		.num_channels    = 16,
+		.min_value       = 0,
+		.max_value       = 2047,
+		.frame_period_us = 7000,
+		.byte_us         = 120,	/* 100000 8E2 */
+	},
+	{
+		.name            = "hsum",
+		.init            = rx_hsum_init,
+		.rcvr_driver     = &pios_hsum_rcvr_driver,
+		.encode          = rx_hsum_encode,
+		.num_channels    = 16,
+		.min_value       = 0x1c20,
+		.max_value       = 0x41a0,
+		.frame_period_us = 22000,
+		.byte_us         = 87,	/* 115200 8N1 */
+	},
+	{
+		.name            = "srxl",
+		.init            = PIOS_SRXL_Init,
+		.rcvr_driver     = &pios_srxl_rcvr_driver,
+		.encode          = rx_srxl_encode,
+		.num_channels    = 12,
+		.min_value       = 0,
+		.max_value       = 4095,
+		.frame_period_us = 14000,
+		.byte_us         = 87,	/* 115200 8N1 */
+	},
+	{
+		.name            = "ibus",
+		.init            = PIOS_IBus_Init,
+		.rcvr_driver     = &pios_ibus_rcvr_driver,
+		.encode          = rx_ibus_encode,
+		.num_channels    = 10,
+		.min_value       = 1000,
+		.max_value       = 2000,
+		.frame_period_us = 7000,
+		.byte_us         = 87,	/* 115200 8N1 */
+	},
+	{
+		.name            = "crossfire",
+		.init            = PIOS_Crossfire_Init,
+		.rcvr_driver     = &pios_crossfire_rcvr_driver,
+		.encode          = rx_crossfire_encode,
+		.num_channels    = 16,
+		.min_value       = 172,
+		.max_value       = 1811,
+		.frame_period_us = 6667,
+		.byte_us         = 24,	/* 420000 8N1 */
+	},
+};
+
+const uint32_t rx_num_decoders = NELEMENTS(rx_decoders);
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,87 @@
+/**
+ ******************************************************************************
+ * @file       rx_decoders.h
+ * @author     dRonin, http://dronin.org, Copyright (C) 2017
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Receiver decoders driven as their serial port would
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+
+#ifndef RX_DECODERS_H
+#define RX_DECODERS_H
+
+#include "pios.h"
+#include "pios_com_priv.h"
+
+/* Longest frame of any of the protocols */
+#define RX_MAX_FRAME 64
+#define RX_MAX_CHANNELS 32
+
+/* The RTC tick the drivers' supervisors are run at */
+#define RX_TICK_US 1600
+
+struct rx_decoder {
+	const char *name;
+	int32_t (*init)(uintptr_t *id, const struct pios_com_driver *driver,
+			uintptr_t lower_id);
+	const struct pios_rcvr_driver *rcvr_driver;
+
+	/* Writes one frame carrying channels[0..num_channels) into buf,
+	 * returning its length */
+	uint16_t (*encode)(uint8_t *buf, const uint16_t *channels);
+	uint8_t num_channels;
+	uint16_t min_value;
+	uint16_t max_value;
+
+	/* Frame period of a common mode, and time per byte on the wire */
+	uint32_t frame_period_us;
+	uint16_t byte_us;
+};
+
+extern const struct rx_decoder rx_decoders[];
+extern const uint32_t rx_num_decoders;
+
+/* One decoder instance, with its serial port and RTC tick faked */
+struct rx_harness {
+	const struct rx_decoder *decoder;
+	uintptr_t id;
+
+	pios_com_callback rx_in_cb;
+	uintptr_t rx_in_context;
+
+	void (*tick_cb)(uintptr_t id);
+	uintptr_t tick_context;
+	uint32_t idle_us;
+};
+
+int32_t rx_harness_open(struct rx_harness *h, const struct rx_decoder *decoder);
+uint16_t rx_harness_feed(struct rx_harness *h, uint8_t *buf, uint16_t len);
+void rx_harness_idle(struct rx_harness *h, uint32_t us);
+int32_t rx_harness_read(struct rx_harness *h, uint8_t channel);
+
+/* Frames the drivers have reported through PIOS_RCVR_ActiveFromISR */
+extern uint32_t rx_frames_decoded;
+
+#endif /* RX_DECODERS_H */
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,389 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     dRonin, http://dronin.org, Copyright (C) 2017
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Benchmarks and fuzzing of the receiver protocol decoders
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>		/* printf */
+#include <stdlib.h>		/* getenv */
+#include <string.h>		/* strrchr */
+#include <stdint.h>		/* uint*_t */
+#include <chrono>
+#include <string>
+
+extern "C" {
+#include "rx_decoders.h"
+#include "pios_dsm_priv.h"	/* DSM_FRAME_LENGTH */
+}
+
+// Frames timed per decoder, and fuzz bytes unless RX_FUZZ_BYTES says
+// otherwise
+#define BENCH_FRAMES 2000
+#define FUZZ_BYTES (1024 * 1024)
+
+typedef std::chrono::steady_clock bench_clock;
+
+// Deterministic, so that a fuzz failure can be replayed
+static uint32_t rand_state;
+
+static uint32_t rand_next()
+{
+  rand_state ^= rand_state << 13;
+  rand_state ^= rand_state >> 17;
+  rand_state ^= rand_state << 5;
+  return rand_state;
+}
+
+class RxBenchmark : public testing::Test {
+protected:
+  virtual void SetUp() {
+    rand_state = 0x2545f491;
+    rx_frames_decoded = 0;
+
+    // What reading the clock itself costs, taken off every sample
+    clock_ns = 1e9;
+    for (int i = 0; i < 1000; i++) {
+      auto a = bench_clock::now();
+      auto b = bench_clock::now();
+      double ns = std::chrono::duration<double, std::nano>(b - a).count();
+      if (ns < clock_ns) {
+        clock_ns = ns;
+      }
+    }
+  }
+
+  void open(struct rx_harness *h, const struct rx_decoder *dec) {
+    ASSERT_EQ(0, rx_harness_open(h, dec));
+
+    // Start from a quiet line, as after power up
+    rx_harness_idle(h, 50000);
+    rx_frames_decoded = 0;
+  }
+
+  void make_channels(const struct rx_decoder *dec, uint32_t frame, uint16_t *channels) {
+    uint32_t span = dec->max_value - dec->min_value + 1;
+
+    for (int i = 0; i < dec->num_channels; i++) {
+      channels[i] = dec->min_value + (frame * 37 + i * 101) % span;
+    }
+  }
+
+  // Feeds one frame, byte by byte or all at once, with the gap to the next
+  uint16_t send_frame(struct rx_harness *h, const uint16_t *channels, bool bytewise) {
+    uint8_t frame[RX_MAX_FRAME];
+    uint16_t len = h->decoder->encode(frame, channels);
+
+    if (bytewise) {
+      for (int i = 0; i < len; i++) {
+        rx_harness_feed(h, &frame[i], 1);
+      }
+    } else {
+      rx_harness_feed(h, frame, len);
+    }
+
+    rx_harness_idle(h, h->decoder->frame_period_us - len * h->decoder->byte_us);
+
+    return len;
+  }
+
+  void expect_channels(struct rx_harness *h, const uint16_t *channels, uint32_t frame) {
+    const struct rx_decoder *dec = h->decoder;
+
+    for (int i = 0; i < dec->num_channels; i++) {
+      EXPECT_EQ(channels[i], rx_harness_read(h, i)) << dec->name << " frame " << frame << " channel " << i;
+    }
+  }
+
+  void report(const struct rx_decoder *dec, const char *what, double value, const char *unit) {
+    std::string name = std::string(dec->name) + "." + what;
+
+    printf("%-10s %-22s %12.1f %s\n", dec->name, what, value, unit);
+    RecordProperty(name.c_str(), (int) (value + 0.5));
+  }
+
+  double clock_ns;
+};
+
+// Every decoder gets back what was encoded, whether the port hands over
+// one byte at a time or whole frames from DMA
+TEST_F(RxBenchmark, Decode) {
+  for (uint32_t d = 0; d < rx_num_decoders; d++) {
+    const struct rx_decoder *dec = &rx_decoders[d];
+
+    for (int bytewise = 0; bytewise < 2; bytewise++) {
+      struct rx_harness h;
+      uint16_t channels[RX_MAX_CHANNELS];
+
+      open(&h, dec);
+
+      // Each set of values goes out twice, as DSM needs two frames for
+      // all of its channels
+      for (uint32_t f = 0; f < 100; f++) {
+        make_channels(dec, f, channels);
+        send_frame(&h, channels, bytewise);
+        send_frame(&h, channels, bytewise);
+        expect_channels(&h, channels, f);
+      }
+
+      EXPECT_EQ(200U, rx_frames_decoded) << dec->name << (bytewise ? " bytewise" : " framewise");
+    }
+  }
+}
+
+// What the receive interrupt costs: bytes decoded per second of CPU when
+// fed a byte at a time, and the dearest single byte, which is the one
+// that completes a frame.  Each byte position takes its cheapest time
+// over all frames, so that host scheduling noise doesn't show up as the
+// worst case.
+TEST_F(RxBenchmark, Throughput) {
+  for (uint32_t d = 0; d < rx_num_decoders; d++) {
+    const struct rx_decoder *dec = &rx_decoders[d];
+    struct rx_harness h;
+    uint16_t channels[RX_MAX_CHANNELS];
+    uint8_t frame[RX_MAX_FRAME];
+    double position_ns[RX_MAX_FRAME];
+    double total_ns = 0, frame_ns = 0;
+    uint32_t bytes = 0;
+
+    for (int i = 0; i < RX_MAX_FRAME; i++) {
+      position_ns[i] = 1e9;
+    }
+
+    open(&h, dec);
+
+    uint16_t len = 0;
+    for (uint32_t f = 0; f < BENCH_FRAMES; f++) {
+      make_channels(dec, f, channels);
+      len = dec->encode(frame, channels);
+
+      for (int i = 0; i < len; i++) {
+        auto start = bench_clock::now();
+        rx_harness_feed(&h, &frame[i], 1);
+        auto end = bench_clock::now();
+
+        double ns = std::chrono::duration<double, std::nano>(end - start).count() - clock_ns;
+        if (ns < 0) {
+          ns = 0;
+        }
+
+        total_ns += ns;
+        if (ns < position_ns[i]) {
+          position_ns[i] = ns;
+        }
+      }
+
+      bytes += len;
+      rx_harness_idle(&h, dec->frame_period_us - len * dec->byte_us);
+    }
+
+    EXPECT_EQ((uint32_t) BENCH_FRAMES, rx_frames_decoded) << dec->name;
+
+    double worst_ns = 0;
+    for (int i = 0; i < len; i++) {
+      if (position_ns[i] > worst_ns) {
+        worst_ns = position_ns[i];
+      }
+    }
+
+    // And whole frames at once, as with DMA reception
+    for (uint32_t f = 0; f < BENCH_FRAMES; f++) {
+      make_channels(dec, f, channels);
+      len = dec->encode(frame, channels);
+
+      auto start = bench_clock::now();
+      rx_harness_feed(&h, frame, len);
+      auto end = bench_clock::now();
+
+      frame_ns += std::chrono::duration<double, std::nano>(end - start).count() - clock_ns;
+      rx_harness_idle(&h, dec->frame_period_us - len * dec->byte_us);
+    }
+
+    report(dec, "bytes_per_s", bytes / (total_ns / 1e9), "B/s");
+    report(dec, "byte_ns", total_ns / bytes, "ns");
+    report(dec, "worst_byte_ns", worst_ns, "ns");
+    report(dec, "dma_frame_ns", frame_ns / BENCH_FRAMES, "ns");
+  }
+}
+
+// The flights captured for the DSM correctness tests, replayed with their
+// own timing
+TEST_F(RxBenchmark, DsmCaptures) {
+  static const char *captures[] = {
+    "../dsm/DX7_11msDSM2.txt",
+    "../dsm/DX7_22msDSMX.txt",
+    "../dsm/DX18_11msDSMX.txt",
+    "../dsm/DX18_22msDSM2_1024res.txt",
+  };
+
+  const struct rx_decoder *dec = &rx_decoders[0];
+  ASSERT_STREQ("dsm", dec->name);
+
+  for (uint32_t c = 0; c < NELEMENTS(captures); c++) {
+    FILE *fid = fopen(captures[c], "r");
+    ASSERT_TRUE(fid != NULL) << captures[c];
+
+    char *line = NULL;
+    size_t line_len = 0;
+
+    // Column headings
+    ASSERT_GT(getline(&line, &line_len, fid), 0);
+    free(line);
+
+    struct rx_harness h;
+    open(&h, dec);
+
+    double t, t_last = -1;
+    uint8_t val;
+    uint32_t bytes = 0;
+    double total_ns = 0;
+
+    while (fscanf(fid, "%lf,%hhx,,", &t, &val) == 2) {
+      if (t_last >= 0) {
+        int32_t gap_us = (t - t_last) * 1e6 - dec->byte_us;
+        if (gap_us > 0) {
+          rx_harness_idle(&h, gap_us);
+        }
+      }
+      t_last = t;
+
+      auto start = bench_clock::now();
+      rx_harness_feed(&h, &val, 1);
+      auto end = bench_clock::now();
+
+      total_ns += std::chrono::duration<double, std::nano>(end - start).count() - clock_ns;
+      bytes++;
+    }
+
+    fclose(fid);
+
+    // Every complete frame in the capture, bar the one it may start
+    // part way through
+    uint32_t frames = bytes / DSM_FRAME_LENGTH;
+    EXPECT_GE(rx_frames_decoded + 1, frames) << captures[c];
+
+    const char *name = strrchr(captures[c], '/') + 1;
+    printf("%-10s %-22s %12.1f B/s\n", dec->name, name, bytes / (total_ns / 1e9));
+    RecordProperty(name, (int) (bytes / (total_ns / 1e9)));
+  }
+}
+
+// Random bytes, corrupted and truncated frames, in random chunks and with
+// random gaps.  None of it may crash a decoder or make it read out of
+// bounds, and a decoder must come back to clean frames afterwards.
+TEST_F(RxBenchmark, Fuzz) {
+  uint32_t fuzz_bytes = FUZZ_BYTES;
+  const char *env = getenv("RX_FUZZ_BYTES");
+  if (env) {
+    fuzz_bytes = strtoul(env, NULL, 0);
+  }
+
+  for (uint32_t d = 0; d < rx_num_decoders; d++) {
+    const struct rx_decoder *dec = &rx_decoders[d];
+    struct rx_harness h;
+    uint16_t channels[RX_MAX_CHANNELS];
+    uint8_t chunk[RX_MAX_FRAME];
+    double total_ns = 0;
+    uint32_t bytes = 0;
+
+    open(&h, dec);
+
+    while (bytes < fuzz_bytes) {
+      uint16_t len;
+      uint32_t kind = rand_next() % 10;
+
+      if (kind < 4) {
+        // Line noise
+        len = 1 + rand_next() % RX_MAX_FRAME;
+        for (int i = 0; i < len; i++) {
+          chunk[i] = rand_next();
+        }
+      } else {
+        make_channels(dec, rand_next(), channels);
+        len = dec->encode(chunk, channels);
+
+        if (kind < 8) {
+          // A few bits flipped
+          for (uint32_t n = rand_next() % 4; n > 0; n--) {
+            chunk[rand_next() % len] ^= 1 << (rand_next() % 8);
+          }
+        } else if (kind < 9) {
+          // Cut short
+          len = 1 + rand_next() % len;
+        }
+      }
+
+      // Handed over in pieces of any size
+      for (uint16_t off = 0; off < len; ) {
+        uint16_t n = 1 + rand_next() % (len - off);
+
+        auto start = bench_clock::now();
+        EXPECT_EQ(n, rx_harness_feed(&h, &chunk[off], n)) << dec->name;
+        auto end = bench_clock::now();
+
+        total_ns += std::chrono::duration<double, std::nano>(end - start).count() - clock_ns;
+        off += n;
+      }
+      bytes += len;
+
+      if (rand_next() % 4 == 0) {
+        rx_harness_idle(&h, rand_next() % 30000);
+      }
+
+      // Whatever made it through the checks has to be readable
+      for (int i = 0; i < dec->num_channels; i++) {
+        rx_harness_read(&h, i);
+      }
+
+      // Channels past the end must be refused, not read out of bounds
+      EXPECT_LT(rx_harness_read(&h, RX_MAX_CHANNELS + 1), 0) << dec->name;
+    }
+
+    report(dec, "fuzz_bytes_per_s", bytes / (total_ns / 1e9), "B/s");
+
+    // And back to normal once the line is clean again
+    rx_harness_idle(&h, 50000);
+    rx_frames_decoded = 0;
+
+    for (uint32_t f = 0; f < 10; f++) {
+      make_channels(dec, f, channels);
+      send_frame(&h, channels, false);
+      send_frame(&h, channels, false);
+    }
+
+    expect_channels(&h, channels, 10);
+    EXPECT_GE(rx_frames_decoded, 18U) << dec->name;
+  }
+}
+
+/**
+ * @}
+ * @}
+ */
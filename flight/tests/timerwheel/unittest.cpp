@@ -0,0 +1,209 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     dRonin, http://dronin.org, Copyright (C) 2017
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>		/* printf */
+#include <stdlib.h>		/* abort */
+#include <string.h>		/* memset */
+#include <stdint.h>		/* uint*_t */
+
+extern "C" {
+#include "timerwheel.h"		/* API for the timer wheel */
+}
+
+#include <vector>
+
+// To use a test fixture, derive a class from testing::Test.
+class TimerWheel : public testing::Test {
+protected:
+  virtual void SetUp() {
+    srand(42);
+  }
+
+  virtual void TearDown() {
+  }
+
+  /* Moves the wheel on to now, returning how many timers expired and
+   * checking that each expired on time */
+  int expireAt(struct timer_wheel *wheel, uint32_t now) {
+    int n = 0;
+
+    for (struct timer_wheel_entry *e = timer_wheel_expire(wheel, now);
+        e; e = e->next) {
+      EXPECT_EQ(now, e->expires);
+      EXPECT_FALSE(timer_wheel_pending(e));
+      n++;
+    }
+
+    return n;
+  }
+};
+
+TEST_F(TimerWheel, ExpiresOnTheTick) {
+  const uint32_t delays[] = { 0, 1, 63, 64, 65, 127, 4095, 4096, 4097,
+    5000, 65535, 100000 };
+  const int num = sizeof(delays) / sizeof(delays[0]);
+
+  /* Start just short of the counter wrapping */
+  for (uint32_t start : { 0U, 1000U, 0xfffff000U, 0xffffffc1U }) {
+    struct timer_wheel wheel;
+    struct timer_wheel_entry entries[num];
+
+    timer_wheel_init(&wheel, start);
+
+    for (int i = 0; i < num; i++) {
+      timer_wheel_add(&wheel, &entries[i], start + delays[i]);
+      EXPECT_TRUE(timer_wheel_pending(&entries[i]));
+    }
+
+    int expired = 0;
+
+    for (uint32_t t = 0; t <= 100000; t++) {
+      struct timer_wheel_entry *e = timer_wheel_expire(&wheel, start + t);
+
+      for (; e; e = e->next) {
+        int i = e - entries;
+
+        ASSERT_GE(i, 0);
+        ASSERT_LT(i, num);
+        EXPECT_EQ(delays[i], t);
+        expired++;
+      }
+    }
+
+    EXPECT_EQ(num, expired);
+  }
+}
+
+TEST_F(TimerWheel, LateAndFarTimers) {
+  struct timer_wheel wheel;
+  struct timer_wheel_entry late, far;
+
+  timer_wheel_init(&wheel, 5000);
+
+  timer_wheel_add(&wheel, &late, 1000);
+  EXPECT_EQ(5000U, late.expires);
+
+  timer_wheel_add(&wheel, &far, 5000 + TIMER_WHEEL_MAX_DELAY + 1000);
+  EXPECT_EQ(5000U + TIMER_WHEEL_MAX_DELAY, far.expires);
+
+  EXPECT_EQ(1, expireAt(&wheel, 5000));
+  EXPECT_EQ(0, expireAt(&wheel, 5000 + TIMER_WHEEL_MAX_DELAY - 1));
+  EXPECT_EQ(1, expireAt(&wheel, 5000 + TIMER_WHEEL_MAX_DELAY));
+}
+
+TEST_F(TimerWheel, RemovedTimersDontExpire) {
+  struct timer_wheel wheel;
+  struct timer_wheel_entry entries[64];
+
+  timer_wheel_init(&wheel, 0);
+
+  for (int i = 0; i < 64; i++) {
+    timer_wheel_add(&wheel, &entries[i], 1 + (rand() % 10000));
+  }
+
+  /* Every other one, from wherever it is in its slot */
+  for (int i = 0; i < 64; i += 2) {
+    timer_wheel_remove(&wheel, &entries[i]);
+    EXPECT_FALSE(timer_wheel_pending(&entries[i]));
+
+    /* Removing again does nothing */
+    timer_wheel_remove(&wheel, &entries[i]);
+  }
+
+  int expired = 0;
+
+  for (struct timer_wheel_entry *e = timer_wheel_expire(&wheel, 10000);
+      e; e = e->next) {
+    EXPECT_EQ(1, (e - entries) % 2);
+    expired++;
+  }
+
+  EXPECT_EQ(32, expired);
+
+  /* And the wheel knows it's empty */
+  EXPECT_EQ(1000U, timer_wheel_next(&wheel, 1000));
+}
+
+TEST_F(TimerWheel, SleepingUntilNextMissesNothing) {
+  struct timer_wheel wheel;
+  const int num = 200;
+  struct timer_wheel_entry entries[num];
+  std::vector<uint32_t> periods(num);
+  std::vector<int> counts(num, 0);
+
+  const uint32_t start = 0xffff0000U;
+  const uint32_t duration = 200000;
+
+  timer_wheel_init(&wheel, start);
+
+  for (int i = 0; i < num; i++) {
+    periods[i] = 1 + (rand() % 20000);
+    timer_wheel_add(&wheel, &entries[i], start + (rand() % periods[i]));
+  }
+
+  uint32_t now = start;
+
+  while (now - start < duration) {
+    struct timer_wheel_entry *e = timer_wheel_expire(&wheel, now);
+
+    while (e) {
+      struct timer_wheel_entry *next = e->next;
+      int i = e - entries;
+
+      /* Only ever woken on time, never late */
+      EXPECT_EQ(now, e->expires);
+      counts[i]++;
+
+      timer_wheel_add(&wheel, e, e->expires + periods[i]);
+
+      e = next;
+    }
+
+    uint32_t sleep = timer_wheel_next(&wheel, 350);
+
+    ASSERT_GE(sleep, 1U);
+    ASSERT_LE(sleep, 350U);
+
+    now += sleep;
+  }
+
+  for (int i = 0; i < num; i++) {
+    EXPECT_NEAR(duration / periods[i], counts[i], 1) << "period " << periods[i];
+  }
+}
+
+/**
+ * @}
+ * @}
+ */
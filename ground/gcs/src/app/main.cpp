@@ -33,6 +33,7 @@
 #define COMMAND_LINE_TEST "test"
 #define COMMAND_LINE_MULTIPLE_OK "multiple-ok"
 #define COMMAND_LINE_PLUGIN_OPTION "plugin-option"
+#define COMMAND_LINE_STARTUP_TIMING "startup-timing"
 
 #include "utils/hostosinfo.h"
 #include "utils/xmlconfig.h"
@@ -268,6 +269,10 @@ int main(int argc, char **argv)
         QStringList() << "m" << COMMAND_LINE_MULTIPLE_OK,
         QCoreApplication::translate("main", "Allows multiple instances to run at once"));
     parser.addOption(multipleInstancesOption);
+    QCommandLineOption startupTimingOption(
+        QStringList() << COMMAND_LINE_STARTUP_TIMING,
+        QCoreApplication::translate("main", "Logs how long each plugin took to load."));
+    parser.addOption(startupTimingOption);
 
     // The options are passed to the plugin init as a QStringList i.e. >> iplugin::initialize(const
     // QStringList &arguments, QString *errorString)
@@ -441,6 +446,7 @@ int main(int argc, char **argv)
     QObject::connect(&pluginManager, &ExtensionSystem::PluginManager::showSplash, &splash,
                      &CustomSplash::show);
 
+    pluginManager.setStartupTimingReport(parser.isSet(startupTimingOption));
     pluginManager.loadPlugins();
     {
         QStringList errors, plugins;
@@ -36,6 +36,7 @@
 
 #include <QtCore/QMetaProperty>
 #include <QtCore/QDir>
+#include <QtCore/QElapsedTimer>
 #include <QtCore/QTextStream>
 #include <QtCore/QWriteLocker>
 #include <QtDebug>
@@ -248,6 +249,16 @@ void PluginManager::loadPlugins()
     return d->loadPlugins();
 }
 
+/*!
+    \fn void PluginManager::setStartupTimingReport(bool enabled)
+    When \a enabled, loadPlugins() logs how long each plugin took to load,
+    to initialize and to initialize its extensions, slowest first.
+*/
+void PluginManager::setStartupTimingReport(bool enabled)
+{
+    d->startupTimingReport = enabled;
+}
+
 /*!
     \fn QStringList PluginManager::pluginPaths() const
     The list of paths were the plugin manager searches for plugins.
@@ -468,7 +479,7 @@ PluginSpecPrivate *PluginManagerPrivate::privateSpec(PluginSpec *spec)
     \internal
 */
 PluginManagerPrivate::PluginManagerPrivate(PluginManager *pluginManager)
-    : extension("xml"), q(pluginManager)
+    : extension("xml"), startupTimingReport(false), q(pluginManager)
 {
 }
 
@@ -553,10 +564,18 @@ void PluginManagerPrivate::removeObject(QObject *obj)
 */
 void PluginManagerPrivate::loadPlugins()
 {
+    QHash<PluginSpec *, StartupTime> times;
+    QElapsedTimer totalTimer;
+    QElapsedTimer timer;
+
+    totalTimer.start();
+
     QList<PluginSpec *> queue = loadQueue();
     foreach (PluginSpec *spec, queue) {
         emit q->splashMessages(QString(QObject::tr("Loading %1 plugin")).arg(spec->name()));
+        timer.start();
         loadPlugin(spec, PluginSpec::Loaded);
+        times[spec].load = timer.nsecsElapsed();
         if(spec->name() == "Core") {
             QObject::connect(spec->plugin(),SIGNAL(splashMessages(QString)), q, SIGNAL(splashMessages(QString)));
             QObject::connect(spec->plugin(),SIGNAL(showSplash()), q, SIGNAL(showSplash()));
@@ -566,18 +585,56 @@ void PluginManagerPrivate::loadPlugins()
 
     foreach (PluginSpec *spec, queue) {
         emit q->splashMessages(QString(QObject::tr("Initializing %1 plugin")).arg(spec->name()));
+        timer.start();
         loadPlugin(spec, PluginSpec::Initialized);
+        times[spec].initialize = timer.nsecsElapsed();
     }
     QListIterator<PluginSpec *> it(queue);
     it.toBack();
     while (it.hasPrevious()) {
-        loadPlugin(it.previous(), PluginSpec::Running);
+        PluginSpec *spec = it.previous();
+        timer.start();
+        loadPlugin(spec, PluginSpec::Running);
+        times[spec].extensions = timer.nsecsElapsed();
     }
+    if (startupTimingReport)
+        reportStartupTimes(times, totalTimer.nsecsElapsed());
     emit q->pluginsChanged();
     q->m_allPluginsLoaded=true;
     emit q->pluginsLoadEnded();
 }
 
+/*!
+    \fn void PluginManagerPrivate::reportStartupTimes(const QHash<PluginSpec *, StartupTime> &times, qint64 total) const
+    \internal
+*/
+void PluginManagerPrivate::reportStartupTimes(const QHash<PluginSpec *, StartupTime> &times,
+                                              qint64 total) const
+{
+    QList<PluginSpec *> specs = times.keys();
+
+    auto sum = [&times](PluginSpec *spec) {
+        const StartupTime &t = times.value(spec);
+        return t.load + t.initialize + t.extensions;
+    };
+
+    std::sort(specs.begin(), specs.end(),
+              [&sum](PluginSpec *a, PluginSpec *b) { return sum(a) > sum(b); });
+
+    qInfo() << "[PluginManager] plugins loaded in" << total / 1000000 << "ms";
+    qInfo() << "[PluginManager]     total     load     init     exts  plugin";
+
+    foreach (PluginSpec *spec, specs) {
+        const StartupTime &t = times.value(spec);
+        qInfo().noquote() << QString("[PluginManager] %1 %2 %3 %4  %5")
+                                 .arg(sum(spec) / 1000000.0, 9, 'f', 1)
+                                 .arg(t.load / 1000000.0, 8, 'f', 1)
+                                 .arg(t.initialize / 1000000.0, 8, 'f', 1)
+                                 .arg(t.extensions / 1000000.0, 8, 'f', 1)
+                                 .arg(spec->name());
+    }
+}
+
 /*!
     \fn void PluginManagerPrivate::loadQueue()
     \internal
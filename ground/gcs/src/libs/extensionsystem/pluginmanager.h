@@ -97,6 +97,7 @@ public:
     QList<PluginSpec *> plugins() const;
     void setFileExtension(const QString &extension);
     QString fileExtension() const;
+    void setStartupTimingReport(bool enabled);
 
     // command line arguments
     QStringList arguments() const;
@@ -30,6 +30,7 @@
 
 #include "pluginspec.h"
 
+#include <QtCore/QHash>
 #include <QtCore/QList>
 #include <QtCore/QSet>
 #include <QtCore/QStringList>
@@ -68,6 +69,15 @@ public:
 
     QStringList arguments;
 
+    //! Time spent on each plugin at each stage of loading, in ns
+    struct StartupTime
+    {
+        qint64 load = 0;
+        qint64 initialize = 0;
+        qint64 extensions = 0;
+    };
+    bool startupTimingReport;
+
     // Look in argument descriptions of the specs for the option.
     PluginSpec *pluginForOption(const QString &option, bool *requiresArgument) const;
     PluginSpec *pluginByName(const QString &name) const;
@@ -83,6 +93,7 @@ private:
             QList<PluginSpec *> &queue,
             QList<PluginSpec *> &circularityCheckQueue);
     void stopAll();
+    void reportStartupTimes(const QHash<PluginSpec *, StartupTime> &times, qint64 total) const;
 };
 
 } // namespace Internal
@@ -116,6 +116,10 @@ $(INITFIELDS)
 	    return ($(NAME))(objMngr.getObject($(NAME).OBJID, instID));
 	}
 
+	/**
+	 * Typed access to the fields by index, without boxing.
+	 */
+$(FIELDACCESSORS)
 	// Constants
 	protected static final long OBJID = $(OBJIDHEX)l;
 	protected static final String NAME = "$(NAME)";
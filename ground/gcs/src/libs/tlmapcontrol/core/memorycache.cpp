@@ -30,7 +30,7 @@
 namespace core {
     MemoryCache::MemoryCache()
     {
-
+        setDecodedCacheCapacity(64);
     }
 
 
@@ -56,5 +56,34 @@ namespace core {
 
         kiberCacheLock.unlock();
     }
+    /* Returns the tile decoded from pic, decoding it only if it isn't
+     * already cached; the loader threads call this as tiles arrive, so
+     * painting normally finds them ready.
+     */
+    QImage MemoryCache::GetDecodedTile(const RawTile &tile, const QByteArray &pic)
+    {
+        decodedLock.lock();
+        QImage *cached=decodedTiles.object(tile);
+        if(cached)
+        {
+            QImage ret=*cached;
+            decodedLock.unlock();
+            return ret;
+        }
+        decodedLock.unlock();
+        QImage img=QImage::fromData(pic).convertToFormat(QImage::Format_ARGB32_Premultiplied);
+        if(img.isNull())
+            return img;
+        decodedLock.lock();
+        decodedTiles.insert(tile,new QImage(img),img.byteCount()/1024);
+        decodedLock.unlock();
+        return img;
+    }
+    void MemoryCache::setDecodedCacheCapacity(int megabytes)
+    {
+        decodedLock.lock();
+        decodedTiles.setMaxCost(megabytes*1024);
+        decodedLock.unlock();
+    }
 
 }
@@ -28,6 +28,8 @@
 #define MEMORYCACHE_H
 
 #include "rawtile.h"
+#include <QCache>
+#include <QImage>
 #include <QMutex>
 #include <QReadWriteLock>
 #include <QQueue>
@@ -43,7 +45,14 @@ namespace core {
         KiberTileCache TilesInMemory;
         QByteArray GetTileFromMemoryCache(const RawTile &tile);
         void AddTileToMemoryCache(const RawTile &tile, const QByteArray &pic);
+        QImage GetDecodedTile(const RawTile &tile, const QByteArray &pic);
+        void setDecodedCacheCapacity(int megabytes);
         QReadWriteLock kiberCacheLock;
+    private:
+        // Tiles decoded ready to draw, dropped least recently used first.
+        // Costs are in KiB.
+        QCache<RawTile,QImage> decodedTiles;
+        QMutex decodedLock;
     };
 
 
@@ -36,6 +36,67 @@ namespace core {
 
     }
 
+    PureImageCache::Connection::~Connection()
+    {
+        if(pending)
+            db.commit();
+        insertTile.clear();
+        insertData.clear();
+        selectTile.clear();
+        db.close();
+        db=QSqlDatabase();
+        QSqlDatabase::removeDatabase(name);
+    }
+
+    /* Returns this thread's connection to the current cache file, opening
+     * it on first use or when the cache has moved.  Call with lock held.
+     */
+    PureImageCache::Connection *PureImageCache::connection()
+    {
+        QString file=gtilecache+"Data.qmdb";
+        Connection *conn=connections.localData();
+        if(conn && conn->file==file)
+            return conn;
+        Mcounter.lock();
+        qlonglong id=++ConnCounter;
+        Mcounter.unlock();
+        conn=new Connection;
+        conn->name=QString("tlmapcache%1").arg(id);
+        conn->file=file;
+        conn->pending=0;
+        conn->db=QSqlDatabase::addDatabase("QSQLITE",conn->name);
+        conn->db.setDatabaseName(file);
+        conn->db.setConnectOptions("QSQLITE_BUSY_TIMEOUT=2000");
+        if(!conn->db.open())
+        {
+#ifdef DEBUG_PUREIMAGECACHE
+            qDebug()<<"Unable to open cache database:"<<conn->db.lastError().driverText();
+#endif //DEBUG_PUREIMAGECACHE
+            delete conn;
+            connections.setLocalData(0);
+            return 0;
+        }
+        {
+            // WAL lets the loader threads read while the cache queue
+            // writes; the index turns tile lookups into a seek, and is
+            // added here too so caches from before it get one
+            QSqlQuery query(conn->db);
+            query.exec("PRAGMA journal_mode=WAL");
+            query.exec("PRAGMA synchronous=NORMAL");
+            query.exec("CREATE INDEX IF NOT EXISTS IndexOfTiles ON Tiles (Type, Zoom, X, Y)");
+        }
+        conn->insertTile=QSqlQuery(conn->db);
+        conn->insertTile.prepare("INSERT INTO Tiles(X, Y, Zoom, Type, Date) VALUES(?, ?, ?, ?, ?)");
+        conn->insertData=QSqlQuery(conn->db);
+        conn->insertData.prepare("INSERT INTO TilesData(id, Tile) VALUES(?, ?)");
+        conn->selectTile=QSqlQuery(conn->db);
+        conn->selectTile.setForwardOnly(true);
+        conn->selectTile.prepare("SELECT Tile FROM TilesData WHERE id = (SELECT id FROM Tiles WHERE X=? AND Y=? AND Zoom=? AND Type=?)");
+        // Drops (and so closes) any connection to a previous cache file
+        connections.setLocalData(conn);
+        return conn;
+    }
+
     void PureImageCache::setGtileCache(const QString &value)
     {
         lock.lockForWrite();
@@ -58,7 +119,74 @@ namespace core {
                 CreateEmptyDB(db);
             }
         }
+        {
+            QDir packs(gtilecache+"TilePacks");
+            foreach(QString f,packs.entryList(QStringList("*.tlpack"),QDir::Files))
+                loadTilePack(packs.filePath(f));
+        }
+        lock.unlock();
+    }
+    /* Call with lock held for writing */
+    bool PureImageCache::loadTilePack(const QString &file)
+    {
+        QString path=QFileInfo(file).absoluteFilePath();
+        foreach(TilePack *pack,tilePacks)
+        {
+            if(pack->FileName()==path)
+                return true;
+        }
+        TilePack *pack=new TilePack;
+        if(!pack->Open(path))
+        {
+#ifdef DEBUG_PUREIMAGECACHE
+            qDebug()<<"Not a usable tile pack:"<<path;
+#endif //DEBUG_PUREIMAGECACHE
+            delete pack;
+            return false;
+        }
+        tilePacks.append(pack);
+        return true;
+    }
+    QByteArray PureImageCache::GetImageFromTilePacks(MapType::Types type, Point pos, int zoom)
+    {
+        QByteArray ar;
+        lock.lockForRead();
+        foreach(TilePack *pack,tilePacks)
+        {
+            ar=pack->GetTile(type,pos,zoom);
+            if(!ar.isEmpty())
+                break;
+        }
+        lock.unlock();
+        return ar;
+    }
+    /* Writes everything in the cache database to a tile pack */
+    bool PureImageCache::ExportTilePack(const QString &file)
+    {
+        if(gtilecache.isEmpty()|gtilecache.isNull())
+            return false;
+        lock.lockForRead();
+        bool ret=TilePack::ExportFromDB(gtilecache+"Data.qmdb",file);
+        lock.unlock();
+        return ret;
+    }
+    /* Copies a tile pack into the cache directory, where it is found again
+     * on later runs, and starts serving tiles from it.
+     */
+    bool PureImageCache::ImportTilePack(const QString &file)
+    {
+        if(gtilecache.isEmpty()|gtilecache.isNull())
+            return false;
+        lock.lockForWrite();
+        QDir d;
+        QString dir=gtilecache+"TilePacks";
+        d.mkpath(dir);
+        QString dest=dir+QDir::separator()+QFileInfo(file).completeBaseName()+".tlpack";
+        bool ret=QFileInfo(dest).exists() || QFile::copy(file,dest);
+        if(ret)
+            ret=loadTilePack(dest);
         lock.unlock();
+        return ret;
     }
     QString PureImageCache::GtileCache()
     {
@@ -118,6 +246,15 @@ namespace core {
             {
 #ifdef DEBUG_PUREIMAGECACHE
                 qDebug()<<"CreateEmptyDB: "<<query.lastError().driverText();
+#endif //DEBUG_PUREIMAGECACHE
+                db.close();
+                return false;
+            }
+            query.exec("CREATE INDEX IF NOT EXISTS IndexOfTiles ON Tiles (Type, Zoom, X, Y)");
+            if(query.numRowsAffected()==-1)
+            {
+#ifdef DEBUG_PUREIMAGECACHE
+                qDebug()<<"CreateEmptyDB: "<<query.lastError().driverText();
 #endif //DEBUG_PUREIMAGECACHE
                 db.close();
                 return false;
@@ -171,6 +308,10 @@ namespace core {
         QSqlDatabase::removeDatabase(QLatin1String("CreateConn"));
         return true;
     }
+    /* Inserts go into a transaction that stays open until
+     * MaxPendingTiles have been added or FlushPendingTiles() is called, so
+     * a burst of tiles costs one commit rather than one each.
+     */
     bool PureImageCache::PutImageToCache(const QByteArray &tile, const MapType::Types &type,const Point &pos,const int &zoom)
     {
         if(gtilecache.isEmpty()|gtilecache.isNull())
@@ -179,80 +320,69 @@ namespace core {
 #ifdef DEBUG_PUREIMAGECACHE
         qDebug()<<"PutImageToCache Start:";//<<pos;
 #endif //DEBUG_PUREIMAGECACHE
-        Mcounter.lock();
-        qlonglong id=++ConnCounter;
-        Mcounter.unlock();
+        bool ret=false;
+        Connection *conn=connection();
+        if(conn)
         {
-            QSqlDatabase cn;
-            cn = QSqlDatabase::addDatabase("QSQLITE",QString::number(id));
-            QString db=gtilecache+"Data.qmdb";
-            cn.setDatabaseName(db);
-            cn.setConnectOptions("QSQLITE_ENABLE_SHARED_CACHE");
-            if(cn.open())
+            if(!conn->pending)
+                conn->db.transaction();
+            conn->insertTile.bindValue(0,pos.X());
+            conn->insertTile.bindValue(1,pos.Y());
+            conn->insertTile.bindValue(2,zoom);
+            conn->insertTile.bindValue(3,(int)type);
+            conn->insertTile.bindValue(4,QDateTime::currentDateTime().toString());
+            if(conn->insertTile.exec())
             {
-                {
-                    QSqlQuery query(cn);
-                    query.prepare("INSERT INTO Tiles(X, Y, Zoom, Type,Date) VALUES(?, ?, ?, ?,?)");
-                    query.addBindValue(pos.X());
-                    query.addBindValue(pos.Y());
-                    query.addBindValue(zoom);
-
-                    query.addBindValue((int)type);
-                    query.addBindValue(QDateTime::currentDateTime().toString());
-                    query.exec();
-                }
-                {
-                    QSqlQuery query(cn);
-                    query.prepare("INSERT INTO TilesData(id, Tile) VALUES((SELECT last_insert_rowid()), ?)");
-                    query.addBindValue(tile);
-                    query.exec();
-                }
-                cn.close();
+                conn->insertData.bindValue(0,conn->insertTile.lastInsertId());
+                conn->insertData.bindValue(1,tile);
+                ret=conn->insertData.exec();
+            }
+            if(++conn->pending>=MaxPendingTiles)
+            {
+                conn->db.commit();
+                conn->pending=0;
             }
         }
-        QSqlDatabase::removeDatabase(QString::number(id));
         lock.unlock();
-        return true;
+        return ret;
+    }
+    /* Commits the tiles this thread has put since the last commit */
+    void PureImageCache::FlushPendingTiles()
+    {
+        lock.lockForRead();
+        Connection *conn=connections.localData();
+        if(conn && conn->pending)
+        {
+            conn->db.commit();
+            conn->pending=0;
+        }
+        lock.unlock();
     }
     QByteArray PureImageCache::GetImageFromCache(MapType::Types type, Point pos, int zoom)
     {
         lock.lockForRead();
         QByteArray ar;
         if(gtilecache.isEmpty()|gtilecache.isNull())
+        {
+            lock.unlock();
             return ar;
-        QString dir=gtilecache;
-        Mcounter.lock();
-        qlonglong id=++ConnCounter;
-        Mcounter.unlock();
+        }
 #ifdef DEBUG_PUREIMAGECACHE
-        qDebug()<<"Cache dir="<<dir<<" Try to GET:"<<pos.X()+","+pos.Y();
+        qDebug()<<"Cache dir="<<gtilecache<<" Try to GET:"<<pos.X()+","+pos.Y();
 #endif //DEBUG_PUREIMAGECACHE
-
+        Connection *conn=connection();
+        if(conn)
         {
-            QString db=dir+"Data.qmdb";
+            conn->selectTile.bindValue(0,pos.X());
+            conn->selectTile.bindValue(1,pos.Y());
+            conn->selectTile.bindValue(2,zoom);
+            conn->selectTile.bindValue(3,(int)type);
+            if(conn->selectTile.exec() && conn->selectTile.next())
             {
-                QSqlDatabase cn;
-
-                cn = QSqlDatabase::addDatabase("QSQLITE",QString::number(id));
-
-                cn.setDatabaseName(db);
-                cn.setConnectOptions("QSQLITE_ENABLE_SHARED_CACHE");
-                if(cn.open())
-                {
-                    {
-                        QSqlQuery query(cn);
-                        query.exec(QString("SELECT Tile FROM TilesData WHERE id = (SELECT id FROM Tiles WHERE X=%1 AND Y=%2 AND Zoom=%3 AND Type=%4)").arg(pos.X()).arg(pos.Y()).arg(zoom).arg((int) type));
-                        query.next();
-                        if(query.isValid())
-                        {
-                            ar=query.value(0).toByteArray();
-                        }
-                    }
-                    cn.close();
-                }
+                ar=conn->selectTile.value(0).toByteArray();
             }
+            conn->selectTile.finish();
         }
-        QSqlDatabase::removeDatabase(QString::number(id));
         lock.unlock();
         return ar;
     }
@@ -261,41 +391,29 @@ namespace core {
         if(gtilecache.isEmpty()|gtilecache.isNull())
             return;
         QList<long> add;
-        bool ret=true;
-        QString dir=gtilecache;
+        lock.lockForRead();
+        Connection *conn=connection();
+        if(conn)
         {
-            QString db=dir+"Data.qmdb";
-            ret=QFileInfo(db).exists();
-            if(ret)
+            QSqlQuery query(conn->db);
+            query.exec(QString("SELECT id, X, Y, Zoom, Type, Date FROM Tiles"));
+            while(query.next())
             {
-                QSqlDatabase cn;
-                Mcounter.lock();
-                qlonglong id=++ConnCounter;
-                Mcounter.unlock();
-                cn = QSqlDatabase::addDatabase("QSQLITE",QString::number(id));
-                cn.setDatabaseName(db);
-                cn.setConnectOptions("QSQLITE_ENABLE_SHARED_CACHE");
-                if(cn.open())
-                {
-                    {
-                        QSqlQuery query(cn);
-                        query.exec(QString("SELECT id, X, Y, Zoom, Type, Date FROM Tiles"));
-                        while(query.next())
-                        {
-                            if(QDateTime::fromString(query.value(5).toString()).daysTo(QDateTime::currentDateTime())>days)
-                                add.append(query.value(0).toLongLong());
-                        }
-                        foreach(long i,add)
-                        {
-                            query.exec(QString("DELETE FROM Tiles WHERE id = %1;").arg(i));
-                        }
-                    }
-
-                    cn.close();
-                }
-                QSqlDatabase::removeDatabase(QString::number(id));
+                if(QDateTime::fromString(query.value(5).toString()).daysTo(QDateTime::currentDateTime())>days)
+                    add.append(query.value(0).toLongLong());
             }
+            if(!conn->pending)
+                conn->db.transaction();
+            query.prepare("DELETE FROM Tiles WHERE id = ?");
+            foreach(long i,add)
+            {
+                query.bindValue(0,(qlonglong)i);
+                query.exec();
+            }
+            conn->db.commit();
+            conn->pending=0;
         }
+        lock.unlock();
     }
     // PureImageCache::ExportMapDataToDB("C:/Users/Xapo/Documents/mapcontrol/debug/mapscache/data.qmdb","C:/Users/Xapo/Documents/mapcontrol/debug/mapscache/data2.qmdb");
     bool PureImageCache::ExportMapDataToDB(QString sourceFile, QString destFile)
@@ -39,9 +39,11 @@
 #include "point.h"
 #include <QVariant>
 #include "pureimage.h"
+#include "tilepack.h"
 #include <QList>
 #include <QMutex>
 #include <QReadWriteLock>
+#include <QThreadStorage>
 namespace core {
     class PureImageCache
     {
@@ -51,14 +53,41 @@ namespace core {
         static bool CreateEmptyDB(const QString &file);
         bool PutImageToCache(const QByteArray &tile,const MapType::Types &type,const core::Point &pos, const int &zoom);
         QByteArray GetImageFromCache(MapType::Types type, core::Point pos, int zoom);
+        void FlushPendingTiles();
+        QByteArray GetImageFromTilePacks(MapType::Types type, core::Point pos, int zoom);
+        bool ExportTilePack(const QString &file);
+        bool ImportTilePack(const QString &file);
         QString GtileCache();
         void setGtileCache(const QString &value);
         static bool ExportMapDataToDB(QString sourceFile, QString destFile);
         void deleteOlderTiles(int const& days);
     private:
+        // Each thread that touches the cache keeps its own open connection,
+        // with the tile statements prepared once
+        struct Connection
+        {
+            ~Connection();
+            QString name;
+            QString file;
+            QSqlDatabase db;
+            QSqlQuery insertTile;
+            QSqlQuery insertData;
+            QSqlQuery selectTile;
+            int pending; // inserts in the open transaction
+        };
+        // Inserts committed together; puts are cheap, commits are not
+        static const int MaxPendingTiles=64;
+        Connection *connection();
+        bool loadTilePack(const QString &file);
+
+        // Packs stay mapped for the life of the program, since tiles
+        // handed out from them point into the mapping
+        QList<TilePack *> tilePacks;
+
         QString gtilecache;
         QMutex Mcounter;
         QReadWriteLock lock;
+        QThreadStorage<Connection *> connections;
         static qlonglong ConnCounter;
 
     };
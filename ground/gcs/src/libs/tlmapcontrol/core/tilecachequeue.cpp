@@ -92,12 +92,13 @@ void TileCacheQueue::run()
             qDebug()<<"Cache engine Put:"<<task->GetPosition().X()<<","<<task->GetPosition().Y();
 #endif //DEBUG_TILECACHEQUEUE
             Cache::Instance()->ImageCache.PutImageToCache(task->GetImg(),task->GetMapType(),task->GetPosition(),task->GetZoom());
-            usleep(44);
             delete task;
         }
 
         else
         {
+            // Caught up; commit what has been put before going idle
+            Cache::Instance()->ImageCache.FlushPendingTiles();
 #ifdef DEBUG_TILECACHEQUEUE
             qDebug()<<"Cache engine BEGIN WAIT";
 #endif //DEBUG_TILECACHEQUEUE
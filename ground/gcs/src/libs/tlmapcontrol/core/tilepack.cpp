@@ -0,0 +1,200 @@
+/**
+******************************************************************************
+*
+* @file       tilepack.cpp
+* @author     dRonin, http://dRonin.org/, Copyright (C) 2017
+* @brief      Read only, memory mapped archives of map tiles
+* @see        The GNU Public License (GPL) Version 3
+* @defgroup   TLMapWidget
+* @{
+*
+*****************************************************************************/
+/*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+*
+* You should have received a copy of the GNU General Public License along
+* with this program; if not, see <http://www.gnu.org/licenses/>
+*/
+#include "tilepack.h"
+#include <QtEndian>
+#include <QVector>
+#include <QVariant>
+#include <QtSql/QSqlDatabase>
+#include <QtSql/QSqlQuery>
+#include <algorithm>
+
+namespace core {
+    static const char TilePackMagic[8]={'T','L','T','P','A','C','K','1'};
+    static const quint32 TilePackVersion=1;
+    static const qint64 TilePackHeaderSize=16;
+    Q_STATIC_ASSERT(sizeof(TilePack::Entry)==32);
+
+    // Index entries are kept little endian in the file
+    static TilePack::Entry entryToFile(TilePack::Entry e)
+    {
+        e.type=qToLittleEndian(e.type);
+        e.zoom=qToLittleEndian(e.zoom);
+        e.x=qToLittleEndian(e.x);
+        e.y=qToLittleEndian(e.y);
+        e.offset=qToLittleEndian(e.offset);
+        e.length=qToLittleEndian(e.length);
+        return e;
+    }
+    static bool entryBefore(const TilePack::Entry &e, qint32 type, qint32 zoom, qint32 x, qint32 y)
+    {
+        qint32 etype=qFromLittleEndian(e.type);
+        if(etype!=type)
+            return etype<type;
+        qint32 ezoom=qFromLittleEndian(e.zoom);
+        if(ezoom!=zoom)
+            return ezoom<zoom;
+        qint32 ex=qFromLittleEndian(e.x);
+        if(ex!=x)
+            return ex<x;
+        return qFromLittleEndian(e.y)<y;
+    }
+
+    TilePack::TilePack():map(0),size(0),index(0),count(0)
+    {
+
+    }
+    TilePack::~TilePack()
+    {
+        if(map)
+            file.unmap(const_cast<uchar *>(map));
+    }
+
+    bool TilePack::Open(const QString &fileName)
+    {
+        file.setFileName(fileName);
+        if(!file.open(QIODevice::ReadOnly))
+            return false;
+        size=file.size();
+        if(size<TilePackHeaderSize)
+            return false;
+        map=file.map(0,size);
+        if(!map)
+            return false;
+        if(memcmp(map,TilePackMagic,sizeof(TilePackMagic)) ||
+                qFromLittleEndian<quint32>(map+8)!=TilePackVersion)
+            return false;
+        quint32 entries=qFromLittleEndian<quint32>(map+12);
+        if((size-TilePackHeaderSize)/(qint64)sizeof(Entry)<entries)
+            return false;
+        index=reinterpret_cast<const Entry *>(map+TilePackHeaderSize);
+        count=entries;
+        return true;
+    }
+
+    /* The returned array shares the pack's mapping; no copy is made */
+    QByteArray TilePack::GetTile(MapType::Types type, const Point &pos, int zoom) const
+    {
+        if(!count)
+            return QByteArray();
+        qint32 x=pos.X();
+        qint32 y=pos.Y();
+        const Entry *end=index+count;
+        const Entry *e=std::lower_bound(index,end,0,[&](const Entry &entry,int)
+        {
+            return entryBefore(entry,type,zoom,x,y);
+        });
+        if(e==end || qFromLittleEndian(e->type)!=type || qFromLittleEndian(e->zoom)!=zoom ||
+                qFromLittleEndian(e->x)!=x || qFromLittleEndian(e->y)!=y)
+            return QByteArray();
+        quint64 offset=qFromLittleEndian(e->offset);
+        quint32 length=qFromLittleEndian(e->length);
+        if(offset+length>(quint64)size)
+            return QByteArray();
+        return QByteArray::fromRawData(reinterpret_cast<const char *>(map+offset),length);
+    }
+
+    /* Writes every tile in a cache database out as a pack */
+    bool TilePack::ExportFromDB(const QString &sourceDB, const QString &destFile)
+    {
+        bool ret=false;
+        {
+            QSqlDatabase db=QSqlDatabase::addDatabase("QSQLITE",QLatin1String("TilePackExport"));
+            db.setDatabaseName(sourceDB);
+            if(db.open())
+            {
+                // First the index, so the data offsets are known up front.
+                // A tile cached more than once goes in only once.
+                QVector<Entry> entries;
+                QVector<qlonglong> ids;
+                QSqlQuery query(db);
+                query.setForwardOnly(true);
+                query.exec("SELECT Tiles.id, Type, Zoom, X, Y, length(Tile) FROM Tiles JOIN TilesData ON Tiles.id=TilesData.id ORDER BY Type, Zoom, X, Y");
+                quint64 offset=TilePackHeaderSize;
+                while(query.next())
+                {
+                    Entry e;
+                    e.type=query.value(1).toInt();
+                    e.zoom=query.value(2).toInt();
+                    e.x=query.value(3).toInt();
+                    e.y=query.value(4).toInt();
+                    e.length=query.value(5).toUInt();
+                    e.reserved=0;
+                    if(!e.length)
+                        continue;
+                    if(!entries.isEmpty())
+                    {
+                        const Entry &last=entries.last();
+                        if(last.type==e.type && last.zoom==e.zoom && last.x==e.x && last.y==e.y)
+                            continue;
+                    }
+                    entries.append(e);
+                    ids.append(query.value(0).toLongLong());
+                }
+                offset+=entries.count()*sizeof(Entry);
+                for(int i=0;i<entries.count();i++)
+                {
+                    entries[i].offset=offset;
+                    offset+=entries[i].length;
+                }
+
+                QFile out(destFile);
+                if(out.open(QIODevice::WriteOnly|QIODevice::Truncate))
+                {
+                    uchar header[TilePackHeaderSize];
+                    memcpy(header,TilePackMagic,sizeof(TilePackMagic));
+                    qToLittleEndian<quint32>(TilePackVersion,header+8);
+                    qToLittleEndian<quint32>(entries.count(),header+12);
+                    ret=out.write(reinterpret_cast<const char *>(header),sizeof(header))==sizeof(header);
+                    for(int i=0;ret && i<entries.count();i++)
+                    {
+                        Entry e=entryToFile(entries[i]);
+                        ret=out.write(reinterpret_cast<const char *>(&e),sizeof(e))==sizeof(e);
+                    }
+                    QSqlQuery tile(db);
+                    tile.prepare("SELECT Tile FROM TilesData WHERE id=?");
+                    for(int i=0;ret && i<ids.count();i++)
+                    {
+                        tile.bindValue(0,ids[i]);
+                        ret=tile.exec() && tile.next();
+                        if(ret)
+                        {
+                            QByteArray data=tile.value(0).toByteArray();
+                            ret=data.size()==(int)entries[i].length &&
+                                    out.write(data)==data.size();
+                        }
+                        tile.finish();
+                    }
+                    out.close();
+                    if(!ret)
+                        out.remove();
+                }
+                db.close();
+            }
+        }
+        QSqlDatabase::removeDatabase(QLatin1String("TilePackExport"));
+        return ret;
+    }
+}
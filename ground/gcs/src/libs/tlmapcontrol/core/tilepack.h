@@ -0,0 +1,77 @@
+/**
+******************************************************************************
+*
+* @file       tilepack.h
+* @author     dRonin, http://dRonin.org/, Copyright (C) 2017
+* @brief      Read only, memory mapped archives of map tiles
+* @see        The GNU Public License (GPL) Version 3
+* @defgroup   TLMapWidget
+* @{
+*
+*****************************************************************************/
+/*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+*
+* You should have received a copy of the GNU General Public License along
+* with this program; if not, see <http://www.gnu.org/licenses/>
+*/
+#ifndef TILEPACK_H
+#define TILEPACK_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+#include "maptype.h"
+#include "point.h"
+
+namespace core {
+    /**
+    * A tile pack is one flat file holding the tiles of an area, for taking
+    * maps where there is no network.  All fields are little endian:
+    *
+    *   header   "TLTPACK1", uint32 version, uint32 count
+    *   index    count entries of int32 type, zoom, x, y, uint64 offset,
+    *            uint32 length, uint32 reserved; sorted by (type, zoom, x, y)
+    *   data     the tile images, at the offsets given in the index
+    *
+    * Packs are mapped rather than read, and GetTile() hands out bytes that
+    * point into the mapping, so a pack must stay open while they're in use.
+    */
+    class TilePack
+    {
+    public:
+        TilePack();
+        ~TilePack();
+        bool Open(const QString &file);
+        QString FileName() const { return file.fileName(); }
+        int Count() const { return count; }
+        QByteArray GetTile(MapType::Types type, const core::Point &pos, int zoom) const;
+        static bool ExportFromDB(const QString &sourceDB, const QString &destFile);
+
+        struct Entry
+        {
+            qint32 type;
+            qint32 zoom;
+            qint32 x;
+            qint32 y;
+            quint64 offset;
+            quint32 length;
+            quint32 reserved;
+        };
+    private:
+        QFile file;
+        const uchar *map;
+        qint64 size;
+        const Entry *index;
+        int count;
+    };
+}
+#endif // TILEPACK_H
@@ -106,6 +106,16 @@ namespace core {
             //Attempt to read tile from cache
             if(accessmode != (AccessMode::ServerOnly) && type != MapType::UserImage) //Don't use cache if the user supplies a file. This is because
             {
+                // Tile packs first; they are mapped, so this is only an
+                // index lookup, and nothing needs copying to memory
+                ret=Cache::Instance()->ImageCache.GetImageFromTilePacks(type,pos,zoom);
+                if(!ret.isEmpty())
+                {
+                    errorvars.lock();
+                    ++diag.tilesFromDB;
+                    errorvars.unlock();
+                    return ret;
+                }
 #ifdef DEBUG_GMAPS
                 qDebug()<<"Try tile from DataBase";
 #endif //DEBUG_GMAPS
@@ -538,6 +548,15 @@ namespace core {
         return Cache::Instance()->ImageCache.ExportMapDataToDB(file,Cache::Instance()->ImageCache.GtileCache()+QDir::separator()+"Data.qmdb");
     }
 
+    bool TLMaps::ExportTilePack(const QString &file)
+    {
+        return Cache::Instance()->ImageCache.ExportTilePack(file);
+    }
+    bool TLMaps::ImportTilePack(const QString &file)
+    {
+        return Cache::Instance()->ImageCache.ImportTilePack(file);
+    }
+
     diagnostics TLMaps::GetDiagnostics()
     {
         diagnostics i;
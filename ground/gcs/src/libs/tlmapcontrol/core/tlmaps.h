@@ -60,6 +60,8 @@ namespace core {
         static TLMaps* Instance();
         bool ImportFromGMDB(const QString &file);
         bool ExportToGMDB(const QString &file);
+        bool ImportTilePack(const QString &file);
+        bool ExportTilePack(const QString &file);
         /// <summary>
         /// timeout for map connections
         /// </summary>
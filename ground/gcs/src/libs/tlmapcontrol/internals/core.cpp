@@ -26,6 +26,7 @@
 * with this program; if not, see <http://www.gnu.org/licenses/>
 */
 #include "core.h"
+#include <algorithm>
 
 #ifdef DEBUG_CORE
 qlonglong internals::Core::debugcounter=0;
@@ -35,7 +36,7 @@ using namespace projections;
 
 namespace internals {
     Core::Core():started(false),MouseWheelZooming(false),currentPosition(0,0),currentPositionPixel(0,0),LastLocationInBounds(-1,-1),sizeOfMapArea(0,0)
-            ,minOfTiles(0,0),maxOfTiles(0,0),zoom(0),isDragging(false),TooltipTextPadding(10,10),mapType(MapType::None),loaderLimit(5),maxzoom(21),runningThreads(0)
+            ,minOfTiles(0,0),maxOfTiles(0,0),zoom(0),isDragging(false),TooltipTextPadding(10,10),mapType(MapType::None),loaderLimit(8),maxzoom(21),runningThreads(0)
     {
         mousewheelzoomtype=MouseWheelZoomType::MousePositionAndCenter;
         SetProjection(new MercatorProjection());
@@ -144,6 +145,7 @@ namespace internals {
                                     Moverlays.lock();
                                     {
                                         t->Overlays.append(tileImage);
+                                        t->OverlayTypes.append(tl);
 #ifdef DEBUG_CORE
                                         qDebug()<<"Core::run append tileImage:"<<tileImage.length()<<" to tile:"<<t->GetPos().ToString()<<" now has "<<t->Overlays.count()<<" overlays"<<" ID="<<debug;
 #endif //DEBUG_CORE
@@ -151,6 +153,9 @@ namespace internals {
                                     }
                                     Moverlays.unlock();
 
+                                    // Decode here rather than on the first paint
+                                    TLMaps::Instance()->GetDecodedTile(RawTile(tl,task.Pos,task.Zoom),tileImage);
+
                                     break;
                                 }
                                 else if(TLMaps::Instance()->RetryLoadTile > 0)
@@ -662,6 +667,23 @@ namespace internals {
 
             emit OnTileLoadStart();
 
+            // Loads still queued for tiles that have gone out of view are
+            // dropped, so the new view doesn't wait behind them
+            MtileLoadQueue.lock();
+            {
+                int before=tileLoadQueue.count();
+                QQueue<LoadTask> kept;
+                foreach(LoadTask task,tileLoadQueue)
+                {
+                    if(task.Zoom==Zoom() && tileDrawingList.contains(task.Pos))
+                        kept.enqueue(task);
+                }
+                tileLoadQueue=kept;
+                MtileToload.lock();
+                tilesToload-=before-kept.count();
+                MtileToload.unlock();
+            }
+            MtileLoadQueue.unlock();
 
             foreach(Point p,tileDrawingList)
             {
@@ -689,12 +711,15 @@ namespace internals {
         MtileDrawingList.unlock();
         UpdateGroundResolution();
     }
+    /* Lists the tiles to keep loaded: those in view plus a ring around them
+     * to prefetch, nearest the center first so that's the order they load.
+     */
     void Core::FindTilesAround(QList<Point> &list)
     {
         list.clear();;
-        for(int i = -sizeOfMapArea.Width(); i <= sizeOfMapArea.Width(); i++)
+        for(int i = -sizeOfMapArea.Width()-1; i <= sizeOfMapArea.Width()+1; i++)
         {
-            for(int j = -sizeOfMapArea.Height(); j <= sizeOfMapArea.Height(); j++)
+            for(int j = -sizeOfMapArea.Height()-1; j <= sizeOfMapArea.Height()+1; j++)
             {
                 Point p = centerTileXYLocation;
                 p.SetX(p.X() + i);
@@ -719,8 +744,13 @@ namespace internals {
                 }
             }
         }
-
-
+        Point center=centerTileXYLocation;
+        std::stable_sort(list.begin(),list.end(),[center](const Point &a,const Point &b)
+        {
+            qint64 da=(a.X()-center.X())*(a.X()-center.X())+(a.Y()-center.Y())*(a.Y()-center.Y());
+            qint64 db=(b.X()-center.X())*(b.X()-center.X())+(b.Y()-center.Y())*(b.Y()-center.Y());
+            return da<db;
+        });
     }
     void Core::UpdateGroundResolution()
     {
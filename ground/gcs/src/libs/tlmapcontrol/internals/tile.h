@@ -30,6 +30,7 @@
 #include "QList"
 #include <QImage>
 #include "../core/point.h"
+#include "../core/maptype.h"
 #include <QMutex>
 #include <QDebug>
 #include "debugheader.h"
@@ -54,6 +55,7 @@ public:
     }
     bool HasValue(){return !(zoom==0);}
     QList<QByteArray> Overlays;
+    QList<MapType::Types> OverlayTypes; // layer of each overlay
 protected:
 
     QMutex mutex;
@@ -176,6 +176,22 @@ public:
     */
     void ExportMapDataToDB(QString const& sourceDB, QString const& destDB)const{core::PureImageCache::ExportMapDataToDB(sourceDB,destDB);}
     /**
+    * @brief Writes every cached tile to a single tile pack file, to carry
+    *        maps to machines without network access
+    *
+    * @param file the pack to write
+    * @return true on success
+    */
+    bool ExportTilePack(QString const& file){return core::Cache::Instance()->ImageCache.ExportTilePack(file);}
+    /**
+    * @brief Adds a tile pack to the cache. Its tiles are served straight
+    *        from the file, ahead of the database, now and on later runs.
+    *
+    * @param file the pack to add
+    * @return true if the pack could be used
+    */
+    bool ImportTilePack(QString const& file){return core::Cache::Instance()->ImageCache.ImportTilePack(file);}
+    /**
     * @brief Returns the location for the SQLite Database used for caching and the geocoding cache files
     *
     * @return
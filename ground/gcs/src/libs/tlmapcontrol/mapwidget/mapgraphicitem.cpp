@@ -377,14 +377,16 @@ namespace mapcontrol
                             //lock(t.Overlays)
                             if(t!=nullptr)
                             {
-                                foreach(QByteArray img,t->Overlays)
+                                for(int k=0;k<t->Overlays.count();k++)
                                 {
+                                    QByteArray img=t->Overlays.at(k);
                                     if(img.count()!=0)
                                     {
                                         if(!found)
                                             found = true;
                                         {
-                                            painter->drawPixmap(core->tileRect.X(),core->tileRect.Y(), core->tileRect.Width(), core->tileRect.Height(),PureImageProxy::FromStream(img));
+                                            RawTile key(t->OverlayTypes.value(k),t->GetPos(),t->GetZoom());
+                                            painter->drawImage(QRectF(core->tileRect.X(),core->tileRect.Y(), core->tileRect.Width(), core->tileRect.Height()),TLMaps::Instance()->GetDecodedTile(key,img));
                                         }
                                     }
                                 }
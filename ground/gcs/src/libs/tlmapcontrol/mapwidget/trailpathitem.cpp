@@ -0,0 +1,295 @@
+/**
+******************************************************************************
+*
+* @file       trailpathitem.cpp
+* @author     dRonin, http://dRonin.org Copyright (C) 2017
+* @brief      A graphicsItem drawing a whole trail, points and line
+* @see        The GNU Public License (GPL) Version 3
+* @defgroup   TLMapWidget
+* @{
+*
+*****************************************************************************/
+/*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+*
+* You should have received a copy of the GNU General Public License along
+* with this program; if not, see <http://www.gnu.org/licenses/>
+*/
+#include "trailpathitem.h"
+#include <QGraphicsSceneHoverEvent>
+#include <QStyleOptionGraphicsItem>
+#include <QPair>
+#include <qmath.h>
+
+namespace mapcontrol
+{
+    //! How far, in pixels, the simplified line may stray from the trail
+    static const qreal SIMPLIFY_TOLERANCE = 0.5;
+    //! Points closer than this, in pixels, to one already drawn are skipped
+    static const qreal POINT_SPACING = 3;
+    static const qreal POINT_RADIUS = 2;
+    //! How close, in pixels, the mouse has to be to a point for its tooltip
+    static const qreal HOVER_DISTANCE = 4;
+
+    TrailPathItem::TrailPathItem(QBrush pointColor, QBrush lineColor, MapGraphicItem *map):QGraphicsItem(map),
+        m_map(map),m_pointBrush(pointColor),m_lineBrush(lineColor),
+        m_showPoints(true),m_showLine(true),m_zoom(-1),m_hovered(-1)
+    {
+        setFlag(QGraphicsItem::ItemUsesExtendedStyleOption,true);
+        setAcceptHoverEvents(true);
+    }
+
+    void TrailPathItem::AddPoint(internals::PointLatLng const& coord, int const& altitude)
+    {
+        TrailPoint point;
+        point.coord=coord;
+        point.altitude=altitude;
+        point.time=QDateTime::currentDateTime();
+        m_points.append(point);
+
+        if(m_points.size()==1 || m_map->ZoomTotal()!=m_zoom)
+        {
+            RefreshPos();
+            return;
+        }
+
+        // The end of the line is always kept, so there's no need to simplify
+        // it all again, just add on to it
+        QPointF local=Project(coord)-pos();
+        m_local.append(local);
+        m_line.append(local);
+
+        prepareGeometryChange();
+        AddToBounds(local);
+        update();
+    }
+
+    void TrailPathItem::Clear()
+    {
+        prepareGeometryChange();
+        m_points.clear();
+        m_local.clear();
+        m_line.clear();
+        m_bounds=QRectF();
+        m_zoom=-1;
+        m_hovered=-1;
+        setToolTip(QString());
+    }
+
+    void TrailPathItem::SetShowPoints(bool const& value)
+    {
+        m_showPoints=value;
+        setVisible(m_showPoints||m_showLine);
+        update();
+    }
+
+    void TrailPathItem::SetShowLine(bool const& value)
+    {
+        m_showLine=value;
+        setVisible(m_showPoints||m_showLine);
+        update();
+    }
+
+    void TrailPathItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
+    {
+        Q_UNUSED(widget);
+
+        QRectF exposed=option->exposedRect.adjusted(-POINT_RADIUS,-POINT_RADIUS,POINT_RADIUS,POINT_RADIUS);
+
+        if(m_showLine && m_line.size()>1)
+        {
+            QPen pen;
+            pen.setBrush(m_lineBrush);
+            pen.setWidth(1);
+            painter->setPen(pen);
+            painter->drawPolyline(m_line);
+        }
+
+        if(m_showPoints)
+        {
+            painter->setPen(QPen());
+            painter->setBrush(m_pointBrush);
+
+            QPointF last;
+            bool drawn=false;
+            foreach(QPointF const& point,m_local)
+            {
+                if(!exposed.contains(point))
+                    continue;
+                if(drawn && (point-last).manhattanLength()<POINT_SPACING)
+                    continue;
+                painter->drawEllipse(point,POINT_RADIUS,POINT_RADIUS);
+                last=point;
+                drawn=true;
+            }
+        }
+    }
+
+    QRectF TrailPathItem::boundingRect()const
+    {
+        return m_bounds.adjusted(-POINT_RADIUS-1,-POINT_RADIUS-1,POINT_RADIUS+1,POINT_RADIUS+1);
+    }
+
+    int TrailPathItem::type()const
+    {
+        return Type;
+    }
+
+    void TrailPathItem::hoverMoveEvent(QGraphicsSceneHoverEvent *event)
+    {
+        int nearest=-1;
+        qreal best=HOVER_DISTANCE;
+
+        if(m_showPoints)
+        {
+            for(int i=0;i<m_local.size();++i)
+            {
+                qreal distance=(m_local[i]-event->pos()).manhattanLength();
+                if(distance<best)
+                {
+                    best=distance;
+                    nearest=i;
+                }
+            }
+        }
+
+        if(nearest==m_hovered)
+            return;
+        m_hovered=nearest;
+
+        if(nearest<0)
+        {
+            setToolTip(QString());
+            return;
+        }
+
+        TrailPoint const& point=m_points[nearest];
+        QString coord_str = " " + QString::number(point.coord.Lat(), 'f', 6) + "   " + QString::number(point.coord.Lng(), 'f', 6);
+        setToolTip(QString(tr("Position:")+"%1\n"+tr("Altitude:")+"%2\n"+tr("Time:")+"%3").arg(coord_str).arg(QString::number(point.altitude)).arg(point.time.toString()));
+    }
+
+    void TrailPathItem::hoverLeaveEvent(QGraphicsSceneHoverEvent *event)
+    {
+        Q_UNUSED(event);
+        m_hovered=-1;
+        setToolTip(QString());
+    }
+
+    QPointF TrailPathItem::Project(internals::PointLatLng const& coord)const
+    {
+        core::Point local=m_map->FromLatLngToLocal(coord);
+        return QPointF(local.X(),local.Y());
+    }
+
+    /**
+    * @brief Moves the trail with the map, and projects it again if the map
+    *        was zoomed
+    */
+    void TrailPathItem::RefreshPos()
+    {
+        if(m_points.isEmpty())
+            return;
+
+        setPos(Project(m_points.first().coord));
+
+        if(m_map->ZoomTotal()!=m_zoom)
+            Reproject();
+    }
+
+    void TrailPathItem::Reproject()
+    {
+        prepareGeometryChange();
+
+        m_zoom=m_map->ZoomTotal();
+        m_local.resize(m_points.size());
+        // Everything is relative to the first point
+        m_bounds=QRectF(0,0,0,0);
+
+        QPointF origin=pos();
+        for(int i=0;i<m_points.size();++i)
+        {
+            m_local[i]=Project(m_points[i].coord)-origin;
+            AddToBounds(m_local[i]);
+        }
+
+        Simplify();
+    }
+
+    /**
+    * @brief Douglas-Peucker: keeps the point furthest from the line between
+    *        the ends of each span, as long as it's further than the tolerance,
+    *        and splits the span there
+    */
+    void TrailPathItem::Simplify()
+    {
+        m_line.clear();
+        int count=m_local.size();
+        if(count<3)
+        {
+            m_line=QPolygonF(m_local);
+            return;
+        }
+
+        QVector<bool> keep(count,false);
+        keep[0]=keep[count-1]=true;
+
+        QVector<QPair<int,int> > spans;
+        spans.append(qMakePair(0,count-1));
+
+        while(!spans.isEmpty())
+        {
+            QPair<int,int> span=spans.takeLast();
+            QPointF const& a=m_local[span.first];
+            QPointF const& b=m_local[span.second];
+            QPointF ab=b-a;
+            qreal length=qSqrt(QPointF::dotProduct(ab,ab));
+
+            int furthest=-1;
+            qreal max=SIMPLIFY_TOLERANCE;
+            for(int i=span.first+1;i<span.second;++i)
+            {
+                QPointF ap=m_local[i]-a;
+                qreal distance;
+                if(length>0)
+                    distance=qAbs(ab.x()*ap.y()-ab.y()*ap.x())/length;
+                else
+                    distance=qSqrt(QPointF::dotProduct(ap,ap));
+                if(distance>max)
+                {
+                    max=distance;
+                    furthest=i;
+                }
+            }
+
+            if(furthest<0)
+                continue;
+
+            keep[furthest]=true;
+            spans.append(qMakePair(span.first,furthest));
+            spans.append(qMakePair(furthest,span.second));
+        }
+
+        for(int i=0;i<count;++i)
+        {
+            if(keep[i])
+                m_line.append(m_local[i]);
+        }
+    }
+
+    void TrailPathItem::AddToBounds(QPointF const& point)
+    {
+        // Not |=, which ignores empty rectangles
+        m_bounds.setLeft(qMin(m_bounds.left(),point.x()));
+        m_bounds.setRight(qMax(m_bounds.right(),point.x()));
+        m_bounds.setTop(qMin(m_bounds.top(),point.y()));
+        m_bounds.setBottom(qMax(m_bounds.bottom(),point.y()));
+    }
+}
@@ -0,0 +1,107 @@
+/**
+******************************************************************************
+*
+* @file       trailpathitem.h
+* @author     dRonin, http://dRonin.org Copyright (C) 2017
+* @brief      A graphicsItem drawing a whole trail, points and line
+* @see        The GNU Public License (GPL) Version 3
+* @defgroup   TLMapWidget
+* @{
+*
+*****************************************************************************/
+/*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+*
+* You should have received a copy of the GNU General Public License along
+* with this program; if not, see <http://www.gnu.org/licenses/>
+*/
+#ifndef TRAILPATHITEM_H
+#define TRAILPATHITEM_H
+
+#include <QGraphicsItem>
+#include <QPainter>
+#include <QDateTime>
+#include <QVector>
+#include <QPolygonF>
+#include "../internals/pointlatlng.h"
+#include <QObject>
+#include "mapgraphicitem.h"
+#include "../core/corecommon.h"
+
+namespace mapcontrol
+{
+    /**
+    * @brief One item for all the points of a trail and the line through them,
+    *        in place of an item per point and per segment.
+    *
+    *        The points are projected again only when the zoom changes; panning
+    *        just moves the item.  The line is simplified for the zoom level, and
+    *        only the points in the exposed area that aren't drawn over one
+    *        another are painted.
+    *
+    * @class TrailPathItem trailpathitem.h "trailpathitem.h"
+    */
+    class TLMAPWIDGET_EXPORT TrailPathItem:public QObject,public QGraphicsItem
+    {
+        Q_OBJECT
+        Q_INTERFACES(QGraphicsItem)
+    public:
+        enum { Type = UserType + 10 };
+        TrailPathItem(QBrush pointColor, QBrush lineColor, MapGraphicItem * map);
+        /**
+        * @brief Adds a point to the end of the trail
+        */
+        void AddPoint(internals::PointLatLng const& coord, int const& altitude);
+        /**
+        * @brief Deletes all the trail points
+        */
+        void Clear();
+        void SetShowPoints(bool const& value);
+        void SetShowLine(bool const& value);
+        void paint(QPainter *painter, const QStyleOptionGraphicsItem *option,
+                    QWidget *widget);
+        QRectF boundingRect() const;
+        int type() const;
+    protected:
+        void hoverMoveEvent(QGraphicsSceneHoverEvent *event);
+        void hoverLeaveEvent(QGraphicsSceneHoverEvent *event);
+    private:
+        struct TrailPoint
+        {
+            internals::PointLatLng coord;
+            int altitude;
+            QDateTime time;
+        };
+
+        QPointF Project(internals::PointLatLng const& coord) const;
+        void Reproject();
+        void Simplify();
+        void AddToBounds(QPointF const& point);
+
+        MapGraphicItem * m_map;
+        QBrush m_pointBrush;
+        QBrush m_lineBrush;
+        bool m_showPoints;
+        bool m_showLine;
+
+        QVector<TrailPoint> m_points;
+        //! Where each point is, relative to the first one, at m_zoom
+        QVector<QPointF> m_local;
+        //! The line, with the points it doesn't need at this zoom left out
+        QPolygonF m_line;
+        QRectF m_bounds;
+        double m_zoom;
+        int m_hovered;
+    public slots:
+        void RefreshPos();
+    };
+}
+#endif // TRAILPATHITEM_H
@@ -54,10 +54,7 @@ namespace mapcontrol
         localposition=map->FromLatLngToLocal(mapwidget->CurrentPosition());
         this->setPos(localposition.X(),localposition.Y());
         this->setZValue(4);
-        trail=new QGraphicsItemGroup(this);
-        trail->setParentItem(map);
-        trailLine=new QGraphicsItemGroup(this);
-        trailLine->setParentItem(map);
+        trail=new TrailPathItem(Qt::green,Qt::red,map);
         this->setFlag(QGraphicsItem::ItemIgnoresTransformations,true);
         setCacheMode(QGraphicsItem::ItemCoordinateCache);
         mapfollowtype=UAVMapFollowType::None;
@@ -267,16 +264,7 @@ namespace mapcontrol
             {
                 if(timer.elapsed()>trailtime*1000)
                 {
-                    TrailItem * ob=new TrailItem(position,altitude,Qt::green,map);
-                    trail->addToGroup(ob);
-                    connect(this,SIGNAL(setChildPosition()),ob,SLOT(setPosSLOT()));
-                    if(!lasttrailline.IsEmpty())
-                    {
-                        TrailLineItem * obj=new TrailLineItem(lasttrailline,position,Qt::red,map);
-                        trailLine->addToGroup(obj);
-                        connect(this,SIGNAL(setChildLine()),obj,SLOT(setLineSlot()));
-                    }
-                    lasttrailline=position;
+                    trail->AddPoint(position,altitude);
                     timer.restart();
                 }
 
@@ -285,16 +273,7 @@ namespace mapcontrol
             {
                 if(qAbs(internals::PureProjection::DistanceBetweenLatLng(lastcoord, position)) > traildistance)
                 {
-                    TrailItem * ob=new TrailItem(position,altitude,Qt::green,map);
-                    trail->addToGroup(ob);
-                    connect(this,SIGNAL(setChildPosition()),ob,SLOT(setPosSLOT()));
-                    if(!lasttrailline.IsEmpty())
-                    {
-                        TrailLineItem * obj=new TrailLineItem(lasttrailline,position,Qt::red,map);
-                        trailLine->addToGroup(obj);
-                        connect(this,SIGNAL(setChildLine()),obj,SLOT(setLineSlot()));
-                    }
-                    lasttrailline=position;
+                    trail->AddPoint(position,altitude);
                     lastcoord=position;
                 }
             }
@@ -372,8 +351,7 @@ namespace mapcontrol
     {
         localposition=map->FromLatLngToLocal(coord);
         this->setPos(localposition.X(),localposition.Y());
-        emit setChildPosition();
-        emit setChildLine();
+        trail->RefreshPos();
         updateTextOverlay();
     }
 
@@ -400,20 +378,17 @@ namespace mapcontrol
     void UAVItem::SetShowTrail(const bool &value)
     {
         showtrail=value;
-        trail->setVisible(value);
+        trail->SetShowPoints(value);
     }
     void UAVItem::SetShowTrailLine(const bool &value)
     {
         showtrailline=value;
-        trailLine->setVisible(value);
+        trail->SetShowLine(value);
     }
 
     void UAVItem::DeleteTrail()const
     {
-        foreach(QGraphicsItem* i,trail->childItems())
-            delete i;
-        foreach(QGraphicsItem* i,trailLine->childItems())
-            delete i;
+        trail->Clear();
     }
 
     void UAVItem::SetUavPic(QString UAVPic)
@@ -27,6 +27,7 @@
 #include "waypointitem.h"
 #include "homeitem.h"
 #include <QGraphicsSceneMouseEvent>
+#include <QPixmapCache>
 
 namespace mapcontrol
 {
@@ -44,7 +45,7 @@ namespace mapcontrol
         text=nullptr;
         numberI=nullptr;
         isMagic=false;
-        picture.load(QString::fromUtf8(":/markers/images/marker.png"));
+        picture=CachedPicture(":/markers/images/marker.png");
         number=WayPointItem::snumber;
         ++WayPointItem::snumber;
         this->setFlag(QGraphicsItem::ItemIsMovable,true);
@@ -59,7 +60,10 @@ namespace mapcontrol
         {
             HomeItem* h=qgraphicsitem_cast <HomeItem*>(obj);
             if(h)
+            {
                 myHome=h;
+                break;
+            }
         }
 
         if(myHome)
@@ -86,7 +90,7 @@ namespace mapcontrol
         if(magicwaypoint)
         {
             isMagic=true;
-            picture.load(QString::fromUtf8(":/opmap/images/waypoint_marker3.png"));
+            picture=CachedPicture(":/opmap/images/waypoint_marker3.png");
             number=-1;
         }
         else
@@ -109,7 +113,10 @@ namespace mapcontrol
         {
             HomeItem* h=qgraphicsitem_cast <HomeItem*>(obj);
             if(h)
+            {
                 myHome=h;
+                break;
+            }
         }
 
         if(myHome)
@@ -137,7 +144,7 @@ namespace mapcontrol
         text=nullptr;
         numberI=nullptr;
         isMagic=false;
-        picture.load(QString::fromUtf8(":/markers/images/marker.png"));
+        picture=CachedPicture(":/markers/images/marker.png");
         number=WayPointItem::snumber;
         ++WayPointItem::snumber;
         this->setFlag(QGraphicsItem::ItemIsMovable,true);
@@ -152,7 +159,10 @@ namespace mapcontrol
         {
             HomeItem* h=qgraphicsitem_cast <HomeItem*>(obj);
             if(h)
+            {
                 myHome=h;
+                break;
+            }
         }
         if(myHome)
         {
@@ -181,7 +191,10 @@ namespace mapcontrol
         {
             HomeItem* h=qgraphicsitem_cast <HomeItem*>(obj);
             if(h)
-               myHome=h;
+            {
+                myHome=h;
+                break;
+            }
         }
         if(myHome)
         {
@@ -192,7 +205,7 @@ namespace mapcontrol
         text=nullptr;
         numberI=nullptr;
         isMagic=false;
-        picture.load(QString::fromUtf8(":/markers/images/marker.png"));
+        picture=CachedPicture(":/markers/images/marker.png");
         number=WayPointItem::snumber;
         ++WayPointItem::snumber;
         this->setFlag(QGraphicsItem::ItemIsMovable,true);
@@ -381,19 +394,19 @@ namespace mapcontrol
         reached=value;
         emit WPValuesChanged(this);
         if(value)
-            picture.load(QString::fromUtf8(":/markers/images/bigMarkerGreen.png"));
+            picture=CachedPicture(":/markers/images/bigMarkerGreen.png");
         else
         {
             if(!isMagic)
             {
                 if(this->flags() & QGraphicsItem::ItemIsMovable)
-                    picture.load(QString::fromUtf8(":/markers/images/marker.png"));
+                    picture=CachedPicture(":/markers/images/marker.png");
                 else
-                    picture.load(QString::fromUtf8(":/markers/images/waypoint_marker2.png"));
+                    picture=CachedPicture(":/markers/images/waypoint_marker2.png");
             }
             else
             {
-                picture.load(QString::fromUtf8(":/opmap/images/waypoint_marker3.png"));
+                picture=CachedPicture(":/opmap/images/waypoint_marker3.png");
             }
         }
             this->update();
@@ -526,12 +539,27 @@ namespace mapcontrol
         else if(flag==QGraphicsItem::ItemIsMovable)
         {
             if(enabled)
-                picture.load(QString::fromUtf8(":/markers/images/marker.png"));
+                picture=CachedPicture(":/markers/images/marker.png");
             else
-                picture.load(QString::fromUtf8(":/markers/images/waypoint_marker2.png"));
+                picture=CachedPicture(":/markers/images/waypoint_marker2.png");
         }
         QGraphicsItem::setFlag(flag,enabled);
     }
 
+    /**
+    * @brief The marker pictures are shared by all the waypoints, rather than
+    *        each waypoint decoding its own copy
+    */
+    QPixmap WayPointItem::CachedPicture(QString const& resource)
+    {
+        QPixmap pixmap;
+        if(!QPixmapCache::find(resource,&pixmap))
+        {
+            pixmap.load(resource);
+            QPixmapCache::insert(resource,pixmap);
+        }
+        return pixmap;
+    }
+
     int WayPointItem::snumber=0;
 }
@@ -149,6 +149,7 @@ protected:
     void mouseReleaseEvent ( QGraphicsSceneMouseEvent * event );
     void mouseDoubleClickEvent(QGraphicsSceneMouseEvent *event);
 private:
+    static QPixmap CachedPicture(QString const& resource);
     bool reached;
     bool shownumber;
     bool isDragging;
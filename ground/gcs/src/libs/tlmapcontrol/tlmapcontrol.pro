@@ -14,6 +14,7 @@ SOURCES += mapwidget/mapgraphicitem.cpp \
     mapwidget/mapripform.cpp \
     mapwidget/mapripper.cpp \
     mapwidget/traillineitem.cpp \
+    mapwidget/trailpathitem.cpp \
     mapwidget/mapline.cpp \
     mapwidget/mapcircle.cpp \
     mapwidget/waypointcurve.cpp \
@@ -34,6 +35,7 @@ SOURCES += mapwidget/mapgraphicitem.cpp \
     core/kibertilecache.cpp \
     core/diagnostics.cpp \
     core/tlmaps.cpp \
+    core/tilepack.cpp \
     internals/core.cpp \
     internals/rectangle.cpp \
     internals/tile.cpp \
@@ -66,6 +68,7 @@ HEADERS += mapwidget/mapgraphicitem.h \
     mapwidget/mapripform.h \
     mapwidget/mapripper.h \
     mapwidget/traillineitem.h \
+    mapwidget/trailpathitem.h \
     mapwidget/mapline.h \
     mapwidget/mapcircle.h \
     mapwidget/waypointcurve.h \
@@ -90,6 +93,7 @@ HEADERS += mapwidget/mapgraphicitem.h \
     core/debugheader.h \
     core/diagnostics.h \
     core/tlmaps.h \
+    core/tilepack.h \
     internals/core.h \
     internals/mousewheelzoomtype.h \
     internals/rectangle.h \
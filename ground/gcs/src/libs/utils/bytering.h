@@ -0,0 +1,117 @@
+/**
+ ******************************************************************************
+ * @file       bytering.h
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2017
+ * @addtogroup libs GCS Libraries
+ * @{
+ * @addtogroup utils Utilities
+ * @{
+ * @brief A byte ring between one writing thread and one reading thread
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ * Additional note on redistribution: The copyright and license notices above
+ * must be maintained in each individual source file that is a derivative work
+ * of this source file; otherwise redistribution is prohibited.
+ */
+
+#ifndef BYTERING_H
+#define BYTERING_H
+
+#include <QAtomicInteger>
+#include <QVector>
+
+#include <string.h>
+
+namespace Utils {
+
+/**
+ * @brief Fixed size FIFO of bytes, without locks, for exactly one thread
+ * putting bytes in and one taking them out.  The positions only ever grow
+ * (wrapping at 2^32), and each is stored by just one of the threads.
+ */
+class ByteRing
+{
+public:
+    /**
+     * @param order the ring holds 2^order bytes
+     */
+    explicit ByteRing(int order = 16)
+        : buffer(1 << order)
+        , mask((1u << order) - 1)
+        , head(0)
+        , tail(0)
+    {
+    }
+
+    //! Bytes waiting to be read
+    int available() const { return head.loadAcquire() - tail.loadAcquire(); }
+
+    //! Room left for writing
+    int space() const { return buffer.size() - available(); }
+
+    /**
+     * @brief Called from the writing thread only
+     * @return how much was written, which is less than size if the ring filled
+     */
+    int write(const char *data, int size)
+    {
+        quint32 in = head.load();
+        size = qMin(size, int(buffer.size() - (in - tail.loadAcquire())));
+
+        int first = qMin(size, int(buffer.size() - (in & mask)));
+        memcpy(buffer.data() + (in & mask), data, first);
+        memcpy(buffer.data(), data + first, size - first);
+
+        head.storeRelease(in + size);
+
+        return size;
+    }
+
+    /**
+     * @brief Called from the reading thread only
+     * @return how much was read
+     */
+    int read(char *data, int size)
+    {
+        quint32 out = tail.load();
+        size = qMin(size, int(head.loadAcquire() - out));
+
+        int first = qMin(size, int(buffer.size() - (out & mask)));
+        memcpy(data, buffer.constData() + (out & mask), first);
+        memcpy(data + first, buffer.constData(), size - first);
+
+        tail.storeRelease(out + size);
+
+        return size;
+    }
+
+private:
+    QVector<char> buffer;
+    const quint32 mask;
+
+    //! Where the next byte is written, and read
+    QAtomicInteger<quint32> head;
+    QAtomicInteger<quint32> tail;
+};
+
+} // namespace Utils
+
+#endif // BYTERING_H
+
+/**
+ * @}
+ * @}
+ */
@@ -59,7 +59,8 @@ HEADERS += utils_global.h \
     mytabwidget.h \
     svgimageprovider.h \
     scaledpixmaplabel.h \
-    longlongspinbox.h
+    longlongspinbox.h \
+    bytering.h
 
 
 HEADERS += xmlconfig.h
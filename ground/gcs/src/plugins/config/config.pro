@@ -6,6 +6,7 @@ DEFINES += QWT_DLL
 QT += svg
 QT += network
 QT += charts
+QT += concurrent
 
 include(../../gcsplugin.pri)
 
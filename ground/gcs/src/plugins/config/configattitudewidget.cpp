@@ -209,7 +209,7 @@ ConfigAttitudeWidget::~ConfigAttitudeWidget()
 
 void ConfigAttitudeWidget::showEvent(QShowEvent *event)
 {
-    Q_UNUSED(event)
+    ConfigTaskWidget::showEvent(event);
     m_ui->sixPointHelp->fitInView(paperplane, Qt::KeepAspectRatio);
 }
 
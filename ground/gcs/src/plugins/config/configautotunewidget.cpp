@@ -69,6 +69,7 @@
 #include <QVector>
 #include <QWidget>
 #include <QWizard>
+#include <QtConcurrent>
 #include <QtNetwork/QNetworkAccessManager>
 #include <QtNetwork/QNetworkRequest>
 
@@ -229,6 +230,9 @@ QJsonDocument ConfigAutotuneWidget::getResultsJson(AutotuneFinalPage *autotuneSh
     roll_ident["bias"] = tuneState->bias[0];
     roll_ident["noise"] = tuneState->noise[0];
     roll_ident["tau"] = tuneState->tau[0];
+    roll_ident["gainCI"] = tuneState->betaCI[0];
+    roll_ident["biasCI"] = tuneState->biasCI[0];
+    roll_ident["tauCI"] = tuneState->tauCI[0];
     identification["roll"] = roll_ident;
 
     QJsonObject pitch_ident;
@@ -236,6 +240,9 @@ QJsonDocument ConfigAutotuneWidget::getResultsJson(AutotuneFinalPage *autotuneSh
     pitch_ident["bias"] = tuneState->bias[1];
     pitch_ident["noise"] = tuneState->noise[1];
     pitch_ident["tau"] = tuneState->tau[1];
+    pitch_ident["gainCI"] = tuneState->betaCI[1];
+    pitch_ident["biasCI"] = tuneState->biasCI[1];
+    pitch_ident["tauCI"] = tuneState->tauCI[1];
     identification["pitch"] = pitch_ident;
 
     QJsonObject yaw_ident;
@@ -243,6 +250,9 @@ QJsonDocument ConfigAutotuneWidget::getResultsJson(AutotuneFinalPage *autotuneSh
     yaw_ident["bias"] = tuneState->bias[2];
     yaw_ident["noise"] = tuneState->noise[2];
     yaw_ident["tau"] = tuneState->tau[2];
+    yaw_ident["gainCI"] = tuneState->betaCI[2];
+    yaw_ident["biasCI"] = tuneState->biasCI[2];
+    yaw_ident["tauCI"] = tuneState->tauCI[2];
     identification["yaw"] = yaw_ident;
 
     identification["tau"] = tuneState->tau[0];
@@ -527,17 +537,24 @@ QChart *AutotuneMeasuredPropertiesPage::makeChart(int axis) {
 
 void AutotuneMeasuredPropertiesPage::initializePage()
 {
-    measuredRollGain->setText(QString::number(tuneState->beta[0], 'f', 2));
-    measuredPitchGain->setText(QString::number(tuneState->beta[1], 'f', 2));
-    measuredYawGain->setText(QString::number(tuneState->beta[2], 'f', 2));
+    auto withCI = [](float value, float ci, int prec) {
+        return QString("%1 %2 %3")
+            .arg(value, 0, 'f', prec)
+            .arg(QChar(0x00b1))
+            .arg(ci, 0, 'f', prec);
+    };
 
-    measuredRollBias->setText(QString::number(tuneState->bias[0], 'f', 3));
-    measuredPitchBias->setText(QString::number(tuneState->bias[1], 'f', 3));
-    measuredYawBias->setText(QString::number(tuneState->bias[2], 'f', 3));
+    measuredRollGain->setText(withCI(tuneState->beta[0], tuneState->betaCI[0], 2));
+    measuredPitchGain->setText(withCI(tuneState->beta[1], tuneState->betaCI[1], 2));
+    measuredYawGain->setText(withCI(tuneState->beta[2], tuneState->betaCI[2], 2));
 
-    rollTau->setText(QString::number(tuneState->tau[0], 'f', 4));
-    pitchTau->setText(QString::number(tuneState->tau[1], 'f', 4));
-    yawTau->setText(QString::number(tuneState->tau[2], 'f', 4));
+    measuredRollBias->setText(withCI(tuneState->bias[0], tuneState->biasCI[0], 3));
+    measuredPitchBias->setText(withCI(tuneState->bias[1], tuneState->biasCI[1], 3));
+    measuredYawBias->setText(withCI(tuneState->bias[2], tuneState->biasCI[2], 3));
+
+    rollTau->setText(withCI(tuneState->tau[0], tuneState->tauCI[0], 4));
+    pitchTau->setText(withCI(tuneState->tau[1], tuneState->tauCI[1], 4));
+    yawTau->setText(withCI(tuneState->tau[2], tuneState->tauCI[2], 4));
 
     measuredRollNoise->setText(QString::number(tuneState->noise[0], 'f', 2));
     measuredPitchNoise->setText(QString::number(tuneState->noise[1], 'f', 2));
@@ -837,6 +854,9 @@ AutotuneBeginningPage::AutotuneBeginningPage(QWidget *parent,
     this->autoOpened = autoOpened;
     dataValid = false;
     setupUi(this);
+
+    connect(&identifyWatcher, &QFutureWatcher<Identification>::finished, this,
+            &AutotuneBeginningPage::identificationDone);
 }
 
 QString AutotuneBeginningPage::tuneValid(bool *okToContinue) const
@@ -930,7 +950,38 @@ void AutotuneBeginningPage::doDownloadAndProcess()
 
     progressBar->setValue(90);
 
-    processAutotuneData();
+    /* The axes are identified on the thread pool; longer captures take a
+     * while, and the wizard should stay responsive in the meantime. */
+    identifyWatcher.setFuture(QtConcurrent::run(&AutotuneBeginningPage::identify,
+            tuneState->data));
+}
+
+void AutotuneBeginningPage::identificationDone()
+{
+    Identification result = identifyWatcher.result();
+
+    if (result.valid) {
+        for (int axis = 0; axis < 3; axis++) {
+            const AxisIdentification &ident = result.axis[axis];
+
+            tuneState->model[axis] = new QLineSeries(this);
+            tuneState->actual[axis] = new QLineSeries(this);
+
+            tuneState->model[axis]->replace(ident.model);
+            tuneState->actual[axis]->replace(ident.actual);
+
+            tuneState->tau[axis] = ident.tau;
+            tuneState->beta[axis] = ident.beta;
+            tuneState->bias[axis] = ident.bias;
+            tuneState->noise[axis] = ident.noise;
+
+            tuneState->tauCI[axis] = ident.tauCI;
+            tuneState->betaCI[axis] = ident.betaCI;
+            tuneState->biasCI[axis] = ident.biasCI;
+        }
+
+        tuneState->valid = true;
+    }
 
     progressBar->setValue(100);
 
@@ -1072,112 +1123,182 @@ float AutotuneBeginningPage::getSampleDelay(int pts,
     return max_idx;
 }
 
-bool AutotuneBeginningPage::processAutotuneData()
+/* Spread between the 5th and 95th percentiles */
+float AutotuneBeginningPage::percentileSpan(QVector<float> data)
 {
-    QByteArray &loadedFile = tuneState->data;
+    std::sort(data.begin(), data.end());
 
-    const at_flash *flash_data = reinterpret_cast<const at_flash *>((const void *)loadedFile);
+    int low_idx = data.size() * 0.05 + 0.5;
+    int high_idx = data.size() - 1 - low_idx;
 
-    unsigned int size = loadedFile.size();
+    return data[high_idx] - data[low_idx];
+}
 
-    /* Determine whether we have a sane amount of data, etc. */
-    if ((size < sizeof(at_flash)) || (flash_data->hdr.magic != ATFLASH_MAGIC)) {
-        return false;
-    }
+AutotuneBeginningPage::AxisIdentification AutotuneBeginningPage::identifyAxis(
+        const at_flash *flash_data, int axis)
+{
+    AxisIdentification ident;
 
-    unsigned int size_expected = sizeof(at_flash)
-        + sizeof(at_measurement) * flash_data->hdr.wiggle_points + flash_data->hdr.aux_data_len;
+    int pts = flash_data->hdr.wiggle_points;
+    float sample_rate = flash_data->hdr.sample_rate;
 
-    if (size < size_expected) {
-        return false;
+    QVector<float> gyro_deriv(pts);
+    QVector<float> actu_desired(pts);
+
+    for (int i = 0; i < pts; i++) {
+        actu_desired[i] = flash_data->data[i].u[axis];
     }
 
-    float duration = (float)flash_data->hdr.wiggle_points / flash_data->hdr.sample_rate;
+    // Differentiate the gyro data
+    for (int i = 1; i < pts; i++) {
+        gyro_deriv[i] = flash_data->data[i].y[axis] - flash_data->data[i - 1].y[axis];
+    }
+
+    gyro_deriv[0] = flash_data->data[0].y[axis] - flash_data->data[pts - 1].y[axis];
+
+    float sample_tau = getSampleDelay(pts, gyro_deriv, actu_desired,
+            (axis == 2) ? 8 : 4);
+
+    float tau = sample_tau / sample_rate;
+
+    biquadFilter(1 / (sample_tau * M_PI * 1.414), pts, actu_desired);
+
+    float gain = percentileSpan(gyro_deriv) / percentileSpan(actu_desired) * sample_rate;
+
+    float avg = std::accumulate(gyro_deriv.begin(), gyro_deriv.end(), 0.0f) / pts;
+    float avg_act = std::accumulate(actu_desired.begin(), actu_desired.end(), 0.0f) / pts;
+
+    float bias = avg - avg_act * (gain / sample_rate);
+
+    /* Jackknife the gain and bias: leave out one block of the capture at a
+     * time and see how far the estimates move.  The delay is a whole number
+     * of samples, so its uncertainty is at least half a sample.
+     */
+    const int blocks = 10;
+
+    QVector<float> jack_beta(blocks);
+    QVector<float> jack_bias(blocks);
+
+    for (int b = 0; b < blocks; b++) {
+        int skip_start = (b * pts) / blocks;
+        int skip_end = ((b + 1) * pts) / blocks;
+
+        QVector<float> gyro_kept = gyro_deriv.mid(0, skip_start) + gyro_deriv.mid(skip_end);
+        QVector<float> actu_kept = actu_desired.mid(0, skip_start) + actu_desired.mid(skip_end);
 
-    if ((duration < 0.25f) || (duration > 5.0f)) {
-        return false;
+        int kept = gyro_kept.size();
+
+        float jack_gain = percentileSpan(gyro_kept) / percentileSpan(actu_kept) * sample_rate;
+
+        float jack_avg = std::accumulate(gyro_kept.begin(), gyro_kept.end(), 0.0f) / kept;
+        float jack_avg_act = std::accumulate(actu_kept.begin(), actu_kept.end(), 0.0f) / kept;
+
+        jack_beta[b] = log(jack_gain);
+        jack_bias[b] = jack_avg - jack_avg_act * (jack_gain / sample_rate);
     }
 
-    int pts = flash_data->hdr.wiggle_points;
+    auto jackknife_ci = [blocks](const QVector<float> &estimates) {
+        float mean = std::accumulate(estimates.begin(), estimates.end(), 0.0f) / blocks;
 
-    for (int axis = 0; axis < 3; axis++) {
-        QVector<float> gyro_deriv(pts);
-        QVector<float> actu_desired(pts);
+        float sq = 0;
 
-        for (int i = 0; i < pts; i++) {
-            actu_desired[i] = flash_data->data[i].u[axis];
+        for (float e : estimates) {
+            sq += (e - mean) * (e - mean);
         }
 
-        // Differentiate the gyro data
-        for (int i = 1; i < pts; i++) {
-            gyro_deriv[i] = flash_data->data[i].y[axis] - flash_data->data[i - 1].y[axis];
-        }
+        return 1.96f * sqrtf(sq * (blocks - 1) / blocks);
+    };
 
-        gyro_deriv[0] = flash_data->data[0].y[axis] - flash_data->data[pts - 1].y[axis];
+    for (int i = 0; i < pts; i++) {
+        gyro_deriv[i] = gyro_deriv[i] - avg;
+    }
 
-        float sample_tau = getSampleDelay(pts, gyro_deriv, actu_desired,
-                (axis == 2) ? 8 : 4);
+    for (int i = 0; i < pts; i++) {
+        actu_desired[i] = (actu_desired[i] - avg_act) * (gain / sample_rate);
+    }
 
-        float tau = sample_tau / flash_data->hdr.sample_rate;
+    ident.model.reserve(pts);
+    ident.actual.reserve(pts);
 
-        biquadFilter(1 / (sample_tau * M_PI * 1.414), pts, actu_desired);
+    for (int i = 0; i < pts; i++) {
+        int tm = (i * 1000) / flash_data->hdr.sample_rate;
 
-        QVector<float> gyro_sorted = gyro_deriv;
-        QVector<float> actu_sorted = actu_desired;
+        ident.model.append(QPointF(tm, actu_desired[i]));
+        ident.actual.append(QPointF(tm, gyro_deriv[i]));
+    }
 
-        std::sort(gyro_sorted.begin(), gyro_sorted.end());
-        std::sort(actu_sorted.begin(), actu_sorted.end());
+    double noise = 0;
 
-        int low_idx = pts * 0.05 + 0.5;
-        int high_idx = pts - 1 - low_idx;
+    for (int i = 0; i < pts; i++) {
+        noise += (actu_desired[i] - gyro_deriv[i]) * (actu_desired[i] - gyro_deriv[i]);
+    }
 
-        float gyro_span = gyro_sorted[high_idx] - gyro_sorted[low_idx];
-        float actu_span = actu_sorted[high_idx] - actu_sorted[low_idx];
+    noise = sqrt(noise / pts);
 
-        float gain = gyro_span / actu_span * flash_data->hdr.sample_rate;
+    ident.tau = tau;
+    ident.beta = log(gain);
+    ident.bias = bias;
+    ident.noise = noise;
 
-        float avg = std::accumulate(gyro_deriv.begin(), gyro_deriv.end(), 0.0f) / pts;
+    ident.tauCI = 0.5f / sample_rate;
+    ident.betaCI = jackknife_ci(jack_beta);
+    ident.biasCI = jackknife_ci(jack_bias);
 
-        for (int i = 0; i < pts; i++) {
-            gyro_deriv[i] = gyro_deriv[i] - avg;
-        }
+    qDebug() << "Series " << axis << ": tau=" << tau << "; gain=" << gain << " (" << ident.beta
+             << " +/- " << ident.betaCI << "); bias=" << bias << " +/- " << ident.biasCI
+             << " noise=" << noise << "";
 
-        float avg_act = std::accumulate(actu_desired.begin(), actu_desired.end(), 0.0f) / pts;
+    return ident;
+}
 
-        for (int i = 0; i < pts; i++) {
-            actu_desired[i] = (actu_desired[i] - avg_act) * (gain / flash_data->hdr.sample_rate);
-        }
+/* Identifies all three axes from a downloaded capture.  Touches nothing but
+ * its argument, so it can run off the UI thread.
+ */
+AutotuneBeginningPage::Identification AutotuneBeginningPage::identify(QByteArray data)
+{
+    Identification result;
 
-        tuneState->model[axis] = new QLineSeries(this);
-        tuneState->actual[axis] = new QLineSeries(this);
+    result.valid = false;
 
-        for (int i = 0; i < pts; i++) {
-            int tm = (i * 1000) / flash_data->hdr.sample_rate;
+    const at_flash *flash_data = reinterpret_cast<const at_flash *>(data.constData());
 
-            tuneState->model[axis]->append(tm, actu_desired[i]);
-            tuneState->actual[axis]->append(tm, gyro_deriv[i]);
-        }
+    unsigned int size = data.size();
 
-        float bias = avg - avg_act * (gain / flash_data->hdr.sample_rate);
+    /* Determine whether we have a sane amount of data, etc. */
+    if ((size < sizeof(at_flash)) || (flash_data->hdr.magic != ATFLASH_MAGIC)) {
+        return result;
+    }
 
-        double noise = 0;
+    unsigned int size_expected = sizeof(at_flash)
+        + sizeof(at_measurement) * flash_data->hdr.wiggle_points + flash_data->hdr.aux_data_len;
 
-        for (int i = 0; i < pts; i++) {
-            noise += (actu_desired[i] - gyro_deriv[i]) * (actu_desired[i] - gyro_deriv[i]);
-        }
+    if (size < size_expected) {
+        return result;
+    }
 
-        noise = sqrt(noise / pts);
+    float duration = (float)flash_data->hdr.wiggle_points / flash_data->hdr.sample_rate;
 
-        qDebug() << "Series " << axis << ": tau=" << tau << "; gain=" << gain << " (" << log(gain)
-                 << "); bias=" << bias << " noise=" << noise << "";
+    if ((duration < 0.25f) || (duration > 30.0f)) {
+        return result;
+    }
 
-        tuneState->tau[axis] = tau;
-        tuneState->beta[axis] = log(gain);
-        tuneState->bias[axis] = bias;
-        tuneState->noise[axis] = noise;
+    int pts = flash_data->hdr.wiggle_points;
+
+    // The correlation is done with a radix 2 FFT
+    if (pts & (pts - 1)) {
+        return result;
+    }
+
+    QList<int> axes = { 0, 1, 2 };
+
+    QList<AxisIdentification> idents = QtConcurrent::blockingMapped<QList<AxisIdentification>>(axes,
+            [flash_data](int axis) { return identifyAxis(flash_data, axis); });
+
+    for (int axis = 0; axis < 3; axis++) {
+        result.axis[axis] = idents[axis];
     }
 
-    tuneState->valid = true;
+    result.valid = true;
 
-    return true;
+    return result;
 }
@@ -36,6 +36,7 @@
 #include "systemident.h"
 
 #include <QChart>
+#include <QFutureWatcher>
 #include <QLineSeries>
 #include <QTimer>
 #include <QWidget>
@@ -63,6 +64,11 @@ struct AutotunedValues
     float bias[3];
     float noise[3];
 
+    // Half widths of the 95% confidence intervals on the above
+    float tauCI[3];
+    float betaCI[3];
+    float biasCI[3];
+
     // Inputs
     float damping;
     float noiseSens;
@@ -114,7 +120,7 @@ private:
      * for now this is at least encapsulated and won't get tainted
      * elsewhere
      */
-    const uint64_t ATFLASH_MAGIC = 0x656e755480008041;
+    static const uint64_t ATFLASH_MAGIC = 0x656e755480008041;
 
     struct at_flash_header
     {
@@ -140,13 +146,37 @@ private:
         struct at_measurement data[];
     };
 
-    bool processAutotuneData();
-    void biquadFilter(float cutoff, int pts, QVector<float> &data);
-    float getSampleDelay(int pts, const QVector<float> &delayed,
+    /* What the identification of one axis found.  Computed away from the
+     * UI thread, so it holds plain points rather than chart series.
+     */
+    struct AxisIdentification
+    {
+        float tau, beta, bias, noise;
+        float tauCI, betaCI, biasCI;
+
+        QVector<QPointF> model;
+        QVector<QPointF> actual;
+    };
+
+    struct Identification
+    {
+        bool valid;
+
+        AxisIdentification axis[3];
+    };
+
+    QFutureWatcher<Identification> identifyWatcher;
+
+    static Identification identify(QByteArray data);
+    static AxisIdentification identifyAxis(const at_flash *flash_data, int axis);
+    static void biquadFilter(float cutoff, int pts, QVector<float> &data);
+    static float getSampleDelay(int pts, const QVector<float> &delayed,
             const QVector<float> &orig, int seriesCutoff = 4);
+    static float percentileSpan(QVector<float> data);
 
 private slots:
     void doDownloadAndProcess();
+    void identificationDone();
 
 };
 
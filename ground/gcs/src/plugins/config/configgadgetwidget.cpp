@@ -70,12 +70,47 @@ ConfigGadgetWidget::ConfigGadgetWidget(QWidget *parent)
 
     help = nullptr;
     chunk = 0;
+    loadScheduled = true;
     lastTabIndex = ConfigGadgetWidget::hardware;
 
     QTimer::singleShot(500, this, &ConfigGadgetWidget::deferredLoader);
 }
 
+/**
+ * Builds the next page, and schedules the one after.  Past the hardware
+ * tab, the pages aren't built until the gadget is first shown, so a GCS
+ * started on another workspace doesn't pay for them up front.
+ */
 void ConfigGadgetWidget::deferredLoader()
+{
+    loadScheduled = false;
+
+    if (chunk > LAST_CHUNK || (chunk > 1 && !isVisible()))
+        return;
+
+    loadChunk();
+    scheduleLoad();
+}
+
+void ConfigGadgetWidget::scheduleLoad()
+{
+    if (loadScheduled || chunk > LAST_CHUNK)
+        return;
+
+    loadScheduled = true;
+    QTimer::singleShot(0, this, &ConfigGadgetWidget::deferredLoader);
+}
+
+/**
+ * Builds every page not built yet, for when one is needed right away
+ */
+void ConfigGadgetWidget::finishLoading()
+{
+    while (chunk <= LAST_CHUNK)
+        loadChunk();
+}
+
+void ConfigGadgetWidget::loadChunk()
 {
     QIcon *icon;
     QWidget *qwd;
@@ -208,8 +243,7 @@ void ConfigGadgetWidget::deferredLoader()
         ftw->setHidden(ConfigGadgetWidget::radio, true);
         break;
 
-    case 13:
-    default:
+    case LAST_CHUNK:
         // *********************
         // Listen to autopilot connection events
 
@@ -227,25 +261,30 @@ void ConfigGadgetWidget::deferredLoader()
 
         connect(ftw, &MyTabbedStackWidget::currentAboutToShow, this,
                 &ConfigGadgetWidget::tabAboutToChange); //,Qt::BlockingQueuedConnection);
-        return;
+        break;
     }
 
     chunk++;
-
-    QTimer::singleShot(0, this, &ConfigGadgetWidget::deferredLoader);
 }
 
 void ConfigGadgetWidget::paintEvent(QPaintEvent *event)
 {
     (void)event;
 
-    if (chunk < 12) {
+    if (chunk < LAST_CHUNK - 1) {
         // jumpstart loading.
-        deferredLoader();
-        deferredLoader();
+        loadChunk();
+        loadChunk();
     }
 }
 
+void ConfigGadgetWidget::showEvent(QShowEvent *event)
+{
+    QWidget::showEvent(event);
+
+    scheduleLoad();
+}
+
 ConfigGadgetWidget::~ConfigGadgetWidget()
 {
     // TODO: properly delete all the tabs in ftw before exiting
@@ -253,6 +292,7 @@ ConfigGadgetWidget::~ConfigGadgetWidget()
 
 void ConfigGadgetWidget::startInputWizard()
 {
+    finishLoading();
     ftw->setCurrentIndex(ConfigGadgetWidget::input);
     ConfigInputWidget *inputWidget =
         dynamic_cast<ConfigInputWidget *>(ftw->getWidget(ConfigGadgetWidget::input));
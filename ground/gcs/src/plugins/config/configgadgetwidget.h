@@ -44,6 +44,10 @@ class ConfigGadgetWidget : public QWidget
     Q_OBJECT
     QTextBrowser *help;
     int chunk;
+    bool loadScheduled;
+
+    //! The step of deferredLoader that finishes setting up
+    static const int LAST_CHUNK = 13;
 
 public:
     ConfigGadgetWidget(QWidget *parent = nullptr);
@@ -78,9 +82,14 @@ signals:
 protected:
     void resizeEvent(QResizeEvent *event);
     void paintEvent(QPaintEvent *event);
+    void showEvent(QShowEvent *event);
     MyTabbedStackWidget *ftw;
 
 private:
+    void scheduleLoad();
+    void finishLoading();
+    void loadChunk();
+
     UAVDataObject *oplinkStatusObj;
     int lastTabIndex;
     // A timer that timesout the connction to the OPLink.
@@ -530,6 +530,13 @@ void ConfigOutputWidget::refreshWidgetRanges()
                     // only the timer period provides bounding
                     maxPulseWidth = timerPeriodUs;
                     break;
+                case RATE_ONESHOT125:
+                case RATE_ONESHOT42:
+                case RATE_MULTISHOT:
+                    // set as 1000-2000us and scaled by the firmware
+                    minPulseWidth = 1000;
+                    maxPulseWidth = 2000;
+                    break;
                 case RATE_DSHOT300:
                 case RATE_DSHOT600:
                 case RATE_DSHOT1200:
@@ -621,6 +628,9 @@ QString ConfigOutputWidget::timerFreqToString(quint32 freq) const
 {
     static const QMap<quint32, QString> mapping{
         { RATE_SYNCPWM, tr("SyncPWM") },
+        { RATE_ONESHOT125, tr("Oneshot125") },
+        { RATE_ONESHOT42, tr("Oneshot42") },
+        { RATE_MULTISHOT, tr("Multishot") },
         { RATE_DSHOT300, tr("Dshot300") },
         { RATE_DSHOT600, tr("Dshot600") },
         { RATE_DSHOT1200, tr("Dshot1200") },
@@ -632,6 +642,9 @@ quint32 ConfigOutputWidget::timerStringToFreq(QString str) const
 {
     static const QMap<QString, quint32> mapping{
         { tr("SyncPWM"), RATE_SYNCPWM },
+        { tr("Oneshot125"), RATE_ONESHOT125 },
+        { tr("Oneshot42"), RATE_ONESHOT42 },
+        { tr("Multishot"), RATE_MULTISHOT },
         { tr("Dshot300"), RATE_DSHOT300 },
         { tr("Dshot600"), RATE_DSHOT600 },
         { tr("Dshot1200"), RATE_DSHOT1200 },
@@ -50,6 +50,9 @@ public:
 private:
     enum SpecialOutputRates {
         RATE_SYNCPWM = 0,
+        RATE_ONESHOT125 = 65529,
+        RATE_ONESHOT42 = 65530,
+        RATE_MULTISHOT = 65531,
         RATE_DSHOT300 = 65532,
         RATE_DSHOT600 = 65533,
         RATE_DSHOT1200 = 65534,
@@ -360,7 +360,7 @@ void ConfigVehicleTypeWidget::switchAirframeType(int index)
  */
 void ConfigVehicleTypeWidget::showEvent(QShowEvent *event)
 {
-    Q_UNUSED(event)
+    ConfigTaskWidget::showEvent(event);
     // Thit fitInView method should only be called now, once the
     // widget is shown, otherwise it cannot compute its values and
     // the result is usually a ahrsbargraph that is way too small.
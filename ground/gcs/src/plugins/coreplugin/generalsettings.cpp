@@ -48,6 +48,8 @@ GeneralSettings::GeneralSettings()
     , m_dialog(nullptr)
     , m_proxyType(QNetworkProxy::NoProxy)
     , m_proxyPort(0)
+    , m_telemetryHubPort(0)
+    , m_telemetryHubRate(10)
 {
 }
 
@@ -134,6 +136,9 @@ QWidget *GeneralSettings::createPage(QWidget *parent)
     m_page->hostNameLE->setText(m_proxyHostname);
     m_page->userLE->setText(m_proxyUser);
     m_page->passwordLE->setText(m_proxyPassword);
+    m_page->telemetryKeyLE->setText(m_telemetryKey);
+    m_page->telemetryHubPortSB->setValue(m_telemetryHubPort);
+    m_page->telemetryHubRateSB->setValue(m_telemetryHubRate);
 
     return w;
 }
@@ -153,6 +158,9 @@ void GeneralSettings::apply()
     m_proxyHostname = m_page->hostNameLE->text();
     m_proxyUser = m_page->userLE->text();
     m_proxyPassword = m_page->passwordLE->text();
+    m_telemetryKey = m_page->telemetryKeyLE->text().trimmed();
+    m_telemetryHubPort = m_page->telemetryHubPortSB->value();
+    m_telemetryHubRate = m_page->telemetryHubRateSB->value();
     QNetworkProxy::setApplicationProxy(getNetworkProxy());
     emit generalSettingsChanged();
 }
@@ -185,6 +193,9 @@ void GeneralSettings::readSettings(QSettings *qs)
     m_motors = qs->value(QLatin1String("motors"), "").toString();
     m_escs = qs->value(QLatin1String("escs"), "").toString();
     m_props = qs->value(QLatin1String("props"), "").toString();
+    m_telemetryKey = qs->value(QLatin1String("TelemetryKey"), "").toString();
+    m_telemetryHubPort = qs->value(QLatin1String("TelemetryHubPort"), m_telemetryHubPort).toInt();
+    m_telemetryHubRate = qs->value(QLatin1String("TelemetryHubRate"), m_telemetryHubRate).toInt();
     qs->endGroup();
     emit generalSettingsChanged();
 }
@@ -217,6 +228,9 @@ void GeneralSettings::saveSettings(QSettings *qs)
     qs->setValue(QLatin1String("motors"), m_motors);
     qs->setValue(QLatin1String("escs"), m_escs);
     qs->setValue(QLatin1String("props"), m_props);
+    qs->setValue(QLatin1String("TelemetryKey"), m_telemetryKey);
+    qs->setValue(QLatin1String("TelemetryHubPort"), m_telemetryHubPort);
+    qs->setValue(QLatin1String("TelemetryHubRate"), m_telemetryHubRate);
     qs->endGroup();
 }
 
@@ -370,6 +384,21 @@ QString GeneralSettings::getProps()
     return m_props;
 }
 
+/**
+ * @brief The key for secured telemetry
+ * @return the 16 bytes of key, or empty if there is none or it isn't
+ * 32 hex digits
+ */
+QByteArray GeneralSettings::telemetryKey() const
+{
+    QByteArray key = QByteArray::fromHex(m_telemetryKey.toLatin1());
+
+    if (m_telemetryKey.length() != 32 || key.size() != 16)
+        return QByteArray();
+
+    return key;
+}
+
 void GeneralSettings::slotAutoConnect(int value)
 {
     if (value == Qt::Checked)
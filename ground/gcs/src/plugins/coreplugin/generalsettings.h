@@ -82,6 +82,9 @@ namespace Internal {
         QString getESCs();
         void setProps(QString props);
         QString getProps();
+        QByteArray telemetryKey() const;
+        int telemetryHubPort() const { return m_telemetryHubPort; }
+        int telemetryHubRate() const { return m_telemetryHubRate; }
     signals:
         void generalSettingsChanged();
     private slots:
@@ -116,6 +119,12 @@ namespace Internal {
         QString m_motors;
         QString m_escs;
         QString m_props;
+        //! Hex digits of the key for secured telemetry, or empty
+        QString m_telemetryKey;
+        //! Local TCP port telemetry is served again on, or 0 for none
+        int m_telemetryHubPort;
+        //! Most updates per second of each object sent to a hub client
+        int m_telemetryHubRate;
     };
 } // namespace Internal
 } // namespace Core
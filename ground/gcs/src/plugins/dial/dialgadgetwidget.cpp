@@ -76,11 +76,11 @@ void DialGadgetWidget::connectNeedles(QString object1, QString nfield1, QString
                                       QString nfield2, QString object3, QString nfield3)
 {
     if (obj1 != NULL)
-        disconnect(obj1, &UAVObject::objectUpdated, this, &DialGadgetWidget::updateNeedle1);
+        disconnect(obj1, &UAVObject::objectChanged, this, &DialGadgetWidget::updateNeedle1);
     if (obj2 != NULL)
-        disconnect(obj2, &UAVObject::objectUpdated, this, &DialGadgetWidget::updateNeedle2);
+        disconnect(obj2, &UAVObject::objectChanged, this, &DialGadgetWidget::updateNeedle2);
     if (obj3 != NULL)
-        disconnect(obj3, &UAVObject::objectUpdated, this, &DialGadgetWidget::updateNeedle3);
+        disconnect(obj3, &UAVObject::objectChanged, this, &DialGadgetWidget::updateNeedle3);
 
     ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
     UAVObjectManager *objManager = pm->getObject<UAVObjectManager>();
@@ -90,7 +90,7 @@ void DialGadgetWidget::connectNeedles(QString object1, QString nfield1, QString
         obj1 = dynamic_cast<UAVDataObject *>(objManager->getObject(object1));
         if (obj1 != NULL) {
             // qDebug() << "Connected Object 1 (" << object1 << ").";
-            connect(obj1, &UAVObject::objectUpdated, this, &DialGadgetWidget::updateNeedle1);
+            connect(obj1, &UAVObject::objectChanged, this, &DialGadgetWidget::updateNeedle1);
             if (nfield1.contains("-")) {
                 QStringList fieldSubfield = nfield1.split("-", QString::SkipEmptyParts);
                 field1 = fieldSubfield.at(0);
@@ -110,7 +110,7 @@ void DialGadgetWidget::connectNeedles(QString object1, QString nfield1, QString
         obj2 = dynamic_cast<UAVDataObject *>(objManager->getObject(object2));
         if (obj2 != NULL) {
             // qDebug() << "Connected Object 2 (" << object2 << ").";
-            connect(obj2, &UAVObject::objectUpdated, this, &DialGadgetWidget::updateNeedle2);
+            connect(obj2, &UAVObject::objectChanged, this, &DialGadgetWidget::updateNeedle2);
             if (nfield2.contains("-")) {
                 QStringList fieldSubfield = nfield2.split("-", QString::SkipEmptyParts);
                 field2 = fieldSubfield.at(0);
@@ -130,7 +130,7 @@ void DialGadgetWidget::connectNeedles(QString object1, QString nfield1, QString
         obj3 = dynamic_cast<UAVDataObject *>(objManager->getObject(object3));
         if (obj3 != NULL) {
             // qDebug() << "Connected Object 3 (" << object3 << ").";
-            connect(obj3, &UAVObject::objectUpdated, this, &DialGadgetWidget::updateNeedle3);
+            connect(obj3, &UAVObject::objectChanged, this, &DialGadgetWidget::updateNeedle3);
             if (nfield3.contains("-")) {
                 QStringList fieldSubfield = nfield3.split("-", QString::SkipEmptyParts);
                 field3 = fieldSubfield.at(0);
@@ -27,6 +27,7 @@
 #include <QDebug>
 #include <QtPlugin>
 #include "gcscontrolgadgetfactory.h"
+#include "uavtalk/telemetrymanager.h"
 #if defined(USE_SDL)
 #include "sdlgamepad/sdlgamepad.h"
 #endif
@@ -36,15 +37,24 @@
 #define CHANNEL_THROTNEUTRAL 1800
 #define CHANNEL_MIN 1000
 
+// Period of the control frames, and of the gamepad poll that drives them
+#define CONTROL_PERIOD_MS 20
+// Frames keep going this often without a gamepad, without ever getting
+// ahead of the poll when there is one
+#define CONTROL_IDLE_PERIOD_MS 30
+
 bool GCSControl::firstInstance = true;
 
 GCSControl::GCSControl()
     : hasControl(false)
+    , telMngr(nullptr)
 {
     Q_ASSERT(firstInstance); // There should only be one instance of this class
     firstInstance = false;
-    receiverActivity.setInterval(100);
-    connect(&receiverActivity, &QTimer::timeout, this, &GCSControl::receiverActivitySlot);
+    controlTimer.setInterval(CONTROL_IDLE_PERIOD_MS);
+    controlTimer.setTimerType(Qt::PreciseTimer);
+    connect(&controlTimer, &QTimer::timeout, this, &GCSControl::sendControlFrame);
+    frameClock.start();
 }
 
 void GCSControl::extensionsInitialized()
@@ -58,6 +68,9 @@ void GCSControl::extensionsInitialized()
 
     m_gcsReceiver = UAVTalkReceiver::GetInstance(objMngr);
     Q_ASSERT(m_gcsReceiver);
+
+    telMngr = pm->getObject<TelemetryManager>();
+    Q_ASSERT(telMngr);
 }
 
 GCSControl::~GCSControl()
@@ -74,6 +87,7 @@ bool GCSControl::initialize(const QStringList &arguments, QString *errorString)
 #if defined(USE_SDL)
     sdlGamepad = new SDLGamepad();
     if (sdlGamepad->init()) {
+        sdlGamepad->setTickRate(CONTROL_PERIOD_MS);
         sdlGamepad->start();
         qRegisterMetaType<QListInt16>("QListInt16");
         qRegisterMetaType<ButtonNumber>("ButtonNumber");
@@ -153,7 +167,7 @@ bool GCSControl::beginGCSControl()
     }
 
     setChannel(ManualControlSettings::CHANNELGROUPS_ARMING, -1);
-    receiverActivity.start();
+    controlTimer.start();
     return true;
 }
 
@@ -170,7 +184,7 @@ bool GCSControl::endGCSControl()
     manControlSettingsUAVO->setMetadata(metaBackup);
     manControlSettingsUAVO->updated();
     hasControl = false;
-    receiverActivity.stop();
+    controlTimer.stop();
     return true;
 }
 
@@ -181,7 +195,6 @@ bool GCSControl::setFlightMode(ManualControlSettings::FlightModePositionOptions
     manControlSettingsUAVO->setFlightModePosition(0, flightMode);
     manControlSettingsUAVO->updated();
     m_gcsReceiver->setChannel(ManualControlSettings::CHANNELGROUPS_FLIGHTMODE, CHANNEL_MIN);
-    m_gcsReceiver->updated();
     return true;
 }
 
@@ -224,19 +237,40 @@ bool GCSControl::setChannel(quint8 channeltype, float value)
         pwmValue = (value * (float)(CHANNEL_MAX - CHANNEL_NEUTRAL)) + (float)CHANNEL_NEUTRAL;
     else
         pwmValue = (value * (float)(CHANNEL_NEUTRAL - CHANNEL_MIN)) + (float)CHANNEL_NEUTRAL;
+    // Goes with the next control frame
     m_gcsReceiver->setChannel(channel, pwmValue);
-    m_gcsReceiver->updated();
     return true;
 }
 
-void GCSControl::objectsUpdated(UAVObject *obj)
+/**
+ * @brief GCSControl::sendControlFrame Sends the channels as they are now,
+ * stamped with when they were sampled
+ *
+ * Frames go straight to the link, ahead of the telemetry queue and without
+ * acks; the next frame replaces a lost one.  The gamepad poll calls this
+ * after each sample, and the timer keeps frames going when there is none.
+ */
+void GCSControl::sendControlFrame()
 {
-    qDebug() << "GCSControl::objectsUpdated"
-             << "Object" << obj->getName() << "changed outside this class";
+    if (!hasControl || !telMngr)
+        return;
+
+    // Several gadgets can pass on the same poll
+    if (lastFrame.isValid() && lastFrame.elapsed() < CONTROL_PERIOD_MS / 2)
+        return;
+
+    // 0 is for senders that don't stamp their frames
+    quint16 stamp = frameClock.elapsed();
+    m_gcsReceiver->setTimestamp(stamp ? stamp : 1);
+
+    telMngr->sendStream(m_gcsReceiver);
+
+    lastFrame.start();
+    controlTimer.start();
 }
 
-void GCSControl::receiverActivitySlot()
+void GCSControl::objectsUpdated(UAVObject *obj)
 {
-    if (m_gcsReceiver)
-        m_gcsReceiver->updated();
+    qDebug() << "GCSControl::objectsUpdated"
+             << "Object" << obj->getName() << "changed outside this class";
 }
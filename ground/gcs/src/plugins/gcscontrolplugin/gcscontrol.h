@@ -34,8 +34,11 @@
 #include "uavtalkreceiver.h"
 #include "extensionsystem/pluginmanager.h"
 #include "QTimer"
+#include <QElapsedTimer>
 #include "gcscontrolgadgetfactory.h"
 
+class TelemetryManager;
+
 class GCSCONTROLSHARED_EXPORT GCSControl : public ExtensionSystem::IPlugin
 {
     Q_OBJECT
@@ -60,6 +63,7 @@ public slots:
     bool setYaw(float value);
     bool setArming(float value);
     bool setChannel(quint8 channel, float value);
+    void sendControlFrame();
 
 private:
     ManualControlSettings *manControlSettingsUAVO;
@@ -68,7 +72,10 @@ private:
     ManualControlSettings::DataFields dataBackup;
     ManualControlSettings::Metadata metaBackup;
     bool hasControl;
-    QTimer receiverActivity;
+    TelemetryManager *telMngr;
+    QTimer controlTimer;
+    QElapsedTimer frameClock;
+    QElapsedTimer lastFrame;
 
     GCSControlGadgetFactory *mf;
 
@@ -76,7 +83,6 @@ private:
 
 private slots:
     void objectsUpdated(UAVObject *);
-    void receiverActivitySlot();
 };
 
 #endif // GCSCONTROL_H
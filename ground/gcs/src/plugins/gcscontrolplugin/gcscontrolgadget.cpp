@@ -32,8 +32,6 @@
 #include "uavobjects/uavobject.h"
 #include <QDebug>
 
-#define JOYSTICK_UPDATE_RATE 50
-
 GCSControlGadget::GCSControlGadget(QString classId, GCSControlGadgetWidget *widget, QWidget *parent,
                                    QObject *plugin)
     : IUAVGadget(classId, parent)
@@ -53,8 +51,6 @@ GCSControlGadget::GCSControlGadget(QString classId, GCSControlGadgetWidget *widg
 
     manualControlCommandUpdated(getManualControlCommand());
 
-    joystickTime.start();
-
 #if defined(USE_SDL)
     GCSControl *pl = dynamic_cast<GCSControl *>(plugin);
     connect(pl->sdlGamepad, SIGNAL(gamepads(quint8)), this, SLOT(gamepads(quint8)));
@@ -389,28 +385,29 @@ void GCSControlGadget::axesValues(QListInt16 values)
         if (channelReverse[throttleChannel] == true)
             tValue = -tValue;
 
-    if (joystickTime.elapsed() > JOYSTICK_UPDATE_RATE) {
-        joystickTime.restart();
-        // Remap RPYT to left X/Y and right X/Y depending on mode
-        // Mode 1: LeftX = Yaw, LeftY = Pitch, RightX = Roll, RightY = Throttle
-        // Mode 2: LeftX = Yaw, LeftY = THrottle, RightX = Roll, RightY = Pitch
-        // Mode 3: LeftX = Roll, LeftY = Pitch, RightX = Yaw, RightY = Throttle
-        // Mode 4: LeftX = Roll, LeftY = Throttle, RightX = Yaw, RightY = Pitch;
-        switch (controlsMode) {
-        case 1:
-            sticksChangedLocally(yValue / max, -pValue / max, rValue / max, -tValue / max, arming);
-            break;
-        case 2:
-            sticksChangedLocally(yValue / max, -tValue / max, rValue / max, -pValue / max, arming);
-            break;
-        case 3:
-            sticksChangedLocally(rValue / max, -pValue / max, yValue / max, -tValue / max, arming);
-            break;
-        case 4:
-            sticksChangedLocally(rValue / max, -tValue / max, yValue / max, -pValue / max, arming);
-            break;
-        }
+    // Remap RPYT to left X/Y and right X/Y depending on mode
+    // Mode 1: LeftX = Yaw, LeftY = Pitch, RightX = Roll, RightY = Throttle
+    // Mode 2: LeftX = Yaw, LeftY = THrottle, RightX = Roll, RightY = Pitch
+    // Mode 3: LeftX = Roll, LeftY = Pitch, RightX = Yaw, RightY = Throttle
+    // Mode 4: LeftX = Roll, LeftY = Throttle, RightX = Yaw, RightY = Pitch;
+    switch (controlsMode) {
+    case 1:
+        sticksChangedLocally(yValue / max, -pValue / max, rValue / max, -tValue / max, arming);
+        break;
+    case 2:
+        sticksChangedLocally(yValue / max, -tValue / max, rValue / max, -pValue / max, arming);
+        break;
+    case 3:
+        sticksChangedLocally(rValue / max, -pValue / max, yValue / max, -tValue / max, arming);
+        break;
+    case 4:
+        sticksChangedLocally(rValue / max, -tValue / max, yValue / max, -pValue / max, arming);
+        break;
     }
+
+    // Each poll of the gamepad goes out as it is sampled
+    if (enableSending)
+        getGcsControl()->sendControlFrame();
 }
 #endif
 
@@ -75,7 +75,6 @@ private:
     //! Set the UAVTalkReceiver object
     void setGcsReceiver(double leftX, double leftY, double rightX, double rightY, double arming);
 
-    QTime joystickTime;
     GCSControlGadgetWidget *m_widget;
     QList<int> m_context;
     UAVObject::Metadata mccInitialData;
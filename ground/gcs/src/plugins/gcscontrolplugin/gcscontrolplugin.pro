@@ -6,6 +6,7 @@ include(../../gcsplugin.pri)
 include(../../plugins/coreplugin/coreplugin.pri)
 include(../../plugins/uavobjects/uavobjects.pri)
 include(../../plugins/uavobjectutil/uavobjectutil.pri)
+include(../../plugins/uavtalk/uavtalk.pri)
 
 DEFINES += GCSCONTROL_LIBRARY
 
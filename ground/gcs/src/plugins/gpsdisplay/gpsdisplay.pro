@@ -1,6 +1,6 @@
 TEMPLATE = lib
 TARGET = GpsDisplayGadget
-QT += svg serialport
+QT += svg serialport network
 
 include(../../gcsplugin.pri)
 
@@ -8,6 +8,7 @@ include(../../libs/qwt/qwt.pri)
 
 include(../../plugins/coreplugin/coreplugin.pri)
 include(../../plugins/uavobjects/uavobjects.pri)
+include(../../plugins/uavtalk/uavtalk.pri)
 
 HEADERS += gpsdisplayplugin.h
 HEADERS += gpsconstellationwidget.h
@@ -18,6 +19,8 @@ HEADERS += buffer.h
 HEADERS += gpsdisplaygadget.h
 HEADERS += gpsdisplaywidget.h
 HEADERS += gpsdisplaygadgetfactory.h
+HEADERS += rtcmsource.h
+HEADERS += rtcminjector.h
 
 SOURCES += gpsdisplayplugin.cpp
 SOURCES += gpsconstellationwidget.cpp
@@ -28,6 +31,8 @@ SOURCES += buffer.cpp
 SOURCES += gpsdisplaygadget.cpp
 SOURCES += gpsdisplaygadgetfactory.cpp
 SOURCES += gpsdisplaywidget.cpp
+SOURCES += rtcmsource.cpp
+SOURCES += rtcminjector.cpp
 
 OTHER_FILES += GpsDisplayGadget.pluginspec
 
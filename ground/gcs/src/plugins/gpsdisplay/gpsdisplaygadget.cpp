@@ -26,6 +26,8 @@
 
 #include "gpsdisplaygadget.h"
 #include "gpsdisplaywidget.h"
+#include "rtcminjector.h"
+#include <extensionsystem/pluginmanager.h>
 
 GpsDisplayGadget::GpsDisplayGadget(QString classId, GpsDisplayWidget *widget, QWidget *parent)
     : IUAVGadget(classId, parent)
@@ -48,9 +50,54 @@ GpsDisplayGadget::GpsDisplayGadget(QString classId, GpsDisplayWidget *widget, QW
     connect(parser, SIGNAL(fixtype(QString)), m_widget, SLOT(setFixType(QString)));
     connect(parser, SIGNAL(dop(double, double, double)), m_widget,
             SLOT(setDOP(double, double, double)));
+
+    RtcmInjector *injector =
+        ExtensionSystem::PluginManager::instance()->getObject<RtcmInjector>();
+
+    if (injector) {
+        connect(&correctionSource, &RtcmSource::frameReceived, injector,
+                &RtcmInjector::injectFrame);
+        connect(injector, &RtcmInjector::statsUpdated, this, &GpsDisplayGadget::correctionStats);
+    }
+
+    connect(parser, SIGNAL(position(double, double, double)), &correctionSource,
+            SLOT(setPosition(double, double, double)));
+    connect(&correctionSource, &RtcmSource::statusChanged, m_widget->correctionStatus,
+            &QLabel::setText);
+    connect(m_widget->correctionButton, &QPushButton::toggled, this,
+            &GpsDisplayGadget::toggleCorrections);
 }
 
 GpsDisplayGadget::~GpsDisplayGadget()
 {
     delete m_widget;
 }
+
+void GpsDisplayGadget::toggleCorrections(bool start)
+{
+    if (start && !correctionSource.open(m_widget->correctionSource->text())) {
+        // Left with the reason showing
+        QSignalBlocker blocker(m_widget->correctionButton);
+        m_widget->correctionButton->setChecked(false);
+        return;
+    }
+
+    if (!start) {
+        correctionSource.close();
+        m_widget->correctionStatus->setText(tr("Stopped"));
+    }
+
+    m_widget->correctionSource->setEnabled(!start);
+    m_widget->correctionButton->setText(start ? tr("Stop") : tr("Start"));
+}
+
+void GpsDisplayGadget::correctionStats(int bytesPerSecond, int ageMs, int dropped)
+{
+    if (!correctionSource.isOpen() || !bytesPerSecond)
+        return;
+
+    m_widget->correctionStatus->setText(tr("Sending %1 B/s, %2 ms old, %3 dropped")
+                                            .arg(bytesPerSecond)
+                                            .arg(ageMs)
+                                            .arg(dropped));
+}
@@ -32,6 +32,7 @@
 #include <coreplugin/iuavgadget.h>
 #include "gpsdisplaywidget.h"
 #include "telemetryparser.h"
+#include "rtcmsource.h"
 
 class IUAVGadget;
 class QWidget;
@@ -49,9 +50,14 @@ public:
 
     QWidget *widget() { return m_widget; }
 
+private slots:
+    void toggleCorrections(bool start);
+    void correctionStats(int bytesPerSecond, int ageMs, int dropped);
+
 private:
     QPointer<GpsDisplayWidget> m_widget;
     QPointer<GPSParser> parser;
+    RtcmSource correctionSource;
     bool connected;
     void processNewSerialData(QByteArray serialData);
 };
@@ -26,6 +26,7 @@
 
 #include "gpsdisplayplugin.h"
 #include "gpsdisplaygadgetfactory.h"
+#include "rtcminjector.h"
 #include <QDebug>
 #include <QtPlugin>
 #include <QStringList>
@@ -48,6 +49,9 @@ bool GpsDisplayPlugin::initialize(const QStringList &args, QString *errMsg)
     mf = new GpsDisplayGadgetFactory(this);
     addAutoReleasedObject(mf);
 
+    // One for all the gadgets, so that two sources share the link's budget
+    addAutoReleasedObject(new RtcmInjector(this));
+
     return true;
 }
 
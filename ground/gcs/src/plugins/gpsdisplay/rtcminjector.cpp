@@ -0,0 +1,242 @@
+/**
+ ******************************************************************************
+ *
+ * @file       rtcminjector.cpp
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2017
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup GPSGadgetPlugin GPS Gadget Plugin
+ * @{
+ * @brief Sends RTCM3 corrections up to the GPS on the aircraft
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "rtcminjector.h"
+
+#include "extensionsystem/pluginmanager.h"
+#include "uavobjects/uavobjectmanager.h"
+#include "uavtalk/telemetrymanager.h"
+#include "gpscorrection.h"
+
+#include <string.h>
+
+#define SEND_PERIOD_MS 20
+#define STATS_PERIOD_MS 1000
+// A frame seen again within this long is taken to be the same one
+#define DUPLICATE_WINDOW_MS 1000
+// Observations older than this only confuse the receiver's solution
+#define DEFAULT_MAX_AGE_MS 2000
+// Leaves most of a 57600 baud radio to the rest of the telemetry
+#define DEFAULT_BYTE_RATE 1000
+// Longest RTCM3 frame, which the budget must allow to go at once
+#define RTCM3_MAX_FRAME (1023 + 6)
+// Ahead of the observations, the others must not pile up without bound
+#define MAX_QUEUED_FRAMES 64
+
+RtcmInjector::RtcmInjector(QObject *parent)
+    : QObject(parent)
+    , telMngr(nullptr)
+    , correctionObj(nullptr)
+    , currentOffset(0)
+    , sequence(0)
+    , byteRate(DEFAULT_BYTE_RATE)
+    , maxAgeMs(DEFAULT_MAX_AGE_MS)
+    , budget(RTCM3_MAX_FRAME)
+    , lastRefill(0)
+    , sentBytes(0)
+    , dropped(0)
+    , lastAgeMs(0)
+{
+    clock.start();
+
+    sendTimer.setInterval(SEND_PERIOD_MS);
+    connect(&sendTimer, &QTimer::timeout, this, &RtcmInjector::sendPending);
+
+    statsTimer.setInterval(STATS_PERIOD_MS);
+    connect(&statsTimer, &QTimer::timeout, this, &RtcmInjector::updateStats);
+    statsTimer.start();
+}
+
+/**
+ * @brief RtcmInjector::setByteRate Sets how much of the link corrections may
+ * take
+ */
+void RtcmInjector::setByteRate(int bytesPerSecond)
+{
+    byteRate = qMax(bytesPerSecond, 1);
+}
+
+/**
+ * @brief RtcmInjector::injectFrame Queues a whole RTCM3 frame to go up
+ */
+void RtcmInjector::injectFrame(const QByteArray &frame)
+{
+    qint64 now = clock.elapsed();
+
+    for (auto i = recentFrames.begin(); i != recentFrames.end();) {
+        if (now - i.value() > DUPLICATE_WINDOW_MS)
+            i = recentFrames.erase(i);
+        else
+            ++i;
+    }
+
+    uint hash = qHash(frame);
+
+    if (recentFrames.contains(hash))
+        return;
+
+    recentFrames.insert(hash, now);
+
+    QQueue<PendingFrame> &queue = isObservation(frame) ? observations : others;
+
+    if (queue.size() >= MAX_QUEUED_FRAMES) {
+        queue.dequeue();
+        dropped++;
+    }
+
+    queue.enqueue({ frame, now });
+
+    if (!sendTimer.isActive()) {
+        // Spent nothing while idle, but can't save up beyond one frame
+        lastRefill = now;
+        sendTimer.start();
+        sendPending();
+    }
+}
+
+/**
+ * @brief RtcmInjector::isObservation Whether a frame carries observations,
+ * legacy or MSM, or the GLONASS biases that go with them
+ */
+bool RtcmInjector::isObservation(const QByteArray &frame)
+{
+    if (frame.size() < 5)
+        return false;
+
+    const quint8 *f = reinterpret_cast<const quint8 *>(frame.constData());
+    int type = (f[3] << 4) | (f[4] >> 4);
+
+    return (type >= 1001 && type <= 1004) || (type >= 1009 && type <= 1012)
+        || (type >= 1071 && type <= 1137) || type == 1230;
+}
+
+void RtcmInjector::dropStale()
+{
+    qint64 now = clock.elapsed();
+
+    while (!observations.isEmpty() && now - observations.head().received > maxAgeMs) {
+        observations.dequeue();
+        dropped++;
+    }
+}
+
+void RtcmInjector::sendPending()
+{
+    qint64 now = clock.elapsed();
+
+    budget = qMin(budget + (now - lastRefill) * byteRate / 1000.0, double(RTCM3_MAX_FRAME));
+    lastRefill = now;
+
+    if (!telMngr) {
+        ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
+
+        telMngr = pm->getObject<TelemetryManager>();
+        correctionObj = GPSCorrection::GetInstance(pm->getObject<UAVObjectManager>());
+
+        if (!telMngr || !correctionObj)
+            return;
+    }
+
+    while (true) {
+        if (current.data.isEmpty()) {
+            // Only between frames, so the aircraft never sees one cut short
+            dropStale();
+
+            if (!observations.isEmpty())
+                current = observations.dequeue();
+            else if (!others.isEmpty())
+                current = others.dequeue();
+            else
+                break;
+
+            currentOffset = 0;
+            sequence++;
+        }
+
+        if (budget < qMin(current.data.size() - currentOffset, int(GPSCorrection::DATA_NUMELEM)))
+            return;
+
+        if (!sendFragment()) {
+            // Not connected; what is waiting will be stale by the time it is
+            current.data.clear();
+            observations.clear();
+            others.clear();
+            break;
+        }
+    }
+
+    sendTimer.stop();
+}
+
+/**
+ * @brief RtcmInjector::sendFragment Sends the next part of the current frame
+ * @return false if it couldn't be sent
+ */
+bool RtcmInjector::sendFragment()
+{
+    GPSCorrection *obj = static_cast<GPSCorrection *>(correctionObj);
+    GPSCorrection::DataFields data = obj->getData();
+
+    int fragments = (current.data.size() + GPSCorrection::DATA_NUMELEM - 1)
+        / GPSCorrection::DATA_NUMELEM;
+    int len = qMin(current.data.size() - currentOffset, int(GPSCorrection::DATA_NUMELEM));
+
+    data.Sequence = sequence;
+    data.Fragment = currentOffset / GPSCorrection::DATA_NUMELEM;
+    data.Fragments = fragments;
+    data.Length = len;
+    memset(data.Data, 0, sizeof(data.Data));
+    memcpy(data.Data, current.data.constData() + currentOffset, len);
+
+    obj->setData(data);
+
+    if (!telMngr->sendStream(obj))
+        return false;
+
+    if (currentOffset == 0)
+        lastAgeMs = clock.elapsed() - current.received;
+
+    currentOffset += len;
+    budget -= len;
+    sentBytes += len;
+
+    if (currentOffset >= current.data.size())
+        current.data.clear();
+
+    return true;
+}
+
+void RtcmInjector::updateStats()
+{
+    emit statsUpdated(sentBytes * 1000 / STATS_PERIOD_MS, lastAgeMs, dropped);
+
+    sentBytes = 0;
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,111 @@
+/**
+ ******************************************************************************
+ *
+ * @file       rtcminjector.h
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2017
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup GPSGadgetPlugin GPS Gadget Plugin
+ * @{
+ * @brief Sends RTCM3 corrections up to the GPS on the aircraft
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef RTCMINJECTOR_H
+#define RTCMINJECTOR_H
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QObject>
+#include <QQueue>
+#include <QTimer>
+
+class UAVObject;
+class TelemetryManager;
+
+/**
+ * @brief The RtcmInjector class Sends corrections up in GPSCorrection
+ * fragments, straight to UAVTalk instead of through the telemetry queue.
+ *
+ * Observations go ahead of station and ephemeris messages, and are
+ * dropped once they are too old to be of use.  Frames seen twice in a
+ * short time, as when two sources carry the same base station, go up
+ * once.  The bytes sent are held to a budget, so that the rest of the
+ * telemetry still gets through on a slow link.  There is one of these,
+ * shared by all the sources.
+ */
+class RtcmInjector : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit RtcmInjector(QObject *parent = nullptr);
+
+    void setByteRate(int bytesPerSecond);
+    void setMaxAge(int ms) { maxAgeMs = ms; }
+
+public slots:
+    void injectFrame(const QByteArray &frame);
+
+signals:
+    void statsUpdated(int bytesPerSecond, int ageMs, int dropped);
+
+private slots:
+    void sendPending();
+    void updateStats();
+
+private:
+    struct PendingFrame
+    {
+        QByteArray data;
+        qint64 received; /** On clock */
+    };
+
+    static bool isObservation(const QByteArray &frame);
+    bool sendFragment();
+    void dropStale();
+
+    TelemetryManager *telMngr;
+    UAVObject *correctionObj;
+
+    QQueue<PendingFrame> observations;
+    QQueue<PendingFrame> others;
+    QHash<uint, qint64> recentFrames; /** Hash of each frame to when it came */
+
+    PendingFrame current; /** Frame being sent, if data isn't empty */
+    int currentOffset;
+    quint8 sequence;
+
+    QTimer sendTimer;
+    QTimer statsTimer;
+    QElapsedTimer clock;
+    int byteRate;
+    int maxAgeMs;
+    double budget; /** Bytes that may be sent now */
+    qint64 lastRefill;
+
+    int sentBytes; /** Since the last stats */
+    int dropped;
+    int lastAgeMs;
+};
+
+#endif // RTCMINJECTOR_H
+
+/**
+ * @}
+ * @}
+ */
@@ -27,8 +27,14 @@
 #include <QMessageBox>
 #include <QTextStream>
 #include <QtGlobal>
+#include <QtEndian>
+#include <QFileInfo>
+#include <QDateTime>
+
+#include <string.h>
 
 #include <coreplugin/coreconstants.h>
+#include <coreplugin/icore.h>
 #include "utils/coordinateconversions.h"
 #include "uavobjects/uavobjectsinit.h"
 #include "uavobjects/uavobjectmanager.h"
@@ -45,8 +51,16 @@ const double ColorMap_Jet[256][3] = COLORMAP_JET;
 #define numberOfWallAxes 5 // Number of wall axes to plot. This shouldn't be hardcoded
 #define wallAxesSeparation 20 // Wall axes separation height in [m]. This shouldn't be hardcoded
 
-KmlExport::KmlExport(QString inputLogFileName, QString outputKmlFileName)
-    : outputFileName(outputKmlFileName)
+KmlExport::KmlExport(QString inputLogFileName, QString outputKmlFileName, int minTrackInterval,
+                     int minTrackDistance)
+    : output(nullptr)
+    , outputFileName(outputKmlFileName)
+    , haveOldPoint(false)
+    , oldPointTime(0)
+    , timeStamp(0)
+    , lastPlacemarkTime(0)
+    , minTrackInterval(minTrackInterval)
+    , minTrackDistance(minTrackDistance)
 {
     logFile.setFileName(inputLogFileName);
 
@@ -54,9 +68,6 @@ KmlExport::KmlExport(QString inputLogFileName, QString outputKmlFileName)
     UAVObjectManager *kmlUAVObjectManager = new UAVObjectManager;
     UAVObjectsInitialize(kmlUAVObjectManager);
 
-    // Connect new UAVO manager to a UAVTalk instance
-    kmlTalk = new UAVTalk(&logFile, kmlUAVObjectManager);
-
     // Get the UAVObjects
     airspeedActual = AirspeedActual::GetInstance(kmlUAVObjectManager);
     attitudeActual = AttitudeActual::GetInstance(kmlUAVObjectManager);
@@ -65,6 +76,13 @@ KmlExport::KmlExport(QString inputLogFileName, QString outputKmlFileName)
     positionActual = PositionActual::GetInstance(kmlUAVObjectManager);
     velocityActual = VelocityActual::GetInstance(kmlUAVObjectManager);
 
+    // Only these are decoded; every other packet in the log is skipped over
+    QList<UAVObject *> objects;
+    objects << airspeedActual << attitudeActual << gpsPosition << homeLocation << positionActual
+            << velocityActual;
+    foreach (UAVObject *obj, objects)
+        logObjects.insert(obj->getObjID(), obj);
+
     homeLocationData = homeLocation->getData();
     gpsPositionData = gpsPosition->getData();
 
@@ -80,26 +98,6 @@ KmlExport::KmlExport(QString inputLogFileName, QString outputKmlFileName)
     // Get the factory singleton to create KML elements.
     factory = KmlFactory::GetFactory();
 
-    // Create <Document>
-    document = factory->CreateDocument();
-
-    // Create folders
-    timestampFolder = factory->CreateFolder();
-    timestampFolder->set_name("Arrows");
-
-    trackFolder = factory->CreateFolder();
-    trackFolder->set_name("Track");
-
-    // Create custom styles. Add as document's first elements
-    StyleMapPtr styleCBS = createCustomBalloonStyle();
-    document->add_styleselector(styleCBS);
-
-    StylePtr styleGT = createGroundTrackStyle();
-    document->add_styleselector(styleGT);
-
-    StyleMapPtr wallAxesStyle = createWallAxesStyle();
-    document->add_styleselector(wallAxesStyle);
-
     // Create an array of lines which will make the wall axes.
     for (int i = 0; i < numberOfWallAxes; i++) {
         CoordinatesPtr coordinates = factory->CreateCoordinates();
@@ -118,21 +116,59 @@ bool KmlExport::exportToKML()
         return false;
     }
 
-    // Parses logfile and generates KML document
-    ret = preparseLogFile();
-    if (!ret) {
-        qDebug() << "Logfile preparsing failed";
+    // A KML file is written as it goes. A KMZ has to be zipped in one go, so
+    // the text is kept until the end; it is still far smaller than the DOM.
+    QString suffix = QFileInfo(outputFileName).suffix().toLower();
+    QFile kmlFile(outputFileName);
+    QBuffer kmzBuffer;
+
+    if (suffix == "kmz") {
+        kmzBuffer.open(QIODevice::WriteOnly);
+        output = &kmzBuffer;
+    } else if (suffix == "kml") {
+        if (!kmlFile.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            qDebug() << "KML write failed: " << outputFileName;
+            QMessageBox::critical(Core::ICore::instance()->mainWindow(), "KML write failed",
+                                  "Failed to write KML file.");
+            stopExport();
+            return false;
+        }
+        output = &kmlFile;
+    } else {
+        qDebug() << "Write failed. Invalid file name:" << outputFileName;
+        QMessageBox::critical(Core::ICore::instance()->mainWindow(), "Write failed",
+                              "Failed to write file. Invalid filename");
+        stopExport();
         return false;
     }
 
-    // Call parser.
-    parseLogFile();
+    output->write("<?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
+                  "<kml xmlns=\"http://www.opengis.net/kml/2.2\">\n"
+                  "<Document>\n");
+
+    // Custom styles are the document's first elements
+    writeElement(createCustomBalloonStyle());
+    writeElement(createGroundTrackStyle());
+    writeElement(createWallAxesStyle());
 
-    // Add track to <Document>
-    document->add_feature(trackFolder);
+    // Parses logfile, writing out the track as it goes
+    output->write("<Folder>\n<name>Track</name>\n");
+    ret = parseLogFile();
+    output->write("</Folder>\n");
+
+    if (!ret) {
+        qDebug() << "Logfile has no data to export";
+        output = nullptr;
+        if (kmlFile.isOpen())
+            kmlFile.remove();
+        return false;
+    }
 
     // Add timespans to <Document>
-    document->add_feature(timestampFolder);
+    output->write("<Folder>\n<name>Arrows</name>\n");
+    output->write(arrowsKml);
+    output->write("</Folder>\n");
+    arrowsKml.clear();
 
     // Add ground track to <Document>
     {
@@ -149,7 +185,7 @@ bool KmlExport::exportToKML()
         placemark->set_styleurl("#ts_2_tb");
         placemark->set_name("Ground track");
 
-        document->add_feature(placemark);
+        writeElement(placemark);
     }
 
     // Add wall axes to <Document>
@@ -170,40 +206,40 @@ bool KmlExport::exportToKML()
         folder->add_feature(placemark);
         folder->set_name("Wall axes");
     }
-    document->add_feature(folder);
-
-    // Create <kml> and give it <Document>.
-    KmlPtr kml = factory->CreateKml();
-    kml->set_feature(document); // kml takes ownership.
+    writeElement(folder);
 
-    // Serialize to XML
-    std::string kml_data = kmldom::SerializePretty(kml);
+    output->write("</Document>\n</kml>\n");
+    output = nullptr;
 
     // Save to file
-    if (QFileInfo(outputFileName).suffix().toLower() == "kmz") {
-        if (!kmlengine::KmzFile::WriteKmz(outputFileName.toStdString().c_str(), kml_data)) {
+    if (suffix == "kmz") {
+        QByteArray kml_data = kmzBuffer.data();
+        if (!kmlengine::KmzFile::WriteKmz(outputFileName.toStdString().c_str(),
+                                          std::string(kml_data.constData(), kml_data.size()))) {
             qDebug() << "KMZ write failed: " << outputFileName;
             QMessageBox::critical(Core::ICore::instance()->mainWindow(), "KMZ write failed",
                                   "Failed to write KMZ file.");
             return false;
         }
-    } else if (QFileInfo(outputFileName).suffix().toLower() == "kml") {
-        if (!kmlbase::File::WriteStringToFile(kml_data, outputFileName.toStdString())) {
-            qDebug() << "KML write failed: " << outputFileName;
-            QMessageBox::critical(Core::ICore::instance()->mainWindow(), "KML write failed",
-                                  "Failed to write KML file.");
-            return false;
-        }
-    } else {
-        qDebug() << "Write failed. Invalid file name:" << outputFileName;
-        QMessageBox::critical(Core::ICore::instance()->mainWindow(), "Write failed",
-                              "Failed to write file. Invalid filename");
+    } else if (kmlFile.error() != QFile::NoError || !kmlFile.flush()) {
+        qDebug() << "KML write failed: " << outputFileName;
+        QMessageBox::critical(Core::ICore::instance()->mainWindow(), "KML write failed",
+                              "Failed to write KML file.");
         return false;
     }
 
     return true;
 }
 
+/**
+ * @brief KmlExport::writeElement Serializes an element to the output
+ */
+void KmlExport::writeElement(const ElementPtr &element)
+{
+    std::string xml = kmldom::SerializePretty(element);
+    output->write(xml.data(), xml.size());
+}
+
 /**
  * @brief KmlExport::open Opens the logfile and ensures it's sane
  * @return returns true if the logfile is successfully opened, returns false otherwise.
@@ -278,44 +314,64 @@ bool KmlExport::open()
 }
 
 /**
- * @brief KmlExport::preparseLogFile Ensures that the logfile has data to export
+ * @brief KmlExport::stopExport Called to stop the export. Currently only closes
+ * the logfile
+ * @return Returns true
+ */
+bool KmlExport::stopExport()
+{
+    logFile.close();
+    return true;
+}
+
+/**
+ * @brief KmlExport::parseLogFile Walks the logfile once, decoding the objects the KML is made
+ * from as it goes. The log is mapped where possible, so nothing is copied.
  * @return Returns true if the logfile has data, false otherwise
  */
-bool KmlExport::preparseLogFile()
+bool KmlExport::parseLogFile()
 {
-    // Read all log timestamps into array
-    timestampBuffer.clear(); // Save beginning of log for later use
-    timestampPos.clear();
-    quint64 logFileStartIdx = logFile.pos();
-    quint32 lastTimeStamp = 0;
+    qint64 start = logFile.pos();
+    qint64 size = logFile.size() - start;
+
+    QByteArray logCopy;
+    const uchar *logData = size > 0 ? logFile.map(start, size) : nullptr;
+
+    if (!logData) {
+        logCopy = logFile.readAll();
+        logData = reinterpret_cast<const uchar *>(logCopy.constData());
+        size = logCopy.size();
+    }
 
-    while (!logFile.atEnd()) {
-        qint64 dataSize;
+    int packets = 0;
+    bool warned = false;
+    qint64 pos = 0;
 
-        // Get time stamp position
-        timestampPos.append(logFile.pos());
+    while (pos + qint64(sizeof(quint32) + sizeof(qint64)) <= size) {
+        quint32 packetTime;
+        qint64 packetSize;
 
         // Read timestamp and logfile packet size
-        logFile.read(reinterpret_cast<char *>(&lastTimeStamp), sizeof(lastTimeStamp));
-        logFile.read(reinterpret_cast<char *>(&dataSize), sizeof(dataSize));
+        memcpy(&packetTime, logData + pos, sizeof(packetTime));
+        memcpy(&packetSize, logData + pos + sizeof(packetTime), sizeof(packetSize));
 
-        // Check if dataSize sync bytes are correct.
-        // TODO: LIKELY AS NOT, THIS WILL FAIL TO RESYNC BECAUSE THERE IS TOO LITTLE INFORMATION IN
-        // THE STRING OF SIX 0x00
-        if ((dataSize & 0xFFFFFFFFFFFF0000) != 0) {
+        // Check if packetSize sync bytes are correct, and resync if not
+        if ((packetSize & 0xFFFFFFFFFFFF0000) != 0 || packetSize < 1) {
             qDebug() << "Wrong sync byte. At file location 0x"
-                     << QString("%1").arg(logFile.pos(), 0, 16) << "Got 0x"
-                     << QString("%1").arg(dataSize & 0xFFFFFFFFFFFF0000, 0, 16)
-                     << ", but expected 0x"
-                        "00"
-                        ".";
-            logFile.seek(timestampPos.last() + 1);
-            timestampPos.pop_back();
+                     << QString("%1").arg(start + pos + sizeof(packetTime), 0, 16);
+            pos++;
             continue;
         }
 
+        qint64 end = pos + sizeof(packetTime) + sizeof(packetSize) + packetSize;
+
+        // A packet cut off at the end of the log is dropped
+        if (end > size) {
+            break;
+        }
+
         // Check if timestamps are sequential.
-        if (!timestampBuffer.isEmpty() && lastTimeStamp < timestampBuffer.last()) {
+        if (packets && packetTime < timeStamp && !warned) {
             QMessageBox msgBox(Core::ICore::instance()->mainWindow());
             msgBox.setText("Corrupted file.");
             msgBox.setInformativeText("Timestamps are not sequential. Playback may have unexpected "
@@ -323,89 +379,117 @@ bool KmlExport::preparseLogFile()
                                                    // description.
             msgBox.exec();
 
-            qDebug() << "Timestamp: " << timestampBuffer.last() << " " << lastTimeStamp;
+            qDebug() << "Timestamp: " << timeStamp << " " << packetTime;
+
+            warned = true;
         }
 
-        timestampBuffer.append(lastTimeStamp);
+        timeStamp = packetTime;
+        packets++;
+
+        decodePacket(logData + pos + sizeof(packetTime) + sizeof(packetSize), packetSize);
 
-        logFile.seek(timestampPos.last() + sizeof(lastTimeStamp) + sizeof(dataSize) + dataSize);
+        pos = end;
     }
 
+    // Closing the file unmaps it
+    stopExport();
+
     // Check if any timestamps were successfully read
-    if (timestampBuffer.size() == 0) {
+    if (packets == 0) {
         QMessageBox msgBox(Core::ICore::instance()->mainWindow());
         msgBox.setText("Empty logfile.");
         msgBox.setInformativeText("No log data can be found.");
         msgBox.exec();
 
-        stopExport();
         return false;
     }
 
-    // Reset to log beginning, including the timestamp.
-    logFile.seek(logFileStartIdx);
-
     return true;
 }
 
-/**
- * @brief KmlExport::stopExport Called to stop the export. Currently only closes
- * the logfile
- * @return Returns true
+/* UAVTalk framing, as in the UAVTalk plugin: sync, type, length (not
+ * counting the CRC), a reserved byte and the object ID, then the data and a
+ * CRC-8.  Each packet in the log holds one frame.
  */
-bool KmlExport::stopExport()
+static const quint8 UAVTALK_SYNC = 0x3C;
+static const quint8 UAVTALK_VER_MASK = 0x70;
+static const quint8 UAVTALK_TYPE_VER = 0x20;
+static const quint8 UAVTALK_TYPE_MASK = 0x0f;
+static const quint8 UAVTALK_TYPE_OBJ = 0x00;
+static const quint8 UAVTALK_TYPE_OBJ_ACK = 0x02;
+static const quint8 UAVTALK_TYPE_OBJ_BATCH = 0x0A;
+static const int UAVTALK_HEADER_LENGTH = 8;
+static const int UAVTALK_BATCH_HEADER_LENGTH = 4;
+static const int UAVTALK_BATCH_RECORD_HEADER_LENGTH = 5;
+
+static quint8 uavtalkCRC(const uchar *data, int length)
 {
-    logFile.close();
-    return true;
+    quint8 crc = 0;
+
+    while (length--) {
+        crc ^= *data++;
+
+        for (int i = 0; i < 8; i++)
+            crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : (crc << 1);
+    }
+
+    return crc;
 }
 
 /**
- * @brief KmlExport::parseLogFile Parses logfile and exports results to KML file
+ * @brief KmlExport::decodePacket Unpacks a logged frame into the object it carries, if it's one
+ * of the objects the KML needs; other frames are passed over without checking them any further.
  */
-void KmlExport::parseLogFile()
+void KmlExport::decodePacket(const uchar *packet, qint64 length)
 {
-    qint64 packetSize;
-    quint32 timeStampIdx;
+    if (length < UAVTALK_HEADER_LENGTH + 1 || packet[0] != UAVTALK_SYNC
+        || (packet[1] & UAVTALK_VER_MASK) != UAVTALK_TYPE_VER) {
+        return;
+    }
 
-    // Read packets
-    while (!logFile.atEnd()) {
-        if (logFile.bytesAvailable() < 4) {
-            break;
-        }
+    quint8 type = packet[1] & UAVTALK_TYPE_MASK;
+    quint8 frameLength = packet[2];
 
-        // Read timestamp and logfile packet size
-        logFile.read(reinterpret_cast<char *>(&timeStamp), sizeof(timeStamp));
-        logFile.read(reinterpret_cast<char *>(&packetSize), sizeof(packetSize));
+    if (frameLength < UAVTALK_HEADER_LENGTH || frameLength + 1 > length) {
+        return;
+    }
 
-        if (packetSize < 1 || packetSize > (1024 * 1024)) {
-            qDebug() << "Error: Logfile corrupted! Unlikely packet size: " << packetSize << "\n";
-            QMessageBox::critical(
-                Core::ICore::instance()->mainWindow(), "Corrupted file",
-                "Incorrect packet size. Stopping export. Data up to this point will be saved.");
+    if (type == UAVTALK_TYPE_OBJ || type == UAVTALK_TYPE_OBJ_ACK) {
+        UAVObject *obj = logObjects.value(qFromLittleEndian<quint32>(packet + 4));
 
-            break;
+        if (!obj || frameLength - UAVTALK_HEADER_LENGTH != int(obj->getNumBytes())
+            || uavtalkCRC(packet, frameLength) != packet[frameLength]) {
+            return;
         }
 
-        if (logFile.bytesAvailable() < packetSize) {
-            break;
+        obj->unpack(packet + UAVTALK_HEADER_LENGTH);
+    } else if (type == UAVTALK_TYPE_OBJ_BATCH) {
+        if (uavtalkCRC(packet, frameLength) != packet[frameLength]) {
+            return;
         }
 
-        // Read the data packet from the file.
-        QByteArray dataBuffer;
-        dataBuffer.append(logFile.read(packetSize));
+        const uchar *data = packet + UAVTALK_BATCH_HEADER_LENGTH;
+        const uchar *end = packet + frameLength;
 
-        // Parse the packet. This operation passes the data to the kmlTalk object, which internally
-        // parses the data
-        // and then emits objectUpdated(UAVObject *) signals. These signals are connected to in the
-        // KmlExport constructor.
-        for (int i = 0; i < dataBuffer.size(); i++) {
-            kmlTalk->processInputByte(dataBuffer[i]);
-        }
+        while (end - data >= UAVTALK_BATCH_RECORD_HEADER_LENGTH) {
+            UAVObject *obj = logObjects.value(qFromLittleEndian<quint32>(data));
+            quint8 recLength = data[4];
 
-        timeStampIdx++;
-    }
+            data += UAVTALK_BATCH_RECORD_HEADER_LENGTH;
 
-    stopExport();
+            if (recLength > end - data) {
+                return;
+            }
+
+            // The objects used here are all single instance
+            if (obj && recLength == obj->getNumBytes()) {
+                obj->unpack(data);
+            }
+
+            data += recLength;
+        }
+    }
 }
 
 /**
@@ -854,42 +938,47 @@ void KmlExport::positionActualUpdated(UAVObject *obj)
                                  .arg(newPoint.groundspeed));
 
     // In case this is the first time through, copy data and exit
-    static bool firstPoint;
-
-    if (firstPoint == false) {
-        oldPoint.latitude = newPoint.latitude;
-        oldPoint.longitude = newPoint.longitude;
-        oldPoint.altitude = newPoint.altitude;
-        oldPoint.groundspeed = newPoint.groundspeed;
+    if (!haveOldPoint) {
+        oldPoint = newPoint;
+        oldPointTime = timeStamp;
+        memcpy(oldNED, NED, sizeof(oldNED));
 
-        firstPoint = true;
+        haveOldPoint = true;
         return;
     }
 
+    // Thin the track out, if asked to
+    double distance = sqrt((NED[0] - oldNED[0]) * (NED[0] - oldNED[0])
+                           + (NED[1] - oldNED[1]) * (NED[1] - oldNED[1])
+                           + (NED[2] - oldNED[2]) * (NED[2] - oldNED[2]));
+
+    if (timeStamp - oldPointTime < quint32(minTrackInterval) || distance < minTrackDistance)
+        return;
+
     // Create wall axes
     for (int i = 0; i < numberOfWallAxes; i++) {
         wallAxes[i]->add_latlngalt(newPoint.latitude, newPoint.longitude,
                                    i * wallAxesSeparation + homeLocationData.Altitude);
     }
 
-    // Create colored tracks and add to the KML document
+    // Create colored tracks and write them straight out
     PlacemarkPtr newPlacemark = CreateLineStringPlacemark(oldPoint, newPoint, timeStamp);
-    trackFolder->add_feature(newPlacemark);
+    writeElement(newPlacemark);
 
     // Every 2 seconds generate a time stamp
     if (timeStamp - lastPlacemarkTime > 2000) {
 
         PlacemarkPtr newPlacemarkTimestamp =
             createTimespanPlacemark(newPoint, lastPlacemarkTime, timeStamp);
-        timestampFolder->add_feature(newPlacemarkTimestamp);
+        std::string xml = kmldom::SerializePretty(newPlacemarkTimestamp);
+        arrowsKml.append(xml.data(), xml.size());
         lastPlacemarkTime = timeStamp;
     }
 
     // Copy newPoint to oldPoint
-    oldPoint.latitude = newPoint.latitude;
-    oldPoint.longitude = newPoint.longitude;
-    oldPoint.altitude = newPoint.altitude;
-    oldPoint.groundspeed = newPoint.groundspeed;
+    oldPoint = newPoint;
+    oldPointTime = timeStamp;
+    memcpy(oldNED, NED, sizeof(oldNED));
 }
 
 void KmlExport::homeLocationUpdated(UAVObject *obj)
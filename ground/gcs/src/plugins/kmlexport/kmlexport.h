@@ -31,13 +31,15 @@
 #include <QTimer>
 #include <QDebug>
 #include <QBuffer>
+#include <QFile>
+#include <QHash>
 #include <math.h>
 
 #include "kml/base/file.h"
 #include "kml/dom.h"
 #include "kml/engine.h"
 
-#include "./uavtalk/uavtalk.h"
+#include "uavobjects/uavobject.h"
 
 #include "airspeedactual.h"
 #include "attitudeactual.h"
@@ -60,18 +62,22 @@ struct LLAVCoordinates
 /**
  * @class KmlExport generates a KML file showing the flight path from a UAVTalk
  * log path that is viewable in Google Earth.
+ *
+ * The log is read straight from the file, decoding only the objects needed,
+ * and the KML is written out as it is made rather than built up in memory.
+ * Track points can be thinned out by time and by distance.
  */
 class KmlExport : public QObject
 {
     Q_OBJECT
 public:
-    explicit KmlExport(QString inputFileName, QString outputFileName);
+    explicit KmlExport(QString inputFileName, QString outputFileName, int minTrackInterval = 0,
+                       int minTrackDistance = 0);
     qint64 bytesAvailable() const;
     qint64 bytesToWrite() { return logFile.bytesToWrite(); }
     bool open();
     void setFileName(QString name) { logFile.setFileName(name); }
 
-    bool preparseLogFile();
     bool stopExport();
     bool exportToKML();
 
@@ -89,10 +95,8 @@ protected:
     QFile logFile;
 
 private:
-    QList<quint32> timestampBuffer;
-    QList<quint32> timestampPos;
-
-    UAVTalk *kmlTalk;
+    //! The objects decoded from the log, by object ID
+    QHash<quint32, UAVObject *> logObjects;
 
     AirspeedActual *airspeedActual;
     AttitudeActual *attitudeActual;
@@ -104,20 +108,31 @@ private:
     GPSPosition::DataFields gpsPositionData;
     HomeLocation::DataFields homeLocationData;
 
-    DocumentPtr document;
-    FolderPtr trackFolder;
-    FolderPtr timestampFolder;
     KmlFactory *factory;
 
+    //! Where the track goes as it's made, and the arrows until the track is done
+    QIODevice *output;
+    QByteArray arrowsKml;
+
     QString outputFileName;
     LLAVCoordinates oldPoint;
+    bool haveOldPoint;
+    double oldNED[3];
+    quint32 oldPointTime;
     quint32 timeStamp;
     quint32 lastPlacemarkTime;
+
+    //! Least time [ms] and distance [m] between track points; 0 keeps them all
+    int minTrackInterval;
+    int minTrackDistance;
+
     QString informationString;
     QVector<CoordinatesPtr> wallAxes;
     static QString dateTimeFormat;
 
-    void parseLogFile();
+    bool parseLogFile();
+    void decodePacket(const uchar *packet, qint64 length);
+    void writeElement(const ElementPtr &element);
     StylePtr createGroundTrackStyle();
     StyleMapPtr createWallAxesStyle();
     StyleMapPtr createCustomBalloonStyle();
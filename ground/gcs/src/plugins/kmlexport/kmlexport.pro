@@ -6,7 +6,6 @@ include(../../gcsplugin.pri)
 
 include(../../plugins/coreplugin/coreplugin.pri)
 include(../../plugins/uavobjects/uavobjects.pri)
-include(../../plugins/uavtalk/uavtalk.pri)
 
 HEADERS += kmlexportplugin.h \
     kmlexport.h
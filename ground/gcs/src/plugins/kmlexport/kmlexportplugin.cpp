@@ -26,10 +26,15 @@
 #include <QDebug>
 #include <QtPlugin>
 #include <QStringList>
+#include <QDialog>
+#include <QDialogButtonBox>
 #include <QDir>
 #include <QFileDialog>
+#include <QFormLayout>
 #include <QList>
 #include <QMessageBox>
+#include <QSettings>
+#include <QSpinBox>
 #include <QWriteLocker>
 
 #include <extensionsystem/pluginmanager.h>
@@ -120,8 +125,49 @@ void KmlExportPlugin::exportToKML()
         }
     }
 
+    // Ask how far the track can be thinned out. Long flights make for huge
+    // files with every sample in them.
+    QSettings *settings = Core::ICore::instance()->settings();
+    settings->beginGroup("KmlExport");
+
+    QDialog decimationDialog(Core::ICore::instance()->mainWindow());
+    decimationDialog.setWindowTitle(tr("Track detail"));
+
+    QSpinBox *intervalBox = new QSpinBox(&decimationDialog);
+    intervalBox->setRange(0, 60000);
+    intervalBox->setSingleStep(100);
+    intervalBox->setSuffix(tr(" ms"));
+    intervalBox->setSpecialValueText(tr("Every sample"));
+    intervalBox->setValue(settings->value("MinTrackInterval", 0).toInt());
+
+    QSpinBox *distanceBox = new QSpinBox(&decimationDialog);
+    distanceBox->setRange(0, 1000);
+    distanceBox->setSuffix(tr(" m"));
+    distanceBox->setSpecialValueText(tr("Any distance"));
+    distanceBox->setValue(settings->value("MinTrackDistance", 0).toInt());
+
+    QDialogButtonBox *buttons =
+        new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel, &decimationDialog);
+    connect(buttons, &QDialogButtonBox::accepted, &decimationDialog, &QDialog::accept);
+    connect(buttons, &QDialogButtonBox::rejected, &decimationDialog, &QDialog::reject);
+
+    QFormLayout *layout = new QFormLayout(&decimationDialog);
+    layout->addRow(tr("Least time between track points:"), intervalBox);
+    layout->addRow(tr("Least distance between track points:"), distanceBox);
+    layout->addRow(buttons);
+
+    if (decimationDialog.exec() != QDialog::Accepted) {
+        settings->endGroup();
+        return;
+    }
+
+    settings->setValue("MinTrackInterval", intervalBox->value());
+    settings->setValue("MinTrackDistance", distanceBox->value());
+    settings->endGroup();
+
     // Create kmlExport instance, and trigger export
-    KmlExport kmlExport(inputFileName, localizedOutputFileName);
+    KmlExport kmlExport(inputFileName, localizedOutputFileName, intervalBox->value(),
+                        distanceBox->value());
     kmlExport.exportToKML();
 }
 
@@ -68,7 +68,8 @@ void LineardialGadgetWidget::connectInput(QString object1, QString nfield1)
 {
 
     if (obj1 != NULL)
-        disconnect(obj1, SIGNAL(objectUpdated(UAVObject *)), this, SLOT(updateIndex(UAVObject *)));
+        disconnect(obj1, SIGNAL(objectChanged(UAVObject *, quint64)), this,
+                   SLOT(updateIndex(UAVObject *)));
     ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
     UAVObjectManager *objManager = pm->getObject<UAVObjectManager>();
 
@@ -78,7 +79,8 @@ void LineardialGadgetWidget::connectInput(QString object1, QString nfield1)
     if (!(object1.isEmpty() || nfield1.isEmpty())) {
         obj1 = dynamic_cast<UAVDataObject *>(objManager->getObject(object1));
         if (obj1 != NULL) {
-            connect(obj1, SIGNAL(objectUpdated(UAVObject *)), this, SLOT(updateIndex(UAVObject *)));
+            connect(obj1, SIGNAL(objectChanged(UAVObject *, quint64)), this,
+                    SLOT(updateIndex(UAVObject *)));
             if (nfield1.contains("-")) {
                 QStringList fieldSubfield = nfield1.split("-", QString::SkipEmptyParts);
                 field1 = fieldSubfield.at(0);
@@ -47,14 +47,26 @@ FlightLogDownload::FlightLogDownload(QWidget *parent)
     ui->setupUi(this);
 
     dl_state = DL_IDLE;
+    spanStart = 0;
 
     ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
     UAVObjectManager *uavoManager = pm->getObject<UAVObjectManager>();
     loggingStats = LoggingStats::GetInstance(uavoManager);
     Q_ASSERT(loggingStats);
+    flightLogSummary = FlightLogSummary::GetInstance(uavoManager);
+    Q_ASSERT(flightLogSummary);
+    systemAlarms = SystemAlarms::GetInstance(uavoManager);
+    Q_ASSERT(systemAlarms);
 
     connect(ui->fileNameButton, SIGNAL(clicked()), this, SLOT(getFilename()));
     connect(ui->saveButton, SIGNAL(clicked()), this, SLOT(startDownload()));
+    connect(ui->summaryButton, SIGNAL(clicked()), this, SLOT(startSummary()));
+    connect(flightLogSummary, SIGNAL(objectUnpacked(UAVObject *)), this,
+            SLOT(summaryReceived()));
+
+    // Until there is a summary, only the whole file can be had
+    ui->cbFrom->addItem(tr("Start"), QVariant(0));
+    ui->cbTo->addItem(tr("End"), QVariant(0));
 
     // Create default file name
     QString fileName =
@@ -100,15 +112,32 @@ void FlightLogDownload::updateReceived()
         return;
     case DL_COMPLETE:
         return;
+    case DL_SUMMARY:
+        // The summary itself comes in FlightLogSummary, just before this
+        if (logging.Operation == LoggingStats::OPERATION_COMPLETE)
+            stopTransfer(tr("Summary read."));
+        else if (logging.Operation == LoggingStats::OPERATION_ERROR)
+            stopTransfer(tr("No summary in this log."));
+        return;
     case DL_DOWNLOADING:
         break;
     }
 
-    UAVObject::Metadata mdata;
-
     switch (logging.Operation) {
     case LoggingStats::OPERATION_IDLE:
         log.append(reinterpret_cast<char *>(logging.FileSector), LoggingStats::FILESECTOR_NUMELEM);
+
+        if (finishSpan()) {
+            if (spans.isEmpty()) {
+                logFile->write(log);
+                logFile->close();
+                stopTransfer(tr("Download complete."));
+            } else {
+                requestSpan();
+            }
+            break;
+        }
+
         logging.Operation = LoggingStats::OPERATION_DOWNLOAD;
         logging.FileSectorNum++;
         loggingStats->setData(logging);
@@ -121,32 +150,180 @@ void FlightLogDownload::updateReceived()
     case LoggingStats::OPERATION_COMPLETE: {
         log.append(reinterpret_cast<char *>(logging.FileSector), LoggingStats::FILESECTOR_NUMELEM);
 
-        dl_state = DL_IDLE;
+        // The end of the file ends a span, whatever its length
+        if (!finishSpan())
+            spans.removeFirst();
 
-        mdata = loggingStats->getMetadata();
-        UAVObject::SetFlightTelemetryUpdateMode(mdata, UAVObject::UPDATEMODE_MANUAL);
-        loggingStats->setMetadata(mdata);
+        if (!spans.isEmpty()) {
+            requestSpan();
+            break;
+        }
 
         logFile->write(log);
         logFile->close();
 
-        ui->lb_operationStatus->setText("Download complete.");
+        stopTransfer(tr("Download complete."));
         break;
     }
     case LoggingStats::OPERATION_ERROR:
-        dl_state = DL_IDLE;
-
-        mdata = loggingStats->getMetadata();
-        UAVObject::SetFlightTelemetryUpdateMode(mdata, UAVObject::UPDATEMODE_MANUAL);
-        loggingStats->setMetadata(mdata);
-
-        ui->lb_operationStatus->setText("Download error.");
+        stopTransfer(tr("Download error."));
         break;
     default:
         qDebug() << "Unhandled";
     }
 }
 
+/**
+ * @brief FlightLogDownload::finishSpan Trims what has come in for the
+ * current span to its length
+ * @return true if the span is complete, and taken off the list
+ */
+bool FlightLogDownload::finishSpan()
+{
+    quint32 length = spans.first().second;
+
+    if (length == 0 || quint32(log.size() - spanStart) < length)
+        return false;
+
+    log.truncate(spanStart + length);
+    spans.removeFirst();
+
+    return true;
+}
+
+/**
+ * @brief FlightLogDownload::requestSpan Starts the download of the next
+ * span, from its first sector
+ */
+void FlightLogDownload::requestSpan()
+{
+    LoggingStats::DataFields logging = loggingStats->getData();
+
+    spanStart = log.size();
+
+    qDebug() << "Download from offset: " << spans.first().first;
+    logging.Operation = LoggingStats::OPERATION_DOWNLOAD;
+    logging.FileOffset = spans.first().first;
+    logging.FileSectorNum = 0;
+    loggingStats->setData(logging);
+    loggingStats->updated();
+}
+
+/**
+ * @brief FlightLogDownload::stopTransfer Goes back to idle, with the
+ * logging object no longer sent as it changes
+ */
+void FlightLogDownload::stopTransfer(const QString &status)
+{
+    dl_state = DL_IDLE;
+
+    UAVObject::Metadata mdata = loggingStats->getMetadata();
+    UAVObject::SetFlightTelemetryUpdateMode(mdata, UAVObject::UPDATEMODE_MANUAL);
+    loggingStats->setMetadata(mdata);
+
+    ui->lb_operationStatus->setText(status);
+}
+
+/**
+ * @brief FlightLogDownload::alarmName Names an alarm and its severity as
+ * SystemAlarms does
+ */
+QString FlightLogDownload::alarmName(int alarm, int severity)
+{
+    UAVObjectField *field = systemAlarms->getField("Alarm");
+    QStringList names = field->getElementNames();
+    QStringList options = field->getOptions();
+
+    return QString("%1 %2")
+        .arg(names.value(alarm, QString::number(alarm)))
+        .arg(options.value(severity, QString::number(severity)));
+}
+
+/**
+ * @brief FlightLogDownload::summaryReceived Shows the summary of a log, and
+ * offers its index and events as places to download from
+ */
+void FlightLogDownload::summaryReceived()
+{
+    FlightLogSummary::DataFields summary = flightLogSummary->getData();
+    QStringList lines;
+
+    lines << tr("Log %1: %2 s, %3 kB")
+                 .arg(summary.FileId)
+                 .arg(summary.Duration / 1000.0, 0, 'f', 1)
+                 .arg(summary.LogBytes / 1024.0, 0, 'f', 1);
+    lines << tr("Peak rates: roll %1, pitch %2, yaw %3 deg/s")
+                 .arg(summary.MaxRollRate)
+                 .arg(summary.MaxPitchRate)
+                 .arg(summary.MaxYawRate);
+    lines << tr("Saturated %1 times, for %2 s")
+                 .arg(summary.Saturations)
+                 .arg(summary.SaturationTime / 1000.0, 0, 'f', 1);
+    lines << tr("Vibration: peak %1, mean %2 m/s^2")
+                 .arg(summary.MaxVibration, 0, 'f', 2)
+                 .arg(summary.MeanVibration, 0, 'f', 2);
+    lines << tr("Loop overruns: %1, longest %2 ms")
+                 .arg(summary.LoopOverruns)
+                 .arg(summary.MaxLoopTime);
+    lines << tr("Alarm changes: %1").arg(summary.AlarmTransitions);
+
+    ui->cbFrom->clear();
+    ui->cbTo->clear();
+    ui->cbFrom->addItem(tr("Start"), QVariant(0));
+
+    int indexCount = qMin(int(summary.IndexCount), int(FlightLogSummary::INDEXOFFSET_NUMELEM));
+
+    for (int i = 1; i < indexCount; i++) {
+        QString label = tr("%1 s").arg(i * summary.IndexPeriod);
+
+        ui->cbFrom->addItem(label, QVariant(summary.IndexOffset[i]));
+        ui->cbTo->addItem(label, QVariant(summary.IndexOffset[i]));
+    }
+
+    int eventCount = qMin(int(summary.EventCount), int(FlightLogSummary::EVENTTIME_NUMELEM));
+
+    for (int i = 0; i < eventCount; i++) {
+        QString label = tr("%1 s: %2")
+                            .arg(summary.EventTime[i] / 1000.0, 0, 'f', 1)
+                            .arg(alarmName(summary.EventAlarm[i], summary.EventSeverity[i]));
+
+        lines << label;
+        ui->cbFrom->addItem(label, QVariant(summary.EventOffset[i]));
+        ui->cbTo->addItem(label, QVariant(summary.EventOffset[i]));
+    }
+
+    ui->cbTo->addItem(tr("End"), QVariant(0));
+    ui->cbTo->setCurrentIndex(ui->cbTo->count() - 1);
+
+    ui->summaryText->setPlainText(lines.join("\n"));
+}
+
+/**
+ * @brief FlightLogDownload::startSummary asks for the summary kept at the
+ * end of the selected log, without downloading it
+ */
+void FlightLogDownload::startSummary()
+{
+    bool ok;
+    qint32 file_id = ui->cbFileId->currentData().toInt(&ok);
+    if (!ok)
+        return;
+
+    UAVObject::Metadata mdata = loggingStats->getMetadata();
+    UAVObject::SetFlightTelemetryUpdateMode(mdata, UAVObject::UPDATEMODE_ONCHANGE);
+    loggingStats->setMetadata(mdata);
+
+    LoggingStats::DataFields logging = loggingStats->getData();
+
+    dl_state = DL_SUMMARY;
+    logging.Operation = LoggingStats::OPERATION_SUMMARY;
+    logging.FileRequest = file_id;
+    loggingStats->setData(logging);
+    loggingStats->updated();
+
+    ui->lb_operationStatus->setText(tr("Reading summary..."));
+}
+
 /**
  * @brief FlightLogDownload::startDownload set up the metadata
  * on the logging object and start a download after checking the
@@ -159,11 +336,35 @@ void FlightLogDownload::startDownload()
     if (!ok)
         return;
 
+    FlightLogSummary::DataFields summary = flightLogSummary->getData();
+    quint32 from = 0;
+    quint32 to = 0;
+
+    // The range is only good for the log it was summarized from
+    if (summary.FileId == file_id) {
+        from = ui->cbFrom->currentData().toUInt();
+        to = ui->cbTo->currentData().toUInt();
+    }
+
+    if (to != 0 && to <= from) {
+        ui->lb_operationStatus->setText(tr("The range is empty."));
+        return;
+    }
+
     logFile = new QFile(ui->fileName->text(), this);
     if (!logFile->open(QIODevice::WriteOnly))
         return;
 
     log.clear();
+    spans.clear();
+
+    if (from != 0) {
+        // Without the header and settings from the start, the rest of the
+        // log can't be read
+        spans << qMakePair(quint32(0), summary.HeaderBytes);
+    }
+
+    spans << qMakePair(from, to ? to - from : 0);
 
     LoggingStats::DataFields logging = loggingStats->getData();
 
@@ -179,11 +380,10 @@ void FlightLogDownload::startDownload()
 
     qDebug() << "Download file id: " << file_id;
     dl_state = DL_DOWNLOADING;
-    logging.Operation = LoggingStats::OPERATION_DOWNLOAD;
     logging.FileRequest = file_id;
-    logging.FileSectorNum = 0;
     loggingStats->setData(logging);
-    loggingStats->updated();
+
+    requestSpan();
 }
 
 /**
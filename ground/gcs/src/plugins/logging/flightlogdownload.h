@@ -31,7 +31,11 @@
 #include <QDialog>
 #include <QByteArray>
 #include <QFile>
+#include <QList>
+#include <QPair>
+#include "flightlogsummary.h"
 #include "loggingstats.h"
+#include "systemalarms.h"
 
 namespace Ui {
 class FlightLogDownload;
@@ -47,15 +51,29 @@ public:
 
 private slots:
     void updateReceived();
+    void summaryReceived();
     void startDownload();
+    void startSummary();
     void getFilename();
 
 private:
+    void requestSpan();
+    bool finishSpan();
+    void stopTransfer(const QString &status);
+    QString alarmName(int alarm, int severity);
+
     LoggingStats *loggingStats;
+    FlightLogSummary *flightLogSummary;
+    SystemAlarms *systemAlarms;
     QByteArray log;
     QFile *logFile;
 
-    enum LOG_DL_STATE { DL_IDLE, DL_DOWNLOADING, DL_COMPLETE } dl_state;
+    /** Parts of the file to fetch, as offset and length; a length of zero
+     * is to the end of the file */
+    QList<QPair<quint32, quint32>> spans;
+    int spanStart; /** Where in log the current span starts */
+
+    enum LOG_DL_STATE { DL_IDLE, DL_DOWNLOADING, DL_SUMMARY, DL_COMPLETE } dl_state;
 
     Ui::FlightLogDownload *ui;
 };
@@ -30,12 +30,19 @@
 #include <QTextStream>
 #include <QMainWindow>
 #include <QMessageBox>
+#include <QDataStream>
+#include <QDateTime>
+#include <QFileInfo>
+
+#include <algorithm>
 
 #include <coreplugin/icore.h>
 #include <coreplugin/coreconstants.h>
 
 LogFile::LogFile(QObject *parent)
     : QIODevice(parent)
+    , logData(nullptr)
+    , logSize(0)
     , timestampBufferIdx(0)
 {
     connect(&timer, SIGNAL(timeout()), this, SLOT(timerFired()));
@@ -163,6 +170,12 @@ void LogFile::close()
 
     if (timer.isActive())
         timer.stop();
+
+    // Closing the file unmaps it
+    logData = nullptr;
+    logSize = 0;
+    logCopy.clear();
+
     file.close();
     QIODevice::close();
 }
@@ -200,100 +213,214 @@ qint64 LogFile::bytesAvailable() const
 
 void LogFile::timerFired()
 {
-    qint64 dataSize;
-
-    if (file.bytesAvailable() > 4) {
-
-        int time;
-        time = myTime.elapsed();
-
-        // Read packets
-        while ((lastPlayTime + ((time - lastPlayTimeOffset) * playbackSpeed)
-                > (lastTimeStamp - firstTimestamp))) {
-            lastPlayTime += ((time - lastPlayTimeOffset) * playbackSpeed);
-            if (file.bytesAvailable() < 4) {
-                stopReplay();
-                return;
-            }
-
-            file.seek(lastTimeStampPos + sizeof(lastTimeStamp));
-
-            file.read(reinterpret_cast<char *>(&dataSize), sizeof(dataSize));
-
-            if (dataSize < 1 || dataSize > (1024 * 1024)) {
-                qDebug() << "Error: Logfile corrupted! Unlikely packet size: " << dataSize << "\n";
-                stopReplay();
-                return;
-            }
-            if (file.bytesAvailable() < dataSize) {
-                stopReplay();
-                return;
-            }
-
-            mutex.lock();
-            dataBuffer.append(file.read(dataSize));
-            mutex.unlock();
-            emit readyRead();
-
-            if (file.bytesAvailable() < 4) {
-                stopReplay();
-                return;
-            }
-
-            lastTimeStampPos = timestampPos[timestampBufferIdx];
-            lastTimeStamp = timestampBuffer[timestampBufferIdx];
-            timestampBufferIdx++;
-
-            lastPlayTimeOffset = time;
-            time = myTime.elapsed();
+    int time = myTime.elapsed();
+
+    lastPlayTime += (time - lastPlayTimeOffset) * playbackSpeed;
+    lastPlayTimeOffset = time;
+
+    int sent = 0;
+
+    mutex.lock();
+
+    while (timestampBufferIdx < timestampBuffer.size()
+           && timestampBuffer[timestampBufferIdx] - firstTimestamp <= lastPlayTime) {
+        if (sent >= MAX_PACKETS_PER_TICK) {
+            // Too far behind to catch up in one go; hold the replay clock
+            // here and carry on next tick rather than block the UI.
+            lastPlayTime = timestampBuffer[timestampBufferIdx] - firstTimestamp;
+            break;
         }
-    } else {
+
+        qint64 pos = timestampPos[timestampBufferIdx];
+        qint64 dataSize;
+
+        memcpy(&dataSize, logData + pos + sizeof(lastTimeStamp), sizeof(dataSize));
+
+        dataBuffer.append(reinterpret_cast<const char *>(logData) + pos + sizeof(lastTimeStamp)
+                              + sizeof(dataSize),
+                          static_cast<int>(dataSize));
+
+        lastTimeStamp = timestampBuffer[timestampBufferIdx];
+        timestampBufferIdx++;
+        sent++;
+    }
+
+    mutex.unlock();
+
+    if (sent) {
+        emit readyRead();
+    }
+
+    if (timestampBufferIdx >= timestampBuffer.size()) {
         stopReplay();
     }
 }
 
-bool LogFile::startReplay()
+/**
+ * Maps the whole log into memory.  Where that's not possible, reads it all
+ * instead.
+ */
+bool LogFile::mapLog()
 {
-    dataBuffer.clear();
-    myTime.restart();
-    lastPlayTimeOffset = 0;
-    lastPlayTime = 0;
-    playbackSpeed = 1;
+    logSize = file.size();
+    logData = file.map(0, logSize);
 
-    // Read all log timestamps into array
-    timestampBuffer.clear(); // Save beginning of log for later use
-    timestampPos.clear();
-    quint64 logFileStartIdx = file.pos();
-    timestampBufferIdx = 0;
-    lastTimeStamp = 0;
+    if (!logData) {
+        qint64 pos = file.pos();
+
+        file.seek(0);
+        logCopy = file.readAll();
+        file.seek(pos);
+
+        if (logCopy.size() != logSize) {
+            logCopy.clear();
+            logSize = 0;
+            return false;
+        }
+
+        logData = reinterpret_cast<const uchar *>(logCopy.constData());
+    }
+
+    return true;
+}
+
+/* The index cached next to the log: magic, version, then the size and
+ * modification time of the log and where its packets start, to tell if it
+ * still matches, then the packet count, timestamps and positions.
+ */
+static const quint32 INDEX_MAGIC = 0x58444c44; // "DLDX"
+static const quint32 INDEX_VERSION = 1;
+
+bool LogFile::loadIndex(qint64 dataStart)
+{
+    QFile indexFile(indexFileName());
+
+    if (!indexFile.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QDataStream in(&indexFile);
+    in.setByteOrder(QDataStream::LittleEndian);
+
+    quint32 magic, version, count;
+    qint64 size, modified, start;
+
+    in >> magic >> version >> size >> modified >> start >> count;
+
+    QFileInfo info(file);
+
+    if (in.status() != QDataStream::Ok || magic != INDEX_MAGIC || version != INDEX_VERSION
+        || size != logSize || modified != info.lastModified().toMSecsSinceEpoch()
+        || start != dataStart) {
+        return false;
+    }
+
+    timestampBuffer.resize(count);
+    timestampPos.resize(count);
+
+    for (quint32 i = 0; i < count; i++) {
+        in >> timestampBuffer[i] >> timestampPos[i];
+    }
+
+    if (in.status() != QDataStream::Ok) {
+        timestampBuffer.clear();
+        timestampPos.clear();
+        return false;
+    }
 
-    while (!file.atEnd()) {
+    // Don't trust positions beyond what's there
+    for (quint32 i = 0; i < count; i++) {
         qint64 dataSize;
+        qint64 pos = timestampPos[i];
+
+        if (pos < dataStart
+            || pos + qint64(sizeof(lastTimeStamp) + sizeof(dataSize)) > logSize) {
+            timestampBuffer.clear();
+            timestampPos.clear();
+            return false;
+        }
+
+        memcpy(&dataSize, logData + pos + sizeof(lastTimeStamp), sizeof(dataSize));
+
+        if (dataSize < 1 || pos + qint64(sizeof(lastTimeStamp) + sizeof(dataSize)) + dataSize
+                > logSize) {
+            timestampBuffer.clear();
+            timestampPos.clear();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void LogFile::saveIndex(qint64 dataStart)
+{
+    // Best effort: the log may well be somewhere we can't write
+    QFile indexFile(indexFileName());
+
+    if (!indexFile.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return;
+    }
+
+    QDataStream out(&indexFile);
+    out.setByteOrder(QDataStream::LittleEndian);
+
+    QFileInfo info(file);
+
+    out << INDEX_MAGIC << INDEX_VERSION << logSize << info.lastModified().toMSecsSinceEpoch()
+        << dataStart << static_cast<quint32>(timestampBuffer.size());
+
+    for (int i = 0; i < timestampBuffer.size(); i++) {
+        out << timestampBuffer[i] << timestampPos[i];
+    }
+
+    if (out.status() != QDataStream::Ok) {
+        indexFile.remove();
+    }
+}
+
+/**
+ * Walks the mapped log once, noting where each packet starts.
+ */
+void LogFile::buildIndex(qint64 dataStart)
+{
+    timestampBuffer.clear();
+    timestampPos.clear();
 
-        // Get time stamp position
-        timestampPos.append(file.pos());
+    bool warned = false;
+    qint64 pos = dataStart;
+
+    while (pos + qint64(sizeof(quint32) + sizeof(qint64)) <= logSize) {
+        quint32 timeStamp;
+        qint64 dataSize;
 
         // Read timestamp and logfile packet size
-        file.read(reinterpret_cast<char *>(&lastTimeStamp), sizeof(lastTimeStamp));
-        file.read(reinterpret_cast<char *>(&dataSize), sizeof(dataSize));
+        memcpy(&timeStamp, logData + pos, sizeof(timeStamp));
+        memcpy(&dataSize, logData + pos + sizeof(timeStamp), sizeof(dataSize));
 
         // Check if dataSize sync bytes are correct.
         // TODO: LIKELY AS NOT, THIS WILL FAIL TO RESYNC BECAUSE THERE IS TOO LITTLE INFORMATION IN
         // THE STRING OF SIX 0x00
-        if ((dataSize & 0xFFFFFFFFFFFF0000) != 0) {
+        if ((dataSize & 0xFFFFFFFFFFFF0000) != 0 || dataSize < 1) {
             qDebug() << "Wrong sync byte. At file location 0x"
-                     << QString("%1").arg(file.pos(), 0, 16) << "Got 0x"
+                     << QString("%1").arg(pos + sizeof(timeStamp), 0, 16) << "Got 0x"
                      << QString("%1").arg(dataSize & 0xFFFFFFFFFFFF0000, 0, 16)
                      << ", but expected 0x"
                         "00"
                         ".";
-            file.seek(timestampPos.last() + 1);
-            timestampPos.pop_back();
+            pos++;
             continue;
         }
 
+        qint64 end = pos + sizeof(timeStamp) + sizeof(dataSize) + dataSize;
+
+        // A packet cut off at the end of the log is dropped
+        if (end > logSize) {
+            break;
+        }
+
         // Check if timestamps are sequential.
-        if (!timestampBuffer.isEmpty() && lastTimeStamp < timestampBuffer.last()) {
+        if (!timestampBuffer.isEmpty() && timeStamp < timestampBuffer.last() && !warned) {
             QMessageBox msgBox(dynamic_cast<QWidget *>(Core::ICore::instance()->mainWindow()));
             msgBox.setText("Corrupted file.");
             msgBox.setInformativeText("Timestamps are not sequential. Playback may have unexpected "
@@ -301,12 +428,41 @@ bool LogFile::startReplay()
                                                    // description.
             msgBox.exec();
 
-            qDebug() << "Timestamp: " << timestampBuffer.last() << " " << lastTimeStamp;
+            qDebug() << "Timestamp: " << timestampBuffer.last() << " " << timeStamp;
+
+            warned = true;
         }
 
-        timestampBuffer.append(lastTimeStamp);
+        timestampBuffer.append(timeStamp);
+        timestampPos.append(pos);
 
-        file.seek(timestampPos.last() + sizeof(lastTimeStamp) + sizeof(dataSize) + dataSize);
+        pos = end;
+    }
+}
+
+bool LogFile::startReplay()
+{
+    dataBuffer.clear();
+    myTime.restart();
+    lastPlayTimeOffset = 0;
+    lastPlayTime = 0;
+    playbackSpeed = 1;
+
+    // Packets start after the header read by open()
+    qint64 logFileStartIdx = file.pos();
+    timestampBufferIdx = 0;
+    lastTimeStamp = 0;
+
+    if (!mapLog()) {
+        qDebug() << "Unable to read " << file.fileName();
+        stopReplay();
+        return false;
+    }
+
+    // Index every packet once, so that seeking doesn't have to scan
+    if (!loadIndex(logFileStartIdx)) {
+        buildIndex(logFileStartIdx);
+        saveIndex(logFileStartIdx);
     }
 
     // Check if any timestamps were successfully read
@@ -320,12 +476,7 @@ bool LogFile::startReplay()
         return false;
     }
 
-    // Reset to log beginning.
-    file.seek(logFileStartIdx + sizeof(lastTimeStamp));
-    lastTimeStampPos = timestampPos[0];
-    lastTimeStamp = timestampBuffer[0];
     firstTimestamp = timestampBuffer[0];
-    timestampBufferIdx = 1;
 
     timer.setInterval(10);
     timer.start();
@@ -353,20 +504,25 @@ void LogFile::resumeReplay()
 
 /**
  * @brief LogFile::setReplayTime, sets the playback time
- * @param val, the time in
+ * @param val, the time in seconds from the start of the log
  */
 void LogFile::setReplayTime(double val)
 {
-    quint32 tmpIdx = 0;
-    while (timestampBuffer[tmpIdx++] <= val * 1000 && tmpIdx <= timestampBufferIdx) {
+    if (timestampBuffer.isEmpty()) {
+        return;
     }
 
-    lastTimeStampPos = timestampPos[tmpIdx];
-    lastTimeStamp = timestampBuffer[tmpIdx];
-    timestampBufferIdx = tmpIdx;
+    quint32 target = firstTimestamp + static_cast<quint32>(qMax(val, 0.0) * 1000);
+
+    QMutexLocker locker(&mutex);
+
+    // Carry on from the first packet at or after the requested time
+    timestampBufferIdx =
+        std::lower_bound(timestampBuffer.constBegin(), timestampBuffer.constEnd(), target)
+        - timestampBuffer.constBegin();
 
     lastPlayTimeOffset = myTime.elapsed();
-    lastPlayTime = lastTimeStamp;
+    lastPlayTime = target - firstTimestamp;
 
-    qDebug() << "Replaying at: " << lastTimeStamp << ", but requestion at" << val * 1000;
+    qDebug() << "Replaying at: " << lastPlayTime << ", but requestion at" << val * 1000;
 }
@@ -33,6 +33,8 @@
 #include <QMutexLocker>
 #include <QDebug>
 #include <QBuffer>
+#include <QFile>
+#include <QVector>
 #include "uavobjects/uavobjectmanager.h"
 #include <math.h>
 
@@ -76,17 +78,31 @@ protected:
     QTime myTime;
     QFile file;
     quint32 lastTimeStamp;
-    quint32 lastPlayTime;
+    double lastPlayTime;
     QMutex mutex;
 
     int lastPlayTimeOffset;
     double playbackSpeed;
 
 private:
-    QList<quint32> timestampBuffer;
-    QList<quint32> timestampPos;
-    quint32 timestampBufferIdx;
-    quint32 lastTimeStampPos;
+    //! Most packets sent from one timer tick, so fast replay can't stall the UI
+    static const int MAX_PACKETS_PER_TICK = 500;
+
+    bool mapLog();
+    bool loadIndex(qint64 dataStart);
+    void saveIndex(qint64 dataStart);
+    void buildIndex(qint64 dataStart);
+    QString indexFileName() const { return file.fileName() + ".idx"; }
+
+    // The whole log, mapped (or read, where mapping isn't possible)
+    const uchar *logData;
+    qint64 logSize;
+    QByteArray logCopy;
+
+    // Timestamp and file position of each packet, in log order
+    QVector<quint32> timestampBuffer;
+    QVector<qint64> timestampPos;
+    int timestampBufferIdx;
     quint32 firstTimestamp;
 };
 
@@ -32,8 +32,17 @@
 #include "glc_lib/glc_context.h"
 #include "glc_lib/glc_exception.h"
 #include "glc_lib/glc_openglexception.h"
+#include "glc_lib/glc_state.h"
+#include "glc_lib/glc_cachemanager.h"
+#include "glc_lib/io/glc_worldto3dxml.h"
 #include "glc_lib/viewport/glc_userinput.h"
 
+#include <QCryptographicHash>
+#include <QDir>
+#include <QGuiApplication>
+#include <QScreen>
+#include <QStandardPaths>
+
 #include <iostream>
 
 // Model 3d object and background image used when specific one isn't available
@@ -73,8 +82,16 @@ ModelViewGadgetWidget::ModelViewGadgetWidget(QWidget *parent)
     UAVObjectManager *objManager = pm->getObject<UAVObjectManager>();
     attState = AttitudeActual::GetInstance(objManager);
 
+    // Telemetry can deliver attitude far faster than the display shows it
+    qreal refreshRate = QGuiApplication::primaryScreen()
+        ? QGuiApplication::primaryScreen()->refreshRate()
+        : 60;
+    m_MotionTimer.setSingleShot(true);
+    m_MotionTimer.setInterval(qMax(1, qRound(1000 / qMax<qreal>(refreshRate, 1))));
+
     connect(&m_MotionTimer, &QTimer::timeout, this,
             QOverload<>::of(&ModelViewGadgetWidget::updateAttitude));
+    connect(attState, &UAVObject::objectUpdated, this, &ModelViewGadgetWidget::attitudeUpdated);
 }
 
 ModelViewGadgetWidget::~ModelViewGadgetWidget() {}
@@ -129,7 +146,7 @@ void ModelViewGadgetWidget::initializeGL()
     // Enable antialiasing
     glEnable(GL_MULTISAMPLE);
 
-    m_MotionTimer.start(100);
+    m_MotionTimer.start();
     setFocusPolicy(Qt::StrongFocus); // keyboard capture for camera switching
 }
 
@@ -199,10 +216,16 @@ void ModelViewGadgetWidget::CreateScene()
         qDebug("ModelView: background image file loading failed.");
     }
 
+    if (acFilename == loadedAcFilename) {
+        m_World.collection()->setVboUsage(vboEnable);
+        return;
+    }
+
     try {
         if (QFile::exists(acFilename)) {
-            QFile aircraft(acFilename);
-            m_World = GLC_Factory::instance()->createWorldFromFile(aircraft);
+            m_World = loadWorld(acFilename);
+            m_World.collection()->setVboUsage(vboEnable);
+            loadedAcFilename = acFilename;
             m_ModelBoundingBox = m_World.boundingBox();
             m_GlView.reframe(m_ModelBoundingBox); // center 3D model in the scene
         } else {
@@ -213,6 +236,57 @@ void ModelViewGadgetWidget::CreateScene()
     }
 }
 
+/**
+ * Loads a model, from the cache if it has been seen before.  Parsing and
+ * tessellating a collada or 3ds model can take seconds; the cached copy is a
+ * 3dxml, whose meshes GLC then also keeps as binary reps ready to go straight
+ * into the VBOs.  Entries are named by the hash of the model file, so an
+ * edited model is picked up again.
+ */
+GLC_World ModelViewGadgetWidget::loadWorld(const QString &fileName)
+{
+    QFile model(fileName);
+    QString cacheDir =
+        QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/modelview";
+    QString cached;
+
+    if (!fileName.startsWith(":") && !fileName.endsWith(".3dxml", Qt::CaseInsensitive)
+        && QDir().mkpath(cacheDir) && model.open(QIODevice::ReadOnly)) {
+        QCryptographicHash hash(QCryptographicHash::Sha1);
+        hash.addData(&model);
+        model.close();
+        cached = cacheDir + "/" + hash.result().toHex() + ".3dxml";
+
+        GLC_State::setCurrentCacheManager(GLC_CacheManager(cacheDir));
+        GLC_State::setCacheUsage(true);
+
+        if (QFile::exists(cached)) {
+            try {
+                QFile cachedModel(cached);
+                return GLC_Factory::instance()->createWorldFromFile(cachedModel);
+            } catch (GLC_Exception &e) {
+                qDebug() << "ModelView: cached model unusable, reloading" << fileName;
+                QFile::remove(cached);
+            }
+        }
+    }
+
+    GLC_World world = GLC_Factory::instance()->createWorldFromFile(model);
+
+    if (!cached.isEmpty()) {
+        try {
+            GLC_WorldTo3dxml exporter(world, false);
+            if (!exporter.exportTo3dxml(cached, GLC_WorldTo3dxml::Compressed3dxml))
+                QFile::remove(cached);
+        } catch (GLC_Exception &e) {
+            qDebug() << "ModelView: could not cache" << fileName << e.what();
+            QFile::remove(cached);
+        }
+    }
+
+    return world;
+}
+
 void ModelViewGadgetWidget::wheelEvent(QWheelEvent *e)
 {
     double delta = m_GlView.cameraHandle()->distEyeTarget() - (e->delta() / 4);
@@ -322,6 +396,14 @@ void ModelViewGadgetWidget::keyPressEvent(QKeyEvent *e) // switch between camera
 //////////////////////////////////////////////////////////////////////
 // Private slots Functions
 //////////////////////////////////////////////////////////////////////
+void ModelViewGadgetWidget::attitudeUpdated()
+{
+    // Updates arriving before the next frame are folded into it; none are
+    // shown while the user is turning the model
+    if (!m_MotionTimer.isActive() && !m_MoverController.hasActiveMover())
+        m_MotionTimer.start();
+}
+
 void ModelViewGadgetWidget::updateAttitude()
 {
     AttitudeActual::DataFields data = attState->getData(); // get attitude data
@@ -60,6 +60,7 @@ private:
     void resizeGL(int width, int height);
     // Create GLC_Object to display
     void CreateScene();
+    GLC_World loadWorld(const QString &fileName);
 
     // Mouse events
     void mousePressEvent(QMouseEvent *e);
@@ -73,6 +74,7 @@ private:
     //////////////////////////////////////////////////////////////////////
 private slots:
     void updateAttitude();
+    void attitudeUpdated();
 
 private:
     GLC_Factory *m_pFactory;
@@ -81,10 +83,13 @@ private:
     GLC_Viewport m_GlView;
     GLC_MoverController m_MoverController;
     GLC_BoundingBox m_ModelBoundingBox;
-    // ! The timer used for motion
+    // ! Redraws once per display frame for any number of attitude updates
     QTimer m_MotionTimer;
 
     QString acFilename;
+    //! The model now in m_World, so a configuration change that keeps it
+    //! doesn't load it again
+    QString loadedAcFilename;
     QString bgFilename;
     bool vboEnable;
 
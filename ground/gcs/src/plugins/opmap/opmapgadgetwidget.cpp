@@ -43,6 +43,8 @@
 #include <QDir>
 #include <QFile>
 #include <QDateTime>
+#include <QFileDialog>
+#include <QMessageBox>
 
 #include <math.h>
 
@@ -389,6 +391,8 @@ void OPMapGadgetWidget::contextMenuEvent(QContextMenuEvent *event)
     contextMenu.addAction(reloadAct);
     contextMenu.addSeparator();
     contextMenu.addAction(ripAct);
+    contextMenu.addAction(exportTilePackAct);
+    contextMenu.addAction(importTilePackAct);
     contextMenu.addSeparator();
 
     QMenu maxUpdateRateSubMenu(
@@ -1282,6 +1286,14 @@ void OPMapGadgetWidget::createActions()
     ripAct = new QAction(tr("&Rip map"), this);
     ripAct->setStatusTip(tr("Rip the map tiles"));
     connect(ripAct, &QAction::triggered, this, &OPMapGadgetWidget::onRipAct_triggered);
+    exportTilePackAct = new QAction(tr("&Export map pack..."), this);
+    exportTilePackAct->setStatusTip(tr("Save all cached map tiles to one file, for use offline"));
+    connect(exportTilePackAct, &QAction::triggered, this,
+            &OPMapGadgetWidget::onExportTilePackAct_triggered);
+    importTilePackAct = new QAction(tr("&Import map pack..."), this);
+    importTilePackAct->setStatusTip(tr("Use the map tiles in a map pack"));
+    connect(importTilePackAct, &QAction::triggered, this,
+            &OPMapGadgetWidget::onImportTilePackAct_triggered);
 
     copyMouseLatLonToClipAct = new QAction(tr("Mouse latitude and longitude"), this);
     copyMouseLatLonToClipAct->setStatusTip(
@@ -1602,6 +1614,37 @@ void OPMapGadgetWidget::onRipAct_triggered()
     m_map->RipMap();
 }
 
+void OPMapGadgetWidget::onExportTilePackAct_triggered()
+{
+    QString file = QFileDialog::getSaveFileName(this, tr("Export map pack"), QString(),
+                                                tr("Map packs (*.tlpack)"));
+    if (file.isEmpty())
+        return;
+
+    if (!file.endsWith(".tlpack"))
+        file += ".tlpack";
+
+    if (!m_map->configuration->ExportTilePack(file))
+        QMessageBox::warning(this, tr("Export map pack"),
+                             tr("Unable to write the map pack to %1.").arg(file));
+}
+
+void OPMapGadgetWidget::onImportTilePackAct_triggered()
+{
+    QString file = QFileDialog::getOpenFileName(this, tr("Import map pack"), QString(),
+                                                tr("Map packs (*.tlpack)"));
+    if (file.isEmpty())
+        return;
+
+    if (!m_map->configuration->ImportTilePack(file)) {
+        QMessageBox::warning(this, tr("Import map pack"),
+                             tr("%1 is not a usable map pack.").arg(file));
+        return;
+    }
+
+    m_map->ReloadMap();
+}
+
 void OPMapGadgetWidget::onCopyMouseLatLonToClipAct_triggered()
 {
     QClipboard *clipboard = QApplication::clipboard();
@@ -175,6 +175,8 @@ private slots:
     */
     void onReloadAct_triggered();
     void onRipAct_triggered();
+    void onExportTilePackAct_triggered();
+    void onImportTilePackAct_triggered();
     void onCopyMouseLatLonToClipAct_triggered();
     void onCopyMouseLatToClipAct_triggered();
     void onCopyMouseLonToClipAct_triggered();
@@ -249,6 +251,8 @@ private:
     QAction *closeAct2;
     QAction *reloadAct;
     QAction *ripAct;
+    QAction *exportTilePackAct;
+    QAction *importTilePackAct;
     QAction *copyMouseLatLonToClipAct;
     QAction *copyMouseLatToClipAct;
     QAction *copyMouseLonToClipAct;
@@ -42,5 +42,6 @@ void PfdQmlGadget::loadConfiguration(IUAVGadgetConfiguration *config)
 {
     PfdQmlGadgetConfiguration *m = qobject_cast<PfdQmlGadgetConfiguration *>(config);
     m_widget->setQmlFile(m->qmlFile());
+    m_widget->setInterpolateAttitude(m->interpolateAttitude());
     m_widget->setSettingsMap(m->settings());
 }
@@ -24,11 +24,13 @@ PfdQmlGadgetConfiguration::PfdQmlGadgetConfiguration(QString classId, QSettings
                                                      QObject *parent)
     : IUAVGadgetConfiguration(classId, parent)
     , m_qmlFile("Unknown")
+    , m_interpolateAttitude(false)
 {
     // if a saved configuration exists load it
     if (qSettings != nullptr) {
         m_qmlFile = qSettings->value("qmlFile").toString();
         m_qmlFile = Utils::PathUtils().InsertDataPath(m_qmlFile);
+        m_interpolateAttitude = qSettings->value("interpolateAttitude", false).toBool();
 
         foreach (const QString &key, qSettings->childKeys()) {
             m_settings.insert(key, qSettings->value(key));
@@ -44,6 +46,7 @@ IUAVGadgetConfiguration *PfdQmlGadgetConfiguration::clone()
 {
     PfdQmlGadgetConfiguration *m = new PfdQmlGadgetConfiguration(this->classId());
     m->m_qmlFile = m_qmlFile;
+    m->m_interpolateAttitude = m_interpolateAttitude;
     m->m_settings = m_settings;
 
     return m;
@@ -57,4 +60,5 @@ void PfdQmlGadgetConfiguration::saveConfig(QSettings *qSettings) const
 {
     QString qmlFile = Utils::PathUtils().RemoveDataPath(m_qmlFile);
     qSettings->setValue("qmlFile", qmlFile);
+    qSettings->setValue("interpolateAttitude", m_interpolateAttitude);
 }
@@ -28,8 +28,10 @@ public:
                                        QObject *parent = nullptr);
 
     void setQmlFile(const QString &fileName) { m_qmlFile = fileName; }
+    void setInterpolateAttitude(bool interpolate) { m_interpolateAttitude = interpolate; }
 
     QString qmlFile() const { return m_qmlFile; }
+    bool interpolateAttitude() const { return m_interpolateAttitude; }
     QVariantMap settings() const { return m_settings; }
 
     void saveConfig(QSettings *settings) const;
@@ -37,6 +39,7 @@ public:
 
 private:
     QString m_qmlFile;
+    bool m_interpolateAttitude;
 
     QVariantMap m_settings;
 };
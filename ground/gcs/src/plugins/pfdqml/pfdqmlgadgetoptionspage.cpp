@@ -43,6 +43,7 @@ QWidget *PfdQmlGadgetOptionsPage::createPage(QWidget *parent)
     options_page->qmlSourceFile->setPromptDialogFilter(tr("QML file (*.qml)"));
     options_page->qmlSourceFile->setPromptDialogTitle(tr("Choose QML file"));
     options_page->qmlSourceFile->setPath(m_config->qmlFile());
+    options_page->interpolateAttitude->setChecked(m_config->interpolateAttitude());
 
     return optionsPageWidget;
 }
@@ -56,6 +57,7 @@ QWidget *PfdQmlGadgetOptionsPage::createPage(QWidget *parent)
 void PfdQmlGadgetOptionsPage::apply()
 {
     m_config->setQmlFile(options_page->qmlSourceFile->path());
+    m_config->setInterpolateAttitude(options_page->interpolateAttitude->isChecked());
 }
 
 void PfdQmlGadgetOptionsPage::finish()
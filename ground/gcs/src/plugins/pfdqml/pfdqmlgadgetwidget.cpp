@@ -30,6 +30,8 @@
 
 PfdQmlGadgetWidget::PfdQmlGadgetWidget(QWindow *parent)
     : QQuickView(parent)
+    , m_snapshot(TelemetrySnapshot::instance())
+    , m_interpolateAttitude(false)
 {
     setResizeMode(SizeRootObjectToView);
 
@@ -50,9 +52,6 @@ PfdQmlGadgetWidget::PfdQmlGadgetWidget(QWindow *parent)
                     << "GCSTelemetryStats"
                     << "FlightBatteryState";
 
-    ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
-    m_objManager = pm->getObject<UAVObjectManager>();
-
     foreach (const QString &objectName, objectsToExport) {
         exportUAVOInstance(objectName, 0);
     }
@@ -61,18 +60,24 @@ PfdQmlGadgetWidget::PfdQmlGadgetWidget(QWindow *parent)
     engine()->rootContext()->setContextProperty("qmlWidget", this);
 }
 
-PfdQmlGadgetWidget::~PfdQmlGadgetWidget() {}
+PfdQmlGadgetWidget::~PfdQmlGadgetWidget()
+{
+    // The scene goes before the snapshot objects it is bound to
+    setSource(QUrl());
+    setInterpolateAttitude(false);
+}
 
 /**
  * @brief PfdQmlGadgetWidget::exportUAVOInstance Makes the UAVO available inside the QML. This works
  * via the Q_PROPERTY()
- * values in the UAVO synthetic-headers
+ * values in the UAVO synthetic-headers.  QML gets the shared snapshot of the object, updated once
+ * per display frame, rather than the object itself.
  * @param objectName UAVObject name
  * @param instId Instance ID
  */
 void PfdQmlGadgetWidget::exportUAVOInstance(const QString &objectName, int instId)
 {
-    UAVObject *object = m_objManager->getObject(objectName, instId);
+    UAVObject *object = m_snapshot->getObject(objectName, instId);
     if (object)
         engine()->rootContext()->setContextProperty(objectName, object);
     else
@@ -86,7 +91,7 @@ void PfdQmlGadgetWidget::exportUAVOInstance(const QString &objectName, int instI
  */
 void PfdQmlGadgetWidget::resetUAVOExport(const QString &objectName, int instId)
 {
-    UAVObject *object = m_objManager->getObject(objectName, instId);
+    UAVObject *object = m_snapshot->getObject(objectName, instId);
     if (object)
         engine()->rootContext()->setContextProperty(objectName, nullptr);
     else
@@ -114,6 +119,18 @@ void PfdQmlGadgetWidget::setQmlFile(QString fn)
     }
 }
 
+/**
+ * @brief Smooth the attitude shown between telemetry packets
+ */
+void PfdQmlGadgetWidget::setInterpolateAttitude(bool interpolate)
+{
+    if (interpolate == m_interpolateAttitude)
+        return;
+
+    m_interpolateAttitude = interpolate;
+    m_snapshot->requestInterpolation(interpolate);
+}
+
 void PfdQmlGadgetWidget::setSettingsMap(const QVariantMap &settings)
 {
     engine()->rootContext()->setContextProperty("settings", settings);
@@ -17,10 +17,9 @@
 #define PFDQMLGADGETWIDGET_H_
 
 #include "pfdqmlgadgetconfiguration.h"
+#include "telemetrysnapshot.h"
 #include <QtQuick/QQuickView>
 
-class UAVObjectManager;
-
 class PfdQmlGadgetWidget : public QQuickView
 {
     Q_OBJECT
@@ -29,6 +28,7 @@ public:
     PfdQmlGadgetWidget(QWindow *parent = nullptr);
     ~PfdQmlGadgetWidget();
     void setQmlFile(QString fn);
+    void setInterpolateAttitude(bool interpolate);
 
 public slots:
     void setSettingsMap(const QVariantMap &settings);
@@ -40,7 +40,8 @@ private:
     QStringList objectsToExport;
     QString m_qmlFileName;
 
-    UAVObjectManager *m_objManager;
+    QSharedPointer<TelemetrySnapshot> m_snapshot;
+    bool m_interpolateAttitude;
     void exportUAVOInstance(const QString &objectName, int instId);
     void resetUAVOExport(const QString &objectName, int instId);
 };
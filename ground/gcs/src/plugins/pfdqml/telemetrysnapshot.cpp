@@ -0,0 +1,217 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "telemetrysnapshot.h"
+#include "extensionsystem/pluginmanager.h"
+#include "uavobjects/uavdataobject.h"
+#include "uavobjects/uavobjectfield.h"
+#include "uavobjects/uavobjectmanager.h"
+
+#include <QGuiApplication>
+#include <QScreen>
+#include <QWeakPointer>
+
+#include <string.h>
+
+//! Longest gap between attitude packets that is still interpolated across
+#define MAX_INTERPOLATION_MS 250
+
+static const char *const angleNames[3] = { "Roll", "Pitch", "Yaw" };
+
+static float wrap180(float angle)
+{
+    while (angle > 180)
+        angle -= 360;
+    while (angle < -180)
+        angle += 360;
+    return angle;
+}
+
+/**
+ * @brief The snapshot all PFDs share, made when the first one asks for it
+ * and freed with the last
+ */
+QSharedPointer<TelemetrySnapshot> TelemetrySnapshot::instance()
+{
+    static QWeakPointer<TelemetrySnapshot> shared;
+
+    QSharedPointer<TelemetrySnapshot> snapshot = shared.toStrongRef();
+    if (!snapshot) {
+        snapshot = QSharedPointer<TelemetrySnapshot>(new TelemetrySnapshot());
+        shared = snapshot;
+    }
+
+    return snapshot;
+}
+
+TelemetrySnapshot::TelemetrySnapshot()
+    : interpolationUsers(0)
+    , lastPacketTime(0)
+    , packetInterval(MAX_INTERPOLATION_MS)
+{
+    ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
+    objManager = pm->getObject<UAVObjectManager>();
+
+    QScreen *screen = QGuiApplication::primaryScreen();
+    qreal refreshRate = screen ? screen->refreshRate() : 60;
+    int framePeriod = qMax(1, qRound(1000 / qMax<qreal>(refreshRate, 1)));
+
+    changes.setInterval(framePeriod);
+    frameTimer.setInterval(framePeriod);
+    clock.start();
+
+    connect(&changes, &UAVObjectUpdateCoalescer::objectChanged, this,
+            &TelemetrySnapshot::objectChanged);
+    connect(&frameTimer, &QTimer::timeout, this, &TelemetrySnapshot::interpolateAttitude);
+
+    attitude = objManager->getObject("AttitudeActual");
+
+    for (int i = 0; i < 3; i++) {
+        angleOffsets[i] = -1;
+        angleFrom[i] = angleTo[i] = 0;
+    }
+
+    if (attitude) {
+        int offset = 0;
+        foreach (UAVObjectField *field, attitude->getFields()) {
+            for (int i = 0; i < 3; i++) {
+                if (field->getName() == angleNames[i]
+                    && field->getType() == UAVObjectField::FLOAT32)
+                    angleOffsets[i] = offset;
+            }
+            offset += field->getNumBytes();
+        }
+    }
+}
+
+TelemetrySnapshot::~TelemetrySnapshot()
+{
+    qDeleteAll(snapshots);
+}
+
+/**
+ * @brief The copy of an object to give to QML in place of the live one
+ * @param name object name
+ * @param instId instance ID
+ * @return the copy, the live object if it is metadata, or NULL if there's
+ * no such object
+ */
+UAVObject *TelemetrySnapshot::getObject(const QString &name, int instId)
+{
+    UAVObject *live = objManager->getObject(name, instId);
+    UAVDataObject *dataObj = dynamic_cast<UAVDataObject *>(live);
+    if (!dataObj)
+        return live;
+
+    UAVDataObject *copy = snapshots.value(live);
+    if (copy)
+        return copy;
+
+    // Never registered, so nothing but QML sees its updates
+    copy = dataObj->clone(instId);
+
+    QByteArray data(static_cast<int>(live->getNumBytes()), 0);
+    live->pack(reinterpret_cast<quint8 *>(data.data()));
+    copy->unpack(reinterpret_cast<const quint8 *>(data.constData()));
+
+    snapshots.insert(live, copy);
+    changes.watch(live);
+
+    return copy;
+}
+
+/**
+ * @brief Ask for, or stop asking for, interpolated attitude.  It is
+ * interpolated while any PFD wants it.
+ */
+void TelemetrySnapshot::requestInterpolation(bool interpolate)
+{
+    interpolationUsers += interpolate ? 1 : -1;
+
+    if (interpolationUsers <= 0 && frameTimer.isActive()) {
+        frameTimer.stop();
+        writeAttitude(1);
+    }
+}
+
+void TelemetrySnapshot::objectChanged(UAVObject *obj, quint64 changedFields)
+{
+    UAVDataObject *copy = snapshots.value(obj);
+    if (!copy || !changedFields)
+        return;
+
+    QByteArray data(static_cast<int>(obj->getNumBytes()), 0);
+    obj->pack(reinterpret_cast<quint8 *>(data.data()));
+
+    bool canInterpolate = obj == attitude && interpolationUsers > 0 && angleOffsets[0] >= 0
+        && angleOffsets[1] >= 0 && angleOffsets[2] >= 0;
+
+    if (!canInterpolate) {
+        copy->unpack(reinterpret_cast<const quint8 *>(data.constData()));
+        return;
+    }
+
+    qint64 now = clock.elapsed();
+    packetInterval = qBound(static_cast<qint64>(frameTimer.interval()), now - lastPacketTime,
+                            static_cast<qint64>(MAX_INTERPOLATION_MS));
+    lastPacketTime = now;
+
+    // Carry on from wherever the display has got to
+    QByteArray shown(static_cast<int>(copy->getNumBytes()), 0);
+    copy->pack(reinterpret_cast<quint8 *>(shown.data()));
+
+    for (int i = 0; i < 3; i++) {
+        memcpy(&angleFrom[i], shown.constData() + angleOffsets[i], sizeof(float));
+        memcpy(&angleTo[i], data.constData() + angleOffsets[i], sizeof(float));
+    }
+
+    attitudeTarget = data;
+    writeAttitude(0);
+
+    if (!frameTimer.isActive())
+        frameTimer.start();
+}
+
+void TelemetrySnapshot::interpolateAttitude()
+{
+    float alpha = (clock.elapsed() - lastPacketTime) / static_cast<float>(packetInterval);
+
+    if (alpha >= 1) {
+        alpha = 1;
+        frameTimer.stop();
+    }
+
+    writeAttitude(alpha);
+}
+
+/**
+ * @brief Shows the latest attitude packet, with the angles a fraction of
+ * the way from where they were to where it has them
+ */
+void TelemetrySnapshot::writeAttitude(float alpha)
+{
+    UAVDataObject *copy = snapshots.value(attitude);
+    if (!copy || attitudeTarget.size() != static_cast<int>(copy->getNumBytes()))
+        return;
+
+    QByteArray data = attitudeTarget;
+
+    for (int i = 0; i < 3; i++) {
+        float angle = wrap180(angleFrom[i] + alpha * wrap180(angleTo[i] - angleFrom[i]));
+        memcpy(data.data() + angleOffsets[i], &angle, sizeof(float));
+    }
+
+    copy->unpack(reinterpret_cast<const quint8 *>(data.constData()));
+}
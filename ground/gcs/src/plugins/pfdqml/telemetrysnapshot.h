@@ -0,0 +1,81 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef TELEMETRYSNAPSHOT_H_
+#define TELEMETRYSNAPSHOT_H_
+
+#include "uavobjects/uavobjectupdatecoalescer.h"
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QSharedPointer>
+#include <QTimer>
+
+class UAVObject;
+class UAVDataObject;
+class UAVObjectManager;
+
+/**
+ * Copies of the objects the PFDs show, shared by every PFD and brought up
+ * to date at most once per display frame.  QML bound to the live objects
+ * reran its bindings for every telemetry packet, in every PFD.
+ *
+ * Optionally the attitude is interpolated from one packet to the next over
+ * the time between them, so it moves smoothly at the display rate; it then
+ * lags the telemetry by up to one packet.
+ */
+class TelemetrySnapshot : public QObject
+{
+    Q_OBJECT
+
+public:
+    static QSharedPointer<TelemetrySnapshot> instance();
+    ~TelemetrySnapshot();
+
+    UAVObject *getObject(const QString &name, int instId = 0);
+    void requestInterpolation(bool interpolate);
+
+private slots:
+    void objectChanged(UAVObject *obj, quint64 changedFields);
+    void interpolateAttitude();
+
+private:
+    TelemetrySnapshot();
+
+    void writeAttitude(float alpha);
+
+    UAVObjectManager *objManager;
+    UAVObjectUpdateCoalescer changes;
+
+    //! The copy of each live object handed out
+    QHash<UAVObject *, UAVDataObject *> snapshots;
+
+    //! PFDs that asked for interpolated attitude
+    int interpolationUsers;
+    QTimer frameTimer;
+    QElapsedTimer clock;
+
+    UAVObject *attitude;
+    //! Latest attitude packet, and where the angles are in it
+    QByteArray attitudeTarget;
+    int angleOffsets[3];
+    float angleFrom[3];
+    float angleTo[3];
+    qint64 lastPacketTime;
+    qint64 packetInterval;
+};
+
+#endif /* TELEMETRYSNAPSHOT_H_ */
@@ -128,6 +128,7 @@ SUBDIRS += plugin_config
 plugin_gpsdisplay.subdir = gpsdisplay
 plugin_gpsdisplay.depends = plugin_coreplugin
 plugin_gpsdisplay.depends += plugin_uavobjects
+plugin_gpsdisplay.depends += plugin_uavtalk
 SUBDIRS += plugin_gpsdisplay
 
 # QML viewer gadget
@@ -149,6 +150,7 @@ plugin_telemetryscheduler.subdir = telemetryscheduler
 plugin_telemetryscheduler.depends = plugin_coreplugin
 plugin_telemetryscheduler.depends += plugin_uavobjects
 plugin_telemetryscheduler.depends += plugin_uavobjectutil
+plugin_telemetryscheduler.depends += plugin_uavtalk
 SUBDIRS += plugin_telemetryscheduler
 
 # Primary Flight Display (PFD) gadget, QML version
@@ -162,6 +164,11 @@ plugin_ipconnection.subdir = ipconnection
 plugin_ipconnection.depends = plugin_coreplugin
 SUBDIRS += plugin_ipconnection
 
+# Shared memory connection plugin
+plugin_shmconnection.subdir = shmconnection
+plugin_shmconnection.depends = plugin_coreplugin
+SUBDIRS += plugin_shmconnection
+
 # Export and Import GCS Configuration
 plugin_importexport.subdir = importexport
 plugin_importexport.depends = plugin_coreplugin
@@ -181,7 +188,6 @@ KML {
     plugin_kmlexport.subdir = kmlexport
     plugin_kmlexport.depends = plugin_coreplugin
     plugin_kmlexport.depends += plugin_uavobjects
-    plugin_kmlexport.depends += plugin_uavtalk
     SUBDIRS += plugin_kmlexport
 }
 
@@ -192,6 +198,7 @@ KML {
     plugin_gcscontrolplugin.depends = plugin_coreplugin
     plugin_gcscontrolplugin.depends += plugin_uavobjects
     plugin_gcscontrolplugin.depends += plugin_uavobjectutil
+    plugin_gcscontrolplugin.depends += plugin_uavtalk
     SUBDIRS += plugin_gcscontrolplugin
 }
 
@@ -41,12 +41,17 @@ class IConnection;
 static const int READ_TIMEOUT = 200;
 static const int READ_SIZE = 64;
 
+// 64 KiB of reports waiting for the reader
+static const int READ_RING_ORDER = 16;
+
 static const int WRITE_SIZE = 64;
 
 static const int WRITE_RETRIES = 10;
 
 RawHIDReadThread::RawHIDReadThread(hid_device *handle)
-    : m_handle(handle)
+    : m_readRing(READ_RING_ORDER)
+    , m_signalPending(0)
+    , m_handle(handle)
     , m_running(true)
 {
 }
@@ -77,16 +82,26 @@ void RawHIDReadThread::run()
 
         if (ret > 0) // read some data
         {
-            QMutexLocker lock(&m_readBufMtx);
-
-            bool needSignal = m_readBuffer.size() == 0;
-
             // Note: Preprocess the USB packets in this OS independent code
             // First byte is report ID, second byte is the number of valid bytes
-            m_readBuffer.append(reinterpret_cast<char *>(&buffer[2]), buffer[1]);
+            const char *data = reinterpret_cast<char *>(&buffer[2]);
+            int size = qMin<int>(buffer[1], READ_SIZE - 2);
 
-            if (needSignal) {
-                emit readyToRead();
+            while (m_running && size > 0) {
+                int written = m_readRing.write(data, size);
+
+                data += written;
+                size -= written;
+
+                // One signal covers everything until the reader gets to it
+                if (written && m_signalPending.testAndSetOrdered(0, 1)) {
+                    emit readyToRead();
+                }
+
+                // Wait for the reader to make room, rather than drop data
+                if (size > 0) {
+                    msleep(1);
+                }
             }
         } else if (ret == 0) // nothing read
         {
@@ -100,20 +115,12 @@ void RawHIDReadThread::run()
 
 int RawHIDReadThread::getReadData(char *data, int size)
 {
-    QMutexLocker lock(&m_readBufMtx);
-
-    size = qMin(size, m_readBuffer.size());
-
-    memcpy(data, m_readBuffer.constData(), size);
-    m_readBuffer.remove(0, size);
-
-    return size;
+    return m_readRing.read(data, size);
 }
 
 qint64 RawHIDReadThread::getBytesAvailable()
 {
-    QMutexLocker lock(&m_readBufMtx);
-    return m_readBuffer.size();
+    return m_readRing.available();
 }
 
 // *********************************************************************************
@@ -263,6 +270,12 @@ bool RawHID::open(OpenMode mode)
 
 void RawHID::sendReadyRead()
 {
+    if (!m_readThread)
+        return;
+
+    // Anything that arrives from here on gets another signal
+    m_readThread->readyToReadHandled();
+
     emit readyRead();
 }
 
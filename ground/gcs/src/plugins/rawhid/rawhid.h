@@ -30,6 +30,7 @@
 
 #include "rawhid_global.h"
 
+#include <QAtomicInt>
 #include <QByteArray>
 #include <QIODevice>
 #include <QMutex>
@@ -38,6 +39,8 @@
 
 #include <coreplugin/iconnection.h>
 
+#include "utils/bytering.h"
+
 #include "hidapi/hidapi.h"
 #include "usbmonitor.h"
 #include "usbdevice.h"
@@ -66,6 +69,9 @@ public:
     /** return the bytes buffered */
     qint64 getBytesAvailable();
 
+    /** Call before reading, once readyToRead has been received */
+    void readyToReadHandled() { m_signalPending.storeRelease(0); }
+
     void stop() { m_running = false; }
 
 signals:
@@ -74,12 +80,11 @@ signals:
 protected:
     void run();
 
-    /** QByteArray might not be the most efficient way to implement
-    a circular buffer but it's good enough and very simple */
-    QByteArray m_readBuffer;
+    /** Filled by this thread and drained by the reader, without locking */
+    Utils::ByteRing m_readRing;
 
-    /** A mutex to protect read buffer */
-    QMutex m_readBufMtx;
+    /** Set while a readyToRead is on its way, so only one is queued at once */
+    QAtomicInt m_signalPending;
 
     hid_device *m_handle;
 
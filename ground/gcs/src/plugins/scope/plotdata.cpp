@@ -138,25 +138,33 @@ Plot3dData::~Plot3dData()
 }
 
 /**
- * @brief valueAsDouble Fetch the value from the UAVO and return it as a double
- * @param obj UAVO
- * @param field UAVO field
- * @param haveSubField TRUE if UAVO has subfield. FALSE if not.
- * @param uavSubFieldName UAVO subfield, if it exists
- * @return
+ * @brief resolveAccessor Find the plotted element of a UAVO, so that
+ * valueAsDouble can read it without looking it up by name on every sample
+ * @param obj UAVO with new data
+ * @return TRUE if the UAVO has the plotted element, FALSE if not
  */
-double PlotData::valueAsDouble(UAVObject *obj, UAVObjectField *field, bool haveSubField,
-                               QString uavSubFieldName)
+bool PlotData::resolveAccessor(UAVObject *obj)
 {
-    Q_UNUSED(obj);
-    QVariant value;
+    if (obj == accessorObj) {
+        return accessor.isValid();
+    }
+
+    accessorObj = obj;
+    accessor = UAVObjectField::Accessor();
+
+    UAVObjectField *field = obj->getField(uavFieldName);
+
+    if (!field) {
+        return false;
+    }
+
+    int index = 0;
 
     if (haveSubField) {
-        int indexOfSubField = field->getElementNames().indexOf(
-            QRegExp(uavSubFieldName, Qt::CaseSensitive, QRegExp::FixedString));
-        value = field->getValue(indexOfSubField);
-    } else
-        value = field->getValue();
+        index = field->getElementIndex(uavSubFieldName);
+    }
+
+    accessor = field->getAccessor(index);
 
-    return value.toDouble();
+    return accessor.isValid();
 }
@@ -32,6 +32,7 @@ class ScopeGadgetWidget;
 class ScopeConfig;
 
 #include "uavobjects/uavobject.h"
+#include "uavobjects/uavobjectfield.h"
 
 #include "qwt/src/qwt_color_map.h"
 #include "qwt/src/qwt_scale_widget.h"
@@ -44,8 +45,13 @@ class PlotData : public QObject
 {
     Q_OBJECT
 public:
-    double valueAsDouble(UAVObject *obj, UAVObjectField *field, bool haveSubField,
-                         QString uavSubFieldName);
+    PlotData()
+        : accessorObj(nullptr)
+    {
+    }
+
+    bool resolveAccessor(UAVObject *obj);
+    double valueAsDouble() const { return accessor.at(); }
 
     // Setter functions
     void setXMinimum(double val) { xMinimum = val; }
@@ -110,6 +116,9 @@ protected:
     int correctionCount;
 
 private:
+    // Reads the plotted element of accessorObj
+    UAVObjectField::Accessor accessor;
+    UAVObject *accessorObj;
 };
 
 /**
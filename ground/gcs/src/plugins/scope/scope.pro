@@ -1,5 +1,5 @@
 TEMPLATE = lib
-QT += widgets
+QT += widgets opengl
 TARGET = ScopeGadget
 DEFINES += SCOPE_LIBRARY
 DEFINES += QWT_DLL
@@ -17,8 +17,10 @@ HEADERS += scopeplugin.h \
     scopes2d/histogramplotdata.h \
     scopes2d/histogramscopeconfig.h \
     scopes2d/scatterplotdata.h \
+    scopes2d/plotringbuffer.h \
     scopes2d/scatterplotscopeconfig.h \
     scopes3d/spectrogramplotdata.h \
+    scopes3d/spectrogramrasterdata.h \
     scopes3d/spectrogramscopeconfig.h \
     scopes2d/plotdata2d.h \
     scopes2d/scopes2dconfig.h \
@@ -37,8 +39,10 @@ SOURCES += scopeplugin.cpp \
     scopes2d/histogramplotdata.cpp \
     scopes2d/histogramscopeconfig.cpp \
     scopes2d/scatterplotdata.cpp \
+    scopes2d/plotringbuffer.cpp \
     scopes2d/scatterplotscopeconfig.cpp \
     scopes3d/spectrogramplotdata.cpp \
+    scopes3d/spectrogramrasterdata.cpp \
     scopes3d/spectrogramscopeconfig.cpp \
     plotdata.cpp
 SOURCES += scopegadgetoptionspage.cpp
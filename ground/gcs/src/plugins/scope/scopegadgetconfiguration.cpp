@@ -96,6 +96,7 @@ ScopeGadgetConfiguration::ScopeGadgetConfiguration(QString classId, QSettings *q
         }
         }
         m_scope->setRefreshInterval(refreshInterval);
+        m_scope->setOpenGLCanvas(qSettings->value("openGLCanvas", false).toBool());
     } else {
         // Default config is just a simple 2D scatterplot
         m_scope = new Scatterplot2dScopeConfig();
@@ -140,6 +141,7 @@ void ScopeGadgetConfiguration::applyGuiConfiguration(Ui::ScopeGadgetOptionsPage
     }
 
     m_scope->setRefreshInterval(refreshInterval);
+    m_scope->setOpenGLCanvas(options_page->cbOpenGLCanvas->isChecked());
 }
 
 /**
@@ -157,6 +159,7 @@ IUAVGadgetConfiguration *ScopeGadgetConfiguration::clone()
 {
     ScopeGadgetConfiguration *m = new ScopeGadgetConfiguration(this->classId());
     m->m_scope = this->getScope()->cloneScope(m_scope);
+    m->m_scope->setOpenGLCanvas(m_scope->getOpenGLCanvas());
 
     return m;
 }
@@ -170,6 +173,7 @@ void ScopeGadgetConfiguration::saveConfig(QSettings *qSettings) const
 {
     qSettings->setValue("plotDimensions", m_scope->getScopeDimensions());
     qSettings->setValue("refreshInterval", m_scope->getRefreshInterval());
+    qSettings->setValue("openGLCanvas", m_scope->getOpenGLCanvas());
 
     m_scope->saveConfiguration(qSettings);
 }
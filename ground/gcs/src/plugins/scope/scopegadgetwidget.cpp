@@ -46,6 +46,8 @@
 
 #include "qwt/src/qwt_legend.h"
 #include "qwt/src/qwt_legend_label.h"
+#include "qwt/src/qwt_plot_canvas.h"
+#include "qwt/src/qwt_plot_glcanvas.h"
 #include "qwt/src/qwt_scale_widget.h"
 
 #include <iostream>
@@ -444,6 +446,35 @@ void ScopeGadgetWidget::connectUAVO(UAVDataObject *obj)
     }
 }
 
+/**
+ * @brief ScopeGadgetWidget::setOpenGLCanvas Chooses between drawing the plot with
+ * OpenGL and with the usual raster painter. Curves and spectrogram images are
+ * then composited by the GPU, which takes most of the replot load off the UI
+ * thread when several scopes are open.
+ * @param enable Whether to use OpenGL; ignored when OpenGL isn't available
+ */
+void ScopeGadgetWidget::setOpenGLCanvas(bool enable)
+{
+    if (enable && !QGLFormat::hasOpenGL()) {
+        qDebug() << "OpenGL is not available, scope falls back to raster drawing";
+        enable = false;
+    }
+
+    bool isOpenGL = qobject_cast<QwtPlotGLCanvas *>(canvas()) != nullptr;
+
+    if (enable == isOpenGL)
+        return;
+
+    // The plot takes ownership of the new canvas, and deletes the old one
+    if (enable) {
+        QwtPlotGLCanvas *glCanvas = new QwtPlotGLCanvas();
+        glCanvas->setFrameStyle(QFrame::NoFrame);
+        setCanvas(glCanvas);
+    } else {
+        setCanvas(new QwtPlotCanvas());
+    }
+}
+
 /**
  * @brief ScopeGadgetWidget::startTimer Starts timer
  * @param refreshInterval
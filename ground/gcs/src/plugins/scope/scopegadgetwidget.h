@@ -101,6 +101,7 @@ public:
     void deleteLegend();
     void clearPlotWidget();
     void startTimer(int);
+    void setOpenGLCanvas(bool enable);
     QwtPlotGrid *m_grid;
     QwtLegend *m_legend;
     void setScopeName(QString val) { scopeName = val; }
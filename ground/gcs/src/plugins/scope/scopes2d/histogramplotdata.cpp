@@ -95,8 +95,8 @@ bool HistogramData::append(UAVObject *obj)
 
     if (uavObjectName == obj->getName()) {
 
-        // Get the field of interest
-        UAVObjectField *field = obj->getField(uavFieldName);
+        // Find the element of interest (looked up once per object)
+        bool haveElement = resolveAccessor(obj);
 
         // Bad place to do this
         double step = binWidth;
@@ -106,9 +106,8 @@ bool HistogramData::append(UAVObject *obj)
         if (numberOfBins > MAX_NUMBER_OF_INTERVALS)
             numberOfBins = MAX_NUMBER_OF_INTERVALS;
 
-        if (field) {
-            double currentValue =
-                valueAsDouble(obj, field, haveSubField, uavSubFieldName) * pow(10, scalePower);
+        if (haveElement) {
+            double currentValue = valueAsDouble() * pow(10, scalePower);
 
             // Extend interval, if necessary
             if (!histogramInterval->empty()) {
@@ -0,0 +1,188 @@
+/**
+ ******************************************************************************
+ *
+ * @file       plotringbuffer.cpp
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2017
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup ScopePlugin Scope Gadget Plugin
+ * @{
+ * @brief Sample storage for the scatterplot curves
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "scopes2d/plotringbuffer.h"
+
+// Enough for an hour of data at 250Hz
+#define DEFAULT_MAX_CAPACITY (1 << 20)
+
+PlotRingBuffer::PlotRingBuffer(int capacity)
+    : xs(qMax(capacity, 1))
+    , ys(qMax(capacity, 1))
+    , head(0)
+    , count(0)
+    , maxCapacity(DEFAULT_MAX_CAPACITY)
+{
+}
+
+/**
+ * @brief PlotRingBuffer::setMaximumCapacity Sets how far the ring may grow
+ * before it starts to overwrite its oldest samples
+ * @param capacity Largest number of samples kept
+ */
+void PlotRingBuffer::setMaximumCapacity(int capacity)
+{
+    maxCapacity = qMax(capacity, 1);
+
+    while (count > maxCapacity)
+        popFront();
+}
+
+/**
+ * @brief PlotRingBuffer::append Adds a sample after the newest one
+ */
+void PlotRingBuffer::append(double x, double y)
+{
+    if (count == xs.size())
+        grow();
+
+    if (count == xs.size()) {
+        // At the limit; drop the oldest sample to make room
+        popFront();
+    }
+
+    int pos = wrap(count);
+
+    xs[pos] = x;
+    ys[pos] = y;
+    count++;
+}
+
+/**
+ * @brief PlotRingBuffer::popFront Drops the oldest sample
+ */
+void PlotRingBuffer::popFront()
+{
+    if (!count)
+        return;
+
+    head = wrap(1);
+    count--;
+}
+
+void PlotRingBuffer::clear()
+{
+    head = 0;
+    count = 0;
+}
+
+void PlotRingBuffer::grow()
+{
+    int capacity = qMin(xs.size() * 2, maxCapacity);
+
+    if (capacity <= xs.size())
+        return;
+
+    QVector<double> newXs(capacity);
+    QVector<double> newYs(capacity);
+
+    for (int i = 0; i < count; i++) {
+        newXs[i] = xAt(i);
+        newYs[i] = yAt(i);
+    }
+
+    xs.swap(newXs);
+    ys.swap(newYs);
+    head = 0;
+}
+
+/**
+ * @brief PlotRingBuffer::decimate Copies the samples out for plotting,
+ * reduced to what can be seen.  The x range is split into one bucket per
+ * pixel, and only the first, smallest, largest and last samples of each
+ * bucket are kept, so that the plotted line covers the same pixels as the
+ * full data would.
+ * @param buckets Number of buckets, normally the plot width in pixels
+ * @param xOffset Subtracted from each x value
+ * @param outX Where to put the plotted x values
+ * @param outY Where to put the plotted y values
+ */
+void PlotRingBuffer::decimate(int buckets, double xOffset, QVector<double> &outX,
+                              QVector<double> &outY) const
+{
+    outX.resize(0);
+    outY.resize(0);
+
+    double x0 = count ? firstX() : 0;
+    double span = count ? lastX() - x0 : 0;
+
+    if (buckets <= 0 || count <= 4 * buckets || span <= 0) {
+        outX.reserve(count);
+        outY.reserve(count);
+
+        for (int i = 0; i < count; i++) {
+            outX.append(xAt(i) - xOffset);
+            outY.append(yAt(i));
+        }
+
+        return;
+    }
+
+    outX.reserve(4 * buckets + 1);
+    outY.reserve(4 * buckets + 1);
+
+    int bucket = -1;
+    int first = 0, minIdx = 0, maxIdx = 0, last = 0;
+
+    for (int i = 0; i <= count; i++) {
+        int b = buckets;
+
+        if (i < count)
+            b = qMin(static_cast<int>((xAt(i) - x0) / span * buckets), buckets - 1);
+
+        if (b == bucket) {
+            if (yAt(i) < yAt(minIdx))
+                minIdx = i;
+            if (yAt(i) > yAt(maxIdx))
+                maxIdx = i;
+            last = i;
+            continue;
+        }
+
+        if (bucket >= 0) {
+            // Emit what the bucket held, in the order it came
+            int idx[4] = { first, qMin(minIdx, maxIdx), qMax(minIdx, maxIdx), last };
+            int prev = -1;
+
+            for (int j = 0; j < 4; j++) {
+                if (idx[j] == prev)
+                    continue;
+
+                outX.append(xAt(idx[j]) - xOffset);
+                outY.append(yAt(idx[j]));
+                prev = idx[j];
+            }
+        }
+
+        bucket = b;
+        first = minIdx = maxIdx = last = i;
+    }
+}
+
+/**
+ * @}
+ * @}
+ */
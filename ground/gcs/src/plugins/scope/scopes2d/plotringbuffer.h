@@ -0,0 +1,80 @@
+/**
+ ******************************************************************************
+ *
+ * @file       plotringbuffer.h
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2017
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup ScopePlugin Scope Gadget Plugin
+ * @{
+ * @brief Sample storage for the scatterplot curves
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef PLOTRINGBUFFER_H
+#define PLOTRINGBUFFER_H
+
+#include <QVector>
+
+/**
+ * @brief The PlotRingBuffer class Keeps the (x, y) samples of one curve in
+ * a ring, so that old samples are dropped without moving the rest.  The
+ * ring grows (up to a limit) when it fills before the caller pops anything,
+ * and otherwise overwrites the oldest sample.
+ */
+class PlotRingBuffer
+{
+public:
+    explicit PlotRingBuffer(int capacity = 256);
+
+    void setMaximumCapacity(int capacity);
+
+    int size() const { return count; }
+    bool isEmpty() const { return count == 0; }
+
+    double xAt(int i) const { return xs[wrap(i)]; }
+    double yAt(int i) const { return ys[wrap(i)]; }
+    double firstX() const { return xAt(0); }
+    double lastX() const { return xAt(count - 1); }
+
+    void append(double x, double y);
+    void popFront();
+    void clear();
+
+    void decimate(int buckets, double xOffset, QVector<double> &outX,
+                  QVector<double> &outY) const;
+
+private:
+    QVector<double> xs;
+    QVector<double> ys;
+    int head;
+    int count;
+    int maxCapacity;
+
+    int wrap(int i) const
+    {
+        i += head;
+        return (i >= xs.size()) ? i - xs.size() : i;
+    }
+    void grow();
+};
+
+#endif // PLOTRINGBUFFER_H
+
+/**
+ * @}
+ * @}
+ */
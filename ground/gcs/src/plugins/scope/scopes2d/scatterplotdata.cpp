@@ -50,7 +50,7 @@ void TimeSeriesPlotData::plotNewData(PlotData *plot2dData, ScopeConfig *scopeCon
 
     // Plot new data
     if (readAndResetUpdatedFlag() == true)
-        curve->setSamples(*xData, *yData);
+        plotSamples(scopeGadgetWidget, 0);
 
     QDateTime NOW = QDateTime::currentDateTime();
     double toTime = NOW.toTime_t();
@@ -70,9 +70,9 @@ void SeriesPlotData::plotNewData(PlotData *plot2dData, ScopeConfig *scopeConfig,
     Q_UNUSED(scopeConfig);
     Q_UNUSED(scopeGadgetWidget);
 
-    // Plot new data
+    // Plot new data, numbering the samples from the oldest one kept
     if (readAndResetUpdatedFlag() == true)
-        curve->setSamples(*xData, *yData);
+        plotSamples(scopeGadgetWidget, samples.isEmpty() ? 0 : samples.firstX());
 }
 
 /**
@@ -84,13 +84,13 @@ bool SeriesPlotData::append(UAVObject *obj)
 {
     if (uavObjectName == obj->getName()) {
 
-        // Get the field of interest
-        UAVObjectField *field = obj->getField(uavFieldName);
+        // Find the element of interest (looked up once per object)
+        bool haveElement = resolveAccessor(obj);
 
-        if (field) {
+        if (haveElement) {
 
-            double currentValue =
-                valueAsDouble(obj, field, haveSubField, uavSubFieldName) * pow(10, scalePower);
+            double currentValue = valueAsDouble() * pow(10, scalePower);
+            double value;
 
             // Perform scope math, if necessary
             if (mathFunction == "Boxcar average" || mathFunction == "Standard deviation") {
@@ -121,19 +121,19 @@ bool SeriesPlotData::append(UAVObject *obj)
                     for (int i = 0; i < yDataHistory->size(); i++) {
                         stdSum += pow(yDataHistory->at(i) - boxcarAvg, 2) / (meanSamples - 1);
                     }
-                    yData->append(sqrt(stdSum));
+                    value = sqrt(stdSum);
                 } else {
-                    yData->append(boxcarAvg);
+                    value = boxcarAvg;
                 }
             } else {
-                yData->append(currentValue);
+                value = currentValue;
             }
 
-            if (yData->size()
-                > getXWindowSize()) { // If new data overflows the window, remove old data...
-                yData->pop_front();
-            } else //...otherwise, add a new y point at position xData
-                xData->insert(xData->size(), xData->size());
+            // If new data overflows the window, drop the oldest data
+            while (!samples.isEmpty() && samples.size() >= getXWindowSize())
+                samples.popFront();
+
+            samples.append(nextX++, value);
 
             return true;
         }
@@ -150,14 +150,14 @@ bool SeriesPlotData::append(UAVObject *obj)
 bool TimeSeriesPlotData::append(UAVObject *obj)
 {
     if (uavObjectName == obj->getName()) {
-        // Get the field of interest
-        UAVObjectField *field = obj->getField(uavFieldName);
+        // Find the element of interest (looked up once per object)
+        bool haveElement = resolveAccessor(obj);
 
-        if (field) {
+        if (haveElement) {
             QDateTime NOW = QDateTime::currentDateTime(); // THINK ABOUT REIMPLEMENTING THIS TO SHOW
                                                           // UAVO TIME, NOT SYSTEM TIME
-            double currentValue =
-                valueAsDouble(obj, field, haveSubField, uavSubFieldName) * pow(10, scalePower);
+            double currentValue = valueAsDouble() * pow(10, scalePower);
+            double value;
 
             // Perform scope math, if necessary
             if (mathFunction == "Boxcar average" || mathFunction == "Standard deviation") {
@@ -187,16 +187,16 @@ bool TimeSeriesPlotData::append(UAVObject *obj)
                     for (int i = 0; i < yDataHistory->size(); i++) {
                         stdSum += pow(yDataHistory->at(i) - boxcarAvg, 2) / (meanSamples - 1);
                     }
-                    yData->append(sqrt(stdSum));
+                    value = sqrt(stdSum);
                 } else {
-                    yData->append(boxcarAvg);
+                    value = boxcarAvg;
                 }
             } else {
-                yData->append(currentValue);
+                value = currentValue;
             }
 
             double valueX = NOW.toTime_t() + NOW.time().msec() / 1000.0;
-            xData->append(valueX);
+            samples.append(valueX, value);
 
             // Remove stale data
             removeStaleData();
@@ -213,22 +213,8 @@ bool TimeSeriesPlotData::append(UAVObject *obj)
  */
 void TimeSeriesPlotData::removeStaleData()
 {
-    double newestValue;
-    double oldestValue;
-
-    while (1) {
-        if (xData->size() == 0)
-            break;
-
-        newestValue = xData->last();
-        oldestValue = xData->first();
-
-        if (newestValue - oldestValue > getXWindowSize()) {
-            yData->pop_front();
-            xData->pop_front();
-        } else
-            break;
-    }
+    while (!samples.isEmpty() && samples.lastX() - samples.firstX() > getXWindowSize())
+        samples.popFront();
 }
 
 /**
@@ -256,6 +242,18 @@ void ScatterplotData::deletePlots(PlotData *scatterplotData)
  */
 void ScatterplotData::clearPlots()
 {
-    yData->clear();
-    xData->clear();
+    samples.clear();
+}
+
+/**
+ * @brief ScatterplotData::plotSamples Hands the curve the samples, decimated
+ * to the width of the plot, so that long windows don't cost a point per sample
+ * @param scopeGadgetWidget The plot
+ * @param xOffset Subtracted from the plotted x values
+ */
+void ScatterplotData::plotSamples(ScopeGadgetWidget *scopeGadgetWidget, double xOffset)
+{
+    samples.decimate(scopeGadgetWidget->canvas()->width(), xOffset, plotX, plotY);
+
+    curve->setSamples(plotX, plotY);
 }
@@ -28,6 +28,7 @@
 #define SCATTERPLOTDATA_H
 
 #include "scopes2d/plotdata2d.h"
+#include "scopes2d/plotringbuffer.h"
 #include "uavobjects/uavobject.h"
 #include "qwt/src/qwt_plot_curve.h"
 
@@ -56,6 +57,14 @@ public:
 
 protected:
     QwtPlotCurve *curve;
+    PlotRingBuffer samples;
+
+    void plotSamples(ScopeGadgetWidget *scopeGadgetWidget, double xOffset);
+
+private:
+    // Decimated copies of the samples, reused by every replot
+    QVector<double> plotX;
+    QVector<double> plotY;
 };
 
 /**
@@ -68,6 +77,7 @@ class SeriesPlotData : public ScatterplotData
 public:
     SeriesPlotData(QString uavObject, QString uavField)
         : ScatterplotData(uavObject, uavField)
+        , nextX(0)
     {
     }
     ~SeriesPlotData() {}
@@ -82,6 +92,9 @@ public:
       */
     virtual void removeStaleData() {}
     virtual void plotNewData(PlotData *, ScopeConfig *, ScopeGadgetWidget *);
+
+private:
+    double nextX;
 };
 
 /**
@@ -295,7 +295,6 @@ void Scatterplot2dScopeConfig::loadConfiguration(ScopeGadgetWidget *scopeGadgetW
         QwtPlotCurve *plotCurve = new QwtPlotCurve(curveNameScaledMath);
         plotCurve->setPen(QPen(QBrush(QColor(color), Qt::SolidPattern), (qreal)1, Qt::SolidLine,
                                Qt::SquareCap, Qt::BevelJoin));
-        plotCurve->setSamples(*(scatterplotData->getXData()), *(scatterplotData->getYData()));
         plotCurve->attach(scopeGadgetWidget);
         scatterplotData->setCurve(plotCurve);
 
@@ -25,7 +25,9 @@
  */
 
 #include <QDebug>
+#include <QDateTime>
 #include <math.h>
+#include <algorithm>
 
 #include "extensionsystem/pluginmanager.h"
 #include "uavobjects/uavobjectmanager.h"
@@ -35,19 +37,40 @@
 
 #include "qwt/src/qwt.h"
 #include "qwt/src/qwt_color_map.h"
-#include "qwt/src/qwt_matrix_raster_data.h"
 #include "qwt/src/qwt_plot_spectrogram.h"
 #include "qwt/src/qwt_scale_draw.h"
 #include "qwt/src/qwt_scale_widget.h"
 
 #define PI 3.1415926535897932384626433832795
 
+// Each transform starts a quarter of its length after the previous one
+#define FFT_OVERLAP 4
+
+// Columns per band of an on-board spectrum, so that the peak the board
+// found in a band can be drawn closer to where it is than the band
+#define SPECTRUM_COLUMNS_PER_BAND 4
+
+/**
+ * @brief findField Looks for an optional field, without the warning
+ * UAVObject::getField() gives about missing ones
+ */
+static UAVObjectField *findField(UAVObject *obj, const QString &name)
+{
+    foreach (UAVObjectField *field, obj->getFields()) {
+        if (field->getName() == name)
+            return field;
+    }
+
+    return nullptr;
+}
+
 /**
  * @brief SpectrogramData
  * @param uavObject
  * @param uavField
  * @param samplingFrequency
- * @param windowWidth
+ * @param windowWidth Columns to plot, or the shortest transform to use with
+ * the FFT math function
  * @param timeHorizon
  */
 SpectrogramData::SpectrogramData(QString uavObject, QString uavField, double samplingFrequency,
@@ -59,19 +82,13 @@ SpectrogramData::SpectrogramData(QString uavObject, QString uavField, double sam
 {
     this->samplingFrequency = samplingFrequency;
     this->timeHorizon = timeHorizon;
+    this->windowWidth = windowWidth;
     autoscaleValueUpdated = 0;
 
     // Create raster data
-    rasterData = new QwtMatrixRasterData();
-
-    if (mathFunction == "FFT") {
-        fft_object = new ffft::FFTReal<double>(windowWidth);
-        windowWidth /= 2;
-    }
-
-    this->windowWidth = windowWidth;
-
-    rasterData->setValueMatrix(*zDataHistory, windowWidth);
+    rasterData = new SpectrogramRasterData();
+    rasterData->setTimeHorizon(timeHorizon);
+    rasterData->reset(windowWidth);
 
     // Set the ranges for the plot
     resetAxisRanges();
@@ -121,9 +138,6 @@ void SpectrogramData::plotNewData(PlotData *plot3dData, ScopeConfig *scopeConfig
 
     // Check for new data
     if (readAndResetUpdatedFlag() == true) {
-        // Plot new data
-        rasterData->setValueMatrix(*zDataHistory, windowWidth);
-
         // Check autoscale. (For some reason, QwtSpectrogram doesn't support autoscale)
         if (zMaximum == 0) {
             double newVal = readAndResetAutoscaleValue();
@@ -145,14 +159,18 @@ void SpectrogramData::plotNewData(PlotData *plot3dData, ScopeConfig *scopeConfig
  */
 bool SpectrogramData::append(UAVObject *multiObj)
 {
-    QDateTime NOW =
-        QDateTime::currentDateTime(); // TODO: Upgrade this to show UAVO time and not system time
+    double now = QDateTime::currentMSecsSinceEpoch()
+        / 1000.0; // TODO: Upgrade this to show UAVO time and not system time
 
     // Check to make sure it's the correct UAVO
     if (uavObjectName == multiObj->getName()) {
 
-        // Only run on UAVOs that have multiple instances
+        // Only run on UAVOs that have multiple instances, or that hold a
+        // spectrum computed on board
         if (multiObj->isSingleInstance()) {
+            if (findField(multiObj, "binwidth"))
+                return appendSpectrum(multiObj, now);
+
             return false;
         }
 
@@ -184,26 +202,32 @@ bool SpectrogramData::append(UAVObject *multiObj)
 
         uint16_t valuesToProcess = newWindowWidth; // Store the number of samples expected
 
-        // Can happen when changing the FFTP Window Width
+        // Check that there is a full window worth of data. While GCS is starting up, the size of
+        // multiple instance UAVOs is 1, so it's possible for spurious data to come in before
+        // the flight controller board has had time to initialize the UAVO size.
+
         if (mathFunction == "FFT") {
+            // Can happen when changing the FFTP Window Width
             if (!((valuesToProcess != 0) && ((valuesToProcess & (valuesToProcess - 1)) == 0))) {
                 return false;
             }
-            newWindowWidth /= 2; // FFT Output is half
-        }
-
-        // Check that there is a full window worth of data. While GCS is starting up, the size of
-        // multiple instance UAVOs is 1, so it's possible for spurious data to come in before
-        // the flight controller board has had time to initialize the UAVO size.
 
-        if (newWindowWidth != windowWidth) {
-            windowWidth = newWindowWidth;
+            // The board's windows follow on from each other, so the transform
+            // can be longer than one of them, for a finer frequency resolution
+            unsigned int fftLength = 2;
+            while (fftLength < qMax(windowWidth, (unsigned int)valuesToProcess))
+                fftLength *= 2;
+
+            // Check if the fft_object was already created or needs to be updated
+            // May happen if settings change after the spectrogram was created
+            if (fft_object == NULL || fft_object->get_length() != (long)fftLength)
+                setFftLength(fftLength);
+        } else if (newWindowWidth != rasterData->columns()) {
             clearPlots();
-
             plotData.clear();
-            rasterData->setValueMatrix(*zDataHistory, windowWidth);
+            rasterData->reset(newWindowWidth);
 
-            qDebug() << "Spectrogram width adjusted to " << windowWidth;
+            qDebug() << "Spectrogram width adjusted to " << newWindowWidth;
         }
 
         UAVObjectField *multiField = multiObj->getField(uavFieldName);
@@ -232,6 +256,7 @@ bool SpectrogramData::append(UAVObject *multiObj)
                             fprintf(stderr, "Out of order index. Got %d expected %d\n",
                                     currentIndex, lastInstanceIndex + 1);
                             plotData.clear();
+                            streamedSamples.clear(); // The stream has a gap now
                             lastInstanceIndex = -1; // Next index will be 0
                             return false;
                         }
@@ -240,9 +265,11 @@ bool SpectrogramData::append(UAVObject *multiObj)
                     }
                 }
 
-                for (int i = 0; i < numElements; i++) {
-                    double currentValue =
-                        field->getValue(i).toDouble() / scale; // Get the value and scale it
+                // Read the elements straight from the data, without a QVariant each
+                UAVObjectField::Accessor values = field->getAccessor(0);
+
+                for (int i = 0; i < numElements && values.isValid(); i++) {
+                    double currentValue = values.at(i) / scale; // Get the value and scale it
 
                     // Normally some math would go here, modifying currentValue before appending it
                     // to values
@@ -271,66 +298,199 @@ bool SpectrogramData::append(UAVObject *multiObj)
             // update the original vector. This will allow using the same code
             // to display the information.
             if (mathFunction == "FFT") {
+                streamSamples(now);
+            } else {
+                appendRow(plotData, now);
+            }
 
-                // Check if the fft_object was already created or needs to be updated
-                // May happen if settings change after the spectrogram was created
-                if (fft_object == NULL || fft_object->get_length() != valuesToProcess) {
-                    if (fft_object != NULL)
-                        delete fft_object;
+            plotData.clear();
+            lastInstanceIndex = -1; // Next index will be 0
 
-                    fft_object = new ffft::FFTReal<double>(valuesToProcess);
-                }
+            return true;
+        }
+    }
 
-                // Hanning Window
-                for (int i = 0; i < valuesToProcess; i++) {
-                    plotData[i] *= pow(sin(PI * i / (valuesToProcess - 1)), 2);
-                }
+    return false;
+}
 
-                QVector<double> fftout(valuesToProcess);
+/**
+ * @brief SpectrogramData::setFftLength Sets up the transform and drops
+ * everything plotted with the old one
+ * @param length Power of two
+ */
+void SpectrogramData::setFftLength(int length)
+{
+    if (fft_object != NULL)
+        delete fft_object;
 
-                fft_object->do_fft(&fftout[0], plotData.data()); // Do FFT
-                plotData.clear(); // Clear vector
+    fft_object = new ffft::FFTReal<double>(length);
 
-                // Lets get the magnitude and scale it.
-                // mag = X * sqrt(re^2 + im^2)/n
-                // X (4.2) is chosen so that the magnitude presented is similar to the acceleration
-                // registered
-                // although this is not 100% correct, it helps users understanding the spectrogram.
-                for (unsigned int i = 0; i < valuesToProcess / 2; i++) {
-                    plotData << 4.2
-                            * sqrt(pow(fftout[i], 2) + pow(fftout[valuesToProcess / 2 + i], 2))
-                            / valuesToProcess;
-                }
-            }
+    // Hanning Window, worked out once instead of for every transform
+    hannWindow.resize(length);
+    for (int i = 0; i < length; i++) {
+        hannWindow[i] = pow(sin(PI * i / (length - 1)), 2);
+    }
 
-            // Apply autoscale if enabled
-            if (zMaximum == 0) {
-                for (unsigned int i = 0; i < windowWidth; i++) {
-                    // See if autoscale is turned on and if the value exceeds the maximum for the
-                    // scope.
-                    if (plotData[i] > rasterData->interval(Qt::ZAxis).maxValue()) {
-                        // Change scope maximum and color depth
-                        rasterData->setInterval(Qt::ZAxis, QwtInterval(0, plotData[i]));
-                        autoscaleValueUpdated = plotData[i];
-                    }
-                }
-            }
+    fftIn.resize(length);
+    fftOut.resize(length);
+    rowData.resize(length / 2);
+    streamedSamples.clear();
+
+    clearPlots();
+    rasterData->reset(length / 2); // FFT Output is half
 
-            timeDataHistory->append(NOW.toTime_t() + NOW.time().msec() / 1000.0);
-            while (timeDataHistory->back() - timeDataHistory->front() > timeHorizon) {
-                timeDataHistory->pop_front();
-                zDataHistory->remove(0, fminl(windowWidth, zDataHistory->size()));
+    qDebug() << "Spectrogram FFT length adjusted to " << length;
+}
+
+/**
+ * @brief SpectrogramData::streamSamples Adds the samples in plotData to the
+ * stream, and plots a spectrum for every quarter transform length of them
+ * @param time When the last sample was received
+ */
+void SpectrogramData::streamSamples(double time)
+{
+    const int length = fft_object->get_length();
+    const int half = length / 2;
+
+    streamedSamples += plotData;
+
+    while (streamedSamples.size() >= length) {
+        double rowTime = time;
+
+        // Place the row at its newest sample, when the rate is known
+        if (samplingFrequency > 0)
+            rowTime -= (streamedSamples.size() - length) / samplingFrequency;
+
+        const double *samples = streamedSamples.constData();
+        const double *window = hannWindow.constData();
+        double *in = fftIn.data();
+
+        for (int i = 0; i < length; i++) {
+            in[i] = samples[i] * window[i];
+        }
+
+        fft_object->do_fft(fftOut.data(), in); // Do FFT
+
+        // Lets get the magnitude and scale it.
+        // mag = X * sqrt(re^2 + im^2)/n
+        // X (4.2) is chosen so that the magnitude presented is similar to the acceleration
+        // registered
+        // although this is not 100% correct, it helps users understanding the spectrogram.
+        // The output holds the real parts, then the imaginary ones from bin 1 on.
+        const double *out = fftOut.constData();
+
+        rowData[0] = 4.2 * fabs(out[0]) / length;
+        for (int i = 1; i < half; i++) {
+            rowData[i] = 4.2 * sqrt(out[i] * out[i] + out[half + i] * out[half + i]) / length;
+        }
+
+        appendRow(rowData, rowTime);
+
+        streamedSamples.remove(0, length / FFT_OVERLAP);
+    }
+}
+
+/**
+ * @brief SpectrogramData::appendRow Plots a row, checking it for autoscale
+ * @param row At least as many values as the raster has columns
+ * @param time When the row starts
+ */
+void SpectrogramData::appendRow(const QVector<double> &row, double time)
+{
+    int columns = qMin(row.size(), rasterData->columns());
+
+    // Apply autoscale if enabled
+    if (zMaximum == 0) {
+        for (int i = 0; i < columns; i++) {
+            // See if autoscale is turned on and if the value exceeds the maximum for the
+            // scope.
+            if (row[i] > rasterData->interval(Qt::ZAxis).maxValue()) {
+                // Change scope maximum and color depth
+                rasterData->setInterval(Qt::ZAxis, QwtInterval(0, row[i]));
+                autoscaleValueUpdated = row[i];
             }
+        }
+    }
 
-            *zDataHistory << plotData;
-            plotData.clear();
-            lastInstanceIndex = -1; // Next index will be 0
+    double *dest = rasterData->appendRow(time);
 
-            return true;
+    std::copy(row.constBegin(), row.constBegin() + columns, dest);
+    std::fill(dest + columns, dest + rasterData->columns(), 0);
+}
+
+/**
+ * @brief SpectrogramData::appendSpectrum Plots a spectrum computed on board,
+ * such as VibrationAnalysisSpectrum, placing its bands by their width. Where
+ * a band holds one of the peaks the board found, the band is drawn only at
+ * the peak's frequency, which the board knows better than to a band.
+ * @param obj UAVO with the bands in the plotted field
+ * @param time When it was received
+ * @return true if a row was plotted
+ */
+bool SpectrogramData::appendSpectrum(UAVObject *obj, double time)
+{
+    UAVObjectField *field = findField(obj, uavFieldName);
+    UAVObjectField *binWidthField = findField(obj, "binwidth");
+    UAVObjectField *scaleField = findField(obj, "scale");
+    UAVObjectField *peakField = findField(obj, "peakfrequency");
+
+    if (!field || !binWidthField || !scaleField)
+        return false;
+
+    double binWidth = binWidthField->getDouble();
+    double scale = scaleField->getDouble();
+    int bands = field->getNumElements();
+
+    // Nothing computed yet
+    if (binWidth <= 0 || scale <= 0 || xMaximum <= xMinimum)
+        return false;
+
+    int columns = qMax((int)windowWidth, bands * SPECTRUM_COLUMNS_PER_BAND);
+
+    if (columns != rasterData->columns()) {
+        clearPlots();
+        rasterData->reset(columns);
+
+        qDebug() << "Spectrogram width adjusted to " << columns;
+    }
+
+    // Read the elements straight from the data, without a QVariant each
+    UAVObjectField::Accessor values = field->getAccessor(0);
+    if (!values.isValid())
+        return false;
+
+    double columnWidth = (xMaximum - xMinimum) / columns;
+
+    QVector<int> peakColumn(bands, -1);
+    if (peakField) {
+        for (unsigned int i = 0; i < peakField->getNumElements(); i++) {
+            double frequency = peakField->getDouble(i);
+            int band = frequency / binWidth;
+
+            if (frequency > 0 && band < bands && frequency >= xMinimum && frequency < xMaximum)
+                peakColumn[band] = (frequency - xMinimum) / columnWidth;
         }
     }
 
-    return false;
+    rowData.fill(0, columns);
+
+    for (int i = 0; i < columns; i++) {
+        int band = (xMinimum + (i + 0.5) * columnWidth) / binWidth;
+
+        if (band >= 0 && band < bands && peakColumn[band] < 0)
+            rowData[i] = values.at(band) / scale;
+    }
+
+    for (int band = 0; band < bands; band++) {
+        int i = peakColumn[band];
+
+        if (i >= 0)
+            rowData[i] = qMax(rowData[i], values.at(band) / scale);
+    }
+
+    appendRow(rowData, time);
+
+    return true;
 }
 
 /**
@@ -353,8 +513,7 @@ void SpectrogramData::deletePlots(PlotData *spectrogramData)
  */
 void SpectrogramData::clearPlots()
 {
-    timeDataHistory->clear();
-    zDataHistory->clear();
+    rasterData->reset(rasterData->columns());
 
     resetAxisRanges();
 }
@@ -28,9 +28,9 @@
 #define SPECTROGRAMDATA_H
 
 #include "scopes3d/plotdata3d.h"
+#include "scopes3d/spectrogramrasterdata.h"
 #include "uavobjects/uavobject.h"
 #include "qwt/src/qwt_plot_spectrogram.h"
-#include "qwt/src/qwt_matrix_raster_data.h"
 
 #include <QTimer>
 #include <QTime>
@@ -41,6 +41,11 @@
 /**
  * @brief The SpectrogramData class The spectrogram plot has a fixed size
  * data buffer. All the curves in one plot have the same size buffer.
+ *
+ * With the FFT math function, the samples of consecutive windows are
+ * streamed through one transform, so its length isn't limited to the
+ * window the board sends, and the transforms overlap so that rows come
+ * more often than windows do.
  */
 class SpectrogramData : public Plot3dData
 {
@@ -48,7 +53,7 @@ class SpectrogramData : public Plot3dData
 public:
     SpectrogramData(QString uavObject, QString uavField, double samplingFrequency,
                     unsigned int windowWidth, double timeHorizon);
-    ~SpectrogramData() {}
+    ~SpectrogramData() { delete fft_object; }
 
     /*!
       \brief Append new data to the plot
@@ -78,20 +83,29 @@ public:
     virtual void setZMaximum(double val);
     void clearPlots();
 
-    QwtMatrixRasterData *getRasterData() { return rasterData; }
+    SpectrogramRasterData *getRasterData() { return rasterData; }
     void setSpectrogram(QwtPlotSpectrogram *val) { spectrogram = val; }
 
 private:
     void resetAxisRanges();
+    void setFftLength(int length);
+    void streamSamples(double time);
+    void appendRow(const QVector<double> &row, double time);
+    bool appendSpectrum(UAVObject *obj, double time);
 
     QwtPlotSpectrogram *spectrogram;
-    QwtMatrixRasterData *rasterData;
+    SpectrogramRasterData *rasterData;
 
     double samplingFrequency;
     double timeHorizon;
     unsigned int windowWidth;
     double autoscaleValueUpdated;
     ffft::FFTReal<double> *fft_object;
+    QVector<double> hannWindow;
+    QVector<double> fftIn;
+    QVector<double> fftOut;
+    QVector<double> streamedSamples;
+    QVector<double> rowData;
     QVector<double> plotData;
     int lastInstanceIndex;
 };
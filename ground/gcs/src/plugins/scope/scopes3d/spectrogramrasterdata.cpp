@@ -0,0 +1,184 @@
+/**
+ ******************************************************************************
+ *
+ * @file       spectrogramrasterdata.cpp
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2017
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup ScopePlugin Scope Gadget Plugin
+ * @{
+ * @brief Scrolling row storage for the spectrogram
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "scopes3d/spectrogramrasterdata.h"
+
+#include "qwt/src/qwt_interval.h"
+
+#include <qnumeric.h>
+#include <algorithm>
+
+// Same memory limit as the scope configuration puts on the whole spectrogram
+#define MAX_VALUES 10000000
+#define INITIAL_ROWS 64
+
+SpectrogramRasterData::SpectrogramRasterData()
+    : numColumns(1)
+    , head(0)
+    , count(0)
+    , timeHorizon(60)
+{
+    reset(1);
+}
+
+/**
+ * @brief SpectrogramRasterData::setTimeHorizon Sets how long rows are kept
+ * @param seconds Age after which a row can no longer be seen
+ */
+void SpectrogramRasterData::setTimeHorizon(double seconds)
+{
+    timeHorizon = seconds;
+}
+
+/**
+ * @brief SpectrogramRasterData::reset Drops all the rows
+ * @param columns Number of values in each new row
+ */
+void SpectrogramRasterData::reset(int columns)
+{
+    numColumns = qMax(columns, 1);
+
+    times.resize(INITIAL_ROWS);
+    values.resize(INITIAL_ROWS * numColumns);
+    head = 0;
+    count = 0;
+}
+
+/**
+ * @brief SpectrogramRasterData::appendRow Makes room for a new row after the
+ * newest one, dropping the rows that have scrolled out of sight
+ * @param time When the row's newest sample was taken, in seconds
+ * @return Where to write the row's columns() values
+ */
+double *SpectrogramRasterData::appendRow(double time)
+{
+    // Rows must stay in order for rowAt() to find them
+    if (count && time < times[wrap(count - 1)])
+        time = times[wrap(count - 1)];
+
+    while (count && times[head] <= time - timeHorizon) {
+        head = wrap(1);
+        count--;
+    }
+
+    if (count == times.size())
+        grow();
+
+    if (count == times.size()) {
+        // At the limit; drop the oldest row to make room
+        head = wrap(1);
+        count--;
+    }
+
+    int pos = wrap(count);
+    count++;
+
+    times[pos] = time;
+    return values.data() + pos * numColumns;
+}
+
+/**
+ * @brief SpectrogramRasterData::value Value drawn at a point of the plot
+ * @param x Frequency, spread over the columns
+ * @param y Time, with the newest row at the top of the axis
+ * @return The value, 0 where there is no row yet, NaN outside the plot
+ */
+double SpectrogramRasterData::value(double x, double y) const
+{
+    const QwtInterval xInterval = interval(Qt::XAxis);
+    const QwtInterval yInterval = interval(Qt::YAxis);
+
+    if (!(xInterval.contains(x) && yInterval.contains(y)))
+        return qQNaN();
+
+    if (!count)
+        return 0;
+
+    int row = rowAt(times[wrap(count - 1)] - (yInterval.maxValue() - y));
+
+    if (row < 0)
+        return 0;
+
+    int col = int((x - xInterval.minValue()) / xInterval.width() * numColumns);
+
+    // The maximum of the interval is included
+    if (col >= numColumns)
+        col = numColumns - 1;
+
+    return values[wrap(row) * numColumns + col];
+}
+
+/**
+ * @brief SpectrogramRasterData::rowAt Finds the row covering a time, which
+ * is the oldest one stamped at or after it
+ * @return Index from the oldest row, or -1 if there is none
+ */
+int SpectrogramRasterData::rowAt(double time) const
+{
+    if (time < times[head] || time > times[wrap(count - 1)])
+        return -1;
+
+    int lo = 0;
+    int hi = count - 1;
+
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+
+        if (times[wrap(mid)] >= time)
+            hi = mid;
+        else
+            lo = mid + 1;
+    }
+
+    return lo;
+}
+
+void SpectrogramRasterData::grow()
+{
+    int rows = qMin(times.size() * 2, MAX_VALUES / numColumns);
+
+    if (rows <= times.size())
+        return;
+
+    QVector<double> newTimes(rows);
+    QVector<double> newValues(rows * numColumns);
+
+    for (int i = 0; i < count; i++) {
+        const double *src = values.constData() + wrap(i) * numColumns;
+
+        newTimes[i] = times[wrap(i)];
+        std::copy(src, src + numColumns, newValues.data() + i * numColumns);
+    }
+
+    times.swap(newTimes);
+    values.swap(newValues);
+    head = 0;
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,78 @@
+/**
+ ******************************************************************************
+ *
+ * @file       spectrogramrasterdata.h
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2017
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup ScopePlugin Scope Gadget Plugin
+ * @{
+ * @brief Scrolling row storage for the spectrogram
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef SPECTROGRAMRASTERDATA_H
+#define SPECTROGRAMRASTERDATA_H
+
+#include <QVector>
+
+#include "qwt/src/qwt_raster_data.h"
+
+/**
+ * @brief The SpectrogramRasterData class Keeps the spectrogram rows, each
+ * stamped with the time of its newest sample, in a ring. A new row is written
+ * in place of the oldest one, so nothing is copied when the plot moves on.
+ * The y axis is time: its top is the newest row, and each row is drawn from
+ * the time of the row before it, so the rows keep their real spacing however
+ * unevenly they arrive.
+ */
+class SpectrogramRasterData : public QwtRasterData
+{
+public:
+    SpectrogramRasterData();
+
+    void setTimeHorizon(double seconds);
+
+    void reset(int columns);
+    int columns() const { return numColumns; }
+
+    double *appendRow(double time);
+
+    virtual double value(double x, double y) const;
+
+private:
+    QVector<double> values;
+    QVector<double> times;
+    int numColumns;
+    int head;
+    int count;
+    double timeHorizon;
+
+    int wrap(int i) const
+    {
+        i += head;
+        return (i >= times.size()) ? i - times.size() : i;
+    }
+    int rowAt(double time) const;
+    void grow();
+};
+
+#endif // SPECTROGRAMRASTERDATA_H
+
+/**
+ * @}
+ * @}
+ */
@@ -272,27 +272,6 @@ void SpectrogramScopeConfig::loadConfiguration(ScopeGadgetWidget *scopeGadgetWid
     plotSpectrogram->setRenderHint(QwtPlotItem::RenderAntialiased);
     plotSpectrogram->setColorMap(new ColorMap(colorMapType));
 
-    // Initial raster data
-
-    QDateTime NOW =
-        QDateTime::currentDateTime(); // TODO: Upgrade this to show UAVO time and not system time
-    for (uint i = 0; i < timeHorizon; i++) {
-        spectrogramData->timeDataHistory->append(NOW.toTime_t() + NOW.time().msec() / 1000.0 + i);
-    }
-
-    if (((double)windowWidth) * timeHorizon < (double)10000000.0
-            * sizeof(spectrogramData->zDataHistory->front())) { // Don't exceed 10MB for memory
-        for (uint i = 0; i < windowWidth * timeHorizon; i++) {
-            spectrogramData->zDataHistory->append(0);
-        }
-    } else {
-        qDebug() << "For some reason, we're trying to allocate a gigantic spectrogram. This "
-                    "probably represents a problem in the configuration file. TimeHorizion: "
-                 << timeHorizon << ", windowWidth: " << windowWidth;
-        Q_ASSERT(0);
-        return;
-    }
-
     // Set up colorbar on right axis
     spectrogramData->rightAxis = scopeGadgetWidget->axisWidget(QwtPlot::yRight);
     spectrogramData->rightAxis->setTitle("Intensity");
@@ -57,6 +57,11 @@ class ScopeConfig : public QObject
 {
     Q_OBJECT
 public:
+    ScopeConfig()
+        : m_openGLCanvas(false)
+    {
+    }
+
     virtual int getScopeDimensions() = 0;
     virtual void saveConfiguration(QSettings *qSettings) = 0;
     virtual int getScopeType() = 0;
@@ -65,6 +70,8 @@ public:
 
     int getRefreshInterval() { return m_refreshInterval; }
     void setRefreshInterval(int val) { m_refreshInterval = val; }
+    bool getOpenGLCanvas() { return m_openGLCanvas; }
+    void setOpenGLCanvas(bool val) { m_openGLCanvas = val; }
 
     virtual void preparePlot(ScopeGadgetWidget *) = 0;
     virtual ScopeConfig *cloneScope(ScopeConfig *histogramSourceConfigs) = 0;
@@ -72,6 +79,7 @@ public:
 protected:
     int m_refreshInterval; // The interval to replot the curve widget. The data buffer is refresh as
                            // the data comes in.
+    bool m_openGLCanvas; // Draw the plot with OpenGL rather than the raster painter
     PlotDimensions m_plotDimensions;
 
     QString getUavObjectFieldUnits(QString uavObjectName, QString uavObjectFieldName)
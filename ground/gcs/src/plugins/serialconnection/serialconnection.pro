@@ -12,11 +12,13 @@ include(../../plugins/coreplugin/coreplugin.pri)
 HEADERS += serialplugin.h \
             serialpluginconfiguration.h \
             serialpluginoptionspage.h \
-            serialdevice.h
+            serialdevice.h \
+            threadedserialport.h
 SOURCES += serialplugin.cpp \
             serialpluginconfiguration.cpp \
             serialpluginoptionspage.cpp \
-            serialdevice.cpp
+            serialdevice.cpp \
+            threadedserialport.cpp
 FORMS += \
     serialpluginoptions.ui
 
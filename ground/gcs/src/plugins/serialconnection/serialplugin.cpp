@@ -26,6 +26,7 @@
 
 #include "serialplugin.h"
 #include "serialdevice.h"
+#include "threadedserialport.h"
 
 #include <extensionsystem/pluginmanager.h>
 #include <coreplugin/icore.h>
@@ -140,15 +141,9 @@ QIODevice *SerialConnection::openDevice(IDevice *deviceName)
         if (port.portName() == deviceName->getName()) {
             // we need to handle port settings here...
 
-            serialHandle = new QSerialPort(port);
+            serialHandle = new ThreadedSerialPort(port, m_config->speed().toInt());
             if (serialHandle->open(QIODevice::ReadWrite)) {
-                if (serialHandle->setBaudRate(m_config->speed().toInt())
-                    && serialHandle->setDataBits(QSerialPort::Data8)
-                    && serialHandle->setParity(QSerialPort::NoParity)
-                    && serialHandle->setStopBits(QSerialPort::OneStop)
-                    && serialHandle->setFlowControl(QSerialPort::NoFlowControl)) {
-                    m_deviceOpened = true;
-                }
+                m_deviceOpened = true;
             }
             return serialHandle;
         }
@@ -39,6 +39,7 @@
 class IConnection;
 class QSerialPortInfo;
 class SerialConnection;
+class ThreadedSerialPort;
 
 /**
 *   Define a connection via the IConnection interface
@@ -66,7 +67,7 @@ public:
     SerialPluginOptionsPage *Optionspage() const { return m_optionspage; }
 
 private:
-    QSerialPort *serialHandle;
+    ThreadedSerialPort *serialHandle;
     bool enablePolling;
     SerialPluginConfiguration *m_config;
     SerialPluginOptionsPage *m_optionspage;
@@ -0,0 +1,265 @@
+/**
+ ******************************************************************************
+ * @file       threadedserialport.cpp
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2017
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup SerialPlugin Serial Connection Plugin
+ * @{
+ * @brief A serial port serviced by its own thread
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ * Additional note on redistribution: The copyright and license notices above
+ * must be maintained in each individual source file that is a derivative work
+ * of this source file; otherwise redistribution is prohibited.
+ */
+
+#include "threadedserialport.h"
+
+#include <QTimer>
+
+#include <climits>
+
+// 64 KiB each way
+static const int RING_ORDER = 16;
+
+// Bytes moved between a ring and the port at a time
+static const int CHUNK_SIZE = 4096;
+
+// How long to leave the port when the reader has let the ring fill
+static const int FULL_RETRY_MS = 1;
+
+SerialPortWorker::SerialPortWorker(const QSerialPortInfo &info, qint32 baudRate)
+    : m_info(info)
+    , m_baudRate(baudRate)
+    , m_port(NULL)
+    , m_readRing(RING_ORDER)
+    , m_readSignalPending(0)
+    , m_writeRing(RING_ORDER)
+    , m_writePending(0)
+    , m_portBacklog(0)
+{
+}
+
+/**
+ * @brief Opens and sets up the port; runs in the port thread
+ * @return true if the port is ready to use
+ */
+bool SerialPortWorker::openPort()
+{
+    m_port = new QSerialPort(m_info, this);
+
+    connect(m_port, &QSerialPort::readyRead, this, &SerialPortWorker::readPort);
+    connect(m_port, &QSerialPort::bytesWritten, this, &SerialPortWorker::updateBacklog);
+
+    return m_port->open(QIODevice::ReadWrite) && m_port->setBaudRate(m_baudRate)
+        && m_port->setDataBits(QSerialPort::Data8) && m_port->setParity(QSerialPort::NoParity)
+        && m_port->setStopBits(QSerialPort::OneStop)
+        && m_port->setFlowControl(QSerialPort::NoFlowControl);
+}
+
+void SerialPortWorker::closePort()
+{
+    if (!m_port)
+        return;
+
+    m_port->close();
+    delete m_port;
+    m_port = NULL;
+}
+
+/**
+ * @brief Queues bytes for the port; called from the thread using the
+ * ThreadedSerialPort
+ * @return how much was queued
+ */
+int SerialPortWorker::write(const char *data, int size)
+{
+    int written = m_writeRing.write(data, size);
+
+    if (written && m_writePending.testAndSetOrdered(0, 1))
+        QMetaObject::invokeMethod(this, "writePort", Qt::QueuedConnection);
+
+    return written;
+}
+
+void SerialPortWorker::readPort()
+{
+    if (!m_port)
+        return;
+
+    char buffer[CHUNK_SIZE];
+    bool wrote = false;
+
+    while (m_port->bytesAvailable() > 0) {
+        int size = qMin(m_readRing.space(), CHUNK_SIZE);
+        if (size <= 0)
+            break;
+
+        size = m_port->read(buffer, size);
+        if (size <= 0)
+            break;
+
+        m_readRing.write(buffer, size);
+        wrote = true;
+    }
+
+    if (wrote && m_readSignalPending.testAndSetOrdered(0, 1))
+        emit readyToRead();
+
+    // The port won't say again until more arrives, so come back for the rest
+    if (m_port->bytesAvailable() > 0)
+        QTimer::singleShot(FULL_RETRY_MS, this, &SerialPortWorker::readPort);
+}
+
+void SerialPortWorker::writePort()
+{
+    // Anything queued from here on asks again
+    m_writePending.storeRelease(0);
+
+    if (!m_port) {
+        char discard[CHUNK_SIZE];
+        while (m_writeRing.read(discard, sizeof(discard)) > 0) {
+        }
+        return;
+    }
+
+    char buffer[CHUNK_SIZE];
+    int size;
+
+    while ((size = m_writeRing.read(buffer, sizeof(buffer))) > 0)
+        m_port->write(buffer, size);
+
+    updateBacklog();
+}
+
+void SerialPortWorker::updateBacklog()
+{
+    m_portBacklog.storeRelease(m_port ? static_cast<int>(m_port->bytesToWrite()) : 0);
+}
+
+// *********************************************************************************
+
+ThreadedSerialPort::ThreadedSerialPort(const QSerialPortInfo &info, qint32 baudRate,
+                                       QObject *parent)
+    : QIODevice(parent)
+    , m_info(info)
+    , m_baudRate(baudRate)
+    , m_worker(NULL)
+{
+    m_thread.setObjectName("Serial " + info.portName());
+}
+
+ThreadedSerialPort::~ThreadedSerialPort()
+{
+    close();
+}
+
+bool ThreadedSerialPort::open(OpenMode mode)
+{
+    if (m_worker)
+        return false;
+
+    m_worker = new SerialPortWorker(m_info, m_baudRate);
+    m_worker->moveToThread(&m_thread);
+
+    connect(m_worker, &SerialPortWorker::readyToRead, this, &ThreadedSerialPort::sendReadyRead);
+
+    m_thread.start();
+
+    // The port has to be made in the thread that services it
+    bool opened = false;
+    QMetaObject::invokeMethod(m_worker, "openPort", Qt::BlockingQueuedConnection,
+                              Q_RETURN_ARG(bool, opened));
+
+    if (!opened) {
+        stop();
+        return false;
+    }
+
+    return QIODevice::open(mode);
+}
+
+void ThreadedSerialPort::close()
+{
+    stop();
+
+    if (isOpen())
+        QIODevice::close();
+}
+
+void ThreadedSerialPort::stop()
+{
+    if (!m_worker)
+        return;
+
+    QMetaObject::invokeMethod(m_worker, "closePort", Qt::BlockingQueuedConnection);
+
+    m_thread.quit();
+    m_thread.wait();
+
+    // The thread is gone, so nothing else can be touching it
+    delete m_worker;
+    m_worker = NULL;
+}
+
+void ThreadedSerialPort::sendReadyRead()
+{
+    if (!m_worker)
+        return;
+
+    // Anything that arrives from here on gets another signal
+    m_worker->readyToReadHandled();
+
+    emit readyRead();
+}
+
+qint64 ThreadedSerialPort::bytesAvailable() const
+{
+    if (!m_worker)
+        return QIODevice::bytesAvailable();
+
+    return m_worker->bytesAvailable() + QIODevice::bytesAvailable();
+}
+
+qint64 ThreadedSerialPort::bytesToWrite() const
+{
+    if (!m_worker)
+        return 0;
+
+    return m_worker->bytesToWrite();
+}
+
+qint64 ThreadedSerialPort::readData(char *data, qint64 maxSize)
+{
+    if (!m_worker)
+        return -1;
+
+    return m_worker->read(data, static_cast<int>(qMin<qint64>(maxSize, INT_MAX)));
+}
+
+qint64 ThreadedSerialPort::writeData(const char *data, qint64 maxSize)
+{
+    if (!m_worker)
+        return -1;
+
+    return m_worker->write(data, static_cast<int>(qMin<qint64>(maxSize, INT_MAX)));
+}
+
+/**
+ * @}
+ * @}
+ */
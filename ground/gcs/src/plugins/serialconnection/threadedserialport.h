@@ -0,0 +1,130 @@
+/**
+ ******************************************************************************
+ * @file       threadedserialport.h
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2017
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup SerialPlugin Serial Connection Plugin
+ * @{
+ * @brief A serial port serviced by its own thread
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ * Additional note on redistribution: The copyright and license notices above
+ * must be maintained in each individual source file that is a derivative work
+ * of this source file; otherwise redistribution is prohibited.
+ */
+
+#ifndef THREADEDSERIALPORT_H
+#define THREADEDSERIALPORT_H
+
+#include <QAtomicInt>
+#include <QIODevice>
+#include <QThread>
+#include <QtSerialPort/QSerialPort>
+#include <QtSerialPort/QSerialPortInfo>
+
+#include "utils/bytering.h"
+
+/**
+ * @brief Owns the QSerialPort, in the port thread.  Bytes pass to and from
+ * the ThreadedSerialPort through a ring each way.
+ */
+class SerialPortWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    SerialPortWorker(const QSerialPortInfo &info, qint32 baudRate);
+
+    //! The rest are called from the thread using the ThreadedSerialPort
+    int read(char *data, int size) { return m_readRing.read(data, size); }
+    int bytesAvailable() const { return m_readRing.available(); }
+    void readyToReadHandled() { m_readSignalPending.storeRelease(0); }
+
+    int write(const char *data, int size);
+    qint64 bytesToWrite() const { return m_writeRing.available() + m_portBacklog.loadAcquire(); }
+
+public slots:
+    bool openPort();
+    void closePort();
+
+signals:
+    //! Queued to the reader, once until it calls readyToReadHandled
+    void readyToRead();
+
+private slots:
+    void readPort();
+    void writePort();
+    void updateBacklog();
+
+private:
+    QSerialPortInfo m_info;
+    qint32 m_baudRate;
+    QSerialPort *m_port;
+
+    Utils::ByteRing m_readRing;
+    QAtomicInt m_readSignalPending;
+
+    Utils::ByteRing m_writeRing;
+    QAtomicInt m_writePending;
+    //! What the QSerialPort holds, which only the port thread may ask it
+    QAtomicInt m_portBacklog;
+};
+
+/**
+ * @brief The device handed to the connection manager.  The QSerialPort
+ * lives in a thread of its own, so reading it keeps up while the main
+ * thread is busy, and the reader gets at most one readyRead waiting at a
+ * time however many chunks the port delivers.
+ */
+class ThreadedSerialPort : public QIODevice
+{
+    Q_OBJECT
+
+public:
+    ThreadedSerialPort(const QSerialPortInfo &info, qint32 baudRate, QObject *parent = 0);
+    virtual ~ThreadedSerialPort();
+
+    virtual bool open(OpenMode mode);
+    virtual void close();
+    virtual bool isSequential() const { return true; }
+
+    virtual qint64 bytesAvailable() const;
+    virtual qint64 bytesToWrite() const;
+
+protected:
+    virtual qint64 readData(char *data, qint64 maxSize);
+    virtual qint64 writeData(const char *data, qint64 maxSize);
+
+private slots:
+    void sendReadyRead();
+
+private:
+    void stop();
+
+    QSerialPortInfo m_info;
+    qint32 m_baudRate;
+
+    QThread m_thread;
+    SerialPortWorker *m_worker;
+};
+
+#endif // THREADEDSERIALPORT_H
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,20 @@
+TEMPLATE = lib
+QT += widgets
+TARGET = ShmConnection
+
+include(../../gcsplugin.pri)
+
+include(../../libs/extensionsystem/extensionsystem.pri)
+
+include(../../plugins/coreplugin/coreplugin.pri)
+
+HEADERS += shmconnectionplugin.h \
+    shmconnection_global.h \
+    shmdevice.h
+
+SOURCES += shmconnectionplugin.cpp \
+    shmdevice.cpp
+
+DEFINES += SHMCONNECTION_LIBRARY
+
+OTHER_FILES += ShmConnection.pluginspec
@@ -0,0 +1,38 @@
+/**
+ ******************************************************************************
+ *
+ * @file       shmconnection_global.h
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2017
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup ShmConnPlugin Shared Memory Telemetry Plugin
+ * @{
+ * @brief Telemetry to a simulator on this host through shared memory
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef SHMCONNECTION_GLOBAL_H
+#define SHMCONNECTION_GLOBAL_H
+
+#include <QtCore/qglobal.h>
+
+#if defined(SHMCONNECTION_LIBRARY)
+#define SHMCONNECTION_EXPORT Q_DECL_EXPORT
+#else
+#define SHMCONNECTION_EXPORT Q_DECL_IMPORT
+#endif
+
+#endif // SHMCONNECTION_GLOBAL_H
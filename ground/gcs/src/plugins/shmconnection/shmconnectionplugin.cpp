@@ -0,0 +1,176 @@
+/**
+ ******************************************************************************
+ *
+ * @file       shmconnectionplugin.cpp
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2017
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup ShmConnPlugin Shared Memory Telemetry Plugin
+ * @{
+ * @brief Telemetry to a simulator on this host through shared memory
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "shmconnectionplugin.h"
+
+#include <coreplugin/icore.h>
+
+#include <QtCore/QtPlugin>
+#include <QDir>
+#include <QFileInfo>
+#include <QMainWindow>
+#include <QMessageBox>
+
+//! Where flightd is normally told to put its files (-S telemetry:shm:/dev/shm/dronin...)
+static const char *SHM_DIR = "/dev/shm";
+static const char *SHM_PATTERN = "dronin*";
+
+ShmConnection::ShmConnection()
+    : shmHandle(nullptr)
+{
+    connect(&periodicTimer, &QTimer::timeout, this, &ShmConnection::periodic);
+    periodicTimer.start(1000);
+}
+
+ShmConnection::~ShmConnection()
+{
+    closeDevice(QString());
+}
+
+void ShmConnection::periodic()
+{
+    if (!shmHandle) {
+        availableDevices();
+
+        // Ignore the output, as availableDevices signals
+    }
+}
+
+QList<Core::IDevice *> ShmConnection::availableDevices()
+{
+    QStringList files;
+
+    QDir dir(SHM_DIR);
+    if (dir.exists()) {
+        for (const auto &name :
+             dir.entryList(QStringList() << SHM_PATTERN, QDir::Files, QDir::Name))
+            files.append(dir.absoluteFilePath(name));
+    }
+
+    bool changed = false;
+
+    // add new devices
+    for (const auto &file : files) {
+        bool found = false;
+        for (auto dev : devices) {
+            if (dev->getName() == file) {
+                found = true;
+                break;
+            }
+        }
+        if (!found) {
+            auto dev = new ShmDevice();
+            dev->setDisplayName(QString("shm:%0").arg(QFileInfo(file).fileName()));
+            dev->setName(file);
+            devices.append(dev);
+
+            changed = true;
+        }
+    }
+
+    // clear out removed devices
+    for (int i = 0; i < devices.length();) {
+        if (!files.contains(devices.at(i)->getName())) {
+            devices.at(i)->deleteLater();
+            devices.removeAt(i);
+
+            changed = true;
+        } else {
+            i++;
+        }
+    }
+
+    if (changed)
+        emit availableDevChanged(this);
+
+    return devices;
+}
+
+QIODevice *ShmConnection::openDevice(Core::IDevice *device)
+{
+    auto *dev = qobject_cast<ShmDevice *>(device);
+    if (!dev)
+        return nullptr;
+
+    closeDevice(QString());
+
+    shmHandle = new ShmIODevice(dev->getName(), this);
+
+    if (shmHandle->open(QIODevice::ReadWrite))
+        return shmHandle;
+
+    QMessageBox msgBox(QMessageBox::Critical, tr("Connection Failed"), shmHandle->errorString(),
+                       QMessageBox::Ok,
+                       static_cast<QWidget *>(Core::ICore::instance()->mainWindow()));
+
+    delete shmHandle;
+    shmHandle = nullptr;
+
+    msgBox.exec();
+
+    return nullptr;
+}
+
+void ShmConnection::closeDevice(const QString &)
+{
+    if (shmHandle) {
+        shmHandle->close();
+        delete shmHandle;
+        shmHandle = nullptr;
+    }
+}
+
+QString ShmConnection::connectionName()
+{
+    return QString("Shared memory telemetry");
+}
+
+QString ShmConnection::shortName()
+{
+    return tr("Shm");
+}
+
+ShmConnectionPlugin::ShmConnectionPlugin()
+{
+}
+
+ShmConnectionPlugin::~ShmConnectionPlugin()
+{
+}
+
+void ShmConnectionPlugin::extensionsInitialized()
+{
+    addAutoReleasedObject(m_connection);
+}
+
+bool ShmConnectionPlugin::initialize(const QStringList &arguments, QString *errorString)
+{
+    Q_UNUSED(arguments);
+    Q_UNUSED(errorString);
+    m_connection = new ShmConnection();
+
+    return true;
+}
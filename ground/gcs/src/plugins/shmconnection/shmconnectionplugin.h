@@ -0,0 +1,78 @@
+/**
+ ******************************************************************************
+ *
+ * @file       shmconnectionplugin.h
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2017
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup ShmConnPlugin Shared Memory Telemetry Plugin
+ * @{
+ * @brief Telemetry to a simulator on this host through shared memory
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef SHMCONNECTIONPLUGIN_H
+#define SHMCONNECTIONPLUGIN_H
+
+#include "shmconnection_global.h"
+#include "coreplugin/iconnection.h"
+#include "shmdevice.h"
+#include <extensionsystem/iplugin.h>
+
+#include <QTimer>
+
+/**
+*   Offers each telemetry file flightd is sharing in /dev/shm as a device
+*/
+class SHMCONNECTION_EXPORT ShmConnection : public Core::IConnection
+{
+    Q_OBJECT
+public:
+    ShmConnection();
+    virtual ~ShmConnection();
+
+    virtual QList<Core::IDevice *> availableDevices();
+    virtual QIODevice *openDevice(Core::IDevice *deviceName);
+    virtual void closeDevice(const QString &deviceName);
+
+    virtual QString connectionName();
+    virtual QString shortName();
+
+protected slots:
+    void periodic();
+
+private:
+    ShmIODevice *shmHandle;
+    QList<Core::IDevice *> devices;
+    QTimer periodicTimer;
+};
+
+class SHMCONNECTION_EXPORT ShmConnectionPlugin : public ExtensionSystem::IPlugin
+{
+    Q_OBJECT
+    Q_PLUGIN_METADATA(IID "org.dronin.plugins.ShmConnection")
+public:
+    ShmConnectionPlugin();
+    ~ShmConnectionPlugin();
+
+    virtual bool initialize(const QStringList &arguments, QString *error_message);
+    virtual void extensionsInitialized();
+
+private:
+    ShmConnection *m_connection;
+};
+
+#endif // SHMCONNECTIONPLUGIN_H
@@ -0,0 +1,210 @@
+/**
+ ******************************************************************************
+ *
+ * @file       shmdevice.cpp
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2017
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup ShmConnPlugin Shared Memory Telemetry Plugin
+ * @{
+ * @brief Telemetry to a simulator on this host through shared memory
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "shmdevice.h"
+
+#include <QAtomicInteger>
+
+// Must match pios_shm_priv.h
+static const quint32 SHM_MAGIC = 0x4d485344;
+static const qint64 SHM_HEADER_SIZE = 16;
+static const qint64 SHM_RING_HEADER_SIZE = 8;
+
+ShmDevice::ShmDevice()
+{
+}
+
+ShmIODevice::ShmIODevice(const QString &path, QObject *parent)
+    : QIODevice(parent)
+    , m_file(path)
+    , m_map(nullptr)
+    , m_ringSize(0)
+{
+    connect(&m_pollTimer, &QTimer::timeout, this, &ShmIODevice::poll);
+}
+
+ShmIODevice::~ShmIODevice()
+{
+    close();
+}
+
+quint32 *ShmIODevice::word(qint64 offset) const
+{
+    return reinterpret_cast<quint32 *>(m_map + offset);
+}
+
+static quint32 loadAcquire(quint32 *p)
+{
+    return reinterpret_cast<QAtomicInteger<quint32> *>(p)->loadAcquire();
+}
+
+static void storeRelease(quint32 *p, quint32 val)
+{
+    reinterpret_cast<QAtomicInteger<quint32> *>(p)->storeRelease(val);
+}
+
+bool ShmIODevice::open(OpenMode mode)
+{
+    if (!m_file.open(QIODevice::ReadWrite)) {
+        setErrorString(m_file.errorString());
+        return false;
+    }
+
+    if (m_file.size() < SHM_HEADER_SIZE) {
+        setErrorString(tr("%0 is not a telemetry file").arg(m_file.fileName()));
+        m_file.close();
+        return false;
+    }
+
+    m_ringSize = 0;
+    m_file.seek(4);
+    m_file.read(reinterpret_cast<char *>(&m_ringSize), sizeof(m_ringSize));
+
+    qint64 needed = SHM_HEADER_SIZE + 2 * (SHM_RING_HEADER_SIZE + m_ringSize);
+
+    if (!m_ringSize || (m_ringSize & (m_ringSize - 1)) || m_file.size() < needed) {
+        setErrorString(tr("%0 is not a telemetry file").arg(m_file.fileName()));
+        m_file.close();
+        return false;
+    }
+
+    m_map = m_file.map(0, needed);
+
+    if (!m_map) {
+        setErrorString(m_file.errorString());
+        m_file.close();
+        return false;
+    }
+
+    // Start from whatever is newest, rather than the backlog from before
+    // we attached
+    qint64 toHost = SHM_HEADER_SIZE;
+    storeRelease(word(toHost + 4), loadAcquire(word(toHost)));
+
+    m_pollTimer.start(1);
+
+    return QIODevice::open(mode | QIODevice::Unbuffered);
+}
+
+void ShmIODevice::close()
+{
+    m_pollTimer.stop();
+
+    if (m_map) {
+        m_file.unmap(m_map);
+        m_map = nullptr;
+    }
+
+    m_file.close();
+
+    QIODevice::close();
+}
+
+bool ShmIODevice::valid() const
+{
+    return m_map && loadAcquire(word(0)) == SHM_MAGIC;
+}
+
+qint64 ShmIODevice::bytesAvailable() const
+{
+    if (!valid())
+        return QIODevice::bytesAvailable();
+
+    qint64 toHost = SHM_HEADER_SIZE;
+    quint32 used = loadAcquire(word(toHost)) - *word(toHost + 4);
+
+    return used + QIODevice::bytesAvailable();
+}
+
+qint64 ShmIODevice::readData(char *data, qint64 maxSize)
+{
+    if (!valid())
+        return 0;
+
+    qint64 toHost = SHM_HEADER_SIZE;
+    quint32 head = loadAcquire(word(toHost));
+    quint32 tail = *word(toHost + 4);
+    const uchar *ring = m_map + toHost + SHM_RING_HEADER_SIZE;
+
+    qint64 len = qMin<qint64>(head - tail, maxSize);
+
+    for (qint64 done = 0; done < len;) {
+        quint32 offset = (tail + done) & (m_ringSize - 1);
+        qint64 chunk = qMin<qint64>(len - done, m_ringSize - offset);
+
+        memcpy(data + done, ring + offset, chunk);
+        done += chunk;
+    }
+
+    storeRelease(word(toHost + 4), tail + len);
+
+    return len;
+}
+
+qint64 ShmIODevice::writeData(const char *data, qint64 maxSize)
+{
+    if (!valid())
+        return -1;
+
+    qint64 toFc = SHM_HEADER_SIZE + SHM_RING_HEADER_SIZE + m_ringSize;
+    quint32 head = *word(toFc);
+    quint32 tail = loadAcquire(word(toFc + 4));
+    uchar *ring = m_map + toFc + SHM_RING_HEADER_SIZE;
+
+    // Like a full socket buffer, take what fits and let the caller retry
+    qint64 len = qMin<qint64>(m_ringSize - (head - tail), maxSize);
+
+    for (qint64 done = 0; done < len;) {
+        quint32 offset = (head + done) & (m_ringSize - 1);
+        qint64 chunk = qMin<qint64>(len - done, m_ringSize - offset);
+
+        memcpy(ring + offset, data + done, chunk);
+        done += chunk;
+    }
+
+    storeRelease(word(toFc), head + len);
+
+    if (len)
+        emit bytesWritten(len);
+
+    return len;
+}
+
+void ShmIODevice::poll()
+{
+    if (!m_map)
+        return;
+
+    if (loadAcquire(word(0)) != SHM_MAGIC) {
+        // flightd went away or is starting over
+        return;
+    }
+
+    qint64 toHost = SHM_HEADER_SIZE;
+
+    if (loadAcquire(word(toHost)) != *word(toHost + 4))
+        emit readyRead();
+}
@@ -0,0 +1,82 @@
+/**
+ ******************************************************************************
+ *
+ * @file       shmdevice.h
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2017
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup ShmConnPlugin Shared Memory Telemetry Plugin
+ * @{
+ * @brief Telemetry to a simulator on this host through shared memory
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef SHMDEVICE_H
+#define SHMDEVICE_H
+
+#include <coreplugin/idevice.h>
+
+#include <QFile>
+#include <QIODevice>
+#include <QTimer>
+
+/**
+ * A shared file flightd is serving telemetry through (-S telemetry:shm:path)
+ */
+class ShmDevice : public Core::IDevice
+{
+    Q_OBJECT
+
+public:
+    ShmDevice();
+};
+
+/**
+ * Reads and writes the rings in the shared file.  The layout is described
+ * in flight/PiOS/posix/inc/pios_shm_priv.h.  There's nothing to wait on,
+ * so the file is polled for new data every millisecond.
+ */
+class ShmIODevice : public QIODevice
+{
+    Q_OBJECT
+
+public:
+    explicit ShmIODevice(const QString &path, QObject *parent = nullptr);
+    virtual ~ShmIODevice();
+
+    virtual bool open(OpenMode mode);
+    virtual void close();
+    virtual bool isSequential() const { return true; }
+    virtual qint64 bytesAvailable() const;
+
+protected:
+    virtual qint64 readData(char *data, qint64 maxSize);
+    virtual qint64 writeData(const char *data, qint64 maxSize);
+
+private slots:
+    void poll();
+
+private:
+    bool valid() const;
+    quint32 *word(qint64 offset) const;
+
+    QFile m_file;
+    uchar *m_map;
+    quint32 m_ringSize;
+    QTimer m_pollTimer;
+};
+
+#endif // SHMDEVICE_H
@@ -29,9 +29,13 @@
 #include "extensionsystem/pluginmanager.h"
 #include "uavobjects/uavobjectmanager.h"
 #include "systemalarms.h"
+#include "looplatency.h"
+#include "taskinfo.h"
+#include "irqinfo.h"
 #include <coreplugin/icore.h>
 #include <QDebug>
 #include <QWhatsThis>
+#include <algorithm>
 
 /*
  * Initialize the widget
@@ -64,7 +68,8 @@ SystemHealthGadgetWidget::SystemHealthGadgetWidget(QWidget *parent)
     connect(telMngr, &TelemetryManager::disconnected, this,
             &SystemHealthGadgetWidget::onAutopilotDisconnect);
 
-    setToolTip(tr("Displays flight system errors. Click on an alarm for more information."));
+    setToolTip(tr("Displays flight system errors. Click on an alarm for more information, or "
+                  "on the background for all alarms, loop latency and CPU load."));
 }
 
 /**
@@ -282,6 +287,8 @@ void SystemHealthGadgetWidget::showAllAlarmDescriptions(const QPoint &location)
                 }
             }
         }
+        alarmsText.append(getLoopLatencyDescription());
+        alarmsText.append(getCpuLoadDescription());
         // Show alarms text if we have any
         if (alarmsText.length() > 0) {
             QWhatsThis::showText(location, alarmsText);
@@ -289,6 +296,108 @@ void SystemHealthGadgetWidget::showAllAlarmDescriptions(const QPoint &location)
     }
 }
 
+/**
+ * Format the latest LoopLatency statistics as an HTML table, one row per
+ * stage of the gyro-to-motor path. Empty when the board does not publish them.
+ */
+QString SystemHealthGadgetWidget::getLoopLatencyDescription()
+{
+    ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
+    UAVObjectManager *objManager = pm->getObject<UAVObjectManager>();
+    LoopLatency *obj = LoopLatency::GetInstance(objManager);
+
+    if (!obj || !obj->getIsPresentOnHardware())
+        return QString();
+
+    LoopLatency::DataFields data = obj->getData();
+    if (data.Samples == 0)
+        return QString();
+
+    QStringList stages = obj->getField("Min")->getElementNames();
+    QString text = tr("<h3>Loop latency (&micro;s)</h3>"
+                      "<table cellpadding=\"2\">"
+                      "<tr><th align=\"left\">Stage</th><th>Min</th><th>Mean</th>"
+                      "<th>Max</th><th>P99</th></tr>");
+    for (int i = 0; i < stages.size() && i < LoopLatency::MIN_NUMELEM; i++) {
+        text.append(QString("<tr><td>%1</td><td align=\"right\">%2</td>"
+                            "<td align=\"right\">%3</td><td align=\"right\">%4</td>"
+                            "<td align=\"right\">%5</td></tr>")
+                        .arg(stages[i])
+                        .arg(data.Min[i])
+                        .arg(data.Mean[i])
+                        .arg(data.Max[i])
+                        .arg(data.P99[i]));
+    }
+    text.append("</table>");
+    text.append(tr("<p>%1 samples, measured from the gyro interrupt.</p>").arg(data.Samples));
+
+    return text;
+}
+
+/**
+ * Format the CPU split between tasks and interrupt handlers as HTML tables,
+ * busiest first. Empty when the board does not publish task statistics.
+ */
+QString SystemHealthGadgetWidget::getCpuLoadDescription()
+{
+    ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
+    UAVObjectManager *objManager = pm->getObject<UAVObjectManager>();
+    TaskInfo *taskInfo = TaskInfo::GetInstance(objManager);
+
+    if (!taskInfo || !taskInfo->getIsPresentOnHardware())
+        return QString();
+
+    TaskInfo::DataFields tasks = taskInfo->getData();
+    QStringList taskNames = taskInfo->getField("RunningTime")->getElementNames();
+
+    QList<int> running;
+    for (int i = 0; i < taskNames.size() && i < TaskInfo::RUNNINGTIME_NUMELEM; i++) {
+        if (tasks.Running[i] == TaskInfo::RUNNING_TRUE)
+            running.append(i);
+    }
+    std::sort(running.begin(), running.end(), [&tasks](int a, int b) {
+        return tasks.RunningTime[a] > tasks.RunningTime[b];
+    });
+
+    QString text = tr("<h3>CPU load</h3>"
+                      "<table cellpadding=\"2\">"
+                      "<tr><th align=\"left\">Task</th><th>CPU (%)</th>"
+                      "<th>Free stack (bytes)</th></tr>");
+    foreach (int i, running) {
+        text.append(QString("<tr><td>%1</td><td align=\"right\">%2</td>"
+                            "<td align=\"right\">%3</td></tr>")
+                        .arg(taskNames[i])
+                        .arg(tasks.RunningTime[i])
+                        .arg(tasks.StackRemaining[i]));
+    }
+    text.append("</table>");
+
+    IRQInfo *irqInfo = IRQInfo::GetInstance(objManager);
+    if (!irqInfo || !irqInfo->getIsPresentOnHardware())
+        return text;
+
+    IRQInfo::DataFields irqs = irqInfo->getData();
+
+    text.append(tr("<table cellpadding=\"2\">"
+                   "<tr><th align=\"left\">Interrupt</th><th>CPU (%)</th></tr>"));
+    for (int i = 0; i < IRQInfo::VECTOR_NUMELEM; i++) {
+        if (irqs.Vector[i] == 0)
+            continue;
+
+        // Exception numbers below 16 are core exceptions rather than IRQs
+        QString name = (irqs.Vector[i] < 16) ? tr("Exception %1").arg(irqs.Vector[i])
+                                             : tr("IRQ %1").arg(irqs.Vector[i] - 16);
+        text.append(QString("<tr><td>%1</td><td align=\"right\">%2</td></tr>")
+                        .arg(name)
+                        .arg(irqs.RunningTime[i], 0, 'f', 2));
+    }
+    text.append("</table>");
+    text.append(tr("<p>%1% of the CPU spent in interrupt handlers.</p>")
+                    .arg(irqs.TotalRunningTime, 0, 'f', 2));
+
+    return text;
+}
+
 QString SystemHealthGadgetWidget::getAlarmDescriptionFileName(const QString itemId)
 {
     QString alarmDescriptionFileName;
@@ -71,5 +71,7 @@ private:
     void showAlarmDescriptionForItemId(const QString itemId, const QPoint &location);
     void showAllAlarmDescriptions(const QPoint &location);
     QString getAlarmDescriptionFileName(const QString itemId);
+    QString getLoopLatencyDescription();
+    QString getCpuLoadDescription();
 };
 #endif /* SYSTEMHEALTHGADGETWIDGET_H_ */
@@ -0,0 +1,200 @@
+/**
+ ******************************************************************************
+ * @file       linkusage_dialog.cpp
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2017
+ * @addtogroup Telemetry Scheduler GCS Plugins
+ * @{
+ * @addtogroup TelemetrySchedulerGadgetPlugin Telemetry Scheduler Gadget Plugin
+ * @{
+ * @brief A dialog showing the telemetry link use of each object
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "linkusage_dialog.h"
+#include "telemetryschedulergadgetwidget.h"
+
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QVBoxLayout>
+
+#include "extensionsystem/pluginmanager.h"
+#include "uavobjects/uavdataobject.h"
+#include "gcstelemetrystats.h"
+
+LinkUsageDialog::LinkUsageDialog(TelemetrySchedulerGadgetWidget *scheduler)
+    : QDialog(scheduler)
+    , scheduler(scheduler)
+{
+    ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
+    telMngr = pm->getObject<TelemetryManager>();
+    objMngr = pm->getObject<UAVObjectManager>();
+    Q_ASSERT(telMngr && objMngr);
+
+    setWindowTitle(tr("Link Usage"));
+    resize(640, 480);
+
+    table = new QTableWidget(0, COL_PROJECTED + 1, this);
+    table->setHorizontalHeaderLabels(QStringList()
+                                     << tr("Object") << tr("Downlink [B/s]")
+                                     << tr("Uplink [B/s]") << tr("Packets/s")
+                                     << tr("Share [%]") << tr("Projected [B/s]"));
+    table->horizontalHeader()->setSectionResizeMode(COL_OBJECT, QHeaderView::Stretch);
+    table->verticalHeader()->setVisible(false);
+    table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    table->setAlternatingRowColors(true);
+    table->setSortingEnabled(true);
+
+    scheduleSelect = new QComboBox(this);
+    scheduleSelect->addItems(scheduler->scheduleNames());
+    scheduleSelect->setCurrentText("Current");
+    scheduleSelect->setToolTip(tr("Schedule the projected downlink use is worked out for"));
+
+    totals = new QLabel(this);
+
+    QHBoxLayout *projectionLayout = new QHBoxLayout();
+    projectionLayout->addWidget(new QLabel(tr("Project for schedule:"), this));
+    projectionLayout->addWidget(scheduleSelect);
+    projectionLayout->addStretch();
+
+    QVBoxLayout *layout = new QVBoxLayout(this);
+    layout->addWidget(table);
+    layout->addLayout(projectionLayout);
+    layout->addWidget(totals);
+
+    connect(scheduleSelect, QOverload<int>::of(&QComboBox::currentIndexChanged), this,
+            &LinkUsageDialog::fillTable);
+    connect(&refreshTimer, &QTimer::timeout, this, &LinkUsageDialog::refresh);
+
+    last = telMngr->getObjectStats();
+    sinceLast.start();
+    refreshTimer.start(REFRESH_PERIOD_MS);
+
+    fillTable();
+}
+
+/**
+ * @brief Works out the rates since the last refresh from the counters
+ */
+void LinkUsageDialog::refresh()
+{
+    QHash<quint32, UAVTalk::ObjectStats> current = telMngr->getObjectStats();
+    double elapsed_s = sinceLast.restart() / 1000.0;
+
+    rates.clear();
+
+    if (elapsed_s <= 0) {
+        last = current;
+        return;
+    }
+
+    for (auto i = current.constBegin(); i != current.constEnd(); ++i) {
+        UAVTalk::ObjectStats before = last.value(i.key(), UAVTalk::ObjectStats());
+
+        // The counters start over with each new link
+        if (i.value().rxBytes < before.rxBytes || i.value().txBytes < before.txBytes)
+            before = UAVTalk::ObjectStats();
+
+        Rates r;
+        // The flight side's transmissions are what we receive
+        r.downlinkBytes = (i.value().rxBytes - before.rxBytes) / elapsed_s;
+        r.uplinkBytes = (i.value().txBytes - before.txBytes) / elapsed_s;
+        r.packets = (i.value().rxPackets - before.rxPackets + i.value().txPackets
+                     - before.txPackets)
+            / elapsed_s;
+
+        if (r.downlinkBytes > 0 || r.uplinkBytes > 0)
+            rates.insert(i.key(), r);
+    }
+
+    last = current;
+
+    fillTable();
+}
+
+/**
+ * @brief Lists every object that used the link or would with the selected
+ * schedule, biggest share first
+ */
+void LinkUsageDialog::fillTable()
+{
+    int col = scheduleSelect->currentIndex();
+
+    double measuredTotal = 0;
+    for (const Rates &r : rates)
+        measuredTotal += r.downlinkBytes + r.uplinkBytes;
+
+    double projectedTotal = 0;
+
+    table->setSortingEnabled(false);
+    table->setRowCount(0);
+
+    for (const QVector<UAVDataObject *> &instances : objMngr->getDataObjectsVector()) {
+        UAVDataObject *dobj = instances.first();
+        UAVObject *obj = dobj;
+
+        Rates r = rates.value(obj->getObjID(), Rates{ 0, 0, 0 });
+
+        double projected = 0;
+        if (col >= 0 && !dobj->isSettings())
+            projected = scheduler->projectedBandwidth(col, obj);
+
+        projectedTotal += projected;
+
+        if (r.downlinkBytes <= 0 && r.uplinkBytes <= 0 && projected <= 0)
+            continue;
+
+        double share = 0;
+        if (measuredTotal > 0)
+            share = 100.0 * (r.downlinkBytes + r.uplinkBytes) / measuredTotal;
+
+        int row = table->rowCount();
+        table->insertRow(row);
+
+        auto number = [](double value) {
+            QTableWidgetItem *item = new QTableWidgetItem();
+            item->setData(Qt::DisplayRole, qRound(value * 10) / 10.0);
+            item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+            return item;
+        };
+
+        table->setItem(row, COL_OBJECT, new QTableWidgetItem(obj->getName()));
+        table->setItem(row, COL_DOWNLINK, number(r.downlinkBytes));
+        table->setItem(row, COL_UPLINK, number(r.uplinkBytes));
+        table->setItem(row, COL_PACKETS, number(r.packets));
+        table->setItem(row, COL_SHARE, number(share));
+        table->setItem(row, COL_PROJECTED, number(projected));
+    }
+
+    table->setSortingEnabled(true);
+    table->sortItems(COL_SHARE, Qt::DescendingOrder);
+
+    QString text = tr("Measured: %1 B/s.  Projected downlink with \"%2\": %3 B/s.")
+                       .arg(qRound(measuredTotal))
+                       .arg(scheduleSelect->currentText())
+                       .arg(qRound(projectedTotal));
+
+    // Zero until the board has answered a ping
+    float latency = GCSTelemetryStats::GetInstance(objMngr)->getData().LinkLatency;
+    if (latency > 0)
+        text += tr("  Latency: %1 ms.").arg(latency, 0, 'f', 1);
+
+    totals->setText(text);
+}
+
+/**
+ * @}
+ * @}
+ */
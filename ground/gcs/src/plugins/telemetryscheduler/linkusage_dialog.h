@@ -0,0 +1,89 @@
+/**
+ ******************************************************************************
+ * @file       linkusage_dialog.h
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2017
+ * @addtogroup Telemetry Scheduler GCS Plugins
+ * @{
+ * @addtogroup TelemetrySchedulerGadgetPlugin Telemetry Scheduler Gadget Plugin
+ * @{
+ * @brief A dialog showing the telemetry link use of each object
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef LINKUSAGE_DIALOG_H_
+#define LINKUSAGE_DIALOG_H_
+
+#include <QComboBox>
+#include <QDialog>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QLabel>
+#include <QTableWidget>
+#include <QTimer>
+
+#include "uavtalk/telemetrymanager.h"
+#include "uavobjects/uavobjectmanager.h"
+
+class TelemetrySchedulerGadgetWidget;
+
+/**
+ * @brief Measured link use per object, from the UAVTalk counters, ranked by
+ * share of the link, next to what each would use with one of the schedules.
+ */
+class LinkUsageDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    LinkUsageDialog(TelemetrySchedulerGadgetWidget *scheduler);
+
+private slots:
+    void refresh();
+    void fillTable();
+
+private:
+    enum Columns { COL_OBJECT, COL_DOWNLINK, COL_UPLINK, COL_PACKETS, COL_SHARE, COL_PROJECTED };
+
+    static const int REFRESH_PERIOD_MS = 2000;
+
+    //! Per second, over the last refresh period
+    struct Rates
+    {
+        double downlinkBytes;
+        double uplinkBytes;
+        double packets;
+    };
+
+    TelemetrySchedulerGadgetWidget *scheduler;
+    TelemetryManager *telMngr;
+    UAVObjectManager *objMngr;
+
+    QTableWidget *table;
+    QComboBox *scheduleSelect;
+    QLabel *totals;
+    QTimer refreshTimer;
+
+    QElapsedTimer sinceLast;
+    QHash<quint32, UAVTalk::ObjectStats> last;
+    QHash<quint32, Rates> rates;
+};
+
+#endif /* LINKUSAGE_DIALOG_H_ */
+
+/**
+ * @}
+ * @}
+ */
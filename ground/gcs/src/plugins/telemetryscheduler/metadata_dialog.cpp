@@ -60,6 +60,11 @@ MetadataDialog::MetadataDialog(UAVObject::Metadata mdata, QWidget *parent)
     metadata_editor.cmbGCSTelemetryMode->addItem("On Change", UAVObject::UPDATEMODE_ONCHANGE);
     metadata_editor.cmbGCSTelemetryMode->addItem("Manual", UAVObject::UPDATEMODE_MANUAL);
 
+    metadata_editor.cmbFlightTelemetryPriority->addItem("High", UAVObject::TELEMETRYPRIORITY_HIGH);
+    metadata_editor.cmbFlightTelemetryPriority->addItem("Normal",
+                                                        UAVObject::TELEMETRYPRIORITY_NORMAL);
+    metadata_editor.cmbFlightTelemetryPriority->addItem("Low", UAVObject::TELEMETRYPRIORITY_LOW);
+
     // Connect the before setting any signals
     connect(metadata_editor.bnApplyMetadata, &QAbstractButton::clicked, this,
             &MetadataDialog::saveApplyMetadata);
@@ -110,6 +115,11 @@ void MetadataDialog::saveApplyMetadata()
         *m_mdata,
         (UAVObject::UpdateMode)metadata_editor.cmbGCSTelemetryMode->itemData(currentGCSIdx)
             .toInt());
+    int currentPriorityIdx = metadata_editor.cmbFlightTelemetryPriority->currentIndex();
+    UAVObject::SetFlightTelemetryPriority(
+        *m_mdata, (UAVObject::TelemetryPriority)metadata_editor.cmbFlightTelemetryPriority
+                      ->itemData(currentPriorityIdx)
+                      .toInt());
 
     accept();
 }
@@ -145,6 +155,11 @@ void MetadataDialog::fillWidgets()
     accessType = UAVObject::GetGcsTelemetryUpdateMode(*m_mdata);
     metadata_editor.cmbGCSTelemetryMode->setCurrentIndex(
         metadata_editor.cmbGCSTelemetryMode->findData(accessType));
+
+    // Set flight telemetry priority combo box
+    int priority = UAVObject::GetFlightTelemetryPriority(*m_mdata);
+    metadata_editor.cmbFlightTelemetryPriority->setCurrentIndex(
+        metadata_editor.cmbFlightTelemetryPriority->findData(priority));
 }
 
 /**
@@ -9,6 +9,7 @@ include(../../gcsplugin.pri)
 include(../../plugins/coreplugin/coreplugin.pri) 
 include(../../plugins/uavobjects/uavobjects.pri)
 include(../../plugins/uavobjectutil/uavobjectutil.pri)
+include(../../plugins/uavtalk/uavtalk.pri)
 
 HEADERS += telemetryschedulergadget.h
 HEADERS += telemetryschedulergadgetwidget.h
@@ -16,12 +17,14 @@ HEADERS += telemetryschedulergadgetfactory.h
 HEADERS += telemetryschedulerplugin.h
 HEADERS += telemetryscheduler_global.h
 HEADERS += metadata_dialog.h
+HEADERS += linkusage_dialog.h
 
 SOURCES += telemetryschedulergadget.cpp
 SOURCES += telemetryschedulergadgetwidget.cpp
 SOURCES += telemetryschedulergadgetfactory.cpp
 SOURCES += telemetryschedulerplugin.cpp
 SOURCES += metadata_dialog.cpp
+SOURCES += linkusage_dialog.cpp
 
 OTHER_FILES += TelemetryScheduler.pluginspec
 
@@ -24,6 +24,7 @@
  */
 #include "telemetryschedulergadgetwidget.h"
 #include "metadata_dialog.h"
+#include "linkusage_dialog.h"
 #include "ui_telemetryscheduler.h"
 #include "ui_metadata_dialog.h"
 
@@ -98,6 +99,8 @@ TelemetrySchedulerGadgetWidget::TelemetrySchedulerGadgetWidget(QWidget *parent)
             &TelemetrySchedulerGadgetWidget::applySchedule);
     connect(m_telemetryeditor->bnSaveSchedule, &QAbstractButton::clicked, this,
             &TelemetrySchedulerGadgetWidget::saveSchedule);
+    connect(m_telemetryeditor->bnLinkUsage, &QAbstractButton::clicked, this,
+            &TelemetrySchedulerGadgetWidget::showLinkUsage);
     connect(m_telemetryeditor->bnAddTelemetryColumn, &QAbstractButton::clicked, this,
             &TelemetrySchedulerGadgetWidget::addTelemetryColumn);
     connect(m_telemetryeditor->bnRemoveTelemetryColumn, &QAbstractButton::clicked, this,
@@ -264,7 +267,6 @@ void TelemetrySchedulerGadgetWidget::dataModel_itemChanged(int col)
     // Update the speed estimate
     double bandwidthRequired_bps = 0;
     for (int i = 1; i < schedulerModel->rowCount(); i++) {
-        // Get UAVO size
         QString uavObjectName = schedulerModel->verticalHeaderItem(i)->text();
         UAVObject *obj = objManager->getObject(uavObjectName);
         UAVDataObject *dobj = dynamic_cast<UAVDataObject *>(obj);
@@ -272,22 +274,9 @@ void TelemetrySchedulerGadgetWidget::dataModel_itemChanged(int col)
             && (!dobj->getIsPresentOnHardware()))
             continue;
         Q_ASSERT(obj);
-        quint16 size = obj->getNumBytes();
-
-        // Get UAVO speed
-        QModelIndex index = schedulerModel->index(i, col, QModelIndex());
-        double updatePeriod_s;
-        if (schedulerModel->data(index).isValid() && stripMs(schedulerModel->data(index)) >= 0)
-            updatePeriod_s = stripMs(schedulerModel->data(index)) / 1000.0;
-        else
-            updatePeriod_s =
-                defaultMdata.value(obj->getName().append("Meta")).flightTelemetryUpdatePeriod
-                / 1000.0;
-
-        double updateFrequency_Hz = updatePeriod_s > 0 ? 1.0 / updatePeriod_s : 0;
 
         // Accumulate bandwidth
-        bandwidthRequired_bps += updateFrequency_Hz * size;
+        bandwidthRequired_bps += projectedBandwidth(col, obj);
     }
 
     QModelIndex index = telemetryScheduleView->getFrozenModel()->index(0, col, QModelIndex());
@@ -297,6 +286,64 @@ void TelemetrySchedulerGadgetWidget::dataModel_itemChanged(int col)
     // TODO: Set color as function of available speed
 }
 
+QStringList TelemetrySchedulerGadgetWidget::scheduleNames() const
+{
+    QStringList names;
+
+    for (int col = 0; col < schedulerModel->columnCount(); col++) {
+        QStandardItem *header = schedulerModel->horizontalHeaderItem(col);
+        names << (header ? header->text() : QString());
+    }
+
+    return names;
+}
+
+/**
+ * @brief Works out the link use of an object with the update periods in a
+ * column, framing included.  Cells left empty take the default period.
+ * @param col the schedule column
+ * @param obj the object
+ * @return bytes per second, every instance together
+ */
+double TelemetrySchedulerGadgetWidget::projectedBandwidth(int col, UAVObject *obj) const
+{
+    // sync, type, size, object ID and checksum; and instance ID on multi
+    // instance objects
+    const int frameOverhead = 9;
+    int size = obj->getNumBytes() + frameOverhead;
+
+    if (!obj->isSingleInstance())
+        size += 2;
+
+    int row = -1;
+    for (int i = 1; i < schedulerModel->rowCount(); i++) {
+        if (schedulerModel->verticalHeaderItem(i)->text() == obj->getName()) {
+            row = i;
+            break;
+        }
+    }
+
+    double updatePeriod_s =
+        defaultMdata.value(obj->getName().append("Meta")).flightTelemetryUpdatePeriod / 1000.0;
+
+    if (row >= 0) {
+        QModelIndex index = schedulerModel->index(row, col, QModelIndex());
+        if (schedulerModel->data(index).isValid() && stripMs(schedulerModel->data(index)) >= 0)
+            updatePeriod_s = stripMs(schedulerModel->data(index)) / 1000.0;
+    }
+
+    double updateFrequency_Hz = updatePeriod_s > 0 ? 1.0 / updatePeriod_s : 0;
+
+    return updateFrequency_Hz * size * objManager->getNumInstances(obj->getObjID());
+}
+
+void TelemetrySchedulerGadgetWidget::showLinkUsage()
+{
+    LinkUsageDialog *dialog = new LinkUsageDialog(this);
+    dialog->setAttribute(Qt::WA_DeleteOnClose);
+    dialog->show();
+}
+
 void TelemetrySchedulerGadgetWidget::saveTelemetryToFile()
 {
     QString file = filename;
@@ -819,7 +866,7 @@ void TelemetrySchedulerGadgetWidget::changeVerticalHeader(int headerIndex)
  * @param rate_ms rate with ms suffix at end
  * @return the integer parsed string
  */
-int TelemetrySchedulerGadgetWidget::stripMs(QVariant rate_ms)
+int TelemetrySchedulerGadgetWidget::stripMs(QVariant rate_ms) const
 {
     return rate_ms.toString().replace(QString("ms"), QString("")).toUInt();
 }
@@ -50,6 +50,11 @@ public:
     TelemetrySchedulerGadgetWidget(QWidget *parent = nullptr);
     ~TelemetrySchedulerGadgetWidget();
 
+    //! The schedule columns, in order
+    QStringList scheduleNames() const;
+    //! Bytes per second the object takes from the flight side with a schedule
+    double projectedBandwidth(int col, UAVObject *obj) const;
+
 signals:
 
 protected slots:
@@ -75,9 +80,10 @@ private slots:
     void customMenuRequested(QPoint pos);
     void uavoPresentOnHardwareChanged(UAVDataObject *);
     void onHideNotPresent(bool);
+    void showLinkUsage();
 
 private:
-    int stripMs(QVariant rate_ms);
+    int stripMs(QVariant rate_ms) const;
     QList<UAVMetaObject *> metaObjectsToSave;
     void importTelemetryConfiguration(const QString &fileName);
     UAVObjectUtilManager *getObjectUtilManager();
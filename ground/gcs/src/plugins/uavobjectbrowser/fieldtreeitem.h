@@ -169,12 +169,14 @@ public:
         , m_field(field)
     {
         setMinMaxValues();
+        updateFormattedData();
     }
     IntFieldTreeItem(UAVObjectField *field, int index, const QVariant &data, TreeItem *parent = nullptr)
         : FieldTreeItem(index, data, parent)
         , m_field(field)
     {
         setMinMaxValues();
+        updateFormattedData();
     }
 
     void setMinMaxValues()
@@ -279,6 +281,7 @@ public:
     {
         setChanged(m_field->getValue(m_index) != value);
         TreeItem::setData(value, column);
+        updateFormattedData();
     }
     void apply()
     {
@@ -319,6 +322,7 @@ public:
                 Q_ASSERT(false);
                 break;
             }
+            updateFormattedData();
             setHighlight();
         }
 
@@ -326,7 +330,11 @@ public:
         if (obj && obj->isSettings())
             setIsDefaultValue(m_field->isDefaultValue(m_index));
     }
-    QString formattedData()
+    // Called on every repaint, so only formatted when the value changes
+    QString formattedData() const { return m_formatted; }
+
+private:
+    void updateFormattedData()
     {
         QString formatted = m_field->getDisplayPrefix();
         switch (m_field->getType()) {
@@ -344,13 +352,13 @@ public:
             Q_ASSERT(false);
             break;
         }
-        return formatted;
+        m_formatted = formatted;
     }
 
-private:
     UAVObjectField *m_field;
     qint64 m_minValue;
     qint64 m_maxValue;
+    QString m_formatted;
 };
 
 class FloatFieldTreeItem : public FieldTreeItem
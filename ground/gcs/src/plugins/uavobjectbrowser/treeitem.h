@@ -256,11 +256,15 @@ public:
     ObjectTreeItem(const QList<QVariant> &data, TreeItem *parent = nullptr)
         : TreeItem(data, parent)
         , m_obj(nullptr)
+        , m_expanded(false)
+        , m_staleFields(0)
     {
     }
     ObjectTreeItem(const QVariant &data, TreeItem *parent = nullptr)
         : TreeItem(data, parent)
         , m_obj(nullptr)
+        , m_expanded(false)
+        , m_staleFields(0)
     {
     }
     virtual void setObject(UAVObject *obj)
@@ -270,8 +274,22 @@ public:
     }
     inline UAVObject *object() { return m_obj; }
 
+    inline bool isExpanded() const { return m_expanded; }
+    void setExpanded(bool expanded) { m_expanded = expanded; }
+
+    // Fields that changed while collapsed, bit n for the nth field
+    void addStaleFields(quint64 fields) { m_staleFields |= fields; }
+    quint64 takeStaleFields()
+    {
+        quint64 fields = m_staleFields;
+        m_staleFields = 0;
+        return fields;
+    }
+
 private:
     UAVObject *m_obj;
+    bool m_expanded;
+    quint64 m_staleFields;
 };
 
 class MetaObjectTreeItem : public ObjectTreeItem
@@ -96,6 +96,8 @@ UAVObjectBrowserWidget::UAVObjectBrowserWidget(QWidget *parent)
 void UAVObjectBrowserWidget::onTreeItemExpanded(QModelIndex currentProxyIndex)
 {
     QModelIndex currentIndex = proxyModel->mapToSource(currentProxyIndex);
+    m_model->setExpanded(currentIndex, true);
+
     TreeItem *item = static_cast<TreeItem *>(currentIndex.internalPointer());
     TopTreeItem *top = dynamic_cast<TopTreeItem *>(item->parent());
 
@@ -154,6 +156,8 @@ void UAVObjectBrowserWidget::onTreeItemExpanded(QModelIndex currentProxyIndex)
 void UAVObjectBrowserWidget::onTreeItemCollapsed(QModelIndex currentProxyIndex)
 {
     QModelIndex currentIndex = proxyModel->mapToSource(currentProxyIndex);
+    m_model->setExpanded(currentIndex, false);
+
     TreeItem *item = static_cast<TreeItem *>(currentIndex.internalPointer());
     TopTreeItem *top = dynamic_cast<TopTreeItem *>(item->parent());
 
@@ -647,7 +651,6 @@ void UAVObjectBrowserWidget::keyReleaseEvent(QKeyEvent *e)
  */
 UAVOBrowserTreeView::UAVOBrowserTreeView(unsigned int updateTimerPeriod)
     : QTreeView()
-    , m_updateTreeViewFlag(false)
 {
     // Start timer at 100ms
     m_updateViewTimer.start(updateTimerPeriod);
@@ -671,53 +674,50 @@ void UAVOBrowserTreeView::updateTimerPeriod(unsigned int val)
 }
 
 /**
- * @brief UAVOBrowserTreeView::onTimeout_updateView On timeout, emits dataChanged() signal.
- * Origingally,
- * this was intended to only function on the the data tree indices that had changed since last
- * timeout,
- * but QTreeView does not respect the limits in dataChanged, instead redrawing the entire tree at
- * each
- * update.
+ * @brief UAVOBrowserTreeView::onTimeout_updateView On timeout, repaints the rows that changed
+ * since the last timeout.  Rows that are under a collapsed parent or scrolled out of sight are
+ * skipped.  Each cell is passed on by itself, since QTreeView redraws the entire tree when
+ * dataChanged is given a range.
  */
 void UAVOBrowserTreeView::onTimeout_updateView()
 {
-    if (m_updateTreeViewFlag == true) {
-        QModelIndex topLeftIndex = model()->index(0, 0);
-        QModelIndex bottomRightIndex = model()->index(1, 1);
+    QRect visible = viewport()->rect();
+
+    foreach (const QPersistentModelIndex &row, m_dirtyRows) {
+        if (!row.isValid())
+            continue;
 
-        QTreeView::dataChanged(topLeftIndex, bottomRightIndex);
+        QModelIndex first = row;
+        int columns = model()->columnCount(first.parent());
+        QModelIndex last = first.sibling(first.row(), columns - 1);
+
+        if (!(visualRect(first) | visualRect(last)).intersects(visible))
+            continue;
+
+        for (int column = 0; column < columns; column++) {
+            QModelIndex cell = first.sibling(first.row(), column);
+            QTreeView::dataChanged(cell, cell);
+        }
     }
 
-    m_updateTreeViewFlag = false;
+    m_dirtyRows.clear();
 }
 
 /**
- * @brief UAVOBrowserTreeView::updateView Determines if a view updates lies outside the
- * range of updates queued for update
+ * @brief UAVOBrowserTreeView::updateView Queues the rows of a data model update for the next
+ * repaint
  * @param topLeft Top left index from data model update
  * @param bottomRight Bottom right index from data model update
  */
-void UAVOBrowserTreeView::updateView(const QModelIndex &topLeftProxy,
-                                     const QModelIndex &bottomRightProxy)
+void UAVOBrowserTreeView::updateView(const QModelIndex &topLeft, const QModelIndex &bottomRight)
 {
-    Q_UNUSED(bottomRightProxy);
-
-    // First static_cast from *void to a tree item pointer. This is safe because we know all the
-    // indices are tree items
-    QModelIndex topLeftModel = proxyModel->mapToSource(topLeftProxy);
-    TreeItem *treeItemPtr = static_cast<TreeItem *>(topLeftModel.internalPointer());
-
-    // Second, do a dynamic_cast in order to detect if this tree item is a data object
-    DataObjectTreeItem *dataObjectTreeItemPtr = dynamic_cast<DataObjectTreeItem *>(treeItemPtr);
-
-    if (dataObjectTreeItemPtr == NULL) {
-        // Do nothing. These QModelIndices are generated by the highlight manager for individual
-        // UAVO fields, which are both updated when updating that UAVO's branch of the settings or
-        // dynamic data tree.
+    if (!topLeft.isValid())
         return;
-    }
 
-    m_updateTreeViewFlag = true;
+    int lastRow = bottomRight.isValid() ? bottomRight.row() : topLeft.row();
+
+    for (int row = topLeft.row(); row <= lastRow; row++)
+        m_dirtyRows.insert(QPersistentModelIndex(topLeft.sibling(row, 0)));
 }
 
 void UAVOBrowserTreeView::dataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight,
@@ -29,6 +29,8 @@
 #define UAVOBJECTBROWSERWIDGET_H_
 
 #include <QModelIndex>
+#include <QPersistentModelIndex>
+#include <QSet>
 #include <QWidget>
 #include <QKeyEvent>
 #include <QTreeView>
@@ -79,7 +81,8 @@ private slots:
     void onTimeout_updateView();
 
 private:
-    bool m_updateTreeViewFlag;
+    // Rows changed since the last repaint, as column 0 indices
+    QSet<QPersistentModelIndex> m_dirtyRows;
     TreeSortFilterProxyModel *proxyModel;
 
     QTimer m_updateViewTimer;
@@ -38,6 +38,7 @@
 #include "uavobjects/uavdataobject.h"
 #include "uavobjects/uavmetaobject.h"
 #include "uavobjects/uavobjectfield.h"
+#include "uavobjects/uavobjectupdatecoalescer.h"
 #include "extensionsystem/pluginmanager.h"
 #include <QColor>
 #include <QtCore/QTimer>
@@ -197,7 +198,8 @@ void UAVObjectTreeModel::addDataObject(UAVDataObject *obj)
 
 MetaObjectTreeItem *UAVObjectTreeModel::addMetaObject(UAVMetaObject *obj, TreeItem *parent)
 {
-    connect(obj, &UAVObject::objectUpdated, this, &UAVObjectTreeModel::highlightUpdatedObject);
+    // Refreshed at display rate rather than on every update
+    connect(obj, &UAVObject::objectChanged, this, &UAVObjectTreeModel::highlightUpdatedObject);
     MetaObjectTreeItem *meta = new MetaObjectTreeItem(obj, tr("Meta Data"));
 
     meta->setHighlightManager(m_highlightManager);
@@ -214,7 +216,8 @@ MetaObjectTreeItem *UAVObjectTreeModel::addMetaObject(UAVMetaObject *obj, TreeIt
 
 void UAVObjectTreeModel::addInstance(UAVObject *obj, TreeItem *parent)
 {
-    connect(obj, &UAVObject::objectUpdated, this, &UAVObjectTreeModel::highlightUpdatedObject);
+    // Refreshed at display rate rather than on every update
+    connect(obj, &UAVObject::objectChanged, this, &UAVObjectTreeModel::highlightUpdatedObject);
     TreeItem *item;
     DataObjectTreeItem *p = static_cast<DataObjectTreeItem *>(parent);
     if (obj->isSingleInstance()) {
@@ -498,15 +501,45 @@ QVariant UAVObjectTreeModel::headerData(int section, Qt::Orientation orientation
     return QVariant();
 }
 
-void UAVObjectTreeModel::highlightUpdatedObject(UAVObject *obj)
+/**
+ * @brief UAVObjectTreeModel::highlightUpdatedObject Brings the rows of an object up to
+ * date with its data.  Only the fields set in changedFields are looked at, and those of a
+ * collapsed telemetry object are left until it is expanded, since nothing shows them.
+ * Settings are always refreshed, as their rows show whether they hold default values.
+ * @param obj The object that changed
+ * @param changedFields Bit n set if the nth field changed, as given by UAVObject::objectChanged
+ */
+void UAVObjectTreeModel::highlightUpdatedObject(UAVObject *obj, quint64 changedFields)
 {
     Q_ASSERT(obj);
     ObjectTreeItem *item = findObjectTreeItem(obj);
     Q_ASSERT(item);
+
+    // Each instance of a multiple instance object keeps its fields under its own row
+    if (!item->object()) {
+        foreach (TreeItem *child, item->treeChildren()) {
+            InstanceTreeItem *inst = dynamic_cast<InstanceTreeItem *>(child);
+            if (inst && inst->object() == obj) {
+                item = inst;
+                break;
+            }
+        }
+        Q_ASSERT(item->object() == obj);
+    }
+
     if (!m_onlyHighlightChangedValues) {
         item->setHighlight();
     }
-    item->update();
+
+    UAVDataObject *dobj = qobject_cast<UAVDataObject *>(obj);
+    if (item->isExpanded() || !dobj || dobj->isSettings()) {
+        updateFields(item, changedFields);
+    } else {
+        item->addStaleFields(changedFields);
+        if (changedFields && m_onlyHighlightChangedValues)
+            item->setHighlight();
+    }
+
     if (!m_onlyHighlightChangedValues) {
         QModelIndex itemIndex = index(item);
         Q_ASSERT(itemIndex != QModelIndex());
@@ -514,6 +547,62 @@ void UAVObjectTreeModel::highlightUpdatedObject(UAVObject *obj)
     }
 }
 
+/**
+ * @brief UAVObjectTreeModel::updateFields Refreshes the field rows of an object item, and
+ * tells the views about those rows only
+ * @param item The item holding the fields
+ * @param fields Bit n set for the nth field to refresh
+ */
+void UAVObjectTreeModel::updateFields(ObjectTreeItem *item, quint64 fields)
+{
+    if (!fields)
+        return;
+
+    int bit = 0;
+
+    // Field rows follow the order of the object's fields, after any metadata row
+    foreach (TreeItem *child, item->treeChildren()) {
+        if (dynamic_cast<MetaObjectTreeItem *>(child))
+            continue;
+
+        if (fields & (1ULL << bit)) {
+            child->update();
+
+            QModelIndex childIndex = index(child);
+            emit dataChanged(childIndex,
+                             childIndex.sibling(childIndex.row(), TreeItem::dataColumn));
+
+            if (child->childCount()) {
+                emit dataChanged(index(0, 0, childIndex),
+                                 index(child->childCount() - 1, TreeItem::dataColumn, childIndex));
+            }
+        }
+
+        if (bit < UAVObjectUpdateCoalescer::LAST_FIELD_BIT)
+            bit++;
+    }
+}
+
+/**
+ * @brief UAVObjectTreeModel::setExpanded Called by the view as object rows are expanded and
+ * collapsed, so that fields which can't be seen aren't refreshed
+ */
+void UAVObjectTreeModel::setExpanded(const QModelIndex &index, bool expanded)
+{
+    if (!index.isValid())
+        return;
+
+    TreeItem *treeItem = static_cast<TreeItem *>(index.internalPointer());
+    ObjectTreeItem *item = dynamic_cast<ObjectTreeItem *>(treeItem);
+    if (!item)
+        return;
+
+    item->setExpanded(expanded);
+
+    if (expanded)
+        updateFields(item, item->takeStaleFields());
+}
+
 ObjectTreeItem *UAVObjectTreeModel::findObjectTreeItem(UAVObject *object)
 {
     UAVDataObject *dataObject = qobject_cast<UAVDataObject *>(object);
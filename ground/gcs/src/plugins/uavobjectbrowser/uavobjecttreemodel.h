@@ -77,6 +77,8 @@ public:
     void setNotPresentOnHwColor(QColor color) { m_notPresentOnHwColor = color; }
     void setOnlyHighlightChangedValues(bool highlight) { m_onlyHighlightChangedValues = highlight; }
 
+    void setExpanded(const QModelIndex &index, bool expanded);
+
     QList<QModelIndex> getMetaDataIndexes();
     QList<QModelIndex> getDataObjectIndexes();
 
@@ -92,7 +94,7 @@ public slots:
     void initializeModel(bool useScientificFloatNotation = true);
     void instanceRemove(UAVObject *);
 private slots:
-    void highlightUpdatedObject(UAVObject *obj);
+    void highlightUpdatedObject(UAVObject *obj, quint64 changedFields);
     void updateHighlight(TreeItem *);
     void presentOnHardwareChangedCB(UAVDataObject *);
 
@@ -105,6 +107,7 @@ private:
     void addArrayField(UAVObjectField *field, TreeItem *parent);
     void addSingleField(int index, UAVObjectField *field, TreeItem *parent);
     void addInstance(UAVObject *obj, TreeItem *parent);
+    void updateFields(ObjectTreeItem *item, quint64 fields);
 
     QString updateMode(quint8 updateMode);
     ObjectTreeItem *findObjectTreeItem(UAVObject *obj);
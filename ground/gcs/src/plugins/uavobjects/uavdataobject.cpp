@@ -45,8 +45,8 @@ UAVDataObject::UAVDataObject(quint32 objID, bool isSingleInst, bool isSet, const
     this->isSet = isSet;
     this->isPresentOnHardware = unknownPresent;
 
-    connect(this, &UAVObject::objectUnpacked,
-            this, &UAVDataObject::setIsPresentOnHardware);
+    // Whatever came from the board is both there and known
+    connect(this, &UAVObject::objectUnpacked, this, [this]() { setReceived(); });
 }
 
 /**
@@ -154,7 +154,7 @@ void UAVDataObject::resetIsPresentOnHardware()
 
     isPresentOnHardware = unknownPresent;
 
-    if (old == isPresent) {
+    if (old == isPresent || old == isPresentAndReceived) {
         emit presentOnHardwareChanged(this);
         emit presentOnHardwareChanged(false);
     }
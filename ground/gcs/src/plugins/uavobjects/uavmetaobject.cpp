@@ -59,6 +59,13 @@ UAVMetaObject::UAVMetaObject(quint32 objID, const QString &name, UAVObject *pare
                                      UAVObjectField::UINT16, 1, QStringList(), QList<int>()));
     fields.append(new UAVObjectField(tr("Logging Update Period"), tr("ms"), UAVObjectField::UINT16,
                                      1, QStringList(), QList<int>()));
+    QStringList priorityEnum;
+    priorityEnum << tr("Normal") << tr("High") << tr("Low");
+    fields.append(new UAVObjectField(tr("Flight Telemetry Priority"), tr(""),
+                                     UAVObjectField::ENUM, 1, priorityEnum,
+                                     QList<int>() << TELEMETRYPRIORITY_NORMAL
+                                                  << TELEMETRYPRIORITY_HIGH
+                                                  << TELEMETRYPRIORITY_LOW));
     // Initialize parent
     UAVObject::initialize(0);
     UAVObject::initializeFields(fields, reinterpret_cast<quint8 *>(&parentMetadata),
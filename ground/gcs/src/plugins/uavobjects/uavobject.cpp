@@ -39,6 +39,8 @@
 #include <QJsonArray>
 #include <QJsonValue>
 
+#include <string.h>
+
 // Constants
 #define UAVOBJ_ACCESS_SHIFT 0
 #define UAVOBJ_GCS_ACCESS_SHIFT 1
@@ -63,6 +65,9 @@ UAVObject::UAVObject(quint32 objID, bool isSingleInst, const QString &name)
     this->instID = 0;
     this->isSingleInst = isSingleInst;
     this->name = name;
+    this->dirtyStart = 0;
+    this->dirtyEnd = 0;
+    this->wireLayout = false;
 }
 
 /**
@@ -91,6 +96,14 @@ void UAVObject::initializeFields(QList<UAVObjectField *> &fields, quint8 *data,
         offset += fields[n]->getNumBytes();
         connect(fields[n], &UAVObjectField::fieldUpdated, this, &UAVObject::fieldUpdated);
     }
+    // The fields are laid end to end in the order they are sent, so the data can be copied
+    // to and from the wire as a whole where the byte order allows
+    Q_ASSERT(offset == numBytes);
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    wireLayout = (offset == numBytes);
+#else
+    wireLayout = false;
+#endif
 }
 
 /**
@@ -101,6 +114,49 @@ void UAVObject::fieldUpdated(UAVObjectField *field)
     Q_UNUSED(field);
 }
 
+/**
+ * Record that a byte range of the object data was changed locally, so that
+ * telemetry can send just that range.
+ * @param offset Offset of the changed bytes into the object data
+ * @param length Number of changed bytes
+ */
+void UAVObject::markDirty(quint32 offset, quint32 length)
+{
+    if (dirtyStart == dirtyEnd) {
+        dirtyStart = offset;
+        dirtyEnd = offset + length;
+    } else {
+        dirtyStart = qMin(dirtyStart, offset);
+        dirtyEnd = qMax(dirtyEnd, offset + length);
+    }
+}
+
+/**
+ * Record that all of the object data was changed locally
+ */
+void UAVObject::markAllDirty()
+{
+    markDirty(0, numBytes);
+}
+
+/**
+ * Get and clear the byte range changed since the last call
+ * @param offset Set to the start of the changed bytes
+ * @param length Set to the number of changed bytes
+ * @returns True if only part of the object changed, false if nothing is
+ * known to have changed or all of it did (send the whole object then)
+ */
+bool UAVObject::takeDirtyRange(quint32 &offset, quint32 &length)
+{
+    offset = dirtyStart;
+    length = dirtyEnd - dirtyStart;
+
+    dirtyStart = 0;
+    dirtyEnd = 0;
+
+    return (length > 0) && (length < numBytes);
+}
+
 /**
  * Get the object ID
  */
@@ -254,6 +310,11 @@ UAVObjectField *UAVObject::getField(const QString &name)
  */
 qint32 UAVObject::pack(quint8 *dataOut)
 {
+    if (wireLayout) {
+        memcpy(dataOut, data, numBytes);
+        return numBytes;
+    }
+
     qint32 offset = 0;
     for (QList<UAVObjectField *>::iterator iter = fields.begin(); iter != fields.end(); ++iter) {
         UAVObjectField *field = *iter;
@@ -269,12 +330,20 @@ qint32 UAVObject::pack(quint8 *dataOut)
  */
 qint32 UAVObject::unpack(const quint8 *dataIn)
 {
-    qint32 offset = 0;
-    for (QList<UAVObjectField *>::iterator iter = fields.begin(); iter != fields.end(); ++iter) {
-        UAVObjectField *field = *iter;
-        field->unpack(&dataIn[offset]);
-        offset += field->getNumBytes();
+    if (wireLayout) {
+        memcpy(data, dataIn, numBytes);
+    } else {
+        qint32 offset = 0;
+        for (QList<UAVObjectField *>::iterator iter = fields.begin(); iter != fields.end();
+             ++iter) {
+            UAVObjectField *field = *iter;
+            field->unpack(&dataIn[offset]);
+            offset += field->getNumBytes();
+        }
     }
+    // The data now matches the other end
+    dirtyStart = 0;
+    dirtyEnd = 0;
     emit objectUnpacked(this); // trigger object updated event
     emit objectUpdated(this);
 
@@ -345,6 +414,14 @@ void UAVObject::emitNewInstance(UAVObject *obj)
     emit newInstance(obj);
 }
 
+/**
+ * Emit the objectChanged event
+ */
+void UAVObject::emitObjectChanged(quint64 changedFields)
+{
+    emit objectChanged(this, changedFields);
+}
+
 /**
  * Emit the instanceRemoved event
  */
@@ -367,6 +444,7 @@ void UAVObject::MetadataInitialize(UAVObject::Metadata &metadata)
     metadata.flightTelemetryUpdatePeriod = 0;
     metadata.gcsTelemetryUpdatePeriod = 0;
     metadata.loggingUpdatePeriod = 0;
+    metadata.flightTelemetryPriority = TELEMETRYPRIORITY_NORMAL;
 }
 
 /**
@@ -491,3 +569,31 @@ void UAVObject::SetGcsTelemetryUpdateMode(UAVObject::Metadata &metadata, UAVObje
 {
     SET_BITS(metadata.flags, UAVOBJ_GCS_TELEMETRY_UPDATE_MODE_SHIFT, val, UAVOBJ_UPDATE_MODE_MASK);
 }
+
+/**
+ * Get the UAVObject metadata flight telemetry priority class
+ * \param[in] metadata The metadata object
+ * \return the flight telemetry priority class
+ */
+UAVObject::TelemetryPriority
+UAVObject::GetFlightTelemetryPriority(const UAVObject::Metadata &metadata)
+{
+    switch (metadata.flightTelemetryPriority) {
+    case TELEMETRYPRIORITY_HIGH:
+    case TELEMETRYPRIORITY_LOW:
+        return UAVObject::TelemetryPriority(metadata.flightTelemetryPriority);
+    default:
+        return TELEMETRYPRIORITY_NORMAL;
+    }
+}
+
+/**
+ * Set the UAVObject metadata flight telemetry priority class
+ * \param[in] metadata The metadata object
+ * \param[in] val The flight telemetry priority class
+ */
+void UAVObject::SetFlightTelemetryPriority(UAVObject::Metadata &metadata,
+                                           UAVObject::TelemetryPriority val)
+{
+    metadata.flightTelemetryPriority = val;
+}
@@ -83,6 +83,15 @@ public:
      */
     typedef enum { ACCESS_READWRITE = 0, ACCESS_READONLY = 1 } AccessMode;
 
+    /**
+     * Flight telemetry scheduler priority class
+     */
+    typedef enum {
+        TELEMETRYPRIORITY_NORMAL = 0, /** Skipped only when the link is overcommitted */
+        TELEMETRYPRIORITY_HIGH = 1, /** Always sent, never deferred or stretched */
+        TELEMETRYPRIORITY_LOW = 2 /** Deferred first, period stretched on a saturated link */
+    } TelemetryPriority;
+
     /**
      * Object metadata, each object has a meta object that holds its metadata. The metadata define
      * properties for each object and can be used by multiple modules (e.g. telemetry and logger)
@@ -114,6 +123,8 @@ public:
                                                  mode is PERIODIC) */
             quint16 loggingUpdatePeriod; /** Update period used by the logging module (only if
                                             logging mode is PERIODIC) */
+            quint8 flightTelemetryPriority; /** Priority class used by the flight telemetry
+                                               scheduler (TelemetryPriority) */
         })
     Metadata;
 
@@ -133,6 +144,9 @@ public:
     qint32 getNumFields();
     QList<UAVObjectField *> getFields();
     UAVObjectField *getField(const QString &name);
+    void markDirty(quint32 offset, quint32 length);
+    void markAllDirty();
+    bool takeDirtyRange(quint32 &offset, quint32 &length);
     QString toString();
     QString toStringBrief();
     QString toStringData();
@@ -140,6 +154,7 @@ public:
     void emitTransactionCompleted(bool success);
     void emitTransactionCompleted(bool success, bool nacked);
     void emitNewInstance(UAVObject *);
+    void emitObjectChanged(quint64 changedFields);
     void emitInstanceRemoved(UAVObject *);
 
     // Metadata accessors
@@ -156,6 +171,8 @@ public:
     static void SetFlightTelemetryUpdateMode(Metadata &meta, UpdateMode val);
     static UpdateMode GetGcsTelemetryUpdateMode(const Metadata &meta);
     static void SetGcsTelemetryUpdateMode(Metadata &meta, UpdateMode val);
+    static TelemetryPriority GetFlightTelemetryPriority(const Metadata &meta);
+    static void SetFlightTelemetryPriority(Metadata &meta, TelemetryPriority val);
 
 public slots:
     void requestUpdate();
@@ -175,6 +192,16 @@ signals:
      */
     void objectUpdated(UAVObject *obj);
 
+    /**
+     * @brief objectChanged: the object was updated since the last display tick.
+     * Sent by the object manager at most once per tick however many updates
+     * arrived, for things that only show the latest values.
+     * @param obj
+     * @param changedFields Mask with bit n set if the nth field changed (fields
+     * past the 63rd share the last bit); 0 if the values are the same
+     */
+    void objectChanged(UAVObject *obj, quint64 changedFields);
+
     /**
      * @brief objectUpdatedAuto: triggered on "setData" only (Object data updated by changing the
      * data structure)
@@ -250,7 +277,10 @@ protected:
     QString category;
     quint32 numBytes;
     quint8 *data;
+    bool wireLayout; /** The data can be copied straight to and from the wire */
     QList<UAVObjectField *> fields;
+    quint32 dirtyStart; /** Start of the bytes changed locally since the last send */
+    quint32 dirtyEnd; /** End of the changed bytes, equal to dirtyStart if none */
     void initializeFields(QList<UAVObjectField *> &fields, quint8 *data, quint32 numBytes);
     void setDescription(const QString &description);
 };
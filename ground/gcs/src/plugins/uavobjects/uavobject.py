@@ -38,6 +38,7 @@ class UAVMetaData(object):
         self.gcsTelemetryUpdatePeriod = 0
         self.loggingUpdateMode = 0
         self.loggingUpdatePeriod = 0
+        self.telemetryPriority = 0
 
 class UAVObject(object):
     def __init__(self, objid, name, metaname, instanceid, issingle):
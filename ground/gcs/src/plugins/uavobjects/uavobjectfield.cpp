@@ -42,15 +42,9 @@ UAVObjectField::UAVObjectField(const QString &name, const QString &units, FieldT
                                const QList<int> &indices, const QString &limits,
                                const QString &description, const QList<QVariant> defaultValues,
                                const DisplayType display)
+    : UAVObjectField(createDescriptor(name, units, type, numElements, options, indices, limits,
+                                      description, defaultValues, display))
 {
-    QStringList elementNames;
-    // Set element names
-    for (auto n = 0; n < numElements; ++n) {
-        elementNames.append(QString("%1").arg(n));
-    }
-    // Initialize
-    constructorInitialize(name, units, type, elementNames, options, indices, limits, description,
-                          defaultValues, display);
 }
 
 UAVObjectField::UAVObjectField(const QString &name, const QString &units, FieldType type,
@@ -58,80 +52,114 @@ UAVObjectField::UAVObjectField(const QString &name, const QString &units, FieldT
                                const QList<int> &indices, const QString &limits,
                                const QString &description, const QList<QVariant> defaultValues,
                                const DisplayType display)
+    : UAVObjectField(createDescriptor(name, units, type, elementNames, options, indices, limits,
+                                      description, defaultValues, display))
+{
+}
+
+/**
+ * @brief Make a field from a descriptor that may be shared with other
+ * instances of the same object
+ * @param descriptor What the field is, from createDescriptor
+ */
+UAVObjectField::UAVObjectField(const DescriptorPtr &descriptor)
+    : desc(descriptor)
+    , offset(0)
+    , data(NULL)
+    , obj(NULL)
 {
-    constructorInitialize(name, units, type, elementNames, options, indices, limits, description,
-                          defaultValues, display);
 }
 
-void UAVObjectField::constructorInitialize(const QString &name, const QString &units,
-                                           FieldType type, const QStringList &elementNames,
-                                           const QStringList &options, const QList<int> &indices,
-                                           const QString &limits, const QString &description,
-                                           const QList<QVariant> defaultValues,
-                                           const DisplayType display)
+UAVObjectField::DescriptorPtr
+UAVObjectField::createDescriptor(const QString &name, const QString &units, FieldType type,
+                                 int numElements, const QStringList &options,
+                                 const QList<int> &indices, const QString &limits,
+                                 const QString &description, const QList<QVariant> defaultValues,
+                                 const DisplayType display)
 {
+    QStringList elementNames;
+    // Set element names
+    for (auto n = 0; n < numElements; ++n) {
+        elementNames.append(QString("%1").arg(n));
+    }
+    return createDescriptor(name, units, type, elementNames, options, indices, limits,
+                            description, defaultValues, display);
+}
+
+/**
+ * @brief Work out everything about a field that doesn't depend on its data
+ * @return The descriptor, to make any number of fields from
+ */
+UAVObjectField::DescriptorPtr
+UAVObjectField::createDescriptor(const QString &name, const QString &units, FieldType type,
+                                 const QStringList &elementNames, const QStringList &options,
+                                 const QList<int> &indices, const QString &limits,
+                                 const QString &description, const QList<QVariant> defaultValues,
+                                 const DisplayType display)
+{
+    QSharedPointer<Descriptor> desc(new Descriptor);
+
     // Copy params
-    this->name = name;
-    this->units = units;
-    this->type = type;
-    this->options = options;
-    this->indices = indices;
-    this->numElements = elementNames.length();
-    this->offset = 0;
-    this->data = NULL;
-    this->obj = NULL;
-    this->elementNames = elementNames;
-    this->description = description;
-    this->display = display;
+    desc->name = name;
+    desc->units = units;
+    desc->type = type;
+    desc->options = options;
+    desc->indices = indices;
+    desc->numElements = elementNames.length();
+    desc->elementNames = elementNames;
+    desc->description = description;
+    desc->display = display;
 
     // Set field size
     switch (type) {
     case INT8:
-        elementSize = sizeof(qint8);
+        desc->elementSize = sizeof(qint8);
         break;
     case INT16:
-        elementSize = sizeof(qint16);
+        desc->elementSize = sizeof(qint16);
         break;
     case INT32:
-        elementSize = sizeof(qint32);
+        desc->elementSize = sizeof(qint32);
         break;
     case UINT8:
-        elementSize = sizeof(quint8);
+        desc->elementSize = sizeof(quint8);
         break;
     case UINT16:
-        elementSize = sizeof(quint16);
+        desc->elementSize = sizeof(quint16);
         break;
     case UINT32:
-        elementSize = sizeof(quint32);
+        desc->elementSize = sizeof(quint32);
         break;
     case FLOAT32:
-        elementSize = sizeof(quint32);
+        desc->elementSize = sizeof(quint32);
         break;
     case ENUM:
-        elementSize = sizeof(quint8);
+        desc->elementSize = sizeof(quint8);
         break;
     case BITFIELD:
-        elementSize = sizeof(quint8);
-        this->options = QStringList() << tr("0") << tr("1");
-        this->indices = QList<int>() << 0 << 1;
+        desc->elementSize = sizeof(quint8);
+        desc->options = QStringList() << tr("0") << tr("1");
+        desc->indices = QList<int>() << 0 << 1;
         break;
     case STRING:
-        elementSize = sizeof(quint8);
+        desc->elementSize = sizeof(quint8);
         break;
     }
-    limitsInitialize(limits);
+    limitsInitialize(*desc, limits);
 
     // store default values, default to zero when not provided
-    this->defaultValues = defaultValues;
-    for (auto i = this->defaultValues.length(); i < this->numElements; i++)
-        this->defaultValues << QVariant(0);
+    desc->defaultValues = defaultValues;
+    for (auto i = desc->defaultValues.length(); i < desc->numElements; i++)
+        desc->defaultValues << QVariant(0);
 
     // fast lookup
-    for (int i = 0; i < indices.length(); i++)
-        enumToIndex.emplace(std::make_pair(indices.at(i), i));
+    for (int i = 0; i < desc->indices.length(); i++)
+        desc->enumToIndex.emplace(std::make_pair(desc->indices.at(i), i));
+
+    return desc;
 }
 
-void UAVObjectField::limitsInitialize(const QString &limits)
+void UAVObjectField::limitsInitialize(Descriptor &desc, const QString &limits)
 {
     /// format
     /// (TY)->type (EQ-equal;NE-not equal;BE-between;BI-bigger;SM-smaller)
@@ -153,7 +181,7 @@ void UAVObjectField::limitsInitialize(const QString &limits)
             QStringList valuesPerElement = _str.split(":");
             LimitStruct lstruc;
             bool startFlag = valuesPerElement.at(0).startsWith("%");
-            bool maxIndexFlag = index < numElements;
+            bool maxIndexFlag = index < desc.numElements;
             bool elemNumberSizeFlag = valuesPerElement.at(0).size() == 3;
             bool aux;
             valuesPerElement.at(0).mid(1, 4).toInt(&aux, 16);
@@ -175,11 +203,11 @@ void UAVObjectField::limitsInitialize(const QString &limits)
                     lstruc.type = SMALLER;
                 else
                     qDebug() << "limits parsing failed (invalid property) on UAVObjectField"
-                             << name;
+                             << desc.name;
                 valuesPerElement.removeAt(0);
                 foreach (const QString &_value, valuesPerElement) {
                     QString value = _value.trimmed();
-                    switch (type) {
+                    switch (desc.type) {
                     case UINT8:
                     case UINT16:
                     case UINT32:
@@ -209,33 +237,33 @@ void UAVObjectField::limitsInitialize(const QString &limits)
                 if (!valuesPerElement.at(0).isEmpty() && !startFlag)
                     qDebug()
                         << "limits parsing failed (property doesn't start with %) on UAVObjectField"
-                        << name;
+                        << desc.name;
                 else if (!maxIndexFlag)
                     qDebug() << "limits parsing failed (index>numelements) on UAVObjectField"
-                             << name << "index" << index << "numElements" << numElements;
+                             << desc.name << "index" << index << "numElements" << desc.numElements;
                 else if (!elemNumberSizeFlag || !b4)
                     qDebug() << "limits parsing failed limit not starting with %XX or %YYYYXX "
                                 "where XX is the limit type and YYYY is the board type on "
                                 "UAVObjectField"
-                             << name;
+                             << desc.name;
             }
         }
-        elementLimits.insert(index, limitList);
+        desc.elementLimits.insert(index, limitList);
         ++index;
     }
 }
 
 bool UAVObjectField::isWithinLimits(QVariant var, int index, int board) const
 {
-    if (!elementLimits.keys().contains(index))
+    if (!desc->elementLimits.contains(index))
         return true;
 
-    foreach (const LimitStruct &struc, elementLimits.value(index)) {
+    foreach (const LimitStruct &struc, desc->elementLimits.value(index)) {
         if ((struc.board != board) && board != 0 && struc.board != 0)
             continue;
         switch (struc.type) {
         case EQUAL:
-            switch (type) {
+            switch (desc->type) {
             case INT8:
             case INT16:
             case INT32:
@@ -275,7 +303,7 @@ bool UAVObjectField::isWithinLimits(QVariant var, int index, int board) const
             }
             break;
         case NOT_EQUAL:
-            switch (type) {
+            switch (desc->type) {
             case INT8:
             case INT16:
             case INT32:
@@ -317,13 +345,13 @@ bool UAVObjectField::isWithinLimits(QVariant var, int index, int board) const
         case BETWEEN:
             if (struc.values.length() < 2) {
                 qDebug() << __FUNCTION__
-                         << "between limit with less than 1 pair, aborting; field:" << name;
+                         << "between limit with less than 1 pair, aborting; field:" << desc->name;
                 return true;
             }
             if (struc.values.length() > 2)
                 qDebug() << __FUNCTION__
-                         << "between limit with more than 1 pair, using first; field" << name;
-            switch (type) {
+                         << "between limit with more than 1 pair, using first; field" << desc->name;
+            switch (desc->type) {
             case INT8:
             case INT16:
             case INT32:
@@ -345,10 +373,10 @@ bool UAVObjectField::isWithinLimits(QVariant var, int index, int board) const
                 // OK, I think this is OK with parents.  Because we'll
                 // consider the limit to mean "as ordered in this object".
                 // So no need to map to underlying types.
-                if (!(options.indexOf(var.toString())
-                          >= options.indexOf(struc.values.at(0).toString())
-                      && options.indexOf(var.toString())
-                          <= options.indexOf(struc.values.at(1).toString())))
+                if (!(desc->options.indexOf(var.toString())
+                          >= desc->options.indexOf(struc.values.at(0).toString())
+                      && desc->options.indexOf(var.toString())
+                          <= desc->options.indexOf(struc.values.at(1).toString())))
                     return false;
                 return true;
                 break;
@@ -368,13 +396,13 @@ bool UAVObjectField::isWithinLimits(QVariant var, int index, int board) const
         case BIGGER:
             if (struc.values.length() < 1) {
                 qDebug() << __FUNCTION__
-                         << "BIGGER limit with less than 1 value, aborting; field:" << name;
+                         << "BIGGER limit with less than 1 value, aborting; field:" << desc->name;
                 return true;
             }
             if (struc.values.length() > 1)
                 qDebug() << __FUNCTION__
-                         << "BIGGER limit with more than 1 value, using first; field" << name;
-            switch (type) {
+                         << "BIGGER limit with more than 1 value, using first; field" << desc->name;
+            switch (desc->type) {
             case INT8:
             case INT16:
             case INT32:
@@ -391,8 +419,8 @@ bool UAVObjectField::isWithinLimits(QVariant var, int index, int board) const
                 return true;
                 break;
             case ENUM:
-                if (!(options.indexOf(var.toString())
-                      >= options.indexOf(struc.values.at(0).toString())))
+                if (!(desc->options.indexOf(var.toString())
+                      >= desc->options.indexOf(struc.values.at(0).toString())))
                     return false;
                 return true;
                 break;
@@ -409,7 +437,7 @@ bool UAVObjectField::isWithinLimits(QVariant var, int index, int board) const
             }
             break;
         case SMALLER:
-            switch (type) {
+            switch (desc->type) {
             case INT8:
             case INT16:
             case INT32:
@@ -426,8 +454,8 @@ bool UAVObjectField::isWithinLimits(QVariant var, int index, int board) const
                 return true;
                 break;
             case ENUM:
-                if (!(options.indexOf(var.toString())
-                      <= options.indexOf(struc.values.at(0).toString())))
+                if (!(desc->options.indexOf(var.toString())
+                      <= desc->options.indexOf(struc.values.at(0).toString())))
                     return false;
                 return true;
                 break;
@@ -449,9 +477,9 @@ bool UAVObjectField::isWithinLimits(QVariant var, int index, int board) const
 
 QVariant UAVObjectField::getMaxLimit(int index, int board) const
 {
-    if (!elementLimits.keys().contains(index)) {
+    if (!desc->elementLimits.contains(index)) {
         // if nothing explicitly specified, assume max possible value
-        switch (type) {
+        switch (desc->type) {
         case INT8:
             return INT8_MAX;
         case INT16:
@@ -474,7 +502,7 @@ QVariant UAVObjectField::getMaxLimit(int index, int board) const
         return QVariant();
     }
 
-    foreach (const LimitStruct &struc, elementLimits.value(index)) {
+    foreach (const LimitStruct &struc, desc->elementLimits.value(index)) {
         if ((struc.board != board) && board != 0 && struc.board != 0)
             continue;
         switch (struc.type) {
@@ -499,9 +527,9 @@ QVariant UAVObjectField::getMaxLimit(int index, int board) const
 }
 QVariant UAVObjectField::getMinLimit(int index, int board) const
 {
-    if (!elementLimits.keys().contains(index)) {
+    if (!desc->elementLimits.contains(index)) {
         // if nothing explicitly specified, assume min possible value
-        switch (type) {
+        switch (desc->type) {
         case INT8:
             return INT8_MIN;
         case INT16:
@@ -522,7 +550,7 @@ QVariant UAVObjectField::getMinLimit(int index, int board) const
         return QVariant();
     }
 
-    foreach (LimitStruct struc, elementLimits.value(index)) {
+    foreach (LimitStruct struc, desc->elementLimits.value(index)) {
         if ((struc.board != board) && board != 0 && struc.board != 0)
             return QVariant();
         switch (struc.type) {
@@ -555,12 +583,12 @@ void UAVObjectField::initialize(quint8 *data, quint32 dataOffset, UAVObject *obj
 
 UAVObjectField::FieldType UAVObjectField::getType() const
 {
-    return type;
+    return desc->type;
 }
 
 QString UAVObjectField::getTypeAsString() const
 {
-    switch (type) {
+    switch (desc->type) {
     case UAVObjectField::INT8:
         return "int8";
     case UAVObjectField::INT16:
@@ -588,28 +616,28 @@ QString UAVObjectField::getTypeAsString() const
 
 QStringList UAVObjectField::getElementNames() const
 {
-    return elementNames;
+    return desc->elementNames;
 }
 
 QString UAVObjectField::getElementName(int index) const
 {
-    if (index < 0 || index >= elementNames.length()) {
+    if (index < 0 || index >= desc->elementNames.length()) {
         Q_ASSERT(false);
-        qWarning() << "Invalid element:" << index << " max=" << elementNames.length();
+        qWarning() << "Invalid element:" << index << " max=" << desc->elementNames.length();
         return "";
     }
-    return elementNames.at(index);
+    return desc->elementNames.at(index);
 }
 
 /**
  * @brief Get the index of an element from it's name
- * @param name Element name
+ * @param elementName Element name
  * @return index on success, -1 on failure
  */
-int UAVObjectField::getElementIndex(const QString &name) const
+int UAVObjectField::getElementIndex(const QString &elementName) const
 {
-    for (int i = 0; i < elementNames.length(); i++) {
-        if (elementNames.at(i) == name)
+    for (int i = 0; i < desc->elementNames.length(); i++) {
+        if (desc->elementNames.at(i) == elementName)
             return i;
     }
     return -1;
@@ -622,122 +650,122 @@ UAVObject *UAVObjectField::getObject() const
 
 void UAVObjectField::clear()
 {
-    switch (type) {
+    switch (desc->type) {
     case BITFIELD:
-        memset(&data[offset], 0, elementSize * ((quint32)(1 + (numElements - 1) / 8)));
+        memset(&data[offset], 0, desc->elementSize * ((quint32)(1 + (desc->numElements - 1) / 8)));
         break;
     default:
-        memset(&data[offset], 0, elementSize * numElements);
+        memset(&data[offset], 0, desc->elementSize * desc->numElements);
         break;
     }
 }
 
 QString UAVObjectField::getName() const
 {
-    return name;
+    return desc->name;
 }
 
 QString UAVObjectField::getUnits() const
 {
-    return units;
+    return desc->units;
 }
 
 QStringList UAVObjectField::getOptions() const
 {
-    return options;
+    return desc->options;
 }
 
 bool UAVObjectField::hasOption(const QString &option)
 {
-    return options.contains(option);
+    return desc->options.contains(option);
 }
 
 int UAVObjectField::getNumElements() const
 {
-    return numElements;
+    return desc->numElements;
 }
 
 size_t UAVObjectField::getNumBytes() const
 {
-    if (type == BITFIELD)
-        return elementSize * static_cast<size_t>((1 + (numElements - 1) / 8));
-    return elementSize * static_cast<size_t>(numElements);
+    if (desc->type == BITFIELD)
+        return desc->elementSize * static_cast<size_t>((1 + (desc->numElements - 1) / 8));
+    return desc->elementSize * static_cast<size_t>(desc->numElements);
 }
 
 QString UAVObjectField::toString() const
 {
     QString sout;
-    sout.append(QString("%1: [ ").arg(name));
-    for (auto n = 0; n < numElements; ++n) {
-        if (type == ENUM) {
+    sout.append(QString("%1: [ ").arg(desc->name));
+    for (auto n = 0; n < desc->numElements; ++n) {
+        if (desc->type == ENUM) {
             sout.append(QString("%1 ").arg(getValue(n).toString()));
         } else {
             sout.append(QString("%1 ").arg(getDouble(n)));
         }
     }
-    sout.append(QString("] %1\n").arg(units));
+    sout.append(QString("] %1\n").arg(desc->units));
     return sout;
 }
 
 qint32 UAVObjectField::pack(quint8 *dataOut)
 {
     // Pack each element in output buffer
-    switch (type) {
+    switch (desc->type) {
     case INT8:
-        memcpy(dataOut, &data[offset], numElements);
+        memcpy(dataOut, &data[offset], desc->numElements);
         break;
     case INT16:
-        for (auto index = 0; index < numElements; ++index) {
+        for (auto index = 0; index < desc->numElements; ++index) {
             qint16 value;
-            memcpy(&value, &data[offset + elementSize * index], elementSize);
-            qToLittleEndian<qint16>(value, &dataOut[elementSize * index]);
+            memcpy(&value, &data[offset + desc->elementSize * index], desc->elementSize);
+            qToLittleEndian<qint16>(value, &dataOut[desc->elementSize * index]);
         }
         break;
     case INT32:
-        for (auto index = 0; index < numElements; ++index) {
+        for (auto index = 0; index < desc->numElements; ++index) {
             qint32 value;
-            memcpy(&value, &data[offset + elementSize * index], elementSize);
-            qToLittleEndian<qint32>(value, &dataOut[elementSize * index]);
+            memcpy(&value, &data[offset + desc->elementSize * index], desc->elementSize);
+            qToLittleEndian<qint32>(value, &dataOut[desc->elementSize * index]);
         }
         break;
     case UINT8:
-        for (auto index = 0; index < numElements; ++index) {
-            dataOut[elementSize * index] = data[offset + elementSize * index];
+        for (auto index = 0; index < desc->numElements; ++index) {
+            dataOut[desc->elementSize * index] = data[offset + desc->elementSize * index];
         }
         break;
     case UINT16:
-        for (auto index = 0; index < numElements; ++index) {
+        for (auto index = 0; index < desc->numElements; ++index) {
             quint16 value;
-            memcpy(&value, &data[offset + elementSize * index], elementSize);
-            qToLittleEndian<quint16>(value, &dataOut[elementSize * index]);
+            memcpy(&value, &data[offset + desc->elementSize * index], desc->elementSize);
+            qToLittleEndian<quint16>(value, &dataOut[desc->elementSize * index]);
         }
         break;
     case UINT32:
-        for (auto index = 0; index < numElements; ++index) {
+        for (auto index = 0; index < desc->numElements; ++index) {
             quint32 value;
-            memcpy(&value, &data[offset + elementSize * index], elementSize);
-            qToLittleEndian<quint32>(value, &dataOut[elementSize * index]);
+            memcpy(&value, &data[offset + desc->elementSize * index], desc->elementSize);
+            qToLittleEndian<quint32>(value, &dataOut[desc->elementSize * index]);
         }
         break;
     case FLOAT32:
-        for (auto index = 0; index < numElements; ++index) {
+        for (auto index = 0; index < desc->numElements; ++index) {
             quint32 value;
-            memcpy(&value, &data[offset + elementSize * index], elementSize);
-            qToLittleEndian<quint32>(value, &dataOut[elementSize * index]);
+            memcpy(&value, &data[offset + desc->elementSize * index], desc->elementSize);
+            qToLittleEndian<quint32>(value, &dataOut[desc->elementSize * index]);
         }
         break;
     case ENUM:
-        for (auto index = 0; index < numElements; ++index) {
-            dataOut[elementSize * index] = data[offset + elementSize * index];
+        for (auto index = 0; index < desc->numElements; ++index) {
+            dataOut[desc->elementSize * index] = data[offset + desc->elementSize * index];
         }
         break;
     case BITFIELD:
-        for (auto index = 0; index < (1 + (numElements - 1) / 8); ++index) {
-            dataOut[elementSize * index] = data[offset + elementSize * index];
+        for (auto index = 0; index < (1 + (desc->numElements - 1) / 8); ++index) {
+            dataOut[desc->elementSize * index] = data[offset + desc->elementSize * index];
         }
         break;
     case STRING:
-        memcpy(dataOut, &data[offset], numElements);
+        memcpy(dataOut, &data[offset], desc->numElements);
         break;
     }
     // Done
@@ -747,62 +775,62 @@ qint32 UAVObjectField::pack(quint8 *dataOut)
 qint32 UAVObjectField::unpack(const quint8 *dataIn)
 {
     // Unpack each element from input buffer
-    switch (type) {
+    switch (desc->type) {
     case INT8:
-        memcpy(&data[offset], dataIn, numElements);
+        memcpy(&data[offset], dataIn, desc->numElements);
         break;
     case INT16:
-        for (auto index = 0; index < numElements; ++index) {
+        for (auto index = 0; index < desc->numElements; ++index) {
             qint16 value;
-            value = qFromLittleEndian<qint16>(&dataIn[elementSize * index]);
-            memcpy(&data[offset + elementSize * index], &value, elementSize);
+            value = qFromLittleEndian<qint16>(&dataIn[desc->elementSize * index]);
+            memcpy(&data[offset + desc->elementSize * index], &value, desc->elementSize);
         }
         break;
     case INT32:
-        for (auto index = 0; index < numElements; ++index) {
+        for (auto index = 0; index < desc->numElements; ++index) {
             qint32 value;
-            value = qFromLittleEndian<qint32>(&dataIn[elementSize * index]);
-            memcpy(&data[offset + elementSize * index], &value, elementSize);
+            value = qFromLittleEndian<qint32>(&dataIn[desc->elementSize * index]);
+            memcpy(&data[offset + desc->elementSize * index], &value, desc->elementSize);
         }
         break;
     case UINT8:
-        for (auto index = 0; index < numElements; ++index) {
-            data[offset + elementSize * index] = dataIn[elementSize * index];
+        for (auto index = 0; index < desc->numElements; ++index) {
+            data[offset + desc->elementSize * index] = dataIn[desc->elementSize * index];
         }
         break;
     case UINT16:
-        for (auto index = 0; index < numElements; ++index) {
+        for (auto index = 0; index < desc->numElements; ++index) {
             quint16 value;
-            value = qFromLittleEndian<quint16>(&dataIn[elementSize * index]);
-            memcpy(&data[offset + elementSize * index], &value, elementSize);
+            value = qFromLittleEndian<quint16>(&dataIn[desc->elementSize * index]);
+            memcpy(&data[offset + desc->elementSize * index], &value, desc->elementSize);
         }
         break;
     case UINT32:
-        for (auto index = 0; index < numElements; ++index) {
+        for (auto index = 0; index < desc->numElements; ++index) {
             quint32 value;
-            value = qFromLittleEndian<quint32>(&dataIn[elementSize * index]);
-            memcpy(&data[offset + elementSize * index], &value, elementSize);
+            value = qFromLittleEndian<quint32>(&dataIn[desc->elementSize * index]);
+            memcpy(&data[offset + desc->elementSize * index], &value, desc->elementSize);
         }
         break;
     case FLOAT32:
-        for (auto index = 0; index < numElements; ++index) {
+        for (auto index = 0; index < desc->numElements; ++index) {
             quint32 value;
-            value = qFromLittleEndian<quint32>(&dataIn[elementSize * index]);
-            memcpy(&data[offset + elementSize * index], &value, elementSize);
+            value = qFromLittleEndian<quint32>(&dataIn[desc->elementSize * index]);
+            memcpy(&data[offset + desc->elementSize * index], &value, desc->elementSize);
         }
         break;
     case ENUM:
-        for (auto index = 0; index < numElements; ++index) {
-            data[offset + elementSize * index] = dataIn[elementSize * index];
+        for (auto index = 0; index < desc->numElements; ++index) {
+            data[offset + desc->elementSize * index] = dataIn[desc->elementSize * index];
         }
         break;
     case BITFIELD:
-        for (auto index = 0; index < (1 + (numElements - 1) / 8); ++index) {
-            data[offset + elementSize * index] = dataIn[elementSize * index];
+        for (auto index = 0; index < (1 + (desc->numElements - 1) / 8); ++index) {
+            data[offset + desc->elementSize * index] = dataIn[desc->elementSize * index];
         }
         break;
     case STRING:
-        memcpy(&data[offset], dataIn, numElements);
+        memcpy(&data[offset], dataIn, desc->numElements);
         break;
     }
     // Done
@@ -811,7 +839,7 @@ qint32 UAVObjectField::unpack(const quint8 *dataIn)
 
 bool UAVObjectField::isNumeric() const
 {
-    switch (type) {
+    switch (desc->type) {
     case INT8:
     case INT16:
     case INT32:
@@ -830,7 +858,7 @@ bool UAVObjectField::isNumeric() const
 
 bool UAVObjectField::isText() const
 {
-    switch (type) {
+    switch (desc->type) {
     case INT8:
     case INT16:
     case INT32:
@@ -850,13 +878,13 @@ bool UAVObjectField::isText() const
 QVariant UAVObjectField::getValue(int index) const
 {
     // Check that index is not out of bounds
-    if (index < 0 || index >= numElements) {
+    if (index < 0 || index >= desc->numElements) {
         return QVariant();
     }
 
-    const void *d = &data[offset + elementSize * static_cast<unsigned>(index)];
+    const void *d = &data[offset + desc->elementSize * static_cast<unsigned>(index)];
 
-    switch (type) {
+    switch (desc->type) {
     case INT8:
         // QVariant treats qint8 as char :(
         return QVariant::fromValue(static_cast<int>(*static_cast<const qint8 *>(d)));
@@ -875,22 +903,22 @@ QVariant UAVObjectField::getValue(int index) const
         return QVariant::fromValue(*static_cast<const float *>(d));
     case ENUM:
         try {
-            auto i = enumToIndex.at(*static_cast<const quint8 *>(d));
-            return QVariant::fromValue(options[i]);
+            auto i = desc->enumToIndex.at(*static_cast<const quint8 *>(d));
+            return QVariant::fromValue(desc->options[i]);
         } catch (const std::out_of_range &e) {
             qWarning() << "Invalid value" << *static_cast<const quint8 *>(d)
-                       << "for ENUM field" << name << ":" << e.what();
+                       << "for ENUM field" << desc->name << ":" << e.what();
         }
         return QVariant::fromValue(QStringLiteral("Bad Value"));
     case BITFIELD: {
-        d = &data[offset + elementSize * static_cast<unsigned>(index / 8)];
+        d = &data[offset + desc->elementSize * static_cast<unsigned>(index / 8)];
         quint8 val = (*static_cast<const quint8 *>(d) >> (index % 8)) & 1;
         return QVariant::fromValue(val > 0 ? QChar('1') : QChar('0'));
     }
     case STRING:
         return QVariant::fromValue(QString::fromLatin1(static_cast<const char *>(d),
             static_cast<int>(strnlen(static_cast<const char *>(d),
-                                     static_cast<size_t>(numElements)))));
+                                     static_cast<size_t>(desc->numElements)))));
     }
     // If this point is reached then we got an invalid type
     Q_ASSERT(false);
@@ -900,14 +928,14 @@ QVariant UAVObjectField::getValue(int index) const
 bool UAVObjectField::checkValue(const QVariant &value, int index) const
 {
     // Check that index is not out of bounds
-    if (index < 0 || index >= numElements) {
+    if (index < 0 || index >= desc->numElements) {
         return false;
     }
     // Get metadata
     UAVObject::Metadata mdata = obj->getMetadata();
     // Update value if the access mode permits
     if (UAVObject::GetFlightAccess(mdata) == UAVObject::ACCESS_READWRITE) {
-        switch (type) {
+        switch (desc->type) {
         case INT8:
         case INT16:
         case INT32:
@@ -920,11 +948,11 @@ bool UAVObjectField::checkValue(const QVariant &value, int index) const
             return true;
         case ENUM:
             if (static_cast<QMetaType::Type>(value.type()) == QMetaType::QString) {
-                int idx = options.indexOf(value.toString());
-                if (idx >= 0 && idx < indices.length())
+                int idx = desc->options.indexOf(value.toString());
+                if (idx >= 0 && idx < desc->indices.length())
                     return true;
             } else if (value.canConvert(QMetaType::Int)) {
-                if (indices.contains(value.toInt()))
+                if (desc->indices.contains(value.toInt()))
                     return true;
             }
             return false;
@@ -936,17 +964,17 @@ bool UAVObjectField::checkValue(const QVariant &value, int index) const
 void UAVObjectField::setValue(const QVariant &value, int index)
 {
     // Check that index is not out of bounds
-    if (index < 0 || index >= numElements) {
+    if (index < 0 || index >= desc->numElements) {
         return;
     }
 
-    void *d = &data[offset + elementSize * static_cast<unsigned>(index)];
+    void *d = &data[offset + desc->elementSize * static_cast<unsigned>(index)];
 
     // Get metadata
     UAVObject::Metadata mdata = obj->getMetadata();
     // Update value if the access mode permits
     if (UAVObject::GetGcsAccess(mdata) == UAVObject::ACCESS_READWRITE) {
-        switch (type) {
+        switch (desc->type) {
         case INT8:
             *static_cast<qint8 *>(d) = static_cast<qint8>(value.toInt());
             break;
@@ -970,39 +998,47 @@ void UAVObjectField::setValue(const QVariant &value, int index)
             break;
         case ENUM:
             if (static_cast<QMetaType::Type>(value.type()) == QMetaType::QString) {
-                int idx = options.indexOf(value.toString());
-                if (idx < 0 || idx >= indices.length()) {
+                int idx = desc->options.indexOf(value.toString());
+                if (idx < 0 || idx >= desc->indices.length()) {
                     Q_ASSERT(false);
-                    qWarning() << "Invalid option!" << obj->getName() << name << value.toString();
+                    qWarning() << "Invalid option!" << obj->getName() << desc->name
+                               << value.toString();
                     return;
                 }
-                *static_cast<quint8 *>(d) = static_cast<quint8>(indices[idx]);
+                *static_cast<quint8 *>(d) = static_cast<quint8>(desc->indices[idx]);
             } else if (value.canConvert(QMetaType::Int)) {
-                if (!indices.contains(value.toInt())) {
+                if (!desc->indices.contains(value.toInt())) {
                     Q_ASSERT(false);
-                    qWarning() << "Invalid option!" << obj->getName() << name << value.toInt();
+                    qWarning() << "Invalid option!" << obj->getName() << desc->name
+                               << value.toInt();
                     return;
                 }
                 *static_cast<quint8 *>(d) = static_cast<quint8>(value.toInt());
             } else {
                 Q_ASSERT(false);
-                qWarning() << "Invalid type!" << obj->getName() << name << value;
+                qWarning() << "Invalid type!" << obj->getName() << desc->name << value;
                 return;
             }
             break;
         case BITFIELD:
-            d = &data[offset + elementSize * static_cast<unsigned>(index / 8)];
+            d = &data[offset + desc->elementSize * static_cast<unsigned>(index / 8)];
             *static_cast<quint8 *>(d) &= ~(1 << (index % 8));
             *static_cast<quint8 *>(d) |= ((value.toUInt() != 0 ? 1 : 0) << (index % 8));
-            break;
+            obj->markDirty(offset + desc->elementSize * static_cast<unsigned>(index / 8),
+                          static_cast<quint32>(desc->elementSize));
+            return;
         case STRING: {
             QByteArray barray = value.toString().toLatin1();
-            barray.resize(numElements);
-            barray[numElements - 1] = '\0';
-            memcpy(d, barray.constData(), static_cast<size_t>(numElements));
-            break;
+            barray.resize(desc->numElements);
+            barray[desc->numElements - 1] = '\0';
+            memcpy(d, barray.constData(), static_cast<size_t>(desc->numElements));
+            obj->markDirty(offset, static_cast<quint32>(desc->numElements));
+            return;
         }
         }
+
+        obj->markDirty(offset + desc->elementSize * static_cast<unsigned>(index),
+                       static_cast<quint32>(desc->elementSize));
     }
 }
 
@@ -1011,6 +1047,31 @@ double UAVObjectField::getDouble(int index) const
     return getValue(index).toDouble();
 }
 
+/**
+ * @brief Get an accessor for reading an element quickly, over and over
+ * @param index The element; an accessor can also read the ones after it
+ * @return The accessor, invalid if there's no such element or the field is a string
+ */
+UAVObjectField::Accessor UAVObjectField::getAccessor(int index) const
+{
+    Accessor accessor;
+
+    if (index < 0 || index >= desc->numElements || desc->type == STRING || !data) {
+        return accessor;
+    }
+
+    accessor.type = desc->type;
+
+    if (desc->type == BITFIELD) {
+        accessor.base = &data[offset];
+        accessor.bit = index;
+    } else {
+        accessor.base = &data[offset + desc->elementSize * static_cast<unsigned>(index)];
+    }
+
+    return accessor;
+}
+
 void UAVObjectField::setDouble(double value, int index)
 {
     setValue(QVariant(value), index);
@@ -1018,17 +1079,17 @@ void UAVObjectField::setDouble(double value, int index)
 
 QString UAVObjectField::getDescription() const
 {
-    return description;
+    return desc->description;
 }
 
 QVariant UAVObjectField::getDefaultValue(int index) const
 {
-    return defaultValues.at(index);
+    return desc->defaultValues.at(index);
 }
 
 bool UAVObjectField::isDefaultValue(int index)
 {
-    switch (type) {
+    switch (desc->type) {
     case INT8:
     case INT16:
     case INT32: {
@@ -1063,7 +1124,7 @@ bool UAVObjectField::isDefaultValue(int index)
 
 int UAVObjectField::getDisplayIntegerBase() const
 {
-    switch (display) {
+    switch (desc->display) {
     case HEX:
         return 16;
     case BIN:
@@ -1077,7 +1138,7 @@ int UAVObjectField::getDisplayIntegerBase() const
 
 QString UAVObjectField::getDisplayPrefix() const
 {
-    switch (display) {
+    switch (desc->display) {
     case HEX:
         return QStringLiteral("0x");
     case BIN:
@@ -34,6 +34,8 @@
 #include <QVariant>
 #include <QList>
 #include <QMap>
+#include <QSharedPointer>
+#include <cstring>
 
 class UAVObject;
 
@@ -64,6 +66,98 @@ public:
         int board;
     };
 
+    /**
+     * Everything about a field but its data.  It's the same for every
+     * instance of an object, so generated objects build theirs once per
+     * type and every instance shares them; fields only hold where their
+     * data is.  Limits are parsed once, into elementLimits, when the
+     * descriptor is made.
+     */
+    struct Descriptor
+    {
+        QString name;
+        QString units;
+        FieldType type;
+        QStringList elementNames;
+        QList<int> indices;
+        std::map<int, int> enumToIndex;
+        QStringList options;
+        int numElements;
+        size_t elementSize;
+        QMap<int, QList<LimitStruct>> elementLimits;
+        QString description;
+        QList<QVariant> defaultValues;
+        DisplayType display;
+    };
+    typedef QSharedPointer<const Descriptor> DescriptorPtr;
+
+    /**
+     * Reads elements straight out of the object's data as doubles.  Where
+     * the element is and what type it has are worked out once, by
+     * getAccessor, rather than on every read as with getValue; this is for
+     * code that samples the same element over and over, like plots.
+     * Enums read as their stored value, and bitfields as 0 or 1.
+     */
+    class Accessor
+    {
+    public:
+        Accessor()
+            : base(nullptr)
+            , type(INT8)
+            , bit(0)
+        {
+        }
+
+        bool isValid() const { return base != nullptr; }
+
+        /**
+         * @brief Read an element
+         * @param n How many elements past the one this was made for
+         * @return The value
+         */
+        double at(int n = 0) const
+        {
+            switch (type) {
+            case INT8:
+                return read<qint8>(n);
+            case INT16:
+                return read<qint16>(n);
+            case INT32:
+                return read<qint32>(n);
+            case ENUM:
+            case UINT8:
+                return read<quint8>(n);
+            case UINT16:
+                return read<quint16>(n);
+            case UINT32:
+                return read<quint32>(n);
+            case FLOAT32:
+                return read<float>(n);
+            case BITFIELD:
+                return (base[(bit + n) / 8] >> ((bit + n) % 8)) & 1;
+            case STRING:
+                break;
+            }
+
+            return 0;
+        }
+
+    private:
+        friend class UAVObjectField;
+
+        template <typename T>
+        T read(int n) const
+        {
+            T value;
+            memcpy(&value, base + sizeof(T) * static_cast<unsigned>(n), sizeof(value));
+            return value;
+        }
+
+        const quint8 *base;
+        FieldType type;
+        int bit;
+    };
+
     UAVObjectField(const QString &name, const QString &units, FieldType type, int numElements,
                    const QStringList &options, const QList<int> &indices,
                    const QString &limits = QString(), const QString &description = QString(),
@@ -75,6 +169,22 @@ public:
                    const QString &description = QString(),
                    const QList<QVariant> defaultValues = QList<QVariant>(),
                    const DisplayType display = DEC);
+    explicit UAVObjectField(const DescriptorPtr &descriptor);
+
+    static DescriptorPtr
+    createDescriptor(const QString &name, const QString &units, FieldType type, int numElements,
+                     const QStringList &options, const QList<int> &indices,
+                     const QString &limits = QString(), const QString &description = QString(),
+                     const QList<QVariant> defaultValues = QList<QVariant>(),
+                     const DisplayType display = DEC);
+    static DescriptorPtr
+    createDescriptor(const QString &name, const QString &units, FieldType type,
+                     const QStringList &elementNames, const QStringList &options,
+                     const QList<int> &indices, const QString &limits = QString(),
+                     const QString &description = QString(),
+                     const QList<QVariant> defaultValues = QList<QVariant>(),
+                     const DisplayType display = DEC);
+
     void initialize(quint8 *data, quint32 dataOffset, UAVObject *obj);
     UAVObject *getObject() const;
     FieldType getType() const;
@@ -98,6 +208,7 @@ public:
     bool checkValue(const QVariant &data, int index = 0) const;
     void setValue(const QVariant &data, int index = 0);
     double getDouble(int index = 0) const;
+    Accessor getAccessor(int index = 0) const;
     void setDouble(double value, int index = 0);
     size_t getNumBytes() const;
     bool isNumeric() const;
@@ -134,30 +245,13 @@ signals:
     void fieldUpdated(UAVObjectField *field);
 
 protected:
-    QString name;
-    QString units;
-    FieldType type;
-    QStringList elementNames;
-    QList<int> indices;
-    std::map<int, int> enumToIndex;
-    QStringList options;
-    int numElements;
-    size_t elementSize;
+    DescriptorPtr desc;
     size_t offset;
     quint8 *data;
     UAVObject *obj;
-    QMap<int, QList<LimitStruct>> elementLimits;
-    QString description;
-    QList<QVariant> defaultValues;
-    DisplayType display;
 
     void clear();
-    void constructorInitialize(const QString &name, const QString &units, FieldType type,
-                               const QStringList &elementNames, const QStringList &options,
-                               const QList<int> &indices, const QString &limits,
-                               const QString &description, const QList<QVariant> defaultValues,
-                               const DisplayType display);
-    void limitsInitialize(const QString &limits);
+    static void limitsInitialize(Descriptor &desc, const QString &limits);
 };
 
 #endif // UAVOBJECTFIELD_H
@@ -38,7 +38,11 @@
  * Constructor
  */
 UAVObjectManager::UAVObjectManager()
+    : changes(CHANGE_TICK_MS)
+    , vectorsValid(false)
 {
+    connect(&changes, &UAVObjectUpdateCoalescer::objectChanged, this,
+            &UAVObjectManager::deliverChange);
 }
 
 UAVObjectManager::~UAVObjectManager()
@@ -59,41 +63,28 @@ bool UAVObjectManager::registerObject(UAVDataObject *obj)
     quint32 objID = obj->getObjID();
     if (objects.contains(objID)) // Known object ID
     {
-        if (objects.value(objID).contains(obj->getInstID())) // Instance already present
+        const QVector<UAVObject *> &instances = objects[objID];
+        quint32 numInstances = static_cast<quint32>(instances.size());
+
+        if (obj->getInstID() < numInstances) // Instance already present
             return false;
         if (obj->isSingleInstance())
             return false;
         if (obj->getInstID() >= MAX_INSTANCES)
             return false;
-        UAVDataObject *refObj = dynamic_cast<UAVDataObject *>(objects.value(objID).first());
+        UAVDataObject *refObj = dynamic_cast<UAVDataObject *>(instances.first());
         if (refObj == NULL) {
             return false;
         }
         UAVMetaObject *mobj = refObj->getMetaObject();
-        if (objects.value(objID).last()->getInstID() < obj->getInstID()) // Space between last
-                                                                         // existent instance and
-                                                                         // new one, lets fill the
-                                                                         // gaps
-        {
-            for (quint32 instidx = objects.value(objID).last()->getInstID() + 1;
-                 instidx < obj->getInstID(); ++instidx) {
-                UAVDataObject *cobj = obj->clone(instidx);
-                cobj->initialize(instidx, mobj);
-                QMap<quint32, UAVObject *> ppp;
-                ppp.insert(instidx, cobj);
-                objects[objID].insert(instidx, cobj);
-                getObject(cobj->getObjID())->emitNewInstance(cobj); // TODO??
-                emit newInstance(cobj);
-            }
-        } else if (obj->getInstID() == 0)
-            obj->initialize(objects.value(objID).last()->getObjID() + 1, mobj);
-        else {
-            return false;
+        // Space between last existent instance and new one, lets fill the gaps
+        for (quint32 instidx = numInstances; instidx < obj->getInstID(); ++instidx) {
+            UAVDataObject *cobj = obj->clone(instidx);
+            cobj->initialize(instidx, mobj);
+            addInstance(objID, cobj);
         }
         // Add the actual object instance in the list
-        objects[objID].insert(obj->getInstID(), obj);
-        getObject(objID)->emitNewInstance(obj);
-        emit newInstance(obj);
+        addInstance(objID, obj);
         return true;
     } else {
         // If this point is reached then this is the first time this object type (ID) is added in
@@ -125,87 +116,120 @@ bool UAVObjectManager::unRegisterObject(UAVDataObject *obj)
     quint32 objID = obj->getObjID();
     if (obj->isSingleInstance())
         return false;
-    quint32 instances = (quint32)objects.value(obj->getObjID()).count();
-    for (quint32 x = obj->getInstID(); x < instances; ++x) {
-        getObject(objects.value(objID).value(x)->getObjID())
-            ->emitInstanceRemoved(objects.value(objID).value(x));
-        emit instanceRemoved(objects.value(objID).value(x));
-        objects[objID].remove(x);
+    if (!objects.contains(objID))
+        return false;
+    QVector<UAVObject *> &instances = objects[objID];
+    for (int x = static_cast<int>(obj->getInstID()); x < instances.size(); ++x) {
+        changes.unwatch(instances.at(x));
+        getObject(objID)->emitInstanceRemoved(instances.at(x));
+        emit instanceRemoved(instances.at(x));
     }
+    if (static_cast<int>(obj->getInstID()) < instances.size())
+        instances.resize(static_cast<int>(obj->getInstID()));
+    vectorsValid = false;
     return true;
 }
 
 void UAVObjectManager::addObject(UAVObject *obj)
 {
     // Add to list
-    QMap<quint32, UAVObject *> list;
-    list.insert(obj->getInstID(), obj);
-    objects.insert(obj->getObjID(), list);
+    objects.insert(obj->getObjID(), QVector<UAVObject *>(1, obj));
+    objectIds.insert(obj->getName(), obj->getObjID());
+    vectorsValid = false;
 
-    objectsByName.insert(obj->getName(), list);
+    changes.watch(obj);
 
     emit newObject(obj);
 }
 
 /**
- * Get all objects. A two dimentional QVector is returned. Objects are grouped by
- * instances of the same object type.
+ * Adds another instance of a known object; instances go in ID order
  */
-QVector<QVector<UAVObject *>> UAVObjectManager::getObjectsVector()
+void UAVObjectManager::addInstance(quint32 objId, UAVDataObject *obj)
 {
-    QVector<QVector<UAVObject *>> vector;
-    foreach (const ObjectMap &map, objects.values()) {
-        QVector<UAVObject *> vec = map.values().toVector();
-        vector.append(vec);
-    }
-    return vector;
+    objects[objId].append(obj);
+    vectorsValid = false;
+
+    changes.watch(obj);
+
+    getObject(objId)->emitNewInstance(obj);
+    emit newInstance(obj);
 }
 
-QHash<quint32, QMap<quint32, UAVObject *>> UAVObjectManager::getObjects()
+/**
+ * Passes the batched changes of an object on to its objectChanged subscribers
+ */
+void UAVObjectManager::deliverChange(UAVObject *obj, quint64 changedFields)
 {
-    return objects;
+    obj->emitObjectChanged(changedFields);
 }
 
 /**
- * Same as getObjects() but will only return DataObjects.
+ * Rebuilds the vectors of all objects after objects were added or removed.
  */
-QVector<QVector<UAVDataObject *>> UAVObjectManager::getDataObjectsVector()
+void UAVObjectManager::updateVectors()
 {
-    QVector<QVector<UAVDataObject *>> vector;
-    foreach (const ObjectMap &map, objects.values()) {
-        UAVDataObject *obj = dynamic_cast<UAVDataObject *>(map.first());
-        if (obj != NULL) {
+    if (vectorsValid)
+        return;
+
+    objectsVector.clear();
+    dataObjectsVector.clear();
+    metaObjectsVector.clear();
+
+    foreach (const QVector<UAVObject *> &instances, objects) {
+        objectsVector.append(instances);
+
+        if (dynamic_cast<UAVDataObject *>(instances.first())) {
             QVector<UAVDataObject *> vec;
-            foreach (UAVObject *o, map) {
+            vec.reserve(instances.size());
+            foreach (UAVObject *o, instances) {
                 UAVDataObject *dobj = dynamic_cast<UAVDataObject *>(o);
                 if (dobj)
                     vec.append(dobj);
             }
-            vector.append(vec);
+            dataObjectsVector.append(vec);
+        } else if (dynamic_cast<UAVMetaObject *>(instances.first())) {
+            QVector<UAVMetaObject *> vec;
+            vec.reserve(instances.size());
+            foreach (UAVObject *o, instances) {
+                UAVMetaObject *mobj = dynamic_cast<UAVMetaObject *>(o);
+                if (mobj)
+                    vec.append(mobj);
+            }
+            metaObjectsVector.append(vec);
         }
     }
-    return vector;
+
+    vectorsValid = true;
+}
+
+/**
+ * Get all objects. A two dimentional QVector is returned. Objects are grouped by
+ * instances of the same object type.  The vectors are shared, so this is cheap
+ * unless objects were added or removed since the last call.
+ */
+QVector<QVector<UAVObject *>> UAVObjectManager::getObjectsVector()
+{
+    updateVectors();
+    return objectsVector;
+}
+
+/**
+ * Same as getObjectsVector() but will only return DataObjects.
+ */
+QVector<QVector<UAVDataObject *>> UAVObjectManager::getDataObjectsVector()
+{
+    updateVectors();
+    return dataObjectsVector;
 }
 
 /**
- * Same as getObjects() but will only return MetaObjects.
+ * Same as getObjectsVector() but will only return MetaObjects.
  */
 QVector<QVector<UAVMetaObject *>> UAVObjectManager::getMetaObjectsVector()
 {
-    QVector<QVector<UAVMetaObject *>> vector;
-    foreach (const ObjectMap &map, objects.values()) {
-        UAVMetaObject *obj = dynamic_cast<UAVMetaObject *>(map.first());
-        if (obj != NULL) {
-            QVector<UAVMetaObject *> vec;
-            foreach (UAVObject *o, map) {
-                UAVMetaObject *mobj = dynamic_cast<UAVMetaObject *>(o);
-                if (mobj)
-                    vec.append(mobj);
-            }
-            vector.append(vec);
-        }
-    }
-    return vector;
+    updateVectors();
+    return metaObjectsVector;
 }
 
 /**
@@ -214,7 +238,12 @@ QVector<QVector<UAVMetaObject *>> UAVObjectManager::getMetaObjectsVector()
  */
 UAVObject *UAVObjectManager::getObject(const QString &name, quint32 instId)
 {
-    return getObject(name, 0, instId);
+    QHash<QString, quint32>::const_iterator id = objectIds.constFind(name);
+
+    if (id == objectIds.constEnd())
+        return NULL;
+
+    return getObject(id.value(), instId);
 }
 
 /**
@@ -223,23 +252,12 @@ UAVObject *UAVObjectManager::getObject(const QString &name, quint32 instId)
  */
 UAVObject *UAVObjectManager::getObject(quint32 objId, quint32 instId)
 {
-    return getObject(NULL, objId, instId);
-}
-
-/**
- * Helper function for the public getObject() functions.
- */
-UAVObject *UAVObjectManager::getObject(const QString &name, quint32 objId, quint32 instId)
-{
-    if (name != NULL) {
-        if (objectsByName.contains(name)) {
-            return objectsByName.value(name).value(instId);
-        }
+    QHash<quint32, QVector<UAVObject *>>::const_iterator instances = objects.constFind(objId);
 
+    if (instances == objects.constEnd() || instId >= static_cast<quint32>(instances->size()))
         return NULL;
-    } else if (objects.contains(objId))
-        return objects.value(objId).value(instId);
-    return NULL;
+
+    return instances->at(static_cast<int>(instId));
 }
 
 /**
@@ -247,7 +265,12 @@ UAVObject *UAVObjectManager::getObject(const QString &name, quint32 objId, quint
  */
 QVector<UAVObject *> UAVObjectManager::getObjectInstancesVector(const QString &name)
 {
-    return getObjectInstancesVector(&name, 0);
+    QHash<QString, quint32>::const_iterator id = objectIds.constFind(name);
+
+    if (id == objectIds.constEnd())
+        return QVector<UAVObject *>();
+
+    return getObjectInstancesVector(id.value());
 }
 
 /**
@@ -255,22 +278,7 @@ QVector<UAVObject *> UAVObjectManager::getObjectInstancesVector(const QString &n
  */
 QVector<UAVObject *> UAVObjectManager::getObjectInstancesVector(quint32 objId)
 {
-    return getObjectInstancesVector(NULL, objId);
-}
-
-/**
- * Helper function for the public getObjectInstances()
- */
-QVector<UAVObject *> UAVObjectManager::getObjectInstancesVector(const QString *name, quint32 objId)
-{
-    if (name != NULL) {
-        foreach (const ObjectMap &map, objects) {
-            if (map.first()->getName().compare(name) == 0)
-                return map.values().toVector();
-        }
-    } else if (objects.contains(objId))
-        return objects.value(objId).values().toVector();
-    return QVector<UAVObject *>();
+    return objects.value(objId);
 }
 
 /**
@@ -278,7 +286,12 @@ QVector<UAVObject *> UAVObjectManager::getObjectInstancesVector(const QString *n
  */
 qint32 UAVObjectManager::getNumInstances(const QString &name)
 {
-    return getNumInstances(&name, 0);
+    QHash<QString, quint32>::const_iterator id = objectIds.constFind(name);
+
+    if (id == objectIds.constEnd())
+        return -1;
+
+    return getNumInstances(id.value());
 }
 
 /**
@@ -286,22 +299,12 @@ qint32 UAVObjectManager::getNumInstances(const QString &name)
  */
 qint32 UAVObjectManager::getNumInstances(quint32 objId)
 {
-    return getNumInstances(NULL, objId);
-}
+    QHash<quint32, QVector<UAVObject *>>::const_iterator instances = objects.constFind(objId);
 
-/**
- * Helper function for public getNumInstances
- */
-qint32 UAVObjectManager::getNumInstances(const QString *name, quint32 objId)
-{
-    if (name != NULL) {
-        foreach (const ObjectMap &map, objects) {
-            if (map.first()->getName().compare(name) == 0)
-                return map.count();
-        }
-    } else if (objects.contains(objId))
-        return objects.value(objId).count();
-    return -1;
+    if (instances == objects.constEnd())
+        return -1;
+
+    return instances->size();
 }
 
 UAVObjectField *UAVObjectManager::getField(const QString &objName, const QString &fieldName,
@@ -40,6 +40,7 @@
 #include "uavobjects/uavobject.h"
 #include "uavobjects/uavdataobject.h"
 #include "uavobjects/uavmetaobject.h"
+#include "uavobjects/uavobjectupdatecoalescer.h"
 #include <QVector>
 #include <QHash>
 
@@ -50,10 +51,8 @@ class UAVOBJECTS_EXPORT UAVObjectManager : public QObject
 public:
     UAVObjectManager();
     ~UAVObjectManager();
-    typedef QMap<quint32, UAVObject *> ObjectMap;
     bool registerObject(UAVDataObject *obj);
     QVector<QVector<UAVObject *>> getObjectsVector();
-    QHash<quint32, QMap<quint32, UAVObject *>> getObjects();
     QVector<QVector<UAVDataObject *>> getDataObjectsVector();
     QVector<QVector<UAVMetaObject *>> getMetaObjectsVector();
     UAVObject *getObject(const QString &name, quint32 instId = 0);
@@ -77,15 +76,30 @@ signals:
     void newInstance(UAVObject *obj);
     void instanceRemoved(UAVObject *obj);
 
+private slots:
+    void deliverChange(UAVObject *obj, quint64 changedFields);
+
 private:
     static const quint32 MAX_INSTANCES = 1000;
-    QHash<quint32, QMap<quint32, UAVObject *>> objects;
-    QHash<QString, QMap<quint32, UAVObject *>> objectsByName;
+    // Display rate of the objectChanged notifications
+    static const int CHANGE_TICK_MS = 33;
+
+    UAVObjectUpdateCoalescer changes;
+
+    // The instances of each object, indexed by instance ID
+    QHash<quint32, QVector<UAVObject *>> objects;
+    QHash<QString, quint32> objectIds;
+
+    // The vectors handed out by get*ObjectsVector, rebuilt only after
+    // objects come or go
+    bool vectorsValid;
+    QVector<QVector<UAVObject *>> objectsVector;
+    QVector<QVector<UAVDataObject *>> dataObjectsVector;
+    QVector<QVector<UAVMetaObject *>> metaObjectsVector;
 
     void addObject(UAVObject *obj);
-    UAVObject *getObject(const QString &name, quint32 objId, quint32 instId);
-    QVector<UAVObject *> getObjectInstancesVector(const QString *name, quint32 objId);
-    qint32 getNumInstances(const QString *name, quint32 objId);
+    void addInstance(quint32 objId, UAVDataObject *obj);
+    void updateVectors();
 };
 
 #endif // UAVOBJECTMANAGER_H
@@ -50,7 +50,8 @@ $(NAME)::$(NAME)(): UAVDataObject(OBJID, ISSINGLEINST, ISSETTINGS, NAME)
 {
     // Create fields
     QList<UAVObjectField*> fields;
-$(FIELDSINIT)
+    for (const UAVObjectField::DescriptorPtr &descriptor : fieldDescriptors())
+        fields.append(new UAVObjectField(descriptor));
     // Initialize object
     initializeFields(fields, reinterpret_cast <quint8 *> (&data), NUMBYTES);
     // Set the default field values
@@ -61,6 +62,23 @@ $(FIELDSINIT)
     connect(this, &$(NAME)::objectUpdated, this, &$(NAME)::emitNotifications);
 }
 
+/**
+ * Descriptors for the fields, made along with the first instance and
+ * shared by every instance after it
+ */
+const QList<UAVObjectField::DescriptorPtr> &$(NAME)::fieldDescriptors()
+{
+    static const QList<UAVObjectField::DescriptorPtr> descriptors = createFieldDescriptors();
+    return descriptors;
+}
+
+QList<UAVObjectField::DescriptorPtr> $(NAME)::createFieldDescriptors()
+{
+    QList<UAVObjectField::DescriptorPtr> descriptors;
+$(FIELDSINIT)
+    return descriptors;
+}
+
 /**
  * Get the default metadata for this object
  */
@@ -77,6 +95,7 @@ UAVObject::Metadata $(NAME)::getDefaultMetadata()
     metadata.flightTelemetryUpdatePeriod = $(FLIGHTTELEM_UPDATEPERIOD);
     metadata.gcsTelemetryUpdatePeriod = $(GCSTELEM_UPDATEPERIOD);
     metadata.loggingUpdatePeriod = $(LOGGING_UPDATEPERIOD);
+    metadata.flightTelemetryPriority = $(FLIGHTTELEM_PRIORITY);
     return metadata;
 }
 
@@ -108,11 +127,22 @@ void $(NAME)::setData(const DataFields& data)
     // Update object if the access mode permits
     if (UAVObject::GetGcsAccess(mdata) == ACCESS_READWRITE) {
         this->data = data;
+        markAllDirty();
         emit objectUpdatedAuto(this); // trigger object updated event
         emit objectUpdated(this);
     }
 }
 
+/**
+ * Record that a field (or field element) of the object data was changed
+ */
+void $(NAME)::markFieldDirty(const void *field, quint32 length)
+{
+    markDirty(static_cast<quint32>(static_cast<const quint8 *>(field)
+                                   - reinterpret_cast<const quint8 *>(&data)),
+              length);
+}
+
 void $(NAME)::emitNotifications()
 {
     $(NOTIFY_PROPERTIES_CHANGED)
@@ -36,8 +36,6 @@
 #include "uavobjects/uavdataobject.h"
 #include "uavobjects/uavobjectmanager.h"
 
-#include "uavogcsversion.h"
-
 $(PARENT_INCLUDES)
 
 class UAVOBJECTS_EXPORT $(NAME): public UAVDataObject
@@ -98,6 +96,10 @@ private:
     DataFields data;
 
     void setDefaultFieldValues();
+    void markFieldDirty(const void *field, quint32 length);
+
+    static const QList<UAVObjectField::DescriptorPtr> &fieldDescriptors();
+    static QList<UAVObjectField::DescriptorPtr> createFieldDescriptors();
 
 };
 
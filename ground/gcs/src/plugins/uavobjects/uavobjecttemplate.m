@@ -22,14 +22,8 @@ outputType='mat'; %Default output is a .mat file
 checkCRC = false;
 wrongSyncByte=0;
 wrongMessageByte=0;
-lastWrongSyncByte=0;
-lastWrongMessageByte=0;
-str1=[]; %#ok<NASGU>
-str2=[];
-str3=[];
-str4=[];
-str5=[];
 multipleInstanceLookup = zeros(0,2);
+uavoNumBytes = zeros(0,1);
 overo = false;
 
 fprintf('\n\n***dRonin log parser***\n\n');
@@ -96,194 +90,161 @@ end
 
 
 buffer=fread(fid,Inf,'uchar=>uchar');
-
-
-bufferIdx=1;
+buffer_len = length(buffer);
 
 correctMsgByte=hex2dec('20');
 correctSyncByte=hex2dec('3C');
-unknownObjIDList=zeros(1,2);
-
-% Parse log file, entry by entry
-% prebuf = buffer(1:12);
-
-last_print = -1e10;
 
 startTime=clock;
 
-if overo
-    instanceIdOffset = -2;
-    timestampWraparound = 2^16;
+if ~overo
+	% For GCS logging the format is as follows
+	% 4 bytes timestamp (milliseconds)
+	% 8 bytes data size
+	% UAVTalk packet (always without timestamped packets)
+	%     Sync val (0x3c)
+	%     Message type (1 byte)
+	%     Length (2 bytes)
+	%     Object ID (4 bytes)
+	%     Instance ID (optional, 2 bytes)
+	%     Data (variable length)
+	%     Checksum (1 byte)
+	syncOffset = 12;
+	headerLen = 20;
+	instanceIdOffset = 0;
+	timestampWraparound = 2^32;
 else
-    instanceIdOffset = 0;
-    timestampWraparound = 2^32;
+	% For Overo logging the format is
+	% UAVTalk packet (with timestamped packet)
+	%     Sync val (0x3c)
+	%     Message type (1 byte, adds 0x80)
+	%     Length (2 bytes)
+	%     Object ID (4 bytes)
+	%     Instance ID (optional, 2 bytes)
+	%     Timestamp (2 bytes)
+	%     Data (variable length)
+	%     Checksum (1 byte)
+	syncOffset = 0;
+	headerLen = 10;
+	instanceIdOffset = -2;
+	timestampWraparound = 2^16;
 end
 
-timestampAccumulator = 0;
-lastTimestamp = 0;
-
-buffer_len = length(buffer);
-
-while bufferIdx < (buffer_len - 20)
-	%% Read message header
-	% get sync field (0x3C, 1 byte)
-	if ~overo
-		sync = buffer(bufferIdx+12);
-	else
-		sync = buffer(bufferIdx);
-	end
-
-	if sync ~= correctSyncByte
-		bufferIdx=bufferIdx+1;
-		if ~overo || sync ~= 255
-			wrongSyncByte = wrongSyncByte + 1;
-		end
-		continue
-	end
-
-	if ~overo
-		% For GCS logging the format is as follows
-		% 4 bytes timestamp (milliseconds)
-		% 8 bytes data size
-		% UAVTalk packet (always without timestamped packets)
-		%     Sync val (0x3c)
-		%     Message type (1 byte)
-		%     Length (2 bytes)
-		%     Object ID (4 bytes)
-		%     Instance ID (optional, 2 bytes)
-		%     Data (variable length)
-		%     Checksum (1 byte)
-
-		% Process header, if we are aligned
-		datasizeBufferIdx = bufferIdx; %Just grab the index. We'll do a typecast later, if necessary
-		datasizeLength = 4;
-		msgType = buffer(bufferIdx+13); % get msg type (quint8 1 byte ) should be 0x20, ignore the rest?
-		objID = typecast(buffer(bufferIdx+16:bufferIdx+ 16+4-1), 'uint32'); % get obj id (quint32 4 bytes)
-		timestamp = double(typecast(buffer(bufferIdx:bufferIdx+4-1),'uint32'));
-
-		% Advance buffer past header to where data is (or instance ID)
-		bufferIdx=bufferIdx + 20;
-	else
-		% For Overo logging the format is
-		% UAVTalk packet (with timestamped packet)
-		%     Sync val (0x3c)
-		%     Message type (1 byte, adds 0x80)
-		%     Length (2 bytes)
-		%     Object ID (4 bytes)
-		%     Instance ID (optional, 2 bytes)
-		%     Timestamp (2 bytes)
-		%     Data (variable length)
-		%     Checksum (1 byte)
-
-		% Process header for overo
-		datasizeBufferIdx = bufferIdx + 2;
-		datasizeLength = 2;
-		msgType = buffer(bufferIdx+1) - 128;
-		objID = typecast(buffer(bufferIdx+4:bufferIdx+ 4+4-1), 'uint32');
-
-		singleInstance = multipleInstanceLookup(multipleInstanceLookup(:,1) == objID, 2);
-		if singleInstance
-			timestamp = double(typecast(buffer(bufferIdx+8:bufferIdx+10-1),'uint16'));
-		else
-			timestamp = double(typecast(buffer(bufferIdx+12:bufferIdx+14-1),'uint16'));
-		end
+%% Find the packets
+% Rather than stepping through the log a packet at a time, every sync byte
+% is taken as a possible packet start, and all of their headers are decoded
+% at once.
+starts = find(buffer(1+syncOffset:end) == correctSyncByte);
+starts = starts(starts < buffer_len - 20);
+numStarts = length(starts);
 
-		% Advance buffer past header to where data is.  In the case of a
-		% multiple instance object this will be where the timstamp is but
-		% the parsing code will advance by two more.
-		bufferIdx = bufferIdx + 10;
-
-    end
+msgType = double(buffer(starts + syncOffset + 1));
+if overo
+	msgType = msgType - 128;
+end
 
-	if timestamp < lastTimestamp
-		timestampAccumulator = timestampAccumulator + timestampWraparound;
-	end
-	lastTimestamp = timestamp;
-	timestamp = timestamp + timestampAccumulator;
+objID = gatherValues(buffer, starts + syncOffset + 4, 'uint32', 1)';
+[known, objIdx] = ismember(objID, multipleInstanceLookup(:,1));
 
-	%Check that message type is correct
-	if msgType ~= correctMsgByte
-		wrongMessageByte = wrongMessageByte + 1;
-		continue
-	end
+singleInstance = true(numStarts, 1);
+singleInstance(known) = multipleInstanceLookup(objIdx(known), 2);
 
-	if (isempty(objID))	%End of file
-		break;
-	end
+% Where each packet would end.  Known objects are stepped over by their
+% size, unknown ones by the data size in the log, and anything that isn't
+% an object packet just by its header.
+packetLen = headerLen + 2*~singleInstance + 1;
+packetLen(known) = packetLen(known) + uavoNumBytes(objIdx(known));
 
-	%% Read object
-	try
-	switch objID
-$(SWITCHCODE)
-		otherwise
-			unknownObjIDListIdx=find(unknownObjIDList(:,1)==objID, 1, 'first');
-			if isempty(unknownObjIDListIdx)
-				unknownObjIDList=[unknownObjIDList; uint32(objID) 1]; %#ok<AGROW>
-			else
-				unknownObjIDList(unknownObjIDListIdx,2)=unknownObjIDList(unknownObjIDListIdx,2)+1;
-			end
-
-			datasize = typecast(buffer(datasizeBufferIdx + 4:datasizeBufferIdx + 12-1), 'uint64');
-
-			msgBytesLeft = datasize - 1 - 1 - 2 - 4;
-			if msgBytesLeft > 255
-				msgBytesLeft = 0;
-			end
-			bufferIdx=bufferIdx+double(msgBytesLeft);
-	end
-	catch
-		% One of the reads failed - indicates EOF
-		break;
-	end
+if ~overo
+	datasize = gatherValues(buffer, starts(~known) + 4, 'uint64', 1)';
 
-	if (wrongSyncByte ~= lastWrongSyncByte || wrongMessageByte~=lastWrongMessageByte ) ||...
-			bufferIdx - last_print > 5e4 %Every 50,000 bytes show the status update
+	msgBytesLeft = datasize - 1 - 1 - 2 - 4;
+	msgBytesLeft(msgBytesLeft > 255 | msgBytesLeft < 0) = 0;
+	packetLen(~known) = headerLen + msgBytesLeft;
+else
+	packetLen(~known) = headerLen;
+end
 
-		lastWrongSyncByte=wrongSyncByte;
-		lastWrongMessageByte=wrongMessageByte;
+packetLen(msgType ~= correctMsgByte) = headerLen;
 
-		str1=[];
-		for i=1:length([str2 str3 str4 str5]);
-			str1=[str1 sprintf('\b')]; %#ok<AGROW>
-		end
-		str2=sprintf('wrongSyncByte instances:    % 10d\n', wrongSyncByte );
-		str3=sprintf('wrongMessageByte instances: % 10d\n\n', wrongMessageByte );
+% Of those, the real packets are the ones reached by going from the first to
+% where it ends, and on from there; after a bad packet, to the next sync
+% byte.  jump(i) is the start that follows start i.  Squaring it each pass
+% doubles how far it reaches, so the whole chain is found in log2(packets)
+% passes.
+[~, jump] = histc(starts + packetLen - 0.5, [0; starts; Inf]);
+jump(numStarts+1) = numStarts+1;
 
-		str4=sprintf('Completed bytes: % 9d of % 9d\n', bufferIdx, buffer_len);
+onChain = 1;
+while jump(1) <= numStarts
+	onChain = unique([onChain; jump(onChain)]);
+	jump = jump(jump);
+end
+onChain = onChain(onChain <= numStarts);
+
+% The last packet may have been cut off
+onChain = onChain(starts(onChain) + packetLen(onChain) - 1 <= buffer_len);
+
+starts = starts(onChain);
+packetLen = packetLen(onChain);
+msgType = msgType(onChain);
+objID = objID(onChain);
+known = known(onChain);
+objIdx = objIdx(onChain);
+singleInstance = singleInstance(onChain);
+
+% Bytes between the packets are what was skipped looking for sync
+gapStart = [1; starts(1:end-1) + packetLen(1:end-1)];
+if ~overo
+	wrongSyncByte = sum(starts - gapStart);
+else
+	% Overo logs are padded with 0xff, which doesn't count
+	padding = [0; cumsum(uint32(buffer == 255))];
+	wrongSyncByte = sum(starts - gapStart) - ...
+		double(sum(padding(starts) - padding(gapStart)));
+end
+wrongMessageByte = sum(msgType ~= correctMsgByte);
 
-		% Arbitrary times two so that it is at least as long
-		estTimeRemaining=(buffer_len-bufferIdx)/(bufferIdx/etime(clock,startTime)) * 2;
-		h=floor(estTimeRemaining/3600);
-		m=floor((estTimeRemaining-h*3600)/60);
-		s=ceil(estTimeRemaining-h*3600-m*60);
+if ~overo
+	timestamp = gatherValues(buffer, starts, 'uint32', 1)';
+else
+	timestamp = gatherValues(buffer, starts + 8 + 2*~singleInstance, 'uint16', 1)';
+end
+timestamp(2:end) = timestamp(2:end) + ...
+	timestampWraparound * cumsum(diff(timestamp) < 0);
 
-		str5=sprintf('Est. time remaining, %02dh:%02dm:%02ds \n', h,m,s);
+fprintf('wrongSyncByte instances:    % 10d\n', wrongSyncByte);
+fprintf('wrongMessageByte instances: % 10d\n\n', wrongMessageByte);
 
-		last_print = bufferIdx;
+isUnknown = msgType == correctMsgByte & ~known;
+if any(isUnknown)
+	[unknownObjIDs, ~, unknownIdx] = unique(objID(isUnknown));
+	unknownCounts = accumarray(unknownIdx(:), 1);
 
-		fprintf([str1 str2 str3 str4 str5]);
+	for i=1:length(unknownObjIDs)
+	   disp(['Unknown object ID: 0x' dec2hex(unknownObjIDs(i),8) ' appeared ' int2str(unknownCounts(i)) ' times.']);
 	end
+end
 
-	%Check if at end of file. If not, load next prebuffer
-	if bufferIdx+12-1 > buffer_len
-		break;
-	end
-%	bufferIdx=bufferIdx+12;
+%% Group the packets by object
+% Sorting is stable, so each object's packets stay in log order
+isObject = msgType == correctMsgByte & known;
 
-end
+[packetObj, order] = sort(objIdx(isObject));
+packetFidIdx = starts(isObject) + headerLen;
+packetFidIdx = packetFidIdx(order);
+packetTimestamp = timestamp(isObject);
+packetTimestamp = packetTimestamp(order);
 
+packetCount = accumarray(packetObj(:), 1, [size(multipleInstanceLookup,1) 1]);
+groupEnd = cumsum(packetCount);
+groupStart = groupEnd - packetCount + 1;
 
-for i=2:size(unknownObjIDList,1) %Don't show the first one, as it was simply a dummy placeholder
-   disp(['Unknown object ID: 0x' dec2hex(unknownObjIDList(i,1),8) ' appeared ' int2str(unknownObjIDList(i,2)) ' times.']);
-end
+$(GROUPCODE)
 
 %% Clean Up and Save mat file
 fclose(fid);
 
-%% Prune vectors
-$(CLEANUPCODE)
-
-
 %% Perform typecasting on vectors
 $(ALLOCATIONCODE)
 
@@ -336,28 +297,11 @@ function crc = compute_crc(data)
         crc = crc_table(1+bitxor(data(i),crc));
     end
 
-function out=mcolon(inStart, inFinish)
-%% This function was inspired by Bruno Luong's 'mcolon'. The name is kept the same as his 'mcolon'
-% function, found on Matlab's file exchange. The two functions return identical
-% results, although his is much faster. Unfortunately, C-compiled mex
-% code would make this function non-cross-platform, so a Matlab scripted
-% version is provided here.
-	if size(inStart,1) > 1 || size(inFinish,1) > 1
-		if size(inStart,2) > 1 || size(inFinish,2) > 1
-			error('Inputs must be vectors, i.e just one column wide.')
-		else
-			inStart=inStart';
-			inFinish=inFinish';
-		end
-	end
+function out = gatherValues(buffer, offsets, type, numElements)
+% Typecasts numElements values of the given type, starting at each offset in
+% the buffer, into one column per offset
+	len = numElements * length(typecast(zeros(1, 1, type), 'uint8'));
 
-	diffIn=diff([inStart; inFinish]);
-	numElements=sum(diffIn)+length(inStart);
+	idx = bsxfun(@plus, offsets(:)', (0:len-1)');
 
-	out=zeros(1,numElements);
-
-	idx=1;
-	for i=1:length(inStart)
-		out(idx:idx+diffIn(i))=inStart(i):inFinish(i);
-		idx=idx+diffIn(i)+1;
-	end
+	out = reshape(double(typecast(buffer(idx(:)), type)), numElements, length(offsets));
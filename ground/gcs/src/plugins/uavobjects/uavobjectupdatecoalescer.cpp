@@ -0,0 +1,143 @@
+/**
+ ******************************************************************************
+ *
+ * @file       uavobjectupdatecoalescer.cpp
+ *
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2017
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup UAVObjectsPlugin UAVObjects Plugin
+ * @{
+ * @brief      Batches object updates into one change notification per tick
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ * Additional note on redistribution: The copyright and license notices above
+ * must be maintained in each individual source file that is a derivative work
+ * of this source file; otherwise redistribution is prohibited.
+ */
+
+#include "uavobjectupdatecoalescer.h"
+#include "uavobjectfield.h"
+
+#include <string.h>
+
+/**
+ * Constructor
+ * \param[in] intervalMs Tick, the shortest time between notifications for one object
+ */
+UAVObjectUpdateCoalescer::UAVObjectUpdateCoalescer(int intervalMs, QObject *parent)
+    : QObject(parent)
+{
+    timer.setSingleShot(true);
+    timer.setInterval(intervalMs);
+
+    connect(&timer, &QTimer::timeout, this, &UAVObjectUpdateCoalescer::deliverUpdates);
+}
+
+/**
+ * Start passing on the updates of an object
+ */
+void UAVObjectUpdateCoalescer::watch(UAVObject *obj)
+{
+    connect(obj, &UAVObject::objectUpdated, this, &UAVObjectUpdateCoalescer::queueUpdate,
+            Qt::UniqueConnection);
+}
+
+/**
+ * Stop passing on the updates of an object, dropping any that are queued
+ */
+void UAVObjectUpdateCoalescer::unwatch(UAVObject *obj)
+{
+    disconnect(obj, &UAVObject::objectUpdated, this, &UAVObjectUpdateCoalescer::queueUpdate);
+
+    if (pending.remove(obj))
+        order.removeAll(QPointer<UAVObject>(obj));
+
+    delivered.remove(obj);
+}
+
+void UAVObjectUpdateCoalescer::queueUpdate(UAVObject *obj)
+{
+    if (pending.contains(obj))
+        return;
+
+    pending.insert(obj);
+    order.append(obj);
+
+    if (!timer.isActive())
+        timer.start();
+}
+
+void UAVObjectUpdateCoalescer::deliverUpdates()
+{
+    // Updates that arrive while these are handled wait for the next round
+    QList<QPointer<UAVObject>> updated;
+    updated.swap(order);
+    pending.clear();
+
+    foreach (const QPointer<UAVObject> &obj, updated) {
+        if (!obj)
+            continue;
+
+        emit objectChanged(obj.data(), changedFields(obj.data()));
+    }
+}
+
+/**
+ * Works out which fields of an object changed since its last notification,
+ * and remembers its data for next time.  The first time an object is seen,
+ * every field counts as changed.
+ */
+quint64 UAVObjectUpdateCoalescer::changedFields(UAVObject *obj)
+{
+    QByteArray data(static_cast<int>(obj->getNumBytes()), 0);
+    obj->pack(reinterpret_cast<quint8 *>(data.data()));
+
+    QHash<UAVObject *, QByteArray>::iterator last = delivered.find(obj);
+
+    if (last == delivered.end() || last->size() != data.size()) {
+        delivered.insert(obj, data);
+        return ~0ULL;
+    }
+
+    quint64 changed = 0;
+    int offset = 0;
+    int bit = 0;
+
+    // Fields are packed in order, so each one's bytes follow the last
+    foreach (UAVObjectField *field, obj->getFields()) {
+        int len = static_cast<int>(field->getNumBytes());
+
+        if (memcmp(last->constData() + offset, data.constData() + offset, len))
+            changed |= 1ULL << bit;
+
+        offset += len;
+
+        if (bit < LAST_FIELD_BIT)
+            bit++;
+    }
+
+    *last = data;
+
+    return changed;
+}
+
+/**
+ * @}
+ * @}
+ */
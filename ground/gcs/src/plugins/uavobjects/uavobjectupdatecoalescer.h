@@ -0,0 +1,92 @@
+/**
+ ******************************************************************************
+ *
+ * @file       uavobjectupdatecoalescer.h
+ *
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2017
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup UAVObjectsPlugin UAVObjects Plugin
+ * @{
+ * @brief      Batches object updates into one change notification per tick
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ * Additional note on redistribution: The copyright and license notices above
+ * must be maintained in each individual source file that is a derivative work
+ * of this source file; otherwise redistribution is prohibited.
+ */
+
+#ifndef UAVOBJECTUPDATECOALESCER_H
+#define UAVOBJECTUPDATECOALESCER_H
+
+#include "uavobjects/uavobjects_global.h"
+#include "uavobjects/uavobject.h"
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QPointer>
+#include <QSet>
+#include <QTimer>
+
+/**
+ * Stands between watched objects and things that only need to show their
+ * latest values.  However quickly an object is updated, objectChanged is
+ * emitted for it at most once per tick, from the event loop, with the
+ * object's newest data and a mask of the fields that differ from what the
+ * last notification carried (0 if it was updated with the same values, bit
+ * n for the nth field, with the rest sharing the last bit).  Anything that needs every update (logging,
+ * plotting) should keep connecting to UAVObject::objectUpdated instead.
+ */
+class UAVOBJECTS_EXPORT UAVObjectUpdateCoalescer : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit UAVObjectUpdateCoalescer(int intervalMs = 33, QObject *parent = nullptr);
+
+    void watch(UAVObject *obj);
+    void unwatch(UAVObject *obj);
+    void setInterval(int intervalMs) { timer.setInterval(intervalMs); }
+
+    //! Bit given to fields past the end of the mask
+    static const int LAST_FIELD_BIT = 63;
+
+signals:
+    void objectChanged(UAVObject *obj, quint64 changedFields);
+
+private slots:
+    void queueUpdate(UAVObject *obj);
+    void deliverUpdates();
+
+private:
+    QTimer timer;
+    QSet<UAVObject *> pending;
+    QList<QPointer<UAVObject>> order;
+    // The data each object had when it was last notified
+    QHash<UAVObject *, QByteArray> delivered;
+
+    quint64 changedFields(UAVObject *obj);
+};
+
+#endif // UAVOBJECTUPDATECOALESCER_H
+
+/**
+ * @}
+ * @}
+ */
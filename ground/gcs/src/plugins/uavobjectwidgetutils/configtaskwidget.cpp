@@ -43,6 +43,7 @@
 
 #include <QWidget>
 #include <QLineEdit>
+#include <QShowEvent>
 
 /**
  * Constructor
@@ -70,6 +71,13 @@ ConfigTaskWidget::ConfigTaskWidget(QWidget *parent)
     UAVSettingsImportExportManager *importexportplugin =
         pm->getObject<UAVSettingsImportExportManager>();
     connect(importexportplugin, SIGNAL(importAboutToBegin()), this, SLOT(invalidateObjects()));
+
+    refreshTimer.setSingleShot(true);
+    refreshTimer.setInterval(0);
+    connect(&refreshTimer, &QTimer::timeout, this, [this]() {
+        if (isVisible())
+            flushWidgetsRefresh();
+    });
 }
 
 /**
@@ -156,7 +164,7 @@ void ConfigTaskWidget::addUAVObjectToWidgetRelation(QString object, QString fiel
         objectUpdates.insert(obj, true);
         connect(obj, SIGNAL(objectUpdated(UAVObject *)), this, SLOT(objectUpdated(UAVObject *)));
         connect(obj, SIGNAL(objectUpdated(UAVObject *)), this,
-                SLOT(refreshWidgetsValues(UAVObject *)), Qt::UniqueConnection);
+                SLOT(queueWidgetsRefresh(UAVObject *)), Qt::UniqueConnection);
         UAVDataObject *dobj = dynamic_cast<UAVDataObject *>(obj);
         if (dobj) {
             connect(dobj, SIGNAL(presentOnHardwareChanged(UAVDataObject *)), this,
@@ -198,6 +206,8 @@ void ConfigTaskWidget::addUAVObjectToWidgetRelation(QString object, QString fiel
         }
     } else {
         connectWidgetUpdatesToSlot(widget, SLOT(widgetsContentsChanged()));
+        connect(widget, &QObject::destroyed, this,
+                [this, widget]() { limitCheckCache.remove(widget); });
         if (defaultReloadGroups)
             addWidgetToDefaultReloadGroups(widget, defaultReloadGroups);
         shadowsList.insert(widget, ow);
@@ -333,6 +343,7 @@ void ConfigTaskWidget::onAutopilotConnect()
 
     invalidateObjects();
     isConnected = true;
+    limitCheckCache.clear();
     loadAllLimits();
     enableControls(true);
     refreshWidgetsValues();
@@ -383,6 +394,33 @@ void ConfigTaskWidget::refreshWidgetsValues(UAVObject *obj)
     setDirty(dirtyBack);
 }
 
+/**
+ * Notes an object update, to be shown in the widgets once the event loop is
+ * idle.  Telemetry sends many updates between frames; each object is
+ * refreshed once for all of them, and not at all while the page is hidden.
+ */
+void ConfigTaskWidget::queueWidgetsRefresh(UAVObject *obj)
+{
+    pendingRefresh.insert(obj);
+    if (!refreshTimer.isActive())
+        refreshTimer.start();
+}
+
+void ConfigTaskWidget::flushWidgetsRefresh()
+{
+    QSet<UAVObject *> objs;
+    objs.swap(pendingRefresh);
+    foreach (UAVObject *obj, objs)
+        refreshWidgetsValues(obj);
+}
+
+void ConfigTaskWidget::showEvent(QShowEvent *event)
+{
+    QWidget::showEvent(event);
+    if (!pendingRefresh.isEmpty())
+        flushWidgetsRefresh();
+}
+
 /**
  * SLOT function used to update the uavobject fields from widgets with relation to
  * object field added to the framework pool
@@ -390,6 +428,10 @@ void ConfigTaskWidget::refreshWidgetsValues(UAVObject *obj)
  */
 void ConfigTaskWidget::updateObjectsFromWidgets()
 {
+    // Don't write back values from before updates the widgets haven't shown
+    if (!pendingRefresh.isEmpty())
+        flushWidgetsRefresh();
+
     emit updateObjectsFromWidgetsRequested();
     for (const auto ow : objOfInterest) {
         if (ow->object && ow->field && !ow->oneWayBind)
@@ -570,8 +612,9 @@ void ConfigTaskWidget::disableObjUpdates()
     foreach (objectToWidget *obj, objOfInterest) {
         if (obj->object)
             disconnect(obj->object, SIGNAL(objectUpdated(UAVObject *)), this,
-                       SLOT(refreshWidgetsValues(UAVObject *)));
+                       SLOT(queueWidgetsRefresh(UAVObject *)));
     }
+    pendingRefresh.clear();
 }
 /**
  * SLOT function used to enable widget contents changes when related object field changes
@@ -582,7 +625,7 @@ void ConfigTaskWidget::enableObjUpdates()
     foreach (objectToWidget *obj, objOfInterest) {
         if (obj->object)
             connect(obj->object, SIGNAL(objectUpdated(UAVObject *)), this,
-                    SLOT(refreshWidgetsValues(UAVObject *)), Qt::UniqueConnection);
+                    SLOT(queueWidgetsRefresh(UAVObject *)), Qt::UniqueConnection);
     }
 }
 /**
@@ -1329,6 +1372,14 @@ void ConfigTaskWidget::checkWidgetsLimits(QWidget *widget, UAVObjectField *field
 {
     if (!hasLimits)
         return;
+
+    // Telemetry mostly repeats the value already shown, and the widget is
+    // already styled for it
+    QHash<QWidget *, QVariant>::const_iterator cached = limitCheckCache.constFind(widget);
+    if (cached != limitCheckCache.constEnd() && cached.value() == value)
+        return;
+    limitCheckCache.insert(widget, value);
+
     if (!field->isWithinLimits(value, index, currentBoard)) {
         if (!widget->property("styleBackup").isValid())
             widget->setProperty("styleBackup", widget->styleSheet());
@@ -31,7 +31,10 @@
 #include <uavobjectwidgetutils/uavobjectwidgetutils_global.h>
 #include <extensionsystem/pluginmanager.h>
 
+#include <QHash>
 #include <QQueue>
+#include <QSet>
+#include <QTimer>
 #include <QWidget>
 #include <QList>
 #include <QLabel>
@@ -213,6 +216,7 @@ private slots:
     void rebootButtonClicked();
     void connectionsButtonClicked();
     void doRefreshHiddenObjects(UAVDataObject *);
+    void queueWidgetsRefresh(UAVObject *obj);
 
 private:
     int currentBoard;
@@ -231,6 +235,13 @@ private:
     QList<QPushButton *> rebootButtonList;
     QList<QPushButton *> connectionsButtonList;
     bool dirty;
+    //! Objects updated since the widgets were last refreshed
+    QSet<UAVObject *> pendingRefresh;
+    //! Runs once the event loop is idle, so a burst of updates costs one refresh
+    QTimer refreshTimer;
+    //! Last value checked against the limits, per widget, for currentBoard
+    QHash<QWidget *, QVariant> limitCheckCache;
+    void flushWidgetsRefresh();
     bool setFieldFromWidget(QWidget *widget, UAVObjectField *field, int index, double scale,
                             bool usesUnits = false);
     /**
@@ -299,6 +310,7 @@ protected slots:
     virtual void helpButtonPressed();
 
 protected:
+    void showEvent(QShowEvent *event);
     virtual void enableControls(bool enable);
     void checkWidgetsLimits(QWidget *widget, UAVObjectField *field, int index, bool hasLimits,
                             bool useUnits, QVariant value, double scale);
@@ -26,10 +26,6 @@
  * with this program; if not, see <http://www.gnu.org/licenses/>
  */
 
-// for XML object
-#include <QDomDocument>
-#include <QXmlQuery>
-
 #include <QMessageBox>
 
 // for Parameterized slots
@@ -101,9 +97,10 @@ void ImportSummaryDialog::openHelp()
 
 /*
   Adds a new line about a UAVObject along with its status
-  (whether it got saved OK or not)
+  (whether it got saved OK or not).  Lines that can be saved start
+  out selected unless checked is false.
   */
-void ImportSummaryDialog::addLine(QString uavObjectName, QString text, bool status)
+void ImportSummaryDialog::addLine(QString uavObjectName, QString text, bool status, bool checked)
 {
     ui->importSummaryList->setRowCount(ui->importSummaryList->rowCount() + 1);
     int row = ui->importSummaryList->rowCount() - 1;
@@ -118,7 +115,7 @@ void ImportSummaryDialog::addLine(QString uavObjectName, QString text, bool stat
     ui->importSummaryList->item(row, 2)->setFlags(Qt::NoItemFlags);
 
     if (status) {
-        box->setChecked(true);
+        box->setChecked(checked);
     } else {
         box->setChecked(false);
         box->setEnabled(false);
@@ -166,8 +163,11 @@ void ImportSummaryDialog::doTheApplySaving()
         }
     }
 
-    if (itemCount == 0)
+    if (itemCount == 0) {
+        // Everything selected was already on the board
+        accept();
         return;
+    }
 
     ui->btnSaveToFlash->setEnabled(false);
     ui->closeButton->setEnabled(false);
@@ -1,7 +1,6 @@
 TEMPLATE = lib
 QT += xml
 QT += widgets
-QT += xmlpatterns
 TARGET = UAVSettingsImportExport
 DEFINES += UAVSETTINGSIMPORTEXPORT_LIBRARY
 
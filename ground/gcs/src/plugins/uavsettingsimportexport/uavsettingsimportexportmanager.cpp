@@ -52,10 +52,13 @@
 #include "uavobjectutil/uavobjectutilmanager.h"
 
 // for XML object
-#include <QDomDocument>
-#include <QXmlQuery>
+#include <QXmlStreamReader>
+#include <QXmlStreamWriter>
+
+#include <algorithm>
 
 // for file dialog and error messages
+#include <QFile>
 #include <QFileDialog>
 #include <QMessageBox>
 
@@ -110,12 +113,27 @@ void UAVSettingsImportExportManager::extensionsInitialized()
 
 bool UAVSettingsImportExportManager::importUAVSettings(const QByteArray &settings, bool quiet)
 {
-    QDomDocument doc("UAVObjects");
+    QXmlStreamReader xml(settings);
+
+    // find the root of settings subtree; either the document element or
+    // right under <uavobjects>
+    bool foundSettings = false;
+    while (!foundSettings && xml.readNextStartElement()) {
+        if (xml.name() == "settings")
+            foundSettings = true;
+        else if (xml.name() != "uavobjects")
+            xml.skipCurrentElement();
+    }
 
-    if (!doc.setContent(settings)) {
+    if (!foundSettings) {
         QMessageBox msgBox(dynamic_cast<QWidget *>(Core::ICore::instance()->mainWindow()));
-        msgBox.setText(tr("File Parsing Failed."));
-        msgBox.setInformativeText(tr("This file is not a correct XML file"));
+        if (xml.hasError()) {
+            msgBox.setText(tr("File Parsing Failed."));
+            msgBox.setInformativeText(tr("This file is not a correct XML file"));
+        } else {
+            msgBox.setText(tr("Wrong file contents"));
+            msgBox.setInformativeText(tr("This file does not contain correct UAVSettings"));
+        }
         msgBox.setStandardButtons(QMessageBox::Ok);
         msgBox.exec();
         return false;
@@ -123,20 +141,6 @@ bool UAVSettingsImportExportManager::importUAVSettings(const QByteArray &setting
     emit importAboutToBegin();
     qDebug() << "Import about to begin";
 
-    // find the root of settings subtree
-    QDomElement root = doc.documentElement();
-    if (root.tagName() == "uavobjects") {
-        root = root.firstChildElement("settings");
-    }
-    if (root.isNull() || (root.tagName() != "settings")) {
-        QMessageBox msgBox(dynamic_cast<QWidget *>(Core::ICore::instance()->mainWindow()));
-        msgBox.setText(tr("Wrong file contents"));
-        msgBox.setInformativeText(tr("This file does not contain correct UAVSettings"));
-        msgBox.setStandardButtons(QMessageBox::Ok);
-        msgBox.exec();
-        return false;
-    }
-
     // We are now ok: setup the import summary dialog & update it as we
     // go along.
     ImportSummaryDialog swui(dynamic_cast<QWidget *>(Core::ICore::instance()->mainWindow()), quiet);
@@ -147,87 +151,106 @@ bool UAVSettingsImportExportManager::importUAVSettings(const QByteArray &setting
 
     swui.show();
 
-    QDomNode node = root.firstChild();
-    while (!node.isNull()) {
-        QDomElement e = node.toElement();
-        if (e.tagName() == "object") {
-
-            //  - Read each object
-            QString uavObjectName = e.attribute("name");
-            uint uavObjectID = e.attribute("id").toUInt(NULL, 16);
-
-            // Sanity Check:
-            UAVObject *obj = boardObjManager->getObject(uavObjectName);
-            UAVDataObject *dobj = dynamic_cast<UAVDataObject *>(obj);
-            if (obj == NULL) {
-                // This object is unknown!
-                qDebug() << "Object unknown:" << uavObjectName << uavObjectID;
-                swui.addLine(uavObjectName, "Error (Object unknown)", false);
-            } else if (dobj && !dobj->getIsPresentOnHardware()) {
-                swui.addLine(uavObjectName, "Error (Object not present on hw)", false);
-            } else {
-                //  - Update each field
-                //  - Issue and "updated" command
-                UAVDataObject *newObj = dobj->clone();
-
-                bool error = false;
-                bool setError = false;
-                QDomNode field = node.firstChild();
-                while (!field.isNull()) {
-                    QDomElement f = field.toElement();
-                    if (f.tagName() == "field") {
-                        UAVObjectField *uavfield = newObj->getField(f.attribute("name"));
-                        if (uavfield) {
-                            QStringList list = f.attribute("values").split(",");
-                            if (list.length() == 1) {
-                                if (false == uavfield->checkValue(f.attribute("values"))) {
-                                    qDebug() << "checkValue returned false on: " << uavObjectName
-                                             << f.attribute("values");
-                                    setError = true;
-                                } else {
-                                    uavfield->setValue(f.attribute("values"));
-                                }
+    while (xml.readNextStartElement()) {
+        if (xml.name() != "object") {
+            xml.skipCurrentElement();
+            continue;
+        }
+
+        //  - Read each object
+        QString uavObjectName = xml.attributes().value("name").toString();
+        uint uavObjectID = xml.attributes().value("id").toString().toUInt(NULL, 16);
+
+        // Sanity Check:
+        UAVObject *obj = boardObjManager->getObject(uavObjectName);
+        UAVDataObject *dobj = dynamic_cast<UAVDataObject *>(obj);
+        if (obj == NULL) {
+            // This object is unknown!
+            qDebug() << "Object unknown:" << uavObjectName << uavObjectID;
+            swui.addLine(uavObjectName, "Error (Object unknown)", false);
+            xml.skipCurrentElement();
+            continue;
+        } else if (dobj && !dobj->getIsPresentOnHardware()) {
+            swui.addLine(uavObjectName, "Error (Object not present on hw)", false);
+            xml.skipCurrentElement();
+            continue;
+        }
+
+        //  - Update each field
+        //  - Issue and "updated" command
+        UAVDataObject *newObj = dobj->clone();
+
+        bool error = false;
+        bool setError = false;
+        while (xml.readNextStartElement()) {
+            if (xml.name() == "field") {
+                QString values = xml.attributes().value("values").toString();
+                UAVObjectField *uavfield =
+                    newObj->getField(xml.attributes().value("name").toString());
+                if (uavfield) {
+                    QStringList list = values.split(",");
+                    if (list.length() == 1) {
+                        if (false == uavfield->checkValue(values)) {
+                            qDebug() << "checkValue returned false on: " << uavObjectName
+                                     << values;
+                            setError = true;
+                        } else {
+                            uavfield->setValue(values);
+                        }
+                    } else {
+                        // This is an enum:
+                        int i = 0;
+                        foreach (QString element, list) {
+                            if (false == uavfield->checkValue(element, i)) {
+                                qDebug() << "checkValue(list) returned false on: "
+                                         << uavObjectName << list;
+                                setError = true;
                             } else {
-                                // This is an enum:
-                                int i = 0;
-                                QStringList list = f.attribute("values").split(",");
-                                foreach (QString element, list) {
-                                    if (false == uavfield->checkValue(element, i)) {
-                                        qDebug() << "checkValue(list) returned false on: "
-                                                 << uavObjectName << list;
-                                        setError = true;
-                                    } else {
-                                        uavfield->setValue(element, i);
-                                    }
-                                    i++;
-                                }
+                                uavfield->setValue(element, i);
                             }
-                        } else {
-                            error = true;
+                            i++;
                         }
                     }
-                    field = field.nextSibling();
-                }
-                newObj->updated();
-
-                if (error) {
-                    swui.addLine(uavObjectName, "Warning (Object field unknown)", true);
-                } else if (uavObjectID != newObj->getObjID()) {
-                    qDebug() << "Mismatch for Object " << uavObjectName << uavObjectID << " - "
-                             << newObj->getObjID();
-                    swui.addLine(uavObjectName, "Warning (ObjectID mismatch)", true);
-                } else if (setError) {
-                    swui.addLine(uavObjectName, "Warning (Objects field value(s) invalid)", false);
                 } else {
-                    swui.addLine(uavObjectName, "OK", true);
+                    error = true;
                 }
-                importedObjectManager->registerObject(newObj);
             }
+            xml.skipCurrentElement();
+        }
+        newObj->updated();
+
+        // Objects the board already holds verbatim needn't be sent or saved
+        bool unchanged = sameData(newObj, dobj);
+
+        if (error) {
+            swui.addLine(uavObjectName, "Warning (Object field unknown)", true, !unchanged);
+        } else if (uavObjectID != newObj->getObjID()) {
+            qDebug() << "Mismatch for Object " << uavObjectName << uavObjectID << " - "
+                     << newObj->getObjID();
+            swui.addLine(uavObjectName, "Warning (ObjectID mismatch)", true, !unchanged);
+        } else if (setError) {
+            swui.addLine(uavObjectName, "Warning (Objects field value(s) invalid)", false);
+        } else if (unchanged) {
+            swui.addLine(uavObjectName, "OK (unchanged)", true, false);
+        } else {
+            swui.addLine(uavObjectName, "OK", true);
         }
-        node = node.nextSibling();
+        importedObjectManager->registerObject(newObj);
     }
     qDebug() << "End import";
 
+    if (xml.hasError()) {
+        qDebug() << "Import failed:" << xml.errorString() << "at line" << xml.lineNumber();
+        delete importedObjectManager;
+        swui.hide();
+        QMessageBox msgBox(dynamic_cast<QWidget *>(Core::ICore::instance()->mainWindow()));
+        msgBox.setText(tr("File Parsing Failed."));
+        msgBox.setInformativeText(tr("This file is not a correct XML file"));
+        msgBox.setStandardButtons(QMessageBox::Ok);
+        msgBox.exec();
+        return false;
+    }
+
     if (swui.numLines() < 1) {
         QMessageBox::critical(dynamic_cast<QWidget *>(Core::ICore::instance()->mainWindow()),
                               tr("Unable to import settings"),
@@ -244,6 +267,22 @@ bool UAVSettingsImportExportManager::importUAVSettings(const QByteArray &setting
     return swui.result() == QDialog::Accepted;
 }
 
+/**
+ * @brief Whether two instances of an object hold the same data
+ */
+bool UAVSettingsImportExportManager::sameData(UAVObject *a, UAVObject *b)
+{
+    if (a->getNumBytes() != b->getNumBytes())
+        return false;
+
+    QByteArray dataA(a->getNumBytes(), 0);
+    QByteArray dataB(b->getNumBytes(), 0);
+    a->pack(reinterpret_cast<quint8 *>(dataA.data()));
+    b->pack(reinterpret_cast<quint8 *>(dataB.data()));
+
+    return dataA == dataB;
+}
+
 // Slot called by the menu manager on user action
 void UAVSettingsImportExportManager::importUAVSettings()
 {
@@ -259,7 +298,6 @@ void UAVSettingsImportExportManager::importUAVSettings()
 
     // Now open the file
     QFile file(fileName);
-    QDomDocument doc("UAVObjects");
     file.open(QFile::ReadOnly | QFile::Text);
 
     importUAVSettings(file.readAll());
@@ -267,6 +305,43 @@ void UAVSettingsImportExportManager::importUAVSettings()
     file.close();
 }
 
+// Writes one object, with its attributes in alphabetical order, which is
+// how they have always been laid out so that *.uav files diff cleanly
+static void writeObject(QXmlStreamWriter &xml, UAVDataObject *obj, bool fullExport)
+{
+    xml.writeStartElement("object");
+    xml.writeAttribute("id", QString("0x") + QString().setNum(obj->getObjID(), 16).toUpper());
+    xml.writeAttribute("name", obj->getName());
+    if (fullExport)
+        xml.writeTextElement("description",
+                             obj->getDescription().remove("@Ref ", Qt::CaseInsensitive));
+
+    // iterate over fields
+    foreach (UAVObjectField *field, obj->getFields()) {
+        // iterate over values
+        QString vals;
+        quint32 nelem = field->getNumElements();
+        for (unsigned int n = 0; n < nelem; ++n) {
+            vals.append(QString("%1,").arg(field->getValue(n).toString()));
+        }
+        vals.chop(1);
+
+        xml.writeEmptyElement("field");
+        if (fullExport)
+            xml.writeAttribute("elements", QString::number(nelem));
+        xml.writeAttribute("name", field->getName());
+        if (fullExport) {
+            if (field->getType() == UAVObjectField::ENUM)
+                xml.writeAttribute("options", field->getOptions().join(","));
+            xml.writeAttribute("type", field->getTypeAsString());
+            xml.writeAttribute("units", field->getUnits());
+        }
+        xml.writeAttribute("values", vals);
+    }
+
+    xml.writeEndElement();
+}
+
 // Create an XML document from UAVObject database
 QString UAVSettingsImportExportManager::createXMLDocument(const enum storedData what,
                                                           const bool fullExport)
@@ -275,189 +350,83 @@ QString UAVSettingsImportExportManager::createXMLDocument(const enum storedData
     ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
     UAVObjectManager *objManager = pm->getObject<UAVObjectManager>();
 
-    // create an XML root
-    QDomDocument doc("UAVObjects");
-    QDomElement root = doc.createElement("uavobjects");
-    doc.appendChild(root);
+    // Written straight out as we go, rather than built up as a DOM and then
+    // sorted with XSLT, which took longer than fetching the settings did
+    QString out;
+    QXmlStreamWriter xml(&out);
+    xml.setAutoFormatting(true);
+    xml.setAutoFormattingIndent(4);
+    xml.writeStartDocument();
+    xml.writeStartElement("uavobjects");
 
     // add hardware, firmware and GCS version info
-    QDomElement versionInfo = doc.createElement("version");
-    root.appendChild(versionInfo);
+    xml.writeStartElement("version");
 
     UAVObjectUtilManager *utilMngr = pm->getObject<UAVObjectUtilManager>();
     deviceDescriptorStruct board;
     utilMngr->getBoardDescriptionStruct(board);
 
-    QDomElement hw = doc.createElement("hardware");
-    hw.setAttribute("type", QString().setNum(board.boardType, 16));
-    hw.setAttribute("revision", QString().setNum(board.boardRevision, 16));
-    hw.setAttribute("serial", QString(utilMngr->getBoardCPUSerial().toHex()));
-    versionInfo.appendChild(hw);
+    xml.writeEmptyElement("hardware");
+    xml.writeAttribute("revision", QString().setNum(board.boardRevision, 16));
+    xml.writeAttribute("serial", QString(utilMngr->getBoardCPUSerial().toHex()));
+    xml.writeAttribute("type", QString().setNum(board.boardType, 16));
 
-    QDomElement fw = doc.createElement("firmware");
-    fw.setAttribute("date", board.gitDate);
-    fw.setAttribute("hash", board.gitHash);
-    fw.setAttribute("tag", board.gitTag);
-    versionInfo.appendChild(fw);
+    xml.writeEmptyElement("firmware");
+    xml.writeAttribute("date", board.gitDate);
+    xml.writeAttribute("hash", board.gitHash);
+    xml.writeAttribute("tag", board.gitTag);
 
     QString gcsRevision = QString::fromLatin1(Core::Constants::GCS_REVISION_STR);
     QString gcsGitDate = gcsRevision.mid(gcsRevision.indexOf(" ") + 1, 14);
     QString gcsGitHash = gcsRevision.mid(gcsRevision.indexOf(":") + 1, 8);
     QString gcsGitTag = gcsRevision.left(gcsRevision.indexOf(":"));
 
-    QDomElement gcs = doc.createElement("gcs");
-    gcs.setAttribute("date", gcsGitDate);
-    gcs.setAttribute("hash", gcsGitHash);
-    gcs.setAttribute("tag", gcsGitTag);
-    versionInfo.appendChild(gcs);
-
-    // create settings and/or data elements
-    QDomElement settings = doc.createElement("settings");
-    QDomElement data = doc.createElement("data");
-
-    switch (what) {
-    case Settings:
-        root.appendChild(settings);
-        break;
-    case Data:
-        root.appendChild(data);
-        break;
-    case Both:
-        root.appendChild(data);
-        root.appendChild(settings);
-        break;
-    }
+    xml.writeEmptyElement("gcs");
+    xml.writeAttribute("date", gcsGitDate);
+    xml.writeAttribute("hash", gcsGitHash);
+    xml.writeAttribute("tag", gcsGitTag);
 
-    // iterate over settings objects
+    xml.writeEndElement();
+
+    // sort settings and data objects apart
+    QList<UAVDataObject *> settingsObjs;
+    QList<UAVDataObject *> dataObjs;
     QVector<QVector<UAVDataObject *>> objList = objManager->getDataObjectsVector();
     foreach (QVector<UAVDataObject *> list, objList) {
         foreach (UAVDataObject *obj, list) {
             if (!obj->getIsPresentOnHardware())
                 continue;
-            if (((what == Settings) && obj->isSettings()) || ((what == Data) && !obj->isSettings())
-                || (what == Both)) {
-
-                // add each object to the XML
-                QDomElement o = doc.createElement("object");
-                o.setAttribute("name", obj->getName());
-                o.setAttribute("id",
-                               QString("0x") + QString().setNum(obj->getObjID(), 16).toUpper());
-                if (fullExport) {
-                    QDomElement d = doc.createElement("description");
-                    QDomText t = doc.createTextNode(
-                        obj->getDescription().remove("@Ref ", Qt::CaseInsensitive));
-                    d.appendChild(t);
-                    o.appendChild(d);
-                }
-
-                // iterate over fields
-                QList<UAVObjectField *> fieldList = obj->getFields();
-
-                foreach (UAVObjectField *field, fieldList) {
-                    QDomElement f = doc.createElement("field");
+            if (obj->isSettings())
+                settingsObjs.append(obj);
+            else
+                dataObjs.append(obj);
+        }
+    }
 
-                    // iterate over values
-                    QString vals;
-                    quint32 nelem = field->getNumElements();
-                    for (unsigned int n = 0; n < nelem; ++n) {
-                        vals.append(QString("%1,").arg(field->getValue(n).toString()));
-                    }
-                    vals.chop(1);
-
-                    f.setAttribute("name", field->getName());
-                    f.setAttribute("values", vals);
-                    if (fullExport) {
-                        f.setAttribute("type", field->getTypeAsString());
-                        f.setAttribute("units", field->getUnits());
-                        f.setAttribute("elements", nelem);
-                        if (field->getType() == UAVObjectField::ENUM) {
-                            f.setAttribute("options", field->getOptions().join(","));
-                        }
-                    }
-                    o.appendChild(f);
-                }
+    // Settings go in alphabetical order, which is particularly helpful when
+    // comparing *.uav files to each other
+    std::stable_sort(settingsObjs.begin(), settingsObjs.end(),
+                     [](UAVDataObject *a, UAVDataObject *b) {
+                         return a->getName() < b->getName();
+                     });
+
+    if (what == Data || what == Both) {
+        xml.writeStartElement("data");
+        foreach (UAVDataObject *obj, dataObjs)
+            writeObject(xml, obj, fullExport);
+        xml.writeEndElement();
+    }
 
-                // append to the settings or data element
-                if (obj->isSettings())
-                    settings.appendChild(o);
-                else
-                    data.appendChild(o);
-            }
-        }
+    if (what == Settings || what == Both) {
+        xml.writeStartElement("settings");
+        foreach (UAVDataObject *obj, settingsObjs)
+            writeObject(xml, obj, fullExport);
+        xml.writeEndElement();
     }
 
-    // This sorts the XML <object> children's <name=".."> attribute by alphabetical order,
-    // as well as sorting all attributes by alphabetical order (see note below for
-    // special circumstances around sorting attributes. This is particularly helpful when
-    // comparing *.uav files to each other.
-    QString preliminaryXMLDoc = doc.toString(4);
-    QString alphabetizedAttributesXMLDoc;
-    QString alphabetizedXMLDoc;
-
-    // (New C++11 "raw string literal" string format.)
-    // This sorts all attributes by alphabetical order. This is *not* guaranteed to
-    // work. In fact, it is guaranteed *not* to work in all conditions. See
-    // http://stackoverflow.com/questions/1429991/using-xsl-to-sort-attributes.
-    // However, it seems to work so far and there's no expectation it will change
-    // in Qt's near future.
-    QString xmlAttributeSorter = R"(
-        <xsl:stylesheet version="2.0" xmlns:xsl="http://www.w3.org/1999/XSL/Transform">
-          <xsl:output method="xml" encoding="UTF-8" indent="yes"/>
-          <xsl:template match="*">
-            <xsl:copy>
-              <xsl:apply-templates select="@*">
-                <xsl:sort select="name() "/>
-              </xsl:apply-templates>
-              <xsl:apply-templates/>
-            </xsl:copy>
-          </xsl:template>
-          <xsl:template match="@*|comment()|processing-instruction() ">
-            <xsl:copy />
-          </xsl:template>
-        </xsl:stylesheet>
-    )";
-
-    // (New C++11 "raw string literal" string format.)
-    // This XSLT template sorts all children by alphabetical order. This is guaranteed
-    // to work (unlike the attribute sorting).
-    QString xmlAlpheticalSorter = R"(
-        <xsl:stylesheet version="2.0" xmlns:xsl="http://www.w3.org/1999/XSL/Transform">
-          <xsl:output method="xml" indent="yes" omit-xml-declaration="no"/>
-          <xsl:strip-space elements="*"/>
-
-          <xsl:template match="@* | node() ">
-            <xsl:copy>
-              <xsl:apply-templates select="@* | node() "/>
-            </xsl:copy>
-          </xsl:template>
-
-          <xsl:template match="settings">
-            <xsl:copy>
-              <xsl:apply-templates select="@*" />
-              <xsl:apply-templates select="object">
-                <xsl:sort select="@name" data-type="text"/>
-
-              </xsl:apply-templates>
-            </xsl:copy>
-          </xsl:template>
-
-        </xsl:stylesheet>
-    )";
-
-    // Generate query and set to XSLT v2.0
-    QXmlQuery query(QXmlQuery::XSLT20);
-
-    // First sort attributes...
-    query.setFocus(preliminaryXMLDoc);
-    query.setQuery(xmlAttributeSorter);
-    query.evaluateTo(&alphabetizedAttributesXMLDoc);
-
-    // Then sort children.
-    query.setFocus(alphabetizedAttributesXMLDoc);
-    query.setQuery(xmlAlpheticalSorter);
-    query.evaluateTo(&alphabetizedXMLDoc);
-
-    return alphabetizedXMLDoc;
+    xml.writeEndDocument();
+
+    return out;
 }
 
 // Slot called by the menu manager on user action
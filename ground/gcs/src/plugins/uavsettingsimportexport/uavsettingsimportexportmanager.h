@@ -33,7 +33,6 @@
 #include "uavsettingsimportexport_global.h"
 #include <QObject>
 
-class QDomNode;
 class UAVObject;
 
 class UAVSETTINGSIMPORTEXPORT_EXPORT UAVSettingsImportExportManager : public QObject
@@ -44,7 +43,6 @@ public:
     UAVSettingsImportExportManager(QObject *parent = nullptr);
     ~UAVSettingsImportExportManager();
 
-    static bool updateObject(UAVObject *obj, QDomNode *node);
     bool importUAVSettings(const QByteArray &settings, bool quiet = false);
     void extensionsInitialized();
 
@@ -59,6 +57,7 @@ private Q_SLOTS:
 private:
     enum storedData { Settings, Data, Both };
     QString createXMLDocument(const enum storedData, const bool fullExport);
+    static bool sameData(UAVObject *a, UAVObject *b);
 
 signals:
     void importAboutToBegin();
@@ -0,0 +1,232 @@
+/**
+ ******************************************************************************
+ * @file       aes128.cpp
+ *
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2017
+ *
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup UAVTalkPlugin UAVTalk Plugin
+ * @{
+ * @brief AES-128 encryption, with the counter and CMAC modes built on it
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ * Additional note on redistribution: The copyright and license notices above
+ * must be maintained in each individual source file that is a derivative work
+ * of this source file; otherwise redistribution is prohibited.
+ */
+
+#include "aes128.h"
+
+#include <string.h>
+
+static const quint8 sbox[256] = {
+    0x63, 0x7c, 0x77, 0x7b, 0xf2, 0x6b, 0x6f, 0xc5, 0x30, 0x01, 0x67, 0x2b, 0xfe, 0xd7, 0xab, 0x76,
+    0xca, 0x82, 0xc9, 0x7d, 0xfa, 0x59, 0x47, 0xf0, 0xad, 0xd4, 0xa2, 0xaf, 0x9c, 0xa4, 0x72, 0xc0,
+    0xb7, 0xfd, 0x93, 0x26, 0x36, 0x3f, 0xf7, 0xcc, 0x34, 0xa5, 0xe5, 0xf1, 0x71, 0xd8, 0x31, 0x15,
+    0x04, 0xc7, 0x23, 0xc3, 0x18, 0x96, 0x05, 0x9a, 0x07, 0x12, 0x80, 0xe2, 0xeb, 0x27, 0xb2, 0x75,
+    0x09, 0x83, 0x2c, 0x1a, 0x1b, 0x6e, 0x5a, 0xa0, 0x52, 0x3b, 0xd6, 0xb3, 0x29, 0xe3, 0x2f, 0x84,
+    0x53, 0xd1, 0x00, 0xed, 0x20, 0xfc, 0xb1, 0x5b, 0x6a, 0xcb, 0xbe, 0x39, 0x4a, 0x4c, 0x58, 0xcf,
+    0xd0, 0xef, 0xaa, 0xfb, 0x43, 0x4d, 0x33, 0x85, 0x45, 0xf9, 0x02, 0x7f, 0x50, 0x3c, 0x9f, 0xa8,
+    0x51, 0xa3, 0x40, 0x8f, 0x92, 0x9d, 0x38, 0xf5, 0xbc, 0xb6, 0xda, 0x21, 0x10, 0xff, 0xf3, 0xd2,
+    0xcd, 0x0c, 0x13, 0xec, 0x5f, 0x97, 0x44, 0x17, 0xc4, 0xa7, 0x7e, 0x3d, 0x64, 0x5d, 0x19, 0x73,
+    0x60, 0x81, 0x4f, 0xdc, 0x22, 0x2a, 0x90, 0x88, 0x46, 0xee, 0xb8, 0x14, 0xde, 0x5e, 0x0b, 0xdb,
+    0xe0, 0x32, 0x3a, 0x0a, 0x49, 0x06, 0x24, 0x5c, 0xc2, 0xd3, 0xac, 0x62, 0x91, 0x95, 0xe4, 0x79,
+    0xe7, 0xc8, 0x37, 0x6d, 0x8d, 0xd5, 0x4e, 0xa9, 0x6c, 0x56, 0xf4, 0xea, 0x65, 0x7a, 0xae, 0x08,
+    0xba, 0x78, 0x25, 0x2e, 0x1c, 0xa6, 0xb4, 0xc6, 0xe8, 0xdd, 0x74, 0x1f, 0x4b, 0xbd, 0x8b, 0x8a,
+    0x70, 0x3e, 0xb5, 0x66, 0x48, 0x03, 0xf6, 0x0e, 0x61, 0x35, 0x57, 0xb9, 0x86, 0xc1, 0x1d, 0x9e,
+    0xe1, 0xf8, 0x98, 0x11, 0x69, 0xd9, 0x8e, 0x94, 0x9b, 0x1e, 0x87, 0xe9, 0xce, 0x55, 0x28, 0xdf,
+    0x8c, 0xa1, 0x89, 0x0d, 0xbf, 0xe6, 0x42, 0x68, 0x41, 0x99, 0x2d, 0x0f, 0xb0, 0x54, 0xbb, 0x16,
+};
+
+static const quint8 rcon[10] = { 0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x1b, 0x36 };
+
+//! Multiply by x in the field, for the column mix
+static quint8 xtime(quint8 b)
+{
+    return static_cast<quint8>((b << 1) ^ ((b & 0x80) ? 0x1b : 0));
+}
+
+//! Multiply by x in the CMAC subkey field
+static void dbl(const quint8 *in, quint8 *out)
+{
+    bool carry = in[0] & 0x80;
+
+    for (int i = 0; i < Aes128::BLOCK_SIZE - 1; i++)
+        out[i] = static_cast<quint8>((in[i] << 1) | (in[i + 1] >> 7));
+
+    out[Aes128::BLOCK_SIZE - 1] = static_cast<quint8>(in[Aes128::BLOCK_SIZE - 1] << 1);
+
+    if (carry)
+        out[Aes128::BLOCK_SIZE - 1] ^= 0x87;
+}
+
+Aes128::Aes128()
+{
+    memset(roundKeys, 0, sizeof(roundKeys));
+    memset(k1, 0, sizeof(k1));
+    memset(k2, 0, sizeof(k2));
+}
+
+/**
+ * Expand a key for use with the other functions
+ * @param key KEY_SIZE bytes of key
+ */
+void Aes128::setKey(const quint8 *key)
+{
+    memcpy(roundKeys, key, KEY_SIZE);
+
+    for (int i = 4; i < 4 * (ROUNDS + 1); i++) {
+        quint8 word[4];
+        memcpy(word, &roundKeys[4 * (i - 1)], 4);
+
+        if (i % 4 == 0) {
+            quint8 first = word[0];
+            word[0] = sbox[word[1]] ^ rcon[i / 4 - 1];
+            word[1] = sbox[word[2]];
+            word[2] = sbox[word[3]];
+            word[3] = sbox[first];
+        }
+
+        for (int j = 0; j < 4; j++)
+            roundKeys[4 * i + j] = roundKeys[4 * (i - 4) + j] ^ word[j];
+    }
+
+    quint8 l[BLOCK_SIZE] = { 0 };
+
+    encryptBlock(l, l);
+    dbl(l, k1);
+    dbl(k1, k2);
+}
+
+/**
+ * Encrypt one block
+ * @param in the block to encrypt
+ * @param out where to put it encrypted; may be the same as in
+ */
+void Aes128::encryptBlock(const quint8 *in, quint8 *out) const
+{
+    quint8 s[BLOCK_SIZE];
+
+    for (int i = 0; i < BLOCK_SIZE; i++)
+        s[i] = in[i] ^ roundKeys[i];
+
+    for (int round = 1; round <= ROUNDS; round++) {
+        quint8 t[BLOCK_SIZE];
+
+        // Byte substitution and row shift together; the state is by column
+        for (int i = 0; i < BLOCK_SIZE; i++)
+            t[i] = sbox[s[(i + 4 * (i % 4)) % BLOCK_SIZE]];
+
+        // The last round has no column mix
+        if (round < ROUNDS) {
+            for (int c = 0; c < 4; c++) {
+                quint8 *col = &t[4 * c];
+                quint8 all = col[0] ^ col[1] ^ col[2] ^ col[3];
+                quint8 first = col[0];
+
+                col[0] ^= all ^ xtime(col[0] ^ col[1]);
+                col[1] ^= all ^ xtime(col[1] ^ col[2]);
+                col[2] ^= all ^ xtime(col[2] ^ col[3]);
+                col[3] ^= all ^ xtime(col[3] ^ first);
+            }
+        }
+
+        for (int i = 0; i < BLOCK_SIZE; i++)
+            s[i] = t[i] ^ roundKeys[round * BLOCK_SIZE + i];
+    }
+
+    memcpy(out, s, BLOCK_SIZE);
+}
+
+/**
+ * Encrypt or decrypt in counter mode.  The last four bytes of the counter
+ * block are a big endian count, incremented for each block.
+ * @param iv the first counter block
+ * @param data the data, replaced with the result
+ * @param length length of data
+ */
+void Aes128::ctr(const quint8 *iv, quint8 *data, int length) const
+{
+    quint8 counter[BLOCK_SIZE];
+    quint8 stream[BLOCK_SIZE];
+
+    memcpy(counter, iv, BLOCK_SIZE);
+
+    quint32 count = (static_cast<quint32>(counter[12]) << 24) | (counter[13] << 16)
+        | (counter[14] << 8) | counter[15];
+
+    while (length > 0) {
+        counter[12] = static_cast<quint8>(count >> 24);
+        counter[13] = static_cast<quint8>(count >> 16);
+        counter[14] = static_cast<quint8>(count >> 8);
+        counter[15] = static_cast<quint8>(count);
+        count++;
+
+        encryptBlock(counter, stream);
+
+        int n = qMin(length, static_cast<int>(BLOCK_SIZE));
+
+        for (int i = 0; i < n; i++)
+            data[i] ^= stream[i];
+
+        data += n;
+        length -= n;
+    }
+}
+
+/**
+ * Compute the CMAC of a message
+ * @param data the message
+ * @param length length of the message
+ * @param mac BLOCK_SIZE bytes of MAC, which may be truncated
+ */
+void Aes128::cmac(const quint8 *data, int length, quint8 *mac) const
+{
+    quint8 x[BLOCK_SIZE] = { 0 };
+
+    // Every block but the last goes through as it is
+    while (length > BLOCK_SIZE) {
+        for (int i = 0; i < BLOCK_SIZE; i++)
+            x[i] ^= data[i];
+
+        encryptBlock(x, x);
+
+        data += BLOCK_SIZE;
+        length -= BLOCK_SIZE;
+    }
+
+    // The last is mixed with K1 if it is whole, else padded and K2
+    const quint8 *k = k1;
+
+    if (length < BLOCK_SIZE) {
+        k = k2;
+        x[length] ^= 0x80;
+    }
+
+    for (int i = 0; i < length; i++)
+        x[i] ^= data[i];
+
+    for (int i = 0; i < BLOCK_SIZE; i++)
+        x[i] ^= k[i];
+
+    encryptBlock(x, mac);
+}
+
+/**
+ * @}
+ * @}
+ */
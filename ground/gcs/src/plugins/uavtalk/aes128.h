@@ -0,0 +1,70 @@
+/**
+ ******************************************************************************
+ * @file       aes128.h
+ *
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2017
+ *
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup UAVTalkPlugin UAVTalk Plugin
+ * @{
+ * @brief AES-128 encryption, with the counter and CMAC modes built on it
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ * Additional note on redistribution: The copyright and license notices above
+ * must be maintained in each individual source file that is a derivative work
+ * of this source file; otherwise redistribution is prohibited.
+ */
+
+#ifndef AES128_H
+#define AES128_H
+
+#include <QtGlobal>
+
+/**
+ * The same cipher and modes as flight/Libraries/aes128.c, for secured
+ * UAVTalk frames.  Only the forward cipher is needed: counter mode decrypts
+ * by encrypting again, and CMAC (RFC 4493) only ever encrypts.
+ */
+class Aes128
+{
+public:
+    static const int BLOCK_SIZE = 16;
+    static const int KEY_SIZE = 16;
+
+    Aes128();
+
+    void setKey(const quint8 *key);
+    void encryptBlock(const quint8 *in, quint8 *out) const;
+    void ctr(const quint8 *iv, quint8 *data, int length) const;
+    void cmac(const quint8 *data, int length, quint8 *mac) const;
+
+private:
+    static const int ROUNDS = 10;
+
+    //! One round key after another
+    quint8 roundKeys[(ROUNDS + 1) * BLOCK_SIZE];
+    //! CMAC subkeys
+    quint8 k1[BLOCK_SIZE];
+    quint8 k2[BLOCK_SIZE];
+};
+
+#endif // AES128_H
+
+/**
+ * @}
+ * @}
+ */
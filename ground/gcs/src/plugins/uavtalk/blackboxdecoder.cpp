@@ -0,0 +1,244 @@
+/**
+ ******************************************************************************
+ * @file       blackboxdecoder.cpp
+ *
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2017
+ *
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup UAVTalkPlugin UAVTalk Plugin
+ * @{
+ * @brief Decodes the control loop frames of the Blackbox logging profile
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ * Additional note on redistribution: The copyright and license notices above
+ * must be maintained in each individual source file that is a derivative work
+ * of this source file; otherwise redistribution is prohibited.
+ */
+
+#include "blackboxdecoder.h"
+
+#include "actuatorcommand.h"
+#include "actuatordesired.h"
+#include "gyros.h"
+#include "ratedesired.h"
+
+// Must match the scaling in flight/Libraries/inc/blackbox.h
+static const float GYRO_SCALE = 16.0f;
+static const float RATE_SCALE = 16.0f;
+static const float DESIRED_SCALE = 10000.0f;
+static const float OUTPUT_SCALE = 1.0f;
+
+static bool readVarint(const quint8 *&data, const quint8 *end, quint32 &value)
+{
+    value = 0;
+
+    for (int shift = 0; data < end && shift < 35; shift += 7) {
+        quint8 b = *(data++);
+
+        value |= static_cast<quint32>(b & 0x7f) << shift;
+
+        if (!(b & 0x80))
+            return true;
+    }
+
+    return false;
+}
+
+static qint32 unzigzag(quint32 value)
+{
+    return static_cast<qint32>(value >> 1) ^ -static_cast<qint32>(value & 1);
+}
+
+BlackboxDecoder::BlackboxDecoder(UAVObjectManager *objMngr)
+    : objMngr(objMngr)
+    , synced(false)
+    , seqValid(false)
+    , lastSeq(0)
+{
+}
+
+void BlackboxDecoder::loseSync()
+{
+    synced = false;
+    partial.clear();
+}
+
+/**
+ * Takes the frames from one chunk, and unpacks every frame it completes.
+ * \param seq Chunk sequence number
+ * \param first Offset of the first frame starting in this chunk
+ * \param numFields Number of fields in each frame
+ * \param frames Frame bytes
+ * \param length Number of frame bytes
+ * \return Success (true), Failure (false) if the chunk couldn't be followed
+ */
+bool BlackboxDecoder::receiveChunk(quint16 seq, quint8 first, quint8 numFields,
+                                   const quint8 *frames, quint32 length)
+{
+    if (seqValid && seq != static_cast<quint16>(lastSeq + 1)) {
+        loseSync();
+    }
+
+    seqValid = true;
+    lastSeq = seq;
+
+    if (numFields < NUM_FIELDS) {
+        loseSync();
+        return false;
+    }
+
+    if (first == NO_FRAME_START) {
+        if (!partial.isEmpty())
+            partial.append(reinterpret_cast<const char *>(frames), static_cast<int>(length));
+
+        return true;
+    }
+
+    if (first > length) {
+        loseSync();
+        return false;
+    }
+
+    bool ok = true;
+
+    if (!partial.isEmpty() || first > 0) {
+        QByteArray data = partial;
+        data.append(reinterpret_cast<const char *>(frames), first);
+        partial.clear();
+
+        ok = decodeFrames(reinterpret_cast<const quint8 *>(data.constData()),
+                          static_cast<quint32>(data.size()), numFields, false);
+    }
+
+    return decodeFrames(frames + first, length - first, numFields, true) && ok;
+}
+
+bool BlackboxDecoder::decodeFrames(const quint8 *data, quint32 length, quint8 numFields,
+                                   bool partialOk)
+{
+    quint32 pos = 0;
+
+    while (pos < length) {
+        quint8 tag = data[pos];
+        quint32 end = pos + 1 + (tag & FRAME_LEN_MASK);
+
+        if (end > length) {
+            if (partialOk) {
+                partial = QByteArray(reinterpret_cast<const char *>(data + pos),
+                                     static_cast<int>(length - pos));
+                return true;
+            }
+
+            loseSync();
+            return false;
+        }
+
+        if (!decodeFrame(data + pos + 1, end - pos - 1, numFields, tag & FRAME_KEYFRAME)) {
+            loseSync();
+            return false;
+        }
+
+        pos = end;
+    }
+
+    return true;
+}
+
+bool BlackboxDecoder::decodeFrame(const quint8 *data, quint32 length, quint8 numFields,
+                                  bool keyframe)
+{
+    if (!keyframe && !synced)
+        return true;
+
+    const quint8 *end = data + length;
+    quint32 time;
+
+    // Replay is paced by the log's own timestamps; frame times go unused.
+    if (!readVarint(data, end, time))
+        return false;
+
+    if (keyframe)
+        values.fill(0, numFields);
+    else if (values.size() != numFields)
+        return false;
+
+    for (int i = 0; i < numFields; i++) {
+        quint32 coded;
+
+        if (!readVarint(data, end, coded))
+            return false;
+
+        values[i] += unzigzag(coded);
+    }
+
+    synced = true;
+
+    publish();
+
+    return true;
+}
+
+void BlackboxDecoder::publish()
+{
+    int pos = 0;
+
+    Gyros *gyros = Gyros::GetInstance(objMngr);
+    if (gyros) {
+        Gyros::DataFields data = gyros->getData();
+        data.x = values[pos] / GYRO_SCALE;
+        data.y = values[pos + 1] / GYRO_SCALE;
+        data.z = values[pos + 2] / GYRO_SCALE;
+        gyros->unpack(reinterpret_cast<const quint8 *>(&data));
+    }
+    pos += NUM_AXES;
+
+    RateDesired *rateDesired = RateDesired::GetInstance(objMngr);
+    if (rateDesired) {
+        RateDesired::DataFields data = rateDesired->getData();
+        data.Roll = values[pos] / RATE_SCALE;
+        data.Pitch = values[pos + 1] / RATE_SCALE;
+        data.Yaw = values[pos + 2] / RATE_SCALE;
+        rateDesired->unpack(reinterpret_cast<const quint8 *>(&data));
+    }
+    pos += NUM_AXES;
+
+    ActuatorDesired *actuatorDesired = ActuatorDesired::GetInstance(objMngr);
+    if (actuatorDesired) {
+        ActuatorDesired::DataFields data = actuatorDesired->getData();
+        data.Roll = values[pos] / DESIRED_SCALE;
+        data.Pitch = values[pos + 1] / DESIRED_SCALE;
+        data.Yaw = values[pos + 2] / DESIRED_SCALE;
+        data.Thrust = values[pos + 3] / DESIRED_SCALE;
+        actuatorDesired->unpack(reinterpret_cast<const quint8 *>(&data));
+    }
+    pos += NUM_DESIRED;
+
+    ActuatorCommand *actuatorCommand = ActuatorCommand::GetInstance(objMngr);
+    if (actuatorCommand) {
+        ActuatorCommand::DataFields data = actuatorCommand->getData();
+        for (int i = 0; i < NUM_OUTPUTS && i < static_cast<int>(ActuatorCommand::CHANNEL_NUMELEM);
+             i++) {
+            data.Channel[i] = values[pos + i] / OUTPUT_SCALE;
+        }
+        actuatorCommand->unpack(reinterpret_cast<const quint8 *>(&data));
+    }
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,80 @@
+/**
+ ******************************************************************************
+ * @file       blackboxdecoder.h
+ *
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2017
+ *
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup UAVTalkPlugin UAVTalk Plugin
+ * @{
+ * @brief Decodes the control loop frames of the Blackbox logging profile
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ * Additional note on redistribution: The copyright and license notices above
+ * must be maintained in each individual source file that is a derivative work
+ * of this source file; otherwise redistribution is prohibited.
+ */
+
+#ifndef BLACKBOXDECODER_H
+#define BLACKBOXDECODER_H
+
+#include <QtCore>
+#include "uavobjects/uavobjectmanager.h"
+
+/**
+ * Follows the frames in blackbox chunks (see flight/Libraries/inc/blackbox.h
+ * for the format) and unpacks each one into Gyros, RateDesired,
+ * ActuatorDesired and ActuatorCommand, as though those had been logged.
+ */
+class BlackboxDecoder
+{
+public:
+    explicit BlackboxDecoder(UAVObjectManager *objMngr);
+
+    bool receiveChunk(quint16 seq, quint8 first, quint8 numFields, const quint8 *frames,
+                      quint32 length);
+
+private:
+    static const quint8 FRAME_KEYFRAME = 0x80;
+    static const quint8 FRAME_LEN_MASK = 0x7f;
+    static const quint8 NO_FRAME_START = 0xff;
+
+    static const int NUM_AXES = 3;
+    static const int NUM_DESIRED = 4;
+    static const int NUM_OUTPUTS = 10;
+    static const int NUM_FIELDS = 2 * NUM_AXES + NUM_DESIRED + NUM_OUTPUTS;
+
+    UAVObjectManager *objMngr;
+
+    bool synced;
+    bool seqValid;
+    quint16 lastSeq;
+    QByteArray partial;
+    QVector<qint32> values;
+
+    void loseSync();
+    bool decodeFrames(const quint8 *data, quint32 length, quint8 numFields, bool partialOk);
+    bool decodeFrame(const quint8 *data, quint32 length, quint8 numFields, bool keyframe);
+    void publish();
+};
+
+#endif // BLACKBOXDECODER_H
+
+/**
+ * @}
+ * @}
+ */
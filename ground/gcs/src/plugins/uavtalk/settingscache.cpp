@@ -0,0 +1,113 @@
+/**
+ ******************************************************************************
+ * @file       settingscache.cpp
+ *
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2017
+ *
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup UAVTalkPlugin UAVTalk Plugin
+ * @{
+ * @brief Settings of a board kept from the last time it was connected
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "settingscache.h"
+
+#include <QDataStream>
+#include <QDir>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+// Changes whenever the file layout does
+static const quint32 CACHE_MAGIC = 0x53434331; // "SCC1"
+
+SettingsCache::SettingsCache(const QByteArray &serial, quint64 uavoHash)
+{
+    path = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/settingscache/"
+        + QString::fromLatin1(serial.toHex()) + "-"
+        + QString("%1").arg(uavoHash, 16, 16, QChar('0'));
+}
+
+/**
+ * Read the cache from disk
+ * @return false if there was none, or it couldn't be read
+ */
+bool SettingsCache::load()
+{
+    entries.clear();
+
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    QDataStream stream(&file);
+    quint32 magic;
+
+    stream >> magic;
+    if (magic != CACHE_MAGIC)
+        return false;
+
+    stream >> entries;
+
+    if (stream.status() != QDataStream::Ok) {
+        entries.clear();
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * Write the cache to disk, replacing what was there
+ */
+bool SettingsCache::save() const
+{
+    QDir().mkpath(QFileInfo(path).absolutePath());
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+
+    QDataStream stream(&file);
+
+    stream << CACHE_MAGIC << entries;
+
+    return file.commit();
+}
+
+/**
+ * The CRC the firmware uses in the settings digest (PIOS_CRC32_updateCRC):
+ * polynomial 0x04C11DB7, most significant bit first, nothing reflected or
+ * inverted
+ */
+quint32 SettingsCache::crc32(quint32 crc, const quint8 *data, int len)
+{
+    for (int i = 0; i < len; i++) {
+        crc ^= static_cast<quint32>(data[i]) << 24;
+
+        for (int bit = 0; bit < 8; bit++)
+            crc = (crc & 0x80000000) ? (crc << 1) ^ 0x04C11DB7 : (crc << 1);
+    }
+
+    return crc;
+}
+
+/**
+ * @}
+ * @}
+ */
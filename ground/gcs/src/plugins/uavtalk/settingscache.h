@@ -0,0 +1,65 @@
+/**
+ ******************************************************************************
+ * @file       settingscache.h
+ *
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2017
+ *
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup UAVTalkPlugin UAVTalk Plugin
+ * @{
+ * @brief Settings of a board kept from the last time it was connected
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef SETTINGSCACHE_H
+#define SETTINGSCACHE_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QString>
+
+/**
+ * The packed data of the settings objects and changed metaobjects of one
+ * board, as of the last connection, kept on disk by board serial number and
+ * UAVO hash.  Whether an entry is still good is told by comparing its CRC
+ * with the one in the settings digest the board sends.
+ */
+class SettingsCache
+{
+public:
+    SettingsCache(const QByteArray &serial, quint64 uavoHash);
+
+    bool load();
+    bool save() const;
+
+    QByteArray get(quint32 objId) const { return entries.value(objId); }
+    void insert(quint32 objId, const QByteArray &data) { entries.insert(objId, data); }
+    void clear() { entries.clear(); }
+
+    static quint32 crc32(quint32 crc, const quint8 *data, int len);
+
+private:
+    QString path;
+    QHash<quint32, QByteArray> entries;
+};
+
+#endif // SETTINGSCACHE_H
+
+/**
+ * @}
+ * @}
+ */
@@ -48,7 +48,7 @@
 #endif // TELEMETRY_DEBUG
 
 /**
- * @brief The TransactionKey class A key for the QMap to track transactions
+ * @brief The TransactionKey class A key for the QHash to track transactions
  */
 class TransactionKey
 {
@@ -73,17 +73,16 @@ public:
         return (rhs.objId == objId && rhs.instId == instId && rhs.req == req);
     }
 
-    bool operator<(const TransactionKey &rhs) const
-    {
-        return objId < rhs.objId || (objId == rhs.objId && instId < rhs.instId)
-            || (objId == rhs.objId && instId == rhs.instId && req != rhs.req);
-    }
-
     quint32 objId;
     quint32 instId;
     bool req;
 };
 
+inline uint qHash(const TransactionKey &key, uint seed = 0)
+{
+    return qHash(key.objId, seed) ^ qHash((key.instId << 1) | key.req, seed);
+}
+
 /**
  * Constructor
  */
@@ -103,13 +102,23 @@ Telemetry::Telemetry(UAVTalk *utalk, UAVObjectManager *objMngr)
     // Listen to transaction completions
     connect(utalk, &UAVTalk::ackReceived, this, &Telemetry::transactionSuccess);
     connect(utalk, &UAVTalk::nackReceived, this, &Telemetry::transactionFailure);
+    connect(utalk, &UAVTalk::allSettingsReceived, this, &Telemetry::allSettingsReceived);
+    settingsDigestPending = false;
+    connect(utalk, &UAVTalk::fileDataReceived, this, &Telemetry::settingsDigestData);
     // Get GCS stats object
     gcsStatsObj = GCSTelemetryStats::GetInstance(objMngr);
+    flightStatsObj = FlightTelemetryStats::GetInstance(objMngr);
     // Setup and start the periodic timer
     timeToNextUpdateMs = 0;
     updateTimer = new QTimer(this);
     connect(updateTimer, &QTimer::timeout, this, &Telemetry::processPeriodicUpdates);
     updateTimer->start(1000);
+    // Setup the transaction timeout timer
+    transSerial = 0;
+    transClock.start();
+    transTimer = new QTimer(this);
+    transTimer->setSingleShot(true);
+    connect(transTimer, &QTimer::timeout, this, &Telemetry::checkTransactionTimeouts);
     // Setup and start the stats timer
     txErrors = 0;
     txRetries = 0;
@@ -117,10 +126,8 @@ Telemetry::Telemetry(UAVTalk *utalk, UAVObjectManager *objMngr)
 
 Telemetry::~Telemetry()
 {
-    for (QMap<TransactionKey, ObjectTransactionInfo *>::iterator itr = transMap.begin();
-         itr != transMap.end(); ++itr) {
-        delete itr.value();
-    }
+    qDeleteAll(transMap);
+    qDeleteAll(transPool);
 }
 
 /**
@@ -357,24 +364,92 @@ void Telemetry::transactionRequestCompleted(UAVObject *obj)
 bool Telemetry::updateTransactionMap(UAVObject *obj, bool request)
 {
     TransactionKey key(obj, request);
-    QMap<TransactionKey, ObjectTransactionInfo *>::iterator itr = transMap.find(key);
-    if (itr != transMap.end()) {
-        ObjectTransactionInfo *transInfo = itr.value();
+    ObjectTransactionInfo *transInfo = transMap.take(key);
+    if (transInfo) {
         // Remove this transaction as it is complete.
-        transInfo->timer->stop();
-        transMap.remove(key);
-        delete transInfo;
+        releaseTransaction(transInfo);
         return true;
     }
     return false;
 }
 
+/**
+ * Get a blank transaction, reusing a finished one if there is one
+ */
+ObjectTransactionInfo *Telemetry::allocTransaction()
+{
+    if (transPool.isEmpty())
+        return new ObjectTransactionInfo();
+
+    ObjectTransactionInfo *transInfo = transPool.takeLast();
+    transInfo->reset();
+    return transInfo;
+}
+
+/**
+ * Return a transaction that is no longer in transMap to the pool.  Its
+ * timeout, if armed, is dropped when it comes up.
+ */
+void Telemetry::releaseTransaction(ObjectTransactionInfo *transInfo)
+{
+    transInfo->serial = 0;
+    transPool.append(transInfo);
+}
+
+/**
+ * Start (or restart) the timeout of a transaction
+ */
+void Telemetry::armTransaction(ObjectTransactionInfo *transInfo)
+{
+    // 0 means not armed
+    if (++transSerial == 0)
+        ++transSerial;
+
+    transInfo->serial = transSerial;
+
+    TransactionDeadline deadline;
+    deadline.info = transInfo;
+    deadline.serial = transSerial;
+    deadline.deadline = transClock.elapsed() + REQ_TIMEOUT_MS;
+    transDeadlines.enqueue(deadline);
+
+    if (!transTimer->isActive())
+        transTimer->start(REQ_TIMEOUT_MS);
+}
+
+/**
+ * Times out the transactions whose deadlines have passed, and sets the
+ * timer for the next one
+ */
+void Telemetry::checkTransactionTimeouts()
+{
+    qint64 now = transClock.elapsed();
+
+    while (!transDeadlines.isEmpty()) {
+        const TransactionDeadline &next = transDeadlines.head();
+
+        // Finished or rearmed since
+        if (next.info->serial != next.serial) {
+            transDeadlines.dequeue();
+            continue;
+        }
+
+        if (next.deadline > now) {
+            transTimer->start(static_cast<int>(next.deadline - now));
+            return;
+        }
+
+        ObjectTransactionInfo *transInfo = transDeadlines.dequeue().info;
+        transInfo->serial = 0;
+        transactionTimeout(transInfo);
+    }
+}
+
 /**
  * Called when a transaction is not completed within the timeout period (timer event)
  */
 void Telemetry::transactionTimeout(ObjectTransactionInfo *transInfo)
 {
-    transInfo->timer->stop();
     // Check if more retries are pending
     if (transInfo->retriesRemaining > 0) {
         --transInfo->retriesRemaining;
@@ -393,20 +468,94 @@ void Telemetry::transactionTimeout(ObjectTransactionInfo *transInfo)
                      + QString(QString(" 0x")
                                + QString::number(transInfo->obj->getObjID(), 16).toUpper()))
                 .arg(transInfo->obj->getInstID());
-        transInfo->timer->stop();
         transactionFailure(transInfo->obj);
         ++txErrors;
     }
 }
 
+/**
+ * Ask the board for all of its settings objects in one burst.  They arrive
+ * as ordinary updates, and allSettingsReceived() is emitted at the end, with
+ * false if the board can't do this.
+ */
+void Telemetry::requestAllSettings()
+{
+    utalk->sendAllSettingsRequest();
+}
+
+/**
+ * Ask the board for its settings digest (see UAVTALK_FILEID_SETTINGS_DIGEST
+ * and UAVObjReadSettingsDigest in the firmware).  settingsDigestReceived()
+ * is emitted with it, empty if the board doesn't have one.
+ */
+void Telemetry::requestSettingsDigest()
+{
+    settingsDigest.clear();
+    settingsDigestPending = true;
+
+    utalk->requestFile(SETTINGS_DIGEST_FILEID, 0);
+}
+
+/**
+ * Collects the settings digest as it comes in, asking for more when a
+ * reply ends before the file does
+ */
+void Telemetry::settingsDigestData(quint32 fileId, quint32 offset, quint8 *data, quint32 len,
+                                   bool eof, bool lastInSeq)
+{
+    if (!settingsDigestPending || fileId != SETTINGS_DIGEST_FILEID)
+        return;
+
+    if (offset == static_cast<quint32>(settingsDigest.size()))
+        settingsDigest.append(reinterpret_cast<const char *>(data), static_cast<int>(len));
+
+    if (eof) {
+        settingsDigestPending = false;
+        emit settingsDigestReceived(settingsDigest);
+    } else if (lastInSeq) {
+        utalk->requestFile(SETTINGS_DIGEST_FILEID, static_cast<quint32>(settingsDigest.size()));
+    }
+}
+
+/**
+ * Send an object now, unacked, ahead of everything queued.  This is for
+ * streams that carry their own sequencing and pace themselves, such as GPS
+ * corrections: nothing is tracked in the transaction map, so an update is
+ * never held back behind an earlier one of the same object, or retried.
+ * @return false if there is no connection, or it couldn't be sent
+ */
+bool Telemetry::sendStream(UAVObject *obj)
+{
+    GCSTelemetryStats::DataFields gcsStats = gcsStatsObj->getData();
+    if (gcsStats.Status != GCSTelemetryStats::STATUS_CONNECTED)
+        return false;
+
+    return utalk->sendObject(obj, false, false);
+}
+
 /* This is synchronous, so we use a primitive callback mechanism
  * instead of signal/slot.  Can have a future async variant if
  * necessary
+ *
+ * The next request is kept going while the last one is answered, so the
+ * link doesn't sit idle waiting on round trips.  If a request comes back
+ * short, as it does from older firmware, this falls back to one request
+ * at a time.
  */
 QByteArray *Telemetry::downloadFile(quint32 fileId, quint32 maxSize,
         std::function<void(quint32)>progressCb)
 {
+    // Messages asked for in each request, of up to 100 bytes of file each
+    const quint8 reqCount = 16;
+    const quint32 reqSpan = reqCount * 100;
+
     quint32 curOffset = 0;
+    quint32 nextOffset = 0;
+
+    // Where each outstanding request should leave curOffset
+    QList<quint32> pending;
+    int window = 2;
+    int chunksDone = 0;
 
     QByteArray *result = new QByteArray();
 
@@ -418,7 +567,6 @@ QByteArray *Telemetry::downloadFile(quint32 fileId, quint32 maxSize,
 
     result->reserve(maxSize);
 
-    bool newReqNeeded = false;
     bool completed = false;
     int inactivityCount = 0;
     int failCount = 0;
@@ -438,52 +586,72 @@ QByteArray *Telemetry::downloadFile(quint32 fileId, quint32 maxSize,
                         return;
                     }
 
-                    if (offset != curOffset) {
-                        if (lastInSeq) {
-                            newReqNeeded = true;
-                            loop.exit();
-                        }
+                    // Anything that doesn't carry on from what we have is
+                    // from a request that has been given up on.
+                    if (offset == curOffset && !completed) {
+                        result->append((const char *) data, dataLen);
 
-                        return;
-                    }
+                        curOffset += dataLen;
 
-                    result->append((const char *) data, dataLen);
+                        if (eof) {
+                            completed = true;
+                        }
 
-                    curOffset += dataLen;
+                        inactivityCount = 0;
+                        failCount = 0;
 
-                    if (eof) {
-                        completed = true;
-                        loop.exit();
-                    } else if (lastInSeq) {
-                        newReqNeeded = true;
-                        loop.exit();
+                        if (progressCb) {
+                            progressCb(curOffset);
+                        }
                     }
 
-                    inactivityCount = 0;
-                    failCount = 0;
+                    if (lastInSeq) {
+                        chunksDone++;
+                    }
 
-                    if (progressCb) {
-                        progressCb(curOffset);
+                    if (completed || lastInSeq) {
+                        loop.exit();
                     }
                 }
             );
 
     while (curOffset < maxSize && (!completed)) {
-        utalk->requestFile(fileId, curOffset);
+        while (chunksDone > 0 && !pending.isEmpty()) {
+            chunksDone--;
+
+            if (curOffset < pending.takeFirst()) {
+                window = 1;
+            }
+        }
+
+        chunksDone = 0;
+
+        if (pending.isEmpty()) {
+            nextOffset = curOffset;
+        }
+
+        while (pending.size() < window) {
+            utalk->requestFile(fileId, nextOffset, reqCount, true);
+
+            nextOffset += reqSpan;
+            pending.append(nextOffset);
+        }
 
-        newReqNeeded = false;
         inactivityCount = 0;
 
         do {
             if ((inactivityCount++) > 10) {
                 qDebug() << "Retrying file transfer because of inactivity";
                 failCount++;
+
+                // Start over from what we have
+                pending.clear();
                 break;
             }
 
             loop.exec();
 
-        } while (curOffset < maxSize && (!completed) && (!newReqNeeded));
+        } while (curOffset < maxSize && (!completed) && (chunksDone == 0));
 
         if (failCount > 5) {
             qDebug() << "Aborting file transfer";
@@ -504,16 +672,19 @@ void Telemetry::processObjectTransaction(ObjectTransactionInfo *transInfo)
     // Initiate transaction
     if (transInfo->objRequest) { // We are requesting an object from the remote end
         utalk->sendObjectRequest(transInfo->obj, transInfo->allInstances);
+    } else if (transInfo->fieldUpdate) { // We are sending part of an object
+        utalk->sendObjectField(transInfo->obj, transInfo->fieldOffset, transInfo->fieldLength,
+                               transInfo->acked);
     } else { // We are sending an object to the remote end
         utalk->sendObject(transInfo->obj, transInfo->acked, transInfo->allInstances);
     }
     // Start timer if a response is expected
     if (transInfo->objRequest || transInfo->acked) {
-        transInfo->timer->start(REQ_TIMEOUT_MS);
+        armTransaction(transInfo);
     } else {
         // Stop tracking this transaction, since we're not expecting a response:
         transMap.remove(TransactionKey(transInfo->obj, transInfo->objRequest));
-        delete transInfo;
+        releaseTransaction(transInfo);
     }
 }
 
@@ -598,7 +769,7 @@ void Telemetry::processObjectQueue()
             // We will not re-request it, then, we should wait for a timeout or success...
         } else {
             UAVObject::Metadata metadata = objInfo.obj->getMetadata();
-            ObjectTransactionInfo *transInfo = new ObjectTransactionInfo(this);
+            ObjectTransactionInfo *transInfo = allocTransaction();
             transInfo->obj = objInfo.obj;
             transInfo->allInstances = objInfo.allInstances;
             transInfo->retriesRemaining = MAX_RETRIES;
@@ -609,7 +780,20 @@ void Telemetry::processObjectQueue()
             } else if (objInfo.event == EV_UPDATE_REQ) {
                 transInfo->objRequest = true;
             }
-            transInfo->telem = this;
+            // If only some fields changed locally since the last send,
+            // and the flight side can take it, send just those.
+            if (!transInfo->objRequest) {
+                quint32 offset, length;
+                bool partial = objInfo.obj->takeDirtyRange(offset, length);
+
+                if (partial && !transInfo->allInstances
+                    && flightStatsObj->getAcceptsFieldUpdates()
+                        == FlightTelemetryStats::ACCEPTSFIELDUPDATES_TRUE) {
+                    transInfo->fieldUpdate = true;
+                    transInfo->fieldOffset = offset;
+                    transInfo->fieldLength = length;
+                }
+            }
             // Insert the transaction into the transaction map.
             TransactionKey key(objInfo.obj, transInfo->objRequest);
             transMap.insert(key, transInfo);
@@ -763,30 +947,15 @@ void Telemetry::newInstance(UAVObject *obj)
     registerObject(obj);
 }
 
-ObjectTransactionInfo::ObjectTransactionInfo(QObject *parent)
-    : QObject(parent)
+void ObjectTransactionInfo::reset()
 {
     obj = nullptr;
     allInstances = false;
     objRequest = false;
     retriesRemaining = 0;
     acked = false;
-    telem = nullptr;
-    // Setup transaction timer
-    timer = new QTimer(this);
-    timer->stop();
-    connect(timer, &QTimer::timeout, this, &ObjectTransactionInfo::timeout);
-}
-
-ObjectTransactionInfo::~ObjectTransactionInfo()
-{
-    telem = nullptr;
-    timer->stop();
-    timer->deleteLater();
-}
-
-void ObjectTransactionInfo::timeout()
-{
-    if (!telem.isNull())
-        telem->transactionTimeout(this);
+    fieldUpdate = false;
+    fieldOffset = 0;
+    fieldLength = 0;
+    serial = 0;
 }
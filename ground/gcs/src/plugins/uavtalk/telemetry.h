@@ -39,28 +39,34 @@
 #include "uavtalk.h"
 #include "uavobjects/uavobjectmanager.h"
 #include "gcstelemetrystats.h"
+#include "flighttelemetrystats.h"
+#include <QElapsedTimer>
 #include <QTimer>
 #include <QQueue>
-#include <QMap>
+#include <QHash>
+#include <QVector>
 
 class TransactionKey;
 
-class ObjectTransactionInfo : public QObject
+/**
+ * A transaction waiting for its ack or reply.  These are plain records,
+ * reused from a pool, and their timeouts all run off one timer owned by
+ * Telemetry.
+ */
+struct ObjectTransactionInfo
 {
-    Q_OBJECT
+    ObjectTransactionInfo() { reset(); }
+    void reset();
 
-public:
-    ObjectTransactionInfo(QObject *parent);
-    ~ObjectTransactionInfo();
     UAVObject *obj;
     bool allInstances;
     bool objRequest;
     qint32 retriesRemaining;
     bool acked;
-    QPointer<class Telemetry> telem;
-    QTimer *timer;
-private slots:
-    void timeout();
+    bool fieldUpdate; /** Only send the byte range below */
+    quint32 fieldOffset;
+    quint32 fieldLength;
+    quint32 serial; /** Changes each time the timeout is armed, 0 if not armed */
 };
 
 class Telemetry : public QObject
@@ -86,10 +92,13 @@ public:
     TelemetryStats getStats();
     QByteArray *downloadFile(quint32 fileId, quint32 maxSize,
             std::function<void(quint32)>progressCb = nullptr);
-
-    void transactionTimeout(ObjectTransactionInfo *info);
+    void requestAllSettings();
+    void requestSettingsDigest();
+    bool sendStream(UAVObject *obj);
 
 signals:
+    void allSettingsReceived(bool success);
+    void settingsDigestReceived(const QByteArray &digest);
 
 private:
     // Constants
@@ -101,6 +110,8 @@ private:
     static const int MAX_UPDATE_PERIOD_MS = 1000;
     static const int MIN_UPDATE_PERIOD_MS = 1;
     static const int MAX_QUEUE_SIZE = 20;
+    // The settings digest, UAVTALK_FILEID_SETTINGS_DIGEST in the firmware
+    static const quint32 SETTINGS_DIGEST_FILEID = 0x81;
 
     // Types
     /**
@@ -129,19 +140,35 @@ private:
         bool allInstances;
     } ObjectQueueInfo;
 
+    typedef struct
+    {
+        ObjectTransactionInfo *info;
+        quint32 serial; /** The info's serial when this was armed */
+        qint64 deadline; /** On transClock */
+    } TransactionDeadline;
+
     // Variables
     UAVObjectManager *objMngr;
     UAVTalk *utalk;
     GCSTelemetryStats *gcsStatsObj;
+    FlightTelemetryStats *flightStatsObj;
     QVector<ObjectTimeInfo> objList;
     QQueue<ObjectQueueInfo> objQueue;
     QQueue<ObjectQueueInfo> objPriorityQueue;
-    QMap<TransactionKey, ObjectTransactionInfo *> transMap;
+    QHash<TransactionKey, ObjectTransactionInfo *> transMap;
+    QVector<ObjectTransactionInfo *> transPool; /** Finished transactions, for reuse */
+    // Every transaction has the same timeout, so they expire in the order they were armed
+    QQueue<TransactionDeadline> transDeadlines;
+    QTimer *transTimer;
+    QElapsedTimer transClock;
+    quint32 transSerial;
     QTimer *updateTimer;
     QTimer *statsTimer;
     qint32 timeToNextUpdateMs;
     quint32 txErrors;
     quint32 txRetries;
+    QByteArray settingsDigest;
+    bool settingsDigestPending;
 
     // Methods
     void registerObject(UAVObject *obj);
@@ -153,6 +180,10 @@ private:
     void processObjectTransaction(ObjectTransactionInfo *transInfo);
     void processObjectQueue();
     bool updateTransactionMap(UAVObject *obj, bool request);
+    ObjectTransactionInfo *allocTransaction();
+    void releaseTransaction(ObjectTransactionInfo *transInfo);
+    void armTransaction(ObjectTransactionInfo *transInfo);
+    void transactionTimeout(ObjectTransactionInfo *transInfo);
 
 private slots:
     void objectUpdatedAuto(UAVObject *obj);
@@ -167,6 +198,9 @@ private slots:
     void transactionSuccess(UAVObject *obj);
     void transactionFailure(UAVObject *obj);
     void transactionRequestCompleted(UAVObject *obj);
+    void checkTransactionTimeouts();
+    void settingsDigestData(quint32 fileId, quint32 offset, quint8 *data, quint32 len, bool eof,
+                            bool lastInSeq);
 };
 
 #endif // TELEMETRY_H
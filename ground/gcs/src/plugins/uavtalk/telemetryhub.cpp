@@ -0,0 +1,222 @@
+/**
+ ******************************************************************************
+ * @file       telemetryhub.cpp
+ *
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2017
+ *
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup UAVTalkPlugin UAVTalk Plugin
+ * @{
+ * @brief Serves the GCS's telemetry again to other local tools
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ * Additional note on redistribution: The copyright and license notices above
+ * must be maintained in each individual source file that is a derivative work
+ * of this source file; otherwise redistribution is prohibited.
+ */
+
+#include "telemetryhub.h"
+
+#include "flighttelemetrystats.h"
+#include "gcstelemetrystats.h"
+
+TelemetryHub::TelemetryHub(UAVObjectManager *objMngr, Core::Internal::GeneralSettings *settings,
+                           QObject *parent)
+    : QObject(parent)
+    , objMngr(objMngr)
+    , settings(settings)
+    , minIntervalMs(0)
+{
+    encodeBuffer.open(QIODevice::WriteOnly);
+    encoder = new UAVTalk(&encodeBuffer, objMngr);
+    encoder->setParent(this);
+
+    foreach (const QVector<UAVObject *> &instances, objMngr->getObjectsVector()) {
+        foreach (UAVObject *obj, instances)
+            registerObject(obj);
+    }
+
+    connect(objMngr, &UAVObjectManager::newObject, this, &TelemetryHub::registerObject);
+    connect(objMngr, &UAVObjectManager::newInstance, this, &TelemetryHub::registerObject);
+
+    connect(&server, &QTcpServer::newConnection, this, &TelemetryHub::newConnection);
+    connect(&flushTimer, &QTimer::timeout, this, &TelemetryHub::flushPending);
+
+    connect(settings, &Core::Internal::GeneralSettings::generalSettingsChanged, this,
+            &TelemetryHub::settingsChanged);
+
+    clock.start();
+    settingsChanged();
+}
+
+TelemetryHub::~TelemetryHub()
+{
+    qDeleteAll(clients);
+}
+
+/**
+ * @brief Starts, stops or moves the server to follow the settings
+ */
+void TelemetryHub::settingsChanged()
+{
+    minIntervalMs = 1000 / qMax(settings->telemetryHubRate(), 1);
+
+    quint16 port = static_cast<quint16>(settings->telemetryHubPort());
+
+    if (server.isListening() && server.serverPort() == port)
+        return;
+
+    server.close();
+
+    while (!clients.isEmpty())
+        removeClient(clients.first());
+
+    flushTimer.stop();
+    frames.clear();
+
+    if (!port)
+        return;
+
+    // Only for this computer; anything further can go through a relay
+    if (!server.listen(QHostAddress::LocalHost, port)) {
+        qWarning() << "Telemetry hub couldn't listen on port" << port << ":"
+                   << server.errorString();
+        return;
+    }
+
+    flushTimer.start(FLUSH_PERIOD_MS);
+}
+
+void TelemetryHub::newConnection()
+{
+    while (QTcpSocket *socket = server.nextPendingConnection()) {
+        Client *client = new Client();
+        client->socket = socket;
+
+        // Parses what the client sends; how the link is doing is the
+        // GCS's business, not the client's
+        client->utalk = new UAVTalk(socket, objMngr);
+        client->utalk->setParent(socket);
+        client->utalk->setReadOnlyObjects(QSet<quint32>() << GCSTelemetryStats::OBJID
+                                                         << FlightTelemetryStats::OBJID);
+
+        connect(client->utalk, &UAVTalk::objectReceived, this,
+                &TelemetryHub::clientObjectReceived);
+        connect(socket, &QTcpSocket::disconnected, this,
+                [this, client]() { removeClient(client); });
+
+        clients.append(client);
+    }
+}
+
+void TelemetryHub::removeClient(Client *client)
+{
+    if (!clients.removeOne(client))
+        return;
+
+    client->socket->disconnect(this);
+    client->socket->deleteLater();
+    delete client;
+}
+
+void TelemetryHub::registerObject(UAVObject *obj)
+{
+    connect(obj, &UAVObject::objectUpdated, this, &TelemetryHub::objectUpdated);
+    connect(obj, &QObject::destroyed, this, [this, obj]() { forgetObject(obj); });
+}
+
+void TelemetryHub::forgetObject(UAVObject *obj)
+{
+    frames.remove(obj);
+
+    for (Client *client : clients) {
+        client->lastSent.remove(obj);
+        client->pending.remove(obj);
+    }
+}
+
+/**
+ * @brief Encodes an update once and sends it to the clients that may have
+ * it now; the rest get it, or whatever follows it, from flushPending
+ */
+void TelemetryHub::objectUpdated(UAVObject *obj)
+{
+    if (clients.isEmpty())
+        return;
+
+    encodeBuffer.seek(0);
+    encodeBuffer.buffer().clear();
+
+    if (!encoder->sendObject(obj, false, false))
+        return;
+
+    frames.insert(obj, encodeBuffer.data());
+
+    qint64 now = clock.elapsed();
+
+    for (Client *client : clients) {
+        if (canSend(client, obj, now))
+            send(client, obj, now);
+        else
+            client->pending.insert(obj);
+    }
+}
+
+/**
+ * @brief Passes what a client sent on to the board
+ */
+void TelemetryHub::clientObjectReceived(UAVObject *obj)
+{
+    obj->updated();
+}
+
+void TelemetryHub::flushPending()
+{
+    qint64 now = clock.elapsed();
+
+    for (Client *client : clients) {
+        for (auto i = client->pending.begin(); i != client->pending.end();) {
+            if (canSend(client, *i, now)) {
+                send(client, *i, now);
+                i = client->pending.erase(i);
+            } else {
+                ++i;
+            }
+        }
+    }
+}
+
+bool TelemetryHub::canSend(Client *client, UAVObject *obj, qint64 now) const
+{
+    if (client->socket->bytesToWrite() > MAX_CLIENT_BACKLOG)
+        return false;
+
+    auto last = client->lastSent.constFind(obj);
+
+    return last == client->lastSent.constEnd() || now - last.value() >= minIntervalMs;
+}
+
+void TelemetryHub::send(Client *client, UAVObject *obj, qint64 now)
+{
+    client->socket->write(frames.value(obj));
+    client->lastSent.insert(obj, now);
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,115 @@
+/**
+ ******************************************************************************
+ * @file       telemetryhub.h
+ *
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2017
+ *
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup UAVTalkPlugin UAVTalk Plugin
+ * @{
+ * @brief Serves the GCS's telemetry again to other local tools
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ * Additional note on redistribution: The copyright and license notices above
+ * must be maintained in each individual source file that is a derivative work
+ * of this source file; otherwise redistribution is prohibited.
+ */
+
+#ifndef TELEMETRYHUB_H
+#define TELEMETRYHUB_H
+
+#include <QBuffer>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QSet>
+#include <QTimer>
+#include <QtNetwork/QTcpServer>
+#include <QtNetwork/QTcpSocket>
+
+#include <coreplugin/generalsettings.h>
+#include "uavobjects/uavobjectmanager.h"
+#include "uavtalk.h"
+
+/**
+ * Lets several local tools (a second GCS display, the Python tools through
+ * NetworkTelemetry) use the board the GCS is connected to.  Each object
+ * update the GCS has is encoded as a UAVTalk frame once and that frame
+ * written to every client, at most telemetryHubRate times a second per
+ * object and client; faster updates, and those for a client whose socket
+ * is backed up, are merged and the latest sent.  Objects the clients send
+ * are unpacked here and sent on to the board by the GCS's own telemetry;
+ * requests are answered from what the GCS has.
+ */
+class TelemetryHub : public QObject
+{
+    Q_OBJECT
+
+public:
+    TelemetryHub(UAVObjectManager *objMngr, Core::Internal::GeneralSettings *settings,
+                 QObject *parent = nullptr);
+    ~TelemetryHub();
+
+private slots:
+    void settingsChanged();
+    void newConnection();
+    void registerObject(UAVObject *obj);
+    void objectUpdated(UAVObject *obj);
+    void clientObjectReceived(UAVObject *obj);
+    void flushPending();
+
+private:
+    static const int FLUSH_PERIOD_MS = 20;
+    // Past this much unsent, a client only gets merged updates
+    static const qint64 MAX_CLIENT_BACKLOG = 16 * 1024;
+
+    struct Client
+    {
+        QTcpSocket *socket;
+        UAVTalk *utalk;
+        QHash<UAVObject *, qint64> lastSent;
+        QSet<UAVObject *> pending;
+    };
+
+    void removeClient(Client *client);
+    void forgetObject(UAVObject *obj);
+    bool canSend(Client *client, UAVObject *obj, qint64 now) const;
+    void send(Client *client, UAVObject *obj, qint64 now);
+
+    UAVObjectManager *objMngr;
+    Core::Internal::GeneralSettings *settings;
+
+    QTcpServer server;
+    QList<Client *> clients;
+
+    // Each object's last update, as sent to the clients
+    QBuffer encodeBuffer;
+    UAVTalk *encoder;
+    QHash<UAVObject *, QByteArray> frames;
+
+    QElapsedTimer clock;
+    QTimer flushTimer;
+    int minIntervalMs;
+};
+
+#endif // TELEMETRYHUB_H
+
+/**
+ * @}
+ * @}
+ */
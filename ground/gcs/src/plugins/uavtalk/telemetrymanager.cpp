@@ -30,7 +30,9 @@
 #include <coreplugin/icore.h>
 
 TelemetryManager::TelemetryManager()
-    : m_connected(false)
+    : utalk(nullptr)
+    , telemetry(nullptr)
+    , m_connected(false)
 {
     // Get UAVObjectManager instance
     ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
@@ -46,6 +48,7 @@ TelemetryManager::~TelemetryManager()
 void TelemetryManager::start(QIODevice *dev)
 {
     utalk = new UAVTalk(dev, objMngr);
+    utalk->setKey(settings->telemetryKey());
     telemetry = new Telemetry(utalk, objMngr);
     telemetryMon = new TelemetryMonitor(objMngr, telemetry);
     connect(telemetryMon, &TelemetryMonitor::connected, this, &TelemetryManager::onConnect);
@@ -87,3 +90,29 @@ QByteArray *TelemetryManager::downloadFile(quint32 fileId, quint32 maxSize,
 
     return telemetry->downloadFile(fileId, maxSize, progressCb);
 }
+
+/**
+ * @brief Bytes and packets each object has taken either way since the link
+ * was opened; empty without a link.  Keyed by object ID.
+ */
+QHash<quint32, UAVTalk::ObjectStats> TelemetryManager::getObjectStats() const
+{
+    if (!utalk) {
+        return QHash<quint32, UAVTalk::ObjectStats>();
+    }
+
+    return utalk->getObjectStats();
+}
+
+/**
+ * @brief Sends an object straight away, unacked and ahead of the queued
+ * updates; see Telemetry::sendStream.  False without a link.
+ */
+bool TelemetryManager::sendStream(UAVObject *obj)
+{
+    if (!telemetry) {
+        return false;
+    }
+
+    return telemetry->sendStream(obj);
+}
@@ -52,6 +52,8 @@ public:
     bool isConnected() const { return m_connected; }
     QByteArray *downloadFile(quint32 fileId, quint32 maxSize,
         std::function<void(quint32)>progressCb);
+    QHash<quint32, UAVTalk::ObjectStats> getObjectStats() const;
+    bool sendStream(UAVObject *obj);
 
 signals:
     void connected();
@@ -34,6 +34,9 @@
 #include "coreplugin/connectionmanager.h"
 #include "coreplugin/icore.h"
 #include "firmwareiapobj.h"
+#include "uavogcsversion.h"
+
+#include <QtEndian>
 
 // Timeout for the object fetching phase, the system will stop fetching objects and emit connected
 // after this
@@ -99,14 +102,20 @@ TelemetryMonitor::TelemetryMonitor(UAVObjectManager *objMngr, Telemetry *tel)
     , tel(tel)
     , queue(decltype(queue)(queueCompare))
     , requestsInFlight(0)
+    , allSettingsPending(false)
+    , settingsDigestPending(false)
+    , pingSequence(0)
 {
     this->connectionTimer = new QTime();
     // Get stats objects
     gcsStatsObj = GCSTelemetryStats::GetInstance(objMngr);
     flightStatsObj = FlightTelemetryStats::GetInstance(objMngr);
+    linkPingObj = LinkPing::GetInstance(objMngr);
 
     // Listen for flight stats updates
     connect(flightStatsObj, &UAVObject::objectUpdated, this, &TelemetryMonitor::flightStatsUpdated);
+    connect(linkPingObj, &UAVObject::objectUnpacked, this, &TelemetryMonitor::linkPingReceived);
+    pingClock.start();
 
     // Start update timer
     statsTimer = new QTimer(this);
@@ -115,6 +124,17 @@ TelemetryMonitor::TelemetryMonitor(UAVObjectManager *objMngr, Telemetry *tel)
     connect(statsTimer, &QTimer::timeout, this, &TelemetryMonitor::processStatsUpdates);
     connect(objectRetrieveTimeout, &QTimer::timeout, this,
             &TelemetryMonitor::objectRetrieveTimeoutCB);
+    allSettingsTimeout = new QTimer(this);
+    allSettingsTimeout->setSingleShot(true);
+    connect(allSettingsTimeout, &QTimer::timeout, this,
+            [this]() { allSettingsReceived(false); });
+    connect(tel, &Telemetry::allSettingsReceived, this, &TelemetryMonitor::allSettingsReceived);
+    settingsDigestTimeout = new QTimer(this);
+    settingsDigestTimeout->setSingleShot(true);
+    connect(settingsDigestTimeout, &QTimer::timeout, this,
+            [this]() { settingsDigestReceived(QByteArray()); });
+    connect(tel, &Telemetry::settingsDigestReceived, this,
+            &TelemetryMonitor::settingsDigestReceived);
     statsTimer->start(STATS_CONNECT_PERIOD_MS);
 
     Core::ConnectionManager *cm = Core::ICore::instance()->connectionManager();
@@ -132,12 +152,11 @@ TelemetryMonitor::~TelemetryMonitor()
     GCSTelemetryStats::DataFields gcsStats = gcsStatsObj->getData();
     gcsStats.Status = GCSTelemetryStats::STATUS_DISCONNECTED;
 
-    foreach (UAVObjectManager::ObjectMap map, objMngr->getObjects()) {
-        foreach (UAVObject *obj, map.values()) {
-            UAVDataObject *dobj = dynamic_cast<UAVDataObject *>(obj);
-            if (dobj)
-                dobj->resetIsPresentOnHardware();
-        }
+    saveSettingsCache();
+
+    foreach (const QVector<UAVDataObject *> &instances, objMngr->getDataObjectsVector()) {
+        foreach (UAVDataObject *dobj, instances)
+            dobj->resetIsPresentOnHardware();
     }
 
     // Set data
@@ -157,8 +176,8 @@ void TelemetryMonitor::startRetrievingObjects()
     queue = decltype(queue)(queueCompare);
 
     objectRetrieveTimeout->start(OBJECT_RETRIEVE_TIMEOUT);
-    foreach (UAVObjectManager::ObjectMap map, objMngr->getObjects().values()) {
-        UAVObject *obj = map.first();
+    foreach (const QVector<UAVObject *> &instances, objMngr->getObjectsVector()) {
+        UAVObject *obj = instances.first();
 
         /* Enqueue everything; decide later whether to bother retrieving. */
         queue.push(obj);
@@ -169,7 +188,185 @@ void TelemetryMonitor::startRetrievingObjects()
         QString(
             tr("Starting to retrieve objects from the autopilot (%1 objects)"))
             .arg(queue.size()));
-    retrieveNextObject();
+
+    // Find out from the digest which of the settings cached from last time
+    // are still good, before fetching any
+    settingsDigestPending = true;
+    settingsDigestTimeout->start(SETTINGS_DIGEST_TIMEOUT_MS);
+    tel->requestSettingsDigest();
+}
+
+/**
+ * Called with the settings digest, or with nothing when the board doesn't
+ * have one or it timed out
+ */
+void TelemetryMonitor::settingsDigestReceived(const QByteArray &digest)
+{
+    if (!settingsDigestPending)
+        return;
+
+    settingsDigestPending = false;
+    settingsDigestTimeout->stop();
+
+    if (connectionStatus != CON_RETRIEVING_OBJECTS)
+        return;
+
+    // Only what changed is fetched, one object at a time
+    if (applySettingsCache(digest)) {
+        retrieveNextObject();
+        return;
+    }
+
+    // Have the board send all its settings in one burst first, rather than
+    // paying a round trip for each.  Whatever that doesn't bring in (or
+    // everything, with firmware that can't do it) is then requested below.
+    allSettingsPending = true;
+    allSettingsTimeout->start(ALL_SETTINGS_TIMEOUT_MS);
+    tel->requestAllSettings();
+}
+
+/**
+ * Takes the settings that haven't changed since last time from the cache,
+ * going by the CRCs in the digest.  Settings the digest doesn't list aren't
+ * on the board, and metaobjects it doesn't list have their defaults.  The
+ * layout of the digest is in the firmware's uavobjectmanager.h.
+ * @return false if the digest or the cache can't be used, so everything
+ * has to be fetched
+ */
+bool TelemetryMonitor::applySettingsCache(const QByteArray &digest)
+{
+    const int serialLen = 12;
+    const int headerLen = 8 + serialLen + 4;
+    const int recordLen = 8;
+
+    settingsCache.reset();
+    cachedMetaObjects.clear();
+
+    if (digest.size() < headerLen || (digest.size() - headerLen) % recordLen)
+        return false;
+
+    const quint8 *bytes = reinterpret_cast<const quint8 *>(digest.constData());
+    quint64 uavoHash = qFromLittleEndian<quint64>(bytes);
+    quint32 fingerprint = qFromLittleEndian<quint32>(bytes + headerLen - 4);
+
+    if (uavoHash != UAVOHASH
+        || SettingsCache::crc32(0, bytes + headerLen, digest.size() - headerLen) != fingerprint)
+        return false;
+
+    QHash<quint32, quint32> crcs;
+    for (int pos = headerLen; pos < digest.size(); pos += recordLen)
+        crcs.insert(qFromLittleEndian<quint32>(bytes + pos),
+                    qFromLittleEndian<quint32>(bytes + pos + 4));
+
+    // Kept even when there's nothing cached yet, to be saved to later
+    settingsCache.reset(new SettingsCache(digest.mid(8, serialLen), uavoHash));
+    if (!settingsCache->load())
+        return false;
+
+    auto fromCache = [this, &crcs](UAVObject *obj) {
+        QByteArray data = settingsCache->get(obj->getObjID());
+        const quint8 *cached = reinterpret_cast<const quint8 *>(data.constData());
+
+        if (data.size() != static_cast<int>(obj->getNumBytes())
+            || SettingsCache::crc32(0, cached, data.size()) != crcs.value(obj->getObjID()))
+            return false;
+
+        obj->unpack(cached);
+        return true;
+    };
+
+    int fromCacheCount = 0;
+
+    foreach (const QVector<UAVObject *> &instances, objMngr->getObjectsVector()) {
+        UAVObject *obj = instances.first();
+        UAVDataObject *dobj = dynamic_cast<UAVDataObject *>(obj);
+        UAVMetaObject *mobj = dynamic_cast<UAVMetaObject *>(obj);
+
+        if (dobj) {
+            // Only instance 0 is in the digest
+            if (!dobj->isSettings() || !dobj->isSingleInstance())
+                continue;
+
+            if (!crcs.contains(obj->getObjID())) {
+                dobj->setIsPresentOnHardware(false);
+            } else if (fromCache(obj)) {
+                dobj->setReceived();
+                fromCacheCount++;
+            }
+        } else if (mobj) {
+            if (!crcs.contains(obj->getObjID())) {
+                UAVObject::Metadata mdata = mobj->getParentObject()->getDefaultMetadata();
+
+                mobj->unpack(reinterpret_cast<const quint8 *>(&mdata));
+                cachedMetaObjects.insert(mobj);
+            } else if (fromCache(obj)) {
+                cachedMetaObjects.insert(mobj);
+                fromCacheCount++;
+            }
+        }
+    }
+
+    qDebug() << QString("Took %0 of %1 settings and metaobjects from the cache")
+                    .arg(fromCacheCount)
+                    .arg(crcs.size());
+
+    return true;
+}
+
+/**
+ * Keeps the settings and metadata of the board, for the next connection to
+ * take from
+ */
+void TelemetryMonitor::saveSettingsCache()
+{
+    if (!settingsCache)
+        return;
+
+    settingsCache->clear();
+
+    foreach (const QVector<UAVObject *> &instances, objMngr->getObjectsVector()) {
+        UAVObject *obj = instances.first();
+        UAVDataObject *dobj = dynamic_cast<UAVDataObject *>(obj);
+        UAVMetaObject *mobj = dynamic_cast<UAVMetaObject *>(obj);
+
+        if (dobj) {
+            if (!dobj->isSettings() || !dobj->isSingleInstance() || !dobj->getReceived())
+                continue;
+        } else if (mobj) {
+            UAVDataObject *pobj = dynamic_cast<UAVDataObject *>(mobj->getParentObject());
+
+            if (!pobj || !pobj->getIsPresentOnHardware())
+                continue;
+        } else {
+            continue;
+        }
+
+        QByteArray data(static_cast<int>(obj->getNumBytes()), 0);
+        obj->pack(reinterpret_cast<quint8 *>(data.data()));
+        settingsCache->insert(obj->getObjID(), data);
+    }
+
+    if (!settingsCache->save())
+        qWarning() << "Could not save the settings cache";
+}
+
+/**
+ * Called at the end of the settings burst, or when it failed or timed out
+ */
+void TelemetryMonitor::allSettingsReceived(bool success)
+{
+    if (!allSettingsPending)
+        return;
+
+    TELEMETRYMONITOR_QXTLOG_DEBUG(
+        QString("%0 settings burst finished, success:%1").arg(Q_FUNC_INFO).arg(success));
+    Q_UNUSED(success);
+
+    allSettingsPending = false;
+    allSettingsTimeout->stop();
+
+    if (connectionStatus == CON_RETRIEVING_OBJECTS)
+        retrieveNextObject();
 }
 
 /**
@@ -185,6 +382,7 @@ void TelemetryMonitor::retrieveNextObject()
                 .arg(Q_FUNC_INFO)
                 .arg(connectionStatus));
         connectionStatus = CON_CONNECTED_MANAGED;
+        saveSettingsCache();
         emit connected();
         objectRetrieveTimeout->stop();
         return;
@@ -221,6 +419,9 @@ void TelemetryMonitor::retrieveNextObject()
             UAVMetaObject *mobj = dynamic_cast<UAVMetaObject *>(obj);
 
             if (mobj) {
+                if (cachedMetaObjects.contains(mobj))
+                    continue;
+
                 UAVDataObject *pobj = dynamic_cast<UAVDataObject *>(
                         mobj->getParentObject());
                 if (pobj->getPresenceKnown() && (!pobj->getIsPresentOnHardware())) {
@@ -386,6 +587,19 @@ void TelemetryMonitor::processStatsUpdates()
     gcsStats.RxFailures += telStats.rxErrors;
     gcsStats.TxFailures += telStats.txErrors;
     gcsStats.TxRetries += telStats.txRetries;
+    gcsStats.AcceptsBatchedFrames = GCSTelemetryStats::ACCEPTSBATCHEDFRAMES_TRUE;
+
+    // The quickest recent ping was held up least, so it tells the most
+    if (!pingSamples.isEmpty()) {
+        PingSample best = pingSamples.first();
+        for (const PingSample &sample : pingSamples) {
+            if (sample.roundTrip < best.roundTrip)
+                best = sample;
+        }
+
+        gcsStats.LinkLatency = best.roundTrip / 2.0;
+        gcsStats.ClockOffset = best.clockOffset;
+    }
 
     // Check for a connection timeout
     bool connectionTimeout;
@@ -435,14 +649,67 @@ void TelemetryMonitor::processStatsUpdates()
     } else if (gcsStats.Status == GCSTelemetryStats::STATUS_DISCONNECTED && gcsStats.Status != oldStatus) {
         statsTimer->setInterval(STATS_CONNECT_PERIOD_MS);
         connectionStatus = CON_DISCONNECTED;
-        foreach (UAVObjectManager::ObjectMap map, objMngr->getObjects()) {
-            foreach (UAVObject *obj, map.values()) {
-                UAVDataObject *dobj = dynamic_cast<UAVDataObject *>(obj);
-                if (dobj)
-                    dobj->resetIsPresentOnHardware();
-            }
+        pingSamples.clear();
+        saveSettingsCache();
+        settingsCache.reset();
+        cachedMetaObjects.clear();
+        foreach (const QVector<UAVDataObject *> &instances, objMngr->getDataObjectsVector()) {
+            foreach (UAVDataObject *dobj, instances)
+                dobj->resetIsPresentOnHardware();
         }
 
         emit disconnected();
     }
+
+    if (connectionStatus == CON_CONNECTED_MANAGED)
+        sendLinkPing();
+}
+
+/**
+ * Sends a ping for the board to stamp with when it got it and when it
+ * answered
+ */
+void TelemetryMonitor::sendLinkPing()
+{
+    LinkPing::DataFields ping = linkPingObj->getData();
+
+    ping.Sequence = ++pingSequence;
+    ping.GCSSent = static_cast<quint32>(pingClock.elapsed());
+    ping.FlightReceived = 0;
+    ping.FlightSent = 0;
+
+    linkPingObj->setData(ping);
+    linkPingObj->updated();
+}
+
+/**
+ * Works out the round trip and clock offset from an answered ping, the way
+ * NTP does: the time the board held the ping doesn't count towards the
+ * round trip, and the offset assumes both directions took as long.
+ */
+void TelemetryMonitor::linkPingReceived(UAVObject *obj)
+{
+    Q_UNUSED(obj);
+
+    LinkPing::DataFields ping = linkPingObj->getData();
+
+    // Only the answer to the last ping; a late one would skew the estimate
+    if (ping.Sequence != pingSequence || !ping.FlightSent)
+        return;
+
+    qint64 t1 = ping.GCSSent;
+    qint64 t2 = ping.FlightReceived;
+    qint64 t3 = ping.FlightSent;
+    qint64 t4 = pingClock.elapsed();
+
+    PingSample sample;
+    sample.roundTrip = (t4 - t1) - (t3 - t2);
+    sample.clockOffset = ((t1 - t2) + (t4 - t3)) / 2.0;
+
+    if (sample.roundTrip < 0)
+        return;
+
+    pingSamples.append(sample);
+    while (pingSamples.size() > LINK_PING_SAMPLES)
+        pingSamples.removeFirst();
 }
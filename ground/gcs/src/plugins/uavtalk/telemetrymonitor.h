@@ -37,14 +37,20 @@
 
 #include <queue>
 
+#include <QElapsedTimer>
+#include <QList>
 #include <QObject>
+#include <QScopedPointer>
+#include <QSet>
 #include <QTimer>
 #include <QTime>
 #include "uavobjects/uavobjectmanager.h"
 #include "gcstelemetrystats.h"
 #include "flighttelemetrystats.h"
+#include "linkping.h"
 #include "systemstats.h"
 #include "telemetry.h"
+#include "settingscache.h"
 #include <coreplugin/generalsettings.h>
 #include <extensionsystem/pluginmanager.h>
 
@@ -73,13 +79,22 @@ public slots:
     void flightStatsUpdated(UAVObject *obj);
 private slots:
     void objectRetrieveTimeoutCB();
+    void allSettingsReceived(bool success);
+    void settingsDigestReceived(const QByteArray &digest);
     void newInstanceSlot(UAVObject *);
+    void linkPingReceived(UAVObject *);
 
 private:
     static const int STATS_UPDATE_PERIOD_MS = 1600;
     static const int STATS_CONNECT_PERIOD_MS = 350;
     static const int CONNECTION_TIMEOUT_MS = 8000;
     static const int MAX_REQUESTS_IN_FLIGHT = 3;
+    // Long enough for all the settings at 9600bps
+    static const int ALL_SETTINGS_TIMEOUT_MS = 8000;
+    // The digest is 8 bytes a setting, so over a radio this is plenty
+    static const int SETTINGS_DIGEST_TIMEOUT_MS = 3000;
+    // Pings the link estimate is taken from; the quickest round trip wins
+    static const int LINK_PING_SAMPLES = 8;
     enum connectionStatusEnum {
         CON_DISCONNECTED,
         CON_INITIALIZING,
@@ -98,10 +113,31 @@ private:
     QTimer *statsTimer;
     QTime *connectionTimer;
     QTimer *objectRetrieveTimeout;
+    QTimer *allSettingsTimeout;
     int requestsInFlight;
+    bool allSettingsPending;
+    QTimer *settingsDigestTimeout;
+    bool settingsDigestPending;
+    QScopedPointer<SettingsCache> settingsCache;
+    // Metaobjects known from the digest, that don't need fetching
+    QSet<UAVObject *> cachedMetaObjects;
+
+    struct PingSample
+    {
+        qint64 roundTrip;
+        double clockOffset;
+    };
+
+    LinkPing *linkPingObj;
+    QElapsedTimer pingClock;
+    quint16 pingSequence;
+    QList<PingSample> pingSamples;
 
     void startRetrievingObjects();
+    bool applySettingsCache(const QByteArray &digest);
+    void saveSettingsCache();
     void retrieveNextObject();
+    void sendLinkPing();
 };
 
 #endif // TELEMETRYMONITOR_H
@@ -38,6 +38,8 @@
 #include <extensionsystem/pluginmanager.h>
 #include <coreplugin/generalsettings.h>
 
+#include <random>
+
 // #define UAVTALK_DEBUG
 #ifdef UAVTALK_DEBUG
 #define UAVTALK_QXTLOG_DEBUG(...) qDebug() << __VA_ARGS__
@@ -70,6 +72,7 @@ const quint8 UAVTalk::crc_table[256] = {
  * Constructor
  */
 UAVTalk::UAVTalk(QIODevice *iodev, UAVObjectManager *objMngr)
+    : blackbox(objMngr)
 {
     io = iodev;
 
@@ -77,6 +80,12 @@ UAVTalk::UAVTalk(QIODevice *iodev, UAVObjectManager *objMngr)
 
     startOffset = 0;
     filledBytes = 0;
+    resumePending = false;
+
+    keyed = false;
+    txSalt = txSeq = 0;
+    rxSalt = rxSeq = 0;
+    rxValid = false;
 
     memset(&stats, 0, sizeof(ComStats));
 
@@ -103,11 +112,61 @@ UAVTalk::ComStats UAVTalk::getStats()
 }
 
 /**
- * Called each time there are data in the input buffer
+ * Set the key shared with the remote end.  Once keyed, every frame is sent
+ * secured and frames that aren't are dropped; the remote end answers in
+ * kind.
+ * \param[in] key Aes128::KEY_SIZE bytes of key, or empty for none
+ */
+void UAVTalk::setKey(const QByteArray &key)
+{
+    keyed = false;
+
+    if (key.size() != Aes128::KEY_SIZE) {
+        return;
+    }
+
+    /* One key for each job, each the shared key's encryption of a constant
+     * block, as the flight side derives them. */
+    quint8 derived[Aes128::BLOCK_SIZE] = { 2 };
+
+    encKey.setKey(reinterpret_cast<const quint8 *>(key.constData()));
+    encKey.encryptBlock(derived, derived);
+    macKey.setKey(derived);
+
+    memset(derived, 0, sizeof(derived));
+    derived[0] = 1;
+
+    encKey.encryptBlock(derived, derived);
+    encKey.setKey(derived);
+
+    memset(derived, 0, sizeof(derived));
+
+    txSeq = 0;
+    rxValid = false;
+    keyed = true;
+}
+
+/**
+ * Called each time there are data in the input buffer.  A burst of input can
+ * take a while to unpack, since every object update is handled as it is
+ * unpacked; rather than hold up the UI through all of it, this hands control
+ * back to the event loop after MAX_PROCESS_MS and carries on afterwards.
  */
 void UAVTalk::processInputStream()
 {
+    QElapsedTimer elapsed;
+    elapsed.start();
+
+    resumePending = false;
+
     while (io && io->isReadable()) {
+        while (processInput()) {
+            if (elapsed.elapsed() >= MAX_PROCESS_MS) {
+                scheduleResume();
+                return;
+            }
+        }
+
         if (startOffset > (sizeof(rxBuffer) - MAX_PACKET_LENGTH)) {
             /* If we're not sure there's room for a frame, shift things left in
              * the buffer so that we can do a bigger read.
@@ -127,11 +186,23 @@ void UAVTalk::processInputStream()
 
         filledBytes += bytes;
         stats.rxBytes += bytes;
-
-        while (processInput());
     }
 }
 
+/**
+ * Queues another pass over the buffered input, after the events that are
+ * waiting have been handled
+ */
+void UAVTalk::scheduleResume()
+{
+    if (resumePending)
+        return;
+
+    resumePending = true;
+
+    QTimer::singleShot(0, this, &UAVTalk::processInputStream);
+}
+
 /**
  * Request an update for the specified object, on success the object data would have been
  * updated by the GCS.
@@ -144,6 +215,22 @@ bool UAVTalk::sendObjectRequest(UAVObject *obj, bool allInstances)
     return objectTransaction(obj, TYPE_OBJ_REQ, allInstances);
 }
 
+/**
+ * Ask the remote end for all of its settings objects at once.  They come
+ * back as ordinary object updates, followed by allSettingsReceived(true);
+ * firmware that can't do this NACKs, giving allSettingsReceived(false).
+ * \return Success (true), Failure (false)
+ */
+bool UAVTalk::sendAllSettingsRequest()
+{
+    txBuffer[0] = SYNC_VAL;
+    txBuffer[1] = TYPE_VER | TYPE_OBJ_REQ;
+
+    qToLittleEndian<quint32>(ALL_SETTINGS_OBJID, &txBuffer[4]);
+
+    return transmitFrame(8, false);
+}
+
 /**
  * Send the specified object through the telemetry link.
  * \param[in] obj Object to send
@@ -160,6 +247,50 @@ bool UAVTalk::sendObject(UAVObject *obj, bool acked, bool allInstances)
     }
 }
 
+/**
+ * Send a byte range of the specified object through the telemetry link,
+ * instead of the whole object.  The remote end must support field updates.
+ * \param[in] obj Object to send
+ * \param[in] offset Offset of the range into the object data
+ * \param[in] length Number of bytes in the range
+ * \param[in] acked Selects if an ack is required
+ * \return Success (true), Failure (false)
+ */
+bool UAVTalk::sendObjectField(UAVObject *obj, quint32 offset, quint32 length, bool acked)
+{
+    if (length == 0 || offset + length > obj->getNumBytes()) {
+        return false;
+    }
+
+    txBuffer[0] = SYNC_VAL;
+    txBuffer[1] = TYPE_VER | (acked ? TYPE_OBJ_FIELD_ACK : TYPE_OBJ_FIELD);
+    qToLittleEndian<quint32>(obj->getObjID(), &txBuffer[4]);
+
+    qint32 dataOffset = 8;
+
+    if (!obj->isSingleInstance()) {
+        qToLittleEndian<quint16>(static_cast<quint16>(obj->getInstID()), &txBuffer[8]);
+        dataOffset = 10;
+    }
+
+    qToLittleEndian<quint16>(static_cast<quint16>(offset), &txBuffer[dataOffset]);
+    dataOffset += 2;
+
+    if (dataOffset + length >= MAX_PACKET_LENGTH) {
+        return false;
+    }
+
+    QByteArray packed(static_cast<int>(obj->getNumBytes()), 0);
+
+    if (!obj->pack(reinterpret_cast<quint8 *>(packed.data()))) {
+        return false;
+    }
+
+    memcpy(&txBuffer[dataOffset], packed.constData() + offset, length);
+
+    return transmitFrame(dataOffset + length);
+}
+
 /**
  * Execute the requested transaction on an object.
  * \param[in] obj Object
@@ -179,6 +310,75 @@ bool UAVTalk::objectTransaction(UAVObject *obj, quint8 type, bool allInstances)
     }
 }
 
+/**
+ * Expands one LZ4 block, as sent by the flight side for compressed file
+ * requests (see flight/Libraries/lz4block.c).
+ * \param[in] data The block
+ * \param[in] length Length of the block
+ * \param[out] out The expanded data
+ * \return Success (true), Failure (false) if the block is malformed
+ */
+static bool lz4Decompress(const quint8 *data, quint32 length, QByteArray &out)
+{
+    const quint8 *end = data + length;
+
+    auto getLength = [&](quint32 &len) {
+        quint8 b;
+
+        do {
+            if (data >= end)
+                return false;
+
+            b = *(data++);
+            len += b;
+        } while (b == 255);
+
+        return true;
+    };
+
+    out.clear();
+
+    while (data < end) {
+        quint8 token = *(data++);
+        quint32 len = token >> 4;
+
+        if (len == 15 && !getLength(len))
+            return false;
+
+        if (static_cast<quint32>(end - data) < len)
+            return false;
+
+        out.append(reinterpret_cast<const char *>(data), static_cast<int>(len));
+        data += len;
+
+        if (data >= end)
+            break;
+
+        if (end - data < 2)
+            return false;
+
+        quint32 offset = data[0] | (data[1] << 8);
+        data += 2;
+
+        if (offset == 0 || offset > static_cast<quint32>(out.size()))
+            return false;
+
+        len = (token & 15) + 4;
+
+        if ((token & 15) == 15 && !getLength(len))
+            return false;
+
+        // Byte by byte, since the match may overlap what it makes
+        int start = out.size() - static_cast<int>(offset);
+
+        for (quint32 i = 0; i < len; i++) {
+            out.append(out.at(start + static_cast<int>(i)));
+        }
+    }
+
+    return true;
+}
+
 /**
  * Processes a frame containing file data.
  * \param fielId the received file id
@@ -199,12 +399,90 @@ bool UAVTalk::receiveFileChunk(quint32 fileId, quint8 *data, quint32 length)
     // qDebug() << "Received file chunk, file=" << fileId << ", offset = " <<
     //    hdr->offset << ", len=" << length << ", flags=" << hdr->flags;
 
+    QByteArray expanded;
+
+    if (hdr->flags & FILEDATA_FLAG_LZ4) {
+        if (!lz4Decompress(data, length, expanded)) {
+            return false;
+        }
+
+        data = reinterpret_cast<quint8 *>(expanded.data());
+        length = static_cast<quint32>(expanded.size());
+    }
+
     emit fileDataReceived(fileId, hdr->offset, data, length, !!(hdr->flags & FILEDATA_FLAG_EOF),
                           !!(hdr->flags & FILEDATA_FLAG_LAST));
 
     return true;
 }
 
+/**
+ * Processes a batched frame, which carries several object updates.
+ * Records for objects we don't know are skipped.
+ * \param data Buffer to the first record
+ * \param length Number of bytes of records
+ * \return Success (true), Failure (false) if any record was malformed
+ */
+bool UAVTalk::receiveBatch(quint8 *data, quint32 length)
+{
+    quint8 *end = data + length;
+
+    while (data < end) {
+        if (end - data < BATCH_RECORD_HEADER_LENGTH) {
+            stats.rxErrors++;
+            return false;
+        }
+
+        quint32 objId = qFromLittleEndian<quint32>(data);
+        quint8 recLength = data[4];
+
+        data += BATCH_RECORD_HEADER_LENGTH;
+
+        if (recLength > end - data) {
+            stats.rxErrors++;
+            return false;
+        }
+
+        quint8 *recData = data;
+        data += recLength;
+
+        UAVObject *obj = objMngr->getObject(objId);
+
+        if (obj == nullptr) {
+            UAVTALK_QXTLOG_DEBUG("UAVTalk: unknown object in batch");
+            continue;
+        }
+
+        quint16 instId = 0;
+        quint32 expected = obj->getNumBytes();
+
+        if (!obj->isSingleInstance()) {
+            expected += 2;
+
+            if (recLength >= 2) {
+                instId = qFromLittleEndian<quint16>(recData);
+                recData += 2;
+            }
+        }
+
+        if (recLength != expected || instId == ALL_INSTANCES) {
+            UAVTALK_QXTLOG_DEBUG("UAVTalk: Unexpected payload size for obj in batch");
+            stats.rxErrors++;
+            continue;
+        }
+
+        receiveObject(TYPE_OBJ, objId, instId, recData, obj->getNumBytes());
+        stats.rxObjectBytes += obj->getNumBytes();
+        stats.rxObjects++;
+
+        ObjectStats &objStats = objectStats[objId];
+        objStats.rxBytes += BATCH_RECORD_HEADER_LENGTH + recLength;
+        objStats.rxPackets++;
+    }
+
+    return true;
+}
+
 /**
  * Process a frame from input, if available.
  * \return False if there was insufficient data for a frame, true if trying
@@ -266,14 +544,44 @@ bool UAVTalk::processInput()
         return true;
     }
 
-    quint8 *payload = rxBuffer + startOffset + sizeof(*hdr);
-    unsigned int payloadBytes = hdr->size - sizeof(*hdr);
+    quint8 *frame = rxBuffer + startOffset;
 
     /* At this point, we'll advance startOffset for the entire length of
      * frame, and not touch startOffset again this function!
      */
     startOffset += hdr->size + 1;
 
+    if ((hdr->type & TYPE_MASK) == TYPE_SECURE) {
+        receiveSecure(frame);
+
+        return true;
+    }
+
+    // Once keyed, only secured frames are trusted
+    if (keyed) {
+        stats.rxErrors++;
+
+        return true;
+    }
+
+    return processFrame(frame);
+}
+
+/**
+ * Act on a complete frame, whose framing and checksum have been checked.
+ * \param[in] frame The frame, sync byte to checksum
+ * \return False if processing should stop for now, as for processInput()
+ */
+bool UAVTalk::processFrame(quint8 *frame)
+{
+    UAVTalkHeader *hdr = reinterpret_cast<UAVTalkHeader *>(frame);
+
+    quint8 *payload = frame + sizeof(*hdr);
+    unsigned int payloadBytes = hdr->size - sizeof(*hdr);
+
+    quint8 *batch = frame + BATCH_HEADER_LENGTH;
+    unsigned int batchBytes = hdr->size - BATCH_HEADER_LENGTH;
+
     /* OK, we have a complete frame as encoded on the wire.  Time to do things
      * with it.
      */
@@ -285,6 +593,27 @@ bool UAVTalk::processInput()
         return receiveFileChunk(rxObjId, payload, payloadBytes);
     }
 
+    if (rxType == TYPE_OBJ_BATCH) {
+        receiveBatch(batch, batchBytes);
+
+        return true;
+    }
+
+    if (rxType == TYPE_BLACKBOX) {
+        if (!blackbox.receiveChunk(rxObjId & 0xffff, (rxObjId >> 16) & 0xff, rxObjId >> 24,
+                                   payload, payloadBytes)) {
+            stats.rxErrors++;
+        }
+
+        return true;
+    }
+
+    if (rxObjId == ALL_SETTINGS_OBJID && (rxType == TYPE_ACK || rxType == TYPE_NACK)) {
+        emit allSettingsReceived(rxType == TYPE_ACK);
+
+        return true;
+    }
+
     UAVObject *rxObj = objMngr->getObject(rxObjId);
 
     if (rxObj == nullptr) {
@@ -335,10 +664,76 @@ bool UAVTalk::processInput()
     stats.rxObjectBytes += payloadBytes;
     stats.rxObjects++;
 
+    ObjectStats &objStats = objectStats[rxObjId];
+    objStats.rxBytes += hdr->size + CHECKSUM_LENGTH;
+    objStats.rxPackets++;
+
     // Done
     return true;
 }
 
+/**
+ * Check and unwrap a secured frame, then act on the frame inside it.
+ * Frames that don't check out, or were seen before, are dropped.
+ * \param[in] frame The secured frame, sync byte to checksum
+ * \return Success (true), Failure (false)
+ */
+bool UAVTalk::receiveSecure(const quint8 *frame)
+{
+    int size = frame[2];
+    int length = size - SECURE_HEADER_LENGTH - SECURE_NONCE_LENGTH - SECURE_TAG_LENGTH;
+
+    if (!keyed || length < MIN_HEADER_LENGTH + CHECKSUM_LENGTH) {
+        stats.rxErrors++;
+        return false;
+    }
+
+    const quint8 *nonce = frame + SECURE_HEADER_LENGTH;
+    const quint8 *sealed = nonce + SECURE_NONCE_LENGTH;
+
+    quint8 block[Aes128::BLOCK_SIZE];
+
+    macKey.cmac(nonce, SECURE_NONCE_LENGTH + length, block);
+
+    quint8 diff = 0;
+
+    for (int i = 0; i < SECURE_TAG_LENGTH; i++) {
+        diff |= block[i] ^ sealed[length + i];
+    }
+
+    quint32 salt = qFromLittleEndian<quint32>(nonce);
+    quint32 seq = qFromLittleEndian<quint32>(nonce + 4);
+
+    if (diff || (rxValid && salt == rxSalt && seq <= rxSeq)) {
+        stats.rxErrors++;
+        return false;
+    }
+
+    rxSalt = salt;
+    rxSeq = seq;
+    rxValid = true;
+
+    quint8 *inner = secureRxBuffer;
+
+    memcpy(inner, sealed, length);
+    memset(block, 0, sizeof(block));
+    memcpy(block, nonce, SECURE_NONCE_LENGTH);
+    encKey.ctr(block, inner, length);
+
+    // It was made by someone with the key, but check it's whole all the same
+    if (inner[0] != SYNC_VAL || (inner[1] & VER_MASK) != TYPE_VER
+        || (inner[1] & TYPE_MASK) == TYPE_SECURE
+        || qFromLittleEndian<quint16>(inner + 2) + CHECKSUM_LENGTH != length
+        || updateCRC(0, inner, length - CHECKSUM_LENGTH) != inner[length - CHECKSUM_LENGTH]) {
+        stats.rxErrors++;
+        return false;
+    }
+
+    processFrame(inner);
+
+    return true;
+}
+
 /**
  * Receive an object. This function process objects received through the telemetry stream.
  * \param[in] type Type of received message (TYPE_OBJ, TYPE_OBJ_REQ, TYPE_OBJ_ACK, TYPE_ACK,
@@ -473,6 +868,9 @@ bool UAVTalk::receiveObject(quint8 type, quint32 objId, quint16 instId, quint8 *
  */
 UAVObject *UAVTalk::updateObject(quint32 objId, quint16 instId, quint8 *data)
 {
+    if (readOnlyObjects.contains(objId))
+        return objMngr->getObject(objId, instId);
+
     // Get object
     UAVObject *obj = objMngr->getObject(objId, instId);
     // If the instance does not exist create it
@@ -493,10 +891,12 @@ UAVObject *UAVTalk::updateObject(quint32 objId, quint16 instId, quint8 *data)
             return nullptr;
         }
         instobj->unpack(data);
+        emit objectReceived(instobj);
         return instobj;
     } else {
         // Unpack data into object instance
         obj->unpack(data);
+        emit objectReceived(obj);
         return obj;
     }
 }
@@ -576,8 +976,22 @@ bool UAVTalk::transmitFrame(quint32 length, bool incrTxObj)
 
     txBuffer[length] = updateCRC(0, txBuffer, length);
 
+    const quint8 *out = txBuffer;
+    quint32 outLength = length + CHECKSUM_LENGTH;
+
+    if (keyed) {
+        outLength = sealFrame(outLength);
+
+        if (!outLength) {
+            ++stats.txErrors;
+            return false;
+        }
+
+        out = secureTxBuffer;
+    }
+
     if (!io.isNull() && io->isWritable() && io->bytesToWrite() < TX_BACKLOG_SIZE) {
-        io->write(reinterpret_cast<const char *>(txBuffer), length + CHECKSUM_LENGTH);
+        io->write(reinterpret_cast<const char *>(out), outLength);
     } else {
         UAVTALK_QXTLOG_DEBUG("UAVTalk: TX refused");
         ++stats.txErrors;
@@ -591,26 +1005,84 @@ bool UAVTalk::transmitFrame(quint32 length, bool incrTxObj)
          * woop / I think this is arguably correct.
          */
         stats.txObjectBytes += length - MIN_HEADER_LENGTH;
+
+        ObjectStats &objStats = objectStats[qFromLittleEndian<quint32>(&txBuffer[4])];
+        objStats.txBytes += outLength;
+        objStats.txPackets++;
     }
 
-    stats.txBytes += length + CHECKSUM_LENGTH;
+    stats.txBytes += outLength;
 
     return true;
 }
 
+/**
+ * Wrap the frame in txBuffer in a secured frame, in secureTxBuffer.
+ * \param[in] length Frame length, including checksum.
+ * \return length of the secured frame, including checksum, or 0 if the
+ * frame is too long to secure
+ */
+quint32 UAVTalk::sealFrame(quint32 length)
+{
+    if (length > MAX_SECURED_FRAME) {
+        return 0;
+    }
+
+    /* A new salt for each session, and whenever the sequence wraps, so
+     * that no counter block is used twice with a key. */
+    if (txSeq == 0) {
+        std::random_device random;
+        txSalt = random();
+        txSeq = 1;
+    }
+
+    quint32 seq = txSeq++;
+
+    quint8 *frame = secureTxBuffer;
+    quint8 *nonce = frame + SECURE_HEADER_LENGTH;
+    quint8 *sealed = nonce + SECURE_NONCE_LENGTH;
+    quint32 size = SECURE_HEADER_LENGTH + SECURE_NONCE_LENGTH + length + SECURE_TAG_LENGTH;
+
+    frame[0] = SYNC_VAL;
+    frame[1] = TYPE_VER | TYPE_SECURE;
+    qToLittleEndian<quint16>(static_cast<quint16>(size), &frame[2]);
+    qToLittleEndian<quint32>(txSalt, nonce);
+    qToLittleEndian<quint32>(seq, nonce + 4);
+
+    quint8 block[Aes128::BLOCK_SIZE] = { 0 };
+
+    memcpy(sealed, txBuffer, length);
+    memcpy(block, nonce, SECURE_NONCE_LENGTH);
+    encKey.ctr(block, sealed, static_cast<int>(length));
+
+    macKey.cmac(nonce, SECURE_NONCE_LENGTH + static_cast<int>(length), block);
+    memcpy(sealed + length, block, SECURE_TAG_LENGTH);
+
+    frame[size] = updateCRC(0, frame, static_cast<qint32>(size));
+
+    return size + CHECKSUM_LENGTH;
+}
+
 /**
  * Send a request for file data.
  * \param[in] fileId The file id to request.
  * \param[in] offset The first requested chunk of the file.
+ * \param[in] count Number of messages to send back, 0 for the default.
+ * \param[in] compress Whether the data may come back LZ4 compressed.
  */
-bool UAVTalk::requestFile(quint32 fileId, quint32 offset)
+bool UAVTalk::requestFile(quint32 fileId, quint32 offset, quint8 count, bool compress)
 {
+    quint16 flags = count;
+
+    if (compress) {
+        flags |= FILEREQ_FLAG_LZ4;
+    }
+
     txBuffer[0] = SYNC_VAL;
     txBuffer[1] = TYPE_VER | TYPE_FILEREQ;
     qToLittleEndian<quint32>(fileId, &txBuffer[4]);
     qToLittleEndian<quint32>(offset, &txBuffer[8]);
-    txBuffer[12] = 0;
-    txBuffer[13] = 0;
+    qToLittleEndian<quint16>(flags, &txBuffer[12]);
 
     // qDebug() << "Sent file req offs=" << offset;
 
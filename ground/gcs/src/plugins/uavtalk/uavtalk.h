@@ -41,6 +41,8 @@
 #include <QSemaphore>
 #include "uavobjects/uavobjectmanager.h"
 #include "uavtalk_global.h"
+#include "blackboxdecoder.h"
+#include "aes128.h"
 #include <QtNetwork/QUdpSocket>
 
 class UAVTALK_EXPORT UAVTalk : public QObject
@@ -60,13 +62,27 @@ public:
         quint32 rxErrors;
     };
 
+    //! Link use by one object, counted up from when the link was opened
+    struct ObjectStats
+    {
+        quint32 txBytes;
+        quint32 rxBytes;
+        quint32 txPackets;
+        quint32 rxPackets;
+    };
+
     UAVTalk(QIODevice *iodev, UAVObjectManager *objMngr);
     ~UAVTalk();
     bool sendObject(UAVObject *obj, bool acked, bool allInstances);
+    bool sendObjectField(UAVObject *obj, quint32 offset, quint32 length, bool acked);
     bool sendObjectRequest(UAVObject *obj, bool allInstances);
-    bool requestFile(quint32 fileId, quint32 offset);
+    bool sendAllSettingsRequest();
+    bool requestFile(quint32 fileId, quint32 offset, quint8 count = 0, bool compress = false);
+    void setKey(const QByteArray &key);
+    void setReadOnlyObjects(const QSet<quint32> &objIds) { readOnlyObjects = objIds; }
 
     ComStats getStats();
+    QHash<quint32, ObjectStats> getObjectStats() const { return objectStats; }
 
     bool processInput();
 
@@ -75,6 +91,10 @@ signals:
     // either receive an ACK or a NACK for a request.
     void ackReceived(UAVObject *obj);
     void nackReceived(UAVObject *obj);
+    // An object the other end sent us was unpacked
+    void objectReceived(UAVObject *obj);
+    // The end of the reply to sendAllSettingsRequest()
+    void allSettingsReceived(bool success);
 
     // Or when we get some file data
     void fileDataReceived(quint32 fileId, quint32 offset, quint8 *data,
@@ -94,20 +114,49 @@ protected:
     static const int TYPE_OBJ_ACK = 0x02;
     static const int TYPE_ACK = 0x03;
     static const int TYPE_NACK = 0x04;
+    static const int TYPE_OBJ_FIELD = 0x05;
+    static const int TYPE_OBJ_FIELD_ACK = 0x06;
     static const int TYPE_FILEREQ = 0x08;
     static const int TYPE_FILEDATA = 0x09;
+    static const int TYPE_OBJ_BATCH = 0x0A;
+    static const int TYPE_BLACKBOX = 0x0B;
+    static const int TYPE_SECURE = 0x0C;
 
     static const int MIN_HEADER_LENGTH = 8; // sync(1), type (1), size(2), object ID(4)
     static const int MAX_HEADER_LENGTH = MIN_HEADER_LENGTH + 2; // instance ID(2, not used in single objs)
 
     static const int CHECKSUM_LENGTH = 1;
 
+    // Batched frames: sync(1), type(1), size(2), then records of
+    // object ID(4), length(1), instance ID(2, multi instance objs) and data
+    static const int BATCH_HEADER_LENGTH = 4;
+    static const int BATCH_RECORD_HEADER_LENGTH = 5;
+
+    // Blackbox chunks: the object ID is replaced by seq(2), first frame
+    // offset(1) and field count(1); see BlackboxDecoder
+
+    // Secured frames: sync(1), type(1), size(2), salt(4), sequence(4), a
+    // whole ordinary frame encrypted with AES-128 in counter mode, then 8
+    // bytes of CMAC over the salt to the end of the encrypted frame.  See
+    // flight/Libraries/inc/uavtalk_priv.h
+    static const int SECURE_HEADER_LENGTH = 4;
+    static const int SECURE_NONCE_LENGTH = 8;
+    static const int SECURE_TAG_LENGTH = 8;
+    static const int MAX_SECURE_LENGTH = 255;
+    static const int MAX_SECURED_FRAME =
+        MAX_SECURE_LENGTH - SECURE_HEADER_LENGTH - SECURE_NONCE_LENGTH - SECURE_TAG_LENGTH;
+
     static const int MAX_PACKET_LENGTH = 256;
 
     static const int MAX_PAYLOAD_LENGTH = (MAX_PACKET_LENGTH - CHECKSUM_LENGTH - MAX_HEADER_LENGTH);
 
+    // Longest the input stream is processed for before yielding to the UI
+    static const int MAX_PROCESS_MS = 10;
+
     static const quint16 ALL_INSTANCES = 0xFFFF;
     static const quint16 OBJID_NOTFOUND = 0x0000;
+    // Requested to get every settings object (see UAVTALK_OBJID_ALL_SETTINGS)
+    static const quint32 ALL_SETTINGS_OBJID = 0xFFFFFFFF;
 
     static const int TX_BACKLOG_SIZE = 2 * 1024;
     static const quint8 crc_table[256];
@@ -129,6 +178,9 @@ protected:
 
     static const quint8 FILEDATA_FLAG_EOF = 0x01;
     static const quint8 FILEDATA_FLAG_LAST = 0x02;
+    static const quint8 FILEDATA_FLAG_LZ4 = 0x04;
+
+    static const quint16 FILEREQ_FLAG_LZ4 = 0x0100;
 #pragma pack(pop)
 
     // Variables
@@ -140,24 +192,51 @@ protected:
     quint8 rxBuffer[MAX_PACKET_LENGTH * 12];
     quint8 txBuffer[MAX_PACKET_LENGTH];
 
+    // Keys and session state for secured frames; once keyed, nothing else
+    // is sent or accepted
+    bool keyed;
+    Aes128 encKey;
+    Aes128 macKey;
+    quint32 txSalt;
+    quint32 txSeq;
+    quint32 rxSalt;
+    quint32 rxSeq;
+    bool rxValid;
+    quint8 secureTxBuffer[MAX_PACKET_LENGTH];
+    quint8 secureRxBuffer[MAX_SECURED_FRAME];
+
     // Variables used by the receive state machine
 
     quint32 startOffset;
     quint32 filledBytes;
 
+    // Set while a continuation of processInputStream is queued
+    bool resumePending;
+
     ComStats stats;
+    QHash<quint32, ObjectStats> objectStats;
+
+    // Objects the other end may not change; updates are acked and dropped
+    QSet<quint32> readOnlyObjects;
+
+    BlackboxDecoder blackbox;
 
     // Methods
+    void scheduleResume();
     bool objectTransaction(UAVObject *obj, quint8 type, bool allInstances);
     bool receiveObject(quint8 type, quint32 objId, quint16 instId,
             quint8 *data, quint32 length);
     bool receiveFileChunk(quint32 fileId, quint8 *data, quint32 length);
+    bool receiveBatch(quint8 *data, quint32 length);
+    bool receiveSecure(const quint8 *frame);
+    bool processFrame(quint8 *frame);
     UAVObject *updateObject(quint32 objId, quint16 instId, quint8 *data);
     bool transmitNack(quint32 objId);
     bool transmitObject(UAVObject *obj, quint8 type, bool allInstances);
     bool transmitSingleObject(UAVObject *obj, quint8 type, bool allInstances);
     quint8 updateCRC(quint8 crc, const quint8 *data, qint32 length);
     bool transmitFrame(quint32 length, bool incrTxObj = true);
+    quint32 sealFrame(quint32 length);
 };
 
 #endif // UAVTALK_H
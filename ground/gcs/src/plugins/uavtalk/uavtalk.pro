@@ -15,13 +15,21 @@ HEADERS += uavtalk.h \
     uavtalkplugin.h \
     telemetrymonitor.h \
     telemetrymanager.h \
+    telemetryhub.h \
     uavtalk_global.h \
-    telemetry.h
+    telemetry.h \
+    blackboxdecoder.h \
+    aes128.h \
+    settingscache.h
 
 SOURCES += uavtalk.cpp \
     uavtalkplugin.cpp \
     telemetrymonitor.cpp \
     telemetrymanager.cpp \
-    telemetry.cpp
+    telemetryhub.cpp \
+    telemetry.cpp \
+    blackboxdecoder.cpp \
+    aes128.cpp \
+    settingscache.cpp
 
 OTHER_FILES += UAVTalk.pluginspec
@@ -58,6 +58,9 @@ bool UAVTalkPlugin::initialize(const QStringList &arguments, QString *errorStrin
     telMngr = new TelemetryManager();
     addAutoReleasedObject(telMngr);
 
+    // Shares the connection with other tools on this computer, if enabled
+    telHub = new TelemetryHub(objMngr, pm->getObject<Core::Internal::GeneralSettings>(), this);
+
     // Connect to connection manager so we get notified when the user connect to his device
     Core::ConnectionManager *cm = Core::ICore::instance()->connectionManager();
     QObject::connect(cm, &Core::ConnectionManager::deviceConnected, this,
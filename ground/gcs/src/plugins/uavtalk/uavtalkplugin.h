@@ -33,6 +33,7 @@
 #include "telemetry.h"
 #include "uavtalk.h"
 #include "telemetrymanager.h"
+#include "telemetryhub.h"
 #include "uavobjects/uavobjectmanager.h"
 
 class UAVTALK_EXPORT UAVTalkPlugin : public ExtensionSystem::IPlugin
@@ -55,6 +56,7 @@ protected slots:
 private:
     UAVObjectManager *objMngr;
     TelemetryManager *telMngr;
+    TelemetryHub *telHub;
 };
 
 #endif // UAVTALKPLUGIN_H
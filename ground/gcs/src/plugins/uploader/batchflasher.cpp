@@ -0,0 +1,203 @@
+/**
+ ******************************************************************************
+ * @file       batchflasher.cpp
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2017
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup  Uploader Uploader Plugin
+ * @{
+ * @brief Unattended flashing of many boards at once
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ * Additional note on redistribution: The copyright and license notices above
+ * must be maintained in each individual source file that is a derivative work
+ * of this source file; otherwise redistribution is prohibited.
+ */
+
+#include "batchflasher.h"
+#include "tl_dfu.h"
+
+#include <QDebug>
+#include <QFutureWatcher>
+#include <QtConcurrent>
+
+#include <coreplugin/boardmanager.h>
+#include <coreplugin/icore.h>
+#include <uavobjectutil/devicedescriptorstruct.h>
+#include <uavobjectutil/uavobjectutilmanager.h>
+
+using namespace uploader;
+using namespace tl_dfu;
+
+BatchFlasher::BatchFlasher(const QByteArray &firmware, const QByteArray &settings, int jobs,
+                           QObject *parent)
+    : QObject(parent)
+    , firmware(firmware)
+    , settings(settings)
+{
+    pool.setMaxThreadCount(qMax(1, jobs));
+
+    scanTimer.setInterval(1000);
+    connect(&scanTimer, &QTimer::timeout, this, &BatchFlasher::scan);
+}
+
+BatchFlasher::~BatchFlasher()
+{
+    scanTimer.stop();
+    pool.waitForDone();
+}
+
+/**
+ * @brief Whether the firmware image carries the description the bootloader
+ * needs alongside it
+ */
+bool BatchFlasher::isValid() const
+{
+    return firmware.right(100).startsWith("TlFw") || firmware.right(100).startsWith("OpFw");
+}
+
+/**
+ * @brief Starts watching for boards in the bootloader
+ */
+void BatchFlasher::start()
+{
+    // hidapi's global setup isn't safe to race from the pool threads
+    hid_init();
+
+    qInfo() << "[BatchFlasher] waiting for boards, flashing up to" << pool.maxThreadCount()
+            << "at once";
+
+    scanTimer.start();
+    scan();
+}
+
+void BatchFlasher::scan()
+{
+    Core::BoardManager *brdMgr = Core::ICore::instance()->boardManager();
+    QList<USBPortInfo> devices;
+
+    foreach (int vendorID, brdMgr->getKnownVendorIDs()) {
+        devices.append(
+            USBMonitor::instance()->availableDevices(vendorID, -1, -1, USBMonitor::Bootloader));
+    }
+
+    QSet<QString> present;
+    foreach (USBPortInfo port, devices)
+        present.insert(port.path);
+
+    // Forget boards that have left the bootloader, so they are flashed
+    // again if they come back
+    done.intersect(present);
+
+    foreach (USBPortInfo port, devices) {
+        if (busy.contains(port.path) || done.contains(port.path))
+            continue;
+
+        busy.insert(port.path);
+        qInfo() << "[BatchFlasher] flashing" << port.serialNumber << port.path;
+
+        QFutureWatcher<Result> *watcher = new QFutureWatcher<Result>(this);
+        connect(watcher, &QFutureWatcher<Result>::finished, this, [this, watcher]() {
+            Result result = watcher->result();
+            watcher->deleteLater();
+
+            busy.remove(result.path);
+            done.insert(result.path);
+
+            qInfo() << "[BatchFlasher]" << result.path << (result.success ? "OK" : "FAILED")
+                    << result.message;
+            emit boardFinished(result.path, result.success, result.message);
+        });
+        watcher->setFuture(
+            QtConcurrent::run(&pool, &BatchFlasher::flashBoard, port, firmware, settings));
+    }
+}
+
+/**
+ * @brief Flashes one board, on a pool thread
+ * @param port the board's bootloader
+ * @param firmware firmware image with its description at the end
+ * @param settings settings partition image, or empty to leave settings be
+ */
+BatchFlasher::Result BatchFlasher::flashBoard(USBPortInfo port, QByteArray firmware,
+                                              QByteArray settings)
+{
+    Result result;
+    result.path = port.path;
+    result.success = false;
+
+    DFUObject dfu;
+
+    if (!dfu.OpenBootloaderComs(port)) {
+        result.message = tr("Could not open bootloader");
+        return result;
+    }
+
+    device dev = dfu.findCapabilities();
+
+    deviceDescriptorStruct description;
+    if (!UAVObjectUtilManager::descriptionToStructure(firmware.right(100), description)) {
+        result.message = tr("Could not parse firmware metadata");
+        return result;
+    }
+
+    if ((dev.ID >> 8) != description.boardType) {
+        result.message = tr("Firmware is for a different board");
+        return result;
+    }
+
+    tl_dfu::Status status = dfu.UploadPartitionBlocking(firmware, DFU_PARTITION_FW, dev.SizeOfCode);
+    if (status != Last_operation_Success) {
+        result.message = tr("Firmware upload failed");
+        return result;
+    }
+
+    // As the uploader does, with the user defined field blanked
+    QByteArray descArray = firmware.right(100);
+    descArray.chop(12);
+    descArray.append(QByteArray(12, ' '));
+
+    status = dfu.UploadPartitionBlocking(descArray, DFU_PARTITION_DESC, 100);
+    if (status != Last_operation_Success) {
+        result.message = tr("Firmware metadata upload failed");
+        return result;
+    }
+
+    if (!settings.isEmpty()) {
+        if (dev.PartitionSizes.size() <= DFU_PARTITION_SETTINGS) {
+            result.message = tr("Bootloader can't write settings");
+            return result;
+        }
+
+        status = dfu.UploadPartitionBlocking(settings, DFU_PARTITION_SETTINGS,
+                                             dev.PartitionSizes.at(DFU_PARTITION_SETTINGS));
+        if (status != Last_operation_Success) {
+            result.message = tr("Settings upload failed");
+            return result;
+        }
+    }
+
+    dfu.JumpToApp(false);
+
+    result.success = true;
+    result.message = settings.isEmpty() ? tr("Flashed") : tr("Flashed with settings");
+    return result;
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,104 @@
+/**
+ ******************************************************************************
+ * @file       batchflasher.h
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2017
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup  Uploader Uploader Plugin
+ * @{
+ * @brief Unattended flashing of many boards at once
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ * Additional note on redistribution: The copyright and license notices above
+ * must be maintained in each individual source file that is a derivative work
+ * of this source file; otherwise redistribution is prohibited.
+ */
+
+#ifndef BATCHFLASHER_H
+#define BATCHFLASHER_H
+
+#include <QByteArray>
+#include <QObject>
+#include <QSet>
+#include <QString>
+#include <QThreadPool>
+#include <QTimer>
+
+#include <rawhid/usbmonitor.h>
+
+namespace uploader {
+
+/**
+ * Watches for boards sitting in the bootloader and flashes each one as it
+ * appears, several at a time.  Every board gets its own DFUObject on a pool
+ * thread, so one slow or failing board doesn't hold up the rest.
+ *
+ * After the firmware and its description, a settings partition image (as
+ * saved from a configured board with the partition browser) can be written
+ * too.  Restoring an XML settings export needs a telemetry connection to
+ * each board, and the GCS only ever has the one.
+ */
+class BatchFlasher : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Result
+    {
+        QString path;
+        bool success;
+        QString message;
+    };
+
+    BatchFlasher(const QByteArray &firmware, const QByteArray &settings, int jobs,
+                 QObject *parent = nullptr);
+    ~BatchFlasher();
+
+    bool isValid() const;
+
+public slots:
+    void start();
+
+signals:
+    void boardFinished(QString path, bool success, QString message);
+
+private slots:
+    void scan();
+
+private:
+    static Result flashBoard(USBPortInfo port, QByteArray firmware, QByteArray settings);
+
+    QByteArray firmware;
+    QByteArray settings;
+
+    QThreadPool pool;
+    QTimer scanTimer;
+
+    //! Boards being flashed
+    QSet<QString> busy;
+    //! Boards finished but still in the bootloader; flashed again only
+    //! once they have left it
+    QSet<QString> done;
+};
+
+} // namespace uploader
+
+#endif // BATCHFLASHER_H
+
+/**
+ * @}
+ * @}
+ */
@@ -62,6 +62,9 @@ enum bl_commands {
     BL_MSG_STATUS_REQ,
     BL_MSG_STATUS_REP,
     BL_MSG_WIPE_PARTITION,
+    BL_MSG_SECTOR_CRC_REQ,
+    BL_MSG_SECTOR_CRC_REP,
+    BL_MSG_WRITE_RANGE_START,
 
     BL_MSG_WRITE_START =
         0x27, // f1 bl masks with 0b11111 so this looks like BL_MSG_WRITE_CONT there
@@ -196,6 +199,35 @@ struct msg_wipe_partition
     uint8_t label;
 };
 
+PACK(struct msg_sector_crc_req {
+    uint8_t label;
+    uint8_t unused;
+    uint16_t first_sector;
+});
+
+#define SECTOR_CRCS_PER_PACKET 6
+PACK(struct msg_sector_crc_rep {
+    uint8_t label;
+    uint8_t num_sectors; /* 0 once past the end of the partition */
+    uint16_t first_sector;
+    uint32_t first_offset;
+    struct
+    {
+        uint32_t size;
+        uint32_t crc;
+    } sectors[SECTOR_CRCS_PER_PACKET];
+});
+
+/* Write part of a partition, erasing only the sectors it covers */
+PACK(struct msg_xfer_range_start {
+    uint32_t packets_in_transfer;
+    uint8_t label;
+    uint8_t words_in_last_packet;
+    uint32_t expected_crc; /* of the whole range, padded with 0xFF */
+    uint32_t start_offset; /* must be the start of a sector */
+    uint32_t length;
+});
+
 PACK(union msg_contents {
     struct msg_capabilities_req cap_req;
     struct msg_capabilities_rep_all cap_rep_all;
@@ -210,6 +242,9 @@ PACK(union msg_contents {
     struct msg_status_req status_req;
     struct msg_status_rep status_rep;
     struct msg_wipe_partition wipe_partition;
+    struct msg_sector_crc_req sector_crc_req;
+    struct msg_sector_crc_rep sector_crc_rep;
+    struct msg_xfer_range_start xfer_range_start;
     uint8_t pad[62];
 });
 
@@ -33,6 +33,7 @@
 
 #include <QApplication>
 #include <QThread>
+#include <QtEndian>
 
 #define TL_DFU_DEBUG
 #ifdef TL_DFU_DEBUG
@@ -45,6 +46,7 @@ using namespace tl_dfu;
 
 DFUObject::DFUObject()
     : m_hidHandle(NULL)
+    , m_capExt(false)
 {
     qRegisterMetaType<tl_dfu::Status>("TL_DFU::Status");
 }
@@ -103,6 +105,86 @@ bool DFUObject::StartUpload(qint32 const &numberOfBytes, dfu_partition_label con
     return false;
 }
 
+/**
+  Tells the board to get ready to rewrite part of a partition.  Only the
+  sectors covering the range are erased; as with StartUpload, query the
+  status to wait for the erase to finish.
+  @param offset start of the range, which must be the start of a sector
+  @param length bytes in the range, all of which the crc covers
+  @param numberOfBytes number of bytes that will actually be sent
+  @param label partition where the data will be uploaded to
+  @param crc crc value of the range, padded with 0xFF to length
+  @returns result of the requested operation
+  */
+bool DFUObject::StartRangeUpload(quint32 offset, quint32 length, qint32 const &numberOfBytes,
+                                 dfu_partition_label const &label, quint32 crc)
+{
+    messagePackets msg = CalculatePadding(numberOfBytes);
+    bl_messages message;
+    message.flags_command = BL_MSG_WRITE_RANGE_START;
+    message.v.xfer_range_start.expected_crc = ntohl(crc);
+    message.v.xfer_range_start.packets_in_transfer = ntohl(msg.numberOfPackets);
+    message.v.xfer_range_start.words_in_last_packet = msg.lastPacketCount;
+    message.v.xfer_range_start.label = label;
+    message.v.xfer_range_start.start_offset = ntohl(offset);
+    message.v.xfer_range_start.length = ntohl(length);
+
+    int result = SendData(message);
+    TL_DFU_QXTLOG_DEBUG(QString("Range 0x%0+0x%1: %2 bytes sent")
+                            .arg(offset, 0, 16)
+                            .arg(length, 0, 16)
+                            .arg(result));
+    return (result > 0);
+}
+
+/**
+  Asks the bootloader for the CRC of each sector of a partition.
+  @param partition the partition
+  @param sectors filled in with each sector's offset, size and crc
+  @returns false if the bootloader can't report them (older bootloaders
+  don't answer at all)
+  */
+bool DFUObject::SectorCRCs(dfu_partition_label partition, QVector<sectorCRC> &sectors)
+{
+    sectors.clear();
+
+    while (true) {
+        bl_messages message;
+        message.flags_command = BL_MSG_SECTOR_CRC_REQ;
+        message.v.sector_crc_req.label = partition;
+        message.v.sector_crc_req.unused = 0;
+        message.v.sector_crc_req.first_sector = ntohs((quint16)sectors.size());
+        if (SendData(message) < 1)
+            return false;
+
+        // CRCing a packet's worth of sectors takes a few milliseconds at
+        // most; no answer means the bootloader doesn't know the request
+        if (ReceiveData(message, 1000) < 1 || message.flags_command != BL_MSG_SECTOR_CRC_REP)
+            return false;
+
+        const msg_sector_crc_rep &rep = message.v.sector_crc_rep;
+        if (rep.label != partition || ntohs(rep.first_sector) != sectors.size()
+            || rep.num_sectors > SECTOR_CRCS_PER_PACKET)
+            return false;
+
+        if (rep.num_sectors == 0)
+            break;
+
+        quint32 offset = ntohl(rep.first_offset);
+        for (int i = 0; i < rep.num_sectors; ++i) {
+            sectorCRC sector;
+            sector.offset = offset;
+            sector.size = ntohl(rep.sectors[i].size);
+            sector.crc = ntohl(rep.sectors[i].crc);
+            sectors.append(sector);
+
+            offset += sector.size;
+        }
+    }
+
+    return !sectors.isEmpty();
+}
+
 /**
   Does the actual data upload to the board. Needs to be called once the
   board is ready to accept data following a StartUpload command, and it is erased.
@@ -124,7 +206,7 @@ bool DFUObject::UploadData(qint32 const &numberOfBytes, QByteArray &data)
         if (laspercentage != (int)percentage)
             emit operationProgress("", percentage);
         laspercentage = (int)percentage;
-        if (packetcount == msg.numberOfPackets)
+        if (packetcount == msg.numberOfPackets - 1)
             packetsize = msg.lastPacketCount;
         else
             packetsize = 14;
@@ -135,6 +217,21 @@ bool DFUObject::UploadData(qint32 const &numberOfBytes, QByteArray &data)
         int result = SendData(message);
         if (result < 1)
             return false;
+
+        // Packets are streamed without waiting on each one; the bootloader
+        // only fails the transfer, it never asks for a resend.  Check in
+        // once per window so a failed transfer stops here instead of after
+        // the whole image has gone out.
+        if (((packetcount + 1) % UploadWindowPackets) == 0
+            && (packetcount + 1) < msg.numberOfPackets) {
+            statusReport ret = StatusRequest();
+            if (ret.status != tl_dfu::uploading) {
+                TL_DFU_QXTLOG_DEBUG(QString("Upload stopped at packet %0, status %1")
+                                        .arg(packetcount)
+                                        .arg(StatusToString(ret.status)));
+                return false;
+            }
+        }
     }
     return true;
 }
@@ -422,6 +519,7 @@ device DFUObject::findCapabilities()
         currentDevice.CapExt = true;
     else
         currentDevice.CapExt = false;
+    m_capExt = currentDevice.CapExt;
     currentDevice.SizeOfDesc = message.v.cap_rep_specific.desc_size;
     currentDevice.ID = ntohs(message.v.cap_rep_specific.device_id);
     message.v.cap_rep_specific.device_number = 1;
@@ -552,6 +650,21 @@ bool DFUObject::UploadPartitionThreaded(QByteArray &sourceArray, dfu_partition_l
     return true;
 }
 
+/**
+  Uploads a partition to the board from the calling thread, for callers
+  that already run off the UI thread (e.g. the batch flasher)
+  @param sourceArray array containing the data to upload
+  @param partition destination partition
+  @param size size of the partition on the board
+  @returns status of the board after upload
+  */
+tl_dfu::Status DFUObject::UploadPartitionBlocking(QByteArray &sourceArray,
+                                                  dfu_partition_label partition, int size)
+{
+    threadJob.partition_size = size;
+    return UploadPartition(sourceArray, partition);
+}
+
 /**
   Synchronously uploads a partition to the board
   @param sourceArray array containing the data to upload
@@ -581,6 +694,10 @@ tl_dfu::Status DFUObject::UploadPartition(QByteArray &sourceArray, dfu_partition
         return tl_dfu::abort;
     }
 
+    if (partition == DFU_PARTITION_FW
+        && UploadPartitionDifferential(sourceArray, partition, ret.status))
+        return ret.status;
+
     quint32 crc = DFUObject::CRCFromQBArray(sourceArray, threadJob.partition_size);
     TL_DFU_QXTLOG_DEBUG(QString("NEW FIRMWARE CRC=%0").arg(crc));
 
@@ -643,6 +760,107 @@ tl_dfu::Status DFUObject::UploadPartition(QByteArray &sourceArray, dfu_partition
     return ret.status;
 }
 
+/**
+  Rewrites only the sectors of a partition that differ from sourceArray,
+  if the bootloader can tell us which those are.
+  @param sourceArray data to upload, a whole number of words
+  @param partition destination partition
+  @param status status of the board after the upload
+  @returns false if the bootloader can't do this, in which case nothing has
+  been written and the whole partition should be uploaded instead
+  */
+bool DFUObject::UploadPartitionDifferential(QByteArray &sourceArray, dfu_partition_label partition,
+                                            tl_dfu::Status &status)
+{
+    if (!m_capExt)
+        return false;
+
+    QVector<sectorCRC> sectors;
+    if (!SectorCRCs(partition, sectors)) {
+        TL_DFU_QXTLOG_DEBUG("No sector CRCs from bootloader, uploading whole partition");
+        return false;
+    }
+
+    const sectorCRC &last = sectors.last();
+    if ((quint64)last.offset + last.size < (quint64)sourceArray.length())
+        return false;
+
+    // The description sits in the firmware partition's last sector, and can
+    // only be written to erased flash.  It is always uploaded again after
+    // the firmware, so always rewrite that sector too.
+    QVector<bool> dirty(sectors.size());
+    int numDirty = 0;
+    for (int i = 0; i < sectors.size(); ++i) {
+        const sectorCRC &sector = sectors.at(i);
+        dirty[i] = (i == sectors.size() - 1)
+            || CRCFromQBArray(sourceArray.mid(sector.offset, sector.size), sector.size)
+                != sector.crc;
+        if (dirty[i])
+            ++numDirty;
+    }
+
+    TL_DFU_QXTLOG_DEBUG(QString("%0 of %1 sectors differ").arg(numDirty).arg(sectors.size()));
+    emit operationProgress(QString(tr("Updating %0 of %1 %2 sectors..."))
+                               .arg(numDirty)
+                               .arg(sectors.size())
+                               .arg(partitionStringFromLabel(partition)),
+                           -1);
+
+    // Write each run of differing sectors as one transfer
+    for (int i = 0; i < sectors.size();) {
+        if (!dirty[i]) {
+            ++i;
+            continue;
+        }
+
+        const quint32 start = sectors.at(i).offset;
+        quint32 length = 0;
+        for (; i < sectors.size() && dirty[i]; ++i)
+            length += sectors.at(i).size;
+
+        // Past the end of the image the sectors are left erased
+        QByteArray range = sourceArray.mid(start, length);
+        quint32 crc = CRCFromQBArray(range, length);
+
+        // An empty range still needs one packet to satisfy the protocol
+        if (range.isEmpty())
+            range = QByteArray(4, (char)0xFF);
+
+        if (!StartRangeUpload(start, length, range.length(), partition, crc)) {
+            status = StatusRequest().status;
+            return true;
+        }
+
+        statusReport ret = StatusRequest();
+        if (ret.status != tl_dfu::uploading) {
+            qDebug() << QString(
+                            "[tl_dfu] Couldn't start range upload, status: %1, additional: 0x%2")
+                            .arg(StatusToString(ret.status))
+                            .arg(ret.additional, 8, 16, QChar('0'));
+            status = ret.status;
+            return true;
+        }
+
+        if (!UploadData(range.length(), range) || !EndOperation()) {
+            status = StatusRequest().status;
+            return true;
+        }
+
+        ret = StatusRequest();
+        if (ret.status != tl_dfu::Last_operation_Success) {
+            qDebug() << QString("[tl_dfu] Range upload failed, status: %1, additional: 0x%2")
+                            .arg(StatusToString(ret.status))
+                            .arg(ret.additional, 8, 16, QChar('0'));
+            status = ret.status;
+            return true;
+        }
+    }
+
+    TL_DFU_QXTLOG_DEBUG("Differential upload succeeded");
+    status = tl_dfu::Last_operation_Success;
+    return true;
+}
+
 /**
   Copies one array into another inverting endianess
   @param source source array
@@ -695,45 +913,35 @@ quint32 DFUObject::CRC32WideFast(quint32 Crc, quint32 Size, quint32 *Buffer)
   Utility function
   Calculates the CRC value of an array after padding it to the format used with the bootloader
   */
-quint32 DFUObject::CRCFromQBArray(QByteArray array, quint32 Size)
+quint32 DFUObject::CRCFromQBArray(const QByteArray &array, quint32 Size)
 {
-    // If array is not an 32-bit word aligned file then
-    // pad out the end to make it so like the firmware
-    // expects
-    if (array.length() % 4 != 0) {
-        int pad = array.length() / 4;
-        ++pad;
-        pad = pad * 4;
-        pad = pad - array.length();
-        array.append(QByteArray(pad, 255));
-    }
-
-    // If the size is greater than the provided code then
-    // pad the end with 0xFF
-    if ((int)Size > array.length()) {
-        TL_DFU_QXTLOG_DEBUG("Padding");
-        quint32 pad = Size - array.length();
-        array.append(QByteArray(pad, 255));
+    // The bootloader CRCs the whole partition, so the image is treated as
+    // padded out with 0xFF to Size.  Work through it a block at a time
+    // rather than building a padded copy of the partition.
+    const quint32 words = Size / 4;
+    const quint32 have = qMin<quint32>(array.length(), words * 4);
+    const uchar *data = reinterpret_cast<const uchar *>(array.constData());
+
+    quint32 crc = 0xFFFFFFFF;
+    quint32 buf[256];
+    quint32 word = 0;
+
+    while (word < words) {
+        quint32 n = 0;
+        for (; n < 256 && word < words; ++n, ++word) {
+            const quint32 offset = word * 4;
+            if (offset + 4 <= have) {
+                buf[n] = qFromLittleEndian<quint32>(data + offset);
+            } else {
+                uchar tail[4] = { 0xFF, 0xFF, 0xFF, 0xFF };
+                if (offset < have)
+                    memcpy(tail, data + offset, have - offset);
+                buf[n] = qFromLittleEndian<quint32>(tail);
+            }
+        }
+        crc = DFUObject::CRC32WideFast(crc, n, buf);
     }
 
-    int maxSize = ((quint32)array.length() > Size) ? Size : array.length();
-
-    // Large firmwares require defining super large arrays,
-    // so better to malloc them.
-    quint32 *t = reinterpret_cast<quint32 *>(malloc(Size));
-    for (int x = 0; x < maxSize / 4; x++) {
-        quint32 aux = 0;
-        aux = (char)array[x * 4 + 3] & 0xFF;
-        aux = aux << 8;
-        aux += (char)array[x * 4 + 2] & 0xFF;
-        aux = aux << 8;
-        aux += (char)array[x * 4 + 1] & 0xFF;
-        aux = aux << 8;
-        aux += (char)array[x * 4 + 0] & 0xFF;
-        t[x] = aux;
-    }
-    quint32 crc = DFUObject::CRC32WideFast(0xFFFFFFFF, Size / 4, reinterpret_cast<quint32 *>(t));
-    free(t);
     return crc;
 }
 
@@ -90,8 +90,15 @@ class DFUObject : public QThread
         tl_dfu::Status status;
     } statusReport;
 
+    typedef struct sectorCRC
+    {
+        quint32 offset;
+        quint32 size;
+        quint32 crc;
+    } sectorCRC;
+
 public:
-    static quint32 CRCFromQBArray(QByteArray array, quint32 Size);
+    static quint32 CRCFromQBArray(const QByteArray &array, quint32 Size);
     DFUObject();
     ~DFUObject();
 
@@ -103,6 +110,8 @@ public:
 
     // Partition operations:
     bool UploadPartitionThreaded(QByteArray &sourceArray, dfu_partition_label partition, int size);
+    tl_dfu::Status UploadPartitionBlocking(QByteArray &sourceArray, dfu_partition_label partition,
+                                           int size);
     bool DownloadPartitionThreaded(QByteArray *firmwareArray, dfu_partition_label partition,
                                    int size);
     bool WipePartition(dfu_partition_label partition);
@@ -121,6 +130,8 @@ private:
     bool DownloadPartition(QByteArray *fw, qint32 const &numberOfBytes,
                            const dfu_partition_label &partition);
     tl_dfu::Status UploadPartition(QByteArray &sfile, dfu_partition_label partition);
+    bool UploadPartitionDifferential(QByteArray &sourceArray, dfu_partition_label partition,
+                                     tl_dfu::Status &status);
 
     // Helper functions:
     QString StatusToString(tl_dfu::Status const &status);
@@ -141,6 +152,16 @@ private:
 
     bool StartUpload(qint32 const &numberOfBytes, const dfu_partition_label &label, quint32 crc);
     bool UploadData(qint32 const &numberOfPackets, QByteArray &data);
+    bool SectorCRCs(dfu_partition_label partition, QVector<sectorCRC> &sectors);
+    bool StartRangeUpload(quint32 offset, quint32 length, qint32 const &numberOfBytes,
+                          dfu_partition_label const &label, quint32 crc);
+
+    // Set when the bootloader reports capability extensions, which all
+    // bootloaders that can write a range of a partition do
+    bool m_capExt;
+
+    // Packets sent between status checks during an upload
+    static const quint32 UploadWindowPackets = 512;
 
     typedef struct ThreadJobStruc
     {
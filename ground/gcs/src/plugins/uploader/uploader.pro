@@ -4,6 +4,7 @@ DEFINES += UPLOADER_LIBRARY
 QT += svg widgets
 QT += testlib
 QT += network
+QT += concurrent
 
 include(../../gcsplugin.pri)
 
@@ -23,14 +24,16 @@ HEADERS += uploadergadget.h \
     uploader_global.h \
     bl_messages.h \
     tl_dfu.h \
-    upgradeassistantdialog.h
+    upgradeassistantdialog.h \
+    batchflasher.h
 
 SOURCES += uploadergadget.cpp \
     uploadergadgetfactory.cpp \
     uploadergadgetwidget.cpp \
     uploaderplugin.cpp \
     upgradeassistantdialog.cpp \
-    tl_dfu.cpp
+    tl_dfu.cpp \
+    batchflasher.cpp
 
 OTHER_FILES += Uploader.pluginspec
 
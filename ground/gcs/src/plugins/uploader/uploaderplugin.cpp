@@ -26,13 +26,17 @@
  */
 #include "uploaderplugin.h"
 #include "uploadergadgetfactory.h"
+#include "batchflasher.h"
+#include <QDebug>
+#include <QFile>
 #include <QtPlugin>
 #include <QStringList>
 #include <extensionsystem/pluginmanager.h>
 #include <QTest>
 UploaderPlugin::UploaderPlugin()
+    : batchJobs(4)
+    , batchFlasher(nullptr)
 {
-    // Do nothing
 }
 
 UploaderPlugin::~UploaderPlugin()
@@ -42,8 +46,18 @@ UploaderPlugin::~UploaderPlugin()
 
 bool UploaderPlugin::initialize(const QStringList &args, QString *errMsg)
 {
-    Q_UNUSED(args);
     Q_UNUSED(errMsg);
+
+    // e.g. -p batchflash=fw_sparky2.tlfw -p batchjobs=8
+    for (int i = 0; i + 1 < args.length(); ++i) {
+        if (args.at(i) == "batchflash")
+            batchFirmwareFile = args.at(i + 1);
+        else if (args.at(i) == "batchsettings")
+            batchSettingsFile = args.at(i + 1);
+        else if (args.at(i) == "batchjobs")
+            batchJobs = args.at(i + 1).toInt();
+    }
+
     mf = new UploaderGadgetFactory(this);
     addAutoReleasedObject(mf);
     return true;
@@ -51,12 +65,40 @@ bool UploaderPlugin::initialize(const QStringList &args, QString *errMsg)
 
 void UploaderPlugin::extensionsInitialized()
 {
-    // Do nothing
+    if (batchFirmwareFile.isEmpty())
+        return;
+
+    QFile fwFile(batchFirmwareFile);
+    if (!fwFile.open(QIODevice::ReadOnly)) {
+        qWarning() << "[UploaderPlugin] can't read batch firmware" << batchFirmwareFile;
+        return;
+    }
+
+    QByteArray settings;
+    if (!batchSettingsFile.isEmpty()) {
+        QFile settingsFile(batchSettingsFile);
+        if (!settingsFile.open(QIODevice::ReadOnly)) {
+            qWarning() << "[UploaderPlugin] can't read batch settings" << batchSettingsFile;
+            return;
+        }
+        settings = settingsFile.readAll();
+    }
+
+    batchFlasher = new BatchFlasher(fwFile.readAll(), settings, batchJobs, this);
+    if (!batchFlasher->isValid()) {
+        qWarning() << "[UploaderPlugin]" << batchFirmwareFile << "is not a firmware image";
+        delete batchFlasher;
+        batchFlasher = nullptr;
+        return;
+    }
+
+    batchFlasher->start();
 }
 
 void UploaderPlugin::shutdown()
 {
-    // Do nothing
+    delete batchFlasher;
+    batchFlasher = nullptr;
 }
 
 void UploaderPlugin::testStuff()
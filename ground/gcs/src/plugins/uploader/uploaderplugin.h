@@ -47,6 +47,7 @@
 
 namespace uploader {
 class UploaderGadgetFactory;
+class BatchFlasher;
 }
 
 using namespace uploader;
@@ -65,6 +66,11 @@ public:
 
 private:
     UploaderGadgetFactory *mf;
+
+    QString batchFirmwareFile;
+    QString batchSettingsFile;
+    int batchJobs;
+    BatchFlasher *batchFlasher;
 private slots:
     void testStuff();
 };
@@ -68,7 +68,11 @@ bool UAVObjectGeneratorFlight::generate(UAVObjectParser *parser, QString templat
     for (int objidx = 0; objidx < parser->getNumObjects(); ++objidx) {
         ObjectInfo *info = parser->getObjectByIndex(objidx);
         process_object(info);
-        flightObjInit.append("    " + info->name + "Initialize();\r\n");
+        // Objects registered first are the ones that get the fast heap
+        if (info->isFastRam)
+            flightObjInit.prepend("    " + info->name + "Initialize();\r\n");
+        else
+            flightObjInit.append("    " + info->name + "Initialize();\r\n");
         objInc.append("#include \"" + info->namelc + ".h\"\r\n");
         objFileNames.append(" " + info->namelc);
         objNames.append(" " + info->name);
@@ -89,6 +93,13 @@ bool UAVObjectGeneratorFlight::generate(UAVObjectParser *parser, QString templat
 
     // Write the flight object initialization header
     flightInitIncludeTemplate.replace(QString("$(SIZECALCULATION)"), QString().setNum(sizeCalc));
+    // ... and how many objects there are, for sizing the ID index
+    int countPow2 = 1;
+    while (countPow2 < parser->getNumObjects())
+        countPow2 <<= 1;
+    flightInitIncludeTemplate.replace(QString("$(OBJCOUNT)"),
+                                      QString().setNum(parser->getNumObjects()));
+    flightInitIncludeTemplate.replace(QString("$(OBJCOUNTPOW2)"), QString().setNum(countPow2));
     res = writeFileIfDiffrent(flightOutputPath.absolutePath() + "/uavobjectsinit.h",
                               flightInitIncludeTemplate);
     if (!res) {
@@ -292,13 +303,13 @@ bool UAVObjectGeneratorFlight::process_object(ObjectInfo *info)
                             info->fields[n]->options.indexOf(info->fields[n]->defaultValues[0]);
 
                     initfields.append(
-                        QString("\tdata.%1 = %2;\r\n").arg(info->fields[n]->name).arg(defaultVal));
+                        QString("\t.%1 = %2,\r\n").arg(info->fields[n]->name).arg(defaultVal));
                 } else if (info->fields[n]->type == FIELDTYPE_FLOAT32) {
-                    initfields.append(QString("\tdata.%1 = %2;\r\n")
+                    initfields.append(QString("\t.%1 = %2,\r\n")
                                           .arg(info->fields[n]->name)
                                           .arg(info->fields[n]->defaultValues[0].toFloat()));
                 } else {
-                    initfields.append(QString("\tdata.%1 = %2;\r\n")
+                    initfields.append(QString("\t.%1 = %2,\r\n")
                                           .arg(info->fields[n]->name)
                                           .arg(info->fields[n]->defaultValues[0].toInt()));
                 }
@@ -314,17 +325,17 @@ bool UAVObjectGeneratorFlight::process_object(ObjectInfo *info)
                             defaultVal = info->fields[n]->options.indexOf(
                                 info->fields[n]->defaultValues[idx]);
 
-                        initfields.append(QString("\tdata.%1[%2] = %3;\r\n")
+                        initfields.append(QString("\t.%1[%2] = %3,\r\n")
                                               .arg(info->fields[n]->name)
                                               .arg(idx)
                                               .arg(defaultVal));
                     } else if (info->fields[n]->type == FIELDTYPE_FLOAT32) {
-                        initfields.append(QString("\tdata.%1[%2] = %3;\r\n")
+                        initfields.append(QString("\t.%1[%2] = %3,\r\n")
                                               .arg(info->fields[n]->name)
                                               .arg(idx)
                                               .arg(info->fields[n]->defaultValues[idx].toFloat()));
                     } else {
-                        initfields.append(QString("\tdata.%1[%2] = %3;\r\n")
+                        initfields.append(QString("\t.%1[%2] = %3,\r\n")
                                               .arg(info->fields[n]->name)
                                               .arg(idx)
                                               .arg(info->fields[n]->defaultValues[idx].toInt()));
@@ -356,6 +367,19 @@ bool UAVObjectGeneratorFlight::process_object(ObjectInfo *info)
                                         .arg(fieldTypeStrC[info->fields[n]->type]));
                 setgetfields.append(QString("}\r\n"));
 
+                /* Set if changed */
+                setgetfields.append(QString("void %2%3SetIfChanged( %1 *New%3 )\r\n")
+                                        .arg(fieldTypeStrC[info->fields[n]->type])
+                                        .arg(info->name)
+                                        .arg(info->fields[n]->name));
+                setgetfields.append(QString("{\r\n"));
+                setgetfields.append(QString("\tUAVObjSetDataFieldIfChanged(%1Handle(), (void *) New%2, "
+                                            "offsetof( %1Data, %2), sizeof(%3));\r\n")
+                                        .arg(info->name)
+                                        .arg(info->fields[n]->name)
+                                        .arg(fieldTypeStrC[info->fields[n]->type]));
+                setgetfields.append(QString("}\r\n"));
+
                 /* GET */
                 setgetfields.append(QString("void %2%3Get( %1 *New%3 )\r\n")
                                         .arg(fieldTypeStrC[info->fields[n]->type])
@@ -385,6 +409,20 @@ bool UAVObjectGeneratorFlight::process_object(ObjectInfo *info)
                                         .arg(fieldTypeStrC[info->fields[n]->type]));
                 setgetfields.append(QString("}\r\n"));
 
+                /* SET IF CHANGED */
+                setgetfields.append(QString("void %2%3SetIfChanged( %1 *New%3 )\r\n")
+                                        .arg(fieldTypeStrC[info->fields[n]->type])
+                                        .arg(info->name)
+                                        .arg(info->fields[n]->name));
+                setgetfields.append(QString("{\r\n"));
+                setgetfields.append(QString("\tUAVObjSetDataFieldIfChanged(%1Handle(), (void *) New%2, "
+                                            "offsetof( %1Data, %2), %3*sizeof(%4));\r\n")
+                                        .arg(info->name)
+                                        .arg(info->fields[n]->name)
+                                        .arg(info->fields[n]->numElements)
+                                        .arg(fieldTypeStrC[info->fields[n]->type]));
+                setgetfields.append(QString("}\r\n"));
+
                 /* GET */
                 setgetfields.append(QString("void %2%3Get( %1 *New%3 )\r\n")
                                         .arg(fieldTypeStrC[info->fields[n]->type])
@@ -415,6 +453,12 @@ bool UAVObjectGeneratorFlight::process_object(ObjectInfo *info)
                                           .arg(info->name)
                                           .arg(info->fields[n]->name));
 
+            /* SET IF CHANGED */
+            setgetfieldsextern.append(QString("extern void %2%3SetIfChanged( %1 *New%3 );\r\n")
+                                          .arg(fieldTypeStrC[info->fields[n]->type])
+                                          .arg(info->name)
+                                          .arg(info->fields[n]->name));
+
             /* GET */
             setgetfieldsextern.append(QString("extern void %2%3Get( %1 *New%3 );\r\n")
                                           .arg(fieldTypeStrC[info->fields[n]->type])
@@ -194,6 +194,7 @@ bool UAVObjectGeneratorGCS::process_object(ObjectInfo* info)
                             "{\n"
                             "   bool changed = data.%2[index] != value;\n"
                             "   data.%2[index] = value;\n"
+                            "   if (changed) markFieldDirty(&data.%2[index], sizeof(value));\n"
                             "   if (changed) emit %2Changed(index,value);\n"
                             "}\n\n")
                     .arg(info->name).arg(field->name).arg(type);
@@ -222,6 +223,7 @@ bool UAVObjectGeneratorGCS::process_object(ObjectInfo* info)
                                 "{\n"
                                 "   bool changed = data.%2[%5] != value;\n"
                                 "   data.%2[%5] = value;\n"
+                                "   if (changed) markFieldDirty(&data.%2[%5], sizeof(value));\n"
                                 "   if (changed) emit %2_%3Changed(value);\n"
                                 "}\n\n")
                         .arg(info->name).arg(field->name).arg(elementName).arg(type).arg(elementIndex);
@@ -253,6 +255,7 @@ bool UAVObjectGeneratorGCS::process_object(ObjectInfo* info)
                             "{\n"
                             "   bool changed = data.%2 != value;\n"
                             "   data.%2 = value;\n"
+                            "   if (changed) markFieldDirty(&data.%2, sizeof(value));\n"
                             "   if (changed) emit %2Changed(value);\n"
                             "}\n\n")
                     .arg(info->name).arg(field->name).arg(type);
@@ -342,7 +345,7 @@ bool UAVObjectGeneratorGCS::process_object(ObjectInfo* info)
 
             const QString defaultValuesInit = "\"" + info->fields[n]->defaultValues.join("\",\"") + "\"";
 
-            finit.append( QString("    fields.append( new UAVObjectField(QString(\"%1\"), QString(\"%2\"), UAVObjectField::ENUM, %3, %4, %5, QString(\"%6\"), FIELD_DESCRIPTIONS[\"%1\"], QList<QVariant>({%7})));\n")
+            finit.append( QString("    descriptors.append(UAVObjectField::createDescriptor(QString(\"%1\"), QString(\"%2\"), UAVObjectField::ENUM, %3, %4, %5, QString(\"%6\"), FIELD_DESCRIPTIONS[\"%1\"], QList<QVariant>({%7})));\n")
                           .arg(info->fields[n]->name)
                           .arg(info->fields[n]->units)
                           .arg(varElemName)
@@ -355,7 +358,7 @@ bool UAVObjectGeneratorGCS::process_object(ObjectInfo* info)
         else {
             const QString defaultValuesInit = info->fields[n]->defaultValues.join(',');
 
-            finit.append( QString("    fields.append( new UAVObjectField(QString(\"%1\"), QString(\"%2\"), UAVObjectField::%3, %4, QStringList(), QList<int>(), QString(\"%5\"), FIELD_DESCRIPTIONS[\"%1\"], QList<QVariant>({%7}), UAVObjectField::%8));\n")
+            finit.append( QString("    descriptors.append(UAVObjectField::createDescriptor(QString(\"%1\"), QString(\"%2\"), UAVObjectField::%3, %4, QStringList(), QList<int>(), QString(\"%5\"), FIELD_DESCRIPTIONS[\"%1\"], QList<QVariant>({%7}), UAVObjectField::%8));\n")
                           .arg(info->fields[n]->name)
                           .arg(info->fields[n]->units)
                           .arg(fieldTypeStrCPPClass[info->fields[n]->type])
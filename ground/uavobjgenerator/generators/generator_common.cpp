@@ -43,6 +43,10 @@ void replaceCommonTags(QString& out, ObjectInfo* info)
 
     accessModeStr << "ACCESS_READWRITE" << "ACCESS_READONLY";
 
+    QStringList telemetryPriorityStr;
+    telemetryPriorityStr << "TELEMETRYPRIORITY_NORMAL" << "TELEMETRYPRIORITY_HIGH"
+                         << "TELEMETRYPRIORITY_LOW";
+
     QString value;
 
     // replace the tags which don't need info 
@@ -72,6 +76,12 @@ void replaceCommonTags(QString& out, ObjectInfo* info)
     // Replace $(ISSETTINGS) tag
     out.replace(QString("$(ISSETTINGS)"), boolTo01String( info->isSettings ));
     out.replace(QString("$(ISSETTINGSTF)"), boolToTRUEFALSEString( info->isSettings ));    
+    // Replace $(ISFASTRAM) tag
+    out.replace(QString("$(ISFASTRAM)"), boolTo01String( info->isFastRam ));
+    // Replace $(ISREADMOSTLY) tag
+    out.replace(QString("$(ISREADMOSTLY)"), boolTo01String( info->isReadMostly ));
+    // Replace $(ISSUPPRESSUNCHANGED) tag
+    out.replace(QString("$(ISSUPPRESSUNCHANGED)"), boolTo01String( info->isSuppressUnchanged ));
     // Replace $(NUMBYTES) tag
     out.replace(QString("$(NUMBYTES)"), QString().setNum(info->numBytes));
     // Replace $(GCSACCESS) tag
@@ -88,6 +98,8 @@ void replaceCommonTags(QString& out, ObjectInfo* info)
     out.replace(QString("$(FLIGHTTELEM_UPDATEMODE)"), value);
     // Replace $(FLIGHTTELEM_UPDATEPERIOD) tag
     out.replace(QString("$(FLIGHTTELEM_UPDATEPERIOD)"), QString().setNum(info->flightTelemetryUpdatePeriod));
+    // Replace $(FLIGHTTELEM_PRIORITY) tag
+    out.replace(QString("$(FLIGHTTELEM_PRIORITY)"), telemetryPriorityStr[info->flightTelemetryPriority]);
     // Replace $(GCSTELEM_ACKED) tag
     out.replace(QString("$(GCSTELEM_ACKED)"),  boolTo01String( info->gcsTelemetryAcked ));
     out.replace(QString("$(GCSTELEM_ACKEDTF)"),  boolToTRUEFALSEString( info->gcsTelemetryAcked ));
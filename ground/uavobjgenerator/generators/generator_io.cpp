@@ -25,8 +25,15 @@
 
 #include "generator_io.h"
 
+#ifdef Q_OS_UNIX
+#include <unistd.h>
+#endif
+
 using namespace std;
 
+// Where output goes this run, with a trailing slash
+static QString outputRoot;
+
 /**
  * Read a file and return its contents as a string
  */
@@ -67,12 +74,82 @@ bool writeFile(QString name, QString& str)
     return true;
 }
 
+/**
+ * Set where output goes this run.  Output is generated to a directory per
+ * UAVO hash, and the directories in the current one link to the last.  A
+ * file that comes out the same as in the last output is hard linked to
+ * rather than written, so it keeps its timestamp and nothing depending on
+ * it gets rebuilt.
+ */
+void setOutputRoot(QString path)
+{
+    outputRoot = QDir(path).absolutePath() + "/";
+}
+
+/**
+ * Where a file was in the last output, or an empty string if there is none
+ */
+static QString previousOutput(QString name)
+{
+    QString path = QFileInfo(name).absoluteFilePath();
+
+    if (outputRoot.isEmpty() || !path.startsWith(outputRoot))
+        return QString();
+
+    // Split into the language directory and the rest
+    QString rel = path.mid(outputRoot.length());
+    int slash = rel.indexOf('/');
+
+    if (slash < 0)
+        return QString();
+
+    QString target = QFile::symLinkTarget(rel.left(slash));
+
+    if (target.isEmpty())
+        return QString();
+
+    return target + rel.mid(slash);
+}
+
+/**
+ * Hard link a file to the same one in the last output
+ */
+static bool linkPrevious(QString name, QString& str)
+{
+#ifdef Q_OS_UNIX
+    QString prev = previousOutput(name);
+
+    if (prev.isEmpty() || str != readFile(prev, false))
+        return false;
+
+    QFile::remove(name);
+
+    return link(QFile::encodeName(prev).constData(),
+                QFile::encodeName(name).constData()) == 0;
+#else
+    Q_UNUSED(name);
+    Q_UNUSED(str);
+    return false;
+#endif
+}
+
 /**
  * Write contents of string to file if the content changes
  */
 bool writeFileIfDiffrent(QString name, QString& str)
 {
-    if (str==readFile(name,false))
+    if (str==readFile(name,false)) {
+        // Going back to an older output, what changed since the last
+        // one must look newer than what was built from that
+        QString prev = previousOutput(name);
+        if (prev.isEmpty() || str==readFile(prev,false))
+            return true;
+        QFile::remove(name);
+        return writeFile(name,str);
+    }
+    if (linkPrevious(name,str))
         return true;
+    // It may be linked to the last output, which has to stay as it is
+    QFile::remove(name);
     return writeFile(name,str);
 }
@@ -31,11 +31,13 @@
 #include <QFile>
 #include <QTextStream>
 #include <QDir>
+#include <QFileInfo>
 #include <iostream>
 
 QString readFile(QString name);
 QString readFile(QString name);
 bool writeFile(QString name, QString& str);
 bool writeFileIfDiffrent(QString name, QString& str);
+void setOutputRoot(QString path);
 
 #endif
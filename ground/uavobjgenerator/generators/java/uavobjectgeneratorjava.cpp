@@ -207,6 +207,49 @@ bool UAVObjectGeneratorJava::process_object(ObjectInfo* info)
 
     outCode.replace(QString("$(INITFIELDS)"), initfields);
 
+    // Replace the $(FIELDACCESSORS) tag; these go through the field index
+    // and primitive values, so neither a name lookup nor boxing is needed
+    QString accessors;
+    for (int n = 0; n < info->fields.length(); ++n)
+    {
+        QString name = info->fields[n]->name;
+        QString type;
+        QString getter;
+        switch (info->fields[n]->type) {
+        case FIELDTYPE_UINT32:
+            type = "long";
+            getter = "getLong";
+            break;
+        case FIELDTYPE_FLOAT32:
+            type = "float";
+            getter = "getFloat";
+            break;
+        default:
+            // Enums give the index of the option
+            type = "int";
+            getter = "getInt";
+        }
+
+        accessors.append( QString("\tpublic static final int FIELD_%1 = %2;\n\n")
+                          .arg( name.toUpper() )
+                          .arg( n ) );
+        accessors.append( QString("\tpublic %1 get%2(int index) {\n"
+                                  "\t\treturn getField(FIELD_%3).%4(index);\n"
+                                  "\t}\n\n")
+                          .arg( type )
+                          .arg( name )
+                          .arg( name.toUpper() )
+                          .arg( getter ) );
+        accessors.append( QString("\tpublic void set%1(%2 value, int index) {\n"
+                                  "\t\tgetField(FIELD_%3).setDouble(value, index);\n"
+                                  "\t}\n\n")
+                          .arg( name )
+                          .arg( type )
+                          .arg( name.toUpper() ) );
+    }
+
+    outCode.replace(QString("$(FIELDACCESSORS)"), accessors);
+
     // Write the java code
     bool res = writeFileIfDiffrent( javaOutputPath.absolutePath() + "/" + info->name + ".java", outCode );
     if (!res) {
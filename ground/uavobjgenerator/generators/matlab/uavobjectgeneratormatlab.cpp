@@ -51,8 +51,7 @@ bool UAVObjectGeneratorMatlab::generate(UAVObjectParser* parser,QString template
     }
 
     matlabCodeTemplate.replace( QString("$(INSTANTIATIONCODE)"), matlabInstantiationCode);
-    matlabCodeTemplate.replace( QString("$(SWITCHCODE)"), matlabSwitchCode);
-    matlabCodeTemplate.replace( QString("$(CLEANUPCODE)"), matlabCleanupCode);
+    matlabCodeTemplate.replace( QString("$(GROUPCODE)"), matlabGroupCode);
     matlabCodeTemplate.replace( QString("$(SAVEOBJECTSCODE)"), matlabSaveObjectsCode);
     matlabCodeTemplate.replace( QString("$(ALLOCATIONCODE)"), matlabAllocationCode);
     matlabCodeTemplate.replace( QString("$(EXPORTCSVCODE)"), matlabExportCsvCode);
@@ -110,28 +109,16 @@ bool UAVObjectGeneratorMatlab::process_object(ObjectInfo* info, int numBytes)
     matlabInstantiationCode.append("\t" + objectTableName.toUpper() + "_NUMBYTES=" + numBytesString + ";\n");
     matlabInstantiationCode.append("\t" + objectName + "FidIdx = [];\n");
     matlabInstantiationCode.append("\n\tmultipleInstanceLookup(end+1,:) = [" + objectID + ", " + (info->isSingleInst ? "true" : "false") + "];\n");
-
-    //==============================================================//
-    // Generate 'Switch:' code (will replace the $(SWITCHCODE) tag) //
-    //==============================================================//
-    matlabSwitchCode.append("\t\tcase " + objectTableName.toUpper() + "_OBJID\n");
-    matlabSwitchCode.append("\t\t\tif buffer_len >= bufferIdx + " +  objectTableName.toUpper() + "_NUMBYTES+1;\n");
-    matlabSwitchCode.append("\t\t\t\t" + tableIdxName + " = " + tableIdxName +" + 1;\n");
-    matlabSwitchCode.append("\t\t\t\t" + objectTableName + "FidIdx(" + tableIdxName + ") = bufferIdx; %#ok<*AGROW>\n");
-    matlabSwitchCode.append("\t\t\t\t" + objectTableName + ".timestamp(" + tableIdxName + ") = timestamp; %#ok<*AGROW>\n");
-    matlabSwitchCode.append("\t\t\t\tbufferIdx=bufferIdx + " +  objectTableName.toUpper() + "_NUMBYTES+1; %+1 is for CRC\n");
-    if(!info->isSingleInst){
-        matlabSwitchCode.append("\t\t\t\tbufferIdx = bufferIdx + 2; %An extra two bytes for the instance ID\n");
-    }
-    matlabSwitchCode.append("\t\t\t\tif " + tableIdxName + " >= length(" + objectTableName +"FidIdx) %Check to see if pre-allocated memory is exhausted\n");
-    matlabSwitchCode.append("\t\t\t\t\t" + objectTableName + "FidIdx(" + tableIdxName + "*2) = 0;\n");
-    matlabSwitchCode.append("\t\t\t\tend\n\t\t\tend\n");
-
+    matlabInstantiationCode.append("\tuavoNumBytes(end+1,1) = " + objectTableName.toUpper() + "_NUMBYTES;\n");
+    matlabInstantiationCode.append("\t" + objectTableName.toUpper() + "_IDX = size(multipleInstanceLookup,1);\n");
 
     //============================================================//
-    // Generate 'Cleanup:' code (will replace the $(CLEANUP) tag) //
+    // Generate grouping code (will replace the $(GROUPCODE) tag) //
     //============================================================//
-    matlabCleanupCode.append(objectTableName + "FidIdx =" + objectTableName + "FidIdx(1:" + tableIdxName +");\n" );
+    matlabGroupCode.append("rows = groupStart(" + objectTableName.toUpper() + "_IDX):groupEnd(" + objectTableName.toUpper() + "_IDX);\n");
+    matlabGroupCode.append(objectTableName + "FidIdx = packetFidIdx(rows);\n");
+    matlabGroupCode.append(objectTableName + ".timestamp = packetTimestamp(rows)';\n");
+
 
     //=================================================================//
     // Generate functions code (will replace the $(ALLOCATIONCODE) tag) //
@@ -145,8 +132,7 @@ bool UAVObjectGeneratorMatlab::process_object(ObjectInfo* info, int numBytes)
     //Add Instance ID, if necessary
     if(!info->isSingleInst){
         allocationFields.append("\t" + objectName + ".instanceID = " +
-                          "double(typecast(buffer(mcolon(" + objectName + "FidIdx + instanceIdOffset "
-                          ", " + objectName + "FidIdx  + instanceIdOffset + 2-1)), 'uint16'))';\n");
+                          "gatherValues(buffer, " + objectName + "FidIdx + instanceIdOffset, 'uint16', 1);\n");
         currentIdx+=2;
     }
 
@@ -157,16 +143,9 @@ bool UAVObjectGeneratorMatlab::process_object(ObjectInfo* info, int numBytes)
         //Determine variable type length
         QString size = fieldSizeStrMatlab[info->fields[n]->type];
         // Append field
-        if ( info->fields[n]->numElements > 1 ){
-            allocationFields.append("\t" + objectName + "." + info->fields[n]->name + " = " +
-                              "reshape(double(typecast(buffer(mcolon(" + objectName + "FidIdx + " + QString("%1").arg(currentIdx) +
-                              ", " + objectName + "FidIdx + " + QString("%1").arg(currentIdx + size.toInt()*info->fields[n]->numElements - 1) + ")), '" + type + "')), "+ QString::number(info->fields[n]->numElements, 10) + ", [] );\n");
-        }
-        else{
-            allocationFields.append("\t" + objectName + "." + info->fields[n]->name + " = " +
-                              "double(typecast(buffer(mcolon(" + objectName + "FidIdx + " + QString("%1").arg(currentIdx) +
-                              ", " + objectName + "FidIdx + " + QString("%1").arg(currentIdx + size.toInt() - 1) + ")), '" + type + "'))';\n");
-        }
+        allocationFields.append("\t" + objectName + "." + info->fields[n]->name + " = " +
+                          "gatherValues(buffer, " + objectName + "FidIdx + " + QString("%1").arg(currentIdx) +
+                          ", '" + type + "', " + QString::number(info->fields[n]->numElements, 10) + ");\n");
         currentIdx+=size.toInt()*info->fields[n]->numElements;
     }
     matlabAllocationCode.append(allocationFields);
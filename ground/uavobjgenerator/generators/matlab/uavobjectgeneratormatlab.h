@@ -36,8 +36,7 @@ public:
 private:
     bool process_object(ObjectInfo* info, int numBytes);
     QString matlabInstantiationCode;
-    QString matlabSwitchCode;
-    QString matlabCleanupCode;
+    QString matlabGroupCode;
     QString matlabAllocationCode;
     QString matlabSaveObjectsCode;
     QString matlabExportCsvCode;
@@ -27,6 +27,7 @@
 #include <QFile>
 #include <QString>
 #include <QStringList>
+#include <QtConcurrent>
 #include <iostream>
 
 #include "generators/java/uavobjectgeneratorjava.h"
@@ -222,44 +223,59 @@ int main(int argc, char *argv[])
     if (do_none)
       return RETURN_OK;
 
+    // Languages only share the parser, which they just read, so they're
+    // generated side by side
+    setOutputRoot(outputpath);
+    QDir().mkpath(outputpath);
+
+    QList<QFuture<bool> > jobs;
+    UAVObjectGeneratorFlight flightgen;
+    UAVObjectGeneratorGCS gcsgen;
+    UAVObjectGeneratorJava javagen;
+    UAVObjectGeneratorMatlab matlabgen;
+    UAVObjectGeneratorWireshark wiresharkgen;
+
     // generate flight code if wanted
     if (do_flight|do_all) {
         cout << "generating flight code" << endl ;
-        UAVObjectGeneratorFlight flightgen;
-        flightgen.generate(parser,templatepath,outputpath);
+        jobs << QtConcurrent::run(&flightgen, &UAVObjectGeneratorFlight::generate,
+                parser, templatepath, outputpath);
     }
 
     // generate gcs code if wanted
     if (do_gcs|do_all) {
         cout << "generating gcs code" << endl ;
-        UAVObjectGeneratorGCS gcsgen;
-        gcsgen.generate(parser,templatepath,outputpath);
+        jobs << QtConcurrent::run(&gcsgen, &UAVObjectGeneratorGCS::generate,
+                parser, templatepath, outputpath);
     }
 
     // generate java code if wanted
     if (do_java|do_all) {
         cout << "generating java code" << endl ;
-        UAVObjectGeneratorJava javagen;
-        javagen.generate(parser,templatepath,outputpath);
+        jobs << QtConcurrent::run(&javagen, &UAVObjectGeneratorJava::generate,
+                parser, templatepath, outputpath);
     }
 
     // generate matlab code if wanted
     if (do_matlab|do_all) {
         cout << "generating matlab code" << endl ;
-        UAVObjectGeneratorMatlab matlabgen;
-        matlabgen.generate(parser,templatepath,outputpath);
+        jobs << QtConcurrent::run(&matlabgen, &UAVObjectGeneratorMatlab::generate,
+                parser, templatepath, outputpath);
     }
 
     // generate wireshark plugin if wanted
     if (do_wireshark|do_all) {
         cout << "generating wireshark code" << endl ;
-        UAVObjectGeneratorWireshark wiresharkgen;
-        wiresharkgen.generate(parser,templatepath,outputpath);
+        jobs << QtConcurrent::run(&wiresharkgen, &UAVObjectGeneratorWireshark::generate,
+                parser, templatepath, outputpath);
     }
 
-    bool changed = false;
+    foreach (QFuture<bool> job, jobs)
+        job.waitForFinished();
 
-    /* Symlink each of these to the current dir */
+    /* Symlink each of these to the current dir.  Files that changed
+     * since the last output were written newer than anything built from
+     * it, so make rebuilds just what depends on them. */
     QDir dir(outputpath);
     QFileInfoList files = dir.entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot);
     foreach (QFileInfo file, files) {
@@ -271,19 +287,10 @@ int main(int argc, char *argv[])
         if (QFile::symLinkTarget(file.fileName()) != file.absoluteFilePath()) {
             QFile::remove(file.fileName());
             QFile::link(file.absoluteFilePath(), file.fileName());
-            changed = true;
         }
 #endif
     }
 
-    /* If anything has changed, ensure flight stuff gets rebuilt */
-    if (changed) {
-        cout << "UAVO version updated, forcing rebuild of all" << endl ;
-        QFile touch(QString("flight/uavoversion.h"));
-        /* This updates the file modification time, so make knows */
-        touch.resize(touch.size());
-    }
-
     return RETURN_OK;
 }
 
@@ -48,6 +48,8 @@ UAVObjectParser::UAVObjectParser()
 
     accessModeStrXML << "readwrite" << "readonly";
 
+    telemetryPriorityStrXML << "normal" << "high" << "low";
+
     displayTypeStrXML << "dec" << "hex" << "bin" << "oct";
 }
 
@@ -384,6 +386,8 @@ QString UAVObjectParser::parseXML(QString& xml, QString& filename)
             else if ( childNode.nodeName().compare(QString("telemetryflight")) == 0 ) {
                 QString status = processObjectMetadata(childNode, &info->flightTelemetryUpdateMode,
                                                        &info->flightTelemetryUpdatePeriod, &info->flightTelemetryAcked);
+                if (status.isNull())
+                    status = processObjectPriority(childNode, &info->flightTelemetryPriority);
                 if (!status.isNull())
                     return genErrorMsg(filename, status,
                             childNode.lineNumber(), childNode.columnNumber());
@@ -598,6 +602,28 @@ QString UAVObjectParser::processObjectMetadata(QDomNode& childNode, UpdateMode*
     return QString();
 }
 
+/**
+ * Process the optional priority attribute of the flight telemetry metadata
+ */
+QString UAVObjectParser::processObjectPriority(QDomNode& childNode, TelemetryPriority* priority)
+{
+    QDomNode elemAttr = childNode.attributes().namedItem("priority");
+
+    if ( elemAttr.isNull() ) {
+        *priority = TELEMETRYPRIORITY_NORMAL;
+        return QString();
+    }
+
+    int index = telemetryPriorityStrXML.indexOf( elemAttr.nodeValue() );
+
+    if (index<0)
+        return QString("Object:telemetryflight:priority attribute value is invalid");
+
+    *priority = (TelemetryPriority)index;
+
+    return QString();
+}
+
 /**
  * Process the object access tag of the XML
  */
@@ -876,6 +902,43 @@ QString UAVObjectParser::processObjectAttributes(QDomNode& node, ObjectInfo* inf
     if ( info->isSettings && !info->isSingleInst )
         return QString("Object: Settings objects can not have multiple instances");
 
+    // Get fastram attribute (optional). Only affects where the flight side
+    // keeps the data, so it's deliberately left out of the object ID.
+    attr = attributes.namedItem("fastram");
+    if ( attr.isNull() || attr.nodeValue().compare(QString("false")) == 0 )
+        info->isFastRam = false;
+    else if ( attr.nodeValue().compare(QString("true")) == 0 )
+        info->isFastRam = true;
+    else
+        return QString("Object:fastram attribute value is invalid");
+
+    // Settings are kept out of fast RAM on purpose
+    if ( info->isSettings && info->isFastRam )
+        return QString("Object: Settings objects can not be placed in fast RAM");
+
+    // Get readmostly attribute (optional). Like fastram, only affects where
+    // the flight side keeps the data.
+    attr = attributes.namedItem("readmostly");
+    if ( attr.isNull() || attr.nodeValue().compare(QString("false")) == 0 )
+        info->isReadMostly = false;
+    else if ( attr.nodeValue().compare(QString("true")) == 0 )
+        info->isReadMostly = true;
+    else
+        return QString("Object:readmostly attribute value is invalid");
+
+    if ( info->isReadMostly && !info->isSettings )
+        return QString("Object: Only settings objects can be read-mostly");
+
+    // Get suppressunchanged attribute (optional). Setting the flight side
+    // object to what it already holds then doesn't send out an update.
+    attr = attributes.namedItem("suppressunchanged");
+    if ( attr.isNull() || attr.nodeValue().compare(QString("false")) == 0 )
+        info->isSuppressUnchanged = false;
+    else if ( attr.nodeValue().compare(QString("true")) == 0 )
+        info->isSuppressUnchanged = true;
+    else
+        return QString("Object:suppressunchanged attribute value is invalid");
+
     // Done
     return QString();
 }
@@ -103,6 +103,12 @@ typedef enum {
     ACCESS_READONLY = 1
 } AccessMode;
 
+typedef enum {
+    TELEMETRYPRIORITY_NORMAL = 0,
+    TELEMETRYPRIORITY_HIGH = 1,
+    TELEMETRYPRIORITY_LOW = 2
+} TelemetryPriority;
+
 struct ObjectInfo_s {
     QString name;
     QString namelc; /** name in lowercase */
@@ -110,11 +116,15 @@ struct ObjectInfo_s {
     quint32 id;
     bool isSingleInst;
     bool isSettings;
+    bool isFastRam; /** Placed in fast RAM ahead of other objects on the flight side **/
+    bool isReadMostly; /** Left in flash on the flight side until it is changed **/
+    bool isSuppressUnchanged; /** Sets that change nothing send no update on the flight side **/
     AccessMode gcsAccess;
     AccessMode flightAccess;
     bool flightTelemetryAcked;
     UpdateMode flightTelemetryUpdateMode; /** Update mode used by the autopilot (UpdateMode) */
     int flightTelemetryUpdatePeriod; /** Update period used by the autopilot (only if telemetry mode is PERIODIC) */
+    TelemetryPriority flightTelemetryPriority; /** Priority class used by the autopilot telemetry scheduler */
     bool gcsTelemetryAcked;
     UpdateMode gcsTelemetryUpdateMode; /** Update mode used by the GCS (UpdateMode) */
     int gcsTelemetryUpdatePeriod; /** Update period used by the GCS (only if telemetry mode is PERIODIC) */
@@ -160,6 +170,7 @@ private:
     QStringList updateModeStrXML;
     QStringList accessModeStr;
     QStringList accessModeStrXML;
+    QStringList telemetryPriorityStrXML;
     quint64 uavoHash;
     QStringList displayTypeStrXML;
 
@@ -171,6 +182,7 @@ private:
     QString processObjectDescription(QDomNode& childNode, QString * description);
     QString processObjectCategory(QDomNode& childNode, QString * category);
     QString processObjectMetadata(QDomNode& childNode, UpdateMode* mode, int* period, bool* acked);
+    QString processObjectPriority(QDomNode& childNode, TelemetryPriority* priority);
     void calculateID(ObjectInfo* info);
     void calculateSize(ObjectInfo* info);
     quint32 updateHash(quint32 value, quint32 hash);
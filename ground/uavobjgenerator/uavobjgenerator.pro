@@ -1,6 +1,7 @@
 include(../tools.pri)
 
 QT += xml
+QT += concurrent
 QT -= gui
 
 macx {
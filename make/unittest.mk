@@ -41,6 +41,11 @@ LDFLAGS += -fprofile-arcs
 # gcov requires specific compile options to enable the profiling hooks
 GCOV_CFLAGS := -fprofile-arcs -ftest-coverage
 
+# Benchmarks time the code under test, so leave it uninstrumented
+ifeq ($(UT_NO_COVERAGE),1)
+GCOV_CFLAGS :=
+endif
+
 
 #################################
 #
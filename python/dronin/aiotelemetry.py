@@ -0,0 +1,575 @@
+"""
+Telemetry over asyncio, for keeping many links open from one thread.
+
+Each connection is an AsyncTelemetry, which is the asyncio protocol for its
+transport: TCP (flightd, or the GCS's telemetry hub), UDP, or a serial port.
+Connections share the parsed UAVO definitions for a githash, so watching a
+fleet costs one set of classes; each still has its own UAVTalk decoder.
+Received objects go to callbacks and/or an asyncio.Queue as they arrive.
+
+    async def watch(addrs):
+        queue = asyncio.Queue()
+
+        for host, port in addrs:
+            await aiotelemetry.open_tcp(host, port, queue=queue)
+
+        while True:
+            telem, obj = await queue.get()
+            print(telem.name, obj)
+
+Copyright (C) 2018 dRonin, http://dronin.org
+Licensed under the GNU LGPL version 2.1 or any later version (see COPYING.LESSER)
+"""
+
+import asyncio
+import os
+import time
+
+from . import uavtalk, uavo_collection
+
+import logging
+
+logger = logging.getLogger(__name__)
+
+# Parsed definitions, by githash (None for the ones in this source tree)
+_uavo_defs_cache = {}
+
+def get_uavo_defs(githash=None):
+    """ Returns the UAVO definitions for githash, parsing them only once. """
+    uavo_defs = _uavo_defs_cache.get(githash)
+
+    if uavo_defs is None:
+        uavo_defs = uavo_collection.UAVOCollection()
+
+        if githash:
+            uavo_defs.from_git_hash(githash)
+        else:
+            xml_path = os.path.join(os.path.dirname(__file__), "..", "..",
+                                    "shared", "uavobjectdefinition")
+            uavo_defs.from_uavo_xml_path(xml_path)
+
+        _uavo_defs_cache[githash] = uavo_defs
+
+    return uavo_defs
+
+class AsyncTelemetry(asyncio.Protocol, asyncio.DatagramProtocol):
+    """
+    One telemetry link, serviced by the event loop it was opened on.
+
+    Normally made by open_tcp, open_udp or open_serial rather than directly.
+    """
+
+    # Same timing as TelemetryBase
+    REQ_RETRIES = 4
+    REQ_RETRY_TIME = 0.5
+    ACK_TRIES = 8
+    ACK_WAIT = 0.26
+    SERVICE_PERIOD = 0.15
+
+    def __init__(self, githash=None, uavo_defs=None, use_walltime=True,
+            do_handshaking=True, name=None, callback=None, queue=None):
+        """ Instantiates a telemetry link, not yet connected to anything.
+
+         - githash: revision control id of the UAVO's used to communicate.
+             if unspecified, we use the version in this source tree.
+         - uavo_defs: a UAVOCollection to use instead of the one for githash
+         - use_walltime: if true, automatically place current time into
+             packets received.
+         - do_handshaking: if true, speak the UAVO_GCSTelemetryStats
+             connection status protocol.  Without it, the link only listens.
+         - name: a name for the link, for logging and for telling apart
+             objects from different links
+         - callback: called as callback(telem, obj) for each object received
+         - queue: an asyncio.Queue that gets a (telem, obj) tuple for each
+             object received
+        """
+
+        if uavo_defs is None:
+            uavo_defs = get_uavo_defs(githash)
+
+        self.uavo_defs = uavo_defs
+        self.githash = githash
+        self.name = name
+        self.do_handshaking = do_handshaking
+
+        self.uavtalk_generator = uavtalk.process_stream(uavo_defs,
+            use_walltime=use_walltime, gcs_timestamps=False,
+            ack_callback=self._gotack_callback,
+            nack_callback=self._gotnack_callback,
+            reqack_callback=self._reqack_callback)
+
+        # Kick the generator off to a sane start.
+        self.uavtalk_generator.send(None)
+
+        self.callbacks = []
+
+        if callback is not None:
+            self.callbacks.append(callback)
+
+        self.queue = queue
+
+        self.last_values = {}
+
+        self.transport = None
+        self.datagram = False
+
+        # Futures waiting on an ack, by object class
+        self.ack_waiters = {}
+        # Outstanding requests, by (object id, instance id)
+        self.req_obj = {}
+        # Futures waiting for the handshake to complete
+        self.connect_waiters = []
+
+        self.eof = False
+        self.closed = None
+
+        self.service_task = None
+
+        self.GCSTelemetryStats = uavo_defs.find_by_name('UAVO_GCSTelemetryStats')
+        self.FlightTelemetryStats = uavo_defs.find_by_name('UAVO_FlightTelemetryStats')
+
+    # asyncio protocol interface
+
+    def connection_made(self, transport):
+        loop = asyncio.get_event_loop()
+
+        self.transport = transport
+        # Datagram transports from the loop don't all derive from
+        # DatagramTransport, but they all have sendto
+        self.datagram = hasattr(transport, 'sendto')
+        self.closed = loop.create_future()
+
+        if self.do_handshaking:
+            self._send(uavtalk.send_object(self.__make_handshake('Disconnected')))
+
+        self.service_task = loop.create_task(self._service())
+
+    def data_received(self, data):
+        self.__handle_frames(data)
+
+    def datagram_received(self, data, addr):
+        self.__handle_frames(data)
+
+    def error_received(self, exc):
+        logger.warning("%s: %s" % (self.name, exc))
+
+    def connection_lost(self, exc):
+        if exc is not None:
+            logger.warning("%s: connection lost: %s" % (self.name, exc))
+
+        self.eof = True
+
+        if self.service_task is not None:
+            self.service_task.cancel()
+
+        # Nothing more is coming for anyone still waiting
+        for req in self.req_obj.values():
+            req.completed(None)
+
+        self.req_obj.clear()
+
+        for waiters in self.ack_waiters.values():
+            for fut in waiters:
+                if not fut.done():
+                    fut.set_result(False)
+
+        self.ack_waiters.clear()
+
+        for fut in self.connect_waiters:
+            if not fut.done():
+                fut.set_exception(ConnectionError("telemetry link closed"))
+
+        self.connect_waiters = []
+
+        if self.closed is not None and not self.closed.done():
+            self.closed.set_result(None)
+
+    # Public interface
+
+    def add_callback(self, callback):
+        """ Calls callback(telem, obj) for each object received from now on. """
+        self.callbacks.append(callback)
+
+    def remove_callback(self, callback):
+        self.callbacks.remove(callback)
+
+    def get_last_values(self):
+        """ Returns the last instance of each kind of object received. """
+        return self.last_values.copy()
+
+    def is_connected(self):
+        fts = self.last_values.get(self.FlightTelemetryStats)
+
+        return fts is not None and fts.Status == fts.ENUM_Status['Connected']
+
+    async def wait_connection(self):
+        """ Waits for the connection handshaking to complete. """
+        if self.is_connected():
+            return
+
+        if self.eof:
+            raise ConnectionError("telemetry link closed")
+
+        fut = asyncio.get_event_loop().create_future()
+        self.connect_waiters.append(fut)
+
+        await fut
+
+    async def send_object(self, send_obj, req_ack=False):
+        """ Sends an object; with req_ack, resends it until acknowledged.
+
+        Returns False if req_ack was given and no ack came.
+        """
+        if not self.do_handshaking:
+            raise ValueError("Can only send on handshaking/bidir sessions")
+
+        if not req_ack:
+            self._send(uavtalk.send_object(send_obj))
+            return True
+
+        for i in range(self.ACK_TRIES):
+            if self.eof:
+                return False
+
+            fut = asyncio.get_event_loop().create_future()
+            self.ack_waiters.setdefault(send_obj.__class__, []).append(fut)
+
+            self._send(uavtalk.send_object(send_obj, req_ack=True))
+
+            try:
+                if await asyncio.wait_for(asyncio.shield(fut), self.ACK_WAIT):
+                    return True
+            except asyncio.TimeoutError:
+                waiters = self.ack_waiters.get(send_obj.__class__, [])
+
+                if fut in waiters:
+                    waiters.remove(fut)
+
+        return False
+
+    async def request_object(self, obj, inst_id=0):
+        """ Asks the other end for an object.
+
+        Returns the object received, or None if it was nacked or never came.
+        """
+        if not self.do_handshaking:
+            raise ValueError("Can only request on handshaking/bidir sessions")
+
+        if isinstance(obj, str):
+            obj = self.uavo_defs.find_by_name(obj)
+
+        if self.eof:
+            return None
+
+        fut = asyncio.get_event_loop().create_future()
+        key = (obj._id, inst_id)
+
+        # Everyone asking for the same thing shares one request
+        req = self.req_obj.get(key)
+
+        if req is None:
+            req = self._PendingReq(obj, inst_id, self.REQ_RETRIES,
+                    self.REQ_RETRY_TIME)
+            self.req_obj[key] = req
+
+            self._send(req.make_request())
+
+        req.waiters.append(fut)
+
+        return await fut
+
+    def close(self):
+        if self.transport is not None:
+            self.transport.close()
+
+    async def wait_closed(self):
+        await self.closed
+
+    # Internals
+
+    class _PendingReq:
+        def __init__(self, obj, inst_id, retries, retry_time):
+            self.obj = obj
+            self.inst_id = inst_id
+            self.retries = retries
+            self.retry_time = retry_time
+            self.expiration = time.time() + retry_time
+            self.waiters = []
+
+        def time_to_resend(self, now):
+            if self.retries and now >= self.expiration:
+                self.expiration = now + self.retry_time
+                self.retries -= 1
+                return True
+
+            return False
+
+        def expired(self, now):
+            return (not self.retries) and now >= self.expiration
+
+        def completed(self, value):
+            for fut in self.waiters:
+                if not fut.done():
+                    fut.set_result(value)
+
+        def make_request(self):
+            return uavtalk.request_object(self.obj, self.inst_id)
+
+    async def _service(self):
+        """ Resends requests that have gone unanswered. """
+        while not self.eof:
+            await asyncio.sleep(self.SERVICE_PERIOD)
+
+            now = time.time()
+
+            for key, req in list(self.req_obj.items()):
+                if req.expired(now):
+                    del self.req_obj[key]
+                    req.completed(None)
+                elif req.time_to_resend(now):
+                    self._send(req.make_request())
+
+    def _send(self, msg):
+        if self.transport is None or self.eof:
+            return
+
+        if self.datagram:
+            self.transport.sendto(msg)
+        else:
+            self.transport.write(msg)
+
+    def _reqack_callback(self, obj):
+        if self.do_handshaking:
+            self._send(uavtalk.acknowledge_object(obj))
+
+    def _gotack_callback(self, obj):
+        for fut in self.ack_waiters.pop(obj, []):
+            if not fut.done():
+                fut.set_result(True)
+
+    def _gotnack_callback(self, obj):
+        # TODO: Need to handle instance id better
+        req = self.req_obj.pop((obj._id, 0), None)
+
+        if req is not None:
+            req.completed(None)
+
+    def __make_handshake(self, handshake):
+        fields = { 'Status' : self.GCSTelemetryStats.ENUM_Status[handshake] }
+
+        batched = getattr(self.GCSTelemetryStats,
+                'ENUM_AcceptsBatchedFrames', None)
+
+        if batched is not None:
+            fields['AcceptsBatchedFrames'] = batched['True']
+
+        return self.GCSTelemetryStats._make_to_send(**fields)
+
+    def __handle_handshake(self, obj):
+        if obj.Status == obj.ENUM_Status['Disconnected']:
+            logger.debug("%s: FlightTelem: Disconnected" % (self.name))
+            send_obj = self.__make_handshake('HandshakeReq')
+        elif obj.Status == obj.ENUM_Status['HandshakeAck']:
+            logger.debug("%s: FlightTelem: Handshake Acked" % (self.name))
+            send_obj = self.__make_handshake('Connected')
+        elif obj.Status == obj.ENUM_Status['Connected']:
+            send_obj = self.__make_handshake('Connected')
+
+            for fut in self.connect_waiters:
+                if not fut.done():
+                    fut.set_result(None)
+
+            self.connect_waiters = []
+        else:
+            return
+
+        self._send(uavtalk.send_object(send_obj))
+
+    def __handle_frames(self, frames):
+        obj = self.uavtalk_generator.send(frames)
+
+        while obj:
+            self.last_values[obj.__class__] = obj
+
+            if self.do_handshaking and \
+                    isinstance(obj, self.FlightTelemetryStats):
+                self.__handle_handshake(obj)
+
+            req = self.req_obj.pop((obj._id, obj.get_inst_id()), None)
+
+            if req is not None:
+                req.completed(obj)
+
+            for cb in list(self.callbacks):
+                try:
+                    cb(self, obj)
+                except Exception:
+                    logger.exception("%s: callback failed" % (self.name))
+
+            if self.queue is not None:
+                self.queue.put_nowait((self, obj))
+
+            obj = self.uavtalk_generator.send(b'')
+
+class _SerialTransport(asyncio.Transport):
+    """ Minimal non-blocking transport over a pyserial port, for when
+    pyserial-asyncio isn't installed.  Needs a port with a fileno, so POSIX
+    only. """
+
+    def __init__(self, loop, ser, protocol):
+        super().__init__()
+
+        self.loop = loop
+        self.ser = ser
+        self.protocol = protocol
+        self.send_buf = b''
+        self.closing = False
+
+        loop.add_reader(ser.fileno(), self.__read_ready)
+        loop.call_soon(protocol.connection_made, self)
+
+    def __read_ready(self):
+        import serial
+
+        try:
+            data = self.ser.read(self.ser.in_waiting or 1)
+        except serial.SerialException as e:
+            self.__fail(e)
+            return
+
+        if data:
+            self.protocol.data_received(data)
+
+    def __write_ready(self):
+        self.__flush()
+
+        if not self.send_buf:
+            self.loop.remove_writer(self.ser.fileno())
+
+            if self.closing:
+                self.__finish(None)
+
+    def __flush(self):
+        import serial
+
+        try:
+            written = self.ser.write(self.send_buf)
+        except serial.SerialTimeoutException:
+            written = 0
+        except serial.SerialException as e:
+            self.__fail(e)
+            return
+
+        self.send_buf = self.send_buf[written or 0:]
+
+    def __fail(self, exc):
+        self.send_buf = b''
+        self.__finish(exc)
+
+    def __finish(self, exc):
+        if self.ser is None:
+            return
+
+        self.loop.remove_reader(self.ser.fileno())
+        self.loop.remove_writer(self.ser.fileno())
+        self.ser.close()
+        self.ser = None
+
+        self.loop.call_soon(self.protocol.connection_lost, exc)
+
+    def write(self, data):
+        if self.ser is None or self.closing:
+            return
+
+        had_pending = bool(self.send_buf)
+        self.send_buf += data
+
+        if had_pending:
+            return
+
+        self.__flush()
+
+        if self.send_buf and self.ser is not None:
+            self.loop.add_writer(self.ser.fileno(), self.__write_ready)
+
+    def is_closing(self):
+        return self.closing or self.ser is None
+
+    def close(self):
+        if self.closing:
+            return
+
+        self.closing = True
+
+        if not self.send_buf:
+            self.__finish(None)
+
+    def abort(self):
+        self.__fail(None)
+
+    def get_write_buffer_size(self):
+        return len(self.send_buf)
+
+async def open_tcp(host="127.0.0.1", port=9000, **kwargs):
+    """ Connects over TCP, to flightd or the GCS's telemetry hub.
+
+    Keyword arguments are passed to AsyncTelemetry.
+    """
+    kwargs.setdefault('name', "%s:%d" % (host, port))
+
+    loop = asyncio.get_event_loop()
+
+    _, telem = await loop.create_connection(
+            lambda: AsyncTelemetry(**kwargs), host, port)
+
+    return telem
+
+async def open_udp(host, port, local_addr=None, **kwargs):
+    """ Talks UAVTalk in UDP datagrams to host:port, e.g. through a radio
+    bridge.
+
+    Keyword arguments are passed to AsyncTelemetry.
+    """
+    kwargs.setdefault('name', "udp:%s:%d" % (host, port))
+
+    loop = asyncio.get_event_loop()
+
+    _, telem = await loop.create_datagram_endpoint(
+            lambda: AsyncTelemetry(**kwargs), local_addr=local_addr,
+            remote_addr=(host, port))
+
+    return telem
+
+async def open_serial(port, speed=115200, **kwargs):
+    """ Connects over a (real or virtual) serial port.
+
+    Uses pyserial-asyncio if it is installed, otherwise pyserial directly.
+
+    Keyword arguments are passed to AsyncTelemetry.
+    """
+    kwargs.setdefault('name', port)
+
+    loop = asyncio.get_event_loop()
+
+    try:
+        import serial_asyncio
+    except ImportError:
+        serial_asyncio = None
+
+    if serial_asyncio is not None:
+        _, telem = await serial_asyncio.create_serial_connection(loop,
+                lambda: AsyncTelemetry(**kwargs), port, baudrate=speed)
+
+        return telem
+
+    import serial
+
+    ser = serial.Serial(port, speed, timeout=0, writeTimeout=0)
+
+    telem = AsyncTelemetry(**kwargs)
+    _SerialTransport(loop, ser, telem)
+
+    # Let connection_made run before handing it back
+    await asyncio.sleep(0)
+
+    return telem
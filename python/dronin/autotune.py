@@ -11,6 +11,7 @@ from __future__ import print_function
 
 import sys, struct
 
+import numpy as np
 import pandas as pd
 from scipy import signal
 
@@ -124,6 +125,131 @@ def read_autotune_from_autotown(tuneid, **kwargs):
 
     return process_autotune_json(contents, **kwargs)
 
+def autotune_arrays(contents):
+    """ Given a block of autotune data, return the gyro and desired actuator
+    samples as two (N, 3) arrays along with the sample rate, without building a
+    data frame.  This is the cheap way in for identify() on long captures. """
+    hdr_tup = at_flash_header_fmt.unpack_from(contents)
+
+    if hdr_tup[0] != 0x656e755480008041:
+        raise ValueError
+
+    pts = hdr_tup[1]
+    sample_rate = hdr_tup[3] or 1000
+
+    meas = np.frombuffer(contents, dtype='<f4', count=pts * 6,
+            offset=at_flash_header_fmt.size).reshape(pts, 6)
+
+    return (meas[:, 0:3], meas[:, 3:6], float(sample_rate))
+
+def _biquad(cutoff, data):
+    """ The same primed Butterworth biquad the GCS runs: filter the circular
+    buffer once to settle the state, then again for the output. """
+    f = 1.0 / np.tan(np.pi * cutoff)
+    q = 1.4142
+
+    b0 = 1.0 / (1.0 + q * f + f * f)
+    a1 = 2.0 * (f * f - 1.0) * b0
+    a2 = -(1.0 - q * f + f * f) * b0
+
+    filtered = signal.lfilter([b0, 2 * b0, b0], [1.0, -a1, -a2],
+            np.concatenate([data, data]))
+
+    return filtered[len(data):]
+
+def _sample_delay(delayed, orig, series_cutoff=4):
+    """ Samples of delay between two series, from the peak of their circular
+    cross correlation. """
+    corr = np.fft.irfft(np.fft.rfft(delayed) * np.conj(np.fft.rfft(orig)),
+            len(delayed))
+
+    half = len(corr) // 2
+
+    mags = np.hypot(corr[:half], corr[half:2 * half])
+
+    return float(np.argmax(mags[:half // series_cutoff]))
+
+def _percentile_span(data):
+    """ Spread between the 5th and 95th percentiles, picked the way the GCS
+    picks them so the two agree. """
+    srt = np.sort(data)
+
+    low_idx = int(len(srt) * 0.05 + 0.5)
+    high_idx = len(srt) - 1 - low_idx
+
+    return srt[high_idx] - srt[low_idx]
+
+def _gain_bias(gyro_deriv, actu, sample_rate):
+    gain = _percentile_span(gyro_deriv) / _percentile_span(actu) * sample_rate
+
+    bias = np.mean(gyro_deriv) - np.mean(actu) * (gain / sample_rate)
+
+    return (gain, bias)
+
+def identify_axis(gyro, desired, sample_rate, series_cutoff=4, blocks=10):
+    """ System identification of one axis, as done by the GCS autotune wizard.
+
+    gyro and desired are 1-D arrays of equal length; any length works, so
+    longer or higher rate captures than the flight code stores can be used.
+
+    Returns a dict with tau, beta, bias and noise, along with the half widths
+    of their 95% confidence intervals (tauCI, betaCI, biasCI).  Gain and bias
+    intervals come from a jackknife over blocks of the capture; tau is a
+    whole number of samples, so its interval is half a sample. """
+    gyro = np.asarray(gyro, dtype=np.float64)
+    actu = np.asarray(desired, dtype=np.float64)
+
+    # Circular derivative, matching the wrap around in the flight capture
+    gyro_deriv = gyro - np.roll(gyro, 1)
+
+    sample_tau = _sample_delay(gyro_deriv, actu, series_cutoff)
+
+    actu = _biquad(1 / (sample_tau * np.pi * 1.414), actu)
+
+    gain, bias = _gain_bias(gyro_deriv, actu, sample_rate)
+
+    model = (actu - np.mean(actu)) * (gain / sample_rate)
+    noise = np.sqrt(np.mean((model - (gyro_deriv - np.mean(gyro_deriv))) ** 2))
+
+    edges = (np.arange(blocks + 1) * len(gyro_deriv)) // blocks
+
+    jack = np.array([_gain_bias(np.delete(gyro_deriv, np.s_[lo:hi]),
+            np.delete(actu, np.s_[lo:hi]), sample_rate)
+        for lo, hi in zip(edges[:-1], edges[1:])])
+
+    jack[:, 0] = np.log(jack[:, 0])
+
+    ci = 1.96 * np.sqrt(np.var(jack, axis=0) * (blocks - 1))
+
+    return {
+        'tau' : sample_tau / sample_rate,
+        'beta' : float(np.log(gain)),
+        'bias' : float(bias),
+        'noise' : float(noise),
+        'tauCI' : 0.5 / sample_rate,
+        'betaCI' : float(ci[0]),
+        'biasCI' : float(ci[1]),
+    }
+
+def identify(gyro, desired, sample_rate, **kwargs):
+    """ Identifies all three axes of (N, 3) gyro and desired arrays, e.g. from
+    autotune_arrays().  Returns a list of identify_axis() results. """
+    return [ identify_axis(gyro[:, axis], desired[:, axis], sample_rate,
+                series_cutoff=(8 if axis == 2 else 4), **kwargs)
+            for axis in range(3) ]
+
+def _identify_job(args):
+    return identify(*args)
+
+def identify_many(captures, processes=None):
+    """ Identifies a batch of captures, each a (gyro, desired, sample_rate)
+    tuple, in parallel across processes.  Returns the identify() results in
+    the same order. """
+    from multiprocessing import Pool
+
+    with Pool(processes) as pool:
+        return pool.map(_identify_job, captures)
+
 def main(argv):
     if len(argv) != 1:
         print("nope")
@@ -0,0 +1,192 @@
+"""
+Decodes the compact control loop frames written by the Blackbox logging
+profile.
+
+Copyright (C) 2017 dRonin, http://dronin.org
+
+Licensed under the GNU LGPL version 2.1 or any later version (see COPYING.LESSER)
+
+The frames arrive in UAVTalk-framed chunks (see flight/Libraries/inc/blackbox.h
+for the layout).  Each decoded frame comes back as Gyros, RateDesired,
+ActuatorDesired and ActuatorCommand instances, so the rest of the tools can
+treat them like any other logged objects.
+"""
+
+import logging
+
+logger = logging.getLogger(__name__)
+
+__all__ = [ "BlackboxDecoder" ]
+
+(FRAME_KEYFRAME, FRAME_LEN_MASK) = (0x80, 0x7f)
+(NO_FRAME_START) = (0xff)
+
+(NUM_AXES, NUM_DESIRED, NUM_OUTPUTS) = (3, 4, 10)
+(GYRO_SCALE, RATE_SCALE, DESIRED_SCALE, OUTPUT_SCALE) = (16.0, 16.0, 10000.0, 1.0)
+
+NUM_FIELDS = 2 * NUM_AXES + NUM_DESIRED + NUM_OUTPUTS
+
+def _read_varint(buf, pos, end):
+    value = 0
+    shift = 0
+
+    while pos < end:
+        b = buf[pos]
+        pos += 1
+
+        value |= (b & 0x7f) << shift
+        shift += 7
+
+        if not (b & 0x80):
+            return value, pos
+
+    raise ValueError("truncated varint")
+
+def _unzigzag(value):
+    return (value >> 1) ^ -(value & 1)
+
+class BlackboxDecoder(object):
+    """ Keeps the state needed to follow the frames across chunks. """
+
+    def __init__(self, uavo_defs):
+        self.gyros = uavo_defs.find_by_name('Gyros')
+        self.rate_desired = uavo_defs.find_by_name('RateDesired')
+        self.actuator_desired = uavo_defs.find_by_name('ActuatorDesired')
+        self.actuator_command = uavo_defs.find_by_name('ActuatorCommand')
+
+        self.synced = False
+        self.last_seq = None
+        self.partial = b''
+        self.values = None
+        self.time_us = 0
+        self.time_base = 0
+
+    def _lose_sync(self):
+        self.synced = False
+        self.partial = b''
+
+    def feed_chunk(self, seq, first, num_fields, frames):
+        """ Takes the header fields and frame bytes of one chunk.
+
+        Returns a list of the objects decoded from all the frames that were
+        completed by this chunk.
+        """
+
+        if self.last_seq is not None and seq != (self.last_seq + 1) & 0xffff:
+            logger.warning("blackbox: lost chunks before %d" % (seq))
+            self._lose_sync()
+
+        self.last_seq = seq
+
+        if num_fields < NUM_FIELDS:
+            logger.warning("blackbox: only %d fields" % (num_fields))
+            self._lose_sync()
+            return []
+
+        if first == NO_FRAME_START:
+            if self.partial:
+                self.partial += frames
+            return []
+
+        data = self.partial + frames[:first]
+        self.partial = b''
+
+        objs = []
+
+        if data:
+            objs += self._decode_frames(data, num_fields, partial_ok=False)
+
+        objs += self._decode_frames(frames[first:], num_fields,
+                partial_ok=True)
+
+        return objs
+
+    def _decode_frames(self, data, num_fields, partial_ok):
+        objs = []
+        pos = 0
+
+        while pos < len(data):
+            tag = data[pos]
+            end = pos + 1 + (tag & FRAME_LEN_MASK)
+
+            if end > len(data):
+                if partial_ok:
+                    self.partial = data[pos:]
+                else:
+                    logger.warning("blackbox: frame overruns next start")
+                    self._lose_sync()
+                break
+
+            try:
+                frame_objs = self._decode_frame(tag, data, pos + 1, end,
+                        num_fields)
+            except ValueError:
+                logger.warning("blackbox: malformed frame")
+                self._lose_sync()
+                frame_objs = []
+
+            objs += frame_objs
+            pos = end
+
+        return objs
+
+    def _decode_frame(self, tag, data, pos, end, num_fields):
+        keyframe = (tag & FRAME_KEYFRAME) != 0
+
+        if not keyframe and not self.synced:
+            return []
+
+        (t, pos) = _read_varint(data, pos, end)
+
+        fields = []
+        for i in range(num_fields):
+            (v, pos) = _read_varint(data, pos, end)
+            fields.append(_unzigzag(v))
+
+        if keyframe:
+            # Keyframes carry the 32 bit microsecond clock; follow it
+            # across wraparound.
+            if self.synced and t < (self.time_us & 0xffffffff):
+                self.time_base += 1 << 32
+            self.time_us = self.time_base + t
+            self.values = fields
+            self.synced = True
+        else:
+            if (self.time_us & 0xffffffff) + t > 0xffffffff:
+                self.time_base += 1 << 32
+            self.time_us += t
+            self.values = [a + b for a, b in zip(self.values, fields)]
+
+        return self._make_objects(self.time_us / 1000000.0, self.values)
+
+    def _make_objects(self, t, values):
+        objs = []
+        pos = 0
+
+        gyro = [v / GYRO_SCALE for v in values[pos:pos + NUM_AXES]]
+        pos += NUM_AXES
+
+        rate = [v / RATE_SCALE for v in values[pos:pos + NUM_AXES]]
+        pos += NUM_AXES
+
+        desired = [v / DESIRED_SCALE for v in values[pos:pos + NUM_DESIRED]]
+        pos += NUM_DESIRED
+
+        outputs = [v / OUTPUT_SCALE for v in values[pos:pos + NUM_OUTPUTS]]
+
+        if self.gyros is not None:
+            objs.append(self.gyros(time=t, x=gyro[0], y=gyro[1], z=gyro[2]))
+
+        if self.rate_desired is not None:
+            objs.append(self.rate_desired(time=t, Roll=rate[0],
+                Pitch=rate[1], Yaw=rate[2]))
+
+        if self.actuator_desired is not None:
+            objs.append(self.actuator_desired(time=t, Roll=desired[0],
+                Pitch=desired[1], Yaw=desired[2], Thrust=desired[3]))
+
+        if self.actuator_command is not None:
+            objs.append(self.actuator_command(time=t,
+                Channel=tuple(outputs)))
+
+        return objs
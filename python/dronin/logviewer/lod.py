@@ -0,0 +1,93 @@
+"""
+Level of detail plotting for long time series.
+
+Copyright (C) 2017 dRonin, http://dronin.org
+
+Licensed under the GNU LGPL version 2.1 or any later version (see COPYING.LESSER)
+"""
+
+import numpy as np
+
+class MinMaxPyramid():
+    """ Min/max summaries of a series at successively coarser levels.
+
+    Level 0 is the series itself.  Each level above has one bucket for every
+    FACTOR buckets of the one below, holding the time the bucket starts at
+    and the least and greatest values in it.  Drawing each bucket as its
+    min and max keeps every spike visible however far out the view is,
+    while never drawing many more points than there are pixels. """
+
+    FACTOR = 8
+
+    def __init__(self, t, y):
+        t = np.asarray(t, dtype=float)
+        y = np.asarray(y, dtype=float)
+
+        self.levels = [ (t, y, y) ]
+
+        while len(t) > self.FACTOR:
+            (t, lo, hi) = self.levels[-1]
+
+            starts = np.arange(0, len(t), self.FACTOR)
+
+            t = t[starts]
+            lo = np.minimum.reduceat(lo, starts)
+            hi = np.maximum.reduceat(hi, starts)
+
+            self.levels.append((t, lo, hi))
+
+    def span(self):
+        t = self.levels[0][0]
+
+        if len(t) == 0:
+            return (0.0, 0.0)
+
+        return (t[0], t[-1])
+
+    def detail(self, t0, t1, max_points):
+        """ Returns the x and y to draw for times t0 to t1, using the finest
+        level that needs no more than max_points buckets there. """
+
+        for (level, (t, lo, hi)) in enumerate(self.levels):
+            # One bucket past each edge, so lines run off the view
+            i0 = max(np.searchsorted(t, t0, side='right') - 1, 0)
+            i1 = min(np.searchsorted(t, t1, side='left') + 1, len(t))
+
+            if (i1 - i0) <= max_points:
+                break
+
+        if level == 0:
+            return (t[i0:i1], lo[i0:i1])
+
+        x = np.repeat(t[i0:i1], 2)
+
+        y = np.empty(len(x))
+        y[0::2] = lo[i0:i1]
+        y[1::2] = hi[i0:i1]
+
+        return (x, y)
+
+class LODCurve():
+    """ A curve in a plot, redrawn from its pyramid whenever the visible
+    time range changes, at the detail that range needs. """
+
+    def __init__(self, plot_item, t, y, **kwargs):
+        self.pyramid = MinMaxPyramid(t, y)
+        self.view = plot_item.getViewBox()
+
+        self.curve = plot_item.plot(**kwargs)
+
+        self.view.sigXRangeChanged.connect(self.update)
+
+        self.update(self.view, self.pyramid.span())
+
+    def update(self, view=None, x_range=None):
+        if x_range is None:
+            x_range = self.view.viewRange()[0]
+
+        # About a bucket per pixel, each drawn as its min and max
+        width = max(int(self.view.width()), 200)
+
+        (x, y) = self.pyramid.detail(x_range[0], x_range[1], width)
+
+        self.curve.setData(x, y)
@@ -5,6 +5,7 @@ from dronin_pyqtgraph.Qt import QtCore, QtGui
 import numpy as np
 
 from dronin.logviewer.plotdockarea import PlotDockArea
+from dronin.logviewer.lod import LODCurve
 
 from dronin_pyqtgraph.dockarea import *
 
@@ -23,24 +24,15 @@ def get_data_series(obj_name, fields):
         except Exception:
             pass
 
-    rows = peeled.shape[0]
-    cols = len(fields)
     outp = np.empty((peeled.shape[0], len(fields)))
 
-    for j in range(cols):
+    for j in range(len(fields)):
         field_info = fields[j].split(':')
 
         if len(field_info) > 1:
-            subs = int(field_info[1])
-            for i in range(rows):
-                val = peeled[i][j][subs]
-
-                outp[i,j] = float(val)
+            outp[:,j] = peeled[field_info[0]][:, int(field_info[1])]
         else:
-            for i in range(rows):
-                val = peeled[i][j]
-
-                outp[i,j] = float(val)
+            outp[:,j] = peeled[field_info[0]]
 
     return outp
 
@@ -55,10 +47,31 @@ def add_plot_area(data_series, dock_name, axis_label, legend=False, **kwargs):
     colors = [ 'w', 'm', 'y', 'c' ]
     idx = 0
 
+    t_min = None
+    t_max = None
+
     for plot_name, data in data_series.items():
-        pw.plot(data, antialias=True, name='&nbsp;'+plot_name, pen=pg.mkPen(colors[idx]), **kwargs)
+        if len(data) < 1:
+            continue
+
+        # Long flights have far more points than pixels, so each curve is
+        # drawn at the detail of what's in view
+        curve = LODCurve(pw.getPlotItem(), data[:,0], data[:,1],
+                antialias=True, name='&nbsp;'+plot_name,
+                pen=pg.mkPen(colors[idx]), **kwargs)
         idx += 1
 
+        (start, end) = curve.pyramid.span()
+
+        t_min = start if t_min is None else min(t_min, start)
+        t_max = end if t_max is None else max(t_max, end)
+
+    # The curves only hold what's in view, so the x range is set from the
+    # whole series instead of being fit to them
+    if t_min is not None:
+        pw.setXRange(t_min, t_max, padding=0.02)
+        pw.enableAutoRange(x=False)
+
     # pen=None, symbol='o', symbolSize=2.5
 
     pw.setLabel('left', axis_label)
@@ -124,109 +137,152 @@ def get_series(name):
 
     return series[name]
 
-def scan_for_events(uv):
+def scan_for_events():
     flight_mode = -1
     armed = -1
 
     events = []
 
-    for u in uv:
-        if u._name == 'UAVO_FlightStatus':
-            ev = []
-            # u.Armed DISARMED/ARMING/ARMED
-            # u.FlightMode
+    typ = objtyps['FlightStatus']
+
+    for u in get_series('FlightStatus'):
+        ev = []
+        # Armed DISARMED/ARMING/ARMED
+        # FlightMode
 
-            if u.Armed != armed:
-                armed = u.Armed
+        if u['Armed'] != armed:
+            armed = int(u['Armed'])
 
-                ev.append(u.ENUMR_Armed[armed])
+            ev.append(typ.ENUMR_Armed[armed])
 
-            if u.FlightMode != flight_mode:
-                flight_mode = u.FlightMode
+        if u['FlightMode'] != flight_mode:
+            flight_mode = int(u['FlightMode'])
 
-                ev.append('MODE:' + u.ENUMR_FlightMode[flight_mode])
+            ev.append('MODE:' + typ.ENUMR_FlightMode[flight_mode])
 
-            if len(ev):
-                tup = (u.time, '/'.join(ev))
-                events.append(tup)
+        if len(ev):
+            tup = (float(u['time']), '/'.join(ev))
+            events.append(tup)
 
     return events
 
+class LogLoader(QtCore.QThread):
+    """ Decodes a log in the background, so the UI stays responsive """
+
+    progress = QtCore.Signal(int, int)
+
+    def __init__(self):
+        QtCore.QThread.__init__(self)
+
+        self.telem = None
+        self.arrays = None
+
+    def run(self):
+        self.arrays = self.telem.as_numpy_arrays()
+
 def handle_open(ignored=False, fname=None):
-    from dronin import telemetry, uavo
+    from dronin import telemetry
+
+    global loader
+
+    if loader is not None and loader.isRunning():
+        return
 
     if fname is None:
         fname = QtGui.QFileDialog.getOpenFileName(win, 'Open file', filter="Log files (*.drlog *.txt)")
 
-    with pg.ProgressDialog("0 objects read...", wait=500, maximum=1000, cancelText=None) as dlg:
-        global t
+    if (len(fname[0]) > 1):
+        fname = fname[0]
 
-        if (len(fname[0]) > 1):
-            fname = fname[0]
+    f = open(fname, 'rb')
+    num_bytes = 1000000000
 
-        f = open(fname, 'rb')
-        num_bytes = 1000000000
+    try:
+        import os
 
-        try:
-            import os
+        stat_info = os.fstat(f.fileno())
 
-            stat_info = os.fstat(f.fileno())
+        num_bytes = stat_info.st_size
+    except Exception:
+        print("Couldn't stat file")
+        pass
 
-            num_bytes = stat_info.st_size
-        except Exception:
-            print("Couldn't stat file")
-            pass
+    dlg = pg.ProgressDialog("0 objects read...", wait=500, maximum=1000, cancelText=None)
+
+    def cb(n_objs, n_bytes):
+        # Top out at 90%, so the dialog doesn't hang at 100%
+        # during the non-reading operations...
+        permille = (n_bytes * 900.0) / num_bytes
+
+        # should not happen, but cover the case anyways
+        if (permille > 900.0): permille = 900.0
 
-        def cb(n_objs, n_bytes):
-            # Top out at 90%, so the dialog doesn't hang at 100%
-            # during the non-reading operations...
-            permille = (n_bytes * 900.0) / num_bytes
+        # Called from the loader thread; the dialog is updated from ours
+        loader.progress.emit(int(permille), n_objs)
 
-            # should not happen, but cover the case anyways
-            if (permille > 900.0): permille = 900.0
-            dlg.setValue(permille)
-            dlg.setLabelText("%d objects read..." % n_objs)
+    def show_progress(permille, n_objs):
+        dlg.setValue(permille)
+        dlg.setLabelText("%d objects read..." % n_objs)
 
-        t = telemetry.FileTelemetry(f, parse_header=True, service_in_iter=True,
-                    gcs_timestamps=None, name=fname, progress_callback=cb)
+    loader = LogLoader()
+    loader.progress.connect(show_progress)
+    loader.finished.connect(lambda: finish_open(dlg))
 
-        global series, objtyps
-        series = {}
-        objtyps = {}
+    loader.telem = telemetry.FileTelemetry(f, parse_header=True,
+            service_in_iter=True, gcs_timestamps=None, name=fname,
+            progress_callback=cb)
 
-        for typ in t.uavo_defs.values():
-            short_name = typ._name[5:]
-            objtyps[short_name] = typ
+    loader.start()
 
-        event_series = scan_for_events(t)
+def finish_open(dlg):
+    global t
+    t = loader.telem
+
+    global series, objtyps
+    series = {}
+    objtyps = {}
+
+    for typ in t.uavo_defs.values():
+        short_name = typ._name[5:]
+        objtyps[short_name] = typ
+
+    for typ, arr in loader.arrays.items():
+        series[typ._name[5:]] = arr
+
+    present = set(series.keys())
+
+    event_series = scan_for_events()
+
+    global last_plot
+    last_plot = None
 
-        global last_plot
-        last_plot = None
+    thrust_plot = plot_vs_time('StabilizationDesired', 'Thrust')
 
-        thrust_plot = plot_vs_time('StabilizationDesired', 'Thrust')
+    clear_plots(skip=[last_plot])
 
-        clear_plots(skip=[last_plot])
+    for tm,text in event_series:
+        thrust_plot.addLine(x=tm)
+        # label=text, labelOpts={'rotateAxis' : (1,0)} )
 
-        for tm,text in event_series:
-            thrust_plot.addLine(x=tm)
-            # label=text, labelOpts={'rotateAxis' : (1,0)} )
+    dlg.setValue(925)
+    plot_vs_time('AttitudeActual', ['Yaw', 'Roll', 'Pitch'])
+    dlg.setValue(975)
+    plot_vs_time('Gyros', ['x', 'y', 'z'])
+    plot_vs_time('ActuatorCommand', ['Channel:0', 'Channel:1', 'Channel:2', 'Channel:3'])
 
-        dlg.setValue(925)
-        plot_vs_time('AttitudeActual', ['Yaw', 'Roll', 'Pitch'])
-        dlg.setValue(975)
-        plot_vs_time('Gyros', ['x', 'y', 'z'])
-        plot_vs_time('ActuatorCommand', ['Channel:0', 'Channel:1', 'Channel:2', 'Channel:3'])
+    objtyps = { k:v for k,v in objtyps.items() if k in present }
 
-        objtyps = { k:v for k,v in objtyps.items() if v in t.last_values }
+    #add all non-settings objects, and autotune, to the keys.
+    objSel.clear()
 
-        #add all non-settings objects, and autotune, to the keys.
-        objSel.clear()
+    for typnam in sorted(objtyps.keys()):
+        if typnam == "SystemIdent" or not objtyps[typnam]._is_settings:
+            objSel.addItem(typnam)
 
-        for typnam in sorted(objtyps.keys()):
-            if typnam == "SystemIdent" or not objtyps[typnam]._is_settings:
-                objSel.addItem(typnam)
+    objSel.setEnabled(True)
 
-        objSel.setEnabled(True)
+    dlg.setValue(1000)
+    dlg.close()
 
 def updateItems(i):
     uavo = objtyps[str(objSel.currentText())]
@@ -275,6 +331,7 @@ menubar = win.menuBar()
 
 win_num = 0
 menus_enabled = False
+loader = None
 
 openAction = QtGui.QAction("&Open", win)
 openAction.setShortcut(QtGui.QKeySequence.Open)
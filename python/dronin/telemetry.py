@@ -7,6 +7,7 @@ Licensed under the GNU LGPL version 2.1 or any later version (see COPYING.LESSER
 """
 
 import socket
+import struct
 import time
 import errno
 import sys
@@ -61,6 +62,9 @@ class TelemetryBase(metaclass=ABCMeta):
             uavo_defs.from_uavo_xml_path(xml_path)
 
         self.uavo_defs = uavo_defs
+        self.githash = githash
+        self.gcs_timestamps = gcs_timestamps
+        self.progress_callback = progress_callback
 
         self.uavtalk_generator = uavtalk.process_stream(uavo_defs,
             use_walltime=use_walltime, gcs_timestamps=gcs_timestamps,
@@ -195,8 +199,17 @@ class TelemetryBase(metaclass=ABCMeta):
                 break
 
     def __make_handshake(self, handshake):
-        return self.GCSTelemetryStats._make_to_send(
-                Status=self.GCSTelemetryStats.ENUM_Status[handshake])
+        fields = { 'Status' : self.GCSTelemetryStats.ENUM_Status[handshake] }
+
+        # Tell the firmware we can parse batched frames, if its objects
+        # know about them.
+        batched = getattr(self.GCSTelemetryStats,
+                'ENUM_AcceptsBatchedFrames', None)
+
+        if batched is not None:
+            fields['AcceptsBatchedFrames'] = batched['True']
+
+        return self.GCSTelemetryStats._make_to_send(**fields)
 
     def __remove_from_ack_set(self, obj):
         with self.ack_cond:
@@ -335,22 +348,23 @@ class TelemetryBase(metaclass=ABCMeta):
             if self.file_id != file_id:
                 return
 
-            if offset != self.file_offset:
-                self.file_chunkdone = True
-                self.ack_cond.notifyAll()
+            # Only take data that carries on from what we have; anything
+            # else is from a request that has been given up on.
+            if offset == self.file_offset and not self.file_eof:
+                self.file_eof = eof
+                self.file_data += data
+                self.file_offset += len(data)
 
-            self.file_eof = eof
-            self.file_chunkdone = last_chunk
-            self.file_data += data
-            self.file_offset += len(data)
+            if last_chunk:
+                self.file_chunks_done += 1
 
             self.ack_cond.notifyAll()
 
-    def request_filedata(self, file_id, offset):
+    def request_filedata(self, file_id, offset, count=0, compress=False):
         if not self.do_handshaking:
             raise ValueError("Can only request on handshaking/bidir sessions")
 
-        self._send(uavtalk.request_filedata(file_id, offset))
+        self._send(uavtalk.request_filedata(file_id, offset, count, compress))
 
     def save_object(self, obj, send_first=False):
         if send_first:
@@ -386,27 +400,97 @@ class TelemetryBase(metaclass=ABCMeta):
         for obj in objs:
             self.save_object(obj, *arg, **kwargs)
 
-    def transfer_file(self, file_id):
+    # Messages asked for in each file request, and the most requests kept
+    # going at once.  Each message carries up to FILE_CHUNK_LEN bytes of
+    # the file.
+    FILE_REQ_COUNT = 16
+    FILE_REQ_WINDOW = 2
+    FILE_CHUNK_LEN = 100
+
+    def transfer_file(self, file_id, compress=True, max_retries=5):
+        """Downloads a whole file from the flight side.
+
+        Keeps the next request going while the last is answered, so the link
+        doesn't sit idle waiting on round trips.  If a request comes back
+        short, as it does from older firmware, it falls back to one request
+        at a time.
+        """
+
+        window = self.FILE_REQ_WINDOW
+        span = self.FILE_REQ_COUNT * self.FILE_CHUNK_LEN
+
+        # Where each outstanding request should leave the file offset
+        pending = []
+        next_offset = 0
+        retries = 0
+
         with self.ack_cond:
             self.file_data = b''
             self.file_eof = False
+            self.file_chunks_done = 0
 
             self.file_offset = 0
             self.file_id = file_id
 
-        while not self.file_eof:
+        while True:
             with self.ack_cond:
-                self.file_id = file_id
-                self.file_chunkdone = False
+                while self.file_chunks_done > 0 and pending:
+                    self.file_chunks_done -= 1
+
+                    if self.file_offset < pending.pop(0):
+                        window = 1
+
+                    retries = 0
+
+                self.file_chunks_done = 0
+
+                if self.file_eof:
+                    break
+
+                if not pending:
+                    next_offset = self.file_offset
+
+                to_send = []
 
-            self.request_filedata(file_id, self.file_offset)
+                while len(pending) < window:
+                    to_send.append(next_offset)
+                    next_offset += span
+                    pending.append(next_offset)
+
+            for offset in to_send:
+                self.request_filedata(file_id, offset,
+                        self.FILE_REQ_COUNT, compress)
 
             with self.ack_cond:
-                while not self.file_chunkdone:
-                    self.ack_cond.wait(1.0)
-                    # XXX timeout
+                # Wait for a request to finish; data still arriving counts
+                # as progress, so slow links aren't mistaken for stalls.
+                last_offset = self.file_offset
+                deadline = time.time() + 1.0
+
+                while self.file_chunks_done == 0 and not self.file_eof:
+                    if self.file_offset != last_offset:
+                        last_offset = self.file_offset
+                        deadline = time.time() + 1.0
+
+                    remaining = deadline - time.time()
+
+                    if remaining <= 0:
+                        break
+
+                    self.ack_cond.wait(remaining)
 
-                self.file_id = None
+                if self.file_chunks_done == 0 and not self.file_eof:
+                    retries += 1
+
+                    if retries > max_retries:
+                        self.file_id = None
+                        raise Exception("File transfer timed out")
+
+                    # Start over from what we have
+                    pending = []
+
+        with self.ack_cond:
+            self.file_id = None
 
         return self.file_data
 
@@ -760,6 +844,9 @@ class NetworkTelemetry(FDTelemetry):
     def __init__(self, host="127.0.0.1", port=9000, *args, **kwargs):
         """ Creates a telemetry instance talking over TCP.
 
+        This can be flightd, or the GCS's telemetry hub (on the port set in
+        its General settings), to share the board the GCS is connected to.
+
          - host: hostname to connect to (default localhost)
          - port: port number to communicate on (default 9000)
 
@@ -779,6 +866,130 @@ class NetworkTelemetry(FDTelemetry):
     def _close(self):
         self.sock.close()
 
+class ShmTelemetry(BidirTelemetry):
+    """ Shared memory telemetry interface, to a flightd on this host.
+
+    flightd started with -S telemetry:shm:<path> keeps a pair of byte rings
+    in that file (layout in flight/PiOS/posix/inc/pios_shm_priv.h).  Data
+    is copied straight between the rings and our buffers, with no sockets
+    or syscalls in the way.
+    """
+
+    MAGIC = 0x4d485344
+    HEADER_SIZE = 16
+    RING_HEADER_SIZE = 8
+
+    def __init__(self, path, *args, **kwargs):
+        """ Creates telemetry instance talking over a shared memory file.
+
+         - path: the file flightd is sharing, e.g. /dev/shm/dronin-sim
+
+        Meaningful parameters passed up to TelemetryBase include: githash,
+        service_in_iter, iter_blocks, use_walltime
+        """
+
+        import mmap
+
+        with open(path, "r+b") as f:
+            self.shm = mmap.mmap(f.fileno(), 0)
+
+        magic, ring_size = struct.unpack_from("<II", self.shm, 0)
+
+        if magic != self.MAGIC:
+            raise ValueError("%s isn't a flightd shared memory file" % (path))
+
+        self.ring_size = ring_size
+        self.to_host = self.HEADER_SIZE
+        self.to_fc = self.HEADER_SIZE + self.RING_HEADER_SIZE + ring_size
+
+        # Start from whatever flightd sends next
+        head, = struct.unpack_from("<I", self.shm, self.to_host)
+        struct.pack_into("<I", self.shm, self.to_host + 4, head)
+
+        BidirTelemetry.__init__(self, *args, **kwargs)
+
+    def __ring_read(self, ring, limit):
+        head, tail = struct.unpack_from("<II", self.shm, ring)
+
+        count = min((head - tail) & 0xffffffff, limit)
+
+        if count == 0:
+            return b''
+
+        data_start = ring + self.RING_HEADER_SIZE
+        offset = tail % self.ring_size
+        first = min(count, self.ring_size - offset)
+
+        chunk = self.shm[data_start + offset:data_start + offset + first]
+        chunk += self.shm[data_start:data_start + count - first]
+
+        struct.pack_into("<I", self.shm, ring + 4,
+                (tail + count) & 0xffffffff)
+
+        return chunk
+
+    def __ring_write(self, ring, data):
+        head, tail = struct.unpack_from("<II", self.shm, ring)
+
+        space = self.ring_size - ((head - tail) & 0xffffffff)
+        count = min(space, len(data))
+
+        if count == 0:
+            return 0
+
+        data_start = ring + self.RING_HEADER_SIZE
+        offset = head % self.ring_size
+        first = min(count, self.ring_size - offset)
+
+        self.shm[data_start + offset:data_start + offset + first] = data[:first]
+        self.shm[data_start:data_start + count - first] = data[first:count]
+
+        struct.pack_into("<I", self.shm, ring,
+                (head + count) & 0xffffffff)
+
+        return count
+
+    def _do_io(self, finish_time):
+        while True:
+            did_stuff = False
+
+            with self.cond:
+                if self.recv_buf is None:
+                    return False
+
+                magic, = struct.unpack_from("<I", self.shm, 0)
+
+                if magic != self.MAGIC:
+                    # flightd went away or is starting over
+                    if self.recv_buf == b'':
+                        self.recv_buf = None
+
+                    return False
+
+                if len(self.recv_buf) < 1024:
+                    chunk = self.__ring_read(self.to_host, 4096)
+
+                    if chunk:
+                        self.recv_buf += chunk
+                        did_stuff = True
+
+                with self.send_lock:
+                    if self.send_buf:
+                        written = self.__ring_write(self.to_fc, self.send_buf)
+
+                        if written > 0:
+                            self.send_buf = self.send_buf[written:]
+                            did_stuff = True
+
+            if did_stuff or time.time() >= finish_time:
+                return did_stuff
+
+            # Nothing to wake us here; poll at about the flight side's rate
+            time.sleep(0.001)
+
+    def _close(self):
+        self.shm.close()
+
 # TODO XXX : Plumb appropriate cleanup / file close for these classes
 
 class SerialTelemetry(BidirTelemetry):
@@ -979,6 +1190,19 @@ class HIDTelemetry(BidirTelemetry):
 
         return did_stuff
 
+# Bump whenever what goes in a log cache changes
+LOG_CACHE_VERSION = 1
+
+def log_cache_dir(log_path):
+    """ Where FileTelemetry keeps the decoded arrays for a log.
+
+    The directory holds one .npy file per object type, which is mapped back
+    in rather than read, and an index saying which log (by size and
+    modification time) they came from.
+    """
+
+    return log_path + '.npcache'
+
 class FileTelemetry(TelemetryBase):
     """ Telemetry interface to data in a file """
 
@@ -1040,10 +1264,131 @@ class FileTelemetry(TelemetryBase):
                 do_handshaking=False, use_walltime=False, *args, **kwargs)
 
         self.done=False
+        self.unread = None
+
+    def as_numpy_arrays(self, use_cache=True):
+        """ Decodes the rest of the file into numpy arrays, one per type.
+
+        Returns a dict from UAVO class to array, in the same form as
+        as_numpy_array gives.  Big logs are decoded in bulk, which is much
+        faster than going object by object; the objects are then not also
+        available by iterating.  Logs the bulk decoder can't handle are
+        iterated through as usual.
+
+        With use_cache, the arrays are kept next to the log (see
+        log_cache_dir), and later calls map them back in rather than
+        decoding the log again.
+        """
+
+        use_cache = use_cache and self.filename is not None and \
+                os.path.isfile(self.filename)
+
+        if use_cache:
+            arrays = self.__load_cache()
+
+            if arrays is not None:
+                self.eof = True
+                return arrays
+
+        buf = self.f.read()
+
+        arrays = uavtalk.process_stream_numpy(self.uavo_defs, buf,
+                gcs_timestamps=self.gcs_timestamps,
+                progress_callback=self.progress_callback)
+
+        if arrays is not None:
+            self.eof = True
+        else:
+            self.unread = buf
+
+            for obj in self:
+                pass
+
+            classes = set(obj.__class__ for obj in self.uavo_list)
+
+            arrays = { cls : self.as_numpy_array(cls, blocks=False) for cls in classes }
+
+        if use_cache:
+            try:
+                self.__save_cache(arrays)
+            except OSError as e:
+                logger.warning("Couldn't cache log: %s" % (e,))
+
+        return arrays
+
+    def __cache_key(self):
+        st = os.stat(self.filename)
+
+        return { 'version' : LOG_CACHE_VERSION, 'size' : st.st_size,
+                'mtime' : st.st_mtime, 'githash' : self.githash }
+
+    def __load_cache(self):
+        import json
+        import numpy as np
+
+        cache_dir = log_cache_dir(self.filename)
+
+        try:
+            with open(os.path.join(cache_dir, 'index.json')) as f:
+                index = json.load(f)
+        except (OSError, ValueError):
+            return None
+
+        if index.get('key') != self.__cache_key():
+            logger.info("Log cache is stale")
+            return None
+
+        arrays = {}
+
+        for name in index['objects']:
+            cls = self.uavo_defs.find_by_name(name)
+
+            if cls is None:
+                return None
+
+            try:
+                arr = np.load(os.path.join(cache_dir, name + '.npy'),
+                        mmap_mode='r')
+            except (OSError, ValueError):
+                return None
+
+            if arr.dtype != np.dtype(cls._dtype):
+                return None
+
+            arrays[cls] = arr
+
+        logger.info("Using log cache %s" % (cache_dir,))
+
+        return arrays
+
+    def __save_cache(self, arrays):
+        import json
+        import numpy as np
+
+        cache_dir = log_cache_dir(self.filename)
+
+        os.makedirs(cache_dir, exist_ok=True)
+
+        for cls, arr in arrays.items():
+            np.save(os.path.join(cache_dir, cls._name + '.npy'), arr)
+
+        # The index goes last, so a cache that was only partly written
+        # never matches
+        index = { 'key' : self.__cache_key(),
+                'objects' : [ cls._name for cls in arrays ] }
+
+        with open(os.path.join(cache_dir, 'index.json'), 'w') as f:
+            json.dump(index, f)
 
     def _receive(self, finish_time):
         """ Fetch available data from file """
 
+        if self.unread is not None:
+            buf = self.unread
+            self.unread = None
+
+            return buf
+
         buf = self.f.read(524288)   # 512k
 
         if buf == b'':
@@ -1077,6 +1422,11 @@ def _finish_telemetry_args(parser, args, service_in_iter, iter_blocks):
                 service_in_iter=service_in_iter, iter_blocks=iter_blocks,
                 githash=githash)
 
+    if args.source.startswith("shm:"):
+        return telemetry.ShmTelemetry(args.source[4:], name=args.source,
+                service_in_iter=service_in_iter, iter_blocks=iter_blocks,
+                githash=githash)
+
     if args.command:
         return telemetry.SubprocessTelemetry(args.source,
                 service_in_iter=service_in_iter, iter_blocks=iter_blocks,
@@ -1166,7 +1516,7 @@ def get_telemetry_by_args(desc="Process telemetry", service_in_iter=True,
                         help    = "use usb hid to communicate with FC")
 
     parser.add_argument("source",
-            help  = "file, host:port, vid:pid, command, or serial port")
+            help  = "file, host:port, shm:path, vid:pid, command, or serial port")
 
     # Parse the command-line.
     if arguments is None:
@@ -75,14 +75,11 @@ class UAVTupleClass():
         # add the remaining fields.  If the thing should be nested, construct
         # an appropriate tuple.
         if not cls._flat:
-            pos = 0
-
-            for n in cls._num_subelems:
-                if n == 1:
+            for pos, end in cls._subelem_slices:
+                if end is None:
                     field_values.append(unpack_field_values[pos])
                 else:
-                    field_values.append(tuple(unpack_field_values[pos:pos+n]))
-                pos += n
+                    field_values.append(tuple(unpack_field_values[pos:end]))
 
             field_values = tuple(field_values)
         else:
@@ -150,12 +147,15 @@ class UAVTupleClass():
 
     @classmethod
     def to_xml_description(cls, as_text=False):
+        # Kept as text, as it's rarely wanted and slow to rebuild in bulk
+        canonical_xml = etree.fromstring(cls._canonical_xml_text)
+
         if not as_text:
-            return cls._canonical_xml
+            return canonical_xml
 
         # TODO: Eliminate this useless wrapping
         xml_elem = etree.Element('xml')
-        xml_elem.append(cls._canonical_xml)
+        xml_elem.append(canonical_xml)
 
         try:
             return etree.tostring(xml_elem, pretty_print = True)
@@ -319,8 +319,10 @@ def canonicalize(subs, fields, is_settings):
     return new_tree
 
 # This is a very long, scary method.  It parses an XML file describing
-# a UAVO and builds an implementation class.
-def make_class(collection, xml_file, update_globals=True):
+# a UAVO into a descriptor: plain data, which can be pickled, holding all
+# that's needed to build the implementation class.  Parent enums are looked
+# up in the collection, and copied into the descriptor.
+def parse_definition(collection, xml_file):
     fields = []
 
     ##### PARSE THE XML FILE INTO INTERNAL REPRESENTATIONS #####
@@ -505,8 +507,6 @@ def make_class(collection, xml_file, update_globals=True):
 
         formats.append('' + f['elements'].__str__() + struct_element_map[f['type']])
 
-    fmt = Struct('<' + ''.join(formats))
-
     ##### CALCULATE THE NUMPY TYPE ASSOCIATED WITH THIS CLASS #####
     dtype  = [('name', 'S20'), ('time', 'double'), ('uavo_id', 'uint')]
 
@@ -519,6 +519,41 @@ def make_class(collection, xml_file, update_globals=True):
         else:
             dtype += [(f['name'], type_numpy_map[f['type']])]
 
+    return {
+        'name' : 'UAVO_' + name,
+        'id' : uavo_id,
+        'single' : is_single_inst,
+        'is_settings' : is_settings,
+        'format' : '<' + ''.join(formats),
+        'flat' : is_flat,
+        'num_subelems' : num_subelems,
+        'dtype' : dtype,
+        'canonical_xml' : etree.tostring(canonical_xml),
+        'fields' : [ {
+                'name' : f['name'],
+                'type' : f['type'],
+                'units' : f['units'],
+                'defaultvalue' : f['defaultvalue'],
+                'options' : f.get('options'),
+            } for f in fields ],
+        }
+
+def class_from_descriptor(desc, update_globals=True):
+    """ Builds the implementation class of a UAVO from its descriptor. """
+
+    name = desc['name']
+    uavo_id = desc['id']
+    is_single_inst = desc['single']
+    fields = desc['fields']
+
+    # Where each field is in the unpacked values, with no end for scalars
+    subelem_slices = []
+    pos = 0
+
+    for n in desc['num_subelems']:
+        subelem_slices.append((pos, None if n == 1 else pos + n))
+        pos += n
+
     ##### DYNAMICALLY CREATE A CLASS TO CONTAIN THIS OBJECT #####
     tuple_fields = ['name', 'time', 'uavo_id']
     if not is_single_inst:
@@ -526,18 +561,17 @@ def make_class(collection, xml_file, update_globals=True):
 
     tuple_fields.extend([f['name'] for f in fields])
 
-    name = 'UAVO_' + name
-
     class tmpClass(UAVTupleClass, namedtuple(name, tuple_fields)):
-        _packstruct = fmt
-        _flat = is_flat
+        _packstruct = Struct(desc['format'])
+        _flat = desc['flat']
         _name = name
         _id = uavo_id
         _single = is_single_inst
-        _num_subelems = num_subelems
-        _dtype = dtype
-        _is_settings = is_settings
-        _canonical_xml = canonical_xml
+        _num_subelems = desc['num_subelems']
+        _subelem_slices = tuple(subelem_slices)
+        _dtype = desc['dtype']
+        _is_settings = desc['is_settings']
+        _canonical_xml_text = desc['canonical_xml']
         _units = {f['name'] : f['units'] for f in fields}
         _types = {f['name'] : f['type'] for f in fields}
 
@@ -565,6 +599,11 @@ def make_class(collection, xml_file, update_globals=True):
 
     return tuple_class
 
+def make_class(collection, xml_file, update_globals=True):
+    """ Parses an XML file describing a UAVO and builds its class. """
+    return class_from_descriptor(parse_definition(collection, xml_file),
+            update_globals)
+
 class UAVOHash():
     def __init__(self):
         self.hval = 0
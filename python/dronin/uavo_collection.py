@@ -11,6 +11,27 @@ from . import uavo
 
 GITHASH_OF_LAST_RESORT = 'Release-20160120.3'
 
+# Changes whenever the descriptors in the cache do
+DESCRIPTOR_CACHE_VERSION = 1
+
+def _descriptor_cache_path(content_list):
+    """ Where the descriptors built from a set of definitions are cached,
+    keyed by a hash of the definitions """
+    import hashlib
+    import os.path as op
+    import os
+
+    h = hashlib.sha1(str(DESCRIPTOR_CACHE_VERSION).encode())
+
+    for contents in sorted(c if isinstance(c, bytes) else c.encode('utf-8')
+            for c in content_list):
+        h.update(hashlib.sha1(contents).digest())
+
+    cache_dir = os.environ.get('XDG_CACHE_HOME') or \
+            op.join(op.expanduser('~'), '.cache')
+
+    return op.join(cache_dir, 'dronin', 'uavo-%s.pickle' % (h.hexdigest()))
+
 class UAVOCollection(dict):
     def __init__(self):
         self.clear()
@@ -46,6 +67,46 @@ class UAVOCollection(dict):
                 f.write(u.to_xml_description(as_text=True))
 
     def from_file_contents(self, content_list):
+        import pickle
+
+        # Parsing is most of the startup time of the tools, so what comes of
+        # it is kept.  The cache is only a speedup; if it can't be used (say
+        # on GAE), the definitions are just parsed.
+        try:
+            cache_path = _descriptor_cache_path(content_list)
+
+            with open(cache_path, 'rb') as f:
+                descriptors = pickle.load(f)
+
+            for desc in descriptors:
+                u = uavo.class_from_descriptor(desc)
+                self.update([('{0:08x}'.format(u._id), u)])
+
+            return
+        except Exception:
+            self.clear()
+
+        descriptors = self._parse_file_contents(content_list)
+
+        try:
+            import os
+
+            os.makedirs(os.path.dirname(cache_path), exist_ok=True)
+
+            # Written aside and moved into place, so readers never see half
+            tmp_path = '%s.%d' % (cache_path, os.getpid())
+
+            with open(tmp_path, 'wb') as f:
+                pickle.dump(descriptors, f, pickle.HIGHEST_PROTOCOL)
+
+            os.replace(tmp_path, cache_path)
+        except Exception:
+            pass
+
+    def _parse_file_contents(self, content_list):
+        """ Builds up the UAVOs from XML definitions, returning their
+        descriptors in the order they were built """
+        descriptors = []
         some_processed = True
 
         # There are dependencies here
@@ -57,10 +118,12 @@ class UAVOCollection(dict):
             # Build up the UAV objects from the xml definitions
             for contents in content_list:
                 try:
-                    u = uavo.make_class(self, contents)
+                    desc = uavo.parse_definition(self, contents)
+                    u = uavo.class_from_descriptor(desc)
 
                     # add this uavo definition to our dictionary
                     self.update([('{0:08x}'.format(u._id), u)])
+                    descriptors.append(desc)
 
                     some_processed = True
                 except Exception:
@@ -71,6 +134,8 @@ class UAVOCollection(dict):
         if len(content_list):
             raise Exception("Unable to parse some uavo files")
 
+        return descriptors
+
     def from_tar_file(self, t):
         # Get the file members
         content_list = []
@@ -18,17 +18,20 @@ except:
 import time
 import logging
 
+from .blackbox import BlackboxDecoder
+
 logger = logging.getLogger(__name__)
 
-__all__ = [ "send_object", "process_stream" ]
+__all__ = [ "send_object", "process_stream", "process_stream_numpy" ]
 
 # Constants used for UAVTalk parsing
 (MIN_HEADER_LENGTH, MAX_HEADER_LENGTH, MAX_PAYLOAD_LENGTH) = (8, 12, (256-12))
 (SYNC_VAL) = (0x3C)
 (TYPE_MASK, TYPE_VER) = (0x70, 0x20)
 (TIMESTAMPED) = (0x80)
-(TYPE_OBJ, TYPE_OBJ_REQ, TYPE_OBJ_ACK, TYPE_ACK, TYPE_NACK, TYPE_FILEREQ, TYPE_FILEDATA, TYPE_OBJ_TS, TYPE_OBJ_ACK_TS, ) = (0x00, 0x01, 0x02, 0x03, 0x04, 0x08, 0x09, 0x80, 0x82)
-(FILEDATA_EOF, FILEDATA_LAST) = (0x01, 0x02)
+(TYPE_OBJ, TYPE_OBJ_REQ, TYPE_OBJ_ACK, TYPE_ACK, TYPE_NACK, TYPE_FILEREQ, TYPE_FILEDATA, TYPE_OBJ_BATCH, TYPE_BLACKBOX, TYPE_OBJ_TS, TYPE_OBJ_ACK_TS, ) = (0x00, 0x01, 0x02, 0x03, 0x04, 0x08, 0x09, 0x0A, 0x0B, 0x80, 0x82)
+(FILEDATA_EOF, FILEDATA_LAST, FILEDATA_LZ4) = (0x01, 0x02, 0x04)
+(FILEREQ_COUNT_MASK, FILEREQ_LZ4) = (0x00ff, 0x0100)
 
 # Serialization of header elements
 
@@ -37,6 +40,11 @@ header_fmt = Struct("<BBHL")
 logheader_fmt = Struct("<IQ")
 timestamp_fmt = Struct("<H")
 instance_fmt = Struct("<H")
+# sync(1) + type(1) + len(2), then records of objid(4) + len(1) + inst/data
+batch_header_fmt = Struct("<BBH")
+batch_record_fmt = Struct("<LB")
+# sync(1) + type(1) + len(2) + seq(2) + first frame(1) + fields(1), then frames
+blackbox_header_fmt = Struct("<BBHHBB")
 filereq_fmt = Struct("<LH")
 fileresp_fmt = Struct("<LB")
 
@@ -82,6 +90,8 @@ def process_stream(uavo_defs, use_walltime=False, gcs_timestamps=None,
 
     pending_pieces = []
 
+    blackbox_decoder = None
+
     while True:
         # If we don't have sufficient data buffered, join up any chunks we've
         # been given to ensure pending_pieces is empty for the rest of this loop.
@@ -168,6 +178,112 @@ def process_stream(uavo_defs, use_walltime=False, gcs_timestamps=None,
             buf_offset += 1
             continue
 
+        if pack_type == TYPE_OBJ_BATCH:
+            # +1 here is for CRC-8
+            while len(buf) < pack_len + 1 + buf_offset:
+                rx = yield None
+
+                if rx is None:
+                    #end of stream, stopiteration
+                    return
+
+                buf += rx
+
+            cs = calcCRC(buf[buf_offset:pack_len+buf_offset])
+            recv_cs = buf[buf_offset + pack_len]
+
+            if recv_cs != cs:
+                print("Bad crc. Got %d but wanted %d"%(recv_cs, cs))
+
+                buf_offset += 1
+
+                continue
+
+            if use_walltime:
+                timestamp = int(time.time()*1000.0)
+            elif gcs_timestamps:
+                timestamp = overrideTimestamp
+            else:
+                timestamp = last_timestamp
+
+            rec_offset = buf_offset + batch_header_fmt.size
+            end = buf_offset + pack_len
+
+            while rec_offset + batch_record_fmt.size <= end:
+                (rec_id, rec_len) = batch_record_fmt.unpack_from(buf, rec_offset)
+                rec_offset += batch_record_fmt.size
+
+                if rec_offset + rec_len > end:
+                    logger.warning("truncated batch record")
+                    break
+
+                obj = uavo_defs.get('{0:08x}'.format(rec_id))
+                data_offset = rec_offset
+                rec_offset += rec_len
+
+                if obj is None:
+                    continue
+
+                if not obj._single:
+                    data_offset += instance_fmt.size
+
+                if data_offset + obj.get_size_of_data() != rec_offset:
+                    logger.warning("mismatched size in batch id=%08x"%(rec_id))
+                    continue
+
+                objInstance = obj.from_bytes(buf, timestamp, offset=data_offset)
+                received += 1
+
+                next_recv = yield objInstance
+
+                if next_recv is not None and next_recv != '':
+                    pending_pieces.append(next_recv)
+
+            buf_offset += pack_len + 1
+
+            continue
+
+        if pack_type == TYPE_BLACKBOX:
+            # +1 here is for CRC-8
+            while len(buf) < pack_len + 1 + buf_offset:
+                rx = yield None
+
+                if rx is None:
+                    #end of stream, stopiteration
+                    return
+
+                buf += rx
+
+            cs = calcCRC(buf[buf_offset:pack_len+buf_offset])
+            recv_cs = buf[buf_offset + pack_len]
+
+            if recv_cs != cs:
+                print("Bad crc. Got %d but wanted %d"%(recv_cs, cs))
+
+                buf_offset += 1
+
+                continue
+
+            if blackbox_decoder is None:
+                blackbox_decoder = BlackboxDecoder(uavo_defs)
+
+            (_, _, _, seq, first, num_fields) = blackbox_header_fmt.unpack_from(buf, buf_offset)
+
+            frames = buf[buf_offset + blackbox_header_fmt.size : buf_offset + pack_len]
+
+            buf_offset += pack_len + 1
+
+            # Frames carry their own timestamps, which win over the others
+            for objInstance in blackbox_decoder.feed_chunk(seq, first, num_fields, frames):
+                received += 1
+
+                next_recv = yield objInstance
+
+                if next_recv is not None and next_recv != '':
+                    pending_pieces.append(next_recv)
+
+            continue
+
         # Search for object.
         uavo_key = '{0:08x}'.format(objId)
         if not uavo_key in uavo_defs:
@@ -301,16 +417,330 @@ def process_stream(uavo_defs, use_walltime=False, gcs_timestamps=None,
                 data_offset += fileresp_fmt.size
                 obj_len -= fileresp_fmt.size
 
-                filedata_callback(objId, file_offset,
-                        file_flags & FILEDATA_EOF != 0,
-                        file_flags & FILEDATA_LAST != 0,
-                        buf[data_offset : data_offset + obj_len])
+                file_data = bytes(buf[data_offset : data_offset + obj_len])
+
+                if file_flags & FILEDATA_LZ4:
+                    try:
+                        file_data = lz4_decompress(file_data)
+                    except ValueError:
+                        logger.warning("filedata: bad compressed chunk")
+                        file_data = None
+
+                if file_data is not None:
+                    filedata_callback(objId, file_offset,
+                            file_flags & FILEDATA_EOF != 0,
+                            file_flags & FILEDATA_LAST != 0,
+                            file_data)
 
         buf_offset += calc_size + 1
 
         if next_recv is not None and next_recv != '':
             pending_pieces.append(next_recv)
 
+# Little endian numpy equivalents of uavo.struct_element_map, for viewing
+# packed object data in place
+packed_numpy_map = {
+    'int8'    : 'i1',
+    'int16'   : '<i2',
+    'int32'   : '<i4',
+    'uint8'   : 'u1',
+    'uint16'  : '<u2',
+    'uint32'  : '<u4',
+    'float'   : '<f4',
+    'enum'    : 'u1',
+    }
+
+def packed_dtype(obj):
+    """Returns a numpy dtype laid out like the object's data on the wire"""
+
+    dtype = []
+
+    for (field, n) in zip(obj._fields[3:], obj._num_subelems):
+        if field == 'inst_id':
+            typ = '<u2'
+        else:
+            typ = packed_numpy_map[obj._types[field]]
+
+        if n == 1:
+            dtype.append((field, typ))
+        else:
+            dtype.append((field, typ, (n,)))
+
+    return dtype
+
+def detect_gcs_timestamps(buf):
+    """Guesses, like process_stream, whether a log has GCS-type timestamps.
+
+    Returns the offset the stream starts at and whether it has them, or
+    (None, None) if no guess could be made near the start."""
+
+    for offset in range(min(len(buf) - logheader_fmt.size - 1, 1024)):
+        overrideTimestamp, logHdrLen = logheader_fmt.unpack_from(buf, offset)
+
+        if (logHdrLen > 1000) or (overrideTimestamp > 100000000):
+            if buf[offset] == SYNC_VAL:
+                return (offset, False)
+        elif buf[offset + logheader_fmt.size] == SYNC_VAL:
+            return (offset, True)
+
+    return (None, None)
+
+def process_stream_numpy(uavo_defs, buf, gcs_timestamps=None,
+        progress_callback=None):
+    """Decodes a whole log at once into numpy arrays.
+
+    Rather than walking the stream one frame at a time, this finds every
+    place a frame could start, checks all of their lengths and CRCs
+    together, and then pulls out the data of each object type as one
+    structured array (with the dtype TelemetryBase.as_numpy_array uses).
+
+    Returns a dict from UAVO class to array, in log order.  Returns None if
+    the log holds batched or blackbox frames, whose contents can only be
+    decoded in order, or if the timestamp format couldn't be detected; use
+    process_stream for those."""
+
+    import numpy as np
+
+    if gcs_timestamps is None:
+        (start, gcs_timestamps) = detect_gcs_timestamps(buf)
+
+        if start is None:
+            return None
+    else:
+        start = 0
+
+    # With GCS timestamps, each frame follows its own log header
+    gap = logheader_fmt.size if gcs_timestamps else 0
+
+    data = np.frombuffer(buf, dtype=np.uint8)
+    n = len(data)
+
+    # Everywhere a frame could start: a sync byte, the right version, and a
+    # length that's sane and fits in what we have (+1 for CRC-8)
+    pos = np.flatnonzero(data[start + gap : max(n - header_fmt.size, 0)] == SYNC_VAL)
+    pos += start + gap
+
+    pos = pos[(data[pos + 1] & TYPE_MASK) == TYPE_VER]
+
+    lens = data[pos + 2].astype(np.int64) | (data[pos + 3].astype(np.int64) << 8)
+
+    ok = ((lens >= MIN_HEADER_LENGTH) &
+            (lens <= MAX_HEADER_LENGTH + MAX_PAYLOAD_LENGTH) &
+            (pos + lens + 1 <= n))
+
+    pos = pos[ok]
+    lens = lens[ok]
+
+    types = data[pos + 1] & (0xff & ~TYPE_MASK)
+
+    obj_ids = (data[pos + 4].astype(np.uint32) |
+            (data[pos + 5].astype(np.uint32) << 8) |
+            (data[pos + 6].astype(np.uint32) << 16) |
+            (data[pos + 7].astype(np.uint32) << 24))
+
+    # What each candidate's length has to be, as process_stream checks it
+    by_id = { obj._id : obj for obj in uavo_defs.values() }
+
+    (uniq_ids, id_idx) = np.unique(obj_ids, return_inverse=True)
+
+    uniq_known = np.array([ int(u) in by_id for u in uniq_ids ], dtype=bool)
+    uniq_size = np.array([ by_id[int(u)].get_size_of_data() if int(u) in by_id else 0
+        for u in uniq_ids ], dtype=np.int64)
+    uniq_multi = np.array([ not by_id[int(u)]._single if int(u) in by_id else False
+        for u in uniq_ids ], dtype=bool)
+
+    known = uniq_known[id_idx]
+    obj_size = uniq_size[id_idx]
+    multi = uniq_multi[id_idx]
+
+    is_req = np.isin(types, (TYPE_OBJ_REQ, TYPE_ACK, TYPE_NACK))
+    is_ts = np.isin(types, (TYPE_OBJ_TS, TYPE_OBJ_ACK_TS)) & known
+    is_whole = np.isin(types, (TYPE_OBJ_BATCH, TYPE_BLACKBOX))
+
+    expected = np.where(is_req, header_fmt.size + np.where(multi, instance_fmt.size, 0),
+                np.where(known, header_fmt.size + obj_size +
+                    np.where(is_ts, timestamp_fmt.size, 0), lens))
+    expected = np.where(is_whole, lens, expected)
+
+    ok = expected == lens
+
+    pos = pos[ok]
+    lens = lens[ok]
+    types = types[ok]
+    obj_ids = obj_ids[ok]
+    known = known[ok]
+    is_ts = is_ts[ok]
+    is_whole = is_whole[ok]
+
+    # CRC every candidate at once.  Going longest first, the ones still
+    # being summed at each step are always a prefix.
+    table = np.array(crc_table, dtype=np.uint8)
+
+    order = np.argsort(-lens, kind='stable')
+    sorted_pos = pos[order]
+    sorted_neg_lens = -lens[order]
+
+    cs = np.zeros(len(pos), dtype=np.uint8)
+
+    for j in range(int(-sorted_neg_lens[0]) if len(pos) else 0):
+        k = np.searchsorted(sorted_neg_lens, -j, side='left')
+        cs[:k] = table[cs[:k] ^ data[sorted_pos[:k] + j]]
+
+    good = np.empty(len(pos), dtype=bool)
+    good[order] = cs == data[sorted_pos - sorted_neg_lens]
+
+    pos = pos[good]
+    lens = lens[good]
+    types = types[good]
+    obj_ids = obj_ids[good]
+    known = known[good]
+    is_ts = is_ts[good]
+    is_whole = is_whole[good]
+
+    # Of the frames that check out, keep the chain that starts at the first
+    # one and continues wherever each ends.  Anything overlapping a kept
+    # frame is just a lucky match in its payload.
+    following = np.searchsorted(pos, pos + lens + 1 + gap).tolist()
+
+    chain = []
+    i = 0
+
+    while i < len(following):
+        chain.append(i)
+        i = following[i]
+
+    chain = np.array(chain, dtype=np.int64)
+
+    if np.any(is_whole[chain]):
+        return None
+
+    pos = pos[chain]
+    types = types[chain]
+    obj_ids = obj_ids[chain]
+    known = known[chain]
+    is_ts = is_ts[chain]
+
+    if gcs_timestamps:
+        hdr = pos - gap
+
+        times = (data[hdr].astype(np.int64) |
+                (data[hdr + 1].astype(np.int64) << 8) |
+                (data[hdr + 2].astype(np.int64) << 16) |
+                (data[hdr + 3].astype(np.int64) << 24))
+    else:
+        stamped = pos[is_ts] + header_fmt.size
+
+        raw = data[stamped].astype(np.int64) | (data[stamped + 1].astype(np.int64) << 8)
+
+        # Each time the 16 bit timestamp goes backwards, it has wrapped
+        wraps = np.concatenate(([0], np.cumsum(raw[1:] < raw[:-1])))
+
+        # Frames without their own timestamp take the last raw one seen,
+        # as process_stream does
+        last_raw = np.concatenate(([0], raw))[np.cumsum(is_ts)]
+
+        times = last_raw.copy()
+        times[is_ts] = raw + wraps * 65536
+
+    is_obj = np.isin(types, (TYPE_OBJ, TYPE_OBJ_ACK, TYPE_OBJ_TS, TYPE_OBJ_ACK_TS)) & known
+
+    pos = pos[is_obj]
+    obj_ids = obj_ids[is_obj]
+    is_ts = is_ts[is_obj]
+    times = times[is_obj]
+
+    data_pos = pos + header_fmt.size + np.where(is_ts, timestamp_fmt.size, 0)
+
+    ret = {}
+
+    order = np.argsort(obj_ids, kind='stable')
+    (uniq_ids, first) = np.unique(obj_ids[order], return_index=True)
+
+    for (obj_id, group) in zip(uniq_ids, np.split(order, first[1:])):
+        obj = by_id[int(obj_id)]
+
+        size = obj.get_size_of_data()
+
+        packed = data[data_pos[group][:, None] + np.arange(size)]
+        packed = packed.view(np.dtype(packed_dtype(obj))).reshape(-1)
+
+        arr = np.zeros(len(group), dtype=obj._dtype)
+
+        arr['name'] = obj._name
+        arr['time'] = times[group] / 1000.0
+        arr['uavo_id'] = obj._id
+
+        for field in packed.dtype.names:
+            arr[field] = packed[field]
+
+        ret[obj] = arr
+
+    if progress_callback is not None:
+        progress_callback(len(pos), n)
+
+    return ret
+
+def lz4_decompress(block):
+    """Expands one LZ4 block (as written by flight/Libraries/lz4block.c)"""
+
+    out = bytearray()
+    pos = 0
+
+    def get_length(pos):
+        length = 0
+
+        while True:
+            if pos >= len(block):
+                raise ValueError("truncated length")
+
+            b = block[pos]
+            pos += 1
+            length += b
+
+            if b != 255:
+                return length, pos
+
+    while pos < len(block):
+        token = block[pos]
+        pos += 1
+
+        lit_len = token >> 4
+
+        if lit_len == 15:
+            (more, pos) = get_length(pos)
+            lit_len += more
+
+        if pos + lit_len > len(block):
+            raise ValueError("truncated literals")
+
+        out += block[pos : pos + lit_len]
+        pos += lit_len
+
+        if pos >= len(block):
+            break
+
+        if pos + 2 > len(block):
+            raise ValueError("truncated offset")
+
+        offset = block[pos] | (block[pos + 1] << 8)
+        pos += 2
+
+        if offset == 0 or offset > len(out):
+            raise ValueError("bad offset")
+
+        match_len = (token & 15) + 4
+
+        if (token & 15) == 15:
+            (more, pos) = get_length(pos)
+            match_len += more
+
+        # Matches may overlap what they produce, so go byte by byte
+        start = len(out) - offset
+        for i in range(match_len):
+            out.append(out[start + i])
+
+    return bytes(out)
+
 def send_object(obj, req_ack=False):
     """Generates a string containing a UAVTalk packet describing this object"""
 
@@ -347,14 +777,23 @@ def request_object(obj, inst_id = 0):
 
     return packet
 
-def request_filedata(file_id, offset = 0):
-    """Makes a request for a chunk of file data"""
+def request_filedata(file_id, offset = 0, count = 0, compress = False):
+    """Makes a request for a chunk of file data
+
+    count is the number of messages to ask for (0 for the flight side's
+    default); with compress, the flight side may send LZ4 blocks instead of
+    the plain data.  Older firmware ignores both.
+    """
+
+    flags = count & FILEREQ_COUNT_MASK
+
+    if compress:
+        flags |= FILEREQ_LZ4
 
     packet = header_fmt.pack(SYNC_VAL, TYPE_FILEREQ | TYPE_VER,
         header_fmt.size + filereq_fmt.size, file_id)
 
-    # 0 = flags, not used for now.
-    packet += filereq_fmt.pack(offset, 0)
+    packet += filereq_fmt.pack(offset, flags)
 
     packet += bytes((calcCRC(packet),))
 
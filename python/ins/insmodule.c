@@ -91,23 +91,13 @@ static bool parseFloatVec3(PyArrayObject *vec_in, float *vec_out)
 }
 
 /**
- * pack_state put the state information into an array
+ * get_state copy the 16 state values out of the filter
  */
-static PyObject*
-pack_state(PyObject* self)
+static void get_state(double *s)
 {
-	float pos[3], vel[3], q[4], gyro_bias[3], accel_bias[3];        
+	float pos[3], vel[3], q[4], gyro_bias[3], accel_bias[3];
 	INSGetState(pos, vel, q, gyro_bias, accel_bias);
 
-	const int N = 16;
-	int nd = 1;
-	int dims[1];
-	dims[0] = N;
-
-	PyArrayObject *state;
-	state = (PyArrayObject*) PyArray_FromDims(nd, dims, NPY_DOUBLE);
-	double *s = (double *) PyArray_DATA(state);
-
 	s[0] = pos[0];
 	s[1] = pos[1];
 	s[2] = pos[2];
@@ -124,6 +114,23 @@ pack_state(PyObject* self)
 	s[13] = accel_bias[0];
 	s[14] = accel_bias[1];
 	s[15] = accel_bias[2];
+}
+
+/**
+ * pack_state put the state information into an array
+ */
+static PyObject*
+pack_state(PyObject* self)
+{
+	const int N = 16;
+	int nd = 1;
+	int dims[1];
+	dims[0] = N;
+
+	PyArrayObject *state;
+	state = (PyArrayObject*) PyArray_FromDims(nd, dims, NPY_DOUBLE);
+
+	get_state((double *) PyArray_DATA(state));
 
 	return Py_BuildValue("O", state);
 }
@@ -193,6 +200,117 @@ correction(PyObject* self, PyObject* args)
 	return pack_state(self);
 }
 
+/**
+ * check_rows make sure an array has N rows of cols values (cols 0 for a
+ * plain vector)
+ */
+static bool check_rows(PyArrayObject *arr, npy_intp N, int cols, const char *name)
+{
+	if (cols == 0 && PyArray_NDIM(arr) == 1 && PyArray_DIM(arr, 0) == N)
+		return true;
+
+	if (cols > 0 && PyArray_NDIM(arr) == 2 && PyArray_DIM(arr, 0) == N &&
+			PyArray_DIM(arr, 1) == cols)
+		return true;
+
+	PyErr_Format(PyExc_ValueError, "%s has the wrong shape", name);
+	return false;
+}
+
+/**
+ * replay - run the filter over a whole recording without coming back to
+ * python for each step.  The interpreter lock is released while it runs.
+ * @params[in] self
+ * @params[in] args
+ *  - gyro - N x 3 gyro samples
+ *  - accel - N x 3 accel samples
+ *  - dT - N time steps
+ *  - Z - N x 10 measurements, laid out as for correction
+ *  - sensors - N sensor masks, applied after the prediction at each step;
+ *    0 where there was nothing to correct with
+ * @return N x 16 state after each step
+ */
+static PyObject*
+replay(PyObject* self, PyObject* args)
+{
+	PyObject *gyro_in, *accel_in, *dT_in, *z_in, *sensors_in;
+
+	if (!PyArg_ParseTuple(args, "OOOOO", &gyro_in, &accel_in, &dT_in,
+				&z_in, &sensors_in))  return NULL;
+
+	PyArrayObject *vec_gyro = (PyArrayObject *) PyArray_FROM_OTF(gyro_in, NPY_DOUBLE, NPY_ARRAY_IN_ARRAY);
+	PyArrayObject *vec_accel = (PyArrayObject *) PyArray_FROM_OTF(accel_in, NPY_DOUBLE, NPY_ARRAY_IN_ARRAY);
+	PyArrayObject *vec_dT = (PyArrayObject *) PyArray_FROM_OTF(dT_in, NPY_DOUBLE, NPY_ARRAY_IN_ARRAY);
+	PyArrayObject *vec_z = (PyArrayObject *) PyArray_FROM_OTF(z_in, NPY_DOUBLE, NPY_ARRAY_IN_ARRAY);
+	PyArrayObject *vec_sensors = (PyArrayObject *) PyArray_FROM_OTF(sensors_in, NPY_INT, NPY_ARRAY_IN_ARRAY);
+	PyArrayObject *history = NULL;
+
+	if (!vec_gyro || !vec_accel || !vec_dT || !vec_z || !vec_sensors)
+		goto out;
+
+	if (PyArray_NDIM(vec_dT) != 1) {
+		PyErr_SetString(PyExc_ValueError, "dT is not a vector");
+		goto out;
+	}
+
+	npy_intp N = PyArray_DIM(vec_dT, 0);
+
+	if (!check_rows(vec_gyro, N, 3, "gyro") ||
+			!check_rows(vec_accel, N, 3, "accel") ||
+			!check_rows(vec_z, N, 10, "Z") ||
+			!check_rows(vec_sensors, N, 0, "sensors"))
+		goto out;
+
+	npy_intp dims[2] = { N, 16 };
+
+	history = (PyArrayObject *) PyArray_SimpleNew(2, dims, NPY_DOUBLE);
+	if (history == NULL)
+		goto out;
+
+	const double *gyro = PyArray_DATA(vec_gyro);
+	const double *accel = PyArray_DATA(vec_accel);
+	const double *dT = PyArray_DATA(vec_dT);
+	const double *z = PyArray_DATA(vec_z);
+	const int *sensors = PyArray_DATA(vec_sensors);
+	double *h = PyArray_DATA(history);
+
+	Py_BEGIN_ALLOW_THREADS
+
+	for (npy_intp k = 0; k < N; k++) {
+		float gyro_data[3], accel_data[3];
+
+		for (int i = 0; i < 3; i++) {
+			gyro_data[i] = gyro[k * 3 + i];
+			accel_data[i] = accel[k * 3 + i];
+		}
+
+		INSStatePrediction(gyro_data, accel_data, dT[k]);
+		INSCovariancePrediction(dT[k]);
+
+		if (sensors[k]) {
+			float zf[10];
+
+			for (int i = 0; i < 10; i++)
+				zf[i] = z[k * 10 + i];
+
+			INSCorrection(&zf[6], &zf[0], &zf[3], zf[9], sensors[k]);
+		}
+
+		get_state(&h[k * 16]);
+	}
+
+	Py_END_ALLOW_THREADS
+
+out:
+	Py_XDECREF(vec_gyro);
+	Py_XDECREF(vec_accel);
+	Py_XDECREF(vec_dT);
+	Py_XDECREF(vec_z);
+	Py_XDECREF(vec_sensors);
+
+	return (PyObject *) history;
+}
+
 /**
  * configure the EKF paramters (e.g. variances)
  * @params[in] self
@@ -248,7 +366,7 @@ configure(PyObject* self, PyObject* args, PyObject *kwarg)
 		INSSetPosVelVar(gps[0], gps[1], gps[2]);
 	}
 
-	return Py_None;
+	Py_RETURN_NONE;
 }
 
 static PyObject*
@@ -290,7 +408,7 @@ set_state(PyObject* self, PyObject* args, PyObject *kwarg)
 
 	INSSetState(pos, vel, q, gyro_bias, accel_bias);
 
-	return Py_None;
+	Py_RETURN_NONE;
 }
 
 
@@ -310,6 +428,7 @@ static PyMethodDef InsMethods[] =
 	{"init", init, METH_VARARGS, "Reset INS state."},
 	{"prediction", prediction, METH_VARARGS, "Advance state 1 time step."},
 	{"correction", correction, METH_VARARGS, "Apply state correction based on measured sensors."},
+	{"replay", replay, METH_VARARGS, "Run the filter over a whole recording."},
 	{"configure", (PyCFunction)configure, METH_VARARGS|METH_KEYWORDS, "Configure EKF parameters."},
 	{"set_state", (PyCFunction)set_state, METH_VARARGS|METH_KEYWORDS, "Set the EKF state."},
 	{NULL, NULL, 0, NULL}
@@ -0,0 +1,163 @@
+"""
+Replays recorded sensor data through the C INS, for tuning its noise
+parameters.
+
+The C filter keeps its state in globals, so only one can run per process.
+batch_replay runs many configurations over shared sensor data by giving
+each worker process its own filter; within a worker, ins.replay runs a
+whole recording in C with the interpreter lock released.
+
+Copyright (C) 2017 dRonin, http://dronin.org
+
+Licensed under the GNU LGPL version 2.1 or any later version (see COPYING.LESSER)
+"""
+
+import itertools
+import multiprocessing
+
+import numpy
+import ins
+
+from cins import default_mag_var, default_gyro_var, default_accel_var, \
+	default_baro_var, default_gps_var
+
+# the masks must match the values in insgps.h, as in cins.py
+POS_SENSORS = 0x0003
+VEL_SENSORS = 0x0038
+MAG_SENSORS = 0x01C0
+BARO_SENSORS = 0x0200
+
+def align(gyro_t, gyro, accel, mag=None, baro=None, pos=None, vel=None):
+	""" Lines slower sensors up with the gyro samples, for replay.
+
+	gyro_t gives the time of each of the N gyro and accel samples (N x 3).
+	mag, baro, pos and vel are each None or a (times, values) pair.  Each
+	measurement is applied after the prediction at the first gyro sample
+	at or after it; if two land on the same step, the later one is used.
+
+	Returns a dict of the arrays ins.replay takes.
+	"""
+
+	gyro_t = numpy.asarray(gyro_t, dtype=numpy.float64)
+	N = len(gyro_t)
+
+	dT = numpy.empty(N)
+	dT[1:] = numpy.diff(gyro_t)
+	dT[0] = dT[1] if N > 1 else 1.0 / 666.0
+
+	Z = numpy.zeros((N, 10))
+	sensors = numpy.zeros(N, dtype=numpy.intc)
+
+	streams = [ (pos, POS_SENSORS, slice(0, 2)),
+		(vel, VEL_SENSORS, slice(3, 6)),
+		(mag, MAG_SENSORS, slice(6, 9)),
+		(baro, BARO_SENSORS, 9) ]
+
+	for (stream, mask, cols) in streams:
+		if stream is None:
+			continue
+
+		(t, values) = stream
+		values = numpy.asarray(values, dtype=numpy.float64)
+
+		if isinstance(cols, slice):
+			values = values[:, :cols.stop - cols.start]
+
+		steps = numpy.searchsorted(gyro_t, numpy.asarray(t), side='left')
+
+		keep = steps < N
+
+		Z[steps[keep], cols] = values[keep]
+		sensors[steps[keep]] |= mask
+
+	return {
+		'gyro' : numpy.ascontiguousarray(gyro, dtype=numpy.float64),
+		'accel' : numpy.ascontiguousarray(accel, dtype=numpy.float64),
+		'dT' : dT,
+		'Z' : Z,
+		'sensors' : sensors,
+	}
+
+def replay(sensors, mag_var=default_mag_var, gyro_var=default_gyro_var,
+		accel_var=default_accel_var, baro_var=default_baro_var,
+		gps_var=default_gps_var, **state):
+	""" Runs one configuration over one aligned recording, from a fresh
+	filter.  Any of the ins.set_state arguments may be given to start from.
+
+	Returns the N x 16 state after each step.
+	"""
+
+	ins.init()
+	ins.configure(mag_var=numpy.asarray(mag_var, dtype=numpy.float64),
+		gyro_var=numpy.asarray(gyro_var, dtype=numpy.float64),
+		accel_var=numpy.asarray(accel_var, dtype=numpy.float64),
+		baro_var=baro_var,
+		gps_var=numpy.asarray(gps_var, dtype=numpy.float64))
+
+	if state:
+		ins.set_state(**state)
+
+	return ins.replay(sensors['gyro'], sensors['accel'], sensors['dT'],
+		sensors['Z'], sensors['sensors'])
+
+def final_state(history, sensors):
+	""" Default score: just where the filter ended up """
+	return history[-1]
+
+def grid(**axes):
+	""" Every combination of the given parameter values, as configurations
+	for batch_replay.  e.g. grid(baro_var=[0.1, 1], gyro_var=[...]) """
+
+	names = sorted(axes.keys())
+
+	return [ dict(zip(names, values))
+		for values in itertools.product(*[ axes[n] for n in names ]) ]
+
+# Set in each worker, so the recordings aren't sent along with every job
+_worker_sensors = None
+_worker_score = None
+
+def _init_worker(sensors, score):
+	global _worker_sensors, _worker_score
+
+	_worker_sensors = sensors
+	_worker_score = score
+
+def _run_job(job):
+	(config, log_idx) = job
+
+	sensors = _worker_sensors[log_idx]
+
+	return _worker_score(replay(sensors, **config), sensors)
+
+def batch_replay(sensors, configs, score=final_state, processes=None):
+	""" Runs every configuration over every recording.
+
+	sensors is one aligned recording (see align) or a list of them, and
+	configs a list of dicts of replay arguments (see grid).  score maps
+	(history, sensors) to the result kept for each run; it must be a
+	module level function, as it goes to the worker processes.  Where
+	processes can be forked the recordings are shared with them rather
+	than copied.
+
+	Returns an array of len(configs) x len(sensors) scores.
+	"""
+
+	if isinstance(sensors, dict):
+		sensors = [ sensors ]
+
+	jobs = [ (config, log_idx) for config in configs
+		for log_idx in range(len(sensors)) ]
+
+	pool = multiprocessing.Pool(processes, initializer=_init_worker,
+		initargs=(sensors, score))
+
+	try:
+		results = pool.map(_run_job, jobs)
+	finally:
+		pool.close()
+		pool.join()
+
+	results = numpy.array(results)
+
+	return results.reshape((len(configs), len(sensors)) + results.shape[1:])
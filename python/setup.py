@@ -85,7 +85,7 @@ setup(
 
     scripts = [ 'dronin-dumplog', 'dronin-halt',
         'dronin-getconfig', 'dronin-logfsimport',
-        'dronin-shell' ],
+        'dronin-shell', 'dronin-logcache', 'dronin-sensorreplay' ],
 #    package_data={
 #        'sample': ['package_data.dat'],
 #    },